@@ -17,6 +17,10 @@ if USE_POSTGRES
 AM_CPPFLAGS += -DUSE_POSTGRES=1 $(libpq_CFLAGS)
 endif # USE_POSTGRES
 
+if USE_ZLIB
+AM_CPPFLAGS += -DUSE_ZLIB=1 $(zlib_CFLAGS)
+endif # USE_ZLIB
+
 if ENABLE_NEXT_PROTOCOL_VERSION_UNSAFE_FOR_PRODUCTION
 AM_CPPFLAGS += -I"$(top_builddir)/src/protocol-next"
 else
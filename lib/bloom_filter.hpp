@@ -454,6 +454,10 @@ class bloom_filter
             {
                 bit_table_[i] |= f.bit_table_[i];
             }
+
+            // stellar-core: only used to merge filters over disjoint key
+            // sets, so the union holds the sum of both insertion counts
+            inserted_element_count_ += f.inserted_element_count_;
         }
 
         return *this;
@@ -52,9 +52,11 @@ void server::add404(routeHandler callback)
 }
 
 void
-server::addRoute(const std::string& routeName, routeHandler callback)
+server::addRoute(const std::string& routeName, routeHandler callback,
+                 const std::string& contentType)
 {
     mRoutes[routeName] = callback;
+    mContentTypes[routeName] = contentType;
 }
 
 void
@@ -120,7 +122,7 @@ server::handle_request(const request& req, reply& rep)
         rep.headers[0].name = "Content-Length";
         rep.headers[0].value = std::to_string(rep.content.size());
         rep.headers[1].name = "Content-Type";
-        rep.headers[1].value = "application/json";
+        rep.headers[1].value = mContentTypes.at(command);
     }
     else
     {
@@ -41,7 +41,8 @@ public:
                     const std::string& address, unsigned short port, int maxClient);
     ~server();
 
-    void addRoute(const std::string& routeName, routeHandler callback);
+    void addRoute(const std::string& routeName, routeHandler callback,
+                  const std::string& contentType = "application/json");
     void add404(routeHandler callback);
 
     void handle_request(const request& req, reply& rep);
@@ -72,6 +73,7 @@ private:
     asio::ip::tcp::socket socket_;
 
     std::map<std::string, routeHandler> mRoutes;
+    std::map<std::string, std::string> mContentTypes;
 };
 
 } // namespace server
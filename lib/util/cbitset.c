@@ -15,6 +15,163 @@
 
 #include "cbitset.h"
 
+/* When the target has AVX2 or NEON, the word loops of the operations below
+ * run a vector of words at a time, with the scalar loop finishing off the
+ * words that don't fill a vector. Whole vectors are compared, combined and
+ * counted through the bitset_vec_* helpers, and the population count of a
+ * vector is accumulated in 64-bit lanes, summed once at the end. */
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#define BITSET_VEC_WORDS 4
+typedef __m256i bitset_vec_t;
+
+static inline bitset_vec_t
+bitset_vec_load(const uint64_t* p)
+{
+    return _mm256_loadu_si256((const __m256i*)p);
+}
+
+static inline void
+bitset_vec_store(uint64_t* p, bitset_vec_t v)
+{
+    _mm256_storeu_si256((__m256i*)p, v);
+}
+
+static inline bitset_vec_t
+bitset_vec_or(bitset_vec_t a, bitset_vec_t b)
+{
+    return _mm256_or_si256(a, b);
+}
+
+static inline bitset_vec_t
+bitset_vec_and(bitset_vec_t a, bitset_vec_t b)
+{
+    return _mm256_and_si256(a, b);
+}
+
+/* a & ~b */
+static inline bitset_vec_t
+bitset_vec_andnot(bitset_vec_t a, bitset_vec_t b)
+{
+    return _mm256_andnot_si256(b, a);
+}
+
+static inline bitset_vec_t
+bitset_vec_xor(bitset_vec_t a, bitset_vec_t b)
+{
+    return _mm256_xor_si256(a, b);
+}
+
+static inline bool
+bitset_vec_is_zero(bitset_vec_t v)
+{
+    return _mm256_testz_si256(v, v) != 0;
+}
+
+static inline bitset_vec_t
+bitset_vec_count_init(void)
+{
+    return _mm256_setzero_si256();
+}
+
+/* Adds the population count of each 64-bit lane of v to acc, looking up the
+ * count of each nibble with a byte shuffle (Mula's method). */
+static inline bitset_vec_t
+bitset_vec_count_add(bitset_vec_t acc, bitset_vec_t v)
+{
+    const __m256i lookup =
+        _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1,
+                         1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(
+        lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    __m256i bytes = _mm256_add_epi8(lo, hi);
+    return _mm256_add_epi64(acc,
+                            _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+}
+
+static inline size_t
+bitset_vec_count_sum(bitset_vec_t acc)
+{
+    return (size_t)(_mm256_extract_epi64(acc, 0) +
+                    _mm256_extract_epi64(acc, 1) +
+                    _mm256_extract_epi64(acc, 2) +
+                    _mm256_extract_epi64(acc, 3));
+}
+
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+
+#define BITSET_VEC_WORDS 2
+typedef uint64x2_t bitset_vec_t;
+
+static inline bitset_vec_t
+bitset_vec_load(const uint64_t* p)
+{
+    return vld1q_u64(p);
+}
+
+static inline void
+bitset_vec_store(uint64_t* p, bitset_vec_t v)
+{
+    vst1q_u64(p, v);
+}
+
+static inline bitset_vec_t
+bitset_vec_or(bitset_vec_t a, bitset_vec_t b)
+{
+    return vorrq_u64(a, b);
+}
+
+static inline bitset_vec_t
+bitset_vec_and(bitset_vec_t a, bitset_vec_t b)
+{
+    return vandq_u64(a, b);
+}
+
+/* a & ~b */
+static inline bitset_vec_t
+bitset_vec_andnot(bitset_vec_t a, bitset_vec_t b)
+{
+    return vbicq_u64(a, b);
+}
+
+static inline bitset_vec_t
+bitset_vec_xor(bitset_vec_t a, bitset_vec_t b)
+{
+    return veorq_u64(a, b);
+}
+
+static inline bool
+bitset_vec_is_zero(bitset_vec_t v)
+{
+    return (vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) == 0;
+}
+
+static inline bitset_vec_t
+bitset_vec_count_init(void)
+{
+    return vdupq_n_u64(0);
+}
+
+/* Adds the population count of each 64-bit lane of v to acc, widening the
+ * per-byte counts pairwise. */
+static inline bitset_vec_t
+bitset_vec_count_add(bitset_vec_t acc, bitset_vec_t v)
+{
+    uint8x16_t bytes = vcntq_u8(vreinterpretq_u8_u64(v));
+    return vaddq_u64(acc, vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(bytes))));
+}
+
+static inline size_t
+bitset_vec_count_sum(bitset_vec_t acc)
+{
+    return (size_t)(vgetq_lane_u64(acc, 0) + vgetq_lane_u64(acc, 1));
+}
+#endif
+
 /* Create a new bitset. Return NULL in case of failure. */
 bitset_t*
 bitset_create()
@@ -184,6 +341,14 @@ bitset_count(const bitset_t* bitset)
 {
     size_t card = 0;
     size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    bitset_vec_t acc = bitset_vec_count_init();
+    for (; k + BITSET_VEC_WORDS <= bitset->arraysize; k += BITSET_VEC_WORDS)
+    {
+        acc = bitset_vec_count_add(acc, bitset_vec_load(bitset->array + k));
+    }
+    card += bitset_vec_count_sum(acc);
+#endif
     // assumes that long long is 8 bytes
     for (; k + 7 < bitset->arraysize; k += 8)
     {
@@ -215,7 +380,16 @@ bitset_inplace_union(bitset_t* b1, const bitset_t* b2)
 {
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
-    for (size_t k = 0; k < minlength; ++k)
+    size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_store(b1->array + k,
+                         bitset_vec_or(bitset_vec_load(b1->array + k),
+                                       bitset_vec_load(b2->array + k)));
+    }
+#endif
+    for (; k < minlength; ++k)
     {
         b1->array[k] |= b2->array[k];
     }
@@ -265,6 +439,16 @@ bitset_union_count(const bitset_t* b1, const bitset_t* b2)
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    bitset_vec_t acc = bitset_vec_count_init();
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        acc = bitset_vec_count_add(
+            acc, bitset_vec_or(bitset_vec_load(b1->array + k),
+                               bitset_vec_load(b2->array + k)));
+    }
+    answer += bitset_vec_count_sum(acc);
+#endif
     for (; k + 3 < minlength; k += 4)
     {
         answer += bitset_popcountll(b1->array[k] | b2->array[k]);
@@ -315,6 +499,14 @@ bitset_inplace_intersection(bitset_t* b1, const bitset_t* b2)
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_store(b1->array + k,
+                         bitset_vec_and(bitset_vec_load(b1->array + k),
+                                        bitset_vec_load(b2->array + k)));
+    }
+#endif
     for (; k < minlength; ++k)
     {
         b1->array[k] &= b2->array[k];
@@ -325,12 +517,44 @@ bitset_inplace_intersection(bitset_t* b1, const bitset_t* b2)
     }
 }
 
+size_t
+bitset_intersection_count(const bitset_t* b1, const bitset_t* b2)
+{
+    size_t answer = 0;
+    size_t minlength =
+        b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
+    size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    bitset_vec_t acc = bitset_vec_count_init();
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        acc = bitset_vec_count_add(
+            acc, bitset_vec_and(bitset_vec_load(b1->array + k),
+                                bitset_vec_load(b2->array + k)));
+    }
+    answer += bitset_vec_count_sum(acc);
+#endif
+    for (; k < minlength; ++k)
+    {
+        answer += bitset_popcountll(b1->array[k] & b2->array[k]);
+    }
+    return answer;
+}
+
 void
 bitset_inplace_difference(bitset_t* b1, const bitset_t* b2)
 {
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_store(b1->array + k,
+                         bitset_vec_andnot(bitset_vec_load(b1->array + k),
+                                           bitset_vec_load(b2->array + k)));
+    }
+#endif
     for (; k < minlength; ++k)
     {
         b1->array[k] &= ~(b2->array[k]);
@@ -344,6 +568,16 @@ bitset_difference_count(const bitset_t* b1, const bitset_t* b2)
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
     size_t answer = 0;
+#ifdef BITSET_VEC_WORDS
+    bitset_vec_t acc = bitset_vec_count_init();
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        acc = bitset_vec_count_add(
+            acc, bitset_vec_andnot(bitset_vec_load(b1->array + k),
+                                   bitset_vec_load(b2->array + k)));
+    }
+    answer += bitset_vec_count_sum(acc);
+#endif
     for (; k < minlength; ++k)
     {
         answer += bitset_popcountll(b1->array[k] & ~(b2->array[k]));
@@ -361,6 +595,14 @@ bitset_inplace_symmetric_difference(bitset_t* b1, const bitset_t* b2)
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_store(b1->array + k,
+                         bitset_vec_xor(bitset_vec_load(b1->array + k),
+                                        bitset_vec_load(b2->array + k)));
+    }
+#endif
     for (; k < minlength; ++k)
     {
         b1->array[k] ^= b2->array[k];
@@ -383,6 +625,16 @@ bitset_symmetric_difference_count(const bitset_t* b1, const bitset_t* b2)
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
     size_t k = 0;
     size_t answer = 0;
+#ifdef BITSET_VEC_WORDS
+    bitset_vec_t acc = bitset_vec_count_init();
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        acc = bitset_vec_count_add(
+            acc, bitset_vec_xor(bitset_vec_load(b1->array + k),
+                                bitset_vec_load(b2->array + k)));
+    }
+    answer += bitset_vec_count_sum(acc);
+#endif
     for (; k < minlength; ++k)
     {
         answer += bitset_popcountll(b1->array[k] ^ b2->array[k]);
@@ -409,7 +661,17 @@ bitset_equal(const bitset_t* b1, const bitset_t* b2)
 {
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
-    for (size_t k = 0; k < minlength; ++k)
+    size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_t v = bitset_vec_xor(bitset_vec_load(b1->array + k),
+                                        bitset_vec_load(b2->array + k));
+        if (!bitset_vec_is_zero(v))
+            return false;
+    }
+#endif
+    for (; k < minlength; ++k)
     {
         if (b1->array[k] != b2->array[k])
             return false;
@@ -422,7 +684,19 @@ bitset_subseteq(const bitset_t* b1, const bitset_t* b2)
 {
     size_t minlength =
         b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
-    for (size_t k = 0; k < minlength; ++k)
+    size_t k = 0;
+#ifdef BITSET_VEC_WORDS
+    for (; k + BITSET_VEC_WORDS <= minlength; k += BITSET_VEC_WORDS)
+    {
+        bitset_vec_t v = bitset_vec_andnot(bitset_vec_load(b1->array + k),
+                                           bitset_vec_load(b2->array + k));
+        if (!bitset_vec_is_zero(v))
+        {
+            return false;
+        }
+    }
+#endif
+    for (; k < minlength; ++k)
     {
         if ((b1->array[k] & b2->array[k]) != b1->array[k])
         {
@@ -165,17 +165,7 @@ size_t bitset_union_count(const bitset_t* b1, const bitset_t* b2);
 void bitset_inplace_intersection(bitset_t* b1, const bitset_t* b2);
 
 /* report the size of the intersection (without materializing it) */
-static inline size_t
-bitset_intersection_count(const bitset_t* b1, const bitset_t* b2)
-{
-    size_t answer = 0;
-    size_t minlength = b1->arraysize < b2->arraysize ? b1->arraysize : b2->arraysize;
-    for (size_t k = 0; k < minlength; ++k)
-    {
-        answer += bitset_popcountll(b1->array[k] & b2->array[k]);
-    }
-    return answer;
-}
+size_t bitset_intersection_count(const bitset_t* b1, const bitset_t* b2);
 
 /* compute the difference in-place (to b1), to generate a new bitset first call
  * bitset_copy */
@@ -8,6 +8,7 @@
 #include "util/asio.h" // IWYU pragma: keep
 #include "bucket/Bucket.h"
 #include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndexBudget.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketListSnapshot.h"
 #include "bucket/BucketManager.h"
@@ -21,43 +22,134 @@
 #include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
 #include "medida/timer.h"
+#include "util/FilePrefetcher.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MmapFile.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
-#include <Tracy.hpp>
+#include <algorithm>
 
 #include "medida/counter.h"
 
 namespace stellar
 {
 
-BucketIndex const&
+std::shared_ptr<BucketIndex const>
 Bucket::getIndex() const
 {
     ZoneScoped;
     releaseAssertOrThrow(!mFilename.empty());
+
+    std::shared_ptr<BucketIndexBudget> budget;
+    std::shared_ptr<BucketIndex const> index;
+    {
+        std::lock_guard<std::mutex> guard(mIndexMutex);
+        if (mIndexBudget)
+        {
+            mLastIndexAccess = mIndexBudget->tick();
+        }
+
+        if (mIndex)
+        {
+            return mIndex;
+        }
+
+        releaseAssertOrThrow(mIndexBudget);
+        mIndex = mIndexBudget->reload(*this);
+        mIndexBytes = mIndex->getMemoryUsage();
+        budget = mIndexBudget;
+        index = mIndex;
+    }
+
+    // Must not hold mIndexMutex, the budget may drop other bucket indexes
+    budget->onIndexLoaded();
+    return index;
+}
+
+void
+Bucket::setIndexBudget(std::shared_ptr<BucketIndexBudget> budget) const
+{
+    std::lock_guard<std::mutex> guard(mIndexMutex);
     releaseAssertOrThrow(mIndex);
-    return *mIndex;
+    releaseAssertOrThrow(!mIndexBudget);
+    mIndexBudget = std::move(budget);
+    mIndexBytes = mIndex->getMemoryUsage();
+    mLastIndexAccess = mIndexBudget->tick();
+}
+
+size_t
+Bucket::getResidentIndexBytes() const
+{
+    std::lock_guard<std::mutex> guard(mIndexMutex);
+    return mIndex ? mIndexBytes : 0;
+}
+
+size_t
+Bucket::dropIndex() const
+{
+    std::lock_guard<std::mutex> guard(mIndexMutex);
+    if (!mIndex)
+    {
+        return 0;
+    }
+
+    releaseAssertOrThrow(mIndexBudget);
+    mIndex.reset();
+    return mIndexBytes;
+}
+
+std::shared_ptr<MmapFile const>
+Bucket::getMappedFile() const
+{
+    releaseAssertOrThrow(!mFilename.empty());
+    std::lock_guard<std::mutex> guard(mMappedFileMutex);
+    if (!mMappedFile)
+    {
+        auto f = std::make_shared<MmapFile>(mFilename.string());
+
+        // BucketListDB reads are point lookups spread uniformly over the
+        // file, so kernel readahead only pollutes the page cache. Reads of
+        // a full index page are instead hinted individually, see
+        // BucketSnapshot::getEntryAtOffset
+        f->adviseRandom();
+        mMappedFile = f;
+    }
+    return mMappedFile;
 }
 
 bool
 Bucket::isIndexed() const
 {
-    return static_cast<bool>(mIndex);
+    std::lock_guard<std::mutex> guard(mIndexMutex);
+    return mIndex || mIndexBudget;
 }
 
 std::optional<std::pair<std::streamoff, std::streamoff>>
 Bucket::getOfferRange() const
 {
-    return getIndex().getOfferRange();
+    return getIndex()->getOfferRange();
+}
+
+std::optional<std::pair<std::streamoff, std::streamoff>>
+Bucket::getContractCodeAndTTLRange() const
+{
+    return getIndex()->getContractCodeAndTTLRange();
+}
+
+std::optional<std::pair<std::streamoff, std::streamoff>>
+Bucket::getLiquidityPoolRange() const
+{
+    return getIndex()->getLiquidityPoolRange();
 }
 
 void
 Bucket::setIndex(std::unique_ptr<BucketIndex const>&& index)
 {
-    releaseAssertOrThrow(!mIndex);
+    std::lock_guard<std::mutex> guard(mIndexMutex);
+    releaseAssertOrThrow(!mIndex && !mIndexBudget);
     mIndex = std::move(index);
 }
 
@@ -127,7 +219,9 @@ Bucket::isEmpty() const
 void
 Bucket::freeIndex()
 {
-    mIndex.reset(nullptr);
+    std::lock_guard<std::mutex> guard(mIndexMutex);
+    mIndex.reset();
+    mIndexBudget.reset();
 }
 
 #ifdef BUILD_TESTS
@@ -291,8 +385,10 @@ Bucket::checkProtocolLegality(BucketEntry const& entry,
     }
 }
 
+// Takes entry by rvalue so it can be swapped into the output iterator's buffer
+// rather than copied; entry is left holding some valid value.
 inline void
-maybePut(BucketOutputIterator& out, BucketEntry const& entry,
+maybePut(BucketOutputIterator& out, BucketEntry&& entry,
          std::vector<BucketInputIterator>& shadowIterators,
          bool keepShadowedLifecycleEntries, MergeCounters& mc)
 {
@@ -338,7 +434,7 @@ maybePut(BucketOutputIterator& out, BucketEntry const& entry,
         (entry.type() == INITENTRY || entry.type() == DEADENTRY))
     {
         // Never shadow-out entries in this case; no point scanning shadows.
-        out.put(entry);
+        out.put(std::move(entry));
         return;
     }
 
@@ -362,7 +458,7 @@ maybePut(BucketOutputIterator& out, BucketEntry const& entry,
         }
     }
     // Nothing shadowed.
-    out.put(entry);
+    out.put(std::move(entry));
 }
 
 static void
@@ -510,14 +606,18 @@ calculateMergeProtocolVersion(
 // side, or entries that compare non-equal. In all these cases we just
 // take the lesser (or existing) entry and advance only one iterator,
 // not scrutinizing the entry type further.
+//
+// Keys are compared once per step with a three-way comparison, which for entry
+// types with fixed-size keys is a memcmp of the serialized keys.
 static bool
 mergeCasesWithDefaultAcceptance(
-    BucketEntryIdCmp const& cmp, MergeCounters& mc, BucketInputIterator& oi,
-    BucketInputIterator& ni, BucketOutputIterator& out,
+    MergeCounters& mc, BucketInputIterator& oi, BucketInputIterator& ni,
+    BucketOutputIterator& out,
     std::vector<BucketInputIterator>& shadowIterators, uint32_t protocolVersion,
     bool keepShadowedLifecycleEntries)
 {
-    if (!ni || (oi && ni && cmp(*oi, *ni)))
+    int c = (oi && ni) ? BucketInputIterator::compareIdentity(oi, ni) : 0;
+    if (!ni || (oi && c < 0))
     {
         // Either of:
         //
@@ -528,11 +628,12 @@ mergeCasesWithDefaultAcceptance(
         ++mc.mOldEntriesDefaultAccepted;
         Bucket::checkProtocolLegality(*oi, protocolVersion);
         countOldEntryType(mc, *oi);
-        maybePut(out, *oi, shadowIterators, keepShadowedLifecycleEntries, mc);
+        maybePut(out, std::move(oi.entryToMove()), shadowIterators,
+                 keepShadowedLifecycleEntries, mc);
         ++oi;
         return true;
     }
-    else if (!oi || (oi && ni && cmp(*ni, *oi)))
+    else if (!oi || c > 0)
     {
         // Either of:
         //
@@ -543,7 +644,8 @@ mergeCasesWithDefaultAcceptance(
         ++mc.mNewEntriesDefaultAccepted;
         Bucket::checkProtocolLegality(*ni, protocolVersion);
         countNewEntryType(mc, *ni);
-        maybePut(out, *ni, shadowIterators, keepShadowedLifecycleEntries, mc);
+        maybePut(out, std::move(ni.entryToMove()), shadowIterators,
+                 keepShadowedLifecycleEntries, mc);
         ++ni;
         return true;
     }
@@ -640,10 +742,10 @@ mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
         }
         BucketEntry newLive;
         newLive.type(LIVEENTRY);
-        newLive.liveEntry() = newEntry.liveEntry();
+        newLive.liveEntry() = std::move(ni.entryToMove().liveEntry());
         ++mc.mNewInitEntriesMergedWithOldDead;
-        maybePut(out, newLive, shadowIterators, keepShadowedLifecycleEntries,
-                 mc);
+        maybePut(out, std::move(newLive), shadowIterators,
+                 keepShadowedLifecycleEntries, mc);
     }
     else if (oldEntry.type() == INITENTRY)
     {
@@ -653,9 +755,9 @@ mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
             // Merge a create+update to a fresher create.
             BucketEntry newInit;
             newInit.type(INITENTRY);
-            newInit.liveEntry() = newEntry.liveEntry();
+            newInit.liveEntry() = std::move(ni.entryToMove().liveEntry());
             ++mc.mOldInitEntriesMergedWithNewLive;
-            maybePut(out, newInit, shadowIterators,
+            maybePut(out, std::move(newInit), shadowIterators,
                      keepShadowedLifecycleEntries, mc);
         }
         else
@@ -668,13 +770,39 @@ mergeCasesWithEqualKeys(MergeCounters& mc, BucketInputIterator& oi,
     {
         // Neither is in INIT state, take the newer one.
         ++mc.mNewEntriesMergedWithOldNeitherInit;
-        maybePut(out, newEntry, shadowIterators, keepShadowedLifecycleEntries,
-                 mc);
+        maybePut(out, std::move(ni.entryToMove()), shadowIterators,
+                 keepShadowedLifecycleEntries, mc);
     }
     ++oi;
     ++ni;
 }
 
+void
+Bucket::openForEvictionScan(XDRInputFileStream& stream, size_t offset,
+                            size_t bytesToScan) const
+{
+    ZoneScoped;
+    stream.setReadBufferSize(std::clamp(bytesToScan,
+                                        EVICTION_SCAN_MIN_READ_BUFFER,
+                                        EVICTION_SCAN_MAX_READ_BUFFER));
+    stream.open(mFilename.string());
+    stream.seek(offset);
+    prefetchForEvictionScan(offset, bytesToScan);
+}
+
+void
+Bucket::prefetchForEvictionScan(size_t offset, size_t len) const
+{
+    ZoneScoped;
+    if (isEmpty() || len == 0 || !FilePrefetcher::isSupported())
+    {
+        return;
+    }
+
+    FilePrefetcher prefetcher(mFilename.string());
+    prefetcher.prefetch({{offset, len}});
+}
+
 bool
 Bucket::scanForEvictionLegacy(AbstractLedgerTxn& ltx, EvictionIterator& iter,
                               uint32_t& bytesToScan,
@@ -702,8 +830,7 @@ Bucket::scanForEvictionLegacy(AbstractLedgerTxn& ltx, EvictionIterator& iter,
     }
 
     XDRInputFileStream stream{};
-    stream.open(mFilename.string());
-    stream.seek(iter.bucketFileOffset);
+    openForEvictionScan(stream, iter.bucketFileOffset, bytesToScan);
 
     BucketEntry be;
     while (stream.readOne(be))
@@ -774,7 +901,7 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
               std::shared_ptr<Bucket> const& newBucket,
               std::vector<std::shared_ptr<Bucket>> const& shadows,
               bool keepDeadEntries, bool countMergeEvents,
-              asio::io_context& ctx, bool doFsync)
+              asio::io_context& ctx, bool doFsync, uint32_t outputLevel)
 {
     ZoneScoped;
     // This is the key operation in the scheme: merging two (read-only)
@@ -799,10 +926,17 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
     auto timer = bucketManager.getMergeTimer().TimeScope();
     BucketMetadata meta;
     meta.ledgerVersion = protocolVersion;
-    BucketOutputIterator out(bucketManager.getTmpDir(), keepDeadEntries, meta,
-                             mc, ctx, doFsync);
+    BucketOutputIterator out(bucketManager.getTmpDirForLevel(outputLevel),
+                             keepDeadEntries, meta, mc, ctx, doFsync);
+
+    // Merge output is at most about the size of its inputs
+    size_t estimatedSize = oldBucket->getSize() + newBucket->getSize();
+    out.preallocate(estimatedSize);
+    auto bypassSize =
+        bucketManager.getConfig().BUCKETLIST_DB_MERGE_CACHE_BYPASS_SIZE *
+        1000000;
+    out.setDropCacheBehind(bypassSize != 0 && estimatedSize >= bypassSize);
 
-    BucketEntryIdCmp cmp;
     size_t iter = 0;
 
     while (oi || ni)
@@ -821,8 +955,8 @@ Bucket::merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
             }
         }
 
-        if (!mergeCasesWithDefaultAcceptance(cmp, mc, oi, ni, out,
-                                             shadowIterators, protocolVersion,
+        if (!mergeCasesWithDefaultAcceptance(mc, oi, ni, out, shadowIterators,
+                                             protocolVersion,
                                              keepShadowedLifecycleEntries))
         {
             mergeCasesWithEqualKeys(mc, oi, ni, out, shadowIterators,
@@ -8,7 +8,9 @@
 #include "util/NonCopyable.h"
 #include "util/ProtocolVersion.h"
 #include "xdr/Stellar-ledger.h"
+#include <atomic>
 #include <list>
+#include <mutex>
 #include <optional>
 #include <string>
 
@@ -39,10 +41,13 @@ namespace stellar
 
 class AbstractLedgerTxn;
 class Application;
+class BucketIndexBudget;
 class BucketManager;
 class SearchableBucketListSnapshot;
 struct EvictionResultEntry;
 class EvictionStatistics;
+class MmapFile;
+class XDRInputFileStream;
 
 class Bucket : public std::enable_shared_from_this<Bucket>,
                public NonMovableOrCopyable
@@ -51,14 +56,56 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     Hash const mHash;
     size_t mSize{0};
 
-    std::unique_ptr<BucketIndex const> mIndex{};
+    // Guarded by mIndexMutex. If mIndexBudget is set, the index is persisted
+    // on disk and may be dropped by the budget at any time, in which case
+    // getIndex() reloads it. Readers hold the index by shared_ptr, so a
+    // concurrent drop never invalidates an in-progress lookup.
+    mutable std::shared_ptr<BucketIndex const> mIndex{};
+    mutable size_t mIndexBytes{0};
+    mutable std::shared_ptr<BucketIndexBudget> mIndexBudget{};
+    mutable std::mutex mIndexMutex;
+    mutable std::atomic<uint64_t> mLastIndexAccess{0};
+
+    // Read-only mapping of the bucket file, shared by all BucketSnapshots of
+    // this bucket that read via mmap. Lazily constructed under mMappedFileMutex.
+    mutable std::shared_ptr<MmapFile const> mMappedFile{};
+    mutable std::mutex mMappedFileMutex;
+
+    // Returns index, reloading it if it was dropped by the index budget.
+    // Throws if index not yet initialized. Threadsafe.
+    std::shared_ptr<BucketIndex const> getIndex() const;
+
+    // Called by BucketIndexBudget only, see BucketIndexBudget.h
+    void setIndexBudget(std::shared_ptr<BucketIndexBudget> budget) const;
+    size_t getResidentIndexBytes() const;
+    uint64_t
+    getLastIndexAccess() const
+    {
+        return mLastIndexAccess;
+    }
 
-    // Returns index, throws if index not yet initialized
-    BucketIndex const& getIndex() const;
+    // Drops the index from memory and returns the number of bytes freed
+    size_t dropIndex() const;
+
+    // Returns (lazily-constructed) read-only mapping of the bucket file.
+    // Threadsafe.
+    std::shared_ptr<MmapFile const> getMappedFile() const;
 
     static std::string randomFileName(std::string const& tmpDir,
                                       std::string ext);
 
+    // Read-ahead used by eviction scans, which read [offset, offset +
+    // bytesToScan) sequentially once per ledger. The stream buffer is sized
+    // to the scan but capped, so that the bytes actually read from the file
+    // stay close to the scan budget.
+    static constexpr size_t EVICTION_SCAN_MIN_READ_BUFFER = 4096;
+    static constexpr size_t EVICTION_SCAN_MAX_READ_BUFFER = 1024 * 1024;
+
+    // Opens stream on the bucket file at offset for an eviction scan of about
+    // bytesToScan bytes, and asks the kernel to read that whole window ahead.
+    void openForEvictionScan(XDRInputFileStream& stream, size_t offset,
+                             size_t bytesToScan) const;
+
   public:
     // Create an empty bucket. The empty bucket has hash '000000...' and its
     // filename is the empty string.
@@ -91,6 +138,16 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const;
 
+    // Returns [lowerBound, upperBound) of file offsets for all contract code
+    // and TTL entries in the bucket, or std::nullopt if none exist
+    std::optional<std::pair<std::streamoff, std::streamoff>>
+    getContractCodeAndTTLRange() const;
+
+    // Returns [lowerBound, upperBound) of file offsets for all liquidity pool
+    // entries in the bucket, or std::nullopt if none exist
+    std::optional<std::pair<std::streamoff, std::streamoff>>
+    getLiquidityPoolRange() const;
+
     // Sets index, throws if index is already set
     void setIndex(std::unique_ptr<BucketIndex const>&& index);
 
@@ -121,10 +178,18 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // tombstone), deletes the corresponding entry in the database.
     void apply(Application& app) const;
 
+    // Reference is only stable if the bucket is not tracked by a
+    // BucketIndexBudget
     BucketIndex const&
     getIndexForTesting() const
     {
-        return getIndex();
+        return *getIndex();
+    }
+
+    bool
+    isIndexResidentForTesting() const
+    {
+        return getResidentIndexBytes() > 0;
     }
 
 #endif // BUILD_TESTS
@@ -147,6 +212,11 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
                          std::list<EvictionResultEntry>& evictableKeys,
                          SearchableBucketListSnapshot& bl) const;
 
+    // Asks the kernel to start reading [offset, offset + len) of the bucket
+    // file into the page cache without waiting for it, so that the eviction
+    // scan of the next ledger does not block on the device.
+    void prefetchForEvictionScan(size_t offset, size_t len) const;
+
     // Create a fresh bucket from given vectors of init (created) and live
     // (updated) LedgerEntries, and dead LedgerEntryKeys. The bucket will
     // be sorted, hashed, and adopted in the provided BucketManager.
@@ -168,18 +238,22 @@ class Bucket : public std::enable_shared_from_this<Bucket>,
     // `maxProtocolVersion` bounds this (for error checking) and should usually
     // be the protocol of the ledger header at which the merge is starting. An
     // exception will be thrown if any provided bucket versions exceed it.
+    //
+    // `outputLevel` is the BucketList level the output will live at, which
+    // selects the storage tier the output is written to.
     static std::shared_ptr<Bucket>
     merge(BucketManager& bucketManager, uint32_t maxProtocolVersion,
           std::shared_ptr<Bucket> const& oldBucket,
           std::shared_ptr<Bucket> const& newBucket,
           std::vector<std::shared_ptr<Bucket>> const& shadows,
           bool keepDeadEntries, bool countMergeEvents, asio::io_context& ctx,
-          bool doFsync);
+          bool doFsync, uint32_t outputLevel = 0);
 
     static uint32_t getBucketVersion(std::shared_ptr<Bucket> const& bucket);
     static uint32_t
     getBucketVersion(std::shared_ptr<Bucket const> const& bucket);
 
     friend class BucketSnapshot;
+    friend class BucketIndexBudget;
 };
 }
@@ -10,8 +10,10 @@
 #include "ledger/LedgerTxnEntry.h"
 #include "main/Application.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include <fmt/format.h>
+#include <future>
 
 namespace stellar
 {
@@ -27,9 +29,11 @@ BucketApplicator::BucketApplicator(Application& app,
     , mMaxProtocolVersion(maxProtocolVersion)
     , mMinProtocolVersionSeen(minProtocolVersionSeen)
     , mLevel(level)
+    , mIsUsingBucketListDB(app.getConfig().isUsingBucketListDB())
     , mBucketIter(bucket)
     , mEntryTypeFilter(filter)
     , mSeenKeys(seenKeys)
+    , mSize(mBucketIter.size())
 {
     auto protocolVersion = mBucketIter.getMetadata().ledgerVersion;
     if (protocolVersion > mMaxProtocolVersion)
@@ -41,7 +45,7 @@ BucketApplicator::BucketApplicator(Application& app,
     }
 
     // Only apply offers if BucketListDB is enabled
-    if (mApp.getConfig().isUsingBucketListDB() && !bucket->isEmpty())
+    if (mIsUsingBucketListDB && !bucket->isEmpty())
     {
         auto offsetOp = bucket->getOfferRange();
         if (offsetOp)
@@ -56,28 +60,37 @@ BucketApplicator::BucketApplicator(Application& app,
             mOffersRemaining = false;
         }
     }
+
+    mPos = mBucketIter.pos();
+    mDone = !hasMoreToRead();
 }
 
-BucketApplicator::operator bool() const
+bool
+BucketApplicator::hasMoreToRead() const
 {
-    // There is more work to do (i.e. (bool) *this == true) iff:
+    // There is more work to do iff:
     // 1. The underlying bucket iterator is not EOF and
     // 2. Either BucketListDB is not enabled (so we must apply all entry types)
     //    or BucketListDB is enabled and we have offers still remaining.
     return static_cast<bool>(mBucketIter) &&
-           (!mApp.getConfig().isUsingBucketListDB() || mOffersRemaining);
+           (!mIsUsingBucketListDB || mOffersRemaining);
+}
+
+BucketApplicator::operator bool() const
+{
+    return !mDone;
 }
 
 size_t
 BucketApplicator::pos()
 {
-    return mBucketIter.pos();
+    return mPos;
 }
 
 size_t
 BucketApplicator::size() const
 {
-    return mBucketIter.size();
+    return mSize;
 }
 
 static bool
@@ -97,38 +110,20 @@ shouldApplyEntry(std::function<bool(LedgerEntryType)> const& filter,
     return filter(e.deadEntry().type());
 }
 
-size_t
-BucketApplicator::advance(BucketApplicator::Counters& counters)
+// Reads the next batch of entries to apply. Does not touch the database, so
+// it may run on a background thread while the previous batch is written.
+BucketApplicator::Batch
+BucketApplicator::readBatch()
 {
-    size_t count = 0;
-
-    auto& root = mApp.getLedgerTxnRoot();
-    AbstractLedgerTxn* ltx;
-    std::unique_ptr<LedgerTxn> innerLtx;
-
-    // when running in memory mode, make changes to the in memory ledger
-    // directly instead of creating a temporary inner LedgerTxn
-    // as "advance" commits changes during each step this does not introduce any
-    // new failure mode
-    if (mApp.getConfig().MODE_USES_IN_MEMORY_LEDGER)
-    {
-        ltx = static_cast<AbstractLedgerTxn*>(&root);
-    }
-    else
-    {
-        innerLtx = std::make_unique<LedgerTxn>(root, false);
-        ltx = innerLtx.get();
-        ltx->prepareNewObjects(LEDGER_ENTRY_BATCH_COMMIT_SIZE);
-    }
-
+    ZoneScoped;
+    Batch batch;
     for (; mBucketIter; ++mBucketIter)
     {
         // Note: mUpperBoundOffset is not inclusive. However, mBucketIter.pos()
         // returns the file offset at the end of the currently loaded entry.
         // This means we must read until pos is strictly greater than the upper
         // bound so that we don't skip the last offer in the range.
-        auto isUsingBucketListDB = mApp.getConfig().isUsingBucketListDB();
-        if (isUsingBucketListDB && mBucketIter.pos() > mUpperBoundOffset)
+        if (mIsUsingBucketListDB && mBucketIter.pos() > mUpperBoundOffset)
         {
             mOffersRemaining = false;
             break;
@@ -139,7 +134,7 @@ BucketApplicator::advance(BucketApplicator::Counters& counters)
 
         if (shouldApplyEntry(mEntryTypeFilter, e))
         {
-            if (isUsingBucketListDB)
+            if (mIsUsingBucketListDB)
             {
                 if (e.type() == LIVEENTRY || e.type() == INITENTRY)
                 {
@@ -160,81 +155,132 @@ BucketApplicator::advance(BucketApplicator::Counters& counters)
                 }
             }
 
-            counters.mark(e);
+            batch.mEntries.emplace_back(e);
+            if (batch.mEntries.size() > LEDGER_ENTRY_BATCH_COMMIT_SIZE)
+            {
+                ++mBucketIter;
+                break;
+            }
+        }
+    }
+
+    batch.mDone = !hasMoreToRead();
+    batch.mPos = mBucketIter.pos();
+    return batch;
+}
 
-            if (e.type() == LIVEENTRY || e.type() == INITENTRY)
+void
+BucketApplicator::applyBatch(AbstractLedgerTxn& ltx, Batch const& batch,
+                             Counters& counters) const
+{
+    ZoneScoped;
+    for (auto const& e : batch.mEntries)
+    {
+        counters.mark(e);
+
+        if (e.type() == LIVEENTRY || e.type() == INITENTRY)
+        {
+            // The last level can have live entries, but at that point we
+            // know that they are actually init entries because the earliest
+            // state of all entries is init, so we mark them as such here
+            if (mLevel == BucketList::kNumLevels - 1 && e.type() == LIVEENTRY)
             {
-                // The last level can have live entries, but at that point we
-                // know that they are actually init entries because the earliest
-                // state of all entries is init, so we mark them as such here
-                if (mLevel == BucketList::kNumLevels - 1 &&
-                    e.type() == LIVEENTRY)
-                {
-                    ltx->createWithoutLoading(e.liveEntry());
-                }
-                else if (
-                    protocolVersionIsBefore(
-                        mMinProtocolVersionSeen,
-                        Bucket::
-                            FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY))
+                ltx.createWithoutLoading(e.liveEntry());
+            }
+            else if (protocolVersionIsBefore(
+                         mMinProtocolVersionSeen,
+                         Bucket::
+                             FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY))
+            {
+                // Prior to protocol 11, INITENTRY didn't exist, so we need
+                // to check ltx to see if this is an update or a create
+                auto key = InternalLedgerEntry(e.liveEntry()).toKey();
+                if (ltx.getNewestVersion(key))
                 {
-                    // Prior to protocol 11, INITENTRY didn't exist, so we need
-                    // to check ltx to see if this is an update or a create
-                    auto key = InternalLedgerEntry(e.liveEntry()).toKey();
-                    if (ltx->getNewestVersion(key))
-                    {
-                        ltx->updateWithoutLoading(e.liveEntry());
-                    }
-                    else
-                    {
-                        ltx->createWithoutLoading(e.liveEntry());
-                    }
+                    ltx.updateWithoutLoading(e.liveEntry());
                 }
                 else
                 {
-                    if (e.type() == LIVEENTRY)
-                    {
-                        ltx->updateWithoutLoading(e.liveEntry());
-                    }
-                    else
-                    {
-                        ltx->createWithoutLoading(e.liveEntry());
-                    }
+                    ltx.createWithoutLoading(e.liveEntry());
                 }
             }
             else
             {
-                releaseAssertOrThrow(!isUsingBucketListDB);
-                if (protocolVersionIsBefore(
-                        mMinProtocolVersionSeen,
-                        Bucket::
-                            FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY))
+                if (e.type() == LIVEENTRY)
                 {
-                    // Prior to protocol 11, DEAD entries could exist
-                    // without LIVE entries in between
-                    if (ltx->getNewestVersion(e.deadEntry()))
-                    {
-                        ltx->eraseWithoutLoading(e.deadEntry());
-                    }
+                    ltx.updateWithoutLoading(e.liveEntry());
                 }
                 else
                 {
-                    ltx->eraseWithoutLoading(e.deadEntry());
+                    ltx.createWithoutLoading(e.liveEntry());
                 }
             }
-
-            if ((++count > LEDGER_ENTRY_BATCH_COMMIT_SIZE))
+        }
+        else
+        {
+            releaseAssertOrThrow(!mIsUsingBucketListDB);
+            if (protocolVersionIsBefore(
+                    mMinProtocolVersionSeen,
+                    Bucket::FIRST_PROTOCOL_SUPPORTING_INITENTRY_AND_METAENTRY))
             {
-                ++mBucketIter;
-                break;
+                // Prior to protocol 11, DEAD entries could exist
+                // without LIVE entries in between
+                if (ltx.getNewestVersion(e.deadEntry()))
+                {
+                    ltx.eraseWithoutLoading(e.deadEntry());
+                }
+            }
+            else
+            {
+                ltx.eraseWithoutLoading(e.deadEntry());
             }
         }
     }
+}
+
+size_t
+BucketApplicator::advance(BucketApplicator::Counters& counters)
+{
+    ZoneScoped;
+    releaseAssert(!mDone);
+
+    // Take the batch prefetched by the previous call, if any, and start
+    // reading the next one before writing this one
+    auto batch = mNextBatch.valid() ? mNextBatch.get() : readBatch();
+    mDone = batch.mDone;
+    mPos = batch.mPos;
+    if (!mDone)
+    {
+        mNextBatch =
+            std::async(std::launch::async, [this]() { return readBatch(); });
+    }
+
+    auto& root = mApp.getLedgerTxnRoot();
+    AbstractLedgerTxn* ltx;
+    std::unique_ptr<LedgerTxn> innerLtx;
+
+    // when running in memory mode, make changes to the in memory ledger
+    // directly instead of creating a temporary inner LedgerTxn
+    // as "advance" commits changes during each step this does not introduce any
+    // new failure mode
+    if (mApp.getConfig().MODE_USES_IN_MEMORY_LEDGER)
+    {
+        ltx = static_cast<AbstractLedgerTxn*>(&root);
+    }
+    else
+    {
+        innerLtx = std::make_unique<LedgerTxn>(root, false);
+        ltx = innerLtx.get();
+        ltx->prepareNewObjects(LEDGER_ENTRY_BATCH_COMMIT_SIZE);
+    }
+
+    applyBatch(*ltx, batch, counters);
     if (innerLtx)
     {
         ltx->commit();
     }
 
+    auto count = batch.mEntries.size();
     mCount += count;
     return count;
 }
@@ -7,30 +7,63 @@
 #include "bucket/Bucket.h"
 #include "bucket/BucketInputIterator.h"
 #include "util/Timer.h"
+#include <future>
 #include <memory>
+#include <vector>
 
 namespace stellar
 {
 
+class AbstractLedgerTxn;
 class Application;
 
 // Class that represents a single apply-bucket-to-database operation in
 // progress. Used during history catchup to split up the task of applying
 // bucket into scheduler-friendly, bite-sized pieces.
-
+//
+// Each call to advance() writes one batch of entries to the database on the
+// calling thread, while the next batch is read, checked and deduplicated from
+// the bucket file on a background thread. Batches are still written strictly
+// in bucket order, so shadowing semantics are unchanged.
 class BucketApplicator
 {
+    // Entries read from the bucket that are to be written by one advance()
+    struct Batch
+    {
+        std::vector<BucketEntry> mEntries;
+
+        // True if there is nothing left to read after this batch
+        bool mDone{false};
+
+        // Position of the bucket iterator after reading this batch
+        size_t mPos{0};
+    };
+
     Application& mApp;
     uint32_t mMaxProtocolVersion;
     uint32_t mMinProtocolVersionSeen;
     uint32_t mLevel;
+    bool const mIsUsingBucketListDB;
+
+    // Only accessed by readBatch(), which runs on at most one thread at a time
     BucketInputIterator mBucketIter;
-    size_t mCount{0};
     std::function<bool(LedgerEntryType)> mEntryTypeFilter;
     std::unordered_set<LedgerKey>& mSeenKeys;
     std::streamoff mUpperBoundOffset;
     bool mOffersRemaining{true};
 
+    size_t const mSize;
+    size_t mCount{0};
+    size_t mPos{0};
+    bool mDone{false};
+
+    // Must be last, so that an in-flight read finishes before any member it
+    // uses is destroyed
+    std::future<Batch> mNextBatch;
+
+    bool hasMoreToRead() const;
+    Batch readBatch();
+
   public:
     class Counters
     {
@@ -65,6 +98,11 @@ class BucketApplicator
                       VirtualClock::time_point now);
     };
 
+  private:
+    void applyBatch(AbstractLedgerTxn& ltx, Batch const& batch,
+                    Counters& counters) const;
+
+  public:
     // If newOffersOnly is true, only offers are applied. Additionally, the
     // offer is only applied iff:
     //    1. They are of type INITENTRY or LIVEENTRY
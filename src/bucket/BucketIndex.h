@@ -66,7 +66,11 @@ class BucketIndex : public NonMovableOrCopyable
         }
     };
 
-    using IndividualEntry = LedgerKey;
+    // Individual indexes store a 64-bit fingerprint of each key rather than
+    // the key itself, sorted by fingerprint. A fingerprint match only means
+    // the key is likely at that offset, so readers must compare the full key
+    // after reading the entry.
+    using IndividualEntry = uint64_t;
     using RangeIndex = std::vector<std::pair<RangeEntry, std::streamoff>>;
     using IndividualIndex =
         std::vector<std::pair<IndividualEntry, std::streamoff>>;
@@ -74,7 +78,7 @@ class BucketIndex : public NonMovableOrCopyable
                                   IndividualIndex::const_iterator>;
 
     inline static const std::string DB_BACKEND_STATE = "bl";
-    inline static const uint32_t BUCKET_INDEX_VERSION = 2;
+    inline static const uint32_t BUCKET_INDEX_VERSION = 5;
 
     // Returns true if LedgerEntryType not supported by BucketListDB
     static bool typeNotSupported(LedgerEntryType t);
@@ -87,11 +91,22 @@ class BucketIndex : public NonMovableOrCopyable
     createIndex(BucketManager& bm, std::filesystem::path const& filename,
                 Hash const& hash);
 
-    // Loads index from given file. If file does not exist or if saved
-    // index does not have same parameters as current config, return null
+#ifdef BUILD_TESTS
+    // Same as createIndex, but with an explicit number of indexing threads
+    // instead of BUCKETLIST_DB_INDEX_THREADS
+    static std::unique_ptr<BucketIndex const>
+    createIndexForTesting(BucketManager& bm,
+                          std::filesystem::path const& filename,
+                          Hash const& hash, size_t numThreads);
+#endif
+
+    // Loads index from given file. If file does not exist, return null. If the
+    // saved index is corrupt, was built for a bucket other than bucketHash, or
+    // does not have same parameters as current config, return null so that
+    // the caller rebuilds it.
     static std::unique_ptr<BucketIndex const>
     load(BucketManager const& bm, std::filesystem::path const& filename,
-         size_t bucketFileSize);
+         Hash const& bucketHash, size_t bucketFileSize);
 
     virtual ~BucketIndex() = default;
 
@@ -103,7 +118,8 @@ class BucketIndex : public NonMovableOrCopyable
     // Returns pair of:
     // file offset in the bucket file for k, or std::nullopt if not found
     // iterator that points to the first index entry not less than k, or
-    // BucketIndex::end()
+    // BucketIndex::end(). Individual indexes are not in key order, so they
+    // search the whole index and return start unchanged.
     virtual std::pair<std::optional<std::streamoff>, Iterator>
     scan(Iterator start, LedgerKey const& k) const = 0;
 
@@ -123,6 +139,17 @@ class BucketIndex : public NonMovableOrCopyable
     virtual std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const = 0;
 
+    // Returns lower bound and upper bound for the positions of CONTRACT_CODE
+    // and TTL entries (and the CONFIG_SETTING entries sorted between them) in
+    // the given bucket, or std::nullopt if there are none
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getContractCodeAndTTLRange() const = 0;
+
+    // Returns lower bound and upper bound for liquidity pool entry positions
+    // in the given bucket, or std::nullopt if no pools exist
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getLiquidityPoolRange() const = 0;
+
     // Returns page size for index. InidividualIndex returns 0 for page size
     virtual std::streamoff getPageSize() const = 0;
 
@@ -130,11 +157,20 @@ class BucketIndex : public NonMovableOrCopyable
 
     virtual Iterator end() const = 0;
 
+    // Returns approximate heap and object size of the index, in bytes
+    virtual size_t getMemoryUsage() const = 0;
+
     virtual void markBloomMiss() const = 0;
     virtual void markBloomLookup() const = 0;
 
 #ifdef BUILD_TESTS
     virtual bool operator==(BucketIndex const& inRaw) const = 0;
 #endif
+
+  private:
+    static std::unique_ptr<BucketIndex const>
+    createIndexWithThreads(BucketManager& bm,
+                           std::filesystem::path const& filename,
+                           Hash const& hash, size_t numThreads);
 };
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketIndexBudget.h"
+#include "bucket/Bucket.h"
+#include "bucket/BucketIndex.h"
+#include "bucket/BucketManager.h"
+#include "crypto/Hex.h"
+#include "util/Fs.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include <algorithm>
+
+namespace stellar
+{
+
+BucketIndexBudget::BucketIndexBudget(BucketManager& bm,
+                                     medida::MetricsRegistry& metrics,
+                                     size_t maxBytes)
+    : mBucketManager(bm)
+    , mMaxBytes(maxBytes)
+    , mResidentBytesCounter(
+          metrics.NewCounter({"bucketlistDB", "index", "resident-bytes"}))
+    , mEvictMeter(
+          metrics.NewMeter({"bucketlistDB", "index", "evict"}, "index"))
+    , mReloadTimer(metrics.NewTimer({"bucketlistDB", "index", "reload"}))
+{
+    releaseAssert(mMaxBytes > 0);
+}
+
+void
+BucketIndexBudget::track(std::shared_ptr<Bucket const> const& b)
+{
+    releaseAssert(b);
+    b->setIndexBudget(shared_from_this());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTracked.emplace_back(b);
+    enforceBudget(mMaxBytes);
+}
+
+std::shared_ptr<BucketIndex const>
+BucketIndexBudget::reload(Bucket const& b)
+{
+    ZoneScoped;
+    auto timer = mReloadTimer.TimeScope();
+    auto indexFilename = mBucketManager.bucketIndexFilename(b.getHash());
+
+    std::unique_ptr<BucketIndex const> index;
+    if (fs::exists(indexFilename))
+    {
+        index = BucketIndex::load(mBucketManager, indexFilename, b.getHash(),
+                                  b.getSize());
+    }
+
+    if (!index)
+    {
+        CLOG_WARNING(Bucket, "Rebuilding dropped index for bucket {}",
+                     hexAbbrev(b.getHash()));
+        index =
+            BucketIndex::createIndex(mBucketManager, b.getFilename(), b.getHash());
+        if (!index)
+        {
+            throw std::runtime_error(
+                "Failed to reload bucket index due to BucketManager shutdown");
+        }
+    }
+
+    CLOG_TRACE(Bucket, "Reloaded index for bucket {}", hexAbbrev(b.getHash()));
+    return std::shared_ptr<BucketIndex const>(std::move(index));
+}
+
+void
+BucketIndexBudget::onIndexLoaded()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    enforceBudget(mMaxBytes);
+}
+
+size_t
+BucketIndexBudget::collectLive(std::vector<std::shared_ptr<Bucket const>>& live)
+{
+    size_t residentBytes = 0;
+    auto it = mTracked.begin();
+    while (it != mTracked.end())
+    {
+        auto b = it->lock();
+        if (!b)
+        {
+            it = mTracked.erase(it);
+            continue;
+        }
+
+        residentBytes += b->getResidentIndexBytes();
+        live.emplace_back(std::move(b));
+        ++it;
+    }
+    return residentBytes;
+}
+
+void
+BucketIndexBudget::enforceBudget(size_t maxBytes)
+{
+    ZoneScoped;
+    std::vector<std::shared_ptr<Bucket const>> live;
+    auto residentBytes = collectLive(live);
+
+    if (residentBytes > maxBytes)
+    {
+        // Snapshot access times first, they change concurrently with readers
+        std::vector<std::pair<uint64_t, Bucket const*>> byAccess;
+        byAccess.reserve(live.size());
+        for (auto const& b : live)
+        {
+            byAccess.emplace_back(b->getLastIndexAccess(), b.get());
+        }
+        std::sort(byAccess.begin(), byAccess.end());
+
+        for (auto const& [_, b] : byAccess)
+        {
+            if (residentBytes <= maxBytes)
+            {
+                break;
+            }
+
+            auto freed = b->dropIndex();
+            if (freed > 0)
+            {
+                releaseAssert(residentBytes >= freed);
+                residentBytes -= freed;
+                mEvictMeter.Mark();
+            }
+        }
+    }
+
+    mResidentBytesCounter.set_count(residentBytes);
+}
+
+void
+BucketIndexBudget::shrinkTo(size_t maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    enforceBudget(std::min(maxBytes, mMaxBytes));
+}
+
+size_t
+BucketIndexBudget::getResidentBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    size_t residentBytes = 0;
+    for (auto const& w : mTracked)
+    {
+        if (auto b = w.lock())
+        {
+            residentBytes += b->getResidentIndexBytes();
+        }
+    }
+    return residentBytes;
+}
+}
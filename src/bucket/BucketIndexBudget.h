@@ -0,0 +1,92 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class MetricsRegistry;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Bucket;
+class BucketIndex;
+class BucketManager;
+
+// Bounds the memory used by BucketIndexes whose persisted index file is on
+// disk. Once the tracked indexes exceed the budget, the least recently used
+// ones are dropped from memory and transparently reloaded from their index
+// file by Bucket::getIndex() on the next lookup. Readers hold indexes by
+// shared_ptr, so dropping an index never invalidates an in-progress lookup.
+//
+// Indexes without a persisted file are not tracked and stay resident.
+//
+// Threadsafe. Lock order is budget, then bucket: Bucket never calls into the
+// budget while holding its own index mutex.
+class BucketIndexBudget
+    : public std::enable_shared_from_this<BucketIndexBudget>,
+      public NonMovableOrCopyable
+{
+    BucketManager& mBucketManager;
+    size_t const mMaxBytes;
+
+    mutable std::mutex mMutex;
+    std::vector<std::weak_ptr<Bucket const>> mTracked;
+
+    std::atomic<uint64_t> mAccessClock{0};
+
+    medida::Counter& mResidentBytesCounter;
+    medida::Meter& mEvictMeter;
+    medida::Timer& mReloadTimer;
+
+    // Returns the resident bytes of all live tracked buckets, forgetting
+    // buckets that have been garbage collected. Requires mMutex.
+    size_t collectLive(std::vector<std::shared_ptr<Bucket const>>& live);
+
+    // Drops least recently used indexes until at most maxBytes are resident.
+    // Requires mMutex.
+    void enforceBudget(size_t maxBytes);
+
+  public:
+    BucketIndexBudget(BucketManager& bm, medida::MetricsRegistry& metrics,
+                      size_t maxBytes);
+
+    // Starts tracking b, whose index must be resident and persisted on disk
+    void track(std::shared_ptr<Bucket const> const& b);
+
+    // Returns a monotonically increasing access timestamp
+    uint64_t
+    tick()
+    {
+        return ++mAccessClock;
+    }
+
+    // Loads b's index from its persisted file, rebuilding it if the file is
+    // missing or stale
+    std::shared_ptr<BucketIndex const> reload(Bucket const& b);
+
+    // Called by Bucket after reloading its index, without holding the
+    // bucket's index mutex
+    void onIndexLoaded();
+
+    // Drops least recently used indexes until at most maxBytes are resident,
+    // for the MemoryBudget. Indexes are reloaded on demand afterwards, within
+    // the budget this was constructed with.
+    void shrinkTo(size_t maxBytes);
+
+    size_t getResidentBytes() const;
+};
+}
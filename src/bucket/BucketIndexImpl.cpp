@@ -12,9 +12,10 @@
 #include "util/Logging.h"
 #include "util/XDRCereal.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
+#include "util/siphash.h"
 
 #include "lib/bloom_filter.hpp"
-#include <Tracy.hpp>
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/memory.hpp>
 #include <cereal/types/utility.hpp>
@@ -22,6 +23,7 @@
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 
+#include <future>
 #include <thread>
 
 namespace stellar
@@ -62,11 +64,172 @@ BucketIndex::typeNotSupported(LedgerEntryType t)
     return t == OFFER;
 }
 
+// Returns the file offsets at which to split a range indexed bucket file into
+// at most numChunks chunks of roughly equal size. Every split point is a
+// record that begins a new index page in a sequential scan, and
+// pageUpperBound only depends on the position of the record that began the
+// current page, so indexing each chunk independently and concatenating the
+// results yields exactly the sequential index. Only XDR record headers are
+// parsed here, so this is much cheaper than a full indexing pass.
+static std::vector<std::streamoff>
+findChunkStarts(std::filesystem::path const& filename, size_t fileSize,
+                std::streamoff pageSize, size_t numChunks)
+{
+    ZoneScoped;
+    std::vector<std::streamoff> starts{0};
+    auto const targetChunkSize =
+        static_cast<std::streamoff>(fileSize / numChunks);
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), filename));
+    }
+
+    std::vector<char> buf(1 << 20);
+    std::streamoff bufStart = 0;
+    std::streamoff bufLen = 0;
+    std::streamoff pos = 0;
+    std::streamoff pageUpperBound = 0;
+    auto const end = static_cast<std::streamoff>(fileSize);
+    while (pos + 4 <= end && starts.size() < numChunks)
+    {
+        if (pos + 4 > bufStart + bufLen)
+        {
+            bufStart = pos;
+            in.clear();
+            in.seekg(pos);
+            in.read(buf.data(), buf.size());
+            bufLen = in.gcount();
+            if (bufLen < 4)
+            {
+                break;
+            }
+        }
+
+        if (pos >= pageUpperBound)
+        {
+            if (pos >= targetChunkSize * static_cast<std::streamoff>(
+                                             starts.size()))
+            {
+                starts.emplace_back(pos);
+            }
+            pageUpperBound = roundDown(pos, pageSize) + pageSize;
+        }
+
+        pos += 4 + XDRInputFileStream::getXDRSize(buf.data() + (pos - bufStart));
+    }
+
+    return starts;
+}
+
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::indexChunk(BucketManager const& bm,
+                                    std::filesystem::path const& filename,
+                                    std::streamoff begin, std::streamoff end,
+                                    IndexChunk& out) const
+{
+    ZoneScoped;
+    XDRInputFileStream in;
+    in.open(filename.string());
+    in.seek(begin);
+    std::streamoff pos = begin;
+    std::streamoff pageUpperBound = 0;
+    BucketEntry be;
+    size_t iter = 0;
+    while (pos < end && in && in.readOne(be))
+    {
+        // peridocially check if bucket manager is exiting to stop indexing
+        // gracefully
+        if (++iter >= 1000)
+        {
+            iter = 0;
+            if (bm.isShutdown())
+            {
+                throw std::runtime_error("Incomplete bucket index due to "
+                                         "BucketManager shutdown");
+            }
+        }
+
+        if (be.type() != METAENTRY)
+        {
+            ++out.count;
+            LedgerKey key = getBucketLedgerKey(be);
+
+            // We need an asset to poolID mapping for
+            // loadPoolshareTrustlineByAccountAndAsset queries. For this
+            // query, we only need to index INIT entries because:
+            // 1. PoolID is the hash of the Assets it refers to, so this
+            //    index cannot be invalidated by newer LIVEENTRY updates
+            // 2. We do a join over all bucket indexes so we avoid storing
+            //    multiple redundant index entries (i.e. LIVEENTRY updates)
+            // 3. We only use this index to collect the possible set of
+            //    Trustline keys, then we load those keys. This means that
+            //    we don't need to keep track of DEADENTRY. Even if a given
+            //    INITENTRY has been deleted by a newer DEADENTRY, the
+            //    trustline load will not return deleted trustlines, so the
+            //    load result is still correct even if the index has a few
+            //    deleted mappings.
+            if (be.type() == INITENTRY && key.type() == LIQUIDITY_POOL)
+            {
+                auto const& poolParams = be.liveEntry()
+                                             .data.liquidityPool()
+                                             .body.constantProduct()
+                                             .params;
+                out.assetToPoolID[poolParams.assetA].emplace_back(
+                    key.liquidityPool().liquidityPoolID);
+                out.assetToPoolID[poolParams.assetB].emplace_back(
+                    key.liquidityPool().liquidityPoolID);
+            }
+
+            if constexpr (std::is_same<IndexT, RangeIndex>::value)
+            {
+                if (pos >= pageUpperBound)
+                {
+                    pageUpperBound =
+                        roundDown(pos, mData.pageSize) + mData.pageSize;
+                    out.keysToOffset.emplace_back(RangeEntry(key, key), pos);
+                }
+                else
+                {
+                    auto& rangeEntry = out.keysToOffset.back().first;
+                    releaseAssert(rangeEntry.upperBound < key);
+                    rangeEntry.upperBound = key;
+                }
+
+                auto keybuf = xdr::xdr_to_opaque(key);
+                if (mData.fuseFilter)
+                {
+                    out.fuseKeyHashes.emplace_back(mData.fuseFilter->hashBytes(
+                        keybuf.data(), keybuf.size()));
+                }
+                else
+                {
+                    out.filter->insert(keybuf.data(), keybuf.size());
+                }
+            }
+            else
+            {
+                out.keysToOffset.emplace_back(fingerprint(key), pos);
+                if (out.typeStarts.empty() ||
+                    out.typeStarts.back().first != key.type())
+                {
+                    out.typeStarts.emplace_back(key.type(), pos);
+                }
+            }
+        }
+
+        pos = in.pos();
+    }
+}
+
 template <class IndexT>
 BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
                                          std::filesystem::path const& filename,
                                          std::streamoff pageSize,
-                                         Hash const& hash)
+                                         Hash const& hash, size_t numThreads)
     : mBloomMissMeter(bm.getBloomMissMeter())
     , mBloomLookupMeter(bm.getBloomLookupMeter())
 {
@@ -76,127 +239,212 @@ BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
     {
         auto timer = LogSlowExecution("Indexing bucket");
         mData.pageSize = pageSize;
+        mData.bucketHash = hash;
 
         size_t const estimatedLedgerEntrySize =
             xdr::xdr_traits<BucketEntry>::serial_size(BucketEntry{});
         auto fileSize = fs::size(filename.string());
         auto estimatedNumElems = fileSize / estimatedLedgerEntrySize;
 
-        // Initialize bloom filter for range index
+        // Large range indexed buckets are split into chunks that are indexed
+        // in parallel. Individual indexes are only used for small buckets.
+        std::vector<std::streamoff> chunkStarts{0};
         if constexpr (std::is_same<IndexT, RangeIndex>::value)
         {
-            ZoneNamedN(bloomInit, "bloomInit", true);
-            bloom_parameters params;
-            params.projected_element_count = estimatedNumElems;
-
-            // Our target false positive rate is 0.1% even though we set the
-            // bloom filter false positive rate to 0.05%. We do this because our
-            // entry count estimation can be an underestimation (we assume every
-            // BucketEntry is an account LiveEntry, but TTL and DEADENTRY are
-            // smaller). If we gave a larger entry count estimate, the size of
-            // our bloom filter would significantly increase. Instead, by
-            // setting the desired false positive rate to 0.05%, the bloom
-            // filter size stays approximately the same and we give ourselves an
-            // additional 10% of wiggle room on the estimation.
-            params.false_positive_probability = 0.0005; // 0.05%
-
-            params.random_seed = shortHash::getShortHashInitKey();
-            params.compute_optimal_parameters();
-            mData.filter = std::make_unique<bloom_filter>(params);
-            auto estimatedIndexEntries = fileSize / mData.pageSize;
-            CLOG_DEBUG(
-                Bucket,
-                "Bloom filter initialized with params: projected element count "
-                "{} false positive probability: {}, number of hashes: {}, "
-                "table size: {}",
-                params.projected_element_count,
-                params.false_positive_probability,
-                params.optimal_parameters.number_of_hashes,
-                params.optimal_parameters.table_size);
+            auto const minChunkSize =
+                MIN_PAGES_PER_INDEX_CHUNK * static_cast<size_t>(pageSize);
+            auto numChunks = std::min(numThreads, fileSize / minChunkSize);
+            if (numChunks > 1)
+            {
+                chunkStarts =
+                    findChunkStarts(filename, fileSize, pageSize, numChunks);
+            }
+        }
+
+        std::vector<IndexChunk> chunks(chunkStarts.size());
+
+        if constexpr (std::is_same<IndexT, IndividualIndex>::value)
+        {
+            mData.fingerprintKey = shortHash::getShortHashInitKey();
+        }
+
+        // Initialize filter for range index
+        if constexpr (std::is_same<IndexT, RangeIndex>::value)
+        {
+            mData.fuseFilterBits =
+                bm.getConfig().BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS;
+            if (mData.fuseFilterBits != 0)
+            {
+                mData.fuseFilter = std::make_unique<BinaryFuseFilter>(
+                    mData.fuseFilterBits, shortHash::getShortHashInitKey());
+                chunks.front().fuseKeyHashes.reserve(estimatedNumElems /
+                                                     chunks.size());
+            }
+            else
+            {
+                ZoneNamedN(bloomInit, "bloomInit", true);
+                bloom_parameters params;
+                params.projected_element_count = estimatedNumElems;
+
+                // Our target false positive rate is 0.1% even though we set
+                // the bloom filter false positive rate to 0.05%. We do this
+                // because our entry count estimation can be an underestimation
+                // (we assume every BucketEntry is an account LiveEntry, but TTL
+                // and DEADENTRY are smaller). If we gave a larger entry count
+                // estimate, the size of our bloom filter would significantly
+                // increase. Instead, by setting the desired false positive rate
+                // to 0.05%, the bloom filter size stays approximately the same
+                // and we give ourselves an additional 10% of wiggle room on the
+                // estimation.
+                params.false_positive_probability = 0.0005; // 0.05%
+
+                params.random_seed = shortHash::getShortHashInitKey();
+                params.compute_optimal_parameters();
+
+                // Every chunk fills its own filter with the full table size,
+                // so filters can be merged with a bitwise or
+                for (auto& chunk : chunks)
+                {
+                    chunk.filter = std::make_unique<bloom_filter>(params);
+                }
+                CLOG_DEBUG(Bucket,
+                           "Bloom filter initialized with params: projected "
+                           "element count {} false positive probability: {}, "
+                           "number of hashes: {}, table size: {}",
+                           params.projected_element_count,
+                           params.false_positive_probability,
+                           params.optimal_parameters.number_of_hashes,
+                           params.optimal_parameters.table_size);
+            }
 
             // We don't have a good way of estimating IndividualIndex size, so
             // only reserve range indexes
+            auto estimatedIndexEntries = fileSize / mData.pageSize;
             mData.keysToOffset.reserve(estimatedIndexEntries);
         }
 
-        XDRInputFileStream in;
-        in.open(filename.string());
-        std::streamoff pos = 0;
-        std::streamoff pageUpperBound = 0;
-        BucketEntry be;
-        size_t iter = 0;
-        size_t count = 0;
-        while (in && in.readOne(be))
+        auto chunkEnd = [&](size_t i) {
+            return i + 1 < chunkStarts.size()
+                       ? chunkStarts[i + 1]
+                       : std::numeric_limits<std::streamoff>::max();
+        };
+
+        if (chunks.size() == 1)
         {
-            // peridocially check if bucket manager is exiting to stop indexing
-            // gracefully
-            if (++iter >= 1000)
+            indexChunk(bm, filename, 0, chunkEnd(0), chunks.front());
+        }
+        else
+        {
+            CLOG_DEBUG(Bucket, "Indexing {} in {} parallel chunks",
+                       filename.filename(), chunks.size());
+
+            // The calling thread indexes the first chunk itself. Exceptions
+            // (i.e. shutdown) are rethrown by get() once all chunks finish.
+            std::vector<std::future<void>> futures;
+            for (size_t i = 1; i < chunks.size(); ++i)
             {
-                iter = 0;
-                if (bm.isShutdown())
-                {
-                    throw std::runtime_error("Incomplete bucket index due to "
-                                             "BucketManager shutdown");
-                }
+                futures.emplace_back(std::async(std::launch::async, [&, i]() {
+                    indexChunk(bm, filename, chunkStarts[i], chunkEnd(i),
+                               chunks[i]);
+                }));
             }
 
-            if (be.type() != METAENTRY)
+            std::exception_ptr firstError;
+            try
+            {
+                indexChunk(bm, filename, 0, chunkEnd(0), chunks.front());
+            }
+            catch (...)
             {
-                ++count;
-                LedgerKey key = getBucketLedgerKey(be);
-
-                // We need an asset to poolID mapping for
-                // loadPoolshareTrustlineByAccountAndAsset queries. For this
-                // query, we only need to index INIT entries because:
-                // 1. PoolID is the hash of the Assets it refers to, so this
-                //    index cannot be invalidated by newer LIVEENTRY updates
-                // 2. We do a join over all bucket indexes so we avoid storing
-                //    multiple redundant index entries (i.e. LIVEENTRY updates)
-                // 3. We only use this index to collect the possible set of
-                //    Trustline keys, then we load those keys. This means that
-                //    we don't need to keep track of DEADENTRY. Even if a given
-                //    INITENTRY has been deleted by a newer DEADENTRY, the
-                //    trustline load will not return deleted trustlines, so the
-                //    load result is still correct even if the index has a few
-                //    deleted mappings.
-                if (be.type() == INITENTRY && key.type() == LIQUIDITY_POOL)
+                firstError = std::current_exception();
+            }
+
+            for (auto& f : futures)
+            {
+                try
                 {
-                    auto const& poolParams = be.liveEntry()
-                                                 .data.liquidityPool()
-                                                 .body.constantProduct()
-                                                 .params;
-                    mData.assetToPoolID[poolParams.assetA].emplace_back(
-                        key.liquidityPool().liquidityPoolID);
-                    mData.assetToPoolID[poolParams.assetB].emplace_back(
-                        key.liquidityPool().liquidityPoolID);
+                    f.get();
                 }
-
-                if constexpr (std::is_same<IndexT, RangeIndex>::value)
+                catch (...)
                 {
-                    if (pos >= pageUpperBound)
-                    {
-                        pageUpperBound =
-                            roundDown(pos, mData.pageSize) + mData.pageSize;
-                        mData.keysToOffset.emplace_back(RangeEntry(key, key),
-                                                        pos);
-                    }
-                    else
+                    if (!firstError)
                     {
-                        auto& rangeEntry = mData.keysToOffset.back().first;
-                        releaseAssert(rangeEntry.upperBound < key);
-                        rangeEntry.upperBound = key;
+                        firstError = std::current_exception();
                     }
+                }
+            }
+
+            if (firstError)
+            {
+                std::rethrow_exception(firstError);
+            }
+        }
 
-                    auto keybuf = xdr::xdr_to_opaque(key);
-                    mData.filter->insert(keybuf.data(), keybuf.size());
+        // Merge chunks in file order
+        size_t count = 0;
+        std::vector<uint64_t> fuseKeyHashes;
+        for (auto& chunk : chunks)
+        {
+            count += chunk.count;
+            mData.keysToOffset.insert(
+                mData.keysToOffset.end(),
+                std::make_move_iterator(chunk.keysToOffset.begin()),
+                std::make_move_iterator(chunk.keysToOffset.end()));
+
+            for (auto& [asset, poolIDs] : chunk.assetToPoolID)
+            {
+                auto& merged = mData.assetToPoolID[asset];
+                merged.insert(merged.end(), poolIDs.begin(), poolIDs.end());
+            }
+
+            if (chunk.filter)
+            {
+                if (!mData.filter)
+                {
+                    mData.filter = std::move(chunk.filter);
                 }
                 else
                 {
-                    mData.keysToOffset.emplace_back(key, pos);
+                    *mData.filter |= *chunk.filter;
+                }
+            }
+
+            for (auto const& typeStart : chunk.typeStarts)
+            {
+                if (mData.typeStarts.empty() ||
+                    mData.typeStarts.back().first != typeStart.first)
+                {
+                    mData.typeStarts.emplace_back(typeStart);
                 }
             }
 
-            pos = in.pos();
+            if (fuseKeyHashes.empty())
+            {
+                fuseKeyHashes = std::move(chunk.fuseKeyHashes);
+            }
+            else
+            {
+                fuseKeyHashes.insert(fuseKeyHashes.end(),
+                                     chunk.fuseKeyHashes.begin(),
+                                     chunk.fuseKeyHashes.end());
+            }
+        }
+
+        if constexpr (std::is_same<IndexT, IndividualIndex>::value)
+        {
+            std::sort(mData.keysToOffset.begin(), mData.keysToOffset.end());
+            separateCollisions(filename);
+        }
+
+        if (mData.fuseFilter)
+        {
+            ZoneNamedN(fuseInit, "fuseFilterInit", true);
+            mData.fuseFilter->populate(fuseKeyHashes);
+            CLOG_DEBUG(Bucket,
+                       "Binary fuse filter built: {} keys, {} bit "
+                       "fingerprints, {} bytes",
+                       fuseKeyHashes.size(), mData.fuseFilterBits,
+                       mData.fuseFilter->sizeInBytes());
         }
 
         CLOG_DEBUG(Bucket, "Indexed {} positions in {}",
@@ -210,19 +458,9 @@ BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager& bm,
     }
 }
 
-// Individual indexes are associated with small buckets, so it's more efficient
-// to just always recreate them instead of serializing to disk
-template <>
+template <class IndexT>
 void
-BucketIndexImpl<BucketIndex::IndividualIndex>::saveToDisk(
-    BucketManager& bm, Hash const& hash) const
-{
-}
-
-template <>
-void
-BucketIndexImpl<BucketIndex::RangeIndex>::saveToDisk(BucketManager& bm,
-                                                     Hash const& hash) const
+BucketIndexImpl<IndexT>::writeToDisk(BucketManager& bm, Hash const& hash) const
 {
     ZoneScoped;
     releaseAssert(bm.getConfig().isPersistingBucketListDBIndexes());
@@ -261,32 +499,156 @@ BucketIndexImpl<BucketIndex::RangeIndex>::saveToDisk(BucketManager& bm,
     }
 }
 
+template <class IndexT>
+uint64_t
+BucketIndexImpl<IndexT>::fingerprint(LedgerKey const& k) const
+{
+    auto keybuf = xdr::xdr_to_opaque(k);
+    SipHash24 sh(mData.fingerprintKey.data());
+    sh.update(keybuf.data(), keybuf.size());
+    return sh.digest();
+}
+
+// Moves every key whose fingerprint is shared with another key in the bucket
+// out of keysToOffset and into collisions, where the full key is kept. With
+// 64-bit fingerprints this is almost always a no-op.
+template <class IndexT>
+void
+BucketIndexImpl<IndexT>::separateCollisions(
+    std::filesystem::path const& filename)
+{
+    auto& fingerprints = mData.keysToOffset;
+    auto sameFingerprint = [](auto const& lhs, auto const& rhs) {
+        return lhs.first == rhs.first;
+    };
+    if (std::adjacent_find(fingerprints.begin(), fingerprints.end(),
+                           sameFingerprint) == fingerprints.end())
+    {
+        return;
+    }
+
+    XDRInputFileStream in;
+    in.open(filename.string());
+    BucketEntry be;
+    IndexT unique;
+    for (auto iter = fingerprints.begin(); iter != fingerprints.end();)
+    {
+        auto runEnd = std::find_if_not(
+            iter, fingerprints.end(),
+            [&](auto const& entry) { return entry.first == iter->first; });
+        if (std::next(iter) == runEnd)
+        {
+            unique.emplace_back(*iter);
+        }
+        else
+        {
+            for (; iter != runEnd; ++iter)
+            {
+                in.seek(iter->second);
+                releaseAssertOrThrow(in.readOne(be));
+                mData.collisions.emplace_back(getBucketLedgerKey(be),
+                                              iter->second);
+            }
+        }
+        iter = runEnd;
+    }
+
+    CLOG_DEBUG(Bucket, "{} keys with colliding fingerprints in {}",
+               mData.collisions.size(), filename.filename());
+    fingerprints = std::move(unique);
+    std::sort(mData.collisions.begin(), mData.collisions.end(),
+              [](auto const& lhs, auto const& rhs) {
+                  return lhs.first < rhs.first;
+              });
+}
+
+template <class IndexT>
+std::optional<std::streamoff>
+BucketIndexImpl<IndexT>::lookupFingerprint(LedgerKey const& k) const
+{
+    auto const& fingerprints = mData.keysToOffset;
+    if (!fingerprints.empty())
+    {
+        // Branchless lower bound: the loop trip count only depends on the
+        // index size, and the comparison compiles to a conditional move
+        auto const fp = fingerprint(k);
+        auto const* base = fingerprints.data();
+        size_t len = fingerprints.size();
+        while (len > 1)
+        {
+            size_t half = len / 2;
+            base += base[half - 1].first < fp ? half : 0;
+            len -= half;
+        }
+        base += base->first < fp ? 1 : 0;
+        if (base != fingerprints.data() + fingerprints.size() &&
+            base->first == fp)
+        {
+            return base->second;
+        }
+    }
+
+    if (!mData.collisions.empty())
+    {
+        auto iter = std::lower_bound(
+            mData.collisions.begin(), mData.collisions.end(), k,
+            [](auto const& entry, LedgerKey const& key) {
+                return entry.first < key;
+            });
+        if (iter != mData.collisions.end() && iter->first == k)
+        {
+            return iter->second;
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Individual indexes are associated with small buckets, so it's usually more
+// efficient to just always recreate them instead of serializing to disk. When
+// index memory is budgeted they are persisted too, so that they can be dropped
+// from memory and reloaded on demand.
+template <>
+void
+BucketIndexImpl<BucketIndex::IndividualIndex>::saveToDisk(
+    BucketManager& bm, Hash const& hash) const
+{
+    if (bm.getConfig().BUCKETLIST_DB_INDEX_MEMORY_BUDGET != 0)
+    {
+        writeToDisk(bm, hash);
+    }
+}
+
+template <>
+void
+BucketIndexImpl<BucketIndex::RangeIndex>::saveToDisk(BucketManager& bm,
+                                                     Hash const& hash) const
+{
+    writeToDisk(bm, hash);
+}
+
 template <class IndexT>
 template <class Archive>
 BucketIndexImpl<IndexT>::BucketIndexImpl(BucketManager const& bm, Archive& ar,
-                                         std::streamoff pageSize)
+                                         std::streamoff pageSize,
+                                         uint32_t fuseFilterBits,
+                                         Hash const& bucketHash)
     : mBloomMissMeter(bm.getBloomMissMeter())
     , mBloomLookupMeter(bm.getBloomLookupMeter())
 {
     mData.pageSize = pageSize;
+    mData.fuseFilterBits = fuseFilterBits;
+    mData.bucketHash = bucketHash;
     ar(mData);
 }
 
-// Returns true if the key is not contained within the given IndexEntry.
-// Range index: check if key is outside range of indexEntry
-// Individual index: check if key does not match indexEntry key
-template <class IndexEntryT>
+// Returns true if the key is outside the key range of the given range index
+// entry
 static bool
-keyNotInIndexEntry(LedgerKey const& key, IndexEntryT const& indexEntry)
+keyNotInIndexEntry(LedgerKey const& key,
+                   BucketIndex::RangeEntry const& indexEntry)
 {
-    if constexpr (std::is_same<IndexEntryT, BucketIndex::RangeEntry>::value)
-    {
-        return key < indexEntry.lowerBound || indexEntry.upperBound < key;
-    }
-    else
-    {
-        return !(key == indexEntry);
-    }
+    return key < indexEntry.lowerBound || indexEntry.upperBound < key;
 }
 
 // std::lower_bound predicate. Returns true if index comes "before" key and does
@@ -294,19 +656,11 @@ keyNotInIndexEntry(LedgerKey const& key, IndexEntryT const& indexEntry)
 // If key is too small for indexEntry bounds: return false
 // If key is contained within indexEntry bounds: return false
 // If key is too large for indexEntry bounds: return true
-template <class IndexEntryT>
 static bool
-lower_bound_pred(IndexEntryT const& indexEntry, LedgerKey const& key)
+lower_bound_pred(BucketIndex::RangeIndex::value_type const& indexEntry,
+                 LedgerKey const& key)
 {
-    if constexpr (std::is_same<IndexEntryT,
-                               BucketIndex::RangeIndex::value_type>::value)
-    {
-        return indexEntry.first.upperBound < key;
-    }
-    else
-    {
-        return indexEntry.first < key;
-    }
+    return indexEntry.first.upperBound < key;
 }
 
 // std::upper_bound predicate. Returns true if key comes "before" and is not
@@ -314,25 +668,36 @@ lower_bound_pred(IndexEntryT const& indexEntry, LedgerKey const& key)
 // If key is too small for indexEntry bounds: return true
 // If key is contained within indexEntry bounds: return false
 // If key is too large for indexEntry bounds: return false
-template <class IndexEntryT>
 static bool
-upper_bound_pred(LedgerKey const& key, IndexEntryT const& indexEntry)
+upper_bound_pred(LedgerKey const& key,
+                 BucketIndex::RangeIndex::value_type const& indexEntry)
 {
-    if constexpr (std::is_same<IndexEntryT,
-                               BucketIndex::RangeIndex::value_type>::value)
-    {
-        return key < indexEntry.first.lowerBound;
-    }
-    else
-    {
-        return key < indexEntry.first;
-    }
+    return key < indexEntry.first.lowerBound;
 }
 
 std::unique_ptr<BucketIndex const>
 BucketIndex::createIndex(BucketManager& bm,
                          std::filesystem::path const& filename,
                          Hash const& hash)
+{
+    return createIndexWithThreads(bm, filename, hash,
+                                  bm.getConfig().BUCKETLIST_DB_INDEX_THREADS);
+}
+
+#ifdef BUILD_TESTS
+std::unique_ptr<BucketIndex const>
+BucketIndex::createIndexForTesting(BucketManager& bm,
+                                   std::filesystem::path const& filename,
+                                   Hash const& hash, size_t numThreads)
+{
+    return createIndexWithThreads(bm, filename, hash, numThreads);
+}
+#endif
+
+std::unique_ptr<BucketIndex const>
+BucketIndex::createIndexWithThreads(BucketManager& bm,
+                                    std::filesystem::path const& filename,
+                                    Hash const& hash, size_t numThreads)
 {
     ZoneScoped;
     auto const& cfg = bm.getConfig();
@@ -349,7 +714,8 @@ BucketIndex::createIndex(BucketManager& bm,
                       "bucket {}",
                       filename);
             return std::unique_ptr<BucketIndexImpl<IndividualIndex> const>(
-                new BucketIndexImpl<IndividualIndex>(bm, filename, 0, hash));
+                new BucketIndexImpl<IndividualIndex>(bm, filename, 0, hash,
+                                                     numThreads));
         }
         else
         {
@@ -359,7 +725,8 @@ BucketIndex::createIndex(BucketManager& bm,
                       "{} in bucket {}",
                       pageSize, filename);
             return std::unique_ptr<BucketIndexImpl<RangeIndex> const>(
-                new BucketIndexImpl<RangeIndex>(bm, filename, pageSize, hash));
+                new BucketIndexImpl<RangeIndex>(bm, filename, pageSize, hash,
+                                                numThreads));
         }
     }
     // BucketIndexImpl throws if BucketManager shuts down before index finishes,
@@ -372,7 +739,8 @@ BucketIndex::createIndex(BucketManager& bm,
 
 std::unique_ptr<BucketIndex const>
 BucketIndex::load(BucketManager const& bm,
-                  std::filesystem::path const& filename, size_t bucketFileSize)
+                  std::filesystem::path const& filename, Hash const& bucketHash,
+                  size_t bucketFileSize)
 {
     std::ifstream in(filename, std::ios::binary);
     if (!in)
@@ -381,28 +749,60 @@ BucketIndex::load(BucketManager const& bm,
             fmt::format(FMT_STRING("Error opening file {}"), filename));
     }
 
-    std::streamoff pageSize;
-    uint32_t version;
-    cereal::BinaryInputArchive ar(in);
-    ar(version, pageSize);
-
-    // Make sure on-disk index was built with correct version and config
-    // parameters before deserializing whole file
-    if (version != BUCKET_INDEX_VERSION ||
-        pageSize != effectivePageSize(bm.getConfig(), bucketFileSize))
+    // A persisted index file may be truncated or corrupt, so treat any
+    // deserialization failure as an invalid index to be rebuilt rather than a
+    // fatal error.
+    try
     {
-        return {};
-    }
+        cereal::BinaryInputArchive ar(in);
 
-    if (pageSize == 0)
-    {
-        return std::unique_ptr<BucketIndexImpl<IndividualIndex> const>(
-            new BucketIndexImpl<IndividualIndex>(bm, ar, pageSize));
+        // Older versions have a different header layout, so check the version
+        // before reading anything else
+        uint32_t version;
+        ar(version);
+        if (version != BUCKET_INDEX_VERSION)
+        {
+            return {};
+        }
+
+        std::streamoff pageSize;
+        uint32_t fuseFilterBits;
+        Hash storedHash;
+        ar(pageSize, fuseFilterBits, storedHash);
+
+        // Make sure on-disk index was built for this bucket with correct
+        // config parameters before deserializing whole file
+        if (storedHash != bucketHash ||
+            pageSize != effectivePageSize(bm.getConfig(), bucketFileSize))
+        {
+            return {};
+        }
+
+        if (pageSize == 0)
+        {
+            return std::unique_ptr<BucketIndexImpl<IndividualIndex> const>(
+                new BucketIndexImpl<IndividualIndex>(
+                    bm, ar, pageSize, fuseFilterBits, storedHash));
+        }
+        else
+        {
+            // Rebuild range indexes whose filter type no longer matches config
+            if (fuseFilterBits !=
+                bm.getConfig().BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS)
+            {
+                return {};
+            }
+
+            return std::unique_ptr<BucketIndexImpl<RangeIndex> const>(
+                new BucketIndexImpl<RangeIndex>(bm, ar, pageSize,
+                                                fuseFilterBits, storedHash));
+        }
     }
-    else
+    catch (std::exception const& e)
     {
-        return std::unique_ptr<BucketIndexImpl<RangeIndex> const>(
-            new BucketIndexImpl<RangeIndex>(bm, ar, pageSize));
+        CLOG_WARNING(Bucket, "Failed to load bucket index {}: {}", filename,
+                     e.what());
+        return {};
     }
 }
 
@@ -421,29 +821,38 @@ BucketIndexImpl<IndexT>::scan(Iterator start, LedgerKey const& k) const
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(mData.keysToOffset.size()));
 
-    // Search for the key in the index before checking the bloom filter so we
-    // return the correct iterator to the caller. This may be slightly less
-    // effecient then checking the bloom filter first, but the filter's primary
-    // purpose is to avoid disk lookups, not to avoid in-memory index search.
-    auto internalStart = std::get<typename IndexT::const_iterator>(start);
-    auto keyIter =
-        std::lower_bound(internalStart, mData.keysToOffset.end(), k,
-                         lower_bound_pred<typename IndexT::value_type>);
-
-    // If the key is not in the bloom filter or in the lower bounded index
-    // entry, return nullopt
-    markBloomLookup();
-    auto keybuf = xdr::xdr_to_opaque(k);
-    if ((mData.filter &&
-         !mData.filter->contains(keybuf.data(), keybuf.size())) ||
-        keyIter == mData.keysToOffset.end() ||
-        keyNotInIndexEntry(k, keyIter->first))
+    if constexpr (std::is_same<IndexT, IndividualIndex>::value)
     {
-        return {std::nullopt, keyIter};
+        return {lookupFingerprint(k), start};
     }
     else
     {
-        return {keyIter->second, keyIter};
+        // Search for the key in the index before checking the bloom filter so
+        // we return the correct iterator to the caller. This may be slightly
+        // less effecient then checking the bloom filter first, but the
+        // filter's primary purpose is to avoid disk lookups, not to avoid
+        // in-memory index search.
+        auto internalStart = std::get<typename IndexT::const_iterator>(start);
+        auto keyIter = std::lower_bound(
+            internalStart, mData.keysToOffset.end(), k, lower_bound_pred);
+
+        // If the key is not in the bloom filter or in the lower bounded index
+        // entry, return nullopt
+        markBloomLookup();
+        auto keybuf = xdr::xdr_to_opaque(k);
+        if ((mData.filter &&
+             !mData.filter->contains(keybuf.data(), keybuf.size())) ||
+            (mData.fuseFilter &&
+             !mData.fuseFilter->contains(keybuf.data(), keybuf.size())) ||
+            keyIter == mData.keysToOffset.end() ||
+            keyNotInIndexEntry(k, keyIter->first))
+        {
+            return {std::nullopt, keyIter};
+        }
+        else
+        {
+            return {keyIter->second, keyIter};
+        }
     }
 }
 
@@ -452,30 +861,58 @@ std::optional<std::pair<std::streamoff, std::streamoff>>
 BucketIndexImpl<IndexT>::getOffsetBounds(LedgerKey const& lowerBound,
                                          LedgerKey const& upperBound) const
 {
-    // Get the index iterators for the bounds
-    auto startIter = std::lower_bound(
-        mData.keysToOffset.begin(), mData.keysToOffset.end(), lowerBound,
-        lower_bound_pred<typename IndexT::value_type>);
-    if (startIter == mData.keysToOffset.end())
+    if constexpr (std::is_same<IndexT, IndividualIndex>::value)
     {
-        return std::nullopt;
+        // Fingerprints carry no key order, so bound the range by the entries
+        // of the key types it spans
+        auto const& typeStarts = mData.typeStarts;
+        auto startIter = std::find_if(
+            typeStarts.begin(), typeStarts.end(), [&](auto const& typeStart) {
+                return typeStart.first >= lowerBound.type();
+            });
+        if (startIter == typeStarts.end() ||
+            startIter->first > upperBound.type())
+        {
+            return std::nullopt;
+        }
+
+        auto endIter = std::find_if(
+            startIter, typeStarts.end(), [&](auto const& typeStart) {
+                return typeStart.first > upperBound.type();
+            });
+        std::streamoff endOff = endIter == typeStarts.end()
+                                    ? std::numeric_limits<std::streamoff>::max()
+                                    : endIter->second;
+        return std::make_pair(startIter->second, endOff);
     }
+    else
+    {
+        // Get the index iterators for the bounds
+        auto startIter =
+            std::lower_bound(mData.keysToOffset.begin(),
+                             mData.keysToOffset.end(), lowerBound,
+                             lower_bound_pred);
+        if (startIter == mData.keysToOffset.end())
+        {
+            return std::nullopt;
+        }
 
-    auto endIter = std::upper_bound(
-        std::next(startIter), mData.keysToOffset.end(), upperBound,
-        upper_bound_pred<typename IndexT::value_type>);
+        auto endIter =
+            std::upper_bound(std::next(startIter), mData.keysToOffset.end(),
+                             upperBound, upper_bound_pred);
 
-    // Get file offsets based on lower and upper bound iterators
-    std::streamoff startOff = startIter->second;
-    std::streamoff endOff = std::numeric_limits<std::streamoff>::max();
+        // Get file offsets based on lower and upper bound iterators
+        std::streamoff startOff = startIter->second;
+        std::streamoff endOff = std::numeric_limits<std::streamoff>::max();
 
-    // If we hit the end of the index then upper bound should be EOF
-    if (endIter != mData.keysToOffset.end())
-    {
-        endOff = endIter->second;
-    }
+        // If we hit the end of the index then upper bound should be EOF
+        if (endIter != mData.keysToOffset.end())
+        {
+            endOff = endIter->second;
+        }
 
-    return std::make_pair(startOff, endOff);
+        return std::make_pair(startOff, endOff);
+    }
 }
 
 template <class IndexT>
@@ -526,6 +963,36 @@ BucketIndexImpl<IndexT>::getOfferRange() const
     return getOffsetBounds(lowerBound, upperBound);
 }
 
+template <class IndexT>
+std::optional<std::pair<std::streamoff, std::streamoff>>
+BucketIndexImpl<IndexT>::getContractCodeAndTTLRange() const
+{
+    // Get the smallest contract code key and the largest TTL key
+    LedgerKey upperBound(TTL);
+    upperBound.ttl().keyHash.fill(std::numeric_limits<uint8_t>::max());
+
+    LedgerKey lowerBound(CONTRACT_CODE);
+    lowerBound.contractCode().hash.fill(std::numeric_limits<uint8_t>::min());
+
+    return getOffsetBounds(lowerBound, upperBound);
+}
+
+template <class IndexT>
+std::optional<std::pair<std::streamoff, std::streamoff>>
+BucketIndexImpl<IndexT>::getLiquidityPoolRange() const
+{
+    // Get the smallest and largest possible liquidity pool keys
+    LedgerKey upperBound(LIQUIDITY_POOL);
+    upperBound.liquidityPool().liquidityPoolID.fill(
+        std::numeric_limits<uint8_t>::max());
+
+    LedgerKey lowerBound(LIQUIDITY_POOL);
+    lowerBound.liquidityPool().liquidityPoolID.fill(
+        std::numeric_limits<uint8_t>::min());
+
+    return getOffsetBounds(lowerBound, upperBound);
+}
+
 #ifdef BUILD_TESTS
 template <class IndexT>
 bool
@@ -537,24 +1004,48 @@ BucketIndexImpl<IndexT>::operator==(BucketIndex const& inRaw) const
     }
 
     auto const& in = dynamic_cast<BucketIndexImpl<IndexT> const&>(inRaw);
-    if (mData.keysToOffset.size() != in.mData.keysToOffset.size())
+    if (mData.bucketHash != in.mData.bucketHash ||
+        mData.keysToOffset.size() != in.mData.keysToOffset.size())
     {
         return false;
     }
 
     if constexpr (std::is_same<IndexT, RangeIndex>::value)
     {
-        releaseAssert(mData.filter);
-        releaseAssert(in.mData.filter);
-        if (*(mData.filter) != *(in.mData.filter))
+        if (mData.fuseFilterBits != in.mData.fuseFilterBits)
         {
             return false;
         }
+
+        if (mData.fuseFilterBits != 0)
+        {
+            releaseAssert(!mData.filter && mData.fuseFilter);
+            releaseAssert(!in.mData.filter && in.mData.fuseFilter);
+            if (*(mData.fuseFilter) != *(in.mData.fuseFilter))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            releaseAssert(mData.filter && !mData.fuseFilter);
+            releaseAssert(in.mData.filter && !in.mData.fuseFilter);
+            if (*(mData.filter) != *(in.mData.filter))
+            {
+                return false;
+            }
+        }
     }
     else
     {
-        releaseAssert(!mData.filter);
-        releaseAssert(!in.mData.filter);
+        releaseAssert(!mData.filter && !mData.fuseFilter);
+        releaseAssert(!in.mData.filter && !in.mData.fuseFilter);
+        if (mData.fingerprintKey != in.mData.fingerprintKey ||
+            mData.collisions != in.mData.collisions ||
+            mData.typeStarts != in.mData.typeStarts)
+        {
+            return false;
+        }
     }
 
     for (size_t i = 0; i < mData.keysToOffset.size(); ++i)
@@ -571,6 +1062,31 @@ BucketIndexImpl<IndexT>::operator==(BucketIndex const& inRaw) const
 }
 #endif
 
+template <class IndexT>
+size_t
+BucketIndexImpl<IndexT>::getMemoryUsage() const
+{
+    size_t bytes = sizeof(*this) + mData.keysToOffset.capacity() *
+                                       sizeof(typename IndexT::value_type);
+    if (mData.filter)
+    {
+        bytes += mData.filter->size() / bits_per_char;
+    }
+    if (mData.fuseFilter)
+    {
+        bytes += mData.fuseFilter->sizeInBytes();
+    }
+    for (auto const& [asset, poolIDs] : mData.assetToPoolID)
+    {
+        bytes += sizeof(asset) + poolIDs.capacity() * sizeof(PoolID);
+    }
+    bytes += mData.collisions.capacity() *
+                 sizeof(decltype(mData.collisions)::value_type) +
+             mData.typeStarts.capacity() *
+                 sizeof(decltype(mData.typeStarts)::value_type);
+    return bytes;
+}
+
 template <class IndexT>
 void
 BucketIndexImpl<IndexT>::markBloomMiss() const
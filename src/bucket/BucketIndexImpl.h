@@ -6,6 +6,7 @@
 
 #include "bucket/BucketIndex.h"
 #include "medida/meter.h"
+#include "util/BinaryFuseFilter.h"
 
 #include <cereal/types/map.hpp>
 #include <map>
@@ -17,7 +18,8 @@ namespace stellar
 
 // Index maps either individual keys or a key range of BucketEntry's to the
 // associated offset within the bucket file. Index stored as vector of pairs:
-// First: LedgerKey/Key ranges sorted in the same scheme as LedgerEntryCmp
+// First: Key ranges sorted in the same scheme as LedgerEntryCmp, or key
+// fingerprints sorted numerically
 // Second: offset into the bucket file for a given key/ key range.
 // pageSize determines how large, in bytes, each range should be. pageSize == 0
 // indicates individual keys used instead of ranges.
@@ -31,40 +33,94 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
         IndexT keysToOffset{};
         std::streamoff pageSize{};
         std::unique_ptr<bloom_filter> filter{};
+
+        // Range indexes have exactly one of filter or fuseFilter, as selected
+        // by fuseFilterBits (0 for bloom filter)
+        uint32_t fuseFilterBits{};
+        std::unique_ptr<BinaryFuseFilter> fuseFilter{};
         std::map<Asset, std::vector<PoolID>> assetToPoolID{};
 
+        // Hash of the bucket this index was built from, so that a persisted
+        // index is never attached to a different bucket file
+        Hash bucketHash{};
+
+        // Individual indexes only. SipHash key the fingerprints in
+        // keysToOffset are computed with, keys whose fingerprints collide
+        // with another key in the bucket (stored in full and sorted by key),
+        // and the offset of the first entry of each LedgerEntryType present,
+        // in file order, for range queries.
+        std::array<unsigned char, 16> fingerprintKey{};
+        std::vector<std::pair<LedgerKey, std::streamoff>> collisions{};
+        std::vector<std::pair<int32_t, std::streamoff>> typeStarts{};
+
         template <class Archive>
         void
         save(Archive& ar) const
         {
             auto version = BUCKET_INDEX_VERSION;
-            ar(version, pageSize, assetToPoolID, keysToOffset, filter);
+            ar(version, pageSize, fuseFilterBits, bucketHash, assetToPoolID,
+               keysToOffset, filter, fuseFilter, fingerprintKey, collisions,
+               typeStarts);
         }
 
-        // Note: version and pageSize must be loaded before this function is
-        // called. pageSize determines template type, so pageSize should be
-        // loaded, checked, and then call this function with the appropriate
-        // template type
+        // Note: version, pageSize, fuseFilterBits and bucketHash must be
+        // loaded before this function is called. pageSize determines template
+        // type, so pageSize should be loaded, checked, and then call this
+        // function with the appropriate template type
         template <class Archive>
         void
         load(Archive& ar)
         {
-            ar(assetToPoolID, keysToOffset, filter);
+            ar(assetToPoolID, keysToOffset, filter, fuseFilter, fingerprintKey,
+               collisions, typeStarts);
         }
     } mData;
 
+    // Partial index over one chunk of the bucket file, built independently
+    // and then merged into mData
+    struct IndexChunk
+    {
+        IndexT keysToOffset{};
+        std::map<Asset, std::vector<PoolID>> assetToPoolID{};
+        std::unique_ptr<bloom_filter> filter{};
+        std::vector<uint64_t> fuseKeyHashes{};
+        std::vector<std::pair<int32_t, std::streamoff>> typeStarts{};
+        size_t count{0};
+    };
+
+    // Range indexes are only split into chunks of at least this many pages
+    static constexpr size_t MIN_PAGES_PER_INDEX_CHUNK = 1024;
+
     medida::Meter& mBloomMissMeter;
     medida::Meter& mBloomLookupMeter;
 
+    // Builds the index using up to numThreads threads. Only range indexes of
+    // sufficiently large buckets are built in parallel.
     BucketIndexImpl(BucketManager& bm, std::filesystem::path const& filename,
-                    std::streamoff pageSize, Hash const& hash);
+                    std::streamoff pageSize, Hash const& hash,
+                    size_t numThreads);
+
+    // Indexes all records starting in [begin, end). begin must be the start
+    // of a record that begins a new index page.
+    void indexChunk(BucketManager const& bm,
+                    std::filesystem::path const& filename,
+                    std::streamoff begin, std::streamoff end,
+                    IndexChunk& out) const;
+
+    // Individual indexes only
+    uint64_t fingerprint(LedgerKey const& k) const;
+    void separateCollisions(std::filesystem::path const& filename);
+    std::optional<std::streamoff> lookupFingerprint(LedgerKey const& k) const;
 
     template <class Archive>
     BucketIndexImpl(BucketManager const& bm, Archive& ar,
-                    std::streamoff pageSize);
+                    std::streamoff pageSize, uint32_t fuseFilterBits,
+                    Hash const& bucketHash);
 
-    // Saves index to disk, overwriting any preexisting file for this index
+    // Saves index to disk if this index type is persisted, overwriting any
+    // preexisting file for this index
     void saveToDisk(BucketManager& bm, Hash const& hash) const;
+    void writeToDisk(BucketManager& bm, Hash const& hash) const;
 
     // Returns [lowFileOffset, highFileOffset) that contain the key ranges
     // [lowerBound, upperBound]. If no file offsets exist, returns [0, 0]
@@ -90,6 +146,12 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
     virtual std::optional<std::pair<std::streamoff, std::streamoff>>
     getOfferRange() const override;
 
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getContractCodeAndTTLRange() const override;
+
+    virtual std::optional<std::pair<std::streamoff, std::streamoff>>
+    getLiquidityPoolRange() const override;
+
     virtual std::streamoff
     getPageSize() const override
     {
@@ -108,6 +170,8 @@ template <class IndexT> class BucketIndexImpl : public BucketIndex
         return mData.keysToOffset.end();
     }
 
+    virtual size_t getMemoryUsage() const override;
+
     virtual void markBloomMiss() const override;
     virtual void markBloomLookup() const override;
 
@@ -4,7 +4,9 @@
 
 #include "bucket/BucketInputIterator.h"
 #include "bucket/Bucket.h"
-#include <Tracy.hpp>
+#include "bucket/LedgerCmp.h"
+#include "util/ZoneProfiler.h"
+#include <cstring>
 
 namespace stellar
 {
@@ -44,6 +46,7 @@ BucketInputIterator::loadEntry()
             {
                 Bucket::checkProtocolLegality(mEntry, mMetadata.ledgerVersion);
             }
+            loadSortKey();
         }
     }
     else
@@ -52,6 +55,77 @@ BucketInputIterator::loadEntry()
     }
 }
 
+void
+BucketInputIterator::loadSortKey()
+{
+    // A serialized BucketEntry starts with its 4-byte type. LIVEENTRY and
+    // INITENTRY are followed by a LedgerEntry, whose 4-byte
+    // lastModifiedLedgerSeq precedes the 4-byte LedgerEntryType. DEADENTRY is
+    // followed by a LedgerKey, which starts with the LedgerEntryType. For the
+    // types below, the key is a prefix of both the LedgerEntry body and the
+    // LedgerKey body, and is made of non-negative enums and unsigned bytes,
+    // which XDR encodes in their natural order.
+    mHasSortKey = false;
+    ByteSlice raw = mIn.lastReadBytes();
+    size_t typePos = mEntry.type() == DEADENTRY ? 4 : 8;
+    if (raw.size() < typePos + 4)
+    {
+        return;
+    }
+
+    size_t keySize = 0;
+    switch (mEntry.type() == DEADENTRY ? mEntry.deadEntry().type()
+                                       : mEntry.liveEntry().data.type())
+    {
+    case ACCOUNT:
+        // PublicKey: 4-byte key type and 32-byte key
+    case CLAIMABLE_BALANCE:
+        // ClaimableBalanceID: 4-byte id type and 32-byte hash
+        keySize = 36;
+        break;
+    case LIQUIDITY_POOL:
+    case TTL:
+        keySize = 32;
+        break;
+    case CONFIG_SETTING:
+        keySize = 4;
+        break;
+    default:
+        // Keys of other types contain variable length or signed fields
+        return;
+    }
+
+    if (raw.size() < typePos + 4 + keySize)
+    {
+        return;
+    }
+    static_assert(SORT_KEY_SIZE >= 4 + 36);
+    auto const* data = raw.data();
+    std::memcpy(mSortKey.data(), data + typePos, 4 + keySize);
+    std::memset(mSortKey.data() + 4 + keySize, 0,
+                SORT_KEY_SIZE - 4 - keySize);
+    mHasSortKey = true;
+}
+
+int
+BucketInputIterator::compareIdentity(BucketInputIterator const& a,
+                                     BucketInputIterator const& b)
+{
+    releaseAssert(a.mEntryPtr && b.mEntryPtr);
+    if (a.mHasSortKey && b.mHasSortKey)
+    {
+        return std::memcmp(a.mSortKey.data(), b.mSortKey.data(),
+                           SORT_KEY_SIZE);
+    }
+
+    BucketEntryIdCmp cmp;
+    if (cmp(*a.mEntryPtr, *b.mEntryPtr))
+    {
+        return -1;
+    }
+    return cmp(*b.mEntryPtr, *a.mEntryPtr) ? 1 : 0;
+}
+
 std::streamoff
 BucketInputIterator::pos()
 {
@@ -75,6 +149,14 @@ BucketInputIterator::operator*()
     return *mEntryPtr;
 }
 
+BucketEntry&
+BucketInputIterator::entryToMove()
+{
+    releaseAssert(mEntryPtr);
+    mEntryPtr = nullptr;
+    return mEntry;
+}
+
 bool
 BucketInputIterator::seenMetadata() const
 {
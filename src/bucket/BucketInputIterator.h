@@ -7,6 +7,7 @@
 #include "util/XDRStream.h"
 #include "xdr/Stellar-ledger.h"
 
+#include <array>
 #include <memory>
 
 namespace stellar
@@ -28,7 +29,18 @@ class BucketInputIterator
     bool mSeenMetadata{false};
     bool mSeenOtherEntries{false};
     BucketMetadata mMetadata;
+
+    // Identity of mEntry taken from its serialized form: the big-endian
+    // LedgerEntryType followed by the bytes of the key, zero padded. Only
+    // set for entry types whose keys are fixed-size and whose XDR encoding
+    // sorts the same way as BucketEntryIdCmp, so that memcmp of two sort keys
+    // agrees with it.
+    static constexpr size_t SORT_KEY_SIZE = 40;
+    std::array<uint8_t, SORT_KEY_SIZE> mSortKey{};
+    bool mHasSortKey{false};
+
     void loadEntry();
+    void loadSortKey();
 
   public:
     operator bool() const;
@@ -45,6 +57,17 @@ class BucketInputIterator
 
     BucketEntry const& operator*();
 
+    // Mutable access to the current entry, so it can be moved from. The
+    // iterator must be advanced before it is dereferenced again.
+    BucketEntry& entryToMove();
+
+    // Three-way identity comparison of the current entries of two valid
+    // iterators, ordering entries the same way as BucketEntryIdCmp. Compares
+    // serialized keys directly when both entries have one, and falls back to
+    // BucketEntryIdCmp on the decoded entries otherwise.
+    static int compareIdentity(BucketInputIterator const& a,
+                               BucketInputIterator const& b);
+
     BucketInputIterator(std::shared_ptr<Bucket const> bucket);
 
     ~BucketInputIterator();
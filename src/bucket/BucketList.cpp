@@ -14,11 +14,11 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 
 #include "medida/counter.h"
 
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
@@ -177,7 +177,8 @@ BucketLevel::prepare(Application& app, uint32_t currLedger,
             ? std::vector<std::shared_ptr<Bucket>>()
             : shadows;
     mNextCurr = FutureBucket(app, curr, snap, shadowsBasedOnProtocol,
-                             currLedgerProtocol, countMergeEvents, mLevel);
+                             currLedgerProtocol, countMergeEvents, mLevel,
+                             currLedger);
     releaseAssert(mNextCurr.isMerging());
 }
 
@@ -392,6 +393,20 @@ BucketList::getHash() const
 //
 // clang-format on
 
+uint32_t
+BucketList::mergeDeadlineLedger(uint32_t ledger, uint32_t level)
+{
+    // Level 0 merges are committed in the same addBatch that starts them.
+    // Merges into level i are started when level i-1 spills and committed at
+    // the next spill of level i-1, one levelHalf(i-1) later.
+    if (level == 0)
+    {
+        return ledger;
+    }
+    auto const half = levelHalf(level - 1);
+    return roundDown(ledger, half) + half;
+}
+
 bool
 BucketList::levelShouldSpill(uint32_t ledger, uint32_t level)
 {
@@ -784,6 +799,14 @@ BucketList::scanForEvictionLegacy(Application& app, AbstractLedgerTxn& ltx,
             counters);
     }
 
+    // This scan runs on the main thread during ledger close, so start
+    // reading the region the next ledger will scan now, while the device is
+    // otherwise idle between closes.
+    getBucketFromIter(evictionIter)
+        ->prefetchForEvictionScan(
+            evictionIter.bucketFileOffset,
+            networkConfig.stateArchivalSettings().evictionScanSize);
+
     networkConfig.updateEvictionIterator(ltx, evictionIter);
 }
 
@@ -798,7 +821,7 @@ BucketList::restartMerges(Application& app, uint32_t maxProtocolVersion,
         auto& next = level.getNext();
         if (next.hasHashes() && !next.isLive())
         {
-            next.makeLive(app, maxProtocolVersion, i);
+            next.makeLive(app, maxProtocolVersion, i, ledger);
             if (next.isMerging())
             {
                 CLOG_INFO(Bucket, "Restarted merge on BucketList level {}", i);
@@ -435,6 +435,10 @@ class BucketList
     // should spill curr->snap and start merging snap into its next level.
     static bool levelShouldSpill(uint32_t ledger, uint32_t level);
 
+    // Returns the ledger at which a merge into `level` that is in progress at
+    // `ledger` has to be resolved, i.e. the next spill of `level - 1`.
+    static uint32_t mergeDeadlineLedger(uint32_t ledger, uint32_t level);
+
     // Returns true if at given `level` dead entries should be kept.
     static bool keepDeadEntries(uint32_t level);
 
@@ -0,0 +1,150 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketListEntryCache.h"
+#include "util/GlobalChecks.h"
+#include "util/XDROperators.h" // IWYU pragma: keep
+#include "util/ZoneProfiler.h"
+
+#include <xdrpp/marshal.h>
+
+namespace stellar
+{
+
+namespace
+{
+// Rough per-entry cost of the hashmap node, pointer vector slot and shared_ptr
+// control block, on top of the key and entry themselves
+constexpr size_t ENTRY_OVERHEAD_BYTES = 128;
+}
+
+BucketListEntryCache::BucketListEntryCache(size_t maxBytes)
+    : mMaxBytes(maxBytes)
+{
+    releaseAssert(mMaxBytes > 0);
+}
+
+void
+BucketListEntryCache::evictOne()
+{
+    size_t sz = mValuePtrs.size();
+    if (sz == 0)
+    {
+        return;
+    }
+    MapValueType*& vp1 =
+        mValuePtrs.at(rand_uniform<size_t>(0, sz - 1, mRandomEngine));
+    MapValueType*& vp2 =
+        mValuePtrs.at(rand_uniform<size_t>(0, sz - 1, mRandomEngine));
+    MapValueType*& victim =
+        (vp1->second.mLastAccess < vp2->second.mLastAccess ? vp1 : vp2);
+    mBytes -= victim->second.mSize;
+    mValueMap.erase(victim->first);
+    std::swap(victim, mValuePtrs.back());
+    mValuePtrs.pop_back();
+    ++mCounters.mEvicts;
+}
+
+void
+BucketListEntryCache::invalidate(uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mLedgerSeq = ledgerSeq;
+    mValuePtrs.clear();
+    mValueMap.clear();
+    mBytes = 0;
+}
+
+std::optional<std::shared_ptr<LedgerEntry const>>
+BucketListEntryCache::maybeGet(LedgerKey const& k, uint32_t ledgerSeq)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (ledgerSeq != mLedgerSeq)
+    {
+        return std::nullopt;
+    }
+
+    auto it = mValueMap.find(k);
+    if (it == mValueMap.end())
+    {
+        ++mCounters.mMisses;
+        return std::nullopt;
+    }
+
+    ++mCounters.mHits;
+    it->second.mLastAccess = ++mGeneration;
+    return it->second.mEntry;
+}
+
+void
+BucketListEntryCache::put(LedgerKey const& k,
+                          std::shared_ptr<LedgerEntry const> entry,
+                          uint32_t ledgerSeq)
+{
+    size_t size = xdr::xdr_size(k) + ENTRY_OVERHEAD_BYTES;
+    if (entry)
+    {
+        size += xdr::xdr_size(*entry);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (ledgerSeq != mLedgerSeq || size > mMaxBytes)
+    {
+        return;
+    }
+
+    CacheValue newValue{std::move(entry), size, ++mGeneration};
+    auto [it, inserted] = mValueMap.emplace(k, newValue);
+    if (inserted)
+    {
+        mValuePtrs.push_back(&*it);
+    }
+    else
+    {
+        // Another thread loaded the same key concurrently, both results come
+        // from the same snapshot
+        mBytes -= it->second.mSize;
+        it->second = newValue;
+    }
+    mBytes += size;
+
+    while (mBytes > mMaxBytes)
+    {
+        evictOne();
+    }
+}
+
+void
+BucketListEntryCache::shrinkTo(size_t maxBytes)
+{
+    ZoneScoped;
+    std::lock_guard<std::mutex> lock(mMutex);
+    while (mBytes > maxBytes && !mValuePtrs.empty())
+    {
+        evictOne();
+    }
+}
+
+size_t
+BucketListEntryCache::getBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mBytes;
+}
+
+size_t
+BucketListEntryCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mValueMap.size();
+}
+
+BucketListEntryCache::Counters
+BucketListEntryCache::getCounters() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCounters;
+}
+}
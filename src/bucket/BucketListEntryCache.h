@@ -0,0 +1,98 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerHashUtils.h"
+#include "util/Math.h"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-ledger-entries.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+// Thread safe, byte-budgeted cache of decoded BucketListDB lookup results,
+// shared by every SearchableBucketListSnapshot. Caches both live entries and
+// negative results (keys that are dead or absent), so hot keys skip the search
+// across all levels and the XDR decode.
+//
+// Cached values are only valid for a single BucketList snapshot, identified by
+// its ledgerSeq. BucketSnapshotManager calls invalidate() whenever it publishes
+// a new snapshot, and lookups or inserts made with any other ledgerSeq are
+// ignored. This prevents a thread still holding an older snapshot from
+// reading newer results or polluting the cache with stale ones.
+//
+// Eviction is least-recent-out-of-2-random-choices, as in RandomEvictionCache,
+// once the approximate size of cached keys and entries exceeds the budget.
+class BucketListEntryCache : public NonMovableOrCopyable
+{
+  public:
+    struct Counters
+    {
+        uint64_t mHits{0};
+        uint64_t mMisses{0};
+        uint64_t mEvicts{0};
+    };
+
+  private:
+    struct CacheValue
+    {
+        // nullptr if key is dead or not in the BucketList
+        std::shared_ptr<LedgerEntry const> mEntry;
+        size_t mSize;
+        uint64_t mLastAccess;
+    };
+
+    using MapType = std::unordered_map<LedgerKey, CacheValue>;
+    using MapValueType = MapType::value_type;
+
+    size_t const mMaxBytes;
+
+    mutable std::mutex mMutex;
+    uint32_t mLedgerSeq{0};
+    size_t mBytes{0};
+    uint64_t mGeneration{0};
+    MapType mValueMap;
+
+    // Pointers to mValueMap elements for random eviction, which stay valid
+    // across rehashing
+    std::vector<MapValueType*> mValuePtrs;
+    Counters mCounters;
+
+    // gRandomEngine is main-thread only, so eviction uses its own engine
+    stellar_default_random_engine mRandomEngine;
+
+    void evictOne();
+
+  public:
+    explicit BucketListEntryCache(size_t maxBytes);
+
+    // Drops all cached values. Only lookups and inserts made for ledgerSeq
+    // are accepted from here on.
+    void invalidate(uint32_t ledgerSeq);
+
+    // Returns std::nullopt on a cache miss. Otherwise returns the cached
+    // result, which is nullptr if the key is dead or does not exist.
+    std::optional<std::shared_ptr<LedgerEntry const>>
+    maybeGet(LedgerKey const& k, uint32_t ledgerSeq);
+
+    // entry should be nullptr if the key is dead or does not exist
+    void put(LedgerKey const& k, std::shared_ptr<LedgerEntry const> entry,
+             uint32_t ledgerSeq);
+
+    // Evicts entries until the cache holds at most maxBytes, for the
+    // MemoryBudget. Cached values stay valid for the current ledgerSeq.
+    void shrinkTo(size_t maxBytes);
+
+    size_t getBytes() const;
+    size_t size() const;
+    Counters getCounters() const;
+};
+}
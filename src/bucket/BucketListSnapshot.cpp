@@ -4,15 +4,22 @@
 
 #include "bucket/BucketListSnapshot.h"
 #include "bucket/BucketInputIterator.h"
+#include "bucket/BucketListEntryCache.h"
 #include "crypto/SecretKey.h" // IWYU pragma: keep
 #include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTypeUtils.h"
+#include "util/UnorderedSet.h"
 
 #include "medida/timer.h"
 
+#include <algorithm>
+#include <future>
+
 namespace stellar
 {
 
-BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq)
+BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq,
+                                       bool useMmap)
     : mLedgerSeq(ledgerSeq)
 {
     releaseAssert(threadIsMain());
@@ -20,7 +27,7 @@ BucketListSnapshot::BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq)
     for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
     {
         auto const& level = bl.getLevel(i);
-        mLevels.emplace_back(BucketLevelSnapshot(level));
+        mLevels.emplace_back(BucketLevelSnapshot(level, useMmap));
     }
 }
 
@@ -72,6 +79,7 @@ SearchableBucketListSnapshot::scanForEviction(
     EvictionIterator evictionIter, std::shared_ptr<EvictionStatistics> stats,
     StateArchivalSettings const& sas)
 {
+    ZoneScoped;
     releaseAssert(mSnapshot);
     releaseAssert(stats);
 
@@ -87,19 +95,44 @@ SearchableBucketListSnapshot::scanForEviction(
 
     EvictionResult result(sas);
     auto startIter = evictionIter;
-    auto scanSize = sas.evictionScanSize;
-
+    uint32_t scanSize = sas.evictionScanSize;
+
+    // The scan region only depends on bucket sizes: a scannable bucket with
+    // at least scanSize bytes left after the iterator ends the region, and
+    // any other bucket is read to eof. So the region is first split into one
+    // segment per bucket, which are then read concurrently. Results are
+    // concatenated in segment order, which is exactly what scanning the
+    // buckets one after another would produce.
+    struct Segment
+    {
+        BucketSnapshot const* bucket;
+        EvictionIterator iter;
+        uint32_t bytesToScan;
+    };
+    std::vector<Segment> segments;
+    bool endsInBucket = false;
     for (;;)
     {
         auto const& b = getBucketFromIter(evictionIter);
         BucketList::checkIfEvictionScanIsStuck(
             evictionIter, sas.evictionScanSize, b.getRawBucket(), counters);
 
-        // If we scan scanSize before hitting bucket EOF, exit early
-        if (b.scanForEviction(evictionIter, scanSize, ledgerSeq,
-                              result.eligibleKeys, *this))
+        if (b.isScannableForEviction())
         {
-            break;
+            segments.push_back({&b, evictionIter, scanSize});
+
+            auto size = b.getRawBucket()->getSize();
+            uint64_t remaining = size > evictionIter.bucketFileOffset
+                                     ? size - evictionIter.bucketFileOffset
+                                     : 0;
+
+            // If we scan scanSize before hitting bucket EOF, exit early
+            if (scanSize <= remaining)
+            {
+                endsInBucket = true;
+                break;
+            }
+            scanSize -= static_cast<uint32_t>(remaining);
         }
 
         // If we return back to the Bucket we started at, exit
@@ -111,6 +144,79 @@ SearchableBucketListSnapshot::scanForEviction(
         }
     }
 
+    auto collect = [](Segment& s) {
+        std::list<EvictionResultEntry> candidates;
+        auto reachedEnd = s.bucket->collectEvictionCandidates(
+            s.iter, s.bytesToScan, candidates);
+        return std::make_pair(reachedEnd, std::move(candidates));
+    };
+
+    std::vector<std::future<std::pair<bool, std::list<EvictionResultEntry>>>>
+        futures;
+    for (size_t i = 1; i < segments.size(); ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async, collect,
+                                        std::ref(segments[i])));
+    }
+
+    std::list<EvictionResultEntry> candidates;
+    for (size_t i = 0; i < segments.size(); ++i)
+    {
+        auto [reachedEnd, segmentCandidates] =
+            i == 0 ? collect(segments[0]) : futures[i - 1].get();
+
+        // Every segment but the last one ending the region reads to eof
+        bool expectEnd = endsInBucket && i + 1 == segments.size();
+        releaseAssert(reachedEnd == expectEnd);
+        candidates.splice(candidates.end(), segmentCandidates);
+    }
+    if (endsInBucket)
+    {
+        evictionIter = segments.back().iter;
+    }
+
+    // Load all TTLs in a single bulk load and keep the candidates that are
+    // expired but not yet deleted
+    LedgerKeySet keysToSearch;
+    for (auto const& e : candidates)
+    {
+        keysToSearch.emplace(getTTLKey(e.key));
+    }
+    auto loadResult =
+        populateLoadedEntries(keysToSearch, loadKeys(keysToSearch));
+    LedgerKeySet keysToEvict;
+    for (auto& e : candidates)
+    {
+        // If TTL entry has not yet been deleted
+        auto const& [ttlKey, ttl] = *loadResult.find(getTTLKey(e.key));
+        if (ttl != nullptr)
+        {
+            // If TTL of entry is expired
+            if (!isLive(*ttl, ledgerSeq))
+            {
+                e.liveUntilLedger = ttl->data.ttl().liveUntilLedgerSeq;
+                result.eligibleKeys.emplace_back(e);
+                if (keysToEvict.size() < sas.maxEntriesToArchive)
+                {
+                    keysToEvict.emplace(e.key);
+                    result.loadedEntries.emplace(ttlKey, ttl);
+                }
+            }
+        }
+    }
+
+    // Load the entries most likely to be evicted in a second bulk load, here
+    // rather than one at a time when they are erased
+    if (!keysToEvict.empty())
+    {
+        auto loaded = loadKeys(keysToEvict);
+        for (auto& kv : populateLoadedEntries(keysToEvict, loaded))
+        {
+            result.loadedEntries.emplace(kv);
+        }
+    }
+    result.loadedLedger = getLedgerSeq();
+
     result.endOfRegionIterator = evictionIter;
     result.initialLedger = ledgerSeq;
     return result;
@@ -136,9 +242,36 @@ SearchableBucketListSnapshot::getLedgerEntry(LedgerKey const& k)
     }
 }
 
+uint32_t
+SearchableBucketListSnapshot::getLedgerSeq() const
+{
+    return mSnapshot->getLedgerSeq();
+}
+
 std::pair<std::shared_ptr<LedgerEntry>, bool>
 SearchableBucketListSnapshot::getLedgerEntryInternal(LedgerKey const& k)
 {
+    auto cache = mSnapshotManager.getEntryCache();
+    auto const ledgerSeq = mSnapshot->getLedgerSeq();
+    if (cache)
+    {
+        auto cached = cache->maybeGet(k, ledgerSeq);
+        if (threadIsMain())
+        {
+            mSnapshotManager.recordEntryCacheMetrics(cached ? 1 : 0,
+                                                     cached ? 0 : 1);
+        }
+
+        // Callers may modify the returned entry, so never hand out the
+        // cached copy
+        if (cached)
+        {
+            return {*cached ? std::make_shared<LedgerEntry>(**cached)
+                            : nullptr,
+                    false};
+        }
+    }
+
     std::shared_ptr<LedgerEntry> result{};
     auto sawBloomMiss = false;
 
@@ -161,6 +294,15 @@ SearchableBucketListSnapshot::getLedgerEntryInternal(LedgerKey const& k)
     };
 
     loopAllBuckets(f);
+
+    if (cache)
+    {
+        cache->put(k,
+                   result ? std::make_shared<LedgerEntry const>(*result)
+                          : nullptr,
+                   ledgerSeq);
+    }
+
     return {result, sawBloomMiss};
 }
 
@@ -172,12 +314,64 @@ SearchableBucketListSnapshot::loadKeysInternal(
 
     // Make a copy of the key set, this loop is destructive
     auto keys = inKeys;
+
+    // Serve what we can from the cache, and only search the BucketList for
+    // the remaining keys
+    auto cache = mSnapshotManager.getEntryCache();
+    auto const ledgerSeq = mSnapshot->getLedgerSeq();
+    std::set<LedgerKey, LedgerEntryIdCmp> notFound;
+    if (cache)
+    {
+        size_t hits = 0;
+        for (auto it = keys.begin(); it != keys.end();)
+        {
+            if (auto cached = cache->maybeGet(*it, ledgerSeq))
+            {
+                ++hits;
+                if (*cached)
+                {
+                    entries.emplace_back(**cached);
+                }
+                it = keys.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (threadIsMain())
+        {
+            mSnapshotManager.recordEntryCacheMetrics(hits, keys.size());
+        }
+        notFound = keys;
+    }
+
+    auto const firstLoaded = entries.size();
     auto f = [&](BucketSnapshot const& b) {
         b.loadKeys(keys, entries);
         return keys.empty();
     };
 
     loopAllBuckets(f);
+
+    if (cache)
+    {
+        for (size_t i = firstLoaded; i < entries.size(); ++i)
+        {
+            auto const& le = entries[i];
+            auto k = LedgerEntryKey(le);
+            notFound.erase(k);
+            cache->put(k, std::make_shared<LedgerEntry const>(le), ledgerSeq);
+        }
+
+        // Remaining keys are either dead or don't exist
+        for (auto const& k : notFound)
+        {
+            cache->put(k, nullptr, ledgerSeq);
+        }
+    }
+
     return entries;
 }
 
@@ -332,8 +526,89 @@ SearchableBucketListSnapshot::loadInflationWinners(size_t maxWinners,
     return winners;
 }
 
-BucketLevelSnapshot::BucketLevelSnapshot(BucketLevel const& level)
-    : curr(level.getCurr()), snap(level.getSnap())
+std::optional<std::vector<LedgerEntry>>
+SearchableBucketListSnapshot::loadAllOfTypes(
+    uint32_t ledgerSeq, std::string const& label,
+    std::vector<LedgerEntryType> const& types,
+    std::function<std::optional<std::pair<std::streamoff, std::streamoff>>(
+        Bucket const&)>
+        getRange)
+{
+    ZoneScoped;
+
+    // Only loaded by LedgerTxnRoot, on the main thread
+    releaseAssert(threadIsMain());
+    mSnapshotManager.maybeUpdateSnapshot(mSnapshot);
+    if (mSnapshot->getLedgerSeq() != ledgerSeq)
+    {
+        return std::nullopt;
+    }
+
+    auto timer = mSnapshotManager.recordBulkLoadMetrics(label, 0).TimeScope();
+
+    std::vector<LedgerEntry> entries;
+    UnorderedSet<LedgerKey> seen;
+
+    auto loadFromBucket = [&](BucketSnapshot const& b) {
+        auto bucket = b.getRawBucket();
+        auto range = getRange(*bucket);
+        if (!range)
+        {
+            return false; // continue
+        }
+
+        BucketInputIterator in(bucket);
+        in.seek(range->first);
+        for (; in && in.pos() < range->second; ++in)
+        {
+            BucketEntry const& be = *in;
+            if (be.type() == METAENTRY)
+            {
+                continue;
+            }
+
+            // Newer levels shadow older ones, including with dead entries
+            LedgerKey key = be.type() == DEADENTRY
+                                ? be.deadEntry()
+                                : LedgerEntryKey(be.liveEntry());
+            if (std::find(types.begin(), types.end(), key.type()) ==
+                    types.end() ||
+                !seen.emplace(std::move(key)).second)
+            {
+                continue;
+            }
+            if (be.type() != DEADENTRY)
+            {
+                entries.emplace_back(be.liveEntry());
+            }
+        }
+
+        return false; // continue
+    };
+
+    loopAllBuckets(loadFromBucket);
+    return entries;
+}
+
+std::optional<std::vector<LedgerEntry>>
+SearchableBucketListSnapshot::loadContractCodeAndTTL(uint32_t ledgerSeq)
+{
+    return loadAllOfTypes(
+        ledgerSeq, "contractCodeAndTTL", {CONTRACT_CODE, TTL},
+        [](Bucket const& b) { return b.getContractCodeAndTTLRange(); });
+}
+
+std::optional<std::vector<LedgerEntry>>
+SearchableBucketListSnapshot::loadLiquidityPools(uint32_t ledgerSeq)
+{
+    return loadAllOfTypes(
+        ledgerSeq, "liquidityPools", {LIQUIDITY_POOL},
+        [](Bucket const& b) { return b.getLiquidityPoolRange(); });
+}
+
+BucketLevelSnapshot::BucketLevelSnapshot(BucketLevel const& level,
+                                         bool useMmap)
+    : curr(level.getCurr(), useMmap), snap(level.getSnap(), useMmap)
 {
 }
 
@@ -22,7 +22,7 @@ struct BucketLevelSnapshot
     BucketSnapshot curr;
     BucketSnapshot snap;
 
-    BucketLevelSnapshot(BucketLevel const& level);
+    BucketLevelSnapshot(BucketLevel const& level, bool useMmap);
 };
 
 class BucketListSnapshot : public NonMovable
@@ -34,7 +34,10 @@ class BucketListSnapshot : public NonMovable
     uint32_t mLedgerSeq;
 
   public:
-    BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq);
+    // If useMmap is set, lookups on this snapshot (and all copies of it) read
+    // bucket files via memory mapping
+    BucketListSnapshot(BucketList const& bl, uint32_t ledgerSeq,
+                       bool useMmap);
 
     // Only allow copies via constructor
     BucketListSnapshot(BucketListSnapshot const& snapshot);
@@ -73,6 +76,16 @@ class SearchableBucketListSnapshot : public NonMovableOrCopyable
     std::pair<std::shared_ptr<LedgerEntry>, bool>
     getLedgerEntryInternal(LedgerKey const& k);
 
+    // Returns every live entry of `types` within the range `getRange` gives
+    // for each bucket, if the snapshot is that of ledger `ledgerSeq`, or
+    // std::nullopt otherwise
+    std::optional<std::vector<LedgerEntry>> loadAllOfTypes(
+        uint32_t ledgerSeq, std::string const& label,
+        std::vector<LedgerEntryType> const& types,
+        std::function<std::optional<std::pair<std::streamoff, std::streamoff>>(
+            Bucket const&)>
+            getRange);
+
     SearchableBucketListSnapshot(BucketSnapshotManager const& snapshotManager);
 
     friend std::shared_ptr<SearchableBucketListSnapshot>
@@ -91,6 +104,17 @@ class SearchableBucketListSnapshot : public NonMovableOrCopyable
 
     std::shared_ptr<LedgerEntry> getLedgerEntry(LedgerKey const& k);
 
+    // Return every live CONTRACT_CODE and TTL entry, or LIQUIDITY_POOL entry,
+    // if the snapshot is that of ledger `ledgerSeq`, or std::nullopt
+    // otherwise
+    std::optional<std::vector<LedgerEntry>>
+    loadContractCodeAndTTL(uint32_t ledgerSeq);
+    std::optional<std::vector<LedgerEntry>>
+    loadLiquidityPools(uint32_t ledgerSeq);
+
+    // Ledger of the snapshot as of the latest lookup; does not refresh it
+    uint32_t getLedgerSeq() const;
+
     EvictionResult scanForEviction(uint32_t ledgerSeq,
                                    EvictionCounters& counters,
                                    EvictionIterator evictionIter,
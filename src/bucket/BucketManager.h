@@ -5,7 +5,9 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/Bucket.h"
+#include "ledger/LedgerHashUtils.h"
 #include "util/NonCopyable.h"
+#include "util/UnorderedMap.h"
 #include "util/types.h"
 #include <future>
 #include <map>
@@ -26,6 +28,7 @@ namespace stellar
 class AbstractLedgerTxn;
 class Application;
 class BasicWork;
+class BucketIndexBudget;
 class BucketList;
 class BucketSnapshotManager;
 class Config;
@@ -110,6 +113,13 @@ struct EvictionResult
     // State archival settings that this scan is based on
     StateArchivalSettings initialSas;
 
+    // The first maxEntriesToArchive eligible entries and their TTLs, as
+    // loaded by the scan from the BucketList of ledger loadedLedger, so that
+    // evicting them needs no load on the close path
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
+        loadedEntries{};
+    uint32_t loadedLedger{};
+
     EvictionResult(StateArchivalSettings const& sas) : initialSas(sas)
     {
     }
@@ -190,10 +200,16 @@ class BucketManager : NonMovableOrCopyable
     virtual void dropAll() = 0;
     virtual std::string bucketIndexFilename(Hash const& hash) const = 0;
     virtual std::string const& getTmpDir() = 0;
+    // Tmp dir on the storage tier holding buckets of the given level. Files
+    // written here are adopted into that tier's bucket directory.
+    virtual std::string const& getTmpDirForLevel(uint32_t level) = 0;
     virtual TmpDirManager& getTmpDirManager() = 0;
     virtual std::string const& getBucketDir() const = 0;
     virtual BucketList& getBucketList() = 0;
     virtual BucketSnapshotManager& getBucketSnapshotManager() const = 0;
+    // The budget of persisted BucketListDB indexes, nullptr unless
+    // BUCKETLIST_DB_INDEX_MEMORY_BUDGET is set
+    virtual BucketIndexBudget* getIndexBudget() const = 0;
     virtual bool renameBucketDirFile(std::filesystem::path const& src,
                                      std::filesystem::path const& dst) = 0;
 
@@ -318,9 +334,15 @@ class BucketManager : NonMovableOrCopyable
     virtual std::set<Hash> getBucketListReferencedBuckets() const = 0;
 
     // Return the set of buckets referenced by the BucketList, LCL HAS,
-    // and publish queue.
+    // publish queue and the state a resumable catchup is applying.
     virtual std::set<Hash> getAllReferencedBuckets() const = 0;
 
+    // Keep the buckets of `has`, including across restarts, until this is
+    // called with nullopt. Used by CATCHUP_RESUMABLE catchups for the state
+    // they download and apply.
+    virtual void
+    setCatchupBucketState(std::optional<HistoryArchiveState> const& has) = 0;
+
     // Check for missing bucket files that would prevent `assumeState` from
     // succeeding
     virtual std::vector<std::string>
@@ -350,30 +372,44 @@ class BucketManager : NonMovableOrCopyable
 
     // Merge the bucket list of the provided HAS into a single "super bucket"
     // consisting of only live entries, and return it.
+    //
+    // Up to `numThreads` buckets are read at once, and then up to
+    // `numThreads` ranges of entry types are merged at once, each across all
+    // the buckets. Every bucket is held in memory until the merge finishes,
+    // so this needs about as much memory as the whole bucket list decoded:
+    // call it offline only.
     virtual std::shared_ptr<Bucket>
-    mergeBuckets(HistoryArchiveState const& has) = 0;
+    mergeBuckets(HistoryArchiveState const& has, size_t numThreads) = 0;
 
     // Visits all the active ledger entries or subset thereof.
     //
     // The order in which the entries are visited is not defined, but roughly
     // goes from more fresh entries to the older ones.
     //
-    // This accepts two visitors. `filterEntry` has to return `true`
-    // if the ledger entry can *potentially* be accepted. The passed entry isn't
-    // necessarily fresh or even alive. `acceptEntry` will only get the fresh
-    // alive entries that have passed the filter. If it returns `false` the
-    // iteration will immediately finish.
+    // This accepts two visitors. `makeFilterEntry` returns a filter that has
+    // to return `true` if the ledger entry can *potentially* be accepted. The
+    // passed entry isn't necessarily fresh or even alive. `acceptEntry` will
+    // only get the fresh alive entries that have passed the filter. If it
+    // returns `false` the iteration will immediately finish.
+    //
+    // Up to `numThreads` buckets are read and filtered at once, each on its
+    // own thread with its own filter from `makeFilterEntry`, which must hence
+    // be safe to call concurrently. `acceptEntry` is only called from the
+    // calling thread. Every bucket being read at once is held in memory until
+    // its entries are accepted.
     //
     // When `minLedger` is specified, only entries that have been modified at
     // `minLedger` or later are visited.
     //
-    // When `filterEntry` and `acceptEntry` always return `true`, this is
+    // When the filter and `acceptEntry` always return `true`, this is
     // equivalent to iterating over `loadCompleteLedgerState`, so the same
     // memory/runtime implications apply.
     virtual void visitLedgerEntries(
         HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-        std::function<bool(LedgerEntry const&)> const& filterEntry,
-        std::function<bool(LedgerEntry const&)> const& acceptEntry) = 0;
+        std::function<std::function<bool(LedgerEntry const&)>()> const&
+            makeFilterEntry,
+        std::function<bool(LedgerEntry const&)> const& acceptEntry,
+        size_t numThreads) = 0;
 
     // Schedule a Work class that verifies the hashes of all referenced buckets
     // on background threads.
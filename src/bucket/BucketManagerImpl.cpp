@@ -4,12 +4,15 @@
 
 #include "bucket/BucketManagerImpl.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndexBudget.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
 #include "bucket/BucketListSnapshot.h"
 #include "bucket/BucketOutputIterator.h"
 #include "bucket/BucketSnapshotManager.h"
+#include "bucket/LedgerCmp.h"
 #include "crypto/Hex.h"
+#include "crypto/SHA.h"
 #include "history/HistoryManager.h"
 #include "historywork/VerifyBucketWork.h"
 #include "ledger/LedgerManager.h"
@@ -17,17 +20,27 @@
 #include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "main/PersistentState.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MemoryAttribution.h"
 #include "util/TmpDir.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdr/Stellar-ledger.h"
+#include <algorithm>
+#include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
+#include <deque>
 #include <filesystem>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
+#include <fstream>
+#include <future>
 #include <map>
+#include <optional>
 #include <regex>
 #include <set>
 #include <thread>
@@ -38,7 +51,6 @@
 #include "medida/timer.h"
 #include "work/WorkScheduler.h"
 #include "xdrpp/printer.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -89,45 +101,149 @@ BucketManagerImpl::initialize()
 {
     ZoneScoped;
     std::string d = mApp.getConfig().BUCKET_DIR_PATH;
+    lockBucketDir(d);
+    mLockedBucketDir = std::make_unique<std::string>(d);
+    mTmpDirManager = std::make_unique<TmpDirManager>(d + "/tmp");
 
-    if (!fs::exists(d))
+    std::string const& deep = mApp.getConfig().DEEP_BUCKET_DIR_PATH;
+    if (!deep.empty())
     {
-        if (!fs::mkpath(d))
+        lockBucketDir(deep);
+        mLockedDeepBucketDir = std::make_unique<std::string>(deep);
+        mDeepTmpDirManager = std::make_unique<TmpDirManager>(deep + "/tmp");
+    }
+
+    if (mApp.getConfig().MODE_ENABLES_BUCKETLIST)
+    {
+        mBucketList = std::make_unique<BucketList>();
+
+        if (mApp.getConfig().isUsingBucketListDB())
         {
-            throw std::runtime_error("Unable to create bucket directory: " + d);
+            mSnapshotManager = std::make_unique<BucketSnapshotManager>(
+                mApp, std::make_unique<BucketListSnapshot>(
+                          *mBucketList, 0,
+                          mApp.getConfig().BUCKETLIST_DB_MMAP_READS));
+
+            auto const& cfg = mApp.getConfig();
+            if (cfg.isPersistingBucketListDBIndexes() &&
+                cfg.BUCKETLIST_DB_INDEX_MEMORY_BUDGET != 0)
+            {
+                mIndexBudget = std::make_shared<BucketIndexBudget>(
+                    *this, mApp.getMetrics(),
+                    cfg.BUCKETLIST_DB_INDEX_MEMORY_BUDGET * 1000000);
+            }
         }
+
+        loadFinishedMerges();
     }
+}
 
-    // Acquire exclusive lock on `buckets` folder
-    std::string lock = d + "/" + kLockFilename;
+void
+BucketManagerImpl::loadFinishedMerges()
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    auto filename = getBucketDir() + "/" + kFinishedMergesFilename;
+    if (!fs::exists(filename))
+    {
+        return;
+    }
 
-    // there are many reasons the lock can fail so let lockFile throw
-    // directly for more clear error messages since we end up just raising
-    // a runtime exception anyway
+    std::vector<std::pair<MergeKey, Hash>> merges;
     try
     {
-        fs::lockFile(lock);
+        std::vector<PersistedMerge> persisted;
+        {
+            std::ifstream in(filename);
+            in.exceptions(std::ios::badbit);
+            cereal::JSONInputArchive ar(in);
+            ar(cereal::make_nvp("merges", persisted));
+        }
+
+        for (auto const& m : persisted)
+        {
+            std::vector<Hash> shadows;
+            for (auto const& s : m.shadows)
+            {
+                shadows.emplace_back(hexToBin256(s));
+            }
+            merges.emplace_back(MergeKey(m.keepDeadEntries,
+                                         hexToBin256(m.curr),
+                                         hexToBin256(m.snap), shadows),
+                                hexToBin256(m.output));
+        }
     }
     catch (std::exception const& e)
     {
-        throw std::runtime_error(fmt::format(
-            FMT_STRING("{}. This can be caused by access rights issues or "
-                       "another stellar-core process already running"),
-            e.what()));
+        // Only a cache, worst case merges are redone
+        CLOG_WARNING(Bucket, "Ignoring unreadable finished merges file {}: {}",
+                     filename, e.what());
+        std::remove(filename.c_str());
+        return;
     }
 
-    mLockedBucketDir = std::make_unique<std::string>(d);
-    mTmpDirManager = std::make_unique<TmpDirManager>(d + "/tmp");
+    size_t loaded = 0;
+    for (auto const& [key, output] : merges)
+    {
+        if (fs::exists(bucketFilename(output)))
+        {
+            mFinishedMerges.recordMerge(key, output);
+            mUnverifiedMergeOutputs.emplace(output);
+            ++loaded;
+        }
+    }
 
-    if (mApp.getConfig().MODE_ENABLES_BUCKETLIST)
+    // Rewrite on next save to drop merges whose output is gone
+    mFinishedMergesDirty = loaded != merges.size();
+    CLOG_INFO(Bucket, "Loaded {} finished merges from {}", loaded, filename);
+}
+
+void
+BucketManagerImpl::saveFinishedMerges()
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    if (!mFinishedMergesDirty || !mLockedBucketDir)
     {
-        mBucketList = std::make_unique<BucketList>();
+        return;
+    }
 
-        if (mApp.getConfig().isUsingBucketListDB())
+    std::vector<PersistedMerge> persisted;
+    for (auto const& [key, output] : mFinishedMerges.getAllMerges())
+    {
+        auto& m = persisted.emplace_back();
+        m.keepDeadEntries = key.mKeepDeadEntries;
+        m.curr = binToHex(key.mInputCurrBucket);
+        m.snap = binToHex(key.mInputSnapBucket);
+        for (auto const& s : key.mInputShadowBuckets)
         {
-            mSnapshotManager = std::make_unique<BucketSnapshotManager>(
-                mApp, std::make_unique<BucketListSnapshot>(*mBucketList, 0));
+            m.shadows.emplace_back(binToHex(s));
+        }
+        m.output = binToHex(output);
+    }
+
+    auto filename = getBucketDir() + "/" + kFinishedMergesFilename;
+    try
+    {
+        auto tmpFilename = getTmpDir() + "/" + kFinishedMergesFilename;
+        {
+            std::ofstream out;
+            out.exceptions(std::ios::failbit | std::ios::badbit);
+            out.open(tmpFilename, std::ios_base::trunc);
+            cereal::JSONOutputArchive ar(out);
+            ar(cereal::make_nvp("merges", persisted));
+        }
+
+        if (!renameBucketDirFile(tmpFilename, filename))
+        {
+            throw std::runtime_error(strerror(errno));
         }
+        mFinishedMergesDirty = false;
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_WARNING(Bucket, "Failed to save finished merges to {}: {}",
+                     filename, e.what());
     }
 }
 
@@ -188,9 +304,60 @@ BucketManagerImpl::BucketManagerImpl(Application& app)
 }
 
 const std::string BucketManagerImpl::kLockFilename = "stellar-core.lock";
+const std::string BucketManagerImpl::kFinishedMergesFilename =
+    "finished-merges.json";
+
+// Creates the bucket directory d if necessary and acquires an exclusive lock
+// on it
+void
+BucketManagerImpl::lockBucketDir(std::string const& d)
+{
+    if (!fs::exists(d))
+    {
+        if (!fs::mkpath(d))
+        {
+            throw std::runtime_error("Unable to create bucket directory: " + d);
+        }
+    }
+
+    std::string lock = d + "/" + kLockFilename;
+
+    // there are many reasons the lock can fail so let lockFile throw
+    // directly for more clear error messages since we end up just raising
+    // a runtime exception anyway
+    try
+    {
+        fs::lockFile(lock);
+    }
+    catch (std::exception const& e)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("{}. This can be caused by access rights issues or "
+                       "another stellar-core process already running"),
+            e.what()));
+    }
+}
 
 namespace
 {
+// On-disk form of one BucketMergeMap record
+struct PersistedMerge
+{
+    bool keepDeadEntries{false};
+    std::string curr;
+    std::string snap;
+    std::vector<std::string> shadows;
+    std::string output;
+
+    template <class Archive>
+    void
+    serialize(Archive& ar)
+    {
+        ar(CEREAL_NVP(keepDeadEntries), CEREAL_NVP(curr), CEREAL_NVP(snap),
+           CEREAL_NVP(shadows), CEREAL_NVP(output));
+    }
+};
+
 std::string
 bucketBasename(std::string const& bucketHexHash)
 {
@@ -215,6 +382,14 @@ std::string
 BucketManagerImpl::bucketFilename(std::string const& bucketHexHash)
 {
     std::string basename = bucketBasename(bucketHexHash);
+    if (mLockedDeepBucketDir)
+    {
+        auto deepName = *mLockedDeepBucketDir + "/" + basename;
+        if (fs::exists(deepName))
+        {
+            return deepName;
+        }
+    }
     return getBucketDir() + "/" + basename;
 }
 
@@ -245,12 +420,42 @@ BucketManagerImpl::getTmpDir()
     return mWorkDir->getName();
 }
 
+std::string const&
+BucketManagerImpl::getTmpDirForLevel(uint32_t level)
+{
+    ZoneScoped;
+    if (!mDeepTmpDirManager ||
+        level < mApp.getConfig().DEEP_BUCKET_DIR_FIRST_LEVEL)
+    {
+        return getTmpDir();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    if (!mDeepWorkDir)
+    {
+        TmpDir t = mDeepTmpDirManager->tmpDir("bucket");
+        mDeepWorkDir = std::make_unique<TmpDir>(std::move(t));
+    }
+    return mDeepWorkDir->getName();
+}
+
 std::string const&
 BucketManagerImpl::getBucketDir() const
 {
     return *(mLockedBucketDir);
 }
 
+std::vector<std::string>
+BucketManagerImpl::getBucketDirs() const
+{
+    std::vector<std::string> dirs{getBucketDir()};
+    if (mLockedDeepBucketDir)
+    {
+        dirs.emplace_back(*mLockedDeepBucketDir);
+    }
+    return dirs;
+}
+
 BucketManagerImpl::~BucketManagerImpl()
 {
     ZoneScoped;
@@ -281,6 +486,13 @@ BucketManagerImpl::deleteEntireBucketDir()
         CLOG_DEBUG(Bucket, "Deleting bucket directory: {}", d);
         fs::deltree(d);
     }
+
+    std::string const& deep = mApp.getConfig().DEEP_BUCKET_DIR_PATH;
+    if (!deep.empty() && fs::exists(deep))
+    {
+        CLOG_DEBUG(Bucket, "Deleting deep bucket directory: {}", deep);
+        fs::deltree(deep);
+    }
 }
 
 void
@@ -297,6 +509,8 @@ BucketManagerImpl::deleteTmpDirAndUnlockBucketDir()
     //
     // (which also contains files from other subsystems, like history)
     mTmpDirManager.reset();
+    mDeepWorkDir.reset();
+    mDeepTmpDirManager.reset();
 
     // Then delete the lockfile $BUCKET_DIR_PATH/stellar-core.lock
     if (mLockedBucketDir)
@@ -307,6 +521,14 @@ BucketManagerImpl::deleteTmpDirAndUnlockBucketDir()
         fs::unlockFile(lock);
         mLockedBucketDir.reset();
     }
+
+    if (mLockedDeepBucketDir)
+    {
+        std::string lock = *mLockedDeepBucketDir + "/" + kLockFilename;
+        releaseAssert(fs::exists(lock));
+        fs::unlockFile(lock);
+        mLockedDeepBucketDir.reset();
+    }
 }
 
 BucketList&
@@ -324,6 +546,12 @@ BucketManagerImpl::getBucketSnapshotManager() const
     return *mSnapshotManager;
 }
 
+BucketIndexBudget*
+BucketManagerImpl::getIndexBudget() const
+{
+    return mIndexBudget.get();
+}
+
 medida::Timer&
 BucketManagerImpl::getMergeTimer()
 {
@@ -451,7 +679,8 @@ BucketManagerImpl::renameBucketDirFile(std::filesystem::path const& src,
     }
     else
     {
-        return fs::durableRename(src.string(), dst.string(), getBucketDir());
+        return fs::durableRename(src.string(), dst.string(),
+                                 dst.parent_path().string());
     }
 }
 
@@ -499,7 +728,16 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
     }
     else
     {
-        std::string canonicalName = bucketFilename(hash);
+        // Files written to the deep tier's tmp dir are adopted there, so that
+        // the rename stays on one filesystem
+        std::string dir = getBucketDir();
+        if (mDeepWorkDir &&
+            std::filesystem::path(filename).parent_path() ==
+                std::filesystem::path(mDeepWorkDir->getName()))
+        {
+            dir = *mLockedDeepBucketDir;
+        }
+        std::string canonicalName = dir + "/" + bucketBasename(binToHex(hash));
         CLOG_DEBUG(Bucket, "Adopting bucket file {} as {}", filename,
                    canonicalName);
         if (!renameBucketDirFile(filename, canonicalName))
@@ -516,11 +754,17 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
             }
         }
 
+        bool indexed = static_cast<bool>(index);
         b = std::make_shared<Bucket>(canonicalName, hash, std::move(index));
         {
             mSharedBuckets.emplace(hash, b);
             mSharedBucketsSize.set_count(mSharedBuckets.size());
         }
+
+        if (indexed)
+        {
+            maybeTrackIndex(b);
+        }
     }
     releaseAssert(b);
     if (mergeKey)
@@ -528,6 +772,7 @@ BucketManagerImpl::adoptFileAsBucket(std::string const& filename,
         // Second half of the mergeKey record-keeping, above: if we successfully
         // adopted (no throw), then (weakly) record the preimage of the hash.
         mFinishedMerges.recordMerge(*mergeKey, hash);
+        mFinishedMergesDirty = true;
     }
     return b;
 }
@@ -615,7 +860,9 @@ BucketManagerImpl::getMergeFuture(MergeKey const& key)
         Hash bucketHash;
         if (mFinishedMerges.findMergeFor(key, bucketHash))
         {
-            auto bucket = getBucketByHash(bucketHash);
+            auto bucket = mUnverifiedMergeOutputs.count(bucketHash) != 0
+                              ? getPersistedMergeOutput(bucketHash)
+                              : getBucketByHash(bucketHash);
             if (bucket)
             {
                 CLOG_TRACE(Bucket,
@@ -645,6 +892,65 @@ BucketManagerImpl::getMergeFuture(MergeKey const& key)
     return i->second;
 }
 
+std::shared_ptr<Bucket>
+BucketManagerImpl::getPersistedMergeOutput(Hash const& hash)
+{
+    ZoneScoped;
+    mUnverifiedMergeOutputs.erase(hash);
+
+    // Buckets already adopted this run have been checked elsewhere
+    if (auto b = getBucketIfExists(hash))
+    {
+        return b;
+    }
+
+    auto filename = bucketFilename(hash);
+    if (fs::exists(filename))
+    {
+        auto timer = LogSlowExecution("Verify persisted merge output");
+        SHA256 hasher;
+        std::ifstream in(filename, std::ifstream::binary);
+        std::vector<char> buf(1024 * 1024);
+        while (in)
+        {
+            in.read(buf.data(), buf.size());
+            hasher.add(ByteSlice(buf.data(), in.gcount()));
+        }
+
+        if (hasher.finish() == hash)
+        {
+            auto b = getBucketByHash(hash);
+            if (b && mApp.getConfig().isUsingBucketListDB() && !b->isIndexed())
+            {
+                std::unique_ptr<BucketIndex const> index;
+                auto indexFilename = bucketIndexFilename(hash);
+                if (mApp.getConfig().isPersistingBucketListDBIndexes() &&
+                    fs::exists(indexFilename))
+                {
+                    index = BucketIndex::load(*this, indexFilename, hash,
+                                              b->getSize());
+                }
+                if (!index)
+                {
+                    index = BucketIndex::createIndex(*this, filename, hash);
+                }
+                maybeSetIndex(b, std::move(index));
+            }
+            return b;
+        }
+
+        CLOG_WARNING(Bucket,
+                     "Persisted merge output {} does not match its hash, "
+                     "redoing merge",
+                     filename);
+        std::remove(filename.c_str());
+    }
+
+    mFinishedMerges.forgetAllMergesProducing(hash);
+    mFinishedMergesDirty = true;
+    return nullptr;
+}
+
 void
 BucketManagerImpl::putMergeFuture(
     MergeKey const& key, std::shared_future<std::shared_ptr<Bucket>> wp)
@@ -750,9 +1056,46 @@ BucketManagerImpl::getAllReferencedBuckets() const
             }
         }
     }
+
+    // retain buckets downloaded by a catchup that was maybe interrupted
+    // before applying them, so that it can resume with them
+    if (mApp.getConfig().CATCHUP_RESUMABLE)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+        if (!mCatchupBuckets)
+        {
+            mCatchupBuckets.emplace();
+            auto state = mApp.getPersistentState().getState(
+                PersistentState::kCatchupBucketState);
+            if (!state.empty())
+            {
+                HistoryArchiveState has;
+                has.fromString(state);
+                *mCatchupBuckets = has.allBuckets();
+            }
+        }
+        for (auto const& h : *mCatchupBuckets)
+        {
+            if (referenced.emplace(hexToBin256(h)).second)
+            {
+                CLOG_TRACE(Bucket, "{} referenced by catchup", h);
+            }
+        }
+    }
     return referenced;
 }
 
+void
+BucketManagerImpl::setCatchupBucketState(
+    std::optional<HistoryArchiveState> const& has)
+{
+    ZoneScoped;
+    std::lock_guard<std::recursive_mutex> lock(mBucketMutex);
+    mApp.getPersistentState().setState(PersistentState::kCatchupBucketState,
+                                       has ? has->toString() : "");
+    mCatchupBuckets = has ? has->allBuckets() : std::vector<std::string>{};
+}
+
 void
 BucketManagerImpl::cleanupStaleFiles()
 {
@@ -770,22 +1113,31 @@ BucketManagerImpl::cleanupStaleFiles()
                        return p.first;
                    });
 
-    for (auto f : fs::findfiles(getBucketDir(), isBucketFile))
+    for (auto const& dir : getBucketDirs())
     {
-        auto hash = extractFromFilename(f);
-        if (referenced.find(hash) == std::end(referenced))
+        for (auto f : fs::findfiles(dir, isBucketFile))
         {
-            // we don't care about failure here
-            // if removing file failed one time, it may not fail when this is
-            // called again
-            auto fullName = getBucketDir() + "/" + f;
-            std::remove(fullName.c_str());
-
-            // GC index as well
-            auto indexFilename = bucketIndexFilename(hash);
-            std::remove(indexFilename.c_str());
+            auto hash = extractFromFilename(f);
+            if (referenced.find(hash) == std::end(referenced))
+            {
+                // we don't care about failure here
+                // if removing file failed one time, it may not fail when this
+                // is called again
+                auto fullName = dir + "/" + f;
+                std::remove(fullName.c_str());
+
+                // GC index as well
+                auto indexFilename = bucketIndexFilename(hash);
+                std::remove(indexFilename.c_str());
+
+                if (!mFinishedMerges.forgetAllMergesProducing(hash).empty())
+                {
+                    mFinishedMergesDirty = true;
+                }
+            }
         }
     }
+    saveFinishedMerges();
 }
 
 void
@@ -851,8 +1203,13 @@ BucketManagerImpl::forgetUnreferencedBuckets()
             // as a short-cut to performing a merge we've already seen.
             // Therefore we should forget it from the weak map we use
             // for that resynthesis.
-            for (auto const& forgottenMergeKey :
-                 mFinishedMerges.forgetAllMergesProducing(j->first))
+            auto forgottenMergeKeys =
+                mFinishedMerges.forgetAllMergesProducing(j->first);
+            if (!forgottenMergeKeys.empty())
+            {
+                mFinishedMergesDirty = true;
+            }
+            for (auto const& forgottenMergeKey : forgottenMergeKeys)
             {
                 // There should be no futures alive with this output: we
                 // switched to storing only weak input/output mappings
@@ -879,6 +1236,7 @@ BucketManagerImpl::forgetUnreferencedBuckets()
         }
     }
     mSharedBucketsSize.set_count(mSharedBuckets.size());
+    saveFinishedMerges();
 }
 
 void
@@ -889,6 +1247,7 @@ BucketManagerImpl::addBatch(Application& app, uint32_t currLedger,
                             std::vector<LedgerKey> const& deadEntries)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Bucket);
     releaseAssertOrThrow(app.getConfig().MODE_ENABLES_BUCKETLIST);
 #ifdef BUILD_TESTS
     if (mUseFakeTestValuesForNextClose)
@@ -906,7 +1265,9 @@ BucketManagerImpl::addBatch(Application& app, uint32_t currLedger,
     if (app.getConfig().isUsingBucketListDB())
     {
         mSnapshotManager->updateCurrentSnapshot(
-            std::make_unique<BucketListSnapshot>(*mBucketList, currLedger));
+            std::make_unique<BucketListSnapshot>(
+                *mBucketList, currLedger,
+                app.getConfig().BUCKETLIST_DB_MMAP_READS));
     }
 }
 
@@ -924,9 +1285,12 @@ std::set<Hash>
 BucketManagerImpl::getBucketHashesInBucketDirForTesting() const
 {
     std::set<Hash> hashes;
-    for (auto f : fs::findfiles(getBucketDir(), isBucketFile))
+    for (auto const& dir : getBucketDirs())
     {
-        hashes.emplace(extractFromFilename(f));
+        for (auto f : fs::findfiles(dir, isBucketFile))
+        {
+            hashes.emplace(extractFromFilename(f));
+        }
     }
     return hashes;
 }
@@ -971,6 +1335,18 @@ BucketManagerImpl::maybeSetIndex(std::shared_ptr<Bucket> b,
     if (!isShutdown() && index && !b->isIndexed())
     {
         b->setIndex(std::move(index));
+        maybeTrackIndex(b);
+    }
+}
+
+void
+BucketManagerImpl::maybeTrackIndex(std::shared_ptr<Bucket> const& b)
+{
+    // Indexes that were not persisted (e.g. a bucket that was too small to
+    // have its index saved) cannot be reloaded and stay resident
+    if (mIndexBudget && fs::exists(bucketIndexFilename(b->getHash())))
+    {
+        mIndexBudget->track(b);
     }
 }
 
@@ -1054,6 +1430,14 @@ BucketManagerImpl::resolveBackgroundEvictionScan(
         }
     }
 
+    // The scan loaded the entries to evict from the BucketList the root
+    // loads from, so they go to its cache rather than being loaded again by
+    // each erase
+    if (evictionCandidates.loadedLedger + 1 == ledgerSeq)
+    {
+        ltx.prefetchLoaded(evictionCandidates.loadedEntries);
+    }
+
     auto remainingEntriesToEvict =
         networkConfig.stateArchivalSettings().maxEntriesToArchive;
     auto entryToEvictIter = eligibleKeys.begin();
@@ -1195,8 +1579,9 @@ BucketManagerImpl::assumeState(HistoryArchiveState const& has,
     if (mApp.getConfig().isUsingBucketListDB())
     {
         mSnapshotManager->updateCurrentSnapshot(
-            std::make_unique<BucketListSnapshot>(*mBucketList,
-                                                 has.currentLedger));
+            std::make_unique<BucketListSnapshot>(
+                *mBucketList, has.currentLedger,
+                mApp.getConfig().BUCKETLIST_DB_MMAP_READS));
     }
     cleanupStaleFiles();
 }
@@ -1205,6 +1590,7 @@ void
 BucketManagerImpl::shutdown()
 {
     mIsShutdown = true;
+    saveFinishedMerges();
 }
 
 bool
@@ -1295,42 +1681,212 @@ BucketManagerImpl::loadCompleteLedgerState(HistoryArchiveState const& has)
     return ledgerMap;
 }
 
+std::vector<std::pair<std::shared_ptr<Bucket const>, std::string>>
+BucketManagerImpl::getBucketsOfHAS(HistoryArchiveState const& has)
+{
+    std::vector<std::pair<Hash, std::string>> hashes;
+    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+    {
+        HistoryStateBucket const& hsb = has.currentBuckets.at(i);
+        hashes.emplace_back(hexToBin256(hsb.curr),
+                            fmt::format(FMT_STRING("curr {:d}"), i));
+        hashes.emplace_back(hexToBin256(hsb.snap),
+                            fmt::format(FMT_STRING("snap {:d}"), i));
+    }
+    std::vector<std::pair<std::shared_ptr<Bucket const>, std::string>>
+        buckets;
+    for (auto const& pair : hashes)
+    {
+        if (isZero(pair.first))
+        {
+            continue;
+        }
+        auto b = getBucketByHash(pair.first);
+        if (!b)
+        {
+            throw std::runtime_error(std::string("missing bucket: ") +
+                                     binToHex(pair.first));
+        }
+        buckets.emplace_back(b, pair.second);
+    }
+    return buckets;
+}
+
+namespace
+{
+// The entries of a bucket, in key order, without its METAENTRY
+std::vector<BucketEntry>
+readBucketEntries(std::shared_ptr<Bucket const> b, std::string const& name)
+{
+    ZoneScoped;
+
+    std::vector<BucketEntry> entries;
+    for (BucketInputIterator in(b); in; ++in)
+    {
+        entries.emplace_back(*in);
+    }
+    CLOG_INFO(Bucket, "Read {} entries of {}-byte bucket file '{}'",
+              entries.size(), b->getSize(), name);
+    return entries;
+}
+
+LedgerEntryType
+bucketEntryType(BucketEntry const& e)
+{
+    return e.type() == DEADENTRY ? e.deadEntry().type()
+                                 : e.liveEntry().data.type();
+}
+
+// Merges the entries of types [first, last] of `runs`, the buckets from the
+// newest, into the live entries they leave, in key order. Keys being ordered
+// by type first, each range of types is a slice of every bucket.
+std::vector<BucketEntry>
+mergeTypeRange(std::vector<std::vector<BucketEntry>> const& runs,
+               LedgerEntryType first, LedgerEntryType last)
+{
+    ZoneScoped;
+
+    using Iter = std::vector<BucketEntry>::const_iterator;
+    std::vector<std::pair<Iter, Iter>> heads;
+    for (auto const& run : runs)
+    {
+        auto begin = std::partition_point(
+            run.begin(), run.end(),
+            [&](BucketEntry const& e) { return bucketEntryType(e) < first; });
+        auto end = std::partition_point(
+            begin, run.end(),
+            [&](BucketEntry const& e) { return bucketEntryType(e) <= last; });
+        heads.emplace_back(begin, end);
+    }
+
+    BucketEntryIdCmp cmp;
+    std::vector<BucketEntry> merged;
+    while (true)
+    {
+        // The lowest key left, from the newest bucket holding it
+        std::optional<size_t> newest;
+        for (size_t i = 0; i < heads.size(); ++i)
+        {
+            if (heads[i].first != heads[i].second &&
+                (!newest || cmp(*heads[i].first, *heads[*newest].first)))
+            {
+                newest = i;
+            }
+        }
+        if (!newest)
+        {
+            break;
+        }
+        BucketEntry const& e = *heads[*newest].first;
+        if (e.type() != DEADENTRY)
+        {
+            BucketEntry live;
+            live.type(LIVEENTRY);
+            live.liveEntry() = e.liveEntry();
+            merged.emplace_back(std::move(live));
+        }
+        for (auto& head : heads)
+        {
+            if (head.first != head.second && !cmp(e, *head.first))
+            {
+                ++head.first;
+            }
+        }
+    }
+    return merged;
+}
+}
+
 std::shared_ptr<Bucket>
-BucketManagerImpl::mergeBuckets(HistoryArchiveState const& has)
+BucketManagerImpl::mergeBuckets(HistoryArchiveState const& has,
+                                size_t numThreads)
 {
     ZoneScoped;
+    releaseAssert(numThreads > 0);
+
+    auto buckets = getBucketsOfHAS(has);
+    auto policy = numThreads > 1 ? std::launch::async : std::launch::deferred;
+
+    // Read up to `numThreads` buckets at once, keeping all of them in memory
+    std::vector<std::vector<BucketEntry>> runs(buckets.size());
+    for (size_t i = 0; i < buckets.size(); i += numThreads)
+    {
+        std::vector<std::future<void>> reads;
+        for (size_t j = i; j < std::min(i + numThreads, buckets.size()); ++j)
+        {
+            reads.emplace_back(std::async(policy, [&buckets, &runs, j]() {
+                runs[j] = readBucketEntries(buckets[j].first,
+                                            buckets[j].second);
+            }));
+        }
+        for (auto& r : reads)
+        {
+            r.get();
+        }
+    }
+
+    // Then merge up to `numThreads` ranges of entry types at once, writing
+    // them in order as they finish
+    std::vector<LedgerEntryType> types;
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        types.emplace_back(static_cast<LedgerEntryType>(let));
+    }
+    size_t numRanges = std::min(numThreads, types.size());
+    std::vector<std::future<std::vector<BucketEntry>>> ranges;
+    for (size_t i = 0; i < numRanges; ++i)
+    {
+        auto first = types.at(i * types.size() / numRanges);
+        auto last = types.at((i + 1) * types.size() / numRanges - 1);
+        ranges.emplace_back(std::async(policy, [&runs, first, last]() {
+            return mergeTypeRange(runs, first, last);
+        }));
+    }
 
-    std::map<LedgerKey, LedgerEntry> ledgerMap = loadCompleteLedgerState(has);
     BucketMetadata meta;
     MergeCounters mc;
     auto& ctx = mApp.getClock().getIOContext();
     meta.ledgerVersion = mApp.getConfig().LEDGER_PROTOCOL_VERSION;
     BucketOutputIterator out(getTmpDir(), /*keepDeadEntries=*/false, meta, mc,
                              ctx, /*doFsync=*/true);
-    for (auto const& pair : ledgerMap)
+    size_t written = 0;
+    for (size_t i = 0; i < ranges.size(); ++i)
     {
-        BucketEntry be;
-        be.type(LIVEENTRY);
-        be.liveEntry() = pair.second;
-        out.put(be);
+        auto entries = ranges[i].get();
+        for (auto& be : entries)
+        {
+            out.put(std::move(be));
+        }
+        written += entries.size();
+        CLOG_INFO(Bucket, "Merged {}/{} entry type ranges, {} entries",
+                  i + 1, ranges.size(), written);
     }
     return out.getBucket(*this, /*shouldSynchronouslyIndex=*/false);
 }
 
-static bool
-visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
-                     std::optional<int64_t> minLedger,
-                     std::function<bool(LedgerEntry const&)> const& filterEntry,
-                     std::function<bool(LedgerEntry const&)> const& acceptEntry,
-                     UnorderedSet<LedgerKey>& processedEntries)
+namespace
+{
+// What is left of a bucket once filtered, before it is deduplicated against
+// the newer buckets. Buckets hold each key at most once, so the order of the
+// entries doesn't matter.
+struct BucketScan
+{
+    std::vector<std::pair<LedgerKey, LedgerEntry>> mLive;
+    std::vector<LedgerKey> mDead;
+    bool mReachedMinLedger{false};
+};
+
+BucketScan
+scanBucket(std::shared_ptr<Bucket const> b, std::string const& name,
+           std::optional<int64_t> minLedger,
+           std::function<bool(LedgerEntry const&)> const& filterEntry)
 {
     ZoneScoped;
 
     using namespace std::chrono;
     medida::Timer timer;
 
-    UnorderedMap<LedgerKey, LedgerEntry> bucketEntries;
-    bool stopIteration = false;
+    BucketScan scan;
     timer.Time([&]() {
         for (BucketInputIterator in(b); in; ++in)
         {
@@ -1340,19 +1896,15 @@ visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
                 if (minLedger &&
                     e.liveEntry().lastModifiedLedgerSeq < *minLedger)
                 {
-                    stopIteration = true;
+                    scan.mReachedMinLedger = true;
                     continue;
                 }
                 if (!filterEntry(e.liveEntry()))
                 {
                     continue;
                 }
-                auto key = LedgerEntryKey(e.liveEntry());
-                if (processedEntries.find(key) != processedEntries.end())
-                {
-                    continue;
-                }
-                bucketEntries[key] = e.liveEntry();
+                scan.mLive.emplace_back(LedgerEntryKey(e.liveEntry()),
+                                        e.liveEntry());
             }
             else
             {
@@ -1363,17 +1915,7 @@ visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
                     CLOG_ERROR(Bucket, "{}", err);
                     throw std::runtime_error(err);
                 }
-                bucketEntries.erase(e.deadEntry());
-                processedEntries.insert(e.deadEntry());
-            }
-        }
-        for (auto const& [key, entry] : bucketEntries)
-        {
-            processedEntries.insert(key);
-            if (!acceptEntry(entry))
-            {
-                stopIteration = true;
-                break;
+                scan.mDead.emplace_back(e.deadEntry());
             }
         }
     });
@@ -1383,48 +1925,83 @@ visitEntriesInBucket(std::shared_ptr<Bucket const> b, std::string const& name,
     size_t bytesPerSec = (b->getSize() * 1000 / (1 + ms.count()));
     CLOG_INFO(Bucket, "Processed {}-byte bucket file '{}' in {} ({}/s)",
               b->getSize(), name, ms, formatSize(bytesPerSec));
-    return !stopIteration;
+    return scan;
+}
+
+// Hands the fresh entries of `scan` to `acceptEntry`, returning false once
+// the iteration should stop
+bool
+acceptScannedEntries(
+    BucketScan& scan,
+    std::function<bool(LedgerEntry const&)> const& acceptEntry,
+    UnorderedSet<LedgerKey>& processedEntries)
+{
+    for (auto& key : scan.mDead)
+    {
+        processedEntries.emplace(std::move(key));
+    }
+    for (auto const& [key, entry] : scan.mLive)
+    {
+        if (!processedEntries.emplace(key).second)
+        {
+            continue;
+        }
+        if (!acceptEntry(entry))
+        {
+            return false;
+        }
+    }
+    return !scan.mReachedMinLedger;
+}
 }
 
 void
 BucketManagerImpl::visitLedgerEntries(
     HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-    std::function<bool(LedgerEntry const&)> const& filterEntry,
-    std::function<bool(LedgerEntry const&)> const& acceptEntry)
+    std::function<std::function<bool(LedgerEntry const&)>()> const&
+        makeFilterEntry,
+    std::function<bool(LedgerEntry const&)> const& acceptEntry,
+    size_t numThreads)
 {
     ZoneScoped;
+    releaseAssert(numThreads > 0);
 
-    UnorderedSet<LedgerKey> deletedEntries;
-    std::vector<std::pair<Hash, std::string>> hashes;
-    for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
-    {
-        HistoryStateBucket const& hsb = has.currentBuckets.at(i);
-        hashes.emplace_back(hexToBin256(hsb.curr),
-                            fmt::format(FMT_STRING("curr {:d}"), i));
-        hashes.emplace_back(hexToBin256(hsb.snap),
-                            fmt::format(FMT_STRING("snap {:d}"), i));
-    }
+    auto buckets = getBucketsOfHAS(has);
+
+    // Up to `numThreads` buckets are read and filtered at once, each with its
+    // own filter, while they are deduplicated and accepted one at a time from
+    // the newest
+    auto policy = numThreads > 1 ? std::launch::async : std::launch::deferred;
+    std::deque<std::future<BucketScan>> scans;
+    size_t nextBucket = 0;
+    UnorderedSet<LedgerKey> processedEntries;
     medida::Timer timer;
     timer.Time([&]() {
-        for (auto const& pair : hashes)
+        while (true)
         {
-            if (isZero(pair.first))
+            while (scans.size() < numThreads && nextBucket < buckets.size())
             {
-                continue;
+                auto const& bucket = buckets[nextBucket++];
+                auto scanFn = [&bucket, minLedger, &makeFilterEntry]() {
+                    return scanBucket(bucket.first, bucket.second, minLedger,
+                                      makeFilterEntry());
+                };
+                scans.emplace_back(std::async(policy, scanFn));
             }
-            auto b = getBucketByHash(pair.first);
-            if (!b)
+            if (scans.empty())
             {
-                throw std::runtime_error(std::string("missing bucket: ") +
-                                         binToHex(pair.first));
+                break;
             }
-            if (!visitEntriesInBucket(b, pair.second, minLedger, filterEntry,
-                                      acceptEntry, deletedEntries))
+            auto scan = scans.front().get();
+            scans.pop_front();
+            if (!acceptScannedEntries(scan, acceptEntry, processedEntries))
             {
                 break;
             }
         }
     });
+    // Scans still running when the iteration stopped early are waited for
+    // by their futures going out of scope, before `buckets`
     auto ns = timer.duration_unit() *
               static_cast<std::chrono::nanoseconds::rep>(timer.max());
     CLOG_INFO(Bucket, "Total ledger processing time: {}",
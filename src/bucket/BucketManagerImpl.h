@@ -29,6 +29,7 @@ class TmpDir;
 class AbstractLedgerTxn;
 class Application;
 class Bucket;
+class BucketIndexBudget;
 class BucketList;
 class BucketSnapshotManager;
 struct HistoryArchiveState;
@@ -36,12 +37,22 @@ struct HistoryArchiveState;
 class BucketManagerImpl : public BucketManager
 {
     static std::string const kLockFilename;
+    static std::string const kFinishedMergesFilename;
 
     Application& mApp;
     std::unique_ptr<BucketList> mBucketList;
     std::unique_ptr<BucketSnapshotManager> mSnapshotManager;
+
+    // Only set if BUCKETLIST_DB_INDEX_MEMORY_BUDGET is set and indexes are
+    // persisted
+    std::shared_ptr<BucketIndexBudget> mIndexBudget;
     std::unique_ptr<TmpDirManager> mTmpDirManager;
     std::unique_ptr<TmpDir> mWorkDir;
+
+    // Only set if DEEP_BUCKET_DIR_PATH is set
+    std::unique_ptr<std::string> mLockedDeepBucketDir;
+    std::unique_ptr<TmpDirManager> mDeepTmpDirManager;
+    std::unique_ptr<TmpDir> mDeepWorkDir;
     std::map<Hash, std::shared_ptr<Bucket>> mSharedBuckets;
 
     // Lock for managing raw Bucket files or the bucket directory. This lock is
@@ -79,9 +90,29 @@ class BucketManagerImpl : public BucketManager
     // alive. Needs to be queried and updated on mSharedBuckets GC events.
     BucketMergeMap mFinishedMerges;
 
+    // mFinishedMerges is persisted in the bucket dir so that merges which
+    // finished before a restart can be reattached to instead of redone.
+    // Outputs of merges loaded from disk are hash-checked before first use.
+    UnorderedSet<Hash> mUnverifiedMergeOutputs;
+    bool mFinishedMergesDirty{false};
+
+    // Buckets of the state set by setCatchupBucketState, loaded from the
+    // database the first time they are needed
+    mutable std::optional<std::vector<std::string>> mCatchupBuckets;
+
     std::atomic<bool> mIsShutdown{false};
 
     void cleanupStaleFiles();
+
+    // Hands b's index to the index budget, if any, once it is on disk
+    void maybeTrackIndex(std::shared_ptr<Bucket> const& b);
+
+    void loadFinishedMerges();
+    void saveFinishedMerges();
+
+    // Returns the output of a merge finished before the last restart, or
+    // nullptr if it is missing or does not match its hash
+    std::shared_ptr<Bucket> getPersistedMergeOutput(Hash const& hash);
     void deleteTmpDirAndUnlockBucketDir();
     void deleteEntireBucketDir();
 
@@ -89,6 +120,11 @@ class BucketManagerImpl : public BucketManager
                                          size_t numEntries) const;
     medida::Timer& getPointLoadTimer(LedgerEntryType t) const;
 
+    // The buckets of `has` that aren't empty, from the newest, with their
+    // names for logging
+    std::vector<std::pair<std::shared_ptr<Bucket const>, std::string>>
+    getBucketsOfHAS(HistoryArchiveState const& has);
+
 #ifdef BUILD_TESTS
     bool mUseFakeTestValuesForNextClose{false};
     uint32_t mFakeTestProtocolVersion;
@@ -97,9 +133,16 @@ class BucketManagerImpl : public BucketManager
 
   protected:
     void calculateSkipValues(LedgerHeader& currentHeader);
+    // Returns the path of the bucket file with the given hash, in whichever
+    // bucket directory holds it. Defaults to the primary bucket directory if
+    // the file does not exist.
     std::string bucketFilename(std::string const& bucketHexHash);
     std::string bucketFilename(Hash const& hash);
 
+    // Bucket directories of all storage tiers, primary first
+    std::vector<std::string> getBucketDirs() const;
+    void lockBucketDir(std::string const& d);
+
   public:
     BucketManagerImpl(Application& app);
     ~BucketManagerImpl() override;
@@ -107,9 +150,11 @@ class BucketManagerImpl : public BucketManager
     void dropAll() override;
     std::string bucketIndexFilename(Hash const& hash) const override;
     std::string const& getTmpDir() override;
+    std::string const& getTmpDirForLevel(uint32_t level) override;
     std::string const& getBucketDir() const override;
     BucketList& getBucketList() override;
     BucketSnapshotManager& getBucketSnapshotManager() const override;
+    BucketIndexBudget* getIndexBudget() const override;
     medida::Timer& getMergeTimer() override;
     MergeCounters readMergeCounters() override;
     void incrMergeCounters(MergeCounters const&) override;
@@ -165,6 +210,8 @@ class BucketManagerImpl : public BucketManager
 
     std::set<Hash> getBucketListReferencedBuckets() const override;
     std::set<Hash> getAllReferencedBuckets() const override;
+    void setCatchupBucketState(
+        std::optional<HistoryArchiveState> const& has) override;
     std::vector<std::string>
     checkForMissingBucketsFiles(HistoryArchiveState const& has) override;
     void assumeState(HistoryArchiveState const& has,
@@ -177,12 +224,14 @@ class BucketManagerImpl : public BucketManager
     loadCompleteLedgerState(HistoryArchiveState const& has) override;
 
     std::shared_ptr<Bucket>
-    mergeBuckets(HistoryArchiveState const& has) override;
+    mergeBuckets(HistoryArchiveState const& has, size_t numThreads) override;
 
     void visitLedgerEntries(
         HistoryArchiveState const& has, std::optional<int64_t> minLedger,
-        std::function<bool(LedgerEntry const&)> const& filterEntry,
-        std::function<bool(LedgerEntry const&)> const& acceptEntry) override;
+        std::function<std::function<bool(LedgerEntry const&)>()> const&
+            makeFilterEntry,
+        std::function<bool(LedgerEntry const&)> const& acceptEntry,
+        size_t numThreads) override;
 
     std::shared_ptr<BasicWork> scheduleVerifyReferencedBucketsWork() override;
 
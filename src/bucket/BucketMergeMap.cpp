@@ -6,7 +6,7 @@
 #include "crypto/Hex.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace
 {
@@ -129,4 +129,12 @@ BucketMergeMap::getOutputsUsingInput(Hash const& input,
                    hexAbbrev(i->second), hexAbbrev(input));
     }
 }
+
+std::vector<std::pair<MergeKey, Hash>>
+BucketMergeMap::getAllMerges() const
+{
+    ZoneScoped;
+    return std::vector<std::pair<MergeKey, Hash>>(mMergeKeyToOutput.begin(),
+                                                  mMergeKeyToOutput.end());
+}
 }
@@ -6,6 +6,7 @@
 #include "util/UnorderedSet.h"
 #include "xdr/Stellar-types.h"
 #include <set>
+#include <vector>
 
 // Copyright 2019 Stellar Development Foundation and contributors. Licensed
 // under the Apache License, Version 2.0. See the COPYING file at the root
@@ -45,5 +46,8 @@ class BucketMergeMap
     UnorderedSet<MergeKey> forgetAllMergesProducing(Hash const& output);
     bool findMergeFor(MergeKey const& input, Hash& output);
     void getOutputsUsingInput(Hash const& input, std::set<Hash>& outputs) const;
+
+    // Returns every recorded merge, for persisting the map across restarts
+    std::vector<std::pair<MergeKey, Hash>> getAllMerges() const;
 };
 }
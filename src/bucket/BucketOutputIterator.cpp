@@ -7,7 +7,7 @@
 #include "bucket/BucketIndex.h"
 #include "bucket/BucketManager.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <filesystem>
 
 namespace stellar
@@ -47,10 +47,9 @@ BucketOutputIterator::BucketOutputIterator(std::string const& tmpDir,
     }
 }
 
-void
-BucketOutputIterator::put(BucketEntry const& e)
+bool
+BucketOutputIterator::prepareToBuffer(BucketEntry const& e)
 {
-    ZoneScoped;
     Bucket::checkProtocolLegality(e, mMeta.ledgerVersion);
     if (e.type() == METAENTRY)
     {
@@ -64,7 +63,7 @@ BucketOutputIterator::put(BucketEntry const& e)
     if (!mKeepDeadEntries && e.type() == DEADENTRY)
     {
         ++mMergeCounters.mOutputIteratorTombstoneElisions;
-        return;
+        return false;
     }
 
     // Check to see if there's an existing buffered entry.
@@ -88,9 +87,43 @@ BucketOutputIterator::put(BucketEntry const& e)
         mBuf = std::make_unique<BucketEntry>();
     }
 
-    // In any case, replace *mBuf with e.
+    // In any case, the caller replaces *mBuf with e.
     ++mMergeCounters.mOutputIteratorBufferUpdates;
-    *mBuf = e;
+    return true;
+}
+
+void
+BucketOutputIterator::put(BucketEntry const& e)
+{
+    ZoneScoped;
+    if (prepareToBuffer(e))
+    {
+        *mBuf = e;
+    }
+}
+
+void
+BucketOutputIterator::put(BucketEntry&& e)
+{
+    ZoneScoped;
+    if (prepareToBuffer(e))
+    {
+        // Swapping hands the previously buffered entry back to the caller, so
+        // its heap storage is reused by whatever is next decoded into it.
+        std::swap(*mBuf, e);
+    }
+}
+
+void
+BucketOutputIterator::preallocate(size_t estimatedSize)
+{
+    mOut.preallocate(estimatedSize);
+}
+
+void
+BucketOutputIterator::setDropCacheBehind(bool dropCacheBehind)
+{
+    mOut.setDropCacheBehind(dropCacheBehind);
 }
 
 std::shared_ptr<Bucket>
@@ -35,6 +35,10 @@ class BucketOutputIterator
     bool mPutMeta{false};
     MergeCounters& mMergeCounters;
 
+    // Checks e, flushes the buffered entry if e has a greater identity and
+    // makes sure mBuf is allocated. Returns false if e should be dropped.
+    bool prepareToBuffer(BucketEntry const& e);
+
   public:
     // BucketOutputIterators must _always_ be constructed with BucketMetadata,
     // regardless of the ledger version the bucket is being written from, even
@@ -49,6 +53,16 @@ class BucketOutputIterator
 
     void put(BucketEntry const& e);
 
+    // Same as put, but may leave e holding any valid value.
+    void put(BucketEntry&& e);
+
+    // Reserves estimatedSize bytes on disk for the output file. Unused space
+    // is released when the bucket is produced.
+    void preallocate(size_t estimatedSize);
+
+    // Keeps the output file out of the OS page cache as it is written.
+    void setDropCacheBehind(bool dropCacheBehind);
+
     std::shared_ptr<Bucket> getBucket(BucketManager& bucketManager,
                                       bool shouldSynchronouslyIndex,
                                       MergeKey* mergeKey = nullptr);
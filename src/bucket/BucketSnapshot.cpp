@@ -7,22 +7,33 @@
 #include "bucket/BucketListSnapshot.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTypeUtils.h"
+#include "util/FilePrefetcher.h"
+#include "util/MmapFile.h"
 #include "util/XDRStream.h"
 
 namespace stellar
 {
-BucketSnapshot::BucketSnapshot(std::shared_ptr<Bucket const> const b)
-    : mBucket(b)
+BucketSnapshot::BucketSnapshot(std::shared_ptr<Bucket const> const b,
+                               bool useMmap)
+    : mBucket(b), mUseMmap(useMmap)
 {
     releaseAssert(mBucket);
 }
 
 BucketSnapshot::BucketSnapshot(BucketSnapshot const& b)
-    : mBucket(b.mBucket), mStream(nullptr)
+    : mBucket(b.mBucket)
+    , mUseMmap(b.mUseMmap)
+    , mStream(nullptr)
+    , mMappedFile(nullptr)
+    , mPrefetcher(nullptr)
 {
     releaseAssert(mBucket);
 }
 
+BucketSnapshot::~BucketSnapshot()
+{
+}
+
 bool
 BucketSnapshot::isEmpty() const
 {
@@ -40,13 +51,26 @@ BucketSnapshot::getEntryAtOffset(LedgerKey const& k, std::streamoff pos,
         return {std::nullopt, false};
     }
 
+    BucketEntry be;
+    if (mUseMmap)
+    {
+        if (readFromMappedFile(be, k, pos, pageSize))
+        {
+            return {std::make_optional(be), false};
+        }
+
+        mBucket->getIndex()->markBloomMiss();
+        return {std::nullopt, true};
+    }
+
     auto& stream = getStream();
     stream.seek(pos);
 
-    BucketEntry be;
     if (pageSize == 0)
     {
-        if (stream.readOne(be))
+        // Individual indexes match keys by fingerprint, so the entry read may
+        // belong to a different key
+        if (stream.readOne(be) && getBucketLedgerKey(be) == k)
         {
             return {std::make_optional(be), false};
         }
@@ -57,10 +81,73 @@ BucketSnapshot::getEntryAtOffset(LedgerKey const& k, std::streamoff pos,
     }
 
     // Mark entry miss for metrics
-    mBucket->getIndex().markBloomMiss();
+    mBucket->getIndex()->markBloomMiss();
     return {std::nullopt, true};
 }
 
+bool
+BucketSnapshot::readFromMappedFile(BucketEntry& out, LedgerKey const& k,
+                                   std::streamoff pos, size_t pageSize) const
+{
+    ZoneScoped;
+    if (!mMappedFile)
+    {
+        mMappedFile = mBucket->getMappedFile();
+    }
+
+    auto const& file = *mMappedFile;
+    char const* const data = file.data();
+    size_t const fileSize = file.size();
+    size_t xdrStart = static_cast<size_t>(pos);
+
+    // Decodes the record whose size header starts at xdrStart and advances
+    // xdrStart past it
+    auto decodeNext = [&]() {
+        auto sz = XDRInputFileStream::getXDRSize(
+            const_cast<char*>(data + xdrStart));
+        xdrStart += 4;
+        size_t xdrEnd = xdrStart + sz;
+        if (xdrEnd > fileSize)
+        {
+            throw xdr::xdr_runtime_error(
+                "malformed XDR file in mapped bucket read");
+        }
+
+        ZoneNamedN(__unpack, "xdr_unpack_entry", true);
+        xdr::xdr_get g(data + xdrStart, data + xdrEnd);
+        xdr::xdr_argpack_archive(g, out);
+        xdrStart = xdrEnd;
+    };
+
+    if (pageSize == 0)
+    {
+        if (xdrStart + 4 > fileSize)
+        {
+            return false;
+        }
+        decodeNext();
+        return getBucketLedgerKey(out) == k;
+    }
+
+    // Fault in the whole index page with one I/O, since random-access advice
+    // on the mapping has disabled readahead
+    file.adviseWillNeed(xdrStart, pageSize);
+
+    // As in XDRInputFileStream::readPage, every entry that starts within the
+    // page is considered, including one that continues past the page end
+    size_t const pageEnd = std::min(fileSize, xdrStart + pageSize);
+    while (xdrStart + 4 <= pageEnd)
+    {
+        decodeNext();
+        if (getBucketLedgerKey(out) == k)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 std::pair<std::optional<BucketEntry>, bool>
 BucketSnapshot::getBucketEntry(LedgerKey const& k) const
 {
@@ -70,21 +157,75 @@ BucketSnapshot::getBucketEntry(LedgerKey const& k) const
         return {std::nullopt, false};
     }
 
-    auto pos = mBucket->getIndex().lookup(k);
+    auto index = mBucket->getIndex();
+    auto pos = index->lookup(k);
     if (pos.has_value())
     {
-        return getEntryAtOffset(k, pos.value(),
-                                mBucket->getIndex().getPageSize());
+        return getEntryAtOffset(k, pos.value(), index->getPageSize());
     }
 
     return {std::nullopt, false};
 }
 
+void
+BucketSnapshot::prefetchOffsets(std::vector<std::streamoff> const& offsets,
+                                size_t pageSize) const
+{
+    ZoneScoped;
+
+    // Individual indexes give exact entry offsets but not sizes, so prefetch
+    // a small fixed amount that covers most entries
+    size_t const len = pageSize == 0 ? INDIVIDUAL_ENTRY_PREFETCH_BYTES
+                                     : pageSize;
+    if (mUseMmap)
+    {
+        if (!mMappedFile)
+        {
+            mMappedFile = mBucket->getMappedFile();
+        }
+        for (auto off : offsets)
+        {
+            mMappedFile->adviseWillNeed(static_cast<size_t>(off), len);
+        }
+        return;
+    }
+
+    if (!FilePrefetcher::isSupported())
+    {
+        return;
+    }
+
+    if (!mPrefetcher)
+    {
+        mPrefetcher = std::make_unique<FilePrefetcher>(
+            mBucket->getFilename().string());
+    }
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    ranges.reserve(offsets.size());
+    for (auto off : offsets)
+    {
+        // Offsets are sorted, so several keys on one page coalesce into a
+        // single range
+        if (!ranges.empty() && ranges.back().first == static_cast<size_t>(off))
+        {
+            continue;
+        }
+        ranges.emplace_back(static_cast<size_t>(off), len);
+    }
+    mPrefetcher->prefetch(ranges);
+}
+
 // When searching for an entry, BucketList calls this function on every bucket.
 // Since the input is sorted, we do a binary search for the first key in keys.
 // If we find the entry, we remove the found key from keys so that later buckets
 // do not load shadowed entries. If we don't find the entry, we do not remove it
 // from keys so that it will be searched for again at a lower level.
+//
+// All offsets are resolved from the in-memory index first, and reads for
+// every candidate page are submitted to the kernel as one batch before any
+// entry is decoded. The reads below then mostly hit the page cache, instead
+// of paying one device round trip per key in sequence.
 void
 BucketSnapshot::loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
                          std::vector<LedgerEntry>& result) const
@@ -95,54 +236,78 @@ BucketSnapshot::loadKeys(std::set<LedgerKey, LedgerEntryIdCmp>& keys,
         return;
     }
 
-    auto currKeyIt = keys.begin();
-    auto const& index = mBucket->getIndex();
+    using KeyIter = std::set<LedgerKey, LedgerEntryIdCmp>::iterator;
+    std::vector<KeyIter> candidateKeys;
+    std::vector<std::streamoff> candidateOffsets;
+
+    // Holding the index keeps it resident for the whole scan, even if the
+    // index budget drops it concurrently
+    auto indexPtr = mBucket->getIndex();
+    auto const& index = *indexPtr;
     auto indexIter = index.begin();
-    while (currKeyIt != keys.end() && indexIter != index.end())
+    for (auto currKeyIt = keys.begin();
+         currKeyIt != keys.end() && indexIter != index.end(); ++currKeyIt)
     {
         auto [offOp, newIndexIter] = index.scan(indexIter, *currKeyIt);
         indexIter = newIndexIter;
         if (offOp)
         {
-            auto [entryOp, bloomMiss] = getEntryAtOffset(
-                *currKeyIt, *offOp, mBucket->getIndex().getPageSize());
-            if (entryOp)
-            {
-                if (entryOp->type() != DEADENTRY)
-                {
-                    result.push_back(entryOp->liveEntry());
-                }
+            candidateKeys.emplace_back(currKeyIt);
+            candidateOffsets.emplace_back(*offOp);
+        }
+    }
+
+    auto const pageSize = index.getPageSize();
+    if (candidateOffsets.size() > 1)
+    {
+        prefetchOffsets(candidateOffsets, pageSize);
+    }
 
-                currKeyIt = keys.erase(currKeyIt);
-                continue;
+    for (size_t i = 0; i < candidateKeys.size(); ++i)
+    {
+        auto currKeyIt = candidateKeys[i];
+        auto [entryOp, bloomMiss] =
+            getEntryAtOffset(*currKeyIt, candidateOffsets[i], pageSize);
+        if (entryOp)
+        {
+            if (entryOp->type() != DEADENTRY)
+            {
+                result.push_back(entryOp->liveEntry());
             }
-        }
 
-        ++currKeyIt;
+            // Erasing from a std::set does not invalidate other iterators
+            keys.erase(currKeyIt);
+        }
     }
 }
 
-std::vector<PoolID> const&
+std::vector<PoolID>
 BucketSnapshot::getPoolIDsByAsset(Asset const& asset) const
 {
-    static std::vector<PoolID> const emptyVec = {};
     if (isEmpty())
     {
-        return emptyVec;
+        return {};
     }
 
-    return mBucket->getIndex().getPoolIDsByAsset(asset);
+    // Copy, since the index may be dropped by the index budget once released
+    return mBucket->getIndex()->getPoolIDsByAsset(asset);
+}
+
+bool
+BucketSnapshot::isScannableForEviction() const
+{
+    return !isEmpty() &&
+           protocolVersionStartsFrom(Bucket::getBucketVersion(mBucket),
+                                     SOROBAN_PROTOCOL_VERSION);
 }
 
 bool
-BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
-                                uint32_t ledgerSeq,
-                                std::list<EvictionResultEntry>& evictableKeys,
-                                SearchableBucketListSnapshot& bl) const
+BucketSnapshot::collectEvictionCandidates(
+    EvictionIterator& iter, uint32_t& bytesToScan,
+    std::list<EvictionResultEntry>& candidates) const
 {
     ZoneScoped;
-    if (isEmpty() || protocolVersionIsBefore(Bucket::getBucketVersion(mBucket),
-                                             SOROBAN_PROTOCOL_VERSION))
+    if (!isScannableForEviction())
     {
         // EOF, skip to next bucket
         return false;
@@ -154,40 +319,14 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
         return true;
     }
 
-    std::list<EvictionResultEntry> maybeEvictQueue;
-    LedgerKeySet keysToSearch;
-
-    auto processQueue = [&]() {
-        auto loadResult =
-            populateLoadedEntries(keysToSearch, bl.loadKeys(keysToSearch));
-        for (auto& e : maybeEvictQueue)
-        {
-            // If TTL entry has not yet been deleted
-            if (auto ttl = loadResult.find(getTTLKey(e.key))->second;
-                ttl != nullptr)
-            {
-                // If TTL of entry is expired
-                if (!isLive(*ttl, ledgerSeq))
-                {
-                    // If entry is expired but not yet deleted, add it to
-                    // evictable keys
-                    e.liveUntilLedger = ttl->data.ttl().liveUntilLedgerSeq;
-                    evictableKeys.emplace_back(e);
-                }
-            }
-        }
-    };
-
     // Open new stream for eviction scan to not interfere with BucketListDB load
     // streams
     XDRInputFileStream stream{};
-    stream.open(mBucket->getFilename());
-    stream.seek(iter.bucketFileOffset);
+    mBucket->openForEvictionScan(stream, iter.bucketFileOffset, bytesToScan);
     BucketEntry be;
 
-    // First, scan the bucket region and record all temp entry keys in
-    // maybeEvictQueue. After scanning, we will load all the TTL keys for these
-    // entries in a single bulk load to determine
+    // Record all temp entry keys in the scan region. The caller then loads
+    // all the TTL keys for these entries in a single bulk load to determine
     //   1. If the entry is expired
     //   2. If the entry has already been deleted/evicted
     while (stream.readOne(be))
@@ -201,11 +340,9 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
             auto const& le = be.liveEntry();
             if (isTemporaryEntry(le.data))
             {
-                keysToSearch.emplace(getTTLKey(le));
-
                 // Set lifetime to 0 as default, will be updated after TTL keys
                 // loaded
-                maybeEvictQueue.emplace_back(
+                candidates.emplace_back(
                     EvictionResultEntry(LedgerEntryKey(le), iter, 0));
             }
         }
@@ -214,7 +351,6 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
         {
             // Reached end of scan region
             bytesToScan = 0;
-            processQueue();
             return true;
         }
 
@@ -222,7 +358,6 @@ BucketSnapshot::scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
     }
 
     // Hit eof
-    processQueue();
     return false;
 }
 
@@ -15,8 +15,9 @@ namespace stellar
 {
 
 class Bucket;
+class FilePrefetcher;
+class MmapFile;
 class XDRInputFileStream;
-class SearchableBucketListSnapshot;
 struct EvictionResultEntry;
 
 // A lightweight wrapper around Bucket for thread safe BucketListDB lookups
@@ -24,9 +25,23 @@ class BucketSnapshot : public NonMovable
 {
     std::shared_ptr<Bucket const> const mBucket;
 
+    // If true, point lookups decode entries directly from a memory mapping of
+    // the bucket file instead of reading through mStream.
+    bool const mUseMmap;
+
     // Lazily-constructed and retained for read path.
     mutable std::unique_ptr<XDRInputFileStream> mStream{};
 
+    // Lazily-retrieved from mBucket and retained for mmap read path.
+    mutable std::shared_ptr<MmapFile const> mMappedFile{};
+
+    // Lazily-constructed and retained for batched bulk loads on the stream
+    // read path.
+    mutable std::unique_ptr<FilePrefetcher> mPrefetcher{};
+
+    // Bytes prefetched per key for individually indexed buckets
+    static constexpr size_t INDIVIDUAL_ENTRY_PREFETCH_BYTES = 4096;
+
     // Returns (lazily-constructed) file stream for bucket file. Note
     // this might be in some random position left over from a previous read --
     // must be seek()'ed before use.
@@ -40,13 +55,25 @@ class BucketSnapshot : public NonMovable
     getEntryAtOffset(LedgerKey const& k, std::streamoff pos,
                      size_t pageSize) const;
 
-    BucketSnapshot(std::shared_ptr<Bucket const> const b);
+    // Same as readOne/readPage on getStream(), but decodes out of mapped
+    // memory. Returns true and sets `out` if the entry was found.
+    bool readFromMappedFile(BucketEntry& out, LedgerKey const& k,
+                            std::streamoff pos, size_t pageSize) const;
+
+    // Asks the kernel to start reading the pages at all given (sorted) file
+    // offsets at once
+    void prefetchOffsets(std::vector<std::streamoff> const& offsets,
+                         size_t pageSize) const;
+
+    BucketSnapshot(std::shared_ptr<Bucket const> const b, bool useMmap);
 
     // Only allow copy constructor, is threadsafe
     BucketSnapshot(BucketSnapshot const& b);
     BucketSnapshot& operator=(BucketSnapshot const&) = delete;
 
   public:
+    ~BucketSnapshot();
+
     bool isEmpty() const;
     std::shared_ptr<Bucket const> getRawBucket() const;
 
@@ -62,12 +89,21 @@ class BucketSnapshot : public NonMovable
 
     // Return all PoolIDs that contain the given asset on either side of the
     // pool
-    std::vector<PoolID> const& getPoolIDsByAsset(Asset const& asset) const;
-
-    bool scanForEviction(EvictionIterator& iter, uint32_t& bytesToScan,
-                         uint32_t ledgerSeq,
-                         std::list<EvictionResultEntry>& evictableKeys,
-                         SearchableBucketListSnapshot& bl) const;
+    std::vector<PoolID> getPoolIDsByAsset(Asset const& asset) const;
+
+    // Returns false if eviction scans skip this bucket: it is empty or
+    // predates Soroban.
+    bool isScannableForEviction() const;
+
+    // Reads the eviction scan region starting at iter and appends every
+    // temporary entry in it to candidates, in bucket order. TTLs are not
+    // loaded, so candidates may still be live. Returns false if eof was
+    // reached, true otherwise; iter and bytesToScan are advanced past the
+    // bytes scanned. Only reads the bucket file through its own stream, so
+    // scans of different buckets may run concurrently.
+    bool
+    collectEvictionCandidates(EvictionIterator& iter, uint32_t& bytesToScan,
+                              std::list<EvictionResultEntry>& candidates) const;
 
     friend struct BucketLevelSnapshot;
 };
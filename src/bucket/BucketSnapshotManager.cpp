@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "bucket/BucketSnapshotManager.h"
+#include "bucket/BucketListEntryCache.h"
 #include "bucket/BucketListSnapshot.h"
 #include "main/Application.h"
 #include "util/XDRStream.h" // IWYU pragma: keep
@@ -17,14 +18,32 @@ BucketSnapshotManager::BucketSnapshotManager(
     Application& app, std::unique_ptr<BucketListSnapshot const>&& snapshot)
     : mApp(app)
     , mCurrentSnapshot(std::move(snapshot))
+    , mCurrentLedgerSeq(mCurrentSnapshot->getLedgerSeq())
     , mBulkLoadMeter(app.getMetrics().NewMeter(
           {"bucketlistDB", "query", "loads"}, "query"))
     , mBloomMisses(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "misses"}, "bloom"))
     , mBloomLookups(app.getMetrics().NewMeter(
           {"bucketlistDB", "bloom", "lookups"}, "bloom"))
+    , mEntryCacheHits(app.getMetrics().NewMeter(
+          {"bucketlistDB", "cache", "hits"}, "entry"))
+    , mEntryCacheMisses(app.getMetrics().NewMeter(
+          {"bucketlistDB", "cache", "misses"}, "entry"))
 {
     releaseAssert(threadIsMain());
+
+    // Convert cfg param from MB to bytes
+    if (auto cacheSize = app.getConfig().BUCKETLIST_DB_ENTRY_CACHE_SIZE;
+        cacheSize != 0)
+    {
+        mEntryCache =
+            std::make_unique<BucketListEntryCache>(cacheSize * 1000000);
+        mEntryCache->invalidate(mCurrentSnapshot->getLedgerSeq());
+    }
+}
+
+BucketSnapshotManager::~BucketSnapshotManager()
+{
 }
 
 std::shared_ptr<SearchableBucketListSnapshot>
@@ -63,14 +82,21 @@ void
 BucketSnapshotManager::maybeUpdateSnapshot(
     std::unique_ptr<BucketListSnapshot const>& snapshot) const
 {
-    std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
-    if (!snapshot ||
-        snapshot->getLedgerSeq() != mCurrentSnapshot->getLedgerSeq())
+    // Fast path, taken by every query between ledger closes
+    if (snapshot && snapshot->getLedgerSeq() ==
+                        mCurrentLedgerSeq.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    auto current =
+        std::atomic_load_explicit(&mCurrentSnapshot, std::memory_order_acquire);
+    if (!snapshot || snapshot->getLedgerSeq() != current->getLedgerSeq())
     {
         // Should only update with a newer snapshot
-        releaseAssert(!snapshot || snapshot->getLedgerSeq() <
-                                       mCurrentSnapshot->getLedgerSeq());
-        snapshot = std::make_unique<BucketListSnapshot>(*mCurrentSnapshot);
+        releaseAssert(!snapshot ||
+                      snapshot->getLedgerSeq() < current->getLedgerSeq());
+        snapshot = std::make_unique<BucketListSnapshot>(*current);
     }
 }
 
@@ -80,10 +106,41 @@ BucketSnapshotManager::updateCurrentSnapshot(
 {
     releaseAssert(newSnapshot);
     releaseAssert(threadIsMain());
-    std::lock_guard<std::recursive_mutex> lock(mSnapshotMutex);
-    releaseAssert(!mCurrentSnapshot || newSnapshot->getLedgerSeq() >=
-                                           mCurrentSnapshot->getLedgerSeq());
-    mCurrentSnapshot.swap(newSnapshot);
+
+    // Only the main thread publishes, so a plain read of the current ledger
+    // is safe here
+    auto const ledgerSeq = newSnapshot->getLedgerSeq();
+    releaseAssert(ledgerSeq >= mCurrentLedgerSeq.load());
+
+    // Cached results are tagged with the ledger they were read at, so
+    // invalidating before publishing never lets a reader of the new snapshot
+    // see results cached for the old one
+    if (mEntryCache)
+    {
+        mEntryCache->invalidate(ledgerSeq);
+    }
+
+    // The previous snapshot is freed by whichever thread drops it last
+    std::atomic_store_explicit(
+        &mCurrentSnapshot,
+        std::shared_ptr<BucketListSnapshot const>(std::move(newSnapshot)),
+        std::memory_order_release);
+    mCurrentLedgerSeq.store(ledgerSeq, std::memory_order_release);
+}
+
+void
+BucketSnapshotManager::recordEntryCacheMetrics(size_t hits,
+                                               size_t misses) const
+{
+    releaseAssert(threadIsMain());
+    if (hits != 0)
+    {
+        mEntryCacheHits.Mark(hits);
+    }
+    if (misses != 0)
+    {
+        mEntryCacheMisses.Mark(misses);
+    }
 }
 
 void
@@ -8,8 +8,8 @@
 #include "util/NonCopyable.h"
 #include "util/UnorderedMap.h"
 
+#include <atomic>
 #include <memory>
-#include <mutex>
 
 namespace medida
 {
@@ -23,6 +23,7 @@ namespace stellar
 
 class Application;
 class BucketList;
+class BucketListEntryCache;
 class BucketListSnapshot;
 
 // This class serves as the boundary between non-threadsafe singleton classes
@@ -35,11 +36,19 @@ class BucketSnapshotManager : NonMovableOrCopyable
 
     // Snapshot that is maintained and periodically updated by BucketManager on
     // the main thread. When background threads need to generate or refresh a
-    // snapshot, they will copy this snapshot.
-    std::unique_ptr<BucketListSnapshot const> mCurrentSnapshot{};
+    // snapshot, they will copy this snapshot. Published with std::atomic_store
+    // and only ever read with std::atomic_load, so readers never block the
+    // main thread. A published snapshot is immutable.
+    std::shared_ptr<BucketListSnapshot const> mCurrentSnapshot{};
 
-    // Lock must be held when accessing mCurrentSnapshot
-    mutable std::recursive_mutex mSnapshotMutex;
+    // Ledger of mCurrentSnapshot, stored after it is published. Lets readers
+    // whose snapshot is already current skip loading mCurrentSnapshot.
+    std::atomic<uint32_t> mCurrentLedgerSeq{0};
+
+    // Decoded lookup results for mCurrentSnapshot, shared by all
+    // SearchableBucketListSnapshots. Null if disabled by config. Invalidated
+    // whenever mCurrentSnapshot is updated.
+    std::unique_ptr<BucketListEntryCache> mEntryCache{};
 
     mutable UnorderedMap<LedgerEntryType, medida::Timer&> mPointTimers{};
     mutable UnorderedMap<std::string, medida::Timer&> mBulkTimers{};
@@ -47,6 +56,8 @@ class BucketSnapshotManager : NonMovableOrCopyable
     medida::Meter& mBulkLoadMeter;
     medida::Meter& mBloomMisses;
     medida::Meter& mBloomLookups;
+    medida::Meter& mEntryCacheHits;
+    medida::Meter& mEntryCacheMisses;
 
     mutable std::optional<VirtualClock::time_point> mTimerStart;
 
@@ -68,19 +79,29 @@ class BucketSnapshotManager : NonMovableOrCopyable
   public:
     BucketSnapshotManager(Application& app,
                           std::unique_ptr<BucketListSnapshot const>&& snapshot);
+    ~BucketSnapshotManager();
 
     std::shared_ptr<SearchableBucketListSnapshot>
     getSearchableBucketListSnapshot() const;
 
     // Checks if snapshot is out of date with mCurrentSnapshot and updates
-    // it accordingly
+    // it accordingly. Lock-free while snapshot is current. Threadsafe.
     void maybeUpdateSnapshot(
         std::unique_ptr<BucketListSnapshot const>& snapshot) const;
 
+    // Returns the shared entry cache, or nullptr if caching is disabled. Safe
+    // to call from any thread.
+    BucketListEntryCache*
+    getEntryCache() const
+    {
+        return mEntryCache.get();
+    }
+
     // All metric recording functions must only be called by the main thread
     void startPointLoadTimer() const;
     void endPointLoadTimer(LedgerEntryType t, bool bloomMiss) const;
     medida::Timer& recordBulkLoadMetrics(std::string const& label,
                                          size_t numEntries) const;
+    void recordEntryCacheMetrics(size_t hits, size_t misses) const;
 };
 }
\ No newline at end of file
@@ -18,8 +18,9 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MemoryAttribution.h"
 #include "util/Thread.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 #include "medida/metrics_registry.h"
@@ -34,7 +35,7 @@ FutureBucket::FutureBucket(Application& app,
                            std::shared_ptr<Bucket> const& snap,
                            std::vector<std::shared_ptr<Bucket>> const& shadows,
                            uint32_t maxProtocolVersion, bool countMergeEvents,
-                           uint32_t level)
+                           uint32_t level, uint32_t currLedger)
     : mState(FB_LIVE_INPUTS)
     , mInputCurrBucket(curr)
     , mInputSnapBucket(snap)
@@ -61,7 +62,8 @@ FutureBucket::FutureBucket(Application& app,
     {
         mInputShadowBucketHashes.push_back(binToHex(b->getHash()));
     }
-    startMerge(app, maxProtocolVersion, countMergeEvents, level);
+    startMerge(app, maxProtocolVersion, countMergeEvents, level,
+               BucketList::mergeDeadlineLedger(currLedger, level));
 }
 
 void
@@ -304,7 +306,8 @@ getAvailableTimeForMerge(Application& app, uint32_t level)
 
 void
 FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
-                         bool countMergeEvents, uint32_t level)
+                         bool countMergeEvents, uint32_t level,
+                         uint32_t deadlineLedger)
 {
     ZoneScoped;
     // NB: startMerge starts with FutureBucket in a half-valid state; the inputs
@@ -353,6 +356,7 @@ FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
     std::shared_ptr<task_t> task = std::make_shared<task_t>(
         [curr, snap, &bm, shadows, maxProtocolVersion, countMergeEvents, level,
          &timer, &ctx, doFsync, availableTime]() mutable {
+            MemoryAttributionScope memoryScope(MemorySubsystem::Bucket);
             auto timeScope = timer.TimeScope();
             CLOG_TRACE(Bucket, "Worker merging curr={} with snap={}",
                        hexAbbrev(curr->getHash()), hexAbbrev(snap->getHash()));
@@ -365,7 +369,7 @@ FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
                 auto res =
                     Bucket::merge(bm, maxProtocolVersion, curr, snap, shadows,
                                   BucketList::keepDeadEntries(level),
-                                  countMergeEvents, ctx, doFsync);
+                                  countMergeEvents, ctx, doFsync, level);
 
                 if (res)
                 {
@@ -396,14 +400,14 @@ FutureBucket::startMerge(Application& app, uint32_t maxProtocolVersion,
 
     mOutputBucketFuture = task->get_future().share();
     bm.putMergeFuture(mk, mOutputBucketFuture);
-    app.postOnBackgroundThread(bind(&task_t::operator(), task),
-                               "FutureBucket: merge");
+    app.postOnBucketMergeThread(bind(&task_t::operator(), task),
+                                "FutureBucket: merge", deadlineLedger);
     checkState();
 }
 
 void
 FutureBucket::makeLive(Application& app, uint32_t maxProtocolVersion,
-                       uint32_t level)
+                       uint32_t level, uint32_t currLedger)
 {
     ZoneScoped;
     checkState();
@@ -431,7 +435,8 @@ FutureBucket::makeLive(Application& app, uint32_t maxProtocolVersion,
             mInputShadowBuckets.push_back(b);
         }
         mState = FB_LIVE_INPUTS;
-        startMerge(app, maxProtocolVersion, /*countMergeEvents=*/true, level);
+        startMerge(app, maxProtocolVersion, /*countMergeEvents=*/true, level,
+                   BucketList::mergeDeadlineLedger(currLedger, level));
         releaseAssert(isLive());
     }
 }
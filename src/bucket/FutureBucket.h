@@ -75,7 +75,8 @@ class FutureBucket
     void checkHashesMatch() const;
     void checkState() const;
     void startMerge(Application& app, uint32_t maxProtocolVersion,
-                    bool countMergeEvents, uint32_t level);
+                    bool countMergeEvents, uint32_t level,
+                    uint32_t deadlineLedger);
 
     void clearInputs();
     void clearOutput();
@@ -86,7 +87,7 @@ class FutureBucket
                  std::shared_ptr<Bucket> const& snap,
                  std::vector<std::shared_ptr<Bucket>> const& shadows,
                  uint32_t maxProtocolVersion, bool countMergeEvents,
-                 uint32_t level);
+                 uint32_t level, uint32_t currLedger);
 
     FutureBucket() = default;
     FutureBucket(FutureBucket const& other) = default;
@@ -120,9 +121,11 @@ class FutureBucket
     // Precondition: isLive(); waits-for and resolves to merged bucket.
     std::shared_ptr<Bucket> resolve();
 
-    // Precondition: !isLive(); transitions from FB_HASH_FOO to FB_LIVE_FOO
+    // Precondition: !isLive(); transitions from FB_HASH_FOO to FB_LIVE_FOO.
+    // `currLedger` is the ledger the bucket list this future belongs to is at;
+    // it is only used to order the restarted merge against other merges.
     void makeLive(Application& app, uint32_t maxProtocolVersion,
-                  uint32_t level);
+                  uint32_t level, uint32_t currLedger);
 
     // Return all hashes referenced by this future.
     std::vector<std::string> getHashes() const;
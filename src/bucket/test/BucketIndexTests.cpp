@@ -5,19 +5,25 @@
 // This file contains tests for the BucketIndex and higher-level operations
 // concerning key-value lookup based on the BucketList.
 
+#include "bucket/BucketIndexBudget.h"
 #include "bucket/BucketIndexImpl.h"
+#include "bucket/BucketInputIterator.h"
 #include "bucket/BucketList.h"
+#include "bucket/BucketListEntryCache.h"
 #include "bucket/BucketListSnapshot.h"
 #include "bucket/BucketManager.h"
 #include "bucket/test/BucketTestUtils.h"
+#include "ledger/LedgerTxn.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "test/MicroBenchmark.h"
 #include "test/test.h"
 
 #include "lib/bloom_filter.hpp"
 
+#include "util/MmapFile.h"
 #include "util/XDRCereal.h"
 
 using namespace stellar;
@@ -90,6 +96,18 @@ class BucketIndexTest
         return mApp->getBucketManager();
     }
 
+    Application&
+    getApp() const
+    {
+        return *mApp;
+    }
+
+    LedgerKeySet const&
+    getKeysToSearch() const
+    {
+        return mKeysToSearch;
+    }
+
     virtual void
     buildGeneralTest()
     {
@@ -284,6 +302,38 @@ class BucketIndexTest
         }
     }
 
+    // Overwrites one sampled entry, then checks that lookups against the new
+    // BucketList return the updated value
+    void
+    updateEntryAndRun()
+    {
+        auto iter = mTestEntries.begin();
+        REQUIRE(iter != mTestEntries.end());
+        iter->second.lastModifiedLedgerSeq =
+            mApp->getLedgerManager().getLastClosedLedgerNum() + 1;
+        insertEntries({iter->second});
+        run();
+    }
+
+    // Prefetches the sampled keys through LedgerTxnRoot, which may split them
+    // across worker threads, then checks the entries served from its cache
+    void
+    runPrefetch()
+    {
+        auto& root = mApp->getLedgerTxnRoot();
+        UnorderedSet<LedgerKey> keys(mKeysToSearch.begin(),
+                                     mKeysToSearch.end());
+        REQUIRE(root.prefetch(keys) == keys.size());
+
+        LedgerTxn ltx(root);
+        for (auto const& key : mKeysToSearch)
+        {
+            auto entry = ltx.getNewestVersion(key);
+            REQUIRE(entry);
+            REQUIRE(entry->ledgerEntry() == mTestEntries.at(key));
+        }
+    }
+
     void
     restartWithConfig(Config const& cfg)
     {
@@ -491,6 +541,204 @@ TEST_CASE("key-value lookup", "[bucket][bucketindex]")
     testAllIndexTypes(f);
 }
 
+TEST_CASE("individual index finds every key by fingerprint",
+          "[bucket][bucketindex]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 0;
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    for (auto const& bucketHash : test.getBM().getBucketListReferencedBuckets())
+    {
+        if (isZero(bucketHash))
+        {
+            continue;
+        }
+
+        auto b = test.getBM().getBucketByHash(bucketHash);
+        auto const& index = b->getIndexForTesting();
+        REQUIRE(index.getPageSize() == 0);
+
+        bool hasOffers = false;
+        for (BucketInputIterator in(b); in; ++in)
+        {
+            auto k = getBucketLedgerKey(*in);
+            REQUIRE(index.lookup(k));
+            hasOffers = hasOffers || k.type() == OFFER;
+        }
+
+        // Range queries are answered from key type boundaries
+        REQUIRE(index.getOfferRange().has_value() == hasOffers);
+    }
+
+    test.run();
+}
+
+TEST_CASE("key-value lookup with mmap reads", "[bucket][bucketindex]")
+{
+    if (!MmapFile::isSupported())
+    {
+        return;
+    }
+
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_MMAP_READS = true;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with binary fuse filter", "[bucket][bucketindex]")
+{
+    auto fingerprintBits = GENERATE(8u, 16u);
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS = fingerprintBits;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+        test.run();
+        test.testInvalidKeys();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with entry cache", "[bucket][bucketindex]")
+{
+    auto f = [&](Config& cfg) {
+        cfg.BUCKETLIST_DB_ENTRY_CACHE_SIZE = 10;
+        auto test = BucketIndexTest(cfg);
+        test.buildMultiVersionTest();
+
+        // Second run is served from the cache
+        test.run();
+        test.run();
+        test.testInvalidKeys();
+        test.testInvalidKeys();
+
+        auto cache = test.getBM().getBucketSnapshotManager().getEntryCache();
+        REQUIRE(cache);
+        REQUIRE(cache->getCounters().mHits > 0);
+        REQUIRE(cache->size() > 0);
+
+        // Closing a ledger must invalidate cached entries
+        test.updateEntryAndRun();
+    };
+
+    testAllIndexTypes(f);
+}
+
+TEST_CASE("key-value lookup with parallel prefetch", "[bucket][bucketindex]")
+{
+    auto workers = GENERATE(0u, 3u);
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.PREFETCH_BATCH_SIZE = 5;
+    cfg.PREFETCH_WORKER_THREADS = workers;
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+    test.runPrefetch();
+}
+
+TEST_CASE("parallel index construction matches sequential",
+          "[bucket][bucketindex]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_PERSIST_INDEX = false;
+
+    // Small pages so that the larger test buckets are split into chunks
+    cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+    cfg.BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 8;
+    cfg.BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS = GENERATE(0u, 8u);
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    auto& bm = test.getBM();
+    size_t numSplit = 0;
+    for (auto const& bucketHash : bm.getBucketListReferencedBuckets())
+    {
+        if (isZero(bucketHash))
+        {
+            continue;
+        }
+
+        auto b = bm.getBucketByHash(bucketHash);
+        auto sequential = BucketIndex::createIndexForTesting(
+            bm, b->getFilename(), b->getHash(), 1);
+        auto parallel = BucketIndex::createIndexForTesting(
+            bm, b->getFilename(), b->getHash(), 4);
+        REQUIRE(sequential);
+        REQUIRE(parallel);
+        REQUIRE((*sequential == *parallel));
+
+        // Pages are 256 bytes, so buckets above 512 KB are split
+        if (b->getSize() >= 2 * 1024 * 256)
+        {
+            ++numSplit;
+        }
+    }
+    REQUIRE(numSplit > 0);
+}
+
+TEST_CASE("key-value lookup with index memory budget",
+          "[bucket][bucketindex]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_PERSIST_INDEX = true;
+
+    // Range indexes are always persisted, so every bucket can be tracked
+    cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    // Budget is far below a single index, so every lookup must reload
+    auto& bm = test.getBM();
+    auto budget =
+        std::make_shared<BucketIndexBudget>(bm, test.getApp().getMetrics(), 1);
+    std::vector<std::shared_ptr<Bucket>> tracked;
+    for (auto const& bucketHash : bm.getBucketListReferencedBuckets())
+    {
+        if (isZero(bucketHash))
+        {
+            continue;
+        }
+
+        auto b = bm.getBucketByHash(bucketHash);
+        REQUIRE(fs::exists(bm.bucketIndexFilename(bucketHash)));
+        budget->track(b);
+        tracked.emplace_back(b);
+    }
+    REQUIRE(!tracked.empty());
+
+    for (auto const& b : tracked)
+    {
+        REQUIRE(b->isIndexed());
+        REQUIRE(!b->isIndexResidentForTesting());
+    }
+    REQUIRE(budget->getResidentBytes() == 0);
+
+    auto& reloadTimer =
+        test.getApp().getMetrics().NewTimer({"bucketlistDB", "index", "reload"});
+    auto reloadsBefore = reloadTimer.count();
+
+    test.run();
+    test.testInvalidKeys();
+
+    REQUIRE(reloadTimer.count() > reloadsBefore);
+    REQUIRE(budget->getResidentBytes() == 0);
+}
+
 TEST_CASE("do not load outdated values", "[bucket][bucketindex]")
 {
     auto f = [&](Config& cfg) {
@@ -547,7 +795,6 @@ TEST_CASE("serialize bucket indexes", "[bucket][bucketindex][!hide]")
     cfg.DEPRECATED_SQL_LEDGER_STATE = false;
     cfg.BUCKETLIST_DB_PERSIST_INDEX = true;
 
-    // Node is not a validator, so indexes will persist
     cfg.NODE_IS_VALIDATOR = false;
     cfg.FORCE_SCP = false;
 
@@ -570,7 +817,8 @@ TEST_CASE("serialize bucket indexes", "[bucket][bucketindex][!hide]")
         REQUIRE(b->isIndexed());
 
         auto onDiskIndex =
-            BucketIndex::load(test.getBM(), indexFilename, b->getSize());
+            BucketIndex::load(test.getBM(), indexFilename, bucketHash,
+                              b->getSize());
         REQUIRE(onDiskIndex);
 
         auto& inMemoryIndex = b->getIndexForTesting();
@@ -602,8 +850,135 @@ TEST_CASE("serialize bucket indexes", "[bucket][bucketindex][!hide]")
         // Check if on-disk index rewritten with correct config params
         auto indexFilename = test.getBM().bucketIndexFilename(bucketHash);
         auto onDiskIndex =
-            BucketIndex::load(test.getBM(), indexFilename, b->getSize());
+            BucketIndex::load(test.getBM(), indexFilename, bucketHash,
+                              b->getSize());
         REQUIRE((inMemoryIndex == *onDiskIndex));
     }
+
+    // Switching filter type must also invalidate every persisted index
+    cfg.BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS = 8;
+    test.restartWithConfig(cfg);
+
+    for (auto const& bucketHash : buckets)
+    {
+        if (isZero(bucketHash))
+        {
+            continue;
+        }
+
+        auto b = test.getBM().getBucketByHash(bucketHash);
+        REQUIRE(b->isIndexed());
+
+        auto indexFilename = test.getBM().bucketIndexFilename(bucketHash);
+        auto onDiskIndex =
+            BucketIndex::load(test.getBM(), indexFilename, bucketHash,
+                              b->getSize());
+        REQUIRE(onDiskIndex);
+        REQUIRE((b->getIndexForTesting() == *onDiskIndex));
+    }
+}
+
+TEST_CASE("validate persisted bucket indexes on load",
+          "[bucket][bucketindex][!hide]")
+{
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.BUCKETLIST_DB_INDEX_CUTOFF = 0;
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.BUCKETLIST_DB_PERSIST_INDEX = true;
+
+    // Validators persist indexes too
+    cfg.NODE_IS_VALIDATOR = true;
+    cfg.FORCE_SCP = false;
+
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    std::vector<Hash> buckets;
+    for (auto const& bucketHash : test.getBM().getBucketListReferencedBuckets())
+    {
+        if (!isZero(bucketHash))
+        {
+            REQUIRE(fs::exists(test.getBM().bucketIndexFilename(bucketHash)));
+            buckets.emplace_back(bucketHash);
+        }
+    }
+    REQUIRE(buckets.size() >= 2);
+
+    auto first = test.getBM().getBucketByHash(buckets[0]);
+    auto second = test.getBM().getBucketByHash(buckets[1]);
+    auto firstIndexFilename = test.getBM().bucketIndexFilename(buckets[0]);
+    auto secondIndexFilename = test.getBM().bucketIndexFilename(buckets[1]);
+
+    // An index built for another bucket is rejected
+    std::filesystem::copy_file(
+        firstIndexFilename, secondIndexFilename,
+        std::filesystem::copy_options::overwrite_existing);
+    REQUIRE(!BucketIndex::load(test.getBM(), secondIndexFilename, buckets[1],
+                               second->getSize()));
+
+    // So is a truncated index
+    std::filesystem::resize_file(firstIndexFilename,
+                                 fs::size(firstIndexFilename) / 2);
+    REQUIRE(!BucketIndex::load(test.getBM(), firstIndexFilename, buckets[0],
+                               first->getSize()));
+
+    // Both are rebuilt and rewritten on restart
+    first.reset();
+    second.reset();
+    test.restartWithConfig(cfg);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        auto b = test.getBM().getBucketByHash(buckets[i]);
+        REQUIRE(b->isIndexed());
+
+        auto onDiskIndex = BucketIndex::load(
+            test.getBM(), test.getBM().bucketIndexFilename(buckets[i]),
+            buckets[i], b->getSize());
+        REQUIRE(onDiskIndex);
+        REQUIRE((b->getIndexForTesting() == *onDiskIndex));
+    }
+}
+
+TEST_CASE("BucketListDB microbench",
+          "[bucket][bucketindex][microbench][bench][!hide]")
+{
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto test = BucketIndexTest(cfg);
+    test.buildGeneralTest();
+
+    auto searchableBL = test.getBM()
+                            .getBucketSnapshotManager()
+                            .getSearchableBucketListSnapshot();
+    auto const& keySet = test.getKeysToSearch();
+    std::vector<LedgerKey> keys(keySet.begin(), keySet.end());
+    REQUIRE(keys.size() > 500);
+
+    size_t next = 0;
+    runMicroBenchmark("bucketlistdb.point-load", [&]() {
+        size_t const batch = 100;
+        for (size_t i = 0; i < batch; ++i)
+        {
+            if (!searchableBL->getLedgerEntry(keys[next++ % keys.size()]))
+            {
+                throw std::runtime_error("missing entry");
+            }
+        }
+        return batch;
+    });
+
+    std::vector<LedgerKeySet> batches;
+    for (size_t i = 0; i + 500 <= keys.size(); i += 500)
+    {
+        batches.emplace_back(keys.begin() + i, keys.begin() + i + 500);
+    }
+    runMicroBenchmark("bucketlistdb.bulk-load", [&]() {
+        auto const& batch = batches[next++ % batches.size()];
+        if (searchableBL->loadKeys(batch).size() != batch.size())
+        {
+            throw std::runtime_error("missing entries");
+        }
+        return batch.size();
+    });
 }
 }
\ No newline at end of file
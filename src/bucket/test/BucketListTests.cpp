@@ -31,8 +31,11 @@
 #include "util/Timer.h"
 #include "xdrpp/autocheck.h"
 
+#include <atomic>
 #include <deque>
+#include <future>
 #include <sstream>
+#include <thread>
 
 using namespace stellar;
 using namespace BucketTestUtils;
@@ -568,6 +571,28 @@ TEST_CASE("BucketList sizeOf and oldestLedgerIn relations",
     }
 }
 
+TEST_CASE("BucketList merge deadlines match spill schedule",
+          "[bucket][bucketlist][count]")
+{
+    // A merge into level i prepared at a spill of level i-1 must be resolved
+    // exactly at the following spill of level i-1, and restarting it at any
+    // ledger in between must yield the same deadline.
+    for (uint32_t level = 1; level < BucketList::kNumLevels - 3; ++level)
+    {
+        uint32_t half = BucketList::levelHalf(level - 1);
+        for (uint32_t start = half; start < 8 * half; start += half)
+        {
+            REQUIRE(BucketList::levelShouldSpill(start, level - 1));
+            uint32_t deadline = BucketList::mergeDeadlineLedger(start, level);
+            REQUIRE(deadline == start + half);
+            REQUIRE(BucketList::levelShouldSpill(deadline, level - 1));
+            REQUIRE(BucketList::mergeDeadlineLedger(deadline - 1, level) ==
+                    deadline);
+        }
+    }
+    REQUIRE(BucketList::mergeDeadlineLedger(17, 0) == 17);
+}
+
 TEST_CASE("BucketList snap reaches steady state", "[bucket][bucketlist][count]")
 {
     // Deliberately exclude deepest level since snap on the deepest level
@@ -1267,6 +1292,70 @@ TEST_CASE_VERSIONS("Searchable BucketListDB snapshots", "[bucketlist]")
     }
 }
 
+TEST_CASE("BucketListDB snapshots refresh on background thread",
+          "[bucketlist]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0, Config::TESTDB_IN_MEMORY_SQLITE));
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+
+    auto app = createTestApplication<BucketTestApplication>(clock, cfg);
+    LedgerManagerForBucketTests& lm = app->getLedgerManager();
+    auto& bm = app->getBucketManager();
+
+    auto entry =
+        LedgerTestUtils::generateValidLedgerEntryOfType(CLAIMABLE_BALANCE);
+    entry.data.claimableBalance().amount = 1;
+    entry.lastModifiedLedgerSeq = 1;
+    lm.setNextLedgerEntryBatchForBucketTesting({}, {entry}, {});
+    closeLedger(*app);
+
+    auto const key = LedgerEntryKey(entry);
+    auto searchableBL =
+        bm.getBucketSnapshotManager().getSearchableBucketListSnapshot();
+
+    // Reader on another thread must only ever observe the entry moving
+    // forward while the main thread publishes new snapshots. Catch assertions
+    // are not threadsafe, so failures are checked on the main thread.
+    std::atomic<bool> done{false};
+    std::atomic<bool> ok{true};
+    std::atomic<int64_t> lastSeen{0};
+    auto reader = std::async(std::launch::async, [&]() {
+        int64_t prev = 0;
+        while (!done)
+        {
+            auto loaded = searchableBL->getLedgerEntry(key);
+            if (!loaded || loaded->data.claimableBalance().amount < prev)
+            {
+                ok = false;
+                return;
+            }
+            prev = loaded->data.claimableBalance().amount;
+            lastSeen = prev;
+        }
+    });
+
+    for (auto ledgerSeq = 2; ledgerSeq < 50; ++ledgerSeq)
+    {
+        ++entry.data.claimableBalance().amount;
+        entry.lastModifiedLedgerSeq = ledgerSeq;
+        lm.setNextLedgerEntryBatchForBucketTesting({}, {entry}, {});
+        closeLedger(*app);
+    }
+
+    // Wait for the reader to catch up to the final snapshot
+    auto const finalAmount = entry.data.claimableBalance().amount;
+    while (lastSeen != finalAmount && reader.wait_for(std::chrono::seconds(
+                                          0)) != std::future_status::ready)
+    {
+        std::this_thread::yield();
+    }
+    done = true;
+    reader.get();
+    REQUIRE(ok);
+    REQUIRE(lastSeen == finalAmount);
+}
+
 static std::string
 formatX32(uint32_t v)
 {
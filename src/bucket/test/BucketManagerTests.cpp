@@ -308,7 +308,10 @@ TEST_CASE("bucketmanager missing buckets fail", "[bucket][bucketmanager]")
         {
             ++ledger;
             lm.setNextLedgerEntryBatchForBucketTesting(
-                {}, LedgerTestUtils::generateValidUniqueLedgerEntries(10), {});
+                {},
+                LedgerTestUtils::generateValidLedgerEntriesWithExclusions(
+                    {CONFIG_SETTING}, 10),
+                {});
             closeLedger(*app);
         } while (!BucketList::levelShouldSpill(ledger, level - 1));
         auto someBucket = bl.getLevel(1).getCurr();
@@ -377,7 +380,7 @@ TEST_CASE_VERSIONS("bucketmanager reattach to finished merge",
 
         // Reattach to _finished_ merge future on level.
         has2.currentBuckets[level].next.makeLive(
-            *app, vers, BucketList::keepDeadEntries(level));
+            *app, vers, BucketList::keepDeadEntries(level), ledger);
         REQUIRE(has2.currentBuckets[level].next.isMerging());
 
         // Resolve reattached future.
@@ -389,6 +392,120 @@ TEST_CASE_VERSIONS("bucketmanager reattach to finished merge",
     });
 }
 
+TEST_CASE("bucketmanager reattach to merge finished before restart",
+          "[bucket][bucketmanager][bucketpersist]")
+{
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.ARTIFICIALLY_PESSIMIZE_MERGES_FOR_TESTING = true;
+    cfg.MANUAL_CLOSE = false;
+
+    {
+        VirtualClock clock;
+        auto app = createTestApplication<BucketTestApplication>(clock, cfg);
+        auto& lm = app->getLedgerManager();
+        auto& bm = app->getBucketManager();
+        auto& bl = bm.getBucketList();
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            lm.setNextLedgerEntryBatchForBucketTesting(
+                {},
+                LedgerTestUtils::generateValidLedgerEntriesWithExclusions(
+                    {CONFIG_SETTING}, 10),
+                {});
+            closeLedger(*app);
+        }
+
+        // Merges are not resolved eagerly, so the persisted state restarts
+        // them from their inputs
+        REQUIRE(!lm.getLastClosedLedgerHAS().futuresAllResolved());
+
+        // Let every merge finish in the background before shutting down
+        for (uint32_t i = 0; i < BucketList::kNumLevels; ++i)
+        {
+            auto& next = bl.getLevel(i).getNext();
+            while (next.isMerging() && !next.mergeComplete())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        bm.forgetUnreferencedBuckets();
+        REQUIRE(fs::exists(cfg.BUCKET_DIR_PATH + "/finished-merges.json"));
+    }
+
+    cfg.FORCE_SCP = false;
+    {
+        VirtualClock clock;
+        Application::pointer app = Application::create(clock, cfg, false);
+        app->start();
+
+        // Restarted merges found their outputs on disk instead of rerunning
+        REQUIRE(app->getBucketManager()
+                    .readMergeCounters()
+                    .mFinishedMergeReattachments > 0);
+    }
+}
+
+TEST_CASE("bucketmanager places deep levels in deep bucket dir",
+          "[bucket][bucketmanager]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+    cfg.DEEP_BUCKET_DIR_PATH = cfg.BUCKET_DIR_PATH + "-deep";
+    cfg.DEEP_BUCKET_DIR_FIRST_LEVEL = 2;
+
+    Hash blHash;
+    {
+        auto app = createTestApplication<BucketTestApplication>(clock, cfg);
+        auto& lm = app->getLedgerManager();
+        auto& bm = app->getBucketManager();
+        auto& bl = bm.getBucketList();
+
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            lm.setNextLedgerEntryBatchForBucketTesting(
+                {},
+                LedgerTestUtils::generateValidLedgerEntriesWithExclusions(
+                    {CONFIG_SETTING}, 10),
+                {});
+            closeLedger(*app);
+        }
+        bl.resolveAnyReadyFutures();
+
+        auto inDir = [](std::shared_ptr<Bucket> const& b,
+                        std::string const& dir) {
+            return std::filesystem::path(b->getFilename()).parent_path() ==
+                   std::filesystem::path(dir);
+        };
+        auto deepCurr = bl.getLevel(2).getCurr();
+        REQUIRE(!deepCurr->isEmpty());
+        REQUIRE(inDir(deepCurr, cfg.DEEP_BUCKET_DIR_PATH));
+        for (uint32_t i = 0; i < cfg.DEEP_BUCKET_DIR_FIRST_LEVEL; ++i)
+        {
+            auto curr = bl.getLevel(i).getCurr();
+            REQUIRE(!curr->isEmpty());
+            REQUIRE(inDir(curr, cfg.BUCKET_DIR_PATH));
+        }
+
+        // Unreferenced buckets are collected from both tiers
+        bm.forgetUnreferencedBuckets();
+        for (auto const& h : bm.getBucketHashesInBucketDirForTesting())
+        {
+            REQUIRE(bm.getBucketByHash(h));
+        }
+        blHash = bl.getHash();
+    }
+
+    // Buckets are found in whichever tier holds them after a restart
+    cfg.FORCE_SCP = false;
+    {
+        VirtualClock clock2;
+        Application::pointer app = Application::create(clock2, cfg, false);
+        app->start();
+        REQUIRE(app->getBucketManager().getBucketList().getHash() == blHash);
+    }
+}
+
 TEST_CASE_VERSIONS("bucketmanager reattach to running merge",
                    "[bucket][bucketmanager]")
 {
@@ -454,7 +571,8 @@ TEST_CASE_VERSIONS("bucketmanager reattach to running merge",
                 if (has2.currentBuckets[level].next.hasHashes())
                 {
                     has2.currentBuckets[level].next.makeLive(
-                        *app, vers, BucketList::keepDeadEntries(level));
+                        *app, vers, BucketList::keepDeadEntries(level),
+                        ledger);
                 }
             }
         }
@@ -1478,3 +1596,65 @@ TEST_CASE_VERSIONS("bucket persistence over app restart",
         }
     });
 }
+
+TEST_CASE("bucketmanager merges bucket list on several threads",
+          "[bucket][bucketmanager]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0, Config::TESTDB_IN_MEMORY_SQLITE));
+    auto app = createTestApplication(clock, cfg);
+
+    BucketManager& bm = app->getBucketManager();
+    BucketList& bl = bm.getBucketList();
+    auto vers = getAppLedgerVersion(app);
+
+    // Spread entries over a few levels, updating and deleting some of them
+    std::vector<LedgerEntry> previous;
+    uint32_t ledger = 1;
+    for (; ledger < 100; ++ledger)
+    {
+        auto live = LedgerTestUtils::generateValidLedgerEntriesWithExclusions(
+            {CONFIG_SETTING}, 10);
+        std::vector<LedgerKey> dead;
+        if (ledger % 3 == 0)
+        {
+            for (size_t i = 0; i < previous.size(); ++i)
+            {
+                if (i % 2 == 0)
+                {
+                    previous[i].lastModifiedLedgerSeq = ledger;
+                    live.emplace_back(previous[i]);
+                }
+                else
+                {
+                    dead.emplace_back(LedgerEntryKey(previous[i]));
+                }
+            }
+        }
+        previous = live;
+        bl.addBatch(*app, ledger, vers, {}, live, dead);
+    }
+    while (!bl.futuresAllResolved())
+    {
+        bl.resolveAnyReadyFutures();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    HistoryArchiveState has(ledger - 1, bl,
+                            app->getConfig().NETWORK_PASSPHRASE);
+
+    auto state = bm.loadCompleteLedgerState(has);
+    auto merged = bm.mergeBuckets(has, 1);
+    REQUIRE(bm.mergeBuckets(has, 4)->getHash() == merged->getHash());
+    REQUIRE(bm.mergeBuckets(has, 32)->getHash() == merged->getHash());
+
+    size_t count = 0;
+    for (BucketInputIterator in(merged); in; ++in)
+    {
+        REQUIRE((*in).type() == LIVEENTRY);
+        auto it = state.find(LedgerEntryKey((*in).liveEntry()));
+        REQUIRE(it != state.end());
+        REQUIRE(it->second == (*in).liveEntry());
+        ++count;
+    }
+    REQUIRE(count == state.size());
+}
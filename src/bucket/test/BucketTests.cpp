@@ -12,6 +12,8 @@
 // else.
 #include "util/asio.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketApplicator.h"
+#include "bucket/BucketIndex.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketManager.h"
 #include "bucket/BucketOutputIterator.h"
@@ -21,14 +23,19 @@
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "test/MicroBenchmark.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/Timer.h"
+#include "util/XDRStream.h"
 #include "xdrpp/autocheck.h"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace stellar;
 using namespace BucketTestUtils;
 
@@ -910,6 +917,59 @@ TEST_CASE_VERSIONS("merging bucket entries with initentry with shadows",
     });
 }
 
+TEST_CASE("bucket input iterator identity comparison", "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto vers = getAppLedgerVersion(app);
+
+    // Entries of every type, with the second bucket holding updates and
+    // deletions of some of the first bucket's keys so that equal identities
+    // are compared too
+    auto live = LedgerTestUtils::generateValidUniqueLedgerEntries(100);
+    std::vector<LedgerEntry> updated;
+    std::vector<LedgerKey> dead;
+    for (size_t i = 0; i < live.size(); i += 3)
+    {
+        updated.emplace_back(live[i]);
+        ++updated.back().lastModifiedLedgerSeq;
+        if (i + 1 < live.size())
+        {
+            dead.emplace_back(LedgerEntryKey(live[i + 1]));
+        }
+    }
+    auto added = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT, TRUSTLINE, OFFER, DATA, CLAIMABLE_BALANCE, LIQUIDITY_POOL,
+         CONTRACT_DATA, CONTRACT_CODE, TTL},
+        50);
+    updated.insert(updated.end(), added.begin(), added.end());
+
+    auto a = Bucket::fresh(bm, vers, {}, live, {}, /*countMergeEvents=*/true,
+                           clock.getIOContext(), /*doFsync=*/true);
+    auto b = Bucket::fresh(bm, vers, {}, updated, dead,
+                           /*countMergeEvents=*/true, clock.getIOContext(),
+                           /*doFsync=*/true);
+
+    BucketEntryIdCmp cmp;
+    size_t equal = 0;
+    for (BucketInputIterator ai(a); ai; ++ai)
+    {
+        for (BucketInputIterator bi(b); bi; ++bi)
+        {
+            int expected = cmp(*ai, *bi) ? -1 : (cmp(*bi, *ai) ? 1 : 0);
+            int actual = BucketInputIterator::compareIdentity(ai, bi);
+            REQUIRE((actual < 0) == (expected < 0));
+            REQUIRE((actual > 0) == (expected > 0));
+            int reversed = BucketInputIterator::compareIdentity(bi, ai);
+            REQUIRE((reversed < 0) == (actual > 0));
+            equal += actual == 0 ? 1 : 0;
+        }
+    }
+    REQUIRE(equal == (live.size() + 2) / 3 + dead.size());
+}
+
 TEST_CASE_VERSIONS("bucket apply", "[bucket]")
 {
     VirtualClock clock;
@@ -955,6 +1015,54 @@ TEST_CASE_VERSIONS("bucket apply", "[bucket]")
     });
 }
 
+TEST_CASE("bucket apply in multiple batches", "[bucket]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+
+    // Apply all entry types to SQL, not only offers
+    cfg.DEPRECATED_SQL_LEDGER_STATE = true;
+    Application::pointer app = createTestApplication(clock, cfg);
+
+    // Enough entries that the next batch is read while one is written
+    std::vector<LedgerEntry> live(2 * LEDGER_ENTRY_BATCH_COMMIT_SIZE + 100);
+    for (auto& e : live)
+    {
+        e.data.type(ACCOUNT);
+        auto& a = e.data.account();
+        a = LedgerTestUtils::generateValidAccountEntry(5);
+        a.balance = 1000000000;
+    }
+
+    std::shared_ptr<Bucket> b =
+        Bucket::fresh(app->getBucketManager(), getAppLedgerVersion(app), {},
+                      live, {}, /*countMergeEvents=*/true,
+                      clock.getIOContext(), /*doFsync=*/true);
+
+    std::unordered_set<LedgerKey> seenKeys;
+    BucketApplicator applicator(
+        *app, app->getConfig().LEDGER_PROTOCOL_VERSION, 0, 0, b,
+        [](LedgerEntryType t) { return t == ACCOUNT; }, seenKeys);
+    BucketApplicator::Counters counters(app->getClock().now());
+
+    size_t applied = 0;
+    size_t batches = 0;
+    size_t lastPos = applicator.pos();
+    while (applicator)
+    {
+        applied += applicator.advance(counters);
+        ++batches;
+        REQUIRE(applicator.pos() >= lastPos);
+        lastPos = applicator.pos();
+    }
+
+    REQUIRE(batches >= 3);
+    REQUIRE(applied == live.size());
+    REQUIRE(applicator.pos() <= applicator.size());
+    REQUIRE(app->getLedgerTxnRoot().countObjects(ACCOUNT) ==
+            live.size() + 1 /* root account */);
+}
+
 TEST_CASE("bucket apply bench", "[bucketbench][!hide]")
 {
     auto runtest = [](Config::TestDbMode mode) {
@@ -994,3 +1102,175 @@ TEST_CASE("bucket apply bench", "[bucketbench][!hide]")
     }
 #endif
 }
+
+// Measures merge throughput, index build time and point lookup latency on
+// synthetic buckets. Entry generation uses the test's random seed, so runs
+// with the same --rng-seed operate on identical buckets and their output can
+// be compared before and after a change to the merge loop or index format.
+TEST_CASE("bucket merge bench", "[bucketbench][!hide]")
+{
+    using clock_type = std::chrono::steady_clock;
+    auto secondsSince = [](clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start)
+            .count();
+    };
+
+    struct EntryMix
+    {
+        std::string name;
+        std::unordered_set<LedgerEntryType> types;
+    };
+    auto mix = GENERATE(
+        EntryMix{"accounts", {ACCOUNT}},
+        EntryMix{"classic", {ACCOUNT, TRUSTLINE, OFFER, DATA}},
+        EntryMix{"soroban", {CONTRACT_DATA, CONTRACT_CODE, TTL}});
+    size_t const oldSize = GENERATE(10000, 100000);
+
+    // The new bucket is a quarter the size of the old one, as between adjacent
+    // BucketList levels, with half of it updating or deleting old entries.
+    size_t const newSize = oldSize / 4;
+    size_t const numLookups = 10000;
+
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto vers = getAppLedgerVersion(app);
+
+    auto oldLive =
+        LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(mix.types,
+                                                                   oldSize);
+    std::vector<LedgerEntry> newLive;
+    std::vector<LedgerKey> newDead;
+    for (size_t i = 0; i < newSize / 2; ++i)
+    {
+        auto const& e = oldLive[i * 2];
+        if (i % 4 == 0)
+        {
+            newDead.emplace_back(LedgerEntryKey(e));
+        }
+        else
+        {
+            newLive.emplace_back(e);
+            ++newLive.back().lastModifiedLedgerSeq;
+        }
+    }
+    auto added = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        mix.types, newSize - newSize / 2);
+    newLive.insert(newLive.end(), added.begin(), added.end());
+
+    auto oldBucket = Bucket::fresh(bm, vers, {}, oldLive, {},
+                                   /*countMergeEvents=*/true,
+                                   clock.getIOContext(), /*doFsync=*/false);
+    auto newBucket = Bucket::fresh(bm, vers, {}, newLive, newDead,
+                                   /*countMergeEvents=*/true,
+                                   clock.getIOContext(), /*doFsync=*/false);
+
+    auto start = clock_type::now();
+    auto merged = Bucket::merge(bm, vers, oldBucket, newBucket,
+                                /*shadows=*/{}, /*keepDeadEntries=*/true,
+                                /*countMergeEvents=*/true, clock.getIOContext(),
+                                /*doFsync=*/false);
+    double mergeSecs = secondsSince(start);
+    double inputMB =
+        static_cast<double>(oldBucket->getSize() + newBucket->getSize()) /
+        1000000;
+
+    start = clock_type::now();
+    auto index = BucketIndex::createIndex(bm, merged->getFilename(),
+                                          merged->getHash());
+    double indexSecs = secondsSince(start);
+    REQUIRE(index);
+
+    // Time point loads of random live keys through the index, the way
+    // BucketSnapshot serves them
+    std::vector<LedgerKey> keys;
+    for (size_t i = 0; i < numLookups; ++i)
+    {
+        auto const& e = added[rand_uniform<size_t>(0, added.size() - 1)];
+        keys.emplace_back(LedgerEntryKey(e));
+    }
+    XDRInputFileStream in;
+    in.open(merged->getFilename().string());
+    auto pageSize = static_cast<size_t>(index->getPageSize());
+    std::vector<double> latenciesUs;
+    latenciesUs.reserve(keys.size());
+    for (auto const& k : keys)
+    {
+        auto lookupStart = clock_type::now();
+        auto pos = index->lookup(k);
+        BucketEntry be;
+        bool found = false;
+        if (pos)
+        {
+            in.seek(*pos);
+            found = pageSize == 0
+                        ? in.readOne(be) && getBucketLedgerKey(be) == k
+                        : in.readPage(be, k, pageSize);
+        }
+        latenciesUs.emplace_back(secondsSince(lookupStart) * 1000000);
+        REQUIRE(found);
+    }
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    auto percentile = [&](double p) {
+        auto i = static_cast<size_t>(p * (latenciesUs.size() - 1));
+        return latenciesUs.at(i);
+    };
+
+    CLOG_INFO(Bucket,
+              "bucket merge bench: mix={} oldEntries={} newEntries={} "
+              "inputMB={:.1f} outputMB={:.1f}",
+              mix.name, oldSize, newSize, inputMB,
+              static_cast<double>(merged->getSize()) / 1000000);
+    CLOG_INFO(Bucket,
+              "bucket merge bench: mix={} oldEntries={} merge={:.3f}s "
+              "({:.1f} MB/s) index={:.3f}s pageSize={} indexMB={:.2f}",
+              mix.name, oldSize, mergeSecs, inputMB / mergeSecs, indexSecs,
+              pageSize,
+              static_cast<double>(index->getMemoryUsage()) / 1000000);
+    CLOG_INFO(Bucket,
+              "bucket merge bench: mix={} oldEntries={} lookups={} "
+              "p50={:.1f}us p90={:.1f}us p99={:.1f}us max={:.1f}us",
+              mix.name, oldSize, latenciesUs.size(), percentile(0.5),
+              percentile(0.9), percentile(0.99), latenciesUs.back());
+}
+
+TEST_CASE("bucket merge microbench", "[bucket][microbench][bench][!hide]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& bm = app->getBucketManager();
+    auto vers = getAppLedgerVersion(app);
+
+    // A quarter of the new bucket updates old entries, as in "bucket merge
+    // bench"
+    size_t const oldSize = 10000;
+    size_t const newSize = oldSize / 4;
+    auto oldLive = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT}, oldSize);
+    auto newLive = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT}, newSize - newSize / 4);
+    for (size_t i = 0; i < newSize / 4; ++i)
+    {
+        newLive.emplace_back(oldLive[i * 4]);
+        ++newLive.back().lastModifiedLedgerSeq;
+    }
+
+    auto oldBucket = Bucket::fresh(bm, vers, {}, oldLive, {},
+                                   /*countMergeEvents=*/true,
+                                   clock.getIOContext(), /*doFsync=*/false);
+    auto newBucket = Bucket::fresh(bm, vers, {}, newLive, {},
+                                   /*countMergeEvents=*/true,
+                                   clock.getIOContext(), /*doFsync=*/false);
+
+    // Every merge produces the same bucket, which the BucketManager already
+    // has after the first one
+    runMicroBenchmark("bucket.merge", [&]() {
+        Bucket::merge(bm, vers, oldBucket, newBucket,
+                      /*shadows=*/{}, /*keepDeadEntries=*/true,
+                      /*countMergeEvents=*/true, clock.getIOContext(),
+                      /*doFsync=*/false);
+        return oldSize + newSize;
+    });
+}
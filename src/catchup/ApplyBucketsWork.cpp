@@ -19,7 +19,7 @@
 #include "main/Application.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -9,7 +9,7 @@
 #include "crypto/Hex.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -23,6 +23,8 @@ void
 ApplyBufferedLedgersWork::onReset()
 {
     mConditionalWork.reset();
+    mLedgersSinceDurable = 0;
+    mApp.getLedgerManager().setDeferDurability(false);
 }
 
 BasicWork::State
@@ -32,22 +34,41 @@ ApplyBufferedLedgersWork::onRun()
     if (mConditionalWork)
     {
         mConditionalWork->crankWork();
+        if (mConditionalWork->getState() == State::WORK_FAILURE)
+        {
+            mApp.getLedgerManager().setDeferDurability(false);
+        }
         if (mConditionalWork->getState() != State::WORK_SUCCESS)
         {
             return mConditionalWork->getState();
         }
     }
 
+    auto& cm = mApp.getCatchupManager();
     std::optional<LedgerCloseData> maybeLcd =
-        mApp.getCatchupManager().maybeGetNextBufferedLedgerToApply();
+        cm.maybeGetNextBufferedLedgerToApply();
 
     if (!maybeLcd)
     {
         CLOG_INFO(History, "No more buffered ledgers to apply");
+        mApp.getLedgerManager().setDeferDurability(false);
         return State::WORK_SUCCESS;
     }
     auto const& lcd = maybeLcd.value();
 
+    // The last ledger buffered is always made durable, as the node may stay
+    // there for a while
+    auto largest = cm.maybeGetLargestBufferedLedger();
+    bool const durable =
+        ++mLedgersSinceDurable >=
+            mApp.getConfig().BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL ||
+        !largest || largest->getLedgerSeq() <= lcd.getLedgerSeq();
+    if (durable)
+    {
+        mLedgersSinceDurable = 0;
+    }
+    mApp.getLedgerManager().setDeferDurability(!durable);
+
     CLOG_INFO(
         History,
         "Scheduling buffered ledger-close: [seq={}, prev={}, txs={}, "
@@ -106,6 +127,7 @@ ApplyBufferedLedgersWork::onAbort()
         mConditionalWork->crankWork();
         return false;
     }
+    mApp.getLedgerManager().setDeferDurability(false);
     return true;
 }
 }
@@ -14,6 +14,9 @@ namespace stellar
 class ApplyBufferedLedgersWork : public BasicWork
 {
     std::shared_ptr<ConditionalWork> mConditionalWork;
+    // Applied since the last one made durable, see
+    // BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL
+    uint32_t mLedgersSinceDurable{0};
 
   public:
     ApplyBufferedLedgersWork(Application& app);
@@ -6,6 +6,7 @@
 #include "bucket/BucketList.h"
 #include "bucket/BucketManager.h"
 #include "catchup/ApplyLedgerWork.h"
+#include "crypto/SHA.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryManager.h"
 #include "historywork/Progress.h"
@@ -17,7 +18,7 @@
 #include "util/FileSystemException.h"
 #include "util/GlobalChecks.h"
 #include "util/XDRCereal.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 #include <optional>
 
@@ -36,6 +37,7 @@ ApplyCheckpointWork::ApplyCheckpointWork(Application& app,
     , mLedgerRange(range)
     , mCheckpoint(
           app.getHistoryManager().checkpointContainingLedger(range.mFirst))
+    , mTrustedReplay(app.getConfig().CATCHUP_TRUSTED_REPLAY)
     , mOnFailure(cb)
 {
     // Ledger range check to enforce application of a single checkpoint
@@ -69,6 +71,7 @@ ApplyCheckpointWork::closeFiles()
 {
     mHdrIn.close();
     mTxIn.close();
+    mResIn.close();
     mFilesOpen = false;
 }
 
@@ -93,8 +96,17 @@ ApplyCheckpointWork::openInputFiles()
     CLOG_DEBUG(History, "Replaying transactions from {}", ti.localPath_nogz());
     mHdrIn.open(hi.localPath_nogz());
     mTxIn.open(ti.localPath_nogz());
+    if (mTrustedReplay)
+    {
+        FileTransferInfo ri(mDownloadDir, HISTORY_FILE_TYPE_RESULTS,
+                            mCheckpoint);
+        CLOG_DEBUG(History, "Trusting results from {}", ri.localPath_nogz());
+        mResIn.close();
+        mResIn.open(ri.localPath_nogz());
+    }
     mTxHistoryEntry = TransactionHistoryEntry();
     mHeaderHistoryEntry = LedgerHeaderHistoryEntry();
+    mTxResultEntry = TransactionHistoryResultEntry();
     mFilesOpen = true;
 }
 
@@ -140,6 +152,47 @@ ApplyCheckpointWork::getCurrentTxSet()
     return TxSetXDRFrame::makeEmpty(lm.getLastClosedLedgerHeader());
 }
 
+std::shared_ptr<UnorderedSet<Hash> const>
+ApplyCheckpointWork::getTxsWithTrustedSignatures(LedgerHeader const& header)
+{
+    ZoneScoped;
+    // Like transaction sets, the results of empty ledgers are left out
+    while (mTxResultEntry.ledgerSeq < header.ledgerSeq && mResIn &&
+           mResIn.readOne(mTxResultEntry))
+    {
+    }
+
+    auto txs = std::make_shared<UnorderedSet<Hash>>();
+    if (mTxResultEntry.ledgerSeq != header.ledgerSeq)
+    {
+        return txs;
+    }
+
+    // The header is part of the verified ledger chain, so results that hash
+    // to what it commits to are the ones the network agreed on
+    auto resultSetHash = xdrSha256(mTxResultEntry.txResultSet);
+    if (resultSetHash != header.txSetResultHash)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("replay results hash differs from results hash in "
+                       "replay ledger: hash for results for {:d} is {:s}, "
+                       "expected {:s}"),
+            header.ledgerSeq, hexAbbrev(resultSetHash),
+            hexAbbrev(header.txSetResultHash)));
+    }
+
+    // Any failed signature check would have made the transaction fail
+    for (auto const& res : mTxResultEntry.txResultSet.results)
+    {
+        auto code = res.result.result.code();
+        if (code == txSUCCESS || code == txFEE_BUMP_INNER_SUCCESS)
+        {
+            txs->emplace(res.transactionHash);
+        }
+    }
+    return txs;
+}
+
 std::shared_ptr<LedgerCloseData>
 ApplyCheckpointWork::getNextLedgerCloseData()
 {
@@ -246,9 +299,14 @@ ApplyCheckpointWork::getNextLedgerCloseData()
     }
 #endif
 
-    return std::make_shared<LedgerCloseData>(
+    auto lcd = std::make_shared<LedgerCloseData>(
         header.ledgerSeq, txset, header.scpValue,
         std::make_optional<Hash>(mHeaderHistoryEntry.hash));
+    if (mTrustedReplay)
+    {
+        lcd->setTxsWithTrustedSignatures(getTxsWithTrustedSignatures(header));
+    }
+    return lcd;
 }
 
 BasicWork::State
@@ -308,6 +366,9 @@ ApplyCheckpointWork::onRun()
         return State::WORK_RUNNING;
     }
 
+    // Get a head start on the ledger while waiting for the merges below
+    mApp.getLedgerManager().startPreparingLedger(*lcd);
+
     auto applyLedger = std::make_shared<ApplyLedgerWork>(mApp, *lcd);
 
     auto predicate = [](Application& app) {
@@ -34,6 +34,11 @@ struct LedgerHeaderHistoryEntry;
  * another check is made - if new local ledger matches corresponding ledger from
  * file.
  *
+ * With CATCHUP_TRUSTED_REPLAY, the results file of the checkpoint is read
+ * too, and the transactions it records as successful are applied without
+ * checking their signatures, once the results are checked against the
+ * txSetResultHash of the (verified) ledger header.
+ *
  * Constructor of this class takes some important parameters:
  * * downloadDir - directory containing ledger and transaction files
  * * range - LedgerRange to apply, must be checkpoint-aligned,
@@ -45,11 +50,14 @@ class ApplyCheckpointWork : public BasicWork
     TmpDir const& mDownloadDir;
     LedgerRange const mLedgerRange;
     uint32_t const mCheckpoint;
+    bool const mTrustedReplay;
 
     XDRInputFileStream mHdrIn;
     XDRInputFileStream mTxIn;
+    XDRInputFileStream mResIn;
     TransactionHistoryEntry mTxHistoryEntry;
     LedgerHeaderHistoryEntry mHeaderHistoryEntry;
+    TransactionHistoryResultEntry mTxResultEntry;
     OnFailureCallback mOnFailure;
 
     bool mFilesOpen{false};
@@ -57,6 +65,8 @@ class ApplyCheckpointWork : public BasicWork
     std::shared_ptr<ConditionalWork> mConditionalWork;
 
     TxSetXDRFrameConstPtr getCurrentTxSet();
+    std::shared_ptr<UnorderedSet<Hash> const>
+    getTxsWithTrustedSignatures(LedgerHeader const& header);
     void openInputFiles();
 
     std::shared_ptr<LedgerCloseData> getNextLedgerCloseData();
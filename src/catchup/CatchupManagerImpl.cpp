@@ -16,8 +16,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/StatusManager.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkScheduler.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
@@ -455,6 +455,15 @@ CatchupManagerImpl::tryApplySyncingLedgers()
             break;
         }
 
+        // Overlap the state-independent work for the next buffered ledger
+        // with closing this one
+        auto next = std::next(it);
+        if (next != mSyncingLedgers.cend() &&
+            next->second.getLedgerSeq() == lcd.getLedgerSeq() + 1)
+        {
+            mApp.getLedgerManager().startPreparingLedger(next->second);
+        }
+
         mApp.getLedgerManager().closeLedger(lcd);
         CLOG_INFO(History, "Closed buffered ledger: {}",
                   LedgerManager::ledgerAbbrev(ledgerHeader));
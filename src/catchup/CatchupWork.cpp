@@ -12,6 +12,7 @@
 #include "catchup/CatchupRange.h"
 #include "catchup/DownloadApplyTxsWork.h"
 #include "catchup/VerifyLedgerChainWork.h"
+#include "crypto/Hex.h"
 #include "herder/Herder.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryManager.h"
@@ -24,10 +25,14 @@
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "main/PersistentState.h"
+#include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/TmpDir.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -75,14 +80,26 @@ setHerderStateTo(FileTransferInfo const& ft, uint32_t ledger, Application& app)
     return true;
 }
 
+static std::unique_ptr<TmpDir>
+makeDownloadDir(Application& app, std::string const& name)
+{
+    auto const& cfg = app.getConfig();
+    if (cfg.CATCHUP_RESUMABLE)
+    {
+        // The same for every catchup, and only emptied once one is over
+        return std::make_unique<TmpDir>(cfg.BUCKET_DIR_PATH + "/catchup",
+                                        /* keep */ true);
+    }
+    return std::make_unique<TmpDir>(app.getTmpDirManager().tmpDir(name));
+}
+
 CatchupWork::CatchupWork(Application& app,
                          CatchupConfiguration catchupConfiguration,
                          std::set<std::shared_ptr<Bucket>> bucketsToRetain,
                          std::shared_ptr<HistoryArchive> archive)
     : Work(app, "catchup", BasicWork::RETRY_NEVER)
     , mLocalState{app.getLedgerManager().getLastClosedLedgerHAS()}
-    , mDownloadDir{std::make_unique<TmpDir>(
-          mApp.getTmpDirManager().tmpDir(getName()))}
+    , mDownloadDir{makeDownloadDir(mApp, getName())}
     , mCatchupConfiguration{catchupConfiguration}
     , mArchive{archive}
     , mRetainedBuckets{bucketsToRetain}
@@ -147,11 +164,29 @@ CatchupWork::doReset()
     mVerifyLedgers.reset();
     mLastApplied = mApp.getLedgerManager().getLastClosedLedgerHeader();
     mCurrentWork.reset();
+    mPhaseTimer.reset();
     mHAS.reset();
     mBucketHAS.reset();
     mRetainedBuckets.clear();
 }
 
+std::shared_ptr<BasicWork>
+CatchupWork::startPhase(std::string const& phase)
+{
+    auto cb = [this, phase](Application& app) {
+        // Records the time of the previous phase
+        mPhaseTimer.reset();
+        if (!phase.empty())
+        {
+            mPhaseTimer.emplace(
+                app.getMetrics().NewTimer({"catchup", "phase", phase}));
+        }
+        return true;
+    };
+    return std::make_shared<WorkWithCallback>(
+        mApp, "start-phase-" + (phase.empty() ? "none" : phase), cb);
+}
+
 void
 CatchupWork::downloadVerifyLedgerChain(CatchupRange const& catchupRange,
                                        LedgerNumHashPair rangeEnd)
@@ -181,7 +216,9 @@ CatchupWork::downloadVerifyLedgerChain(CatchupRange const& catchupRange,
 
     // Never retry the sequence: downloads already have retries, and there's no
     // point retrying verification
-    std::vector<std::shared_ptr<BasicWork>> seq{getLedgers, mVerifyLedgers};
+    std::vector<std::shared_ptr<BasicWork>> seq{
+        startPhase("download-ledgers"), getLedgers,
+        startPhase("verify-ledgers"), mVerifyLedgers, startPhase("")};
     mDownloadVerifyLedgersSeq = addWork<WorkSequence>(
         "download-verify-ledgers-seq", seq, BasicWork::RETRY_NEVER);
     mCurrentWork = mDownloadVerifyLedgersSeq;
@@ -225,10 +262,29 @@ CatchupWork::downloadApplyBuckets()
     // Download buckets, or skip if catchup is local
     if (!mCatchupConfiguration.localBucketsOnly())
     {
-        std::vector<std::string> hashes =
-            mBucketHAS->differingBuckets(mLocalState);
+        // Buckets already in the bucket dir, like those kept by an
+        // interrupted resumable catchup, don't need to be downloaded again
+        auto& bm = mApp.getBucketManager();
+        std::vector<std::string> hashes;
+        for (auto const& hash : mBucketHAS->differingBuckets(mLocalState))
+        {
+            auto b = bm.getBucketByHash(hexToBin256(hash));
+            if (b)
+            {
+                mBuckets[hash] = b;
+            }
+            else
+            {
+                hashes.emplace_back(hash);
+            }
+        }
+        if (mApp.getConfig().CATCHUP_RESUMABLE)
+        {
+            bm.setCatchupBucketState(mBucketHAS);
+        }
         auto getBuckets = std::make_shared<DownloadBucketsWork>(
             mApp, mBuckets, hashes, *mDownloadDir, mArchive);
+        seq.push_back(startPhase("download-buckets"));
         seq.push_back(getBuckets);
 
         auto verifyHASCallback = [has = *mBucketHAS](Application& app) {
@@ -241,6 +297,7 @@ CatchupWork::downloadApplyBuckets()
         };
         auto verifyHAS = std::make_shared<WorkWithCallback>(mApp, "verify-has",
                                                             verifyHASCallback);
+        seq.push_back(startPhase("verify-buckets"));
         seq.push_back(verifyHAS);
         version = mVerifiedLedgerRangeStart.header.ledgerVersion;
     }
@@ -259,7 +316,9 @@ CatchupWork::downloadApplyBuckets()
         applyBuckets = std::make_shared<ApplyBucketsWork>(mApp, mBuckets,
                                                           *mBucketHAS, version);
     }
+    seq.push_back(startPhase("apply-buckets"));
     seq.push_back(applyBuckets);
+    seq.push_back(startPhase(""));
     return std::make_shared<WorkSequence>(mApp, "download-verify-apply-buckets",
                                           seq, RETRY_NEVER);
 }
@@ -535,6 +594,13 @@ CatchupWork::runCatchupStep()
                 {
                     ps.clearRebuildForType(static_cast<LedgerEntryType>(let));
                 }
+
+                // The LCL references the buckets now
+                if (mApp.getConfig().CATCHUP_RESUMABLE)
+                {
+                    mApp.getBucketManager().setCatchupBucketState(
+                        std::nullopt);
+                }
             }
         }
         else if (mTransactionsVerifyApplySeq)
@@ -612,7 +678,9 @@ CatchupWork::runCatchupStep()
                 CatchupConfiguration::Mode::OFFLINE_COMPLETE)
             {
                 downloadVerifyTxResults(catchupRange);
+                seq.push_back(startPhase("verify-tx-results"));
                 seq.push_back(mVerifyTxResults);
+                seq.push_back(startPhase(""));
             }
 
             if (catchupRange.applyBuckets())
@@ -626,7 +694,9 @@ CatchupWork::runCatchupStep()
             {
                 // Step 4.3: Download and apply ledger chain
                 downloadApplyTransactions(catchupRange);
+                seq.push_back(startPhase("apply-txs"));
                 seq.push_back(mTransactionsVerifyApplySeq);
+                seq.push_back(startPhase(""));
             }
 
             mCatchupSeq =
@@ -668,10 +738,33 @@ CatchupWork::doWork()
     return nextState;
 }
 
+void
+CatchupWork::dropResumableProgress()
+{
+    if (!mApp.getConfig().CATCHUP_RESUMABLE)
+    {
+        return;
+    }
+
+    // Only an interrupted catchup is resumed: after a failure, what was
+    // downloaded may be the reason for it
+    mApp.getBucketManager().setCatchupBucketState(std::nullopt);
+    try
+    {
+        fs::deltree(mDownloadDir->getName());
+    }
+    catch (std::runtime_error& e)
+    {
+        CLOG_ERROR(History, "Failed to delete {}: {}",
+                   mDownloadDir->getName(), e.what());
+    }
+}
+
 void
 CatchupWork::onFailureRaise()
 {
     CLOG_WARNING(History, "Catchup failed");
+    dropResumableProgress();
     Work::onFailureRaise();
     if (mCatchupConfiguration.localBucketsOnly())
     {
@@ -683,6 +776,7 @@ void
 CatchupWork::onSuccess()
 {
     CLOG_INFO(History, "Catchup finished");
+    dropResumableProgress();
     Work::onSuccess();
 }
 }
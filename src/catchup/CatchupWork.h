@@ -12,6 +12,8 @@
 #include "work/Work.h"
 #include "work/WorkSequence.h"
 
+#include "medida/timer_context.h"
+
 namespace stellar
 {
 
@@ -41,6 +43,16 @@ using WorkSeqPtr = std::shared_ptr<WorkSequence>;
 //
 // After that, catchup is done and node can replay buffered ledgers and take
 // part in consensus protocol.
+//
+// With CATCHUP_RESUMABLE, the files are downloaded to a directory that outlives
+// the process, and the buckets downloaded are kept in the bucket dir, until
+// the catchup succeeds or fails. A catchup after a restart then reuses them,
+// and as always replays from the LCL, which is stored after each ledger.
+//
+// The time spent in each phase (download-ledgers, verify-ledgers,
+// download-buckets, apply-buckets, apply-txs...) goes to the timers
+// "catchup.phase.<phase>", switched by marker works placed between the works
+// of the sequences.
 
 class CatchupWork : public Work
 {
@@ -112,7 +124,14 @@ class CatchupWork : public Work
 
     std::shared_future<bool> mFatalFailureFuture;
 
+    std::optional<medida::TimerContext> mPhaseTimer;
+
+    // A work that stops timing the current phase and starts timing `phase`,
+    // or nothing if empty
+    std::shared_ptr<BasicWork> startPhase(std::string const& phase);
+
     bool alreadyHaveBucketsHistoryArchiveState(uint32_t atCheckpoint) const;
+    void dropResumableProgress();
     void assertBucketState();
 
     void downloadVerifyLedgerChain(CatchupRange const& catchupRange,
@@ -10,16 +10,28 @@
 #include "history/HistoryManager.h"
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "ledger/LedgerManager.h"
+#include "util/ZoneProfiler.h"
 #include "work/ConditionalWork.h"
 #include "work/WorkSequence.h"
 #include "work/WorkWithCallback.h"
 
-#include <Tracy.hpp>
+#include <algorithm>
+#include <cmath>
 #include <fmt/format.h>
 
 namespace stellar
 {
 
+namespace
+{
+void
+updateAverage(std::optional<double>& avg, VirtualClock::duration d)
+{
+    double secs = std::chrono::duration<double>(d).count();
+    avg = avg ? 0.8 * *avg + 0.2 * secs : secs;
+}
+}
+
 DownloadApplyTxsWork::DownloadApplyTxsWork(
     Application& app, TmpDir const& downloadDir, LedgerRange const& range,
     LedgerHeaderHistoryEntry& lastApplied, bool waitForPublish,
@@ -32,6 +44,7 @@ DownloadApplyTxsWork::DownloadApplyTxsWork(
           app.getHistoryManager().checkpointContainingLedger(range.mFirst))
     , mWaitForPublish(waitForPublish)
     , mArchive(archive)
+    , mStageTimes(std::make_shared<StageTimes>())
 {
 }
 
@@ -79,6 +92,23 @@ DownloadApplyTxsWork::yieldMoreWork()
         mApp, mDownloadDir, LedgerRange::inclusive(low, high), cb);
 
     std::vector<std::shared_ptr<BasicWork>> seq{getAndUnzip};
+    std::vector<std::string> filesToDelete{ft.localPath_nogz()};
+    if (mApp.getConfig().CATCHUP_TRUSTED_REPLAY)
+    {
+        // ApplyCheckpointWork reads which transactions succeeded from them
+        FileTransferInfo ri(mDownloadDir, HISTORY_FILE_TYPE_RESULTS,
+                            mCheckpointToQueue);
+        seq.push_back(
+            std::make_shared<GetAndUnzipRemoteFileWork>(mApp, ri, mArchive));
+        filesToDelete.emplace_back(ri.localPath_nogz());
+    }
+    auto times = mStageTimes;
+    seq.push_back(std::make_shared<WorkWithCallback>(
+        mApp, "downloaded-transactions-" + std::to_string(mCheckpointToQueue),
+        [times, queuedAt = mApp.getClock().now()](Application& app) {
+            updateAverage(times->mDownload, app.getClock().now() - queuedAt);
+            return true;
+        }));
 
     auto maybeWaitForMerges = [](Application& app) {
         if (app.getConfig().CATCHUP_WAIT_MERGES_TX_APPLY_FOR_TESTING)
@@ -93,6 +123,17 @@ DownloadApplyTxsWork::yieldMoreWork()
         }
     };
 
+    auto timeApply = [times](ConditionFn cond) {
+        return [times, cond](Application& app) mutable {
+            if (!cond(app))
+            {
+                return false;
+            }
+            times->mApplyStart = app.getClock().now();
+            return true;
+        };
+    };
+
     if (mLastYieldedWork)
     {
         auto prev = mLastYieldedWork;
@@ -130,31 +171,36 @@ DownloadApplyTxsWork::yieldMoreWork()
             return res && maybeWaitForMerges(app);
         };
         seq.push_back(std::make_shared<ConditionalWork>(
-            mApp, "conditional-" + apply->getName(), predicate, apply));
+            mApp, "conditional-" + apply->getName(), timeApply(predicate),
+            apply));
     }
     else
     {
         seq.push_back(std::make_shared<ConditionalWork>(
-            mApp, "wait-merges" + apply->getName(), maybeWaitForMerges, apply));
+            mApp, "wait-merges" + apply->getName(),
+            timeApply(maybeWaitForMerges), apply));
     }
 
     seq.push_back(std::make_shared<WorkWithCallback>(
         mApp, "delete-transactions-" + std::to_string(mCheckpointToQueue),
-        [ft](Application& app) {
-            try
-            {
-                std::filesystem::remove(
-                    std::filesystem::path(ft.localPath_nogz()));
-                CLOG_DEBUG(History, "Deleted transactions {}",
-                           ft.localPath_nogz());
-                return true;
-            }
-            catch (std::filesystem::filesystem_error const& e)
+        [filesToDelete, times](Application& app) {
+            updateAverage(times->mApply,
+                          app.getClock().now() - times->mApplyStart);
+            for (auto const& path : filesToDelete)
             {
-                CLOG_ERROR(History, "Could not delete transactions {}: {}",
-                           ft.localPath_nogz(), e.what());
-                return false;
+                try
+                {
+                    std::filesystem::remove(std::filesystem::path(path));
+                    CLOG_DEBUG(History, "Deleted transactions {}", path);
+                }
+                catch (std::filesystem::filesystem_error const& e)
+                {
+                    CLOG_ERROR(History, "Could not delete transactions {}: {}",
+                               path, e.what());
+                    return false;
+                }
             }
+            return true;
         }));
 
     auto nextWork = std::make_shared<WorkSequence>(
@@ -174,6 +220,33 @@ DownloadApplyTxsWork::resetIter()
     mLastApplied = mApp.getLedgerManager().getLastClosedLedgerHeader();
 }
 
+size_t
+DownloadApplyTxsWork::getMaxConcurrency() const
+{
+    auto const& cfg = mApp.getConfig();
+    size_t maxAhead = cfg.CATCHUP_MAX_DOWNLOAD_AHEAD;
+    if (maxAhead == 0)
+    {
+        return BatchWork::getMaxConcurrency();
+    }
+
+    size_t ahead = std::min(maxAhead, cfg.MAX_CONCURRENT_SUBPROCESSES);
+    auto const& times = *mStageTimes;
+    if (times.mDownload && times.mApply)
+    {
+        ahead = maxAhead;
+        if (*times.mApply > 0)
+        {
+            auto needed = std::ceil(*times.mDownload / *times.mApply);
+            if (needed < static_cast<double>(maxAhead))
+            {
+                ahead = std::max<size_t>(static_cast<size_t>(needed), 1);
+            }
+        }
+    }
+    return ahead + 1;
+}
+
 bool
 DownloadApplyTxsWork::hasNext() const
 {
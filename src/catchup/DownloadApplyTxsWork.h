@@ -5,10 +5,13 @@
 #pragma once
 
 #include "ledger/LedgerRange.h"
+#include "util/Timer.h"
 #include "util/XDRStream.h"
 #include "work/BatchWork.h"
 #include "xdr/Stellar-ledger.h"
 
+#include <optional>
+
 namespace medida
 {
 class Meter;
@@ -31,6 +34,16 @@ class DownloadApplyTxsWork : public BatchWork
     bool const mWaitForPublish;
     std::shared_ptr<HistoryArchive> mArchive;
 
+    // Moving averages of how long a checkpoint takes to download and to
+    // apply, in seconds, updated by the works of each checkpoint
+    struct StageTimes
+    {
+        std::optional<double> mDownload;
+        std::optional<double> mApply;
+        VirtualClock::time_point mApplyStart;
+    };
+    std::shared_ptr<StageTimes> mStageTimes;
+
   public:
     DownloadApplyTxsWork(Application& app, TmpDir const& downloadDir,
                          LedgerRange const& range,
@@ -44,6 +57,10 @@ class DownloadApplyTxsWork : public BatchWork
     bool hasNext() const override;
     std::shared_ptr<BasicWork> yieldMoreWork() override;
     void resetIter() override;
+    // With CATCHUP_MAX_DOWNLOAD_AHEAD, the checkpoint being applied plus
+    // as many as are needed for the next one to be downloaded by the time
+    // the current one is applied
+    size_t getMaxConcurrency() const override;
     void onSuccess() override;
 };
 }
\ No newline at end of file
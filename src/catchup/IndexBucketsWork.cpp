@@ -8,9 +8,9 @@
 #include "util/HashOfHash.h"
 #include "util/UnorderedSet.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -61,6 +61,7 @@ IndexBucketsWork::IndexWork::postWork()
                 fs::exists(indexFilename))
             {
                 self->mIndex = BucketIndex::load(bm, indexFilename,
+                                                 self->mBucket->getHash(),
                                                  self->mBucket->getSize());
 
                 // If we could not load the index from the file, file is out of
@@ -100,7 +101,7 @@ IndexBucketsWork::IndexWork::postWork()
                 },
                 "IndexWork: finished");
         },
-        "IndexWork: starting in background");
+        "IndexWork: starting in background", BackgroundTaskClass::INDEX);
 }
 
 IndexBucketsWork::IndexBucketsWork(
@@ -5,7 +5,6 @@
 #include "catchup/ReplayDebugMetaWork.h"
 #include "catchup/CatchupWork.h"
 #include "work/WorkScheduler.h"
-#include "work/WorkWithCallback.h"
 
 #include "catchup/ApplyLedgerWork.h"
 #include "herder/LedgerCloseData.h"
@@ -14,27 +13,143 @@
 #include "util/DebugMetaUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include <regex>
 
 namespace stellar
 {
 
-// Helper class to apply ledgers from a single debug meta file
-class ApplyLedgersFromMetaWork : public Work
+// Helper class reading all the ledgers of a single (unzipped) debug meta
+// file on a background thread, so that they're decoded while the ledgers
+// before them are applied
+class DecodeLedgersFromMetaWork : public BasicWork
 {
-    XDRInputFileStream mMetaIn;
     std::filesystem::path const mFilename;
-    bool mFileOpen{false};
+    bool const mRemoveFile;
+    bool mStarted{false};
+    bool mDone{false};
+    bool mFailed{false};
+    std::vector<LedgerCloseMeta> mLedgers;
+
+  public:
+    DecodeLedgersFromMetaWork(Application& app,
+                              std::filesystem::path const& unzippedMetaFile,
+                              bool removeFile)
+        : BasicWork(app,
+                    fmt::format("decode-ledgers-from-{}", unzippedMetaFile),
+                    BasicWork::RETRY_NEVER)
+        , mFilename(unzippedMetaFile)
+        , mRemoveFile(removeFile)
+    {
+    }
+
+    virtual ~DecodeLedgersFromMetaWork() = default;
+
+    std::vector<LedgerCloseMeta>
+    takeLedgers()
+    {
+        releaseAssert(mDone && !mFailed);
+        return std::move(mLedgers);
+    }
+
+  protected:
+    void
+    onReset() override
+    {
+        mStarted = false;
+        mDone = false;
+        mFailed = false;
+        mLedgers.clear();
+    }
+
+    bool
+    onAbort() override
+    {
+        return true;
+    }
+
+    State
+    onRun() override
+    {
+        if (mDone)
+        {
+            return mFailed ? State::WORK_FAILURE : State::WORK_SUCCESS;
+        }
+        if (!mStarted)
+        {
+            mStarted = true;
+            startDecoding();
+        }
+        return State::WORK_WAITING;
+    }
+
+  private:
+    void
+    startDecoding()
+    {
+        Application& app = mApp;
+        std::weak_ptr<DecodeLedgersFromMetaWork> weak(
+            std::static_pointer_cast<DecodeLedgersFromMetaWork>(
+                shared_from_this()));
+        app.postOnBackgroundThread(
+            [&app, weak, filename = mFilename, removeFile = mRemoveFile]() {
+                ZoneNamedN(decodeZone, "decode debug meta", true);
+                auto ledgers = std::make_shared<std::vector<LedgerCloseMeta>>();
+                bool failed = false;
+                try
+                {
+                    XDRInputFileStream in;
+                    in.open(filename.string());
+                    LedgerCloseMeta lcm;
+                    while (in.readOne(lcm))
+                    {
+                        ledgers->emplace_back(std::move(lcm));
+                    }
+                }
+                catch (std::exception const& e)
+                {
+                    CLOG_ERROR(Work, "Failed to read debug meta file {}: {}",
+                               filename.string(), e.what());
+                    failed = true;
+                }
+                if (removeFile)
+                {
+                    std::error_code ec;
+                    std::filesystem::remove(filename, ec);
+                }
+                app.postOnMainThread(
+                    [weak, ledgers, failed]() {
+                        auto self = weak.lock();
+                        if (self && !self->isDone())
+                        {
+                            self->mLedgers = std::move(*ledgers);
+                            self->mFailed = failed;
+                            self->mDone = true;
+                            self->wakeUp();
+                        }
+                    },
+                    "DecodeLedgersFromMetaWork: finish");
+            },
+            "DecodeLedgersFromMetaWork: start in background");
+    }
+};
+
+// Helper class to apply the ledgers decoded from a single debug meta file
+class ApplyLedgersFromMetaWork : public Work
+{
+    std::vector<LedgerCloseMeta> const mLedgers;
+    size_t mNextToApply{0};
     std::shared_ptr<ApplyLedgerWork> mApplyLedgerWork;
     uint32_t const mTargetLedger;
 
   public:
     ApplyLedgersFromMetaWork(Application& app,
-                             std::filesystem::path const& unzippedMetaFile,
+                             std::filesystem::path const& metaFile,
+                             std::vector<LedgerCloseMeta>&& ledgers,
                              uint32_t targetLedger)
-        : Work(app, fmt::format("apply-ledgers-from-{}", unzippedMetaFile),
+        : Work(app, fmt::format("apply-ledgers-from-{}", metaFile),
                BasicWork::RETRY_NEVER)
-        , mFilename(unzippedMetaFile)
+        , mLedgers(std::move(ledgers))
         , mTargetLedger(targetLedger)
     {
     }
@@ -45,20 +160,13 @@ class ApplyLedgersFromMetaWork : public Work
     void
     doReset() override
     {
-        mMetaIn.close();
-        mFileOpen = false;
+        mNextToApply = 0;
         mApplyLedgerWork.reset();
     }
 
     State
     doWork() override
     {
-        if (!mFileOpen)
-        {
-            mMetaIn.open(mFilename.string());
-            mFileOpen = true;
-        }
-
         if (mApplyLedgerWork)
         {
             if (mApplyLedgerWork->getState() == BasicWork::State::WORK_SUCCESS)
@@ -79,16 +187,17 @@ class ApplyLedgersFromMetaWork : public Work
             return BasicWork::State::WORK_SUCCESS;
         }
 
-        // Invariant: ledger close meta can't have gaps, so here reading should
-        // always yield the next ledger
-        LedgerCloseMeta lcm;
-        if (!mMetaIn.readOne(lcm))
+        // Invariant: ledger close meta can't have gaps, so here the next
+        // decoded ledger should always be the next ledger
+        if (mNextToApply == mLedgers.size())
         {
-            // Reached the end of the stream, success
+            // Applied all ledgers of the file, success
             return BasicWork::State::WORK_SUCCESS;
         }
+        auto const& lcm = mLedgers[mNextToApply++];
 
-        auto lh = lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
+        auto const& lh =
+            lcm.v() == 0 ? lcm.v0().ledgerHeader : lcm.v1().ledgerHeader;
 
         auto ledgerSeqToApply = lh.header.ledgerSeq;
         auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
@@ -125,14 +234,6 @@ class ApplyLedgersFromMetaWork : public Work
         mApplyLedgerWork = addWork<ApplyLedgerWork>(ledgerCloseData);
         return BasicWork::State::WORK_RUNNING;
     }
-
-    void
-    onSuccess() override
-    {
-        // Close the stream just in case Work is kept alive for some time before
-        // it's garbage-collected
-        mMetaIn.close();
-    }
 };
 
 ReplayDebugMetaWork::ReplayDebugMetaWork(Application& app,
@@ -143,7 +244,7 @@ ReplayDebugMetaWork::ReplayDebugMetaWork(Application& app,
     , mFiles(metautils::listMetaDebugFiles(metaDir))
     , mMetaDir(metaDir)
 {
-    mNextToApply = mFiles.cbegin();
+    mNextToDecode = mFiles.cbegin();
 }
 
 BasicWork::State
@@ -177,27 +278,68 @@ ReplayDebugMetaWork::applyLastLedger()
     return BasicWork::State::WORK_SUCCESS;
 }
 
+void
+ReplayDebugMetaWork::startDecodingNextFile()
+{
+    auto filename = *mNextToDecode++;
+    CLOG_INFO(Work, "Decode next debug meta file: {}", filename.string());
+    auto isZipped = std::regex_match(filename.string(),
+                                     metautils::META_DEBUG_ZIP_FILE_REGEX);
+
+    auto zipped = metautils::getMetaDebugDirPath(mMetaDir) / filename;
+
+    std::filesystem::path unzipped = zipped;
+    std::vector<std::shared_ptr<BasicWork>> seq;
+
+    if (isZipped)
+    {
+        seq.emplace_back(std::make_shared<GunzipFileWork>(
+            mApp, zipped.string(), /* keepExisting */ true));
+        // If zipped, remove `gz` extension
+        unzipped.replace_extension();
+    }
+
+    // The unzipped copy is removed once decoded
+    auto decode = std::make_shared<DecodeLedgersFromMetaWork>(mApp, unzipped,
+                                                              isZipped);
+    seq.emplace_back(decode);
+
+    auto sequence = addWork<WorkSequence>("unzip-and-decode-from-meta", seq,
+                                          BasicWork::RETRY_NEVER);
+    mDecoding.push_back({filename, sequence, decode});
+}
+
 BasicWork::State
 ReplayDebugMetaWork::doWork()
 {
-    if (mCurrentWorkSequence)
+    // Keep the next files decoding while the current one applies, unless
+    // there's nothing left to apply
+    bool targetReached =
+        mTargetLedger != 0 &&
+        mApp.getLedgerManager().getLastClosedLedgerNum() >= mTargetLedger;
+    while (!targetReached && mDecoding.size() < FILES_DECODED_AHEAD &&
+           mNextToDecode != mFiles.end())
+    {
+        startDecodingNextFile();
+    }
+
+    if (mCurrentApplyWork)
     {
-        if (mCurrentWorkSequence->getState() == BasicWork::State::WORK_SUCCESS)
+        if (mCurrentApplyWork->getState() == BasicWork::State::WORK_SUCCESS)
         {
-            mCurrentWorkSequence.reset();
-            ++mNextToApply;
+            mCurrentApplyWork.reset();
         }
         else
         {
-            return mCurrentWorkSequence->getState();
+            return mCurrentApplyWork->getState();
         }
     }
 
-    releaseAssert(!mCurrentWorkSequence);
-    if (mNextToApply == mFiles.end())
+    releaseAssert(!mCurrentApplyWork);
+    if (mDecoding.empty())
     {
-        if (mTargetLedger == 0 ||
-            mApp.getLedgerManager().getLastClosedLedgerNum() < mTargetLedger)
+        releaseAssert(targetReached || mNextToDecode == mFiles.end());
+        if (!targetReached)
         {
             // Finished applying meta from all debug files, see if we can apply
             // the latest saved tx set on top
@@ -209,46 +351,25 @@ ReplayDebugMetaWork::doWork()
         }
     }
 
-    auto filename = *mNextToApply;
-    CLOG_INFO(Work, "Process next debug meta file: {}", filename.string());
-    auto isZipped = std::regex_match(filename.string(),
-                                     metautils::META_DEBUG_ZIP_FILE_REGEX);
-
-    auto zipped = metautils::getMetaDebugDirPath(mMetaDir) / filename;
-
-    std::filesystem::path unzipped = zipped;
-    std::vector<std::shared_ptr<BasicWork>> seq;
-
-    if (isZipped)
+    auto& next = mDecoding.front();
+    if (next.mSequence->getState() != BasicWork::State::WORK_SUCCESS)
     {
-        seq.emplace_back(std::make_shared<GunzipFileWork>(
-            mApp, zipped.string(), /* keepExisting */ true));
-        // If zipped, remove `gz` extension
-        unzipped.replace_extension();
+        return next.mSequence->getState();
     }
 
-    seq.emplace_back(std::make_shared<ApplyLedgersFromMetaWork>(mApp, unzipped,
-                                                                mTargetLedger));
-    auto removeUnzipped = [isZipped, unzipped](Application& app) {
-        if (isZipped)
-        {
-            std::filesystem::remove(unzipped);
-        }
-        return true;
-    };
-    seq.emplace_back(std::make_shared<WorkWithCallback>(mApp, "remove-unzipped",
-                                                        removeUnzipped));
-
-    mCurrentWorkSequence = addWork<WorkSequence>("unzip-and-apply-from-meta",
-                                                 seq, BasicWork::RETRY_NEVER);
+    CLOG_INFO(Work, "Apply next debug meta file: {}", next.mFile.string());
+    mCurrentApplyWork = addWork<ApplyLedgersFromMetaWork>(
+        next.mFile, next.mDecode->takeLedgers(), mTargetLedger);
+    mDecoding.pop_front();
     return BasicWork::State::WORK_RUNNING;
 }
 
 void
 ReplayDebugMetaWork::doReset()
 {
-    mNextToApply = mFiles.cbegin();
-    mCurrentWorkSequence.reset();
+    mNextToDecode = mFiles.cbegin();
+    mDecoding.clear();
+    mCurrentApplyWork.reset();
 }
 
 }
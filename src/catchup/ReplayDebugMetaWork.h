@@ -6,6 +6,7 @@
 
 #include "main/Application.h"
 #include "work/Work.h"
+#include <deque>
 #include <filesystem>
 
 namespace stellar
@@ -13,9 +14,18 @@ namespace stellar
 
 class CatchupWork;
 class WorkSequence;
+class DecodeLedgersFromMetaWork;
+class ApplyLedgersFromMetaWork;
 
+// Replays the ledgers of the debug meta files, decoding the files after the
+// one being applied on background threads so that replay is bound by how
+// fast ledgers apply.
 class ReplayDebugMetaWork : public Work
 {
+    // Files decoded ahead of the one applied. A file holds 256 ledgers of
+    // meta, a bit more than 100MB decoded, so this bounds memory use too.
+    static size_t const FILES_DECODED_AHEAD = 2;
+
     // Target replay ledger
     uint32_t const mTargetLedger;
 
@@ -25,12 +35,22 @@ class ReplayDebugMetaWork : public Work
     // Directory containing META_DEBUG_DIRNAME
     std::filesystem::path const mMetaDir;
 
-    // File iterator to keep track of the next ledger batch to apply
-    std::vector<std::filesystem::path>::const_iterator mNextToApply;
+    // File iterator to keep track of the next file to decode
+    std::vector<std::filesystem::path>::const_iterator mNextToDecode;
 
-    BasicWork::State applyLastLedger();
+    struct DecodingFile
+    {
+        std::filesystem::path mFile;
+        std::shared_ptr<WorkSequence> mSequence;
+        std::shared_ptr<DecodeLedgersFromMetaWork> mDecode;
+    };
+    // Files being unzipped and decoded, in the order they apply
+    std::deque<DecodingFile> mDecoding;
 
-    std::shared_ptr<WorkSequence> mCurrentWorkSequence;
+    std::shared_ptr<ApplyLedgersFromMetaWork> mCurrentApplyWork;
+
+    BasicWork::State applyLastLedger();
+    void startDecodingNextFile();
 
   public:
     ReplayDebugMetaWork(Application& app, uint32_t targetLedger,
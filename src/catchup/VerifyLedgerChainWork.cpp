@@ -12,8 +12,9 @@
 #include "util/GlobalChecks.h"
 #include "util/Thread.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
-#include <Tracy.hpp>
+#include <algorithm>
 #include <fmt/format.h>
 #include <fstream>
 
@@ -24,7 +25,7 @@ static HistoryManager::LedgerVerificationStatus
 verifyLedgerHistoryEntry(LedgerHeaderHistoryEntry const& hhe)
 {
     ZoneScoped;
-    Hash calculated = sha256(xdr::xdr_to_opaque(hhe.header));
+    Hash calculated = xdrSha256(hhe.header);
     if (calculated != hhe.hash)
     {
         CLOG_ERROR(
@@ -154,22 +155,102 @@ VerifyLedgerChainWork::onReset()
                                 mRange.last());
     mChainDisagreesWithLocalState.reset();
     mHasTrustedHash = false;
+    // Drop the results of scans started before
+    ++mScanGeneration;
+    mScans.clear();
+    mNextCheckpointToScan = mCurrCheckpoint;
+    mAllScansStarted = mRange.mCount == 0;
 }
 
-HistoryManager::LedgerVerificationStatus
-VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
+void
+VerifyLedgerChainWork::startScans()
+{
+    auto const& hm = mApp.getHistoryManager();
+    auto minCheckpoint = hm.checkpointContainingLedger(mRange.mFirst);
+    size_t window =
+        static_cast<size_t>(std::max(mApp.getConfig().WORKER_THREADS, 1));
+    while (!mAllScansStarted && mScans.size() < window)
+    {
+        auto checkpoint = mNextCheckpointToScan;
+        mScans.emplace(checkpoint, std::nullopt);
+        if (checkpoint <= minCheckpoint)
+        {
+            mAllScansStarted = true;
+        }
+        else
+        {
+            mNextCheckpointToScan -= hm.getCheckpointFrequency();
+        }
+
+        FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
+                            checkpoint);
+        Application& app = mApp;
+        std::weak_ptr<VerifyLedgerChainWork> weak(
+            std::static_pointer_cast<VerifyLedgerChainWork>(
+                shared_from_this()));
+        app.postOnBackgroundThread(
+            [&app, weak, path = ft.localPath_nogz(), checkpoint,
+             range = mRange, lastClosed = mLastClosed,
+             version = app.getConfig().LEDGER_PROTOCOL_VERSION,
+             generation = mScanGeneration]() {
+                auto scan = scanCheckpoint(path, checkpoint, range,
+                                           lastClosed, version);
+                app.postOnMainThread(
+                    [weak, checkpoint, generation, scan]() {
+                        auto self = weak.lock();
+                        if (!self || self->mScanGeneration != generation)
+                        {
+                            return;
+                        }
+                        auto it = self->mScans.find(checkpoint);
+                        if (it != self->mScans.end())
+                        {
+                            it->second = scan;
+                            if (checkpoint == self->mCurrCheckpoint)
+                            {
+                                self->wakeUp();
+                            }
+                        }
+                    },
+                    "VerifyLedgerChainWork: checkpoint scanned");
+            },
+            "VerifyLedgerChainWork: scan checkpoint",
+            BackgroundTaskClass::VERIFY);
+    }
+}
+
+VerifyLedgerChainWork::CheckpointScan
+VerifyLedgerChainWork::scanCheckpoint(std::string const& path,
+                                      uint32_t checkpoint,
+                                      LedgerRange const& range,
+                                      LedgerNumHashPair const& lastClosed,
+                                      uint32_t maxProtocolVersion)
 {
     ZoneScoped;
-    // When verifying a checkpoint, we rely on the fact that the next checkpoint
-    // has been verified (unless there's 1 checkpoint).
-    // Once the end of the range is reached, ensure that the chain agrees with
-    // trusted hash passed in. If LCL is reached, verify that it agrees with
-    // the chain.
+    CheckpointScan scan;
+    try
+    {
+        scan.mStatus = scanCheckpointFile(path, checkpoint, range,
+                                          lastClosed, maxProtocolVersion, scan);
+    }
+    catch (...)
+    {
+        // Rethrown on the main thread, as if verifying there
+        scan.mError = std::current_exception();
+    }
+    return scan;
+}
 
-    FileTransferInfo ft(mDownloadDir, HISTORY_FILE_TYPE_LEDGER,
-                        mCurrCheckpoint);
+HistoryManager::LedgerVerificationStatus
+VerifyLedgerChainWork::scanCheckpointFile(std::string const& path,
+                                          uint32_t checkpoint,
+                                          LedgerRange const& range,
+                                          LedgerNumHashPair const& lastClosed,
+                                          uint32_t maxProtocolVersion,
+                                          CheckpointScan& scan)
+{
     XDRInputFileStream hdrIn;
-    hdrIn.open(ft.localPath_nogz());
+    hdrIn.open(path);
 
     bool beginCheckpoint = true;
 
@@ -178,12 +259,12 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
     // stream; `first` will be set to `curr` only on the first iteration, and
     // `prev` will be set to `curr` at the end of the loop to make the previous
     // iteration's `curr` available during the loop.
-    LedgerHeaderHistoryEntry curr;
-    LedgerHeaderHistoryEntry first;
+    auto& curr = scan.mLast;
+    auto& first = scan.mFirst;
     LedgerHeaderHistoryEntry prev;
 
     CLOG_DEBUG(History, "Verifying ledger headers from {} for checkpoint {}",
-               ft.localPath_nogz(), mCurrCheckpoint);
+               path, checkpoint);
 
     while (hdrIn)
     {
@@ -199,45 +280,44 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
             return HistoryManager::VERIFY_STATUS_ERR_BAD_LEDGER_VERSION;
         }
 
-        if (curr.header.ledgerVersion >
-            mApp.getConfig().LEDGER_PROTOCOL_VERSION)
+        if (curr.header.ledgerVersion > maxProtocolVersion)
         {
             // Note that local state does not agree with the archives; depending
             // on the presence of trusted hash
-            mChainDisagreesWithLocalState =
+            scan.mChainDisagreesWithLocalState =
                 HistoryManager::VERIFY_STATUS_ERR_BAD_LEDGER_VERSION;
         }
 
         // Verify ledger with local state by comparing to LCL
         // When checking against LCL, see it the local node is in the bad state,
         // or if the archive is in a bad state (in which case, retry)
-        if (curr.header.ledgerSeq == mLastClosed.first)
+        if (curr.header.ledgerSeq == lastClosed.first)
         {
-            if (sha256(xdr::xdr_to_opaque(curr.header)) != *mLastClosed.second)
+            if (xdrSha256(curr.header) != *lastClosed.second)
             {
                 CLOG_ERROR(History,
                            "Bad ledger-header history entry: claimed ledger {} "
                            "does not agree with LCL {}",
                            LedgerManager::ledgerAbbrev(curr),
-                           LedgerManager::ledgerAbbrev(mLastClosed.first,
-                                                       *mLastClosed.second));
-                mChainDisagreesWithLocalState =
+                           LedgerManager::ledgerAbbrev(lastClosed.first,
+                                                       *lastClosed.second));
+                scan.mChainDisagreesWithLocalState =
                     HistoryManager::VERIFY_STATUS_ERR_BAD_HASH;
             }
         }
         // Verify LCL that is just before the first ledger in range
-        else if (curr.header.ledgerSeq == mLastClosed.first + 1)
+        else if (curr.header.ledgerSeq == lastClosed.first + 1)
         {
-            auto lclResult = verifyLedgerHistoryLink(*mLastClosed.second, curr);
+            auto lclResult = verifyLedgerHistoryLink(*lastClosed.second, curr);
             if (lclResult != HistoryManager::VERIFY_STATUS_OK)
             {
                 CLOG_ERROR(History,
                            "Bad ledger-header history entry: claimed ledger {} "
                            "previous hash does not agree with LCL: {}",
                            LedgerManager::ledgerAbbrev(curr),
-                           LedgerManager::ledgerAbbrev(mLastClosed.first,
-                                                       *mLastClosed.second));
-                mChainDisagreesWithLocalState = lclResult;
+                           LedgerManager::ledgerAbbrev(lastClosed.first,
+                                                       *lastClosed.second));
+                scan.mChainDisagreesWithLocalState = lclResult;
             }
         }
 
@@ -284,27 +364,57 @@ VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint()
             }
         }
 
-        mApp.getCatchupManager().ledgersVerified();
+        ++scan.mLedgersVerified;
         prev = curr;
 
         // No need to keep verifying if the range is covered
-        if (curr.header.ledgerSeq == mRange.last())
+        if (curr.header.ledgerSeq == range.last())
         {
             break;
         }
     }
 
-    if (curr.header.ledgerSeq != mCurrCheckpoint &&
-        curr.header.ledgerSeq != mRange.last())
+    if (curr.header.ledgerSeq != checkpoint &&
+        curr.header.ledgerSeq != range.last())
     {
-        // We can end at mCurrCheckpoint if checkpoint was valid
-        // or at mRange.last() if history chain file was valid and we
-        // reached last ledger in the range. Any other ledger here means
-        // that file is corrupted.
+        // We can end at the checkpoint if it was valid or at range.last() if
+        // history chain file was valid and we reached last ledger in the
+        // range. Any other ledger here means that file is corrupted.
         CLOG_ERROR(History, "History chain did not end with {} or {}",
-                   mCurrCheckpoint, mRange.last());
+                   checkpoint, range.last());
         return HistoryManager::VERIFY_STATUS_ERR_MISSING_ENTRIES;
     }
+    return HistoryManager::VERIFY_STATUS_OK;
+}
+
+HistoryManager::LedgerVerificationStatus
+VerifyLedgerChainWork::verifyHistoryOfSingleCheckpoint(
+    CheckpointScan const& scan)
+{
+    ZoneScoped;
+    // When verifying a checkpoint, we rely on the fact that the next checkpoint
+    // has been verified (unless there's 1 checkpoint).
+    // Once the end of the range is reached, ensure that the chain agrees with
+    // trusted hash passed in. If LCL is reached, verify that it agrees with
+    // the chain.
+    //
+    // The checkpoint's own file was already checked by scanCheckpoint, what
+    // is left is linking it to the checkpoint ahead.
+    if (scan.mLedgersVerified > 0)
+    {
+        mApp.getCatchupManager().ledgersVerified(scan.mLedgersVerified);
+    }
+    if (scan.mChainDisagreesWithLocalState)
+    {
+        mChainDisagreesWithLocalState = scan.mChainDisagreesWithLocalState;
+    }
+    if (scan.mStatus != HistoryManager::VERIFY_STATUS_OK)
+    {
+        return scan.mStatus;
+    }
+
+    auto const& first = scan.mFirst;
+    auto const& curr = scan.mLast;
 
     // We just finished scanning a checkpoint. We first grab the _incoming_
     // hash-link our caller (or previous call to this method) saved for us.
@@ -412,6 +522,8 @@ VerifyLedgerChainWork::onSuccess()
             (*mOutputStream) << "\n[" << pair.first << ", \""
                              << binToHex(*pair.second) << "\"],";
         }
+        // Flushed so that an interrupted run can be resumed from them
+        mOutputStream->flush();
     }
 }
 
@@ -439,12 +551,27 @@ VerifyLedgerChainWork::onRun()
             "Verification undershot first ledger in the range.");
     }
 
+    startScans();
+    auto it = mScans.find(mCurrCheckpoint);
+    releaseAssert(it != mScans.end());
+    if (!it->second)
+    {
+        // Woken up once its scan is done
+        return BasicWork::State::WORK_WAITING;
+    }
+    auto scan = std::move(*it->second);
+    mScans.erase(it);
+
     HistoryManager::LedgerVerificationStatus result;
 
     // Catch FS-related errors to gracefully fail Work instead of crashing
     try
     {
-        result = verifyHistoryOfSingleCheckpoint();
+        if (scan.mError)
+        {
+            std::rethrow_exception(scan.mError);
+        }
+        result = verifyHistoryOfSingleCheckpoint(scan);
     }
     catch (FileSystemException&)
     {
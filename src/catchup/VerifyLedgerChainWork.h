@@ -7,8 +7,12 @@
 #include "history/HistoryManager.h"
 #include "ledger/LedgerRange.h"
 #include "work/Work.h"
+#include "xdr/Stellar-ledger.h"
+#include <exception>
 #include <future>
 #include <iosfwd>
+#include <map>
+#include <optional>
 #include <vector>
 
 namespace stellar
@@ -72,7 +76,44 @@ class VerifyLedgerChainWork : public BasicWork
     std::vector<LedgerNumHashPair> mVerifiedLedgers;
     std::shared_ptr<std::ofstream> mOutputStream;
 
-    HistoryManager::LedgerVerificationStatus verifyHistoryOfSingleCheckpoint();
+    // What reading the ledger headers of a checkpoint found. Everything but
+    // linking the checkpoint to the one ahead of it can be checked from its
+    // own file, so checkpoints are scanned in parallel on background threads,
+    // up to WORKER_THREADS of them ahead of mCurrCheckpoint, and then linked
+    // in order on the main thread.
+    struct CheckpointScan
+    {
+        HistoryManager::LedgerVerificationStatus mStatus{
+            HistoryManager::VERIFY_STATUS_OK};
+        std::optional<HistoryManager::LedgerVerificationStatus>
+            mChainDisagreesWithLocalState;
+        LedgerHeaderHistoryEntry mFirst;
+        LedgerHeaderHistoryEntry mLast;
+        uint32_t mLedgersVerified{0};
+        // Set if scanning threw
+        std::exception_ptr mError;
+    };
+
+    // Scans started and not linked yet, unset while running
+    std::map<uint32_t, std::optional<CheckpointScan>> mScans;
+    uint32_t mNextCheckpointToScan{0};
+    bool mAllScansStarted{false};
+    // Bumped on reset so that the scans started before are ignored
+    uint64_t mScanGeneration{0};
+
+    static CheckpointScan scanCheckpoint(std::string const& path,
+                                         uint32_t checkpoint,
+                                         LedgerRange const& range,
+                                         LedgerNumHashPair const& lastClosed,
+                                         uint32_t maxProtocolVersion);
+    static HistoryManager::LedgerVerificationStatus
+    scanCheckpointFile(std::string const& path, uint32_t checkpoint,
+                       LedgerRange const& range,
+                       LedgerNumHashPair const& lastClosed,
+                       uint32_t maxProtocolVersion, CheckpointScan& scan);
+    void startScans();
+    HistoryManager::LedgerVerificationStatus
+    verifyHistoryOfSingleCheckpoint(CheckpointScan const& scan);
 
   public:
     VerifyLedgerChainWork(
@@ -7,6 +7,7 @@
 #include "crypto/ByteSlice.h"
 #include "crypto/XDRHasher.h"
 #include "sodium/crypto_generichash.h"
+#include "util/GlobalChecks.h"
 #include "xdr/Stellar-types.h"
 #include <memory>
 
@@ -55,4 +56,18 @@ xdrBlake2(T const& t)
     xb.flush();
     return xb.state.finish();
 }
+
+// Sets `out` to `xdr_to_opaque(t)` and returns its BLAKE2, encoding `t` only
+// once, for callers that need both.
+template <typename T>
+uint256
+xdrBlake2Encode(T const& t, xdr::opaque_vec<>& out)
+{
+    out.resize(xdr::xdr_size(t));
+    XDREncodingHasher<BLAKE2> xb(out.data());
+    xdr::archive(xb, t);
+    xb.flush();
+    releaseAssert(xb.mOut == out.data() + out.size());
+    return xb.mState.finish();
+}
 }
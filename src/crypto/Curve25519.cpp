@@ -6,7 +6,7 @@
 #include "crypto/CryptoError.h"
 #include "crypto/SHA.h"
 #include "util/HashOfHash.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <functional>
 
 #ifdef MSAN_ENABLED
@@ -13,6 +13,9 @@ namespace stellar
 // Hex-encode a ByteSlice.
 std::string binToHex(ByteSlice const& bin);
 
+// Same, into `out`, whose capacity is reused when encoding many values
+void binToHex(ByteSlice const& bin, std::string& out);
+
 // Hex-encode a ByteSlice and return a 6-character prefix of it (for logging).
 std::string hexAbbrev(ByteSlice const& bin);
 
@@ -7,9 +7,19 @@
 #include "crypto/CryptoError.h"
 #include "crypto/Curve25519.h"
 #include "util/NonCopyable.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
 #include <sodium.h>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STELLAR_SHA256_AVX2
+#define STELLAR_SHA256_SHANI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 namespace stellar
 {
 
@@ -26,6 +36,360 @@ sha256(ByteSlice const& bin)
     return out;
 }
 
+#ifdef STELLAR_SHA256_AVX2
+namespace
+{
+// Hashes up to 8 messages at a time, one in each 32-bit lane of the AVX2
+// registers.
+constexpr size_t SHA256_LANES = 8;
+constexpr size_t SHA256_BLOCK = 64;
+
+uint32_t const SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t const SHA256_IV[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372,
+                               0xa54ff53a, 0x510e527f, 0x9b05688c,
+                               0x1f83d9ab, 0x5be0cd19};
+
+unsigned char const SHA256_ZERO_BLOCK[SHA256_BLOCK] = {};
+
+// One message of a batch
+struct Sha256Lane
+{
+    unsigned char const* mData{SHA256_ZERO_BLOCK};
+    size_t mFullBlocks{0};
+    // Zero for the lanes left unused in the last batch
+    size_t mBlocks{0};
+    // The last, padded, one or two blocks of the message
+    unsigned char mTail[2 * SHA256_BLOCK];
+
+    void
+    init(ByteSlice const& bin)
+    {
+        mData = bin.data();
+        mFullBlocks = bin.size() / SHA256_BLOCK;
+        // The message is followed by 0x80 and its size in bits on 8 bytes
+        mBlocks = (bin.size() + 9 + SHA256_BLOCK - 1) / SHA256_BLOCK;
+
+        size_t const rem = bin.size() % SHA256_BLOCK;
+        size_t const tailSize = (mBlocks - mFullBlocks) * SHA256_BLOCK;
+        std::memset(mTail, 0, sizeof(mTail));
+        std::memcpy(mTail, mData + mFullBlocks * SHA256_BLOCK, rem);
+        mTail[rem] = 0x80;
+        uint64_t bits = static_cast<uint64_t>(bin.size()) * 8;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            mTail[tailSize - 1 - i] =
+                static_cast<unsigned char>(bits >> (8 * i));
+        }
+    }
+
+    unsigned char const*
+    block(size_t i) const
+    {
+        if (i < mFullBlocks)
+        {
+            return mData + i * SHA256_BLOCK;
+        }
+        if (i < mBlocks)
+        {
+            return mTail + (i - mFullBlocks) * SHA256_BLOCK;
+        }
+        return SHA256_ZERO_BLOCK;
+    }
+};
+
+__attribute__((target("avx2"))) inline __m256i
+rotr(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n),
+                           _mm256_slli_epi32(x, 32 - n));
+}
+
+__attribute__((target("avx2"))) inline __m256i
+add(__m256i a, __m256i b)
+{
+    return _mm256_add_epi32(a, b);
+}
+
+__attribute__((target("avx2"))) inline __m256i
+xor3(__m256i a, __m256i b, __m256i c)
+{
+    return _mm256_xor_si256(_mm256_xor_si256(a, b), c);
+}
+
+__attribute__((target("avx2"))) inline uint32_t
+loadBigEndian(unsigned char const* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return __builtin_bswap32(v);
+}
+
+__attribute__((target("avx2"))) void
+sha256Lanes(Sha256Lane const* lanes, uint256* const* out)
+{
+    __m256i state[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        state[i] = _mm256_set1_epi32(static_cast<int>(SHA256_IV[i]));
+    }
+
+    size_t blocks = 0;
+    alignas(32) int32_t laneBlocks[SHA256_LANES];
+    for (size_t l = 0; l < SHA256_LANES; ++l)
+    {
+        blocks = std::max(blocks, lanes[l].mBlocks);
+        laneBlocks[l] = static_cast<int32_t>(lanes[l].mBlocks);
+    }
+    __m256i const laneBlocksV =
+        _mm256_load_si256(reinterpret_cast<__m256i const*>(laneBlocks));
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        unsigned char const* p[SHA256_LANES];
+        for (size_t l = 0; l < SHA256_LANES; ++l)
+        {
+            p[l] = lanes[l].block(b);
+        }
+
+        __m256i w[16];
+        for (size_t t = 0; t < 16; ++t)
+        {
+            size_t const o = 4 * t;
+            w[t] = _mm256_setr_epi32(
+                static_cast<int>(loadBigEndian(p[0] + o)),
+                static_cast<int>(loadBigEndian(p[1] + o)),
+                static_cast<int>(loadBigEndian(p[2] + o)),
+                static_cast<int>(loadBigEndian(p[3] + o)),
+                static_cast<int>(loadBigEndian(p[4] + o)),
+                static_cast<int>(loadBigEndian(p[5] + o)),
+                static_cast<int>(loadBigEndian(p[6] + o)),
+                static_cast<int>(loadBigEndian(p[7] + o)));
+        }
+
+        __m256i a = state[0], bb = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (size_t t = 0; t < 64; ++t)
+        {
+            if (t >= 16)
+            {
+                __m256i const w2 = w[(t - 2) & 15];
+                __m256i const w15 = w[(t - 15) & 15];
+                __m256i const s0 = xor3(rotr(w15, 7), rotr(w15, 18),
+                                        _mm256_srli_epi32(w15, 3));
+                __m256i const s1 = xor3(rotr(w2, 17), rotr(w2, 19),
+                                        _mm256_srli_epi32(w2, 10));
+                w[t & 15] =
+                    add(add(w[t & 15], s0), add(w[(t - 7) & 15], s1));
+            }
+            __m256i const ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                                _mm256_andnot_si256(e, g));
+            __m256i const maj = _mm256_or_si256(
+                _mm256_and_si256(a, bb),
+                _mm256_and_si256(c, _mm256_or_si256(a, bb)));
+            __m256i const t1 = add(
+                add(add(h, xor3(rotr(e, 6), rotr(e, 11), rotr(e, 25))),
+                    add(ch, w[t & 15])),
+                _mm256_set1_epi32(static_cast<int>(SHA256_K[t])));
+            __m256i const t2 =
+                add(xor3(rotr(a, 2), rotr(a, 13), rotr(a, 22)), maj);
+            h = g;
+            g = f;
+            f = e;
+            e = add(d, t1);
+            d = c;
+            c = bb;
+            bb = a;
+            a = add(t1, t2);
+        }
+
+        // Lanes whose message is done keep their state
+        __m256i const active = _mm256_cmpgt_epi32(
+            laneBlocksV, _mm256_set1_epi32(static_cast<int>(b)));
+        __m256i const vars[8] = {a, bb, c, d, e, f, g, h};
+        for (size_t i = 0; i < 8; ++i)
+        {
+            state[i] = _mm256_blendv_epi8(
+                state[i], add(state[i], vars[i]), active);
+        }
+    }
+
+    alignas(32) uint32_t words[8][SHA256_LANES];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+    }
+    for (size_t l = 0; l < SHA256_LANES; ++l)
+    {
+        if (!out[l])
+        {
+            continue;
+        }
+        for (size_t i = 0; i < 8; ++i)
+        {
+            uint32_t const v = words[i][l];
+            for (size_t j = 0; j < 4; ++j)
+            {
+                (*out[l])[4 * i + j] =
+                    static_cast<unsigned char>(v >> (8 * (3 - j)));
+            }
+        }
+    }
+}
+
+bool
+haveAvx2()
+{
+    static bool const avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+}
+#endif
+
+#ifdef STELLAR_SHA256_SHANI
+namespace
+{
+// Runs the SHA256 compression function over `blocks` 64-byte blocks with
+// the SHA extensions, on a state laid out like libsodium's.
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha256BlocksShaNi(uint32_t state[8], unsigned char const* data, size_t blocks)
+{
+    __m128i const shuffleMask =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions work on the state as ABEF and CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<__m128i const*>(state));
+    __m128i state1 =
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(state + 4));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; --blocks, data += 64)
+    {
+        __m128i const abefSave = state0;
+        __m128i const cdghSave = state1;
+        // Message schedule, 4 words at a time
+        __m128i w[16];
+        for (size_t g = 0; g < 16; ++g)
+        {
+            if (g < 4)
+            {
+                w[g] = _mm_shuffle_epi8(
+                    _mm_loadu_si128(
+                        reinterpret_cast<__m128i const*>(data + 16 * g)),
+                    shuffleMask);
+            }
+            else
+            {
+                __m128i t = _mm_sha256msg1_epu32(w[g - 4], w[g - 3]);
+                t = _mm_add_epi32(t, _mm_alignr_epi8(w[g - 1], w[g - 2], 4));
+                w[g] = _mm_sha256msg2_epu32(t, w[g - 1]);
+            }
+            __m128i msg = _mm_add_epi32(
+                w[g], _mm_loadu_si128(
+                          reinterpret_cast<__m128i const*>(SHA256_K + 4 * g)));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+        state0 = _mm_add_epi32(state0, abefSave);
+        state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+}
+
+bool
+haveShaNi()
+{
+    static bool const shaNi = []() {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+            !(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+        {
+            return false;
+        }
+        return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) &&
+               (ebx & bit_SHA);
+    }();
+    return shaNi;
+}
+}
+#endif
+
+std::vector<uint256>
+sha256Batch(std::vector<ByteSlice> const& bins)
+{
+    ZoneScoped;
+    std::vector<uint256> out(bins.size());
+    size_t done = 0;
+#ifdef STELLAR_SHA256_AVX2
+    if (haveAvx2() && bins.size() > 1)
+    {
+        // Hash messages of similar size together so that fewer lanes run
+        // past the end of their message
+        std::vector<size_t> order(bins.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return bins[a].size() > bins[b].size();
+        });
+
+        Sha256Lane lanes[SHA256_LANES];
+        uint256* lanesOut[SHA256_LANES];
+        while (bins.size() - done > 1)
+        {
+            size_t const n = std::min(SHA256_LANES, bins.size() - done);
+            for (size_t l = 0; l < SHA256_LANES; ++l)
+            {
+                if (l < n)
+                {
+                    size_t const i = order[done + l];
+                    lanes[l].init(bins[i]);
+                    lanesOut[l] = &out[i];
+                }
+                else
+                {
+                    lanes[l] = Sha256Lane{};
+                    lanesOut[l] = nullptr;
+                }
+            }
+            sha256Lanes(lanes, lanesOut);
+            done += n;
+        }
+        if (done < bins.size())
+        {
+            // A single message is left, which is faster to hash on its own
+            size_t const i = order[done];
+            out[i] = sha256(bins[i]);
+        }
+        return out;
+    }
+#endif
+    for (; done < bins.size(); ++done)
+    {
+        out[done] = sha256(bins[done]);
+    }
+    return out;
+}
+
 SHA256::SHA256()
 {
     reset();
@@ -49,7 +413,36 @@ SHA256::add(ByteSlice const& bin)
     {
         throw std::runtime_error("adding bytes to finished SHA256");
     }
-    if (crypto_hash_sha256_update(&mState, bin.data(), bin.size()) != 0)
+    unsigned char const* data = bin.data();
+    size_t size = bin.size();
+#ifdef STELLAR_SHA256_SHANI
+    if (haveShaNi() && size >= SHA256_BLOCK)
+    {
+        // Whole blocks are hashed right into libsodium's state, the part
+        // of a block before and after them goes through libsodium's
+        // buffer as usual
+        size_t const buffered = (mState.count >> 3) % SHA256_BLOCK;
+        if (buffered != 0)
+        {
+            size_t const fill = SHA256_BLOCK - buffered;
+            if (crypto_hash_sha256_update(&mState, data, fill) != 0)
+            {
+                throw CryptoError("error from crypto_hash_sha256_update");
+            }
+            data += fill;
+            size -= fill;
+        }
+        size_t const blocks = size / SHA256_BLOCK;
+        if (blocks > 0)
+        {
+            sha256BlocksShaNi(mState.state, data, blocks);
+            mState.count += static_cast<uint64_t>(blocks) * SHA256_BLOCK * 8;
+            data += blocks * SHA256_BLOCK;
+            size -= blocks * SHA256_BLOCK;
+        }
+    }
+#endif
+    if (crypto_hash_sha256_update(&mState, data, size) != 0)
     {
         throw CryptoError("error from crypto_hash_sha256_update");
     }
@@ -7,8 +7,10 @@
 #include "crypto/ByteSlice.h"
 #include "crypto/XDRHasher.h"
 #include "sodium/crypto_hash_sha256.h"
+#include "util/GlobalChecks.h"
 #include "xdr/Stellar-types.h"
 #include <memory>
+#include <vector>
 
 namespace stellar
 {
@@ -16,6 +18,11 @@ namespace stellar
 // Plain SHA256
 uint256 sha256(ByteSlice const& bin);
 
+// SHA256 of each of `bins`, the same as calling sha256 on each of them. On
+// CPUs with AVX2 this hashes 8 messages at a time, which is much faster when
+// there are many small messages, such as the transactions of a set.
+std::vector<uint256> sha256Batch(std::vector<ByteSlice> const& bins);
+
 // SHA256 in incremental mode, for large inputs.
 class SHA256
 {
@@ -46,16 +53,58 @@ struct XDRSHA256 : XDRHasher<XDRSHA256>
 // NB: This is not an overload of `sha256` to avoid ambiguity when called
 // with xdrpp-provided types like opaque_vec, which will convert to a ByteSlice
 // if demanded, but can also be passed to XDRSHA256.
-template <typename T>
+//
+// Several objects are hashed one after the other, as xdr_to_opaque encodes
+// them, e.g. `xdrSha256(networkID, ENVELOPE_TYPE_TX, tx)`.
+template <typename... Args>
 uint256
-xdrSha256(T const& t)
+xdrSha256(Args const&... args)
 {
     XDRSHA256 xs;
-    xdr::archive(xs, t);
+    xdr::xdr_argpack_archive(xs, args...);
     xs.flush();
     return xs.state.finish();
 }
 
+// Helper for xdrSha256Add below, hashing into a SHA256 it doesn't own.
+struct XDRSHA256Into : XDRHasher<XDRSHA256Into>
+{
+    SHA256& state;
+    explicit XDRSHA256Into(SHA256& s) : state(s)
+    {
+    }
+    void
+    hashBytes(unsigned char const* bytes, size_t size)
+    {
+        state.add(ByteSlice(bytes, size));
+    }
+};
+
+// Equivalent to `hasher.add(xdr_to_opaque(args...))` but without allocating
+// a temporary buffer.
+template <typename... Args>
+void
+xdrSha256Add(SHA256& hasher, Args const&... args)
+{
+    XDRSHA256Into xs(hasher);
+    xdr::xdr_argpack_archive(xs, args...);
+    xs.flush();
+}
+
+// Sets `out` to `xdr_to_opaque(t)` and returns its SHA256, encoding `t` only
+// once, for callers that need both.
+template <typename T>
+uint256
+xdrSha256Encode(T const& t, xdr::opaque_vec<>& out)
+{
+    out.resize(xdr::xdr_size(t));
+    XDREncodingHasher<SHA256> xs(out.data());
+    xdr::archive(xs, t);
+    xs.flush();
+    releaseAssert(xs.mOut == out.data() + out.size());
+    return xs.mState.finish();
+}
+
 // HMAC-SHA256 (keyed)
 HmacSha256Mac hmacSha256(HmacSha256Key const& key, ByteSlice const& bin);
 
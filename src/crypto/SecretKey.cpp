@@ -15,12 +15,15 @@
 #include "util/GlobalChecks.h"
 #include "util/HashOfHash.h"
 #include "util/Math.h"
-#include "util/RandomEvictionCache.h"
-#include <Tracy.hpp>
+#include "util/ClockCache.h"
+#include "util/ConcurrentCache.h"
+#include "util/ZoneProfiler.h"
+#include <atomic>
 #include <chrono>
+#include <future>
 #include <memory>
-#include <mutex>
 #include <sodium.h>
+#include <thread>
 #include <type_traits>
 
 #ifdef MSAN_ENABLED
@@ -41,10 +44,31 @@ namespace stellar
 // makes all signature-verification in the program faster and
 // has no effect on correctness.
 
-static std::mutex gVerifySigCacheMutex;
-static RandomEvictionCache<Hash, bool> gVerifySigCache(0xffff);
-static uint64_t gVerifyCacheHit = 0;
-static uint64_t gVerifyCacheMiss = 0;
+//
+// The cache is split into shards, each behind its own lock, so threads
+// verifying signatures at the same time rarely wait on each other. Shards
+// evict with CLOCK, which draws no random numbers and so is safe to use from
+// any thread.
+
+static constexpr size_t VERIFY_SIG_CACHE_SHARDS = 16;
+
+using VerifySigCacheShard = ClockCache<Hash, bool>;
+
+static std::unique_ptr<VerifySigCacheShard>
+makeVerifySigCacheShard(size_t entries)
+{
+    return std::make_unique<VerifySigCacheShard>(
+        std::max<size_t>(1, (entries + VERIFY_SIG_CACHE_SHARDS - 1) /
+                                VERIFY_SIG_CACHE_SHARDS));
+}
+
+static ConcurrentCache<Hash, bool, VerifySigCacheShard> gVerifySigCache(
+    VERIFY_SIG_CACHE_SHARDS, []() {
+        return makeVerifySigCacheShard(
+            PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE);
+    });
+static std::atomic<uint64_t> gVerifyCacheHit{0};
+static std::atomic<uint64_t> gVerifyCacheMiss{0};
 
 static Hash
 verifySigCacheKey(PublicKey const& key, Signature const& signature,
@@ -190,7 +214,8 @@ struct SignVerifyTestcase
 
 void
 SecretKey::benchmarkOpsPerSecond(size_t& sign, size_t& verify,
-                                 size_t iterations, size_t cachedVerifyPasses)
+                                 size_t& batchVerify, size_t iterations,
+                                 size_t cachedVerifyPasses)
 {
     namespace ch = std::chrono;
     using clock = ch::high_resolution_clock;
@@ -225,11 +250,41 @@ SecretKey::benchmarkOpsPerSecond(size_t& sign, size_t& verify,
     }
     auto verifyEnd = clock::now();
 
+    std::vector<PubKeyUtils::VerifySigRequest> requests;
+    for (auto const& c : cases)
+    {
+        requests.emplace_back(
+            PubKeyUtils::VerifySigRequest{c.key.getPublicKey(), c.sig, c.msg});
+    }
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    PubKeyUtils::clearVerifySigCache();
+    auto batchStart = clock::now();
+    for (auto pass = 0; pass < cachedVerifyPasses; ++pass)
+    {
+        if (pass == 1)
+        {
+            batchStart = clock::now();
+        }
+        for (bool ok : PubKeyUtils::verifySigs(requests, threads))
+        {
+            if (!ok)
+            {
+                throw std::runtime_error("batch verify failed");
+            }
+        }
+    }
+    auto batchEnd = clock::now();
+
     auto signUsec = ch::duration_cast<usec>(signEnd - signStart);
     auto verifyUsec = ch::duration_cast<usec>(verifyEnd - verifyStart);
+    auto batchUsec = ch::duration_cast<usec>(batchEnd - batchStart);
     sign = 1000000 / std::max(size_t(1), size_t(signUsec.count() / iterations));
     verify =
         1000000 / std::max(size_t(1), size_t(verifyUsec.count() / iterations));
+    // Batches may verify faster than one per microsecond
+    batchVerify = static_cast<size_t>(
+        1000000.0 * iterations /
+        std::max<double>(1.0, static_cast<double>(batchUsec.count())));
 }
 
 #ifdef BUILD_TESTS
@@ -316,18 +371,36 @@ SecretKey::fromStrKeySeed(std::string const& strKeySeed)
 void
 PubKeyUtils::clearVerifySigCache()
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
     gVerifySigCache.clear();
 }
 
+size_t
+PubKeyUtils::getVerifySigCacheBytes()
+{
+    // Each result costs its key, the hashmap node and the slot of the
+    // ring
+    size_t const bytesPerEntry = 96;
+    return gVerifySigCache.size() * bytesPerEntry;
+}
+
+void
+PubKeyUtils::setVerifySigCacheSize(size_t entries)
+{
+    auto perShard = makeVerifySigCacheShard(entries)->maxSize();
+    if (gVerifySigCache.withShard(0, [](VerifySigCacheShard& cache) {
+            return cache.maxSize();
+        }) != perShard)
+    {
+        gVerifySigCache.reset(
+            [entries]() { return makeVerifySigCacheShard(entries); });
+    }
+}
+
 void
 PubKeyUtils::flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses)
 {
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-    hits = gVerifyCacheHit;
-    misses = gVerifyCacheMiss;
-    gVerifyCacheHit = 0;
-    gVerifyCacheMiss = 0;
+    hits = gVerifyCacheHit.exchange(0);
+    misses = gVerifyCacheMiss.exchange(0);
 }
 
 std::string
@@ -437,15 +510,12 @@ PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
 
     auto cacheKey = verifySigCacheKey(key, signature, bin);
 
+    if (auto cached = gVerifySigCache.maybeGet(cacheKey))
     {
-        std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
-        if (gVerifySigCache.exists(cacheKey))
-        {
-            ++gVerifyCacheHit;
-            std::string hitStr("hit");
-            ZoneText(hitStr.c_str(), hitStr.size());
-            return gVerifySigCache.get(cacheKey);
-        }
+        ++gVerifyCacheHit;
+        std::string hitStr("hit");
+        ZoneText(hitStr.c_str(), hitStr.size());
+        return *cached;
     }
 
     std::string missStr("miss");
@@ -453,12 +523,104 @@ PubKeyUtils::verifySig(PublicKey const& key, Signature const& signature,
     bool ok =
         (crypto_sign_verify_detached(signature.data(), bin.data(), bin.size(),
                                      key.ed25519().data()) == 0);
-    std::lock_guard<std::mutex> guard(gVerifySigCacheMutex);
     ++gVerifyCacheMiss;
     gVerifySigCache.put(cacheKey, ok);
     return ok;
 }
 
+std::vector<bool>
+PubKeyUtils::verifySigs(std::vector<VerifySigRequest> const& requests,
+                        size_t threads)
+{
+    ZoneScoped;
+    std::vector<bool> res(requests.size(), false);
+    std::vector<Hash> cacheKeys(requests.size());
+    std::vector<std::vector<size_t>> byShard(gVerifySigCache.shardCount());
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        auto const& req = requests[i];
+        releaseAssert(req.key.type() == PUBLIC_KEY_TYPE_ED25519);
+        if (req.signature.size() == 64)
+        {
+            cacheKeys[i] = verifySigCacheKey(req.key, req.signature, req.bin);
+            byShard[gVerifySigCache.shardOf(cacheKeys[i])].emplace_back(i);
+        }
+    }
+
+    std::vector<size_t> misses;
+    for (size_t s = 0; s < byShard.size(); ++s)
+    {
+        if (byShard[s].empty())
+        {
+            continue;
+        }
+        gVerifySigCache.withShard(s, [&](VerifySigCacheShard& cache) {
+            for (auto i : byShard[s])
+            {
+                if (auto* cached = cache.maybeGet(cacheKeys[i]))
+                {
+                    ++gVerifyCacheHit;
+                    res[i] = *cached;
+                }
+                else
+                {
+                    misses.emplace_back(i);
+                }
+            }
+        });
+    }
+
+    // Not a std::vector<bool>, which threads can't write to concurrently
+    std::vector<uint8_t> ok(misses.size(), 0);
+    auto verifyRange = [&](size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j)
+        {
+            auto const& req = requests[misses[j]];
+            ok[j] = crypto_sign_verify_detached(
+                        req.signature.data(), req.bin.data(), req.bin.size(),
+                        req.key.ed25519().data()) == 0;
+        }
+    };
+
+    // Below this many signatures per thread, starting a thread costs about
+    // as much as it saves
+    size_t const minPerThread = 16;
+    threads = std::max<size_t>(
+        1, std::min(threads, misses.size() / minPerThread));
+    size_t const chunk = (misses.size() + threads - 1) / threads;
+    std::vector<std::future<void>> workers;
+    for (size_t t = 1; t < threads; ++t)
+    {
+        size_t begin = t * chunk;
+        size_t end = std::min(misses.size(), begin + chunk);
+        workers.emplace_back(std::async(std::launch::async, verifyRange,
+                                        begin, end));
+    }
+    verifyRange(0, std::min(misses.size(), chunk));
+    for (auto& w : workers)
+    {
+        w.get();
+    }
+
+    // Misses were collected shard by shard, so each shard is locked once
+    gVerifyCacheMiss += misses.size();
+    size_t j = 0;
+    while (j < misses.size())
+    {
+        auto shard = gVerifySigCache.shardOf(cacheKeys[misses[j]]);
+        gVerifySigCache.withShard(shard, [&](VerifySigCacheShard& cache) {
+            for (; j < misses.size() &&
+                   gVerifySigCache.shardOf(cacheKeys[misses[j]]) == shard;
+                 ++j)
+            {
+                cache.put(cacheKeys[misses[j]], ok[j] != 0);
+                res[misses[j]] = ok[j] != 0;
+            }
+        });
+    }
+    return res;
+}
+
 PublicKey
 PubKeyUtils::random()
 {
@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/ByteSlice.h"
 #include "crypto/KeyUtils.h"
 #include "util/XDROperators.h"
 #include "xdr/Stellar-types.h"
@@ -11,11 +12,11 @@
 #include <array>
 #include <functional>
 #include <ostream>
+#include <vector>
 
 namespace stellar
 {
 
-class ByteSlice;
 struct SecretValue;
 struct SignerKey;
 
@@ -58,9 +59,11 @@ class SecretKey
     // Create a new, random secret key.
     static SecretKey random();
 
-    // Measure the speed of sign-and-verify ops.
+    // Measure the speed of sign-and-verify ops. `batchVerify` is the speed
+    // of verifying the same signatures with PubKeyUtils::verifySigs on all
+    // hardware threads, starting from an empty signature cache.
     static void benchmarkOpsPerSecond(size_t& sign, size_t& verify,
-                                      size_t iterations,
+                                      size_t& batchVerify, size_t iterations,
                                       size_t cachedVerifyPasses = 1);
 
 #ifdef BUILD_TESTS
@@ -139,7 +142,31 @@ namespace PubKeyUtils
 bool verifySig(PublicKey const& key, Signature const& signature,
                ByteSlice const& bin);
 
+// A signature to check with verifySigs. The bytes `bin` refers to must
+// outlive the call.
+struct VerifySigRequest
+{
+    PublicKey key;
+    Signature signature;
+    ByteSlice bin;
+};
+
+// Return, for each request, what verifySig would return for it. Each shard
+// of the signature cache is locked once to look up and once to update the
+// whole batch, and the signatures missing from it are verified on up to
+// `threads` threads (including the calling one).
+std::vector<bool> verifySigs(std::vector<VerifySigRequest> const& requests,
+                             size_t threads = 1);
+
+// Number of results the signature cache holds, across all threads, unless
+// changed with setVerifySigCacheSize
+constexpr size_t DEFAULT_VERIFY_SIG_CACHE_SIZE = 0xffff;
+
 void clearVerifySigCache();
+// Approximate number of bytes the signature cache holds
+size_t getVerifySigCacheBytes();
+// Resize the signature cache, emptying it unless the size is unchanged
+void setVerifySigCacheSize(size_t entries);
 void flushVerifySigCacheCounts(uint64_t& hits, uint64_t& misses);
 
 PublicKey random();
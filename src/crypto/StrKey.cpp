@@ -5,8 +5,11 @@
 #include "StrKey.h"
 #include "util/Decoder.h"
 #include "util/SecretValue.h"
+#include "util/ZoneProfiler.h"
 #include "util/crc16.h"
-#include <Tracy.hpp>
+
+#include <cstring>
+#include <vector>
 
 namespace stellar
 {
@@ -15,22 +18,39 @@ namespace strKey
 // Encode a version byte and ByteSlice into StrKey
 SecretValue
 toStrKey(uint8_t ver, ByteSlice const& bin)
+{
+    SecretValue res;
+    toStrKey(ver, bin, res.value);
+    return res;
+}
+
+void
+toStrKey(uint8_t ver, ByteSlice const& bin, std::string& out)
 {
     ZoneScoped;
-    ver <<= 3; // promote to 8 bits
-    std::vector<uint8_t> toEncode;
-    toEncode.reserve(1 + bin.size() + 2);
-    toEncode.emplace_back(ver);
-    toEncode.insert(toEncode.end(), bin.begin(), bin.end());
+    // Version, data and CRC, on the stack for all the keys but large signed
+    // payloads
+    unsigned char small[64];
+    std::vector<unsigned char> large;
+    size_t const size = 1 + bin.size() + 2;
+    unsigned char* toEncode = small;
+    if (size > sizeof(small))
+    {
+        large.resize(size);
+        toEncode = large.data();
+    }
+    toEncode[0] = static_cast<unsigned char>(ver << 3); // promote to 8 bits
+    if (!bin.empty())
+    {
+        std::memcpy(toEncode + 1, bin.data(), bin.size());
+    }
 
-    uint16_t crc = crc16((char*)toEncode.data(), (int)toEncode.size());
-    toEncode.emplace_back(static_cast<uint8_t>(crc & 0xFF));
-    crc >>= 8;
-    toEncode.emplace_back(static_cast<uint8_t>(crc & 0xFF));
+    uint16_t crc = crc16((char*)toEncode, (int)(size - 2));
+    toEncode[size - 2] = static_cast<unsigned char>(crc & 0xFF);
+    toEncode[size - 1] = static_cast<unsigned char>(crc >> 8);
 
-    std::string res;
-    res = decoder::encode_b32(toEncode);
-    return SecretValue{res};
+    out.resize(decoder::encoded_size32(size));
+    decoder::encode_b32(toEncode, size, out.data());
 }
 
 size_t
@@ -29,6 +29,9 @@ enum StrKeyVersionByte : uint8_t
 // Encode a version byte and ByteSlice into StrKey
 SecretValue toStrKey(uint8_t ver, ByteSlice const& bin);
 
+// Same, into `out`, whose capacity is reused when rendering many keys
+void toStrKey(uint8_t ver, ByteSlice const& bin, std::string& out);
+
 // computes the size of the StrKey that would result from encoding
 // a ByteSlice of dataSize bytes
 size_t getStrKeySize(size_t dataSize);
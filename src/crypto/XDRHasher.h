@@ -4,6 +4,8 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/ByteSlice.h"
+#include <cstring>
 #include <xdrpp/endian.h>
 #include <xdrpp/marshal.h>
 
@@ -102,4 +104,27 @@ template <typename Derived> struct XDRHasher
         xdr::xdr_traits<T>::save(*this, t);
     }
 };
+
+// Archiver hashing XDR with `Hasher` (such as SHA256 or BLAKE2) while copying
+// it to a buffer, for callers that need both an object's encoding and its
+// hash: the object is walked once, and the bytes are hashed while they are
+// still in cache. `mOut` must point to at least xdr_size of what is archived.
+template <typename Hasher>
+struct XDREncodingHasher : XDRHasher<XDREncodingHasher<Hasher>>
+{
+    Hasher mState;
+    unsigned char* mOut;
+
+    explicit XDREncodingHasher(unsigned char* out) : mOut(out)
+    {
+    }
+
+    void
+    hashBytes(unsigned char const* bytes, size_t size)
+    {
+        std::memcpy(mOut, bytes, size);
+        mOut += size;
+        mState.add(ByteSlice(bytes, size));
+    }
+};
 }
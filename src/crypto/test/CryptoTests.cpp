@@ -13,14 +13,18 @@
 #include "crypto/StrKey.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
+#include "test/MicroBenchmark.h"
 #include "test/test.h"
 #include "util/Logging.h"
 #include "xdr/Stellar-types.h"
+#include <algorithm>
+#include <atomic>
 #include <autocheck/autocheck.hpp>
 #include <map>
 #include <regex>
 #include <sodium.h>
 #include <stdexcept>
+#include <thread>
 
 using namespace stellar;
 
@@ -72,6 +76,21 @@ TEST_CASE("hex tests", "[crypto]")
         20);
 }
 
+TEST_CASE("hex encoding matches sodium", "[crypto]")
+{
+    std::string reused;
+    for (size_t size = 0; size < 100; ++size)
+    {
+        auto bytes = randomBytes(size);
+        std::vector<char> expected(size * 2 + 1);
+        sodium_bin2hex(expected.data(), expected.size(), bytes.data(),
+                       bytes.size());
+        CHECK(binToHex(bytes) == expected.data());
+        binToHex(bytes, reused);
+        CHECK(reused == expected.data());
+    }
+}
+
 static std::map<std::string, std::string> sha256TestVectors = {
     {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
 
@@ -109,6 +128,24 @@ TEST_CASE("Stateful SHA256 tests", "[crypto]")
     }
 }
 
+TEST_CASE("Stateful SHA256 in pieces is identical to SHA256", "[crypto]")
+{
+    // Pieces that start and end at every offset in a block, and that cover
+    // many blocks at once
+    auto message = randomBytes(10000);
+    auto expected = sha256(message);
+    for (size_t piece : {1, 3, 63, 64, 65, 200, 4096, 10000})
+    {
+        SHA256 h;
+        for (size_t i = 0; i < message.size(); i += piece)
+        {
+            h.add(ByteSlice(message.data() + i,
+                            std::min(piece, message.size() - i)));
+        }
+        CHECK(h.finish() == expected);
+    }
+}
+
 TEST_CASE("XDRSHA256 is identical to byte SHA256", "[crypto]")
 {
     for (size_t i = 0; i < 1000; ++i)
@@ -120,6 +157,67 @@ TEST_CASE("XDRSHA256 is identical to byte SHA256", "[crypto]")
     }
 }
 
+TEST_CASE("streamed XDR hashes match hashes of the encoding", "[crypto]")
+{
+    Hash networkID = sha256("network");
+    for (size_t i = 0; i < 100; ++i)
+    {
+        auto entry = LedgerTestUtils::generateValidLedgerEntry(100);
+        auto bytes = xdr::xdr_to_opaque(entry);
+
+        // Several objects, as xdr_to_opaque packs them
+        CHECK(xdrSha256(networkID, ENVELOPE_TYPE_TX, entry) ==
+              sha256(xdr::xdr_to_opaque(networkID, ENVELOPE_TYPE_TX, entry)));
+
+        SHA256 streamed;
+        SHA256 copied;
+        streamed.add(networkID);
+        copied.add(networkID);
+        xdrSha256Add(streamed, entry);
+        copied.add(bytes);
+        CHECK(streamed.finish() == copied.finish());
+
+        xdr::opaque_vec<> encoding;
+        CHECK(xdrSha256Encode(entry, encoding) == sha256(bytes));
+        CHECK(encoding == bytes);
+        CHECK(xdrBlake2Encode(entry, encoding) == blake2(bytes));
+        CHECK(encoding == bytes);
+    }
+}
+
+TEST_CASE("batch SHA256 is identical to SHA256", "[crypto]")
+{
+    // Messages of every size around the padding boundaries, in batches that
+    // don't fill the last group of lanes
+    for (size_t count : {0, 1, 2, 7, 8, 9, 17, 100})
+    {
+        std::vector<std::vector<uint8_t>> messages;
+        for (size_t i = 0; i < count; ++i)
+        {
+            messages.emplace_back(randomBytes((i * 37) % 200));
+        }
+        std::vector<ByteSlice> bins(messages.begin(), messages.end());
+        auto hashes = sha256Batch(bins);
+        REQUIRE(hashes.size() == count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            CHECK(hashes[i] == sha256(messages[i]));
+        }
+    }
+
+    std::vector<ByteSlice> vectors;
+    for (auto const& pair : sha256TestVectors)
+    {
+        vectors.emplace_back(pair.first);
+    }
+    auto hashes = sha256Batch(vectors);
+    size_t i = 0;
+    for (auto const& pair : sha256TestVectors)
+    {
+        CHECK(binToHex(hashes[i++]) == pair.second);
+    }
+}
+
 TEST_CASE("SHA256 bytes bench", "[!hide][sha-bytes-bench]")
 {
     shortHash::initialize();
@@ -296,23 +394,236 @@ TEST_CASE("sign tests", "[crypto]")
     CHECK(!PubKeyUtils::verifySig(pk, sig, msg));
 }
 
+TEST_CASE("batch verify matches single verify", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    std::vector<SecretKey> keys;
+    std::vector<std::string> msgs;
+    for (int i = 0; i < 100; ++i)
+    {
+        keys.emplace_back(SecretKey::pseudoRandomForTesting());
+        msgs.emplace_back("message " + std::to_string(i));
+    }
+
+    std::vector<PubKeyUtils::VerifySigRequest> requests;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        auto sig = keys[i].sign(msgs[i]);
+        // Corrupt every third signature, and truncate one of them
+        if (i % 3 == 0)
+        {
+            sig[4] ^= 1;
+        }
+        if (i == 30)
+        {
+            sig.resize(63);
+        }
+        requests.emplace_back(PubKeyUtils::VerifySigRequest{
+            keys[i].getPublicKey(), sig, msgs[i]});
+    }
+
+    auto check = [&](std::vector<bool> const& res) {
+        REQUIRE(res.size() == requests.size());
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            REQUIRE(res[i] == (i % 3 != 0));
+        }
+    };
+
+    SECTION("single thread")
+    {
+        check(PubKeyUtils::verifySigs(requests));
+    }
+    SECTION("several threads")
+    {
+        check(PubKeyUtils::verifySigs(requests, 4));
+    }
+
+    // The results are cached for verifySig and later batches
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        auto const& req = requests[i];
+        REQUIRE(PubKeyUtils::verifySig(req.key, req.signature, req.bin) ==
+                (i % 3 != 0));
+    }
+    check(PubKeyUtils::verifySigs(requests, 4));
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(misses == 0);
+    REQUIRE(hits == 2 * (requests.size() - 1));
+}
+
+TEST_CASE("signature cache is sharded and resizable", "[crypto]")
+{
+    PubKeyUtils::clearVerifySigCache();
+    std::vector<PubKeyUtils::VerifySigRequest> requests;
+    std::vector<std::string> msgs(200);
+    for (size_t i = 0; i < msgs.size(); ++i)
+    {
+        auto sk = SecretKey::pseudoRandomForTesting();
+        msgs[i] = "message " + std::to_string(i);
+        requests.emplace_back(PubKeyUtils::VerifySigRequest{
+            sk.getPublicKey(), sk.sign(msgs[i]), msgs[i]});
+    }
+    uint64_t hits, misses;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+
+    SECTION("concurrent verification")
+    {
+        // Catch assertions are not thread-safe
+        std::atomic<size_t> failures{0};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&]() {
+                for (auto const& req : requests)
+                {
+                    if (!PubKeyUtils::verifySig(req.key, req.signature,
+                                                req.bin))
+                    {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        REQUIRE(failures == 0);
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(hits + misses == 4 * requests.size());
+        REQUIRE(misses >= requests.size());
+    }
+
+    SECTION("small cache evicts")
+    {
+        // One entry per shard
+        PubKeyUtils::setVerifySigCacheSize(16);
+        PubKeyUtils::verifySigs(requests);
+        PubKeyUtils::verifySigs(requests);
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses > requests.size());
+        PubKeyUtils::setVerifySigCacheSize(
+            PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE);
+
+        PubKeyUtils::verifySigs(requests);
+        PubKeyUtils::verifySigs(requests);
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+        REQUIRE(misses == requests.size());
+        REQUIRE(hits == requests.size());
+    }
+}
+
 TEST_CASE("sign and verify benchmarking", "[crypto-bench][bench][!hide]")
 {
-    size_t signPerSec = 0, verifyPerSec = 0;
+    size_t signPerSec = 0, verifyPerSec = 0, batchVerifyPerSec = 0;
     LOG_INFO(DEFAULT_LOG, "Benchmarking signatures and verifications");
-    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec, 10000);
+    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec,
+                                     batchVerifyPerSec, 10000);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} signatures / sec", signPerSec);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} verifications / sec", verifyPerSec);
+    LOG_INFO(DEFAULT_LOG, "Benchmarked {} batched verifications / sec",
+             batchVerifyPerSec);
 }
 
 TEST_CASE("verify-hit benchmarking", "[crypto-bench][bench][!hide]")
 {
-    size_t signPerSec = 0, verifyPerSec = 0;
+    size_t signPerSec = 0, verifyPerSec = 0, batchVerifyPerSec = 0;
     LOG_INFO(DEFAULT_LOG, "Benchmarking signatures and verify cache-hits");
-    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec, 10000, 10);
+    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec,
+                                     batchVerifyPerSec, 10000, 10);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} signatures / sec", signPerSec);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} verification cache-hits / sec",
              verifyPerSec);
+    LOG_INFO(DEFAULT_LOG,
+             "Benchmarked {} batched verification cache-hits / sec",
+             batchVerifyPerSec);
+}
+
+TEST_CASE("ed25519 verify microbench", "[crypto][microbench][bench][!hide]")
+{
+    struct Signed
+    {
+        PublicKey mKey;
+        Signature mSig;
+        std::vector<uint8_t> mMsg;
+    };
+    std::vector<Signed> signedMsgs;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        auto sk = SecretKey::pseudoRandomForTesting();
+        auto msg = randomBytes(256);
+        signedMsgs.emplace_back(Signed{sk.getPublicKey(), sk.sign(msg), msg});
+    }
+    auto verifyAll = [&]() {
+        for (auto const& s : signedMsgs)
+        {
+            if (!PubKeyUtils::verifySig(s.mKey, s.mSig, s.mMsg))
+            {
+                throw std::runtime_error("verify failed");
+            }
+        }
+        return signedMsgs.size();
+    };
+
+    // Each shard of the cache only remembers the last signature it saw,
+    // which is almost never the next one
+    PubKeyUtils::setVerifySigCacheSize(1);
+    runMicroBenchmark("ed25519.verify", verifyAll);
+    PubKeyUtils::setVerifySigCacheSize(
+        PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE);
+    runMicroBenchmark("ed25519.verify-cached", verifyAll);
+}
+
+TEST_CASE("sha256 microbench", "[crypto][microbench][bench][!hide]")
+{
+    auto bytes = randomBytes(1024);
+    auto entry = LedgerTestUtils::generateValidLedgerEntry();
+    uint8_t sink = 0;
+    runMicroBenchmark("sha256.1k", [&]() {
+        size_t const batch = 1000;
+        for (size_t i = 0; i < batch; ++i)
+        {
+            sink ^= sha256(bytes)[0];
+        }
+        return batch;
+    });
+    runMicroBenchmark("xdrsha256.ledger-entry", [&]() {
+        size_t const batch = 1000;
+        for (size_t i = 0; i < batch; ++i)
+        {
+            sink ^= xdrSha256(entry)[0];
+        }
+        return batch;
+    });
+    LOG_DEBUG(DEFAULT_LOG, "sha256 microbench sink {}", sink);
+}
+
+TEST_CASE("strkey and hex microbench", "[crypto][microbench][bench][!hide]")
+{
+    auto key = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto hash = sha256("microbench");
+    size_t const batch = 1000;
+    size_t sink = 0;
+    runMicroBenchmark("strkey.public-key", [&]() {
+        for (size_t i = 0; i < batch; ++i)
+        {
+            sink += KeyUtils::toStrKey(key).size();
+        }
+        return batch;
+    });
+    runMicroBenchmark("hex.hash", [&]() {
+        std::string out;
+        for (size_t i = 0; i < batch; ++i)
+        {
+            binToHex(hash, out);
+            sink += out.size();
+        }
+        return batch;
+    });
+    LOG_DEBUG(DEFAULT_LOG, "strkey microbench sink {}", sink);
 }
 
 TEST_CASE("StrKey tests", "[crypto]")
@@ -0,0 +1,160 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/BulkInsertOperation.h"
+#include "ledger/LedgerTxnImpl.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+
+namespace stellar
+{
+
+BulkInsertOperation::BulkInsertOperation(Database& db,
+                                         std::string const& table,
+                                         std::string const& onConflict,
+                                         soci::session* sess)
+    : mDB(db)
+    , mSession(sess)
+    , mTable(table)
+    , mOnConflict(onConflict.empty() ? "" : " " + onConflict)
+{
+}
+
+void
+BulkInsertOperation::addColumn(std::string const& name,
+                               std::vector<std::string> const& values)
+{
+    releaseAssert(mColumns.empty() || numRows() == values.size());
+    mColumns.push_back({name, &values, nullptr});
+}
+
+void
+BulkInsertOperation::addColumn(std::string const& name,
+                               std::vector<int32_t> const& values)
+{
+    releaseAssert(mColumns.empty() || numRows() == values.size());
+    mColumns.push_back({name, nullptr, &values});
+}
+
+size_t
+BulkInsertOperation::numRows() const
+{
+    auto const& first = mColumns.at(0);
+    return first.mText ? first.mText->size() : first.mInts->size();
+}
+
+std::string
+BulkInsertOperation::columnNames() const
+{
+    std::string names;
+    for (auto const& column : mColumns)
+    {
+        names += (names.empty() ? "" : ", ") + column.mName;
+    }
+    return names;
+}
+
+StatementContext
+BulkInsertOperation::prepare(std::string const& sql)
+{
+    if (!mSession)
+    {
+        return mDB.getPreparedStatement(sql);
+    }
+    auto st = std::make_shared<soci::statement>(*mSession);
+    st->alloc();
+    st->prepare(sql);
+    return StatementContext(st);
+}
+
+void
+BulkInsertOperation::execute(soci::statement& st)
+{
+    if (mSession)
+    {
+        // Database's timers are only for the main thread
+        st.execute(true);
+    }
+    else if (mOnConflict.empty())
+    {
+        auto timer = mDB.getInsertTimer(mTable);
+        st.execute(true);
+    }
+    else
+    {
+        auto timer = mDB.getUpsertTimer(mTable);
+        st.execute(true);
+    }
+}
+
+size_t
+BulkInsertOperation::doSqliteSpecificOperation(
+    soci::sqlite3_session_backend* sq)
+{
+    ZoneScoped;
+    releaseAssert(!mColumns.empty());
+    std::string values;
+    for (size_t i = 0; i < mColumns.size(); ++i)
+    {
+        values += (i == 0 ? ":v" : ", :v") + std::to_string(i);
+    }
+    auto prep = prepare("INSERT INTO " + mTable + " (" + columnNames() +
+                        ") VALUES (" + values + ")" + mOnConflict);
+    auto& st = prep.statement();
+    for (auto const& column : mColumns)
+    {
+        if (column.mText)
+        {
+            st.exchange(soci::use(*column.mText));
+        }
+        else
+        {
+            st.exchange(soci::use(*column.mInts));
+        }
+    }
+    st.define_and_bind();
+    execute(st);
+    return static_cast<size_t>(st.get_affected_rows());
+}
+
+#ifdef USE_POSTGRES
+size_t
+BulkInsertOperation::doPostgresSpecificOperation(
+    soci::postgresql_session_backend* pg)
+{
+    ZoneScoped;
+    releaseAssert(!mColumns.empty());
+    std::vector<std::string> arrays(mColumns.size());
+    std::string unnests;
+    std::string selected;
+    for (size_t i = 0; i < mColumns.size(); ++i)
+    {
+        auto const& column = mColumns[i];
+        if (column.mText)
+        {
+            marshalToPGArray(pg->conn_, arrays[i], *column.mText);
+        }
+        else
+        {
+            marshalToPGArray(pg->conn_, arrays[i], *column.mInts);
+        }
+        auto n = std::to_string(i);
+        unnests += (i == 0 ? "" : ", ") + std::string("unnest(:v") + n +
+                   (column.mText ? "::TEXT[]" : "::INT[]") + ") AS c" + n;
+        selected += (i == 0 ? "c" : ", c") + n;
+    }
+    auto prep = prepare("WITH r AS (SELECT " + unnests + ") INSERT INTO " +
+                        mTable + " (" + columnNames() + ") SELECT " +
+                        selected + " FROM r" + mOnConflict);
+    auto& st = prep.statement();
+    for (auto const& array : arrays)
+    {
+        st.exchange(soci::use(array));
+    }
+    st.define_and_bind();
+    execute(st);
+    return static_cast<size_t>(st.get_affected_rows());
+}
+#endif
+}
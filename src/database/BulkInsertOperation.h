@@ -0,0 +1,67 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "database/Database.h"
+#include "database/DatabaseTypeSpecificOperation.h"
+
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// Inserts a batch of rows into a table with a single statement. On postgres
+// every column is sent as one array and unnested by the server, so the batch
+// costs one round trip instead of one per row. On sqlite there are no round
+// trips to save and the columns are bound as vectors, as usual.
+//
+// Columns are added one at a time, each with one value per row. The vectors
+// are not copied and must outlive the operation. Returns the number of rows
+// inserted or updated. On the main session the statement is timed by the
+// "insert" database timer for the table, or by the "upsert" one when an ON
+// CONFLICT clause is given.
+class BulkInsertOperation : public DatabaseTypeSpecificOperation<size_t>
+{
+    struct Column
+    {
+        std::string mName;
+        std::vector<std::string> const* mText;
+        std::vector<int32_t> const* mInts;
+    };
+
+    Database& mDB;
+    // Set when inserting through another session than the main one
+    soci::session* const mSession;
+    std::string const mTable;
+    std::string const mOnConflict;
+    std::vector<Column> mColumns;
+
+    size_t numRows() const;
+    std::string columnNames() const;
+    StatementContext prepare(std::string const& sql);
+    void execute(soci::statement& st);
+
+  public:
+    // `onConflict` is appended to the statement as is, e.g.
+    // "ON CONFLICT (id) DO UPDATE SET v = excluded.v". `sess`, when given, is
+    // a session other than db's main one that the operation runs on, from any
+    // thread.
+    BulkInsertOperation(Database& db, std::string const& table,
+                        std::string const& onConflict = "",
+                        soci::session* sess = nullptr);
+
+    void addColumn(std::string const& name,
+                   std::vector<std::string> const& values);
+    void addColumn(std::string const& name, std::vector<int32_t> const& values);
+
+    size_t
+    doSqliteSpecificOperation(soci::sqlite3_session_backend* sq) override;
+#ifdef USE_POSTGRES
+    size_t
+    doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override;
+#endif
+};
+}
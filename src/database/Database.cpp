@@ -15,6 +15,7 @@
 #include "util/Logging.h"
 #include "util/Timer.h"
 #include "util/types.h"
+#include <algorithm>
 #include <error.h>
 #include <fmt/format.h>
 
@@ -63,7 +64,7 @@ bool Database::gDriversRegistered = false;
 
 // smallest schema version supported
 static unsigned long const MIN_SCHEMA_VERSION = 21;
-static unsigned long const SCHEMA_VERSION = 21;
+static unsigned long const SCHEMA_VERSION = 22;
 
 // These should always match our compiled version precisely, since we are
 // using a bundled version to get access to carray(). But in case someone
@@ -185,6 +186,10 @@ Database::Database(Application& app)
     : mApp(app)
     , mQueryMeter(
           app.getMetrics().NewMeter({"database", "query", "exec"}, "query"))
+    , mReadOnlyWaitTimer(
+          app.getMetrics().NewTimer({"database", "read-only-session", "wait"}))
+    , mReadOnlyBorrowed(app.getMetrics().NewCounter(
+          {"database", "read-only-session", "borrowed"}))
     , mStatementsSize(
           app.getMetrics().NewCounter({"database", "memory", "statements"}))
 {
@@ -213,10 +218,8 @@ Database::applySchemaUpgrade(unsigned long vers)
     switch (vers)
     {
     case 22:
-        // Add schema upgrades for version 21 -> 22 here.
-        // Currently, this is empty as the schema is already at version 21 and
-        // there are no upgrades to apply. However, this case is left here to
-        // allow for future upgrades to be added.
+        // The publish queue moved from the publishqueue table to files
+        HistoryManager::migratePublishQueue(*this, mApp.getConfig());
         break;
     default:
         throw std::runtime_error("Unknown DB schema version");
@@ -381,6 +384,16 @@ Database::getUpsertTimer(std::string const& entityName)
         .TimeScope();
 }
 
+medida::TimerContext
+Database::getCopyTimer(std::string const& entityName)
+{
+    mEntityTypes.insert(entityName);
+    mQueryMeter.Mark();
+    return mApp.getMetrics()
+        .NewTimer({"database", "copy", entityName})
+        .TimeScope();
+}
+
 void
 Database::setCurrentTransactionReadOnly()
 {
@@ -393,6 +406,22 @@ Database::setCurrentTransactionReadOnly()
     }
 }
 
+void
+Database::setSynchronousCommits(bool synchronous)
+{
+    if (isSqlite())
+    {
+        // FULL is the default, see DatabaseConfigureSessionOp
+        mSession << (synchronous ? "PRAGMA synchronous = FULL"
+                                 : "PRAGMA synchronous = NORMAL");
+    }
+    else
+    {
+        mSession << (synchronous ? "SET synchronous_commit = on"
+                                 : "SET synchronous_commit = off");
+    }
+}
+
 bool
 Database::isSqlite() const
 {
@@ -523,6 +552,150 @@ Database::getPool()
     return *mPool;
 }
 
+void
+Database::openReadOnlySession(soci::session& sess)
+{
+    auto const& c = mApp.getConfig().DATABASE;
+    LOG_DEBUG(DEFAULT_LOG, "Opening read-only session to: {}",
+              removePasswordFromConnectionString(c.value));
+    sess.open(c.value);
+    DatabaseConfigureSessionOp op(sess);
+    stellar::doDatabaseTypeSpecificOperation(sess, op);
+    if (isSqlite())
+    {
+        sess << "PRAGMA query_only = ON";
+    }
+}
+
+ReadOnlySession
+Database::getReadOnlySession()
+{
+    if (!canUsePool())
+    {
+        std::string s("Can't open read-only sessions to ");
+        s += removePasswordFromConnectionString(
+            mApp.getConfig().DATABASE.value);
+        throw std::runtime_error(s);
+    }
+
+    size_t maxSessions =
+        std::max(1, static_cast<int>(mApp.getConfig().WORKER_THREADS));
+    soci::session* sess = nullptr;
+    bool mustOpen = false;
+    {
+        auto timer = mReadOnlyWaitTimer.TimeScope();
+        std::unique_lock<std::mutex> lock(mReadOnlyMutex);
+        mReadOnlyCond.wait(lock, [&] {
+            return !mIdleReadOnlySessions.empty() ||
+                   mReadOnlySessions.size() < maxSessions;
+        });
+        if (!mIdleReadOnlySessions.empty())
+        {
+            sess = mIdleReadOnlySessions.back();
+            mIdleReadOnlySessions.pop_back();
+        }
+        else
+        {
+            mReadOnlySessions.emplace_back(std::make_unique<soci::session>());
+            sess = mReadOnlySessions.back().get();
+            mustOpen = true;
+        }
+        mReadOnlyBorrowed.inc();
+    }
+
+    // Connect outside of the lock, other threads can borrow the open sessions
+    // meanwhile
+    try
+    {
+        if (mustOpen)
+        {
+            openReadOnlySession(*sess);
+        }
+        return ReadOnlySession(*this, *sess);
+    }
+    catch (...)
+    {
+        releaseReadOnlySession(*sess, /*discard=*/true);
+        throw;
+    }
+}
+
+void
+Database::releaseReadOnlySession(soci::session& sess, bool discard)
+{
+    {
+        std::lock_guard<std::mutex> lock(mReadOnlyMutex);
+        if (discard)
+        {
+            // The next borrow opens a new session in its place
+            auto it = std::find_if(
+                mReadOnlySessions.begin(), mReadOnlySessions.end(),
+                [&](auto const& s) { return s.get() == &sess; });
+            releaseAssert(it != mReadOnlySessions.end());
+            mReadOnlySessions.erase(it);
+        }
+        else
+        {
+            mIdleReadOnlySessions.emplace_back(&sess);
+        }
+        mReadOnlyBorrowed.dec();
+    }
+    mReadOnlyCond.notify_one();
+}
+
+ReadOnlySession::ReadOnlySession(Database& db, soci::session& sess)
+    : mDatabase(&db), mSession(&sess)
+{
+    // REPEATABLE READ takes the snapshot at the first query of the
+    // transaction in Postgresql, as does a deferred transaction in SQLite, so
+    // query right away to see the database as of now.
+    if (db.isSqlite())
+    {
+        sess << "BEGIN";
+    }
+    else
+    {
+        sess << "BEGIN TRANSACTION ISOLATION LEVEL REPEATABLE READ READ ONLY";
+    }
+    soci::indicator ind;
+    sess << "SELECT state FROM storestate WHERE statename = "
+            "'lastclosedledger'",
+        soci::into(mLastClosedLedgerHash, ind);
+    if (!sess.got_data() || ind != soci::i_ok)
+    {
+        mLastClosedLedgerHash.clear();
+    }
+}
+
+ReadOnlySession::ReadOnlySession(ReadOnlySession&& other)
+    : mDatabase(other.mDatabase)
+    , mSession(other.mSession)
+    , mLastClosedLedgerHash(std::move(other.mLastClosedLedgerHash))
+{
+    other.mDatabase = nullptr;
+    other.mSession = nullptr;
+}
+
+ReadOnlySession::~ReadOnlySession()
+{
+    if (!mSession)
+    {
+        return;
+    }
+    try
+    {
+        *mSession << "ROLLBACK";
+        mDatabase->releaseReadOnlySession(*mSession);
+    }
+    catch (std::exception& e)
+    {
+        // Drop the session rather than lending it with an open transaction
+        CLOG_ERROR(Database, "Failed to end read-only transaction: {}",
+                   e.what());
+        mDatabase->releaseReadOnlySession(*mSession, /*discard=*/true);
+    }
+}
+
 class SQLLogContext : NonCopyable
 {
     std::string mName;
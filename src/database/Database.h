@@ -10,7 +10,9 @@
 #include "util/Decoder.h"
 #include "util/NonCopyable.h"
 #include "util/Timer.h"
+#include <condition_variable>
 #include <functional>
+#include <mutex>
 #include <set>
 #include <soci.h>
 #include <string>
@@ -20,11 +22,13 @@ namespace medida
 {
 class Meter;
 class Counter;
+class Timer;
 }
 
 namespace stellar
 {
 class Application;
+class Database;
 class SQLLogContext;
 
 /**
@@ -60,6 +64,41 @@ class StatementContext : NonCopyable
     }
 };
 
+/**
+ * Helper class for borrowing one of the Database's read-only sessions into a
+ * local scope. Returned by Database::getReadOnlySession below.
+ *
+ * The session is in a read transaction for as long as it is borrowed, so all
+ * the queries made through it see the database as it was at the last commit
+ * before it was borrowed -- that is, at the last ledger closed by then --
+ * whatever the main connection commits meanwhile.
+ */
+class ReadOnlySession : NonCopyable
+{
+    Database* mDatabase;
+    soci::session* mSession;
+    std::string mLastClosedLedgerHash;
+
+  public:
+    ReadOnlySession(Database& db, soci::session& sess);
+    ReadOnlySession(ReadOnlySession&& other);
+    ~ReadOnlySession();
+
+    soci::session&
+    session()
+    {
+        return *mSession;
+    }
+
+    // Hex hash of the last closed ledger the session sees, empty if the
+    // database doesn't have one yet.
+    std::string const&
+    getLastClosedLedgerHash() const
+    {
+        return mLastClosedLedgerHash;
+    }
+};
+
 /**
  * Object that owns the database connection(s) that an application
  * uses to store the current ledger and other persistent state in.
@@ -80,6 +119,12 @@ class StatementContext : NonCopyable
  * pool will connect to the same target and only one connection will be made per
  * worker thread.
  *
+ * Database also keeps a pool of read-only sessions, opened as they are first
+ * needed and at most one per worker thread, that any thread can borrow with
+ * getReadOnlySession to query the last closed ledger. With SQLite these rely
+ * on WAL mode to read while the main connection writes, so, like the connection
+ * pool, they aren't available for in-memory databases.
+ *
  * All database connections and transactions are set to snapshot isolation level
  * (SQL isolation level 'SERIALIZABLE' in Postgresql and Sqlite, neither of
  * which provide true serializability).
@@ -91,6 +136,15 @@ class Database : NonMovableOrCopyable
     soci::session mSession;
     std::unique_ptr<soci::connection_pool> mPool;
 
+    std::mutex mReadOnlyMutex;
+    std::condition_variable mReadOnlyCond;
+    // All read-only sessions opened, or being opened, and the ones not
+    // borrowed
+    std::vector<std::unique_ptr<soci::session>> mReadOnlySessions;
+    std::vector<soci::session*> mIdleReadOnlySessions;
+    medida::Timer& mReadOnlyWaitTimer;
+    medida::Counter& mReadOnlyBorrowed;
+
     std::map<std::string, std::shared_ptr<soci::statement>> mStatements;
     medida::Counter& mStatementsSize;
 
@@ -100,6 +154,10 @@ class Database : NonMovableOrCopyable
     static void registerDrivers();
     void applySchemaUpgrade(unsigned long vers);
     void open();
+    void openReadOnlySession(soci::session& sess);
+    void releaseReadOnlySession(soci::session& sess, bool discard = false);
+
+    friend class ReadOnlySession;
 
   public:
     // Instantiate object and connect to app.getConfig().DATABASE;
@@ -133,12 +191,20 @@ class Database : NonMovableOrCopyable
     medida::TimerContext getDeleteTimer(std::string const& entityName);
     medida::TimerContext getUpdateTimer(std::string const& entityName);
     medida::TimerContext getUpsertTimer(std::string const& entityName);
+    medida::TimerContext getCopyTimer(std::string const& entityName);
 
     // If possible (i.e. "on postgres") issue an SQL pragma that marks
     // the current transaction as read-only. The effects of this last
     // only as long as the current SQL transaction.
     void setCurrentTransactionReadOnly();
 
+    // Whether commits on the main session wait for the database to make
+    // them durable, as they do by default. Commits that don't are still
+    // atomic and visible, but can be lost, along with those after them, if
+    // the machine (or, on PostgreSQL, the server) crashes; the next one that
+    // does makes them all durable.
+    void setSynchronousCommits(bool synchronous);
+
     // Return true if the Database target is SQLite, otherwise false.
     bool isSqlite() const;
 
@@ -181,6 +247,11 @@ class Database : NonMovableOrCopyable
     // Access the optional SOCI connection pool available for worker
     // threads. Throws an error if !canUsePool().
     soci::connection_pool& getPool();
+
+    // Borrow a read-only session, from any thread, waiting for one to be
+    // returned if all of them are borrowed. A thread must not borrow a second
+    // session while it holds one. Throws an error if !canUsePool().
+    ReadOnlySession getReadOnlySession();
 };
 
 template <typename T>
@@ -8,7 +8,7 @@ namespace stellar
 {
 namespace DatabaseUtils
 {
-void
+uint64_t
 deleteOldEntriesHelper(soci::session& sess, uint32_t ledgerSeq, uint32_t count,
                        std::string const& tableName,
                        std::string const& ledgerSeqColumn)
@@ -26,9 +26,13 @@ deleteOldEntriesHelper(soci::session& sess, uint32_t ledgerSeq, uint32_t count,
             std::min<uint64>(static_cast<uint64>(curMin) + count, ledgerSeq);
         // safe to cast down as it's at most ledgerSeq
         uint64 m = static_cast<uint32>(m64);
-        sess << "DELETE FROM " << tableName << " WHERE " << ledgerSeqColumn
-             << " <= " << m;
+        soci::statement del =
+            (sess.prepare << "DELETE FROM " << tableName << " WHERE "
+                          << ledgerSeqColumn << " <= " << m);
+        del.execute(true);
+        return static_cast<uint64_t>(del.get_affected_rows());
     }
+    return 0;
 }
 
 void
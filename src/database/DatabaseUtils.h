@@ -10,9 +10,11 @@ namespace stellar
 {
 namespace DatabaseUtils
 {
-void deleteOldEntriesHelper(soci::session& sess, uint32_t ledgerSeq,
-                            uint32_t count, std::string const& tableName,
-                            std::string const& ledgerSeqColumn);
+// Deletes the rows of at most `count` ledgers, the oldest, up to `ledgerSeq`
+// included, and returns the number of rows deleted
+uint64_t deleteOldEntriesHelper(soci::session& sess, uint32_t ledgerSeq,
+                                uint32_t count, std::string const& tableName,
+                                std::string const& ledgerSeqColumn);
 
 void deleteNewerEntriesHelper(soci::session& sess, uint32_t ledgerSeq,
                               std::string const& tableName,
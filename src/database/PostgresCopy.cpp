@@ -0,0 +1,241 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_POSTGRES
+#include "database/PostgresCopy.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <stdexcept>
+
+namespace stellar
+{
+
+namespace
+{
+// Rows are handed to libpq in chunks of about this many bytes
+constexpr size_t COPY_CHUNK_SIZE = 1024 * 1024;
+
+std::string
+joinColumns(std::vector<std::string> const& columns)
+{
+    std::string res;
+    for (auto const& c : columns)
+    {
+        if (!res.empty())
+        {
+            res += ", ";
+        }
+        res += c;
+    }
+    return res;
+}
+
+// Collects the results of a finished COPY, returning the first error message
+// (or an empty string if there was none)
+std::string
+drainCopyResults(PGconn* conn)
+{
+    std::string error;
+    while (PGresult* res = PQgetResult(conn))
+    {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK && error.empty())
+        {
+            error = PQresultErrorMessage(res);
+            if (error.empty())
+            {
+                error = "unknown error";
+            }
+        }
+        PQclear(res);
+    }
+    return error;
+}
+}
+
+PostgresCopyUpsert::PostgresCopyUpsert(
+    std::string const& table, std::vector<std::string> const& conflictColumns)
+    : mTable(table), mConflictColumns(conflictColumns)
+{
+    releaseAssert(!mConflictColumns.empty());
+}
+
+std::string
+PostgresCopyUpsert::encode(std::string const& item)
+{
+    std::string res;
+    res.reserve(item.size());
+    for (char c : item)
+    {
+        switch (c)
+        {
+        case '\\':
+            res += "\\\\";
+            break;
+        case '\t':
+            res += "\\t";
+            break;
+        case '\n':
+            res += "\\n";
+            break;
+        case '\r':
+            res += "\\r";
+            break;
+        default:
+            res += c;
+        }
+    }
+    return res;
+}
+
+void
+PostgresCopyUpsert::addEncodedColumn(std::string const& name,
+                                     std::vector<std::string>&& cells)
+{
+    if (!mCells.empty() && mCells.front().size() != cells.size())
+    {
+        throw std::runtime_error(
+            fmt::format("column {} of {} has {} rows instead of {}", name,
+                        mTable, cells.size(), mCells.front().size()));
+    }
+    mColumns.emplace_back(name);
+    mCells.emplace_back(std::move(cells));
+}
+
+void
+PostgresCopyUpsert::copyRows(PGconn* conn, std::string const& sql) const
+{
+    PGresult* res = PQexec(conn, sql.c_str());
+    auto status = PQresultStatus(res);
+    std::string error = PQresultErrorMessage(res);
+    PQclear(res);
+    if (status != PGRES_COPY_IN)
+    {
+        drainCopyResults(conn);
+        throw std::runtime_error(
+            fmt::format("Could not start COPY into {}: {}", mTable, error));
+    }
+
+    try
+    {
+        std::string buf;
+        buf.reserve(COPY_CHUNK_SIZE);
+        auto flush = [&]() {
+            auto size = static_cast<int>(buf.size());
+            if (PQputCopyData(conn, buf.data(), size) != 1)
+            {
+                throw std::runtime_error(
+                    fmt::format("Could not send COPY data for {}: {}", mTable,
+                                PQerrorMessage(conn)));
+            }
+            buf.clear();
+        };
+
+        size_t const rows = mCells.front().size();
+        for (size_t row = 0; row < rows; ++row)
+        {
+            for (size_t col = 0; col < mCells.size(); ++col)
+            {
+                if (col > 0)
+                {
+                    buf += '\t';
+                }
+                buf += mCells[col][row];
+            }
+            buf += '\n';
+            if (buf.size() >= COPY_CHUNK_SIZE)
+            {
+                flush();
+            }
+        }
+        if (!buf.empty())
+        {
+            flush();
+        }
+    }
+    catch (...)
+    {
+        // Leave the connection usable; the transaction is aborted anyway
+        PQputCopyEnd(conn, "aborted by client");
+        drainCopyResults(conn);
+        throw;
+    }
+
+    if (PQputCopyEnd(conn, nullptr) != 1)
+    {
+        drainCopyResults(conn);
+        throw std::runtime_error(fmt::format("Could not end COPY into {}: {}",
+                                             mTable, PQerrorMessage(conn)));
+    }
+    error = drainCopyResults(conn);
+    if (!error.empty())
+    {
+        throw std::runtime_error(
+            fmt::format("COPY into {} failed: {}", mTable, error));
+    }
+}
+
+size_t
+PostgresCopyUpsert::execute(Database& db, PGconn* conn,
+                            std::string const& entityName)
+{
+    ZoneScoped;
+    releaseAssert(!mColumns.empty());
+
+    // The temporary table lives as long as the connection and is emptied at
+    // the end of every transaction, but may still hold the rows of an earlier
+    // batch from the current one.
+    std::string const tmpTable = "copy_" + mTable;
+    int missing = 0;
+    db.getSession() << "SELECT CASE WHEN to_regclass('pg_temp." << tmpTable
+                    << "') IS NULL THEN 1 ELSE 0 END",
+        soci::into(missing);
+    if (missing)
+    {
+        db.getSession() << "CREATE TEMP TABLE " << tmpTable << " (LIKE "
+                        << mTable << ") ON COMMIT DELETE ROWS";
+    }
+    else
+    {
+        db.getSession() << "TRUNCATE " << tmpTable;
+    }
+
+    auto const columns = joinColumns(mColumns);
+    {
+        auto timer = db.getCopyTimer(entityName);
+        copyRows(conn, "COPY " + tmpTable + " (" + columns + ") FROM STDIN");
+    }
+
+    std::string updates;
+    for (auto const& c : mColumns)
+    {
+        if (std::find(mConflictColumns.begin(), mConflictColumns.end(), c) !=
+            mConflictColumns.end())
+        {
+            continue;
+        }
+        if (!updates.empty())
+        {
+            updates += ", ";
+        }
+        updates += c + " = excluded." + c;
+    }
+
+    std::string sql = "INSERT INTO " + mTable + " (" + columns + ") SELECT " +
+                      columns + " FROM " + tmpTable + " ON CONFLICT (" +
+                      joinColumns(mConflictColumns) + ") DO UPDATE SET " +
+                      updates;
+    auto prep = db.getPreparedStatement(sql);
+    soci::statement& st = prep.statement();
+    st.define_and_bind();
+    {
+        auto timer = db.getUpsertTimer(entityName);
+        st.execute(true);
+    }
+    return static_cast<size_t>(st.get_affected_rows());
+}
+}
+#endif
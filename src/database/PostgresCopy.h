@@ -0,0 +1,87 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_POSTGRES
+#include "database/Database.h"
+#include <lib/soci/src/backends/postgresql/soci-postgresql.h>
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// Upserts a batch of rows by streaming them with COPY ... FROM STDIN into a
+// temporary table with the layout of the target table, then merging that into
+// the target table with a single INSERT ... ON CONFLICT DO UPDATE statement.
+// Rows travel in COPY's text format instead of as one array literal per
+// column, which the server would otherwise have to parse again and unnest.
+//
+// Columns are added one at a time, each with one value per row, in the same
+// way values are bound for the unnest-based upserts. Every column that is not
+// a conflict column is overwritten on conflict.
+class PostgresCopyUpsert
+{
+    std::string const mTable;
+    std::vector<std::string> const mConflictColumns;
+    std::vector<std::string> mColumns;
+    // Values in COPY text format, one vector per column
+    std::vector<std::vector<std::string>> mCells;
+
+    template <typename T>
+    static std::string
+    encode(T const& item)
+    {
+        // As in marshalToPGArrayItem, max_digits10 ensures a double is
+        // reconstructed exactly on the postgres side
+        std::ostringstream oss;
+        oss << std::setprecision(std::numeric_limits<T>::max_digits10)
+            << item;
+        return oss.str();
+    }
+
+    static std::string encode(std::string const& item);
+
+    void addEncodedColumn(std::string const& name,
+                          std::vector<std::string>&& cells);
+
+    void copyRows(PGconn* conn, std::string const& sql) const;
+
+  public:
+    PostgresCopyUpsert(std::string const& table,
+                       std::vector<std::string> const& conflictColumns);
+
+    template <typename T>
+    void
+    addColumn(std::string const& name, std::vector<T> const& values,
+              std::vector<soci::indicator> const* ind = nullptr)
+    {
+        std::vector<std::string> cells;
+        cells.reserve(values.size());
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            if (ind && (*ind)[i] == soci::i_null)
+            {
+                cells.emplace_back("\\N");
+            }
+            else
+            {
+                cells.emplace_back(encode(values[i]));
+            }
+        }
+        addEncodedColumn(name, std::move(cells));
+    }
+
+    // Returns the number of rows inserted or updated. The transfer and the
+    // merge are timed separately, by the "copy" and "upsert" database timers
+    // for entityName.
+    size_t execute(Database& db, PGconn* conn, std::string const& entityName);
+};
+}
+#endif
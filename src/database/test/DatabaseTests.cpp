@@ -6,6 +6,7 @@
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
 #include "database/Database.h"
+#include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
@@ -20,8 +21,10 @@
 #include "util/Timer.h"
 #include "util/TmpDir.h"
 #include <algorithm>
+#include <future>
 #include <optional>
 #include <random>
+#include <thread>
 
 using namespace stellar;
 
@@ -207,6 +210,77 @@ TEST_CASE("sqlite MVCC test", "[db]")
     checkMVCCIsolation(app);
 }
 
+TEST_CASE("read-only sessions", "[db]")
+{
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    cfg.WORKER_THREADS = 2;
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg, true, false);
+    auto& db = app->getDatabase();
+    auto& sess = db.getSession();
+    sess << "DROP TABLE IF EXISTS test";
+    sess << "CREATE TABLE test (x INTEGER)";
+    sess << "INSERT INTO test (x) VALUES (1)";
+
+    auto selectX = [](soci::session& s) {
+        int x = 0;
+        s << "SELECT x FROM test", soci::into(x);
+        return x;
+    };
+
+    SECTION("see the last commit before they were borrowed")
+    {
+        auto lcl = app->getLedgerManager().getLastClosedLedgerHeader();
+        auto ro = db.getReadOnlySession();
+        CHECK(ro.getLastClosedLedgerHash() == binToHex(lcl.hash));
+        CHECK(selectX(ro.session()) == 1);
+
+        sess << "UPDATE test SET x = 2";
+        CHECK(selectX(ro.session()) == 1);
+        CHECK(selectX(db.getReadOnlySession().session()) == 2);
+    }
+
+    SECTION("can't write")
+    {
+        auto ro = db.getReadOnlySession();
+        REQUIRE_THROWS_AS(ro.session() << "UPDATE test SET x = 3",
+                          soci::soci_error);
+    }
+
+    SECTION("are shared by worker threads")
+    {
+        auto ro1 = std::make_optional(db.getReadOnlySession());
+        auto ro2 = std::async(std::launch::async, [&] {
+                       return selectX(db.getReadOnlySession().session());
+                   }).get();
+        CHECK(ro2 == 1);
+
+        // ro1 is still borrowed, so these take turns with the other session
+        std::thread t1([&] {
+            auto ro3 = db.getReadOnlySession();
+            CHECK(selectX(ro3.session()) == 1);
+        });
+        std::thread t2([&] {
+            auto ro4 = db.getReadOnlySession();
+            CHECK(selectX(ro4.session()) == 1);
+        });
+        t1.join();
+        ro1.reset();
+        t2.join();
+    }
+
+    sess << "DROP TABLE test";
+}
+
+TEST_CASE("read-only sessions need an on-disk database", "[db]")
+{
+    Config const& cfg = getTestConfig(0, Config::TESTDB_IN_MEMORY_SQLITE);
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, cfg, true, false);
+    REQUIRE_THROWS_AS(app->getDatabase().getReadOnlySession(),
+                      std::runtime_error);
+}
+
 #ifdef USE_POSTGRES
 TEST_CASE("postgres smoketest", "[db]")
 {
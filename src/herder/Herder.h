@@ -136,6 +136,10 @@ class Herder
 
     virtual bool isTracking() const = 0;
 
+    // When this node is due to nominate the next ledger, if it is
+    virtual std::optional<VirtualClock::time_point>
+    getNextNominationTime() const = 0;
+
 #ifdef BUILD_TESTS
     // We are learning about a new fully-fetched envelope.
     virtual EnvelopeStatus recvSCPEnvelope(SCPEnvelope const& envelope,
@@ -186,6 +190,11 @@ class Herder
                                    bool forceTrackingSCP) = 0;
     virtual void setInSyncAndTriggerNextLedger() = 0;
 
+    // Builds the tx set that this node would nominate now from its
+    // transaction queues, along with its close time. Unlike nomination, this
+    // doesn't ban the invalid transactions.
+    virtual std::pair<TxSetXDRFrameConstPtr, uint64_t> makeCandidateTxSet() = 0;
+
     // lookup a nodeID in config and in SCP messages
     virtual bool resolveNodeID(std::string const& s, PublicKey& retKey) = 0;
 
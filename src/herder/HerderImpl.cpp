@@ -30,8 +30,11 @@
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include "util/MemoryAttribution.h"
 #include "util/StatusManager.h"
 #include "util/Timer.h"
+#include "util/UnorderedMap.h"
+#include "util/ZoneProfiler.h"
 
 #include "medida/counter.h"
 #include "medida/meter.h"
@@ -41,7 +44,6 @@
 #include "xdr/Stellar-internal.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/types.h"
-#include <Tracy.hpp>
 
 #include "util/GlobalChecks.h"
 #include <algorithm>
@@ -546,6 +548,7 @@ TransactionQueue::AddResult
 HerderImpl::recvTransaction(TransactionFrameBasePtr tx, bool submittedFromSelf)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Herder);
     TransactionQueue::AddResult result;
 
     // Allow txs of the same kind to reach the tx queue in case it can be
@@ -713,6 +716,7 @@ Herder::EnvelopeStatus
 HerderImpl::recvSCPEnvelope(SCPEnvelope const& envelope)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Herder);
     if (mApp.getConfig().MANUAL_CLOSE)
     {
         return Herder::ENVELOPE_STATUS_DISCARDED;
@@ -1260,6 +1264,16 @@ HerderImpl::getMostRecentCheckpointSeq()
         lastIndex);
 }
 
+std::optional<VirtualClock::time_point>
+HerderImpl::getNextNominationTime() const
+{
+    if (mTriggerTimer.seq() == 0 || mApp.getConfig().MANUAL_CLOSE)
+    {
+        return std::nullopt;
+    }
+    return mTriggerTimer.expiry_time();
+}
+
 void
 HerderImpl::setInSyncAndTriggerNextLedger()
 {
@@ -1284,27 +1298,29 @@ HerderImpl::setInSyncAndTriggerNextLedger()
     triggerNextLedger(lcl + 1, false);
 }
 
-// called to take a position during the next round
-// uses the state in LedgerManager to derive a starting position
-void
-HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
-                              bool checkTrackingSCP)
+uint64_t
+HerderImpl::getNextCloseTime(LedgerHeaderHistoryEntry const& lcl) const
 {
-    ZoneScoped;
-    ZoneValue(static_cast<int64_t>(ledgerSeqToTrigger));
-
-    auto isTrackingValid = isTracking() || !checkTrackingSCP;
-
-    if (!isTrackingValid || !mLedgerManager.isSynced())
+    // We pick as next close time the current time unless it's before the last
+    // close time. We don't know how much time it will take to reach consensus
+    // so this is the most appropriate value to use as closeTime.
+    uint64_t nextCloseTime =
+        VirtualClock::to_time_t(mApp.getClock().system_now());
+    if (nextCloseTime <= lcl.header.scpValue.closeTime)
     {
-        CLOG_DEBUG(Herder, "triggerNextLedger: skipping (out of sync) : {}",
-                   mApp.getStateHuman());
-        return;
+        nextCloseTime = lcl.header.scpValue.closeTime + 1;
     }
+    return nextCloseTime;
+}
 
+TxSetXDRFrameConstPtr
+HerderImpl::makeTxSetFromQueues(LedgerHeaderHistoryEntry const& lcl,
+                                uint64_t closeTime,
+                                TxSetPhaseTransactions& invalidTxPhases)
+{
+    ZoneScoped;
     // our first choice for this round's set is all the tx we have collected
     // during last few ledger closes
-    auto const& lcl = mLedgerManager.getLastClosedLedgerHeader();
     TxSetPhaseTransactions txPhases;
     txPhases.emplace_back(mTransactionQueue.getTransactions(lcl.header));
 
@@ -1316,16 +1332,54 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
             mSorobanTransactionQueue->getTransactions(lcl.header));
     }
 
-    // We pick as next close time the current time unless it's before the last
-    // close time. We don't know how much time it will take to reach consensus
-    // so this is the most appropriate value to use as closeTime.
-    uint64_t nextCloseTime =
-        VirtualClock::to_time_t(mApp.getClock().system_now());
-    if (nextCloseTime <= lcl.header.scpValue.closeTime)
+    // Protocols including the "closetime change" (CAP-0034) externalize
+    // the exact closeTime contained in the StellarValue with the best
+    // transaction set, so we know the exact closeTime against which to
+    // validate here -- 'closeTime'.  (The _offset_, therefore, is
+    // the difference between 'closeTime' and the last ledger close time.)
+    TimePoint upperBoundCloseTimeOffset, lowerBoundCloseTimeOffset;
+    upperBoundCloseTimeOffset = closeTime - lcl.header.scpValue.closeTime;
+    lowerBoundCloseTimeOffset = upperBoundCloseTimeOffset;
+
+    invalidTxPhases.clear();
+    invalidTxPhases.resize(txPhases.size());
+
+    return makeTxSetFromTransactions(txPhases, mApp, lowerBoundCloseTimeOffset,
+                                     upperBoundCloseTimeOffset, invalidTxPhases)
+        .first;
+}
+
+std::pair<TxSetXDRFrameConstPtr, uint64_t>
+HerderImpl::makeCandidateTxSet()
+{
+    auto const& lcl = mLedgerManager.getLastClosedLedgerHeader();
+    auto closeTime = getNextCloseTime(lcl);
+    TxSetPhaseTransactions invalidTxPhases;
+    return std::make_pair(makeTxSetFromQueues(lcl, closeTime, invalidTxPhases),
+                          closeTime);
+}
+
+// called to take a position during the next round
+// uses the state in LedgerManager to derive a starting position
+void
+HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
+                              bool checkTrackingSCP)
+{
+    ZoneScoped;
+    ZoneValue(static_cast<int64_t>(ledgerSeqToTrigger));
+
+    auto isTrackingValid = isTracking() || !checkTrackingSCP;
+
+    if (!isTrackingValid || !mLedgerManager.isSynced())
     {
-        nextCloseTime = lcl.header.scpValue.closeTime + 1;
+        CLOG_DEBUG(Herder, "triggerNextLedger: skipping (out of sync) : {}",
+                   mApp.getStateHuman());
+        return;
     }
 
+    auto const& lcl = mLedgerManager.getLastClosedLedgerHeader();
+    uint64_t nextCloseTime = getNextCloseTime(lcl);
+
     // Ensure we're about to nominate a value with valid close time
     auto isCtValid =
         ctValidityOffset(nextCloseTime) == std::chrono::milliseconds::zero();
@@ -1338,21 +1392,8 @@ HerderImpl::triggerNextLedger(uint32_t ledgerSeqToTrigger,
         return;
     }
 
-    // Protocols including the "closetime change" (CAP-0034) externalize
-    // the exact closeTime contained in the StellarValue with the best
-    // transaction set, so we know the exact closeTime against which to
-    // validate here -- 'nextCloseTime'.  (The _offset_, therefore, is
-    // the difference between 'nextCloseTime' and the last ledger close time.)
-    TimePoint upperBoundCloseTimeOffset, lowerBoundCloseTimeOffset;
-    upperBoundCloseTimeOffset = nextCloseTime - lcl.header.scpValue.closeTime;
-    lowerBoundCloseTimeOffset = upperBoundCloseTimeOffset;
-
     TxSetPhaseTransactions invalidTxPhases;
-    invalidTxPhases.resize(txPhases.size());
-
-    auto [proposedSet, applicableProposedSet] =
-        makeTxSetFromTransactions(txPhases, mApp, lowerBoundCloseTimeOffset,
-                                  upperBoundCloseTimeOffset, invalidTxPhases);
+    auto proposedSet = makeTxSetFromQueues(lcl, nextCloseTime, invalidTxPhases);
 
     if (protocolVersionStartsFrom(lcl.header.ledgerVersion,
                                   SOROBAN_PROTOCOL_VERSION))
@@ -1513,10 +1554,40 @@ HerderImpl::getJsonInfo(size_t limit, bool fullKeys)
     return ret;
 }
 
+namespace
+{
+// Names of nodes as quorum JSON renders them, computed once per node for the
+// whole rendering, as the same validators show up in many quorum sets
+class NodeNames
+{
+    Config const& mConfig;
+    bool const mFullKeys;
+    UnorderedMap<NodeID, std::string> mNames;
+
+  public:
+    NodeNames(Config const& config, bool fullKeys)
+        : mConfig(config), mFullKeys(fullKeys)
+    {
+    }
+
+    std::string const&
+    operator()(NodeID const& id)
+    {
+        auto it = mNames.find(id);
+        if (it == mNames.end())
+        {
+            it = mNames.emplace(id, mConfig.toStrKey(id, mFullKeys)).first;
+        }
+        return it->second;
+    }
+};
+}
+
 Json::Value
 HerderImpl::getJsonTransitiveQuorumIntersectionInfo(bool fullKeys) const
 {
     Json::Value ret;
+    NodeNames names(mApp.getConfig(), fullKeys);
     ret["intersection"] =
         mLastQuorumMapIntersectionState.enjoysQuorunIntersection();
     ret["node_count"] =
@@ -1532,8 +1603,7 @@ HerderImpl::getJsonTransitiveQuorumIntersectionInfo(bool fullKeys) const
             Json::Value jg;
             for (auto const& k : group)
             {
-                auto s = mApp.getConfig().toStrKey(k, fullKeys);
-                jg.append(s);
+                jg.append(names(k));
             }
             critical.append(jg);
         }
@@ -1547,13 +1617,11 @@ HerderImpl::getJsonTransitiveQuorumIntersectionInfo(bool fullKeys) const
         auto const& pair = mLastQuorumMapIntersectionState.mPotentialSplit;
         for (auto const& k : pair.first)
         {
-            auto s = mApp.getConfig().toStrKey(k, fullKeys);
-            a.append(s);
+            a.append(names(k));
         }
         for (auto const& k : pair.second)
         {
-            auto s = mApp.getConfig().toStrKey(k, fullKeys);
-            b.append(s);
+            b.append(names(k));
         }
         split.append(a);
         split.append(b);
@@ -1599,6 +1667,7 @@ HerderImpl::getJsonTransitiveQuorumInfo(NodeID const& rootID, bool summary,
     }
 
     Json::Value& nodes = ret["nodes"];
+    NodeNames names(mApp.getConfig(), fullKeys);
 
     auto& q = mPendingEnvelopes.getCurrentlyTrackedQuorum();
 
@@ -1621,7 +1690,7 @@ HerderImpl::getJsonTransitiveQuorumInfo(NodeID const& rootID, bool summary,
         {
             Json::Value cur;
             valGenID++;
-            cur["node"] = mApp.getConfig().toStrKey(id, fullKeys);
+            cur["node"] = names(id);
             if (!summary)
             {
                 cur["distance"] = distance;
@@ -1635,8 +1704,8 @@ HerderImpl::getJsonTransitiveQuorumInfo(NodeID const& rootID, bool summary,
                 {
                     if (!summary)
                     {
-                        cur["qset"] =
-                            getSCP().getLocalNode()->toJson(*qSet, fullKeys);
+                        cur["qset"] = LocalNode::toJson(
+                            *qSet, [&](NodeID const& n) { return names(n); });
                     }
                     LocalNode::forAllNodes(*qSet, [&](NodeID const& n) {
                         auto b = visited.emplace(n);
@@ -1727,10 +1796,10 @@ getQmapHash(QuorumTracker::QuorumMap const& qmap)
                                                           qmap.end());
     for (auto const& pair : ordered_map)
     {
-        hasher.add(xdr::xdr_to_opaque(pair.first));
+        xdrSha256Add(hasher, pair.first);
         if (pair.second.mQuorumSet)
         {
-            hasher.add(xdr::xdr_to_opaque(*(pair.second.mQuorumSet)));
+            xdrSha256Add(hasher, *(pair.second.mQuorumSet));
         }
         else
         {
@@ -1791,6 +1860,8 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
         auto seed = gRandomEngine();
         auto qic = QuorumIntersectionChecker::create(
             qmap, cfg, mLastQuorumMapIntersectionState.mInterruptFlag, seed);
+        qic->setPriorScanResult(
+            mLastQuorumMapIntersectionState.mLastScanResult);
         auto ledger = trackingConsensusLedgerIndex();
         auto nNodes = qmap.size();
         auto& hState = mLastQuorumMapIntersectionState;
@@ -1802,6 +1873,7 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
                 ZoneScoped;
                 bool ok = qic->networkEnjoysQuorumIntersection();
                 auto split = qic->getPotentialSplit();
+                auto scan = qic->getScanResult();
                 std::set<std::set<PublicKey>> critical;
                 if (ok)
                 {
@@ -1813,7 +1885,8 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
                             qmap, cfg, hState.mInterruptFlag, seed);
                 }
                 app.postOnMainThread(
-                    [ok, curr, ledger, nNodes, split, critical, &hState] {
+                    [ok, curr, ledger, nNodes, split, critical, scan,
+                     &hState] {
                         hState.mRecalculating = false;
                         hState.mInterruptFlag = false;
                         hState.mNumNodes = nNodes;
@@ -1822,6 +1895,7 @@ HerderImpl::checkAndMaybeReanalyzeQuorumMap()
                         hState.mCheckingQuorumMapHash = Hash{};
                         hState.mPotentialSplit = split;
                         hState.mIntersectionCriticalNodes = critical;
+                        hState.mLastScanResult = scan;
                         if (ok)
                         {
                             hState.mLastGoodLedger = ledger;
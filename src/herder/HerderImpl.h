@@ -7,6 +7,7 @@
 #include "herder/Herder.h"
 #include "herder/HerderSCPDriver.h"
 #include "herder/PendingEnvelopes.h"
+#include "herder/QuorumIntersectionChecker.h"
 #include "herder/TransactionQueue.h"
 #include "herder/Upgrades.h"
 #include "util/Timer.h"
@@ -88,6 +89,9 @@ class HerderImpl : public Herder
         return mState == State::HERDER_TRACKING_NETWORK_STATE;
     }
 
+    std::optional<VirtualClock::time_point>
+    getNextNominationTime() const override;
+
     void processExternalized(uint64 slotIndex, StellarValue const& value,
                              bool isLatestSlot);
     void valueExternalized(uint64 slotIndex, StellarValue const& value,
@@ -167,6 +171,8 @@ class HerderImpl : public Herder
 
     void setInSyncAndTriggerNextLedger() override;
 
+    std::pair<TxSetXDRFrameConstPtr, uint64_t> makeCandidateTxSet() override;
+
     void setUpgrades(Upgrades::UpgradeParameters const& upgrades) override;
     std::string getUpgradesJson() override;
 
@@ -228,6 +234,15 @@ class HerderImpl : public Herder
 
     void setupTriggerNextLedger();
 
+    uint64_t getNextCloseTime(LedgerHeaderHistoryEntry const& lcl) const;
+    // Builds the tx set to nominate with `closeTime` from the transaction
+    // queues. `invalidTxPhases` is set to the transactions left out of it as
+    // invalid.
+    TxSetXDRFrameConstPtr
+    makeTxSetFromQueues(LedgerHeaderHistoryEntry const& lcl,
+                        uint64_t closeTime,
+                        TxSetPhaseTransactions& invalidTxPhases);
+
     void startOutOfSyncTimer();
     void outOfSyncRecovery();
     void broadcast(SCPEnvelope const& e);
@@ -327,6 +342,10 @@ class HerderImpl : public Herder
         std::pair<std::vector<PublicKey>, std::vector<PublicKey>>
             mPotentialSplit{};
         std::set<std::set<PublicKey>> mIntersectionCriticalNodes{};
+        // Scan of the last completed check, which the next check reuses if
+        // the quorum map only changed outside of the SCC it scanned.
+        std::shared_ptr<QuorumIntersectionChecker::ScanResult const>
+            mLastScanResult{};
 
         bool
         hasAnyResults() const
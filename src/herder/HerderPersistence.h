@@ -36,10 +36,17 @@ class HerderPersistence
                                 std::vector<SCPEnvelope> const& envs,
                                 QuorumTracker::QuorumMap const& qmap) = 0;
 
-    static size_t copySCPHistoryToStream(Database& db, soci::session& sess,
-                                         uint32_t ledgerSeq,
-                                         uint32_t ledgerCount,
-                                         XDROutputFileStream& scpHistory);
+    // Writes the SCP messages of the given ledgers and the quorum sets they
+    // refer to. May be called from a background thread, with its own session.
+    virtual size_t copySCPHistoryToStream(Database& db, soci::session& sess,
+                                          uint32_t ledgerSeq,
+                                          uint32_t ledgerCount,
+                                          XDROutputFileStream& scpHistory) = 0;
+
+    // SCP messages saved for the ledger, ordered by node
+    virtual std::vector<SCPEnvelope> getSCPHistory(soci::session& sess,
+                                                   uint32_t ledgerSeq) = 0;
+
     // quorum information lookup
     static std::optional<Hash>
     getNodeQuorumSet(Database& db, soci::session& sess, NodeID const& nodeID);
@@ -47,9 +54,10 @@ class HerderPersistence
                                         Hash const& qSetHash);
 
     static void dropAll(Database& db);
-    static void deleteOldEntries(Database& db, uint32_t ledgerSeq,
-                                 uint32_t count);
-    static void deleteNewerEntries(Database& db, uint32_t ledgerSeq);
+    // Returns the number of rows deleted
+    virtual uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                      uint32_t count) = 0;
+    virtual void deleteNewerEntries(Database& db, uint32_t ledgerSeq) = 0;
 
     static void createQuorumTrackingTable(soci::session& sess);
 };
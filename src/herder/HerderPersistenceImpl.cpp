@@ -4,15 +4,19 @@
 
 #include "herder/HerderPersistenceImpl.h"
 #include "crypto/Hex.h"
+#include "database/BulkInsertOperation.h"
 #include "database/Database.h"
 #include "database/DatabaseUtils.h"
 #include "herder/Herder.h"
+#include "history/HistoryManager.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "scp/Slot.h"
 #include "util/Decoder.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
+#include <algorithm>
 #include <optional>
 #include <soci.h>
 #include <xdrpp/marshal.h>
@@ -26,7 +30,12 @@ HerderPersistence::create(Application& app)
     return std::make_unique<HerderPersistenceImpl>(app);
 }
 
-HerderPersistenceImpl::HerderPersistenceImpl(Application& app) : mApp(app)
+HerderPersistenceImpl::HerderPersistenceImpl(Application& app)
+    : mApp(app)
+    , mLog(app.getClock().getIOContext(),
+           app.getConfig().BUCKET_DIR_PATH + "/scp-history",
+           app.getHistoryManager().getCheckpointFrequency(),
+           !app.getConfig().DISABLE_XDR_FSYNC)
 {
 }
 
@@ -48,67 +57,24 @@ HerderPersistenceImpl::saveSCPHistory(uint32_t seq,
     auto usedQSets = UnorderedMap<Hash, SCPQuorumSetPtr>{};
     auto& db = mApp.getDatabase();
 
-    soci::transaction txscope(db.getSession());
-
-    {
-        auto prepClean = db.getPreparedStatement(
-            "DELETE FROM scphistory WHERE ledgerseq =:l");
-
-        auto& st = prepClean.statement();
-        st.exchange(soci::use(seq));
-        st.define_and_bind();
-        {
-            ZoneNamedN(deleteSCPHistoryZone, "delete scphistory", true);
-            st.execute(true);
-        }
-    }
-
-    // Prepare multi-row insert into scphistory
-    std::vector<std::string> nodeIDs;
-    std::vector<uint32_t> seqs;
-    std::vector<std::string> envelopes;
     for (auto const& e : envs)
     {
         auto const& qHash =
             Slot::getCompanionQuorumSetHashFromStatement(e.statement);
         usedQSets.insert(
             std::make_pair(qHash, mApp.getHerder().getQSet(qHash)));
-
-        std::string nodeIDStrKey = KeyUtils::toStrKey(e.statement.nodeID);
-
-        auto envelopeBytes(xdr::xdr_to_opaque(e));
-
-        std::string envelopeEncoded;
-        envelopeEncoded = decoder::encode_b64(envelopeBytes);
-
-        nodeIDs.push_back(nodeIDStrKey);
-        seqs.push_back(seq);
-        envelopes.push_back(envelopeEncoded);
     }
 
-    if (!envs.empty())
     {
-        // Perform multi-row insert into scphistory
-        auto prepEnv =
-            db.getPreparedStatement("INSERT INTO scphistory "
-                                    "(nodeid, ledgerseq, envelope) VALUES "
-                                    "(:n, :l, :e)");
-        auto& st = prepEnv.statement();
-        st.exchange(soci::use(nodeIDs, "n"));
-        st.exchange(soci::use(seqs, "l"));
-        st.exchange(soci::use(envelopes, "e"));
-        st.define_and_bind();
-        {
-            ZoneNamedN(insertSCPHistoryZone, "insert scphistory", true);
-            st.execute(true);
-        }
-        if (st.get_affected_rows() != envs.size())
-        {
-            throw std::runtime_error("Could not update data in SQL");
-        }
+        ZoneNamedN(appendSCPHistoryZone, "append scp history", true);
+        mLog.append(seq, envs);
     }
 
+    soci::transaction txscope(db.getSession());
+
     // save quorum information
+    std::vector<std::string> nodeIDs;
+    std::vector<std::string> nodeQSetHashes;
     for (auto const& p : qmap)
     {
         auto const& nodeID = p.first;
@@ -120,125 +86,135 @@ HerderPersistenceImpl::saveSCPHistory(uint32_t seq,
         auto qSetH = xdrSha256(*(p.second.mQuorumSet));
         usedQSets.insert(std::make_pair(qSetH, p.second.mQuorumSet));
 
-        std::string nodeIDStrKey = KeyUtils::toStrKey(nodeID);
-        std::string qSetHHex(binToHex(qSetH));
+        nodeIDs.emplace_back(KeyUtils::toStrKey(nodeID));
+        nodeQSetHashes.emplace_back(binToHex(qSetH));
+    }
+    if (!nodeIDs.empty())
+    {
+        ZoneNamedN(upsertQsetZone, "upsert quoruminfo", true);
+        BulkInsertOperation op(db, "quoruminfo",
+                               "ON CONFLICT (nodeid) DO UPDATE SET "
+                               "qsethash = excluded.qsethash");
+        op.addColumn("nodeid", nodeIDs);
+        op.addColumn("qsethash", nodeQSetHashes);
+        db.doDatabaseTypeSpecificOperation(op);
+    }
+
+    // save quorum sets, only bumping the last ledger of those already saved
+    std::vector<std::string> qSetHashes;
+    std::vector<std::string> qSets;
+    for (auto const& p : usedQSets)
+    {
+        qSetHashes.emplace_back(binToHex(p.first));
+        qSets.emplace_back(decoder::encode_b64(xdr::xdr_to_opaque(*p.second)));
+    }
+    if (!qSetHashes.empty())
+    {
+        ZoneNamedN(upsertSCPQuorumsZone, "upsert scpquorums", true);
+        std::vector<int32_t> ledgerSeqs(qSetHashes.size(),
+                                        static_cast<int32_t>(seq));
+        BulkInsertOperation op(
+            db, "scpquorums",
+            "ON CONFLICT (qsethash) DO UPDATE SET "
+            "lastledgerseq = excluded.lastledgerseq "
+            "WHERE scpquorums.lastledgerseq < excluded.lastledgerseq");
+        op.addColumn("qsethash", qSetHashes);
+        op.addColumn("qset", qSets);
+        op.addColumn("lastledgerseq", ledgerSeqs);
+        db.doDatabaseTypeSpecificOperation(op);
+    }
+
+    txscope.commit();
+}
 
-        auto prep = db.getPreparedStatement(
-            "UPDATE quoruminfo SET qsethash = :h WHERE nodeid = :id");
-        auto& st = prep.statement();
-        st.exchange(soci::use(qSetHHex));
-        st.exchange(soci::use(nodeIDStrKey));
-        st.define_and_bind();
+std::map<uint32_t, std::vector<SCPEnvelope>>
+HerderPersistenceImpl::loadSCPHistory(soci::session& sess, uint32_t ledgerSeq,
+                                      uint32_t ledgerCount)
+{
+    ZoneScoped;
+    auto res = mLog.read(ledgerSeq, ledgerCount);
+    for (auto& p : res)
+    {
+        // same order as the scphistory table was read in
+        std::vector<std::pair<std::string, SCPEnvelope>> byNode;
+        for (auto& env : p.second)
         {
-            ZoneNamedN(updateQsetZone, "update quoruminfo", true);
-            st.execute(true);
+            byNode.emplace_back(KeyUtils::toStrKey(env.statement.nodeID),
+                                std::move(env));
         }
-        if (st.get_affected_rows() != 1)
+        std::stable_sort(
+            byNode.begin(), byNode.end(),
+            [](auto const& a, auto const& b) { return a.first < b.first; });
+        p.second.clear();
+        for (auto& n : byNode)
         {
-            auto prepI = db.getPreparedStatement(
-                "INSERT INTO quoruminfo (nodeid, qsethash) VALUES (:id, :h)");
-            auto& stI = prepI.statement();
-            stI.exchange(soci::use(nodeIDStrKey));
-            stI.exchange(soci::use(qSetHHex));
-            stI.define_and_bind();
-            {
-                ZoneNamedN(insertQsetZone, "insert quoruminfo", true);
-                stI.execute(true);
-            }
-            if (stI.get_affected_rows() != 1)
-            {
-                throw std::runtime_error("Could not update data in SQL");
-            }
+            p.second.emplace_back(std::move(n.second));
         }
     }
-    // save quorum sets
-    for (auto const& p : usedQSets)
+    if (res.size() == ledgerCount)
     {
-        std::string qSetH = binToHex(p.first);
-
-        uint32_t lastSeenSeq;
-        auto prepSelQSet = db.getPreparedStatement(
-            "SELECT lastledgerseq FROM scpquorums WHERE qsethash = :h");
-        auto& stSel = prepSelQSet.statement();
-        stSel.exchange(soci::into(lastSeenSeq));
-        stSel.exchange(soci::use(qSetH));
-        stSel.define_and_bind();
-        {
-            ZoneNamedN(selectSCPQuorumsZone, "select scpquorums", true);
-            stSel.execute(true);
-        }
-
-        if (stSel.got_data())
-        {
-            if (lastSeenSeq >= seq)
-            {
-                continue;
-            }
+        return res;
+    }
 
-            auto prepUpQSet = db.getPreparedStatement(
-                "UPDATE scpquorums SET "
-                "lastledgerseq = :l WHERE qsethash = :h");
+    // fall back to the scphistory table for the ledgers missing from mLog
+    uint32_t end = ledgerSeq + ledgerCount;
+    uint32_t curLedgerSeq;
+    std::string envB64;
 
-            auto& stUp = prepUpQSet.statement();
-            stUp.exchange(soci::use(seq));
-            stUp.exchange(soci::use(qSetH));
-            stUp.define_and_bind();
-            {
-                ZoneNamedN(updateSCPQuorumsZone, "update scpquorums", true);
-                stUp.execute(true);
-            }
-            if (stUp.get_affected_rows() != 1)
-            {
-                throw std::runtime_error("Could not update data in SQL");
-            }
-        }
-        else
-        {
-            auto qSetBytes(xdr::xdr_to_opaque(*p.second));
+    ZoneNamedN(selectSCPHistoryZone, "select scphistory", true);
 
-            std::string qSetEncoded;
-            qSetEncoded = decoder::encode_b64(qSetBytes);
+    soci::statement st =
+        (sess.prepare << "SELECT ledgerseq, envelope FROM scphistory "
+                         "WHERE ledgerseq >= :b AND ledgerseq < :e "
+                         "ORDER BY ledgerseq, nodeid",
+         soci::into(curLedgerSeq), soci::into(envB64), soci::use(ledgerSeq),
+         soci::use(end));
 
-            auto prepInsQSet = db.getPreparedStatement(
-                "INSERT INTO scpquorums "
-                "(qsethash, lastledgerseq, qset) VALUES "
-                "(:h, :l, :v);");
+    st.execute(true);
 
-            auto& stIns = prepInsQSet.statement();
-            stIns.exchange(soci::use(qSetH));
-            stIns.exchange(soci::use(seq));
-            stIns.exchange(soci::use(qSetEncoded));
-            stIns.define_and_bind();
-            {
-                ZoneNamedN(insertSCPQuorumsZone, "insert scpquorums", true);
-                stIns.execute(true);
-            }
-            if (stIns.get_affected_rows() != 1)
-            {
-                throw std::runtime_error("Could not update data in SQL");
-            }
+    std::map<uint32_t, std::vector<SCPEnvelope>> legacy;
+    while (st.got_data())
+    {
+        if (res.find(curLedgerSeq) == res.end())
+        {
+            auto& env = legacy[curLedgerSeq].emplace_back();
+            std::vector<uint8_t> envBytes;
+            decoder::decode_b64(envB64, envBytes);
+            xdr::xdr_from_opaque(envBytes, env);
         }
+        st.fetch();
     }
+    res.merge(legacy);
+    return res;
+}
 
-    txscope.commit();
+std::vector<SCPEnvelope>
+HerderPersistenceImpl::getSCPHistory(soci::session& sess, uint32_t ledgerSeq)
+{
+    auto res = loadSCPHistory(sess, ledgerSeq, 1);
+    auto it = res.find(ledgerSeq);
+    return it == res.end() ? std::vector<SCPEnvelope>{} : std::move(it->second);
 }
 
 size_t
-HerderPersistence::copySCPHistoryToStream(Database& db, soci::session& sess,
-                                          uint32_t ledgerSeq,
-                                          uint32_t ledgerCount,
-                                          XDROutputFileStream& scpHistory)
+HerderPersistenceImpl::copySCPHistoryToStream(Database& db, soci::session& sess,
+                                              uint32_t ledgerSeq,
+                                              uint32_t ledgerCount,
+                                              XDROutputFileStream& scpHistory)
 {
     ZoneScoped;
-    uint32_t begin = ledgerSeq, end = ledgerSeq + ledgerCount;
     size_t n = 0;
 
     // all known quorum sets
     UnorderedMap<Hash, SCPQuorumSet> qSets;
 
-    for (uint32_t curLedgerSeq = begin; curLedgerSeq < end; curLedgerSeq++)
+    for (auto& p : loadSCPHistory(sess, ledgerSeq, ledgerCount))
     {
-        // SCP envelopes for this ledger
+        if (p.second.empty())
+        {
+            continue;
+        }
+
         // quorum sets missing in this batch of envelopes
         std::set<Hash> missingQSets;
 
@@ -246,51 +222,25 @@ HerderPersistence::copySCPHistoryToStream(Database& db, soci::session& sess,
         hEntryV.v(0);
         auto& hEntry = hEntryV.v0();
         auto& lm = hEntry.ledgerMessages;
-        lm.ledgerSeq = curLedgerSeq;
+        lm.ledgerSeq = p.first;
 
         auto& curEnvs = lm.messages;
-
-        // fetch SCP messages from history
+        for (auto& env : p.second)
         {
-            std::string envB64;
-
-            ZoneNamedN(selectSCPHistoryZone, "select scphistory", true);
-
-            soci::statement st =
-                (sess.prepare << "SELECT envelope FROM scphistory "
-                                 "WHERE ledgerseq = :cur ORDER BY nodeid",
-                 soci::into(envB64), soci::use(curLedgerSeq));
-
-            st.execute(true);
-
-            while (st.got_data())
+            // record new quorum sets encountered
+            Hash const& qSetHash =
+                Slot::getCompanionQuorumSetHashFromStatement(env.statement);
+            if (qSets.find(qSetHash) == qSets.end())
             {
-                curEnvs.emplace_back();
-                auto& env = curEnvs.back();
-
-                std::vector<uint8_t> envBytes;
-                decoder::decode_b64(envB64, envBytes);
-                xdr::xdr_from_opaque(envBytes, env);
-
-                // record new quorum sets encountered
-                Hash const& qSetHash =
-                    Slot::getCompanionQuorumSetHashFromStatement(env.statement);
-                if (qSets.find(qSetHash) == qSets.end())
-                {
-                    missingQSets.insert(qSetHash);
-                }
-
-                n++;
-
-                st.fetch();
+                missingQSets.insert(qSetHash);
             }
+            curEnvs.emplace_back(std::move(env));
+            n++;
         }
 
         // fetch the quorum sets from the db
         for (auto const& q : missingQSets)
         {
-            std::string qset64, qSetHashHex;
-
             auto qset = getQuorumSet(db, sess, q);
             if (!qset)
             {
@@ -300,10 +250,7 @@ HerderPersistence::copySCPHistoryToStream(Database& db, soci::session& sess,
             hEntry.quorumSets.emplace_back(std::move(*qset));
         }
 
-        if (curEnvs.size() != 0)
-        {
-            scpHistory.writeOne(hEntryV);
-        }
+        scpHistory.writeOne(hEntryV);
     }
 
     return n;
@@ -406,21 +353,25 @@ HerderPersistence::createQuorumTrackingTable(soci::session& sess)
             "PRIMARY KEY (nodeid))";
 }
 
-void
-HerderPersistence::deleteOldEntries(Database& db, uint32_t ledgerSeq,
-                                    uint32_t count)
+uint64_t
+HerderPersistenceImpl::deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                        uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "scphistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "scpquorums", "lastledgerseq");
+    mLog.deleteOldEntries(ledgerSeq);
+    uint64_t rows = 0;
+    rows += DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                  "scphistory", "ledgerseq");
+    rows += DatabaseUtils::deleteOldEntriesHelper(
+        sess, ledgerSeq, count, "scpquorums", "lastledgerseq");
+    return rows;
 }
 
 void
-HerderPersistence::deleteNewerEntries(Database& db, uint32_t ledgerSeq)
+HerderPersistenceImpl::deleteNewerEntries(Database& db, uint32_t ledgerSeq)
 {
     ZoneScoped;
+    mLog.deleteNewerEntries(ledgerSeq);
     DatabaseUtils::deleteNewerEntriesHelper(db.getSession(), ledgerSeq,
                                             "scphistory", "ledgerseq");
     DatabaseUtils::deleteNewerEntriesHelper(db.getSession(), ledgerSeq,
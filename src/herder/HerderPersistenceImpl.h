@@ -5,6 +5,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/HerderPersistence.h"
+#include "herder/SCPHistoryLog.h"
+#include <map>
 
 namespace stellar
 {
@@ -20,7 +22,28 @@ class HerderPersistenceImpl : public HerderPersistence
     void saveSCPHistory(uint32_t seq, std::vector<SCPEnvelope> const& envs,
                         QuorumTracker::QuorumMap const& qmap) override;
 
+    size_t copySCPHistoryToStream(Database& db, soci::session& sess,
+                                  uint32_t ledgerSeq, uint32_t ledgerCount,
+                                  XDROutputFileStream& scpHistory) override;
+    std::vector<SCPEnvelope> getSCPHistory(soci::session& sess,
+                                           uint32_t ledgerSeq) override;
+
+    uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                              uint32_t count) override;
+    void deleteNewerEntries(Database& db, uint32_t ledgerSeq) override;
+
   private:
     Application& mApp;
+
+    // SCP messages of recent ledgers, in BUCKET_DIR_PATH/scp-history. The
+    // scphistory table only holds the messages saved by earlier versions,
+    // until they get pruned.
+    SCPHistoryLog mLog;
+
+    // messages of each of the given ledgers, from mLog or else from the
+    // scphistory table
+    std::map<uint32_t, std::vector<SCPEnvelope>>
+    loadSCPHistory(soci::session& sess, uint32_t ledgerSeq,
+                   uint32_t ledgerCount);
 };
 }
@@ -20,10 +20,10 @@
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/ProtocolVersion.h"
+#include "util/ZoneProfiler.h"
 #include "xdr/Stellar-SCP.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdr/Stellar-ledger.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <fmt/format.h>
 #include <medida/metrics_registry.h>
@@ -36,6 +36,8 @@ namespace stellar
 {
 
 uint32_t const TXSETVALID_CACHE_SIZE = 1000;
+// Only a few tx sets are nominated per slot, and each holds its transactions
+uint32_t const APPLICABLE_TXSET_CACHE_SIZE = 16;
 
 Hash
 HerderSCPDriver::getHashOf(std::vector<xdr::opaque_vec<>> const& vals) const
@@ -86,6 +88,7 @@ HerderSCPDriver::HerderSCPDriver(Application& app, HerderImpl& herder,
           {"scp", "slot", "values-referenced"})}
     , mLedgerSeqNominating(0)
     , mTxSetValidCache(TXSETVALID_CACHE_SIZE)
+    , mApplicableTxSets(APPLICABLE_TXSET_CACHE_SIZE)
 {
 }
 
@@ -702,7 +705,7 @@ HerderSCPDriver::combineCandidates(uint64_t slotIndex,
     {
         auto highest = candidateValues.cend();
         TxSetXDRFrameConstPtr highestTxSet;
-        ApplicableTxSetFrameConstPtr highestApplicableTxSet;
+        std::shared_ptr<ApplicableTxSetFrame const> highestApplicableTxSet;
         for (auto it = candidateValues.cbegin(); it != candidateValues.cend();
              ++it)
         {
@@ -710,7 +713,7 @@ HerderSCPDriver::combineCandidates(uint64_t slotIndex,
             auto cTxSet = mPendingEnvelopes.getTxSet(sv.txSetHash);
             releaseAssert(cTxSet);
             // Only valid applicable tx sets should be combined.
-            auto cApplicableTxSet = cTxSet->prepareForApply(mApp);
+            auto cApplicableTxSet = getApplicableTxSet(*cTxSet);
             releaseAssert(cApplicableTxSet);
             if (cTxSet->previousLedgerHash() == lcl.hash)
             {
@@ -734,6 +737,10 @@ HerderSCPDriver::combineCandidates(uint64_t slotIndex,
                 "No highest candidate transaction set found");
         }
         comp = *highest;
+
+        // The composite value will most likely be externalized with this tx
+        // set, so get its entries loaded while SCP finishes
+        mLedgerManager.startSpeculativePrefetch(*highestApplicableTxSet);
     }
     comp.upgrades.clear();
     for (auto const& upgrade : upgrades)
@@ -764,6 +771,7 @@ void
 HerderSCPDriver::valueExternalized(uint64_t slotIndex, Value const& value)
 {
     ZoneScoped;
+    recordTimelineEvent(slotIndex, LedgerCloseTimeline::Event::EXTERNALIZED);
     auto it = mSCPTimers.begin(); // cancel all timers below this slot
     while (it != mSCPTimers.end() && it->first <= slotIndex)
     {
@@ -930,11 +938,14 @@ void
 HerderSCPDriver::confirmedBallotPrepared(uint64_t slotIndex,
                                          SCPBallot const& ballot)
 {
+    recordTimelineEvent(slotIndex,
+                        LedgerCloseTimeline::Event::PREPARE_CONFIRMED);
 }
 
 void
 HerderSCPDriver::acceptedCommit(uint64_t slotIndex, SCPBallot const& ballot)
 {
+    recordTimelineEvent(slotIndex, LedgerCloseTimeline::Event::COMMIT_ACCEPTED);
 }
 
 std::optional<VirtualClock::time_point>
@@ -1013,6 +1024,18 @@ HerderSCPDriver::recordSCPEvent(uint64_t slotIndex, bool isNomination)
         timing.mPrepareStart =
             std::make_optional<VirtualClock::time_point>(start);
     }
+    recordTimelineEvent(slotIndex,
+                        isNomination
+                            ? LedgerCloseTimeline::Event::NOMINATION_START
+                            : LedgerCloseTimeline::Event::PREPARE_START);
+}
+
+void
+HerderSCPDriver::recordTimelineEvent(uint64_t slotIndex,
+                                     LedgerCloseTimeline::Event event)
+{
+    mApp.getLedgerManager().getCloseTimeline().record(
+        static_cast<uint32_t>(slotIndex), event);
 }
 
 void
@@ -1244,11 +1267,11 @@ HerderSCPDriver::checkAndCacheTxSetValid(TxSetXDRFrame const& txSet,
         // if we receive a bad SCP value for the current state, we still
         // might end up with malformed tx set that doesn't refer to the
         // LCL.
-        ApplicableTxSetFrameConstPtr applicableTxSet;
+        std::shared_ptr<ApplicableTxSetFrame const> applicableTxSet;
         if (txSet.previousLedgerHash() ==
             mApp.getLedgerManager().getLastClosedLedgerHeader().hash)
         {
-            applicableTxSet = txSet.prepareForApply(mApp);
+            applicableTxSet = getApplicableTxSet(txSet);
         }
 
         bool res = true;
@@ -1274,6 +1297,29 @@ HerderSCPDriver::checkAndCacheTxSetValid(TxSetXDRFrame const& txSet,
         return *pRes;
     }
 }
+std::shared_ptr<ApplicableTxSetFrame const>
+HerderSCPDriver::getApplicableTxSet(TxSetXDRFrame const& txSet) const
+{
+    ZoneScoped;
+    auto const& lclHash =
+        mApp.getLedgerManager().getLastClosedLedgerHeader().hash;
+    if (lclHash != mApplicableTxSetsLcl)
+    {
+        mApplicableTxSets.clear();
+        mApplicableTxSetsLcl = lclHash;
+    }
+
+    auto* cached = mApplicableTxSets.maybeGet(txSet.getContentsHash());
+    if (cached)
+    {
+        return *cached;
+    }
+    std::shared_ptr<ApplicableTxSetFrame const> applicableTxSet =
+        txSet.prepareForApply(mApp);
+    mApplicableTxSets.put(txSet.getContentsHash(), applicableTxSet);
+    return applicableTxSet;
+}
+
 size_t
 HerderSCPDriver::TxSetValidityKeyHash::operator()(
     TxSetValidityKey const& key) const
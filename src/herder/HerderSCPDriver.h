@@ -7,6 +7,7 @@
 #include "herder/Herder.h"
 #include "herder/TxSetFrame.h"
 #include "herder/TxSetUtils.h"
+#include "ledger/LedgerCloseTimeline.h"
 #include "medida/timer.h"
 #include "scp/SCPDriver.h"
 #include "util/RandomEvictionCache.h"
@@ -53,6 +54,8 @@ class HerderSCPDriver : public SCPDriver
     void recordSCPEvent(uint64_t slotIndex, bool isNomination);
     void recordSCPExternalizeEvent(uint64_t slotIndex, NodeID const& id,
                                    bool forceUpdateSelf);
+    void recordTimelineEvent(uint64_t slotIndex,
+                             LedgerCloseTimeline::Event event);
 
     // envelope handling
     SCPEnvelopeWrapperPtr wrapEnvelope(SCPEnvelope const& envelope) override;
@@ -209,6 +212,18 @@ class HerderSCPDriver : public SCPDriver
     mutable RandomEvictionCache<TxSetValidityKey, bool, TxSetValidityKeyHash>
         mTxSetValidCache;
 
+    // Tx sets prepared for apply on top of mApplicableTxSetsLcl, by contents
+    // hash, as the same tx set is typically validated for several close
+    // times and then combined within a slot. A null frame means the tx set
+    // couldn't be prepared. Cleared once the LCL changes.
+    mutable RandomEvictionCache<Hash,
+                                std::shared_ptr<ApplicableTxSetFrame const>>
+        mApplicableTxSets;
+    mutable Hash mApplicableTxSetsLcl;
+
+    std::shared_ptr<ApplicableTxSetFrame const>
+    getApplicableTxSet(TxSetXDRFrame const& txSet) const;
+
     SCPDriver::ValidationLevel validateValueHelper(uint64_t slotIndex,
                                                    StellarValue const& sv,
                                                    bool nomination) const;
@@ -7,7 +7,9 @@
 #include "TxSetFrame.h"
 #include "main/Config.h"
 #include "overlay/StellarXDR.h"
+#include "util/UnorderedSet.h"
 #include "xdr/Stellar-internal.h"
+#include <memory>
 #include <optional>
 #include <string>
 
@@ -49,6 +51,20 @@ class LedgerCloseData
         return mExpectedLedgerHash;
     }
 
+    // Contents hashes of the transactions applied without checking their
+    // signatures, as they are known to have succeeded when this ledger was
+    // closed before. Only set when replaying with CATCHUP_TRUSTED_REPLAY.
+    std::shared_ptr<UnorderedSet<Hash> const> const&
+    getTxsWithTrustedSignatures() const
+    {
+        return mTxsWithTrustedSignatures;
+    }
+    void
+    setTxsWithTrustedSignatures(std::shared_ptr<UnorderedSet<Hash> const> txs)
+    {
+        mTxsWithTrustedSignatures = std::move(txs);
+    }
+
     StoredDebugTransactionSet
     toXDR() const
     {
@@ -82,6 +98,7 @@ class LedgerCloseData
     TxSetXDRFrameConstPtr mTxSet;
     StellarValue mValue;
     std::optional<Hash> mExpectedLedgerHash;
+    std::shared_ptr<UnorderedSet<Hash> const> mTxsWithTrustedSignatures;
 };
 
 std::string stellarValueToString(Config const& c, StellarValue const& sv);
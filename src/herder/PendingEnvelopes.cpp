@@ -5,6 +5,8 @@
 #include "herder/HerderPersistence.h"
 #include "herder/HerderUtils.h"
 #include "herder/TxSetFrame.h"
+#include "ledger/LedgerCloseTimeline.h"
+#include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/OverlayManager.h"
@@ -13,7 +15,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/UnorderedSet.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <xdrpp/marshal.h>
 
 using namespace std;
@@ -250,6 +252,9 @@ PendingEnvelopes::recvTxSet(Hash const& hash, TxSetXDRFrameConstPtr txset)
     }
 
     addTxSet(hash, lastSeenSlotIndex, txset);
+    mApp.getLedgerManager().getCloseTimeline().record(
+        static_cast<uint32_t>(lastSeenSlotIndex),
+        LedgerCloseTimeline::Event::TX_SET_FETCHED);
     return true;
 }
 
@@ -789,40 +794,44 @@ PendingEnvelopes::getJsonInfo(size_t limit)
     return ret;
 }
 
-void
-PendingEnvelopes::rebuildQuorumTrackerState()
+SCPQuorumSetPtr
+PendingEnvelopes::lookupQuorumSet(NodeID const& id)
 {
-    // rebuild quorum information using data sources starting with the
-    // freshest source
-    mQuorumTracker.rebuild([&](NodeID const& id) -> SCPQuorumSetPtr {
-        SCPQuorumSetPtr res;
-        if (id == mHerder.getSCP().getLocalNodeID())
+    // use data sources starting with the freshest source
+    SCPQuorumSetPtr res;
+    if (id == mHerder.getSCP().getLocalNodeID())
+    {
+        res = getQSet(mHerder.getSCP().getLocalNode()->getQuorumSetHash());
+    }
+    else
+    {
+        auto m = mHerder.getSCP().getLatestMessage(id);
+        if (m != nullptr)
         {
-            res = getQSet(mHerder.getSCP().getLocalNode()->getQuorumSetHash());
+            auto h = Slot::getCompanionQuorumSetHashFromStatement(m->statement);
+            res = getQSet(h);
         }
-        else
+        if (res == nullptr)
         {
-            auto m = mHerder.getSCP().getLatestMessage(id);
-            if (m != nullptr)
+            // see if we had some information for that node
+            auto& db = mApp.getDatabase();
+            auto h =
+                HerderPersistence::getNodeQuorumSet(db, db.getSession(), id);
+            if (h)
             {
-                auto h =
-                    Slot::getCompanionQuorumSetHashFromStatement(m->statement);
-                res = getQSet(h);
-            }
-            if (res == nullptr)
-            {
-                // see if we had some information for that node
-                auto& db = mApp.getDatabase();
-                auto h = HerderPersistence::getNodeQuorumSet(
-                    db, db.getSession(), id);
-                if (h)
-                {
-                    res = getQSet(*h);
-                }
+                res = getQSet(*h);
             }
         }
-        return res;
-    });
+    }
+    return res;
+}
+
+void
+PendingEnvelopes::rebuildQuorumTrackerState()
+{
+    // rebuild quorum information from scratch
+    mQuorumTracker.rebuild(
+        [&](NodeID const& id) { return lookupQuorumSet(id); });
 }
 
 QuorumTracker::QuorumMap const&
@@ -840,9 +849,10 @@ PendingEnvelopes::envelopeProcessed(SCPEnvelope const& env)
     auto h = Slot::getCompanionQuorumSetHashFromStatement(st);
 
     SCPQuorumSetPtr qset = getQSet(h);
-    if (!mQuorumTracker.expand(id, qset))
+    if (!mQuorumTracker.update(
+            id, qset, [&](NodeID const& n) { return lookupQuorumSet(n); }))
     {
-        // could not expand quorum, queue up a rebuild
+        // could not update quorum, queue up a rebuild
         mRebuildQuorum = true;
     }
 }
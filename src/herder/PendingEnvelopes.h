@@ -108,6 +108,10 @@ class PendingEnvelopes
 
     void cleanKnownData();
 
+    // the freshest quorum set known for `id`, from its latest message or
+    // else from the database
+    SCPQuorumSetPtr lookupQuorumSet(NodeID const& id);
+
     void recordReceivedCost(SCPEnvelope const& env);
 
     UnorderedMap<NodeID, size_t> getCostPerValidator(uint64 slotIndex) const;
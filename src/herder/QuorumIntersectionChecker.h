@@ -6,6 +6,7 @@
 
 #include "herder/QuorumTracker.h"
 #include <atomic>
+#include <map>
 #include <memory>
 #include <optional>
 
@@ -42,12 +43,31 @@ class QuorumIntersectionChecker
         std::atomic<bool>& interruptFlag,
         stellar_default_random_engine::result_type seed);
 
+    // What networkEnjoysQuorumIntersection found scanning the powerset of the
+    // one SCC with quorums. The scan only depends on the quorum sets of the
+    // nodes of that SCC, so a later check of a network in which the SCC with
+    // quorums has the same nodes with the same quorum sets reuses it instead.
+    struct ScanResult
+    {
+        std::map<NodeID, SCPQuorumSet> mScanSCC;
+        bool mFoundDisjoint{false};
+        std::pair<std::vector<NodeID>, std::vector<NodeID>> mPotentialSplit;
+    };
+
     virtual ~QuorumIntersectionChecker(){};
     virtual bool networkEnjoysQuorumIntersection() const = 0;
     virtual size_t getMaxQuorumsFound() const = 0;
     virtual std::pair<std::vector<NodeID>, std::vector<NodeID>>
     getPotentialSplit() const = 0;
 
+    // Result of the last scan done or reused by
+    // networkEnjoysQuorumIntersection, null if it didn't need one.
+    virtual std::shared_ptr<ScanResult const> getScanResult() const = 0;
+    // Result of an earlier check for networkEnjoysQuorumIntersection to
+    // reuse when it applies.
+    virtual void
+    setPriorScanResult(std::shared_ptr<ScanResult const> prior) = 0;
+
     // If any thread sets the atomic interruptFlag passed into any of the above
     // methods, any calculation-in-progress will throw InterruptedException and
     // unwind.
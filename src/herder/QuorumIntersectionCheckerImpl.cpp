@@ -8,6 +8,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include <future>
 
 namespace
 {
@@ -58,10 +59,9 @@ QBitSet::getSuccessors(BitSet const& nodes, QGraph const& inner)
 
 // Slightly tweaked variant of Lachowski's next-node function.
 size_t
-MinQuorumEnumerator::pickSplitNode(
-    stellar::stellar_default_random_engine& randEngine) const
+MinQuorumEnumerator::pickSplitNode() const
 {
-    std::vector<size_t>& inDegrees = mQic.mInDegrees;
+    std::vector<size_t>& inDegrees = mState.mInDegrees;
     inDegrees.assign(mQic.mGraph.size(), 0);
     releaseAssert(!mRemaining.empty());
     size_t maxNode = mRemaining.max();
@@ -84,7 +84,7 @@ MinQuorumEnumerator::pickSplitNode(
                     // currDegree same as existing max: replace it
                     // only probabilistically.
                     maxCount++;
-                    if (rand_uniform<size_t>(0, maxCount, randEngine) == 0)
+                    if (rand_uniform<size_t>(0, maxCount, mState.mRand) == 0)
                     {
                         // Not switching max element with max degree.
                         continue;
@@ -112,12 +112,18 @@ MinQuorumEnumerator::maxCommit() const
 
 MinQuorumEnumerator::MinQuorumEnumerator(
     BitSet const& committed, BitSet const& remaining, BitSet const& scanSCC,
-    QuorumIntersectionCheckerImpl const& qic)
+    QuorumIntersectionCheckerImpl const& qic, SearchState& state,
+    std::vector<std::pair<BitSet, BitSet>>* subproblems, size_t depth,
+    size_t splitDepth)
     : mCommitted(committed)
     , mRemaining(remaining)
     , mPerimeter(committed | remaining)
     , mScanSCC(scanSCC)
     , mQic(qic)
+    , mState(state)
+    , mSubproblems(subproblems)
+    , mDepth(depth)
+    , mSplitDepth(splitDepth)
 {
 }
 
@@ -128,13 +134,18 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     {
         throw QuorumIntersectionChecker::InterruptedException();
     }
+    if (mQic.mFoundDisjoint)
+    {
+        // Another thread has found disjoint quorums, the answer is known.
+        return false;
+    }
 
-    mQic.mStats.mCallsStarted++;
+    mState.mStats.mCallsStarted++;
 
     // Emit a progress meter every million calls.
-    if ((mQic.mStats.mCallsStarted & 0xfffff) == 0)
+    if ((mState.mStats.mCallsStarted & 0xfffff) == 0)
     {
-        mQic.mStats.log();
+        mState.mStats.log();
     }
     if (mQic.mLogTrace)
     {
@@ -148,7 +159,7 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     // min-quorum they find (if they find any).
     if (mCommitted.count() > maxCommit())
     {
-        mQic.mStats.mEarlyExit1s++;
+        mState.mStats.mEarlyExit1s++;
         if (mQic.mLogTrace)
         {
             CLOG_TRACE(SCP, "early exit 1, with committed={}", mCommitted);
@@ -165,10 +176,10 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     {
         CLOG_TRACE(SCP, "checking for quorum in committed={}", mCommitted);
     }
-    auto committedQuorum = mQic.contractToMaximalQuorum(mCommitted);
+    auto committedQuorum = mQic.contractToMaximalQuorum(mCommitted, mState);
     if (!committedQuorum.empty())
     {
-        if (mQic.isMinimalQuorum(committedQuorum))
+        if (mQic.isMinimalQuorum(committedQuorum, mState))
         {
             // Found a min-quorum. Examine it to see if
             // there's a disjoint quorum.
@@ -177,7 +188,7 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
                 CLOG_TRACE(SCP, "early exit 3.1: minimal quorum={}",
                            committedQuorum);
             }
-            mQic.mStats.mEarlyExit31s++;
+            mState.mStats.mEarlyExit31s++;
             return hasDisjointQuorum(committedQuorum);
         }
         if (mQic.mLogTrace)
@@ -185,7 +196,7 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
             CLOG_TRACE(SCP, "early exit 3.2: non-minimal quorum={}",
                        committedQuorum);
         }
-        mQic.mStats.mEarlyExit32s++;
+        mState.mStats.mEarlyExit32s++;
         return false;
     }
 
@@ -196,7 +207,7 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     {
         CLOG_TRACE(SCP, "checking for quorum in perimeter={}", mPerimeter);
     }
-    auto extensionQuorum = mQic.contractToMaximalQuorum(mPerimeter);
+    auto extensionQuorum = mQic.contractToMaximalQuorum(mPerimeter, mState);
     if (!extensionQuorum.empty())
     {
         if (!mCommitted.isSubsetEq(extensionQuorum))
@@ -209,7 +220,7 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
                     "does not extend committed={}",
                     extensionQuorum, mPerimeter, mCommitted);
             }
-            mQic.mStats.mEarlyExit22s++;
+            mState.mStats.mEarlyExit22s++;
             return false;
         }
     }
@@ -221,14 +232,14 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
                        "early exit 2.1: no extension quorum in perimeter={}",
                        mPerimeter);
         }
-        mQic.mStats.mEarlyExit21s++;
+        mState.mStats.mEarlyExit21s++;
         return false;
     }
 
     // Principal termination condition: stop when remainder is empty.
     if (mRemaining.empty())
     {
-        mQic.mStats.mTerminations++;
+        mState.mStats.mTerminations++;
         if (mQic.mLogTrace)
         {
             CLOG_TRACE(SCP, "remainder exhausted");
@@ -236,16 +247,24 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
         return false;
     }
 
+    // Leave the subtree to be scanned by one of the searching threads.
+    if (mSubproblems && mDepth == mSplitDepth)
+    {
+        mSubproblems->emplace_back(mCommitted, mRemaining);
+        return false;
+    }
+
     // Phase two: recurse into subproblems.
-    size_t split = pickSplitNode(mQic.mRand);
+    size_t split = pickSplitNode();
     if (mQic.mLogTrace)
     {
         CLOG_TRACE(SCP, "recursing into subproblems, split={}", split);
     }
     mRemaining.unset(split);
     MinQuorumEnumerator childExcludingSplit(mCommitted, mRemaining, mScanSCC,
-                                            mQic);
-    mQic.mStats.mFirstRecursionsTaken++;
+                                            mQic, mState, mSubproblems,
+                                            mDepth + 1, mSplitDepth);
+    mState.mStats.mFirstRecursionsTaken++;
     if (childExcludingSplit.anyMinQuorumHasDisjointQuorum())
     {
         if (mQic.mLogTrace)
@@ -257,8 +276,9 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
     }
     mCommitted.set(split);
     MinQuorumEnumerator childIncludingSplit(mCommitted, mRemaining, mScanSCC,
-                                            mQic);
-    mQic.mStats.mSecondRecursionsTaken++;
+                                            mQic, mState, mSubproblems,
+                                            mDepth + 1, mSplitDepth);
+    mState.mStats.mSecondRecursionsTaken++;
     return childIncludingSplit.anyMinQuorumHasDisjointQuorum();
 }
 
@@ -266,17 +286,33 @@ MinQuorumEnumerator::anyMinQuorumHasDisjointQuorum()
 // Implementation of QuorumIntersectionChecker
 ////////////////////////////////////////////////////////////////////////////////
 
+SearchState::SearchState(stellar_default_random_engine::result_type seed)
+    : mCachedQuorums(MAX_CACHED_QUORUMS_SIZE), mRand(seed)
+{
+}
+
 QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
     QuorumIntersectionChecker::QuorumSetMap const& qmap,
     std::optional<Config> const& cfg, std::atomic<bool>& interruptFlag,
     stellar_default_random_engine::result_type seed, bool quiet)
+    : QuorumIntersectionCheckerImpl(
+          qmap, cfg, interruptFlag, seed, quiet,
+          cfg ? cfg->QUORUM_INTERSECTION_CHECKER_THREADS : 1)
+{
+}
+
+QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
+    QuorumIntersectionChecker::QuorumSetMap const& qmap,
+    std::optional<Config> const& cfg, std::atomic<bool>& interruptFlag,
+    stellar_default_random_engine::result_type seed, bool quiet,
+    size_t threads)
     : mCfg(cfg)
     , mLogTrace(Logging::logTrace("SCP"))
     , mQuiet(quiet)
+    , mThreads(std::max<size_t>(threads, 1))
     , mTSC()
     , mInterruptFlag(interruptFlag)
-    , mCachedQuorums(MAX_CACHED_QUORUMS_SIZE)
-    , mRand(seed)
+    , mState(std::make_unique<SearchState>(seed))
 {
     buildGraph(qmap);
     // Awkwardly, the graph size is zero when we initialize mTSC. Update it
@@ -284,16 +320,34 @@ QuorumIntersectionCheckerImpl::QuorumIntersectionCheckerImpl(
     buildSCCs();
 }
 
+QuorumIntersectionCheckerImpl::~QuorumIntersectionCheckerImpl()
+{
+}
+
 std::pair<std::vector<NodeID>, std::vector<NodeID>>
 QuorumIntersectionCheckerImpl::getPotentialSplit() const
 {
+    std::lock_guard<std::mutex> lock(mPotentialSplitMutex);
     return mPotentialSplit;
 }
 
 size_t
 QuorumIntersectionCheckerImpl::getMaxQuorumsFound() const
 {
-    return mStats.mMaxQuorumsSeen;
+    return mState->mStats.mMaxQuorumsSeen;
+}
+
+std::shared_ptr<QuorumIntersectionChecker::ScanResult const>
+QuorumIntersectionCheckerImpl::getScanResult() const
+{
+    return mScanResult;
+}
+
+void
+QuorumIntersectionCheckerImpl::setPriorScanResult(
+    std::shared_ptr<ScanResult const> prior)
+{
+    mPriorScanResult = prior;
 }
 
 void
@@ -312,6 +366,22 @@ QuorumIntersectionCheckerImpl::Stats::log() const
                mEarlyExit21s, mEarlyExit22s, mEarlyExit31s, mEarlyExit32s);
 }
 
+void
+QuorumIntersectionCheckerImpl::Stats::add(Stats const& other)
+{
+    mCallsStarted += other.mCallsStarted;
+    mFirstRecursionsTaken += other.mFirstRecursionsTaken;
+    mSecondRecursionsTaken += other.mSecondRecursionsTaken;
+    mMaxQuorumsSeen += other.mMaxQuorumsSeen;
+    mMinQuorumsSeen += other.mMinQuorumsSeen;
+    mTerminations += other.mTerminations;
+    mEarlyExit1s += other.mEarlyExit1s;
+    mEarlyExit21s += other.mEarlyExit21s;
+    mEarlyExit22s += other.mEarlyExit22s;
+    mEarlyExit31s += other.mEarlyExit31s;
+    mEarlyExit32s += other.mEarlyExit32s;
+}
+
 // This function is the innermost call in the checker and must be as fast
 // as possible. We spend almost all of our time in here.
 bool
@@ -391,13 +461,14 @@ QuorumIntersectionCheckerImpl::containsQuorumSliceForNode(BitSet const& bs,
 }
 
 bool
-QuorumIntersectionCheckerImpl::isAQuorum(BitSet const& nodes) const
+QuorumIntersectionCheckerImpl::isAQuorum(BitSet const& nodes,
+                                         SearchState& state) const
 {
-    bool* pRes = mCachedQuorums.maybeGet(nodes);
+    bool* pRes = state.mCachedQuorums.maybeGet(nodes);
     if (pRes == nullptr)
     {
-        bool result = !contractToMaximalQuorum(nodes).empty();
-        mCachedQuorums.put(nodes, result);
+        bool result = !contractToMaximalQuorum(nodes, state).empty();
+        state.mCachedQuorums.put(nodes, result);
         return result;
     }
     else
@@ -407,7 +478,8 @@ QuorumIntersectionCheckerImpl::isAQuorum(BitSet const& nodes) const
 }
 
 BitSet
-QuorumIntersectionCheckerImpl::contractToMaximalQuorum(BitSet nodes) const
+QuorumIntersectionCheckerImpl::contractToMaximalQuorum(
+    BitSet nodes, SearchState& state) const
 {
     // Find greatest fixpoint of f(X) = {n ∈ X | containsQuorumSliceForNode(X,
     // n)}
@@ -444,7 +516,7 @@ QuorumIntersectionCheckerImpl::contractToMaximalQuorum(BitSet nodes) const
             }
             if (!filtered.empty())
             {
-                ++mStats.mMaxQuorumsSeen;
+                ++state.mStats.mMaxQuorumsSeen;
             }
             return filtered;
         }
@@ -453,12 +525,13 @@ QuorumIntersectionCheckerImpl::contractToMaximalQuorum(BitSet nodes) const
 }
 
 bool
-QuorumIntersectionCheckerImpl::isMinimalQuorum(BitSet const& nodes) const
+QuorumIntersectionCheckerImpl::isMinimalQuorum(BitSet const& nodes,
+                                               SearchState& state) const
 {
 #ifndef NDEBUG
     // We should only be called with a quorum, such that contracting to its
     // maximum doesn't do anything. This is a slightly expensive check.
-    releaseAssert(contractToMaximalQuorum(nodes) == nodes);
+    releaseAssert(contractToMaximalQuorum(nodes, state) == nodes);
 #endif
 
     BitSet minQ = nodes;
@@ -470,7 +543,7 @@ QuorumIntersectionCheckerImpl::isMinimalQuorum(BitSet const& nodes) const
     for (size_t i = 0; nodes.nextSet(i); ++i)
     {
         minQ.unset(i);
-        if (isAQuorum(minQ))
+        if (isAQuorum(minQ, state))
         {
             // There's a subquorum with i removed: nodes isn't a minq.
             return false;
@@ -480,7 +553,7 @@ QuorumIntersectionCheckerImpl::isMinimalQuorum(BitSet const& nodes) const
     }
     // Tried every possible one-node-less subset, found no subquorums: this one
     // is minimal.
-    mStats.mMinQuorumsSeen++;
+    state.mStats.mMinQuorumsSeen++;
     return true;
 }
 
@@ -488,6 +561,8 @@ void
 QuorumIntersectionCheckerImpl::noteFoundDisjointQuorums(
     BitSet const& nodes, BitSet const& disj) const
 {
+    std::lock_guard<std::mutex> lock(mPotentialSplitMutex);
+    mFoundDisjoint = true;
     mPotentialSplit.first.clear();
     mPotentialSplit.second.clear();
 
@@ -515,7 +590,7 @@ QuorumIntersectionCheckerImpl::noteFoundDisjointQuorums(
 bool
 MinQuorumEnumerator::hasDisjointQuorum(BitSet const& nodes) const
 {
-    BitSet disj = mQic.contractToMaximalQuorum(mScanSCC - nodes);
+    BitSet disj = mQic.contractToMaximalQuorum(mScanSCC - nodes, mState);
     if (!disj.empty())
     {
         mQic.noteFoundDisjointQuorums(nodes, disj);
@@ -604,6 +679,7 @@ QuorumIntersectionCheckerImpl::buildGraph(
 {
     mPubKeyBitNums.clear();
     mBitNumPubKeys.clear();
+    mBitNumQSets.clear();
     mGraph.clear();
 
     for (auto const& pair : qmap)
@@ -613,6 +689,7 @@ QuorumIntersectionCheckerImpl::buildGraph(
             size_t n = mBitNumPubKeys.size();
             mPubKeyBitNums.insert(std::make_pair(pair.first, n));
             mBitNumPubKeys.emplace_back(pair.first);
+            mBitNumQSets.emplace_back(pair.second);
         }
         else
         {
@@ -634,7 +711,7 @@ QuorumIntersectionCheckerImpl::buildGraph(
             mGraph.emplace_back(qb);
         }
     }
-    mStats.mTotalNodes = mPubKeyBitNums.size();
+    mState->mStats.mTotalNodes = mPubKeyBitNums.size();
 }
 
 void
@@ -646,7 +723,7 @@ QuorumIntersectionCheckerImpl::buildSCCs()
         // winds up returning a dangling reference at its site of use.
         return this->mGraph.at(i).mAllSuccessors;
     });
-    mStats.mNumSCCs = mTSC.mSCCs.size();
+    mState->mStats.mNumSCCs = mTSC.mSCCs.size();
 }
 
 std::string
@@ -669,11 +746,13 @@ QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
     // quorum (on which to focus second stage enumeration); also note and bypass
     // second stage exhaustive scan if there are _two_ such SCCs with quorums,
     // as they necessarily contain disjoint min-quorums.
+    mFoundDisjoint = false;
+    mScanResult.reset();
     bool foundDisjoint = false;
     BitSet scanSCC;
     for (auto const& scc : mTSC.mSCCs)
     {
-        auto q = contractToMaximalQuorum(scc);
+        auto q = contractToMaximalQuorum(scc, *mState);
         if (!q.empty())
         {
             if (scanSCC.empty())
@@ -681,7 +760,7 @@ QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
                 // This is the first SCC with a quorum, we'll make it the
                 // scan SCC.
                 scanSCC = scc;
-                mStats.mScanSCCSize = scanSCC.count();
+                mState->mStats.mScanSCCSize = scanSCC.count();
                 CLOG_DEBUG(SCP, "Found scan SCC: {}", scc);
                 CLOG_DEBUG(SCP, "Containing quorum: {}", q);
                 for (size_t i = 0; scanSCC.nextSet(i); ++i)
@@ -693,7 +772,8 @@ QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
             {
                 CLOG_DEBUG(SCP, "Found extra SCC: {}", scc);
                 CLOG_DEBUG(SCP, "Containing quorum: {}", q);
-                noteFoundDisjointQuorums(contractToMaximalQuorum(scanSCC), q);
+                noteFoundDisjointQuorums(
+                    contractToMaximalQuorum(scanSCC, *mState), q);
                 foundDisjoint = true;
                 break;
             }
@@ -724,15 +804,155 @@ QuorumIntersectionCheckerImpl::networkEnjoysQuorumIntersection() const
     // Second stage: scan the scan-SCC powerset, potentially expensive.
     if (!foundDisjoint)
     {
-        BitSet committed;
-        BitSet remaining = scanSCC;
-        MinQuorumEnumerator mqe(committed, remaining, scanSCC, *this);
-        foundDisjoint = mqe.anyMinQuorumHasDisjointQuorum();
-        mStats.log();
+        if (mPriorScanResult && isScanResultFor(*mPriorScanResult, scanSCC))
+        {
+            CLOG_DEBUG(SCP, "Scan SCC unchanged, reusing earlier scan");
+            mScanResult = mPriorScanResult;
+            foundDisjoint = mScanResult->mFoundDisjoint;
+            std::lock_guard<std::mutex> lock(mPotentialSplitMutex);
+            mPotentialSplit = mScanResult->mPotentialSplit;
+        }
+        else
+        {
+            foundDisjoint = anyMinQuorumInSCCHasDisjointQuorum(scanSCC);
+            mState->mStats.log();
+            auto res = std::make_shared<ScanResult>();
+            for (size_t i = 0; scanSCC.nextSet(i); ++i)
+            {
+                res->mScanSCC.emplace(mBitNumPubKeys.at(i),
+                                      *mBitNumQSets.at(i));
+            }
+            res->mFoundDisjoint = foundDisjoint;
+            if (foundDisjoint)
+            {
+                res->mPotentialSplit = getPotentialSplit();
+            }
+            mScanResult = res;
+        }
     }
     return !foundDisjoint;
 }
 
+bool
+QuorumIntersectionCheckerImpl::isScanResultFor(ScanResult const& result,
+                                               BitSet const& scanSCC) const
+{
+    if (result.mScanSCC.size() != scanSCC.count())
+    {
+        return false;
+    }
+    for (size_t i = 0; scanSCC.nextSet(i); ++i)
+    {
+        auto it = result.mScanSCC.find(mBitNumPubKeys.at(i));
+        if (it == result.mScanSCC.end() || !(it->second == *mBitNumQSets.at(i)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+QuorumIntersectionCheckerImpl::anyMinQuorumInSCCHasDisjointQuorum(
+    BitSet const& scanSCC) const
+{
+    BitSet committed;
+    BitSet remaining = scanSCC;
+    if (mThreads == 1)
+    {
+        MinQuorumEnumerator mqe(committed, remaining, scanSCC, *this, *mState);
+        return mqe.anyMinQuorumHasDisjointQuorum();
+    }
+
+    // Enumerate the top of the search tree on this thread, down to a depth
+    // leaving enough subtrees for the threads to balance their work by
+    // claiming them one at a time.
+    size_t const SUBPROBLEMS_PER_THREAD = 32;
+    size_t splitDepth = 0;
+    while ((size_t(1) << splitDepth) < mThreads * SUBPROBLEMS_PER_THREAD)
+    {
+        ++splitDepth;
+    }
+    std::vector<std::pair<BitSet, BitSet>> subproblems;
+    MinQuorumEnumerator root(committed, remaining, scanSCC, *this, *mState,
+                             &subproblems, 0, splitDepth);
+    if (root.anyMinQuorumHasDisjointQuorum())
+    {
+        return true;
+    }
+    CLOG_DEBUG(SCP, "Scanning {} subproblems on {} threads",
+               subproblems.size(), mThreads);
+
+    std::atomic<size_t> next{0};
+    auto scan = [&](SearchState& state) {
+        while (!mFoundDisjoint)
+        {
+            size_t i = next++;
+            if (i >= subproblems.size())
+            {
+                break;
+            }
+            MinQuorumEnumerator mqe(subproblems[i].first,
+                                    subproblems[i].second, scanSCC, *this,
+                                    state);
+            if (mqe.anyMinQuorumHasDisjointQuorum())
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    size_t const threads = std::min(mThreads, subproblems.size());
+    std::vector<std::unique_ptr<SearchState>> states;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        states.emplace_back(std::make_unique<SearchState>(mState->mRand()));
+    }
+    std::vector<std::future<bool>> workers;
+    for (size_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(
+            std::async(std::launch::async, scan, std::ref(*states[i])));
+    }
+
+    // This thread scans too, then waits for the others to finish whether or
+    // not they found anything, before rethrowing any exception.
+    bool found = false;
+    std::exception_ptr error;
+    try
+    {
+        found = threads > 0 && scan(*states[0]);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    for (auto& w : workers)
+    {
+        try
+        {
+            found = w.get() || found;
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+    for (auto const& state : states)
+    {
+        mState->mStats.add(state->mStats);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return found;
+}
+
 bool
 pointsToCandidate(SCPQuorumSet const& p, NodeID const& candidate)
 {
@@ -802,6 +1022,86 @@ groupString(std::optional<Config> const& cfg, std::set<NodeID> const& group)
     return out.str();
 }
 
+// Checks whether making `group` fickle splits the network of `qmap`.
+// `test_qmap` must match `qmap` and is restored to it before returning,
+// unless the check is interrupted.
+bool
+isIntersectionCritical(std::set<NodeID> const& group,
+                       QuorumIntersectionChecker::QuorumSetMap const& qmap,
+                       QuorumIntersectionChecker::QuorumSetMap& test_qmap,
+                       std::optional<Config> const& cfg,
+                       std::atomic<bool>& interruptFlag,
+                       stellar_default_random_engine::result_type seed)
+{
+    // Every member of the group will share the same fickle qset.
+    auto fickleQSet = std::make_shared<SCPQuorumSet>();
+
+    // The fickle qset has 2 innerSets: self and others.
+    SCPQuorumSet groupQSet;
+    SCPQuorumSet pointsToGroupQSet;
+
+    for (auto const& k : group)
+    {
+        groupQSet.validators.emplace_back(k);
+    }
+    groupQSet.threshold = static_cast<uint32>(group.size());
+
+    std::set<NodeID> pointsToGroup;
+    for (NodeID const& candidate : group)
+    {
+        for (auto const& d : qmap)
+        {
+            if (group.find(d.first) == group.end() && d.second &&
+                pointsToCandidate(*(d.second), candidate))
+            {
+                pointsToGroup.insert(d.first);
+            }
+        }
+    }
+    for (auto const& p : pointsToGroup)
+    {
+        pointsToGroupQSet.validators.emplace_back(p);
+    }
+    pointsToGroupQSet.threshold = 1;
+
+    fickleQSet->innerSets.emplace_back(std::move(groupQSet));
+    fickleQSet->innerSets.emplace_back(std::move(pointsToGroupQSet));
+    fickleQSet->threshold = 2;
+
+    // Install the fickle qset in every member of the group.
+    for (auto const& candidate : group)
+    {
+        test_qmap[candidate] = fickleQSet;
+    }
+
+    // Check to see if this modified config is vulnerable to splitting. Groups
+    // are checked in parallel already, so each check runs on a single thread.
+    QuorumIntersectionCheckerImpl checker(test_qmap, cfg, interruptFlag, seed,
+                                          /*quiet=*/true, /*threads=*/1);
+    bool critical = !checker.networkEnjoysQuorumIntersection();
+    if (!critical)
+    {
+        CLOG_DEBUG(SCP,
+                   "group is not intersection-critical: {} (with {} "
+                   "depending nodes)",
+                   groupString(cfg, group), pointsToGroup.size());
+    }
+    else
+    {
+        CLOG_WARNING(
+            SCP,
+            "Group is intersection-critical: {} (with {} depending nodes)",
+            groupString(cfg, group), pointsToGroup.size());
+    }
+
+    // Restore proper qsets for all group members, for next iteration.
+    for (auto const& candidate : group)
+    {
+        test_qmap[candidate] = qmap.find(candidate)->second;
+    }
+    return critical;
+}
+
 QuorumIntersectionChecker::QuorumSetMap
 toQuorumIntersectionMap(QuorumTracker::QuorumMap const& qmap)
 {
@@ -879,7 +1179,6 @@ QuorumIntersectionChecker::getIntersectionCriticalGroups(
 
     std::set<std::set<NodeID>> candidates;
     std::set<std::set<NodeID>> critical;
-    QuorumSetMap test_qmap(qmap);
 
     for (auto const& k : qmap)
     {
@@ -892,75 +1191,64 @@ QuorumIntersectionChecker::getIntersectionCriticalGroups(
     CLOG_INFO(SCP, "Examining {} node groups for intersection-criticality",
               candidates.size());
 
+    // Groups are checked independently of each other, so spread them over
+    // the threads the checker would use, each with its own copy of the map.
+    std::vector<std::set<NodeID> const*> groups;
     for (auto const& group : candidates)
     {
-        // Every member of the group will share the same fickle qset.
-        auto fickleQSet = std::make_shared<SCPQuorumSet>();
-
-        // The fickle qset has 2 innerSets: self and others.
-        SCPQuorumSet groupQSet;
-        SCPQuorumSet pointsToGroupQSet;
-
-        for (auto const& k : group)
-        {
-            groupQSet.validators.emplace_back(k);
-        }
-        groupQSet.threshold = static_cast<uint32>(group.size());
-
-        std::set<NodeID> pointsToGroup;
-        for (NodeID const& candidate : group)
+        groups.emplace_back(&group);
+    }
+    std::atomic<size_t> next{0};
+    auto checkGroups = [&]() {
+        std::set<std::set<NodeID>> found;
+        QuorumSetMap test_qmap(qmap);
+        for (size_t i = next++; i < groups.size(); i = next++)
         {
-            for (auto const& d : qmap)
+            if (isIntersectionCritical(*groups[i], qmap, test_qmap, cfg,
+                                       interruptFlag, seed))
             {
-                if (group.find(d.first) == group.end() && d.second &&
-                    pointsToCandidate(*(d.second), candidate))
-                {
-                    pointsToGroup.insert(d.first);
-                }
+                found.insert(*groups[i]);
             }
         }
-        for (auto const& p : pointsToGroup)
-        {
-            pointsToGroupQSet.validators.emplace_back(p);
-        }
-        pointsToGroupQSet.threshold = 1;
-
-        fickleQSet->innerSets.emplace_back(std::move(groupQSet));
-        fickleQSet->innerSets.emplace_back(std::move(pointsToGroupQSet));
-        fickleQSet->threshold = 2;
+        return found;
+    };
 
-        // Install the fickle qset in every member of the group.
-        for (auto const& candidate : group)
-        {
-            test_qmap[candidate] = fickleQSet;
-        }
-
-        // Check to see if this modified config is vulnerable to splitting.
-        auto checker = QuorumIntersectionChecker::create(test_qmap, cfg,
-                                                         interruptFlag, seed,
-                                                         /*quiet=*/true);
-        if (checker->networkEnjoysQuorumIntersection())
-        {
-            CLOG_DEBUG(SCP,
-                       "group is not intersection-critical: {} (with {} "
-                       "depending nodes)",
-                       groupString(cfg, group), pointsToGroup.size());
-        }
-        else
+    size_t threads = cfg ? cfg->QUORUM_INTERSECTION_CHECKER_THREADS : 1;
+    threads = std::max<size_t>(std::min(threads, groups.size()), 1);
+    std::vector<std::future<std::set<std::set<NodeID>>>> workers;
+    for (size_t i = 1; i < threads; ++i)
+    {
+        workers.emplace_back(std::async(std::launch::async, checkGroups));
+    }
+    std::exception_ptr error;
+    try
+    {
+        critical = checkGroups();
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    for (auto& w : workers)
+    {
+        try
         {
-            CLOG_WARNING(
-                SCP,
-                "Group is intersection-critical: {} (with {} depending nodes)",
-                groupString(cfg, group), pointsToGroup.size());
-            critical.insert(group);
+            auto found = w.get();
+            critical.insert(found.begin(), found.end());
         }
-
-        // Restore proper qsets for all group members, for next iteration.
-        for (auto const& candidate : group)
+        catch (...)
         {
-            test_qmap[candidate] = qmap.find(candidate)->second;
+            if (!error)
+            {
+                error = std::current_exception();
+            }
         }
     }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+
     if (critical.empty())
     {
         CLOG_INFO(SCP, "No intersection-critical groups found");
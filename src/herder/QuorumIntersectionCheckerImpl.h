@@ -337,6 +337,22 @@
 //        the graph. This typically excludes lots of nodes.
 //
 //
+// Refinement 9: Search subtrees in parallel
+// =========================================
+//
+// The two recursive calls of enumerate share nothing but the answer, so
+// distinct subtrees of the search can be explored on separate threads. We run
+// the enumeration on a single thread until it reaches a fixed depth, recording
+// the (C, R) arguments of every call at that depth instead of making it. This
+// leaves many more subtrees than threads, which the threads then claim one at
+// a time until none are left, so that a thread that drew a small subtree just
+// claims another one. Once any thread finds a minq with a quorum in its
+// complement, the others stop exploring as the answer is known.
+//
+// Every thread uses its own statistics, quorum cache and random engine, so
+// the only state they share is read-only: the graph and the SCC.
+//
+//
 // Coda: micro-optimizations
 // =========================
 //
@@ -357,7 +373,9 @@
 #include "util/TarjanSCCCalculator.h"
 #include "xdr/Stellar-SCP.h"
 #include "xdr/Stellar-types.h"
+#include <atomic>
 #include <functional>
+#include <mutex>
 #include <optional>
 
 namespace
@@ -366,6 +384,7 @@ namespace
 struct QBitSet;
 using QGraph = std::vector<QBitSet>;
 class QuorumIntersectionCheckerImpl;
+struct SearchState;
 
 // A QBitSet is the "fast" representation of a SCPQuorumSet. It includes both a
 // BitSet of its own nodes and a set of innerSets, along with a "successors"
@@ -423,20 +442,32 @@ class MinQuorumEnumerator
     // the overall SCC we're considering subsets of.
     BitSet const& mScanSCC;
 
-    // Checker that owns us, contains state of stats, graph, etc.
+    // Checker that owns us, contains the graph, etc.
     QuorumIntersectionCheckerImpl const& mQic;
 
+    // Stats, caches and random engine of the thread running this enumerator.
+    SearchState& mState;
+
+    // When set, calls at depth mSplitDepth record their committed and
+    // remaining sets here rather than recursing, leaving them to be scanned
+    // in parallel.
+    std::vector<std::pair<BitSet, BitSet>>* mSubproblems;
+    size_t mDepth;
+    size_t mSplitDepth;
+
     // Select the next node in mRemaining to split recursive cases between.
-    size_t
-    pickSplitNode(stellar::stellar_default_random_engine& randEngine) const;
+    size_t pickSplitNode() const;
 
     // Size limit for mCommitted beyond which we should stop scanning.
     size_t maxCommit() const;
 
   public:
-    MinQuorumEnumerator(BitSet const& committed, BitSet const& remaining,
-                        BitSet const& scanSCC,
-                        QuorumIntersectionCheckerImpl const& qic);
+    MinQuorumEnumerator(
+        BitSet const& committed, BitSet const& remaining,
+        BitSet const& scanSCC, QuorumIntersectionCheckerImpl const& qic,
+        SearchState& state,
+        std::vector<std::pair<BitSet, BitSet>>* subproblems = nullptr,
+        size_t depth = 0, size_t splitDepth = 0);
 
     bool hasDisjointQuorum(BitSet const& nodes) const;
     bool anyMinQuorumHasDisjointQuorum();
@@ -469,35 +500,45 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
         size_t mEarlyExit31s = {0};
         size_t mEarlyExit32s = {0};
         void log() const;
+        // Adds the search counters of another thread's stats to these.
+        void add(Stats const& other);
     };
 
     // We use our own stats and a local cached flag to control tracing because
     // using the global metrics and log-partition lookups at a fine grain
     // actually becomes problematic CPU-wise.
-    mutable Stats mStats;
     bool mLogTrace;
 
     // When run as a subroutine of criticality-checking, we inhibit
     // INFO/ERROR/WARNING level messages.
     bool mQuiet;
 
+    // Number of threads scanning the powerset of the scan SCC.
+    size_t const mThreads;
+
     // State to capture a counterexample found during search, for later
-    // reporting.
+    // reporting. Guarded by mPotentialSplitMutex as any searching thread may
+    // find one.
+    mutable std::mutex mPotentialSplitMutex;
     mutable std::pair<std::vector<stellar::NodeID>,
                       std::vector<stellar::NodeID>>
         mPotentialSplit;
 
+    // Set once a searching thread has found disjoint quorums, so that the
+    // others stop.
+    mutable std::atomic<bool> mFoundDisjoint{false};
+
     // These are the key state of the checker: the mapping from node public keys
     // to graph node numbers, and the graph of QBitSets itself.
     std::vector<stellar::NodeID> mBitNumPubKeys;
+    std::vector<stellar::SCPQuorumSetPtr> mBitNumQSets;
     std::unordered_map<stellar::NodeID, size_t> mPubKeyBitNums;
     QGraph mGraph;
 
-    // This is a temporary structure that's reused very often within the
-    // MinQuorumEnumerators, but never reentrantly / simultaneously. So we
-    // allocate it once here and let the MQEs use it to avoid hammering
-    // on malloc.
-    mutable std::vector<size_t> mInDegrees;
+    // Scan result of an earlier check to reuse, and the result of the scan
+    // done or reused by the last call to networkEnjoysQuorumIntersection.
+    std::shared_ptr<ScanResult const> mPriorScanResult;
+    mutable std::shared_ptr<ScanResult const> mScanResult;
 
     // This just calculates SCCs, from which we extract the first one found with
     // a quorum, which (assuming no other SCCs have quorums) we'll use for the
@@ -515,32 +556,75 @@ class QuorumIntersectionCheckerImpl : public stellar::QuorumIntersectionChecker
 
     bool containsQuorumSlice(BitSet const& bs, QBitSet const& qbs) const;
     bool containsQuorumSliceForNode(BitSet const& bs, size_t node) const;
-    BitSet contractToMaximalQuorum(BitSet nodes) const;
+    BitSet contractToMaximalQuorum(BitSet nodes, SearchState& state) const;
 
-    const int MAX_CACHED_QUORUMS_SIZE = 0xffff;
-    mutable stellar::RandomEvictionCache<BitSet, bool, BitSet::HashFunction>
-        mCachedQuorums;
-    bool isAQuorum(BitSet const& nodes) const;
-    bool isMinimalQuorum(BitSet const& nodes) const;
+    bool isAQuorum(BitSet const& nodes, SearchState& state) const;
+    bool isMinimalQuorum(BitSet const& nodes, SearchState& state) const;
     void noteFoundDisjointQuorums(BitSet const& nodes,
                                   BitSet const& disj) const;
     std::string nodeName(size_t node) const;
 
+    // Scans the powerset of scanSCC on mThreads threads, returning whether
+    // some min-quorum has a disjoint quorum.
+    bool anyMinQuorumInSCCHasDisjointQuorum(BitSet const& scanSCC) const;
+
+    // Whether the nodes of scanSCC are those of the SCC scanned for `result`,
+    // with the same quorum sets.
+    bool isScanResultFor(ScanResult const& result,
+                         BitSet const& scanSCC) const;
+
     friend class MinQuorumEnumerator;
+    friend struct SearchState;
 
-    mutable stellar::stellar_default_random_engine mRand;
+    // State of the search run on the calling thread. Threads added by
+    // anyMinQuorumInSCCHasDisjointQuorum add their stats to it when done.
+    std::unique_ptr<SearchState> mState;
 
   public:
+    // Uses QUORUM_INTERSECTION_CHECKER_THREADS threads, or a single one
+    // without a config.
     QuorumIntersectionCheckerImpl(
         stellar::QuorumIntersectionChecker::QuorumSetMap const& qmap,
         std::optional<stellar::Config> const& cfg,
         std::atomic<bool>& interruptFlag,
         stellar::stellar_default_random_engine::result_type seed,
         bool quiet = false);
+    QuorumIntersectionCheckerImpl(
+        stellar::QuorumIntersectionChecker::QuorumSetMap const& qmap,
+        std::optional<stellar::Config> const& cfg,
+        std::atomic<bool>& interruptFlag,
+        stellar::stellar_default_random_engine::result_type seed, bool quiet,
+        size_t threads);
+    ~QuorumIntersectionCheckerImpl();
     bool networkEnjoysQuorumIntersection() const override;
 
     std::pair<std::vector<stellar::NodeID>, std::vector<stellar::NodeID>>
     getPotentialSplit() const override;
     size_t getMaxQuorumsFound() const override;
+
+    std::shared_ptr<ScanResult const> getScanResult() const override;
+    void setPriorScanResult(std::shared_ptr<ScanResult const> prior) override;
+};
+
+// State that the search mutates as it goes, of which every searching thread
+// has its own.
+struct SearchState
+{
+    QuorumIntersectionCheckerImpl::Stats mStats;
+
+    // This is a temporary structure that's reused very often within the
+    // MinQuorumEnumerators, but never reentrantly / simultaneously. So we
+    // allocate it once here and let the MQEs use it to avoid hammering
+    // on malloc.
+    std::vector<size_t> mInDegrees;
+
+    static constexpr int MAX_CACHED_QUORUMS_SIZE = 0xffff;
+    stellar::RandomEvictionCache<BitSet, bool, BitSet::HashFunction>
+        mCachedQuorums;
+
+    stellar::stellar_default_random_engine mRand;
+
+    explicit SearchState(
+        stellar::stellar_default_random_engine::result_type seed);
 };
 }
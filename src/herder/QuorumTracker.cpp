@@ -6,10 +6,31 @@
 #include "crypto/SecretKey.h"
 #include "scp/LocalNode.h"
 #include "util/GlobalChecks.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <limits>
+#include <map>
 
 namespace stellar
 {
+namespace
+{
+constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+std::set<NodeID>
+quorumSetNodes(SCPQuorumSetPtr const& qSet)
+{
+    std::set<NodeID> res;
+    if (qSet)
+    {
+        LocalNode::forAllNodes(*qSet, [&](NodeID const& id) {
+            res.emplace(id);
+            return true;
+        });
+    }
+    return res;
+}
+}
+
 QuorumTracker::QuorumTracker(NodeID const& localNodeID)
     : mLocalNodeID(localNodeID)
 {
@@ -69,6 +90,7 @@ QuorumTracker::expand(NodeID const& id, SCPQuorumSetPtr qSet)
     int newDist = nodeInfo.mDistance + 1;
 
     return LocalNode::forAllNodes(*qSet, [&](NodeID const& qNode) {
+        mPredecessors[qNode].emplace(id);
         auto qPair = mQuorum.emplace(qNode, NodeInfo{nullptr, newDist, {}});
 
         bool exists = !qPair.second;
@@ -132,12 +154,305 @@ QuorumTracker::expand(NodeID const& id, SCPQuorumSetPtr qSet)
     });
 }
 
+// `update` maintains the state `rebuild` would arrive at: the distances of a
+// breadth-first traversal from the local node, over the edges of the quorum
+// sets known, and the closest validators that follow from them. After
+// changing the edges out of one node, it only revisits the nodes whose
+// distance or closest validators may change as a result:
+//
+//   1. Nodes whose shortest path went through a removed edge lose their
+//      distance, unless another predecessor is still one step closer; this
+//      spreads to the successors that relied on them, in order of distance.
+//   2. The nodes that lost their distance, and the targets of added edges,
+//      get it back from their predecessors, spreading to their successors in
+//      order of distance, like in the traversal.
+//   3. The nodes left without a distance are no longer in the quorum.
+//   4. The closest validators of the nodes whose distance or predecessors
+//      changed are recomputed from those of their predecessors one step
+//      closer, spreading to successors one step further whenever they
+//      change.
+bool
+QuorumTracker::update(NodeID const& id, SCPQuorumSetPtr qSet,
+                      QuorumSetLookup const& lookup)
+{
+    ZoneScoped;
+
+    releaseAssertOrThrow(qSet);
+    auto it = mQuorum.find(id);
+    if (it == mQuorum.end())
+    {
+        return false;
+    }
+    if (it->second.mQuorumSet == qSet)
+    {
+        return true;
+    }
+
+    std::deque<std::pair<NodeID, SCPQuorumSetPtr>> changes{{id, qSet}};
+    while (!changes.empty())
+    {
+        std::vector<NodeID> added;
+        setQuorumSet(changes.front().first, changes.front().second, added);
+        changes.pop_front();
+        for (auto const& node : added)
+        {
+            auto nodeIt = mQuorum.find(node);
+            if (nodeIt != mQuorum.end() && !nodeIt->second.mQuorumSet)
+            {
+                auto nodeQSet = lookup(node);
+                if (nodeQSet)
+                {
+                    changes.emplace_back(node, nodeQSet);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void
+QuorumTracker::setQuorumSet(NodeID const& id, SCPQuorumSetPtr qSet,
+                            std::vector<NodeID>& added)
+{
+    auto it = mQuorum.find(id);
+    if (it == mQuorum.end())
+    {
+        // Dropped by an earlier change
+        return;
+    }
+    auto oldNodes = quorumSetNodes(it->second.mQuorumSet);
+    auto newNodes = quorumSetNodes(qSet);
+    it->second.mQuorumSet = qSet;
+
+    auto distance = [&](NodeID const& node) {
+        return mQuorum.at(node).mDistance;
+    };
+    auto successors = [&](NodeID const& node) {
+        return quorumSetNodes(mQuorum.at(node).mQuorumSet);
+    };
+
+    // Targets of the edges removed and added
+    std::vector<NodeID> removedTargets;
+    std::vector<NodeID> addedTargets;
+    for (auto const& node : oldNodes)
+    {
+        if (newNodes.find(node) == newNodes.end())
+        {
+            mPredecessors[node].erase(id);
+            removedTargets.emplace_back(node);
+        }
+    }
+    for (auto const& node : newNodes)
+    {
+        if (oldNodes.find(node) == oldNodes.end())
+        {
+            if (mQuorum.emplace(node, NodeInfo{nullptr, UNREACHABLE, {}})
+                    .second)
+            {
+                added.emplace_back(node);
+            }
+            mPredecessors[node].emplace(id);
+            addedTargets.emplace_back(node);
+        }
+    }
+
+    // Distance each node had before this change, for the nodes it changes
+    std::map<NodeID, int> oldDistances;
+    auto setDistance = [&](NodeID const& node, int dist) {
+        auto& info = mQuorum.at(node);
+        oldDistances.emplace(node, info.mDistance);
+        info.mDistance = dist;
+    };
+
+    // 1. Lose distances no longer supported by a predecessor
+    std::set<std::pair<int, NodeID>> pending;
+    for (auto const& node : removedTargets)
+    {
+        pending.emplace(distance(node), node);
+    }
+    std::set<NodeID> lost;
+    while (!pending.empty())
+    {
+        auto [dist, node] = *pending.begin();
+        pending.erase(pending.begin());
+        if (node == mLocalNodeID || dist == UNREACHABLE)
+        {
+            continue;
+        }
+        bool supported = false;
+        for (auto const& pred : mPredecessors[node])
+        {
+            if (lost.find(pred) == lost.end() && distance(pred) == dist - 1)
+            {
+                supported = true;
+                break;
+            }
+        }
+        if (!supported)
+        {
+            lost.emplace(node);
+            for (auto const& succ : successors(node))
+            {
+                if (distance(succ) == dist + 1)
+                {
+                    pending.emplace(dist + 1, succ);
+                }
+            }
+        }
+    }
+
+    // 2. Find distances again, from the predecessors of the nodes that lost
+    // theirs and through the added edges
+    for (auto const& node : lost)
+    {
+        int best = UNREACHABLE;
+        for (auto const& pred : mPredecessors[node])
+        {
+            if (lost.find(pred) == lost.end() &&
+                distance(pred) != UNREACHABLE)
+            {
+                best = std::min(best, distance(pred) + 1);
+            }
+        }
+        setDistance(node, best);
+        pending.emplace(best, node);
+    }
+    if (distance(id) != UNREACHABLE)
+    {
+        for (auto const& node : addedTargets)
+        {
+            if (distance(id) + 1 < distance(node))
+            {
+                setDistance(node, distance(id) + 1);
+                pending.emplace(distance(node), node);
+            }
+        }
+    }
+    while (!pending.empty())
+    {
+        auto [dist, node] = *pending.begin();
+        pending.erase(pending.begin());
+        if (dist == UNREACHABLE)
+        {
+            break;
+        }
+        if (dist != distance(node))
+        {
+            continue;
+        }
+        for (auto const& succ : successors(node))
+        {
+            if (dist + 1 < distance(succ))
+            {
+                setDistance(succ, dist + 1);
+                pending.emplace(dist + 1, succ);
+            }
+        }
+    }
+
+    // Closest validators to recompute: those of the nodes whose distance or
+    // predecessors changed
+    std::set<std::pair<int, NodeID>> stale;
+    std::vector<NodeID> unreachable;
+    auto markStale = [&](NodeID const& node) {
+        if (distance(node) != UNREACHABLE)
+        {
+            stale.emplace(distance(node), node);
+        }
+    };
+    for (auto const& kv : oldDistances)
+    {
+        if (distance(kv.first) == kv.second)
+        {
+            continue;
+        }
+        markStale(kv.first);
+        for (auto const& succ : successors(kv.first))
+        {
+            markStale(succ);
+        }
+        if (distance(kv.first) == UNREACHABLE)
+        {
+            unreachable.emplace_back(kv.first);
+        }
+    }
+    for (auto const& node : removedTargets)
+    {
+        markStale(node);
+    }
+    for (auto const& node : addedTargets)
+    {
+        markStale(node);
+        if (distance(node) == UNREACHABLE)
+        {
+            // Added by this change, but from a node that is itself
+            // unreachable
+            unreachable.emplace_back(node);
+        }
+    }
+
+    // 3. Drop the nodes without a path from the local node, and their edges
+    for (auto const& node : unreachable)
+    {
+        for (auto const& succ : successors(node))
+        {
+            auto predIt = mPredecessors.find(succ);
+            if (predIt != mPredecessors.end())
+            {
+                predIt->second.erase(node);
+            }
+        }
+    }
+    for (auto const& node : unreachable)
+    {
+        mQuorum.erase(node);
+        mPredecessors.erase(node);
+    }
+
+    // 4. Recompute closest validators, in order of distance
+    while (!stale.empty())
+    {
+        auto [dist, node] = *stale.begin();
+        stale.erase(stale.begin());
+        auto& info = mQuorum.at(node);
+        std::set<NodeID> closest;
+        if (dist == 1)
+        {
+            closest.emplace(node);
+        }
+        else if (dist > 1)
+        {
+            for (auto const& pred : mPredecessors[node])
+            {
+                auto const& predInfo = mQuorum.at(pred);
+                if (predInfo.mDistance == dist - 1)
+                {
+                    closest.insert(predInfo.mClosestValidators.begin(),
+                                   predInfo.mClosestValidators.end());
+                }
+            }
+        }
+        if (closest != info.mClosestValidators)
+        {
+            info.mClosestValidators = std::move(closest);
+            for (auto const& succ : successors(node))
+            {
+                if (distance(succ) == dist + 1)
+                {
+                    stale.emplace(dist + 1, succ);
+                }
+            }
+        }
+    }
+}
+
 void
-QuorumTracker::rebuild(std::function<SCPQuorumSetPtr(NodeID const&)> lookup)
+QuorumTracker::rebuild(QuorumSetLookup lookup)
 {
     ZoneScoped;
 
     mQuorum.clear();
+    mPredecessors.clear();
 
     mQuorum.emplace(mLocalNodeID, NodeInfo{nullptr, 0, {}});
 
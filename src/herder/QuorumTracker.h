@@ -9,6 +9,7 @@
 #include "util/UnorderedMap.h"
 #include "util/UnorderedSet.h"
 #include <deque>
+#include <functional>
 #include <set>
 
 namespace stellar
@@ -19,8 +20,10 @@ namespace stellar
 // If its associated quorum set is empty (nullptr), it just means
 // that another node has that node in its quorum set
 // but could not explore the quorum further (as we're missing the quorum set)
-// Nodes can be added one by one (calling `expand`, most efficient)
-// or the quorum can be rebuilt from scratch by using a lookup function
+// Nodes can be added one by one (calling `expand`, most efficient), their
+// quorum sets changed (calling `update`, at a cost proportional to the part
+// of the quorum affected) or the quorum can be rebuilt from scratch by using a
+// lookup function
 class QuorumTracker : public NonMovableOrCopyable
 {
   public:
@@ -41,10 +44,20 @@ class QuorumTracker : public NonMovableOrCopyable
     };
 
     using QuorumMap = UnorderedMap<NodeID, NodeInfo>;
+    using QuorumSetLookup = std::function<SCPQuorumSetPtr(NodeID const&)>;
 
   private:
     NodeID const mLocalNodeID;
     QuorumMap mQuorum;
+    // For every node in mQuorum, the nodes in mQuorum whose quorum set
+    // contains it
+    UnorderedMap<NodeID, UnorderedSet<NodeID>> mPredecessors;
+
+    // Replaces the quorum set of `id` and brings distances and closest
+    // validators up to date, dropping the nodes no longer reachable. Nodes
+    // added to mQuorum are appended to `added`.
+    void setQuorumSet(NodeID const& id, SCPQuorumSetPtr qSet,
+                      std::vector<NodeID>& added);
 
   public:
     QuorumTracker(NodeID const& localNodeID);
@@ -69,8 +82,20 @@ class QuorumTracker : public NonMovableOrCopyable
     // the nodes in the qset, which are equally close to the external node
     bool expand(NodeID const& id, SCPQuorumSetPtr qSet);
 
+    // sets the quorum set of `id`, already known or not, and updates the
+    // transitive quorum accordingly: nodes that become part of it get their
+    // quorum set from `lookup`, nodes that are no longer part of it are
+    // dropped, and the distances and closest validators of the others are
+    // updated, all at a cost proportional to the nodes affected. The result
+    // is the same as that of `rebuild` with a lookup function returning
+    // `qSet` for `id`, the known quorum sets of the nodes tracked already and
+    // those from `lookup` for the others.
+    // returns false if `id` is unknown, in which case nothing changes
+    bool update(NodeID const& id, SCPQuorumSetPtr qSet,
+                QuorumSetLookup const& lookup);
+
     // rebuild the transitive quorum given a lookup function
-    void rebuild(std::function<SCPQuorumSetPtr(NodeID const&)> lookup);
+    void rebuild(QuorumSetLookup lookup);
 
     // returns the current known quorum
     QuorumMap const& getQuorum() const;
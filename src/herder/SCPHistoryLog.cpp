@@ -0,0 +1,217 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "herder/SCPHistoryLog.h"
+#include "util/Fs.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <regex>
+
+namespace stellar
+{
+
+namespace
+{
+std::regex const SEGMENT_REGEX("^scp-([0-9a-f]{8})\\.xdr$");
+}
+
+SCPHistoryLog::SCPHistoryLog(asio::io_context& ctx, std::string const& dir,
+                             uint32_t checkpointFrequency, bool fsync)
+    : mCtx(ctx)
+    , mDir(dir)
+    , mCheckpointFrequency(checkpointFrequency)
+    , mFsync(fsync)
+{
+    releaseAssert(mCheckpointFrequency > 0);
+    if (!fs::mkpath(mDir))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Unable to create {}"), mDir));
+    }
+
+    auto segments = listSegments();
+    if (!segments.empty())
+    {
+        std::vector<LedgerSCPMessages> records;
+        if (!readSegment(segments.back(), records))
+        {
+            CLOG_WARNING(Herder, "Dropping torn tail of {}",
+                         segmentPath(segments.back()));
+            rewriteSegment(segments.back(), records);
+        }
+    }
+}
+
+std::string
+SCPHistoryLog::segmentPath(uint32_t segment) const
+{
+    return fmt::format(FMT_STRING("{}/scp-{}.xdr"), mDir, fs::hexStr(segment));
+}
+
+std::vector<uint32_t>
+SCPHistoryLog::listSegments() const
+{
+    std::vector<uint32_t> res;
+    for (auto const& f : fs::findfiles(mDir, [](std::string const& name) {
+             return std::regex_match(name, SEGMENT_REGEX);
+         }))
+    {
+        std::smatch sm;
+        std::regex_match(f, sm, SEGMENT_REGEX);
+        res.emplace_back(
+            static_cast<uint32_t>(std::stoul(sm[1].str(), nullptr, 16)));
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+bool
+SCPHistoryLog::readSegment(uint32_t segment,
+                           std::vector<LedgerSCPMessages>& records) const
+{
+    ZoneScoped;
+    auto path = segmentPath(segment);
+    if (!fs::exists(path))
+    {
+        return true;
+    }
+    XDRInputFileStream in;
+    in.open(path);
+    LedgerSCPMessages rec;
+    try
+    {
+        while (in.readOne(rec))
+        {
+            records.emplace_back(std::move(rec));
+        }
+    }
+    catch (xdr::xdr_runtime_error& e)
+    {
+        CLOG_WARNING(Herder, "Stopped reading {} after {} records: {}", path,
+                     records.size(), e.what());
+        return false;
+    }
+    return true;
+}
+
+void
+SCPHistoryLog::rewriteSegment(uint32_t segment,
+                              std::vector<LedgerSCPMessages> const& records)
+{
+    ZoneScoped;
+    auto path = segmentPath(segment);
+    if (records.empty())
+    {
+        std::remove(path.c_str());
+        return;
+    }
+    auto tmp = path + ".tmp";
+    std::remove(tmp.c_str());
+    {
+        XDROutputFileStream out(mCtx, mFsync);
+        out.open(tmp);
+        for (auto const& rec : records)
+        {
+            out.writeOne(rec);
+        }
+    }
+    if (!fs::durableRename(tmp, path, mDir))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Unable to replace {}"), path));
+    }
+}
+
+void
+SCPHistoryLog::append(uint32_t ledgerSeq, std::vector<SCPEnvelope> const& envs)
+{
+    ZoneScoped;
+    LedgerSCPMessages rec;
+    rec.ledgerSeq = ledgerSeq;
+    rec.messages.assign(envs.begin(), envs.end());
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    XDROutputFileStream out(mCtx, mFsync);
+    out.open(segmentPath(ledgerSeq / mCheckpointFrequency));
+    out.writeOne(rec);
+}
+
+std::map<uint32_t, std::vector<SCPEnvelope>>
+SCPHistoryLog::read(uint32_t ledgerSeq, uint32_t ledgerCount)
+{
+    ZoneScoped;
+    std::map<uint32_t, std::vector<SCPEnvelope>> res;
+    if (ledgerCount == 0)
+    {
+        return res;
+    }
+    uint64_t end = static_cast<uint64_t>(ledgerSeq) + ledgerCount;
+
+    std::lock_guard<std::mutex> guard(mMutex);
+    uint32_t last = static_cast<uint32_t>((end - 1) / mCheckpointFrequency);
+    for (uint32_t s = ledgerSeq / mCheckpointFrequency; s <= last; ++s)
+    {
+        std::vector<LedgerSCPMessages> records;
+        readSegment(s, records);
+        for (auto& rec : records)
+        {
+            if (rec.ledgerSeq >= ledgerSeq && rec.ledgerSeq < end)
+            {
+                res[rec.ledgerSeq].assign(rec.messages.begin(),
+                                          rec.messages.end());
+            }
+        }
+    }
+    return res;
+}
+
+void
+SCPHistoryLog::deleteOldEntries(uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    std::lock_guard<std::mutex> guard(mMutex);
+    for (auto s : listSegments())
+    {
+        // last ledger of the segment
+        uint64_t segmentEnd =
+            (static_cast<uint64_t>(s) + 1) * mCheckpointFrequency - 1;
+        if (segmentEnd > ledgerSeq)
+        {
+            break;
+        }
+        std::remove(segmentPath(s).c_str());
+    }
+}
+
+void
+SCPHistoryLog::deleteNewerEntries(uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    std::lock_guard<std::mutex> guard(mMutex);
+    uint32_t first = ledgerSeq / mCheckpointFrequency;
+    for (auto s : listSegments())
+    {
+        if (s > first)
+        {
+            std::remove(segmentPath(s).c_str());
+        }
+        else if (s == first)
+        {
+            std::vector<LedgerSCPMessages> records;
+            readSegment(s, records);
+            records.erase(std::remove_if(records.begin(), records.end(),
+                                         [&](LedgerSCPMessages const& rec) {
+                                             return rec.ledgerSeq >= ledgerSeq;
+                                         }),
+                          records.end());
+            rewriteSegment(s, records);
+        }
+    }
+}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-ledger.h"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// Append-only log of the SCP messages used to close recent ledgers, split in
+// one file per checkpoint. Saving the messages of a ledger appends a
+// LedgerSCPMessages record to the file of its checkpoint; as the messages of
+// a ledger are saved again when the next one closes, the last record of a
+// ledger replaces the earlier ones. Pruning old ledgers removes whole files.
+//
+// Reading a checkpoint may happen on a background thread while the main
+// thread appends, so all methods hold mMutex.
+class SCPHistoryLog : NonMovableOrCopyable
+{
+    asio::io_context& mCtx;
+    std::string const mDir;
+    uint32_t const mCheckpointFrequency;
+    bool const mFsync;
+    std::mutex mMutex;
+
+    std::string segmentPath(uint32_t segment) const;
+    std::vector<uint32_t> listSegments() const;
+
+    // reads the records of the segment, stopping at a torn or corrupt tail.
+    // Returns false if it had to stop early.
+    bool readSegment(uint32_t segment,
+                     std::vector<LedgerSCPMessages>& records) const;
+    void rewriteSegment(uint32_t segment,
+                        std::vector<LedgerSCPMessages> const& records);
+
+  public:
+    // Drops the torn tail a crash may have left in the latest file, so that
+    // later appends can be read back.
+    SCPHistoryLog(asio::io_context& ctx, std::string const& dir,
+                  uint32_t checkpointFrequency, bool fsync);
+
+    void append(uint32_t ledgerSeq, std::vector<SCPEnvelope> const& envs);
+
+    // Latest messages saved for the ledgers in
+    // [ledgerSeq, ledgerSeq + ledgerCount) that have any
+    std::map<uint32_t, std::vector<SCPEnvelope>> read(uint32_t ledgerSeq,
+                                                      uint32_t ledgerCount);
+
+    // Removes the files of the checkpoints ending at or before ledgerSeq
+    void deleteOldEntries(uint32_t ledgerSeq);
+
+    // Removes the messages of ledgers ledgerSeq and later
+    void deleteNewerEntries(uint32_t ledgerSeq);
+};
+}
@@ -5,9 +5,9 @@
 #include "herder/SurgePricingUtils.h"
 #include "crypto/SecretKey.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric128.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 #include <numeric>
 
 namespace stellar
@@ -177,6 +177,43 @@ SurgePricingPriorityQueue::getMostTopTxsWithinLimits(
     return txs;
 }
 
+bool
+SurgePricingPriorityQueue::allTxsFitWithinLimits(
+    std::vector<TransactionFrameBasePtr> const& txs,
+    SurgePricingLaneConfig& laneConfig)
+{
+    ZoneScoped;
+    auto const& limits = laneConfig.getLaneLimits();
+    std::vector<Resource> total(
+        limits.size(), Resource::makeEmpty(limits[GENERIC_LANE].size()));
+    for (auto const& tx : txs)
+    {
+        auto res = laneConfig.getTxResources(*tx);
+        auto lane = laneConfig.getLane(*tx);
+        if (!total[GENERIC_LANE].canAdd(res))
+        {
+            return false;
+        }
+        total[GENERIC_LANE] += res;
+        if (lane != GENERIC_LANE)
+        {
+            if (!total[lane].canAdd(res))
+            {
+                return false;
+            }
+            total[lane] += res;
+        }
+    }
+    for (size_t lane = 0; lane < limits.size(); ++lane)
+    {
+        if (anyGreater(total[lane], limits[lane]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 void
 SurgePricingPriorityQueue::visitTopTxs(
     std::vector<TxStackPtr> const& txStacks,
@@ -203,6 +240,7 @@ SurgePricingPriorityQueue::add(TxStackPtr txStack)
     if (inserted)
     {
         mLaneCurrentCount[lane] += txStack->getResources();
+        updateFeeLevels(*txStack, true);
     }
 }
 
@@ -232,9 +270,46 @@ SurgePricingPriorityQueue::erase(
     auto res = (*iter)->getResources();
     releaseAssert(res <= mLaneCurrentCount[lane]);
     mLaneCurrentCount[lane] -= res;
+    updateFeeLevels(**iter, false);
     mTxStackSets[lane].erase(iter);
 }
 
+void
+SurgePricingPriorityQueue::updateFeeLevels(TxStack const& txStack, bool added)
+{
+    if (mComparator.isGreater())
+    {
+        return;
+    }
+    auto const& tx = *txStack.getTopTx();
+    FeeRate feeRate(tx.getInclusionFee(), tx.getNumOperations());
+    auto res = txStack.getResources();
+    if (added)
+    {
+        auto it = mFeeLevels.find(feeRate);
+        if (it == mFeeLevels.end())
+        {
+            mFeeLevels.emplace(feeRate, FeeLevel{res, 1});
+        }
+        else
+        {
+            it->second.mResources += res;
+            ++it->second.mTxStackCount;
+        }
+        return;
+    }
+    auto it = mFeeLevels.find(feeRate);
+    releaseAssert(it != mFeeLevels.end());
+    if (--it->second.mTxStackCount == 0)
+    {
+        mFeeLevels.erase(it);
+    }
+    else
+    {
+        it->second.mResources -= res;
+    }
+}
+
 void
 SurgePricingPriorityQueue::popTopTxs(
     bool allowGaps,
@@ -405,6 +480,35 @@ SurgePricingPriorityQueue::canFitWithEviction(
     // The above checks should ensure there are some operations that need to be
     // evicted.
     releaseAssert(neededTotal.anyPositive() || neededLane.anyPositive());
+
+    // A 'generic' lane tx can evict any cheaper tx, so it can only fit if the
+    // cheaper txs have enough resources in total. Otherwise the scan below
+    // would stop at the cheapest tx that doesn't have a lower fee rate.
+    if (lane == GENERIC_LANE)
+    {
+        FeeRate txFeeRate(tx.getInclusionFee(), tx.getNumOperations());
+        auto notCheaper = mFeeLevels.lower_bound(txFeeRate);
+        Resource cheaper = Resource::makeEmpty(neededTotal.size());
+        bool enoughCheaper = false;
+        for (auto it = mFeeLevels.begin(); it != notCheaper; ++it)
+        {
+            cheaper += it->second.mResources;
+            if (!anyGreater(neededTotal, cheaper))
+            {
+                enoughCheaper = true;
+                break;
+            }
+        }
+        if (!enoughCheaper)
+        {
+            // All the queued txs together always have enough resources
+            releaseAssert(notCheaper != mFeeLevels.end());
+            auto minFee = computeBetterFee(tx, notCheaper->first.first,
+                                           notCheaper->first.second);
+            return std::make_pair(
+                false, minFee + (tx.getFullFee() - tx.getInclusionFee()));
+        }
+    }
     while (neededTotal.anyPositive() || neededLane.anyPositive())
     {
         bool evictedDueToLaneLimit = false;
@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <map>
 #include <set>
 
 #include "transactions/TransactionFrameBase.h"
@@ -149,6 +150,14 @@ class SurgePricingPriorityQueue
         std::shared_ptr<SurgePricingLaneConfig> laneConfig,
         std::vector<bool>& hadTxNotFittingLane);
 
+    // Returns whether all of `txs` fit within the limits of `laneConfig`
+    // together, in which case `getMostTopTxsWithinLimits` would select all of
+    // them without finding any transaction not fitting a lane. This is linear
+    // in the number of transactions, as it doesn't need to order them.
+    static bool
+    allTxsFitWithinLimits(std::vector<TransactionFrameBasePtr> const& txs,
+                          SurgePricingLaneConfig& laneConfig);
+
     // Returns total number of resources in all the stacks in this queue.
     Resource totalResources() const;
 
@@ -246,6 +255,24 @@ class SurgePricingPriorityQueue
     using TxStackSet = std::set<TxStackPtr, TxStackComparator>;
     using LaneIter = std::pair<size_t, TxStackSet::iterator>;
 
+    // Fee bid and number of operations of a transaction, ordered by the fee
+    // rate only.
+    using FeeRate = std::pair<int64_t, uint32_t>;
+    struct FeeRateLess
+    {
+        bool
+        operator()(FeeRate const& l, FeeRate const& r) const
+        {
+            return feeRate3WayCompare(l.first, l.second, r.first, r.second) <
+                   0;
+        }
+    };
+    struct FeeLevel
+    {
+        Resource mResources;
+        size_t mTxStackCount;
+    };
+
     // Iterator for walking the queue from top to bottom, possibly restricted
     // only to some lanes. The actual ordering is defined by
     // `isHighestPriority`.
@@ -286,6 +313,7 @@ class SurgePricingPriorityQueue
     void erase(size_t lane,
                SurgePricingPriorityQueue::TxStackSet::iterator iter);
     void popTopTx(Iterator iter);
+    void updateFeeLevels(TxStack const& txStack, bool added);
 
     Iterator getTop() const;
 
@@ -296,6 +324,13 @@ class SurgePricingPriorityQueue
     std::vector<Resource> mLaneCurrentCount;
 
     std::vector<TxStackSet> mTxStackSets;
+
+    // Resources of the stacks in all the lanes aggregated by the fee rate of
+    // their top transaction. This is only maintained when the lowest fee rate
+    // transaction is on top and allows `canFitWithEviction` to reject the
+    // transactions that can't evict enough cheaper ones by looking at the
+    // distinct fee rates instead of every cheaper transaction.
+    std::map<FeeRate, FeeLevel, FeeRateLess> mFeeLevels;
 };
 
 } // namespace stellar
@@ -5,6 +5,7 @@
 #include "herder/TransactionQueue.h"
 #include "crypto/Hex.h"
 #include "crypto/SecretKey.h"
+#include "herder/Herder.h"
 #include "herder/SurgePricingUtils.h"
 #include "herder/TxQueueLimiter.h"
 #include "ledger/LedgerHashUtils.h"
@@ -24,9 +25,9 @@
 #include "util/ProtocolVersion.h"
 #include "util/TarjanSCCCalculator.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric128.h"
 
-#include <Tracy.hpp>
 #include <algorithm>
 #include <fmt/format.h>
 #include <functional>
@@ -879,7 +880,7 @@ ClassicTransactionQueue::getMaxResourcesToFloodThisPeriod() const
     auto opsToFlood =
         mBroadcastOpCarryover[SurgePricingPriorityQueue::GENERIC_LANE] +
         Resource(
-            bigDivideOrThrow(opsToFloodLedger, getFloodPeriod(),
+            bigDivideOrThrow(opsToFloodLedger, getFloodRoundDuration(),
                              cfg.getExpectedLedgerCloseTime().count() * 1000,
                              Rounding::ROUND_UP));
     releaseAssertOrThrow(Resource(0) <= opsToFlood &&
@@ -900,7 +901,7 @@ ClassicTransactionQueue::getMaxResourcesToFloodThisPeriod() const
         auto dexOpsToFloodUint =
             dexOpsCarryover +
             static_cast<uint32>(bigDivideOrThrow(
-                dexOpsToFloodLedger, getFloodPeriod(),
+                dexOpsToFloodLedger, getFloodRoundDuration(),
                 cfg.getExpectedLedgerCloseTime().count() * 1000ll,
                 Rounding::ROUND_UP));
         dexOpsToFlood = dexOpsToFloodUint;
@@ -1034,7 +1035,7 @@ SorobanTransactionQueue::getMaxResourcesToFloodThisPeriod() const
 
     Resource resToFlood =
         mBroadcastOpCarryover[SurgePricingPriorityQueue::GENERIC_LANE] +
-        bigDivideOrThrow(totalFloodPerLedger, getFloodPeriod(),
+        bigDivideOrThrow(totalFloodPerLedger, getFloodRoundDuration(),
                          cfg.getExpectedLedgerCloseTime().count() * 1000,
                          Rounding::ROUND_UP);
     return std::make_pair(resToFlood, std::nullopt);
@@ -1198,6 +1199,62 @@ ClassicTransactionQueue::broadcastSome()
     return !totalToFlood.isZero();
 }
 
+int64_t
+TransactionQueue::getFloodRoundDuration() const
+{
+    int64_t period = getFloodPeriod();
+    if (!mApp.getConfig().ADAPTIVE_TX_FLOOD_PACING || !mLastBroadcastRound)
+    {
+        return period;
+    }
+    auto sinceLast = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         mApp.getClock().now() - *mLastBroadcastRound)
+                         .count();
+    auto duration =
+        static_cast<double>(std::clamp<int64_t>(sinceLast, 0, period));
+    // Transactions that can't be sent yet would only wait in the outbound
+    // queues, where they get trimmed when the queues are full
+    duration *= 1.0 - mApp.getOverlayManager().getOutboundTxQueueFill();
+    return static_cast<int64_t>(duration);
+}
+
+std::chrono::milliseconds
+TransactionQueue::getNextFloodDelay(bool fromCallback) const
+{
+    std::chrono::milliseconds period(getFloodPeriod());
+    if (!mApp.getConfig().ADAPTIVE_TX_FLOOD_PACING)
+    {
+        return period;
+    }
+
+    auto now = mApp.getClock().now();
+    VirtualClock::time_point next = now + period;
+    if (!fromCallback)
+    {
+        // Nothing was left to flood: rather than waiting a whole period for
+        // the new transactions, flood them as soon as the flood rate allows
+        next = now;
+        if (mLastBroadcastRound)
+        {
+            next = std::max(next, *mLastBroadcastRound + period);
+        }
+    }
+
+    // A round landing after the next nomination would leave its transactions
+    // out of this node's candidate tx set; run it half a period before
+    // instead, so that they also reach the peers in time
+    auto nomination = mApp.getHerder().getNextNominationTime();
+    if (nomination && *nomination < next)
+    {
+        auto early = *nomination - period / 2;
+        if (early > now)
+        {
+            next = early;
+        }
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(next - now);
+}
+
 void
 TransactionQueue::broadcast(bool fromCallback)
 {
@@ -1216,13 +1273,13 @@ TransactionQueue::broadcast(bool fromCallback)
     else
     {
         needsMore = broadcastSome();
+        mLastBroadcastRound = mApp.getClock().now();
     }
 
     if (needsMore)
     {
         mWaiting = true;
-        mBroadcastTimer.expires_from_now(
-            std::chrono::milliseconds(getFloodPeriod()));
+        mBroadcastTimer.expires_from_now(getNextFloodDelay(fromCallback));
         mBroadcastTimer.async_wait([&]() { broadcast(true); },
                                    &VirtualTimer::onFailureNoop);
     }
@@ -1314,7 +1371,8 @@ size_t
 ClassicTransactionQueue::getMaxQueueSizeOps() const
 {
     auto res = mTxQueueLimiter->maxScaledLedgerResources(false);
-    releaseAssert(res.size() == NUM_CLASSIC_TX_RESOURCES);
+    releaseAssert(res.size() == NUM_CLASSIC_TX_RESOURCES ||
+                  res.size() == NUM_CLASSIC_TX_BYTES_RESOURCES);
     return res.getVal(Resource::Type::OPERATIONS);
 }
 }
@@ -184,6 +184,15 @@ class TransactionQueue
     bool mShutdown{false};
     bool mWaiting{false};
     VirtualTimer mBroadcastTimer;
+    // When the last call to broadcastSome happened
+    std::optional<VirtualClock::time_point> mLastBroadcastRound;
+
+    // Time in milliseconds that the resources flooded by the next round are
+    // meant to cover: the flood period, or with ADAPTIVE_TX_FLOOD_PACING the
+    // time since the last round, up to the flood period and reduced when the
+    // outbound queues of the peers fill up
+    int64_t getFloodRoundDuration() const;
+    std::chrono::milliseconds getNextFloodDelay(bool fromCallback) const;
 
     virtual std::pair<Resource, std::optional<Resource>>
     getMaxResourcesToFloodThisPeriod() const = 0;
@@ -36,11 +36,21 @@ TxQueueLimiter::TxQueueLimiter(uint32 multiplier, Application& app,
     , mApp(app)
     , mIsSoroban(isSoroban)
 {
+    // Soroban transactions are already limited by their size through the
+    // ledger limits
+    auto maxBytes = app.getConfig().CLASSIC_TRANSACTION_QUEUE_MAX_BYTES;
+    if (maxBytes && !mIsSoroban)
+    {
+        mMaxQueueBytes = std::make_optional<int64_t>(*maxBytes);
+    }
+
     auto maxDexOps = app.getConfig().MAX_DEX_TX_OPERATIONS_IN_TX_SET;
     if (maxDexOps && !mIsSoroban)
     {
-        mMaxDexOperations =
-            std::make_optional<Resource>(*maxDexOps * multiplier);
+        int64_t dexOps = static_cast<int64_t>(*maxDexOps) * multiplier;
+        mMaxDexOperations = std::make_optional<Resource>(
+            mMaxQueueBytes ? Resource({dexOps, *mMaxQueueBytes})
+                           : Resource(dexOps));
     }
 
     mEnforceSingleAccounts =
@@ -63,8 +73,14 @@ TxQueueLimiter::size() const
 Resource
 TxQueueLimiter::maxScaledLedgerResources(bool isSoroban) const
 {
-    return multiplyByDouble(mLedgerManager.maxLedgerResources(isSoroban),
-                            mPoolLedgerMultiplier);
+    auto res = multiplyByDouble(mLedgerManager.maxLedgerResources(isSoroban),
+                                mPoolLedgerMultiplier);
+    if (!isSoroban && mMaxQueueBytes)
+    {
+        return Resource(
+            {res.getVal(Resource::Type::OPERATIONS), *mMaxQueueBytes});
+    }
+    return res;
 }
 
 void
@@ -84,7 +100,8 @@ TxQueueLimiter::addTransaction(TransactionFrameBasePtr const& tx)
                 "TxQueueLimiter");
         }
     }
-    auto txStack = std::make_shared<SingleTxStack>(tx);
+    auto txStack =
+        std::make_shared<SingleTxStack>(tx, mMaxQueueBytes.has_value());
     mStackForTx[tx] = txStack;
     mTxs->add(txStack);
 }
@@ -176,7 +193,7 @@ TxQueueLimiter::canAddTx(TransactionFrameBasePtr const& newTx,
     std::optional<Resource> oldTxDiscount = std::nullopt;
     if (oldTx)
     {
-        oldTxDiscount = oldTx->getResources(false);
+        oldTxDiscount = oldTx->getResources(mMaxQueueBytes.has_value());
     }
 
     // Update the operation limit in case upgrade happened. This is cheap
@@ -192,8 +209,7 @@ TxQueueLimiter::evictTransactions(
     TransactionFrameBase const& txToFit,
     std::function<void(TransactionFrameBasePtr const&)> evict)
 {
-    auto resourcesToFit =
-        txToFit.getResources(/* useByteLimitInClassic */ false);
+    auto resourcesToFit = mSurgePricingLaneConfig->getTxResources(txToFit);
 
     auto txToFitLane = mSurgePricingLaneConfig->getLane(txToFit);
 
@@ -259,9 +275,10 @@ TxQueueLimiter::reset(uint32_t ledgerVersion)
     {
         mSurgePricingLaneConfig = std::make_shared<DexLimitingLaneConfig>(
             maxScaledLedgerResources(mIsSoroban), mMaxDexOperations);
-        // Ensure byte limits aren't counted in tx limiter
+        // Ensure byte limits are only counted in tx limiter when configured
         releaseAssert(mSurgePricingLaneConfig->getLaneLimits()[0].size() ==
-                      NUM_CLASSIC_TX_RESOURCES);
+                      (mMaxQueueBytes ? NUM_CLASSIC_TX_BYTES_RESOURCES
+                                      : NUM_CLASSIC_TX_RESOURCES));
     }
 
     if (mSurgePricingLaneConfig)
@@ -16,7 +16,8 @@ namespace stellar
 class SingleTxStack : public TxStack
 {
   public:
-    SingleTxStack(TransactionFrameBasePtr tx) : mTx(tx)
+    SingleTxStack(TransactionFrameBasePtr tx, bool useByteLimitInClassic)
+        : mTx(tx), mUseByteLimitInClassic(useByteLimitInClassic)
     {
     }
 
@@ -44,11 +45,12 @@ class SingleTxStack : public TxStack
     getResources() const override
     {
         releaseAssert(mTx);
-        return Resource(mTx->getResources(/* useByteLimitInClassic */ false));
+        return Resource(mTx->getResources(mUseByteLimitInClassic));
     }
 
   private:
     TransactionFrameBasePtr mTx;
+    bool const mUseByteLimitInClassic;
 };
 
 class TxQueueLimiter
@@ -65,6 +67,10 @@ class TxQueueLimiter
     // When non-nullopt, limit the number dex operations by this value
     std::optional<Resource> mMaxDexOperations;
 
+    // When non-nullopt, limit the total size of the classic transactions by
+    // this value, in addition to their operations
+    std::optional<int64_t> mMaxQueueBytes;
+
     // Stores the maximum inclusion fee among the transactions evicted from
     // every tx lane. Inclusion fees are stored as ratios (fee_bid / num_ops).
     std::vector<std::pair<int64, uint32_t>> mLaneEvictedInclusionFee;
@@ -18,14 +18,15 @@
 #include "main/Config.h"
 #include "overlay/Peer.h"
 #include "transactions/TransactionUtils.h"
+#include "util/Arena.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
 #include <algorithm>
 #include <list>
 #include <numeric>
@@ -137,7 +138,7 @@ computeNonGenericTxSetContentsHash(TransactionSet const& xdrTxSet)
     hasher.add(xdrTxSet.previousLedgerHash);
     for (auto const& tx : xdrTxSet.txs)
     {
-        hasher.add(xdr::xdr_to_opaque(tx));
+        xdrSha256Add(hasher, tx);
     }
     return hasher.finish();
 }
@@ -471,22 +472,34 @@ makeTxSetFromTransactions(TxSetTransactions txs, Application& app,
 StellarMessage
 TxSetXDRFrame::toStellarMessage() const
 {
-    StellarMessage newMsg;
-    if (isGeneralizedTxSet())
-    {
-        newMsg.type(GENERALIZED_TX_SET);
-        toXDR(newMsg.generalizedTxSet());
-    }
-    else
-    {
-        newMsg.type(TX_SET);
-        toXDR(newMsg.txSet());
-    }
-    return newMsg;
+    return *getStellarMessage();
 }
 
 #endif
 
+std::shared_ptr<StellarMessage const>
+TxSetXDRFrame::getStellarMessage() const
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    if (!mStellarMessage)
+    {
+        auto newMsg = std::make_shared<StellarMessage>();
+        if (isGeneralizedTxSet())
+        {
+            newMsg->type(GENERALIZED_TX_SET);
+            toXDR(newMsg->generalizedTxSet());
+        }
+        else
+        {
+            newMsg->type(TX_SET);
+            toXDR(newMsg->txSet());
+        }
+        mStellarMessage = newMsg;
+    }
+    return mStellarMessage;
+}
+
 ApplicableTxSetFrameConstPtr
 TxSetXDRFrame::prepareForApply(Application& app) const
 {
@@ -498,6 +511,9 @@ TxSetXDRFrame::prepareForApply(Application& app) const
     }
 #endif
     ZoneScoped;
+    // All the frames of the set are allocated together and released once the
+    // last of them goes away
+    auto arena = std::make_shared<Arena>();
     std::unique_ptr<ApplicableTxSetFrame> txSet{};
     if (isGeneralizedTxSet())
     {
@@ -539,7 +555,7 @@ TxSetXDRFrame::prepareForApply(Application& app) const
                     if (!txSet->addTxsFromXdr(
                             app.getNetworkID(),
                             component.txsMaybeDiscountedFee().txs, true,
-                            baseFee, static_cast<TxSetPhase>(phaseId)))
+                            baseFee, static_cast<TxSetPhase>(phaseId), arena))
                     {
                         CLOG_DEBUG(Herder,
                                    "Got bad generalized txSet: transactions "
@@ -558,7 +574,7 @@ TxSetXDRFrame::prepareForApply(Application& app) const
         txSet = std::unique_ptr<ApplicableTxSetFrame>(new ApplicableTxSetFrame(
             app, false, previousLedgerHash(), {TxSetTransactions{}}, mHash));
         if (!txSet->addTxsFromXdr(app.getNetworkID(), xdrTxSet.txs, false,
-                                  std::nullopt, TxSetPhase::CLASSIC))
+                                  std::nullopt, TxSetPhase::CLASSIC, arena))
         {
             CLOG_DEBUG(Herder,
                        "Got bad txSet: transactions are not ordered correctly "
@@ -664,21 +680,30 @@ TxSetXDRFrame::sizeOpTotalForLogging() const
 TxSetPhaseTransactions
 TxSetXDRFrame::createTransactionFrames(Hash const& networkID) const
 {
+    ZoneScoped;
+    auto arena = std::make_shared<Arena>();
     TxSetPhaseTransactions phaseTxs;
     if (isGeneralizedTxSet())
     {
         auto const& txSet =
             std::get<GeneralizedTransactionSet>(mXDRTxSet).v1TxSet();
+        phaseTxs.reserve(txSet.phases.size());
         for (auto const& phase : txSet.phases)
         {
             auto& txs = phaseTxs.emplace_back();
+            size_t phaseSize = 0;
+            for (auto const& component : phase.v0Components())
+            {
+                phaseSize += component.txsMaybeDiscountedFee().txs.size();
+            }
+            txs.reserve(phaseSize);
             for (auto const& component : phase.v0Components())
             {
                 for (auto const& tx : component.txsMaybeDiscountedFee().txs)
                 {
                     txs.emplace_back(
-                        TransactionFrameBase::makeTransactionFromWire(networkID,
-                                                                      tx));
+                        TransactionFrameBase::makeTransactionFromWire(
+                            networkID, tx, arena));
                 }
             }
         }
@@ -687,12 +712,17 @@ TxSetXDRFrame::createTransactionFrames(Hash const& networkID) const
     {
         auto& txs = phaseTxs.emplace_back();
         auto const& txSet = std::get<TransactionSet>(mXDRTxSet).txs;
+        txs.reserve(txSet.size());
         for (auto const& tx : txSet)
         {
-            txs.emplace_back(
-                TransactionFrameBase::makeTransactionFromWire(networkID, tx));
+            txs.emplace_back(TransactionFrameBase::makeTransactionFromWire(
+                networkID, tx, arena));
         }
     }
+    for (auto const& txs : phaseTxs)
+    {
+        TransactionFrameBase::cacheHashes(txs);
+    }
     return phaseTxs;
 }
 
@@ -1338,7 +1368,8 @@ ApplicableTxSetFrame::isGeneralizedTxSet() const
 bool
 ApplicableTxSetFrame::addTxsFromXdr(
     Hash const& networkID, xdr::xvector<TransactionEnvelope> const& txs,
-    bool useBaseFee, std::optional<int64_t> baseFee, TxSetPhase phase)
+    bool useBaseFee, std::optional<int64_t> baseFee, TxSetPhase phase,
+    std::shared_ptr<Arena> const& arena)
 {
     auto& phaseTxs = mTxPhases.at(static_cast<int>(phase));
     size_t oldSize = phaseTxs.size();
@@ -1346,7 +1377,8 @@ ApplicableTxSetFrame::addTxsFromXdr(
 
     for (auto const& env : txs)
     {
-        auto tx = TransactionFrameBase::makeTransactionFromWire(networkID, env);
+        auto tx = TransactionFrameBase::makeTransactionFromWire(networkID, env,
+                                                                arena);
         if (!tx->XDRProvidesValidFee())
         {
             return false;
@@ -1364,6 +1396,7 @@ ApplicableTxSetFrame::addTxsFromXdr(
             getInclusionFeeMap(phase)[tx] = baseFee;
         }
     }
+    TransactionFrameBase::cacheHashes(phaseTxs);
     return std::is_sorted(phaseTxs.begin() + oldSize, phaseTxs.end(),
                           &TxSetUtils::hashTxSorter);
 }
@@ -1385,13 +1418,30 @@ ApplicableTxSetFrame::applySurgePricing(Application& app)
     auto const& lclHeader =
         app.getLedgerManager().getLastClosedLedgerHeader().header;
 
+    // Ranking the transactions by fee rate only matters when they don't all
+    // fit, so it's skipped when the queue they come from isn't congested
+    auto selectTxs = [](TxSetTransactions const& txs,
+                        std::shared_ptr<SurgePricingLaneConfig> laneConfig,
+                        std::vector<bool>& hadTxNotFittingLane) {
+        if (SurgePricingPriorityQueue::allTxsFitWithinLimits(txs,
+                                                             *laneConfig))
+        {
+            hadTxNotFittingLane.assign(laneConfig->getLaneLimits().size(),
+                                       false);
+            return txs;
+        }
+        auto actTxQueues = TxSetUtils::buildAccountTxQueues(txs);
+        return SurgePricingPriorityQueue::getMostTopTxsWithinLimits(
+            std::vector<TxStackPtr>(actTxQueues.begin(), actTxQueues.end()),
+            laneConfig, hadTxNotFittingLane);
+    };
+
     releaseAssert(mTxPhases.size() <=
                   static_cast<int>(TxSetPhase::PHASE_COUNT));
     for (int i = 0; i < mTxPhases.size(); i++)
     {
         TxSetPhase phaseType = static_cast<TxSetPhase>(i);
         auto& phase = mTxPhases[i];
-        auto actTxQueues = TxSetUtils::buildAccountTxQueues(phase);
 
         if (phaseType == TxSetPhase::CLASSIC)
         {
@@ -1415,11 +1465,8 @@ ApplicableTxSetFrame::applySurgePricing(Application& app)
                 std::make_shared<DexLimitingLaneConfig>(maxOps, dexOpsLimit);
 
             std::vector<bool> hadTxNotFittingLane;
-            auto includedTxs =
-                SurgePricingPriorityQueue::getMostTopTxsWithinLimits(
-                    std::vector<TxStackPtr>(actTxQueues.begin(),
-                                            actTxQueues.end()),
-                    surgePricingLaneConfig, hadTxNotFittingLane);
+            auto includedTxs = selectTxs(phase, surgePricingLaneConfig,
+                                         hadTxNotFittingLane);
 
             size_t laneCount = surgePricingLaneConfig->getLaneLimits().size();
             std::vector<int64_t> lowestLaneFee(
@@ -1463,11 +1510,8 @@ ApplicableTxSetFrame::applySurgePricing(Application& app)
                 std::make_shared<SorobanGenericLaneConfig>(limits);
 
             std::vector<bool> hadTxNotFittingLane;
-            auto includedTxs =
-                SurgePricingPriorityQueue::getMostTopTxsWithinLimits(
-                    std::vector<TxStackPtr>(actTxQueues.begin(),
-                                            actTxQueues.end()),
-                    surgePricingLaneConfig, hadTxNotFittingLane);
+            auto includedTxs = selectTxs(phase, surgePricingLaneConfig,
+                                         hadTxNotFittingLane);
 
             size_t laneCount = surgePricingLaneConfig->getLaneLimits().size();
             std::vector<int64_t> lowestLaneFee(
@@ -20,6 +20,7 @@
 namespace stellar
 {
 class Application;
+class Arena;
 class TxSetXDRFrame;
 class ApplicableTxSetFrame;
 using TxSetXDRFrameConstPtr = std::shared_ptr<TxSetXDRFrame const>;
@@ -172,6 +173,12 @@ class TxSetXDRFrame : public NonMovableOrCopyable
     // getTransactionsForPhase() in `ApplicableTxSetFrame`.
     TxSetPhaseTransactions createTransactionFrames(Hash const& networkID) const;
 
+    // Returns the TX_SET or GENERALIZED_TX_SET message with this tx set.
+    // The message is built on the first call and shared by the later ones,
+    // so that sending the tx set to many peers doesn't copy it every time.
+    // This must only be called from the main thread.
+    std::shared_ptr<StellarMessage const> getStellarMessage() const;
+
 #ifdef BUILD_TESTS
     mutable ApplicableTxSetFrameConstPtr mApplicableTxSetOverride;
 
@@ -185,6 +192,7 @@ class TxSetXDRFrame : public NonMovableOrCopyable
     std::variant<TransactionSet, GeneralizedTransactionSet> mXDRTxSet;
     size_t mEncodedSize{};
     Hash mHash;
+    mutable std::shared_ptr<StellarMessage const> mStellarMessage;
 };
 
 // Transaction set that is suitable for being applied to the ledger.
@@ -312,10 +320,11 @@ class ApplicableTxSetFrame
     // sets won't exist in the network anymore.
     void computeTxFeesForNonGeneralizedSet(LedgerHeader const& lclHeader) const;
 
+    // The frames are allocated from `arena`, see makeTransactionFromWire
     bool addTxsFromXdr(Hash const& networkID,
                        xdr::xvector<TransactionEnvelope> const& txs,
                        bool useBaseFee, std::optional<int64_t> baseFee,
-                       TxSetPhase phase);
+                       TxSetPhase phase, std::shared_ptr<Arena> const& arena);
     void applySurgePricing(Application& app);
 
     void computeTxFeesForNonGeneralizedSet(LedgerHeader const& lclHeader,
@@ -21,9 +21,9 @@
 #include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
 #include <algorithm>
 #include <list>
 #include <numeric>
@@ -56,6 +56,26 @@ removeTxs(TxSetTransactions const& txs, TxSetTransactions const& txsToRemove)
 
     return newTxs;
 }
+
+// Loads the source and fee source accounts of `txs` into the LedgerTxnRoot
+// cache in one batch, so that validating the account queues one after the
+// other doesn't load them one at a time. With BucketListDB the batch is split
+// across the prefetch worker threads, each searching a snapshot of its own.
+void
+prefetchSourceAccounts(Application& app, TxSetTransactions const& txs)
+{
+    ZoneScoped;
+    if (app.getConfig().PREFETCH_BATCH_SIZE == 0)
+    {
+        return;
+    }
+    UnorderedSet<LedgerKey> keys;
+    for (auto const& tx : txs)
+    {
+        tx->insertKeysForFeeProcessing(keys);
+    }
+    app.getLedgerTxnRoot().prefetch(keys);
+}
 } // namespace
 
 AccountTransactionQueue::AccountTransactionQueue(
@@ -171,11 +191,24 @@ TxSetUtils::getInvalidTxList(TxSetTransactions const& txs, Application& app,
         ltx.loadHeader().current().ledgerSeq =
             app.getLedgerManager().getLastClosedLedgerNum() + 1;
     }
+    auto const ledgerVersion = ltx.loadHeader().current().ledgerVersion;
+    if (protocolVersionStartsFrom(ledgerVersion, SOROBAN_PROTOCOL_VERSION) &&
+        std::any_of(txs.begin(), txs.end(),
+                    [](auto const& tx) { return tx->isSoroban(); }))
+    {
+        TransactionFrame::precomputePreApplySorobanResourceFees(
+            txs, ledgerVersion,
+            app.getLedgerManager().getSorobanNetworkConfig(),
+            app.getConfig());
+    }
 
     UnorderedMap<AccountID, int64_t> accountFeeMap;
     TxSetTransactions invalidTxs;
 
     auto accountTxQueues = buildAccountTxQueues(txs);
+    verifySignaturesInParallel(
+        app, txs, app.getConfig().TX_SET_VALIDATION_SIG_VERIFY_THREADS);
+    prefetchSourceAccounts(app, txs);
     for (auto& accountQueue : accountTxQueues)
     {
         int64_t lastSeq = 0;
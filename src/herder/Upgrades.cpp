@@ -26,9 +26,9 @@
 #include "util/ProtocolVersion.h"
 #include "util/Timer.h"
 #include "util/XDRCereal.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdrpp/printer.h"
-#include <Tracy.hpp>
 #include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <cereal/types/optional.hpp>
@@ -772,12 +772,13 @@ Upgrades::storeUpgradeHistory(Database& db, uint32_t ledgerSeq,
     }
 }
 
-void
-Upgrades::deleteOldEntries(Database& db, uint32_t ledgerSeq, uint32_t count)
+uint64_t
+Upgrades::deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                           uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "upgradehistory", "ledgerseq");
+    return DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                 "upgradehistory", "ledgerseq");
 }
 
 void
@@ -1355,7 +1356,7 @@ bool
 ConfigUpgradeSetFrame::isValidXDR(ConfigUpgradeSet const& upgradeSetXDR,
                                   ConfigUpgradeSetKey const& key) const
 {
-    if (key.contentHash != sha256(xdr::xdr_to_opaque(upgradeSetXDR)))
+    if (key.contentHash != xdrSha256(upgradeSetXDR))
     {
         CLOG_DEBUG(Herder,
                    "Got bad configUpgradeSet. Does not match hash in key {}",
@@ -13,6 +13,11 @@
 #include <stdint.h>
 #include <vector>
 
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 class AbstractLedgerTxn;
@@ -124,8 +129,8 @@ class Upgrades
                                     LedgerUpgrade const& upgrade,
                                     LedgerEntryChanges const& changes,
                                     int index);
-    static void deleteOldEntries(Database& db, uint32_t ledgerSeq,
-                                 uint32_t count);
+    static uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                     uint32_t count);
     static void deleteNewerEntries(Database& db, uint32_t ledgerSeq);
 
   private:
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "herder/HerderImpl.h"
+#include "herder/HerderPersistence.h"
 #include "herder/LedgerCloseData.h"
 #include "herder/test/TestTxSetUtils.h"
 #include "main/Application.h"
@@ -4914,6 +4915,48 @@ TEST_CASE("do not flood invalid transactions", "[herder]")
     REQUIRE(txSet->checkValid(*app, 0, 0));
 }
 
+TEST_CASE("adaptive transaction flood pacing", "[herder][transactionqueue]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.FLOOD_TX_PERIOD_MS = 10000;
+    cfg.ADAPTIVE_TX_FLOOD_PACING = true;
+    auto app = createTestApplication(clock, cfg);
+
+    auto& lm = app->getLedgerManager();
+    auto& herder = static_cast<HerderImpl&>(app->getHerder());
+    auto& tq = herder.getTransactionQueue();
+    std::chrono::milliseconds const period(cfg.FLOOD_TX_PERIOD_MS);
+
+    auto root = TestAccount::createRoot(*app);
+    auto acc = root.create("A", lm.getLastMinBalance(2));
+
+    std::vector<VirtualClock::time_point> broadcastTimes;
+    tq.mTxBroadcastedEvent = [&](TransactionFrameBasePtr&) {
+        broadcastTimes.emplace_back(clock.now());
+    };
+    auto crankUntilBroadcast = [&](size_t n) {
+        auto timeout = clock.now() + 3 * period;
+        while (broadcastTimes.size() < n)
+        {
+            clock.crank(true);
+            REQUIRE(clock.now() < timeout);
+        }
+    };
+
+    auto start = clock.now();
+    herder.recvTransaction(root.tx({payment(root, 1)}), false);
+    crankUntilBroadcast(1);
+    // Nothing was waiting to be flooded, so the transaction doesn't wait for
+    // the flood period
+    REQUIRE(broadcastTimes[0] - start < period);
+
+    // A round just happened, so the next one waits for the flood period
+    herder.recvTransaction(acc.tx({payment(acc, 1)}), false);
+    crankUntilBroadcast(2);
+    REQUIRE(broadcastTimes[1] - broadcastTimes[0] >= period);
+}
+
 TEST_CASE("do not flood too many soroban transactions",
           "[soroban][herder][transactionqueue]")
 {
@@ -5852,7 +5895,7 @@ TEST_CASE("exclude transactions by operation type", "[herder]")
     }
 }
 
-// Test that Herder updates the scphistory table with additional messages from
+// Test that Herder updates the SCP history with additional messages from
 // ledger `n-1` when closing ledger `n`
 TEST_CASE("SCP message capture from previous ledger", "[herder]")
 {
@@ -5889,44 +5932,32 @@ TEST_CASE("SCP message capture from previous ledger", "[herder]")
         },
         4 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
 
-    // Check that a node's scphistory table for a given ledger has the correct
+    // Check that a node's SCP history for a given ledger has the correct
     // number of entries of each type in `expectedTypes`
     auto checkSCPHistoryEntries =
         [&](Application::pointer node, uint32_t ledgerNum,
             UnorderedMap<SCPStatementType, size_t> const& expectedTypes) {
-            // Prepare query
-            auto& db = node->getDatabase();
-            auto prep = db.getPreparedStatement(
-                "SELECT envelope FROM scphistory WHERE ledgerseq = :l");
-            auto& st = prep.statement();
-            st.exchange(soci::use(ledgerNum));
-            std::string envStr;
-            st.exchange(soci::into(envStr));
-            st.define_and_bind();
-            st.execute(false);
+            auto envs = node->getHerderPersistence().getSCPHistory(
+                node->getDatabase().getSession(), ledgerNum);
 
             // Count the number of entries of each type
             UnorderedMap<SCPStatementType, size_t> actualTypes;
-            while (st.fetch())
+            for (auto const& env : envs)
             {
-                Value v;
-                decoder::decode_b64(envStr, v);
-                SCPEnvelope env;
-                xdr::xdr_from_opaque(v, env);
                 ++actualTypes[env.statement.pledges.type()];
             }
 
             return actualTypes == expectedTypes;
         };
 
-    // Expected counts of scphistory entry types for ledger 2
+    // Expected counts of SCP history entry types for ledger 2
     UnorderedMap<SCPStatementType, size_t> expConfExt = {
         {SCPStatementType::SCP_ST_CONFIRM, 1},
         {SCPStatementType::SCP_ST_EXTERNALIZE, 1}};
     UnorderedMap<SCPStatementType, size_t> exp2Ext = {
         {SCPStatementType::SCP_ST_EXTERNALIZE, 2}};
 
-    // Examine scphistory tables for A and B for ledger 2. Either A has 1
+    // Examine SCP history of A and B for ledger 2. Either A has 1
     // CONFIRM and 1 EXTERNALIZE and B has 2 EXTERNALIZEs, or A has 2
     // EXTERNALIZEs and B has 1 CONFIRM and 1 EXTERNALIZE.
     REQUIRE((checkSCPHistoryEntries(A, 2, expConfExt) &&
@@ -5934,7 +5965,7 @@ TEST_CASE("SCP message capture from previous ledger", "[herder]")
             (checkSCPHistoryEntries(A, 2, exp2Ext) &&
              checkSCPHistoryEntries(B, 2, expConfExt)));
 
-    // C has no entries in its scphistory table for ledger 2.
+    // C has no entries in its SCP history for ledger 2.
     REQUIRE(checkSCPHistoryEntries(C, 2, {}));
 
     // Get messages from A and B
@@ -5977,7 +6008,7 @@ TEST_CASE("SCP message capture from previous ledger", "[herder]")
         },
         4 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
 
-    // A and B should now each have 3 EXTERNALIZEs in their scphistory table for
+    // A and B should now each have 3 EXTERNALIZEs in their SCP history for
     // ledger 2. A's CONFIRM entry has been replaced with an EXTERNALIZE.
     UnorderedMap<SCPStatementType, size_t> const expectedTypes = {
         {SCPStatementType::SCP_ST_EXTERNALIZE, 3}};
@@ -5991,8 +6022,58 @@ TEST_CASE("SCP message capture from previous ledger", "[herder]")
         [&]() { return C->getLedgerManager().getLastClosedLedgerNum() == 3; },
         4 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
 
-    // C should have 3 EXTERNALIZEs in its scphistory table for ledger 2. This
+    // C should have 3 EXTERNALIZEs in its SCP history for ledger 2. This
     // check ensures that C does not double count messages from ledger 2 when
     // closing ledger 3.
     REQUIRE(checkSCPHistoryEntries(C, 2, expectedTypes));
-}
\ No newline at end of file
+}
+TEST_CASE("SCP history saves quorum information", "[herder]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    auto& herder = static_cast<HerderImpl&>(app->getHerder());
+    auto& persistence = app->getHerderPersistence();
+    auto& db = app->getDatabase();
+
+    auto localQSet = herder.getSCP().getLocalQuorumSet();
+    auto localQSetHash = xdrSha256(localQSet);
+    auto makeEnvelope = [&](uint64_t slotIndex) {
+        SCPEnvelope env;
+        env.statement.nodeID = app->getConfig().NODE_SEED.getPublicKey();
+        env.statement.slotIndex = slotIndex;
+        env.statement.pledges.type(SCP_ST_EXTERNALIZE);
+        env.statement.pledges.externalize().commitQuorumSetHash =
+            localQSetHash;
+        return env;
+    };
+
+    auto otherNode = SecretKey::pseudoRandomForTesting().getPublicKey();
+    auto otherQSet = std::make_shared<SCPQuorumSet>();
+    otherQSet->threshold = 1;
+    otherQSet->validators.emplace_back(otherNode);
+    auto otherQSetHash = xdrSha256(*otherQSet);
+
+    QuorumTracker::QuorumMap qmap;
+    qmap[otherNode].mQuorumSet = std::make_shared<SCPQuorumSet>(localQSet);
+    persistence.saveSCPHistory(2, {makeEnvelope(2)}, qmap);
+    auto nodeQSet =
+        HerderPersistence::getNodeQuorumSet(db, db.getSession(), otherNode);
+    REQUIRE(nodeQSet);
+    REQUIRE(*nodeQSet == localQSetHash);
+    REQUIRE(HerderPersistence::getQuorumSet(db, db.getSession(),
+                                            localQSetHash));
+
+    // Saving the next ledger updates the rows saved for the previous one
+    qmap[otherNode].mQuorumSet = otherQSet;
+    persistence.saveSCPHistory(3, {makeEnvelope(3)}, qmap);
+    nodeQSet =
+        HerderPersistence::getNodeQuorumSet(db, db.getSession(), otherNode);
+    REQUIRE(nodeQSet);
+    REQUIRE(*nodeQSet == otherQSetHash);
+    auto saved =
+        HerderPersistence::getQuorumSet(db, db.getSession(), otherQSetHash);
+    REQUIRE(saved);
+    REQUIRE(*saved == *otherQSet);
+    REQUIRE(HerderPersistence::getQuorumSet(db, db.getSession(),
+                                            localQSetHash));
+}
@@ -8,7 +8,9 @@
 #include "lib/catch.hpp"
 #include "main/Config.h"
 #include "scp/LocalNode.h"
+#include "test/MicroBenchmark.h"
 #include "test/test.h"
+#include "util/BitSet.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "xdrpp/marshal.h"
@@ -875,6 +877,57 @@ TEST_CASE("quorum intersection scaling test",
     REQUIRE(qic->networkEnjoysQuorumIntersection());
 }
 
+TEST_CASE("quorum intersection bitset microbench",
+          "[herder][quorumintersection][microbench][bench][!hide]")
+{
+    // The set operations of the checker's innermost loops, on sets of nodes
+    // of a network small enough for BitSet's inline storage and of one that
+    // isn't. Compare builds with and without AVX2 / NEON to see what the
+    // vectorized loops of cbitset buy.
+    for (size_t nodes : {200, 1000})
+    {
+        std::vector<BitSet> sets(64);
+        for (auto& bs : sets)
+        {
+            for (size_t i = 0; i < nodes; ++i)
+            {
+                if (rand_flip())
+                {
+                    bs.set(i);
+                }
+            }
+        }
+        size_t total = 0;
+        auto bench =
+            [&](std::string const& op,
+                std::function<size_t(BitSet const&, BitSet const&)> f) {
+                runMicroBenchmark(
+                    fmt::format("quorumintersection.bitset-{}-{}", op, nodes),
+                    [&]() {
+                        for (size_t i = 0; i < sets.size(); ++i)
+                        {
+                            total += f(sets[i], sets[(i + 1) % sets.size()]);
+                        }
+                        return sets.size();
+                    });
+            };
+        bench("union", [](BitSet const& a, BitSet const& b) -> size_t {
+            BitSet tmp(a);
+            tmp.inplaceUnion(b);
+            return tmp.get(0);
+        });
+        bench("intersection-count", [](BitSet const& a, BitSet const& b) {
+            BitSet tmp(a);
+            tmp.inplaceIntersection(b);
+            return tmp.count();
+        });
+        bench("subset", [](BitSet const& a, BitSet const& b) -> size_t {
+            return a.isSubsetEq(a | b);
+        });
+        REQUIRE(total != 0);
+    }
+}
+
 TEST_CASE("quorum intersection interruption", "[herder][quorumintersection]")
 {
     auto orgs = generateOrgs(16);
@@ -992,6 +1045,104 @@ TEST_CASE("quorum intersection criticality",
     REQUIRE(groups == std::set<std::set<PublicKey>>{{orgs[3][0]}});
 }
 
+TEST_CASE("quorum intersection checked on several threads",
+          "[herder][quorumintersection]")
+{
+    auto threads = GENERATE(1u, 2u, 4u);
+    Config cfg(getTestConfig());
+    cfg.QUORUM_INTERSECTION_CHECKER_THREADS = threads;
+    std::atomic<bool> flag{false};
+
+    SECTION("intersecting")
+    {
+        auto orgs = generateOrgs(6, {3});
+        auto qm =
+            interconnectOrgs(orgs, [](size_t i, size_t j) { return true; });
+        cfg = configureShortNames(cfg, orgs);
+        auto qic =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        REQUIRE(qic->networkEnjoysQuorumIntersection());
+    }
+    SECTION("not intersecting")
+    {
+        // Any 4 of the 10 nodes make a quorum, all in a single SCC.
+        auto orgs = generateOrgs(10, {1});
+        auto qm = interconnectOrgs(
+            orgs, [](size_t i, size_t j) { return true; },
+            /*ownThreshPct=*/34);
+        cfg = configureShortNames(cfg, orgs);
+        auto qic =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        REQUIRE(!qic->networkEnjoysQuorumIntersection());
+        auto split = qic->getPotentialSplit();
+        REQUIRE(!split.first.empty());
+        REQUIRE(!split.second.empty());
+    }
+    SECTION("criticality")
+    {
+        // Same network as in the criticality test above.
+        auto orgs = generateOrgs(7, {1});
+        auto qm = interconnectOrgsBidir(
+            orgs,
+            {{0, 1}, {1, 2}, {4, 5}, {4, 6}, {5, 6}, {0, 3}, {1, 3}, {2, 3},
+             {4, 3}, {6, 3}});
+        cfg = configureShortNames(cfg, orgs);
+        auto groups = QuorumIntersectionChecker::getIntersectionCriticalGroups(
+            qm, cfg, flag, gRandomEngine());
+        REQUIRE(groups == std::set<std::set<PublicKey>>{{orgs[3][0]}});
+    }
+}
+
+TEST_CASE("quorum intersection reuses scan of unchanged SCC",
+          "[herder][quorumintersection]")
+{
+    // Six fully-connected orgs, plus a node outside of their SCC that
+    // depends on them but that no one depends on.
+    auto orgs = generateOrgs(6, {3});
+    auto qm = interconnectOrgs(orgs, [](size_t i, size_t j) { return true; });
+    auto outside = SecretKey::pseudoRandomForTesting().getPublicKey();
+    qm[outside] = QuorumTracker::NodeInfo{
+        make_shared<QS>(1, VK({orgs[0][0]}), VQ{}), 0};
+    Config cfg(getTestConfig());
+    cfg = configureShortNames(cfg, orgs);
+    std::atomic<bool> flag{false};
+
+    auto qic =
+        QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+    REQUIRE(qic->networkEnjoysQuorumIntersection());
+    auto scan = qic->getScanResult();
+    REQUIRE(scan);
+    REQUIRE(scan->mScanSCC.size() == 18);
+    REQUIRE(!scan->mFoundDisjoint);
+
+    SECTION("change outside of the SCC")
+    {
+        qm[outside] = QuorumTracker::NodeInfo{
+            make_shared<QS>(2, VK({orgs[0][0], orgs[1][0]}), VQ{}), 0};
+        auto next =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        next->setPriorScanResult(scan);
+        REQUIRE(next->networkEnjoysQuorumIntersection());
+        REQUIRE(next->getScanResult() == scan);
+    }
+    SECTION("change inside of the SCC")
+    {
+        // Any 2 of the 6 orgs now make a quorum for the nodes of org0.
+        auto qs = make_shared<QS>(*qm[orgs[0][0]].mQuorumSet);
+        qs->threshold = 2;
+        qs->validators.clear();
+        for (auto const& pk : orgs[0])
+        {
+            qm[pk] = QuorumTracker::NodeInfo{qs, 0};
+        }
+        auto next =
+            QuorumIntersectionChecker::create(qm, cfg, flag, gRandomEngine());
+        next->setPriorScanResult(scan);
+        next->networkEnjoysQuorumIntersection();
+        REQUIRE(next->getScanResult() != scan);
+    }
+}
+
 TEST_CASE("quorum intersection finds smaller SCC with quorums",
           "[herder][quorumintersectionsize]")
 {
@@ -10,6 +10,7 @@
 #include "scp/SCP.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
+#include "util/Math.h"
 #include "xdr/Stellar-ledger.h"
 
 using namespace stellar;
@@ -352,3 +353,80 @@ TEST_CASE("quorum tracker closest validators", "[quorum][herder]")
         }
     }
 }
+
+TEST_CASE("quorum tracker update matches rebuild", "[quorum][herder]")
+{
+    std::vector<NodeID> keys;
+    for (int i = 0; i < 20; i++)
+    {
+        keys.emplace_back(SecretKey::pseudoRandomForTesting().getPublicKey());
+    }
+    auto const& localNodeID = keys[0];
+
+    auto randomQSet = [&]() {
+        auto q = std::make_shared<SCPQuorumSet>();
+        auto n = rand_uniform<size_t>(0, 3);
+        for (size_t i = 0; i < n; i++)
+        {
+            q->validators.emplace_back(rand_element(keys));
+        }
+        if (rand_flip())
+        {
+            SCPQuorumSet inner;
+            inner.threshold = 1;
+            inner.validators.emplace_back(rand_element(keys));
+            q->innerSets.emplace_back(inner);
+        }
+        q->threshold = static_cast<uint32>(
+            std::max<size_t>(1, q->validators.size()));
+        return q;
+    };
+
+    for (int round = 0; round < 50; round++)
+    {
+        std::map<NodeID, SCPQuorumSetPtr> qSets;
+        for (auto const& key : keys)
+        {
+            // Leave some of the quorum sets unknown
+            if (key == localNodeID || rand_uniform(0, 4) != 0)
+            {
+                qSets[key] = randomQSet();
+            }
+        }
+        auto lookup = [&](NodeID const& id) -> SCPQuorumSetPtr {
+            auto it = qSets.find(id);
+            return it == qSets.end() ? nullptr : it->second;
+        };
+
+        QuorumTracker qt(localNodeID);
+        qt.rebuild(lookup);
+        for (int change = 0; change < 20; change++)
+        {
+            auto const& id = rand_element(keys);
+            auto qSet = randomQSet();
+            qSets[id] = qSet;
+            if (!qt.isNodeDefinitelyInQuorum(id))
+            {
+                REQUIRE_FALSE(qt.update(id, qSet, lookup));
+                continue;
+            }
+            REQUIRE(qt.update(id, qSet, lookup));
+
+            // Incremental updates (including dropping the nodes no longer
+            // reachable) arrive at the quorum a rebuild finds
+            QuorumTracker expected(localNodeID);
+            expected.rebuild(lookup);
+            auto const& got = qt.getQuorum();
+            REQUIRE(got.size() == expected.getQuorum().size());
+            for (auto const& kv : expected.getQuorum())
+            {
+                auto it = got.find(kv.first);
+                REQUIRE(it != got.end());
+                REQUIRE(it->second.mQuorumSet == kv.second.mQuorumSet);
+                REQUIRE(it->second.mDistance == kv.second.mDistance);
+                REQUIRE(it->second.mClosestValidators ==
+                        kv.second.mClosestValidators);
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/Hex.h"
+#include "crypto/Random.h"
+#include "herder/SCPHistoryLog.h"
+#include "lib/catch.hpp"
+#include "util/Fs.h"
+#include "util/Timer.h"
+#include "util/TmpDir.h"
+#include "util/XDROperators.h"
+
+#include <fstream>
+
+using namespace stellar;
+
+namespace
+{
+std::vector<SCPEnvelope>
+makeEnvelopes(uint32_t ledgerSeq, size_t n)
+{
+    std::vector<SCPEnvelope> res(n);
+    for (auto& env : res)
+    {
+        env.statement.slotIndex = ledgerSeq;
+        env.statement.pledges.type(SCP_ST_EXTERNALIZE);
+        env.statement.pledges.externalize().commit.counter = ledgerSeq;
+    }
+    return res;
+}
+}
+
+TEST_CASE("SCP history log", "[herder][scphistory]")
+{
+    TmpDirManager tdm(std::string("scp-history-log-") +
+                      binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("scp-history-log");
+    std::string dir = td.getName() + "/log";
+    VirtualClock clock;
+    uint32_t const freq = 8;
+
+    auto log = std::make_unique<SCPHistoryLog>(clock.getIOContext(), dir, freq,
+                                               false);
+    for (uint32_t seq = 2; seq < 30; ++seq)
+    {
+        log->append(seq, makeEnvelopes(seq, 1));
+    }
+    // the messages of a ledger are saved again with the next ledger
+    log->append(9, makeEnvelopes(9, 3));
+
+    SECTION("read")
+    {
+        auto res = log->read(8, 8);
+        REQUIRE(res.size() == 8);
+        REQUIRE(res.begin()->first == 8);
+        REQUIRE(res.rbegin()->first == 15);
+        REQUIRE(res[9] == makeEnvelopes(9, 3));
+        REQUIRE(res[10] == makeEnvelopes(10, 1));
+        REQUIRE(log->read(30, 8).empty());
+    }
+    SECTION("delete old entries")
+    {
+        log->deleteOldEntries(20);
+        REQUIRE(log->read(0, 16).empty());
+        // the checkpoint of ledgers 16 to 23 is kept as a whole
+        REQUIRE(log->read(16, 16).size() == 14);
+    }
+    SECTION("delete newer entries")
+    {
+        log->deleteNewerEntries(13);
+        auto res = log->read(0, 32);
+        REQUIRE(res.size() == 11);
+        REQUIRE(res.rbegin()->first == 12);
+
+        log->append(13, makeEnvelopes(13, 2));
+        REQUIRE(log->read(13, 1)[13] == makeEnvelopes(13, 2));
+    }
+    SECTION("torn tail is dropped on restart")
+    {
+        log.reset();
+        {
+            std::ofstream out(dir + "/scp-" + fs::hexStr(29 / freq) + ".xdr",
+                              std::ios::binary | std::ios::app);
+            out.write("\x80\x00\x01\x00\x01", 5);
+        }
+        log = std::make_unique<SCPHistoryLog>(clock.getIOContext(), dir, freq,
+                                              false);
+        log->append(30, makeEnvelopes(30, 1));
+        auto res = log->read(24, 8);
+        REQUIRE(res.size() == 7);
+        REQUIRE(res[30] == makeEnvelopes(30, 1));
+    }
+}
@@ -1515,7 +1515,7 @@ TEST_CASE("Soroban TransactionQueue limits",
             SECTION("limited evicts")
             {
                 // Add 2 generic transactions to reach generic limit
-                queue->add(std::make_shared<SingleTxStack>(tx));
+                queue->add(std::make_shared<SingleTxStack>(tx, false));
                 resources.instructions =
                     static_cast<uint32>(conf.ledgerMaxInstructions() / 2);
                 // The fee is slightly higher so this transactions is more
@@ -1529,7 +1529,8 @@ TEST_CASE("Soroban TransactionQueue limits",
                                                  toEvict)
                             .first);
                 REQUIRE(toEvict.empty());
-                queue->add(std::make_shared<SingleTxStack>(secondGeneric));
+                queue->add(
+                    std::make_shared<SingleTxStack>(secondGeneric, false));
 
                 SECTION("limited evicts generic")
                 {
@@ -1553,7 +1554,7 @@ TEST_CASE("Soroban TransactionQueue limits",
                     REQUIRE(
                         queue->canFitWithEviction(*tx2, std::nullopt, toEvict)
                             .first);
-                    queue->add(std::make_shared<SingleTxStack>(tx2));
+                    queue->add(std::make_shared<SingleTxStack>(tx2, false));
 
                     // Add, new tx with max limited lane resources, set a high
                     // fee
@@ -1735,6 +1736,12 @@ TEST_CASE("TransactionQueue limits", "[herder][transactionqueue]")
     {
         checkAndAddTx(false, account4, 3, 3 * 300, 0, 0);
     }
+    SECTION("not enough cheaper transactions to evict")
+    {
+        // Only 2 operations have a lower fee rate than 250, so the required
+        // fee is reported even though account5 can't evict its own tx
+        checkAndAddTx(false, account5, 4, 4 * 250, 4 * 300 + 1, 0);
+    }
     SECTION("evict all")
     {
         checkAndAddTx(true, account6, 6, 6 * 500, 0, 5);
@@ -1759,6 +1766,78 @@ TEST_CASE("TransactionQueue limits", "[herder][transactionqueue]")
     }
 }
 
+TEST_CASE("TransactionQueue limiter with byte limit",
+          "[herder][transactionqueue]")
+{
+    // All the transactions below are 1 operation payments of the same size
+    uint32_t txSize = 0;
+    {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, getTestConfig());
+        auto root = TestAccount::createRoot(*app);
+        txSize = static_cast<uint32_t>(
+            xdr::xdr_size(transaction(*app, root, 1, 1, 100)->getEnvelope()));
+    }
+
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 100;
+    // Fits 3 transactions, way below the operation limit
+    cfg.CLASSIC_TRANSACTION_QUEUE_MAX_BYTES = 3 * txSize + txSize / 2;
+    auto app = createTestApplication(clock, cfg);
+    auto const minBalance2 = app->getLedgerManager().getLastMinBalance(2);
+
+    auto root = TestAccount::createRoot(*app);
+    std::vector<TestAccount> accounts;
+    accounts.reserve(5);
+    for (int i = 0; i < 5; ++i)
+    {
+        accounts.emplace_back(root.create(fmt::format("a{}", i), minBalance2));
+    }
+
+    TxQueueLimiter limiter(1, *app, false);
+    TransactionFrameBasePtr noTx;
+
+    auto checkAndAddTx = [&](TestAccount& account, uint32 fee, bool expected,
+                             std::vector<TransactionFrameBasePtr> expEvicted) {
+        auto tx = transaction(*app, account, 1, 1, fee);
+        REQUIRE(xdr::xdr_size(tx->getEnvelope()) == txSize);
+        std::vector<std::pair<TxStackPtr, bool>> txsToEvict;
+        auto can = limiter.canAddTx(tx, noTx, txsToEvict);
+        REQUIRE(can.first == expected);
+        if (can.first)
+        {
+            std::vector<TransactionFrameBasePtr> evicted;
+            limiter.evictTransactions(
+                txsToEvict, *tx, [&](TransactionFrameBasePtr const& evict) {
+                    evicted.emplace_back(evict);
+                    limiter.removeTransaction(evict);
+                });
+            REQUIRE(evicted == expEvicted);
+            limiter.addTransaction(tx);
+        }
+        return tx;
+    };
+
+    auto tx100 = checkAndAddTx(accounts[0], 100, true, {});
+    auto tx300 = checkAndAddTx(accounts[1], 300, true, {});
+    auto tx200 = checkAndAddTx(accounts[2], 200, true, {});
+    REQUIRE(limiter.size() == 3);
+
+    SECTION("can't evict transaction with the same fee")
+    {
+        checkAndAddTx(accounts[3], 100, false, {});
+    }
+    SECTION("evict lowest fee transactions first")
+    {
+        checkAndAddTx(accounts[3], 400, true, {tx100});
+        checkAndAddTx(accounts[4], 400, true, {tx200});
+        REQUIRE(limiter.size() == 3);
+        // 200 fee transaction was evicted
+        checkAndAddTx(accounts[0], 200, false, {});
+    }
+}
+
 TEST_CASE("TransactionQueue limiter with DEX separation",
           "[herder][transactionqueue]")
 {
@@ -2,17 +2,23 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "herder/SurgePricingUtils.h"
 #include "herder/TxSetFrame.h"
 #include "herder/test/TestTxSetUtils.h"
 #include "ledger/LedgerManager.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "overlay/Peer.h"
+#include "test/MicroBenchmark.h"
 #include "test/TestAccount.h"
 #include "test/TestUtils.h"
 #include "test/TxTests.h"
 #include "test/test.h"
+#include "transactions/TransactionBridge.h"
+#include "util/Math.h"
 #include "util/ProtocolVersion.h"
+#include "util/UnorderedSet.h"
 
 namespace stellar
 {
@@ -638,6 +644,37 @@ TEST_CASE("generalized tx set XDR conversion", "[txset]")
                         .txs.size() == 5);
             checkXdrRoundtrip(txSetXdr);
         }
+        SECTION("frames outlive the tx set")
+        {
+            auto wireTxSet = makeTxSetFromTransactions(txs, *app, 0, 0).first;
+            TxSetPhaseTransactions phaseTxs;
+            TxSetTransactions applicableTxs;
+            {
+                auto applicableTxSet = wireTxSet->prepareForApply(*app);
+                REQUIRE(applicableTxSet);
+                applicableTxs =
+                    applicableTxSet->getTxsForPhase(TxSetPhase::CLASSIC);
+                phaseTxs = wireTxSet->createTransactionFrames(
+                    app->getNetworkID());
+                wireTxSet.reset();
+            }
+            REQUIRE(phaseTxs.size() == 2);
+            REQUIRE(phaseTxs[0].size() == txs.size());
+            REQUIRE(applicableTxs.size() == txs.size());
+            UnorderedSet<Hash> hashes;
+            for (auto const& tx : txs)
+            {
+                hashes.emplace(tx->getFullHash());
+            }
+            for (auto const& tx : phaseTxs[0])
+            {
+                REQUIRE(hashes.count(tx->getFullHash()) == 1);
+            }
+            for (auto const& tx : applicableTxs)
+            {
+                REQUIRE(hashes.count(tx->getFullHash()) == 1);
+            }
+        }
         SECTION("classic and soroban")
         {
             SECTION("valid")
@@ -810,6 +847,104 @@ TEST_CASE("generalized tx set with multiple txs per source account",
     }
 }
 
+TEST_CASE("tx set signatures verified on several threads", "[txset]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION =
+        static_cast<uint32_t>(SOROBAN_PROTOCOL_VERSION);
+    cfg.TX_SET_VALIDATION_SIG_VERIFY_THREADS = 2;
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto root = TestAccount::createRoot(*app);
+
+    std::vector<TransactionFramePtr> txs;
+    for (int i = 0; i < 64; ++i)
+    {
+        auto source =
+            root.create("source " + std::to_string(i),
+                        app->getLedgerManager().getLastMinBalance(2));
+        txs.emplace_back(transactionFromOperations(
+            *app, source.getSecretKey(), source.nextSequenceNumber(),
+            {payment(root, 1)}, 100));
+    }
+    PubKeyUtils::clearVerifySigCache();
+
+    auto checkTxSet = [&]() {
+        return testtxset::makeNonValidatedGeneralizedTxSet(
+                   {{std::make_pair(
+                       100, std::vector<TransactionFrameBasePtr>(txs.begin(),
+                                                                 txs.end()))},
+                    {}},
+                   *app,
+                   app->getLedgerManager().getLastClosedLedgerHeader().hash)
+            .second->checkValid(*app, 0, 0);
+    };
+
+    SECTION("valid")
+    {
+        REQUIRE(checkTxSet());
+    }
+    SECTION("invalid signature")
+    {
+        getSignatures(txs[40])[0].signature[0] ^= 1;
+        txs[40]->clearCached();
+        REQUIRE(!checkTxSet());
+    }
+}
+
+TEST_CASE("surge pricing lane limits fit check", "[txset]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+
+    std::vector<TransactionFrameBasePtr> txs;
+    for (int i = 0; i < 3; ++i)
+    {
+        auto source =
+            root.create("source " + std::to_string(i),
+                        app->getLedgerManager().getLastMinBalance(2));
+        txs.emplace_back(transactionFromOperations(
+            *app, source.getSecretKey(), source.nextSequenceNumber(),
+            {payment(root, 1), payment(root, 1)}, 200));
+    }
+
+    auto fits = [&](uint32_t maxOps, std::optional<uint32_t> maxDexOps) {
+        std::optional<Resource> dexLimit;
+        if (maxDexOps)
+        {
+            dexLimit = Resource({*maxDexOps, MAX_CLASSIC_BYTE_ALLOWANCE});
+        }
+        DexLimitingLaneConfig laneConfig(
+            Resource({maxOps, MAX_CLASSIC_BYTE_ALLOWANCE}), dexLimit);
+        return SurgePricingPriorityQueue::allTxsFitWithinLimits(txs,
+                                                                laneConfig);
+    };
+
+    REQUIRE(fits(6, std::nullopt));
+    REQUIRE(!fits(5, std::nullopt));
+    // None of the transactions is in the DEX lane
+    REQUIRE(fits(6, 0));
+    txs.clear();
+    REQUIRE(fits(0, std::nullopt));
+}
+
+TEST_CASE("tx set message is shared", "[txset]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    auto txSet = TxSetXDRFrame::makeEmpty(
+        app->getLedgerManager().getLastClosedLedgerHeader());
+
+    auto msg = txSet->getStellarMessage();
+    REQUIRE(msg == txSet->getStellarMessage());
+    REQUIRE(msg->type() == GENERALIZED_TX_SET);
+    REQUIRE(TxSetXDRFrame::makeFromWire(msg->generalizedTxSet())
+                ->getContentsHash() == txSet->getContentsHash());
+}
+
 TEST_CASE("generalized tx set fees", "[txset][soroban]")
 {
     VirtualClock clock;
@@ -978,5 +1113,33 @@ TEST_CASE("generalized tx set fees", "[txset][soroban]")
     }
 }
 
+TEST_CASE("tx set building microbench", "[txset][microbench][bench][!hide]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    // Five times more transactions than fit, so that they are surge priced
+    cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 200;
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto root = TestAccount::createRoot(*app);
+
+    TxSetTransactions txs;
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto source =
+            root.create("source " + std::to_string(i),
+                        app->getLedgerManager().getLastMinBalance(2));
+        txs.emplace_back(transactionFromOperations(
+            *app, source.getSecretKey(), source.nextSequenceNumber(),
+            {payment(root, 1)}, rand_uniform<uint32_t>(100, 1100)));
+    }
+    REQUIRE(makeTxSetFromTransactions(txs, *app, 0, 0).second->sizeTxTotal() ==
+            cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE);
+
+    runMicroBenchmark("txset.surge-pricing", [&]() {
+        makeTxSetFromTransactions(txs, *app, 0, 0);
+        return txs.size();
+    });
+}
+
 } // namespace
 } // namespace stellar
@@ -3,7 +3,8 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "FileTransferInfo.h"
-#include <Tracy.hpp>
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
 #include <thread>
 
 namespace stellar
@@ -14,23 +15,34 @@ char const* HISTORY_FILE_TYPE_TRANSACTIONS = "transactions";
 char const* HISTORY_FILE_TYPE_RESULTS = "results";
 char const* HISTORY_FILE_TYPE_SCP = "scp";
 
+char const* BUCKET_INDEX_SUFFIX = "index";
+
 std::string
 FileTransferInfo::getLocalDir(TmpDir const& localRoot) const
 {
     ZoneScoped;
-    auto localDir = localRoot.getName();
-    localDir += "/" + fs::remoteDir(mType, mHexDigits);
+    // Unlike in archives, files are staged two directory levels deep, a
+    // directory holding the files of 65536 ledgers rather than 256, which
+    // takes far fewer directories to make over a long catchup
+    releaseAssert(mHexDigits.size() >= 4);
+    auto localDir = mType + "/" + mHexDigits.substr(0, 2) + "/" +
+                    mHexDigits.substr(2, 2);
     int retries = 5;
     // Similarly to TmpDir, retry in case there were
     // OS-related errors (e.g. out of memory) or race conditions
-    while (!fs::mkpath(localDir))
+    for (;;)
     {
+        auto path = localRoot.makeSubdir(localDir);
+        if (path)
+        {
+            return *path;
+        }
         if (--retries == 0)
         {
-            throw std::runtime_error("Unable to make a path " + localDir);
+            throw std::runtime_error("Unable to make a path " +
+                                     localRoot.getName() + "/" + localDir);
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    return localDir;
 }
 }
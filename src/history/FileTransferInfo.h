@@ -20,10 +20,15 @@ extern char const* HISTORY_FILE_TYPE_TRANSACTIONS;
 extern char const* HISTORY_FILE_TYPE_RESULTS;
 extern char const* HISTORY_FILE_TYPE_SCP;
 
+// Suffix of the files of BucketListDB indexes, published next to buckets
+extern char const* BUCKET_INDEX_SUFFIX;
+
 class FileTransferInfo
 {
     std::string mType;
     std::string mHexDigits;
+    // Extension of the file once unzipped
+    std::string mSuffix{"xdr"};
     std::string mLocalPath;
     std::string getLocalDir(TmpDir const& localRoot) const;
 
@@ -35,6 +40,15 @@ class FileTransferInfo
     {
     }
 
+    // The BucketListDB index of `bucket`, stored next to it in archives
+    FileTransferInfo(Bucket const& bucket, std::string const& indexPath)
+        : mType(HISTORY_FILE_TYPE_BUCKET)
+        , mHexDigits(binToHex(bucket.getHash()))
+        , mSuffix(BUCKET_INDEX_SUFFIX)
+        , mLocalPath(indexPath)
+    {
+    }
+
     FileTransferInfo(TmpDir const& snapDir, std::string const& snapType,
                      uint32_t checkpointLedger)
         : mType(snapType)
@@ -44,9 +58,11 @@ class FileTransferInfo
     }
 
     FileTransferInfo(TmpDir const& snapDir, std::string const& snapType,
-                     std::string const& hexDigits)
+                     std::string const& hexDigits,
+                     std::string const& suffix = "xdr")
         : mType(snapType)
         , mHexDigits(hexDigits)
+        , mSuffix(suffix)
         , mLocalPath(getLocalDir(snapDir) + "/" + baseName_nogz())
     {
     }
@@ -63,6 +79,11 @@ class FileTransferInfo
         return mLocalPath;
     }
     std::string
+    localPath_nogz_tmp() const
+    {
+        return mLocalPath + ".tmp";
+    }
+    std::string
     localPath_gz() const
     {
         return mLocalPath + ".gz";
@@ -76,7 +97,7 @@ class FileTransferInfo
     std::string
     baseName_nogz() const
     {
-        return fs::baseName(mType, mHexDigits, "xdr");
+        return fs::baseName(mType, mHexDigits, mSuffix);
     }
     std::string
     baseName_gz() const
@@ -97,7 +118,7 @@ class FileTransferInfo
     std::string
     remoteName() const
     {
-        return fs::remoteName(mType, mHexDigits, "xdr.gz");
+        return fs::remoteName(mType, mHexDigits, mSuffix + ".gz");
     }
 };
 }
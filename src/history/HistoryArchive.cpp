@@ -20,7 +20,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 #include <cereal/archives/json.hpp>
@@ -411,7 +411,7 @@ HistoryArchiveState::prepareForPublish(Application& app)
             // here, we're going to live with the approximate value for now.
             uint32_t maxProtocolVersion =
                 app.getConfig().LEDGER_PROTOCOL_VERSION;
-            level.next.makeLive(app, maxProtocolVersion, i);
+            level.next.makeLive(app, maxProtocolVersion, i, currentLedger);
         }
     }
 }
@@ -490,6 +490,32 @@ HistoryArchive::getFileCmd(std::string const& remote,
     return formatString(mConfig.mGetCmd, remote, local);
 }
 
+std::optional<std::string>
+HistoryArchive::getFileUrl(std::string const& remote) const
+{
+    std::optional<std::string> res;
+    std::istringstream in(mConfig.mGetCmd);
+    std::string arg;
+    while (in >> arg)
+    {
+        if (arg.size() >= 2 && (arg.front() == '"' || arg.front() == '\'') &&
+            arg.back() == arg.front())
+        {
+            arg = arg.substr(1, arg.size() - 2);
+        }
+        if (arg.rfind("http://", 0) == 0 &&
+            arg.find("{0}") != std::string::npos)
+        {
+            if (res)
+            {
+                return std::nullopt;
+            }
+            res = formatString(arg, remote);
+        }
+    }
+    return res;
+}
+
 std::string
 HistoryArchive::putFileCmd(std::string const& local,
                            std::string const& remote) const
@@ -506,4 +532,28 @@ HistoryArchive::mkdirCmd(std::string const& remoteDir) const
         return "";
     return formatString(mConfig.mMkdirCmd, remoteDir);
 }
+
+bool
+HistoryArchive::hasPutUrl() const
+{
+    return !mConfig.mPutUrl.empty();
+}
+
+std::string
+HistoryArchive::putFileUrl(std::string const& remote) const
+{
+    auto root = mConfig.mPutUrl;
+    while (!root.empty() && root.back() == '/')
+    {
+        root.pop_back();
+    }
+    return root + "/" + remote;
+}
+
+std::string const&
+HistoryArchive::getPutRegion() const
+{
+    static std::string const DEFAULT_REGION = "us-east-1";
+    return mConfig.mPutRegion.empty() ? DEFAULT_REGION : mConfig.mPutRegion;
+}
 }
@@ -10,6 +10,7 @@
 
 #include <cereal/cereal.hpp>
 #include <memory>
+#include <optional>
 #include <string>
 #include <system_error>
 
@@ -162,10 +163,19 @@ class HistoryArchive : public std::enable_shared_from_this<HistoryArchive>
 
     std::string getFileCmd(std::string const& remote,
                            std::string const& local) const;
+    // URL the get command downloads `remote` from, if it has a single
+    // http:// URL argument to fill in
+    std::optional<std::string> getFileUrl(std::string const& remote) const;
     std::string putFileCmd(std::string const& local,
                            std::string const& remote) const;
     std::string mkdirCmd(std::string const& remoteDir) const;
 
+    // Whether files can be uploaded to the archive's put_url
+    bool hasPutUrl() const;
+    // URL of `remote` under the put_url
+    std::string putFileUrl(std::string const& remote) const;
+    std::string const& getPutRegion() const;
+
   private:
     HistoryArchiveConfiguration mConfig;
 };
@@ -5,6 +5,8 @@
 #include "history/HistoryArchiveManager.h"
 #include "history/HistoryArchive.h"
 #include "history/HistoryArchiveReportWork.h"
+#include "history/HttpFileFetcher.h"
+#include "history/HttpFileUploader.h"
 #include "historywork/CheckSingleLedgerHeaderWork.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
 #include "historywork/PutHistoryArchiveStateWork.h"
@@ -16,6 +18,7 @@
 #include "work/WorkScheduler.h"
 #include "work/WorkSequence.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace stellar
@@ -126,8 +129,8 @@ HistoryArchiveManager::checkSensibleConfig() const
     return true;
 }
 
-std::shared_ptr<HistoryArchive>
-HistoryArchiveManager::selectRandomReadableHistoryArchive() const
+std::vector<std::shared_ptr<HistoryArchive>>
+HistoryArchiveManager::getReadableHistoryArchives() const
 {
     std::vector<std::shared_ptr<HistoryArchive>> archives;
 
@@ -153,7 +156,14 @@ HistoryArchiveManager::selectRandomReadableHistoryArchive() const
     {
         throw std::runtime_error("No GET-enabled history archive in config");
     }
-    else if (archives.size() == 1)
+    return archives;
+}
+
+std::shared_ptr<HistoryArchive>
+HistoryArchiveManager::selectRandomReadableHistoryArchive() const
+{
+    auto archives = getReadableHistoryArchives();
+    if (archives.size() == 1)
     {
         CLOG_DEBUG(History, "Fetching from sole readable history archive '{}'",
                    archives[0]->getName());
@@ -169,6 +179,96 @@ HistoryArchiveManager::selectRandomReadableHistoryArchive() const
     }
 }
 
+double const HistoryArchiveManager::MIN_DOWNLOAD_SHARE = 0.05;
+
+std::shared_ptr<HistoryArchive>
+HistoryArchiveManager::selectReadableHistoryArchiveByScore() const
+{
+    auto archives = getReadableHistoryArchives();
+    if (archives.size() == 1)
+    {
+        return archives[0];
+    }
+
+    // Archives with no throughput measured yet are assumed to be as fast as
+    // the average of the others, so that they get tried
+    double measuredSum = 0;
+    size_t measured = 0;
+    for (auto const& archive : archives)
+    {
+        auto it = mDownloadScores.find(archive->getName());
+        if (it != mDownloadScores.end() && it->second.mHasThroughput)
+        {
+            measuredSum += it->second.mBytesPerSecond;
+            ++measured;
+        }
+    }
+    double const defaultRate = measured == 0 ? 1.0 : measuredSum / measured;
+
+    std::vector<double> weights;
+    double total = 0;
+    for (auto const& archive : archives)
+    {
+        double rate = defaultRate;
+        double errorRate = 0;
+        auto it = mDownloadScores.find(archive->getName());
+        if (it != mDownloadScores.end())
+        {
+            if (it->second.mHasThroughput)
+            {
+                rate = it->second.mBytesPerSecond;
+            }
+            errorRate = it->second.mErrorRate;
+        }
+        weights.emplace_back(rate * (1.0 - errorRate));
+        total += weights.back();
+    }
+
+    double const minWeight = total > 0 ? total * MIN_DOWNLOAD_SHARE : 1.0;
+    double sum = 0;
+    for (auto& w : weights)
+    {
+        w = std::max(w, minWeight);
+        sum += w;
+    }
+
+    double pick = rand_fraction() * sum;
+    size_t i = 0;
+    for (; i + 1 < weights.size() && pick >= weights[i]; ++i)
+    {
+        pick -= weights[i];
+    }
+    CLOG_DEBUG(History,
+               "Fetching from readable history archive '{}' ({:.0f}% of "
+               "downloads)",
+               archives[i]->getName(), 100 * weights[i] / sum);
+    return archives[i];
+}
+
+void
+HistoryArchiveManager::recordDownloadSuccess(
+    std::shared_ptr<HistoryArchive> const& archive, size_t bytes,
+    VirtualClock::duration elapsed)
+{
+    std::chrono::duration<double> secs = elapsed;
+    // Don't let small files downloaded in no time skew the average
+    double rate = bytes / std::max(secs.count(), 0.001);
+    auto& score = mDownloadScores[archive->getName()];
+    score.mBytesPerSecond = score.mHasThroughput
+                                ? 0.8 * score.mBytesPerSecond + 0.2 * rate
+                                : rate;
+    score.mHasThroughput = true;
+    score.mErrorRate = 0.8 * score.mErrorRate;
+}
+
+void
+HistoryArchiveManager::recordDownloadFailure(
+    std::shared_ptr<HistoryArchive> const& archive)
+{
+    auto& score = mDownloadScores[archive->getName()];
+    score.mErrorRate = 0.8 * score.mErrorRate + 0.2;
+}
+
 std::shared_ptr<BasicWork>
 HistoryArchiveManager::getHistoryArchiveReportWork() const
 {
@@ -268,4 +368,26 @@ HistoryArchiveManager::getWritableHistoryArchives() const
                  });
     return result;
 }
+
+HttpFileFetcher&
+HistoryArchiveManager::getHttpFileFetcher()
+{
+    if (!mHttpFileFetcher)
+    {
+        mHttpFileFetcher = std::make_shared<HttpFileFetcher>(
+            mApp, mApp.getConfig().HISTORY_HTTP_MAX_CONNECTIONS);
+    }
+    return *mHttpFileFetcher;
+}
+
+HttpFileUploader&
+HistoryArchiveManager::getHttpFileUploader()
+{
+    if (!mHttpFileUploader)
+    {
+        mHttpFileUploader = std::make_shared<HttpFileUploader>(
+            mApp, mApp.getConfig().HISTORY_HTTP_MAX_CONNECTIONS);
+    }
+    return *mHttpFileUploader;
+}
 }
@@ -4,6 +4,9 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "util/Timer.h"
+
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -13,6 +16,8 @@ namespace stellar
 class Application;
 class Config;
 class HistoryArchive;
+class HttpFileFetcher;
+class HttpFileUploader;
 
 class BasicWork;
 struct LedgerHeaderHistoryEntry;
@@ -29,6 +34,19 @@ class HistoryArchiveManager
     // select one at random.
     std::shared_ptr<HistoryArchive> selectRandomReadableHistoryArchive() const;
 
+    // Select a readable history archive at random, giving each one a chance
+    // in proportion to the throughput it delivered and the share of its
+    // downloads that succeeded. Used with HISTORY_STRIPED_DOWNLOADS so that
+    // the files downloaded in parallel are spread over the archives.
+    std::shared_ptr<HistoryArchive>
+    selectReadableHistoryArchiveByScore() const;
+
+    // Account a download from `archive` in its score
+    void recordDownloadSuccess(std::shared_ptr<HistoryArchive> const& archive,
+                               size_t bytes,
+                               VirtualClock::duration elapsed);
+    void recordDownloadFailure(std::shared_ptr<HistoryArchive> const& archive);
+
     // Returns a work that reports the last-published checkpoint on each
     // archive.
     std::shared_ptr<BasicWork> getHistoryArchiveReportWork() const;
@@ -54,8 +72,31 @@ class HistoryArchiveManager
     std::vector<std::shared_ptr<HistoryArchive>>
     getWritableHistoryArchives() const;
 
+    // Client for the archives downloaded from with HISTORY_HTTP_CLIENT
+    HttpFileFetcher& getHttpFileFetcher();
+    // Client for the archives uploaded to with HISTORY_HTTP_CLIENT
+    HttpFileUploader& getHttpFileUploader();
+
+    // Every archive gets at least this share of the downloads, so that one
+    // that got faster or stopped failing is noticed
+    static double const MIN_DOWNLOAD_SHARE;
+
   private:
+    struct DownloadScore
+    {
+        // Moving averages over the last downloads
+        double mBytesPerSecond{0};
+        double mErrorRate{0};
+        bool mHasThroughput{false};
+    };
+
     Application& mApp;
     std::vector<std::shared_ptr<HistoryArchive>> mArchives;
+    std::shared_ptr<HttpFileFetcher> mHttpFileFetcher;
+    std::shared_ptr<HttpFileUploader> mHttpFileUploader;
+    std::map<std::string, DownloadScore> mDownloadScores;
+
+    std::vector<std::shared_ptr<HistoryArchive>>
+    getReadableHistoryArchives() const;
 };
 }
@@ -6,8 +6,8 @@
 #include "history/HistoryArchive.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkSequence.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 #include <iostream>
 
@@ -206,9 +206,21 @@ class HistoryManager
 
     static std::unique_ptr<HistoryManager> create(Application& app);
 
-    // Initialize DB table for persistent publishing queue.
+    // Initialize DB table for persistent publishing queue. The table is only
+    // kept for schema upgrades, see migratePublishQueue.
     static void dropAll(Database& db);
 
+    // The persistent publishing queue is a directory of the bucket dir
+    // holding one file per checkpoint queued, named after its ledger, with
+    // the HistoryArchiveState to publish for it.
+    static std::string publishQueuePath(Config const& cfg);
+    static std::string publishQueueFilename(Config const& cfg,
+                                            uint32_t ledger);
+
+    // Move the checkpoints queued in the publishqueue table of older schemas
+    // to the publish queue directory, and drop the table.
+    static void migratePublishQueue(Database& db, Config const& cfg);
+
     // Checkpoints are made every getCheckpointFrequency() ledgers.
     // This should normally be a constant (64) but in testing cases
     // may be different (see ARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING).
@@ -315,7 +327,7 @@ class HistoryManager
 
     // Checkpoint the LCL -- both the log of history from the previous
     // checkpoint to it, as well as the bucketlist of its state -- to a
-    // publication-queue in the database. This should be followed shortly
+    // publication-queue on disk. This should be followed shortly
     // (typically after commit) with a call to publishQueuedHistory.
     virtual void queueCurrentHistory() = 0;
 
@@ -327,18 +339,17 @@ class HistoryManager
     // returns 0 if the publish queue has nothing in it.
     virtual uint32_t getMaxLedgerQueuedToPublish() = 0;
 
-    // Publish any checkpoints queued (in the database) for publication.
+    // Publish any checkpoints queued (on disk) for publication.
     // Returns the number of publishes initiated.
     virtual size_t publishQueuedHistory() = 0;
 
-    // Return the set of buckets referenced by the persistent (DB) publish
+    // Return the set of buckets referenced by the persistent publish
     // queue that are not present in the BucketManager. These need to be
     // fetched from somewhere before publishing can begin again.
     virtual std::vector<std::string>
     getMissingBucketsReferencedByPublishQueue() = 0;
 
-    // Return the set of buckets referenced by the persistent (DB) publish
-    // queue.
+    // Return the set of buckets referenced by the persistent publish queue.
     virtual std::vector<std::string> getBucketsReferencedByPublishQueue() = 0;
 
     // Return the full set of HistoryArchiveStates in the persistent (DB)
@@ -28,15 +28,16 @@
 #include "medida/metrics_registry.h"
 #include "overlay/StellarXDR.h"
 #include "process/ProcessManager.h"
+#include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/StatusManager.h"
 #include "util/TmpDir.h"
+#include "util/ZoneProfiler.h"
 #include "work/ConditionalWork.h"
 #include "work/WorkScheduler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 #include <fstream>
@@ -52,6 +53,8 @@ static string kSQLCreateStatement = "CREATE TABLE IF NOT EXISTS publishqueue ("
                                     "state    TEXT"
                                     "); ";
 
+static std::string const kPublishQueueSuffix = ".checkpoint";
+
 void
 HistoryManager::dropAll(Database& db)
 {
@@ -60,6 +63,89 @@ HistoryManager::dropAll(Database& db)
     st.execute(true);
 }
 
+std::string
+HistoryManager::publishQueuePath(Config const& cfg)
+{
+    return cfg.BUCKET_DIR_PATH + "/publishqueue";
+}
+
+std::string
+HistoryManager::publishQueueFilename(Config const& cfg, uint32_t ledger)
+{
+    return publishQueuePath(cfg) + "/" + fs::hexStr(ledger) +
+           kPublishQueueSuffix;
+}
+
+// Write the file of a queued checkpoint in a temporary file renamed once
+// complete, so that a crash never leaves a partial checkpoint in the queue
+static void
+writePublishQueueFile(Config const& cfg, uint32_t ledger,
+                      std::string const& state)
+{
+    ZoneScoped;
+    auto dir = HistoryManager::publishQueuePath(cfg);
+    if (!fs::mkpath(dir))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Failed to create {}"), dir));
+    }
+    auto filename = HistoryManager::publishQueueFilename(cfg, ledger);
+    auto tmpFilename = filename + ".tmp";
+
+    auto handle = fs::openFileToWrite(tmpFilename);
+    FILE* out = fs::fdOpen(handle);
+    bool written = fwrite(state.data(), 1, state.size(), out) == state.size() &&
+                   fflush(out) == 0;
+    if (written && !cfg.DISABLE_XDR_FSYNC)
+    {
+        fs::flushFileChanges(handle);
+    }
+    if (fclose(out) != 0 || !written)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Failed to write {}"), tmpFilename));
+    }
+
+    bool renamed =
+        cfg.DISABLE_XDR_FSYNC
+            ? std::rename(tmpFilename.c_str(), filename.c_str()) == 0
+            : fs::durableRename(tmpFilename, filename, dir);
+    if (!renamed)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Failed to rename {} to {}"), tmpFilename,
+                        filename));
+    }
+}
+
+void
+HistoryManager::migratePublishQueue(Database& db, Config const& cfg)
+{
+    ZoneScoped;
+    uint32_t ledger;
+    std::string state;
+    auto prep =
+        db.getPreparedStatement("SELECT ledger, state FROM publishqueue;");
+    auto& st = prep.statement();
+    st.exchange(soci::into(ledger));
+    st.exchange(soci::into(state));
+    st.define_and_bind();
+    st.execute(true);
+    size_t count = 0;
+    while (st.got_data())
+    {
+        writePublishQueueFile(cfg, ledger, state);
+        ++count;
+        st.fetch();
+    }
+    if (count > 0)
+    {
+        CLOG_INFO(History, "Moved {} queued checkpoints to {}", count,
+                  publishQueuePath(cfg));
+    }
+    db.getSession() << "DROP TABLE IF EXISTS publishqueue;";
+}
+
 std::unique_ptr<HistoryManager>
 HistoryManager::create(Application& app)
 {
@@ -125,18 +211,44 @@ HistoryManagerImpl::logAndUpdatePublishStatus()
     }
 }
 
+std::set<uint32_t> const&
+HistoryManagerImpl::getQueuedCheckpoints() const
+{
+    if (!mQueuedCheckpoints)
+    {
+        ZoneScoped;
+        mQueuedCheckpoints.emplace();
+        auto dir = publishQueuePath(mApp.getConfig());
+        if (fs::exists(dir))
+        {
+            // Skips the temporary files left by a crash while writing
+            auto isCheckpoint = [](std::string const& name) {
+                return name.size() == 8 + kPublishQueueSuffix.size() &&
+                       name.compare(8, std::string::npos,
+                                    kPublishQueueSuffix) == 0;
+            };
+            for (auto const& name : fs::findfiles(dir, isCheckpoint))
+            {
+                mQueuedCheckpoints->insert(static_cast<uint32_t>(
+                    std::stoul(name.substr(0, 8), nullptr, 16)));
+            }
+        }
+    }
+    return *mQueuedCheckpoints;
+}
+
+HistoryArchiveState
+HistoryManagerImpl::loadQueuedCheckpoint(uint32_t ledger) const
+{
+    HistoryArchiveState has;
+    has.load(publishQueueFilename(mApp.getConfig(), ledger));
+    return has;
+}
+
 size_t
 HistoryManagerImpl::publishQueueLength() const
 {
-    ZoneScoped;
-    uint32_t count;
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT count(ledger) FROM publishqueue;");
-    auto& st = prep.statement();
-    st.exchange(soci::into(count));
-    st.define_and_bind();
-    st.execute(true);
-    return count;
+    return getQueuedCheckpoints().size();
 }
 
 string const&
@@ -160,39 +272,15 @@ HistoryManagerImpl::localFilename(std::string const& basename)
 uint32_t
 HistoryManagerImpl::getMinLedgerQueuedToPublish()
 {
-    ZoneScoped;
-    uint32_t seq;
-    soci::indicator minIndicator;
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT min(ledger) FROM publishqueue;");
-    auto& st = prep.statement();
-    st.exchange(soci::into(seq, minIndicator));
-    st.define_and_bind();
-    st.execute(true);
-    if (minIndicator == soci::indicator::i_ok)
-    {
-        return seq;
-    }
-    return 0;
+    auto const& queued = getQueuedCheckpoints();
+    return queued.empty() ? 0 : *queued.begin();
 }
 
 uint32_t
 HistoryManagerImpl::getMaxLedgerQueuedToPublish()
 {
-    ZoneScoped;
-    uint32_t seq;
-    soci::indicator maxIndicator;
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT max(ledger) FROM publishqueue;");
-    auto& st = prep.statement();
-    st.exchange(soci::into(seq, maxIndicator));
-    st.define_and_bind();
-    st.execute(true);
-    if (maxIndicator == soci::indicator::i_ok)
-    {
-        return seq;
-    }
-    return 0;
+    auto const& queued = getQueuedCheckpoints();
+    return queued.empty() ? 0 : *queued.rbegin();
 }
 
 bool
@@ -211,6 +299,12 @@ HistoryManagerImpl::maybeQueueHistoryCheckpoint()
         return false;
     }
 
+    if (mApp.getConfig().MODE_REPLAY_ONLY)
+    {
+        CLOG_DEBUG(History, "Skipping checkpoint, only replaying history");
+        return false;
+    }
+
     queueCurrentHistory();
     return true;
 }
@@ -232,19 +326,11 @@ HistoryManagerImpl::queueCurrentHistory()
     CLOG_DEBUG(History, "Queueing publish state for ledger {}", ledger);
     mEnqueueTimes.emplace(ledger, std::chrono::steady_clock::now());
 
-    auto state = has.toString();
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "INSERT INTO publishqueue (ledger, state) VALUES (:lg, :st);");
-    auto& st = prep.statement();
-    st.exchange(soci::use(ledger));
-    st.exchange(soci::use(state));
-    st.define_and_bind();
-    {
-        ZoneNamedN(insertPublishQueueZone, "insert publishqueue", true);
-        st.execute(true);
-    }
+    writePublishQueueFile(mApp.getConfig(), ledger, has.toString());
+    getQueuedCheckpoints();
+    mQueuedCheckpoints->insert(ledger);
 
-    // We have now written the current HAS to the database, so
+    // We have now written the current HAS to the publish queue, so
     // it's "safe" to crash (at least after the enclosing tx commits);
     // but that HAS might have merges running and if we throw it
     // away at this point we'll lose the merges and have to restart
@@ -327,21 +413,10 @@ HistoryManagerImpl::publishQueuedHistory()
 #endif
 
     ZoneScoped;
-    std::string state;
-
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT state FROM publishqueue"
-        " ORDER BY ledger ASC LIMIT 1;");
-    auto& st = prep.statement();
-    soci::indicator stateIndicator;
-    st.exchange(soci::into(state, stateIndicator));
-    st.define_and_bind();
-    st.execute(true);
-    if (st.got_data() && stateIndicator == soci::indicator::i_ok)
+    auto const& queued = getQueuedCheckpoints();
+    if (!queued.empty())
     {
-        HistoryArchiveState has;
-        has.fromString(state);
-        takeSnapshotAndPublish(has);
+        takeSnapshotAndPublish(loadQueuedCheckpoint(*queued.begin()));
         return 1;
     }
     return 0;
@@ -352,19 +427,9 @@ HistoryManagerImpl::getPublishQueueStates()
 {
     ZoneScoped;
     std::vector<HistoryArchiveState> states;
-
-    std::string state;
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "SELECT state FROM publishqueue;");
-    auto& st = prep.statement();
-    st.exchange(soci::into(state));
-    st.define_and_bind();
-    st.execute(true);
-    while (st.got_data())
+    for (auto ledger : getQueuedCheckpoints())
     {
-        states.emplace_back();
-        states.back().fromString(state);
-        st.fetch();
+        states.emplace_back(loadQueuedCheckpoint(ledger));
     }
     return states;
 }
@@ -440,15 +505,10 @@ HistoryManagerImpl::historyPublished(
         }
 
         this->mPublishSuccess.Mark();
-        auto prep = mApp.getDatabase().getPreparedStatement(
-            "DELETE FROM publishqueue WHERE ledger = :lg;");
-        auto& st = prep.statement();
-        st.exchange(soci::use(ledgerSeq));
-        st.define_and_bind();
-        {
-            ZoneNamedN(deletePublishQueueZone, "delete publishqueue", true);
-            st.execute(true);
-        }
+        getQueuedCheckpoints();
+        mQueuedCheckpoints->erase(ledgerSeq);
+        std::remove(
+            publishQueueFilename(mApp.getConfig(), ledgerSeq).c_str());
 
         mPublishQueueBuckets.removeBuckets(originalBuckets);
     }
@@ -465,12 +525,15 @@ void
 HistoryManagerImpl::deleteCheckpointsNewerThan(uint32_t ledgerSeq)
 {
     ZoneScoped;
-    auto prep = mApp.getDatabase().getPreparedStatement(
-        "DELETE FROM publishqueue WHERE ledger >= :lg;");
-    auto& st = prep.statement();
-    st.exchange(soci::use(ledgerSeq));
-    st.define_and_bind();
-    st.execute(true);
+    getQueuedCheckpoints();
+    auto it = mQueuedCheckpoints->lower_bound(ledgerSeq);
+    while (it != mQueuedCheckpoints->end())
+    {
+        CLOG_INFO(History, "Dropping checkpoint {} from the publish queue",
+                  *it);
+        std::remove(publishQueueFilename(mApp.getConfig(), *it).c_str());
+        it = mQueuedCheckpoints->erase(it);
+    }
 }
 
 uint64_t
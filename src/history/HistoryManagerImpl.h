@@ -9,6 +9,8 @@
 #include "util/TmpDir.h"
 #include "work/Work.h"
 #include <memory>
+#include <optional>
+#include <set>
 
 namespace medida
 {
@@ -37,6 +39,12 @@ class HistoryManagerImpl : public HistoryManager
     medida::Timer& mEnqueueToPublishTimer;
     UnorderedMap<uint32_t, std::chrono::steady_clock::time_point> mEnqueueTimes;
 
+    // Ledgers of the checkpoints in the publish queue directory, listed
+    // the first time they're needed then kept in sync with the files
+    mutable std::optional<std::set<uint32_t>> mQueuedCheckpoints;
+    std::set<uint32_t> const& getQueuedCheckpoints() const;
+    HistoryArchiveState loadQueuedCheckpoint(uint32_t ledger) const;
+
     PublishQueueBuckets::BucketCount loadBucketsReferencedByPublishQueue();
 #ifdef BUILD_TESTS
     bool mPublicationEnabled{true};
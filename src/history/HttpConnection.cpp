@@ -0,0 +1,515 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// ASIO is somewhat particular about when it gets included -- it wants to be the
+// first to include <windows.h> -- so we try to include it before everything
+// else.
+#include "util/asio.h"
+#include "history/HttpConnection.h"
+#include "main/Application.h"
+#include "util/Logging.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <sstream>
+#include <tuple>
+
+namespace stellar
+{
+
+std::chrono::seconds const HttpConnection::IDLE_TIMEOUT(60);
+
+namespace
+{
+std::error_code
+protocolError()
+{
+    return std::make_error_code(std::errc::protocol_error);
+}
+
+std::error_code
+fileError()
+{
+    return std::make_error_code(std::errc::io_error);
+}
+}
+
+std::string
+HttpConnection::trim(std::string const& s)
+{
+    auto start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+    {
+        return "";
+    }
+    auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+std::string
+HttpConnection::toLower(std::string s)
+{
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return s;
+}
+
+HttpConnection::HttpConnection(Application& app)
+    : mSocket(app.getClock().getIOContext())
+    , mResolver(app.getClock().getIOContext())
+    , mTimer(app)
+    , mChunk(64 * 1024)
+{
+}
+
+void
+HttpConnection::start(Request request, HeadersHandler onHeaders,
+                      BodyHandler onBody, DoneHandler done)
+{
+    mRequest = std::move(request);
+    mOnHeaders = std::move(onHeaders);
+    mOnBody = std::move(onBody);
+    mDone = std::move(done);
+    mBuf.consume(mBuf.size());
+    mGotResponse = false;
+    mRemaining.reset();
+    mChunked = false;
+    mChunkRemaining = 0;
+    mKeepAlive = true;
+
+    mReused = mSocket.is_open();
+    if (mReused)
+    {
+        send();
+    }
+    else
+    {
+        connect();
+    }
+}
+
+void
+HttpConnection::close()
+{
+    asio::error_code ec;
+    mResolver.cancel();
+    std::ignore = mSocket.close(ec);
+}
+
+void
+HttpConnection::armTimer()
+{
+    std::weak_ptr<HttpConnection> weak = shared_from_this();
+    mTimer.expires_from_now(IDLE_TIMEOUT);
+    mTimer.async_wait(
+        [weak]() {
+            auto self = weak.lock();
+            if (self)
+            {
+                CLOG_DEBUG(History, "HTTP request to {} timed out",
+                           self->mRequest.mHost);
+                self->close();
+            }
+        },
+        &VirtualTimer::onFailureNoop);
+}
+
+void
+HttpConnection::connect()
+{
+    armTimer();
+    auto self = shared_from_this();
+    mResolver.async_resolve(
+        mRequest.mHost, mRequest.mPort,
+        [self](asio::error_code const& ec,
+               asio::ip::tcp::resolver::results_type results) {
+            if (ec)
+            {
+                self->finish(ec);
+                return;
+            }
+            asio::async_connect(self->mSocket, results,
+                                [self](asio::error_code const& ec,
+                                       asio::ip::tcp::endpoint const&) {
+                                    if (ec)
+                                    {
+                                        self->finish(ec);
+                                        return;
+                                    }
+                                    asio::error_code ignored;
+                                    std::ignore = self->mSocket.set_option(
+                                        asio::ip::tcp::no_delay(true),
+                                        ignored);
+                                    self->send();
+                                });
+        });
+}
+
+void
+HttpConnection::retryOrFinish(asio::error_code const& ec)
+{
+    // Unless we closed the connection ourselves
+    if (mReused && !mGotResponse && ec != asio::error::operation_aborted)
+    {
+        mReused = false;
+        close();
+        mBuf.consume(mBuf.size());
+        connect();
+        return;
+    }
+    finish(ec);
+}
+
+void
+HttpConnection::send()
+{
+    if (!mRequest.mFile.empty())
+    {
+        mIn.close();
+        mIn.clear();
+        mIn.open(mRequest.mFile, std::ios::binary);
+        mIn.seekg(static_cast<std::streamoff>(mRequest.mOffset));
+        if (!mIn)
+        {
+            mKeepAlive = false;
+            finish(fileError());
+            return;
+        }
+        mSent = 0;
+    }
+
+    armTimer();
+    auto self = shared_from_this();
+    std::array<asio::const_buffer, 2> buffers{asio::buffer(mRequest.mHead),
+                                              asio::buffer(mRequest.mBody)};
+    asio::async_write(mSocket, buffers,
+                      [self](asio::error_code const& ec, size_t) {
+                          if (ec)
+                          {
+                              self->retryOrFinish(ec);
+                              return;
+                          }
+                          self->sendFile();
+                      });
+}
+
+void
+HttpConnection::sendFile()
+{
+    if (mRequest.mFile.empty() || mSent == mRequest.mLength)
+    {
+        mIn.close();
+        readHeaders();
+        return;
+    }
+    auto n = static_cast<size_t>(
+        std::min<uint64_t>(mChunk.size(), mRequest.mLength - mSent));
+    mIn.read(mChunk.data(), static_cast<std::streamsize>(n));
+    if (!mIn)
+    {
+        mKeepAlive = false;
+        finish(fileError());
+        return;
+    }
+    mSent += n;
+
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_write(mSocket, asio::buffer(mChunk.data(), n),
+                      [self](asio::error_code const& ec, size_t) {
+                          if (ec)
+                          {
+                              self->retryOrFinish(ec);
+                              return;
+                          }
+                          self->sendFile();
+                      });
+}
+
+void
+HttpConnection::readHeaders()
+{
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_read_until(mSocket, mBuf, "\r\n\r\n",
+                           [self](asio::error_code const& ec, size_t n) {
+                               if (ec)
+                               {
+                                   self->retryOrFinish(ec);
+                                   return;
+                               }
+                               self->mGotResponse = true;
+                               self->processHeaders(n);
+                           });
+}
+
+void
+HttpConnection::processHeaders(size_t n)
+{
+    auto begin = asio::buffers_begin(mBuf.data());
+    std::string head(begin, begin + n);
+    mBuf.consume(n);
+
+    Response response;
+    std::istringstream in(head);
+    std::string line;
+    std::getline(in, line);
+    std::istringstream statusLine(line);
+    std::string version;
+    statusLine >> version >> response.mStatus;
+    if (!statusLine || version.rfind("HTTP/", 0) != 0)
+    {
+        mKeepAlive = false;
+        finish(protocolError());
+        return;
+    }
+    mKeepAlive = version != "HTTP/1.0";
+
+    while (std::getline(in, line))
+    {
+        auto colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        auto name = toLower(trim(line.substr(0, colon)));
+        auto value = trim(line.substr(colon + 1));
+        response.mHeaders[name] = value;
+        if (name == "content-length")
+        {
+            try
+            {
+                mRemaining = std::stoull(value);
+            }
+            catch (std::exception const&)
+            {
+                mKeepAlive = false;
+                finish(protocolError());
+                return;
+            }
+        }
+        else if (name == "transfer-encoding")
+        {
+            mChunked = toLower(value).find("chunked") != std::string::npos;
+        }
+        else if (name == "connection")
+        {
+            auto v = toLower(value);
+            if (v == "close")
+            {
+                mKeepAlive = false;
+            }
+            else if (v == "keep-alive")
+            {
+                mKeepAlive = true;
+            }
+        }
+    }
+
+    if (auto ec = mOnHeaders(response))
+    {
+        // Not worth reading the rest of the response to keep the connection
+        mKeepAlive = false;
+        finish(ec);
+        return;
+    }
+
+    if (mChunked)
+    {
+        mRemaining.reset();
+        readChunkSize();
+    }
+    else
+    {
+        if (!mRemaining)
+        {
+            // The body ends with the connection
+            mKeepAlive = false;
+        }
+        readBody();
+    }
+}
+
+std::error_code
+HttpConnection::consumeBody(size_t n)
+{
+    if (n == 0)
+    {
+        return {};
+    }
+    auto ec = mOnBody(static_cast<char const*>(mBuf.data().data()), n);
+    mBuf.consume(n);
+    if (ec)
+    {
+        mKeepAlive = false;
+    }
+    return ec;
+}
+
+void
+HttpConnection::readBody()
+{
+    size_t n = mBuf.size();
+    if (mRemaining)
+    {
+        n = std::min(n, *mRemaining);
+    }
+    if (auto ec = consumeBody(n))
+    {
+        finish(ec);
+        return;
+    }
+    if (mRemaining)
+    {
+        *mRemaining -= n;
+        if (*mRemaining == 0)
+        {
+            finish({});
+            return;
+        }
+    }
+
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_read(mSocket, mBuf, asio::transfer_at_least(1),
+                     [self](asio::error_code const& ec, size_t) {
+                         if (ec == asio::error::eof && !self->mRemaining)
+                         {
+                             self->finish(
+                                 self->consumeBody(self->mBuf.size()));
+                             return;
+                         }
+                         if (ec)
+                         {
+                             self->finish(ec);
+                             return;
+                         }
+                         self->readBody();
+                     });
+}
+
+void
+HttpConnection::readChunkSize()
+{
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_read_until(
+        mSocket, mBuf, "\r\n", [self](asio::error_code const& ec, size_t n) {
+            if (ec)
+            {
+                self->finish(ec);
+                return;
+            }
+            auto begin = asio::buffers_begin(self->mBuf.data());
+            std::string line(begin, begin + n - 2);
+            self->mBuf.consume(n);
+            // Chunk extensions follow the size after a ';'
+            line = trim(line.substr(0, line.find(';')));
+            size_t size = 0;
+            try
+            {
+                size_t used = 0;
+                size = std::stoull(line, &used, 16);
+                if (used != line.size())
+                {
+                    throw std::invalid_argument(line);
+                }
+            }
+            catch (std::exception const&)
+            {
+                self->mKeepAlive = false;
+                self->finish(protocolError());
+                return;
+            }
+            if (size == 0)
+            {
+                self->readTrailers();
+            }
+            else
+            {
+                self->mChunkRemaining = size + 2;
+                self->readChunkData();
+            }
+        });
+}
+
+void
+HttpConnection::readChunkData()
+{
+    size_t n = std::min(mBuf.size(), mChunkRemaining);
+    size_t data = mChunkRemaining > 2 ? std::min(n, mChunkRemaining - 2) : 0;
+    if (auto ec = consumeBody(data))
+    {
+        finish(ec);
+        return;
+    }
+    // The rest is the CRLF closing the chunk
+    mBuf.consume(n - data);
+    mChunkRemaining -= n;
+    if (mChunkRemaining == 0)
+    {
+        readChunkSize();
+        return;
+    }
+
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_read(mSocket, mBuf, asio::transfer_at_least(1),
+                     [self](asio::error_code const& ec, size_t) {
+                         if (ec)
+                         {
+                             self->finish(ec);
+                             return;
+                         }
+                         self->readChunkData();
+                     });
+}
+
+void
+HttpConnection::readTrailers()
+{
+    armTimer();
+    auto self = shared_from_this();
+    asio::async_read_until(mSocket, mBuf, "\r\n",
+                           [self](asio::error_code const& ec, size_t n) {
+                               if (ec)
+                               {
+                                   self->finish(ec);
+                                   return;
+                               }
+                               self->mBuf.consume(n);
+                               if (n == 2)
+                               {
+                                   self->finish({});
+                               }
+                               else
+                               {
+                                   self->readTrailers();
+                               }
+                           });
+}
+
+void
+HttpConnection::finish(std::error_code ec)
+{
+    mTimer.cancel();
+    mIn.close();
+    mIn.clear();
+
+    bool reusable = !ec && mKeepAlive && mBuf.size() == 0;
+    if (!reusable)
+    {
+        close();
+    }
+    mOnHeaders = nullptr;
+    mOnBody = nullptr;
+    auto done = std::move(mDone);
+    mDone = nullptr;
+    if (done)
+    {
+        done(ec, reusable);
+    }
+}
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/asio.h"
+#include "util/NonCopyable.h"
+#include "util/Timer.h"
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace stellar
+{
+
+class Application;
+
+// One HTTP/1.1 connection to a host, running one request at a time on the
+// main thread's io_context: it sends the request, then reads the response
+// headers and streams the body, plain, sized or chunked, to the caller. It
+// stays open after a request when the server allows it and the whole
+// response was read, so that the caller can reuse it for the next request
+// to the same host.
+//
+// A reused connection that fails before the response starts was most likely
+// closed by the server while idle, so the request is sent again over a new
+// one. Any pending operation fails once the connection gets no data for
+// IDLE_TIMEOUT.
+class HttpConnection : public std::enable_shared_from_this<HttpConnection>,
+                       public NonMovableOrCopyable
+{
+  public:
+    struct Request
+    {
+        std::string mHost;
+        std::string mPort;
+        // Request line and headers, with the blank line ending them
+        std::string mHead;
+        std::string mBody;
+        // Unless empty, this range of the file is sent after mBody, a chunk
+        // at a time so that it's never held in memory whole
+        std::string mFile;
+        uint64_t mOffset{0};
+        uint64_t mLength{0};
+    };
+
+    struct Response
+    {
+        unsigned int mStatus{0};
+        // By lowercase name, values keep their case, that of ETags matters
+        std::map<std::string, std::string> mHeaders;
+    };
+
+    // Called once the response headers are read, and with each piece of the
+    // body as it arrives. Returning an error stops the request there, and the
+    // connection is closed rather than reused.
+    using HeadersHandler = std::function<std::error_code(Response const&)>;
+    using BodyHandler = std::function<std::error_code(char const*, size_t)>;
+    // Called once, when the request is done or has failed
+    using DoneHandler =
+        std::function<void(std::error_code const&, bool reusable)>;
+
+    static std::chrono::seconds const IDLE_TIMEOUT;
+
+    explicit HttpConnection(Application& app);
+
+    void start(Request request, HeadersHandler onHeaders, BodyHandler onBody,
+               DoneHandler done);
+    // Fails the pending operation, if any
+    void close();
+
+    // Strips the whitespace allowed around header values
+    static std::string trim(std::string const& s);
+    static std::string toLower(std::string s);
+
+  private:
+    asio::ip::tcp::socket mSocket;
+    asio::ip::tcp::resolver mResolver;
+    VirtualTimer mTimer;
+    asio::streambuf mBuf;
+    Request mRequest;
+    HeadersHandler mOnHeaders;
+    BodyHandler mOnBody;
+    DoneHandler mDone;
+    std::ifstream mIn;
+    std::vector<char> mChunk;
+    uint64_t mSent{0};
+
+    // Set if the request went out over a connection used before, which the
+    // server may have closed in the meantime
+    bool mReused{false};
+    bool mGotResponse{false};
+    std::optional<size_t> mRemaining;
+    bool mChunked{false};
+    // Bytes left in the current chunk, its trailing CRLF included
+    size_t mChunkRemaining{0};
+    bool mKeepAlive{true};
+
+    void armTimer();
+    void connect();
+    void retryOrFinish(asio::error_code const& ec);
+    void send();
+    void sendFile();
+    void readHeaders();
+    void processHeaders(size_t n);
+    std::error_code consumeBody(size_t n);
+    void readBody();
+    void readChunkSize();
+    void readChunkData();
+    void readTrailers();
+    void finish(std::error_code ec);
+};
+}
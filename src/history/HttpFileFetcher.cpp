@@ -0,0 +1,369 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// ASIO is somewhat particular about when it gets included -- it wants to be the
+// first to include <windows.h> -- so we try to include it before everything
+// else.
+#include "util/asio.h"
+#include "history/HttpFileFetcher.h"
+#include "history/HttpConnection.h"
+#include "main/Application.h"
+#include "util/GlobalChecks.h"
+#include "util/GzipInflater.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+
+namespace stellar
+{
+
+namespace
+{
+std::error_code
+protocolError()
+{
+    return std::make_error_code(std::errc::protocol_error);
+}
+
+std::error_code
+fileError()
+{
+    return std::make_error_code(std::errc::io_error);
+}
+
+// The file the body of a running request goes to, decompressed on the way
+// if asked to
+class Download
+{
+    HttpFileFetcher::Url const mUrl;
+    std::string const mLocalPath;
+    std::ofstream mOut;
+#ifdef USE_ZLIB
+    std::unique_ptr<GzipInflater> mInflater;
+#endif
+
+  public:
+    size_t mBodyBytes{0};
+
+    Download(HttpFileFetcher::Url const& url, std::string const& localPath,
+             bool gunzip)
+        : mUrl(url), mLocalPath(localPath)
+    {
+#ifdef USE_ZLIB
+        if (gunzip)
+        {
+            mInflater = std::make_unique<GzipInflater>();
+        }
+#else
+        releaseAssert(!gunzip);
+#endif
+    }
+
+    std::error_code
+    onHeaders(HttpConnection::Response const& response)
+    {
+        if (response.mStatus != 200)
+        {
+            CLOG_DEBUG(History, "GET {}{} returned {}", mUrl.mHost, mUrl.mPath,
+                       response.mStatus);
+            return protocolError();
+        }
+        mOut.open(mLocalPath, std::ios::binary | std::ios::trunc);
+        return mOut ? std::error_code() : fileError();
+    }
+
+    std::error_code
+    write(char const* data, size_t n)
+    {
+        mBodyBytes += n;
+#ifdef USE_ZLIB
+        if (mInflater)
+        {
+            try
+            {
+                mInflater->inflate(data, n, [&](char const* out, size_t size) {
+                    mOut.write(out, static_cast<std::streamsize>(size));
+                });
+            }
+            catch (std::runtime_error const& e)
+            {
+                CLOG_DEBUG(History, "GET {}{}: {}", mUrl.mHost, mUrl.mPath,
+                           e.what());
+                return protocolError();
+            }
+        }
+        else
+#endif
+        {
+            mOut.write(data, static_cast<std::streamsize>(n));
+        }
+        return mOut ? std::error_code() : fileError();
+    }
+
+    // The result of the request, once the file is closed
+    std::error_code
+    finish(std::error_code ec)
+    {
+        if (mOut.is_open())
+        {
+            mOut.close();
+            if (!mOut && !ec)
+            {
+                ec = fileError();
+            }
+        }
+#ifdef USE_ZLIB
+        if (!ec && mInflater && !mInflater->done())
+        {
+            CLOG_DEBUG(History, "GET {}{}: truncated gzip data", mUrl.mHost,
+                       mUrl.mPath);
+            ec = protocolError();
+        }
+#endif
+        return ec;
+    }
+};
+}
+
+std::optional<HttpFileFetcher::Url>
+HttpFileFetcher::parseUrl(std::string const& url)
+{
+    std::string const scheme = "http://";
+    if (url.rfind(scheme, 0) != 0)
+    {
+        return std::nullopt;
+    }
+    auto rest = url.substr(scheme.size());
+    auto slash = rest.find('/');
+    auto authority = rest.substr(0, slash);
+    Url res;
+    res.mPath = slash == std::string::npos ? "/" : rest.substr(slash);
+    if (authority.empty() || authority.find('@') != std::string::npos)
+    {
+        return std::nullopt;
+    }
+    auto colon = authority.find(':');
+    res.mHost = authority.substr(0, colon);
+    res.mPort = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+    if (res.mHost.empty() || res.mPort.empty() ||
+        !std::all_of(res.mPort.begin(), res.mPort.end(),
+                     [](unsigned char c) { return std::isdigit(c); }))
+    {
+        return std::nullopt;
+    }
+    return res;
+}
+
+HttpFileFetcher::HttpFileFetcher(Application& app,
+                                 size_t maxConnectionsPerHost)
+    : mApp(app)
+    , mMaxConnectionsPerHost(maxConnectionsPerHost)
+    , mNewConnections(app.getMetrics().NewMeter(
+          {"history", "http", "new-connection"}, "connection"))
+    , mReusedConnections(app.getMetrics().NewMeter(
+          {"history", "http", "reused-connection"}, "connection"))
+{
+    releaseAssert(mMaxConnectionsPerHost > 0);
+}
+
+HttpFileFetcher::~HttpFileFetcher()
+{
+    shutdown();
+}
+
+bool
+HttpFileFetcher::canGunzip()
+{
+#ifdef USE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t
+HttpFileFetcher::fetch(Url const& url, std::string const& localPath,
+                       Handler handler, bool gunzip)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    releaseAssert(!mShutdown);
+    releaseAssert(!gunzip || canGunzip());
+    auto id = mNextID++;
+    auto hostKey = url.mHost + ":" + url.mPort;
+    mHosts[hostKey].mQueue.emplace_back(
+        Request{id, url, localPath, gunzip, std::move(handler)});
+    mQueued.emplace(id);
+    dispatch(hostKey);
+    return id;
+}
+
+void
+HttpFileFetcher::cancel(uint64_t id)
+{
+    releaseAssert(threadIsMain());
+    mQueued.erase(id);
+    auto it = mRunning.find(id);
+    if (it != mRunning.end())
+    {
+        auto conn = it->second.mConnection.lock();
+        mRunning.erase(it);
+        if (conn)
+        {
+            // Its handler runs once the pending operation is aborted, and
+            // frees the connection's slot
+            conn->close();
+        }
+    }
+}
+
+void
+HttpFileFetcher::shutdown()
+{
+    if (mShutdown)
+    {
+        return;
+    }
+    mShutdown = true;
+    for (auto& kv : mRunning)
+    {
+        auto conn = kv.second.mConnection.lock();
+        if (conn)
+        {
+            conn->close();
+        }
+    }
+    for (auto& kv : mHosts)
+    {
+        for (auto& conn : kv.second.mIdle)
+        {
+            conn->close();
+        }
+    }
+    mRunning.clear();
+    mQueued.clear();
+    mHosts.clear();
+}
+
+void
+HttpFileFetcher::dispatch(std::string const& hostKey)
+{
+    auto& host = mHosts[hostKey];
+    while (!host.mQueue.empty())
+    {
+        if (mQueued.find(host.mQueue.front().mID) == mQueued.end())
+        {
+            // Cancelled while waiting
+            host.mQueue.pop_front();
+            continue;
+        }
+
+        std::shared_ptr<HttpConnection> conn;
+        if (!host.mIdle.empty())
+        {
+            conn = host.mIdle.back();
+            host.mIdle.pop_back();
+            mReusedConnections.Mark();
+        }
+        else if (host.mBusy < mMaxConnectionsPerHost)
+        {
+            conn = std::make_shared<HttpConnection>(mApp);
+            mNewConnections.Mark();
+        }
+        else
+        {
+            break;
+        }
+
+        auto req = std::move(host.mQueue.front());
+        host.mQueue.pop_front();
+        mQueued.erase(req.mID);
+        ++host.mBusy;
+        mRunning.emplace(req.mID, Running{conn, std::move(req.mHandler)});
+
+        HttpConnection::Request request;
+        request.mHost = req.mUrl.mHost;
+        request.mPort = req.mUrl.mPort;
+        auto hostHeader = req.mUrl.mPort == "80"
+                              ? req.mUrl.mHost
+                              : req.mUrl.mHost + ":" + req.mUrl.mPort;
+        request.mHead =
+            fmt::format(FMT_STRING("GET {} HTTP/1.1\r\n"
+                                   "Host: {}\r\n"
+                                   "Accept: */*\r\n"
+                                   "User-Agent: stellar-core\r\n\r\n"),
+                        req.mUrl.mPath, hostHeader);
+        auto download =
+            std::make_shared<Download>(req.mUrl, req.mLocalPath, req.mGunzip);
+
+        std::weak_ptr<HttpFileFetcher> weak = shared_from_this();
+        std::weak_ptr<HttpConnection> weakConn = conn;
+        conn->start(
+            std::move(request),
+            [download](HttpConnection::Response const& response) {
+                return download->onHeaders(response);
+            },
+            [download](char const* data, size_t n) {
+                return download->write(data, n);
+            },
+            [weak, weakConn, hostKey, id = req.mID,
+             download](std::error_code const& ec, bool reusable) {
+                auto res = download->finish(ec);
+                auto self = weak.lock();
+                if (self)
+                {
+                    self->onRequestDone(hostKey, weakConn, id, res,
+                                        download->mBodyBytes, reusable);
+                }
+            });
+    }
+}
+
+void
+HttpFileFetcher::onRequestDone(std::string const& hostKey,
+                               std::weak_ptr<HttpConnection> weakConn,
+                               uint64_t id, std::error_code const& ec,
+                               size_t bytes, bool reusable)
+{
+    ZoneScoped;
+    if (mShutdown)
+    {
+        return;
+    }
+
+    auto& host = mHosts[hostKey];
+    releaseAssert(host.mBusy > 0);
+    --host.mBusy;
+    auto conn = weakConn.lock();
+    if (reusable && conn)
+    {
+        host.mIdle.emplace_back(conn);
+    }
+
+    Handler handler;
+    auto it = mRunning.find(id);
+    if (it != mRunning.end())
+    {
+        handler = std::move(it->second.mHandler);
+        mRunning.erase(it);
+    }
+    dispatch(hostKey);
+
+    if (handler)
+    {
+        if (ec)
+        {
+            CLOG_DEBUG(History, "HTTP download from {} failed: {}", hostKey,
+                       ec.message());
+        }
+        handler(ec, bytes);
+    }
+}
+}
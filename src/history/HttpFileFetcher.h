@@ -0,0 +1,109 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+
+class Application;
+class HttpConnection;
+
+// Downloads files from http:// history archives without spawning a process
+// for each of them. Requests are made over HTTP/1.1 on the main thread's
+// io_context, and the connections to a host are kept open and reused by the
+// next requests to it. At most `maxConnectionsPerHost` requests run at a
+// time for a host, the others wait in order for one of its connections.
+class HttpFileFetcher : public std::enable_shared_from_this<HttpFileFetcher>,
+                        public NonMovableOrCopyable
+{
+  public:
+    // Called with the result and the number of bytes of body received
+    using Handler = std::function<void(std::error_code const&, size_t)>;
+
+    struct Url
+    {
+        std::string mHost;
+        std::string mPort;
+        std::string mPath;
+    };
+
+    // Split an http:// URL, or return nullopt if it isn't one
+    static std::optional<Url> parseUrl(std::string const& url);
+
+    HttpFileFetcher(Application& app, size_t maxConnectionsPerHost);
+    ~HttpFileFetcher();
+
+    // Download `url` into `localPath` and call `handler` with the result,
+    // which is an error unless the server answered with 200 and the whole
+    // body was written. With `gunzip`, the body is decompressed as it
+    // arrives and a body that isn't a complete gzip file is an error.
+    // Returns an ID to cancel the request with.
+    uint64_t fetch(Url const& url, std::string const& localPath,
+                   Handler handler, bool gunzip = false);
+
+    // Whether fetch can decompress bodies, which needs zlib
+    static bool canGunzip();
+    // Drop a request, its handler won't be called
+    void cancel(uint64_t id);
+    // Close all the connections and drop all the requests
+    void shutdown();
+
+  private:
+    struct Request
+    {
+        uint64_t mID;
+        Url mUrl;
+        std::string mLocalPath;
+        bool mGunzip;
+        Handler mHandler;
+    };
+    struct Running
+    {
+        std::weak_ptr<HttpConnection> mConnection;
+        Handler mHandler;
+    };
+    struct Host
+    {
+        std::deque<Request> mQueue;
+        std::vector<std::shared_ptr<HttpConnection>> mIdle;
+        size_t mBusy{0};
+    };
+
+    Application& mApp;
+    size_t const mMaxConnectionsPerHost;
+    std::map<std::string, Host> mHosts;
+    // Requests queued and not cancelled
+    std::set<uint64_t> mQueued;
+    std::map<uint64_t, Running> mRunning;
+    uint64_t mNextID{1};
+    bool mShutdown{false};
+    medida::Meter& mNewConnections;
+    medida::Meter& mReusedConnections;
+
+    void dispatch(std::string const& hostKey);
+    void onRequestDone(std::string const& hostKey,
+                       std::weak_ptr<HttpConnection> weakConn, uint64_t id,
+                       std::error_code const& ec, size_t bytes,
+                       bool reusable);
+};
+}
@@ -0,0 +1,614 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// ASIO is somewhat particular about when it gets included -- it wants to be the
+// first to include <windows.h> -- so we try to include it before everything
+// else.
+#include "util/asio.h"
+#include "history/HttpFileUploader.h"
+#include "crypto/Hex.h"
+#include "crypto/SHA.h"
+#include "history/HttpConnection.h"
+#include "main/Application.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Timer.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <sodium.h>
+
+namespace stellar
+{
+
+size_t const HttpFileUploader::PART_SIZE = 16 * 1024 * 1024;
+size_t const HttpFileUploader::MAX_RESPONSE_BODY = 1024 * 1024;
+
+namespace
+{
+std::error_code
+protocolError()
+{
+    return std::make_error_code(std::errc::protocol_error);
+}
+
+std::error_code
+fileError()
+{
+    return std::make_error_code(std::errc::io_error);
+}
+
+// Percent-encoding of everything but unreserved characters, and slashes
+// unless `encodeSlash`, as SigV4 wants it
+std::string
+uriEncode(std::string const& s, bool encodeSlash)
+{
+    std::string res;
+    for (unsigned char c : s)
+    {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' ||
+            (c == '/' && !encodeSlash))
+        {
+            res += static_cast<char>(c);
+        }
+        else
+        {
+            res += fmt::format(FMT_STRING("%{:02X}"), c);
+        }
+    }
+    return res;
+}
+
+// The query's parameters are all made of unreserved characters, so sorting
+// them by name before or after encoding is the same
+std::string
+canonicalQuery(std::map<std::string, std::string> const& query)
+{
+    std::string res;
+    for (auto const& kv : query)
+    {
+        if (!res.empty())
+        {
+            res += '&';
+        }
+        res += uriEncode(kv.first, true) + "=" + uriEncode(kv.second, true);
+    }
+    return res;
+}
+
+std::string
+hmacSha256(std::string const& key, std::string const& data)
+{
+    std::array<unsigned char, crypto_auth_hmacsha256_BYTES> out;
+    crypto_auth_hmacsha256_state state;
+    crypto_auth_hmacsha256_init(
+        &state, reinterpret_cast<unsigned char const*>(key.data()),
+        key.size());
+    crypto_auth_hmacsha256_update(
+        &state, reinterpret_cast<unsigned char const*>(data.data()),
+        data.size());
+    crypto_auth_hmacsha256_final(&state, out.data());
+    return std::string(out.begin(), out.end());
+}
+}
+
+std::optional<S3Credentials>
+S3Credentials::fromEnvironment()
+{
+    auto accessKey = std::getenv("AWS_ACCESS_KEY_ID");
+    auto secretKey = std::getenv("AWS_SECRET_ACCESS_KEY");
+    if (!accessKey || !secretKey)
+    {
+        return std::nullopt;
+    }
+    auto sessionToken = std::getenv("AWS_SESSION_TOKEN");
+    return S3Credentials{accessKey, secretKey,
+                         sessionToken ? sessionToken : ""};
+}
+
+std::string
+signAwsV4(std::string const& method, std::string const& path,
+          std::map<std::string, std::string> const& query,
+          std::map<std::string, std::string> const& headers,
+          std::string const& payloadHash, std::string const& region,
+          std::string const& service, S3Credentials const& credentials)
+{
+    auto const& amzDate = headers.at("x-amz-date");
+    auto date = amzDate.substr(0, 8);
+
+    std::string canonicalHeaders;
+    std::string signedHeaders;
+    for (auto const& kv : headers)
+    {
+        canonicalHeaders +=
+            kv.first + ":" + HttpConnection::trim(kv.second) + "\n";
+        if (!signedHeaders.empty())
+        {
+            signedHeaders += ';';
+        }
+        signedHeaders += kv.first;
+    }
+    auto canonicalRequest =
+        fmt::format(FMT_STRING("{}\n{}\n{}\n{}\n{}\n{}"), method, path,
+                    canonicalQuery(query), canonicalHeaders, signedHeaders,
+                    payloadHash);
+
+    auto scope = fmt::format(FMT_STRING("{}/{}/{}/aws4_request"), date, region,
+                             service);
+    auto toSign = fmt::format(FMT_STRING("AWS4-HMAC-SHA256\n{}\n{}\n{}"),
+                              amzDate, scope,
+                              binToHex(sha256(canonicalRequest)));
+
+    auto key = hmacSha256("AWS4" + credentials.mSecretKey, date);
+    key = hmacSha256(key, region);
+    key = hmacSha256(key, service);
+    key = hmacSha256(key, "aws4_request");
+    auto signature = binToHex(hmacSha256(key, toSign));
+
+    return fmt::format(
+        FMT_STRING("AWS4-HMAC-SHA256 Credential={}/{}, SignedHeaders={}, "
+                   "Signature={}"),
+        credentials.mAccessKey, scope, signedHeaders, signature);
+}
+
+std::optional<std::string>
+HttpFileUploader::parseUploadId(std::string const& body)
+{
+    std::string const open = "<UploadId>";
+    std::string const close = "</UploadId>";
+    auto start = body.find(open);
+    if (start == std::string::npos)
+    {
+        return std::nullopt;
+    }
+    start += open.size();
+    auto end = body.find(close, start);
+    if (end == std::string::npos || end == start)
+    {
+        return std::nullopt;
+    }
+    return body.substr(start, end - start);
+}
+
+std::string
+HttpFileUploader::completeMultipartBody(std::vector<std::string> const& etags)
+{
+    std::string res = "<CompleteMultipartUpload>";
+    for (size_t i = 0; i < etags.size(); ++i)
+    {
+        res += fmt::format(
+            FMT_STRING("<Part><PartNumber>{}</PartNumber><ETag>{}</ETag>"
+                       "</Part>"),
+            i + 1, etags[i]);
+    }
+    res += "</CompleteMultipartUpload>";
+    return res;
+}
+
+HttpFileUploader::HttpFileUploader(Application& app,
+                                   size_t maxConnectionsPerHost)
+    : mApp(app)
+    , mMaxConnectionsPerHost(maxConnectionsPerHost)
+    , mNewConnections(app.getMetrics().NewMeter(
+          {"history", "http-upload", "new-connection"}, "connection"))
+    , mReusedConnections(app.getMetrics().NewMeter(
+          {"history", "http-upload", "reused-connection"}, "connection"))
+    , mParts(app.getMetrics().NewMeter({"history", "http-upload", "part"},
+                                       "part"))
+{
+    releaseAssert(mMaxConnectionsPerHost > 0);
+}
+
+HttpFileUploader::~HttpFileUploader()
+{
+    shutdown();
+}
+
+std::string
+HttpFileUploader::hostKey(Url const& url)
+{
+    return url.mHost + ":" + url.mPort;
+}
+
+HttpFileUploader::Call
+HttpFileUploader::makeCall(uint64_t id, Upload const& upload,
+                           std::string const& method)
+{
+    Call call;
+    call.mUploadID = id;
+    call.mUrl = upload.mUrl;
+    call.mRegion = upload.mRegion;
+    call.mCredentials = upload.mCredentials;
+    call.mMethod = method;
+    return call;
+}
+
+uint64_t
+HttpFileUploader::upload(Url const& url, std::string const& region,
+                         std::optional<S3Credentials> const& credentials,
+                         std::string const& localPath, Handler handler)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    releaseAssert(!mShutdown);
+    auto id = mNextID++;
+    auto& upload =
+        mUploads
+            .emplace(id, Upload{url, region, credentials, localPath, 0,
+                                std::move(handler)})
+            .first->second;
+
+    std::ifstream in(localPath, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        // The handler is never called before upload returns
+        std::weak_ptr<HttpFileUploader> weak = shared_from_this();
+        mApp.postOnMainThread(
+            [weak, id]() {
+                auto self = weak.lock();
+                if (self && !self->mShutdown)
+                {
+                    self->finish(id, fileError());
+                }
+            },
+            "HttpFileUploader: missing file");
+        return id;
+    }
+    upload.mSize = static_cast<uint64_t>(in.tellg());
+
+    if (upload.mSize <= PART_SIZE)
+    {
+        auto call = makeCall(id, upload, "PUT");
+        call.mFile = localPath;
+        call.mLength = upload.mSize;
+        call.mHandler = [this, id](std::error_code const& ec,
+                                   Response const& resp) {
+            finish(id, ec ? ec
+                          : (resp.mStatus == 200 ? std::error_code()
+                                                 : protocolError()));
+        };
+        enqueue(std::move(call));
+    }
+    else
+    {
+        auto call = makeCall(id, upload, "POST");
+        call.mQuery = {{"uploads", ""}};
+        call.mHandler = [this, id](std::error_code const& ec,
+                                   Response const& resp) {
+            auto uploadId = parseUploadId(resp.mBody);
+            if (ec || resp.mStatus != 200 || !uploadId)
+            {
+                finish(id, ec ? ec : protocolError());
+                return;
+            }
+            mUploads.at(id).mMultipartID = *uploadId;
+            startParts(id);
+        };
+        enqueue(std::move(call));
+    }
+    return id;
+}
+
+void
+HttpFileUploader::startParts(uint64_t id)
+{
+    auto& upload = mUploads.at(id);
+    auto parts =
+        static_cast<size_t>((upload.mSize + PART_SIZE - 1) / PART_SIZE);
+    upload.mETags.assign(parts, "");
+    upload.mPartsLeft = parts;
+    for (size_t i = 0; i < parts; ++i)
+    {
+        auto call = makeCall(id, upload, "PUT");
+        call.mQuery = {{"partNumber", std::to_string(i + 1)},
+                       {"uploadId", upload.mMultipartID}};
+        call.mFile = upload.mLocalPath;
+        call.mOffset = uint64_t(i) * PART_SIZE;
+        call.mLength =
+            std::min<uint64_t>(PART_SIZE, upload.mSize - call.mOffset);
+        call.mHandler = [this, id, i](std::error_code const& ec,
+                                      Response const& resp) {
+            auto etag = resp.mHeaders.find("etag");
+            if (ec || resp.mStatus != 200 || etag == resp.mHeaders.end())
+            {
+                finish(id, ec ? ec : protocolError());
+                return;
+            }
+            mParts.Mark();
+            auto& upload = mUploads.at(id);
+            upload.mETags[i] = etag->second;
+            if (--upload.mPartsLeft == 0)
+            {
+                completeMultipart(id);
+            }
+        };
+        enqueue(std::move(call));
+    }
+}
+
+void
+HttpFileUploader::completeMultipart(uint64_t id)
+{
+    auto const& upload = mUploads.at(id);
+    auto call = makeCall(id, upload, "POST");
+    call.mQuery = {{"uploadId", upload.mMultipartID}};
+    call.mBody = completeMultipartBody(upload.mETags);
+    call.mHandler = [this, id](std::error_code const& ec,
+                               Response const& resp) {
+        // S3 may report a failure in the body of a 200 response, sent before
+        // it knew whether combining the parts would work
+        if (ec || resp.mStatus != 200 ||
+            resp.mBody.find("<Error>") != std::string::npos)
+        {
+            finish(id, ec ? ec : protocolError());
+            return;
+        }
+        finish(id, {});
+    };
+    enqueue(std::move(call));
+}
+
+void
+HttpFileUploader::finish(uint64_t id, std::error_code const& ec)
+{
+    auto it = mUploads.find(id);
+    if (it == mUploads.end())
+    {
+        return;
+    }
+    auto handler = std::move(it->second.mHandler);
+    auto size = static_cast<size_t>(it->second.mSize);
+    if (ec)
+    {
+        CLOG_DEBUG(History, "HTTP upload of {} to {}{} failed: {}",
+                   it->second.mLocalPath, it->second.mUrl.mHost,
+                   it->second.mUrl.mPath, ec.message());
+        drop(id);
+    }
+    else
+    {
+        mUploads.erase(it);
+    }
+    if (handler)
+    {
+        handler(ec, ec ? 0 : size);
+    }
+}
+
+void
+HttpFileUploader::cancel(uint64_t id)
+{
+    releaseAssert(threadIsMain());
+    drop(id);
+}
+
+void
+HttpFileUploader::drop(uint64_t id)
+{
+    auto it = mUploads.find(id);
+    if (it == mUploads.end())
+    {
+        return;
+    }
+    auto upload = std::move(it->second);
+    mUploads.erase(it);
+
+    // Calls still queued are skipped when they come up. The handlers of
+    // those running run once their pending operation is aborted, and free
+    // their connection's slot.
+    auto& host = mHosts[hostKey(upload.mUrl)];
+    auto range = host.mRunning.equal_range(id);
+    for (auto r = range.first; r != range.second; ++r)
+    {
+        if (auto conn = r->second.lock())
+        {
+            conn->close();
+        }
+    }
+
+    if (!upload.mMultipartID.empty())
+    {
+        // Best effort, so that the store doesn't keep the parts around
+        auto call = makeCall(0, upload, "DELETE");
+        call.mQuery = {{"uploadId", upload.mMultipartID}};
+        enqueue(std::move(call));
+    }
+}
+
+void
+HttpFileUploader::shutdown()
+{
+    if (mShutdown)
+    {
+        return;
+    }
+    mShutdown = true;
+    for (auto& kv : mHosts)
+    {
+        for (auto& r : kv.second.mRunning)
+        {
+            if (auto conn = r.second.lock())
+            {
+                conn->close();
+            }
+        }
+        for (auto& conn : kv.second.mIdle)
+        {
+            conn->close();
+        }
+    }
+    mUploads.clear();
+    mHosts.clear();
+}
+
+std::string
+HttpFileUploader::requestHead(Call const& call) const
+{
+    auto const& url = call.mUrl;
+    auto path = uriEncode(url.mPath, false);
+    auto hostHeader =
+        url.mPort == "80" ? url.mHost : url.mHost + ":" + url.mPort;
+    auto t = VirtualClock::systemPointToTm(mApp.getClock().system_now());
+    auto amzDate = fmt::format(
+        FMT_STRING("{:04}{:02}{:02}T{:02}{:02}{:02}Z"), t.tm_year + 1900,
+        t.tm_mon + 1, t.tm_mday, t.tm_hour, t.tm_min, t.tm_sec);
+
+    std::map<std::string, std::string> headers = {
+        {"host", hostHeader},
+        {"x-amz-content-sha256", "UNSIGNED-PAYLOAD"},
+        {"x-amz-date", amzDate}};
+    if (call.mCredentials && !call.mCredentials->mSessionToken.empty())
+    {
+        headers.emplace("x-amz-security-token",
+                        call.mCredentials->mSessionToken);
+    }
+
+    auto target = path;
+    if (!call.mQuery.empty())
+    {
+        target += "?" + canonicalQuery(call.mQuery);
+    }
+    auto head = fmt::format(FMT_STRING("{} {} HTTP/1.1\r\n"), call.mMethod,
+                            target);
+    for (auto const& kv : headers)
+    {
+        head += kv.first + ": " + kv.second + "\r\n";
+    }
+    if (call.mCredentials)
+    {
+        head += "Authorization: " +
+                signAwsV4(call.mMethod, path, call.mQuery, headers,
+                          "UNSIGNED-PAYLOAD", call.mRegion, "s3",
+                          *call.mCredentials) +
+                "\r\n";
+    }
+    if (!call.mBody.empty())
+    {
+        head += "Content-Type: application/xml\r\n";
+    }
+    auto length = call.mFile.empty() ? call.mBody.size() : call.mLength;
+    head += fmt::format(FMT_STRING("Content-Length: {}\r\n"
+                                   "User-Agent: stellar-core\r\n\r\n"),
+                        length);
+    return head;
+}
+
+void
+HttpFileUploader::enqueue(Call call)
+{
+    auto key = hostKey(call.mUrl);
+    mHosts[key].mQueue.emplace_back(std::move(call));
+    dispatch(key);
+}
+
+void
+HttpFileUploader::dispatch(std::string const& key)
+{
+    auto& host = mHosts[key];
+    while (!host.mQueue.empty())
+    {
+        auto uploadID = host.mQueue.front().mUploadID;
+        if (uploadID != 0 && mUploads.find(uploadID) == mUploads.end())
+        {
+            // Dropped while waiting
+            host.mQueue.pop_front();
+            continue;
+        }
+
+        std::shared_ptr<HttpConnection> conn;
+        if (!host.mIdle.empty())
+        {
+            conn = host.mIdle.back();
+            host.mIdle.pop_back();
+            mReusedConnections.Mark();
+        }
+        else if (host.mRunning.size() < mMaxConnectionsPerHost)
+        {
+            conn = std::make_shared<HttpConnection>(mApp);
+            mNewConnections.Mark();
+        }
+        else
+        {
+            break;
+        }
+
+        auto call = std::move(host.mQueue.front());
+        host.mQueue.pop_front();
+        host.mRunning.emplace(uploadID, conn);
+
+        HttpConnection::Request request;
+        request.mHost = call.mUrl.mHost;
+        request.mPort = call.mUrl.mPort;
+        request.mHead = requestHead(call);
+        request.mBody = call.mBody;
+        request.mFile = call.mFile;
+        request.mOffset = call.mOffset;
+        request.mLength = call.mLength;
+        // Error bodies are read too, both to keep the connection and because
+        // S3 explains errors there
+        auto response = std::make_shared<Response>();
+
+        std::weak_ptr<HttpFileUploader> weak = shared_from_this();
+        std::weak_ptr<HttpConnection> weakConn = conn;
+        conn->start(
+            std::move(request),
+            [response](HttpConnection::Response const& head) {
+                response->mStatus = head.mStatus;
+                response->mHeaders = head.mHeaders;
+                return std::error_code();
+            },
+            [response](char const* data, size_t n) {
+                response->mBody.append(data, n);
+                return response->mBody.size() > MAX_RESPONSE_BODY
+                           ? protocolError()
+                           : std::error_code();
+            },
+            [weak, weakConn, key, uploadID, response,
+             handler = std::move(call.mHandler)](std::error_code const& ec,
+                                                 bool reusable) {
+                auto self = weak.lock();
+                if (!self || self->mShutdown)
+                {
+                    return;
+                }
+                self->onCallDone(key, uploadID, weakConn, reusable);
+                if (handler &&
+                    self->mUploads.find(uploadID) != self->mUploads.end())
+                {
+                    handler(ec, *response);
+                }
+            });
+    }
+}
+
+void
+HttpFileUploader::onCallDone(std::string const& key, uint64_t uploadID,
+                             std::weak_ptr<HttpConnection> weakConn,
+                             bool reusable)
+{
+    ZoneScoped;
+    auto& host = mHosts[key];
+    auto range = host.mRunning.equal_range(uploadID);
+    auto it = std::find_if(range.first, range.second, [&](auto const& r) {
+        return !r.second.owner_before(weakConn) &&
+               !weakConn.owner_before(r.second);
+    });
+    releaseAssert(it != range.second);
+    host.mRunning.erase(it);
+
+    auto conn = weakConn.lock();
+    if (reusable && conn)
+    {
+        host.mIdle.emplace_back(conn);
+    }
+    dispatch(key);
+}
+}
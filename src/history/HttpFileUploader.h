@@ -0,0 +1,179 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "history/HttpFileFetcher.h"
+#include "util/NonCopyable.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+
+class Application;
+class HttpConnection;
+
+// Credentials to sign requests to an S3-compatible store with
+struct S3Credentials
+{
+    std::string mAccessKey;
+    std::string mSecretKey;
+    // Only set for temporary credentials
+    std::string mSessionToken;
+
+    // From AWS_ACCESS_KEY_ID, AWS_SECRET_ACCESS_KEY and AWS_SESSION_TOKEN, the
+    // variables the usual put commands read too, or nullopt if the first two
+    // aren't set
+    static std::optional<S3Credentials> fromEnvironment();
+};
+
+// Value of the Authorization header signing a request with AWS Signature
+// Version 4. `path` is the URI-encoded path of the request, `query` its
+// parameters (not encoded) and `headers` all the headers to sign, by
+// lowercase name, "host" and "x-amz-date" among them.
+std::string signAwsV4(std::string const& method, std::string const& path,
+                      std::map<std::string, std::string> const& query,
+                      std::map<std::string, std::string> const& headers,
+                      std::string const& payloadHash,
+                      std::string const& region, std::string const& service,
+                      S3Credentials const& credentials);
+
+// Uploads files to S3-compatible object stores over http:// without spawning
+// a process for each of them. The object URL names the bucket in its path,
+// and requests are signed with AWS Signature Version 4 when credentials are
+// given, leaving the payload unsigned so that files are read once, as they
+// are sent.
+//
+// Like HttpFileFetcher, requests run on the main thread's io_context over
+// HTTP/1.1 connections that are kept open and reused, at most
+// `maxConnectionsPerHost` at a time to a host, the others waiting in order.
+// Files of up to PART_SIZE bytes go in a single PUT. Larger ones go in a
+// multipart upload whose parts all queue at once, so that they are sent in
+// parallel over the host's connections; a multipart upload that fails is
+// aborted so that the store drops its parts.
+class HttpFileUploader : public std::enable_shared_from_this<HttpFileUploader>,
+                         public NonMovableOrCopyable
+{
+  public:
+    // Called with the result and the number of bytes of the file uploaded
+    using Handler = std::function<void(std::error_code const&, size_t)>;
+    using Url = HttpFileFetcher::Url;
+
+    static size_t const PART_SIZE;
+    // Longest response body read, S3's being short XML documents
+    static size_t const MAX_RESPONSE_BODY;
+
+    HttpFileUploader(Application& app, size_t maxConnectionsPerHost);
+    ~HttpFileUploader();
+
+    // Upload `localPath` to the object at `url`, signing the requests for
+    // `region` if there are `credentials`, and call `handler` with the
+    // result. Returns an ID to cancel the upload with.
+    uint64_t upload(Url const& url, std::string const& region,
+                    std::optional<S3Credentials> const& credentials,
+                    std::string const& localPath, Handler handler);
+
+    // Drop an upload, its handler won't be called
+    void cancel(uint64_t id);
+    // Close all the connections and drop all the uploads
+    void shutdown();
+
+    // The UploadId of a CreateMultipartUpload response body, if any
+    static std::optional<std::string> parseUploadId(std::string const& body);
+    // The CompleteMultipartUpload request body for parts of these ETags
+    static std::string
+    completeMultipartBody(std::vector<std::string> const& etags);
+
+  private:
+    struct Response
+    {
+        unsigned int mStatus{0};
+        std::map<std::string, std::string> mHeaders;
+        std::string mBody;
+    };
+    using CallHandler =
+        std::function<void(std::error_code const&, Response const&)>;
+
+    // One HTTP request made for an upload, or for none (0) when aborting one
+    // that's already dropped
+    struct Call
+    {
+        uint64_t mUploadID;
+        Url mUrl;
+        std::string mRegion;
+        std::optional<S3Credentials> mCredentials;
+        std::string mMethod;
+        std::map<std::string, std::string> mQuery;
+        std::string mBody;
+        // Unless empty, the body is this range of the file instead
+        std::string mFile;
+        uint64_t mOffset{0};
+        uint64_t mLength{0};
+        CallHandler mHandler;
+    };
+
+    struct Upload
+    {
+        Url mUrl;
+        std::string mRegion;
+        std::optional<S3Credentials> mCredentials;
+        std::string mLocalPath;
+        uint64_t mSize{0};
+        Handler mHandler;
+        // Of the multipart upload, once created
+        std::string mMultipartID;
+        std::vector<std::string> mETags;
+        size_t mPartsLeft{0};
+    };
+
+    struct Host
+    {
+        std::deque<Call> mQueue;
+        std::vector<std::shared_ptr<HttpConnection>> mIdle;
+        // Connections running a call, by upload
+        std::multimap<uint64_t, std::weak_ptr<HttpConnection>> mRunning;
+    };
+
+    Application& mApp;
+    size_t const mMaxConnectionsPerHost;
+    std::map<std::string, Host> mHosts;
+    std::map<uint64_t, Upload> mUploads;
+    uint64_t mNextID{1};
+    bool mShutdown{false};
+    medida::Meter& mNewConnections;
+    medida::Meter& mReusedConnections;
+    medida::Meter& mParts;
+
+    static std::string hostKey(Url const& url);
+    // A call of `upload`, without query nor body
+    static Call makeCall(uint64_t id, Upload const& upload,
+                         std::string const& method);
+    std::string requestHead(Call const& call) const;
+    void enqueue(Call call);
+    void dispatch(std::string const& key);
+    void onCallDone(std::string const& key, uint64_t uploadID,
+                    std::weak_ptr<HttpConnection> weakConn, bool reusable);
+
+    void startParts(uint64_t id);
+    void completeMultipart(uint64_t id);
+    void finish(uint64_t id, std::error_code const& ec);
+    // Forget an upload, closing the connections running its calls and
+    // aborting its multipart upload if there is one
+    void drop(uint64_t id);
+};
+}
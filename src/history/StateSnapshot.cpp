@@ -13,13 +13,15 @@
 #include "history/HistoryArchive.h"
 #include "history/HistoryManager.h"
 #include "ledger/LedgerHeaderUtils.h"
+#include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "transactions/TransactionSQL.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <optional>
 
 namespace stellar
 {
@@ -51,12 +53,20 @@ bool
 StateSnapshot::writeHistoryBlocks() const
 {
     ZoneScoped;
-    std::unique_ptr<soci::session> snapSess(
-        mApp.getDatabase().canUsePool()
-            ? std::make_unique<soci::session>(mApp.getDatabase().getPool())
-            : nullptr);
-    soci::session& sess(snapSess ? *snapSess : mApp.getDatabase().getSession());
-    soci::transaction tx(sess);
+    // Off the main thread, read through a read-only session, which stays in
+    // one transaction for as long as it is borrowed.
+    std::optional<ReadOnlySession> snapSess;
+    std::optional<soci::transaction> tx;
+    if (mApp.getDatabase().canUsePool())
+    {
+        snapSess.emplace(mApp.getDatabase().getReadOnlySession());
+    }
+    else
+    {
+        tx.emplace(mApp.getDatabase().getSession());
+    }
+    soci::session& sess(snapSess ? snapSess->session()
+                                 : mApp.getDatabase().getSession());
 
     // The current "history block" is stored in _four_ files, one just ledger
     // headers, one TransactionHistoryEntry (which contain txSets),
@@ -82,8 +92,9 @@ StateSnapshot::writeHistoryBlocks() const
         CLOG_DEBUG(History, "Streaming {} ledgers worth of history, from {}",
                    count, begin);
 
-        nHeaders = LedgerHeaderUtils::copyToStream(mApp.getDatabase(), sess,
-                                                   begin, count, ledgerOut);
+        nHeaders = LedgerHeaderUtils::copyToStream(
+            mApp.getDatabase(), sess, begin, count, ledgerOut,
+            &mApp.getLedgerManager().getRecentLedgerHeaders());
 
         size_t nTxs = copyTransactionsToStream(mApp, sess, begin, count, txOut,
                                                txResultOut);
@@ -93,7 +104,7 @@ StateSnapshot::writeHistoryBlocks() const
                    mTransactionSnapFile->localPath_nogz(),
                    mTransactionResultSnapFile->localPath_nogz());
 
-        nbSCPMessages = HerderPersistence::copySCPHistoryToStream(
+        nbSCPMessages = mApp.getHerderPersistence().copySCPHistoryToStream(
             mApp.getDatabase(), sess, begin, count, scpHistory);
 
         CLOG_DEBUG(History, "Wrote {} SCP messages to {}", nbSCPMessages,
@@ -145,11 +156,18 @@ StateSnapshot::differingHASFiles(HistoryArchiveState const& other)
     addIfExists(mTransactionResultSnapFile);
     addIfExists(mSCPHistorySnapFile);
 
+    auto& bm = mApp.getBucketManager();
+    bool publishIndexes = mApp.getConfig().isUsingHistoryBucketIndexes();
     for (auto const& hash : mLocalState.differingBuckets(other))
     {
-        auto b = mApp.getBucketManager().getBucketByHash(hexToBin256(hash));
+        auto b = bm.getBucketByHash(hexToBin256(hash));
         releaseAssert(b);
         addIfExists(std::make_shared<FileTransferInfo>(*b));
+        if (publishIndexes)
+        {
+            addIfExists(std::make_shared<FileTransferInfo>(
+                *b, bm.bucketIndexFilename(b->getHash())));
+        }
     }
 
     return files;
@@ -0,0 +1,130 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "catchup/CatchupManager.h"
+#include "history/HistoryManager.h"
+#include "history/test/HistoryTestsUtils.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "test/test.h"
+#include "util/Logging.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <chrono>
+#include <fmt/format.h>
+#include <limits>
+
+using namespace stellar;
+using namespace historytestutils;
+
+namespace
+{
+
+struct StorageMode
+{
+    std::string mName;
+    Config::TestDbMode mDbMode;
+    bool mBucketListDB;
+};
+
+// The phases CatchupWork times, in the order they run
+std::vector<std::string> const PHASES = {
+    "download-ledgers", "verify-ledgers", "download-buckets",
+    "verify-buckets",   "apply-buckets",  "apply-txs"};
+
+void
+runCatchupBench(CatchupSimulation& simulation, StorageMode const& mode,
+                std::string const& rangeName, uint32_t count,
+                uint32_t toLedger)
+{
+    auto name = mode.mName + ", " + rangeName;
+    auto app = simulation.createCatchupApplication(
+        count, mode.mDbMode, name, /*publish=*/false, mode.mBucketListDB);
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE(simulation.catchupOffline(app, toLedger));
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - start;
+
+    auto& metrics = app->getMetrics();
+    auto work = app->getCatchupManager().getCatchupMetrics();
+    auto bytes = metrics.NewMeter({"history", "get", "throughput"}, "bytes")
+                     .count();
+    double downloadTime = 0;
+
+    LOG_INFO(DEFAULT_LOG, "catchup bench '{}': {:.3f}s, {} ledgers, {} buckets",
+             name, wall.count(), work.mTxSetsApplied, work.mBucketsApplied);
+    for (auto const& phase : PHASES)
+    {
+        auto& timer = metrics.NewTimer({"catchup", "phase", phase});
+        if (timer.count() == 0)
+        {
+            continue;
+        }
+        // Timers are in milliseconds
+        double seconds = timer.sum() / 1000;
+        std::string rate;
+        if (phase == "download-ledgers" || phase == "download-buckets")
+        {
+            downloadTime += seconds;
+        }
+        else if (phase == "verify-ledgers" && seconds > 0)
+        {
+            rate = fmt::format(FMT_STRING(", {:.0f} ledgers/s"),
+                               work.mLedgersVerified / seconds);
+        }
+        else if (phase == "apply-buckets" && seconds > 0)
+        {
+            rate = fmt::format(FMT_STRING(", {:.1f} buckets/s"),
+                               work.mBucketsApplied / seconds);
+        }
+        else if (phase == "apply-txs" && seconds > 0)
+        {
+            // This includes downloading the transactions, which overlaps
+            // with applying them
+            rate = fmt::format(FMT_STRING(", {:.0f} ledgers/s"),
+                               work.mTxSetsApplied / seconds);
+        }
+        LOG_INFO(DEFAULT_LOG, "  {}: {:.3f}s{}", phase, seconds, rate);
+    }
+    LOG_INFO(DEFAULT_LOG, "  downloaded {:.2f} MB, {:.2f} MB/s", bytes / 1e6,
+             downloadTime > 0 ? bytes / downloadTime / 1e6 : 0.0);
+}
+}
+
+TEST_CASE("catchup throughput bench", "[catchup][bench][!hide]")
+{
+    // Every mode replays the same range, published once to a local
+    // archive. The ledgers are generated from the test's seed, so runs with
+    // the same --rng-seed replay the same archive.
+    uint32_t const checkpoints = 10;
+    CatchupSimulation simulation{};
+    auto toLedger = simulation.getLastCheckpointLedger(checkpoints);
+    simulation.ensureOfflineCatchupPossible(toLedger);
+    auto frequency =
+        simulation.getApp().getHistoryManager().getCheckpointFrequency();
+
+    std::vector<StorageMode> modes = {
+        {"BucketListDB", Config::TESTDB_ON_DISK_SQLITE, true},
+        {"SQL, in-memory SQLite", Config::TESTDB_IN_MEMORY_SQLITE, false},
+        {"SQL, on-disk SQLite", Config::TESTDB_ON_DISK_SQLITE, false}};
+#ifdef USE_POSTGRES
+    if (!force_sqlite)
+    {
+        modes.push_back({"SQL, PostgreSQL", Config::TESTDB_POSTGRESQL, false});
+    }
+#endif
+
+    for (auto const& mode : modes)
+    {
+        runCatchupBench(simulation, mode, "complete",
+                        std::numeric_limits<uint32_t>::max(), toLedger);
+        // Applies buckets, then replays the last two checkpoints
+        runCatchupBench(simulation, mode, "recent", 2 * frequency, toLedger);
+    }
+}
@@ -7,10 +7,13 @@
 #include "catchup/CatchupManager.h"
 #include "history/FileTransferInfo.h"
 #include "history/HistoryArchive.h"
+#include "main/Application.h"
+#include "main/Config.h"
 #include "historywork/GetAndUnzipRemoteFileWork.h"
+#include "historywork/GetBucketIndexWork.h"
 #include "historywork/VerifyBucketWork.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkWithCallback.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
@@ -107,6 +110,11 @@ DownloadBucketsWork::yieldMoreWork()
     auto w3 = std::make_shared<WorkWithCallback>(mApp, "adopt-verified-bucket",
                                                  successCb);
     std::vector<std::shared_ptr<BasicWork>> seq{w1, w2, w3};
+    if (mApp.getConfig().isUsingHistoryBucketIndexes())
+    {
+        seq.push_back(std::make_shared<GetBucketIndexWork>(
+            mApp, mDownloadDir, hash, mArchive));
+    }
     auto w4 = std::make_shared<WorkSequence>(
         mApp, "download-verify-sequence-" + hash, seq);
 
@@ -12,7 +12,7 @@
 #include "util/FileSystemException.h"
 #include "util/TmpDir.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -5,11 +5,13 @@
 #include "historywork/GetAndUnzipRemoteFileWork.h"
 #include "catchup/CatchupManager.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryArchiveManager.h"
 #include "historywork/GetRemoteFileWork.h"
 #include "historywork/GunzipFileWork.h"
+#include "main/Application.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -23,6 +25,10 @@ GetAndUnzipRemoteFileWork::GetAndUnzipRemoteFileWork(
     , mFt(std::move(ft))
     , mArchive(archive)
 {
+    // Files only appear under their final name once complete, and gzip
+    // removes the .gz after it has written all of the .xdr
+    mReuseLocalFile = fs::exists(mFt.localPath_nogz()) &&
+                      !fs::exists(mFt.localPath_gz());
 }
 
 std::string
@@ -42,11 +48,16 @@ GetAndUnzipRemoteFileWork::getStatus() const
 void
 GetAndUnzipRemoteFileWork::doReset()
 {
+    mGetRemoteFileWork.reset();
+    mGunzipFileWork.reset();
+    if (mReuseLocalFile)
+    {
+        return;
+    }
     std::remove(mFt.localPath_nogz().c_str());
+    std::remove(mFt.localPath_nogz_tmp().c_str());
     std::remove(mFt.localPath_gz().c_str());
     std::remove(mFt.localPath_gz_tmp().c_str());
-    mGetRemoteFileWork.reset();
-    mGunzipFileWork.reset();
 }
 
 void
@@ -58,6 +69,7 @@ GetAndUnzipRemoteFileWork::onFailureRaise()
     {
         CLOG_ERROR(History, "Archive {}: file {} is maybe corrupt",
                    ar->getName(), mFt.remoteName());
+        mApp.getHistoryArchiveManager().recordDownloadFailure(ar);
     }
     Work::onFailureRaise();
 }
@@ -91,7 +103,14 @@ GetAndUnzipRemoteFileWork::doWork()
     {
         // Download started
         auto state = mGetRemoteFileWork->getState();
-        if (state == State::WORK_SUCCESS)
+        if (state == State::WORK_SUCCESS &&
+            mGetRemoteFileWork->isUnzipped())
+        {
+            // Decompressed while downloading, only the rename is left
+            return finishUnzipped() ? State::WORK_SUCCESS
+                                    : State::WORK_FAILURE;
+        }
+        else if (state == State::WORK_SUCCESS)
         {
             if (!validateFile())
             {
@@ -103,12 +122,19 @@ GetAndUnzipRemoteFileWork::doWork()
         }
         return state;
     }
+    else if (mReuseLocalFile)
+    {
+        // Use it once, a retry downloads the file again
+        CLOG_DEBUG(History, "Reusing already downloaded {}", mFt.remoteName());
+        mReuseLocalFile = false;
+        return State::WORK_SUCCESS;
+    }
     else
     {
         CLOG_DEBUG(History, "Downloading and unzipping {}", mFt.remoteName());
-        mGetRemoteFileWork =
-            addWork<GetRemoteFileWork>(mFt.remoteName(), mFt.localPath_gz_tmp(),
-                                       mArchive, BasicWork::RETRY_NEVER);
+        mGetRemoteFileWork = addWork<GetRemoteFileWork>(
+            mFt.remoteName(), mFt.localPath_gz_tmp(), mArchive,
+            BasicWork::RETRY_NEVER, mFt.localPath_nogz_tmp());
         return State::WORK_RUNNING;
     }
 }
@@ -157,6 +183,27 @@ GetAndUnzipRemoteFileWork::validateFile()
     return true;
 }
 
+bool
+GetAndUnzipRemoteFileWork::finishUnzipped()
+{
+    if (!fs::exists(mFt.localPath_nogz_tmp()))
+    {
+        CLOG_ERROR(History, "Downloading and unzipping {}: .xdr.tmp not found",
+                   mFt.remoteName());
+        return false;
+    }
+    if (std::rename(mFt.localPath_nogz_tmp().c_str(),
+                    mFt.localPath_nogz().c_str()))
+    {
+        CLOG_ERROR(History,
+                   "Downloading and unzipping {}: failed to rename .xdr.tmp "
+                   "to .xdr",
+                   mFt.remoteName());
+        return false;
+    }
+    return true;
+}
+
 std::shared_ptr<HistoryArchive>
 GetAndUnzipRemoteFileWork::getArchive() const
 {
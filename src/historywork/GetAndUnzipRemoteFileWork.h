@@ -20,8 +20,12 @@ class GetAndUnzipRemoteFileWork : public Work
 
     FileTransferInfo mFt;
     std::shared_ptr<HistoryArchive> const mArchive;
+    // Whether the file was completely downloaded and unzipped before this
+    // work was created, by an earlier run that left it in place
+    bool mReuseLocalFile{false};
 
     bool validateFile();
+    bool finishUnzipped();
 
   public:
     // Passing `nullptr` for the archive argument will cause the work to
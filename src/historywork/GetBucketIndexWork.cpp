@@ -0,0 +1,99 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "historywork/GetBucketIndexWork.h"
+#include "bucket/BucketManager.h"
+#include "historywork/GetAndUnzipRemoteFileWork.h"
+#include "main/Application.h"
+#include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+
+namespace stellar
+{
+
+GetBucketIndexWork::GetBucketIndexWork(Application& app,
+                                       TmpDir const& downloadDir,
+                                       std::string const& bucketHash,
+                                       std::shared_ptr<HistoryArchive> archive)
+    : BasicWork(app, "get-bucket-index-" + bucketHash, BasicWork::RETRY_NEVER)
+    , mFt(downloadDir, HISTORY_FILE_TYPE_BUCKET, bucketHash,
+          BUCKET_INDEX_SUFFIX)
+    , mIndexPath(
+          app.getBucketManager().bucketIndexFilename(hexToBin256(bucketHash)))
+    , mArchive(archive)
+{
+}
+
+BasicWork::State
+GetBucketIndexWork::onRun()
+{
+    ZoneScoped;
+    if (!mGetIndexWork)
+    {
+        if (fs::exists(mIndexPath))
+        {
+            return State::WORK_SUCCESS;
+        }
+        // Don't retry: most likely the archive doesn't have the index
+        mGetIndexWork = std::make_shared<GetAndUnzipRemoteFileWork>(
+            mApp, mFt, mArchive, BasicWork::RETRY_NEVER);
+        mGetIndexWork->startWork(wakeSelfUpCallback());
+    }
+
+    mGetIndexWork->crankWork();
+    auto state = mGetIndexWork->getState();
+    if (state == State::WORK_SUCCESS)
+    {
+        if (!mApp.getBucketManager().renameBucketDirFile(mFt.localPath_nogz(),
+                                                         mIndexPath))
+        {
+            CLOG_WARNING(History, "Failed to move bucket index {} to {}",
+                         mFt.localPath_nogz(), mIndexPath);
+        }
+    }
+    else if (state == State::WORK_FAILURE)
+    {
+        CLOG_DEBUG(History, "No index downloaded for {}, it will be built",
+                   mFt.baseName_nogz());
+        return State::WORK_SUCCESS;
+    }
+    return state;
+}
+
+void
+GetBucketIndexWork::shutdown()
+{
+    ZoneScoped;
+    if (mGetIndexWork)
+    {
+        mGetIndexWork->shutdown();
+    }
+    BasicWork::shutdown();
+}
+
+bool
+GetBucketIndexWork::onAbort()
+{
+    ZoneScoped;
+    if (mGetIndexWork && !mGetIndexWork->isDone())
+    {
+        mGetIndexWork->crankWork();
+        return false;
+    }
+    return true;
+}
+
+void
+GetBucketIndexWork::onReset()
+{
+    mGetIndexWork.reset();
+}
+
+std::string
+GetBucketIndexWork::getStatus() const
+{
+    return mGetIndexWork ? mGetIndexWork->getStatus() : BasicWork::getStatus();
+}
+}
@@ -0,0 +1,42 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#pragma once
+
+#include "history/FileTransferInfo.h"
+#include "work/BasicWork.h"
+
+namespace stellar
+{
+
+class HistoryArchive;
+class GetAndUnzipRemoteFileWork;
+
+// Downloads the BucketListDB index published next to a bucket, and moves it
+// to the bucket dir where indexing the bucket loads it instead of building
+// it. Archives only have the indexes of the buckets published with
+// HISTORY_BUCKET_INDEXES, so this succeeds whether the index could be
+// downloaded or not. Nothing is trusted here: BucketIndex::load checks that
+// the index was built for this bucket, by the same index version and with the
+// same parameters, before it is used.
+class GetBucketIndexWork : public BasicWork
+{
+    FileTransferInfo const mFt;
+    std::string const mIndexPath;
+    std::shared_ptr<HistoryArchive> const mArchive;
+    std::shared_ptr<GetAndUnzipRemoteFileWork> mGetIndexWork;
+
+  public:
+    GetBucketIndexWork(Application& app, TmpDir const& downloadDir,
+                       std::string const& bucketHash,
+                       std::shared_ptr<HistoryArchive> archive = nullptr);
+    void shutdown() override;
+    std::string getStatus() const override;
+
+  protected:
+    State onRun() override;
+    bool onAbort() override;
+    void onReset() override;
+};
+}
@@ -7,6 +7,7 @@
 #include "history/HistoryArchive.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/HistoryManager.h"
+#include "history/HttpFileFetcher.h"
 #include "main/Application.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
@@ -18,7 +19,8 @@ GetRemoteFileWork::GetRemoteFileWork(Application& app,
                                      std::string const& remote,
                                      std::string const& local,
                                      std::shared_ptr<HistoryArchive> archive,
-                                     size_t maxRetries)
+                                     size_t maxRetries,
+                                     std::string const& localUnzipped)
     : RunCommandWork(app, std::string("get-remote-file ") + remote, maxRetries)
     , mRemote(remote)
     , mLocal(local)
@@ -27,28 +29,121 @@ GetRemoteFileWork::GetRemoteFileWork(Application& app,
           app.getMetrics().NewMeter({"history", "get", "failure"}, "failure"))
     , mBytesPerSecond(
           app.getMetrics().NewMeter({"history", "get", "throughput"}, "bytes"))
+    , mLocalUnzipped(localUnzipped)
 {
 }
 
-CommandInfo
-GetRemoteFileWork::getCommand()
+void
+GetRemoteFileWork::selectArchive()
 {
     mCurrentArchive = mArchive;
     if (!mCurrentArchive)
     {
-        mCurrentArchive = mApp.getHistoryArchiveManager()
-                              .selectRandomReadableHistoryArchive();
+        auto& ham = mApp.getHistoryArchiveManager();
+        mCurrentArchive = mApp.getConfig().HISTORY_STRIPED_DOWNLOADS
+                              ? ham.selectReadableHistoryArchiveByScore()
+                              : ham.selectRandomReadableHistoryArchive();
     }
     releaseAssert(mCurrentArchive);
     releaseAssert(mCurrentArchive->hasGetCmd());
+}
+
+CommandInfo
+GetRemoteFileWork::getCommand()
+{
+    selectArchive();
     auto cmdLine = mCurrentArchive->getFileCmd(mRemote, mLocal);
 
-    return CommandInfo{cmdLine, std::string()};
+    return CommandInfo{cmdLine, std::string(), ProcessClass::DOWNLOAD};
+}
+
+bool
+GetRemoteFileWork::startHttpRequest()
+{
+    selectArchive();
+    auto url = mCurrentArchive->getFileUrl(mRemote);
+    auto parsed = url ? HttpFileFetcher::parseUrl(*url) : std::nullopt;
+    if (!parsed)
+    {
+        return false;
+    }
+
+    mUnzipped = !mLocalUnzipped.empty() && HttpFileFetcher::canGunzip();
+    std::weak_ptr<GetRemoteFileWork> weak(
+        std::static_pointer_cast<GetRemoteFileWork>(shared_from_this()));
+    mHttpRequest = mApp.getHistoryArchiveManager().getHttpFileFetcher().fetch(
+        *parsed, mUnzipped ? mLocalUnzipped : mLocal,
+        [weak](std::error_code const& ec, size_t bytes) {
+            auto self = weak.lock();
+            if (self && !self->isDone())
+            {
+                self->mHttpEc = ec;
+                self->mHttpBytes = bytes;
+                self->mHttpDone = true;
+                self->wakeUp();
+            }
+        },
+        mUnzipped);
+    return true;
+}
+
+BasicWork::State
+GetRemoteFileWork::onRun()
+{
+    if (mHttpRequest)
+    {
+        if (!mHttpDone)
+        {
+            return State::WORK_WAITING;
+        }
+        return mHttpEc ? State::WORK_FAILURE : State::WORK_SUCCESS;
+    }
+    if (!mRunningCommand)
+    {
+        mStartedAt = mApp.getClock().now();
+    }
+    if (!mRunningCommand && mApp.getConfig().HISTORY_HTTP_CLIENT &&
+        startHttpRequest())
+    {
+        return State::WORK_WAITING;
+    }
+    mRunningCommand = true;
+    return RunCommandWork::onRun();
+}
+
+bool
+GetRemoteFileWork::onAbort()
+{
+    if (mHttpRequest)
+    {
+        if (!mHttpDone)
+        {
+            mApp.getHistoryArchiveManager().getHttpFileFetcher().cancel(
+                *mHttpRequest);
+        }
+        return true;
+    }
+    return RunCommandWork::onAbort();
 }
 
 void
 GetRemoteFileWork::onReset()
 {
+    if (mHttpRequest && !mHttpDone)
+    {
+        mApp.getHistoryArchiveManager().getHttpFileFetcher().cancel(
+            *mHttpRequest);
+    }
+    mHttpRequest.reset();
+    mHttpDone = false;
+    mHttpEc = std::error_code();
+    mHttpBytes = 0;
+    mRunningCommand = false;
+    if (mUnzipped)
+    {
+        std::remove(mLocalUnzipped.c_str());
+        mUnzipped = false;
+    }
     std::remove(mLocal.c_str());
     RunCommandWork::onReset();
 }
@@ -57,15 +152,30 @@ void
 GetRemoteFileWork::onSuccess()
 {
     releaseAssert(mCurrentArchive);
-    mBytesPerSecond.Mark(fs::size(mLocal));
+    auto bytes = mHttpRequest ? mHttpBytes : fs::size(mLocal);
+    mBytesPerSecond.Mark(bytes);
+    mApp.getHistoryArchiveManager().recordDownloadSuccess(
+        mCurrentArchive, bytes, mApp.getClock().now() - mStartedAt);
     RunCommandWork::onSuccess();
 }
 
+void
+GetRemoteFileWork::onFailureRetry()
+{
+    if (mCurrentArchive)
+    {
+        mApp.getHistoryArchiveManager().recordDownloadFailure(
+            mCurrentArchive);
+    }
+    RunCommandWork::onFailureRetry();
+}
+
 void
 GetRemoteFileWork::onFailureRaise()
 {
     releaseAssert(mCurrentArchive);
     mFailuresPerSecond.Mark(1);
+    mApp.getHistoryArchiveManager().recordDownloadFailure(mCurrentArchive);
     CLOG_ERROR(History,
                "Could not download file: archive {} maybe missing file {}",
                mCurrentArchive->getName(), mRemote);
@@ -77,4 +187,10 @@ GetRemoteFileWork::getCurrentArchive() const
 {
     return mCurrentArchive;
 }
+
+bool
+GetRemoteFileWork::isUnzipped() const
+{
+    return mUnzipped;
+}
 }
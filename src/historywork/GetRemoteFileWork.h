@@ -6,6 +6,7 @@
 
 #include "historywork/RunCommandWork.h"
 #include "medida/medida.h"
+#include <optional>
 
 namespace stellar
 {
@@ -22,6 +23,22 @@ class GetRemoteFileWork : public RunCommandWork
     medida::Meter& mFailuresPerSecond;
     medida::Meter& mBytesPerSecond;
 
+    // With HISTORY_HTTP_CLIENT, the request made to the HttpFileFetcher
+    // instead of running the get command
+    std::optional<uint64_t> mHttpRequest;
+    bool mHttpDone{false};
+    std::error_code mHttpEc;
+    size_t mHttpBytes{0};
+    bool mRunningCommand{false};
+    VirtualClock::time_point mStartedAt;
+    std::string const mLocalUnzipped;
+    bool mUnzipped{false};
+
+    void selectArchive();
+    // Start downloading with the HttpFileFetcher, returns false if the
+    // archive can't be downloaded from that way
+    bool startHttpRequest();
+
   public:
     // Passing `nullptr` for the archive argument will cause the work to
     // select a new readable history archive at random each time it runs /
@@ -29,13 +46,21 @@ class GetRemoteFileWork : public RunCommandWork
     GetRemoteFileWork(Application& app, std::string const& remote,
                       std::string const& local,
                       std::shared_ptr<HistoryArchive> archive = nullptr,
-                      size_t maxRetries = BasicWork::RETRY_A_LOT);
+                      size_t maxRetries = BasicWork::RETRY_A_LOT,
+                      std::string const& localUnzipped = "");
     ~GetRemoteFileWork() = default;
     std::shared_ptr<HistoryArchive> getCurrentArchive() const;
+    // If `localUnzipped` is set and the file can be decompressed while it is
+    // downloaded, it is written decompressed there instead of to `local`.
+    // True if the last successful run did so.
+    bool isUnzipped() const;
 
   protected:
+    BasicWork::State onRun() override;
+    bool onAbort() override;
     void onReset() override;
     void onSuccess() override;
+    void onFailureRetry() override;
     void onFailureRaise() override;
 };
 }
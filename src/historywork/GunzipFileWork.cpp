@@ -28,7 +28,7 @@ GunzipFileWork::getCommand()
         outFile = mFilenameGz.substr(0, mFilenameGz.size() - 3);
     }
     cmdLine += mFilenameGz;
-    return CommandInfo{cmdLine, outFile};
+    return CommandInfo{cmdLine, outFile, ProcessClass::COMPRESSION};
 }
 
 void
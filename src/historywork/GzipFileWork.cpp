@@ -3,7 +3,12 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "historywork/GzipFileWork.h"
+#include "main/Application.h"
 #include "util/Fs.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ParallelGzip.h"
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -23,6 +28,9 @@ GzipFileWork::onReset()
 {
     std::string filenameGz = mFilenameNoGz + ".gz";
     std::remove(filenameGz.c_str());
+    mInProcessStarted = false;
+    mInProcessDone = false;
+    mInProcessFailed = false;
 }
 
 CommandInfo
@@ -37,6 +45,71 @@ GzipFileWork::getCommand()
     }
     cmdLine += mFilenameNoGz;
 
-    return CommandInfo{cmdLine, outFile};
+    return CommandInfo{cmdLine, outFile, ProcessClass::COMPRESSION};
+}
+
+BasicWork::State
+GzipFileWork::onRun()
+{
+    if (mApp.getConfig().GZIP_THREADS == 0)
+    {
+        return RunCommandWork::onRun();
+    }
+    if (mInProcessDone)
+    {
+        return mInProcessFailed ? State::WORK_FAILURE : State::WORK_SUCCESS;
+    }
+    if (!mInProcessStarted)
+    {
+        startInProcess();
+    }
+    return State::WORK_WAITING;
+}
+
+void
+GzipFileWork::startInProcess()
+{
+#ifdef USE_ZLIB
+    mInProcessStarted = true;
+    Application& app = mApp;
+    std::weak_ptr<GzipFileWork> weak(
+        std::static_pointer_cast<GzipFileWork>(shared_from_this()));
+    app.postOnBackgroundThread(
+        [&app, weak, in = mFilenameNoGz, keepExisting = mKeepExisting,
+         threads = app.getConfig().GZIP_THREADS]() {
+            bool failed = false;
+            try
+            {
+                ZoneNamedN(gzipZone, "gzip file", true);
+                gzipFile(in, in + ".gz", threads);
+                // Like gzip, replace the file unless told to keep it
+                if (!keepExisting && std::remove(in.c_str()) != 0)
+                {
+                    throw std::runtime_error("failed to remove " + in);
+                }
+            }
+            catch (std::exception const& e)
+            {
+                CLOG_WARNING(History, "Failed to compress {}: {}", in,
+                             e.what());
+                failed = true;
+            }
+            app.postOnMainThread(
+                [weak, failed]() {
+                    auto self = weak.lock();
+                    if (self && !self->isDone())
+                    {
+                        self->mInProcessFailed = failed;
+                        self->mInProcessDone = true;
+                        self->wakeUp();
+                    }
+                },
+                "GzipFileWork: finish");
+        },
+        "GzipFileWork: start in background");
+#else
+    // Config rejects GZIP_THREADS without zlib
+    releaseAssert(false);
+#endif
 }
 }
@@ -9,18 +9,26 @@
 namespace stellar
 {
 
+// Runs gzip on a file, or with GZIP_THREADS compresses it in-process on a
+// background thread
 class GzipFileWork : public RunCommandWork
 {
     std::string const mFilenameNoGz;
     bool const mKeepExisting;
     CommandInfo getCommand() override;
 
+    bool mInProcessStarted{false};
+    bool mInProcessDone{false};
+    bool mInProcessFailed{false};
+    void startInProcess();
+
   public:
     GzipFileWork(Application& app, std::string const& filenameNoGz,
                  bool keepExisting = false);
     ~GzipFileWork() = default;
 
   protected:
+    BasicWork::State onRun() override;
     void onReset() override;
 };
 }
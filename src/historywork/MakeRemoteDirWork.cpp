@@ -4,6 +4,7 @@
 
 #include "historywork/MakeRemoteDirWork.h"
 #include "history/HistoryArchive.h"
+#include "historywork/PutRemoteFileWork.h"
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
 
@@ -24,10 +25,12 @@ CommandInfo
 MakeRemoteDirWork::getCommand()
 {
     std::string cmdLine;
-    if (mArchive->hasMkdirCmd())
+    // Object stores need no directories made before uploading into them
+    if (mArchive->hasMkdirCmd() &&
+        !PutRemoteFileWork::uploadsOverHttp(mApp, mArchive))
     {
         cmdLine = mArchive->mkdirCmd(mDir);
     }
-    return CommandInfo{cmdLine, std::string()};
+    return CommandInfo{cmdLine, std::string(), ProcessClass::UPLOAD};
 }
 }
@@ -7,8 +7,8 @@
 #include "historywork/GzipFileWork.h"
 #include "historywork/MakeRemoteDirWork.h"
 #include "historywork/PutRemoteFileWork.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkSequence.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
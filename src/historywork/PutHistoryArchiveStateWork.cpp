@@ -10,7 +10,7 @@
 #include "historywork/PutRemoteFileWork.h"
 #include "main/ErrorMessages.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -4,6 +4,8 @@
 
 #include "historywork/PutRemoteFileWork.h"
 #include "history/HistoryArchive.h"
+#include "history/HistoryArchiveManager.h"
+#include "history/HttpFileUploader.h"
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
 
@@ -22,10 +24,87 @@ PutRemoteFileWork::PutRemoteFileWork(Application& app, std::string const& local,
     releaseAssert(mArchive->hasPutCmd());
 }
 
+bool
+PutRemoteFileWork::uploadsOverHttp(Application& app,
+                                   std::shared_ptr<HistoryArchive> archive)
+{
+    return app.getConfig().HISTORY_HTTP_CLIENT && archive->hasPutUrl();
+}
+
 CommandInfo
 PutRemoteFileWork::getCommand()
 {
     auto cmdLine = mArchive->putFileCmd(mLocal, mRemote);
-    return CommandInfo{cmdLine, std::string()};
+    return CommandInfo{cmdLine, std::string(), ProcessClass::UPLOAD};
+}
+
+void
+PutRemoteFileWork::startHttpUpload()
+{
+    // The URL was checked when the config was loaded
+    auto url = HttpFileFetcher::parseUrl(mArchive->putFileUrl(mRemote));
+    releaseAssert(url);
+
+    std::weak_ptr<PutRemoteFileWork> weak(
+        std::static_pointer_cast<PutRemoteFileWork>(shared_from_this()));
+    mHttpUpload = mApp.getHistoryArchiveManager().getHttpFileUploader().upload(
+        *url, mArchive->getPutRegion(), S3Credentials::fromEnvironment(),
+        mLocal, [weak](std::error_code const& ec, size_t) {
+            auto self = weak.lock();
+            if (self && !self->isDone())
+            {
+                self->mHttpEc = ec;
+                self->mHttpDone = true;
+                self->wakeUp();
+            }
+        });
+}
+
+BasicWork::State
+PutRemoteFileWork::onRun()
+{
+    if (mHttpUpload)
+    {
+        if (!mHttpDone)
+        {
+            return State::WORK_WAITING;
+        }
+        return mHttpEc ? State::WORK_FAILURE : State::WORK_SUCCESS;
+    }
+    if (uploadsOverHttp(mApp, mArchive))
+    {
+        startHttpUpload();
+        return State::WORK_WAITING;
+    }
+    return RunCommandWork::onRun();
+}
+
+bool
+PutRemoteFileWork::onAbort()
+{
+    if (mHttpUpload)
+    {
+        if (!mHttpDone)
+        {
+            mApp.getHistoryArchiveManager().getHttpFileUploader().cancel(
+                *mHttpUpload);
+        }
+        return true;
+    }
+    return RunCommandWork::onAbort();
+}
+
+void
+PutRemoteFileWork::onReset()
+{
+    if (mHttpUpload && !mHttpDone)
+    {
+        mApp.getHistoryArchiveManager().getHttpFileUploader().cancel(
+            *mHttpUpload);
+    }
+    mHttpUpload.reset();
+    mHttpDone = false;
+    mHttpEc = std::error_code();
+    RunCommandWork::onReset();
 }
 }
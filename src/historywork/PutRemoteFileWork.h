@@ -5,6 +5,8 @@
 #pragma once
 
 #include "historywork/RunCommandWork.h"
+#include <optional>
+#include <system_error>
 
 namespace stellar
 {
@@ -18,10 +20,28 @@ class PutRemoteFileWork : public RunCommandWork
     std::shared_ptr<HistoryArchive> mArchive;
     CommandInfo getCommand() override;
 
+    // With HISTORY_HTTP_CLIENT and a put_url, the upload made with the
+    // HttpFileUploader instead of running the put command
+    std::optional<uint64_t> mHttpUpload;
+    bool mHttpDone{false};
+    std::error_code mHttpEc;
+
+    void startHttpUpload();
+
   public:
     PutRemoteFileWork(Application& app, std::string const& local,
                       std::string const& remote,
                       std::shared_ptr<HistoryArchive> archive);
     ~PutRemoteFileWork() = default;
+
+    // Whether files are uploaded to `archive` without its put command, in
+    // which case there are no directories to make either
+    static bool uploadsOverHttp(Application& app,
+                                std::shared_ptr<HistoryArchive> archive);
+
+  protected:
+    BasicWork::State onRun() override;
+    bool onAbort() override;
+    void onReset() override;
 };
 }
@@ -11,8 +11,8 @@
 #include "historywork/PutFilesWork.h"
 #include "historywork/PutHistoryArchiveStateWork.h"
 #include "main/Application.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkSequence.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
@@ -5,7 +5,7 @@
 #include "historywork/RunCommandWork.h"
 #include "main/Application.h"
 #include "process/ProcessManager.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -31,7 +31,8 @@ RunCommandWork::onRun()
         auto outfile = commandInfo.mOutFile;
         if (!cmd.empty())
         {
-            mExitEvent = mApp.getProcessManager().runProcess(cmd, outfile);
+            mExitEvent = mApp.getProcessManager().runProcess(
+                cmd, outfile, commandInfo.mClass);
             auto exit = mExitEvent.lock();
             if (!exit)
             {
@@ -13,6 +13,7 @@ struct CommandInfo
 {
     std::string mCommand;
     std::string mOutFile;
+    ProcessClass mClass{ProcessClass::OTHER};
 };
 
 /**
@@ -9,22 +9,63 @@
 #include "main/ErrorMessages.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
-#include <Tracy.hpp>
 #include <medida/meter.h>
 #include <medida/metrics_registry.h>
 
 #include <fstream>
+#include <functional>
+#include <future>
+#include <vector>
 
 namespace stellar
 {
 
+namespace
+{
+// Buckets can be many GB, so they are read in large pieces, the next one
+// being read on another thread while the current one is hashed
+size_t const HASH_READ_SIZE = 4 * 1024 * 1024;
+
+uint256
+hashFile(std::string const& filename)
+{
+    std::ifstream in(filename, std::ifstream::binary);
+    if (!in)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), filename));
+    }
+    in.exceptions(std::ios::badbit);
+    auto readInto = [&in](std::vector<char>& buf) {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        return static_cast<size_t>(in.gcount());
+    };
+
+    SHA256 hasher;
+    std::vector<char> current(HASH_READ_SIZE);
+    std::vector<char> next(HASH_READ_SIZE);
+    size_t n = readInto(current);
+    while (n > 0)
+    {
+        auto reading =
+            std::async(std::launch::async, readInto, std::ref(next));
+        hasher.add(ByteSlice(current.data(), n));
+        n = reading.get();
+        std::swap(current, next);
+    }
+    return hasher.finish();
+}
+}
+
 VerifyBucketWork::VerifyBucketWork(Application& app,
                                    std::string const& bucketFile,
                                    uint256 const& hash,
                                    OnFailureCallback failureCb)
-    : BasicWork(app, "verify-bucket-hash-" + bucketFile, BasicWork::RETRY_NEVER)
+    : BackgroundWork(app, "verify-bucket-hash-" + bucketFile,
+                     BasicWork::RETRY_NEVER, BackgroundTaskClass::VERIFY)
     , mBucketFile(bucketFile)
     , mHash(hash)
     , mOnFailure(failureCb)
@@ -32,100 +73,33 @@ VerifyBucketWork::VerifyBucketWork(Application& app,
 }
 
 BasicWork::State
-VerifyBucketWork::onRun()
+VerifyBucketWork::runInBackground()
 {
-    ZoneScoped;
-    if (mDone)
+    ZoneNamedN(verifyZone, "bucket verify", true);
+    CLOG_INFO(History, "Verifying bucket {}", binToHex(mHash));
+
+    uint256 vHash;
+    try
     {
-        if (mEc)
-        {
-            return State::WORK_FAILURE;
-        }
-        return State::WORK_SUCCESS;
+        vHash = hashFile(mBucketFile);
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_WARNING(History, "Failed verification : {}", e.what());
+        return State::WORK_FAILURE;
     }
 
-    spawnVerifier();
-    return State::WORK_WAITING;
-}
-
-void
-VerifyBucketWork::spawnVerifier()
-{
-    std::string filename = mBucketFile;
-    uint256 hash = mHash;
-    Application& app = this->mApp;
-    std::weak_ptr<VerifyBucketWork> weak(
-        std::static_pointer_cast<VerifyBucketWork>(shared_from_this()));
-    app.postOnBackgroundThread(
-        [&app, filename, weak, hash]() {
-            SHA256 hasher;
-            asio::error_code ec;
-
-            // No point in verifying buckets if things are shutting down
-            auto self = weak.lock();
-            if (!self || self->isAborting())
-            {
-                return;
-            }
-
-            try
-            {
-                ZoneNamedN(verifyZone, "bucket verify", true);
-                CLOG_INFO(History, "Verifying bucket {}", binToHex(hash));
-
-                // ensure that the stream gets its own scope to avoid race with
-                // main thread
-                std::ifstream in(filename, std::ifstream::binary);
-                if (!in)
-                {
-                    throw std::runtime_error(fmt::format(
-                        FMT_STRING("Error opening file {}"), filename));
-                }
-                in.exceptions(std::ios::badbit);
-                char buf[4096];
-                while (in)
-                {
-                    in.read(buf, sizeof(buf));
-                    hasher.add(ByteSlice(buf, in.gcount()));
-                }
-                uint256 vHash = hasher.finish();
-                if (vHash == hash)
-                {
-                    CLOG_DEBUG(History, "Verified hash ({}) for {}",
-                               hexAbbrev(hash), filename);
-                }
-                else
-                {
-                    CLOG_WARNING(History, "FAILED verifying hash for {}",
-                                 filename);
-                    CLOG_WARNING(History, "expected hash: {}", binToHex(hash));
-                    CLOG_WARNING(History, "computed hash: {}", binToHex(vHash));
-                    CLOG_WARNING(History, "{}", POSSIBLY_CORRUPTED_HISTORY);
-                    ec = std::make_error_code(std::errc::io_error);
-                }
-            }
-            catch (std::exception const& e)
-            {
-                CLOG_WARNING(History, "Failed verification : {}", e.what());
-                ec = std::make_error_code(std::errc::io_error);
-            }
-
-            // Not ideal, but needed to prevent race conditions with
-            // main thread, since BasicWork's state is not thread-safe. This is
-            // a temporary workaround, as a cleaner solution is needed.
-            app.postOnMainThread(
-                [weak, ec]() {
-                    auto self = weak.lock();
-                    if (self)
-                    {
-                        self->mEc = ec;
-                        self->mDone = true;
-                        self->wakeUp();
-                    }
-                },
-                "VerifyBucket: finish");
-        },
-        "VerifyBucket: start in background");
+    if (vHash != mHash)
+    {
+        CLOG_WARNING(History, "FAILED verifying hash for {}", mBucketFile);
+        CLOG_WARNING(History, "expected hash: {}", binToHex(mHash));
+        CLOG_WARNING(History, "computed hash: {}", binToHex(vHash));
+        CLOG_WARNING(History, "{}", POSSIBLY_CORRUPTED_HISTORY);
+        return State::WORK_FAILURE;
+    }
+    CLOG_DEBUG(History, "Verified hash ({}) for {}", hexAbbrev(mHash),
+               mBucketFile);
+    return State::WORK_SUCCESS;
 }
 
 void
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "work/BackgroundWork.h"
 #include "work/Work.h"
 #include "xdr/Stellar-types.h"
 
@@ -17,14 +18,10 @@ namespace stellar
 
 class Bucket;
 
-class VerifyBucketWork : public BasicWork
+class VerifyBucketWork : public BackgroundWork
 {
-    std::string mBucketFile;
-    uint256 mHash;
-    bool mDone{false};
-    std::error_code mEc;
-
-    void spawnVerifier();
+    std::string const mBucketFile;
+    uint256 const mHash;
 
     OnFailureCallback mOnFailure;
 
@@ -34,12 +31,7 @@ class VerifyBucketWork : public BasicWork
     ~VerifyBucketWork() = default;
 
   protected:
-    BasicWork::State onRun() override;
-    bool
-    onAbort() override
-    {
-        return true;
-    };
+    BasicWork::State runInBackground() override;
     void onFailureRaise() override;
 };
 }
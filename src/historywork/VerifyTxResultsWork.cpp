@@ -9,7 +9,7 @@
 #include "util/FileSystemException.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 namespace stellar
@@ -79,7 +79,8 @@ VerifyTxResultsWork::onRun()
         }
     };
 
-    mApp.postOnBackgroundThread(verify, "VerifyTxResults: start in background");
+    mApp.postOnBackgroundThread(verify, "VerifyTxResults: start in background",
+                                BackgroundTaskClass::VERIFY);
     return State::WORK_WAITING;
 }
 
@@ -101,8 +102,7 @@ VerifyTxResultsWork::verifyTxResultsOfCheckpoint()
         {
             auto ledgerSeq = curr.header.ledgerSeq;
             auto txResultEntry = getCurrentTxResultSet(ledgerSeq);
-            auto resultSetHash =
-                sha256(xdr::xdr_to_opaque(txResultEntry.txResultSet));
+            auto resultSetHash = xdrSha256(txResultEntry.txResultSet);
             auto genesis = ledgerSeq == LedgerManager::GENESIS_LEDGER_SEQ &&
                            txResultEntry.txResultSet.results.empty();
 
@@ -6,9 +6,10 @@
 #include "database/Database.h"
 #include "history/StateSnapshot.h"
 #include "historywork/Progress.h"
+#include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "util/XDRStream.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -31,6 +32,15 @@ WriteSnapshotWork::onRun()
         return mSuccess ? State::WORK_SUCCESS : State::WORK_FAILURE;
     }
 
+    // The snapshot reads the transactions of the checkpoint from the
+    // database, so wait for them to be written when done in the background
+    if (!mApp.getLedgerManager().isTransactionHistoryWritten(
+            mSnapshot->mLocalState.currentLedger))
+    {
+        setupWaitingCallback(std::chrono::milliseconds(100));
+        return State::WORK_WAITING;
+    }
+
     std::weak_ptr<WriteSnapshotWork> weak(
         std::static_pointer_cast<WriteSnapshotWork>(shared_from_this()));
 
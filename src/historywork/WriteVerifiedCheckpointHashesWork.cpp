@@ -11,10 +11,12 @@
 #include "main/Application.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "work/ConditionalWork.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <fmt/format.h>
+#include <fstream>
+#include <regex>
 
 namespace stellar
 {
@@ -55,9 +57,11 @@ WriteVerifiedCheckpointHashesWork::loadHashFromJsonOutput(
 
 WriteVerifiedCheckpointHashesWork::WriteVerifiedCheckpointHashesWork(
     Application& app, LedgerNumHashPair rangeEnd, std::string const& outputFile,
-    uint32_t nestedBatchSize, std::shared_ptr<HistoryArchive> archive)
+    uint32_t nestedBatchSize, std::shared_ptr<HistoryArchive> archive,
+    uint32_t downloadWindow, bool resume)
     : BatchWork(app, "write-verified-checkpoint-hashes")
     , mNestedBatchSize(nestedBatchSize)
+    , mDownloadWindow(downloadWindow)
     , mRangeEnd(rangeEnd)
     , mRangeEndPromise()
     , mRangeEndFuture(mRangeEndPromise.get_future().share())
@@ -65,6 +69,10 @@ WriteVerifiedCheckpointHashesWork::WriteVerifiedCheckpointHashesWork(
     , mArchive(archive)
     , mOutputFileName(outputFile)
 {
+    if (resume)
+    {
+        loadPartialOutputFile();
+    }
     mRangeEndPromise.set_value(mRangeEnd);
     if (mArchive)
     {
@@ -78,6 +86,73 @@ WriteVerifiedCheckpointHashesWork::~WriteVerifiedCheckpointHashesWork()
     endOutputFile();
 }
 
+void
+WriteVerifiedCheckpointHashesWork::loadPartialOutputFile()
+{
+    ZoneScoped;
+    std::ifstream in(mOutputFileName);
+    if (!in)
+    {
+        // Nothing to resume from
+        return;
+    }
+
+    // Past the opening bracket, the file has an entry per line from the
+    // highest ledger down, so a run interrupted midway leaves all the entries
+    // it flushed followed by the end of the array, or by part of an entry.
+    std::string line;
+    if (!std::getline(in, line) || line != "[")
+    {
+        throw std::runtime_error(mOutputFileName +
+                                 " isn't a file of verified checkpoints");
+    }
+    static std::regex const entryRegex(
+        "\\[([0-9]+), \"([[:xdigit:]]{64})\"\\],");
+    std::vector<LedgerNumHashPair> entries;
+    while (std::getline(in, line))
+    {
+        std::smatch match;
+        if (!std::regex_match(line, match, entryRegex))
+        {
+            break;
+        }
+        entries.emplace_back(
+            static_cast<uint32_t>(std::stoul(match[1].str())),
+            std::make_optional<Hash>(hexToBin256(match[2].str())));
+    }
+
+    if (entries.empty())
+    {
+        return;
+    }
+    if (entries.back().first ==
+        mApp.getHistoryManager().checkpointContainingLedger(
+            LedgerManager::GENESIS_LEDGER_SEQ))
+    {
+        CLOG_INFO(History, "{} is complete, nothing to verify",
+                  mOutputFileName);
+        mOutputComplete = true;
+        mCurrCheckpoint = LedgerManager::GENESIS_LEDGER_SEQ;
+        return;
+    }
+    if (entries.front().first != mRangeEnd.first)
+    {
+        CLOG_INFO(History,
+                  "Resuming the verification of ledgers up to {} rather than "
+                  "{}, as {} was started for those",
+                  entries.front().first, mRangeEnd.first, mOutputFileName);
+    }
+
+    // Start again from the lowest checkpoint verified, which gets written
+    // again when its batch is verified
+    mRangeEnd = entries.back();
+    entries.pop_back();
+    mResumedLedgers = std::move(entries);
+    mCurrCheckpoint = mRangeEnd.first;
+    CLOG_INFO(History, "Resuming verification from ledger {} with hash {}",
+              mRangeEnd.first, hexAbbrev(*mRangeEnd.second));
+}
+
 bool
 WriteVerifiedCheckpointHashesWork::hasNext() const
 {
@@ -163,10 +238,26 @@ WriteVerifiedCheckpointHashesWork::yieldMoreWork()
     return workSeq;
 }
 
+size_t
+WriteVerifiedCheckpointHashesWork::getMaxConcurrency() const
+{
+    if (mDownloadWindow == 0)
+    {
+        return BatchWork::getMaxConcurrency();
+    }
+    // Each batch element downloads mNestedBatchSize checkpoints
+    return std::max<size_t>(
+        1, (mDownloadWindow + mNestedBatchSize - 1) / mNestedBatchSize);
+}
+
 void
 WriteVerifiedCheckpointHashesWork::startOutputFile()
 {
     releaseAssert(!mOutputFile);
+    if (mOutputComplete)
+    {
+        return;
+    }
     auto mode = std::ios::out | std::ios::trunc;
     mOutputFile = std::make_shared<std::ofstream>(mOutputFileName, mode);
     if (!*mOutputFile)
@@ -175,6 +266,12 @@ WriteVerifiedCheckpointHashesWork::startOutputFile()
                                  mOutputFileName);
     }
     (*mOutputFile) << "[";
+    for (auto const& pair : mResumedLedgers)
+    {
+        (*mOutputFile) << "\n[" << pair.first << ", \""
+                       << binToHex(*pair.second) << "\"],";
+    }
+    mOutputFile->flush();
 }
 
 void
@@ -195,7 +292,8 @@ WriteVerifiedCheckpointHashesWork::endOutputFile()
 void
 WriteVerifiedCheckpointHashesWork::resetIter()
 {
-    mCurrCheckpoint = mRangeEnd.first;
+    mCurrCheckpoint =
+        mOutputComplete ? LedgerManager::GENESIS_LEDGER_SEQ : mRangeEnd.first;
     mTmpDirs.clear();
     endOutputFile();
     startOutputFile();
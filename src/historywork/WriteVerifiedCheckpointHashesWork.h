@@ -17,19 +17,37 @@ class HistoryArchive;
 class WorkSequence;
 class TmpDir;
 
+// Verifies the whole history up to a trusted ledger, writing the hash of each
+// checkpoint ledger to a JSON file as it goes, from the highest ledger down.
+// Downloads of up to `downloadWindow` checkpoints (or, when 0, of
+// MAX_CONCURRENT_SUBPROCESSES nested batches) run ahead of verification,
+// and the headers of each checkpoint are checked in parallel before being
+// linked in order. The entries of each verified batch are flushed to the file
+// so that, with `resume`, a run interrupted midway carries on from the lowest
+// checkpoint the file has, trusting its hash as the previous run did.
 class WriteVerifiedCheckpointHashesWork : public BatchWork
 {
   protected:
     bool hasNext() const override;
     std::shared_ptr<BasicWork> yieldMoreWork() override;
     void resetIter() override;
+    size_t getMaxConcurrency() const override;
 
   public:
+    // This class is a batch work, but it also creates a conditional dependency
+    // chain among its batch elements (for trusted ledger propagation): this
+    // dependency chain can in turn cause the BatchWork logic to stall, failing
+    // to saturate the parallel subprocess-execution system. So to keep the
+    // latter busy we introduce an inner level of fully-parallelizable batching
+    // of downloads. Empirically this seems to work well at a fixed size.
+    static constexpr uint32_t NESTED_DOWNLOAD_BATCH_SIZE = 64;
+
     WriteVerifiedCheckpointHashesWork(
         Application& app, LedgerNumHashPair rangeEnd,
         std::string const& outputFile,
         uint32_t nestedBatchSize = NESTED_DOWNLOAD_BATCH_SIZE,
-        std::shared_ptr<HistoryArchive> archive = nullptr);
+        std::shared_ptr<HistoryArchive> archive = nullptr,
+        uint32_t downloadWindow = 0, bool resume = false);
     ~WriteVerifiedCheckpointHashesWork();
 
     // Helper to load a hash back from a file produced by this class.
@@ -39,17 +57,12 @@ class WriteVerifiedCheckpointHashesWork : public BatchWork
     void onSuccess() override;
 
   private:
-    // This class is a batch work, but it also creates a conditional dependency
-    // chain among its batch elements (for trusted ledger propagation): this
-    // dependency chain can in turn cause the BatchWork logic to stall, failing
-    // to saturate the parallel subprocess-execution system. So to keep the
-    // latter busy we introduce an inner level of fully-parallelizable batching
-    // of downloads. Empirically this seems to work well at a fixed size.
-    static constexpr uint32_t NESTED_DOWNLOAD_BATCH_SIZE = 64;
-
     // For testing purposes we'd like to be able to change this, however.
     uint32_t const mNestedBatchSize;
 
+    // Checkpoints downloaded ahead of verification, 0 for the default
+    uint32_t const mDownloadWindow;
+
     // We make a TmpDir for each inner WorkSequence we run, but delete them on
     // the end of each to free up disk space. Since the inner WorkSequences end
     // in unpredictable order we just keep them in a vector and scan it each
@@ -58,8 +71,17 @@ class WriteVerifiedCheckpointHashesWork : public BatchWork
         std::pair<std::shared_ptr<WorkSequence>, std::shared_ptr<TmpDir>>>
         mTmpDirs;
 
-    // Total range to verify is implicitly 1 .. mRangeEnd.first
-    LedgerNumHashPair const mRangeEnd;
+    // Total range to verify is implicitly 1 .. mRangeEnd.first. When resuming,
+    // this is the lowest checkpoint of the output file instead of the
+    // trusted ledger we were constructed with.
+    LedgerNumHashPair mRangeEnd;
+
+    // Entries of the output file of an interrupted run, written back to it
+    // before those verified by this run
+    std::vector<LedgerNumHashPair> mResumedLedgers;
+    // Set when resuming from an output file that's already complete
+    bool mOutputComplete{false};
+    void loadPartialOutputFile();
 
     // We form a promise and an associated shared_future that hold a copy
     // of mRangeEnd so that we can provide it to the work that we yield
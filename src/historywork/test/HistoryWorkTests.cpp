@@ -13,6 +13,8 @@
 #include "work/WorkScheduler.h"
 #include <lib/catch.hpp>
 #include <lib/json/json.h>
+#include <fstream>
+#include <set>
 
 using namespace stellar;
 using namespace historytestutils;
@@ -49,6 +51,77 @@ TEST_CASE("write verified checkpoint hashes", "[historywork]")
     }
 }
 
+TEST_CASE("resume writing verified checkpoint hashes", "[historywork]")
+{
+    CatchupSimulation catchupSimulation{};
+    uint32_t nestedBatchSize = 4;
+    auto checkpointLedger =
+        catchupSimulation.getLastCheckpointLedger(5 * nestedBatchSize);
+    catchupSimulation.ensureOnlineCatchupPossible(checkpointLedger,
+                                                  5 * nestedBatchSize);
+
+    std::vector<LedgerNumHashPair> pairs =
+        catchupSimulation.getAllPublishedCheckpoints();
+    LedgerNumHashPair pair = pairs.back();
+    auto tmpDir = catchupSimulation.getApp().getTmpDirManager().tmpDir(
+        "resume-checkpoint-hashes-test");
+    auto file = tmpDir.getName() + "/verified-ledgers.json";
+    auto& wm = catchupSimulation.getApp().getWorkScheduler();
+    {
+        auto w = wm.executeWork<WriteVerifiedCheckpointHashesWork>(
+            pair, file, nestedBatchSize);
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+    }
+
+    // Cut the file as if the run was interrupted in the middle of writing
+    // the entries of its third batch
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            lines.emplace_back(line);
+        }
+    }
+    size_t kept = 2 * nestedBatchSize + 1;
+    REQUIRE(lines.size() > kept + 1);
+    {
+        std::ofstream out(file, std::ios::out | std::ios::trunc);
+        out << lines[0];
+        for (size_t i = 1; i <= kept; ++i)
+        {
+            out << "\n" << lines[i];
+        }
+        out << "\n" << lines[kept + 1].substr(0, 10);
+    }
+
+    {
+        auto w = wm.executeWork<WriteVerifiedCheckpointHashesWork>(
+            pair, file, nestedBatchSize, nullptr,
+            /* downloadWindow */ 2 * nestedBatchSize, /* resume */ true);
+        REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+    }
+
+    std::ifstream in(file);
+    Json::Value root;
+    Json::Reader rdr;
+    REQUIRE(rdr.parse(in, root));
+    // The checkpoint the run resumed from isn't written twice
+    std::set<uint32_t> seqs;
+    for (auto const& jpair : root)
+    {
+        seqs.insert(jpair[0].asUInt());
+    }
+    REQUIRE(seqs.size() == root.size());
+    for (auto const& p : pairs)
+    {
+        Hash h = WriteVerifiedCheckpointHashesWork::loadHashFromJsonOutput(
+            p.first, file);
+        REQUIRE(h == *p.second);
+    }
+}
+
 TEST_CASE("check single ledger header work", "[historywork]")
 {
     CatchupSimulation catchupSimulation{};
@@ -6,6 +6,7 @@
 #include "bucket/Bucket.h"
 #include "bucket/BucketInputIterator.h"
 #include "bucket/BucketManager.h"
+#include "bucket/LedgerCmp.h"
 #include "crypto/Hex.h"
 #include "history/HistoryArchive.h"
 #include "invariant/InvariantManager.h"
@@ -16,7 +17,9 @@
 #include "main/Application.h"
 #include "main/PersistentState.h"
 #include "medida/timer.h"
+#include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
+#include <algorithm>
 #include <chrono>
 #include <fmt/chrono.h>
 #include <fmt/format.h>
@@ -64,6 +67,148 @@ checkAgainstDatabase(AbstractLedgerTxn& ltx, LedgerKey const& key)
     return s;
 }
 
+// Compares a batch of bucket entries with the database, loading all of their
+// keys with one bulk load per entry type first
+static std::string
+checkBatchAgainstDatabase(Application& app, AbstractLedgerTxn& ltx,
+                          std::vector<BucketEntry>& batch)
+{
+    UnorderedSet<LedgerKey> keys;
+    for (auto const& e : batch)
+    {
+        keys.emplace(e.type() == DEADENTRY ? e.deadEntry()
+                                           : LedgerEntryKey(e.liveEntry()));
+    }
+    app.getLedgerTxnRoot().prefetch(keys);
+
+    std::string s;
+    for (auto const& e : batch)
+    {
+        s = e.type() == DEADENTRY ? checkAgainstDatabase(ltx, e.deadEntry())
+                                  : checkAgainstDatabase(ltx, e.liveEntry());
+        if (!s.empty())
+        {
+            break;
+        }
+    }
+    batch.clear();
+    return s;
+}
+
+namespace
+{
+// Reads the live entries of a bucket list in key order, one version per key
+// (the newest), by merging the buckets as they are read: nothing but the
+// current entry of each bucket is held in memory.
+class BucketListStream
+{
+    std::vector<std::unique_ptr<BucketInputIterator>> mIters;
+    // Indexes in mIters, newest bucket first, of the valid iterators, as a
+    // heap whose top has the lowest entry, the newest one among equals
+    std::vector<size_t> mHeap;
+    size_t mTotalBytes{0};
+    size_t mDoneBytes{0};
+
+    bool
+    after(size_t a, size_t b) const
+    {
+        auto c = BucketInputIterator::compareIdentity(*mIters[a], *mIters[b]);
+        return c > 0 || (c == 0 && a > b);
+    }
+
+    void
+    push(size_t i)
+    {
+        if (*mIters[i])
+        {
+            mHeap.emplace_back(i);
+            std::push_heap(mHeap.begin(), mHeap.end(),
+                           [&](size_t a, size_t b) { return after(a, b); });
+        }
+        else
+        {
+            mDoneBytes += mIters[i]->size();
+        }
+    }
+
+    size_t
+    pop()
+    {
+        std::pop_heap(mHeap.begin(), mHeap.end(),
+                      [&](size_t a, size_t b) { return after(a, b); });
+        auto i = mHeap.back();
+        mHeap.pop_back();
+        return i;
+    }
+
+  public:
+    BucketListStream(BucketManager& bm, HistoryArchiveState const& has)
+    {
+        for (auto const& level : has.currentBuckets)
+        {
+            for (auto const& hash : {level.curr, level.snap})
+            {
+                auto h = hexToBin256(hash);
+                if (isZero(h))
+                {
+                    continue;
+                }
+                auto b = bm.getBucketByHash(h);
+                if (!b)
+                {
+                    throw std::runtime_error("missing bucket: " + hash);
+                }
+                mIters.emplace_back(std::make_unique<BucketInputIterator>(b));
+                mTotalBytes += mIters.back()->size();
+            }
+        }
+        for (size_t i = 0; i < mIters.size(); ++i)
+        {
+            push(i);
+        }
+    }
+
+    // Next live entry, false once there are none left
+    bool
+    next(LedgerEntry& entry)
+    {
+        while (!mHeap.empty())
+        {
+            auto i = pop();
+            BucketEntry e = std::move(mIters[i]->entryToMove());
+            ++*mIters[i];
+            push(i);
+            // Skip the older versions of the entry
+            while (!mHeap.empty() &&
+                   !BucketEntryIdCmp{}(e, **mIters[mHeap.front()]))
+            {
+                auto j = pop();
+                ++*mIters[j];
+                push(j);
+            }
+            if (e.type() != DEADENTRY)
+            {
+                entry = std::move(e.liveEntry());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Share of the bytes of the buckets read so far
+    double
+    progress()
+    {
+        size_t read = mDoneBytes;
+        for (auto i : mHeap)
+        {
+            read += mIters[i]->pos();
+        }
+        return mTotalBytes == 0 ? 1.0 : static_cast<double>(read) / mTotalBytes;
+    }
+};
+}
+
 std::shared_ptr<Invariant>
 BucketListIsConsistentWithDatabase::registerInvariant(Application& app)
 {
@@ -186,42 +331,62 @@ BucketListIsConsistentWithDatabase::checkEntireBucketlist()
     auto& lm = mApp.getLedgerManager();
     auto& bm = mApp.getBucketManager();
     HistoryArchiveState has = lm.getLastClosedLedgerHAS();
-    std::map<LedgerKey, LedgerEntry> bucketLedgerMap =
-        bm.loadCompleteLedgerState(has);
+    BucketListStream stream(bm, has);
     EntryCounts counts;
-    medida::Timer timer(std::chrono::microseconds(1));
+    auto const batchSize =
+        std::max<size_t>(mApp.getConfig().PREFETCH_BATCH_SIZE, 1);
 
     {
+        using namespace std::chrono;
+        auto start = steady_clock::now();
+        auto lastReport = start;
         LedgerTxn ltx(mApp.getLedgerTxnRoot());
-        for (auto const& pair : bucketLedgerMap)
+        std::vector<BucketEntry> batch;
+        batch.reserve(batchSize);
+        auto checkBatch = [&]() {
+            auto s = checkBatchAgainstDatabase(mApp, ltx, batch);
+            if (!s.empty())
+            {
+                throw std::runtime_error(s);
+            }
+        };
+
+        LedgerEntry entry;
+        while (stream.next(entry))
         {
             // Don't check entry types in BucketListDB when enabled
             if (mApp.getConfig().isUsingBucketListDB() &&
-                !BucketIndex::typeNotSupported(pair.first.type()))
+                !BucketIndex::typeNotSupported(entry.data.type()))
             {
                 continue;
             }
 
-            counts.countLiveEntry(pair.second);
-            std::string s;
-            timer.Time([&]() { s = checkAgainstDatabase(ltx, pair.second); });
-            if (!s.empty())
+            counts.countLiveEntry(entry);
+            batch.emplace_back();
+            batch.back().type(LIVEENTRY);
+            batch.back().liveEntry() = std::move(entry);
+            if (batch.size() < batchSize)
             {
-                throw std::runtime_error(s);
+                continue;
             }
-            auto i = counts.totalEntries();
-            if ((i & 0x7ffff) == 0)
+            checkBatch();
+
+            auto now = steady_clock::now();
+            if (now - lastReport >= seconds(10))
             {
-                using namespace std::chrono;
-                nanoseconds ns = timer.duration_unit() *
-                                 static_cast<nanoseconds::rep>(timer.mean());
-                microseconds us = duration_cast<microseconds>(ns);
+                lastReport = now;
+                auto elapsed = duration_cast<duration<double>>(now - start);
+                auto checked = counts.totalEntries();
                 CLOG_INFO(Ledger,
-                          "Checked bucket-vs-DB consistency for "
-                          "{} entries (mean {}/entry)",
-                          i, us);
+                          "Checked bucket-vs-DB consistency for {} entries, "
+                          "{:.1f}% of the bucket list read ({:.0f} entries/s)",
+                          checked, stream.progress() * 100,
+                          checked / elapsed.count());
             }
         }
+        checkBatch();
+        CLOG_INFO(Ledger, "Checked bucket-vs-DB consistency for {} entries",
+                  counts.totalEntries());
     }
 
     // Count functionality does not support in-memory LedgerTxn
@@ -266,6 +431,10 @@ BucketListIsConsistentWithDatabase::checkOnBucketApply(
     EntryCounts counts;
     {
         LedgerTxn ltx(mApp.getLedgerTxnRoot());
+        auto const batchSize =
+            std::max<size_t>(mApp.getConfig().PREFETCH_BATCH_SIZE, 1);
+        std::vector<BucketEntry> batch;
+        batch.reserve(batchSize);
 
         bool hasPreviousEntry = false;
         BucketEntry previousEntry;
@@ -306,24 +475,31 @@ BucketListIsConsistentWithDatabase::checkOnBucketApply(
                 if (entryTypeFilter(e.liveEntry().data.type()))
                 {
                     counts.countLiveEntry(e.liveEntry());
-                    auto s = checkAgainstDatabase(ltx, e.liveEntry());
-                    if (!s.empty())
-                    {
-                        return s;
-                    }
+                    batch.emplace_back(e);
                 }
             }
             else if (e.type() == DEADENTRY)
             {
                 if (entryTypeFilter(e.deadEntry().type()))
                 {
-                    auto s = checkAgainstDatabase(ltx, e.deadEntry());
-                    if (!s.empty())
-                    {
-                        return s;
-                    }
+                    batch.emplace_back(e);
                 }
             }
+
+            if (batch.size() >= batchSize)
+            {
+                auto s = checkBatchAgainstDatabase(mApp, ltx, batch);
+                if (!s.empty())
+                {
+                    return s;
+                }
+            }
+        }
+
+        auto s = checkBatchAgainstDatabase(mApp, ltx, batch);
+        if (!s.empty())
+        {
+            return s;
         }
     }
 
@@ -44,6 +44,12 @@ class InvariantManager
                                        OperationResult const& opres,
                                        LedgerTxnDelta const& ltxDelta) = 0;
 
+    // Operations can be checked in the background, with
+    // INVARIANT_CHECK_THREADS: wait for the checks of the operations applied
+    // so far, then report their failures in the order of the operations.
+    // Called before the ledger they belong to is committed.
+    virtual void finishOperationChecks() = 0;
+
     virtual void registerInvariant(std::shared_ptr<Invariant> invariant) = 0;
 
     virtual void enableInvariant(std::string const& name) = 0;
@@ -12,31 +12,77 @@
 #include "ledger/LedgerTxn.h"
 #include "main/Application.h"
 #include "main/ErrorMessages.h"
+#include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/Math.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDRCereal.h"
 #include <fmt/format.h>
 
 #include "medida/counter.h"
+#include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <regex>
+#include <tuple>
 
 namespace stellar
 {
 
+namespace
+{
+// Applying waits for the checks once that many operations are queued
+size_t const MAX_PENDING_OPERATION_CHECKS = 1024;
+
+std::string
+operationFailureMessage(Invariant const& invariant, std::string const& result,
+                        Operation const& operation)
+{
+    return fmt::format(
+        FMT_STRING(R"(Invariant "{}" does not hold on operation: {}{}{})"),
+        invariant.getName(), result, "\n",
+        xdrToCerealString(operation, "Operation"));
+}
+}
+
+struct InvariantManagerImpl::OperationCheck
+{
+    uint64_t mSeq;
+    Operation mOperation;
+    OperationResult mResult;
+    LedgerTxnDelta mDelta;
+};
+
 std::unique_ptr<InvariantManager>
 InvariantManager::create(Application& app)
 {
-    return std::make_unique<InvariantManagerImpl>(app.getMetrics());
+    auto const& cfg = app.getConfig();
+    return std::make_unique<InvariantManagerImpl>(
+        app.getMetrics(), cfg.INVARIANT_CHECK_THREADS,
+        cfg.INVARIANT_CHECK_SAMPLE_PERCENT);
 }
 
-InvariantManagerImpl::InvariantManagerImpl(medida::MetricsRegistry& registry)
+InvariantManagerImpl::InvariantManagerImpl(medida::MetricsRegistry& registry,
+                                           uint32_t checkThreads,
+                                           uint32_t samplePercent)
     : mInvariantFailureCount(
           registry.NewCounter({"ledger", "invariant", "failure"}))
+    , mSamplePercent(samplePercent)
+    , mSampledOutOperations(registry.NewMeter(
+          {"ledger", "invariant", "sampled-out"}, "operation"))
+    , mOperationChecksWait(
+          registry.NewTimer({"ledger", "invariant", "checks-wait"}))
 {
+    releaseAssert(samplePercent > 0 && samplePercent <= 100);
+    for (uint32_t i = 0; i < checkThreads; ++i)
+    {
+        mCheckThreads.emplace_back(std::make_unique<DeadlineThreadPool>(
+            1, /* lowPriority */ false));
+    }
 }
 
 Json::Value
@@ -108,22 +154,114 @@ InvariantManagerImpl::checkOnOperationApply(Operation const& operation,
     {
         return;
     }
+    if (mSamplePercent < 100 &&
+        rand_uniform<uint32_t>(1, 100) > mSamplePercent)
+    {
+        mSampledOutOperations.Mark();
+        return;
+    }
 
-    for (auto invariant : mEnabled)
+    if (mCheckThreads.empty() || mEnabled.empty())
     {
-        auto result =
-            invariant->checkOnOperationApply(operation, opres, ltxDelta);
-        if (result.empty())
+        for (auto invariant : mEnabled)
         {
-            continue;
+            auto result =
+                invariant->checkOnOperationApply(operation, opres, ltxDelta);
+            if (result.empty())
+            {
+                continue;
+            }
+
+            onInvariantFailure(
+                invariant,
+                operationFailureMessage(*invariant, result, operation),
+                ltxDelta.header.current.ledgerSeq);
         }
+        return;
+    }
 
-        auto message = fmt::format(
-            FMT_STRING(R"(Invariant "{}" does not hold on operation: {}{}{})"),
-            invariant->getName(), result, "\n",
-            xdrToCerealString(operation, "Operation"));
-        onInvariantFailure(invariant, message,
-                           ltxDelta.header.current.ledgerSeq);
+    auto check = std::make_shared<OperationCheck const>(
+        OperationCheck{mNextCheckSeq++, operation, opres, ltxDelta});
+    auto lanes = std::min(mCheckThreads.size(), mEnabled.size());
+    {
+        std::unique_lock<std::mutex> lock(mChecksMutex);
+        mChecksCond.wait(lock, [&] {
+            return mPendingChecks < MAX_PENDING_OPERATION_CHECKS * lanes;
+        });
+        mPendingChecks += lanes;
+    }
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        mCheckThreads[lane]->post(
+            [this, check, lane, lanes]() {
+                runOperationChecks(*check, lane, lanes);
+            },
+            check->mSeq);
+    }
+}
+
+void
+InvariantManagerImpl::runOperationChecks(OperationCheck const& check,
+                                         size_t lane, size_t lanes)
+{
+    std::vector<OperationCheckFailure> failures;
+    for (size_t i = lane; i < mEnabled.size(); i += lanes)
+    {
+        auto& invariant = *mEnabled[i];
+        std::string result;
+        try
+        {
+            result = invariant.checkOnOperationApply(
+                check.mOperation, check.mResult, check.mDelta);
+        }
+        catch (std::exception& e)
+        {
+            result = std::string("check failed: ") + e.what();
+        }
+        if (!result.empty())
+        {
+            failures.emplace_back(OperationCheckFailure{
+                check.mSeq, i,
+                operationFailureMessage(invariant, result, check.mOperation),
+                check.mDelta.header.current.ledgerSeq});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mChecksMutex);
+        std::move(failures.begin(), failures.end(),
+                  std::back_inserter(mCheckFailures));
+        --mPendingChecks;
+    }
+    mChecksCond.notify_all();
+}
+
+void
+InvariantManagerImpl::finishOperationChecks()
+{
+    if (mCheckThreads.empty())
+    {
+        return;
+    }
+
+    std::vector<OperationCheckFailure> failures;
+    {
+        auto timer = mOperationChecksWait.TimeScope();
+        std::unique_lock<std::mutex> lock(mChecksMutex);
+        mChecksCond.wait(lock, [&] { return mPendingChecks == 0; });
+        failures.swap(mCheckFailures);
+    }
+
+    // Report as if they had been checked when applied
+    std::sort(failures.begin(), failures.end(),
+              [](auto const& lhs, auto const& rhs) {
+                  return std::tie(lhs.mSeq, lhs.mInvariant) <
+                         std::tie(rhs.mSeq, rhs.mInvariant);
+              });
+    for (auto const& failure : failures)
+    {
+        onInvariantFailure(mEnabled[failure.mInvariant], failure.mMessage,
+                           failure.mLedger);
     }
 }
 
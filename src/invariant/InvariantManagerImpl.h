@@ -5,13 +5,18 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "invariant/InvariantManager.h"
+#include "util/DeadlineThreadPool.h"
+#include <condition_variable>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace medida
 {
 class MetricsRegistry;
 class Counter;
+class Meter;
+class Timer;
 }
 
 namespace stellar
@@ -30,8 +35,42 @@ class InvariantManagerImpl : public InvariantManager
     };
     std::map<std::string, InvariantFailureInformation> mFailureInformation;
 
+    // What checkOnOperationApply gets, kept until it's checked in the
+    // background
+    struct OperationCheck;
+    struct OperationCheckFailure
+    {
+        uint64_t mSeq;
+        size_t mInvariant;
+        std::string mMessage;
+        uint32_t mLedger;
+    };
+
+    uint32_t const mSamplePercent;
+    medida::Meter& mSampledOutOperations;
+    medida::Timer& mOperationChecksWait;
+    uint64_t mNextCheckSeq{0};
+    std::mutex mChecksMutex;
+    std::condition_variable mChecksCond;
+    // Checks posted to mCheckThreads and not done yet
+    size_t mPendingChecks{0};
+    std::vector<OperationCheckFailure> mCheckFailures;
+    // One thread per lane: lane i checks the enabled invariants i, i + lanes,
+    // ... of every operation, in the order of the operations, so that no
+    // invariant is ever checking two operations at once. Last, so that it's
+    // joined before the rest is destroyed.
+    std::vector<std::unique_ptr<DeadlineThreadPool>> mCheckThreads;
+
+    void runOperationChecks(OperationCheck const& check, size_t lane,
+                            size_t lanes);
+
   public:
-    InvariantManagerImpl(medida::MetricsRegistry& registry);
+    // With `checkThreads`, operations are checked on that many threads
+    // instead of as they are applied. Only `samplePercent` percent of the
+    // operations, picked at random, are checked.
+    InvariantManagerImpl(medida::MetricsRegistry& registry,
+                         uint32_t checkThreads = 0,
+                         uint32_t samplePercent = 100);
 
     virtual Json::Value getJsonInfo() override;
 
@@ -41,6 +80,8 @@ class InvariantManagerImpl : public InvariantManager
                                        OperationResult const& opres,
                                        LedgerTxnDelta const& ltxDelta) override;
 
+    virtual void finishOperationChecks() override;
+
     virtual void checkOnBucketApply(
         std::shared_ptr<Bucket const> bucket, uint32_t ledger, uint32_t level,
         bool isCurr,
@@ -20,24 +20,17 @@ namespace stellar
 typedef std::map<AccountID, std::map<TrustLineAsset, Liabilities>>
     LiabilitiesMap;
 
-static int64_t
-getOfferBuyingLiabilities(LedgerEntry const& le)
-{
-    auto const& oe = le.data.offer();
-    auto res = exchangeV10WithoutPriceErrorThresholds(
-        oe.price, oe.amount, INT64_MAX, INT64_MAX, INT64_MAX,
-        RoundingType::NORMAL);
-    return res.numSheepSend;
-}
-
-static int64_t
-getOfferSellingLiabilities(LedgerEntry const& le)
+static Liabilities
+getOfferLiabilities(LedgerEntry const& le)
 {
     auto const& oe = le.data.offer();
     auto res = exchangeV10WithoutPriceErrorThresholds(
         oe.price, oe.amount, INT64_MAX, INT64_MAX, INT64_MAX,
         RoundingType::NORMAL);
-    return res.numWheatReceived;
+    Liabilities liabilities;
+    liabilities.buying = res.numSheepSend;
+    liabilities.selling = res.numWheatReceived;
+    return liabilities;
 }
 
 static int64_t
@@ -169,19 +162,18 @@ addOrSubtractLiabilities(LiabilitiesMap& deltaLiabilities,
     else if (entry->data.type() == OFFER)
     {
         auto const& offer = entry->data.offer();
+        auto offerLiabilities = getOfferLiabilities(*entry);
         if (!isIssuer(offer.sellerID, offer.selling))
         {
             deltaLiabilities[offer.sellerID]
                             [assetToTrustLineAsset(offer.selling)]
-                                .selling +=
-                sign * getOfferSellingLiabilities(*entry);
+                                .selling += sign * offerLiabilities.selling;
         }
         if (!isIssuer(offer.sellerID, offer.buying))
         {
             deltaLiabilities[offer.sellerID]
                             [assetToTrustLineAsset(offer.buying)]
-                                .buying +=
-                sign * getOfferBuyingLiabilities(*entry);
+                                .buying += sign * offerLiabilities.buying;
         }
     }
 }
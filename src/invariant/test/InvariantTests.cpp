@@ -216,3 +216,53 @@ TEST_CASE("onOperationApply fail succeed", "[invariant]")
             {}, res, ltx.getDelta()));
     }
 }
+
+TEST_CASE("onOperationApply checked in the background", "[invariant]")
+{
+    VirtualClock clock;
+    Config cfg = getTestConfig();
+    cfg.INVARIANT_CHECK_THREADS = 2;
+    Application::pointer app = createTestApplication(clock, cfg);
+    auto& im = app->getInvariantManager();
+
+    OperationResult res;
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    SECTION("Fail")
+    {
+        im.registerInvariant<TestInvariant>(0, false);
+        im.registerInvariant<TestInvariant>(1, true);
+        im.registerInvariant<TestInvariant>(2, true);
+        im.enableInvariant(TestInvariant::toString(0, false));
+        im.enableInvariant(TestInvariant::toString(2, true));
+        im.enableInvariant(TestInvariant::toString(1, true));
+
+        // Failures are only reported once the checks are done, starting
+        // with the first invariant enabled that failed on the first operation
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE_NOTHROW(im.checkOnOperationApply({}, res, ltx.getDelta()));
+        }
+        try
+        {
+            im.finishOperationChecks();
+            FAIL("invariant failure not reported");
+        }
+        catch (InvariantDoesNotHold const& e)
+        {
+            REQUIRE(std::string(e.what()).find(TestInvariant::toString(
+                        2, true)) != std::string::npos);
+        }
+    }
+    SECTION("Succeed")
+    {
+        im.registerInvariant<TestInvariant>(0, false);
+        im.registerInvariant<TestInvariant>(1, false);
+        im.enableInvariant(TestInvariant::toString(-1, false));
+
+        for (int i = 0; i < 10; ++i)
+        {
+            im.checkOnOperationApply({}, res, ltx.getDelta());
+        }
+        REQUIRE_NOTHROW(im.finishOperationChecks());
+    }
+}
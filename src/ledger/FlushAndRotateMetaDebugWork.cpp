@@ -7,6 +7,7 @@
 #include "util/DebugMetaUtils.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
+#include "util/ParallelGzip.h"
 #include <filesystem>
 #include <memory>
 #include <regex>
@@ -32,9 +33,10 @@ BasicWork::State
 FlushAndRotateMetaDebugWork::doWork()
 {
     // Step 1: transfer ownership of mMetaDebugFile to background thread
-    // and flush/fsync it. When that completes, it will post an action
-    // back to the main thread that unblocks this work to continue with
-    // gzip'ing and rotating.
+    // and flush/fsync it, then gzip it there too when built with zlib. When
+    // that completes, it will post an action back to the main thread that
+    // unblocks this work to continue with gzip'ing (if still needed) and
+    // rotating.
     if (mMetaDebugFile)
     {
         std::weak_ptr<FlushAndRotateMetaDebugWork> weak =
@@ -74,12 +76,36 @@ FlushAndRotateMetaDebugWork::doWork()
                                  e.what());
                 }
 
+                bool compressed = false;
+#ifdef USE_ZLIB
+                auto path = self->mMetaDebugPath.string();
+                CLOG_DEBUG(Ledger, "compressing meta-debug file {}", path);
+                try
+                {
+                    gzipFile(path, path + ".gz", 1);
+                    if (std::remove(path.c_str()) != 0)
+                    {
+                        throw std::runtime_error("failed to remove " + path);
+                    }
+                    compressed = true;
+                }
+                catch (std::runtime_error& e)
+                {
+                    // Leave it to GzipFileWork on the main thread
+                    CLOG_WARNING(Ledger,
+                                 "Failed to compress debug metadata: {}",
+                                 e.what());
+                    std::remove((path + ".gz").c_str());
+                }
+#endif
+
                 // Then post back to main thread.
                 self->mApp.postOnMainThread(
-                    [weak]() {
+                    [weak, compressed]() {
                         auto self = weak.lock();
                         if (self)
                         {
+                            self->mCompressed = compressed;
                             self->wakeUp();
                         }
                     },
@@ -89,19 +115,25 @@ FlushAndRotateMetaDebugWork::doWork()
         return BasicWork::State::WORK_WAITING;
     }
 
-    // Step 2: wait for the creation and completion of mGzipFileWork.
-    if (!mGzipFileWork)
+    // Step 2: unless the file was compressed in the background, wait for
+    // the creation and completion of mGzipFileWork.
+    if (mCompressed)
+    {
+        CLOG_DEBUG(Ledger, "compressed meta-debug file {}",
+                   mMetaDebugPath.string());
+    }
+    else if (!mGzipFileWork)
     {
         CLOG_DEBUG(Ledger, "compressing meta-debug file {}",
                    mMetaDebugPath.string());
         mGzipFileWork = addWork<GzipFileWork>(mMetaDebugPath.string());
         return BasicWork::State::WORK_RUNNING;
     }
-    if (!mGzipFileWork->isDone())
+    else if (!mGzipFileWork->isDone())
     {
         return mGzipFileWork->getState();
     }
-    if (mGzipFileWork->getState() == State::WORK_SUCCESS)
+    else if (mGzipFileWork->getState() == State::WORK_SUCCESS)
     {
         CLOG_DEBUG(Ledger, "compressed meta-debug file {}",
                    mMetaDebugPath.string());
@@ -16,6 +16,8 @@ class FlushAndRotateMetaDebugWork : public Work
     std::filesystem::path mMetaDebugPath;
     std::unique_ptr<XDROutputFileStream> mMetaDebugFile;
     std::shared_ptr<GzipFileWork> mGzipFileWork;
+    // Set once the background thread compressed the file after closing it
+    bool mCompressed{false};
     uint32_t mLedgersToKeep;
 
   public:
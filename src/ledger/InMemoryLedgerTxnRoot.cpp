@@ -177,6 +177,19 @@ InMemoryLedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const&)
     return 0;
 }
 
+uint32_t
+InMemoryLedgerTxnRoot::prefetchLoaded(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&)
+{
+    return 0;
+}
+
+LedgerTxnMemoryUsage
+InMemoryLedgerTxnRoot::getMemoryUsage() const
+{
+    return {};
+}
+
 void InMemoryLedgerTxnRoot::prepareNewObjects(size_t)
 {
 }
@@ -82,7 +82,11 @@ class InMemoryLedgerTxnRoot : public AbstractLedgerTxnParent
     void dropTTL(bool rebuild) override;
     double getPrefetchHitRate() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+    uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries) override;
     void prepareNewObjects(size_t s) override;
+    LedgerTxnMemoryUsage getMemoryUsage() const override;
 
 #ifdef BUILD_TESTS
     void resetForFuzzer() override;
@@ -108,6 +108,12 @@ InternalLedgerKey::InternalLedgerKey(LedgerKey const& lk)
     ledgerKeyRef() = lk;
 }
 
+InternalLedgerKey::InternalLedgerKey(LedgerKey&& lk)
+    : InternalLedgerKey(InternalLedgerEntryType::LEDGER_ENTRY)
+{
+    ledgerKeyRef() = std::move(lk);
+}
+
 InternalLedgerKey::InternalLedgerKey(SponsorshipKey const& sk)
     : InternalLedgerKey(InternalLedgerEntryType::SPONSORSHIP)
 {
@@ -71,6 +71,7 @@ class InternalLedgerKey
     explicit InternalLedgerKey(InternalLedgerEntryType t);
 
     InternalLedgerKey(LedgerKey const& lk);
+    InternalLedgerKey(LedgerKey&& lk);
     explicit InternalLedgerKey(SponsorshipKey const& sk);
     explicit InternalLedgerKey(SponsorshipCounterKey const& sck);
     explicit InternalLedgerKey(MaxSeqNumToApplyKey const& msnk);
@@ -0,0 +1,151 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerCloseTimeline.h"
+#include "lib/json/json.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace stellar
+{
+
+LedgerCloseTimeline::LedgerCloseTimeline(VirtualClock& clock) : mClock(clock)
+{
+}
+
+char const*
+LedgerCloseTimeline::eventName(Event event)
+{
+    switch (event)
+    {
+    case Event::NOMINATION_START:
+        return "nomination_start";
+    case Event::TX_SET_FETCHED:
+        return "tx_set_fetched";
+    case Event::PREPARE_START:
+        return "prepare_start";
+    case Event::PREPARE_CONFIRMED:
+        return "prepare_confirmed";
+    case Event::COMMIT_ACCEPTED:
+        return "commit_accepted";
+    case Event::EXTERNALIZED:
+        return "externalized";
+    case Event::VALUE_EXTERNALIZED:
+        return "value_externalized";
+    case Event::APPLY_START:
+        return "apply_start";
+    case Event::APPLY_END:
+        return "apply_end";
+    case Event::BUCKET_ADD_BATCH:
+        return "bucket_add_batch";
+    case Event::COMMIT:
+        return "commit";
+    case Event::META_EMITTED:
+        return "meta_emitted";
+    default:
+        releaseAssert(false);
+    }
+}
+
+void
+LedgerCloseTimeline::record(uint32_t ledgerSeq, Event event)
+{
+    releaseAssert(threadIsMain());
+    releaseAssert(event != Event::COUNT);
+    if (mTimelines.size() >= MAX_LEDGERS &&
+        ledgerSeq < mTimelines.begin()->first)
+    {
+        // Late messages about a ledger that was already dropped
+        return;
+    }
+
+    auto& tl = mTimelines[ledgerSeq];
+    auto& at = tl.mEvents[static_cast<size_t>(event)];
+    if (at)
+    {
+        return;
+    }
+    auto now = mClock.now();
+    bool first =
+        std::none_of(tl.mEvents.begin(), tl.mEvents.end(),
+                     [](auto const& e) { return e.has_value(); });
+    if (first)
+    {
+        tl.mFirstSystemTime = mClock.system_now();
+    }
+    at = now;
+
+#ifdef USE_TRACY
+    auto msg = fmt::format(FMT_STRING("ledger {} {}"), ledgerSeq,
+                           eventName(event));
+    TracyMessage(msg.c_str(), msg.size());
+#endif
+
+    while (mTimelines.size() > MAX_LEDGERS)
+    {
+        mTimelines.erase(mTimelines.begin());
+    }
+}
+
+std::map<LedgerCloseTimeline::Event, double>
+LedgerCloseTimeline::getOffsets(uint32_t ledgerSeq) const
+{
+    std::map<Event, double> res;
+    auto it = mTimelines.find(ledgerSeq);
+    if (it == mTimelines.end())
+    {
+        return res;
+    }
+    auto const& events = it->second.mEvents;
+    std::optional<VirtualClock::time_point> start;
+    for (auto const& e : events)
+    {
+        if (e && (!start || *e < *start))
+        {
+            start = e;
+        }
+    }
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        if (events[i])
+        {
+            std::chrono::duration<double, std::milli> offset =
+                *events[i] - *start;
+            res.emplace(static_cast<Event>(i), offset.count());
+        }
+    }
+    return res;
+}
+
+Json::Value
+LedgerCloseTimeline::getJsonInfo(uint32_t ledgerSeq, Timeline const& tl) const
+{
+    Json::Value res;
+    res["start"] = VirtualClock::systemPointToISOString(tl.mFirstSystemTime);
+    auto& offsets = res["offsets_ms"];
+    offsets = Json::objectValue;
+    for (auto const& kv : getOffsets(ledgerSeq))
+    {
+        offsets[eventName(kv.first)] = kv.second;
+    }
+    return res;
+}
+
+Json::Value
+LedgerCloseTimeline::getJsonInfo(std::optional<uint32_t> ledgerSeq) const
+{
+    Json::Value res = Json::objectValue;
+    for (auto const& kv : mTimelines)
+    {
+        if (!ledgerSeq || kv.first == *ledgerSeq)
+        {
+            res[std::to_string(kv.first)] = getJsonInfo(kv.first, kv.second);
+        }
+    }
+    return res;
+}
+}
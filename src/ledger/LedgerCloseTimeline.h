@@ -0,0 +1,77 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// This class records when each step of closing a ledger happened, from the
+// first nomination of its slot to the emission of its meta, so that the time
+// of a slow ledger close can be attributed to consensus, fetching the tx set,
+// applying it or storing the result. Each step is also sent to Tracy as a
+// message. Only the first occurrence of a step in a ledger is kept, and only
+// for the last MAX_LEDGERS ledgers.
+#include "util/Timer.h"
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+namespace Json
+{
+class Value;
+}
+
+namespace stellar
+{
+
+class LedgerCloseTimeline
+{
+  public:
+    enum class Event
+    {
+        NOMINATION_START,
+        TX_SET_FETCHED,
+        PREPARE_START,
+        PREPARE_CONFIRMED,
+        COMMIT_ACCEPTED,
+        EXTERNALIZED,
+        VALUE_EXTERNALIZED,
+        APPLY_START,
+        APPLY_END,
+        BUCKET_ADD_BATCH,
+        COMMIT,
+        META_EMITTED,
+        COUNT
+    };
+
+    static size_t const MAX_LEDGERS = 64;
+
+    explicit LedgerCloseTimeline(VirtualClock& clock);
+
+    void record(uint32_t ledgerSeq, Event event);
+
+    // Time of every step recorded for the ledger, in milliseconds since its
+    // first step, or empty if the ledger isn't known
+    std::map<Event, double> getOffsets(uint32_t ledgerSeq) const;
+
+    // Timeline of `ledgerSeq`, or of all the ledgers kept if not set
+    Json::Value getJsonInfo(std::optional<uint32_t> ledgerSeq) const;
+
+    static char const* eventName(Event event);
+
+  private:
+    struct Timeline
+    {
+        VirtualClock::system_time_point mFirstSystemTime;
+        std::array<std::optional<VirtualClock::time_point>,
+                   static_cast<size_t>(Event::COUNT)>
+            mEvents;
+    };
+
+    VirtualClock& mClock;
+    std::map<uint32_t, Timeline> mTimelines;
+
+    Json::Value getJsonInfo(uint32_t ledgerSeq, Timeline const& tl) const;
+};
+}
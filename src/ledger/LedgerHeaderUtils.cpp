@@ -7,14 +7,16 @@
 #include "crypto/SHA.h"
 #include "database/Database.h"
 #include "database/DatabaseUtils.h"
+#include "ledger/RecentLedgerHeaders.h"
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
 
-#include <Tracy.hpp>
+#include <algorithm>
 #include <fmt/format.h>
 #include <util/basen.h>
 
@@ -138,9 +140,17 @@ loadByHash(Database& db, Hash const& hash)
 }
 
 std::shared_ptr<LedgerHeader>
-loadBySequence(Database& db, soci::session& sess, uint32_t seq)
+loadBySequence(Database& db, soci::session& sess, uint32_t seq,
+               RecentLedgerHeaders const* recent)
 {
     ZoneScoped;
+    if (recent)
+    {
+        if (auto lhe = recent->get(seq))
+        {
+            return std::make_shared<LedgerHeader>(lhe->header);
+        }
+    }
     std::shared_ptr<LedgerHeader> lhPtr;
 
     std::string headerEncoded;
@@ -167,12 +177,12 @@ loadBySequence(Database& db, soci::session& sess, uint32_t seq)
     return lhPtr;
 }
 
-void
-deleteOldEntries(Database& db, uint32_t ledgerSeq, uint32_t count)
+uint64_t
+deleteOldEntries(soci::session& sess, uint32_t ledgerSeq, uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "ledgerheaders", "ledgerseq");
+    return DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                 "ledgerheaders", "ledgerseq");
 }
 
 void
@@ -185,12 +195,36 @@ deleteNewerEntries(Database& db, uint32_t ledgerSeq)
 
 size_t
 copyToStream(Database& db, soci::session& sess, uint32_t ledgerSeq,
-             uint32_t ledgerCount, XDROutputFileStream& headersOut)
+             uint32_t ledgerCount, XDROutputFileStream& headersOut,
+             RecentLedgerHeaders const* recent)
 {
     ZoneNamedN(selectLedgerHeadersZone, "select ledgerheaders history", true);
     uint32_t begin = ledgerSeq, end = ledgerSeq + ledgerCount;
     releaseAssert(begin <= end);
 
+    if (recent)
+    {
+        // There's no ledger 0, so the first checkpoint starts at 1
+        auto lhes = recent->getRange(std::max(begin, 1u), end);
+        if (lhes)
+        {
+            uint64_t n = 0;
+            sess << "SELECT COUNT(*) FROM ledgerheaders "
+                    "WHERE ledgerseq >= :begin AND ledgerseq < :end",
+                soci::into(n), soci::use(begin), soci::use(end);
+            if (n == lhes->size())
+            {
+                for (auto const& lhe : *lhes)
+                {
+                    CLOG_DEBUG(Ledger, "Streaming ledger-header {}",
+                               lhe.header.ledgerSeq);
+                    headersOut.writeOne(lhe);
+                }
+                return n;
+            }
+        }
+    }
+
     std::string headerEncoded;
 
     soci::statement st =
@@ -9,6 +9,7 @@
 
 namespace stellar
 {
+class RecentLedgerHeaders;
 class XDROutputFileStream;
 
 namespace LedgerHeaderUtils
@@ -24,14 +25,21 @@ LedgerHeader decodeFromData(std::string const& data);
 
 std::shared_ptr<LedgerHeader> loadByHash(Database& db, Hash const& hash);
 
-std::shared_ptr<LedgerHeader> loadBySequence(Database& db, soci::session& sess,
-                                             uint32_t seq);
+// Looks in `recent`, if set, before the database
+std::shared_ptr<LedgerHeader>
+loadBySequence(Database& db, soci::session& sess, uint32_t seq,
+               RecentLedgerHeaders const* recent = nullptr);
 
-void deleteOldEntries(Database& db, uint32_t ledgerSeq, uint32_t count);
+uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                          uint32_t count);
 void deleteNewerEntries(Database& db, uint32_t ledgerSeq);
 
+// Writes the headers from `recent`, if set and holding all of them, but
+// still counts them in the database, so that a snapshot of `sess` missing
+// some of them is noticed the same way
 size_t copyToStream(Database& db, soci::session& sess, uint32_t ledgerSeq,
-                    uint32_t ledgerCount, XDROutputFileStream& headersOut);
+                    uint32_t ledgerCount, XDROutputFileStream& headersOut,
+                    RecentLedgerHeaders const* recent = nullptr);
 
 void dropAll(Database& db);
 }
@@ -7,14 +7,56 @@
 #include "catchup/CatchupManager.h"
 #include "history/HistoryManager.h"
 #include "ledger/NetworkConfig.h"
+#include <chrono>
 #include <memory>
 
+namespace soci
+{
+class session;
+}
+
 namespace stellar
 {
 
+class ApplicableTxSetFrame;
 class LedgerCloseData;
 class Database;
+class LedgerCloseTimeline;
+class ParallelSorobanApply;
+class RecentLedgerHeaders;
+class SorobanContractUsage;
+class OperationApplyMetrics;
 class SorobanMetrics;
+class TxSetXDRFrame;
+struct LedgerTxnMemoryUsage;
+
+// Cost of applying a transaction set, as measured by
+// `LedgerManager::dryRunTxSet`.
+struct TxSetApplyCost
+{
+    size_t mTxCount{0};
+    size_t mOpCount{0};
+    size_t mTxSucceeded{0};
+    std::chrono::nanoseconds mFeeProcessingTime{0};
+    std::chrono::nanoseconds mApplyTime{0};
+    // Where the apply time went by operation type, as
+    // OperationApplyMetrics::getLedgerBreakdown
+    std::string mOperationBreakdown;
+    // Committing the changes of the transactions into the ledger's LedgerTxn
+    std::chrono::nanoseconds mCommitTime{0};
+    // Writing the level 0 bucket the BucketList would add for the ledger
+    std::chrono::nanoseconds mBucketBatchTime{0};
+    // Encoding the ledger's meta, only measured when asked for
+    std::chrono::nanoseconds mMetaTime{0};
+    size_t mMetaBytes{0};
+    // Entries looked up in the BucketList, in bulk or one at a time
+    uint64_t mEntriesLoaded{0};
+    size_t mEntriesCreated{0};
+    size_t mEntriesUpdated{0};
+    size_t mEntriesDeleted{0};
+    // Sum of the resources declared by the Soroban transactions
+    Resource mSorobanResources{Resource::makeEmptySoroban()};
+};
 
 /**
  * LedgerManager maintains, in memory, a logical pair of ledgers:
@@ -97,7 +139,7 @@ class LedgerManager
     getLastClosedLedgerHeader() const = 0;
 
     // return the HAS that corresponds to the last closed ledger as persisted in
-    // the database
+    // the database, or in memory with MODE_REPLAY_ONLY
     virtual HistoryArchiveState getLastClosedLedgerHAS() = 0;
 
     // Return the sequence number of the LCL.
@@ -129,6 +171,11 @@ class LedgerManager
     // Ledger txn here is needed for the sake of lazy load; it won't be
     // used most of the time.
     virtual SorobanNetworkConfig const& getSorobanNetworkConfig() = 0;
+    // Return an immutable copy of the network config for Soroban, which can
+    // be handed to other threads. The same copy is returned until the config
+    // changes. Must be called from the main thread.
+    virtual std::shared_ptr<SorobanNetworkConfig const>
+    getSorobanNetworkConfigSnapshot() = 0;
     virtual bool hasSorobanNetworkConfig() const = 0;
 
 #ifdef BUILD_TESTS
@@ -138,6 +185,16 @@ class LedgerManager
     // Return the (changing) number of seconds since the LCL closed.
     virtual uint64_t secondsSinceLastLedgerClose() const = 0;
 
+    // Return the approximate memory held, just before it was committed, by
+    // the LedgerTxn of the last ledger closed and by the caches of the
+    // LedgerTxnRoot underneath it.
+    virtual LedgerTxnMemoryUsage const& getLastLedgerMemoryUsage() const = 0;
+
+    // Return the host invocations running ahead of the Soroban transactions
+    // being applied, or nullptr outside of the Soroban phase of apply or if
+    // EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS is 0.
+    virtual ParallelSorobanApply* getParallelSorobanApply() const = 0;
+
     // Ensure any metrics that are "current state" gauge-like counters reflect
     // the current reality as best as possible.
     virtual void syncMetrics() = 0;
@@ -178,9 +235,40 @@ class LedgerManager
     // permit testing.
     virtual void closeLedger(LedgerCloseData const& ledgerData) = 0;
 
-    // deletes old entries stored in the database
-    virtual void deleteOldEntries(Database& db, uint32_t ledgerSeq,
-                                  uint32_t count) = 0;
+    // While set, the ledgers closed are committed without waiting for the
+    // database to make them durable, and garbage collecting buckets and
+    // publishing history wait for the first ledger closed once it's unset,
+    // which makes them all durable. A crash can then lose the last ledgers
+    // closed, but not the buckets of the ledger it restarts from.
+    virtual void setDeferDurability(bool defer) = 0;
+
+    // Start work for closing `ledgerData` that does not depend on the ledger
+    // state, so that it overlaps with whatever happens before the ledger is
+    // actually closed (for example waiting on bucket merges or closing the
+    // previous ledger). Currently this verifies the transaction signatures
+    // against the source accounts' master keys on a background thread,
+    // warming the signature cache used during apply. Calling this is always
+    // optional and never changes the outcome of `closeLedger`.
+    virtual void startPreparingLedger(LedgerCloseData const& ledgerData) = 0;
+
+    // Start prefetching the ledger entries that `txSet`, a candidate for the
+    // next ledger, would load when applied, in batches posted to the main
+    // thread. Superseded by a later call for a different set and cancelled by
+    // `cancelSpeculativePrefetch` or by closing a ledger. Does nothing unless
+    // EXPERIMENTAL_SPECULATIVE_PREFETCH is set.
+    virtual void
+    startSpeculativePrefetch(ApplicableTxSetFrame const& txSet) = 0;
+    virtual void cancelSpeculativePrefetch() = 0;
+
+    // deletes old entries stored in the database, the rows of at most
+    // `count` ledgers up to `ledgerSeq` from each table, and returns the
+    // number of rows deleted
+    virtual uint64_t deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                                      uint32_t count) = 0;
+    // Same, through `sess`, in the transaction the caller opened on it. Can
+    // be called from any thread.
+    virtual uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                      uint32_t count) = 0;
 
     // cleans historical data newer than ledgerSeq
     // as this is used when applying buckets, the data is deleted such that:
@@ -188,12 +276,35 @@ class LedgerManager
     // everything else > ledgerSeq
     virtual void deleteNewerEntries(Database& db, uint32_t ledgerSeq) = 0;
 
+    // Whether the txhistory and txfeehistory rows of the ledgers up to
+    // `ledgerSeq` are in the database, which they may not be yet when
+    // BACKGROUND_TX_HISTORY_WRITES is set.
+    virtual bool isTransactionHistoryWritten(uint32_t ledgerSeq) = 0;
+
     virtual void setLastClosedLedger(LedgerHeaderHistoryEntry const& lastClosed,
                                      bool storeInDB) = 0;
 
     virtual void manuallyAdvanceLedgerHeader(LedgerHeader const& header) = 0;
 
     virtual SorobanMetrics& getSorobanMetrics() = 0;
+    virtual OperationApplyMetrics& getOperationApplyMetrics() = 0;
+    virtual LedgerCloseTimeline& getCloseTimeline() = 0;
+    virtual SorobanContractUsage& getSorobanContractUsage() = 0;
+    // Headers of the last ledgers closed, safe to read from any thread
+    virtual RecentLedgerHeaders const& getRecentLedgerHeaders() const = 0;
+
+    // Applies `txSet` on top of the last closed ledger as if it closed at
+    // `closeTime` and returns what it cost, then rolls back all of its
+    // changes. Nothing is stored or emitted as meta, but the apply metrics
+    // are updated as usual; with `withMeta` the meta is built and encoded as
+    // when streaming it. This is only meant for capacity planning and
+    // benchmarks, and can be repeated on the same last closed ledger.
+    virtual TxSetApplyCost dryRunTxSet(TxSetXDRFrame const& txSet,
+                                       TimePoint closeTime, bool withMeta) = 0;
+
+    // Writes out the meta still queued for METADATA_OUTPUT_STREAM and stops
+    // the thread writing it. No ledger can be closed after this.
+    virtual void shutdown() = 0;
 
     virtual ~LedgerManager()
     {
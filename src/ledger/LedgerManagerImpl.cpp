@@ -18,18 +18,23 @@
 #include "herder/TxSetFrame.h"
 #include "herder/Upgrades.h"
 #include "history/HistoryManager.h"
+#include "invariant/InvariantManager.h"
 #include "ledger/FlushAndRotateMetaDebugWork.h"
 #include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerRange.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/MetaStreamFormat.h"
+#include "ledger/MetaStreamWriter.h"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "main/ErrorMessages.h"
 #include "overlay/OverlayManager.h"
 #include "transactions/OperationFrame.h"
+#include "transactions/TransactionFrame.h"
 #include "transactions/TransactionFrameBase.h"
+#include "transactions/TransactionHistoryWriter.h"
 #include "transactions/TransactionMetaFrame.h"
 #include "transactions/TransactionSQL.h"
 #include "transactions/TransactionUtils.h"
@@ -38,10 +43,13 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MemoryAttribution.h"
 #include "util/ProtocolVersion.h"
+#include "util/UnorderedSet.h"
 #include "util/XDRCereal.h"
 #include "util/XDROperators.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "work/WorkScheduler.h"
 
 #include <fmt/format.h>
@@ -55,8 +63,8 @@
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
 #include "medida/timer.h"
-#include <Tracy.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <numeric>
 #include <regex>
@@ -128,6 +136,10 @@ LedgerManager::ledgerAbbrev(LedgerHeaderHistoryEntry const& he)
 LedgerManagerImpl::LedgerManagerImpl(Application& app)
     : mApp(app)
     , mSorobanMetrics(app.getMetrics())
+    , mOperationApplyMetrics(app.getMetrics())
+    , mCloseTimeline(app.getClock())
+    , mRecentLedgerHeaders(app.getMetrics())
+    , mSorobanContractUsage(app.getConfig().SOROBAN_CONTRACT_USAGE_TOP_N)
     , mTransactionApply(
           app.getMetrics().NewTimer({"ledger", "transaction", "apply"}))
     , mTransactionCount(
@@ -136,6 +148,12 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewHistogram({"ledger", "operation", "count"}))
     , mPrefetchHitRate(
           app.getMetrics().NewHistogram({"ledger", "prefetch", "hit-rate"}))
+    , mSpeculativePrefetchLoad(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "speculative-load"}, "entry"))
+    , mApplyPrefetchCached(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "apply-cached"}, "entry"))
+    , mApplyPrefetchLoad(app.getMetrics().NewMeter(
+          {"ledger", "prefetch", "apply-load"}, "entry"))
     , mLedgerClose(app.getMetrics().NewTimer({"ledger", "ledger", "close"}))
     , mLedgerAgeClosed(app.getMetrics().NewBuckets(
           {"ledger", "age", "closed"}, {5000.0, 7000.0, 10000.0, 20000.0}))
@@ -153,15 +171,46 @@ LedgerManagerImpl::LedgerManagerImpl(Application& app)
           app.getMetrics().NewMeter({"ledger", "metastream", "bytes"}, "byte"))
     , mMetaStreamWriteTime(
           app.getMetrics().NewTimer({"ledger", "metastream", "write"}))
+    , mLedgerTxnInternalBytes(app.getMetrics().NewCounter(
+          {"ledger", "memory", "ledger-txn-internal"}))
+    , mEntryCacheBytes(
+          app.getMetrics().NewCounter({"ledger", "memory", "entry-cache"}))
+    , mBestOffersBytes(
+          app.getMetrics().NewCounter({"ledger", "memory", "best-offers"}))
+    , mSorobanStateBytes(
+          app.getMetrics().NewCounter({"ledger", "memory", "soroban-state"}))
+    , mLiquidityPoolsBytes(app.getMetrics().NewCounter(
+          {"ledger", "memory", "liquidity-pools"}))
     , mLastClose(mApp.getClock().now())
     , mCatchupDuration(
           app.getMetrics().NewTimer({"ledger", "catchup", "duration"}))
     , mState(LM_BOOTING_STATE)
 
 {
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        std::string name = xdr::xdr_traits<LedgerEntryType>::enum_name(
+            static_cast<LedgerEntryType>(let));
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        mLedgerTxnEntryBytes.emplace_back(&app.getMetrics().NewCounter(
+            {"ledger", "memory", "ledger-txn-" + name}));
+    }
     setupLedgerCloseMetaStream();
 }
 
+LedgerManagerImpl::~LedgerManagerImpl()
+{
+}
+
+void
+LedgerManagerImpl::shutdown()
+{
+    if (mMetaStreamWriter)
+    {
+        mMetaStreamWriter->shutdown();
+    }
+}
+
 void
 LedgerManagerImpl::moveToSynced()
 {
@@ -351,6 +400,12 @@ LedgerManagerImpl::loadLastKnownLedger(bool restoreBucketlist,
 
     releaseAssert(latestLedgerHeader.has_value());
 
+    // Checkpoints are queued to publish before the ledger closing them is
+    // committed, so drop any queued by a ledger lost in a crash: it will be
+    // queued again when the ledger is closed again.
+    mApp.getHistoryManager().deleteCheckpointsNewerThan(
+        latestLedgerHeader->ledgerSeq + 1);
+
     // Step 3. Restore BucketList if we're doing a full core startup
     // (startServices=true), OR when using BucketListDB
     if (restoreBucketlist || mApp.getConfig().isUsingBucketListDB())
@@ -534,6 +589,10 @@ HistoryArchiveState
 LedgerManagerImpl::getLastClosedLedgerHAS()
 {
     ZoneScoped;
+    if (mReplayLastClosedHAS)
+    {
+        return *mReplayLastClosedHAS;
+    }
 
     string hasString = mApp.getPersistentState().getState(
         PersistentState::kHistoryArchiveState);
@@ -561,6 +620,19 @@ LedgerManagerImpl::getSorobanNetworkConfig()
     return getSorobanNetworkConfigInternal();
 }
 
+std::shared_ptr<SorobanNetworkConfig const>
+LedgerManagerImpl::getSorobanNetworkConfigSnapshot()
+{
+    releaseAssert(threadIsMain());
+    if (!mSorobanNetworkConfigSnapshot)
+    {
+        mSorobanNetworkConfigSnapshot =
+            std::make_shared<SorobanNetworkConfig const>(
+                getSorobanNetworkConfigInternal());
+    }
+    return mSorobanNetworkConfigSnapshot;
+}
+
 bool
 LedgerManagerImpl::hasSorobanNetworkConfig() const
 {
@@ -571,6 +643,8 @@ LedgerManagerImpl::hasSorobanNetworkConfig() const
 SorobanNetworkConfig&
 LedgerManagerImpl::getMutableSorobanNetworkConfig()
 {
+    // The caller may change the config
+    mSorobanNetworkConfigSnapshot.reset();
     return getSorobanNetworkConfigInternal();
 }
 #endif
@@ -581,6 +655,30 @@ LedgerManagerImpl::getSorobanMetrics()
     return mSorobanMetrics;
 }
 
+OperationApplyMetrics&
+LedgerManagerImpl::getOperationApplyMetrics()
+{
+    return mOperationApplyMetrics;
+}
+
+LedgerCloseTimeline&
+LedgerManagerImpl::getCloseTimeline()
+{
+    return mCloseTimeline;
+}
+
+SorobanContractUsage&
+LedgerManagerImpl::getSorobanContractUsage()
+{
+    return mSorobanContractUsage;
+}
+
+RecentLedgerHeaders const&
+LedgerManagerImpl::getRecentLedgerHeaders() const
+{
+    return mRecentLedgerHeaders;
+}
+
 void
 LedgerManagerImpl::publishSorobanMetrics()
 {
@@ -639,6 +737,8 @@ LedgerManagerImpl::valueExternalized(LedgerCloseData const& ledgerData)
 
     // Capture LCL before we do any processing (which may trigger ledger close)
     auto lcl = getLastClosedLedgerNum();
+    mCloseTimeline.record(ledgerData.getLedgerSeq(),
+                          LedgerCloseTimeline::Event::VALUE_EXTERNALIZED);
 
     CLOG_INFO(Ledger,
               "Got consensus: [seq={}, prev={}, txs={}, ops={}, sv: {}]",
@@ -682,6 +782,133 @@ LedgerManagerImpl::valueExternalized(LedgerCloseData const& ledgerData)
     FrameMark;
 }
 
+void
+LedgerManagerImpl::setDeferDurability(bool defer)
+{
+    if (defer != mDeferDurability)
+    {
+        mApp.getDatabase().setSynchronousCommits(!defer);
+        mDeferDurability = defer;
+    }
+}
+
+void
+LedgerManagerImpl::startPreparingLedger(LedgerCloseData const& ledgerData)
+{
+    ZoneScoped;
+    uint32_t seq = ledgerData.getLedgerSeq();
+    if (seq <= getLastClosedLedgerNum() || seq == mPreparingLedgerSeq)
+    {
+        return;
+    }
+    mPreparingLedgerSeq = seq;
+
+    // The task must not reference `this`, as it may still be queued when the
+    // ledger manager goes away; it only touches the immutable tx set and
+    // the (thread-safe) signature cache.
+    auto txSet = ledgerData.getTxSet();
+    auto closingSeq = mClosingLedgerSeq;
+    Hash networkID = mApp.getNetworkID();
+    auto trusted = ledgerData.getTxsWithTrustedSignatures();
+    mApp.postOnBackgroundThread(
+        [txSet, closingSeq, seq, networkID, trusted]() {
+            ZoneNamedN(prepareZone, "prepare ledger", true);
+            try
+            {
+                for (auto const& phase :
+                     txSet->createTransactionFrames(networkID))
+                {
+                    for (auto const& tx : phase)
+                    {
+                        if (seq < *closingSeq)
+                        {
+                            return;
+                        }
+                        if (trusted && trusted->count(tx->getContentsHash()))
+                        {
+                            continue;
+                        }
+                        verifyMasterKeySignatures(networkID, *tx);
+                    }
+                }
+            }
+            catch (std::exception const& e)
+            {
+                // Malformed transactions are dealt with when the ledger is
+                // closed
+                CLOG_DEBUG(Ledger, "Could not prepare ledger {}: {}", seq,
+                           e.what());
+            }
+        },
+        "LedgerManager: prepare ledger", BackgroundTaskClass::PREFETCH);
+}
+
+void
+LedgerManagerImpl::startSpeculativePrefetch(ApplicableTxSetFrame const& txSet)
+{
+    ZoneScoped;
+    auto const& cfg = mApp.getConfig();
+    if (!cfg.EXPERIMENTAL_SPECULATIVE_PREFETCH ||
+        cfg.PREFETCH_BATCH_SIZE == 0 ||
+        mSpeculativePrefetchTxSet == txSet.getContentsHash())
+    {
+        return;
+    }
+
+    cancelSpeculativePrefetch();
+    mSpeculativePrefetchTxSet = txSet.getContentsHash();
+
+    // Same keys as prefetchTxSourceIds and prefetchTransactionData will ask
+    // for once the set is applied
+    UnorderedSet<LedgerKey> keySet;
+    for (size_t i = 0; i < txSet.numPhases(); ++i)
+    {
+        for (auto const& tx : txSet.getTxsForPhase(static_cast<TxSetPhase>(i)))
+        {
+            tx->insertKeysForFeeProcessing(keySet);
+            tx->insertKeysForTxApply(keySet);
+        }
+    }
+    auto keys =
+        std::make_shared<std::vector<LedgerKey>>(keySet.begin(), keySet.end());
+    speculativePrefetchStep(mSpeculativePrefetchGeneration, keys, 0);
+}
+
+void
+LedgerManagerImpl::cancelSpeculativePrefetch()
+{
+    ++mSpeculativePrefetchGeneration;
+    mSpeculativePrefetchTxSet.reset();
+}
+
+void
+LedgerManagerImpl::speculativePrefetchStep(
+    uint64_t generation, std::shared_ptr<std::vector<LedgerKey>> keys,
+    size_t next)
+{
+    ZoneScoped;
+    if (generation != mSpeculativePrefetchGeneration || mApp.isStopping())
+    {
+        return;
+    }
+
+    auto end = std::min(keys->size(),
+                        next + mApp.getConfig().PREFETCH_BATCH_SIZE);
+    UnorderedSet<LedgerKey> batch(keys->begin() + next, keys->begin() + end);
+    mSpeculativePrefetchLoad.Mark(mApp.getLedgerTxnRoot().prefetch(batch));
+    if (end == keys->size())
+    {
+        return;
+    }
+
+    // Yield to SCP and overlay between batches
+    mApp.postOnMainThread(
+        [this, generation, keys, end]() {
+            speculativePrefetchStep(generation, keys, end);
+        },
+        "LedgerManager: speculative prefetch");
+}
+
 void
 LedgerManagerImpl::closeLedgerIf(LedgerCloseData const& ledgerData)
 {
@@ -754,24 +981,82 @@ LedgerManagerImpl::syncMetrics()
     mApp.syncOwnMetrics();
 }
 
+LedgerTxnMemoryUsage const&
+LedgerManagerImpl::getLastLedgerMemoryUsage() const
+{
+    return mLastLedgerMemoryUsage;
+}
+
+ParallelSorobanApply*
+LedgerManagerImpl::getParallelSorobanApply() const
+{
+    return mParallelSorobanApply.get();
+}
+
+void
+LedgerManagerImpl::recordMemoryUsage(AbstractLedgerTxn const& ltx)
+{
+    ZoneScoped;
+    auto usage = ltx.getMemoryUsage();
+    auto rootUsage = mApp.getLedgerTxnRoot().getMemoryUsage();
+    usage.entryCacheBytes = rootUsage.entryCacheBytes;
+    usage.bestOffersBytes = rootUsage.bestOffersBytes;
+    usage.contractCodeAndTTLBytes = rootUsage.contractCodeAndTTLBytes;
+    usage.liquidityPoolsBytes = rootUsage.liquidityPoolsBytes;
+
+    for (size_t i = 0; i < mLedgerTxnEntryBytes.size(); ++i)
+    {
+        auto it = usage.entryBytes.find(static_cast<LedgerEntryType>(i));
+        mLedgerTxnEntryBytes[i]->set_count(
+            it == usage.entryBytes.end() ? 0 : it->second);
+    }
+    mLedgerTxnInternalBytes.set_count(usage.internalEntryBytes);
+    mEntryCacheBytes.set_count(usage.entryCacheBytes);
+    mBestOffersBytes.set_count(usage.bestOffersBytes);
+    mSorobanStateBytes.set_count(usage.contractCodeAndTTLBytes);
+    mLiquidityPoolsBytes.set_count(usage.liquidityPoolsBytes);
+    mLastLedgerMemoryUsage = std::move(usage);
+}
+
+bool
+LedgerManagerImpl::isStreamingMeta() const
+{
+    return mMetaStream || mMetaStreamWriter || mMetaDebugStream;
+}
+
 void
 LedgerManagerImpl::emitNextMeta()
 {
     ZoneScoped;
 
     releaseAssert(mNextMetaToEmit);
-    releaseAssert(mMetaStream || mMetaDebugStream);
+    releaseAssert(isStreamingMeta());
     auto timer = LogSlowExecution("MetaStream write",
                                   LogSlowExecution::Mode::AUTOMATIC_RAII,
                                   "took", std::chrono::milliseconds(100));
     auto streamWrite = mMetaStreamWriteTime.TimeScope();
-    if (mMetaStream)
+    auto const& cfg = mApp.getConfig();
+    auto ledgerSeq = mNextMetaToEmit->ledgerHeader().header.ledgerSeq;
+    if (mMetaStream && cfg.METADATA_OUTPUT_STREAM_FORMAT == "FRAMED")
+    {
+        auto frame = toMetaFrame(toXDRRecord(mNextMetaToEmit->getXDR()),
+                                 ledgerSeq,
+                                 cfg.METADATA_OUTPUT_STREAM_COMPRESSION);
+        mMetaStream->writeBytes(frame.data(), frame.size());
+        mMetaStream->flush();
+        mMetaStreamBytes.Mark(frame.size());
+    }
+    else if (mMetaStream)
     {
         size_t written = 0;
         mMetaStream->writeOne(mNextMetaToEmit->getXDR(), nullptr, &written);
         mMetaStream->flush();
         mMetaStreamBytes.Mark(written);
     }
+    else if (mMetaStreamWriter)
+    {
+        mMetaStreamWriter->enqueue(mNextMetaToEmit->getXDR(), ledgerSeq);
+    }
     if (mMetaDebugStream)
     {
         mMetaDebugStream->writeOne(mNextMetaToEmit->getXDR());
@@ -780,9 +1065,42 @@ LedgerManagerImpl::emitNextMeta()
         // the meta for problematic ledgers that is vital for diagnostics.
         mMetaDebugStream->flush();
     }
+    mCloseTimeline.record(ledgerSeq, LedgerCloseTimeline::Event::META_EMITTED);
     mNextMetaToEmit.reset();
 }
 
+// Whether any of `changes` touches a config setting entry
+static bool
+changesConfigSettings(LedgerEntryChanges const& changes)
+{
+    for (auto const& change : changes)
+    {
+        LedgerEntryType type;
+        switch (change.type())
+        {
+        case LEDGER_ENTRY_CREATED:
+            type = change.created().data.type();
+            break;
+        case LEDGER_ENTRY_UPDATED:
+            type = change.updated().data.type();
+            break;
+        case LEDGER_ENTRY_REMOVED:
+            type = change.removed().type();
+            break;
+        case LEDGER_ENTRY_STATE:
+            type = change.state().data.type();
+            break;
+        default:
+            throw std::runtime_error("unknown ledger entry change type");
+        }
+        if (type == CONFIG_SETTING)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 /*
     This is the main method that closes the current ledger based on
 the close context that was computed by SCP or by the historical module
@@ -793,11 +1111,17 @@ void
 LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Ledger);
     auto ledgerTime = mLedgerClose.TimeScope();
     LogSlowExecution closeLedgerTime{"closeLedger",
                                      LogSlowExecution::Mode::MANUAL, "",
                                      std::chrono::milliseconds::max()};
 
+    // Preparations of earlier ledgers are now useless; those of this ledger
+    // or later ones keep going, as they only add to the signature cache.
+    *mClosingLedgerSeq = ledgerData.getLedgerSeq();
+    cancelSpeculativePrefetch();
+
     LedgerTxn ltx(mApp.getLedgerTxnRoot());
     auto header = ltx.loadHeader();
     auto initialLedgerVers = header.current().ledgerVersion;
@@ -807,6 +1131,8 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
                header.current().ledgerSeq);
 
     ZoneValue(static_cast<int64_t>(header.current().ledgerSeq));
+    mCloseTimeline.record(header.current().ledgerSeq,
+                          LedgerCloseTimeline::Event::APPLY_START);
 
     auto now = mApp.getClock().now();
     mLedgerAgeClosed.Update(now - mLastClose);
@@ -875,7 +1201,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     // the ledger entries modified by each tx during tx processing in a
     // LedgerCloseMeta, for streaming to attached clients (typically: horizon).
     std::unique_ptr<LedgerCloseMetaFrame> ledgerCloseMeta;
-    if (mMetaStream || mMetaDebugStream)
+    if (isStreamingMeta())
     {
         if (mNextMetaToEmit)
         {
@@ -899,21 +1225,46 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     std::vector<TransactionFrameBasePtr> const txs =
         applicableTxSet->getTxsInApplyOrder();
 
+    if (auto const& trusted = ledgerData.getTxsWithTrustedSignatures())
+    {
+        for (auto const& tx : txs)
+        {
+            bool isTrusted = trusted->count(tx->getContentsHash()) != 0;
+            tx->setSignaturesTrusted(isTrusted);
+        }
+    }
+
     // first, prefetch source accounts for txset, then charge fees
     prefetchTxSourceIds(txs);
-    processFeesSeqNums(txs, ltx, *applicableTxSet, ledgerCloseMeta);
+    TransactionHistoryRows txHistoryRows;
+    processFeesSeqNums(txs, ltx, *applicableTxSet, ledgerCloseMeta,
+                       txHistoryRows);
 
     TransactionResultSet txResultSet;
     txResultSet.results.reserve(txs.size());
-    applyTransactions(*applicableTxSet, txs, ltx, txResultSet, ledgerCloseMeta);
+    applyTransactions(*applicableTxSet, txs, ltx, txResultSet, ledgerCloseMeta,
+                      txHistoryRows);
+    mApp.getInvariantManager().finishOperationChecks();
+    mCloseTimeline.record(ltx.loadHeader().current().ledgerSeq,
+                          LedgerCloseTimeline::Event::APPLY_END);
     if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
     {
-        storeTxSet(mApp.getDatabase(), ltx.loadHeader().current().ledgerSeq,
-                   *txSet);
+        auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
+        // The writer takes the rows once the ledger is committed
+        if (!getTxHistoryWriter())
+        {
+            txHistoryRows.store(mApp.getDatabase(), ledgerSeq,
+                                mApp.getConfig());
+        }
+        storeTxSet(mApp.getDatabase(), ledgerSeq, *txSet);
     }
 
     ltx.loadHeader().current().txSetResultHash = xdrSha256(txResultSet);
 
+    // Config settings only change through upgrades, so the Soroban network
+    // config is only reloaded when one of them touches a setting
+    bool sorobanConfigChanged = !hasSorobanNetworkConfig();
+
     // apply any upgrades that were decided during consensus
     // this must be done after applying transactions as the txset
     // was validated before upgrades
@@ -946,6 +1297,8 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
 
             auto ledgerSeq = ltxUpgrade.loadHeader().current().ledgerSeq;
             LedgerEntryChanges changes = ltxUpgrade.getChanges();
+            sorobanConfigChanged =
+                sorobanConfigChanged || changesConfigSettings(changes);
             if (ledgerCloseMeta)
             {
                 auto& up = ledgerCloseMeta->upgradesProcessing();
@@ -955,7 +1308,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
                 uem.changes = changes;
             }
             // Note: Index from 1 rather than 0 to match the behavior of
-            // storeTransaction and storeTransactionFee.
+            // the txhistory and txfeehistory tables.
             if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
             {
                 Upgrades::storeUpgradeHistory(getDatabase(), ledgerSeq,
@@ -977,7 +1330,10 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
     if (protocolVersionStartsFrom(maybeNewVersion, SOROBAN_PROTOCOL_VERSION))
     {
-        updateNetworkConfig(ltx);
+        if (sorobanConfigChanged || maybeNewVersion != initialLedgerVers)
+        {
+            updateNetworkConfig(ltx);
+        }
         mApp.getOverlayManager().dropPeersIf(
             shouldDropPeerPredicate, maybeNewVersion, "version too old");
     }
@@ -990,7 +1346,7 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         throw std::runtime_error("Local node's ledger corrupted during close");
     }
 
-    if (mMetaStream || mMetaDebugStream)
+    if (isStreamingMeta())
     {
         releaseAssert(ledgerCloseMeta);
         ledgerCloseMeta->ledgerHeader() = mLastClosedLedger;
@@ -1013,9 +1369,11 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     // This is unfortunate and it would be nice if we could make it not
     // be so subtle, but for the time being this is where we are.
     //
-    // 1. Queue any history-checkpoint to the database, _within_ the current
-    //    transaction. This way if there's a crash after commit and before
-    //    we've published successfully, we'll re-publish on restart.
+    // 1. Queue any history-checkpoint to disk, _before_ committing the
+    //    current transaction. This way if there's a crash after commit and
+    //    before we've published successfully, we'll re-publish on restart;
+    //    a checkpoint queued by a ledger that didn't commit is dropped when
+    //    the LCL is loaded.
     //
     // 2. Commit the current transaction.
     //
@@ -1035,7 +1393,13 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     hm.maybeQueueHistoryCheckpoint();
 
     // step 2
+    recordMemoryUsage(ltx);
     ltx.commit();
+    mCloseTimeline.record(ledgerSeq, LedgerCloseTimeline::Event::COMMIT);
+    if (mTxHistoryWriter && mApp.getConfig().MODE_STORES_HISTORY_MISC)
+    {
+        mTxHistoryWriter->enqueue(ledgerSeq, std::move(txHistoryRows));
+    }
 
     // step 3
     if (protocolVersionStartsFrom(initialLedgerVers,
@@ -1045,12 +1409,17 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
         mApp.getBucketManager().startBackgroundEvictionScan(ledgerSeq + 1);
     }
 
-    // step 4
-    hm.publishQueuedHistory();
-    hm.logAndUpdatePublishStatus();
+    // Steps 4 and 5 wait for a durable commit, as a crash could otherwise
+    // restart from a ledger whose buckets were collected
+    if (!mDeferDurability)
+    {
+        // step 4
+        hm.publishQueuedHistory();
+        hm.logAndUpdatePublishStatus();
 
-    // step 5
-    mApp.getBucketManager().forgetUnreferencedBuckets();
+        // step 5
+        mApp.getBucketManager().forgetUnreferencedBuckets();
+    }
 
     if (!mApp.getConfig().OP_APPLY_SLEEP_TIME_WEIGHT_FOR_TESTING.empty())
     {
@@ -1082,35 +1451,71 @@ LedgerManagerImpl::closeLedger(LedgerCloseData const& ledgerData)
     CLOG_DEBUG(Perf, "Applied ledger in {} seconds", ledgerTimeSeconds.count());
 }
 
-void
+uint64_t
 LedgerManagerImpl::deleteOldEntries(Database& db, uint32_t ledgerSeq,
                                     uint32_t count)
 {
     ZoneScoped;
     soci::transaction txscope(db.getSession());
     db.clearPreparedStatementCache();
-    LedgerHeaderUtils::deleteOldEntries(db, ledgerSeq, count);
-    deleteOldTransactionHistoryEntries(db, ledgerSeq, count);
-    HerderPersistence::deleteOldEntries(db, ledgerSeq, count);
-    Upgrades::deleteOldEntries(db, ledgerSeq, count);
+    auto rows = deleteOldEntries(db.getSession(), ledgerSeq, count);
     db.clearPreparedStatementCache();
     txscope.commit();
+    return rows;
+}
+
+uint64_t
+LedgerManagerImpl::deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                                    uint32_t count)
+{
+    ZoneScoped;
+    uint64_t rows = 0;
+    rows += LedgerHeaderUtils::deleteOldEntries(sess, ledgerSeq, count);
+    rows += deleteOldTransactionHistoryEntries(sess, ledgerSeq, count);
+    rows +=
+        mApp.getHerderPersistence().deleteOldEntries(sess, ledgerSeq, count);
+    rows += Upgrades::deleteOldEntries(sess, ledgerSeq, count);
+    return rows;
+}
+
+TransactionHistoryWriter*
+LedgerManagerImpl::getTxHistoryWriter()
+{
+    if (!mTxHistoryWriter && mApp.getConfig().BACKGROUND_TX_HISTORY_WRITES &&
+        mApp.getDatabase().canUsePool())
+    {
+        mTxHistoryWriter = std::make_unique<TransactionHistoryWriter>(
+            mApp, getLastClosedLedgerNum());
+    }
+    return mTxHistoryWriter.get();
+}
+
+bool
+LedgerManagerImpl::isTransactionHistoryWritten(uint32_t ledgerSeq)
+{
+    return !mTxHistoryWriter || mTxHistoryWriter->isWritten(ledgerSeq);
 }
 
 void
 LedgerManagerImpl::deleteNewerEntries(Database& db, uint32_t ledgerSeq)
 {
     ZoneScoped;
+    if (mTxHistoryWriter)
+    {
+        // Don't let the writer add rows back after they are deleted
+        mTxHistoryWriter->waitUntilWritten();
+    }
     soci::transaction txscope(db.getSession());
     db.clearPreparedStatementCache();
 
     // as we use this method only when we apply buckets, we have to preserve
     // data for everything but ledger header
     LedgerHeaderUtils::deleteNewerEntries(db, ledgerSeq);
+    mRecentLedgerHeaders.eraseFrom(ledgerSeq);
     // for other data we delete data *after*
     ++ledgerSeq;
     deleteNewerTransactionHistoryEntries(db, ledgerSeq);
-    HerderPersistence::deleteNewerEntries(db, ledgerSeq);
+    mApp.getHerderPersistence().deleteNewerEntries(db, ledgerSeq);
     Upgrades::deleteNewerEntries(db, ledgerSeq);
     db.clearPreparedStatementCache();
     txscope.commit();
@@ -1127,6 +1532,13 @@ LedgerManagerImpl::setLastClosedLedger(
     storeCurrentLedger(header.current(), storeInDB);
     ltx.commit();
 
+    // The BucketList was replaced rather than closed, so entries loaded from
+    // the previous one must be loaded again
+    if (auto root = dynamic_cast<LedgerTxnRoot*>(&mApp.getLedgerTxnRoot()))
+    {
+        root->clearInMemoryEntries();
+    }
+
     mRebuildInMemoryState = false;
     advanceLedgerPointers(lastClosed.header);
     LedgerTxn ltx2(mApp.getLedgerTxnRoot(), false,
@@ -1155,7 +1567,7 @@ LedgerManagerImpl::setupLedgerCloseMetaStream()
 {
     ZoneScoped;
 
-    if (mMetaStream)
+    if (mMetaStream || mMetaStreamWriter)
     {
         throw std::runtime_error("LedgerManagerImpl already streaming");
     }
@@ -1181,6 +1593,11 @@ LedgerManagerImpl::setupLedgerCloseMetaStream()
                       cfg.METADATA_OUTPUT_STREAM);
             mMetaStream->open(cfg.METADATA_OUTPUT_STREAM);
         }
+        if (cfg.METADATA_OUTPUT_STREAM_QUEUE > 0)
+        {
+            mMetaStreamWriter = std::make_unique<MetaStreamWriter>(
+                mApp, std::move(mMetaStream));
+        }
     }
 }
 void
@@ -1295,6 +1712,7 @@ LedgerManagerImpl::advanceLedgerPointers(LedgerHeader const& header,
 
     mLastClosedLedger.hash = ledgerHash;
     mLastClosedLedger.header = header;
+    mRecentLedgerHeaders.add(mLastClosedLedger);
 }
 
 void
@@ -1318,6 +1736,7 @@ LedgerManagerImpl::updateNetworkConfig(AbstractLedgerTxn& rootLtx)
         mSorobanNetworkConfig->loadFromLedger(
             rootLtx, mApp.getConfig().CURRENT_LEDGER_PROTOCOL_VERSION,
             ledgerVersion);
+        mSorobanNetworkConfigSnapshot.reset();
         publishSorobanMetrics();
     }
     else
@@ -1344,7 +1763,8 @@ void
 LedgerManagerImpl::processFeesSeqNums(
     std::vector<TransactionFrameBasePtr> const& txs,
     AbstractLedgerTxn& ltxOuter, ApplicableTxSetFrame const& txSet,
-    std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta)
+    std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta,
+    TransactionHistoryRows& txHistoryRows)
 {
     ZoneScoped;
     CLOG_DEBUG(Ledger, "processing fees and sequence numbers");
@@ -1380,7 +1800,11 @@ LedgerManagerImpl::processFeesSeqNums(
                 }
             }
 
-            LedgerEntryChanges changes = ltxTx.getChanges();
+            LedgerEntryChanges changes;
+            if (ledgerCloseMeta || mApp.getConfig().MODE_STORES_HISTORY_MISC)
+            {
+                changes = ltxTx.getChanges();
+            }
             if (ledgerCloseMeta)
             {
                 ledgerCloseMeta->pushTxProcessingEntry();
@@ -1396,8 +1820,7 @@ LedgerManagerImpl::processFeesSeqNums(
             ++index;
             if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
             {
-                storeTransactionFee(mApp.getDatabase(), ledgerSeq, tx, changes,
-                                    index);
+                txHistoryRows.addTransactionFee(tx, changes, index);
             }
             ltxTx.commit();
         }
@@ -1453,7 +1876,7 @@ LedgerManagerImpl::prefetchTxSourceIds(
         {
             tx->insertKeysForFeeProcessing(keys);
         }
-        mApp.getLedgerTxnRoot().prefetch(keys);
+        prefetchForApply(keys);
     }
 }
 
@@ -1469,18 +1892,43 @@ LedgerManagerImpl::prefetchTransactionData(
         {
             tx->insertKeysForTxApply(keys);
         }
-        mApp.getLedgerTxnRoot().prefetch(keys);
+        prefetchForApply(keys);
     }
 }
 
+void
+LedgerManagerImpl::prefetchForApply(UnorderedSet<LedgerKey> const& keys)
+{
+    // Keys that are already cached (for instance by a speculative prefetch
+    // during nomination) are not loaded again
+    auto loaded = mApp.getLedgerTxnRoot().prefetch(keys);
+    mApplyPrefetchLoad.Mark(loaded);
+    mApplyPrefetchCached.Mark(keys.size() -
+                              std::min<size_t>(loaded, keys.size()));
+}
+
+// The PRNG seed of the Soroban transaction at position txNum of the apply
+// order
+static Hash
+sorobanSubSeed(Hash const& sorobanBasePrngSeed, uint64_t txNum)
+{
+    SHA256 subSeedSha;
+    subSeedSha.add(sorobanBasePrngSeed);
+    xdrSha256Add(subSeedSha, txNum);
+    return subSeedSha.finish();
+}
+
 void
 LedgerManagerImpl::applyTransactions(
     ApplicableTxSetFrame const& txSet,
     std::vector<TransactionFrameBasePtr> const& txs, AbstractLedgerTxn& ltx,
     TransactionResultSet& txResultSet,
-    std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta)
+    std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta,
+    TransactionHistoryRows& txHistoryRows)
 {
     ZoneNamedN(txsZone, "applyTransactions", true);
+    auto const applyStart = std::chrono::steady_clock::now();
+    mOperationApplyMetrics.resetLedger();
     int index = 0;
 
     // Record counts
@@ -1498,6 +1946,14 @@ LedgerManagerImpl::applyTransactions(
     }
 
     prefetchTransactionData(txs);
+    auto const ledgerVersion = ltx.loadHeader().current().ledgerVersion;
+    if (protocolVersionStartsFrom(ledgerVersion, SOROBAN_PROTOCOL_VERSION) &&
+        std::any_of(txs.begin(), txs.end(),
+                    [](auto const& tx) { return tx->isSoroban(); }))
+    {
+        TransactionFrame::precomputePreApplySorobanResourceFees(
+            txs, ledgerVersion, getSorobanNetworkConfig(), mApp.getConfig());
+    }
 
     Hash sorobanBasePrngSeed = txSet.getContentsHash();
     uint64_t txNum{0};
@@ -1505,89 +1961,295 @@ LedgerManagerImpl::applyTransactions(
     uint64_t txFailed{0};
     uint64_t sorobanTxSucceeded{0};
     uint64_t sorobanTxFailed{0};
-    for (auto tx : txs)
-    {
-        ZoneNamedN(txZone, "applyTransaction", true);
-        auto txTime = mTransactionApply.TimeScope();
-        TransactionMetaFrame tm(ltx.loadHeader().current().ledgerVersion);
-        CLOG_DEBUG(Tx, " tx#{} = {} ops={} txseq={} (@ {})", index,
-                   hexAbbrev(tx->getContentsHash()), tx->getNumOperations(),
-                   tx->getSeqNum(),
-                   mApp.getConfig().toShortString(tx->getSourceID()));
-
-        Hash subSeed = sorobanBasePrngSeed;
-        // If tx can use the seed, we need to compute a sub-seed for it.
-        if (tx->isSoroban())
-        {
-            SHA256 subSeedSha;
-            subSeedSha.add(sorobanBasePrngSeed);
-            subSeedSha.add(xdr::xdr_to_opaque(txNum));
-            subSeed = subSeedSha.finish();
-        }
-        ++txNum;
-
-        tx->apply(mApp, ltx, tm, subSeed);
-        tx->processPostApply(mApp, ltx, tm);
-        TransactionResultPair results;
-        results.transactionHash = tx->getContentsHash();
-        results.result = tx->getResult();
-        if (results.result.result.code() == TransactionResultCode::txSUCCESS)
+    auto const parallelThreads =
+        mApp.getConfig().EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS;
+    // Without a meta stream or a txhistory table nothing reads the meta, so
+    // its changes aren't even computed
+    bool const metaEnabled =
+        ledgerCloseMeta || mApp.getConfig().MODE_STORES_HISTORY_MISC;
+    try
+    {
+        for (auto tx : txs)
         {
+            ZoneNamedN(txZone, "applyTransaction", true);
+            auto txTime = mTransactionApply.TimeScope();
+            TransactionMetaFrame tm(ltx.loadHeader().current().ledgerVersion,
+                                    metaEnabled);
+            CLOG_DEBUG(Tx, " tx#{} = {} ops={} txseq={} (@ {})", index,
+                       hexAbbrev(tx->getContentsHash()), tx->getNumOperations(),
+                       tx->getSeqNum(),
+                       mApp.getConfig().toShortString(tx->getSourceID()));
+
+            Hash subSeed = sorobanBasePrngSeed;
+            // If tx can use the seed, we need to compute a sub-seed for it.
             if (tx->isSoroban())
             {
-                ++sorobanTxSucceeded;
+                subSeed = sorobanSubSeed(sorobanBasePrngSeed, txNum);
+                if (parallelThreads > 0 && !mParallelSorobanApply)
+                {
+                    // Soroban transactions are applied after all classic ones
+                    std::vector<TransactionFrameBasePtr> sorobanTxs;
+                    std::vector<Hash> seeds;
+                    for (uint64_t i = txNum; i < txs.size(); ++i)
+                    {
+                        if (txs[i]->isSoroban())
+                        {
+                            sorobanTxs.emplace_back(txs[i]);
+                            // The seed the host gets is that of the
+                            // transaction's only operation, see
+                            // TransactionFrame::applyOperations
+                            seeds.emplace_back(sorobanSubSeed(
+                                sorobanSubSeed(sorobanBasePrngSeed, i), 0));
+                        }
+                    }
+                    mParallelSorobanApply =
+                        std::make_unique<ParallelSorobanApply>(
+                            mApp, ltx, sorobanTxs, seeds, parallelThreads);
+                }
             }
-            ++txSucceeded;
-        }
-        else
-        {
-            if (tx->isSoroban())
+            ++txNum;
+
+            tx->apply(mApp, ltx, tm, subSeed);
+            tx->processPostApply(mApp, ltx, tm);
+            TransactionResultPair results;
+            results.transactionHash = tx->getContentsHash();
+            results.result = tx->getResult();
+            if (results.result.result.code() ==
+                TransactionResultCode::txSUCCESS)
             {
-                ++sorobanTxFailed;
+                if (tx->isSoroban())
+                {
+                    ++sorobanTxSucceeded;
+                }
+                ++txSucceeded;
+            }
+            else
+            {
+                if (tx->isSoroban())
+                {
+                    ++sorobanTxFailed;
+                }
+                ++txFailed;
             }
-            ++txFailed;
-        }
 
-        // First gather the TransactionResultPair into the TxResultSet for
-        // hashing into the ledger header.
-        txResultSet.results.emplace_back(results);
+            // First gather the TransactionResultPair into the TxResultSet for
+            // hashing into the ledger header.
+            txResultSet.results.emplace_back(results);
 
-        // Then potentially add that TRP and its associated TransactionMeta
-        // into the associated slot of any LedgerCloseMeta we're collecting.
-        if (ledgerCloseMeta)
-        {
-            ledgerCloseMeta->setTxProcessingMetaAndResultPair(
-                tm.getXDR(), std::move(results), index);
-        }
+            // Then potentially add that TRP and its associated TransactionMeta
+            // into the associated slot of any LedgerCloseMeta we're collecting.
+            if (ledgerCloseMeta)
+            {
+                ledgerCloseMeta->setTxProcessingMetaAndResultPair(
+                    tm.getXDR(), std::move(results), index);
+            }
 
-        // Then finally store the results and meta into the txhistory table.
-        // if we're running in a mode that has one.
-        //
-        // Note to future: when we eliminate the txhistory and txfeehistory
-        // tables, the following step can be removed.
-        //
-        // Also note: for historical reasons the history tables number
-        // txs counting from 1, not 0. We preserve this for the time being
-        // in case anyone depends on it.
-        ++index;
-        if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
-        {
-            auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
-            storeTransaction(mApp.getDatabase(), ledgerSeq, tx, tm.getXDR(),
-                             txResultSet, mApp.getConfig());
+            // Then finally queue the results and meta for the txhistory table,
+            // if we're running in a mode that has one.
+            //
+            // Note to future: when we eliminate the txhistory and txfeehistory
+            // tables, the following step can be removed.
+            //
+            // Also note: for historical reasons the history tables number
+            // txs counting from 1, not 0. We preserve this for the time being
+            // in case anyone depends on it.
+            ++index;
+            if (mApp.getConfig().MODE_STORES_HISTORY_MISC)
+            {
+                txHistoryRows.addTransaction(tx, tm.getXDR(),
+                                             txResultSet.results.back(), index,
+                                             mApp.getConfig());
+            }
         }
     }
+    catch (...)
+    {
+        mParallelSorobanApply.reset();
+        throw;
+    }
+    mParallelSorobanApply.reset();
 
     mTransactionApplySucceeded.inc(txSucceeded);
     mTransactionApplyFailed.inc(txFailed);
     mSorobanTransactionApplySucceeded.inc(sorobanTxSucceeded);
     mSorobanTransactionApplyFailed.inc(sorobanTxFailed);
-    logTxApplyMetrics(ltx, numTxs, numOps);
+    logTxApplyMetrics(ltx, numTxs, numOps,
+                      std::chrono::steady_clock::now() - applyStart);
+}
+
+// Number of entries looked up in the BucketList so far, in bulk or one at a
+// time
+static uint64_t
+countBucketListLoads(medida::MetricsRegistry& metrics)
+{
+    uint64_t res = 0;
+    for (auto const& [name, metric] : metrics.GetAllMetrics())
+    {
+        if (name.domain() != "bucketlistDB")
+        {
+            continue;
+        }
+        if (name.type() == "query" && name.name() == "loads")
+        {
+            res += dynamic_cast<medida::Meter&>(*metric).count();
+        }
+        else if (name.type() == "point")
+        {
+            res += dynamic_cast<medida::Timer&>(*metric).count();
+        }
+    }
+    return res;
+}
+
+TxSetApplyCost
+LedgerManagerImpl::dryRunTxSet(TxSetXDRFrame const& txSet, TimePoint closeTime,
+                               bool withMeta)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    if (txSet.previousLedgerHash() != mLastClosedLedger.hash)
+    {
+        throw std::invalid_argument(
+            "tx set doesn't apply on top of the last closed ledger");
+    }
+    // This builds new frames, so the ones in the transaction queue are left
+    // untouched
+    auto applicableTxSet = txSet.prepareForApply(mApp);
+    if (!applicableTxSet)
+    {
+        throw std::invalid_argument("tx set can't be prepared for apply");
+    }
+
+    TxSetApplyCost cost;
+    auto const txs = applicableTxSet->getTxsInApplyOrder();
+    cost.mTxCount = txs.size();
+    cost.mOpCount = applicableTxSet->sizeOpTotal();
+    for (auto const& tx : txs)
+    {
+        if (tx->isSoroban())
+        {
+            cost.mSorobanResources += tx->getResources(false);
+        }
+    }
+    auto loadsBefore = countBucketListLoads(mApp.getMetrics());
+
+    // Same header changes as closeLedger, except for the upgrades
+    LedgerTxn ltx(mApp.getLedgerTxnRoot());
+    auto header = ltx.loadHeader();
+    ++header.current().ledgerSeq;
+    header.current().previousLedgerHash = mLastClosedLedger.hash;
+    header.current().scpValue.txSetHash = txSet.getContentsHash();
+    header.current().scpValue.closeTime = closeTime;
+    auto const ledgerHeader = header.current();
+    header.deactivate();
+
+    std::unique_ptr<LedgerCloseMetaFrame> ledgerCloseMeta;
+    if (withMeta)
+    {
+        ledgerCloseMeta =
+            std::make_unique<LedgerCloseMetaFrame>(ledgerHeader.ledgerVersion);
+        ledgerCloseMeta->reserveTxProcessing(applicableTxSet->sizeTxTotal());
+        ledgerCloseMeta->populateTxSet(txSet);
+    }
+
+    // The transactions apply in a child of ltx, so that committing their
+    // changes can be timed too
+    LedgerTxn ltxApply(ltx);
+    mOperationApplyMetrics.resetLedger();
+    auto start = std::chrono::steady_clock::now();
+    for (auto const& tx : txs)
+    {
+        auto baseFee = applicableTxSet->getTxBaseFee(tx, ledgerHeader);
+        if (ledgerCloseMeta)
+        {
+            LedgerTxn ltxTx(ltxApply);
+            tx->processFeeSeqNum(ltxTx, baseFee);
+            ledgerCloseMeta->pushTxProcessingEntry();
+            ledgerCloseMeta->setLastTxProcessingFeeProcessingChanges(
+                ltxTx.getChanges());
+            ltxTx.commit();
+        }
+        else
+        {
+            tx->processFeeSeqNum(ltxApply, baseFee);
+        }
+    }
+    auto feesDone = std::chrono::steady_clock::now();
+    cost.mFeeProcessingTime = feesDone - start;
+
+    if (protocolVersionStartsFrom(ledgerHeader.ledgerVersion,
+                                  SOROBAN_PROTOCOL_VERSION) &&
+        !cost.mSorobanResources.isZero())
+    {
+        TransactionFrame::precomputePreApplySorobanResourceFees(
+            txs, ledgerHeader.ledgerVersion, getSorobanNetworkConfig(),
+            mApp.getConfig());
+    }
+    Hash sorobanBasePrngSeed = txSet.getContentsHash();
+    for (uint64_t txNum = 0; txNum < txs.size(); ++txNum)
+    {
+        auto const& tx = txs[txNum];
+        TransactionMetaFrame tm(ledgerHeader.ledgerVersion, withMeta);
+        Hash subSeed = tx->isSoroban()
+                           ? sorobanSubSeed(sorobanBasePrngSeed, txNum)
+                           : sorobanBasePrngSeed;
+        tx->apply(mApp, ltxApply, tm, subSeed);
+        tx->processPostApply(mApp, ltxApply, tm);
+        if (tx->getResult().result.code() == TransactionResultCode::txSUCCESS)
+        {
+            ++cost.mTxSucceeded;
+        }
+        if (ledgerCloseMeta)
+        {
+            TransactionResultPair results;
+            results.transactionHash = tx->getContentsHash();
+            results.result = tx->getResult();
+            ledgerCloseMeta->setTxProcessingMetaAndResultPair(
+                tm.getXDR(), std::move(results), static_cast<int>(txNum));
+        }
+    }
+    mApp.getInvariantManager().finishOperationChecks();
+    auto applyDone = std::chrono::steady_clock::now();
+    cost.mApplyTime = applyDone - feesDone;
+    cost.mOperationBreakdown = mOperationApplyMetrics.getLedgerBreakdown();
+    cost.mEntriesLoaded = countBucketListLoads(mApp.getMetrics()) - loadsBefore;
+
+    ltxApply.commit();
+    auto commitDone = std::chrono::steady_clock::now();
+    cost.mCommitTime = commitDone - applyDone;
+
+    std::vector<LedgerEntry> initEntries;
+    std::vector<LedgerEntry> liveEntries;
+    std::vector<LedgerKey> deadEntries;
+    ltx.getAllEntries(initEntries, liveEntries, deadEntries);
+    cost.mEntriesCreated = initEntries.size();
+    cost.mEntriesUpdated = liveEntries.size();
+    cost.mEntriesDeleted = deadEntries.size();
+
+    // The bucket isn't added to the BucketList; unreferenced, it is garbage
+    // collected like any other
+    auto bucketStart = std::chrono::steady_clock::now();
+    Bucket::fresh(mApp.getBucketManager(), ledgerHeader.ledgerVersion,
+                  initEntries, liveEntries, deadEntries,
+                  /* countMergeEvents */ false, mApp.getClock().getIOContext(),
+                  !mApp.getConfig().DISABLE_XDR_FSYNC);
+    auto bucketDone = std::chrono::steady_clock::now();
+    cost.mBucketBatchTime = bucketDone - bucketStart;
+
+    if (ledgerCloseMeta)
+    {
+        ledgerCloseMeta->ledgerHeader().header = ledgerHeader;
+        cost.mMetaBytes = xdr::xdr_to_opaque(ledgerCloseMeta->getXDR()).size();
+        cost.mMetaTime = std::chrono::steady_clock::now() - bucketDone;
+    }
+    // ltx is rolled back when it goes out of scope
+    return cost;
 }
 
 void
 LedgerManagerImpl::logTxApplyMetrics(AbstractLedgerTxn& ltx, size_t numTxs,
-                                     size_t numOps)
+                                     size_t numOps,
+                                     std::chrono::nanoseconds applyTime)
 {
     auto ledgerSeq = ltx.loadHeader().current().ledgerSeq;
     auto hitRate = mApp.getLedgerTxnRoot().getPrefetchHitRate() * 100;
@@ -1595,6 +2257,17 @@ LedgerManagerImpl::logTxApplyMetrics(AbstractLedgerTxn& ltx, size_t numTxs,
     CLOG_DEBUG(Ledger, "Ledger: {} txs: {}, ops: {}, prefetch hit rate (%): {}",
                ledgerSeq, numTxs, numOps, hitRate);
 
+    auto threshold = mApp.getConfig().SLOW_LEDGER_APPLY_LOG_THRESHOLD_MS;
+    if (threshold > 0 && applyTime >= std::chrono::milliseconds(threshold))
+    {
+        CLOG_WARNING(
+            Ledger, "Ledger: {} took {}ms to apply {} txs, {} ops: {}",
+            ledgerSeq,
+            std::chrono::duration_cast<std::chrono::milliseconds>(applyTime)
+                .count(),
+            numTxs, numOps, mOperationApplyMetrics.getLedgerBreakdown());
+    }
+
     // We lose a bit of precision here, as medida only accepts int64_t
     mPrefetchHitRate.Update(std::llround(hitRate));
     TracyPlot("ledger.prefetch.hit-rate", hitRate);
@@ -1606,11 +2279,6 @@ LedgerManagerImpl::storeCurrentLedger(LedgerHeader const& header,
 {
     ZoneScoped;
 
-    Hash hash = xdrSha256(header);
-    releaseAssert(!isZero(hash));
-    mApp.getPersistentState().setState(PersistentState::kLastClosedLedger,
-                                       binToHex(hash));
-
     BucketList bl;
     if (mApp.getConfig().MODE_ENABLES_BUCKETLIST)
     {
@@ -1621,6 +2289,18 @@ LedgerManagerImpl::storeCurrentLedger(LedgerHeader const& header,
     HistoryArchiveState has(header.ledgerSeq, bl,
                             mApp.getConfig().NETWORK_PASSPHRASE);
 
+    if (mApp.getConfig().MODE_REPLAY_ONLY)
+    {
+        // Nothing restarts from a replay, so don't serialize the HAS and
+        // write it to the database after every ledger
+        mReplayLastClosedHAS = std::move(has);
+        return;
+    }
+
+    Hash hash = xdrSha256(header);
+    releaseAssert(!isZero(hash));
+    mApp.getPersistentState().setState(PersistentState::kLastClosedLedger,
+                                       binToHex(hash));
     mApp.getPersistentState().setState(PersistentState::kHistoryArchiveState,
                                        has.toString());
 
@@ -1673,8 +2353,11 @@ LedgerManagerImpl::transferLedgerEntriesToBucketList(
             ltxEvictions.commit();
         }
 
-        getSorobanNetworkConfigInternal().maybeSnapshotBucketListSize(
-            ledgerSeq, ltx, mApp);
+        if (getSorobanNetworkConfigInternal().maybeSnapshotBucketListSize(
+                ledgerSeq, ltx, mApp))
+        {
+            mSorobanNetworkConfigSnapshot.reset();
+        }
     }
 
     ltx.getAllEntries(initEntries, liveEntries, deadEntries);
@@ -1682,6 +2365,8 @@ LedgerManagerImpl::transferLedgerEntriesToBucketList(
     {
         mApp.getBucketManager().addBatch(mApp, ledgerSeq, currLedgerVers,
                                          initEntries, liveEntries, deadEntries);
+        mCloseTimeline.record(ledgerSeq,
+                              LedgerCloseTimeline::Event::BUCKET_ADD_BATCH);
     }
 }
 
@@ -7,13 +7,20 @@
 
 #include "history/HistoryManager.h"
 #include "ledger/LedgerCloseMetaFrame.h"
+#include "ledger/LedgerCloseTimeline.h"
 #include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
 #include "ledger/NetworkConfig.h"
+#include "ledger/OperationApplyMetrics.h"
+#include "ledger/RecentLedgerHeaders.h"
+#include "ledger/SorobanContractUsage.h"
 #include "ledger/SorobanMetrics.h"
 #include "main/PersistentState.h"
+#include "transactions/ParallelSorobanApply.h"
 #include "transactions/TransactionFrame.h"
 #include "util/XDRStream.h"
 #include "xdr/Stellar-ledger.h"
+#include <atomic>
 #include <filesystem>
 #include <string>
 
@@ -38,25 +45,44 @@ class Application;
 class Database;
 class LedgerTxnHeader;
 class BasicWork;
+class TransactionHistoryRows;
+class TransactionHistoryWriter;
+class MetaStreamWriter;
 
 class LedgerManagerImpl : public LedgerManager
 {
   protected:
     Application& mApp;
     std::unique_ptr<XDROutputFileStream> mMetaStream;
+    // Owns the meta stream instead of mMetaStream when
+    // METADATA_OUTPUT_STREAM_QUEUE is set
+    std::unique_ptr<MetaStreamWriter> mMetaStreamWriter;
     std::unique_ptr<XDROutputFileStream> mMetaDebugStream;
     std::weak_ptr<BasicWork> mFlushAndRotateMetaDebugWork;
     std::filesystem::path mMetaDebugPath;
 
   private:
     LedgerHeaderHistoryEntry mLastClosedLedger;
+    // With MODE_REPLAY_ONLY, the HAS of the last closed ledger, kept here
+    // rather than in the database
+    std::optional<HistoryArchiveState> mReplayLastClosedHAS;
     std::optional<SorobanNetworkConfig> mSorobanNetworkConfig;
+    // Copy of mSorobanNetworkConfig, made when first asked for after the
+    // config changes
+    std::shared_ptr<SorobanNetworkConfig const> mSorobanNetworkConfigSnapshot;
 
     SorobanMetrics mSorobanMetrics;
+    OperationApplyMetrics mOperationApplyMetrics;
+    LedgerCloseTimeline mCloseTimeline;
+    RecentLedgerHeaders mRecentLedgerHeaders;
+    SorobanContractUsage mSorobanContractUsage;
     medida::Timer& mTransactionApply;
     medida::Histogram& mTransactionCount;
     medida::Histogram& mOperationCount;
     medida::Histogram& mPrefetchHitRate;
+    medida::Meter& mSpeculativePrefetchLoad;
+    medida::Meter& mApplyPrefetchCached;
+    medida::Meter& mApplyPrefetchLoad;
     medida::Timer& mLedgerClose;
     medida::Buckets& mLedgerAgeClosed;
     medida::Counter& mLedgerAge;
@@ -66,24 +92,59 @@ class LedgerManagerImpl : public LedgerManager
     medida::Counter& mSorobanTransactionApplyFailed;
     medida::Meter& mMetaStreamBytes;
     medida::Timer& mMetaStreamWriteTime;
+    // Memory used by the LedgerTxn of the last ledger closed, indexed by
+    // LedgerEntryType, and by the LedgerTxnRoot caches
+    std::vector<medida::Counter*> mLedgerTxnEntryBytes;
+    medida::Counter& mLedgerTxnInternalBytes;
+    medida::Counter& mEntryCacheBytes;
+    medida::Counter& mBestOffersBytes;
+    medida::Counter& mSorobanStateBytes;
+    medida::Counter& mLiquidityPoolsBytes;
+    LedgerTxnMemoryUsage mLastLedgerMemoryUsage;
+    std::unique_ptr<ParallelSorobanApply> mParallelSorobanApply;
     VirtualClock::time_point mLastClose;
     bool mRebuildInMemoryState{false};
+    // See setDeferDurability
+    bool mDeferDurability{false};
 
     std::unique_ptr<VirtualClock::time_point> mStartCatchup;
     medida::Timer& mCatchupDuration;
 
     std::unique_ptr<LedgerCloseMetaFrame> mNextMetaToEmit;
 
+    // Only present with BACKGROUND_TX_HISTORY_WRITES, from the first ledger
+    // closed
+    std::unique_ptr<TransactionHistoryWriter> mTxHistoryWriter;
+    TransactionHistoryWriter* getTxHistoryWriter();
+
+    // Ledger sequence of the latest preparation started by
+    // startPreparingLedger, and of the ledger being (or last) closed, which
+    // preparations of earlier ledgers check to abandon their work
+    uint32_t mPreparingLedgerSeq{0};
+    std::shared_ptr<std::atomic<uint32_t>> mClosingLedgerSeq{
+        std::make_shared<std::atomic<uint32_t>>(0)};
+
+    // Incremented whenever the running speculative prefetch is superseded or
+    // cancelled, which its remaining batches check before running
+    uint64_t mSpeculativePrefetchGeneration{0};
+    std::optional<Hash> mSpeculativePrefetchTxSet;
+    void speculativePrefetchStep(uint64_t generation,
+                                 std::shared_ptr<std::vector<LedgerKey>> keys,
+                                 size_t next);
+    void prefetchForApply(UnorderedSet<LedgerKey> const& keys);
+
     void processFeesSeqNums(
         std::vector<TransactionFrameBasePtr> const& txs,
         AbstractLedgerTxn& ltxOuter, ApplicableTxSetFrame const& txSet,
-        std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta);
+        std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta,
+        TransactionHistoryRows& txHistoryRows);
 
     void applyTransactions(
         ApplicableTxSetFrame const& txSet,
         std::vector<TransactionFrameBasePtr> const& txs, AbstractLedgerTxn& ltx,
         TransactionResultSet& txResultSet,
-        std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta);
+        std::unique_ptr<LedgerCloseMetaFrame> const& ledgerCloseMeta,
+        TransactionHistoryRows& txHistoryRows);
 
     // initialLedgerVers must be the ledger version at the start of the ledger.
     // On the ledger in which a protocol upgrade from vN to vN + 1 occurs,
@@ -94,6 +155,7 @@ class LedgerManagerImpl : public LedgerManager
                  uint32_t initialLedgerVers);
 
     void storeCurrentLedger(LedgerHeader const& header, bool storeHeader);
+    void recordMemoryUsage(AbstractLedgerTxn const& ltx);
     void
     prefetchTransactionData(std::vector<TransactionFrameBasePtr> const& txs);
     void prefetchTxSourceIds(std::vector<TransactionFrameBasePtr> const& txs);
@@ -102,6 +164,7 @@ class LedgerManagerImpl : public LedgerManager
     State mState;
     void setState(State s);
 
+    bool isStreamingMeta() const;
     void emitNextMeta();
 
     SorobanNetworkConfig& getSorobanNetworkConfigInternal();
@@ -125,10 +188,13 @@ class LedgerManagerImpl : public LedgerManager
     void advanceLedgerPointers(LedgerHeader const& header,
                                bool debugLog = true);
     void logTxApplyMetrics(AbstractLedgerTxn& ltx, size_t numTxs,
-                           size_t numOps);
+                           size_t numOps,
+                           std::chrono::nanoseconds applyTime);
 
   public:
     LedgerManagerImpl(Application& app);
+    ~LedgerManagerImpl() override;
+    void shutdown() override;
 
     // Reloads the network configuration from the ledger.
     // This needs to be called every time a ledger is closed.
@@ -149,6 +215,8 @@ class LedgerManagerImpl : public LedgerManager
     uint32_t getLastTxFee() const override;
     uint32_t getLastClosedLedgerNum() const override;
     SorobanNetworkConfig const& getSorobanNetworkConfig() override;
+    std::shared_ptr<SorobanNetworkConfig const>
+    getSorobanNetworkConfigSnapshot() override;
     bool hasSorobanNetworkConfig() const override;
 
 #ifdef BUILD_TESTS
@@ -157,6 +225,8 @@ class LedgerManagerImpl : public LedgerManager
 
     uint64_t secondsSinceLastLedgerClose() const override;
     void syncMetrics() override;
+    LedgerTxnMemoryUsage const& getLastLedgerMemoryUsage() const override;
+    ParallelSorobanApply* getParallelSorobanApply() const override;
 
     void startNewLedger(LedgerHeader const& genesisLedger);
     void startNewLedger() override;
@@ -177,19 +247,34 @@ class LedgerManagerImpl : public LedgerManager
                  std::set<std::shared_ptr<Bucket>> bucketsToRetain) override;
 
     void closeLedger(LedgerCloseData const& ledgerData) override;
-    void deleteOldEntries(Database& db, uint32_t ledgerSeq,
-                          uint32_t count) override;
+    void setDeferDurability(bool defer) override;
+    void startPreparingLedger(LedgerCloseData const& ledgerData) override;
+    void startSpeculativePrefetch(ApplicableTxSetFrame const& txSet) override;
+    void cancelSpeculativePrefetch() override;
+    uint64_t deleteOldEntries(Database& db, uint32_t ledgerSeq,
+                              uint32_t count) override;
+    uint64_t deleteOldEntries(soci::session& sess, uint32_t ledgerSeq,
+                              uint32_t count) override;
 
     void deleteNewerEntries(Database& db, uint32_t ledgerSeq) override;
 
+    bool isTransactionHistoryWritten(uint32_t ledgerSeq) override;
+
     void setLastClosedLedger(LedgerHeaderHistoryEntry const& lastClosed,
                              bool storeInDB) override;
 
     void manuallyAdvanceLedgerHeader(LedgerHeader const& header) override;
 
+    TxSetApplyCost dryRunTxSet(TxSetXDRFrame const& txSet,
+                               TimePoint closeTime, bool withMeta) override;
+
     void setupLedgerCloseMetaStream();
     void maybeResetLedgerCloseMetaDebugStream(uint32_t ledgerSeq);
 
     SorobanMetrics& getSorobanMetrics() override;
+    OperationApplyMetrics& getOperationApplyMetrics() override;
+    LedgerCloseTimeline& getCloseTimeline() override;
+    SorobanContractUsage& getSorobanContractUsage() override;
+    RecentLedgerHeaders const& getRecentLedgerHeaders() const override;
 };
 }
@@ -17,14 +17,19 @@
 #include "ledger/LedgerTypeUtils.h"
 #include "ledger/NonSociRelatedException.h"
 #include "main/Application.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/XDROperators.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
+#include <algorithm>
+#include <future>
+#include <typeinfo>
 #include <soci.h>
 
 namespace stellar
@@ -312,6 +317,8 @@ LedgerTxn::Impl::Impl(LedgerTxn& self, AbstractLedgerTxnParent& parent,
     : mParent(parent)
     , mChild(nullptr)
     , mHeader(std::make_unique<LedgerHeader>(mParent.getHeader()))
+    , mArena(getArenaForParent(parent))
+    , mEntry(0, EntryMap::allocator_type(mArena))
     , mShouldUpdateLastModified(shouldUpdateLastModified)
     , mIsSealed(false)
     , mConsistency(LedgerTxnConsistency::EXACT)
@@ -319,6 +326,27 @@ LedgerTxn::Impl::Impl(LedgerTxn& self, AbstractLedgerTxnParent& parent,
     mParent.addChild(self, mode);
 }
 
+std::shared_ptr<Arena>
+LedgerTxn::Impl::getArenaForParent(AbstractLedgerTxnParent& parent)
+{
+    if (auto ltx = dynamic_cast<LedgerTxn*>(&parent))
+    {
+        return ltx->getImpl()->mArena;
+    }
+    if (dynamic_cast<LedgerTxnRoot*>(&parent))
+    {
+        return std::make_shared<Arena>();
+    }
+    return nullptr;
+}
+
+std::shared_ptr<InternalLedgerEntry>
+LedgerTxn::Impl::makeEntry(InternalLedgerEntry const& entry) const
+{
+    return std::allocate_shared<InternalLedgerEntry>(
+        ArenaAllocator<InternalLedgerEntry>(mArena), entry);
+}
+
 LedgerTxn::~LedgerTxn()
 {
     if (mImpl)
@@ -423,12 +451,42 @@ void
 LedgerTxn::Impl::commit() noexcept
 {
     maybeUpdateLastModifiedThenInvokeThenSeal([&](EntryMap const& entries) {
-        // getEntryIterator has the strong exception safety guarantee
-        // commitChild has the strong exception safety guarantee
-        mParent.commitChild(getEntryIterator(entries), mConsistency);
+        // A sealed LedgerTxn has already cleared its order book, so only an
+        // unsealed one can hand its maps over
+        auto parent = mIsSealed ? nullptr : getMergeableParent();
+        if (parent)
+        {
+            parent->commitChild(*this, mConsistency);
+        }
+        else
+        {
+            // getEntryIterator has the strong exception safety guarantee
+            // commitChild has the strong exception safety guarantee
+            mParent.commitChild(getEntryIterator(entries), mConsistency);
+        }
     });
 }
 
+LedgerTxn::Impl*
+LedgerTxn::Impl::getMergeableParent() const
+{
+    // Subclasses such as InMemoryLedgerTxn override commitChild, so they must
+    // be committed to through the EntryIterator
+    auto ltx = dynamic_cast<LedgerTxn*>(&mParent);
+    if (!ltx || typeid(*ltx) != typeid(LedgerTxn))
+    {
+        return nullptr;
+    }
+
+    // Nodes can only move between maps with equal allocators
+    auto parent = ltx->getImpl().get();
+    if (parent->mEntry.get_allocator() != mEntry.get_allocator())
+    {
+        return nullptr;
+    }
+    return parent;
+}
+
 void
 LedgerTxn::commitChild(EntryIterator iter, LedgerTxnConsistency cons) noexcept
 {
@@ -452,6 +510,77 @@ joinConsistencyLevels(LedgerTxnConsistency c1, LedgerTxnConsistency c2)
 void
 LedgerTxn::Impl::commitChild(EntryIterator iter,
                              LedgerTxnConsistency cons) noexcept
+{
+    commitChildWith(
+        [&]() {
+            for (; (bool)iter; ++iter)
+            {
+                updateEntry(iter.key(), /* keyHint */ nullptr,
+                            iter.entryPtr(), /* effectiveActive */ false);
+            }
+        },
+        cons);
+}
+
+void
+LedgerTxn::Impl::commitChild(Impl& child, LedgerTxnConsistency cons) noexcept
+{
+    commitChildWith(
+        [&]() {
+            // Moves the nodes of every key that is not recorded here, leaving
+            // the others in child.mEntry. Those are merged exactly as
+            // updateEntry would for an EntryIterator.
+            mEntry.merge(child.mEntry);
+            for (auto& kv : child.mEntry)
+            {
+                updateEntry(kv.first, /* keyHint */ nullptr, kv.second,
+                            /* effectiveActive */ false);
+            }
+
+            // The child's order book holds exactly its live offers that are
+            // not active. Those moved above have no order book entry here yet,
+            // and those merged by updateEntry already have the same one, so
+            // merging the order books is exact once the child's active offers
+            // are added back.
+            if (mMultiOrderBook.empty())
+            {
+                mMultiOrderBook.swap(child.mMultiOrderBook);
+            }
+            else
+            {
+                for (auto& buying : child.mMultiOrderBook)
+                {
+                    auto& mobBuying = mMultiOrderBook[buying.first];
+                    for (auto& selling : buying.second)
+                    {
+                        mobBuying[selling.first].merge(selling.second);
+                    }
+                }
+            }
+            for (auto const& kv : child.mActive)
+            {
+                auto const& key = kv.first;
+                if (key.type() != InternalLedgerEntryType::LEDGER_ENTRY ||
+                    key.ledgerKey().type() != OFFER)
+                {
+                    continue;
+                }
+                auto iter = mEntry.find(key);
+                if (iter != mEntry.end() && !iter->second.isDeleted())
+                {
+                    auto const& oe = iter->second->ledgerEntry().data.offer();
+                    mMultiOrderBook[oe.buying][oe.selling].emplace(
+                        OfferDescriptor{oe.price, oe.offerID},
+                        key.ledgerKey());
+                }
+            }
+        },
+        cons);
+}
+
+void
+LedgerTxn::Impl::commitChildWith(std::function<void()> mergeEntries,
+                                 LedgerTxnConsistency cons) noexcept
 {
     // Assignment of xdrpp objects does not have the strong exception safety
     // guarantee, so use std::unique_ptr<...>::swap to achieve it
@@ -466,11 +595,7 @@ LedgerTxn::Impl::commitChild(EntryIterator iter,
     }
     try
     {
-        for (; (bool)iter; ++iter)
-        {
-            updateEntry(iter.key(), /* keyHint */ nullptr, iter.entryPtr(),
-                        /* effectiveActive */ false);
-        }
+        mergeEntries();
 
         // We will show that the following update procedure leaves the self
         // worst best offer map in a correct state.
@@ -579,7 +704,7 @@ LedgerTxn::Impl::create(LedgerTxn& self, InternalLedgerEntry const& entry)
         throw std::runtime_error("Key already exists");
     }
 
-    auto current = std::make_shared<InternalLedgerEntry>(entry);
+    auto current = makeEntry(entry);
     auto impl = LedgerTxnEntry::makeSharedImpl(self, *current);
 
     // Set the key to active before constructing the LedgerTxnEntry, as this
@@ -623,10 +748,9 @@ LedgerTxn::Impl::createWithoutLoading(InternalLedgerEntry const& entry)
     // after this INIT entry is merged with the DELETED will be a LIVE. This is
     // because the entry would have been a LIVE before the delete. If it were an
     // INIT instead, the key would've been annihilated.
-    updateEntry(
-        key, /* keyHint */ nullptr,
-        LedgerEntryPtr::Init(std::make_shared<InternalLedgerEntry>(entry)),
-        /* effectiveActive */ false);
+    updateEntry(key, /* keyHint */ nullptr,
+                LedgerEntryPtr::Init(makeEntry(entry)),
+                /* effectiveActive */ false);
 }
 
 void
@@ -648,10 +772,9 @@ LedgerTxn::Impl::updateWithoutLoading(InternalLedgerEntry const& entry)
         throw std::runtime_error("Key is already active");
     }
 
-    updateEntry(
-        key, /* keyHint */ nullptr,
-        LedgerEntryPtr::Live(std::make_shared<InternalLedgerEntry>(entry)),
-        /* effectiveActive */ false);
+    updateEntry(key, /* keyHint */ nullptr,
+                LedgerEntryPtr::Live(makeEntry(entry)),
+                /* effectiveActive */ false);
 }
 
 void
@@ -1580,8 +1703,7 @@ LedgerTxn::Impl::load(LedgerTxn& self, InternalLedgerKey const& key)
     }
     else
     {
-        currentEntryPtr = LedgerEntryPtr::Live(
-            std::make_shared<InternalLedgerEntry>(*newest.first));
+        currentEntryPtr = LedgerEntryPtr::Live(makeEntry(*newest.first));
     }
 
     releaseAssert(currentEntryPtr.has_value());
@@ -2037,6 +2159,20 @@ LedgerTxn::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
     return mParent.prefetch(keys);
 }
 
+uint32_t
+LedgerTxn::prefetchLoaded(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    return getImpl()->prefetchLoaded(entries);
+}
+
+uint32_t
+LedgerTxn::Impl::prefetchLoaded(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    return mParent.prefetchLoaded(entries);
+}
+
 void
 LedgerTxn::Impl::maybeUpdateLastModified() noexcept
 {
@@ -2302,6 +2438,57 @@ LedgerTxn::prepareNewObjects(size_t s)
     getImpl()->prepareNewObjects(s);
 }
 
+uint64_t
+LedgerTxnMemoryUsage::total() const
+{
+    uint64_t res = internalEntryBytes + entryCacheBytes + bestOffersBytes +
+                   contractCodeAndTTLBytes + liquidityPoolsBytes;
+    for (auto const& kv : entryBytes)
+    {
+        res += kv.second;
+    }
+    return res;
+}
+
+LedgerTxnMemoryUsage
+LedgerTxn::getMemoryUsage() const
+{
+    return getImpl()->getMemoryUsage();
+}
+
+LedgerTxnMemoryUsage
+LedgerTxn::Impl::getMemoryUsage() const
+{
+    // A node of mEntry also holds the next pointer and the cached hash
+    size_t const nodeBytes =
+        sizeof(EntryMap::value_type) + sizeof(void*) + sizeof(size_t);
+
+    LedgerTxnMemoryUsage usage;
+    for (auto const& [key, lePtr] : mEntry)
+    {
+        uint64_t bytes = nodeBytes;
+        auto const entry = lePtr.get();
+        if (entry)
+        {
+            bytes += sizeof(InternalLedgerEntry);
+        }
+        if (key.type() == InternalLedgerEntryType::LEDGER_ENTRY)
+        {
+            bytes += xdr::xdr_size(key.ledgerKey());
+            if (entry)
+            {
+                bytes += xdr::xdr_size(entry->ledgerEntry());
+            }
+            usage.entryBytes[key.ledgerKey().type()] += bytes;
+        }
+        else
+        {
+            usage.internalEntryBytes += bytes;
+        }
+    }
+    return usage;
+}
+
 void
 LedgerTxn::Impl::prepareNewObjects(size_t s)
 {
@@ -2428,13 +2615,35 @@ LedgerTxnRoot::Impl::Impl(Application& app, size_t entryCacheSize,
                    getMaxOffersToCross()))
     , mApp(app)
     , mHeader(std::make_unique<LedgerHeader>())
-    , mEntryCache(entryCacheSize)
+    , mEntryCache(entryCacheSize,
+                  app.getConfig().ENTRY_CACHE_SIZE_MB * 1000000ull)
+    , mInMemoryOrderBook(app.getConfig().IN_MEMORY_ORDER_BOOK)
+    , mCacheSoftLimitBytes(
+          app.getConfig().LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB * 1000000ull)
+    , mCacheShrinks(app.getMetrics().NewMeter(
+          {"ledger", "memory", "cache-shrink"}, "shrink"))
     , mBulkLoadBatchSize(prefetchBatchSize)
     , mChild(nullptr)
 #ifdef BEST_OFFER_DEBUGGING
     , mBestOfferDebuggingEnabled(bestOfferDebuggingEnabled)
 #endif
 {
+    for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
+    {
+        std::string name = xdr::xdr_traits<LedgerEntryType>::enum_name(
+            static_cast<LedgerEntryType>(let));
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        mEntryCacheHits.emplace_back(&mApp.getMetrics().NewMeter(
+            {"ledger", "entry-cache-hit", name}, "entry"));
+        mEntryCacheMisses.emplace_back(&mApp.getMetrics().NewMeter(
+            {"ledger", "entry-cache-miss", name}, "entry"));
+    }
+
+    bool const bucketListDB = app.getConfig().isUsingBucketListDB();
+    mContractCodeAndTTL.mEnabled =
+        bucketListDB && app.getConfig().IN_MEMORY_CONTRACT_CODE_AND_TTL;
+    mLiquidityPools.mEnabled =
+        bucketListDB && app.getConfig().IN_MEMORY_LIQUIDITY_POOLS;
 }
 
 LedgerTxnRoot::~LedgerTxnRoot()
@@ -2453,7 +2662,8 @@ LedgerTxnRoot::Impl::~Impl()
 void
 LedgerTxnRoot::Impl::resetForFuzzer()
 {
-    mBestOffers.clear();
+    clearBestOffers();
+    clearInMemoryEntries();
     mEntryCache.clear();
 }
 
@@ -2582,6 +2792,13 @@ BulkLedgerEntryChangeAccumulator::accumulate(EntryIterator const& iter,
     return true;
 }
 
+bool
+LedgerTxnRoot::Impl::useCopyUpsert(LedgerEntryType t) const
+{
+    auto const& types = mApp.getConfig().POSTGRES_COPY_UPSERT_ENTRY_TYPES;
+    return std::find(types.begin(), types.end(), t) != types.end();
+}
+
 void
 LedgerTxnRoot::Impl::bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
                                size_t bufferThreshold,
@@ -2727,11 +2944,41 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter,
 
     auto bucketListDBEnabled = mApp.getConfig().isUsingBucketListDB();
     auto bleca = BulkLedgerEntryChangeAccumulator();
+    bool const updateBook = mInMemoryOrderBook && mOrderBookLoaded;
+    std::vector<std::pair<int64_t, std::optional<LedgerEntry>>> offerChanges;
+    std::vector<
+        std::pair<LedgerKey, std::shared_ptr<InternalLedgerEntry const>>>
+        inMemoryChanges;
     [[maybe_unused]] int64_t counter{0};
     try
     {
         while ((bool)iter)
         {
+            if (updateBook &&
+                iter.key().type() == InternalLedgerEntryType::LEDGER_ENTRY &&
+                iter.key().ledgerKey().type() == OFFER)
+            {
+                auto offerID = iter.key().ledgerKey().offer().offerID;
+                if (iter.entryExists())
+                {
+                    offerChanges.emplace_back(offerID,
+                                              iter.entry().ledgerEntry());
+                }
+                else
+                {
+                    offerChanges.emplace_back(offerID, std::nullopt);
+                }
+            }
+            if (iter.key().type() == InternalLedgerEntryType::LEDGER_ENTRY &&
+                isInMemoryEntryLoaded(iter.key().ledgerKey().type()))
+            {
+                inMemoryChanges.emplace_back(
+                    iter.key().ledgerKey(),
+                    iter.entryExists()
+                        ? std::make_shared<InternalLedgerEntry const>(
+                              iter.entry())
+                        : nullptr);
+            }
             if (bleca.accumulate(iter, bucketListDBEnabled))
             {
                 ++counter;
@@ -2765,8 +3012,36 @@ LedgerTxnRoot::Impl::commitChild(EntryIterator iter,
             "unknown fatal error during commit to LedgerTxnRoot");
     }
 
-    // Clearing the cache does not throw
-    mBestOffers.clear();
+    if (updateBook)
+    {
+        try
+        {
+            updateOrderBook(offerChanges);
+        }
+        catch (...)
+        {
+            // The database is already committed, so the order book can
+            // always be rebuilt from it on the next query.
+            clearBestOffers();
+        }
+    }
+    else
+    {
+        // Clearing the cache does not throw
+        clearBestOffers();
+    }
+    try
+    {
+        for (auto& [key, entry] : inMemoryChanges)
+        {
+            getInMemoryEntries(key.type())->set(key, std::move(entry));
+        }
+    }
+    catch (...)
+    {
+        // They are reloaded from the BucketList once that has the ledger
+        clearInMemoryEntries();
+    }
     mEntryCache.clear();
 
     // std::unique_ptr<...>::reset does not throw
@@ -2866,7 +3141,8 @@ LedgerTxnRoot::Impl::deleteObjectsModifiedOnOrAfterLedger(uint32_t ledger) const
     using namespace soci;
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
+    clearInMemoryEntries();
 
     for (auto let : xdr::xdr_traits<LedgerEntryType>::enum_values())
     {
@@ -2943,6 +3219,113 @@ LedgerTxnRoot::prefetch(UnorderedSet<LedgerKey> const& keys)
     return mImpl->prefetch(keys);
 }
 
+uint32_t
+LedgerTxnRoot::prefetchLoaded(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    return mImpl->prefetchLoaded(entries);
+}
+
+uint32_t
+LedgerTxnRoot::Impl::prefetchLoaded(
+    UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const& entries)
+{
+    ZoneScoped;
+    uint32_t total = 0;
+    for (auto const& [key, entry] : entries)
+    {
+        // Entries held in memory are never looked up in the cache
+        if (isInMemoryEntryLoaded(key.type()) || mEntryCache.exists(key, false))
+        {
+            continue;
+        }
+        putInEntryCache(key, entry, LoadType::PREFETCH);
+        ++total;
+    }
+    return total;
+}
+
+std::vector<LedgerEntry>
+LedgerTxnRoot::Impl::loadKeysInParallel(LedgerKeySet const& keys) const
+{
+    ZoneScoped;
+
+    // Split the keys into contiguous ranges of at least mBulkLoadBatchSize
+    // keys, one per thread. The calling thread loads the first range through
+    // the main snapshot (which records metrics), and each worker uses a
+    // snapshot of its own, since snapshots are not thread-safe.
+    size_t const batch = std::max<size_t>(mBulkLoadBatchSize, 1);
+    size_t const shards = std::min<size_t>(
+        mApp.getConfig().PREFETCH_WORKER_THREADS + 1,
+        (keys.size() + batch - 1) / batch);
+    if (shards <= 1)
+    {
+        return getSearchableBucketListSnapshot().loadKeys(keys);
+    }
+
+    auto& snapshotManager = mApp.getBucketManager().getBucketSnapshotManager();
+    while (mPrefetchSnapshots.size() < shards - 1)
+    {
+        mPrefetchSnapshots.emplace_back(
+            snapshotManager.getSearchableBucketListSnapshot());
+    }
+
+    std::vector<LedgerKeySet> shardKeys(shards);
+    size_t const perShard = (keys.size() + shards - 1) / shards;
+    size_t i = 0;
+    for (auto const& k : keys)
+    {
+        auto& dst = shardKeys.at(i++ / perShard);
+        dst.emplace_hint(dst.end(), k);
+    }
+
+    std::vector<std::future<std::vector<LedgerEntry>>> futures;
+    futures.reserve(shards - 1);
+    for (size_t shard = 1; shard < shards; ++shard)
+    {
+        futures.emplace_back(std::async(
+            std::launch::async,
+            [snapshot = mPrefetchSnapshots.at(shard - 1),
+             &shardKeys = shardKeys.at(shard)]() {
+                return snapshot->loadKeys(shardKeys);
+            }));
+    }
+
+    // Make sure all workers are done with shardKeys before returning, even
+    // if loading the first shard throws.
+    std::vector<LedgerEntry> result;
+    std::exception_ptr error;
+    try
+    {
+        result = getSearchableBucketListSnapshot().loadKeys(shardKeys.at(0));
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+    for (auto& f : futures)
+    {
+        try
+        {
+            auto entries = f.get();
+            std::move(entries.begin(), entries.end(),
+                      std::back_inserter(result));
+        }
+        catch (...)
+        {
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    return result;
+}
+
 uint32_t
 LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
 {
@@ -2971,10 +3354,14 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
         LedgerKeySet keysToSearch;
         for (auto const& key : keys)
         {
-            insertIfNotLoaded(keysToSearch, key);
+            // Entries held in memory need no prefetching
+            if (!isInMemoryEntryLoaded(key.type()))
+            {
+                insertIfNotLoaded(keysToSearch, key);
+            }
         }
 
-        auto blLoad = getSearchableBucketListSnapshot().loadKeys(keysToSearch);
+        auto blLoad = loadKeysInParallel(keysToSearch);
         cacheResult(populateLoadedEntries(keysToSearch, blLoad));
     }
     else
@@ -3089,6 +3476,7 @@ LedgerTxnRoot::Impl::prefetch(UnorderedSet<LedgerKey> const& keys)
         cacheResult(bulkLoadTTL(ttl));
     }
 
+    maybeShrinkCaches();
     return total;
 }
 
@@ -3109,6 +3497,23 @@ LedgerTxnRoot::Impl::getPrefetchHitRate() const
            (mPrefetchMisses + mPrefetchHits);
 }
 
+std::vector<LedgerKey>
+LedgerTxnRoot::getCachedKeys(size_t maxKeys) const
+{
+    return mImpl->getCachedKeys(maxKeys);
+}
+
+std::vector<LedgerKey>
+LedgerTxnRoot::Impl::getCachedKeys(size_t maxKeys) const
+{
+    std::vector<LedgerKey> keys;
+    for (auto const& key : mEntryCache.recentKeys(maxKeys))
+    {
+        keys.emplace_back(key.ledgerKey());
+    }
+    return keys;
+}
+
 void
 LedgerTxnRoot::prepareNewObjects(size_t s)
 {
@@ -3119,6 +3524,23 @@ void LedgerTxnRoot::Impl::prepareNewObjects(size_t)
 {
 }
 
+LedgerTxnMemoryUsage
+LedgerTxnRoot::getMemoryUsage() const
+{
+    return mImpl->getMemoryUsage();
+}
+
+LedgerTxnMemoryUsage
+LedgerTxnRoot::Impl::getMemoryUsage() const
+{
+    LedgerTxnMemoryUsage usage;
+    usage.entryCacheBytes = mEntryCache.approximateBytes();
+    usage.bestOffersBytes = getBestOffersBytes();
+    usage.contractCodeAndTTLBytes = mContractCodeAndTTL.mBytes;
+    usage.liquidityPoolsBytes = mLiquidityPools.mBytes;
+    return usage;
+}
+
 UnorderedMap<LedgerKey, LedgerEntry>
 LedgerTxnRoot::getAllOffers()
 {
@@ -3607,16 +4029,36 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
     }
     auto const& key = gkey.ledgerKey();
 
-    if (mEntryCache.exists(key))
+    if (auto inMemory = getInMemoryEntries(key.type()))
+    {
+        try
+        {
+            if (inMemory->mLoaded || loadInMemoryEntries(*inMemory))
+            {
+                auto it = inMemory->mEntries.find(key);
+                return it == inMemory->mEntries.end() ? nullptr : it->second;
+            }
+        }
+        catch (...)
+        {
+            inMemory->clear();
+            throw;
+        }
+    }
+
+    // Cache lookups use gkey, whose hash is computed at most once
+    if (mEntryCache.exists(gkey))
     {
         std::string zoneTxt("hit");
         ZoneText(zoneTxt.c_str(), zoneTxt.size());
-        return getFromEntryCache(key);
+        mEntryCacheHits.at(key.type())->Mark();
+        return getFromEntryCache(gkey);
     }
     else
     {
         std::string zoneTxt("miss");
         ZoneText(zoneTxt.c_str(), zoneTxt.size());
+        mEntryCacheMisses.at(key.type())->Mark();
         ++mPrefetchMisses;
     }
 
@@ -3682,7 +4124,7 @@ LedgerTxnRoot::Impl::getNewestVersion(InternalLedgerKey const& gkey) const
                            "LedgerTxnRoot");
     }
 
-    putInEntryCache(key, entry, LoadType::IMMEDIATE);
+    putInEntryCache(gkey, entry, LoadType::IMMEDIATE);
     if (entry)
     {
         return std::make_shared<InternalLedgerEntry const>(*entry);
@@ -3727,8 +4169,96 @@ LedgerTxnRoot::Impl::rollbackChild() noexcept
     mPrefetchMisses = 0;
 }
 
+size_t
+LedgerTxnRoot::Impl::CacheEntryWeigher::operator()(CacheEntry const& e) const
+{
+    // The key is not visible here, but it is at most as large as the entry
+    size_t entrySize = e.entry ? xdr::xdr_size(*e.entry) : 0;
+    return sizeof(InternalLedgerKey) + sizeof(CacheEntry) +
+           sizeof(LedgerEntry) + 2 * entrySize;
+}
+
+LedgerTxnRoot::Impl::EntryCache::EntryCache(size_t maxEntries, size_t maxBytes)
+{
+    if (maxBytes > 0)
+    {
+        mTinyLFU = std::make_unique<
+            TinyLFUCache<InternalLedgerKey, CacheEntry, CacheEntryWeigher>>(
+            maxBytes, maxEntries);
+    }
+    else
+    {
+        mRandom = std::make_unique<
+            RandomEvictionCache<InternalLedgerKey, CacheEntry>>(maxEntries);
+    }
+}
+
+void
+LedgerTxnRoot::Impl::EntryCache::put(InternalLedgerKey const& k,
+                                     CacheEntry const& v)
+{
+    if (mTinyLFU)
+    {
+        mTinyLFU->put(k, v);
+    }
+    else
+    {
+        mRandom->put(k, v);
+        mRandomPutBytes += CacheEntryWeigher()(v);
+        ++mRandomPuts;
+    }
+}
+
+bool
+LedgerTxnRoot::Impl::EntryCache::exists(InternalLedgerKey const& k,
+                                        bool countMisses)
+{
+    return mTinyLFU ? mTinyLFU->exists(k, countMisses)
+                    : mRandom->exists(k, countMisses);
+}
+
+LedgerTxnRoot::Impl::CacheEntry&
+LedgerTxnRoot::Impl::EntryCache::get(InternalLedgerKey const& k)
+{
+    return mTinyLFU ? mTinyLFU->get(k) : mRandom->get(k);
+}
+
+void
+LedgerTxnRoot::Impl::EntryCache::clear()
+{
+    if (mTinyLFU)
+    {
+        mTinyLFU->clear();
+    }
+    else
+    {
+        mRandom->clear();
+    }
+}
+
+std::vector<InternalLedgerKey>
+LedgerTxnRoot::Impl::EntryCache::recentKeys(size_t maxKeys) const
+{
+    return mTinyLFU ? mTinyLFU->recentKeys(maxKeys)
+                    : mRandom->recentKeys(maxKeys);
+}
+
+uint64_t
+LedgerTxnRoot::Impl::EntryCache::approximateBytes() const
+{
+    if (mTinyLFU)
+    {
+        return mTinyLFU->weight();
+    }
+    if (mRandomPuts == 0)
+    {
+        return 0;
+    }
+    return mRandom->size() * (mRandomPutBytes / mRandomPuts);
+}
+
 std::shared_ptr<InternalLedgerEntry const>
-LedgerTxnRoot::Impl::getFromEntryCache(LedgerKey const& key) const
+LedgerTxnRoot::Impl::getFromEntryCache(InternalLedgerKey const& key) const
 {
     try
     {
@@ -3756,8 +4286,8 @@ LedgerTxnRoot::Impl::getFromEntryCache(LedgerKey const& key) const
 
 void
 LedgerTxnRoot::Impl::putInEntryCache(
-    LedgerKey const& key, std::shared_ptr<LedgerEntry const> const& entry,
-    LoadType type) const
+    InternalLedgerKey const& key,
+    std::shared_ptr<LedgerEntry const> const& entry, LoadType type) const
 {
     try
     {
@@ -3776,6 +4306,11 @@ LedgerTxnRoot::Impl::getFromBestOffers(Asset const& buying,
 {
     try
     {
+        if (mInMemoryOrderBook && !mOrderBookLoaded)
+        {
+            loadOrderBook();
+        }
+
         BestOffersKey offersKey{buying, selling};
         auto it = mBestOffers.find(offersKey);
 
@@ -3784,15 +4319,305 @@ LedgerTxnRoot::Impl::getFromBestOffers(Asset const& buying,
             return it->second;
         }
 
-        auto emptyPtr =
-            std::make_shared<BestOffersEntry>(BestOffersEntry{{}, false});
+        // A loaded order book contains every asset pair that has offers, so
+        // any other pair is known to be empty
+        auto emptyPtr = std::make_shared<BestOffersEntry>(
+            BestOffersEntry{{}, mOrderBookLoaded});
         mBestOffers.emplace(offersKey, emptyPtr);
         return emptyPtr;
     }
     catch (...)
     {
-        mBestOffers.clear();
+        clearBestOffers();
         throw;
     }
 }
+
+void
+LedgerTxnRoot::Impl::clearBestOffers() const
+{
+    mBestOffers.clear();
+    mOfferLocations.clear();
+    mOrderBookLoaded = false;
+}
+
+uint64_t
+LedgerTxnRoot::Impl::getBestOffersBytes() const
+{
+    // Offers have no variable-length fields apart from their (empty)
+    // extensions, so sizeof(LedgerEntry) is a close estimate of their size
+    uint64_t bytes =
+        mOfferLocations.size() *
+        (sizeof(decltype(mOfferLocations)::value_type) + 2 * sizeof(void*));
+    for (auto const& kv : mBestOffers)
+    {
+        bytes += sizeof(BestOffers::value_type) + 2 * sizeof(void*);
+        if (kv.second)
+        {
+            bytes += sizeof(BestOffersEntry) +
+                     kv.second->bestOffers.size() * sizeof(LedgerEntry);
+        }
+    }
+    return bytes;
+}
+
+void
+LedgerTxnRoot::Impl::maybeShrinkCaches() const
+{
+    if (mCacheSoftLimitBytes != 0)
+    {
+        shrinkCaches(mCacheSoftLimitBytes);
+    }
+}
+
+void
+LedgerTxnRoot::shrinkCaches(uint64_t maxBytes) const
+{
+    mImpl->shrinkCaches(maxBytes);
+}
+
+void
+LedgerTxnRoot::Impl::shrinkCaches(uint64_t maxBytes) const
+{
+    uint64_t const cacheBytes = mEntryCache.approximateBytes();
+    uint64_t const bestOffersBytes = getBestOffersBytes();
+    if (cacheBytes + bestOffersBytes <= maxBytes)
+    {
+        return;
+    }
+
+    CLOG_INFO(Ledger,
+              "Ledger caches hold about {} bytes of entries and {} bytes of "
+              "best offers, over the limit of {} bytes; shrinking",
+              cacheBytes, bestOffersBytes, maxBytes);
+    mCacheShrinks.Mark();
+    mEntryCache.clear();
+    if (bestOffersBytes > maxBytes && !mInMemoryOrderBook)
+    {
+        clearBestOffers();
+    }
+}
+
+void
+LedgerTxnRoot::Impl::loadOrderBook() const
+{
+    ZoneScoped;
+    releaseAssert(mInMemoryOrderBook);
+    clearBestOffers();
+
+    for (auto& offer : loadAllOffers())
+    {
+        auto const& oe = offer.data.offer();
+        AssetPair assets{oe.buying, oe.selling};
+        mOfferLocations.emplace(oe.offerID,
+                                OfferLocation{assets, {oe.price, oe.offerID}});
+        auto& entry = mBestOffers[assets];
+        if (!entry)
+        {
+            entry =
+                std::make_shared<BestOffersEntry>(BestOffersEntry{{}, true});
+        }
+        entry->bestOffers.emplace_back(std::move(offer));
+    }
+
+    for (auto& kv : mBestOffers)
+    {
+        auto& offers = kv.second->bestOffers;
+        std::sort(offers.begin(), offers.end(),
+                  [](LedgerEntry const& lhs, LedgerEntry const& rhs) {
+                      return isBetterOffer(lhs, rhs);
+                  });
+    }
+
+    mOrderBookLoaded = true;
+    CLOG_INFO(Ledger, "Loaded {} offers in {} asset pairs into order book",
+              mOfferLocations.size(), mBestOffers.size());
+}
+
+void
+LedgerTxnRoot::Impl::updateOrderBook(
+    std::vector<std::pair<int64_t, std::optional<LedgerEntry>>> const&
+        offerChanges)
+{
+    ZoneScoped;
+    releaseAssert(mOrderBookLoaded);
+
+    // Offers in each list are ordered by isBetterOffer, so the first offer
+    // that is not better than an existing descriptor is the offer itself.
+    auto position = [](std::deque<LedgerEntry>& offers,
+                       OfferDescriptor const& desc) {
+        return std::partition_point(
+            offers.begin(), offers.end(), [&](LedgerEntry const& le) {
+                auto const& oe = le.data.offer();
+                return isBetterOffer(OfferDescriptor{oe.price, oe.offerID},
+                                     desc);
+            });
+    };
+
+    for (auto const& change : offerChanges)
+    {
+        auto locIter = mOfferLocations.find(change.first);
+        if (locIter != mOfferLocations.end())
+        {
+            auto const& loc = locIter->second;
+            auto entryIter = mBestOffers.find(loc.assets);
+            if (entryIter == mBestOffers.end())
+            {
+                throw std::runtime_error("order book missing asset pair");
+            }
+            auto& offers = entryIter->second->bestOffers;
+            auto offerIter = position(offers, loc.descriptor);
+            if (offerIter == offers.end() ||
+                offerIter->data.offer().offerID != change.first)
+            {
+                throw std::runtime_error("order book missing offer");
+            }
+            offers.erase(offerIter);
+            mOfferLocations.erase(locIter);
+        }
+
+        if (change.second)
+        {
+            auto const& oe = change.second->data.offer();
+            AssetPair assets{oe.buying, oe.selling};
+            OfferDescriptor desc{oe.price, oe.offerID};
+            auto& entry = mBestOffers[assets];
+            if (!entry)
+            {
+                entry = std::make_shared<BestOffersEntry>(
+                    BestOffersEntry{{}, true});
+            }
+            entry->bestOffers.insert(position(entry->bestOffers, desc),
+                                     *change.second);
+            mOfferLocations.emplace(oe.offerID, OfferLocation{assets, desc});
+        }
+    }
+}
+
+void
+LedgerTxnRoot::clearInMemoryEntries()
+{
+    mImpl->clearInMemoryEntries();
+}
+
+void
+LedgerTxnRoot::Impl::clearInMemoryEntries() const
+{
+    mContractCodeAndTTL.clear();
+    mLiquidityPools.clear();
+}
+
+LedgerTxnRoot::Impl::InMemoryEntries*
+LedgerTxnRoot::Impl::getInMemoryEntries(LedgerEntryType type) const
+{
+    InMemoryEntries* res = nullptr;
+    switch (type)
+    {
+    case CONTRACT_CODE:
+    case TTL:
+        res = &mContractCodeAndTTL;
+        break;
+    case LIQUIDITY_POOL:
+        res = &mLiquidityPools;
+        break;
+    default:
+        break;
+    }
+    return res && res->mEnabled ? res : nullptr;
+}
+
+bool
+LedgerTxnRoot::Impl::isInMemoryEntryLoaded(LedgerEntryType type) const
+{
+    auto inMemory = getInMemoryEntries(type);
+    return inMemory && inMemory->mLoaded;
+}
+
+bool
+LedgerTxnRoot::Impl::loadInMemoryEntries(InMemoryEntries& inMemory) const
+{
+    ZoneScoped;
+    releaseAssert(inMemory.mEnabled);
+    inMemory.clear();
+
+    // The entries would otherwise miss or undo the changes of ledgers not
+    // yet added to the BucketList
+    auto& snapshot = getSearchableBucketListSnapshot();
+    auto const ledgerSeq = mHeader->ledgerSeq;
+    bool const pools = &inMemory == &mLiquidityPools;
+    auto entries = pools ? snapshot.loadLiquidityPools(ledgerSeq)
+                         : snapshot.loadContractCodeAndTTL(ledgerSeq);
+    if (!entries)
+    {
+        return false;
+    }
+
+    inMemory.load(*entries);
+    CLOG_INFO(Ledger,
+              "Loaded {} {} entries ({} bytes) into memory at ledger {}",
+              inMemory.mEntries.size(),
+              pools ? "liquidity pool" : "contract code and TTL",
+              inMemory.mBytes, ledgerSeq);
+    return true;
+}
+
+void
+LedgerTxnRoot::Impl::InMemoryEntries::clear()
+{
+    mEntries.clear();
+    mBytes = 0;
+    mLoaded = false;
+}
+
+uint64_t
+LedgerTxnRoot::Impl::InMemoryEntries::entryBytes(
+    LedgerKey const& key, InternalLedgerEntry const& entry)
+{
+    // A node holds the key, the next pointer and the cached hash, and points
+    // to the entry with its control block
+    return sizeof(decltype(mEntries)::value_type) + 2 * sizeof(void*) +
+           xdr::xdr_size(key) + sizeof(InternalLedgerEntry) +
+           2 * sizeof(void*) + xdr::xdr_size(entry.ledgerEntry());
+}
+
+void
+LedgerTxnRoot::Impl::InMemoryEntries::load(std::vector<LedgerEntry>& entries)
+{
+    clear();
+    mEntries.reserve(entries.size());
+    for (auto& le : entries)
+    {
+        auto key = LedgerEntryKey(le);
+        auto entry = std::make_shared<InternalLedgerEntry const>(std::move(le));
+        mBytes += entryBytes(key, *entry);
+        mEntries.emplace(std::move(key), std::move(entry));
+    }
+    mLoaded = true;
+}
+
+void
+LedgerTxnRoot::Impl::InMemoryEntries::set(
+    LedgerKey const& key, std::shared_ptr<InternalLedgerEntry const> entry)
+{
+    releaseAssert(mLoaded);
+    auto it = mEntries.find(key);
+    if (it != mEntries.end())
+    {
+        mBytes -= entryBytes(it->first, *it->second);
+        if (entry)
+        {
+            mBytes += entryBytes(it->first, *entry);
+            it->second = std::move(entry);
+        }
+        else
+        {
+            mEntries.erase(it);
+        }
+    }
+    else if (entry)
+    {
+        mBytes += entryBytes(key, *entry);
+        mEntries.emplace(key, std::move(entry));
+    }
+}
 }
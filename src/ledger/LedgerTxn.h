@@ -332,6 +332,26 @@ struct LedgerTxnDelta
     HeaderDelta header;
 };
 
+// LedgerTxnMemoryUsage is the approximate number of bytes held in memory by
+// a single AbstractLedgerTxnParent, not counting its parent or child. It is
+// an estimate based on the XDR size of the data, not an exact measurement.
+struct LedgerTxnMemoryUsage
+{
+    // Entries recorded in a LedgerTxn (including erased ones) and their keys,
+    // by type. Internal entries such as sponsorships are counted together.
+    std::map<LedgerEntryType, uint64_t> entryBytes;
+    uint64_t internalEntryBytes{0};
+
+    // The caches of LedgerTxnRoot
+    uint64_t entryCacheBytes{0};
+    uint64_t bestOffersBytes{0};
+    // The in-memory entries of LedgerTxnRoot
+    uint64_t contractCodeAndTTLBytes{0};
+    uint64_t liquidityPoolsBytes{0};
+
+    uint64_t total() const;
+};
+
 // An abstraction for an object that is iterator-like and permits enumerating
 // the LedgerTxnEntry objects managed by an AbstractLedgerTxn. This enables
 // an AbstractLedgerTxnParent to iterate over the entries managed by its child
@@ -502,9 +522,22 @@ class AbstractLedgerTxnParent
     // than a (real or stub) root LedgerTxn.
     virtual uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) = 0;
 
+    // Like prefetch, for entries already loaded from the BucketList of the
+    // last closed ledger, nullptr standing for those that don't exist. Keys
+    // already cached keep their entry. Will throw when called on anything
+    // other than a (real or stub) root LedgerTxn.
+    virtual uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries) = 0;
+
     // prepares to increase the capacity of pending changes by up to "s" changes
     virtual void prepareNewObjects(size_t s) = 0;
 
+    // Return the approximate memory held by this AbstractLedgerTxnParent
+    // itself: the entries recorded in a LedgerTxn, or the caches of a
+    // LedgerTxnRoot. Takes time linear in the number of recorded entries.
+    virtual LedgerTxnMemoryUsage getMemoryUsage() const = 0;
+
 #ifdef BUILD_TESTS
     virtual void resetForFuzzer() = 0;
 #endif // BUILD_TESTS
@@ -801,7 +834,11 @@ class LedgerTxn : public AbstractLedgerTxn
 
     double getPrefetchHitRate() const override;
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+    uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries) override;
     void prepareNewObjects(size_t s) override;
+    LedgerTxnMemoryUsage getMemoryUsage() const override;
 
     bool hasSponsorshipEntry() const override;
 
@@ -893,10 +930,31 @@ class LedgerTxnRoot : public AbstractLedgerTxnParent
     void rollbackChild() noexcept override;
 
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys) override;
+    uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries) override;
     double getPrefetchHitRate() const override;
 
+    // Keys of at most `maxKeys` of the entries of the entry cache, those
+    // most likely to be used again first. Prefetching them warms the cache
+    // of another LedgerTxnRoot up, such as after a restart.
+    std::vector<LedgerKey> getCachedKeys(size_t maxKeys) const;
+
+    // Empties the entry cache and then, unless the in-memory order book is
+    // used, the best offers cache, while they hold more than `maxBytes`.
+    // Does not throw.
+    void shrinkCaches(uint64_t maxBytes) const;
+
+    // Drops the in-memory contract code, TTL and liquidity pool entries, if
+    // loaded, so that they are loaded again from the BucketList by the next
+    // lookup. Must be called when the BucketList is replaced rather than
+    // closed, such as when applying buckets. Does not throw.
+    void clearInMemoryEntries();
+
     void prepareNewObjects(size_t s) override;
 
+    LedgerTxnMemoryUsage getMemoryUsage() const override;
+
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const override;
 
@@ -7,6 +7,7 @@
 #include "crypto/SignerKey.h"
 #include "database/Database.h"
 #include "database/DatabaseTypeSpecificOperation.h"
+#include "database/PostgresCopy.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
@@ -14,9 +15,9 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -149,11 +150,13 @@ class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
     std::vector<std::string> mExtensions;
     std::vector<soci::indicator> mExtensionInds;
     std::vector<std::string> mLedgerExtensions;
+    bool const mUseCopy;
 
   public:
     BulkUpsertAccountsOperation(Database& DB,
-                                std::vector<EntryIterator> const& entries)
-        : mDB(DB)
+                                std::vector<EntryIterator> const& entries,
+                                bool useCopy)
+        : mDB(DB), mUseCopy(useCopy)
     {
         mAccountIDs.reserve(entries.size());
         mBalances.reserve(entries.size());
@@ -283,9 +286,37 @@ class BulkUpsertAccountsOperation : public DatabaseTypeSpecificOperation<void>
     }
 
 #ifdef USE_POSTGRES
+    void
+    doPostgresCopyOperation(PGconn* conn)
+    {
+        PostgresCopyUpsert upsert("accounts", {"accountid"});
+        upsert.addColumn("accountid", mAccountIDs);
+        upsert.addColumn("balance", mBalances);
+        upsert.addColumn("seqnum", mSeqNums);
+        upsert.addColumn("numsubentries", mSubEntryNums);
+        upsert.addColumn("inflationdest", mInflationDests, &mInflationDestInds);
+        upsert.addColumn("homedomain", mHomeDomains);
+        upsert.addColumn("thresholds", mThresholds);
+        upsert.addColumn("signers", mSigners, &mSignerInds);
+        upsert.addColumn("flags", mFlags);
+        upsert.addColumn("lastmodified", mLastModifieds);
+        upsert.addColumn("extension", mExtensions, &mExtensionInds);
+        upsert.addColumn("ledgerext", mLedgerExtensions);
+        if (upsert.execute(mDB, conn, "account") != mAccountIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
+        if (mUseCopy)
+        {
+            doPostgresCopyOperation(pg->conn_);
+            return;
+        }
+
         std::string strAccountIDs, strBalances, strSeqNums, strSubEntryNums,
             strInflationDests, strFlags, strHomeDomains, strThresholds,
             strSigners, strLastModifieds, strExtensions, strLedgerExtensions;
@@ -445,7 +476,8 @@ LedgerTxnRoot::Impl::bulkUpsertAccounts(
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertAccountsOperation op(mApp.getDatabase(), entries);
+    BulkUpsertAccountsOperation op(mApp.getDatabase(), entries,
+                                   useCopyUpsert(ACCOUNT));
     mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
 }
 
@@ -464,7 +496,7 @@ LedgerTxnRoot::Impl::dropAccounts(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS accounts;";
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS signers;";
@@ -356,7 +356,7 @@ LedgerTxnRoot::Impl::dropClaimableBalances(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS claimablebalance;";
 
@@ -277,7 +277,7 @@ LedgerTxnRoot::Impl::dropConfigSettings(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS configsettings;";
 
@@ -360,7 +360,7 @@ LedgerTxnRoot::Impl::dropContractCode(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     std::string coll = mApp.getDatabase().getSimpleCollationClause();
 
@@ -430,7 +430,7 @@ LedgerTxnRoot::Impl::dropContractData(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS contractdata;";
 
@@ -12,8 +12,8 @@
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -322,7 +322,7 @@ LedgerTxnRoot::Impl::dropData(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS accountdata;";
 
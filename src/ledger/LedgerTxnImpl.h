@@ -7,7 +7,9 @@
 #include "bucket/BucketList.h"
 #include "database/Database.h"
 #include "ledger/LedgerTxn.h"
+#include "util/Arena.h"
 #include "util/RandomEvictionCache.h"
+#include "util/TinyLFUCache.h"
 #include <list>
 #include <optional>
 #ifdef USE_POSTGRES
@@ -17,6 +19,11 @@
 #include <sstream>
 #endif
 
+namespace medida
+{
+class Meter;
+}
+
 namespace stellar
 {
 
@@ -207,12 +214,23 @@ class LedgerTxn::Impl
 {
     class EntryIteratorImpl;
 
-    typedef UnorderedMap<InternalLedgerKey, LedgerEntryPtr> EntryMap;
+    typedef std::unordered_map<
+        InternalLedgerKey, LedgerEntryPtr, RandHasher<InternalLedgerKey>,
+        std::equal_to<InternalLedgerKey>,
+        ArenaAllocator<std::pair<InternalLedgerKey const, LedgerEntryPtr>>>
+        EntryMap;
 
     AbstractLedgerTxnParent& mParent;
     AbstractLedgerTxn* mChild;
     std::unique_ptr<LedgerHeader> mHeader;
     std::shared_ptr<LedgerTxnHeader::Impl> mActiveHeader;
+    // Entries and the nodes of mEntry are allocated from an arena shared by
+    // a LedgerTxn stack whose bottom is a LedgerTxnRoot, so the allocations
+    // made while closing a ledger are released together once everything
+    // referencing them is gone. Null (meaning the global heap) for other
+    // parents, such as the long-lived InMemoryLedgerTxn, where a monotonic
+    // arena would grow without bound.
+    std::shared_ptr<Arena> const mArena;
     EntryMap mEntry;
     UnorderedMap<InternalLedgerKey, std::shared_ptr<EntryImplBase>> mActive;
     bool const mShouldUpdateLastModified;
@@ -415,6 +433,18 @@ class LedgerTxn::Impl
     // getEntryIterator has the strong exception safety guarantee
     EntryIterator getEntryIterator(EntryMap const& entries) const;
 
+    static std::shared_ptr<Arena>
+    getArenaForParent(AbstractLedgerTxnParent& parent);
+
+    // makeEntry has the strong exception safety guarantee
+    std::shared_ptr<InternalLedgerEntry>
+    makeEntry(InternalLedgerEntry const& entry) const;
+
+    // getMergeableParent returns the implementation of the parent if it is a
+    // plain LedgerTxn whose entry map can take over the nodes of mEntry on
+    // commit, and nullptr otherwise
+    Impl* getMergeableParent() const;
+
     void maybeUpdateLastModified() noexcept;
 
     // f should not throw
@@ -422,6 +452,11 @@ class LedgerTxn::Impl
     void maybeUpdateLastModifiedThenInvokeThenSeal(
         std::function<void(EntryMap const&)> f) noexcept;
 
+    // Shared by both commitChild overloads. An exception thrown by
+    // mergeEntries is fatal.
+    void commitChildWith(std::function<void()> mergeEntries,
+                         LedgerTxnConsistency cons) noexcept;
+
     // findOrderBook has the strong exception safety guarantee
     // returns: the orderbook that the offer le would be in (if found)
     OrderBook* findOrderBook(Asset const& buying, Asset const& selling);
@@ -457,6 +492,13 @@ class LedgerTxn::Impl
 
     void commitChild(EntryIterator iter, LedgerTxnConsistency cons) noexcept;
 
+    // Commits a LedgerTxn child that has not been sealed by moving the nodes
+    // of its entry map and order book into this one, so committing does not
+    // copy or reallocate the keys the child recorded. Only entries that are
+    // also recorded here are merged one by one. child is left empty apart
+    // from those entries and must be sealed and destroyed afterwards.
+    void commitChild(Impl& child, LedgerTxnConsistency cons) noexcept;
+
     // create has the basic exception safety guarantee. If it throws an
     // exception, then
     // - the prepared statement cache may be, but is not guaranteed to be,
@@ -634,11 +676,17 @@ class LedgerTxn::Impl
     void unsealHeader(LedgerTxn& self, std::function<void(LedgerHeader&)> f);
 
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys);
+    uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries);
 
     double getPrefetchHitRate() const;
 
     void prepareNewObjects(size_t s);
 
+    // getMemoryUsage has the strong exception safety guarantee
+    LedgerTxnMemoryUsage getMemoryUsage() const;
+
     // hasSponsorshipEntry has the strong exception safety guarantee
     bool hasSponsorshipEntry() const;
 
@@ -712,7 +760,53 @@ class LedgerTxnRoot::Impl
         LoadType type;
     };
 
-    typedef RandomEvictionCache<LedgerKey, CacheEntry> EntryCache;
+    // Approximate memory held by a cached entry
+    struct CacheEntryWeigher
+    {
+        size_t operator()(CacheEntry const& e) const;
+    };
+
+    // The entry cache evicts either randomly once it holds ENTRY_CACHE_SIZE
+    // entries or, if ENTRY_CACHE_SIZE_MB is set, with the scan-resistant
+    // W-TinyLFU policy once the entries it holds exceed that many bytes.
+    //
+    // It is keyed by InternalLedgerKey (always of type LEDGER_ENTRY) rather
+    // than LedgerKey because InternalLedgerKey computes its hash only once:
+    // a key handed down from a LedgerTxn has usually been hashed already,
+    // and is then looked up, inserted and (for W-TinyLFU) counted in the
+    // frequency sketch without hashing its XDR again.
+    class EntryCache
+    {
+        std::unique_ptr<RandomEvictionCache<InternalLedgerKey, CacheEntry>>
+            mRandom;
+        std::unique_ptr<
+            TinyLFUCache<InternalLedgerKey, CacheEntry, CacheEntryWeigher>>
+            mTinyLFU;
+
+      public:
+        EntryCache(size_t maxEntries, size_t maxBytes);
+
+        // These methods have the same exception safety guarantees as the
+        // corresponding RandomEvictionCache methods
+        void put(InternalLedgerKey const& k, CacheEntry const& v);
+        bool exists(InternalLedgerKey const& k, bool countMisses = true);
+        CacheEntry& get(InternalLedgerKey const& k);
+        void clear();
+
+        // Approximate bytes held by the cached entries, as computed by
+        // CacheEntryWeigher. The random eviction cache does not report what
+        // it evicts, so its size is extrapolated from the average weight of
+        // the entries put into it.
+        uint64_t approximateBytes() const;
+
+        // Keys of at most `maxKeys` of the entries most likely to be used
+        // again, as the eviction policy sees it
+        std::vector<InternalLedgerKey> recentKeys(size_t maxKeys) const;
+
+      private:
+        uint64_t mRandomPutBytes{0};
+        uint64_t mRandomPuts{0};
+    };
 
     typedef AssetPair BestOffersKey;
 
@@ -732,11 +826,68 @@ class LedgerTxnRoot::Impl
     Application& mApp;
     std::unique_ptr<LedgerHeader> mHeader;
     mutable EntryCache mEntryCache;
+    // Entry cache hits and misses, indexed by LedgerEntryType
+    std::vector<medida::Meter*> mEntryCacheHits;
+    std::vector<medida::Meter*> mEntryCacheMisses;
     mutable BestOffers mBestOffers;
+
+    // When mInMemoryOrderBook is set, mBestOffers holds every offer once
+    // mOrderBookLoaded is true (with allLoaded set for every asset pair) and
+    // is updated in place by commitChild rather than cleared. mOfferLocations
+    // maps each offer to its position in mBestOffers so that updates and
+    // deletions can find the previous version.
+    struct OfferLocation
+    {
+        AssetPair assets;
+        OfferDescriptor descriptor;
+    };
+    bool const mInMemoryOrderBook;
+    mutable bool mOrderBookLoaded{false};
+    mutable UnorderedMap<int64_t, OfferLocation> mOfferLocations;
+
+    // When enabled, every entry of the ledger of some types, loaded from the
+    // BucketList by the first lookup of one of them made once the BucketList
+    // snapshot is that of the ledger of mHeader. It is then updated in place
+    // by commitChild rather than cleared, and lookups of these types are
+    // answered from it alone, a missing key being an entry that doesn't
+    // exist.
+    struct InMemoryEntries
+    {
+        bool mEnabled{false};
+        bool mLoaded{false};
+        UnorderedMap<LedgerKey, std::shared_ptr<InternalLedgerEntry const>>
+            mEntries;
+        uint64_t mBytes{0};
+
+        // Does not throw
+        void clear();
+        // Replaces all the entries, moving from `entries`
+        void load(std::vector<LedgerEntry>& entries);
+        // Sets the entry of `key`, or erases it if `entry` is null
+        void set(LedgerKey const& key,
+                 std::shared_ptr<InternalLedgerEntry const> entry);
+        // Approximate bytes held by an entry
+        static uint64_t entryBytes(LedgerKey const& key,
+                                   InternalLedgerEntry const& entry);
+    };
+    // CONTRACT_CODE and TTL entries, with IN_MEMORY_CONTRACT_CODE_AND_TTL
+    mutable InMemoryEntries mContractCodeAndTTL;
+    // LIQUIDITY_POOL entries, with IN_MEMORY_LIQUIDITY_POOLS
+    mutable InMemoryEntries mLiquidityPools;
     mutable uint64_t mPrefetchHits{0};
     mutable uint64_t mPrefetchMisses{0};
+
+    // Once mEntryCache and mBestOffers together hold more than
+    // LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB (if set), maybeShrinkCaches empties
+    // them. Unlike the entries recorded by the LedgerTxns being applied,
+    // they can be dropped at any time and reloaded if needed.
+    uint64_t const mCacheSoftLimitBytes;
+    medida::Meter& mCacheShrinks;
     mutable std::shared_ptr<SearchableBucketListSnapshot>
         mSearchableBucketListSnapshot{};
+    // Snapshots used by prefetch worker threads, one per worker
+    mutable std::vector<std::shared_ptr<SearchableBucketListSnapshot>>
+        mPrefetchSnapshots{};
 
     size_t mBulkLoadBatchSize;
     std::unique_ptr<soci::transaction> mTransaction;
@@ -786,6 +937,9 @@ class LedgerTxnRoot::Impl
 
     void bulkApply(BulkLedgerEntryChangeAccumulator& bleca,
                    size_t bufferThreshold, LedgerTxnConsistency cons);
+    // Whether upserts of entries of type t use PostgresCopyUpsert, as set by
+    // POSTGRES_COPY_UPSERT_ENTRY_TYPES
+    bool useCopyUpsert(LedgerEntryType t) const;
     void bulkUpsertAccounts(std::vector<EntryIterator> const& entries);
     void bulkDeleteAccounts(std::vector<EntryIterator> const& entries,
                             LedgerTxnConsistency cons);
@@ -831,14 +985,39 @@ class LedgerTxnRoot::Impl
     //    database for the keyset that it has entries for. It's a precise
     //    image of a subset of the database.
     std::shared_ptr<InternalLedgerEntry const>
-    getFromEntryCache(LedgerKey const& key) const;
-    void putInEntryCache(LedgerKey const& key,
+    getFromEntryCache(InternalLedgerKey const& key) const;
+    void putInEntryCache(InternalLedgerKey const& key,
                          std::shared_ptr<LedgerEntry const> const& entry,
                          LoadType type) const;
 
     BestOffersEntryPtr getFromBestOffers(Asset const& buying,
                                          Asset const& selling) const;
 
+    // Does not throw
+    void clearBestOffers() const;
+
+    uint64_t getBestOffersBytes() const;
+
+    // Does not throw. Shrinks the caches to mCacheSoftLimitBytes, if set.
+    void maybeShrinkCaches() const;
+
+    // loadOrderBook and updateOrderBook have the basic exception safety
+    // guarantee. If they throw, the caller must call clearBestOffers.
+    void loadOrderBook() const;
+    void updateOrderBook(
+        std::vector<std::pair<int64_t, std::optional<LedgerEntry>>> const&
+            offerChanges);
+
+    // The in-memory entries holding entries of `type`, if enabled, or null
+    InMemoryEntries* getInMemoryEntries(LedgerEntryType type) const;
+    bool isInMemoryEntryLoaded(LedgerEntryType type) const;
+
+    // Returns false, and leaves `inMemory` unloaded, if the BucketList
+    // snapshot is not yet that of the ledger of mHeader. Has the basic
+    // exception safety guarantee. If it throws, the caller must clear
+    // `inMemory`.
+    bool loadInMemoryEntries(InMemoryEntries& inMemory) const;
+
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
     bulkLoadAccounts(UnorderedSet<LedgerKey> const& keys) const;
     UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>>
@@ -871,6 +1050,10 @@ class LedgerTxnRoot::Impl
 
     SearchableBucketListSnapshot& getSearchableBucketListSnapshot() const;
 
+    // Loads keys from the BucketList, split across up to
+    // PREFETCH_WORKER_THREADS additional threads
+    std::vector<LedgerEntry> loadKeysInParallel(LedgerKeySet const& keys) const;
+
   public:
     // Constructor has the strong exception safety guarantee
     Impl(Application& app, size_t entryCacheSize, size_t prefetchBatchSize
@@ -969,11 +1152,25 @@ class LedgerTxnRoot::Impl
     // could occur if the cache is at its fill ratio. Returns number of keys
     // prefetched.
     uint32_t prefetch(UnorderedSet<LedgerKey> const& keys);
+    uint32_t prefetchLoaded(
+        UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> const&
+            entries);
 
     double getPrefetchHitRate() const;
 
+    // See LedgerTxnRoot::getCachedKeys
+    std::vector<LedgerKey> getCachedKeys(size_t maxKeys) const;
+
+    // See LedgerTxnRoot::shrinkCaches
+    void shrinkCaches(uint64_t maxBytes) const;
+
+    // See LedgerTxnRoot::clearInMemoryEntries
+    void clearInMemoryEntries() const;
+
     void prepareNewObjects(size_t s);
 
+    LedgerTxnMemoryUsage getMemoryUsage() const;
+
 #ifdef BEST_OFFER_DEBUGGING
     bool bestOfferDebuggingEnabled() const;
 
@@ -392,7 +392,7 @@ LedgerTxnRoot::Impl::dropLiquidityPools(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS liquiditypool;";
 
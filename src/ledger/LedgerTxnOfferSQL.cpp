@@ -6,6 +6,7 @@
 #include "crypto/SecretKey.h"
 #include "database/Database.h"
 #include "database/DatabaseTypeSpecificOperation.h"
+#include "database/PostgresCopy.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/LedgerTypeUtils.h"
 #include "main/Application.h"
@@ -15,9 +16,9 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -339,6 +340,7 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     std::vector<int32_t> mLastModifieds;
     std::vector<std::string> mExtensions;
     std::vector<std::string> mLedgerExtensions;
+    bool mUseCopy{false};
 
     void
     accumulateEntry(LedgerEntry const& entry)
@@ -394,8 +396,9 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     }
 
     BulkUpsertOffersOperation(Database& DB,
-                              std::vector<EntryIterator> const& entries)
-        : mDB(DB)
+                              std::vector<EntryIterator> const& entries,
+                              bool useCopy)
+        : mDB(DB), mUseCopy(useCopy)
     {
         mSellerIDs.reserve(entries.size());
         mOfferIDs.reserve(entries.size());
@@ -473,9 +476,36 @@ class BulkUpsertOffersOperation : public DatabaseTypeSpecificOperation<void>
     }
 
 #ifdef USE_POSTGRES
+    void
+    doPostgresCopyOperation(PGconn* conn)
+    {
+        PostgresCopyUpsert upsert("offers", {"offerid"});
+        upsert.addColumn("sellerid", mSellerIDs);
+        upsert.addColumn("offerid", mOfferIDs);
+        upsert.addColumn("sellingasset", mSellingAssets);
+        upsert.addColumn("buyingasset", mBuyingAssets);
+        upsert.addColumn("amount", mAmounts);
+        upsert.addColumn("pricen", mPriceNs);
+        upsert.addColumn("priced", mPriceDs);
+        upsert.addColumn("price", mPrices);
+        upsert.addColumn("flags", mFlags);
+        upsert.addColumn("lastmodified", mLastModifieds);
+        upsert.addColumn("extension", mExtensions);
+        upsert.addColumn("ledgerext", mLedgerExtensions);
+        if (upsert.execute(mDB, conn, "offer") != mOfferIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
+        if (mUseCopy)
+        {
+            doPostgresCopyOperation(pg->conn_);
+            return;
+        }
 
         std::string strSellerIDs, strOfferIDs, strSellingAssets,
             strBuyingAssets, strAmounts, strPriceNs, strPriceDs, strPrices,
@@ -637,7 +667,8 @@ LedgerTxnRoot::Impl::bulkUpsertOffers(std::vector<EntryIterator> const& entries)
 {
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
-    BulkUpsertOffersOperation op(mApp.getDatabase(), entries);
+    BulkUpsertOffersOperation op(mApp.getDatabase(), entries,
+                                 useCopyUpsert(OFFER));
     mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
 }
 
@@ -656,7 +687,7 @@ LedgerTxnRoot::Impl::dropOffers(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS offers;";
 
@@ -355,7 +355,7 @@ LedgerTxnRoot::Impl::dropTTL(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     std::string coll = mApp.getDatabase().getSimpleCollationClause();
 
@@ -6,6 +6,7 @@
 #include "crypto/SecretKey.h"
 #include "database/Database.h"
 #include "database/DatabaseTypeSpecificOperation.h"
+#include "database/PostgresCopy.h"
 #include "ledger/LedgerTxnImpl.h"
 #include "ledger/LedgerTypeUtils.h"
 #include "ledger/NonSociRelatedException.h"
@@ -13,8 +14,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -128,12 +129,13 @@ class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
     std::vector<std::string> mAssets;
     std::vector<std::string> mTrustLineEntries;
     std::vector<int32_t> mLastModifieds;
+    bool const mUseCopy;
 
   public:
     BulkUpsertTrustLinesOperation(Database& DB,
                                   std::vector<EntryIterator> const& entries,
-                                  uint32_t ledgerVersion)
-        : mDB(DB)
+                                  uint32_t ledgerVersion, bool useCopy)
+        : mDB(DB), mUseCopy(useCopy)
     {
         mAccountIDs.reserve(entries.size());
         mAssets.reserve(entries.size());
@@ -194,10 +196,29 @@ class BulkUpsertTrustLinesOperation : public DatabaseTypeSpecificOperation<void>
     }
 
 #ifdef USE_POSTGRES
+    void
+    doPostgresCopyOperation(PGconn* conn)
+    {
+        PostgresCopyUpsert upsert("trustlines", {"accountid", "asset"});
+        upsert.addColumn("accountid", mAccountIDs);
+        upsert.addColumn("asset", mAssets);
+        upsert.addColumn("ledgerentry", mTrustLineEntries);
+        upsert.addColumn("lastmodified", mLastModifieds);
+        if (upsert.execute(mDB, conn, "trustline") != mAccountIDs.size())
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    }
+
     void
     doPostgresSpecificOperation(soci::postgresql_session_backend* pg) override
     {
         PGconn* conn = pg->conn_;
+        if (mUseCopy)
+        {
+            doPostgresCopyOperation(conn);
+            return;
+        }
 
         std::string strAccountIDs, strAssets, strTrustLineEntries,
             strLastModifieds;
@@ -333,7 +354,8 @@ LedgerTxnRoot::Impl::bulkUpsertTrustLines(
     ZoneScoped;
     ZoneValue(static_cast<int64_t>(entries.size()));
     BulkUpsertTrustLinesOperation op(mApp.getDatabase(), entries,
-                                     mHeader->ledgerVersion);
+                                     mHeader->ledgerVersion,
+                                     useCopyUpsert(TRUSTLINE));
     mApp.getDatabase().doDatabaseTypeSpecificOperation(op);
 }
 
@@ -353,7 +375,7 @@ LedgerTxnRoot::Impl::dropTrustLines(bool rebuild)
 {
     throwIfChild();
     mEntryCache.clear();
-    mBestOffers.clear();
+    clearBestOffers();
 
     mApp.getDatabase().getSession() << "DROP TABLE IF EXISTS trustlines;";
 
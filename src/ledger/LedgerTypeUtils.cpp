@@ -31,7 +31,7 @@ getTTLKey(LedgerKey const& e)
     releaseAssert(e.type() == CONTRACT_CODE || e.type() == CONTRACT_DATA);
     LedgerKey k;
     k.type(TTL);
-    k.ttl().keyHash = sha256(xdr::xdr_to_opaque(e));
+    k.ttl().keyHash = xdrSha256(e);
     return k;
 }
 };
\ No newline at end of file
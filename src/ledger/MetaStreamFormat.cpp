@@ -0,0 +1,169 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/MetaStreamFormat.h"
+#include "crypto/SHA.h"
+#include "util/GlobalChecks.h"
+#include "util/XDRUncheckedPut.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <cstring>
+#include <stdexcept>
+#ifdef USE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace stellar
+{
+
+namespace
+{
+void
+putUint32(char* out, uint32_t v)
+{
+    out[0] = static_cast<char>((v >> 24) & 0xFF);
+    out[1] = static_cast<char>((v >> 16) & 0xFF);
+    out[2] = static_cast<char>((v >> 8) & 0xFF);
+    out[3] = static_cast<char>(v & 0xFF);
+}
+
+uint32_t
+getUint32(char const* in)
+{
+    auto b = reinterpret_cast<unsigned char const*>(in);
+    return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) |
+           (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+}
+
+std::vector<char>
+toXDRRecord(LedgerCloseMeta const& meta)
+{
+    ZoneScoped;
+    uint32_t sz = static_cast<uint32_t>(xdr::xdr_size(meta));
+    releaseAssertOrThrow(sz < 0x80000000);
+    std::vector<char> record(sz + 4);
+    // Size with the XDR 'continuation' bit set, as writeOne does
+    putUint32(record.data(), sz | 0x80000000);
+    xdrPutUnchecked(meta, record.data() + 4, record.data() + record.size());
+    return record;
+}
+
+std::vector<char>
+toMetaFrame(std::vector<char> const& record, uint32_t ledgerSeq,
+            int compressionLevel)
+{
+    ZoneScoped;
+    releaseAssert(record.size() >= 4);
+    char const* xdr = record.data() + 4;
+    size_t const xdrSize = record.size() - 4;
+    auto hash = sha256(ByteSlice(xdr, xdrSize));
+
+    std::vector<char> frame;
+    uint32_t flags = 0;
+    if (compressionLevel > 0)
+    {
+#ifdef USE_ZLIB
+        auto bound = compressBound(static_cast<uLong>(xdrSize));
+        frame.resize(META_FRAME_HEADER_SIZE + bound);
+        uLongf compressedSize = bound;
+        if (compress2(reinterpret_cast<Bytef*>(frame.data()) +
+                          META_FRAME_HEADER_SIZE,
+                      &compressedSize, reinterpret_cast<Bytef const*>(xdr),
+                      static_cast<uLong>(xdrSize),
+                      compressionLevel) != Z_OK)
+        {
+            throw std::runtime_error("failed to compress meta");
+        }
+        frame.resize(META_FRAME_HEADER_SIZE + compressedSize);
+        flags |= META_FRAME_ZLIB;
+#else
+        releaseAssert(false);
+#endif
+    }
+    else
+    {
+        frame.resize(META_FRAME_HEADER_SIZE + xdrSize);
+        std::memcpy(frame.data() + META_FRAME_HEADER_SIZE, xdr, xdrSize);
+    }
+
+    auto out = frame.data();
+    putUint32(out, META_FRAME_MAGIC);
+    putUint32(out + 4, flags);
+    putUint32(out + 8, ledgerSeq);
+    putUint32(out + 12, static_cast<uint32_t>(xdrSize));
+    putUint32(out + 16,
+              static_cast<uint32_t>(frame.size() - META_FRAME_HEADER_SIZE));
+    std::memcpy(out + 20, hash.data(), hash.size());
+    return frame;
+}
+
+bool
+readMetaFrame(std::istream& in, MetaFrameHeader& header, LedgerCloseMeta& meta)
+{
+    ZoneScoped;
+    char buf[META_FRAME_HEADER_SIZE];
+    if (!in.read(buf, META_FRAME_HEADER_SIZE))
+    {
+        if (in.gcount() == 0)
+        {
+            return false;
+        }
+        throw std::runtime_error("truncated meta frame header");
+    }
+    if (getUint32(buf) != META_FRAME_MAGIC)
+    {
+        throw std::runtime_error("bad meta frame magic");
+    }
+    header.mFlags = getUint32(buf + 4);
+    header.mLedgerSeq = getUint32(buf + 8);
+    header.mUncompressedSize = getUint32(buf + 12);
+    header.mPayloadSize = getUint32(buf + 16);
+    std::memcpy(header.mHash.data(), buf + 20, header.mHash.size());
+
+    std::vector<char> payload(header.mPayloadSize);
+    if (!in.read(payload.data(), payload.size()))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("truncated meta frame of ledger {}"),
+                        header.mLedgerSeq));
+    }
+
+    std::vector<char> xdr;
+    if (header.mFlags & META_FRAME_ZLIB)
+    {
+#ifdef USE_ZLIB
+        xdr.resize(header.mUncompressedSize);
+        uLongf size = header.mUncompressedSize;
+        if (uncompress(reinterpret_cast<Bytef*>(xdr.data()), &size,
+                       reinterpret_cast<Bytef const*>(payload.data()),
+                       static_cast<uLong>(payload.size())) != Z_OK ||
+            size != header.mUncompressedSize)
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("failed to inflate meta of ledger {}"),
+                            header.mLedgerSeq));
+        }
+#else
+        throw std::runtime_error("compressed meta frames need zlib");
+#endif
+    }
+    else
+    {
+        xdr = std::move(payload);
+    }
+
+    if (xdr.size() != header.mUncompressedSize ||
+        sha256(ByteSlice(xdr.data(), xdr.size())) != header.mHash)
+    {
+        throw std::runtime_error(fmt::format(
+            FMT_STRING("meta frame of ledger {} doesn't match its hash"),
+            header.mLedgerSeq));
+    }
+    xdr::xdr_get g(xdr.data(), xdr.data() + xdr.size());
+    xdr::xdr_argpack_archive(g, meta);
+    return true;
+}
+}
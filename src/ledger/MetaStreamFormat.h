@@ -0,0 +1,59 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-ledger.h"
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+
+namespace stellar
+{
+
+// With METADATA_OUTPUT_STREAM_FORMAT=FRAMED, the meta of each ledger is
+// written to METADATA_OUTPUT_STREAM as a frame: a fixed-size header followed
+// by the XDR of its LedgerCloseMeta, deflated with zlib when
+// METADATA_OUTPUT_STREAM_COMPRESSION is set. The header holds, as
+// big-endian 32-bit integers unless said otherwise:
+//
+//   magic              META_FRAME_MAGIC, "SCMF"
+//   flags              META_FRAME_ZLIB when the payload is deflated
+//   ledger seq         the ledger the meta is of
+//   uncompressed size  size of the XDR of the LedgerCloseMeta
+//   payload size       size of what follows the header
+//   hash               32 bytes, SHA-256 of the (uncompressed) XDR
+//
+// Readers can then skip to a ledger without decoding, or even inflating,
+// the meta before it.
+uint32_t const META_FRAME_MAGIC = 0x53434d46;
+uint32_t const META_FRAME_ZLIB = 1;
+size_t const META_FRAME_HEADER_SIZE = 5 * 4 + 32;
+
+struct MetaFrameHeader
+{
+    uint32_t mFlags{0};
+    uint32_t mLedgerSeq{0};
+    uint32_t mUncompressedSize{0};
+    uint32_t mPayloadSize{0};
+    Hash mHash;
+};
+
+// The XDR of `meta` with its record mark, as XDROutputFileStream::writeOne
+// writes it
+std::vector<char> toXDRRecord(LedgerCloseMeta const& meta);
+
+// The frame of the meta of `ledgerSeq`, from its record as toXDRRecord
+// returns it. The payload is deflated at `compressionLevel`, from 1 to 9,
+// unless it is 0.
+std::vector<char> toMetaFrame(std::vector<char> const& record,
+                              uint32_t ledgerSeq, int compressionLevel);
+
+// Reads the next frame of `in` into `header` and `meta`, returning false at
+// the end of the stream. Throws std::runtime_error if the frame is malformed
+// or doesn't match its hash.
+bool readMetaFrame(std::istream& in, MetaFrameHeader& header,
+                   LedgerCloseMeta& meta);
+}
@@ -0,0 +1,170 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/MetaStreamWriter.h"
+#include "ledger/MetaStreamFormat.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+namespace stellar
+{
+
+MetaStreamWriter::MetaStreamWriter(Application& app,
+                                   std::unique_ptr<XDROutputFileStream> stream)
+    : mStream(std::move(stream))
+    , mMaxQueued(app.getConfig().METADATA_OUTPUT_STREAM_QUEUE)
+    , mFailWhenFull(app.getConfig().METADATA_OUTPUT_STREAM_FULL_POLICY ==
+                    "FAIL")
+    , mFramed(app.getConfig().METADATA_OUTPUT_STREAM_FORMAT == "FRAMED")
+    , mCompressionLevel(app.getConfig().METADATA_OUTPUT_STREAM_COMPRESSION)
+    , mBytes(
+          app.getMetrics().NewMeter({"ledger", "metastream", "bytes"}, "byte"))
+    , mWriteTime(app.getMetrics().NewTimer(
+          {"ledger", "metastream", "background-write"}))
+    , mBlockedTime(
+          app.getMetrics().NewTimer({"ledger", "metastream", "blocked"}))
+    , mQueuedLedgers(
+          app.getMetrics().NewCounter({"ledger", "metastream", "queued"}))
+    , mQueuedBytes(
+          app.getMetrics().NewCounter({"ledger", "metastream", "queued-bytes"}))
+{
+    releaseAssert(mMaxQueued > 0);
+    mThread = std::thread{[this]() { run(); }};
+}
+
+MetaStreamWriter::~MetaStreamWriter()
+{
+    shutdown();
+}
+
+void
+MetaStreamWriter::run()
+{
+    while (true)
+    {
+        std::pair<uint32_t, std::vector<char>>* next = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [&] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty())
+            {
+                return;
+            }
+            // Leave it queued until it is written, the main thread only
+            // appends to the queue so the reference stays valid
+            next = &mQueue.front();
+        }
+
+        try
+        {
+            ZoneNamedN(writeZone, "meta stream write", true);
+            auto timer = mWriteTime.TimeScope();
+            auto const& record = next->second;
+            if (mFramed)
+            {
+                // Compressing here rather than as the ledger closes
+                auto frame =
+                    toMetaFrame(record, next->first, mCompressionLevel);
+                mStream->writeBytes(frame.data(), frame.size());
+                mBytes.Mark(frame.size());
+            }
+            else
+            {
+                mStream->writeBytes(record.data(), record.size());
+                mBytes.Mark(record.size());
+            }
+            mStream->flush();
+        }
+        catch (std::exception& e)
+        {
+            CLOG_ERROR(Ledger, "Failed to write to the meta stream: {}",
+                       e.what());
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFailure = std::current_exception();
+            mQueue.clear();
+            mQueuedSize = 0;
+            mQueuedLedgers.set_count(0);
+            mQueuedBytes.set_count(0);
+            mCond.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueuedSize -= mQueue.front().second.size();
+            mQueue.pop_front();
+            mQueuedLedgers.set_count(mQueue.size());
+            mQueuedBytes.set_count(mQueuedSize);
+        }
+        mCond.notify_all();
+    }
+}
+
+void
+MetaStreamWriter::rethrowFailure()
+{
+    if (mFailure)
+    {
+        std::rethrow_exception(mFailure);
+    }
+}
+
+void
+MetaStreamWriter::enqueue(LedgerCloseMeta const& meta, uint32_t ledgerSeq)
+{
+    ZoneScoped;
+    auto record = toXDRRecord(meta);
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        releaseAssert(!mStopping);
+        rethrowFailure();
+        if (mQueue.size() >= mMaxQueued)
+        {
+            if (mFailWhenFull)
+            {
+                throw std::runtime_error(fmt::format(
+                    FMT_STRING("The meta stream reader is {} ledgers behind"),
+                    mQueue.size()));
+            }
+            CLOG_WARNING(Ledger,
+                         "The meta stream reader is {} ledgers behind, "
+                         "ledger close waits for it",
+                         mQueue.size());
+            auto timer = mBlockedTime.TimeScope();
+            mCond.wait(lock, [&] {
+                return mFailure || mQueue.size() < mMaxQueued;
+            });
+            rethrowFailure();
+        }
+        mQueuedSize += record.size();
+        mQueue.emplace_back(ledgerSeq, std::move(record));
+        mQueuedLedgers.set_count(mQueue.size());
+        mQueuedBytes.set_count(mQueuedSize);
+    }
+    mCond.notify_all();
+}
+
+void
+MetaStreamWriter::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCond.notify_all();
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/XDRStream.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+
+// Writes the LedgerCloseMeta of closed ledgers to METADATA_OUTPUT_STREAM from
+// a thread of its own, so that a slow reader of the stream doesn't hold
+// ledger close up. Meta is serialized on the main thread and queued, up to
+// METADATA_OUTPUT_STREAM_QUEUE ledgers; once the queue is full ledger close
+// either waits for the reader or fails, as METADATA_OUTPUT_STREAM_FULL_POLICY
+// says.
+//
+// The meta of the ledgers still queued is lost if the process dies, while
+// the ledgers themselves are committed: readers must be able to restart
+// from the last ledger they got, as they already do after a crash.
+class MetaStreamWriter : NonMovableOrCopyable
+{
+    std::unique_ptr<XDROutputFileStream> mStream;
+    size_t const mMaxQueued;
+    bool const mFailWhenFull;
+    bool const mFramed;
+    int const mCompressionLevel;
+    medida::Meter& mBytes;
+    medida::Timer& mWriteTime;
+    medida::Timer& mBlockedTime;
+    medida::Counter& mQueuedLedgers;
+    medida::Counter& mQueuedBytes;
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // XDR records of the meta of each ledger queued, the one at the front
+    // being written
+    std::deque<std::pair<uint32_t, std::vector<char>>> mQueue;
+    size_t mQueuedSize{0};
+    bool mStopping{false};
+    // Set when writing failed, the writer stops then
+    std::exception_ptr mFailure;
+    std::thread mThread;
+
+    void run();
+    void rethrowFailure();
+
+  public:
+    MetaStreamWriter(Application& app,
+                     std::unique_ptr<XDROutputFileStream> stream);
+    ~MetaStreamWriter();
+
+    // Queue the meta of `ledgerSeq`, waiting for the writer or throwing if
+    // the queue is full. Rethrows the error that stopped the writer, if any.
+    void enqueue(LedgerCloseMeta const& meta, uint32_t ledgerSeq);
+
+    // Writes what is still queued and stops the writer, nothing can be
+    // queued after. This must be called while the metrics still exist.
+    void shutdown();
+};
+}
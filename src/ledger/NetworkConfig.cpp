@@ -7,7 +7,7 @@
 #include "bucket/BucketManager.h"
 #include "main/Application.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 #ifdef BUILD_TESTS
 #include "ledger/LedgerManager.h"
@@ -1412,7 +1412,7 @@ SorobanNetworkConfig::maybeUpdateBucketListWindowSize(AbstractLedgerTxn& ltx)
     writeBucketListSizeWindow(ltx);
 }
 
-void
+bool
 SorobanNetworkConfig::maybeSnapshotBucketListSize(uint32_t currLedger,
                                                   AbstractLedgerTxn& ltx,
                                                   Application& app)
@@ -1424,7 +1424,7 @@ SorobanNetworkConfig::maybeSnapshotBucketListSize(uint32_t currLedger,
     if (protocolVersionIsBefore(ledgerVersion, SOROBAN_PROTOCOL_VERSION) ||
         !app.getConfig().MODE_ENABLES_BUCKETLIST)
     {
-        return;
+        return false;
     }
 
     if (currLedger % mStateArchivalSettings.bucketListWindowSamplePeriod == 0)
@@ -1438,7 +1438,9 @@ SorobanNetworkConfig::maybeSnapshotBucketListSize(uint32_t currLedger,
         updateBucketListSizeAverage();
         computeWriteFee(app.getConfig().CURRENT_LEDGER_PROTOCOL_VERSION,
                         ledgerVersion);
+        return true;
     }
+    return false;
 }
 
 uint64_t
@@ -293,8 +293,8 @@ class SorobanNetworkConfig
     uint32_t ledgerMaxTxCount() const;
 
     // If currLedger is a ledger when we should snapshot, add a new snapshot to
-    // the sliding window and write it to disk.
-    void maybeSnapshotBucketListSize(uint32_t currLedger,
+    // the sliding window and write it to disk. Returns whether it did.
+    bool maybeSnapshotBucketListSize(uint32_t currLedger,
                                      AbstractLedgerTxn& ltx, Application& app);
 
     // Returns the average of all BucketList size snapshots in the sliding
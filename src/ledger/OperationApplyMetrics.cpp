@@ -0,0 +1,119 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/OperationApplyMetrics.h"
+#include "util/GlobalChecks.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include <algorithm>
+#include <fmt/format.h>
+
+namespace stellar
+{
+
+OperationApplyMetrics::PerType::PerType(medida::Timer& apply,
+                                        medida::Timer& commit,
+                                        medida::Meter& failure)
+    : mApply(apply), mCommit(commit), mFailure(failure)
+{
+}
+
+OperationApplyMetrics::OperationApplyMetrics(medida::MetricsRegistry& metrics)
+{
+    auto const& types = xdr::xdr_traits<OperationType>::enum_values();
+    mPerType.reserve(types.size());
+    for (size_t i = 0; i < types.size(); ++i)
+    {
+        // OperationType values are the indices of mPerType
+        releaseAssert(static_cast<size_t>(types[i]) == i);
+        std::string name = xdr::xdr_traits<OperationType>::enum_name(
+            static_cast<OperationType>(types[i]));
+        std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+            return c == '_' ? '-' : static_cast<char>(::tolower(c));
+        });
+        auto domain = "operation-" + name;
+        mPerType.emplace_back(metrics.NewTimer({"ledger", domain, "apply"}),
+                              metrics.NewTimer({"ledger", domain, "commit"}),
+                              metrics.NewMeter({"ledger", domain, "failure"},
+                                               "operation"));
+    }
+}
+
+OperationApplyMetrics::PerType&
+OperationApplyMetrics::get(OperationType type)
+{
+    return mPerType.at(static_cast<size_t>(type));
+}
+
+void
+OperationApplyMetrics::recordApply(OperationType type,
+                                   std::chrono::nanoseconds duration,
+                                   bool success)
+{
+    auto& m = get(type);
+    m.mApply.Update(duration);
+    if (!success)
+    {
+        m.mFailure.Mark();
+    }
+    ++m.mLedgerCount;
+    m.mLedgerApply += duration;
+}
+
+void
+OperationApplyMetrics::recordCommit(OperationType type,
+                                    std::chrono::nanoseconds duration)
+{
+    auto& m = get(type);
+    m.mCommit.Update(duration);
+    m.mLedgerCommit += duration;
+}
+
+std::string
+OperationApplyMetrics::getLedgerBreakdown() const
+{
+    std::vector<size_t> applied;
+    for (size_t i = 0; i < mPerType.size(); ++i)
+    {
+        if (mPerType[i].mLedgerCount > 0)
+        {
+            applied.emplace_back(i);
+        }
+    }
+    auto total = [&](size_t i) {
+        return mPerType[i].mLedgerApply + mPerType[i].mLedgerCommit;
+    };
+    std::sort(applied.begin(), applied.end(),
+              [&](size_t a, size_t b) { return total(a) > total(b); });
+
+    std::string res;
+    for (auto i : applied)
+    {
+        auto const& m = mPerType[i];
+        using std::chrono::microseconds;
+        using std::chrono::duration_cast;
+        res += fmt::format(
+            FMT_STRING("{}{}: {} ops, apply {}us, commit {}us"),
+            res.empty() ? "" : "; ",
+            xdr::xdr_traits<OperationType>::enum_name(
+                static_cast<OperationType>(i)),
+            m.mLedgerCount, duration_cast<microseconds>(m.mLedgerApply).count(),
+            duration_cast<microseconds>(m.mLedgerCommit).count());
+    }
+    return res;
+}
+
+void
+OperationApplyMetrics::resetLedger()
+{
+    for (auto& m : mPerType)
+    {
+        m.mLedgerCount = 0;
+        m.mLedgerApply = std::chrono::nanoseconds::zero();
+        m.mLedgerCommit = std::chrono::nanoseconds::zero();
+    }
+}
+}
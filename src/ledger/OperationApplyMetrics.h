@@ -0,0 +1,65 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// This class splits the time spent applying operations by operation type. For
+// every type it exposes ledger.operation-<type>.apply, the time to run the
+// operation including loading the entries it touches, and
+// ledger.operation-<type>.commit, the time to check the invariants, record
+// the meta changes and commit it, along with a meter of the failed ones. It
+// also accumulates the same times over the current ledger, so that a slow
+// ledger can log where its apply time went.
+#include "xdr/Stellar-transaction.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace medida
+{
+class Timer;
+class Meter;
+class MetricsRegistry;
+}
+
+namespace stellar
+{
+
+class OperationApplyMetrics
+{
+    struct PerType
+    {
+        medida::Timer& mApply;
+        medida::Timer& mCommit;
+        medida::Meter& mFailure;
+
+        // Totals over the current ledger
+        uint64_t mLedgerCount{0};
+        std::chrono::nanoseconds mLedgerApply{0};
+        std::chrono::nanoseconds mLedgerCommit{0};
+
+        PerType(medida::Timer& apply, medida::Timer& commit,
+                medida::Meter& failure);
+    };
+
+    // Indexed by OperationType
+    std::vector<PerType> mPerType;
+
+    PerType& get(OperationType type);
+
+  public:
+    explicit OperationApplyMetrics(medida::MetricsRegistry& metrics);
+
+    void recordApply(OperationType type, std::chrono::nanoseconds duration,
+                     bool success);
+    void recordCommit(OperationType type, std::chrono::nanoseconds duration);
+
+    // Operation types applied in the current ledger, by decreasing total time,
+    // with their count and apply and commit times
+    std::string getLedgerBreakdown() const;
+    void resetLedger();
+};
+}
@@ -0,0 +1,119 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/RecentLedgerHeaders.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+namespace stellar
+{
+
+// A few checkpoints, so that a publish running behind still finds its
+// ledgers
+size_t const RecentLedgerHeaders::MAX_LEDGERS = 256;
+
+RecentLedgerHeaders::RecentLedgerHeaders(medida::MetricsRegistry& metrics)
+    : mHits(metrics.NewMeter({"ledger", "header-cache", "hit"}, "header"))
+    , mMisses(metrics.NewMeter({"ledger", "header-cache", "miss"}, "header"))
+{
+}
+
+std::optional<size_t>
+RecentLedgerHeaders::indexOf(uint32_t ledgerSeq) const
+{
+    if (mHeaders.empty() || ledgerSeq < mHeaders.front().header.ledgerSeq)
+    {
+        return std::nullopt;
+    }
+    size_t i = ledgerSeq - mHeaders.front().header.ledgerSeq;
+    if (i >= mHeaders.size())
+    {
+        return std::nullopt;
+    }
+    return i;
+}
+
+void
+RecentLedgerHeaders::add(LedgerHeaderHistoryEntry const& lhe)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto seq = lhe.header.ledgerSeq;
+    if (!mHeaders.empty() && seq != mHeaders.back().header.ledgerSeq + 1)
+    {
+        auto i = indexOf(seq);
+        if (i)
+        {
+            mHeaders.erase(mHeaders.begin() + *i, mHeaders.end());
+        }
+        else
+        {
+            mHeaders.clear();
+        }
+    }
+    // A ledger replaced must be followed by the one before it
+    if (!mHeaders.empty() &&
+        mHeaders.back().hash != lhe.header.previousLedgerHash)
+    {
+        mHeaders.clear();
+    }
+    mHeaders.emplace_back(lhe);
+    while (mHeaders.size() > MAX_LEDGERS)
+    {
+        mHeaders.pop_front();
+    }
+}
+
+void
+RecentLedgerHeaders::eraseFrom(uint32_t ledgerSeq)
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    if (!mHeaders.empty() && ledgerSeq <= mHeaders.front().header.ledgerSeq)
+    {
+        mHeaders.clear();
+        return;
+    }
+    auto i = indexOf(ledgerSeq);
+    if (i)
+    {
+        mHeaders.erase(mHeaders.begin() + *i, mHeaders.end());
+    }
+}
+
+void
+RecentLedgerHeaders::clear()
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    mHeaders.clear();
+}
+
+std::optional<LedgerHeaderHistoryEntry>
+RecentLedgerHeaders::get(uint32_t ledgerSeq) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto i = indexOf(ledgerSeq);
+    if (!i)
+    {
+        mMisses.Mark();
+        return std::nullopt;
+    }
+    mHits.Mark();
+    return mHeaders[*i];
+}
+
+std::optional<std::vector<LedgerHeaderHistoryEntry>>
+RecentLedgerHeaders::getRange(uint32_t begin, uint32_t end) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    auto first = indexOf(begin);
+    if (begin >= end || !first || !indexOf(end - 1))
+    {
+        mMisses.Mark(end > begin ? end - begin : 0);
+        return std::nullopt;
+    }
+    mHits.Mark(end - begin);
+    return std::vector<LedgerHeaderHistoryEntry>(
+        mHeaders.begin() + *first, mHeaders.begin() + *first + (end - begin));
+}
+}
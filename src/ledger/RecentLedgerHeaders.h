@@ -0,0 +1,58 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+class MetricsRegistry;
+}
+
+namespace stellar
+{
+
+// The headers and hashes of the last MAX_LEDGERS ledgers closed, in memory,
+// so that reading recent headers, as publishing a checkpoint does, needs no
+// SQL query. The ledgers kept are consecutive: adding one that doesn't follow
+// the latest drops those it replaces or, after a gap, all of them. It is
+// read from publishing threads, so every method locks.
+//
+// Lookups are counted by ledger.header-cache.hit and
+// ledger.header-cache.miss.
+class RecentLedgerHeaders : public NonMovableOrCopyable
+{
+  public:
+    static size_t const MAX_LEDGERS;
+
+    explicit RecentLedgerHeaders(medida::MetricsRegistry& metrics);
+
+    void add(LedgerHeaderHistoryEntry const& lhe);
+    // Drops the ledgers from `ledgerSeq` on
+    void eraseFrom(uint32_t ledgerSeq);
+    void clear();
+
+    std::optional<LedgerHeaderHistoryEntry> get(uint32_t ledgerSeq) const;
+    // The ledgers of [begin, end), or nullopt unless all of them are kept
+    std::optional<std::vector<LedgerHeaderHistoryEntry>>
+    getRange(uint32_t begin, uint32_t end) const;
+
+  private:
+    mutable std::mutex mMutex;
+    std::deque<LedgerHeaderHistoryEntry> mHeaders;
+    medida::Meter& mHits;
+    medida::Meter& mMisses;
+
+    // Index of `ledgerSeq` in mHeaders, if kept
+    std::optional<size_t> indexOf(uint32_t ledgerSeq) const;
+};
+}
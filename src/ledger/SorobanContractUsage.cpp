@@ -0,0 +1,177 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/SorobanContractUsage.h"
+#include "crypto/StrKey.h"
+#include "lib/json/json.h"
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace stellar
+{
+
+// About 5 minutes
+uint32_t const SorobanContractUsage::WINDOW_LEDGERS = 64;
+size_t const SorobanContractUsage::CAPACITY_FACTOR = 4;
+
+namespace
+{
+template <typename Totals>
+void
+totalsToJson(Json::Value& res, Totals const& totals)
+{
+    res["invocations"] = static_cast<Json::UInt64>(totals.mInvocations);
+    res["failures"] = static_cast<Json::UInt64>(totals.mFailures);
+    res["cpu_insns"] = static_cast<Json::UInt64>(totals.mCpuInsn);
+    res["mem_bytes"] = static_cast<Json::UInt64>(totals.mMemByte);
+    res["read_bytes"] = static_cast<Json::UInt64>(totals.mReadByte);
+    res["write_bytes"] = static_cast<Json::UInt64>(totals.mWriteByte);
+    res["invoke_time_nsecs"] =
+        static_cast<Json::UInt64>(totals.mInvokeTimeNsecs);
+    res["max_overcount_nsecs"] =
+        static_cast<Json::UInt64>(totals.mOvercountNsecs);
+}
+
+// The `n` entries of `table` of highest rank, from the highest
+template <typename Table>
+std::vector<typename Table::const_iterator>
+topOf(Table const& table, size_t n)
+{
+    std::vector<typename Table::const_iterator> res;
+    for (auto it = table.begin(); it != table.end(); ++it)
+    {
+        res.emplace_back(it);
+    }
+    n = std::min(n, res.size());
+    std::partial_sort(res.begin(), res.begin() + n, res.end(),
+                      [](auto const& a, auto const& b) {
+                          return a->second.rank() > b->second.rank();
+                      });
+    res.resize(n);
+    return res;
+}
+
+std::string
+contractStrKey(Hash const& contractID)
+{
+    return strKey::toStrKey(strKey::STRKEY_CONTRACT, contractID).value;
+}
+}
+
+SorobanContractUsage::SorobanContractUsage(size_t topN) : mTopN(topN)
+{
+}
+
+void
+SorobanContractUsage::Totals::add(SorobanInvocationUsage const& usage)
+{
+    ++mInvocations;
+    if (!usage.mSuccess)
+    {
+        ++mFailures;
+    }
+    mCpuInsn += usage.mCpuInsn;
+    mMemByte += usage.mMemByte;
+    mReadByte += usage.mReadByte;
+    mWriteByte += usage.mWriteByte;
+    mInvokeTimeNsecs += usage.mInvokeTimeNsecs;
+}
+
+template <typename Key>
+void
+SorobanContractUsage::add(Table<Key>& table, Key const& key,
+                          SorobanInvocationUsage const& usage) const
+{
+    auto it = table.find(key);
+    if (it == table.end())
+    {
+        Totals totals;
+        if (table.size() >= mTopN * CAPACITY_FACTOR)
+        {
+            auto least = std::min_element(
+                table.begin(), table.end(), [](auto const& a, auto const& b) {
+                    return a.second.rank() < b.second.rank();
+                });
+            totals.mOvercountNsecs = least->second.rank();
+            table.erase(least);
+        }
+        it = table.emplace(key, totals).first;
+    }
+    it->second.add(usage);
+}
+
+void
+SorobanContractUsage::record(uint32_t ledgerSeq, Hash const& contractID,
+                             std::string const& function,
+                             SorobanInvocationUsage const& usage)
+{
+    ZoneScoped;
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    if (!mCurrent ||
+        ledgerSeq / WINDOW_LEDGERS != mCurrent->mFirstLedger / WINDOW_LEDGERS)
+    {
+        mPrevious = std::move(mCurrent);
+        mCurrent.emplace();
+        mCurrent->mFirstLedger = ledgerSeq;
+    }
+    mCurrent->mLastLedger = ledgerSeq;
+    ++mCurrent->mInvocations;
+    add(mCurrent->mContracts, contractID, usage);
+    add(mCurrent->mFunctions, FunctionKey{contractID, function}, usage);
+}
+
+Json::Value
+SorobanContractUsage::getJsonInfo(Window const& window) const
+{
+    Json::Value res;
+    res["first_ledger"] = window.mFirstLedger;
+    res["last_ledger"] = window.mLastLedger;
+    res["invocations"] = static_cast<Json::UInt64>(window.mInvocations);
+
+    auto& contracts = res["contracts"];
+    contracts = Json::arrayValue;
+    for (auto const& it : topOf(window.mContracts, mTopN))
+    {
+        Json::Value c;
+        c["contract"] = contractStrKey(it->first);
+        totalsToJson(c, it->second);
+        contracts.append(c);
+    }
+
+    auto& functions = res["functions"];
+    functions = Json::arrayValue;
+    for (auto const& it : topOf(window.mFunctions, mTopN))
+    {
+        Json::Value f;
+        f["contract"] = contractStrKey(it->first.first);
+        f["function"] = it->first.second;
+        totalsToJson(f, it->second);
+        functions.append(f);
+    }
+    return res;
+}
+
+Json::Value
+SorobanContractUsage::getJsonInfo() const
+{
+    Json::Value res;
+    res["top_n"] = static_cast<Json::UInt64>(mTopN);
+    res["window_ledgers"] = WINDOW_LEDGERS;
+    if (mCurrent)
+    {
+        res["current"] = getJsonInfo(*mCurrent);
+    }
+    if (mPrevious)
+    {
+        res["previous"] = getJsonInfo(*mPrevious);
+    }
+    return res;
+}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// This class accumulates the Soroban resources used by each contract, and by
+// each function of each contract, over windows of WINDOW_LEDGERS ledgers, so
+// that the contracts behind slow ledgers can be found. Only the current and
+// the previous window are kept.
+//
+// A window holds at most CAPACITY_FACTOR times the number of contracts and
+// functions reported. Once full, a new contract replaces the one with the
+// least invoke time and inherits that time in its rank (the "space saving"
+// algorithm), so that the contracts using the most time stay while the
+// others churn. The totals reported are those of the invocations seen since
+// the contract entered the window, the rank overestimating its invoke time by
+// at most `max_overcount_nsecs`.
+#include "xdr/Stellar-types.h"
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace Json
+{
+class Value;
+}
+
+namespace stellar
+{
+
+// Resources used by one invocation of a contract function
+struct SorobanInvocationUsage
+{
+    uint64_t mCpuInsn{0};
+    uint64_t mMemByte{0};
+    uint64_t mReadByte{0};
+    uint64_t mWriteByte{0};
+    uint64_t mInvokeTimeNsecs{0};
+    bool mSuccess{false};
+};
+
+class SorobanContractUsage
+{
+  public:
+    static uint32_t const WINDOW_LEDGERS;
+    static size_t const CAPACITY_FACTOR;
+
+    // Reports the `topN` contracts and functions using the most invoke time,
+    // tracking nothing if 0
+    explicit SorobanContractUsage(size_t topN);
+
+    bool
+    isEnabled() const
+    {
+        return mTopN != 0;
+    }
+
+    void record(uint32_t ledgerSeq, Hash const& contractID,
+                std::string const& function,
+                SorobanInvocationUsage const& usage);
+
+    // Top contracts and functions of the current and the previous windows
+    Json::Value getJsonInfo() const;
+
+  private:
+    struct Totals
+    {
+        uint64_t mInvocations{0};
+        uint64_t mFailures{0};
+        uint64_t mCpuInsn{0};
+        uint64_t mMemByte{0};
+        uint64_t mReadByte{0};
+        uint64_t mWriteByte{0};
+        uint64_t mInvokeTimeNsecs{0};
+        // Invoke time of the entry this one replaced
+        uint64_t mOvercountNsecs{0};
+
+        void add(SorobanInvocationUsage const& usage);
+
+        uint64_t
+        rank() const
+        {
+            return mInvokeTimeNsecs + mOvercountNsecs;
+        }
+    };
+
+    template <typename Key> using Table = std::map<Key, Totals>;
+    using FunctionKey = std::pair<Hash, std::string>;
+
+    struct Window
+    {
+        uint32_t mFirstLedger{0};
+        uint32_t mLastLedger{0};
+        uint64_t mInvocations{0};
+        Table<Hash> mContracts;
+        Table<FunctionKey> mFunctions;
+    };
+
+    size_t const mTopN;
+    std::optional<Window> mCurrent;
+    std::optional<Window> mPrevious;
+
+    template <typename Key>
+    void add(Table<Key>& table, Key const& key,
+             SorobanInvocationUsage const& usage) const;
+    Json::Value getJsonInfo(Window const& window) const;
+};
+}
@@ -78,6 +78,8 @@ SorobanMetrics::SorobanMetrics(medida::MetricsRegistry& metrics)
     /* ExtendFootprintTTLOp metrics */
     , mExtFpTtlOpReadLedgerByte(metrics.NewMeter(
           {"soroban", "ext-fprint-ttl-op", "read-ledger-byte"}, "byte"))
+    , mExtFpTtlOpPrefetchEntry(metrics.NewMeter(
+          {"soroban", "ext-fprint-ttl-op", "prefetch-entry"}, "entry"))
     , mExtFpTtlOpExec(
           metrics.NewTimer({"soroban", "ext-fprint-ttl-op", "exec"}))
     /* RestoreFootprintOp metrics */
@@ -85,6 +87,8 @@ SorobanMetrics::SorobanMetrics(medida::MetricsRegistry& metrics)
           {"soroban", "restore-fprint-op", "read-ledger-byte"}, "byte"))
     , mRestoreFpOpWriteLedgerByte(metrics.NewMeter(
           {"soroban", "restore-fprint-op", "write-ledger-byte"}, "byte"))
+    , mRestoreFpOpPrefetchEntry(metrics.NewMeter(
+          {"soroban", "restore-fprint-op", "prefetch-entry"}, "entry"))
     , mRestoreFpOpExec(
           metrics.NewTimer({"soroban", "restore-fprint-op", "exec"}))
     /* network config metrics */
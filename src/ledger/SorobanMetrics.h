@@ -75,11 +75,13 @@ class SorobanMetrics
 
     // `ExtendFootprintTTLOp` metrics
     medida::Meter& mExtFpTtlOpReadLedgerByte;
+    medida::Meter& mExtFpTtlOpPrefetchEntry;
     medida::Timer& mExtFpTtlOpExec;
 
     // `RestoreFootprintOp` metrics
     medida::Meter& mRestoreFpOpReadLedgerByte;
     medida::Meter& mRestoreFpOpWriteLedgerByte;
+    medida::Meter& mRestoreFpOpPrefetchEntry;
     medida::Timer& mRestoreFpOpExec;
 
     // `NetworkConfig` metrics
@@ -0,0 +1,136 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/WarmStartCache.h"
+#include "bucket/BucketManager.h"
+#include "crypto/Hex.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "util/Fs.h"
+#include "util/Logging.h"
+#include "util/UnorderedSet.h"
+#include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
+
+#include <chrono>
+#include <limits>
+
+namespace stellar
+{
+
+namespace
+{
+// Bump when the contents of the file change
+uint32_t const WARM_START_CACHE_VERSION = 1;
+}
+
+std::string
+warmStartCacheFilename(Application& app)
+{
+    return app.getBucketManager().getBucketDir() + "/warm-start-cache.xdr";
+}
+
+void
+saveWarmStartCache(Application& app)
+{
+    ZoneScoped;
+    auto root = dynamic_cast<LedgerTxnRoot*>(&app.getLedgerTxnRoot());
+    if (!root)
+    {
+        return;
+    }
+
+    auto filename = warmStartCacheFilename(app);
+    auto tmpFilename = filename + ".tmp";
+    try
+    {
+        auto keys = root->getCachedKeys(std::numeric_limits<size_t>::max());
+        auto const& lcl = app.getLedgerManager().getLastClosedLedgerHeader();
+        {
+            XDROutputFileStream out(app.getClock().getIOContext(),
+                                    /*fsyncOnClose=*/true);
+            out.open(tmpFilename);
+            out.writeOne(WARM_START_CACHE_VERSION);
+            out.writeOne(lcl.hash);
+            for (auto const& key : keys)
+            {
+                out.writeOne(key);
+            }
+            out.close();
+        }
+        if (!fs::durableRename(tmpFilename, filename,
+                               app.getBucketManager().getBucketDir()))
+        {
+            throw std::runtime_error("failed to rename " + tmpFilename);
+        }
+        CLOG_INFO(Ledger, "Saved {} cached keys at ledger {} to {}",
+                  keys.size(), lcl.header.ledgerSeq, filename);
+    }
+    catch (std::exception const& e)
+    {
+        // Only a cold start is lost
+        CLOG_WARNING(Ledger, "Failed to save the warm start cache: {}",
+                     e.what());
+        std::remove(tmpFilename.c_str());
+    }
+}
+
+void
+loadWarmStartCache(Application& app)
+{
+    ZoneScoped;
+    auto filename = warmStartCacheFilename(app);
+    if (!fs::exists(filename))
+    {
+        return;
+    }
+
+    try
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto const& lclHash =
+            app.getLedgerManager().getLastClosedLedgerHeader().hash;
+        XDRInputFileStream in;
+        in.open(filename);
+        uint32_t version = 0;
+        Hash hash;
+        if (!in.readOne(version) || version != WARM_START_CACHE_VERSION)
+        {
+            CLOG_INFO(Ledger, "Ignoring warm start cache of version {}",
+                      version);
+        }
+        else if (!in.readOne(hash) || hash != lclHash)
+        {
+            CLOG_INFO(Ledger,
+                      "Ignoring warm start cache saved at ledger {}, which "
+                      "isn't the last closed one ({})",
+                      hexAbbrev(hash), hexAbbrev(lclHash));
+        }
+        else
+        {
+            UnorderedSet<LedgerKey> keys;
+            LedgerKey key;
+            while (in.readOne(key))
+            {
+                keys.emplace(key);
+            }
+            auto loaded = app.getLedgerTxnRoot().prefetch(keys);
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            CLOG_INFO(Ledger,
+                      "Warmed the entry cache up with {} of {} saved keys in "
+                      "{:.3f}s",
+                      loaded, keys.size(), elapsed.count());
+        }
+    }
+    catch (std::exception const& e)
+    {
+        CLOG_WARNING(Ledger, "Ignoring unreadable warm start cache: {}",
+                     e.what());
+    }
+    std::remove(filename.c_str());
+}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <string>
+
+namespace stellar
+{
+
+class Application;
+
+// With WARM_START_CACHE, a graceful stop saves the keys of the entries held
+// by the LedgerTxnRoot entry cache, with the hash of the last closed ledger,
+// and the next startup prefetches them when that ledger is still the last
+// closed one. Only keys are saved: the entries are loaded again from the
+// database or the BucketList, so a stale or damaged file can at worst warm
+// the cache up with the wrong entries.
+//
+// The file is versioned by WARM_START_CACHE_VERSION and deleted once read,
+// so that it doesn't outlive the ledger it was saved at.
+std::string warmStartCacheFilename(Application& app);
+void saveWarmStartCache(Application& app);
+void loadWarmStartCache(Application& app);
+}
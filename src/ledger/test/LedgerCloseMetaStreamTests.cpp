@@ -13,6 +13,7 @@
 #include "history/test/HistoryTestsUtils.h"
 #include "ledger/FlushAndRotateMetaDebugWork.h"
 #include "ledger/LedgerTxn.h"
+#include "ledger/MetaStreamFormat.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
@@ -34,6 +35,7 @@
 #include <fmt/format.h>
 #include <fstream>
 #include <iterator>
+#include <sstream>
 
 using namespace stellar;
 
@@ -281,6 +283,10 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
 #endif
 
     bool const delayMeta = GENERATE(true, false);
+    // Meta written as ledgers close, and queued for the writer thread
+    uint32_t const queue = GENERATE(0, 4);
+    // Keeping the last closed ledger state in memory only
+    bool const replayOnly = GENERATE(false, true);
 
     // Step 3: pass it to an application and have it catch up to the generated
     // history, streaming ledgerCloseMeta to the file descriptor.
@@ -290,8 +296,16 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
         cfg.NODE_IS_VALIDATOR = false;
         cfg.FORCE_SCP = false;
         cfg.RUN_STANDALONE = true;
-        cfg.setInMemoryMode();
+        if (replayOnly)
+        {
+            cfg.setInMemoryReplayMode();
+        }
+        else
+        {
+            cfg.setInMemoryMode();
+        }
         cfg.EXPERIMENTAL_PRECAUTION_DELAY_META = delayMeta;
+        cfg.METADATA_OUTPUT_STREAM_QUEUE = queue;
         VirtualClock clock;
         auto app = createTestApplication(clock, cfg, /*newdb=*/false);
 
@@ -305,6 +319,8 @@ TEST_CASE("LedgerCloseMetaStream file descriptor - REPLAY_IN_MEMORY",
         int res = catchup(app, cc, catchupInfo, archive);
         REQUIRE(res == 0);
         hash = lm.getLastClosedLedgerHeader().hash;
+        REQUIRE(lm.getLastClosedLedgerHAS().currentLedger ==
+                lm.getLastClosedLedgerNum());
         while (clock.cancelAllEvents() ||
                app->getProcessManager().getNumRunningProcesses() > 0)
         {
@@ -479,6 +495,78 @@ TEST_CASE("METADATA_DEBUG_LEDGERS works", "[metadebug]")
     }
 }
 
+TEST_CASE("framed meta stream", "[ledgerclosemeta]")
+{
+    TmpDirManager tdm(std::string("streamtmp-") + binToHex(randomBytes(8)));
+    TmpDir td = tdm.tmpDir("streams");
+    std::string metaPath = td.getName() + "/stream.framed";
+
+#ifdef USE_ZLIB
+    int const compression = GENERATE(0, 6);
+#else
+    int const compression = 0;
+#endif
+    uint32_t const queue = GENERATE(0, 4);
+    CAPTURE(compression, queue);
+
+    uint32_t lastSeq;
+    {
+        VirtualClock clock;
+        Config cfg = getTestConfig();
+        cfg.METADATA_OUTPUT_STREAM = metaPath;
+        cfg.METADATA_OUTPUT_STREAM_FORMAT = "FRAMED";
+        cfg.METADATA_OUTPUT_STREAM_COMPRESSION = compression;
+        cfg.METADATA_OUTPUT_STREAM_QUEUE = queue;
+        auto app = createTestApplication(clock, cfg);
+        for (int i = 0; i < 10; ++i)
+        {
+            txtest::closeLedger(*app);
+        }
+        lastSeq = app->getLedgerManager().getLastClosedLedgerNum();
+    }
+
+    std::ifstream in(metaPath, std::ios::binary);
+    REQUIRE(in);
+    MetaFrameHeader header;
+    LedgerCloseMeta lcm;
+    uint32_t expectedSeq = 2;
+    while (readMetaFrame(in, header, lcm))
+    {
+        REQUIRE(header.mLedgerSeq == expectedSeq);
+        auto const& lh = lcm.v() == 0 ? lcm.v0().ledgerHeader.header
+                                      : lcm.v1().ledgerHeader.header;
+        REQUIRE(lh.ledgerSeq == expectedSeq);
+        REQUIRE(header.mUncompressedSize == xdr::xdr_size(lcm));
+        if (compression > 0)
+        {
+            REQUIRE(header.mFlags == META_FRAME_ZLIB);
+            REQUIRE(header.mPayloadSize < header.mUncompressedSize);
+        }
+        else
+        {
+            REQUIRE(header.mFlags == 0);
+            REQUIRE(header.mPayloadSize == header.mUncompressedSize);
+        }
+        ++expectedSeq;
+    }
+    REQUIRE(expectedSeq == lastSeq + 1);
+
+    SECTION("corrupted frame is rejected")
+    {
+        std::ifstream whole(metaPath, std::ios::binary);
+        std::string bytes(std::istreambuf_iterator<char>{whole}, {});
+        REQUIRE(bytes.size() > META_FRAME_HEADER_SIZE);
+        bytes[bytes.size() / 2] ^= 0x5a;
+        std::istringstream corrupted(bytes);
+        auto readAll = [&]() {
+            while (readMetaFrame(corrupted, header, lcm))
+            {
+            }
+        };
+        REQUIRE_THROWS(readAll());
+    }
+}
+
 TEST_CASE_VERSIONS("meta stream contains reasonable meta", "[ledgerclosemeta]")
 {
     auto test = [&](Config cfg, bool isSoroban) {
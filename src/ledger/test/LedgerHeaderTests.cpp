@@ -4,14 +4,19 @@
 
 #include "util/asio.h"
 #include "crypto/Hex.h"
+#include "crypto/SHA.h"
 #include "herder/Herder.h"
 #include "herder/LedgerCloseData.h"
+#include "database/Database.h"
+#include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/RecentLedgerHeaders.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "test/TestUtils.h"
+#include "test/TxTests.h"
 #include "test/test.h"
 #include "transactions/TransactionUtils.h"
 #include "util/Logging.h"
@@ -117,3 +122,53 @@ TEST_CASE_VERSIONS("base reserve", "[ledger]")
                 expectedReserve);
     });
 }
+
+TEST_CASE("recent ledger headers", "[ledger]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& lm = app->getLedgerManager();
+    auto& db = app->getDatabase();
+    auto const& recent = lm.getRecentLedgerHeaders();
+
+    for (int i = 0; i < 5; ++i)
+    {
+        txtest::closeLedger(*app);
+    }
+    auto lcl = lm.getLastClosedLedgerHeader();
+    auto first = lcl.header.ledgerSeq - 4;
+
+    SECTION("match the headers stored")
+    {
+        for (auto seq = first; seq <= lcl.header.ledgerSeq; ++seq)
+        {
+            auto lhe = recent.get(seq);
+            REQUIRE(lhe);
+            auto stored = LedgerHeaderUtils::loadBySequence(
+                db, db.getSession(), seq);
+            REQUIRE(stored);
+            REQUIRE(lhe->header == *stored);
+            REQUIRE(lhe->hash == xdrSha256(*stored));
+            auto loaded = LedgerHeaderUtils::loadBySequence(
+                db, db.getSession(), seq, &recent);
+            REQUIRE(loaded);
+            REQUIRE(*loaded == *stored);
+        }
+        REQUIRE(recent.get(lcl.header.ledgerSeq)->hash == lcl.hash);
+        REQUIRE(!recent.get(lcl.header.ledgerSeq + 1));
+
+        auto range = recent.getRange(first, lcl.header.ledgerSeq + 1);
+        REQUIRE(range);
+        REQUIRE(range->size() == 5);
+        REQUIRE(range->back() == lcl);
+        REQUIRE(!recent.getRange(first, lcl.header.ledgerSeq + 2));
+    }
+
+    SECTION("drop the headers deleted")
+    {
+        lm.deleteNewerEntries(db, lcl.header.ledgerSeq - 1);
+        REQUIRE(recent.get(lcl.header.ledgerSeq - 2));
+        REQUIRE(!recent.get(lcl.header.ledgerSeq - 1));
+        REQUIRE(!recent.get(lcl.header.ledgerSeq));
+    }
+}
@@ -2,13 +2,29 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/SecretKey.h"
+#include "crypto/StrKey.h"
 #include "herder/Herder.h"
+#include "herder/TxSetFrame.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
+#include "ledger/OperationApplyMetrics.h"
+#include "ledger/SorobanContractUsage.h"
 #include "main/Application.h"
+#include "main/PersistentState.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
 #include "test/test.h"
+#include "transactions/TransactionSQL.h"
 
+#include "lib/json/json.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
 #include <lib/catch.hpp>
+#include <chrono>
+#include <thread>
 
 using namespace stellar;
 
@@ -45,3 +61,315 @@ TEST_CASE("cannot close ledger with unsupported ledger version", "[ledger]")
     }
     REQUIRE_THROWS_AS(applyEmptyLedger(), std::runtime_error);
 }
+
+TEST_CASE("prepared ledger closes with cached signatures", "[ledger]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig(0));
+    auto& lm = app->getLedgerManager();
+
+    auto root = TestAccount::createRoot(*app);
+    auto const minBalance = lm.getLastMinBalance(0);
+    auto a1 = root.create("a1", minBalance * 10);
+    auto a2 = root.create("a2", minBalance * 10);
+
+    auto tx = a1.tx({txtest::payment(a2, 100)});
+    auto txSet = makeTxSetFromTransactions({tx}, *app, 0, 0).first;
+    auto const& lcl = lm.getLastClosedLedgerHeader();
+    StellarValue sv = app->getHerder().makeStellarValue(
+        txSet->getContentsHash(), lcl.header.scpValue.closeTime + 1,
+        emptyUpgradeSteps, app->getConfig().NODE_SEED);
+    LedgerCloseData ledgerData(lcl.header.ledgerSeq + 1, txSet, sv);
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    lm.startPreparingLedger(ledgerData);
+
+    // Wait for the background verification of the signature
+    for (int i = 0; i < 100 && misses == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    }
+    REQUIRE(misses == 1);
+
+    auto balance = a2.getBalance();
+    lm.closeLedger(ledgerData);
+    PubKeyUtils::flushVerifySigCacheCounts(hits, misses);
+    REQUIRE(hits > 0);
+    REQUIRE(misses == 0);
+    REQUIRE(a2.getBalance() == balance + 100);
+
+    // Preparing a ledger that is already closed does nothing
+    lm.startPreparingLedger(ledgerData);
+}
+
+TEST_CASE("speculative prefetch loads entries before apply", "[ledger]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig(0));
+    cfg.EXPERIMENTAL_SPECULATIVE_PREFETCH = true;
+    auto app = createTestApplication(clock, cfg);
+    auto& lm = app->getLedgerManager();
+
+    auto root = TestAccount::createRoot(*app);
+    auto const minBalance = lm.getLastMinBalance(0);
+    auto a1 = root.create("a1", minBalance * 10);
+    auto a2 = root.create("a2", minBalance * 10);
+
+    auto tx = a1.tx({txtest::payment(a2, 100)});
+    auto txSets = makeTxSetFromTransactions({tx}, *app, 0, 0);
+
+    auto& applyLoad = app->getMetrics().NewMeter(
+        {"ledger", "prefetch", "apply-load"}, "entry");
+    auto& applyCached = app->getMetrics().NewMeter(
+        {"ledger", "prefetch", "apply-cached"}, "entry");
+    auto loadsBefore = applyLoad.count();
+    auto cachedBefore = applyCached.count();
+
+    lm.startSpeculativePrefetch(*txSets.second);
+    txtest::closeLedger(*app, txSets.first);
+
+    // Everything apply asked for was already in the cache
+    REQUIRE(applyLoad.count() == loadsBefore);
+    REQUIRE(applyCached.count() > cachedBefore);
+    REQUIRE(a2.getBalance() == minBalance * 10 + 100);
+}
+
+TEST_CASE("ledger results don't depend on building meta", "[ledger]")
+{
+    auto run = [](Config const& cfg) {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+        auto& lm = app->getLedgerManager();
+
+        auto root = TestAccount::createRoot(*app);
+        auto const minBalance = lm.getLastMinBalance(0);
+        auto a1 = root.create("a1", minBalance * 10);
+        auto a2 = root.create("a2", minBalance * 10);
+        txtest::closeLedger(*app, {a1.tx({txtest::payment(a2, 100)}),
+                                   a2.tx({txtest::payment(root, 1)})});
+
+        auto const& header = lm.getLastClosedLedgerHeader().header;
+        return std::make_pair(header.txSetResultHash, header.bucketListHash);
+    };
+
+    auto withMeta = run(getTestConfig(0));
+
+    // No meta stream, no debug meta and no txhistory table
+    Config cfg(getTestConfig(1));
+    cfg.METADATA_OUTPUT_STREAM = "";
+    cfg.METADATA_DEBUG_LEDGERS = 0;
+    cfg.MODE_STORES_HISTORY_MISC = false;
+    REQUIRE(run(cfg) == withMeta);
+}
+
+TEST_CASE("transaction history written in the background", "[ledger]")
+{
+    auto run = [](bool background) {
+        VirtualClock clock;
+        Config cfg(getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE));
+        cfg.BACKGROUND_TX_HISTORY_WRITES = background;
+        auto app = createTestApplication(clock, cfg);
+        auto& lm = app->getLedgerManager();
+
+        auto root = TestAccount::createRoot(*app);
+        auto const minBalance = lm.getLastMinBalance(0);
+        auto a1 = root.create("a1", minBalance * 10);
+        auto a2 = root.create("a2", minBalance * 10);
+        txtest::closeLedger(*app, {a1.tx({txtest::payment(a2, 100)}),
+                                   a2.tx({txtest::payment(root, 1)})});
+        auto ledgerSeq = lm.getLastClosedLedgerNum();
+
+        while (!lm.isTransactionHistoryWritten(ledgerSeq))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        auto& ps = app->getPersistentState();
+        REQUIRE(ps.getState(PersistentState::kTxHistoryWritten) ==
+                (background ? std::to_string(ledgerSeq) : ""));
+        auto results =
+            getTransactionHistoryResults(app->getDatabase(), ledgerSeq);
+        REQUIRE(results.results.size() == 2);
+        return std::make_pair(
+            results, getTransactionFeeMeta(app->getDatabase(), ledgerSeq));
+    };
+
+    REQUIRE(run(true) == run(false));
+}
+
+TEST_CASE("operation apply time is split by operation type", "[ledger]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig(0));
+    auto& lm = app->getLedgerManager();
+
+    auto root = TestAccount::createRoot(*app);
+    auto const minBalance = lm.getLastMinBalance(1);
+    auto a1 = root.create("a1", minBalance * 10);
+    auto a2 = root.create("a2", minBalance * 10);
+
+    auto& payments =
+        app->getMetrics().NewTimer({"ledger", "operation-payment", "apply"});
+    auto& paymentCommits =
+        app->getMetrics().NewTimer({"ledger", "operation-payment", "commit"});
+    auto& paymentFailures = app->getMetrics().NewMeter(
+        {"ledger", "operation-payment", "failure"}, "operation");
+    auto& bumps = app->getMetrics().NewTimer(
+        {"ledger", "operation-bump-sequence", "apply"});
+    auto paymentsBefore = payments.count();
+    auto paymentCommitsBefore = paymentCommits.count();
+    auto failuresBefore = paymentFailures.count();
+    auto bumpsBefore = bumps.count();
+
+    // The second payment is underfunded
+    std::vector<TransactionFrameBasePtr> txs = {
+        a1.tx({txtest::payment(a2, 100),
+               txtest::bumpSequence(a1.getLastSequenceNumber() + 10)}),
+        a2.tx({txtest::payment(a1, minBalance * 100)})};
+    auto r = txtest::closeLedger(*app, txs);
+    REQUIRE(r.size() == txs.size());
+
+    REQUIRE(payments.count() == paymentsBefore + 2);
+    REQUIRE(paymentCommits.count() == paymentCommitsBefore + 2);
+    REQUIRE(paymentFailures.count() == failuresBefore + 1);
+    REQUIRE(bumps.count() == bumpsBefore + 1);
+
+    auto breakdown = lm.getOperationApplyMetrics().getLedgerBreakdown();
+    REQUIRE(breakdown.find("PAYMENT: 2 ops") != std::string::npos);
+    REQUIRE(breakdown.find("BUMP_SEQUENCE: 1 ops") != std::string::npos);
+    REQUIRE(breakdown.find("CREATE_ACCOUNT") == std::string::npos);
+}
+
+TEST_CASE("soroban contract usage keeps the top contracts per window",
+          "[ledger][soroban]")
+{
+    auto contract = [](uint8_t i) {
+        Hash h;
+        h[0] = i;
+        return h;
+    };
+    auto strKeyOf = [](Hash const& h) {
+        return strKey::toStrKey(strKey::STRKEY_CONTRACT, h).value;
+    };
+    auto invocation = [](uint64_t nsecs, bool success = true) {
+        SorobanInvocationUsage u;
+        u.mCpuInsn = nsecs * 10;
+        u.mInvokeTimeNsecs = nsecs;
+        u.mSuccess = success;
+        return u;
+    };
+    auto a = contract(1);
+    auto b = contract(2);
+    auto c = contract(3);
+
+    SECTION("disabled")
+    {
+        SorobanContractUsage usage(0);
+        REQUIRE(!usage.isEnabled());
+        usage.record(64, a, "f", invocation(10));
+        REQUIRE(!usage.getJsonInfo().isMember("current"));
+    }
+
+    SECTION("ranked by invoke time")
+    {
+        SorobanContractUsage usage(2);
+        usage.record(64, a, "f", invocation(10));
+        usage.record(64, a, "g", invocation(40, false));
+        usage.record(65, b, "f", invocation(30));
+        usage.record(65, c, "f", invocation(5));
+
+        auto info = usage.getJsonInfo();
+        REQUIRE(!info.isMember("previous"));
+        auto const& current = info["current"];
+        REQUIRE(current["first_ledger"].asUInt() == 64);
+        REQUIRE(current["last_ledger"].asUInt() == 65);
+        REQUIRE(current["invocations"].asUInt64() == 4);
+
+        auto const& contracts = current["contracts"];
+        REQUIRE(contracts.size() == 2);
+        REQUIRE(contracts[0]["contract"].asString() == strKeyOf(a));
+        REQUIRE(contracts[0]["invocations"].asUInt64() == 2);
+        REQUIRE(contracts[0]["failures"].asUInt64() == 1);
+        REQUIRE(contracts[0]["cpu_insns"].asUInt64() == 500);
+        REQUIRE(contracts[0]["invoke_time_nsecs"].asUInt64() == 50);
+        REQUIRE(contracts[1]["contract"].asString() == strKeyOf(b));
+
+        auto const& functions = current["functions"];
+        REQUIRE(functions.size() == 2);
+        REQUIRE(functions[0]["contract"].asString() == strKeyOf(a));
+        REQUIRE(functions[0]["function"].asString() == "g");
+        REQUIRE(functions[1]["contract"].asString() == strKeyOf(b));
+        REQUIRE(functions[1]["function"].asString() == "f");
+    }
+
+    SECTION("windows roll over")
+    {
+        SorobanContractUsage usage(2);
+        usage.record(64, a, "f", invocation(10));
+        usage.record(128, b, "f", invocation(20));
+        auto info = usage.getJsonInfo();
+        REQUIRE(info["previous"]["first_ledger"].asUInt() == 64);
+        REQUIRE(info["previous"]["contracts"][0]["contract"].asString() ==
+                strKeyOf(a));
+        REQUIRE(info["current"]["first_ledger"].asUInt() == 128);
+        REQUIRE(info["current"]["contracts"].size() == 1);
+
+        usage.record(300, c, "f", invocation(30));
+        info = usage.getJsonInfo();
+        REQUIRE(info["previous"]["first_ledger"].asUInt() == 128);
+        REQUIRE(info["current"]["first_ledger"].asUInt() == 300);
+    }
+
+    SECTION("bounded")
+    {
+        SorobanContractUsage usage(1);
+        auto capacity = SorobanContractUsage::CAPACITY_FACTOR;
+        for (size_t i = 0; i <= capacity; ++i)
+        {
+            usage.record(64, contract(static_cast<uint8_t>(i + 1)), "f",
+                         invocation(100 + i));
+        }
+
+        // The last contract replaced the first, which used the least time,
+        // and ranks first with the time it inherited
+        auto info = usage.getJsonInfo();
+        auto const& contracts = info["current"]["contracts"];
+        REQUIRE(contracts.size() == 1);
+        REQUIRE(contracts[0]["contract"].asString() ==
+                strKeyOf(contract(static_cast<uint8_t>(capacity + 1))));
+        REQUIRE(contracts[0]["invocations"].asUInt64() == 1);
+        REQUIRE(contracts[0]["invoke_time_nsecs"].asUInt64() ==
+                100 + capacity);
+        REQUIRE(contracts[0]["max_overcount_nsecs"].asUInt64() == 100);
+    }
+}
+
+TEST_CASE("soroban network config snapshot is kept until the config changes",
+          "[ledger][soroban]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& lm = app->getLedgerManager();
+
+    auto snapshot = lm.getSorobanNetworkConfigSnapshot();
+    auto const maxTxCount = snapshot->ledgerMaxTxCount();
+    REQUIRE(maxTxCount == lm.getSorobanNetworkConfig().ledgerMaxTxCount());
+
+    // Ledgers without upgrades don't reload the config
+    txtest::closeLedger(*app);
+    txtest::closeLedger(*app);
+    REQUIRE(lm.getSorobanNetworkConfigSnapshot() == snapshot);
+
+    auto upgrade = LedgerUpgrade{LEDGER_UPGRADE_MAX_SOROBAN_TX_SET_SIZE};
+    upgrade.newMaxSorobanTxSetSize() = maxTxCount + 1;
+    txtest::executeUpgrade(*app, upgrade);
+
+    auto newSnapshot = lm.getSorobanNetworkConfigSnapshot();
+    REQUIRE(newSnapshot != snapshot);
+    REQUIRE(newSnapshot->ledgerMaxTxCount() == maxTxCount + 1);
+    REQUIRE(lm.getSorobanNetworkConfig().ledgerMaxTxCount() == maxTxCount + 1);
+    // Holders of the old snapshot still see the old config
+    REQUIRE(snapshot->ledgerMaxTxCount() == maxTxCount);
+}
@@ -5,16 +5,19 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/LedgerTypeUtils.h"
 #include "ledger/NonSociRelatedException.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "test/MicroBenchmark.h"
 #include "test/TestAccount.h"
 #include "test/TestUtils.h"
 #include "test/TxTests.h"
 #include "test/test.h"
 #include "transactions/TransactionUtils.h"
+#include "util/Arena.h"
 #include "util/Math.h"
 #include "util/XDROperators.h"
 #include <algorithm>
@@ -234,6 +237,42 @@ TEST_CASE("LedgerTxn commit into LedgerTxn", "[ledgertxn]")
     }
 }
 
+TEST_CASE("LedgerTxn allocates entries from an arena", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+
+    auto entries = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {ACCOUNT, TRUSTLINE, DATA}, 10);
+
+    auto before = Arena::getTotalStats();
+    std::shared_ptr<InternalLedgerEntry const> retained;
+    {
+        LedgerTxn ltx1(app->getLedgerTxnRoot());
+        {
+            LedgerTxn ltx2(ltx1);
+            for (auto const& le : entries)
+            {
+                REQUIRE(ltx2.create(le));
+            }
+            ltx2.commit();
+        }
+        retained = ltx1.getNewestVersion(LedgerEntryKey(entries.front()));
+        REQUIRE(retained);
+        ltx1.commit();
+    }
+
+    // The arena is kept alive by the retained entry
+    REQUIRE(Arena::getTotalStats().allocations == before.allocations);
+    REQUIRE(retained->ledgerEntry() == entries.front());
+
+    retained.reset();
+    auto after = Arena::getTotalStats();
+    // At least one allocation for each entry and each key in each LedgerTxn
+    REQUIRE(after.allocations >= before.allocations + 2 * entries.size());
+    REQUIRE(after.blocks > before.blocks);
+}
+
 TEST_CASE("LedgerTxn rollback into LedgerTxn", "[ledgertxn]")
 {
     auto runTest = [&](Config::TestDbMode mode) {
@@ -2662,6 +2701,33 @@ TEST_CASE("LedgerTxnRoot prefetch", "[ledgertxn]")
             REQUIRE(root.prefetch(keysToPrefetch) == keysToPrefetch.size());
             ltx2.commit();
         }
+        SECTION("prefetch entries already loaded")
+        {
+            LedgerTxn ltx2(root);
+            UnorderedMap<LedgerKey, std::shared_ptr<LedgerEntry const>> loaded;
+            for (auto const& e : entrySet)
+            {
+                loaded.emplace(LedgerEntryKey(e),
+                               std::make_shared<LedgerEntry const>(e));
+                if (loaded.size() > (cfg.ENTRY_CACHE_SIZE / 3))
+                {
+                    break;
+                }
+            }
+
+            REQUIRE(root.prefetchLoaded(loaded) == loaded.size());
+            // Keys already cached keep their entry
+            REQUIRE(root.prefetchLoaded(loaded) == 0);
+
+            for (auto const& [k, e] : loaded)
+            {
+                auto txle = ltx2.load(k);
+                REQUIRE(txle);
+                REQUIRE(txle.current() == *e);
+            }
+            REQUIRE(fabs(ltx2.getPrefetchHitRate() - 1.0f) < 0.0001f);
+            ltx2.commit();
+        }
     };
 
     SECTION("default")
@@ -3190,6 +3256,79 @@ TEST_CASE("Load best offers benchmark", "[!hide][bestoffersbench]")
     }
 }
 
+TEST_CASE("LedgerTxn microbench", "[ledgertxn][microbench][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    size_t const batch = 100;
+
+    auto stored =
+        LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes({ACCOUNT},
+                                                                   10 * batch);
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto const& e : stored)
+        {
+            ltx.createWithoutLoading(e);
+        }
+        ltx.commit();
+    }
+    auto fresh =
+        LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes({ACCOUNT},
+                                                                   batch);
+
+    // Everything is rolled back, so every run sees the same ledger
+    size_t next = 0;
+    runMicroBenchmark("ledgertxn.load", [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (size_t i = 0; i < batch; ++i)
+        {
+            auto const& e = stored[next++ % stored.size()];
+            if (!ltx.load(LedgerEntryKey(e)))
+            {
+                throw std::runtime_error("missing entry");
+            }
+        }
+        return batch;
+    });
+    runMicroBenchmark("ledgertxn.create", [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto const& e : fresh)
+        {
+            ltx.create(e);
+        }
+        return batch;
+    });
+
+    // Entries are updated by the innermost LedgerTxn, and committed into each
+    // of its parents in turn, up to the outermost one
+    for (size_t depth : {1, 4, 16})
+    {
+        auto name = fmt::format(FMT_STRING("ledgertxn.commit-depth-{}"), depth);
+        runMicroBenchmark(name, [&]() {
+            std::vector<std::unique_ptr<LedgerTxn>> ltxs;
+            ltxs.emplace_back(
+                std::make_unique<LedgerTxn>(app->getLedgerTxnRoot()));
+            for (size_t d = 0; d < depth; ++d)
+            {
+                ltxs.emplace_back(std::make_unique<LedgerTxn>(*ltxs.back()));
+            }
+            for (size_t i = 0; i < batch; ++i)
+            {
+                auto const& e = stored[next++ % stored.size()];
+                auto entry = ltxs.back()->load(LedgerEntryKey(e));
+                entry.current().data.account().balance += 1;
+            }
+            while (ltxs.size() > 1)
+            {
+                ltxs.back()->commit();
+                ltxs.pop_back();
+            }
+            return batch;
+        });
+    }
+}
+
 typedef UnorderedMap<AssetPair, std::vector<LedgerEntry>, AssetPairHash>
     OrderBook;
 typedef UnorderedMap<
@@ -3646,6 +3785,61 @@ TEST_CASE_VERSIONS("LedgerTxn bulk-load offers", "[ledgertxn]")
 #endif
 }
 
+#ifdef USE_POSTGRES
+TEST_CASE("LedgerTxnRoot upserts offers with COPY", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0, Config::TESTDB_POSTGRESQL);
+    cfg.POSTGRES_COPY_UPSERT_ENTRY_TYPES = {OFFER};
+    auto app = createTestApplication(clock, cfg);
+
+    std::vector<LedgerEntry> offers(10);
+    for (size_t i = 0; i < offers.size(); ++i)
+    {
+        offers[i].data.type(OFFER);
+        offers[i].data.offer() = LedgerTestUtils::generateValidOfferEntry();
+        offers[i].data.offer().offerID = static_cast<int64_t>(i) + 1;
+    }
+
+    auto checkOffers = [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto const& le : offers)
+        {
+            auto ltxe = ltx.loadWithoutRecord(LedgerEntryKey(le));
+            REQUIRE(ltxe);
+            REQUIRE(ltxe.current().data == le.data);
+        }
+    };
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto const& le : offers)
+        {
+            ltx.create(le);
+        }
+        ltx.commit();
+    }
+    checkOffers();
+
+    // Updates go through the conflict clause, and reuse the temporary table
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        for (auto& le : offers)
+        {
+            auto& oe = le.data.offer();
+            oe.amount = oe.amount / 2 + 1;
+            oe.price = Price{3, 7};
+            ltx.load(LedgerEntryKey(le)).current() = le;
+        }
+        ltx.commit();
+    }
+    checkOffers();
+
+    auto& timer = app->getMetrics().NewTimer({"database", "copy", "offer"});
+    REQUIRE(timer.count() == 2);
+}
+#endif
+
 TEST_CASE("Access deactivated entry", "[ledgertxn]")
 {
     auto runTest = [&](Config::TestDbMode mode) {
@@ -3888,6 +4082,442 @@ TEST_CASE("LedgerTxn best offers cache eviction", "[ledgertxn]")
     }
 }
 
+TEST_CASE("LedgerTxnRoot entry cache", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    SECTION("random eviction")
+    {
+        cfg.ENTRY_CACHE_SIZE_MB = 0;
+    }
+    SECTION("tinylfu")
+    {
+        cfg.ENTRY_CACHE_SIZE_MB = 1;
+    }
+    auto app = createTestApplication(clock, cfg);
+    // Offers are always stored in SQL, so they go through the entry cache
+    auto& hits = app->getMetrics().NewMeter(
+        {"ledger", "entry-cache-hit", "offer"}, "entry");
+    auto& misses = app->getMetrics().NewMeter(
+        {"ledger", "entry-cache-miss", "offer"}, "entry");
+
+    auto le = LedgerTestUtils::generateValidLedgerEntryOfType(OFFER);
+    auto key = LedgerEntryKey(le);
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        ltx.create(le);
+        ltx.commit();
+    }
+
+    auto hitsBefore = hits.count();
+    auto missesBefore = misses.count();
+    for (int i = 0; i < 3; ++i)
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        REQUIRE(ltx.load(key).current().data == le.data);
+    }
+    REQUIRE(misses.count() == missesBefore + 1);
+    REQUIRE(hits.count() == hitsBefore + 2);
+}
+
+TEST_CASE("LedgerTxn memory usage", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    SECTION("random eviction")
+    {
+        cfg.ENTRY_CACHE_SIZE_MB = 0;
+    }
+    SECTION("tinylfu")
+    {
+        cfg.ENTRY_CACHE_SIZE_MB = 1;
+    }
+    auto app = createTestApplication(clock, cfg);
+    auto& root = app->getLedgerTxnRoot();
+
+    auto offers =
+        LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes({OFFER}, 5);
+    {
+        LedgerTxn ltx(root);
+        REQUIRE(ltx.getMemoryUsage().total() == 0);
+        for (auto const& le : offers)
+        {
+            ltx.create(le);
+        }
+        auto usage = ltx.getMemoryUsage();
+        REQUIRE(usage.entryBytes.size() == 1);
+        REQUIRE(usage.entryBytes.at(OFFER) >=
+                offers.size() * xdr::xdr_size(offers.front()));
+        REQUIRE(usage.total() == usage.entryBytes.at(OFFER));
+
+        // Each level only counts what it records itself
+        LedgerTxn child(ltx);
+        REQUIRE(child.getMemoryUsage().total() == 0);
+        child.erase(LedgerEntryKey(offers.front()));
+        auto childUsage = child.getMemoryUsage();
+        REQUIRE(childUsage.entryBytes.at(OFFER) > 0);
+        REQUIRE(childUsage.entryBytes.at(OFFER) <
+                usage.entryBytes.at(OFFER) / offers.size());
+        child.commit();
+        ltx.commit();
+    }
+
+    // Offers are stored in SQL, so loading them fills the entry cache
+    REQUIRE(root.getMemoryUsage().entryCacheBytes == 0);
+    LedgerTxn ltx(root);
+    for (auto const& le : offers)
+    {
+        ltx.load(LedgerEntryKey(le));
+    }
+    REQUIRE(root.getMemoryUsage().entryCacheBytes > 0);
+    REQUIRE(ltx.getMemoryUsage().entryBytes.at(OFFER) > 0);
+}
+
+TEST_CASE("LedgerTxnRoot shrinks caches over the soft limit", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    cfg.LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB = 1;
+    auto app = createTestApplication(clock, cfg);
+    auto& root = app->getLedgerTxnRoot();
+    auto& shrinks = app->getMetrics().NewMeter(
+        {"ledger", "memory", "cache-shrink"}, "shrink");
+
+    // Enough offers that their cache entries hold more than a megabyte
+    auto offers = LedgerTestUtils::generateValidUniqueLedgerEntriesWithTypes(
+        {OFFER}, 5000);
+    UnorderedSet<LedgerKey> keys;
+    {
+        LedgerTxn ltx(root);
+        for (auto const& le : offers)
+        {
+            ltx.create(le);
+            keys.emplace(LedgerEntryKey(le));
+        }
+        ltx.commit();
+    }
+
+    auto before = shrinks.count();
+    LedgerTxn ltx(root);
+    ltx.prefetch(keys);
+    REQUIRE(shrinks.count() == before + 1);
+    REQUIRE(root.getMemoryUsage().entryCacheBytes == 0);
+}
+
+TEST_CASE("LedgerTxn in-memory order book", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    cfg.IN_MEMORY_ORDER_BOOK = true;
+    auto app = createTestApplication(clock, cfg);
+
+    auto a = autocheck::generator<Asset>()(UINT32_MAX);
+    auto b = autocheck::generator<Asset>()(UINT32_MAX);
+    while (a == b)
+    {
+        b = autocheck::generator<Asset>()(UINT32_MAX);
+    }
+
+    auto makeOffer = [&](int64_t offerID, Price const& price,
+                         Asset const& buying, Asset const& selling) {
+        LedgerEntry le;
+        le.data.type(OFFER);
+        auto& oe = le.data.offer();
+        oe.offerID = offerID;
+        oe.price = price;
+        oe.buying = buying;
+        oe.selling = selling;
+        return le;
+    };
+
+    // Returns the offer ids for the asset pair, best first, by repeatedly
+    // loading and erasing the best offer in a nested LedgerTxn
+    auto bestOfferIDs = [&](Asset const& buying, Asset const& selling) {
+        std::vector<int64_t> ids;
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        while (auto ltxe = ltx.loadBestOffer(buying, selling))
+        {
+            ids.emplace_back(ltxe.current().data.offer().offerID);
+            ltxe.erase();
+        }
+        return ids;
+    };
+
+    {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        ltx.create(makeOffer(1, Price{2, 1}, a, b));
+        ltx.create(makeOffer(2, Price{1, 1}, a, b));
+        ltx.create(makeOffer(3, Price{3, 1}, a, b));
+        ltx.create(makeOffer(4, Price{1, 1}, b, a));
+        ltx.commit();
+    }
+
+    // The first query loads the entire order book
+    REQUIRE(bestOfferIDs(a, b) == std::vector<int64_t>{2, 1, 3});
+    REQUIRE(bestOfferIDs(b, a) == std::vector<int64_t>{4});
+
+    SECTION("commits update the order book")
+    {
+        {
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            // Erase the best offer
+            ltx.load(LedgerEntryKey(makeOffer(2, {}, a, b))).erase();
+            // Make the worst offer the best
+            ltx.load(LedgerEntryKey(makeOffer(3, {}, a, b)))
+                .current()
+                .data.offer()
+                .price = Price{1, 2};
+            // Move an offer to the other asset pair
+            auto ltxe = ltx.load(LedgerEntryKey(makeOffer(1, {}, a, b)));
+            std::swap(ltxe.current().data.offer().buying,
+                      ltxe.current().data.offer().selling);
+            // Create an offer in a new asset pair
+            ltx.create(makeOffer(5, Price{1, 1}, a, a));
+            ltx.commit();
+        }
+
+        REQUIRE(bestOfferIDs(a, b) == std::vector<int64_t>{3});
+        REQUIRE(bestOfferIDs(b, a) == std::vector<int64_t>{4, 1});
+        REQUIRE(bestOfferIDs(a, a) == std::vector<int64_t>{5});
+    }
+
+    SECTION("rollback leaves the order book unchanged")
+    {
+        {
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            ltx.load(LedgerEntryKey(makeOffer(2, {}, a, b))).erase();
+            ltx.create(makeOffer(5, Price{1, 2}, a, b));
+        }
+
+        REQUIRE(bestOfferIDs(a, b) == std::vector<int64_t>{2, 1, 3});
+    }
+}
+
+TEST_CASE("LedgerTxn in-memory contract code and TTL", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.IN_MEMORY_CONTRACT_CODE_AND_TTL = true;
+    auto app = createTestApplication(clock, cfg);
+    auto& root = static_cast<LedgerTxnRoot&>(app->getLedgerTxnRoot());
+
+    auto code = LedgerTestUtils::generateValidLedgerEntryOfType(CONTRACT_CODE);
+    LedgerEntry ttl;
+    ttl.data.type(TTL);
+    ttl.data.ttl().keyHash = getTTLKey(code).ttl().keyHash;
+    ttl.data.ttl().liveUntilLedgerSeq = 100;
+
+    auto loadData = [&](LedgerEntry const& le) -> std::optional<LedgerEntry> {
+        LedgerTxn ltx(root);
+        auto ltxe = ltx.loadWithoutRecord(LedgerEntryKey(le));
+        if (ltxe)
+        {
+            return ltxe.current();
+        }
+        return std::nullopt;
+    };
+
+    // The first lookup loads the (empty) set of entries of the BucketList
+    REQUIRE(!loadData(code));
+    REQUIRE(root.getMemoryUsage().contractCodeAndTTLBytes == 0);
+
+    {
+        LedgerTxn ltx(root);
+        ltx.create(code);
+        ltx.create(ttl);
+        ltx.commit();
+    }
+
+    // Committing to LedgerTxnRoot doesn't add entries to the BucketList, so
+    // these can only be found in memory
+    REQUIRE(loadData(code)->data == code.data);
+    REQUIRE(loadData(ttl)->data == ttl.data);
+    REQUIRE(root.getMemoryUsage().contractCodeAndTTLBytes >=
+            xdr::xdr_size(code) + xdr::xdr_size(ttl));
+
+    SECTION("commits update the entries")
+    {
+        {
+            LedgerTxn ltx(root);
+            ltx.load(LedgerEntryKey(ttl))
+                .current()
+                .data.ttl()
+                .liveUntilLedgerSeq = 200;
+            ltx.erase(LedgerEntryKey(code));
+            ltx.commit();
+        }
+
+        REQUIRE(!loadData(code));
+        REQUIRE(loadData(ttl)->data.ttl().liveUntilLedgerSeq == 200);
+        REQUIRE(root.getMemoryUsage().contractCodeAndTTLBytes <
+                xdr::xdr_size(code));
+    }
+
+    SECTION("rollback leaves the entries unchanged")
+    {
+        {
+            LedgerTxn ltx(root);
+            ltx.erase(LedgerEntryKey(code));
+        }
+
+        REQUIRE(loadData(code)->data == code.data);
+    }
+
+    SECTION("clearing reloads the entries from the BucketList")
+    {
+        root.clearInMemoryEntries();
+        REQUIRE(root.getMemoryUsage().contractCodeAndTTLBytes == 0);
+        REQUIRE(!loadData(code));
+        REQUIRE(!loadData(ttl));
+    }
+}
+
+TEST_CASE("LedgerTxn in-memory liquidity pools", "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    cfg.IN_MEMORY_LIQUIDITY_POOLS = true;
+    auto app = createTestApplication(clock, cfg);
+    auto& root = static_cast<LedgerTxnRoot&>(app->getLedgerTxnRoot());
+
+    auto pool = LedgerTestUtils::generateValidLedgerEntryOfType(LIQUIDITY_POOL);
+    auto key = LedgerEntryKey(pool);
+    auto reserveA = [&]() -> std::optional<int64_t> {
+        LedgerTxn ltx(root);
+        auto ltxe = ltx.loadWithoutRecord(key);
+        if (ltxe)
+        {
+            return ltxe.current()
+                .data.liquidityPool()
+                .body.constantProduct()
+                .reserveA;
+        }
+        return std::nullopt;
+    };
+
+    REQUIRE(!reserveA());
+    {
+        LedgerTxn ltx(root);
+        ltx.create(pool);
+        ltx.commit();
+    }
+    REQUIRE(reserveA() ==
+            pool.data.liquidityPool().body.constantProduct().reserveA);
+    REQUIRE(root.getMemoryUsage().liquidityPoolsBytes >= xdr::xdr_size(pool));
+
+    {
+        LedgerTxn ltx(root);
+        ltx.load(key)
+            .current()
+            .data.liquidityPool()
+            .body.constantProduct()
+            .reserveA = 42;
+        ltx.commit();
+    }
+    REQUIRE(reserveA() == 42);
+
+    // Not being in the BucketList, the pool is gone once reloaded from it
+    root.clearInMemoryEntries();
+    REQUIRE(!reserveA());
+}
+
+TEST_CASE("LedgerTxn commit moves entries into a LedgerTxn parent",
+          "[ledgertxn]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig(0));
+
+    auto a = autocheck::generator<Asset>()(UINT32_MAX);
+    auto b = autocheck::generator<Asset>()(UINT32_MAX);
+    while (a == b)
+    {
+        b = autocheck::generator<Asset>()(UINT32_MAX);
+    }
+
+    auto makeOffer = [&](int64_t offerID, Price const& price,
+                         Asset const& buying, Asset const& selling) {
+        LedgerEntry le;
+        le.data.type(OFFER);
+        auto& oe = le.data.offer();
+        oe.offerID = offerID;
+        oe.price = price;
+        oe.buying = buying;
+        oe.selling = selling;
+        return le;
+    };
+    auto offerKey = [&](int64_t offerID) {
+        return LedgerEntryKey(makeOffer(offerID, {}, a, b));
+    };
+
+    // Returns the offer ids for the asset pair in ltx, best first
+    auto bestOfferIDs = [&](AbstractLedgerTxn& ltx, Asset const& buying,
+                            Asset const& selling) {
+        std::vector<int64_t> ids;
+        LedgerTxn inner(ltx);
+        while (auto ltxe = inner.loadBestOffer(buying, selling))
+        {
+            ids.emplace_back(ltxe.current().data.offer().offerID);
+            ltxe.erase();
+        }
+        return ids;
+    };
+
+    LedgerTxn parent(app->getLedgerTxnRoot());
+
+    SECTION("empty parent")
+    {
+        {
+            LedgerTxn child(parent);
+            child.create(makeOffer(1, Price{2, 1}, a, b));
+            child.create(makeOffer(2, Price{1, 1}, a, b));
+            // Still active when the child commits
+            auto ltxe = child.create(makeOffer(3, Price{1, 2}, a, b));
+            child.commit();
+        }
+
+        REQUIRE(bestOfferIDs(parent, a, b) == std::vector<int64_t>{3, 2, 1});
+        REQUIRE(parent.getAllOffers().size() == 3);
+    }
+
+    SECTION("parent with recorded entries")
+    {
+        parent.create(makeOffer(1, Price{2, 1}, a, b));
+        parent.create(makeOffer(2, Price{1, 1}, a, b));
+        parent.create(makeOffer(3, Price{1, 1}, b, a));
+
+        {
+            LedgerTxn child(parent);
+            // Annihilates the init entry in the parent
+            child.load(offerKey(2)).erase();
+            child.erase(LedgerEntryKey(makeOffer(3, {}, b, a)));
+            child.create(makeOffer(4, Price{3, 1}, a, b));
+            // Still active when the child commits
+            auto ltxe = child.load(offerKey(1));
+            ltxe.current().data.offer().price = Price{1, 3};
+            child.commit();
+        }
+
+        REQUIRE(bestOfferIDs(parent, a, b) == std::vector<int64_t>{1, 4});
+        REQUIRE(bestOfferIDs(parent, b, a).empty());
+        REQUIRE(!parent.loadWithoutRecord(offerKey(2)));
+        REQUIRE(parent.getAllOffers().size() == 2);
+    }
+
+    SECTION("sealed child")
+    {
+        {
+            LedgerTxn child(parent);
+            child.create(makeOffer(1, Price{2, 1}, a, b));
+            REQUIRE(child.getDelta().entry.size() == 1);
+            child.commit();
+        }
+
+        REQUIRE(bestOfferIDs(parent, a, b) == std::vector<int64_t>{1});
+    }
+}
+
 typedef std::map<std::tuple<AccountID, Asset, Asset>, int64_t> PoolShareUpdates;
 typedef std::map<std::pair<Asset, Asset>, int64_t> LiquidityPoolUpdates;
 
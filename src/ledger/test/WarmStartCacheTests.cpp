@@ -0,0 +1,71 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/WarmStartCache.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/TransactionUtils.h"
+#include "util/Fs.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace stellar;
+
+namespace
+{
+bool
+isCached(Application& app, LedgerKey const& key)
+{
+    auto& root = dynamic_cast<LedgerTxnRoot&>(app.getLedgerTxnRoot());
+    auto keys = root.getCachedKeys(std::numeric_limits<size_t>::max());
+    return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+}
+
+TEST_CASE("warm start cache", "[ledger][warmstart]")
+{
+    Config cfg = getTestConfig(0, Config::TESTDB_ON_DISK_SQLITE);
+    bool const sameLedger = GENERATE(true, false);
+    CAPTURE(sameLedger);
+
+    LedgerKey key;
+    std::string filename;
+    {
+        VirtualClock clock;
+        auto app = createTestApplication(clock, cfg);
+        auto root = TestAccount::createRoot(*app);
+        auto& lm = app->getLedgerManager();
+        auto a1 = root.create("a1", lm.getLastMinBalance(0));
+        key = accountKey(a1.getPublicKey());
+        {
+            // Closing the ledger emptied the cache, load the account back
+            LedgerTxn ltx(app->getLedgerTxnRoot());
+            REQUIRE(ltx.load(key));
+        }
+        REQUIRE(isCached(*app, key));
+
+        filename = warmStartCacheFilename(*app);
+        saveWarmStartCache(*app);
+        REQUIRE(fs::exists(filename));
+        if (!sameLedger)
+        {
+            txtest::closeLedger(*app);
+        }
+    }
+
+    cfg.WARM_START_CACHE = true;
+    VirtualClock clock;
+    auto app = createTestApplication(clock, cfg, /*newDB=*/false);
+    // Only warmed up from a cache saved at the last closed ledger
+    REQUIRE(isCached(*app, key) == sameLedger);
+    REQUIRE(!fs::exists(filename));
+}
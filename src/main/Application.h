@@ -5,6 +5,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/Config.h"
+#include "util/BackgroundExecutor.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include "xdr/Stellar-types.h"
 #include <lib/json/json.h>
@@ -227,18 +228,36 @@ class Application
     // with caution.
     virtual asio::io_context& getWorkerIOContext() = 0;
     virtual asio::io_context& getEvictionIOContext() = 0;
+    virtual asio::io_context& getOverlayIOContext() = 0;
 
     virtual void postOnMainThread(
         std::function<void()>&& f, std::string&& name,
         Scheduler::ActionType type = Scheduler::ActionType::NORMAL_ACTION) = 0;
 
     // While both are lower priority than the main thread, eviction threads have
-    // more priority than regular worker background threads
-    virtual void postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName) = 0;
+    // more priority than regular worker background threads. Jobs are started
+    // by class, in the order of BackgroundTaskClass, and within the
+    // BACKGROUND_TASK_LIMITS of their class.
+    virtual void postOnBackgroundThread(
+        std::function<void()>&& f, std::string jobName,
+        BackgroundTaskClass cls = BackgroundTaskClass::GENERAL) = 0;
     virtual void postOnEvictionBackgroundThread(std::function<void()>&& f,
                                                 std::string jobName) = 0;
 
+    // Post to the dedicated overlay thread, only available when
+    // BACKGROUND_OVERLAY_DECODE is set. Jobs run one at a time in the order
+    // they were posted.
+    virtual void postOnOverlayThread(std::function<void()>&& f,
+                                     std::string jobName) = 0;
+
+    // Post a bucket merge. If BUCKET_MERGE_THREADS is set this runs on the
+    // dedicated merge threads, where queued merges are started in order of
+    // `deadlineLedger` (the ledger at which the merge output is needed);
+    // otherwise it behaves like postOnBackgroundThread.
+    virtual void postOnBucketMergeThread(std::function<void()>&& f,
+                                         std::string jobName,
+                                         uint32_t deadlineLedger) = 0;
+
     // Perform actions necessary to transition from BOOTING_STATE to other
     // states. In particular: either reload or reinitialize the database, and
     // either restart or begin reacquiring SCP consensus (as instructed by
@@ -15,7 +15,10 @@
 // else.
 #include "util/asio.h"
 #include "bucket/Bucket.h"
+#include "bucket/BucketIndexBudget.h"
+#include "bucket/BucketListEntryCache.h"
 #include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
 #include "catchup/ApplyBucketsWork.h"
 #include "crypto/Hex.h"
 #include "crypto/SHA.h"
@@ -39,10 +42,14 @@
 #include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
+#include "ledger/WarmStartCache.h"
 #include "main/ApplicationUtils.h"
 #include "main/CommandHandler.h"
 #include "main/ExternalQueue.h"
 #include "main/Maintainer.h"
+#include "main/MemoryBudget.h"
+#include "main/PrometheusServer.h"
+#include "main/QueryServer.h"
 #include "main/StellarCoreVersion.h"
 #include "medida/counter.h"
 #include "medida/meter.h"
@@ -55,12 +62,15 @@
 #include "process/ProcessManager.h"
 #include "scp/LocalNode.h"
 #include "scp/QuorumSetUtils.h"
+#include "util/DeadlineThreadPool.h"
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/MmapFile.h"
 #include "util/StatusManager.h"
 #include "util/Thread.h"
 #include "util/TmpDir.h"
+#include "util/ZoneProfiler.h"
 #include "work/BasicWork.h"
 #include "work/WorkScheduler.h"
 
@@ -68,7 +78,6 @@
 #include "simulation/LoadGenerator.h"
 #endif
 
-#include <Tracy.hpp>
 #include <fmt/format.h>
 #include <optional>
 #include <set>
@@ -89,13 +98,22 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     , mEvictionIOContext(mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN
                              ? std::make_unique<asio::io_context>(1)
                              : nullptr)
+    , mOverlayIOContext(mConfig.BACKGROUND_OVERLAY_DECODE
+                            ? std::make_unique<asio::io_context>(1)
+                            : nullptr)
     , mWork(std::make_unique<asio::io_context::work>(mWorkerIOContext))
     , mEvictionWork(
           mEvictionIOContext
               ? std::make_unique<asio::io_context::work>(*mEvictionIOContext)
               : nullptr)
+    , mOverlayWork(
+          mOverlayIOContext
+              ? std::make_unique<asio::io_context::work>(*mOverlayIOContext)
+              : nullptr)
     , mWorkerThreads()
     , mEvictionThread()
+    , mOverlayThread()
+    , mMergeThreadPool()
     , mStopSignals(clock.getIOContext(), SIGINT)
     , mStarted(false)
     , mStopping(false)
@@ -119,6 +137,16 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     std::srand(static_cast<uint32>(clock.now().time_since_epoch().count()));
 
     mNetworkID = sha256(mConfig.NETWORK_PASSPHRASE);
+    PubKeyUtils::setVerifySigCacheSize(mConfig.VERIFY_SIG_CACHE_SIZE);
+    setZoneProfilerSamplePeriod(mConfig.ZONE_PROFILER_SAMPLE_PERIOD);
+
+    if (!mConfig.SCHEDULER_LATENCY_SLOS.empty())
+    {
+        std::map<std::string, std::chrono::nanoseconds> slos(
+            mConfig.SCHEDULER_LATENCY_SLOS.begin(),
+            mConfig.SCHEDULER_LATENCY_SLOS.end());
+        clock.getActionScheduler().setLatencySLOs(std::move(slos));
+    }
 
     TracyAppInfo(STELLAR_CORE_VERSION.c_str(), STELLAR_CORE_VERSION.size());
     TracyAppInfo(mConfig.NETWORK_PASSPHRASE.c_str(),
@@ -148,6 +176,14 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
     auto t = mConfig.WORKER_THREADS;
     LOG_DEBUG(DEFAULT_LOG, "Application constructing (worker threads: {})", t);
 
+    if (mConfig.PROMETHEUS_HTTP_PORT &&
+        (mConfig.PROMETHEUS_HTTP_PORT == mConfig.HTTP_PORT ||
+         mConfig.PROMETHEUS_HTTP_PORT == mConfig.HTTP_QUERY_PORT))
+    {
+        throw std::invalid_argument("PROMETHEUS_HTTP_PORT must be different "
+                                    "from HTTP_PORT and HTTP_QUERY_PORT");
+    }
+
     if (mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN)
     {
         releaseAssert(mConfig.WORKER_THREADS > 0);
@@ -162,6 +198,26 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
         --t;
     }
 
+    if (mOverlayIOContext)
+    {
+        // Messages wait on this thread before the main thread gets them, so
+        // it shouldn't run behind low priority background work
+        mOverlayThread = std::thread{[this]() {
+            runCurrentThreadWithMediumPriority();
+            mOverlayIOContext->run();
+        }};
+    }
+
+    std::map<BackgroundTaskClass, size_t> limits;
+    for (auto const& [name, limit] : mConfig.BACKGROUND_TASK_LIMITS)
+    {
+        auto cls = backgroundTaskClassFromName(name);
+        releaseAssert(cls);
+        limits.emplace(*cls, limit);
+    }
+    mBackgroundExecutor = std::make_unique<BackgroundExecutor>(
+        mWorkerIOContext, std::max(t, 1), *mMetrics, limits);
+
     while (t--)
     {
         auto thread = std::thread{[this]() {
@@ -170,6 +226,14 @@ ApplicationImpl::ApplicationImpl(VirtualClock& clock, Config const& cfg)
         }};
         mWorkerThreads.emplace_back(std::move(thread));
     }
+
+    if (mConfig.BUCKET_MERGE_THREADS > 0)
+    {
+        LOG_DEBUG(DEFAULT_LOG, "Starting {} bucket merge threads",
+                  mConfig.BUCKET_MERGE_THREADS);
+        mMergeThreadPool = std::make_unique<DeadlineThreadPool>(
+            static_cast<size_t>(mConfig.BUCKET_MERGE_THREADS));
+    }
 }
 
 static void
@@ -306,10 +370,11 @@ ApplicationImpl::initialize(bool createNewDB, bool forceRebuild)
     mOverlayManager = createOverlayManager();
     mLedgerManager = createLedgerManager();
     mHerder = createHerder();
-    mHerderPersistence = HerderPersistence::create(*this);
     mCatchupManager = CatchupManager::create(*this);
     mHistoryArchiveManager = std::make_unique<HistoryArchiveManager>(*this);
     mHistoryManager = HistoryManager::create(*this);
+    // uses the checkpoint frequency
+    mHerderPersistence = HerderPersistence::create(*this);
     mInvariantManager = createInvariantManager();
     mMaintainer = std::make_unique<Maintainer>(*this);
     mWorkScheduler = WorkScheduler::create(*this);
@@ -513,6 +578,32 @@ ApplicationImpl::getJsonInfo(bool verbose)
 
     info["ledger"]["age"] = (int)lm.secondsSinceLastLedgerClose();
 
+    // Approximate bytes held while the last ledger was applied
+    auto const& memory = lm.getLastLedgerMemoryUsage();
+    auto& memoryInfo = info["ledger"]["memory"];
+    memoryInfo["ledger_txn"] = static_cast<Json::UInt64>(
+        memory.total() - memory.entryCacheBytes - memory.bestOffersBytes -
+        memory.contractCodeAndTTLBytes - memory.liquidityPoolsBytes);
+    memoryInfo["entry_cache"] =
+        static_cast<Json::UInt64>(memory.entryCacheBytes);
+    memoryInfo["best_offers"] =
+        static_cast<Json::UInt64>(memory.bestOffersBytes);
+    memoryInfo["soroban_state"] =
+        static_cast<Json::UInt64>(memory.contractCodeAndTTLBytes);
+    memoryInfo["liquidity_pools"] =
+        static_cast<Json::UInt64>(memory.liquidityPoolsBytes);
+    if (verbose)
+    {
+        for (auto const& [let, bytes] : memory.entryBytes)
+        {
+            memoryInfo["ledger_txn_entries"][xdr::xdr_traits<
+                LedgerEntryType>::enum_name(let)] =
+                static_cast<Json::UInt64>(bytes);
+        }
+        memoryInfo["ledger_txn_entries"]["INTERNAL"] =
+            static_cast<Json::UInt64>(memory.internalEntryBytes);
+    }
+
     if (verbose)
     {
         auto has = lm.getLastClosedLedgerHAS();
@@ -654,11 +745,30 @@ ApplicationImpl::~ApplicationImpl()
     LOG_INFO(DEFAULT_LOG, "Application destructing");
     try
     {
+        // Query threads read from the BucketManager's snapshots
+        mQueryServer.reset();
+        mPrometheusServer.reset();
+        if (mCommandHandler)
+        {
+            mCommandHandler->shutdown();
+        }
+        if (mMemoryBudget)
+        {
+            mMemoryBudget->shutdown();
+        }
+        if (mMaintainer)
+        {
+            mMaintainer->shutdown();
+        }
         shutdownWorkScheduler();
         if (mProcessManager)
         {
             mProcessManager->shutdown();
         }
+        if (mLedgerManager)
+        {
+            mLedgerManager->shutdown();
+        }
         if (mBucketManager)
         {
             mBucketManager->shutdown();
@@ -732,6 +842,11 @@ ApplicationImpl::validateAndLogConfig()
             "requires --in-memory");
     }
 
+    if (mConfig.MODE_REPLAY_ONLY && !mConfig.isInMemoryMode())
+    {
+        throw std::invalid_argument("MODE_REPLAY_ONLY requires --in-memory");
+    }
+
     if (mConfig.isInMemoryMode())
     {
         CLOG_WARNING(
@@ -784,11 +899,19 @@ ApplicationImpl::validateAndLogConfig()
                 }
             }
 
+            if (mConfig.BUCKETLIST_DB_MMAP_READS && !MmapFile::isSupported())
+            {
+                throw std::invalid_argument(
+                    "BUCKETLIST_DB_MMAP_READS is not supported on this "
+                    "platform");
+            }
+
             CLOG_INFO(Bucket,
                       "BucketListDB enabled: pageSizeExponent: {} indexCutOff: "
-                      "{}MB, persist indexes: {}",
+                      "{}MB, persist indexes: {}, mmap reads: {}",
                       pageSizeExp, mConfig.BUCKETLIST_DB_INDEX_CUTOFF,
-                      mConfig.isPersistingBucketListDBIndexes());
+                      mConfig.isPersistingBucketListDBIndexes(),
+                      mConfig.BUCKETLIST_DB_MMAP_READS);
         }
         else
         {
@@ -802,6 +925,22 @@ ApplicationImpl::validateAndLogConfig()
         }
     }
 
+    if (mConfig.HTTP_QUERY_PORT)
+    {
+        if (!mConfig.isUsingBucketListDB())
+        {
+            throw std::invalid_argument(
+                "DEPRECATED_SQL_LEDGER_STATE must be false to use "
+                "HTTP_QUERY_PORT");
+        }
+
+        if (mConfig.HTTP_QUERY_PORT == mConfig.HTTP_PORT)
+        {
+            throw std::invalid_argument(
+                "HTTP_QUERY_PORT must be different from HTTP_PORT");
+        }
+    }
+
     if (mConfig.EXPERIMENTAL_BACKGROUND_EVICTION_SCAN)
     {
         if (!mConfig.isUsingBucketListDB())
@@ -896,9 +1035,76 @@ ApplicationImpl::start()
 
     mLedgerManager->loadLastKnownLedger(/* restoreBucketlist */ true,
                                         /* isLedgerStateReady */ true);
+    if (mConfig.WARM_START_CACHE && !mConfig.MODE_USES_IN_MEMORY_LEDGER)
+    {
+        loadWarmStartCache(*this);
+    }
+    // BucketList snapshots are only available once the ledger is loaded
+    mCommandHandler->startThreads();
+    if (mConfig.HTTP_QUERY_PORT)
+    {
+        mQueryServer = std::make_unique<QueryServer>(
+            mConfig.PUBLIC_HTTP_PORT ? "0.0.0.0" : "127.0.0.1",
+            mConfig.HTTP_QUERY_PORT, mConfig.HTTP_MAX_CLIENT,
+            static_cast<size_t>(mConfig.QUERY_THREAD_POOL_SIZE),
+            getBucketManager().getBucketSnapshotManager());
+    }
+    if (mConfig.PROMETHEUS_HTTP_PORT)
+    {
+        mPrometheusServer = std::make_unique<PrometheusServer>(
+            *this, mConfig.PUBLIC_HTTP_PORT ? "0.0.0.0" : "127.0.0.1",
+            mConfig.PROMETHEUS_HTTP_PORT, mConfig.HTTP_MAX_CLIENT,
+            mConfig.PROMETHEUS_SNAPSHOT_PERIOD);
+    }
+    if (mConfig.MEMORY_BUDGET_MB != 0)
+    {
+        startMemoryBudget();
+    }
     startServices();
 }
 
+void
+ApplicationImpl::startMemoryBudget()
+{
+    // Shares are weighted towards the ledger caches, which closing ledgers
+    // depends on the most
+    mMemoryBudget = std::make_unique<MemoryBudget>(
+        *this, static_cast<uint64_t>(mConfig.MEMORY_BUDGET_MB) * 1000000);
+    if (auto root = dynamic_cast<LedgerTxnRoot*>(mLedgerTxnRoot.get()))
+    {
+        mMemoryBudget->registerConsumer(
+            "ledger-cache", 4,
+            [root]() {
+                auto usage = root->getMemoryUsage();
+                return usage.entryCacheBytes + usage.bestOffersBytes;
+            },
+            [root](uint64_t maxBytes) { root->shrinkCaches(maxBytes); });
+    }
+    if (mConfig.isUsingBucketListDB())
+    {
+        auto& bm = getBucketManager();
+        if (auto cache = bm.getBucketSnapshotManager().getEntryCache())
+        {
+            mMemoryBudget->registerConsumer(
+                "bucketlist-cache", 2, [cache]() { return cache->getBytes(); },
+                [cache](uint64_t maxBytes) { cache->shrinkTo(maxBytes); });
+        }
+        if (auto budget = bm.getIndexBudget())
+        {
+            mMemoryBudget->registerConsumer(
+                "bucket-index", 2,
+                [budget]() { return budget->getResidentBytes(); },
+                [budget](uint64_t maxBytes) { budget->shrinkTo(maxBytes); });
+        }
+    }
+    // The signature cache can't shrink partially, it is emptied
+    mMemoryBudget->registerConsumer(
+        "signature-cache", 1,
+        []() { return PubKeyUtils::getVerifySigCacheBytes(); },
+        [](uint64_t) { PubKeyUtils::clearVerifySigCache(); });
+    mMemoryBudget->start();
+}
+
 void
 ApplicationImpl::gracefulStop()
 {
@@ -911,7 +1117,18 @@ ApplicationImpl::gracefulStop()
     {
         mOverlayManager->shutdown();
     }
+    mQueryServer.reset();
+    mPrometheusServer.reset();
+    mCommandHandler->shutdown();
     mSelfCheckTimer.cancel();
+    if (mMemoryBudget)
+    {
+        mMemoryBudget->shutdown();
+    }
+    if (mMaintainer)
+    {
+        mMaintainer->shutdown();
+    }
     shutdownWorkScheduler();
     if (mProcessManager)
     {
@@ -929,6 +1146,12 @@ ApplicationImpl::gracefulStop()
     {
         mHerder->shutdown();
     }
+    if (mStarted && mConfig.WARM_START_CACHE &&
+        !mConfig.MODE_USES_IN_MEMORY_LEDGER)
+    {
+        // Nothing closes ledgers anymore
+        saveWarmStartCache(*this);
+    }
 
     mStoppingTimer.expires_from_now(
         std::chrono::seconds(SHUTDOWN_DELAY_SECONDS));
@@ -980,6 +1203,24 @@ ApplicationImpl::joinAllThreads()
         mEvictionThread->join();
     }
 
+    if (mOverlayWork)
+    {
+        mOverlayWork.reset();
+    }
+
+    if (mOverlayThread)
+    {
+        LOG_DEBUG(DEFAULT_LOG, "Joining overlay thread");
+        mOverlayThread->join();
+    }
+
+    if (mMergeThreadPool)
+    {
+        LOG_DEBUG(DEFAULT_LOG, "Joining {} bucket merge threads",
+                  mMergeThreadPool->numThreads());
+        mMergeThreadPool->shutdown();
+    }
+
     LOG_DEBUG(DEFAULT_LOG, "Joined all {} threads", mWorkerThreads.size());
 }
 
@@ -1302,6 +1543,27 @@ ApplicationImpl::syncOwnMetrics()
     mMetrics->NewCounter({"process", "action", "overloaded"})
         .set_count(static_cast<int64_t>(getClock().actionQueueIsOverloaded()));
 
+    // Action classes are few, unlike action queues, so they get their own
+    // metrics (durations in microseconds)
+    auto toUs = [](std::chrono::nanoseconds d) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(d)
+            .count();
+    };
+    for (auto const& [cls, stats] :
+         getClock().getActionScheduler().getClassStats())
+    {
+        mMetrics->NewCounter({"scheduler", cls, "runs"})
+            .set_count(static_cast<int64_t>(stats.mRuns));
+        mMetrics->NewCounter({"scheduler", cls, "dropped"})
+            .set_count(static_cast<int64_t>(stats.mDropped));
+        mMetrics->NewCounter({"scheduler", cls, "delay-p99"})
+            .set_count(toUs(stats.mQueueDelay.quantile(0.99)));
+        mMetrics->NewCounter({"scheduler", cls, "run-p99"})
+            .set_count(toUs(stats.mRunTime.quantile(0.99)));
+        mMetrics->NewCounter({"scheduler", cls, "run-max"})
+            .set_count(toUs(stats.mRunTime.max()));
+    }
+
     // Update overlay inbound-connections and file-handle metrics.
     if (mOverlayManager)
     {
@@ -1456,6 +1718,13 @@ ApplicationImpl::getEvictionIOContext()
     return *mEvictionIOContext;
 }
 
+asio::io_context&
+ApplicationImpl::getOverlayIOContext()
+{
+    releaseAssert(mOverlayIOContext);
+    return *mOverlayIOContext;
+}
+
 void
 ApplicationImpl::postOnMainThread(std::function<void()>&& f, std::string&& name,
                                   Scheduler::ActionType type)
@@ -1478,11 +1747,12 @@ ApplicationImpl::postOnMainThread(std::function<void()>&& f, std::string&& name,
 
 void
 ApplicationImpl::postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName)
+                                        std::string jobName,
+                                        BackgroundTaskClass cls)
 {
     LogSlowExecution isSlow{std::move(jobName), LogSlowExecution::Mode::MANUAL,
                             "executed after"};
-    asio::post(getWorkerIOContext(), [this, f = std::move(f), isSlow]() {
+    mBackgroundExecutor->post(cls, [this, f = std::move(f), isSlow]() {
         mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
         f();
     });
@@ -1500,6 +1770,40 @@ ApplicationImpl::postOnEvictionBackgroundThread(std::function<void()>&& f,
     });
 }
 
+void
+ApplicationImpl::postOnOverlayThread(std::function<void()>&& f,
+                                     std::string jobName)
+{
+    LogSlowExecution isSlow{std::move(jobName), LogSlowExecution::Mode::MANUAL,
+                            "executed after"};
+    asio::post(getOverlayIOContext(), [this, f = std::move(f), isSlow]() {
+        mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
+        f();
+    });
+}
+
+void
+ApplicationImpl::postOnBucketMergeThread(std::function<void()>&& f,
+                                         std::string jobName,
+                                         uint32_t deadlineLedger)
+{
+    if (!mMergeThreadPool)
+    {
+        postOnBackgroundThread(std::move(f), std::move(jobName),
+                               BackgroundTaskClass::MERGE);
+        return;
+    }
+
+    LogSlowExecution isSlow{std::move(jobName), LogSlowExecution::Mode::MANUAL,
+                            "executed after"};
+    mMergeThreadPool->post(
+        [this, f = std::move(f), isSlow]() {
+            mPostOnBackgroundThreadDelay.Update(isSlow.checkElapsedTime());
+            f();
+        },
+        deadlineLedger);
+}
+
 void
 ApplicationImpl::enableInvariantsFromConfig()
 {
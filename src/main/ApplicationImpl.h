@@ -35,6 +35,10 @@ class LedgerTxnRoot;
 class InMemoryLedgerTxn;
 class InMemoryLedgerTxnRoot;
 class LoadGenerator;
+class MemoryBudget;
+class DeadlineThreadPool;
+class QueryServer;
+class PrometheusServer;
 
 class ApplicationImpl : public Application
 {
@@ -79,12 +83,19 @@ class ApplicationImpl : public Application
 
     virtual asio::io_context& getWorkerIOContext() override;
     virtual asio::io_context& getEvictionIOContext() override;
+    virtual asio::io_context& getOverlayIOContext() override;
     virtual void postOnMainThread(std::function<void()>&& f, std::string&& name,
                                   Scheduler::ActionType type) override;
-    virtual void postOnBackgroundThread(std::function<void()>&& f,
-                                        std::string jobName) override;
+    virtual void postOnBackgroundThread(
+        std::function<void()>&& f, std::string jobName,
+        BackgroundTaskClass cls = BackgroundTaskClass::GENERAL) override;
+    virtual void postOnOverlayThread(std::function<void()>&& f,
+                                     std::string jobName) override;
     virtual void postOnEvictionBackgroundThread(std::function<void()>&& f,
                                                 std::string jobName) override;
+    virtual void postOnBucketMergeThread(std::function<void()>&& f,
+                                         std::string jobName,
+                                         uint32_t deadlineLedger) override;
 
     virtual void start() override;
     void startServices();
@@ -146,8 +157,10 @@ class ApplicationImpl : public Application
 
     asio::io_context mWorkerIOContext;
     std::unique_ptr<asio::io_context> mEvictionIOContext;
+    std::unique_ptr<asio::io_context> mOverlayIOContext;
     std::unique_ptr<asio::io_context::work> mWork;
     std::unique_ptr<asio::io_context::work> mEvictionWork;
+    std::unique_ptr<asio::io_context::work> mOverlayWork;
 
     std::unique_ptr<BucketManager> mBucketManager;
     std::unique_ptr<Database> mDatabase;
@@ -187,11 +200,21 @@ class ApplicationImpl : public Application
 
     std::unique_ptr<CommandHandler> mCommandHandler;
 
+    // Serves read-only queries on HTTP_QUERY_PORT off the main thread; only
+    // present once the application has started and the port is set.
+    std::unique_ptr<QueryServer> mQueryServer;
+    std::unique_ptr<PrometheusServer> mPrometheusServer;
+
+    // Only present once the application has started with MEMORY_BUDGET_MB
+    std::unique_ptr<MemoryBudget> mMemoryBudget;
+
 #ifdef BUILD_TESTS
     std::unique_ptr<LoadGenerator> mLoadGenerator;
 #endif
 
     std::vector<std::thread> mWorkerThreads;
+    // Schedules the jobs posted to mWorkerThreads by postOnBackgroundThread
+    std::unique_ptr<BackgroundExecutor> mBackgroundExecutor;
 
     // Unlike mWorkerThreads (which are low priority), eviction scans require a
     // medium priority thread. In the future, this may become a more general
@@ -199,6 +222,14 @@ class ApplicationImpl : public Application
     // thread for eviction scans.
     std::optional<std::thread> mEvictionThread;
 
+    // Decodes and authenticates the messages received by the overlay; only
+    // present when BACKGROUND_OVERLAY_DECODE is set.
+    std::optional<std::thread> mOverlayThread;
+
+    // Dedicated, deadline-ordered threads for bucket merges; only present when
+    // BUCKET_MERGE_THREADS > 0.
+    std::unique_ptr<DeadlineThreadPool> mMergeThreadPool;
+
     asio::signal_set mStopSignals;
 
     bool mStarted;
@@ -220,6 +251,9 @@ class ApplicationImpl : public Application
 
     void newDB();
 
+    // Registers the caches that share MEMORY_BUDGET_MB with mMemoryBudget
+    void startMemoryBudget();
+
     void shutdownMainIOContext();
     void shutdownWorkScheduler();
 
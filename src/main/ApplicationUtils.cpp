@@ -11,11 +11,13 @@
 #include "crypto/Hex.h"
 #include "database/Database.h"
 #include "herder/Herder.h"
+#include "herder/LedgerCloseData.h"
 #include "herder/QuorumIntersectionChecker.h"
 #include "history/HistoryArchive.h"
 #include "history/HistoryArchiveManager.h"
 #include "history/HistoryArchiveReportWork.h"
 #include "historywork/GetHistoryArchiveStateWork.h"
+#include "historywork/GunzipFileWork.h"
 #include "invariant/BucketListIsConsistentWithDatabase.h"
 #include "ledger/LedgerHeaderUtils.h"
 #include "ledger/LedgerManager.h"
@@ -27,9 +29,11 @@
 #include "main/StellarCoreVersion.h"
 #include "overlay/OverlayManager.h"
 #include "scp/LocalNode.h"
+#include "util/DebugMetaUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDRCereal.h"
+#include "util/XDRStream.h"
 #include "util/xdrquery/XDRQuery.h"
 #include "work/WorkScheduler.h"
 
@@ -509,10 +513,13 @@ selfCheck(Config cfg)
     }
 
     LOG_INFO(DEFAULT_LOG, "Self-check phase 4: crypto benchmarking");
-    size_t signPerSec = 0, verifyPerSec = 0;
-    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec, 10000);
+    size_t signPerSec = 0, verifyPerSec = 0, batchVerifyPerSec = 0;
+    SecretKey::benchmarkOpsPerSecond(signPerSec, verifyPerSec,
+                                     batchVerifyPerSec, 10000);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} signatures / sec", signPerSec);
     LOG_INFO(DEFAULT_LOG, "Benchmarked {} verifications / sec", verifyPerSec);
+    LOG_INFO(DEFAULT_LOG, "Benchmarked {} batched verifications / sec",
+             batchVerifyPerSec);
 
     if (seq1->getState() == BasicWork::State::WORK_SUCCESS &&
         seq2->getState() == BasicWork::State::WORK_SUCCESS && blcOk)
@@ -528,7 +535,7 @@ selfCheck(Config cfg)
 }
 
 int
-mergeBucketList(Config cfg, std::string const& outputDir)
+mergeBucketList(Config cfg, std::string const& outputDir, size_t numThreads)
 {
     VirtualClock clock;
     cfg.setNoListen();
@@ -539,7 +546,7 @@ mergeBucketList(Config cfg, std::string const& outputDir)
     lm.loadLastKnownLedger(/* restoreBucketlist */ false,
                            /* isLedgerStateReady */ true);
     HistoryArchiveState has = lm.getLastClosedLedgerHAS();
-    auto bucket = bm.mergeBuckets(has);
+    auto bucket = bm.mergeBuckets(has, numThreads);
 
     using std::filesystem::path;
     path bpath(bucket->getFilename());
@@ -742,7 +749,7 @@ dumpLedger(Config cfg, std::string const& outputFile,
            std::optional<std::string> filterQuery,
            std::optional<uint32_t> lastModifiedLedgerCount,
            std::optional<uint64_t> limit, std::optional<std::string> groupBy,
-           std::optional<std::string> aggregate)
+           std::optional<std::string> aggregate, size_t numThreads)
 {
     if (groupBy && !aggregate)
     {
@@ -770,12 +777,6 @@ dumpLedger(Config cfg, std::string const& outputFile,
             minLedger = 0;
         }
     }
-    std::optional<xdrquery::XDRMatcher> matcher;
-    if (filterQuery)
-    {
-        matcher.emplace(*filterQuery);
-    }
-
     std::optional<xdrquery::XDRFieldExtractor> groupByExtractor;
     if (groupBy)
     {
@@ -793,8 +794,18 @@ dumpLedger(Config cfg, std::string const& outputFile,
     {
         bm.visitLedgerEntries(
             has, minLedger,
-            [&](LedgerEntry const& entry) {
-                return !matcher || matcher->matchXDR(entry);
+            [&]() -> std::function<bool(LedgerEntry const&)> {
+                if (!filterQuery)
+                {
+                    return [](LedgerEntry const&) { return true; };
+                }
+                // Matchers resolve the query lazily, so each of the threads
+                // scanning the buckets needs its own
+                auto matcher =
+                    std::make_shared<xdrquery::XDRMatcher>(*filterQuery);
+                return [matcher](LedgerEntry const& entry) {
+                    return matcher->matchXDR(entry);
+                };
             },
             [&](LedgerEntry const& entry) {
                 if (aggregate)
@@ -816,11 +827,12 @@ dumpLedger(Config cfg, std::string const& outputFile,
                 }
                 else
                 {
-                    ofs << xdrToCerealString(entry, "entry", true) << std::endl;
+                    ofs << xdrToCerealString(entry, "entry", true) << '\n';
                 }
                 ++entryCount;
                 return !limit || entryCount < *limit;
-            });
+            },
+            numThreads);
     }
     catch (xdrquery::XDRQueryError& e)
     {
@@ -994,6 +1006,179 @@ reportLastHistoryCheckpoint(Config cfg, std::string const& outputFile)
     return ok ? 0 : 1;
 }
 
+namespace
+{
+// The tx set and StellarValue of `ledgerSeq` as recorded in the debug meta
+// of `metaDir`, either in the segment holding it or as the latest tx set
+std::optional<LedgerCloseData>
+findLedgerInDebugMeta(Application& app, std::filesystem::path const& metaDir,
+                      uint32_t ledgerSeq)
+{
+    // Segments are named after their first ledger, in hex, so the one holding
+    // `ledgerSeq` is the last one starting at or before it
+    std::optional<std::filesystem::path> segment;
+    std::string const prefix = "meta-debug-";
+    for (auto const& file : metautils::listMetaDebugFiles(metaDir))
+    {
+        auto first =
+            std::stoul(file.string().substr(prefix.size(), 8), nullptr, 16);
+        if (first <= ledgerSeq)
+        {
+            segment = file;
+        }
+    }
+
+    if (segment)
+    {
+        auto path = metautils::getMetaDebugDirPath(metaDir) / *segment;
+        bool const isZipped = std::regex_match(
+            segment->string(), metautils::META_DEBUG_ZIP_FILE_REGEX);
+        if (isZipped)
+        {
+            auto gunzip = app.getWorkScheduler().executeWork<GunzipFileWork>(
+                path.string(), /* keepExisting */ true);
+            if (gunzip->getState() != BasicWork::State::WORK_SUCCESS)
+            {
+                throw std::runtime_error("failed to unzip " + path.string());
+            }
+            path.replace_extension();
+        }
+
+        std::optional<LedgerCloseData> res;
+        {
+            XDRInputFileStream in;
+            in.open(path.string());
+            LedgerCloseMeta lcm;
+            while (!res && in.readOne(lcm))
+            {
+                auto const& lh = lcm.v() == 0 ? lcm.v0().ledgerHeader
+                                              : lcm.v1().ledgerHeader;
+                if (lh.header.ledgerSeq != ledgerSeq)
+                {
+                    continue;
+                }
+                auto txSet = lcm.v() == 0
+                                 ? TxSetXDRFrame::makeFromWire(lcm.v0().txSet)
+                                 : TxSetXDRFrame::makeFromWire(lcm.v1().txSet);
+                res.emplace(ledgerSeq, txSet, lh.header.scpValue);
+            }
+        }
+        if (isZipped)
+        {
+            std::error_code ec;
+            std::filesystem::remove(path, ec);
+        }
+        if (res)
+        {
+            return res;
+        }
+    }
+
+    auto txSetPath = metautils::getLatestTxSetFilePath(metaDir);
+    if (std::filesystem::exists(txSetPath))
+    {
+        XDRInputFileStream in;
+        in.open(txSetPath.string());
+        StoredDebugTransactionSet debugTxSet;
+        if (in.readOne(debugTxSet) && debugTxSet.ledgerSeq == ledgerSeq)
+        {
+            return LedgerCloseData::toLedgerCloseData(debugTxSet);
+        }
+    }
+    return std::nullopt;
+}
+}
+
+int
+applyLoad(Config cfg, std::string const& metaDir, uint32_t ledgerSeq,
+          uint32_t iterations, bool withMeta)
+{
+    ZoneScoped;
+    VirtualClock clock(VirtualClock::REAL_TIME);
+    cfg.setNoListen();
+    cfg.AUTOMATIC_SELF_CHECK_PERIOD = std::chrono::seconds::zero();
+    auto app = Application::create(clock, cfg, false);
+    app->start();
+
+    auto& lm = app->getLedgerManager();
+    int res = 1;
+    auto ledgerData = findLedgerInDebugMeta(*app, metaDir, ledgerSeq);
+    if (!ledgerData)
+    {
+        LOG_FATAL(DEFAULT_LOG, "Ledger {} not found in the debug meta of {}",
+                  ledgerSeq, metaDir);
+    }
+    else if (lm.getLastClosedLedgerNum() + 1 != ledgerSeq)
+    {
+        LOG_FATAL(DEFAULT_LOG,
+                  "Ledger {} doesn't apply on top of LCL {}, please run "
+                  "`catchup {}/0` first",
+                  ledgerSeq, lm.getLastClosedLedgerNum(), ledgerSeq - 1);
+    }
+    else
+    {
+        // Every iteration applies the tx set on top of the same last closed
+        // ledger, so only the first one runs with cold caches
+        std::vector<TxSetApplyCost> costs;
+        for (uint32_t i = 0; i < iterations; ++i)
+        {
+            costs.emplace_back(
+                lm.dryRunTxSet(*ledgerData->getTxSet(),
+                               ledgerData->getValue().closeTime, withMeta));
+            LOG_INFO(DEFAULT_LOG, "Iteration {}: {}", i + 1,
+                     costs.back().mOperationBreakdown);
+        }
+
+        Json::Value info;
+        info["ledger"] = ledgerSeq;
+        info["iterations"] = iterations;
+        if (!costs.empty())
+        {
+            info["txs"] = static_cast<Json::UInt64>(costs.front().mTxCount);
+            info["ops"] = static_cast<Json::UInt64>(costs.front().mOpCount);
+            info["succeeded"] =
+                static_cast<Json::UInt64>(costs.front().mTxSucceeded);
+            info["meta_bytes"] =
+                static_cast<Json::UInt64>(costs.front().mMetaBytes);
+        }
+        auto addPhase = [&](std::string const& name,
+                            std::chrono::nanoseconds TxSetApplyCost::*time) {
+            std::vector<double> ms;
+            for (auto const& cost : costs)
+            {
+                ms.emplace_back(
+                    std::chrono::duration<double, std::milli>(cost.*time)
+                        .count());
+            }
+            if (ms.empty())
+            {
+                return;
+            }
+            auto& phase = info["phases_ms"][name];
+            phase["first"] = ms.front();
+            std::sort(ms.begin(), ms.end());
+            phase["min"] = ms.front();
+            phase["median"] = ms[ms.size() / 2];
+            phase["max"] = ms.back();
+        };
+        addPhase("fee_processing", &TxSetApplyCost::mFeeProcessingTime);
+        addPhase("apply", &TxSetApplyCost::mApplyTime);
+        addPhase("commit", &TxSetApplyCost::mCommitTime);
+        addPhase("bucket_batch", &TxSetApplyCost::mBucketBatchTime);
+        if (withMeta)
+        {
+            addPhase("meta", &TxSetApplyCost::mMetaTime);
+        }
+        std::cout << info.toStyledString() << std::endl;
+        res = 0;
+    }
+
+    app->gracefulStop();
+    while (clock.crank(true))
+        ;
+    return res;
+}
+
 void
 genSeed()
 {
@@ -23,7 +23,8 @@ void setForceSCPFlag();
 void initializeDatabase(Config cfg);
 void httpCommand(std::string const& command, unsigned short port);
 int selfCheck(Config cfg);
-int mergeBucketList(Config cfg, std::string const& outputDir);
+int mergeBucketList(Config cfg, std::string const& outputDir,
+                    size_t numThreads);
 
 // Logs state archival statistics, such as the number of expired entries
 // currently in the BucketList, number of bytes of evicted entries, etc.
@@ -34,9 +35,15 @@ int dumpLedger(Config cfg, std::string const& outputFile,
                std::optional<uint32_t> lastModifiedLedgerCount,
                std::optional<uint64_t> limit,
                std::optional<std::string> groupBy,
-               std::optional<std::string> aggregate);
+               std::optional<std::string> aggregate, size_t numThreads);
 void showOfflineInfo(Config cfg, bool verbose);
 int reportLastHistoryCheckpoint(Config cfg, std::string const& outputFile);
+// Applies ledger `ledgerSeq`, as recorded in the debug meta of `metaDir`,
+// `iterations` times on top of the last closed ledger, which must be the
+// ledger before it, rolling it back every time, and prints how long each
+// phase of the apply took.
+int applyLoad(Config cfg, std::string const& metaDir, uint32_t ledgerSeq,
+              uint32_t iterations, bool withMeta);
 
 // Check that the network specified by `jsonPath` enjoys a quorum intersection.
 // This function throws `std::runtime_exception` or `KeyUtils::InvalidStrKey` on
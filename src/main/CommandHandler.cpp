@@ -3,15 +3,20 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/CommandHandler.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketManager.h"
+#include "bucket/BucketSnapshotManager.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
 #include "herder/Herder.h"
 #include "history/HistoryArchiveManager.h"
 #include "ledger/InternalLedgerEntry.h"
+#include "ledger/LedgerCloseTimeline.h"
 #include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnImpl.h"
+#include "ledger/SorobanContractUsage.h"
 #include "lib/http/server.hpp"
 #include "lib/json/json.h"
 #include "main/Application.h"
@@ -23,9 +28,13 @@
 #include "transactions/InvokeHostFunctionOpFrame.h"
 #include "transactions/TransactionBridge.h"
 #include "transactions/TransactionUtils.h"
+#include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MemoryAttribution.h"
 #include "util/StatusManager.h"
-#include <Tracy.hpp>
+#include "util/Thread.h"
+#include "util/UnorderedSet.h"
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 #include "medida/reporting/json_reporter.h"
@@ -43,6 +52,8 @@
 #include "test/TestAccount.h"
 #include "test/TxTests.h"
 #endif
+#include <algorithm>
+#include <future>
 #include <iterator>
 #include <optional>
 #include <regex>
@@ -52,7 +63,10 @@ using std::placeholders::_2;
 
 namespace stellar
 {
-CommandHandler::CommandHandler(Application& app) : mApp(app)
+CommandHandler::CommandHandler(Application& app)
+    : mApp(app)
+    , mIOContext(std::max(1, app.getConfig().HTTP_COMMAND_THREADS))
+    , mAlive(std::make_shared<bool>(true))
 {
     if (mApp.getConfig().HTTP_PORT)
     {
@@ -71,8 +85,10 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
         int httpMaxClient = mApp.getConfig().HTTP_MAX_CLIENT;
 
         mServer = std::make_unique<http::server::server>(
-            app.getClock().getIOContext(), ipStr, mApp.getConfig().HTTP_PORT,
-            httpMaxClient);
+            mApp.getConfig().HTTP_COMMAND_THREADS != 0
+                ? mIOContext
+                : app.getClock().getIOContext(),
+            ipStr, mApp.getConfig().HTTP_PORT, httpMaxClient);
     }
     else
     {
@@ -118,11 +134,21 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
     addRoute("manualclose", &CommandHandler::manualClose);
     addRoute("metrics", &CommandHandler::metrics);
     addRoute("tx", &CommandHandler::tx);
-    addRoute("getledgerentry", &CommandHandler::getLedgerEntry);
+    addRoute("txbatch", &CommandHandler::txBatch);
+    // BucketList snapshots hold the complete ledger state with BucketListDB
+    addRoute("getledgerentry", &CommandHandler::getLedgerEntry,
+             mApp.getConfig().isUsingBucketListDB() ? RouteThread::ANY
+                                                    : RouteThread::MAIN);
     addRoute("upgrades", &CommandHandler::upgrades);
     addRoute("dumpproposedsettings", &CommandHandler::dumpProposedSettings);
     addRoute("self-check", &CommandHandler::selfCheck);
     addRoute("sorobaninfo", &CommandHandler::sorobanInfo);
+    addRoute("dryruntxset", &CommandHandler::dryRunTxSet);
+    addRoute("ledgertimeline", &CommandHandler::ledgerTimeline);
+    addRoute("contractusage", &CommandHandler::contractUsage);
+    addRoute("scheduler", &CommandHandler::scheduler);
+    addRoute("memory", &CommandHandler::memory, RouteThread::ANY);
+    addRoute("zones", &CommandHandler::zones, RouteThread::ANY);
 
 #ifdef BUILD_TESTS
     addRoute("generateload", &CommandHandler::generateLoad);
@@ -137,11 +163,107 @@ CommandHandler::CommandHandler(Application& app) : mApp(app)
 #endif
 }
 
+CommandHandler::~CommandHandler()
+{
+    shutdown();
+}
+
+void
+CommandHandler::startThreads()
+{
+    releaseAssert(threadIsMain());
+    if (!mApp.getConfig().HTTP_PORT || !mThreads.empty() || mStopping)
+    {
+        return;
+    }
+    for (int i = 0; i < mApp.getConfig().HTTP_COMMAND_THREADS; ++i)
+    {
+        mThreads.emplace_back([this]() {
+            runCurrentThreadWithLowPriority();
+            mIOContext.run();
+        });
+    }
+}
+
+void
+CommandHandler::shutdown()
+{
+    mStopping = true;
+    mIOContext.stop();
+    for (auto& t : mThreads)
+    {
+        t.join();
+    }
+    mThreads.clear();
+}
+
+void
+CommandHandler::addRoute(std::string const& name, HandlerRoute route,
+                         RouteThread thread)
+{
+    mServer->addRoute(name, [this, name, route, thread](
+                                std::string const& params,
+                                std::string& retStr) {
+        // manualCmd and the server running on the main thread call routes
+        // from the main thread
+        if (thread == RouteThread::MAIN && !threadIsMain())
+        {
+            runOnMainThread(name, route, params, retStr);
+        }
+        else
+        {
+            safeRouter(route, params, retStr);
+        }
+    });
+}
+
 void
-CommandHandler::addRoute(std::string const& name, HandlerRoute route)
+CommandHandler::runOnMainThread(std::string const& name, HandlerRoute route,
+                                std::string const& params,
+                                std::string& retStr)
 {
-    mServer->addRoute(
-        name, std::bind(&CommandHandler::safeRouter, this, route, _1, _2));
+    auto result = std::make_shared<std::promise<std::string>>();
+    auto future = result->get_future();
+    std::weak_ptr<bool> alive = mAlive;
+    mApp.postOnMainThread(
+        [this, alive, route, params, result]() {
+            // The handler is destroyed on the main thread, so can't expire
+            // while this runs
+            if (alive.expired())
+            {
+                return;
+            }
+            std::string res;
+            safeRouter(route, params, res);
+            result->set_value(std::move(res));
+        },
+        "HTTP command: " + name);
+
+    // The main thread may stop cranking before getting to it
+    while (future.wait_for(std::chrono::milliseconds(100)) !=
+           std::future_status::ready)
+    {
+        if (mStopping)
+        {
+            retStr = R"({"exception": "shutting down"})";
+            return;
+        }
+    }
+    retStr = future.get();
+}
+
+SearchableBucketListSnapshot&
+CommandHandler::getSnapshot()
+{
+    std::lock_guard<std::mutex> guard(mSnapshotsMutex);
+    auto& snapshot = mSnapshots[std::this_thread::get_id()];
+    if (!snapshot)
+    {
+        snapshot = mApp.getBucketManager()
+                       .getBucketSnapshotManager()
+                       .getSearchableBucketListSnapshot();
+    }
+    return *snapshot;
 }
 
 void
@@ -732,6 +854,216 @@ CommandHandler::quorum(std::string const& params, std::string& retStr)
     retStr = root.toStyledString();
 }
 
+void
+CommandHandler::ledgerTimeline(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    auto ledger = parseOptionalParam<uint32_t>(retMap, "ledger");
+    retStr = mApp.getLedgerManager()
+                 .getCloseTimeline()
+                 .getJsonInfo(ledger)
+                 .toStyledString();
+}
+
+void
+CommandHandler::contractUsage(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    auto const& usage = mApp.getLedgerManager().getSorobanContractUsage();
+    if (!usage.isEnabled())
+    {
+        throw std::runtime_error(
+            "SOROBAN_CONTRACT_USAGE_TOP_N is not set in the config");
+    }
+    retStr = usage.getJsonInfo().toStyledString();
+}
+
+static Json::Value
+actionStatsToJson(Scheduler::ActionStats const& stats)
+{
+    auto toUs = [](std::chrono::nanoseconds d) {
+        return static_cast<Json::UInt64>(
+            std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    };
+    auto histogram = [&](Scheduler::LatencyHistogram const& h) {
+        Json::Value res;
+        res["total_us"] = toUs(h.total());
+        res["p50_us"] = toUs(h.quantile(0.5));
+        res["p99_us"] = toUs(h.quantile(0.99));
+        res["max_us"] = toUs(h.max());
+        return res;
+    };
+    Json::Value res;
+    res["runs"] = static_cast<Json::UInt64>(stats.mRuns);
+    res["dropped"] = static_cast<Json::UInt64>(stats.mDropped);
+    res["queue_delay"] = histogram(stats.mQueueDelay);
+    res["run_time"] = histogram(stats.mRunTime);
+    return res;
+}
+
+void
+CommandHandler::scheduler(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    auto limit = parseOptionalParamOrDefault<uint32_t>(retMap, "limit", 20);
+
+    auto& sched = mApp.getClock().getActionScheduler();
+    Json::Value root;
+    for (auto const& [cls, stats] : sched.getClassStats())
+    {
+        root["classes"][cls] = actionStatsToJson(stats);
+    }
+
+    // The queues that held the main thread the longest first
+    auto queues = sched.getQueueInfo();
+    std::sort(queues.begin(), queues.end(), [](auto const& a, auto const& b) {
+        return a.mStats.mRunTime.total() > b.mStats.mRunTime.total();
+    });
+    root["queues"] = Json::arrayValue;
+    for (size_t i = 0; i < queues.size() && i < limit; ++i)
+    {
+        auto q = actionStatsToJson(queues[i].mStats);
+        q["name"] = queues[i].mName;
+        q["droppable"] = queues[i].mType ==
+                         Scheduler::ActionType::DROPPABLE_ACTION;
+        q["queued"] = static_cast<Json::UInt64>(queues[i].mQueued);
+        root["queues"].append(q);
+    }
+    retStr = root.toStyledString();
+}
+
+void
+CommandHandler::memory(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    if (!memoryAttributionEnabled())
+    {
+        throw std::runtime_error(
+            "stellar-core was not built with --enable-memory-attribution");
+    }
+
+    // Read first, so that building the reply isn't counted
+    auto stats = getMemoryAttributionStats();
+    Json::Value root;
+    uint64_t totalLive = 0;
+    for (auto const& s : stats)
+    {
+        auto& sub = root["subsystems"][s.mSubsystem];
+        sub["allocs"] = static_cast<Json::UInt64>(s.mAllocs);
+        sub["frees"] = static_cast<Json::UInt64>(s.mFrees);
+        sub["allocated_bytes"] = static_cast<Json::UInt64>(s.mAllocatedBytes);
+        // Allocations and releases are counted separately, so a concurrent
+        // release can be seen before its allocation
+        auto live = s.mAllocatedBytes > s.mFreedBytes
+                        ? s.mAllocatedBytes - s.mFreedBytes
+                        : 0;
+        sub["live_bytes"] = static_cast<Json::UInt64>(live);
+        sub["live_allocs"] = static_cast<Json::UInt64>(
+            s.mAllocs > s.mFrees ? s.mAllocs - s.mFrees : 0);
+        totalLive += live;
+    }
+    root["live_bytes"] = static_cast<Json::UInt64>(totalLive);
+    retStr = root.toStyledString();
+}
+
+void
+CommandHandler::zones(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> retMap;
+    http::server::server::parseParams(params, retMap);
+    auto limit = parseOptionalParamOrDefault<size_t>(retMap, "limit", 50);
+
+    auto stats = getZoneStats();
+    std::sort(stats.begin(), stats.end(),
+              [](ZoneStats const& a, ZoneStats const& b) {
+                  return a.mTotalNs > b.mTotalNs;
+              });
+    if (stats.size() > limit)
+    {
+        stats.resize(limit);
+    }
+
+    auto period = getZoneProfilerSamplePeriod();
+    auto toUs = [](uint64_t ns) {
+        return static_cast<Json::UInt64>(ns / 1000);
+    };
+    Json::Value root;
+    root["sample_period"] = period;
+    root["zones"] = Json::arrayValue;
+    for (auto const& s : stats)
+    {
+        Json::Value zone;
+        zone["name"] = s.mName;
+        zone["location"] = fmt::format(FMT_STRING("{}:{}"), s.mFile, s.mLine);
+        zone["samples"] = static_cast<Json::UInt64>(s.mSamples);
+        zone["estimated_calls"] =
+            static_cast<Json::UInt64>(s.mSamples * period);
+        zone["estimated_total_ms"] =
+            static_cast<Json::UInt64>(s.mTotalNs * period / 1000000);
+        zone["mean_us"] = toUs(s.mTotalNs / s.mSamples);
+        zone["p50_us"] = toUs(s.quantileNs(0.5));
+        zone["p99_us"] = toUs(s.quantileNs(0.99));
+        zone["max_us"] = toUs(s.mMaxNs);
+        root["zones"].append(zone);
+    }
+    retStr = root.toStyledString();
+}
+
+void
+CommandHandler::dryRunTxSet(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    auto& lm = mApp.getLedgerManager();
+    if (!lm.isSynced())
+    {
+        throw std::runtime_error("Node is not in sync");
+    }
+
+    auto [txSet, closeTime] = mApp.getHerder().makeCandidateTxSet();
+    auto cost = lm.dryRunTxSet(*txSet, closeTime, /* withMeta */ false);
+
+    auto toMs = [](std::chrono::nanoseconds d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    Json::Value res;
+    res["ledger"] = lm.getLastClosedLedgerNum() + 1;
+    res["txs"] = static_cast<Json::UInt64>(cost.mTxCount);
+    res["ops"] = static_cast<Json::UInt64>(cost.mOpCount);
+    res["succeeded"] = static_cast<Json::UInt64>(cost.mTxSucceeded);
+    res["fee_processing_ms"] = toMs(cost.mFeeProcessingTime);
+    res["apply_ms"] = toMs(cost.mApplyTime);
+    res["commit_ms"] = toMs(cost.mCommitTime);
+    res["bucket_batch_ms"] = toMs(cost.mBucketBatchTime);
+    res["entries"]["loaded"] = static_cast<Json::UInt64>(cost.mEntriesLoaded);
+    res["entries"]["created"] = static_cast<Json::UInt64>(cost.mEntriesCreated);
+    res["entries"]["updated"] = static_cast<Json::UInt64>(cost.mEntriesUpdated);
+    res["entries"]["deleted"] = static_cast<Json::UInt64>(cost.mEntriesDeleted);
+
+    if (lm.hasSorobanNetworkConfig())
+    {
+        auto limits = lm.maxLedgerResources(/* isSoroban */ true);
+        auto addResource = [&](std::string const& name, Resource::Type type) {
+            auto& r = res["soroban"][name];
+            r["declared"] =
+                static_cast<Json::Int64>(cost.mSorobanResources.getVal(type));
+            r["ledger_limit"] = static_cast<Json::Int64>(limits.getVal(type));
+        };
+        addResource("txs", Resource::Type::OPERATIONS);
+        addResource("instructions", Resource::Type::INSTRUCTIONS);
+        addResource("tx_size_bytes", Resource::Type::TX_BYTE_SIZE);
+        addResource("read_bytes", Resource::Type::READ_BYTES);
+        addResource("write_bytes", Resource::Type::WRITE_BYTES);
+        addResource("read_entries", Resource::Type::READ_LEDGER_ENTRIES);
+        addResource("write_entries", Resource::Type::WRITE_LEDGER_ENTRIES);
+    }
+    retStr = res.toStyledString();
+}
+
 void
 CommandHandler::scpInfo(std::string const& params, std::string& retStr)
 {
@@ -934,7 +1266,25 @@ CommandHandler::getLedgerEntry(std::string const& params, std::string& retStr)
     std::map<std::string, std::string> paramMap;
     http::server::server::parseParams(params, paramMap);
     std::string key = paramMap["key"];
-    if (!key.empty())
+    if (!key.empty() && !threadIsMain())
+    {
+        // Only routed off the main thread with BucketListDB
+        LedgerKey k;
+        fromOpaqueBase64(k, key);
+        auto& snapshot = getSnapshot();
+        auto le = snapshot.getLedgerEntry(k);
+        root["ledger"] = snapshot.getLedgerSeq();
+        if (le)
+        {
+            root["state"] = "live";
+            root["entry"] = toOpaqueBase64(*le);
+        }
+        else
+        {
+            root["state"] = "dead";
+        }
+    }
+    else if (!key.empty())
     {
         LedgerTxn ltx(mApp.getLedgerTxnRoot(),
                       /* shouldUpdateLastModified */ false,
@@ -963,6 +1313,59 @@ CommandHandler::getLedgerEntry(std::string const& params, std::string& retStr)
     retStr = Json::FastWriter().write(root);
 }
 
+// Decodes a base64 TransactionEnvelope submitted over HTTP, returning nullptr
+// if it can't be turned into a transaction
+static TransactionFrameBasePtr
+parseTransactionBlob(Application& app, std::string const& blob)
+{
+    TransactionEnvelope envelope;
+    std::vector<uint8_t> binBlob;
+    decoder::decode_b64(blob, binBlob);
+    xdr::xdr_from_opaque(binBlob, envelope);
+
+    {
+        auto lhhe = app.getLedgerManager().getLastClosedLedgerHeader();
+        if (protocolVersionStartsFrom(lhhe.header.ledgerVersion,
+                                      ProtocolVersion::V_13))
+        {
+            envelope = txbridge::convertForV13(envelope);
+        }
+    }
+
+    return TransactionFrameBase::makeTransactionFromWire(app.getNetworkID(),
+                                                         envelope);
+}
+
+// Adds `transaction` to the transaction queue and describes the result
+static Json::Value
+submitTransaction(Application& app, TransactionFrameBasePtr const& transaction)
+{
+    Json::Value root;
+    // Add it to our current set and make sure it is valid.
+    TransactionQueue::AddResult status =
+        app.getHerder().recvTransaction(transaction, true);
+
+    root["status"] = TX_STATUS_STRING[static_cast<int>(status)];
+    if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
+    {
+        std::string resultBase64;
+        auto resultBin = xdr::xdr_to_opaque(transaction->getResult());
+        resultBase64.reserve(decoder::encoded_size64(resultBin.size()) + 1);
+        resultBase64 = decoder::encode_b64(resultBin);
+        root["error"] = resultBase64;
+        if (app.getConfig().ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION &&
+            transaction->isSoroban() &&
+            !transaction->getDiagnosticEvents().empty())
+        {
+            auto diagsBin =
+                xdr::xdr_to_opaque(transaction->getDiagnosticEvents());
+            auto diagsBase64 = decoder::encode_b64(diagsBin);
+            root["diagnostic_events"] = diagsBase64;
+        }
+    }
+    return root;
+}
+
 void
 CommandHandler::tx(std::string const& params, std::string& retStr)
 {
@@ -975,47 +1378,10 @@ CommandHandler::tx(std::string const& params, std::string& retStr)
 
     if (!blob.empty())
     {
-        TransactionEnvelope envelope;
-        std::vector<uint8_t> binBlob;
-        decoder::decode_b64(blob, binBlob);
-        xdr::xdr_from_opaque(binBlob, envelope);
-
-        {
-            auto lhhe = mApp.getLedgerManager().getLastClosedLedgerHeader();
-            if (protocolVersionStartsFrom(lhhe.header.ledgerVersion,
-                                          ProtocolVersion::V_13))
-            {
-                envelope = txbridge::convertForV13(envelope);
-            }
-        }
-
-        auto transaction = TransactionFrameBase::makeTransactionFromWire(
-            mApp.getNetworkID(), envelope);
+        auto transaction = parseTransactionBlob(mApp, blob);
         if (transaction)
         {
-            // Add it to our current set and make sure it is valid.
-            TransactionQueue::AddResult status =
-                mApp.getHerder().recvTransaction(transaction, true);
-
-            root["status"] = TX_STATUS_STRING[static_cast<int>(status)];
-            if (status == TransactionQueue::AddResult::ADD_STATUS_ERROR)
-            {
-                std::string resultBase64;
-                auto resultBin = xdr::xdr_to_opaque(transaction->getResult());
-                resultBase64.reserve(decoder::encoded_size64(resultBin.size()) +
-                                     1);
-                resultBase64 = decoder::encode_b64(resultBin);
-                root["error"] = resultBase64;
-                if (mApp.getConfig().ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION &&
-                    transaction->isSoroban() &&
-                    !transaction->getDiagnosticEvents().empty())
-                {
-                    auto diagsBin =
-                        xdr::xdr_to_opaque(transaction->getDiagnosticEvents());
-                    auto diagsBase64 = decoder::encode_b64(diagsBin);
-                    root["diagnostic_events"] = diagsBase64;
-                }
-            }
+            root = submitTransaction(mApp, transaction);
         }
     }
     else
@@ -1027,6 +1393,84 @@ CommandHandler::tx(std::string const& params, std::string& retStr)
     retStr = Json::FastWriter().write(root);
 }
 
+void
+CommandHandler::txBatch(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    auto const& blobs = paramMap["blobs"];
+    if (blobs.empty())
+    {
+        throw std::invalid_argument(
+            "Must specify tx blobs: txbatch?blobs=<tx in xdr format>,...");
+    }
+
+    // Decode everything first, so that the signatures can be checked on
+    // worker threads and the source accounts loaded in one batch before
+    // the transactions are queued one after the other.
+    std::vector<std::string> errors;
+    std::vector<TransactionFrameBasePtr> txs;
+    size_t begin = 0;
+    while (begin <= blobs.size())
+    {
+        auto end = std::min(blobs.find(',', begin), blobs.size());
+        TransactionFrameBasePtr tx;
+        std::string error;
+        try
+        {
+            tx = parseTransactionBlob(mApp, blobs.substr(begin, end - begin));
+        }
+        catch (std::exception& e)
+        {
+            error = e.what();
+        }
+        txs.emplace_back(tx);
+        errors.emplace_back(error);
+        begin = end + 1;
+    }
+
+    std::vector<TransactionFrameBasePtr> validTxs;
+    for (auto const& tx : txs)
+    {
+        if (tx)
+        {
+            validTxs.emplace_back(tx);
+        }
+    }
+    verifySignaturesInParallel(
+        mApp, validTxs, mApp.getConfig().TX_SET_VALIDATION_SIG_VERIFY_THREADS);
+    if (mApp.getConfig().PREFETCH_BATCH_SIZE > 0)
+    {
+        UnorderedSet<LedgerKey> keys;
+        for (auto const& tx : validTxs)
+        {
+            tx->insertKeysForFeeProcessing(keys);
+        }
+        mApp.getLedgerTxnRoot().prefetch(keys);
+    }
+
+    Json::Value root(Json::arrayValue);
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        if (txs[i])
+        {
+            root.append(submitTransaction(mApp, txs[i]));
+        }
+        else if (!errors[i].empty())
+        {
+            Json::Value res;
+            res["exception"] = errors[i];
+            root.append(res);
+        }
+        else
+        {
+            root.append(Json::Value(Json::objectValue));
+        }
+    }
+    retStr = Json::FastWriter().write(root);
+}
+
 void
 CommandHandler::dropcursor(std::string const& params, std::string& retStr)
 {
@@ -1306,6 +1750,10 @@ CommandHandler::generateLoad(std::string const& params, std::string& retStr)
             parseOptionalParam<uint32_t>(map, "maxfeerate");
         cfg.skipLowFeeTxs =
             parseOptionalParamOrDefault<bool>(map, "skiplowfeetxs", false);
+        cfg.openLoop =
+            parseOptionalParamOrDefault<bool>(map, "openloop", false);
+        cfg.backgroundSigning = parseOptionalParamOrDefault<bool>(
+            map, "backgroundsigning", false);
 
         if (cfg.mode == LoadGenMode::MIXED_CLASSIC)
         {
@@ -6,7 +6,13 @@
 
 #include "lib/http/server.hpp"
 #include "util/ProtocolVersion.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 /*
 handler functions for the http commands this server supports
@@ -15,6 +21,7 @@ handler functions for the http commands this server supports
 namespace stellar
 {
 class Application;
+class SearchableBucketListSnapshot;
 
 class CommandHandler
 {
@@ -22,12 +29,39 @@ class CommandHandler
                                std::string&)>
         HandlerRoute;
 
+    // Where a route runs when requests are served by HTTP_COMMAND_THREADS
+    enum class RouteThread
+    {
+        // Posted to the main thread, the serving thread waiting for it
+        MAIN,
+        // Run by the serving thread; must only touch thread-safe state
+        ANY
+    };
+
     Application& mApp;
+    // Only run by mThreads, with HTTP_COMMAND_THREADS; otherwise the server
+    // runs on the main thread's io_context
+    asio::io_context mIOContext;
     std::unique_ptr<http::server::server> mServer;
+    std::vector<std::thread> mThreads;
+    std::atomic<bool> mStopping{false};
+    // Expires with the handler, for main thread routes posted as it goes
+    std::shared_ptr<bool> mAlive;
+
+    // For getledgerentry off the main thread, one per serving thread
+    std::mutex mSnapshotsMutex;
+    std::unordered_map<std::thread::id,
+                       std::shared_ptr<SearchableBucketListSnapshot>>
+        mSnapshots;
 
-    void addRoute(std::string const& name, HandlerRoute route);
+    SearchableBucketListSnapshot& getSnapshot();
+
+    void addRoute(std::string const& name, HandlerRoute route,
+                  RouteThread thread = RouteThread::MAIN);
     void safeRouter(HandlerRoute route, std::string const& params,
                     std::string& retStr);
+    void runOnMainThread(std::string const& name, HandlerRoute route,
+                         std::string const& params, std::string& retStr);
 
     void ensureProtocolVersion(std::map<std::string, std::string> const& args,
                                std::string const& argName,
@@ -37,6 +71,16 @@ class CommandHandler
 
   public:
     CommandHandler(Application& app);
+    ~CommandHandler();
+
+    // Starts the HTTP_COMMAND_THREADS serving requests. Called once the
+    // ledger is loaded, as routes served off the main thread read from
+    // BucketList snapshots.
+    void startThreads();
+    // Stops serving requests and joins the serving threads; requests
+    // waiting for the main thread are answered with an exception. Commands
+    // can still be run with manualCmd.
+    void shutdown();
 
     std::string manualCmd(std::string const& cmd);
 
@@ -60,6 +104,7 @@ class CommandHandler
     void getcursor(std::string const& params, std::string& retStr);
     void scpInfo(std::string const& params, std::string& retStr);
     void tx(std::string const& params, std::string& retStr);
+    void txBatch(std::string const& params, std::string& retStr);
     void getLedgerEntry(std::string const& params, std::string& retStr);
     void unban(std::string const& params, std::string& retStr);
     void upgrades(std::string const& params, std::string& retStr);
@@ -68,6 +113,12 @@ class CommandHandler
     void stopSurvey(std::string const&, std::string& retStr);
     void getSurveyResult(std::string const&, std::string& retStr);
     void sorobanInfo(std::string const&, std::string& retStr);
+    void dryRunTxSet(std::string const&, std::string& retStr);
+    void ledgerTimeline(std::string const& params, std::string& retStr);
+    void contractUsage(std::string const& params, std::string& retStr);
+    void scheduler(std::string const& params, std::string& retStr);
+    void memory(std::string const& params, std::string& retStr);
+    void zones(std::string const& params, std::string& retStr);
     void startSurveyCollecting(std::string const& params, std::string& retStr);
     void stopSurveyCollecting(std::string const& params, std::string& retStr);
     void surveyTopologyTimeSliced(std::string const& params,
@@ -296,6 +296,21 @@ historyHashParser(std::string& hash)
         "specify a hash to trust for the provided ledger");
 }
 
+clara::Opt
+downloadWindowParser(uint32_t& downloadWindow)
+{
+    return clara::Opt{downloadWindow, "CHECKPOINTS"}["--download-window"](
+        "checkpoints to download ahead of verification, by default 64 per "
+        "MAX_CONCURRENT_SUBPROCESSES");
+}
+
+clara::Opt
+resumeParser(bool& resume)
+{
+    return clara::Opt{resume}["--resume"](
+        "carry on from the checkpoints already in the output file");
+}
+
 clara::Parser
 configurationParser(CommandLine::ConfigOption& configOption)
 {
@@ -458,6 +473,13 @@ limitParser(std::optional<std::uint64_t>& limit)
         "process only this many recent ledger entries (not *most* recent)");
 }
 
+clara::Opt
+threadsParser(size_t& numThreads)
+{
+    return clara::Opt{numThreads, "THREADS"}["--threads"](
+        "process that many bucket files at once");
+}
+
 int
 runWithHelp(CommandLineArgs const& args,
             std::vector<ParserWithValidation> parsers, std::function<int()> f)
@@ -596,6 +618,11 @@ CommandLine::ConfigOption::getConfig(bool logToFile) const
     bool consoleLogging =
         !logToFile || config.LOG_FILE_PATH.empty() || mConsoleLog;
     Logging::setLoggingToConsole(consoleLogging);
+    if (!config.LOG_ASYNC_PARTITIONS.empty())
+    {
+        Logging::setAsyncPartitions(config.LOG_ASYNC_PARTITIONS,
+                                    config.LOG_ASYNC_QUEUE_SIZE);
+    }
     Logging::setLogLevel(mLogLevel, nullptr);
 
     config.REPORT_METRICS = mMetrics;
@@ -769,6 +796,35 @@ runReplayDebugMeta(CommandLineArgs const& args)
         });
 }
 
+int
+runApplyLoad(CommandLineArgs const& args)
+{
+    CommandLine::ConfigOption configOption;
+    std::string metaDir{"."};
+    uint32_t ledger = 0;
+    uint32_t iterations = 10;
+    bool withMeta = false;
+
+    ParserWithValidation ledgerParser{
+        clara::Opt{ledger, "LEDGER"}["--ledger"]("ledger to apply").required(),
+        [&] { return ledger > 1 ? "" : "--ledger must be greater than 1"; }};
+    ParserWithValidation iterationsParser{
+        clara::Opt{iterations, "N"}["--iterations"](
+            "number of times to apply the ledger, 10 by default"),
+        [&] { return iterations > 0 ? "" : "--iterations must be positive"; }};
+
+    return runWithHelp(
+        args,
+        {configurationParser(configOption), metaDirParser(metaDir).required(),
+         ledgerParser, iterationsParser,
+         clara::Opt{withMeta}["--with-meta"](
+             "build and encode the meta of the ledger too")},
+        [&] {
+            return applyLoad(configOption.getConfig(), metaDir, ledger,
+                             iterations, withMeta);
+        });
+}
+
 int
 runCatchup(CommandLineArgs const& args)
 {
@@ -779,6 +835,7 @@ runCatchup(CommandLineArgs const& args)
     std::string trustedCheckpointHashesFile;
     bool completeValidation = false;
     bool inMemory = false;
+    bool replayOnly = false;
     bool forceBack = false;
     bool forceUntrusted = false;
     std::string hash;
@@ -827,6 +884,12 @@ runCatchup(CommandLineArgs const& args)
             "verify all files from the archive for the catchup range");
     };
 
+    auto replayOnlyParser = [](bool& replayOnly) {
+        return clara::Opt{replayOnly}["--replay-only"](
+            "with --in-memory, only replay history to emit its meta, without "
+            "persisting ledger state or publishing");
+    };
+
     auto forceBackParser = [](bool& forceBackClean) {
         return clara::Opt{forceBackClean}["--force-back"](
             "force ledger state to a previous state, preserving older "
@@ -841,7 +904,8 @@ runCatchup(CommandLineArgs const& args)
          outputFileParser(outputFile), disableBucketGCParser(disableBucketGC),
          validationParser(completeValidation), inMemoryParser(inMemory),
          ledgerHashParser(hash), forceUntrustedCatchup(forceUntrusted),
-         metadataOutputStreamParser(stream), forceBackParser(forceBack)},
+         metadataOutputStreamParser(stream), forceBackParser(forceBack),
+         replayOnlyParser(replayOnly)},
         [&] {
             auto config = configOption.getConfig();
             // Don't call config.setNoListen() here as we might want to
@@ -865,6 +929,15 @@ runCatchup(CommandLineArgs const& args)
             // so pass defaults values
             maybeEnableInMemoryMode(config, inMemory, 0, "",
                                     /* persistMinimalData */ false);
+            if (replayOnly)
+            {
+                if (!inMemory)
+                {
+                    throw std::runtime_error(
+                        "--replay-only requires --in-memory");
+                }
+                config.setInMemoryReplayMode();
+            }
             maybeSetMetadataOutputStream(config, stream);
 
             VirtualClock clock(VirtualClock::REAL_TIME);
@@ -997,11 +1070,14 @@ runWriteVerifiedCheckpointHashes(CommandLineArgs const& args)
     std::string outputFile;
     uint32_t startLedger = 0;
     std::string startHash;
+    uint32_t downloadWindow = 0;
+    bool resume = false;
     CommandLine::ConfigOption configOption;
     return runWithHelp(
         args,
         {configurationParser(configOption), historyLedgerNumber(startLedger),
-         historyHashParser(startHash), outputFileParser(outputFile).required()},
+         historyHashParser(startHash), outputFileParser(outputFile).required(),
+         downloadWindowParser(downloadWindow), resumeParser(resume)},
         [&] {
             VirtualClock clock(VirtualClock::REAL_TIME);
             auto cfg = configOption.getConfig();
@@ -1029,8 +1105,11 @@ runWriteVerifiedCheckpointHashes(CommandLineArgs const& args)
                 app->getOverlayManager().shutdown();
                 app->getHerder().shutdown();
                 app->getWorkScheduler()
-                    .executeWork<WriteVerifiedCheckpointHashesWork>(authPair,
-                                                                    outputFile);
+                    .executeWork<WriteVerifiedCheckpointHashesWork>(
+                        authPair, outputFile,
+                        WriteVerifiedCheckpointHashesWork::
+                            NESTED_DOWNLOAD_BATCH_SIZE,
+                        nullptr, downloadWindow, resume);
                 app->gracefulStop();
                 return 0;
             }
@@ -1161,12 +1240,21 @@ runMergeBucketList(CommandLineArgs const& args)
 {
     CommandLine::ConfigOption configOption;
     std::string outputDir{"."};
+    size_t numThreads = 1;
 
-    return runWithHelp(
-        args,
-        {configurationParser(configOption),
-         outputDirParser(outputDir).required()},
-        [&] { return mergeBucketList(configOption.getConfig(), outputDir); });
+    return runWithHelp(args,
+                       {configurationParser(configOption),
+                        outputDirParser(outputDir).required(),
+                        threadsParser(numThreads)},
+                       [&] {
+                           if (numThreads == 0)
+                           {
+                               throw std::runtime_error(
+                                   "--threads must be positive");
+                           }
+                           return mergeBucketList(configOption.getConfig(),
+                                                  outputDir, numThreads);
+                       });
 }
 
 int
@@ -1188,18 +1276,24 @@ runDumpLedger(CommandLineArgs const& args)
     std::optional<uint64_t> limit;
     std::optional<std::string> groupBy;
     std::optional<std::string> aggregate;
+    size_t numThreads = 1;
     return runWithHelp(args,
                        {configurationParser(configOption),
                         outputFileParser(outputFile).required(),
                         filterQueryParser(filterQuery),
                         lastModifiedLedgerCountParser(lastModifiedLedgerCount),
                         limitParser(limit), groupByParser(groupBy),
-                        aggregateParser(aggregate)},
+                        aggregateParser(aggregate), threadsParser(numThreads)},
                        [&] {
+                           if (numThreads == 0)
+                           {
+                               throw std::runtime_error(
+                                   "--threads must be positive");
+                           }
                            return dumpLedger(configOption.getConfig(),
                                              outputFile, filterQuery,
                                              lastModifiedLedgerCount, limit,
-                                             groupBy, aggregate);
+                                             groupBy, aggregate, numThreads);
                        });
 }
 
@@ -1339,8 +1433,7 @@ getSettingsUpgradeTransactions(CommandLineArgs const& args)
                     << "Unsigned TransactionEnvelope to upload upgrade WASM "
                     << std::endl;
                 std::cout << tx1 << std::endl;
-                std::cout << binToHex(xdr::xdr_to_opaque(
-                                 sha256(xdr::xdr_to_opaque(payload1))))
+                std::cout << binToHex(xdr::xdr_to_opaque(xdrSha256(payload1)))
                           << std::endl;
 
                 std::cerr << "Unsigned TransactionEnvelope to create upgrade "
@@ -1348,8 +1441,7 @@ getSettingsUpgradeTransactions(CommandLineArgs const& args)
                           << std::endl;
 
                 std::cout << tx2 << std::endl;
-                std::cout << binToHex(xdr::xdr_to_opaque(
-                                 sha256(xdr::xdr_to_opaque(payload2))))
+                std::cout << binToHex(xdr::xdr_to_opaque(xdrSha256(payload2)))
                           << std::endl;
 
                 std::cerr
@@ -1357,8 +1449,7 @@ getSettingsUpgradeTransactions(CommandLineArgs const& args)
                        "upgrade bytes "
                     << std::endl;
                 std::cout << tx3 << std::endl;
-                std::cout << binToHex(xdr::xdr_to_opaque(
-                                 sha256(xdr::xdr_to_opaque(payload3))))
+                std::cout << binToHex(xdr::xdr_to_opaque(xdrSha256(payload3)))
                           << std::endl;
             }
 
@@ -1767,7 +1858,7 @@ runFuzz(CommandLineArgs const& args)
 {
     LogLevel logLevel{LogLevel::LVL_FATAL};
     std::vector<std::string> metrics;
-    std::string fileName;
+    std::vector<std::string> fileNames;
     std::string outputFile;
     int processID = 0;
     bool consoleLog = false;
@@ -1776,7 +1867,8 @@ runFuzz(CommandLineArgs const& args)
 
     return runWithHelp(args,
                        {logLevelParser(logLevel), metricsParser(metrics),
-                        consoleParser(consoleLog), fileNameParser(fileName),
+                        consoleParser(consoleLog),
+                        requiredArgParser(fileNames, "FILE-NAME"),
                         outputFileParser(outputFile),
                         processIDParser(processID),
                         fuzzerModeParser(fuzzerModeArg, fuzzerMode)},
@@ -1787,7 +1879,7 @@ runFuzz(CommandLineArgs const& args)
                                Logging::setLoggingToFile(outputFile);
                            }
 
-                           fuzz(fileName, metrics, processID, fuzzerMode);
+                           fuzz(fileNames, metrics, processID, fuzzerMode);
                            return 0;
                        });
 }
@@ -1824,7 +1916,11 @@ int
 handleCommandLine(int argc, char* const* argv)
 {
     auto commandLine = CommandLine{
-        {{"catchup",
+        {{"apply-load",
+          "apply a ledger from local debug metadata files repeatedly, for "
+          "benchmarking",
+          runApplyLoad},
+         {"catchup",
           "execute catchup from history archives without connecting to "
           "network",
           runCatchup},
@@ -1887,7 +1983,7 @@ handleCommandLine(int argc, char* const* argv)
          {"rebuild-ledger-from-buckets",
           "rebuild the current database ledger from the bucket list",
           runRebuildLedgerFromBuckets},
-         {"fuzz", "run a single fuzz input and exit", runFuzz},
+         {"fuzz", "run fuzz inputs (files or directories) and exit", runFuzz},
          {"gen-fuzz", "generate a random fuzzer input file", runGenFuzz},
          {"test", "execute test suite", runTest},
 #endif
@@ -9,11 +9,13 @@
 #include "crypto/KeyUtils.h"
 #include "herder/Herder.h"
 #include "history/HistoryArchive.h"
+#include "history/HttpFileFetcher.h"
 #include "ledger/LedgerManager.h"
 #include "main/ExternalQueue.h"
 #include "main/StellarCoreVersion.h"
 #include "scp/LocalNode.h"
 #include "scp/QuorumSetUtils.h"
+#include "util/BackgroundExecutor.h"
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
@@ -21,6 +23,7 @@
 #include "util/types.h"
 
 #include "overlay/OverlayManager.h"
+#include "overlay/Peer.h"
 #include "util/UnorderedSet.h"
 #include <fmt/chrono.h>
 #include <fmt/format.h>
@@ -122,6 +125,7 @@ Config::Config() : NODE_SEED(SecretKey::random())
     // non configurable
     MODE_ENABLES_BUCKETLIST = true;
     MODE_USES_IN_MEMORY_LEDGER = false;
+    MODE_REPLAY_ONLY = false;
     MODE_STORES_HISTORY_MISC = true;
     MODE_STORES_HISTORY_LEDGERHEADERS = true;
     MODE_DOES_CATCHUP = true;
@@ -166,6 +170,13 @@ Config::Config() : NODE_SEED(SecretKey::random())
     BUCKETLIST_DB_INDEX_PAGE_SIZE_EXPONENT = 14; // 2^14 == 16 kb
     BUCKETLIST_DB_INDEX_CUTOFF = 20;             // 20 mb
     BUCKETLIST_DB_PERSIST_INDEX = true;
+    BUCKETLIST_DB_MMAP_READS = false;
+    BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS = 0;
+    BUCKETLIST_DB_ENTRY_CACHE_SIZE = 0;
+    BUCKETLIST_DB_INDEX_THREADS = 4;
+    BUCKETLIST_DB_INDEX_MEMORY_BUDGET = 0;
+    BUCKETLIST_DB_MERGE_CACHE_BYPASS_SIZE = 100;
+    HISTORY_BUCKET_INDEXES = false;
     EXPERIMENTAL_BACKGROUND_EVICTION_SCAN = false;
     PUBLISH_TO_ARCHIVE_DELAY = std::chrono::seconds{0};
     // automatic maintenance settings:
@@ -206,14 +217,21 @@ Config::Config() : NODE_SEED(SecretKey::random())
                                Herder::EXP_LEDGER_TIMESPAN_SECONDS.count(),
                            CLOSETIME_DRIFT_LIMIT);
     METADATA_OUTPUT_STREAM = "";
+    METADATA_OUTPUT_STREAM_QUEUE = 0;
+    METADATA_OUTPUT_STREAM_FULL_POLICY = "BLOCK";
+    METADATA_OUTPUT_STREAM_FORMAT = "XDR";
+    METADATA_OUTPUT_STREAM_COMPRESSION = 0;
 
     // Store at least 1 checkpoint plus a buffer worth of debug meta
     METADATA_DEBUG_LEDGERS = 100;
 
     LOG_FILE_PATH = "stellar-core-{datetime:%Y-%m-%d_%H-%M-%S}.log";
     BUCKET_DIR_PATH = "buckets";
+    DEEP_BUCKET_DIR_PATH = "";
+    DEEP_BUCKET_DIR_FIRST_LEVEL = 7;
 
     LOG_COLOR = false;
+    LOG_ASYNC_QUEUE_SIZE = 8192;
 
     TESTING_UPGRADE_LEDGER_PROTOCOL_VERSION = LEDGER_PROTOCOL_VERSION;
     TESTING_UPGRADE_DESIRED_FEE = LedgerManager::GENESIS_LEDGER_BASE_FEE;
@@ -224,6 +242,11 @@ Config::Config() : NODE_SEED(SecretKey::random())
     HTTP_PORT = DEFAULT_PEER_PORT + 1;
     PUBLIC_HTTP_PORT = false;
     HTTP_MAX_CLIENT = 128;
+    HTTP_COMMAND_THREADS = 2;
+    HTTP_QUERY_PORT = 0;
+    QUERY_THREAD_POOL_SIZE = 4;
+    PROMETHEUS_HTTP_PORT = 0;
+    PROMETHEUS_SNAPSHOT_PERIOD = std::chrono::seconds(5);
     PEER_PORT = DEFAULT_PEER_PORT;
     TARGET_PEER_CONNECTIONS = 8;
     MAX_PENDING_CONNECTIONS = 500;
@@ -231,24 +254,32 @@ Config::Config() : NODE_SEED(SecretKey::random())
     MAX_OUTBOUND_PENDING_CONNECTIONS = 0;
     MAX_INBOUND_PENDING_CONNECTIONS = 0;
     PEER_AUTHENTICATION_TIMEOUT = 2;
+    PEER_AUTH_RESUMPTION = false;
     PEER_TIMEOUT = 30;
     PEER_STRAGGLER_TIMEOUT = 120;
+    PEER_TABLE_FLUSH_PERIOD_MS = std::chrono::milliseconds(0);
 
     FLOOD_OP_RATE_PER_LEDGER = 1.0;
     FLOOD_TX_PERIOD_MS = 200;
 
     FLOOD_SOROBAN_RATE_PER_LEDGER = 1.0;
     FLOOD_SOROBAN_TX_PERIOD_MS = 200;
+    ADAPTIVE_TX_FLOOD_PACING = false;
 
     FLOOD_ARB_TX_BASE_ALLOWANCE = 5;
     FLOOD_ARB_TX_DAMPING_FACTOR = 0.8;
 
     FLOOD_DEMAND_PERIOD_MS = std::chrono::milliseconds(200);
     FLOOD_ADVERT_PERIOD_MS = std::chrono::milliseconds(100);
+    FLOOD_ADVERT_FANOUT = 0;
     FLOOD_DEMAND_BACKOFF_DELAY_MS = std::chrono::milliseconds(500);
+    ADAPTIVE_TX_DEMANDS = false;
+    SCP_RELAY_QUORUM_FIRST = false;
 
     MAX_BATCH_WRITE_COUNT = 1024;
     MAX_BATCH_WRITE_BYTES = 1 * 1024 * 1024;
+    OUTBOUND_PRIORITY_SCHEDULING = false;
+    PEER_TCP_NOTSENT_LOWAT = 0;
     PREFERRED_PEERS_ONLY = false;
 
     PEER_READING_CAPACITY = 200;
@@ -259,8 +290,16 @@ Config::Config() : NODE_SEED(SecretKey::random())
     // startup as we need to load soroban configs)
     PEER_FLOOD_READING_CAPACITY_BYTES = 0;
     FLOW_CONTROL_SEND_MORE_BATCH_SIZE_BYTES = 0;
+    FLOW_CONTROL_MAX_CAPACITY_FACTOR = 1;
     OUTBOUND_TX_QUEUE_BYTE_LIMIT = 1024 * 1024 * 3;
+    OUTBOUND_TX_QUEUE_TRIM_BY_FEE = false;
     ENABLE_FLOW_CONTROL_BYTES = true;
+    BACKGROUND_OVERLAY_DECODE = false;
+    BACKGROUND_TX_HISTORY_WRITES = false;
+    BACKGROUND_MAINTENANCE = false;
+    EARLY_DUPLICATE_TX_DETECTION = false;
+    MAX_PARALLEL_FETCH_PEERS = 1;
+    BACKGROUND_SURVEY_PROCESSING = false;
 
     // WORKER_THREADS: setting this too low risks a form of priority inversion
     // where a long-running background task occupies all worker threads and
@@ -273,22 +312,57 @@ Config::Config() : NODE_SEED(SecretKey::random())
     //
     // Worst case = 10 concurrent merges + 1 quorum intersection calculation.
     WORKER_THREADS = 11;
+    BUCKET_MERGE_THREADS = 0;
     MAX_CONCURRENT_SUBPROCESSES = 16;
+    MAX_CONCURRENT_DOWNLOAD_SUBPROCESSES = 0;
+    MAX_CONCURRENT_COMPRESSION_SUBPROCESSES = 0;
+    MAX_CONCURRENT_UPLOAD_SUBPROCESSES = 0;
+    BACKGROUND_SUBPROCESS_NICENESS = 0;
+    BACKGROUND_SUBPROCESS_IDLE_IO = false;
+    ZONE_PROFILER_SAMPLE_PERIOD = 64;
+    HISTORY_HTTP_CLIENT = false;
+    HISTORY_HTTP_MAX_CONNECTIONS = 8;
+    HISTORY_STRIPED_DOWNLOADS = false;
+    CATCHUP_MAX_DOWNLOAD_AHEAD = 0;
+    CATCHUP_RESUMABLE = false;
+    CATCHUP_TRUSTED_REPLAY = false;
+    BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL = 1;
+    GZIP_THREADS = 0;
     NODE_IS_VALIDATOR = false;
     QUORUM_INTERSECTION_CHECKER = true;
+    QUORUM_INTERSECTION_CHECKER_THREADS = 2;
+    INVARIANT_CHECK_THREADS = 0;
+    INVARIANT_CHECK_SAMPLE_PERCENT = 100;
     DATABASE = SecretValue{"sqlite3://:memory:"};
 
     ENTRY_CACHE_SIZE = 100000;
+    ENTRY_CACHE_SIZE_MB = 0;
+    LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB = 0;
+    WARM_START_CACHE = false;
+    MEMORY_BUDGET_MB = 0;
+    VERIFY_SIG_CACHE_SIZE = PubKeyUtils::DEFAULT_VERIFY_SIG_CACHE_SIZE;
+    EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION = false;
+    TX_SET_VALIDATION_SIG_VERIFY_THREADS = 0;
+    EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION = false;
     PREFETCH_BATCH_SIZE = 1000;
+    PREFETCH_WORKER_THREADS = 3;
+    EXPERIMENTAL_SPECULATIVE_PREFETCH = false;
+    EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS = 0;
+    SLOW_LEDGER_APPLY_LOG_THRESHOLD_MS = 0;
+    IN_MEMORY_ORDER_BOOK = false;
+    IN_MEMORY_CONTRACT_CODE_AND_TTL = false;
+    IN_MEMORY_LIQUIDITY_POOLS = false;
 
     HISTOGRAM_WINDOW_SIZE = std::chrono::seconds(30);
 
     HALT_ON_INTERNAL_TRANSACTION_ERROR = false;
 
     MAX_DEX_TX_OPERATIONS_IN_TX_SET = std::nullopt;
+    CLASSIC_TRANSACTION_QUEUE_MAX_BYTES = std::nullopt;
 
     ENABLE_SOROBAN_DIAGNOSTIC_EVENTS = false;
     ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION = false;
+    SOROBAN_CONTRACT_USAGE_TOP_N = 0;
     TESTING_MINIMUM_PERSISTENT_ENTRY_LIFETIME = 0;
     TESTING_SOROBAN_HIGH_LIMIT_OVERRIDE = false;
     OVERRIDE_EVICTION_PARAMS_FOR_TESTING = false;
@@ -548,10 +622,19 @@ Config::loadQset(std::shared_ptr<cpptoml::table> group, SCPQuorumSet& qset,
 
 void
 Config::addHistoryArchive(std::string const& name, std::string const& get,
-                          std::string const& put, std::string const& mkdir)
+                          std::string const& put, std::string const& mkdir,
+                          std::string const& putUrl,
+                          std::string const& putRegion)
 {
+    if (!putUrl.empty() && !HttpFileFetcher::parseUrl(putUrl))
+    {
+        throw std::invalid_argument(fmt::format(
+            FMT_STRING("Archive '{}' has a put_url that isn't an http:// URL"),
+            name));
+    }
     auto r = HISTORY.insert(std::make_pair(
-        name, HistoryArchiveConfiguration{name, get, put, mkdir}));
+        name, HistoryArchiveConfiguration{name, get, put, mkdir, putUrl,
+                                          putRegion}));
     if (!r.second)
     {
         throw std::invalid_argument(
@@ -1030,6 +1113,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 FLOW_CONTROL_SEND_MORE_BATCH_SIZE_BYTES =
                     readInt<uint32_t>(item, 1);
             }
+            else if (item.first == "FLOW_CONTROL_MAX_CAPACITY_FACTOR")
+            {
+                FLOW_CONTROL_MAX_CAPACITY_FACTOR = readInt<uint32_t>(item, 1);
+            }
             else if (item.first == "ENABLE_FLOW_CONTROL_BYTES")
             {
                 ENABLE_FLOW_CONTROL_BYTES = readBool(item);
@@ -1038,6 +1125,34 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 OUTBOUND_TX_QUEUE_BYTE_LIMIT = readInt<uint32_t>(item, 1);
             }
+            else if (item.first == "OUTBOUND_TX_QUEUE_TRIM_BY_FEE")
+            {
+                OUTBOUND_TX_QUEUE_TRIM_BY_FEE = readBool(item);
+            }
+            else if (item.first == "BACKGROUND_OVERLAY_DECODE")
+            {
+                BACKGROUND_OVERLAY_DECODE = readBool(item);
+            }
+            else if (item.first == "BACKGROUND_TX_HISTORY_WRITES")
+            {
+                BACKGROUND_TX_HISTORY_WRITES = readBool(item);
+            }
+            else if (item.first == "BACKGROUND_MAINTENANCE")
+            {
+                BACKGROUND_MAINTENANCE = readBool(item);
+            }
+            else if (item.first == "EARLY_DUPLICATE_TX_DETECTION")
+            {
+                EARLY_DUPLICATE_TX_DETECTION = readBool(item);
+            }
+            else if (item.first == "MAX_PARALLEL_FETCH_PEERS")
+            {
+                MAX_PARALLEL_FETCH_PEERS = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "BACKGROUND_SURVEY_PROCESSING")
+            {
+                BACKGROUND_SURVEY_PROCESSING = readBool(item);
+            }
             else if (item.first == "PEER_PORT")
             {
                 PEER_PORT = readInt<unsigned short>(item, 1);
@@ -1054,6 +1169,27 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 PUBLIC_HTTP_PORT = readBool(item);
             }
+            else if (item.first == "HTTP_QUERY_PORT")
+            {
+                HTTP_QUERY_PORT = readInt<unsigned short>(item);
+            }
+            else if (item.first == "HTTP_COMMAND_THREADS")
+            {
+                HTTP_COMMAND_THREADS = readInt<int>(item, 0);
+            }
+            else if (item.first == "QUERY_THREAD_POOL_SIZE")
+            {
+                QUERY_THREAD_POOL_SIZE = readInt<int>(item, 1);
+            }
+            else if (item.first == "PROMETHEUS_HTTP_PORT")
+            {
+                PROMETHEUS_HTTP_PORT = readInt<unsigned short>(item);
+            }
+            else if (item.first == "PROMETHEUS_SNAPSHOT_PERIOD")
+            {
+                PROMETHEUS_SNAPSHOT_PERIOD =
+                    std::chrono::seconds{readInt<uint32_t>(item, 1)};
+            }
             else if (item.first == "FAILURE_SAFETY")
             {
                 FAILURE_SAFETY = readInt<int32_t>(item, -1, INT32_MAX - 1);
@@ -1070,6 +1206,46 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 METADATA_OUTPUT_STREAM = readString(item);
             }
+            else if (item.first == "METADATA_OUTPUT_STREAM_QUEUE")
+            {
+                METADATA_OUTPUT_STREAM_QUEUE = readInt<uint32_t>(item);
+            }
+            else if (item.first == "METADATA_OUTPUT_STREAM_FULL_POLICY")
+            {
+                METADATA_OUTPUT_STREAM_FULL_POLICY = readString(item);
+                if (METADATA_OUTPUT_STREAM_FULL_POLICY != "BLOCK" &&
+                    METADATA_OUTPUT_STREAM_FULL_POLICY != "FAIL")
+                {
+                    throw std::invalid_argument(fmt::format(
+                        FMT_STRING("invalid METADATA_OUTPUT_STREAM_FULL_POLICY "
+                                   "'{}', expected BLOCK or FAIL"),
+                        METADATA_OUTPUT_STREAM_FULL_POLICY));
+                }
+            }
+            else if (item.first == "METADATA_OUTPUT_STREAM_FORMAT")
+            {
+                METADATA_OUTPUT_STREAM_FORMAT = readString(item);
+                if (METADATA_OUTPUT_STREAM_FORMAT != "XDR" &&
+                    METADATA_OUTPUT_STREAM_FORMAT != "FRAMED")
+                {
+                    throw std::invalid_argument(fmt::format(
+                        FMT_STRING("invalid METADATA_OUTPUT_STREAM_FORMAT "
+                                   "'{}', expected XDR or FRAMED"),
+                        METADATA_OUTPUT_STREAM_FORMAT));
+                }
+            }
+            else if (item.first == "METADATA_OUTPUT_STREAM_COMPRESSION")
+            {
+                METADATA_OUTPUT_STREAM_COMPRESSION = readInt<int>(item, 0, 9);
+#ifndef USE_ZLIB
+                if (METADATA_OUTPUT_STREAM_COMPRESSION != 0)
+                {
+                    throw std::invalid_argument(
+                        "METADATA_OUTPUT_STREAM_COMPRESSION needs zlib, "
+                        "which this build doesn't have");
+                }
+#endif
+            }
             else if (item.first == "EXPERIMENTAL_PRECAUTION_DELAY_META")
             {
                 EXPERIMENTAL_PRECAUTION_DELAY_META = readBool(item);
@@ -1129,6 +1305,43 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 BUCKETLIST_DB_PERSIST_INDEX = readBool(item);
             }
+            else if (item.first == "BUCKETLIST_DB_MMAP_READS")
+            {
+                BUCKETLIST_DB_MMAP_READS = readBool(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS")
+            {
+                BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS =
+                    readInt<uint32_t>(item, 0, 16);
+                if (BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS != 0 &&
+                    BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS != 8 &&
+                    BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS != 16)
+                {
+                    throw std::invalid_argument(
+                        "BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS must be 0, 8 "
+                        "or 16");
+                }
+            }
+            else if (item.first == "BUCKETLIST_DB_ENTRY_CACHE_SIZE")
+            {
+                BUCKETLIST_DB_ENTRY_CACHE_SIZE = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_INDEX_THREADS")
+            {
+                BUCKETLIST_DB_INDEX_THREADS = readInt<size_t>(item, 1, 64);
+            }
+            else if (item.first == "BUCKETLIST_DB_INDEX_MEMORY_BUDGET")
+            {
+                BUCKETLIST_DB_INDEX_MEMORY_BUDGET = readInt<size_t>(item);
+            }
+            else if (item.first == "BUCKETLIST_DB_MERGE_CACHE_BYPASS_SIZE")
+            {
+                BUCKETLIST_DB_MERGE_CACHE_BYPASS_SIZE = readInt<size_t>(item);
+            }
+            else if (item.first == "HISTORY_BUCKET_INDEXES")
+            {
+                HISTORY_BUCKET_INDEXES = readBool(item);
+            }
             else if (item.first == "METADATA_DEBUG_LEDGERS")
             {
                 METADATA_DEBUG_LEDGERS = readInt<uint32_t>(item);
@@ -1221,10 +1434,41 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 LOG_COLOR = readBool(item);
             }
+            else if (item.first == "LOG_ASYNC_PARTITIONS")
+            {
+                LOG_ASYNC_PARTITIONS.clear();
+                for (auto const& p : readArray<std::string>(item))
+                {
+                    try
+                    {
+                        LOG_ASYNC_PARTITIONS.emplace_back(
+                            Logging::normalizePartition(p));
+                    }
+                    catch (std::invalid_argument const&)
+                    {
+                        throw std::invalid_argument(fmt::format(
+                            FMT_STRING("invalid LOG_ASYNC_PARTITIONS entry {}"),
+                            p));
+                    }
+                }
+            }
+            else if (item.first == "LOG_ASYNC_QUEUE_SIZE")
+            {
+                LOG_ASYNC_QUEUE_SIZE = readInt<uint32_t>(item, 2);
+            }
             else if (item.first == "BUCKET_DIR_PATH")
             {
                 BUCKET_DIR_PATH = readString(item);
             }
+            else if (item.first == "DEEP_BUCKET_DIR_PATH")
+            {
+                DEEP_BUCKET_DIR_PATH = readString(item);
+            }
+            else if (item.first == "DEEP_BUCKET_DIR_FIRST_LEVEL")
+            {
+                DEEP_BUCKET_DIR_FIRST_LEVEL =
+                    readInt<uint32_t>(item, 1, BucketList::kNumLevels - 1);
+            }
             else if (item.first == "NODE_NAMES")
             {
                 auto names = readArray<std::string>(item);
@@ -1266,6 +1510,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 PEER_AUTHENTICATION_TIMEOUT = readInt<unsigned short>(
                     item, 1, std::numeric_limits<unsigned short>::max());
             }
+            else if (item.first == "PEER_AUTH_RESUMPTION")
+            {
+                PEER_AUTH_RESUMPTION = readBool(item);
+            }
             else if (item.first == "PEER_TIMEOUT")
             {
                 PEER_TIMEOUT = readInt<unsigned short>(
@@ -1276,6 +1524,11 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 PEER_STRAGGLER_TIMEOUT = readInt<unsigned short>(
                     item, 1, std::numeric_limits<unsigned short>::max());
             }
+            else if (item.first == "PEER_TABLE_FLUSH_PERIOD_MS")
+            {
+                PEER_TABLE_FLUSH_PERIOD_MS =
+                    std::chrono::milliseconds(readInt<int>(item, 0));
+            }
             else if (item.first == "MAX_BATCH_WRITE_COUNT")
             {
                 MAX_BATCH_WRITE_COUNT = readInt<int>(item, 1);
@@ -1284,6 +1537,14 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 MAX_BATCH_WRITE_BYTES = readInt<int>(item, 1);
             }
+            else if (item.first == "OUTBOUND_PRIORITY_SCHEDULING")
+            {
+                OUTBOUND_PRIORITY_SCHEDULING = readBool(item);
+            }
+            else if (item.first == "PEER_TCP_NOTSENT_LOWAT")
+            {
+                PEER_TCP_NOTSENT_LOWAT = readInt<int>(item, 0);
+            }
             else if (item.first == "FLOOD_OP_RATE_PER_LEDGER")
             {
                 FLOOD_OP_RATE_PER_LEDGER = readDouble(item);
@@ -1310,6 +1571,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 FLOOD_SOROBAN_TX_PERIOD_MS = readInt<int>(item, 1);
             }
+            else if (item.first == "ADAPTIVE_TX_FLOOD_PACING")
+            {
+                ADAPTIVE_TX_FLOOD_PACING = readBool(item);
+            }
             else if (item.first == "FLOOD_DEMAND_PERIOD_MS")
             {
                 FLOOD_DEMAND_PERIOD_MS =
@@ -1320,11 +1585,23 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 FLOOD_ADVERT_PERIOD_MS =
                     std::chrono::milliseconds(readInt<int>(item, 1));
             }
+            else if (item.first == "FLOOD_ADVERT_FANOUT")
+            {
+                FLOOD_ADVERT_FANOUT = readInt<int>(item, 0);
+            }
             else if (item.first == "FLOOD_DEMAND_BACKOFF_DELAY_MS")
             {
                 FLOOD_DEMAND_BACKOFF_DELAY_MS =
                     std::chrono::milliseconds(readInt<int>(item, 1));
             }
+            else if (item.first == "ADAPTIVE_TX_DEMANDS")
+            {
+                ADAPTIVE_TX_DEMANDS = readBool(item);
+            }
+            else if (item.first == "SCP_RELAY_QUORUM_FIRST")
+            {
+                SCP_RELAY_QUORUM_FIRST = readBool(item);
+            }
             else if (item.first == "FLOOD_ARB_TX_BASE_ALLOWANCE")
             {
                 FLOOD_ARB_TX_BASE_ALLOWANCE = readInt<int32_t>(item, -1);
@@ -1369,14 +1646,151 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 WORKER_THREADS = readInt<int>(item, 2, 1000);
             }
+            else if (item.first == "BUCKET_MERGE_THREADS")
+            {
+                BUCKET_MERGE_THREADS = readInt<int>(item, 0, 1000);
+            }
+            else if (item.first == "SCHEDULER_LATENCY_SLOS")
+            {
+                // Items are "<action class>=<milliseconds>"
+                SCHEDULER_LATENCY_SLOS.clear();
+                for (auto const& v : readArray<std::string>(item))
+                {
+                    auto sep = v.find('=');
+                    std::string cls = v.substr(0, sep);
+                    int64_t ms = 0;
+                    if (sep != std::string::npos)
+                    {
+                        try
+                        {
+                            ms = std::stoll(v.substr(sep + 1));
+                        }
+                        catch (std::exception&)
+                        {
+                        }
+                    }
+                    if (cls.empty() || cls.find(' ') != std::string::npos ||
+                        ms <= 0 ||
+                        !SCHEDULER_LATENCY_SLOS
+                             .emplace(cls, std::chrono::milliseconds(ms))
+                             .second)
+                    {
+                        throw std::invalid_argument(fmt::format(
+                            FMT_STRING("invalid SCHEDULER_LATENCY_SLOS item "
+                                       "'{}'"),
+                            v));
+                    }
+                }
+            }
+            else if (item.first == "BACKGROUND_TASK_LIMITS")
+            {
+                // Items are "<class>=<limit>"
+                BACKGROUND_TASK_LIMITS.clear();
+                for (auto const& v : readArray<std::string>(item))
+                {
+                    auto sep = v.find('=');
+                    std::string name = v.substr(0, sep);
+                    size_t limit = 0;
+                    if (sep != std::string::npos)
+                    {
+                        try
+                        {
+                            limit = std::stoul(v.substr(sep + 1));
+                        }
+                        catch (std::exception&)
+                        {
+                        }
+                    }
+                    if (!backgroundTaskClassFromName(name) || limit == 0 ||
+                        !BACKGROUND_TASK_LIMITS.emplace(name, limit).second)
+                    {
+                        throw std::invalid_argument(fmt::format(
+                            FMT_STRING("invalid BACKGROUND_TASK_LIMITS item "
+                                       "'{}'"),
+                            v));
+                    }
+                }
+            }
+            else if (item.first == "ZONE_PROFILER_SAMPLE_PERIOD")
+            {
+                // Sampled zones have countdowns up to twice the period
+                ZONE_PROFILER_SAMPLE_PERIOD =
+                    readInt<uint32_t>(item, 0, UINT32_MAX / 2);
+            }
             else if (item.first == "MAX_CONCURRENT_SUBPROCESSES")
             {
                 MAX_CONCURRENT_SUBPROCESSES = readInt<size_t>(item, 1);
             }
+            else if (item.first == "MAX_CONCURRENT_DOWNLOAD_SUBPROCESSES")
+            {
+                MAX_CONCURRENT_DOWNLOAD_SUBPROCESSES = readInt<size_t>(item);
+            }
+            else if (item.first == "MAX_CONCURRENT_COMPRESSION_SUBPROCESSES")
+            {
+                MAX_CONCURRENT_COMPRESSION_SUBPROCESSES =
+                    readInt<size_t>(item);
+            }
+            else if (item.first == "MAX_CONCURRENT_UPLOAD_SUBPROCESSES")
+            {
+                MAX_CONCURRENT_UPLOAD_SUBPROCESSES = readInt<size_t>(item);
+            }
+            else if (item.first == "BACKGROUND_SUBPROCESS_NICENESS")
+            {
+                BACKGROUND_SUBPROCESS_NICENESS = readInt<int>(item, 0, 19);
+            }
+            else if (item.first == "BACKGROUND_SUBPROCESS_IDLE_IO")
+            {
+                BACKGROUND_SUBPROCESS_IDLE_IO = readBool(item);
+            }
+            else if (item.first == "HISTORY_HTTP_CLIENT")
+            {
+                HISTORY_HTTP_CLIENT = readBool(item);
+            }
+            else if (item.first == "HISTORY_HTTP_MAX_CONNECTIONS")
+            {
+                HISTORY_HTTP_MAX_CONNECTIONS = readInt<size_t>(item, 1);
+            }
+            else if (item.first == "HISTORY_STRIPED_DOWNLOADS")
+            {
+                HISTORY_STRIPED_DOWNLOADS = readBool(item);
+            }
+            else if (item.first == "CATCHUP_MAX_DOWNLOAD_AHEAD")
+            {
+                CATCHUP_MAX_DOWNLOAD_AHEAD = readInt<uint32_t>(item, 0);
+            }
+            else if (item.first == "CATCHUP_RESUMABLE")
+            {
+                CATCHUP_RESUMABLE = readBool(item);
+            }
+            else if (item.first == "CATCHUP_TRUSTED_REPLAY")
+            {
+                CATCHUP_TRUSTED_REPLAY = readBool(item);
+            }
+            else if (item.first == "BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL")
+            {
+                BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL =
+                    readInt<uint32_t>(item, 1);
+            }
+            else if (item.first == "GZIP_THREADS")
+            {
+                GZIP_THREADS = readInt<uint32_t>(item, 0, 256);
+#ifndef USE_ZLIB
+                if (GZIP_THREADS != 0)
+                {
+                    throw std::invalid_argument(
+                        "GZIP_THREADS needs stellar-core built with zlib");
+                }
+#endif
+            }
             else if (item.first == "QUORUM_INTERSECTION_CHECKER")
             {
                 QUORUM_INTERSECTION_CHECKER = readBool(item);
             }
+            else if (item.first == "QUORUM_INTERSECTION_CHECKER_THREADS")
+            {
+                QUORUM_INTERSECTION_CHECKER_THREADS =
+                    readInt<uint32_t>(item, 1, 64);
+            }
             else if (item.first == "HISTORY")
             {
                 auto hist = item.second->as_table();
@@ -1392,7 +1806,7 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                             throw std::invalid_argument(
                                 "malformed HISTORY config block");
                         }
-                        std::string get, put, mkdir;
+                        std::string get, put, mkdir, putUrl, putRegion;
                         for (auto const& c : *tab)
                         {
                             if (c.first == "get")
@@ -1407,6 +1821,14 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                             {
                                 mkdir = c.second->as<std::string>()->get();
                             }
+                            else if (c.first == "put_url")
+                            {
+                                putUrl = c.second->as<std::string>()->get();
+                            }
+                            else if (c.first == "put_region")
+                            {
+                                putRegion = c.second->as<std::string>()->get();
+                            }
                             else
                             {
                                 std::string err(
@@ -1417,7 +1839,8 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                                 throw std::invalid_argument(err);
                             }
                         }
-                        addHistoryArchive(archive.first, get, put, mkdir);
+                        addHistoryArchive(archive.first, get, put, mkdir,
+                                          putUrl, putRegion);
                     }
                 }
                 else
@@ -1437,14 +1860,102 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 INVARIANT_CHECKS = readArray<std::string>(item);
             }
+            else if (item.first == "INVARIANT_CHECK_THREADS")
+            {
+                INVARIANT_CHECK_THREADS = readInt<uint32_t>(item, 0, 64);
+            }
+            else if (item.first == "INVARIANT_CHECK_SAMPLE_PERCENT")
+            {
+                INVARIANT_CHECK_SAMPLE_PERCENT =
+                    readInt<uint32_t>(item, 1, 100);
+            }
             else if (item.first == "ENTRY_CACHE_SIZE")
             {
                 ENTRY_CACHE_SIZE = readInt<uint32_t>(item);
             }
+            else if (item.first == "ENTRY_CACHE_SIZE_MB")
+            {
+                ENTRY_CACHE_SIZE_MB = readInt<uint32_t>(item);
+            }
+            else if (item.first == "LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB")
+            {
+                LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB = readInt<uint32_t>(item);
+            }
+            else if (item.first == "WARM_START_CACHE")
+            {
+                WARM_START_CACHE = readBool(item);
+            }
+            else if (item.first == "MEMORY_BUDGET_MB")
+            {
+                MEMORY_BUDGET_MB = readInt<uint32_t>(item);
+            }
+            else if (item.first == "VERIFY_SIG_CACHE_SIZE")
+            {
+                VERIFY_SIG_CACHE_SIZE = readInt<uint32_t>(item, 1);
+            }
+            else if (item.first ==
+                     "EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION")
+            {
+                EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION = readBool(item);
+            }
+            else if (item.first == "TX_SET_VALIDATION_SIG_VERIFY_THREADS")
+            {
+                TX_SET_VALIDATION_SIG_VERIFY_THREADS =
+                    readInt<uint32_t>(item, 0, 64);
+            }
+            else if (item.first ==
+                     "EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION")
+            {
+                EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION = readBool(item);
+            }
             else if (item.first == "PREFETCH_BATCH_SIZE")
             {
                 PREFETCH_BATCH_SIZE = readInt<uint32_t>(item);
             }
+            else if (item.first == "PREFETCH_WORKER_THREADS")
+            {
+                PREFETCH_WORKER_THREADS = readInt<uint32_t>(item, 0, 64);
+            }
+            else if (item.first == "EXPERIMENTAL_SPECULATIVE_PREFETCH")
+            {
+                EXPERIMENTAL_SPECULATIVE_PREFETCH = readBool(item);
+            }
+            else if (item.first ==
+                     "EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS")
+            {
+                EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS =
+                    readInt<uint32_t>(item, 0, 64);
+            }
+            else if (item.first == "SLOW_LEDGER_APPLY_LOG_THRESHOLD_MS")
+            {
+                SLOW_LEDGER_APPLY_LOG_THRESHOLD_MS = readInt<uint32_t>(item);
+            }
+            else if (item.first == "IN_MEMORY_ORDER_BOOK")
+            {
+                IN_MEMORY_ORDER_BOOK = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_CONTRACT_CODE_AND_TTL")
+            {
+                IN_MEMORY_CONTRACT_CODE_AND_TTL = readBool(item);
+            }
+            else if (item.first == "IN_MEMORY_LIQUIDITY_POOLS")
+            {
+                IN_MEMORY_LIQUIDITY_POOLS = readBool(item);
+            }
+            else if (item.first == "POSTGRES_COPY_UPSERT_ENTRY_TYPES")
+            {
+                POSTGRES_COPY_UPSERT_ENTRY_TYPES =
+                    readXdrEnumArray<LedgerEntryType>(item);
+                for (auto t : POSTGRES_COPY_UPSERT_ENTRY_TYPES)
+                {
+                    if (t != OFFER && t != ACCOUNT && t != TRUSTLINE)
+                    {
+                        throw std::invalid_argument(fmt::format(
+                            FMT_STRING("unsupported element of '{}'"),
+                            item.first));
+                    }
+                }
+            }
             else if (item.first == "MAXIMUM_LEDGER_CLOSETIME_DRIFT")
             {
                 MAXIMUM_LEDGER_CLOSETIME_DRIFT = readInt<int64_t>(item, 0);
@@ -1581,6 +2092,10 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
             {
                 ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION = readBool(item);
             }
+            else if (item.first == "SOROBAN_CONTRACT_USAGE_TOP_N")
+            {
+                SOROBAN_CONTRACT_USAGE_TOP_N = readInt<uint32_t>(item);
+            }
             else if (item.first == "TESTING_MINIMUM_PERSISTENT_ENTRY_LIFETIME")
             {
                 TESTING_MINIMUM_PERSISTENT_ENTRY_LIFETIME =
@@ -1653,6 +2168,19 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
                 MAX_DEX_TX_OPERATIONS_IN_TX_SET =
                     value == 0 ? std::nullopt : std::make_optional(value);
             }
+            else if (item.first == "CLASSIC_TRANSACTION_QUEUE_MAX_BYTES")
+            {
+                auto value = readInt<uint32_t>(item);
+                if (value > 0 && value < MAX_CLASSIC_TX_SIZE_BYTES)
+                {
+                    throw std::invalid_argument(fmt::format(
+                        "CLASSIC_TRANSACTION_QUEUE_MAX_BYTES must be either 0 "
+                        "or at least {} in order to fit any transaction.",
+                        MAX_CLASSIC_TX_SIZE_BYTES));
+                }
+                CLASSIC_TRANSACTION_QUEUE_MAX_BYTES =
+                    value == 0 ? std::nullopt : std::make_optional(value);
+            }
             else if (item.first == "EMIT_SOROBAN_TRANSACTION_META_EXT_V1")
             {
                 EMIT_SOROBAN_TRANSACTION_META_EXT_V1 = readBool(item);
@@ -1728,6 +2256,12 @@ Config::processConfig(std::shared_ptr<cpptoml::table> t)
         // Validators default to starting the network from local state
         FORCE_SCP = NODE_IS_VALIDATOR;
 
+        if (NODE_IS_VALIDATOR && CATCHUP_TRUSTED_REPLAY)
+        {
+            throw std::invalid_argument(
+                "CATCHUP_TRUSTED_REPLAY can't be used with NODE_IS_VALIDATOR");
+        }
+
         // Require either DEPRECATED_SQL_LEDGER_STATE or
         // EXPERIMENTAL_BUCKETLIST_DB to be backwards compatible with horizon
         // and RPC, but do not allow both.
@@ -2299,6 +2833,15 @@ Config::setInMemoryMode()
     MODE_ENABLES_BUCKETLIST = true;
 }
 
+void
+Config::setInMemoryReplayMode()
+{
+    setInMemoryMode();
+    MODE_REPLAY_ONLY = true;
+    // The meta of every ledger goes to METADATA_OUTPUT_STREAM already
+    METADATA_DEBUG_LEDGERS = 0;
+}
+
 bool
 Config::modeDoesCatchupWithBucketList() const
 {
@@ -2318,6 +2861,12 @@ Config::isUsingBucketListDB() const
            MODE_ENABLES_BUCKETLIST;
 }
 
+bool
+Config::isUsingHistoryBucketIndexes() const
+{
+    return HISTORY_BUCKET_INDEXES && isPersistingBucketListDBIndexes();
+}
+
 bool
 Config::isPersistingBucketListDBIndexes() const
 {
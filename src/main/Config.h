@@ -28,6 +28,11 @@ struct HistoryArchiveConfiguration
     std::string mGetCmd;
     std::string mPutCmd;
     std::string mMkdirCmd;
+    // With HISTORY_HTTP_CLIENT, files are uploaded to this S3-compatible
+    // http:// URL, the archive's root, instead of with mPutCmd
+    std::string mPutUrl{};
+    // Region the uploads to mPutUrl are signed for
+    std::string mPutRegion{};
 };
 
 enum class ValidationThresholdLevels : int
@@ -74,7 +79,9 @@ class Config : public std::enable_shared_from_this<Config>
     void addValidatorName(std::string const& pubKeyStr,
                           std::string const& name);
     void addHistoryArchive(std::string const& name, std::string const& get,
-                           std::string const& put, std::string const& mkdir);
+                           std::string const& put, std::string const& mkdir,
+                           std::string const& putUrl = "",
+                           std::string const& putRegion = "");
 
     std::string toString(ValidatorQuality q) const;
     ValidatorQuality parseQuality(std::string const& q) const;
@@ -324,6 +331,12 @@ class Config : public std::enable_shared_from_this<Config>
     uint32_t PEER_FLOOD_READING_CAPACITY_BYTES;
     uint32_t FLOW_CONTROL_SEND_MORE_BATCH_SIZE_BYTES;
 
+    // When greater than 1, the flood capacities above (and
+    // PEER_READING_CAPACITY with them) are only a minimum: each peer's
+    // windows are resized to what it can use given its round trip time and
+    // the rate we process its messages, up to this many times the minimum.
+    uint32_t FLOW_CONTROL_MAX_CAPACITY_FACTOR;
+
     // Enable flow control in bytes. This config allows core to process large
     // transactions on the network more efficiently and apply back pressure if
     // needed.
@@ -332,6 +345,42 @@ class Config : public std::enable_shared_from_this<Config>
     // Byte limit for outbound transaction queue.
     uint32_t OUTBOUND_TX_QUEUE_BYTE_LIMIT;
 
+    // When set to true, the outbound transaction queue of a peer that is
+    // over its limits drops its transactions with the lowest inclusion fee
+    // rate first, instead of the oldest ones.
+    bool OUTBOUND_TX_QUEUE_TRIM_BY_FEE;
+
+    // When set to true, messages received from authenticated peers are
+    // decoded and their MAC is verified on a dedicated overlay thread instead
+    // of the main thread.
+    bool BACKGROUND_OVERLAY_DECODE;
+
+    // When set to true, the txhistory and txfeehistory rows of a ledger are
+    // written by a dedicated thread after the ledger is committed, instead of
+    // while it closes. Ignored with in-memory databases.
+    bool BACKGROUND_TX_HISTORY_WRITES;
+
+    // When set to true, automatic maintenance deletes old history from a
+    // dedicated thread, in batches sized by how long they take, instead of
+    // AUTOMATIC_MAINTENANCE_COUNT ledgers at a time on the main thread.
+    // Ignored with in-memory databases.
+    bool BACKGROUND_MAINTENANCE;
+
+    // When set to true, transactions received again from a peer are
+    // recognized by a hash of their raw bytes and dropped before they are
+    // decoded.
+    bool EARLY_DUPLICATE_TX_DETECTION;
+
+    // Number of peers asked in parallel for a missing tx set or quorum set.
+    // Past the first one, a peer is only asked when the previous ones haven't
+    // answered within a delay based on their round trip time.
+    uint32_t MAX_PARALLEL_FETCH_PEERS;
+
+    // When set to true, survey responses are encrypted, signed and decrypted
+    // on a background thread, and the surveyor sends no requests while the
+    // main thread is overloaded.
+    bool BACKGROUND_SURVEY_PROCESSING;
+
     // A config parameter that allows a node to generate buckets. This should
     // be set to `false` only for testing purposes.
     bool MODE_ENABLES_BUCKETLIST;
@@ -342,6 +391,12 @@ class Config : public std::enable_shared_from_this<Config>
     // production validators.
     bool MODE_USES_IN_MEMORY_LEDGER;
 
+    // A config parameter that, with MODE_USES_IN_MEMORY_LEDGER, only replays
+    // history to emit its meta: the state of the last closed ledger is kept
+    // in memory rather than written to the database after every ledger, and
+    // no checkpoint is queued for publishing.
+    bool MODE_REPLAY_ONLY;
+
     // A config parameter that can be set to true (in a captive-core
     // configuration) to delay emitting metadata by one ledger.
     bool EXPERIMENTAL_PRECAUTION_DELAY_META;
@@ -365,12 +420,50 @@ class Config : public std::enable_shared_from_this<Config>
 
     // When set to true, BucketListDB indexes are persisted on-disk so that the
     // BucketList does not need to be reindexed on startup. Defaults to true.
-    // This should only be set to false for testing purposes
-    // Validators do not currently support persisted indexes. If
-    // NODE_IS_VALIDATOR=true, this value is ingnored and indexes are never
-    // persisted.
+    // This should only be set to false for testing purposes. Persisted
+    // indexes are validated against their bucket hash and index version on
+    // load, and rebuilt only if invalid.
     bool BUCKETLIST_DB_PERSIST_INDEX;
 
+    // When set to true, BucketListDB point and bulk loads decode entries
+    // directly from a read-only memory mapping of each bucket file rather
+    // than reading pages through a file stream. Only supported on POSIX
+    // systems.
+    bool BUCKETLIST_DB_MMAP_READS;
+
+    // Selects the membership filter used by range indexes to skip disk reads
+    // for keys a bucket does not contain. 0 selects the bloom filter. 8 or 16
+    // selects a binary fuse filter with fingerprints of that many bits.
+    uint32_t BUCKETLIST_DB_INDEX_FUSE_FILTER_BITS;
+
+    // Size, in MB, of the cache of decoded LedgerEntry's shared by all
+    // BucketListDB snapshots. The cache is cleared whenever the BucketList
+    // changes. If set to 0, no cache is used.
+    size_t BUCKETLIST_DB_ENTRY_CACHE_SIZE;
+
+    // Maximum number of threads used to build the index of a single large
+    // range indexed bucket. If set to 1, every bucket is indexed by a single
+    // sequential scan.
+    size_t BUCKETLIST_DB_INDEX_THREADS;
+
+    // Size, in MB, that persisted BucketListDB indexes may use in memory.
+    // Least recently used indexes beyond this are dropped and reloaded from
+    // disk on demand. Has no effect unless indexes are persisted. If set to 0,
+    // all indexes stay in memory.
+    size_t BUCKETLIST_DB_INDEX_MEMORY_BUDGET;
+
+    // Size, in MB, of merge inputs above which merge output is written behind
+    // the page cache: written pages are dropped from cache as the merge
+    // proceeds, so large merges do not evict pages used by BucketListDB
+    // lookups. If set to 0, merge output is always cached.
+    size_t BUCKETLIST_DB_MERGE_CACHE_BYPASS_SIZE;
+
+    // When set to true, the persisted BucketListDB indexes of the buckets
+    // published to history archives are published next to them, and catchup
+    // downloads the indexes of the buckets it downloads instead of building
+    // them when the archive has them. Only used with persisted indexes.
+    bool HISTORY_BUCKET_INDEXES;
+
     // When set to true, eviction scans occur on the background thread,
     // increasing performance. Requires EXPERIMENTAL_BUCKETLIST_DB.
     bool EXPERIMENTAL_BACKGROUND_EVICTION_SCAN;
@@ -449,6 +542,25 @@ class Config : public std::enable_shared_from_this<Config>
     // in consensus, only a passive "watcher" node.
     std::string METADATA_OUTPUT_STREAM;
 
+    // Number of ledgers of meta that can be queued for METADATA_OUTPUT_STREAM
+    // while a thread of its own writes it, so that ledger close doesn't wait
+    // for the reader. When 0, meta is written as the ledger closes.
+    uint32_t METADATA_OUTPUT_STREAM_QUEUE;
+
+    // What happens when a ledger closes while METADATA_OUTPUT_STREAM_QUEUE
+    // ledgers are queued: "BLOCK" waits for the reader, "FAIL" stops the node
+    // with an error.
+    std::string METADATA_OUTPUT_STREAM_FULL_POLICY;
+
+    // "XDR" writes the LedgerCloseMeta of each ledger to
+    // METADATA_OUTPUT_STREAM as an XDR record, "FRAMED" as a frame with a
+    // header giving its ledger, sizes and hash (see MetaStreamFormat.h).
+    std::string METADATA_OUTPUT_STREAM_FORMAT;
+
+    // zlib level, from 1 to 9, at which FRAMED meta is compressed, or 0 to
+    // leave it uncompressed.
+    int METADATA_OUTPUT_STREAM_COMPRESSION;
+
     // Number of ledgers worth of transaction metadata to preserve on disk for
     // debugging purposes. These records are automatically maintained and
     // rotated during processing, and are helpful for recovery in case of a
@@ -487,6 +599,16 @@ class Config : public std::enable_shared_from_this<Config>
     //   against each other.
     std::optional<uint32_t> MAX_DEX_TX_OPERATIONS_IN_TX_SET;
 
+    // Maximum total size, in bytes, of the classic transactions kept in the
+    // transaction queue.
+    //
+    // By default the classic queue is only limited by the number of
+    // operations, so a queue full of large transactions uses much more
+    // memory than one with small ones. Setting this to a non-nullopt value
+    // makes the queue also evict the lowest fee transactions when their total
+    // size goes above the limit.
+    std::optional<uint32_t> CLASSIC_TRANSACTION_QUEUE_MAX_BYTES;
+
     // note: all versions in the range
     // [OVERLAY_PROTOCOL_MIN_VERSION, OVERLAY_PROTOCOL_VERSION] must be handled
     uint32_t OVERLAY_PROTOCOL_MIN_VERSION; // min overlay version understood
@@ -494,8 +616,21 @@ class Config : public std::enable_shared_from_this<Config>
     std::string VERSION_STR;
     std::string LOG_FILE_PATH;
     bool LOG_COLOR;
+
+    // Log partitions whose messages are written out by a background thread
+    // through a queue of LOG_ASYNC_QUEUE_SIZE messages; messages logged when
+    // it is full are dropped.
+    std::vector<std::string> LOG_ASYNC_PARTITIONS;
+    uint32_t LOG_ASYNC_QUEUE_SIZE;
     std::string BUCKET_DIR_PATH;
 
+    // If set, buckets of BucketList levels DEEP_BUCKET_DIR_FIRST_LEVEL and
+    // deeper are written to this directory instead of BUCKET_DIR_PATH, so
+    // that the large, rarely read deep levels can live on cheaper storage.
+    // Bucket indexes always stay in BUCKET_DIR_PATH.
+    std::string DEEP_BUCKET_DIR_PATH;
+    uint32_t DEEP_BUCKET_DIR_FIRST_LEVEL;
+
     // Ledger protocol version for testing purposes. Defaulted to
     // LEDGER_PROTOCOL_VERSION. Used in the following scenarios: 1. to specify
     // the genesis ledger version (only when USE_CONFIG_FOR_GENESIS is true) 2.
@@ -509,6 +644,22 @@ class Config : public std::enable_shared_from_this<Config>
     unsigned short HTTP_PORT; // what port to listen for commands
     bool PUBLIC_HTTP_PORT;    // if you accept commands from not localhost
     int HTTP_MAX_CLIENT;      // maximum number of http clients, i.e backlog
+    // Threads serving HTTP_PORT. Commands needing the main thread are
+    // posted to it, the others are answered by these threads directly. 0
+    // serves everything on the main thread.
+    int HTTP_COMMAND_THREADS;
+
+    // Port for the read-only query server, which answers ledger state
+    // queries from BucketList snapshots on QUERY_THREAD_POOL_SIZE threads
+    // of its own. 0 disables it. Only supported with BucketListDB.
+    unsigned short HTTP_QUERY_PORT;
+    int QUERY_THREAD_POOL_SIZE;
+
+    // Port serving metrics in the Prometheus text format from a thread of
+    // its own, off a snapshot captured every PROMETHEUS_SNAPSHOT_PERIOD. 0
+    // disables it.
+    unsigned short PROMETHEUS_HTTP_PORT;
+    std::chrono::seconds PROMETHEUS_SNAPSHOT_PERIOD;
     std::string NETWORK_PASSPHRASE; // identifier for the network
 
     // overlay config
@@ -519,20 +670,46 @@ class Config : public std::enable_shared_from_this<Config>
     unsigned short MAX_INBOUND_PENDING_CONNECTIONS;
     unsigned short MAX_OUTBOUND_PENDING_CONNECTIONS;
     unsigned short PEER_AUTHENTICATION_TIMEOUT;
+    // When set to true, the auth cert a peer last authenticated with is
+    // remembered until it expires, and isn't verified again when the peer
+    // reconnects with it.
+    bool PEER_AUTH_RESUMPTION;
     unsigned short PEER_TIMEOUT;
     unsigned short PEER_STRAGGLER_TIMEOUT;
+    // How long changes to the peer table are kept in memory before they are
+    // written to the database, 0 to write them right away
+    std::chrono::milliseconds PEER_TABLE_FLUSH_PERIOD_MS;
     int MAX_BATCH_WRITE_COUNT;
     int MAX_BATCH_WRITE_BYTES;
+    // Hold outgoing messages by priority while a write to the peer is in
+    // progress, rather than queuing them for the socket in sending order,
+    // see TCPPeer::schedulePendingSends
+    bool OUTBOUND_PRIORITY_SCHEDULING;
+    // Limit of the bytes written to a peer socket and not sent yet by the
+    // kernel, 0 for no limit (TCP_NOTSENT_LOWAT)
+    int PEER_TCP_NOTSENT_LOWAT;
     double FLOOD_OP_RATE_PER_LEDGER;
     int FLOOD_TX_PERIOD_MS;
     double FLOOD_SOROBAN_RATE_PER_LEDGER;
     int FLOOD_SOROBAN_TX_PERIOD_MS;
+    // Adapt the transaction flood rounds to the load, see
+    // TransactionQueue::getNextFloodDelay
+    bool ADAPTIVE_TX_FLOOD_PACING;
     int32_t FLOOD_ARB_TX_BASE_ALLOWANCE;
     double FLOOD_ARB_TX_DAMPING_FACTOR;
 
     std::chrono::milliseconds FLOOD_DEMAND_PERIOD_MS;
     std::chrono::milliseconds FLOOD_ADVERT_PERIOD_MS;
+    // Number of peers a transaction is advertised to right away, 0 for all
+    // of them. See TxAdverts::queueDelayedOutgoingAdvert
+    int FLOOD_ADVERT_FANOUT;
     std::chrono::milliseconds FLOOD_DEMAND_BACKOFF_DELAY_MS;
+    // Route demands to the fastest, least loaded advertisers and adapt the
+    // retry delay to their pull latency, see TxDemandsManager
+    bool ADAPTIVE_TX_DEMANDS;
+    // Send SCP messages right away to the peers in the transitive quorum,
+    // before the other peers, see Floodgate::broadcast
+    bool SCP_RELAY_QUORUM_FIRST;
     static constexpr size_t const POSSIBLY_PREFERRED_EXTRA = 2;
     static constexpr size_t const REALLY_DEAD_NUM_FAILURES_CUTOFF = 120;
 
@@ -552,8 +729,73 @@ class Config : public std::enable_shared_from_this<Config>
     // thread-management config
     int WORKER_THREADS;
 
+    // Number of threads dedicated to bucket merges. When nonzero, merges are
+    // run on their own pool, ordered by the ledger at which each merge must be
+    // resolved, rather than on the general worker threads. When zero, merges
+    // share the general worker threads.
+    int BUCKET_MERGE_THREADS;
+
+    // Maximum number of jobs of a class (see BackgroundTaskClass) running on
+    // the worker threads at once, by class name. Classes missing from it can
+    // use all the worker threads.
+    std::map<std::string, size_t> BACKGROUND_TASK_LIMITS;
+
+    // Latency SLOs of the main thread's action classes (the first word of
+    // the name of an action queue, see Scheduler): droppable actions of a
+    // class are dropped once they have waited longer than its SLO, instead
+    // of the scheduler's latency window.
+    std::map<std::string, std::chrono::milliseconds> SCHEDULER_LATENCY_SLOS;
+
+    // One in about every ZONE_PROFILER_SAMPLE_PERIOD profiling zones entered
+    // is timed for the `zones` command, see ZoneProfiler; 0 disables it.
+    uint32_t ZONE_PROFILER_SAMPLE_PERIOD;
+
     // process-management config
     size_t MAX_CONCURRENT_SUBPROCESSES;
+    // Limits of their own for archive downloads, (de)compression and
+    // uploads, see ProcessClass; 0 makes them share MAX_CONCURRENT_SUBPROCESSES
+    size_t MAX_CONCURRENT_DOWNLOAD_SUBPROCESSES;
+    size_t MAX_CONCURRENT_COMPRESSION_SUBPROCESSES;
+    size_t MAX_CONCURRENT_UPLOAD_SUBPROCESSES;
+    // Niceness (0 to 19) compression and upload commands run with
+    int BACKGROUND_SUBPROCESS_NICENESS;
+    // Run compression and upload commands in the idle I/O scheduling class,
+    // on Linux
+    bool BACKGROUND_SUBPROCESS_IDLE_IO;
+
+    // Download from the history archives whose get command fetches an
+    // http:// URL with a built-in client instead of running the command,
+    // see HttpFileFetcher, and upload to those with a put_url the same way,
+    // see HttpFileUploader
+    bool HISTORY_HTTP_CLIENT;
+    // Connections the built-in client opens at most to each archive host
+    size_t HISTORY_HTTP_MAX_CONNECTIONS;
+    // Spread the downloads over all the readable archives by how well each
+    // one does, instead of picking one at random for each of them
+    bool HISTORY_STRIPED_DOWNLOADS;
+
+    // Upper bound on the checkpoints catchup downloads ahead of the one it
+    // applies, the actual number being tuned from the measured download and
+    // apply times. 0 keeps MAX_CONCURRENT_SUBPROCESSES checkpoints in flight.
+    uint32_t CATCHUP_MAX_DOWNLOAD_AHEAD;
+
+    // Keep what catchup downloaded and verified in the bucket directory
+    // when it's interrupted, so that the next catchup starts from there
+    bool CATCHUP_RESUMABLE;
+
+    // When replaying history, don't check again the signatures of the
+    // transactions that the archive's results say succeeded. Only for
+    // watchers and archivers that trust their archives.
+    bool CATCHUP_TRUSTED_REPLAY;
+
+    // When applying the ledgers buffered during catchup, only wait for the
+    // database to make every this many ledgers durable, and the last one.
+    // 1 makes every ledger durable.
+    uint32_t BUFFERED_LEDGERS_DURABLE_COMMIT_INTERVAL;
+
+    // Threads compressing each file published to history in-process rather
+    // than by running gzip, 0 to run gzip. Needs zlib.
+    uint32_t GZIP_THREADS;
 
     // SCP config
     SecretKey NODE_SEED;
@@ -565,9 +807,23 @@ class Config : public std::enable_shared_from_this<Config>
     // Whether to run online quorum intersection checks.
     bool QUORUM_INTERSECTION_CHECKER;
 
+    // Number of threads a quorum intersection check searches for disjoint
+    // quorums on, and over which the intersection-critical groups are
+    // checked.
+    uint32_t QUORUM_INTERSECTION_CHECKER_THREADS;
+
     // Invariants
     std::vector<std::string> INVARIANT_CHECKS;
 
+    // Number of threads the invariants are checked on after each operation,
+    // instead of on the thread applying it. Their failures are reported, in
+    // order, before the ledger is committed. 0 checks them as they apply.
+    uint32_t INVARIANT_CHECK_THREADS;
+
+    // Percentage of the operations, picked at random, that the invariants
+    // are checked on.
+    uint32_t INVARIANT_CHECK_SAMPLE_PERCENT;
+
     std::map<std::string, std::string> VALIDATOR_NAMES;
 
     // History config
@@ -583,6 +839,51 @@ class Config : public std::enable_shared_from_this<Config>
     // - ENTRY_CACHE_SIZE controls the maximum number of LedgerEntry objects
     //   that will be stored in the cache
     size_t ENTRY_CACHE_SIZE;
+    // - ENTRY_CACHE_SIZE_MB, if non-zero, instead bounds the cache by the
+    //   approximate memory used by its entries, and switches it from random
+    //   eviction to the scan-resistant W-TinyLFU policy. ENTRY_CACHE_SIZE is
+    //   then only used as an estimate of the number of cached entries.
+    uint32_t ENTRY_CACHE_SIZE_MB;
+    // - LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB, if non-zero, empties the entry
+    //   cache and the best offers cache whenever their approximate memory use
+    //   together exceeds it.
+    uint32_t LEDGER_CACHE_MEMORY_SOFT_LIMIT_MB;
+    // - WARM_START_CACHE saves the keys of the entry cache on a graceful stop
+    //   and prefetches them on the next startup, if the last closed ledger is
+    //   still the same (see WarmStartCache.h).
+    bool WARM_START_CACHE;
+    // - MEMORY_BUDGET_MB, if non-zero, bounds the memory used together by
+    //   the ledger caches, the BucketListDB entry cache and persisted
+    //   indexes and the signature cache (see MemoryBudget.h).
+    uint32_t MEMORY_BUDGET_MB;
+
+    // Number of signature verification results kept in the process-wide
+    // signature cache. The cache is shared by all the applications of a
+    // process, so the last one created decides its size.
+    uint32_t VERIFY_SIG_CACHE_SIZE;
+
+    // If set to true, transactions received from peers are decoded, hashed
+    // and have the signatures of their source accounts' master keys verified
+    // on a background thread before the main thread admits them into the
+    // transaction queue, in the order they were received. The queue still
+    // checks them against the current ledger state, now hitting the
+    // signature cache.
+    bool EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION;
+
+    // Maximum number of background jobs used, along with the main thread, to
+    // verify the signatures of the source accounts' master keys of a
+    // transaction set before its transactions are validated on the main
+    // thread, which then hits the signature cache. The jobs run on the
+    // application's worker threads. 0 verifies them on the main thread
+    // during validation.
+    uint32_t TX_SET_VALIDATION_SIG_VERIFY_THREADS;
+
+    // If set to true, SCP envelopes received from peers are queued and have
+    // their signatures verified in batches on a background thread, one batch
+    // at a time, before the main thread hands them to the herder in the order
+    // they were received. The herder still verifies them, now hitting the
+    // signature cache.
+    bool EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION;
 
     // Data layer prefetcher configuration
     // - PREFETCH_BATCH_SIZE determines how many records we'll prefetch per
@@ -590,6 +891,51 @@ class Config : public std::enable_shared_from_this<Config>
     // the entry cache
     size_t PREFETCH_BATCH_SIZE;
 
+    // Maximum number of additional threads used to prefetch entries from
+    // BucketListDB. Each thread loads at least PREFETCH_BATCH_SIZE keys. 0
+    // loads everything on the main thread.
+    uint32_t PREFETCH_WORKER_THREADS;
+
+    // If set to true, the entries that the leading candidate transaction set
+    // will need are prefetched into the entry cache while SCP is still
+    // nominating, in batches of PREFETCH_BATCH_SIZE keys between other main
+    // thread work, instead of only right before the set is applied.
+    bool EXPERIMENTAL_SPECULATIVE_PREFETCH;
+
+    // If non-zero, the host functions of Soroban transactions whose
+    // footprints don't conflict are invoked ahead of apply on up to this many
+    // additional threads. Apply reuses an invocation only if it would have
+    // invoked the host with exactly the same entries, so results are those
+    // of serial apply. 0 invokes everything on the main thread.
+    uint32_t EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS;
+
+    // If non-zero, a warning breaking the apply time down by operation type
+    // is logged for every ledger whose transactions take at least this many
+    // milliseconds to apply.
+    uint32_t SLOW_LEDGER_APPLY_LOG_THRESHOLD_MS;
+
+    // If set to true, LedgerTxnRoot loads every offer into memory the first
+    // time the order book is queried and then keeps that copy up to date on
+    // each commit, instead of loading best offers from SQL in batches and
+    // discarding them at the end of every ledger.
+    bool IN_MEMORY_ORDER_BOOK;
+
+    // If set to true (with BucketListDB), LedgerTxnRoot loads every
+    // CONTRACT_CODE and TTL entry from the BucketList into memory the first
+    // time one is looked up, keeps them up to date on each commit and serves
+    // all lookups of these types from memory.
+    bool IN_MEMORY_CONTRACT_CODE_AND_TTL;
+
+    // Same as IN_MEMORY_CONTRACT_CODE_AND_TTL, for LIQUIDITY_POOL entries,
+    // which path payments look up for every hop.
+    bool IN_MEMORY_LIQUIDITY_POOLS;
+
+    // On PostgreSQL, entries of these types are upserted when a ledger is
+    // committed by streaming them into a temporary table with COPY and
+    // merging that into the entry table, instead of by unnesting one array
+    // parameter per column. Only OFFER, ACCOUNT and TRUSTLINE are supported.
+    std::vector<LedgerEntryType> POSTGRES_COPY_UPSERT_ENTRY_TYPES;
+
     // If set to true, the application will halt when an internal error is
     // encountered during applying a transaction. Otherwise, the
     // txINTERNAL_ERROR transaction is created but not applied.
@@ -613,6 +959,11 @@ class Config : public std::enable_shared_from_this<Config>
     // on validators that accept transactions.
     bool ENABLE_DIAGNOSTICS_FOR_TX_SUBMISSION;
 
+    // Number of contracts, and of contract functions, whose Soroban resource
+    // usage is reported by the `contractusage` command, by decreasing invoke
+    // time over windows of ledgers. 0, the default, doesn't track it.
+    uint32_t SOROBAN_CONTRACT_USAGE_TOP_N;
+
     // Override the initial hardcoded MINIMUM_PERSISTENT_ENTRY_LIFETIME
     // for testing.
     uint32_t TESTING_MINIMUM_PERSISTENT_ENTRY_LIFETIME;
@@ -665,11 +1016,15 @@ class Config : public std::enable_shared_from_this<Config>
     std::chrono::seconds getExpectedLedgerCloseTime() const;
 
     void setInMemoryMode();
+    // In-memory mode that only replays history as fast as it can be applied,
+    // see MODE_REPLAY_ONLY
+    void setInMemoryReplayMode();
     bool modeDoesCatchupWithBucketList() const;
     bool isInMemoryMode() const;
     bool isInMemoryModeWithoutMinimalDB() const;
     bool isUsingBucketListDB() const;
     bool isPersistingBucketListDBIndexes() const;
+    bool isUsingHistoryBucketIndexes() const;
     bool modeStoresAllHistory() const;
     bool modeStoresAnyHistory() const;
     void logBasicInfo();
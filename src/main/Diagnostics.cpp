@@ -35,7 +35,7 @@ bucketStats(std::string const& filename, bool aggregateAccounts)
         {
             auto const& le = tmp.liveEntry().data;
             auto t = le.type();
-            auto bytes = xdr::xdr_to_opaque(tmp).size();
+            auto bytes = xdr::xdr_size(tmp);
             ledgerEntriesSizeBytes[t] += bytes;
             ++ledgerEntriesCount[t];
 
@@ -9,7 +9,7 @@
 #include "ledger/LedgerManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <limits>
 #include <regex>
 
@@ -159,8 +159,8 @@ ExternalQueue::deleteCursor(std::string const& resid)
     }
 }
 
-void
-ExternalQueue::deleteOldEntries(uint32 count)
+uint32
+ExternalQueue::getLastTrimmableLedger()
 {
     ZoneScoped;
     auto& db = mApp.getDatabase();
@@ -203,8 +203,15 @@ ExternalQueue::deleteOldEntries(uint32 count)
     CLOG_INFO(History,
               "Trimming history <= ledger {} (rmin={}, qmin={}, lmin={})", cmin,
               rmin, qmin, lmin);
+    return cmin;
+}
 
-    mApp.getLedgerManager().deleteOldEntries(mApp.getDatabase(), cmin, count);
+void
+ExternalQueue::deleteOldEntries(uint32 count)
+{
+    ZoneScoped;
+    mApp.getLedgerManager().deleteOldEntries(mApp.getDatabase(),
+                                             getLastTrimmableLedger(), count);
 }
 
 void
@@ -33,6 +33,10 @@ class ExternalQueue
     // deletes the subscription for the resource
     void deleteCursor(std::string const& resid);
 
+    // the last ledger whose data is neither needed to publish history nor
+    // unread by a subscriber, so that it can be deleted
+    uint32 getLastTrimmableLedger();
+
     // safely delete data, maximum count entries from each table
     void deleteOldEntries(uint32 count);
 
@@ -3,21 +3,53 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "main/Maintainer.h"
+#include "database/Database.h"
+#include "ledger/LedgerManager.h"
+#include "main/Application.h"
 #include "main/Config.h"
 #include "main/ExternalQueue.h"
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/Thread.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric.h"
 
-#include <Tracy.hpp>
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <algorithm>
 #include <fmt/format.h>
 
 namespace stellar
 {
 
-Maintainer::Maintainer(Application& app) : mApp{app}, mTimer{mApp}
+namespace
+{
+// Background batches are resized to take about that long, so that they never
+// hold the database for long while ledgers close
+std::chrono::milliseconds const MAINTENANCE_BATCH_TARGET{100};
+// The thread also waits at least that long between two batches
+std::chrono::milliseconds const MAINTENANCE_BATCH_PAUSE{10};
+uint32_t const MAINTENANCE_MAX_BATCH_LEDGERS = 1 << 16;
+}
+
+Maintainer::Maintainer(Application& app)
+    : mApp{app}
+    , mTimer{mApp}
+    , mRowsPruned{app.getMetrics().NewMeter({"maintenance", "rows", "pruned"},
+                                            "row")}
+    , mBacklog{
+          app.getMetrics().NewCounter({"maintenance", "ledgers", "backlog"})}
+    , mBatchTimer{app.getMetrics().NewTimer({"maintenance", "batch", "time"})}
+{
+}
+
+Maintainer::~Maintainer()
 {
+    shutdown();
 }
 
 void
@@ -33,7 +65,18 @@ Maintainer::start()
         int64 ledgersPerMaintenancePeriod = bigDivideOrThrow(
             c.AUTOMATIC_MAINTENANCE_PERIOD.count(), 1,
             c.getExpectedLedgerCloseTime().count(), Rounding::ROUND_UP);
-        if (c.AUTOMATIC_MAINTENANCE_COUNT <= ledgersPerMaintenancePeriod)
+        if (c.BACKGROUND_MAINTENANCE && mApp.getDatabase().canUsePool())
+        {
+            // Batches grow as needed to keep up
+            mBatchLedgers = c.AUTOMATIC_MAINTENANCE_COUNT;
+            mSession =
+                std::make_unique<soci::session>(mApp.getDatabase().getPool());
+            mThread = std::thread{[this]() {
+                runCurrentThreadWithLowPriority();
+                run();
+            }};
+        }
+        else if (c.AUTOMATIC_MAINTENANCE_COUNT <= ledgersPerMaintenancePeriod)
         {
             LOG_WARNING(
                 DEFAULT_LOG, "{}",
@@ -47,6 +90,22 @@ Maintainer::start()
     }
 }
 
+void
+Maintainer::shutdown()
+{
+    mTimer.cancel();
+    if (mThread)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+        mCond.notify_all();
+        mThread->join();
+        mThread.reset();
+    }
+}
+
 void
 Maintainer::scheduleMaintenance()
 {
@@ -58,7 +117,19 @@ void
 Maintainer::tick()
 {
     ZoneScoped;
-    performMaintenance(mApp.getConfig().AUTOMATIC_MAINTENANCE_COUNT);
+    if (mThread)
+    {
+        auto lastTrimmable = ExternalQueue{mApp}.getLastTrimmableLedger();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mLastTrimmable = std::max(mLastTrimmable, lastTrimmable);
+        }
+        mCond.notify_all();
+    }
+    else
+    {
+        performMaintenance(mApp.getConfig().AUTOMATIC_MAINTENANCE_COUNT);
+    }
     scheduleMaintenance();
 }
 
@@ -72,7 +143,99 @@ Maintainer::performMaintenance(uint32_t count)
         "performance issue: check database or perform a large manual "
         "maintenance followed by database maintenance. Maintenance took",
         std::chrono::seconds{2});
-    ExternalQueue ps{mApp};
-    ps.deleteOldEntries(count);
+    auto& db = mApp.getDatabase();
+    auto lastTrimmable = ExternalQueue{mApp}.getLastTrimmableLedger();
+    mRowsPruned.Mark(
+        mApp.getLedgerManager().deleteOldEntries(db, lastTrimmable, count));
+    updateBacklog(db.getSession(), lastTrimmable);
+}
+
+void
+Maintainer::run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mCond.wait(lock,
+                   [&] { return mStopping || mTrimmed < mLastTrimmable; });
+        if (mStopping)
+        {
+            return;
+        }
+        auto lastTrimmable = mLastTrimmable;
+        lock.unlock();
+
+        uint64_t rows = 0;
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            rows = deleteBatch(lastTrimmable);
+        }
+        catch (std::exception& e)
+        {
+            // Try again on the next tick
+            CLOG_ERROR(History, "Failed to delete old history: {}", e.what());
+            lock.lock();
+            mTrimmed = mLastTrimmable;
+            continue;
+        }
+        auto pause = std::max<std::chrono::steady_clock::duration>(
+            std::chrono::steady_clock::now() - start, MAINTENANCE_BATCH_PAUSE);
+
+        lock.lock();
+        if (rows == 0)
+        {
+            mTrimmed = std::max(mTrimmed, lastTrimmable);
+        }
+        else
+        {
+            // Leave the database to the main thread for as long as the batch
+            // took
+            mCond.wait_for(lock, pause, [&] { return mStopping; });
+        }
+    }
+}
+
+uint64_t
+Maintainer::deleteBatch(uint32_t lastTrimmable)
+{
+    ZoneScoped;
+    auto start = std::chrono::steady_clock::now();
+    soci::transaction tx(*mSession);
+    auto rows = mApp.getLedgerManager().deleteOldEntries(
+        *mSession, lastTrimmable, mBatchLedgers);
+    tx.commit();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    mBatchTimer.Update(elapsed);
+    mRowsPruned.Mark(rows);
+
+    if (elapsed > MAINTENANCE_BATCH_TARGET)
+    {
+        mBatchLedgers = std::max<uint32_t>(mBatchLedgers / 2, 1);
+    }
+    else if (rows != 0 && elapsed < MAINTENANCE_BATCH_TARGET / 2)
+    {
+        mBatchLedgers =
+            std::min(mBatchLedgers * 2, MAINTENANCE_MAX_BATCH_LEDGERS);
+    }
+    CLOG_DEBUG(History, "Deleted {} rows of old history, next batch {} ledgers",
+               rows, mBatchLedgers);
+    updateBacklog(*mSession, lastTrimmable);
+    return rows;
+}
+
+void
+Maintainer::updateBacklog(soci::session& sess, uint32_t lastTrimmable)
+{
+    uint32_t oldest = 0;
+    soci::indicator gotOldest;
+    sess << "SELECT MIN(ledgerseq) FROM ledgerheaders",
+        soci::into(oldest, gotOldest);
+    int64_t backlog = 0;
+    if (gotOldest == soci::i_ok && oldest <= lastTrimmable)
+    {
+        backlog = static_cast<int64_t>(lastTrimmable) - oldest + 1;
+    }
+    mBacklog.set_count(backlog);
 }
 }
@@ -6,7 +6,25 @@
 
 #include "util/Timer.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace medida
+{
+class Counter;
+class Meter;
+class Timer;
+}
+
+namespace soci
+{
+class session;
+}
 
 namespace stellar
 {
@@ -17,18 +35,43 @@ class Maintainer
 {
   public:
     explicit Maintainer(Application& app);
+    ~Maintainer();
 
     // start automatic maintenance according to app.getConfig()
     void start();
 
+    // stops the background maintenance thread, if any, once the batch it is
+    // deleting is committed
+    void shutdown();
+
     // removes maximum count entries from tables like txhistory or scphistory
     void performMaintenance(uint32_t count);
 
   private:
     Application& mApp;
     VirtualTimer mTimer;
+    medida::Meter& mRowsPruned;
+    medida::Counter& mBacklog;
+    medida::Timer& mBatchTimer;
+
+    // With BACKGROUND_MAINTENANCE, each tick only raises mLastTrimmable and
+    // the thread deletes everything up to it, in batches of mBatchLedgers
+    // ledgers sized to take about MAINTENANCE_BATCH_TARGET each, through a
+    // session of its own.
+    std::unique_ptr<soci::session> mSession;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    uint32_t mLastTrimmable{0};
+    uint32_t mTrimmed{0};
+    uint32_t mBatchLedgers{0};
+    bool mStopping{false};
+    std::optional<std::thread> mThread;
 
     void scheduleMaintenance();
     void tick();
+    void run();
+    // deletes one batch, returning the number of rows deleted
+    uint64_t deleteBatch(uint32_t lastTrimmable);
+    void updateBacklog(soci::session& sess, uint32_t lastTrimmable);
 };
 }
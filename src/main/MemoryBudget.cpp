@@ -0,0 +1,175 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/MemoryBudget.h"
+#include "main/Application.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+#include <chrono>
+
+namespace stellar
+{
+
+namespace
+{
+// Caches grow between two checks, this bounds by how much
+std::chrono::seconds const MEMORY_BUDGET_PERIOD{5};
+}
+
+MemoryBudget::MemoryBudget(Application& app, uint64_t maxBytes)
+    : mApp(app)
+    , mMaxBytes(maxBytes)
+    , mTimer(app)
+    , mTotalBytes(app.getMetrics().NewCounter({"memory", "total", "bytes"}))
+{
+    releaseAssert(mMaxBytes > 0);
+}
+
+void
+MemoryBudget::registerConsumer(std::string const& name, uint32_t weight,
+                               BytesFn bytes, ShrinkFn shrink)
+{
+    releaseAssert(threadIsMain());
+    releaseAssert(weight > 0);
+    for (auto const& c : mConsumers)
+    {
+        releaseAssert(c.mName != name);
+    }
+    auto& metrics = mApp.getMetrics();
+    mConsumers.emplace_back(
+        Consumer{name, weight, std::move(bytes), std::move(shrink),
+                 metrics.NewCounter({"memory", name, "bytes"}),
+                 metrics.NewMeter({"memory", name, "shrink"}, "shrink")});
+}
+
+void
+MemoryBudget::start()
+{
+    CLOG_INFO(Perf, "Enforcing a memory budget of {} bytes across {} caches",
+              mMaxBytes, mConsumers.size());
+    scheduleEnforce();
+}
+
+void
+MemoryBudget::shutdown()
+{
+    mTimer.cancel();
+}
+
+void
+MemoryBudget::scheduleEnforce()
+{
+    mTimer.expires_from_now(MEMORY_BUDGET_PERIOD);
+    mTimer.async_wait(
+        [this]() {
+            enforce();
+            scheduleEnforce();
+        },
+        VirtualTimer::onFailureNoop);
+}
+
+std::vector<uint64_t>
+MemoryBudget::computeShares(uint64_t maxBytes,
+                            std::vector<uint64_t> const& used,
+                            std::vector<uint32_t> const& weights)
+{
+    releaseAssert(used.size() == weights.size());
+    std::vector<uint64_t> shares(used.size(), 0);
+    std::vector<bool> settled(used.size(), false);
+    uint64_t remaining = maxBytes;
+
+    while (true)
+    {
+        uint64_t totalWeight = 0;
+        for (size_t i = 0; i < used.size(); ++i)
+        {
+            if (!settled[i])
+            {
+                totalWeight += weights[i];
+            }
+        }
+        if (totalWeight == 0)
+        {
+            return shares;
+        }
+
+        // Settle every consumer within its share of what is left at once, so
+        // that the result doesn't depend on the order of the consumers
+        auto shareOf = [&](size_t i) {
+            return static_cast<uint64_t>(static_cast<double>(remaining) *
+                                         weights[i] / totalWeight);
+        };
+        uint64_t settledBytes = 0;
+        bool progress = false;
+        for (size_t i = 0; i < used.size(); ++i)
+        {
+            if (!settled[i] && used[i] <= shareOf(i))
+            {
+                shares[i] = used[i];
+                settledBytes += used[i];
+                settled[i] = true;
+                progress = true;
+            }
+        }
+
+        if (!progress)
+        {
+            // Everyone left is over its share, which it gets
+            for (size_t i = 0; i < used.size(); ++i)
+            {
+                if (!settled[i])
+                {
+                    shares[i] = shareOf(i);
+                }
+            }
+            return shares;
+        }
+        remaining -= settledBytes;
+    }
+}
+
+size_t
+MemoryBudget::enforce()
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    std::vector<uint64_t> used;
+    std::vector<uint32_t> weights;
+    uint64_t total = 0;
+    for (auto& c : mConsumers)
+    {
+        used.emplace_back(c.mBytes());
+        weights.emplace_back(c.mWeight);
+        c.mBytesCounter.set_count(used.back());
+        total += used.back();
+    }
+    mTotalBytes.set_count(total);
+    if (total <= mMaxBytes)
+    {
+        return 0;
+    }
+
+    auto shares = computeShares(mMaxBytes, used, weights);
+    size_t shrunk = 0;
+    for (size_t i = 0; i < mConsumers.size(); ++i)
+    {
+        if (used[i] > shares[i])
+        {
+            auto& c = mConsumers[i];
+            CLOG_DEBUG(Perf, "Shrinking {} from {} to {} bytes", c.mName,
+                       used[i], shares[i]);
+            c.mShrink(shares[i]);
+            c.mShrinkMeter.Mark();
+            ++shrunk;
+        }
+    }
+    return shrunk;
+}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/Timer.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class Meter;
+}
+
+namespace stellar
+{
+
+class Application;
+
+// Splits MEMORY_BUDGET_MB between the caches that can be dropped and
+// rebuilt at any time, which are otherwise sized independently of each
+// other. Every few seconds, on the main thread, the budget reads how many
+// bytes each consumer holds; if their total exceeds the budget, each
+// consumer holding more than its share is asked to shrink to it.
+//
+// Shares are weighted, and a consumer using less than its share leaves the
+// rest to the others in proportion to their weights, so a cache that is
+// cold or disabled doesn't waste its part of the budget.
+class MemoryBudget : NonMovableOrCopyable
+{
+  public:
+    // Returns the approximate number of bytes the consumer holds
+    using BytesFn = std::function<uint64_t()>;
+    // Asks the consumer to hold at most that many bytes
+    using ShrinkFn = std::function<void(uint64_t)>;
+
+    MemoryBudget(Application& app, uint64_t maxBytes);
+
+    // Consumers must outlive the budget, or at least its shutdown
+    void registerConsumer(std::string const& name, uint32_t weight,
+                          BytesFn bytes, ShrinkFn shrink);
+
+    // Enforces the budget periodically from now on
+    void start();
+    void shutdown();
+
+    // Enforces the budget once, returning the number of consumers asked to
+    // shrink
+    size_t enforce();
+
+    uint64_t
+    getMaxBytes() const
+    {
+        return mMaxBytes;
+    }
+
+    // The share of `maxBytes` of each consumer, by water-filling: consumers
+    // using less than their weighted share keep what they use, and the rest
+    // is split again among the others by weight.
+    static std::vector<uint64_t>
+    computeShares(uint64_t maxBytes, std::vector<uint64_t> const& used,
+                  std::vector<uint32_t> const& weights);
+
+  private:
+    struct Consumer
+    {
+        std::string mName;
+        uint32_t mWeight;
+        BytesFn mBytes;
+        ShrinkFn mShrink;
+        medida::Counter& mBytesCounter;
+        medida::Meter& mShrinkMeter;
+    };
+
+    Application& mApp;
+    uint64_t const mMaxBytes;
+    VirtualTimer mTimer;
+    medida::Counter& mTotalBytes;
+    std::vector<Consumer> mConsumers;
+
+    void scheduleEnforce();
+};
+}
@@ -11,7 +11,7 @@
 #include "ledger/LedgerManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -22,7 +22,7 @@ std::string PersistentState::mapping[kLastEntry] = {
     "lastclosedledger", "historyarchivestate", "lastscpdata",
     "databaseschema",   "networkpassphrase",   "ledgerupgrades",
     "rebuildledger",    "lastscpdataxdr",      "txset",
-    "dbbackend"};
+    "dbbackend",        "catchupbucketstate",  "txhistorywritten"};
 
 std::string PersistentState::kSQLCreateStatement =
     "CREATE TABLE IF NOT EXISTS storestate ("
@@ -61,6 +61,14 @@ PersistentState::dropAll(Database& db)
     st.execute(true);
 }
 
+std::string const&
+PersistentState::getStateName(PersistentState::Entry n)
+{
+    releaseAssert(n >= 0 && n < kLastEntry && n != kLastSCPData &&
+                  n != kLastSCPDataXDR && n != kRebuildLedger && n != kTxSet);
+    return mapping[n];
+}
+
 std::string
 PersistentState::getStoreStateName(PersistentState::Entry n, uint32 subscript)
 {
@@ -29,6 +29,8 @@ class PersistentState
         kLastSCPDataXDR,
         kTxSet,
         kDBBackend,
+        kCatchupBucketState,
+        kTxHistoryWritten,
         kLastEntry,
     };
 
@@ -37,6 +39,10 @@ class PersistentState
     std::string getState(Entry stateName);
     void setState(Entry stateName, std::string const& value);
 
+    // The statename column of an entry that has no subscript, for writing it
+    // through another session than the main one
+    static std::string const& getStateName(Entry stateName);
+
     // Special methods for SCP state (multiple slots)
     std::vector<std::string> getSCPStateAllSlots();
     std::vector<std::string> getTxSetsForAllSlots();
@@ -0,0 +1,277 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/PrometheusServer.h"
+#include "main/Application.h"
+#include "medida/counter.h"
+#include "medida/histogram.h"
+#include "medida/meter.h"
+#include "medida/timer.h"
+#include "util/Logging.h"
+#include "util/Thread.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <cctype>
+#include <cmath>
+#include <iterator>
+
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+namespace stellar
+{
+
+namespace
+{
+// Families registered once per value of their type component, exported as
+// one metric with that value as a label
+struct LabelRule
+{
+    char const* mDomain;
+    char const* mTypePrefix;
+    char const* mLabel;
+};
+LabelRule const LABEL_RULES[] = {
+    // ledger.operation-<operation type>.{apply,commit,failure}
+    {"ledger", "operation-", "type"},
+    // background.<task class>.{queued,running,wait,run}
+    {"background", "", "class"},
+};
+
+double const QUANTILES[] = {0.5, 0.75, 0.95, 0.99, 0.999};
+
+std::string
+sanitize(std::string const& name)
+{
+    std::string res;
+    res.reserve(name.size());
+    for (char c : name)
+    {
+        res += std::isalnum(static_cast<unsigned char>(c))
+                   ? static_cast<char>(
+                         std::tolower(static_cast<unsigned char>(c)))
+                   : '_';
+    }
+    return res;
+}
+
+void
+nameAndLabels(medida::MetricName const& metric, std::string& name,
+              std::string& labels)
+{
+    auto const& domain = metric.domain();
+    auto const& type = metric.type();
+    for (auto const& rule : LABEL_RULES)
+    {
+        std::string prefix(rule.mTypePrefix);
+        if (domain == rule.mDomain && type.size() > prefix.size() &&
+            type.compare(0, prefix.size(), prefix) == 0)
+        {
+            auto base = domain;
+            if (!prefix.empty())
+            {
+                base += "_" + prefix.substr(0, prefix.size() - 1);
+            }
+            name = "stellar_core_" + sanitize(base + "_" + metric.name());
+            labels = fmt::format(FMT_STRING("{}=\"{}\""), rule.mLabel,
+                                 type.substr(prefix.size()));
+            return;
+        }
+    }
+    name = "stellar_core_" +
+           sanitize(domain + "_" + type + "_" + metric.name());
+    labels.clear();
+}
+
+std::string
+formatValue(double v)
+{
+    if (std::isnan(v))
+    {
+        return "NaN";
+    }
+    if (std::isinf(v))
+    {
+        return v > 0 ? "+Inf" : "-Inf";
+    }
+    return fmt::format(FMT_STRING("{}"), v);
+}
+}
+
+PrometheusSnapshot::PrometheusSnapshot(medida::MetricsRegistry& registry)
+{
+    for (auto const& kv : registry.GetAllMetrics())
+    {
+        nameAndLabels(kv.first, mName, mLabels);
+        kv.second->Process(*this);
+    }
+}
+
+PrometheusSnapshot::Family&
+PrometheusSnapshot::family(char const* type)
+{
+    auto& f = mFamilies[mName];
+    f.mType = type;
+    return f;
+}
+
+void
+PrometheusSnapshot::Process(medida::Counter& counter)
+{
+    // medida counters go both ways
+    family("gauge").mSamples.emplace_back(
+        Sample{"", mLabels, static_cast<double>(counter.count())});
+}
+
+void
+PrometheusSnapshot::Process(medida::Meter& meter)
+{
+    // Rates are for Prometheus to compute
+    mName += "_total";
+    family("counter").mSamples.emplace_back(
+        Sample{"", mLabels, static_cast<double>(meter.count())});
+}
+
+void
+PrometheusSnapshot::addSummary(medida::stats::Snapshot const& snapshot,
+                               double sum, uint64_t count, double scale)
+{
+    auto& f = family("summary");
+    auto sep = mLabels.empty() ? "" : ",";
+    for (auto q : QUANTILES)
+    {
+        f.mSamples.emplace_back(Sample{
+            "", fmt::format(FMT_STRING("{}{}quantile=\"{}\""), mLabels, sep, q),
+            snapshot.getValue(q) * scale});
+    }
+    f.mSamples.emplace_back(Sample{"_sum", mLabels, sum * scale});
+    f.mSamples.emplace_back(
+        Sample{"_count", mLabels, static_cast<double>(count)});
+}
+
+void
+PrometheusSnapshot::Process(medida::Histogram& histogram)
+{
+    addSummary(histogram.GetSnapshot(), histogram.sum(), histogram.count(),
+               1.0);
+}
+
+void
+PrometheusSnapshot::Process(medida::Timer& timer)
+{
+    mName += "_seconds";
+    // Timers record in their duration unit
+    addSummary(timer.GetSnapshot(), timer.sum(), timer.count(),
+               std::chrono::duration<double>(timer.duration_unit()).count());
+}
+
+void
+PrometheusSnapshot::Process(medida::Buckets& buckets)
+{
+    // Not exported
+}
+
+std::string
+PrometheusSnapshot::render() const
+{
+    std::string res;
+    auto out = std::back_inserter(res);
+    for (auto const& kv : mFamilies)
+    {
+        fmt::format_to(out, FMT_STRING("# TYPE {} {}\n"), kv.first,
+                       kv.second.mType);
+        for (auto const& s : kv.second.mSamples)
+        {
+            if (s.mLabels.empty())
+            {
+                fmt::format_to(out, FMT_STRING("{}{} {}\n"), kv.first,
+                               s.mSuffix, formatValue(s.mValue));
+            }
+            else
+            {
+                fmt::format_to(out, FMT_STRING("{}{}{{{}}} {}\n"), kv.first,
+                               s.mSuffix, s.mLabels, formatValue(s.mValue));
+            }
+        }
+    }
+    return res;
+}
+
+PrometheusServer::PrometheusServer(Application& app,
+                                   std::string const& address,
+                                   unsigned short port, int maxClient,
+                                   std::chrono::seconds period)
+    : mApp(app), mPeriod(period), mTimer(app), mIOContext(1)
+{
+    captureSnapshot();
+
+    LOG_INFO(DEFAULT_LOG, "Listening on {}:{} for Prometheus scrapes", address,
+             port);
+    mServer = std::make_unique<http::server::server>(mIOContext, address,
+                                                     port, maxClient);
+    mServer->add404(std::bind(&PrometheusServer::notFound, this, _1, _2));
+    mServer->addRoute(
+        "metrics",
+        [this](std::string const& params, std::string& retStr) {
+            try
+            {
+                ZoneNamedN(httpZone, "Prometheus scrape", true);
+                metrics(params, retStr);
+            }
+            catch (std::exception const& e)
+            {
+                retStr = fmt::format(FMT_STRING("# error: {}\n"), e.what());
+            }
+        },
+        "text/plain; version=0.0.4");
+
+    mThread = std::thread([this]() {
+        runCurrentThreadWithLowPriority();
+        mIOContext.run();
+    });
+}
+
+PrometheusServer::~PrometheusServer()
+{
+    mTimer.cancel();
+    mIOContext.stop();
+    mThread.join();
+}
+
+void
+PrometheusServer::captureSnapshot()
+{
+    ZoneScoped;
+    mApp.syncAllMetrics();
+    auto snapshot = std::make_shared<PrometheusSnapshot const>(
+        mApp.getMetrics());
+    {
+        std::lock_guard<std::mutex> guard(mSnapshotMutex);
+        mSnapshot = std::move(snapshot);
+    }
+
+    mTimer.expires_from_now(mPeriod);
+    mTimer.async_wait([this]() { captureSnapshot(); },
+                      VirtualTimer::onFailureNoop);
+}
+
+void
+PrometheusServer::notFound(std::string const& params, std::string& retStr)
+{
+    retStr = "<b>Welcome to the stellar-core Prometheus exporter!</b><p>"
+             "Metrics are served at /metrics</p>";
+}
+
+void
+PrometheusServer::metrics(std::string const& params, std::string& retStr)
+{
+    std::shared_ptr<PrometheusSnapshot const> snapshot;
+    {
+        std::lock_guard<std::mutex> guard(mSnapshotMutex);
+        snapshot = mSnapshot;
+    }
+    retStr = snapshot->render();
+}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/http/server.hpp"
+#include "medida/metrics_registry.h"
+#include "medida/stats/snapshot.h"
+#include "util/NonCopyable.h"
+#include "util/Timer.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stellar
+{
+class Application;
+
+// The values of all metrics of a registry at some point, in terms of the
+// Prometheus text exposition format: medida counters become gauges, meters
+// become counters, and histograms and timers become summaries, timers in
+// seconds. A metric named domain.type.name is exported as
+// stellar_core_domain_type_name, except for the families registered once
+// per operation type or background task class, whose members are exported
+// under one name with a label telling them apart.
+class PrometheusSnapshot : public medida::MetricProcessor
+{
+    struct Sample
+    {
+        std::string mSuffix;
+        std::string mLabels;
+        double mValue;
+    };
+    struct Family
+    {
+        char const* mType;
+        std::vector<Sample> mSamples;
+    };
+    std::map<std::string, Family> mFamilies;
+
+    // Name and labels of the metric being captured
+    std::string mName;
+    std::string mLabels;
+
+    Family& family(char const* type);
+    void addSummary(medida::stats::Snapshot const& snapshot, double sum,
+                    uint64_t count, double scale);
+
+  public:
+    // Must be called from the thread updating the registry's metrics (the
+    // main thread for the application's registry)
+    explicit PrometheusSnapshot(medida::MetricsRegistry& registry);
+
+    void Process(medida::Counter& counter) override;
+    void Process(medida::Meter& meter) override;
+    void Process(medida::Histogram& histogram) override;
+    void Process(medida::Timer& timer) override;
+    void Process(medida::Buckets& buckets) override;
+
+    // Safe to call from any thread
+    std::string render() const;
+};
+
+// Serves the application's metrics in the Prometheus format on its own
+// thread, off a snapshot that the main thread captures every
+// PROMETHEUS_SNAPSHOT_PERIOD, so that scrapes cost the main thread nothing
+// and never wait for it.
+class PrometheusServer : public NonMovableOrCopyable
+{
+    Application& mApp;
+    std::chrono::seconds const mPeriod;
+    VirtualTimer mTimer;
+    asio::io_context mIOContext;
+    std::unique_ptr<http::server::server> mServer;
+    std::thread mThread;
+
+    std::mutex mSnapshotMutex;
+    std::shared_ptr<PrometheusSnapshot const> mSnapshot;
+
+    void captureSnapshot();
+
+  public:
+    // Captures a first snapshot and starts listening on `address`:`port`
+    // right away
+    PrometheusServer(Application& app, std::string const& address,
+                     unsigned short port, int maxClient,
+                     std::chrono::seconds period);
+
+    // Stops serving and joins the serving thread
+    ~PrometheusServer();
+
+    void notFound(std::string const& params, std::string& retStr);
+
+    // metrics: the latest snapshot in the text exposition format
+    void metrics(std::string const& params, std::string& retStr);
+};
+}
@@ -0,0 +1,220 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "main/QueryServer.h"
+#include "bucket/BucketListSnapshot.h"
+#include "bucket/BucketSnapshotManager.h"
+#include "ledger/LedgerTxnImpl.h"
+#include "ledger/LedgerTypeUtils.h"
+#include "lib/json/json.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/Thread.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <map>
+#include <set>
+
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+namespace stellar
+{
+
+size_t const QueryServer::MAX_KEYS_PER_QUERY = 1000;
+
+QueryServer::QueryServer(std::string const& address, unsigned short port,
+                         int maxClient, size_t threadCount,
+                         BucketSnapshotManager const& snapshotManager)
+    : mSnapshotManager(snapshotManager)
+    , mIOContext(static_cast<int>(threadCount))
+{
+    releaseAssert(threadCount > 0);
+    LOG_INFO(DEFAULT_LOG, "Listening on {}:{} for HTTP queries", address,
+             port);
+
+    mServer = std::make_unique<http::server::server>(mIOContext, address,
+                                                     port, maxClient);
+    mServer->add404(std::bind(&QueryServer::notFound, this, _1, _2));
+    addRoute("getledgerentry", &QueryServer::getLedgerEntry);
+    addRoute("getledgerentries", &QueryServer::getLedgerEntries);
+
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        mThreads.emplace_back([this]() {
+            runCurrentThreadWithLowPriority();
+            mIOContext.run();
+        });
+    }
+}
+
+QueryServer::~QueryServer()
+{
+    mIOContext.stop();
+    for (auto& t : mThreads)
+    {
+        t.join();
+    }
+}
+
+void
+QueryServer::addRoute(std::string const& name,
+                      void (QueryServer::*route)(std::string const&,
+                                                 std::string&))
+{
+    mServer->addRoute(name, [this, route](std::string const& params,
+                                          std::string& retStr) {
+        try
+        {
+            ZoneNamedN(httpZone, "HTTP query handler", true);
+            (this->*route)(params, retStr);
+        }
+        catch (std::exception const& e)
+        {
+            retStr =
+                fmt::format(FMT_STRING(R"({{"exception": "{}"}})"), e.what());
+        }
+        catch (...)
+        {
+            retStr = R"({"exception": "generic"})";
+        }
+    });
+}
+
+SearchableBucketListSnapshot&
+QueryServer::getSnapshot()
+{
+    std::lock_guard<std::mutex> guard(mSnapshotsMutex);
+    auto& snapshot = mSnapshots[std::this_thread::get_id()];
+    if (!snapshot)
+    {
+        snapshot = mSnapshotManager.getSearchableBucketListSnapshot();
+    }
+    return *snapshot;
+}
+
+void
+QueryServer::notFound(std::string const& params, std::string& retStr)
+{
+    retStr = "<b>Welcome to the stellar-core query server!</b><p>"
+             "Supported HTTP queries: getledgerentry?key=<LedgerKey in base64 "
+             "XDR format>, getledgerentries?keys=<LedgerKey in base64 XDR "
+             "format>,...</p>";
+}
+
+void
+QueryServer::getLedgerEntry(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    Json::Value root;
+
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    std::string key = paramMap["key"];
+    if (key.empty())
+    {
+        throw std::invalid_argument(
+            "Must specify ledger key: getledgerentry?key=<LedgerKey in base64 "
+            "XDR format>");
+    }
+
+    LedgerKey k;
+    fromOpaqueBase64(k, key);
+    auto& snapshot = getSnapshot();
+    auto le = snapshot.getLedgerEntry(k);
+    root["ledger"] = snapshot.getLedgerSeq();
+    if (le)
+    {
+        root["state"] = "live";
+        root["entry"] = toOpaqueBase64(*le);
+    }
+    else
+    {
+        root["state"] = "dead";
+    }
+    retStr = Json::FastWriter().write(root);
+}
+
+void
+QueryServer::getLedgerEntries(std::string const& params, std::string& retStr)
+{
+    ZoneScoped;
+    std::map<std::string, std::string> paramMap;
+    http::server::server::parseParams(params, paramMap);
+    auto const& keysParam = paramMap["keys"];
+    if (keysParam.empty())
+    {
+        throw std::invalid_argument(
+            "Must specify ledger keys: getledgerentries?keys=<LedgerKey in "
+            "base64 XDR format>,...");
+    }
+
+    std::vector<LedgerKey> keys;
+    size_t begin = 0;
+    while (begin <= keysParam.size())
+    {
+        auto end = std::min(keysParam.find(',', begin), keysParam.size());
+        if (keys.size() == MAX_KEYS_PER_QUERY)
+        {
+            throw std::invalid_argument(fmt::format(
+                FMT_STRING("At most {} keys can be queried at once"),
+                MAX_KEYS_PER_QUERY));
+        }
+        LedgerKey k;
+        fromOpaqueBase64(k, keysParam.substr(begin, end - begin));
+        keys.emplace_back(k);
+        begin = end + 1;
+    }
+
+    // The TTLs of Soroban entries are loaded along with them, so that both
+    // come from the same ledger
+    std::set<LedgerKey, LedgerEntryIdCmp> toLoad(keys.begin(), keys.end());
+    for (auto const& k : keys)
+    {
+        if (isSorobanEntry(k))
+        {
+            toLoad.emplace(getTTLKey(k));
+        }
+    }
+    auto& snapshot = getSnapshot();
+    auto loaded = populateLoadedEntries(toLoad, snapshot.loadKeys(toLoad));
+    auto const ledgerSeq = snapshot.getLedgerSeq();
+
+    Json::Value root;
+    root["ledger"] = ledgerSeq;
+    root["entries"] = Json::arrayValue;
+    for (auto const& k : keys)
+    {
+        Json::Value res;
+        res["key"] = toOpaqueBase64(k);
+        auto const& le = loaded.at(k);
+        if (!le)
+        {
+            res["state"] = "dead";
+        }
+        else
+        {
+            res["state"] = "live";
+            res["entry"] = toOpaqueBase64(*le);
+            if (isSorobanEntry(k))
+            {
+                // Entries can outlive their TTL until they are evicted
+                auto const& ttl = loaded.at(getTTLKey(k));
+                if (ttl)
+                {
+                    res["liveUntilLedgerSeq"] =
+                        ttl->data.ttl().liveUntilLedgerSeq;
+                    if (!isLive(*ttl, ledgerSeq))
+                    {
+                        res["state"] = "expired";
+                    }
+                }
+            }
+        }
+        root["entries"].append(res);
+    }
+    retStr = Json::FastWriter().write(root);
+}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/http/server.hpp"
+#include "util/NonCopyable.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+class BucketSnapshotManager;
+class SearchableBucketListSnapshot;
+
+// HTTP server for read-only ledger state queries, served by its own pool of
+// threads from BucketList snapshots instead of by the main thread from the
+// LedgerTxnRoot, so that a burst of queries never delays consensus or ledger
+// close. Every thread keeps its own SearchableBucketListSnapshot, which
+// follows the latest closed ledger on each lookup.
+//
+// Only available with BucketListDB, as it needs the BucketList to hold the
+// complete ledger state.
+class QueryServer : public NonMovableOrCopyable
+{
+    BucketSnapshotManager const& mSnapshotManager;
+    asio::io_context mIOContext;
+    std::unique_ptr<http::server::server> mServer;
+    std::vector<std::thread> mThreads;
+
+    std::mutex mSnapshotsMutex;
+    std::unordered_map<std::thread::id,
+                       std::shared_ptr<SearchableBucketListSnapshot>>
+        mSnapshots;
+
+    SearchableBucketListSnapshot& getSnapshot();
+
+    void addRoute(std::string const& name,
+                  void (QueryServer::*route)(std::string const&,
+                                             std::string&));
+
+  public:
+    // Starts listening on `address`:`port` right away, serving requests on
+    // `threadCount` threads
+    QueryServer(std::string const& address, unsigned short port,
+                int maxClient, size_t threadCount,
+                BucketSnapshotManager const& snapshotManager);
+
+    // Stops serving and joins all threads
+    ~QueryServer();
+
+    void notFound(std::string const& params, std::string& retStr);
+
+    // getledgerentry?key=<LedgerKey in base64 XDR format>, with the same
+    // output as the command handler's getledgerentry
+    void getLedgerEntry(std::string const& params, std::string& retStr);
+
+    // getledgerentries?keys=<LedgerKey in base64 XDR format>,... with at
+    // most MAX_KEYS_PER_QUERY keys, all looked up in one pass over the same
+    // snapshot, whose ledger sequence is returned along with every entry
+    // and, for Soroban entries, the ledger their TTL lasts until
+    void getLedgerEntries(std::string const& params, std::string& retStr);
+
+    static size_t const MAX_KEYS_PER_QUERY;
+};
+}
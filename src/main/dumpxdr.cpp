@@ -430,7 +430,7 @@ signtxns(std::vector<TransactionEnvelope>& txEnvs, std::string netId,
             abort();
         }
 
-        auto payloadHash = sha256(xdr::xdr_to_opaque(payload));
+        auto payloadHash = xdrSha256(payload);
 
         signatures.emplace_back(
             SignatureUtils::getHint(sk.getPublicKey().ed25519()),
@@ -2,9 +2,14 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "herder/Herder.h"
+#include "ledger/LedgerCloseTimeline.h"
+#include "ledger/LedgerManager.h"
 #include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTxnImpl.h"
 #include "ledger/test/LedgerTestUtils.h"
 #include "lib/catch.hpp"
+#include "lib/json/json.h"
 #include "main/Application.h"
 #include "main/CommandHandler.h"
 #include "test/TestAccount.h"
@@ -20,8 +25,10 @@
 #include "xdr/Stellar-transaction.h"
 #include "xdrpp/marshal.h"
 #include <fmt/format.h>
+#include <atomic>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 
 using namespace stellar;
 using namespace stellar::txbridge;
@@ -543,3 +550,193 @@ TEST_CASE("manualclose", "[commandhandler]")
         }
     }
 }
+
+TEST_CASE("batch transaction submission", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto b64 = [](TransactionFrameBasePtr const& tx) {
+        return decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope()));
+    };
+
+    auto tx1 = root.tx({payment(root, 1)});
+    auto tx2 = root.tx({payment(root, 2)});
+    // the sequence number was already used
+    auto badTx = root.tx({payment(root, 3)}, tx1->getSeqNum());
+
+    std::string retStr;
+    app->getCommandHandler().txBatch(
+        fmt::format("?blobs={},{},{},not-a-tx,{}", b64(tx1), b64(tx2),
+                    b64(tx1), b64(badTx)),
+        retStr);
+
+    Json::Value res;
+    REQUIRE(Json::Reader().parse(retStr, res));
+    REQUIRE(res.size() == 5);
+    REQUIRE(res[0]["status"] == "PENDING");
+    REQUIRE(res[1]["status"] == "PENDING");
+    REQUIRE(res[2]["status"] == "DUPLICATE");
+    REQUIRE(res[3].isMember("exception"));
+    REQUIRE(res[4]["status"] == "ERROR");
+    REQUIRE(res[4].isMember("error"));
+    REQUIRE(app->getHerder().getTx(tx2->getFullHash()));
+
+    REQUIRE_THROWS_AS(app->getCommandHandler().txBatch("", retStr),
+                      std::invalid_argument);
+}
+
+TEST_CASE("dry run of the candidate tx set", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& lm = app->getLedgerManager();
+    auto const minBalance = lm.getLastMinBalance(0);
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("a1", minBalance);
+
+    auto tx = root.tx({payment(a1, 100)});
+    REQUIRE(app->getHerder().recvTransaction(tx, false) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+    auto lcl = lm.getLastClosedLedgerHeader();
+
+    auto [txSet, closeTime] = app->getHerder().makeCandidateTxSet();
+    auto cost = lm.dryRunTxSet(*txSet, closeTime, /* withMeta */ false);
+    REQUIRE(cost.mTxCount == 1);
+    REQUIRE(cost.mOpCount == 1);
+    REQUIRE(cost.mTxSucceeded == 1);
+    // root and a1
+    REQUIRE(cost.mEntriesUpdated == 2);
+    REQUIRE(cost.mEntriesCreated == 0);
+    REQUIRE(cost.mEntriesDeleted == 0);
+    REQUIRE(cost.mSorobanResources.isZero());
+    REQUIRE(cost.mMetaBytes == 0);
+
+    // It can be repeated on the same ledger, building the meta this time
+    auto costWithMeta = lm.dryRunTxSet(*txSet, closeTime, /* withMeta */ true);
+    REQUIRE(costWithMeta.mTxSucceeded == 1);
+    REQUIRE(costWithMeta.mEntriesUpdated == 2);
+    REQUIRE(costWithMeta.mMetaBytes > 0);
+
+    // Nothing was committed and the queued transaction is left untouched
+    REQUIRE(lm.getLastClosedLedgerHeader().hash == lcl.hash);
+    REQUIRE(a1.getBalance() == minBalance);
+    REQUIRE(!app->getHerder().isBannedTx(tx->getFullHash()));
+    REQUIRE(app->getHerder().getTx(tx->getFullHash()) == tx);
+}
+
+TEST_CASE("ledger close timeline", "[commandhandler]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto& timeline = app->getLedgerManager().getCloseTimeline();
+    using Event = LedgerCloseTimeline::Event;
+
+    closeLedger(*app);
+    auto ledgerSeq = app->getLedgerManager().getLastClosedLedgerNum();
+
+    auto offsets = timeline.getOffsets(ledgerSeq);
+    std::vector<Event> const expected = {
+        Event::EXTERNALIZED,     Event::VALUE_EXTERNALIZED,
+        Event::APPLY_START,      Event::APPLY_END,
+        Event::BUCKET_ADD_BATCH, Event::COMMIT};
+    double prev = 0;
+    for (auto e : expected)
+    {
+        REQUIRE(offsets.count(e) == 1);
+        REQUIRE(offsets[e] >= prev);
+        prev = offsets[e];
+    }
+
+    std::string retStr;
+    app->getCommandHandler().ledgerTimeline(
+        fmt::format("ledger={}", ledgerSeq), retStr);
+    Json::Value res;
+    REQUIRE(Json::Reader().parse(retStr, res));
+    REQUIRE(res.size() == 1);
+    auto const& info = res[std::to_string(ledgerSeq)];
+    REQUIRE(info["offsets_ms"].size() == offsets.size());
+    REQUIRE(info["offsets_ms"]["commit"].asDouble() == offsets[Event::COMMIT]);
+
+    SECTION("only the last ledgers are kept")
+    {
+        auto last = ledgerSeq + LedgerCloseTimeline::MAX_LEDGERS;
+        for (auto seq = ledgerSeq + 1; seq <= last; ++seq)
+        {
+            timeline.record(seq, Event::NOMINATION_START);
+        }
+        REQUIRE(timeline.getOffsets(ledgerSeq).empty());
+        timeline.record(ledgerSeq, Event::META_EMITTED);
+        REQUIRE(timeline.getOffsets(ledgerSeq).empty());
+        REQUIRE(timeline.getJsonInfo(std::nullopt).size() ==
+                LedgerCloseTimeline::MAX_LEDGERS);
+    }
+}
+
+TEST_CASE("commands served off the main thread", "[commandhandler]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.HTTP_COMMAND_THREADS = 1;
+    // For getledgerentry to be served from BucketList snapshots
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto app = createTestApplication(clock, cfg);
+    auto& ch = app->getCommandHandler();
+
+    // Runs the command as a serving thread would
+    std::atomic<bool> done{false};
+    std::string res;
+    std::thread t;
+    auto start = [&](std::string const& cmd) {
+        done = false;
+        t = std::thread([&, cmd]() {
+            res = ch.manualCmd(cmd);
+            done = true;
+        });
+    };
+
+    SECTION("main thread commands wait for the main thread")
+    {
+        start("info");
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        REQUIRE(!done);
+        while (!done)
+        {
+            clock.crank(false);
+        }
+        t.join();
+        Json::Value info;
+        REQUIRE(Json::Reader().parse(res, info));
+        REQUIRE(info.isMember("info"));
+    }
+
+    SECTION("thread-safe commands don't")
+    {
+        start("zones");
+        t.join();
+        Json::Value zones;
+        REQUIRE(Json::Reader().parse(res, zones));
+        REQUIRE(zones.isMember("sample_period"));
+
+        LedgerKey key(ACCOUNT);
+        key.account().accountID = getRoot(app->getNetworkID()).getPublicKey();
+        start("getledgerentry?key=" + toOpaqueBase64(key));
+        t.join();
+        Json::Value entry;
+        REQUIRE(Json::Reader().parse(res, entry));
+        REQUIRE(entry["state"].asString() == "live");
+        REQUIRE(entry["ledger"].asUInt() ==
+                app->getLedgerManager().getLastClosedLedgerNum());
+    }
+
+    SECTION("shutdown answers commands waiting for the main thread")
+    {
+        start("info");
+        ch.shutdown();
+        t.join();
+        REQUIRE(res.find("shutting down") != std::string::npos);
+        // Commands still run when called from the main thread
+        REQUIRE(ch.manualCmd("zones").find("sample_period") !=
+                std::string::npos);
+    }
+}
@@ -0,0 +1,87 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "main/MemoryBudget.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+
+using namespace stellar;
+
+TEST_CASE("memory budget shares", "[memorybudget]")
+{
+    SECTION("weighted when everyone is over its share")
+    {
+        auto shares =
+            MemoryBudget::computeShares(1000, {5000, 5000, 5000}, {2, 1, 1});
+        REQUIRE(shares == std::vector<uint64_t>{500, 250, 250});
+    }
+
+    SECTION("unused share goes to the others")
+    {
+        auto shares =
+            MemoryBudget::computeShares(1000, {100, 5000, 5000}, {2, 1, 1});
+        REQUIRE(shares == std::vector<uint64_t>{100, 450, 450});
+    }
+
+    SECTION("settling cascades")
+    {
+        // Once the first one is settled, the second is within its share
+        auto shares =
+            MemoryBudget::computeShares(1000, {100, 400, 5000}, {1, 1, 1});
+        REQUIRE(shares == std::vector<uint64_t>{100, 400, 500});
+    }
+
+    SECTION("everyone within the budget keeps what it uses")
+    {
+        auto shares =
+            MemoryBudget::computeShares(1000, {0, 200, 300}, {4, 2, 1});
+        REQUIRE(shares == std::vector<uint64_t>{0, 200, 300});
+    }
+}
+
+TEST_CASE("memory budget enforcement", "[memorybudget]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    MemoryBudget budget(*app, 1000);
+
+    uint64_t bigBytes = 3000;
+    uint64_t smallBytes = 100;
+    budget.registerConsumer(
+        "test-big", 1, [&]() { return bigBytes; },
+        [&](uint64_t maxBytes) { bigBytes = std::min(bigBytes, maxBytes); });
+    budget.registerConsumer(
+        "test-small", 1, [&]() { return smallBytes; },
+        [&](uint64_t) { FAIL("within its share"); });
+
+    auto& metrics = app->getMetrics();
+    REQUIRE(budget.enforce() == 1);
+    REQUIRE(bigBytes == 900);
+    REQUIRE(metrics.NewCounter({"memory", "test-big", "bytes"}).count() ==
+            3000);
+    REQUIRE(metrics.NewCounter({"memory", "total", "bytes"}).count() == 3100);
+    REQUIRE(metrics.NewMeter({"memory", "test-big", "shrink"}, "shrink")
+                .count() == 1);
+
+    // Within the budget, nothing shrinks, however the shares are split
+    smallBytes = 50;
+    REQUIRE(budget.enforce() == 0);
+    REQUIRE(bigBytes == 900);
+
+    SECTION("enforced periodically once started")
+    {
+        bigBytes = 5000;
+        budget.start();
+        testutil::crankFor(clock, std::chrono::seconds(6));
+        REQUIRE(bigBytes == 950);
+        budget.shutdown();
+    }
+}
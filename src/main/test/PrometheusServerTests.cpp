@@ -0,0 +1,84 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/PrometheusServer.h"
+#include "medida/counter.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+#include "test/TestUtils.h"
+#include "test/test.h"
+
+#include <thread>
+
+using namespace stellar;
+
+TEST_CASE("prometheus snapshot", "[prometheus]")
+{
+    medida::MetricsRegistry registry;
+    registry.NewCounter({"overlay", "connection", "pending"}).inc(3);
+    registry.NewMeter({"ledger", "operation-payment", "failure"}, "operation")
+        .Mark(2);
+    registry
+        .NewMeter({"ledger", "operation-create-account", "failure"},
+                  "operation")
+        .Mark();
+    registry.NewTimer({"ledger", "ledger", "close"})
+        .Update(std::chrono::milliseconds(250));
+
+    PrometheusSnapshot snapshot(registry);
+    // Updates after the capture aren't seen
+    registry.NewCounter({"overlay", "connection", "pending"}).inc();
+
+    auto text = snapshot.render();
+    auto has = [&](std::string const& line) {
+        return text.find(line + "\n") != std::string::npos;
+    };
+    CHECK(has("# TYPE stellar_core_overlay_connection_pending gauge"));
+    CHECK(has("stellar_core_overlay_connection_pending 3"));
+
+    // Per operation type meters are one counter with a label
+    CHECK(has("# TYPE stellar_core_ledger_operation_failure_total counter"));
+    CHECK(has("stellar_core_ledger_operation_failure_total{type=\"payment\"} "
+              "2"));
+    CHECK(has("stellar_core_ledger_operation_failure_total"
+              "{type=\"create-account\"} 1"));
+
+    CHECK(has("# TYPE stellar_core_ledger_ledger_close_seconds summary"));
+    CHECK(text.find("stellar_core_ledger_ledger_close_seconds"
+                    "{quantile=\"0.99\"} ") != std::string::npos);
+    CHECK(has("stellar_core_ledger_ledger_close_seconds_sum 0.25"));
+    CHECK(has("stellar_core_ledger_ledger_close_seconds_count 1"));
+}
+
+TEST_CASE("prometheus server serves snapshots off the main thread",
+          "[prometheus]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    auto const port = cfg.HTTP_PORT;
+    cfg.HTTP_PORT = 0;
+    auto app = createTestApplication(clock, cfg);
+
+    PrometheusServer ps(*app, "127.0.0.1", port, cfg.HTTP_MAX_CLIENT,
+                        std::chrono::seconds(1));
+    auto& counter = app->getMetrics().NewCounter({"test", "prometheus", "c"});
+    counter.inc(7);
+
+    auto scrape = [&]() {
+        std::string res;
+        std::thread t([&]() { ps.metrics("", res); });
+        t.join();
+        return res;
+    };
+    // Captured before the counter was set
+    REQUIRE(scrape().find("stellar_core_test_prometheus_c 7\n") ==
+            std::string::npos);
+
+    testutil::crankFor(clock, std::chrono::seconds(2));
+    REQUIRE(scrape().find("stellar_core_test_prometheus_c 7\n") !=
+            std::string::npos);
+}
@@ -0,0 +1,127 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "bucket/BucketManager.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxnImpl.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/CommandHandler.h"
+#include "main/QueryServer.h"
+#include "test/TestAccount.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "transactions/TransactionUtils.h"
+
+#include "lib/json/json.h"
+#include <thread>
+
+using namespace stellar;
+using namespace stellar::txtest;
+
+TEST_CASE("query server answers from bucket list snapshots", "[queryserver]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto const port = cfg.HTTP_PORT;
+    cfg.HTTP_PORT = 0;
+    auto app = createTestApplication(clock, cfg);
+
+    QueryServer qs("127.0.0.1", port, cfg.HTTP_MAX_CLIENT, 2,
+                   app->getBucketManager().getBucketSnapshotManager());
+
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("a1", app->getLedgerManager().getLastMinBalance(1));
+    auto b1 = getAccount("b1");
+
+    // Queries made off the main thread must give the same answers as the
+    // command handler gives on it
+    auto check = [&](LedgerKey const& key) {
+        auto params = "?key=" + toOpaqueBase64(key);
+        std::string expected;
+        app->getCommandHandler().getLedgerEntry(params, expected);
+
+        std::string res;
+        std::thread t([&]() { qs.getLedgerEntry(params, res); });
+        t.join();
+        REQUIRE(res == expected);
+        return res;
+    };
+
+    auto const before = check(accountKey(a1.getPublicKey()));
+    REQUIRE(before.find("\"live\"") != std::string::npos);
+    REQUIRE(check(accountKey(b1.getPublicKey())).find("\"dead\"") !=
+            std::string::npos);
+
+    // Snapshots follow newly closed ledgers
+    root.pay(a1, 100);
+    REQUIRE(check(accountKey(a1.getPublicKey())) != before);
+
+    std::string res;
+    REQUIRE_THROWS_AS(qs.getLedgerEntry("", res), std::invalid_argument);
+}
+
+TEST_CASE("query server batches ledger entry lookups", "[queryserver]")
+{
+    VirtualClock clock;
+    Config cfg(getTestConfig());
+    cfg.DEPRECATED_SQL_LEDGER_STATE = false;
+    auto const port = cfg.HTTP_PORT;
+    cfg.HTTP_PORT = 0;
+    auto app = createTestApplication(clock, cfg);
+
+    QueryServer qs("127.0.0.1", port, cfg.HTTP_MAX_CLIENT, 1,
+                   app->getBucketManager().getBucketSnapshotManager());
+
+    auto root = TestAccount::createRoot(*app);
+    auto a1 = root.create("a1", app->getLedgerManager().getLastMinBalance(1));
+    auto b1 = getAccount("b1");
+
+    auto query = [&](std::vector<LedgerKey> const& keys) {
+        std::string params = "?keys=";
+        for (auto const& k : keys)
+        {
+            params += toOpaqueBase64(k) + ",";
+        }
+        params.pop_back();
+        std::string res;
+        std::thread t([&]() { qs.getLedgerEntries(params, res); });
+        t.join();
+        Json::Value json;
+        REQUIRE(Json::Reader().parse(res, json));
+        return json;
+    };
+
+    auto const a1Key = accountKey(a1.getPublicKey());
+    auto const b1Key = accountKey(b1.getPublicKey());
+    auto res = query({b1Key, a1Key, b1Key});
+    REQUIRE(res["ledger"].asUInt() ==
+            app->getLedgerManager().getLastClosedLedgerNum());
+    auto const& entries = res["entries"];
+    REQUIRE(entries.size() == 3);
+    // In the order asked for
+    REQUIRE(entries[0]["key"].asString() == toOpaqueBase64(b1Key));
+    REQUIRE(entries[0]["state"].asString() == "dead");
+    REQUIRE(entries[1]["state"].asString() == "live");
+    REQUIRE(entries[2]["state"].asString() == "dead");
+
+    LedgerEntry le;
+    fromOpaqueBase64(le, entries[1]["entry"].asString());
+    REQUIRE(le.data.account().balance == a1.getBalance());
+
+    std::vector<LedgerKey> tooMany(QueryServer::MAX_KEYS_PER_QUERY + 1,
+                                   a1Key);
+    std::string params = "?keys=";
+    for (auto const& k : tooMany)
+    {
+        params += toOpaqueBase64(k) + ",";
+    }
+    params.pop_back();
+    std::string ret;
+    REQUIRE_THROWS_AS(qs.getLedgerEntries(params, ret),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(qs.getLedgerEntries("", ret), std::invalid_argument);
+}
@@ -0,0 +1,61 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "overlay/EncodedMessageCache.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+#include "xdrpp/marshal.h"
+
+namespace stellar
+{
+
+void
+EncodedMessageCache::add(std::shared_ptr<StellarMessage const> const& msg)
+{
+    releaseAssert(threadIsMain());
+    if (mEncodings.find(Key(msg)) == mEncodings.end())
+    {
+        add(msg, std::make_shared<xdr::opaque_vec<> const>(
+                     xdr::xdr_to_opaque(*msg)));
+    }
+}
+
+void
+EncodedMessageCache::add(std::shared_ptr<StellarMessage const> const& msg,
+                         std::shared_ptr<xdr::opaque_vec<> const> encoding)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    Key key(msg);
+    if (mEncodings.find(key) != mEncodings.end())
+    {
+        return;
+    }
+    mEncodings.emplace(key, std::move(encoding));
+    mOrder.emplace_back(key);
+
+    // Messages are usually sent to all the peers shortly after being added,
+    // so only look for the released ones at the front
+    while (!mOrder.empty() &&
+           (mOrder.front().expired() || mOrder.size() > MAX_ENTRIES))
+    {
+        mEncodings.erase(mOrder.front());
+        mOrder.pop_front();
+    }
+}
+
+std::shared_ptr<xdr::opaque_vec<> const>
+EncodedMessageCache::get(std::shared_ptr<StellarMessage const> const& msg) const
+{
+    releaseAssert(threadIsMain());
+    auto it = mEncodings.find(Key(msg));
+    return it == mEncodings.end() ? nullptr : it->second;
+}
+
+size_t
+EncodedMessageCache::size() const
+{
+    return mEncodings.size();
+}
+}
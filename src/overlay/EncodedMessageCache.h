@@ -0,0 +1,45 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "xdr/Stellar-overlay.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+
+namespace stellar
+{
+
+// Keeps the XDR encoding of the messages broadcast to several peers, so that
+// each of them is encoded once instead of once per peer. Messages are
+// identified by the shared_ptr they are sent with, and are forgotten once
+// it is released.
+class EncodedMessageCache
+{
+  public:
+    static size_t const MAX_ENTRIES = 1024;
+
+    void add(std::shared_ptr<StellarMessage const> const& msg);
+    // Same, with its encoding already at hand
+    void add(std::shared_ptr<StellarMessage const> const& msg,
+             std::shared_ptr<xdr::opaque_vec<> const> encoding);
+
+    // Encoding of `msg`, or nullptr if it wasn't added
+    std::shared_ptr<xdr::opaque_vec<> const>
+    get(std::shared_ptr<StellarMessage const> const& msg) const;
+
+    size_t size() const;
+
+  private:
+    using Key = std::weak_ptr<StellarMessage const>;
+
+    std::map<Key, std::shared_ptr<xdr::opaque_vec<> const>,
+             std::owner_less<Key>>
+        mEncodings;
+    // Keys in the order they were added
+    std::deque<Key> mOrder;
+};
+}
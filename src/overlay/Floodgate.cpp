@@ -6,24 +6,20 @@
 #include "crypto/BLAKE2.h"
 #include "crypto/Hex.h"
 #include "herder/Herder.h"
+#include "lib/util/stdrandom.h"
 #include "main/Application.h"
 #include "medida/counter.h"
 #include "medida/metrics_registry.h"
+#include "overlay/EncodedMessageCache.h"
 #include "overlay/OverlayManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/Math.h"
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 namespace stellar
 {
-Floodgate::FloodRecord::FloodRecord(uint32_t ledger, Peer::pointer peer)
-    : mLedgerSeq(ledger)
-{
-    if (peer)
-        mPeersTold.insert(peer->toString());
-}
-
 Floodgate::Floodgate(Application& app)
     : mApp(app)
     , mFloodMapSize(
@@ -32,6 +28,8 @@ Floodgate::Floodgate(Application& app)
           {"overlay", "flood", "broadcast"}, "message"))
     , mMessagesAdvertised(app.getMetrics().NewMeter(
           {"overlay", "flood", "advertised"}, "message"))
+    , mSendToQuorumFirst(app.getMetrics().NewMeter(
+          {"overlay", "flood", "quorum-first"}, "message"))
     , mShuttingDown(false)
 {
 }
@@ -41,20 +39,82 @@ void
 Floodgate::clearBelow(uint32_t maxLedger)
 {
     ZoneScoped;
-    for (auto it = mFloodMap.cbegin(); it != mFloodMap.cend();)
+    auto end = mLedgerRecords.lower_bound(maxLedger);
+    for (auto it = mLedgerRecords.begin(); it != end; ++it)
     {
-        if (it->second->mLedgerSeq < maxLedger)
+        for (auto& record : it->second)
         {
-            it = mFloodMap.erase(it);
+            // Forgotten records may have been added again since
+            auto current = mFloodMap.find(record.mMsgID);
+            if (current != mFloodMap.end() && current->second == &record)
+            {
+                mFloodMap.erase(current);
+            }
         }
-        else
+    }
+    mLedgerRecords.erase(mLedgerRecords.begin(), end);
+
+    for (size_t slot = 0; slot < mPeerSlots.size(); ++slot)
+    {
+        auto& ps = mPeerSlots[slot];
+        if (ps && ps->mLastLedgerSeq < maxLedger)
         {
-            ++it;
+            mSlotByPeer.erase(ps->mPeer);
+            ps.reset();
+            mFreeSlots.emplace_back(slot);
         }
     }
     mFloodMapSize.set_count(mFloodMap.size());
 }
 
+Floodgate::FloodRecord&
+Floodgate::newRecord(Hash const& msgID)
+{
+    auto ledgerSeq = mApp.getHerder().trackingConsensusLedgerIndex();
+    auto& records = mLedgerRecords[ledgerSeq];
+    auto& record = records.emplace_back(FloodRecord{msgID, ledgerSeq, {}});
+    mFloodMap[msgID] = &record;
+    mFloodMapSize.set_count(mFloodMap.size());
+    TracyPlot("overlay.memory.flood-known",
+              static_cast<int64_t>(mFloodMap.size()));
+    return record;
+}
+
+bool
+Floodgate::setPeerTold(FloodRecord& record, std::string const& peer)
+{
+    auto it = mSlotByPeer.find(peer);
+    size_t slot;
+    if (it != mSlotByPeer.end())
+    {
+        slot = it->second;
+    }
+    else
+    {
+        if (mFreeSlots.empty())
+        {
+            slot = mPeerSlots.size();
+            mPeerSlots.emplace_back();
+        }
+        else
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        mPeerSlots[slot] = PeerSlot{peer, record.mLedgerSeq};
+        mSlotByPeer.emplace(peer, slot);
+    }
+
+    auto& ps = *mPeerSlots[slot];
+    ps.mLastLedgerSeq = std::max(ps.mLastLedgerSeq, record.mLedgerSeq);
+    if (record.mPeersTold.get(slot))
+    {
+        return false;
+    }
+    record.mPeersTold.set(slot);
+    return true;
+}
+
 bool
 Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer, Hash& index)
 {
@@ -65,20 +125,34 @@ Floodgate::addRecord(StellarMessage const& msg, Peer::pointer peer, Hash& index)
         return false;
     }
     auto result = mFloodMap.find(index);
-    if (result == mFloodMap.end())
-    { // we have never seen this message
-        mFloodMap[index] = std::make_shared<FloodRecord>(
-            mApp.getHerder().trackingConsensusLedgerIndex(), peer);
-        mFloodMapSize.set_count(mFloodMap.size());
-        TracyPlot("overlay.memory.flood-known",
-                  static_cast<int64_t>(mFloodMap.size()));
-        return true;
+    bool isNew = result == mFloodMap.end();
+    // we have never seen this message
+    auto& record = isNew ? newRecord(index) : *result->second;
+    if (peer)
+    {
+        setPeerTold(record, peer->toString());
     }
-    else
+    return isNew;
+}
+
+bool
+Floodgate::addKnownRecord(Hash const& msgID, Peer::pointer fromPeer)
+{
+    ZoneScoped;
+    if (mShuttingDown)
+    {
+        return false;
+    }
+    auto result = mFloodMap.find(msgID);
+    if (result == mFloodMap.end())
     {
-        result->second->mPeersTold.insert(peer->toString());
         return false;
     }
+    if (fromPeer)
+    {
+        setPeerTold(*result->second, fromPeer->toString());
+    }
+    return true;
 }
 
 // send message to anyone you haven't gotten it from
@@ -97,28 +171,40 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
         // Must pass a hash when broadcasting transactions.
         releaseAssert(hash.has_value());
     }
-    Hash index = xdrBlake2(*msg);
 
-    FloodRecord::pointer fr;
-    auto result = mFloodMap.find(index);
-    if (result == mFloodMap.end())
-    { // no one has sent us this message / start from scratch
-        fr = std::make_shared<FloodRecord>(
-            mApp.getHerder().trackingConsensusLedgerIndex(), Peer::pointer());
-        mFloodMap[index] = fr;
-        mFloodMapSize.set_count(mFloodMap.size());
+    // make a copy, in case peers gets modified
+    auto peers = mApp.getOverlayManager().getAuthenticatedPeers();
+
+    bool pullMode = msg->type() == TRANSACTION;
+    Hash index;
+    if (!pullMode && peers.size() > 1)
+    {
+        // Encode the message once for all the peers, hashing it on the way
+        auto encoding = std::make_shared<xdr::opaque_vec<>>();
+        index = xdrBlake2Encode(*msg, *encoding);
+        mApp.getOverlayManager().getEncodedMessageCache().add(msg, encoding);
     }
     else
     {
-        fr = result->second;
+        index = xdrBlake2(*msg);
     }
-    // send it to people that haven't sent it to us
-    auto& peersTold = fr->mPeersTold;
 
-    // make a copy, in case peers gets modified
-    auto peers = mApp.getOverlayManager().getAuthenticatedPeers();
+    auto result = mFloodMap.find(index);
+    // no one has sent us this message / start from scratch
+    auto& record =
+        result == mFloodMap.end() ? newRecord(index) : *result->second;
+
+    // With SCP_RELAY_QUORUM_FIRST, SCP messages are sent right away to the
+    // peers in our transitive quorum, the other peers only get them once the
+    // sends queued on the main thread before them are done
+    QuorumTracker::QuorumMap const* quorum = nullptr;
+    if (msg->type() == SCP_MESSAGE && mApp.getConfig().SCP_RELAY_QUORUM_FIRST)
+    {
+        quorum = &mApp.getHerder().getCurrentlyTrackedQuorum();
+    }
 
     bool broadcasted = false;
+    std::vector<Peer::pointer> advertPeers;
     for (auto peer : peers)
     {
         releaseAssert(peer.second->isAuthenticated());
@@ -130,16 +216,19 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
             continue;
         }
 
-        bool pullMode = msg->type() == TRANSACTION;
-
-        if (peersTold.insert(peer.second->toString()).second)
+        // send it to people that haven't sent it to us
+        if (setPeerTold(record, peer.second->toString()))
         {
             if (pullMode)
             {
-                if (peer.second->sendAdvert(hash.value()))
-                {
-                    mMessagesAdvertised.Mark();
-                }
+                advertPeers.emplace_back(peer.second);
+            }
+            else if (quorum &&
+                     quorum->find(peer.second->getPeerID()) != quorum->end())
+            {
+                mSendFromBroadcast.Mark();
+                mSendToQuorumFirst.Mark();
+                peer.second->sendMessage(msg, !broadcasted);
             }
             else
             {
@@ -160,8 +249,32 @@ Floodgate::broadcast(std::shared_ptr<StellarMessage const> msg,
             broadcasted = true;
         }
     }
+
+    if (!advertPeers.empty())
+    {
+        // With FLOOD_ADVERT_FANOUT set, only a random subset of the peers
+        // get the advert right away, the others get it later if they still
+        // need it
+        auto fanout = static_cast<size_t>(mApp.getConfig().FLOOD_ADVERT_FANOUT);
+        if (fanout == 0)
+        {
+            fanout = advertPeers.size();
+        }
+        else if (fanout < advertPeers.size())
+        {
+            stellar::shuffle(advertPeers.begin(), advertPeers.end(),
+                             gRandomEngine);
+        }
+        for (size_t i = 0; i < advertPeers.size(); ++i)
+        {
+            if (advertPeers[i]->sendAdvert(hash.value(), i >= fanout))
+            {
+                mMessagesAdvertised.Mark();
+            }
+        }
+    }
     CLOG_TRACE(Overlay, "broadcast {} told {}", hexAbbrev(index),
-               peersTold.size());
+               record.mPeersTold.count());
     return broadcasted;
 }
 
@@ -172,11 +285,12 @@ Floodgate::getPeersKnows(Hash const& h)
     auto record = mFloodMap.find(h);
     if (record != mFloodMap.end())
     {
-        auto& ids = record->second->mPeersTold;
+        auto const& told = record->second->mPeersTold;
         auto const& peers = mApp.getOverlayManager().getAuthenticatedPeers();
         for (auto& p : peers)
         {
-            if (ids.find(p.second->toString()) != ids.end())
+            auto slot = mSlotByPeer.find(p.second->toString());
+            if (slot != mSlotByPeer.end() && told.get(slot->second))
             {
                 res.insert(p.second);
             }
@@ -190,6 +304,7 @@ Floodgate::shutdown()
 {
     mShuttingDown = true;
     mFloodMap.clear();
+    mLedgerRecords.clear();
 }
 
 void
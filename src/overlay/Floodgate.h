@@ -5,7 +5,12 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/Peer.h"
+#include "util/BitSet.h"
+#include "util/UnorderedMap.h"
+#include <deque>
 #include <map>
+#include <optional>
+#include <vector>
 
 /**
  * FloodGate keeps track of which peers have sent us which broadcast messages,
@@ -18,6 +23,11 @@
  * All messages are marked with the ledger sequence number to which they
  * relate, and all flood-management information for a given ledger number
  * is purged from the FloodGate when the ledger closes.
+ *
+ * Records are grouped by ledger so that a ledger is purged at once, without
+ * looking at the records of the other ledgers. The peers a message was
+ * exchanged with are kept as a bitmap of small per-peer slots, a slot being
+ * reused only once all the records it was set in have been purged.
  */
 
 namespace medida
@@ -32,24 +42,40 @@ struct StellarMessage;
 
 class Floodgate
 {
-    class FloodRecord
+    struct FloodRecord
     {
-      public:
-        typedef std::shared_ptr<FloodRecord> pointer;
-
+        Hash mMsgID;
         uint32_t mLedgerSeq;
-        std::set<std::string> mPeersTold;
+        BitSet mPeersTold;
+    };
+
+    // Records by the ledger they were added in; references to the elements
+    // of a deque stay valid as it grows
+    std::map<uint32_t, std::deque<FloodRecord>> mLedgerRecords;
+    // Current record of each message
+    UnorderedMap<Hash, FloodRecord*> mFloodMap;
 
-        FloodRecord(uint32_t ledger, Peer::pointer peer);
+    struct PeerSlot
+    {
+        std::string mPeer;
+        // Latest ledger of the records this slot was set in
+        uint32_t mLastLedgerSeq;
     };
+    std::vector<std::optional<PeerSlot>> mPeerSlots;
+    UnorderedMap<std::string, size_t> mSlotByPeer;
+    std::vector<size_t> mFreeSlots;
 
-    std::map<Hash, FloodRecord::pointer> mFloodMap;
     Application& mApp;
     medida::Counter& mFloodMapSize;
     medida::Meter& mSendFromBroadcast;
     medida::Meter& mMessagesAdvertised;
+    medida::Meter& mSendToQuorumFirst;
     bool mShuttingDown;
 
+    FloodRecord& newRecord(Hash const& msgID);
+    // Mark `record` as exchanged with `peer`, returns true if it wasn't yet
+    bool setPeerTold(FloodRecord& record, std::string const& peer);
+
   public:
     Floodgate(Application& app);
     // forget data strictly older than `maxLedger`
@@ -58,6 +84,9 @@ class Floodgate
     // fills msgID with msg's hash
     bool addRecord(StellarMessage const& msg, Peer::pointer fromPeer,
                    Hash& msgID);
+    // Same as addRecord for a message already known by its hash `msgID`:
+    // returns false, without adding it, if there's no record of it
+    bool addKnownRecord(Hash const& msgID, Peer::pointer fromPeer);
 
     // returns true if msg was sent to at least one peer
     // The hash required for transactions
@@ -76,5 +105,11 @@ class Floodgate
     void forgetRecord(Hash const& msgID);
 
     void shutdown();
+
+    size_t
+    getRecordCount() const
+    {
+        return mFloodMap.size();
+    }
 };
 }
@@ -4,13 +4,16 @@
 
 #include "overlay/FlowControl.h"
 #include "herder/Herder.h"
+#include "herder/SurgePricingUtils.h"
 #include "main/Application.h"
+#include "medida/histogram.h"
 #include "medida/meter.h"
 #include "medida/timer.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <algorithm>
 
 namespace stellar
 {
@@ -18,6 +21,37 @@ namespace stellar
 constexpr std::chrono::seconds const OUTBOUND_QUEUE_TIMEOUT =
     std::chrono::seconds(30);
 
+namespace
+{
+// Inclusion fee bid and number of operations of `env`, read from the
+// envelope to avoid building a transaction frame for each queued message.
+// This matches TransactionFrameBase for all the transactions that are valid.
+std::pair<int64_t, uint32_t>
+getInclusionFeeBid(TransactionEnvelope const& env)
+{
+    auto resourceFee = [](Transaction const& tx) -> int64_t {
+        return tx.ext.v() == 1 ? tx.ext.sorobanData().resourceFee : 0;
+    };
+    switch (env.type())
+    {
+    case ENVELOPE_TYPE_TX_V0:
+        return {env.v0().tx.fee,
+                static_cast<uint32_t>(env.v0().tx.operations.size())};
+    case ENVELOPE_TYPE_TX:
+        return {env.v1().tx.fee - resourceFee(env.v1().tx),
+                static_cast<uint32_t>(env.v1().tx.operations.size())};
+    case ENVELOPE_TYPE_TX_FEE_BUMP:
+    {
+        auto const& inner = env.feeBump().tx.innerTx.v1().tx;
+        return {env.feeBump().tx.fee - resourceFee(inner),
+                static_cast<uint32_t>(inner.operations.size()) + 1};
+    }
+    default:
+        abort();
+    }
+}
+}
+
 size_t
 FlowControl::getOutboundQueueByteLimit() const
 {
@@ -60,6 +94,7 @@ FlowControl::start(
 {
     mNodeID = peerID;
     mSendCallback = sendCb;
+    mLastSendMoreTime = mAppConnector.now();
 
     if (enableFCBytes)
     {
@@ -77,8 +112,9 @@ FlowControl::maybeReleaseCapacityAndTriggerSend(StellarMessage const& msg)
     {
         if (mNoOutboundCapacity)
         {
-            mOverlayMetrics.mConnectionFloodThrottle.Update(
-                mAppConnector.now() - *mNoOutboundCapacity);
+            auto throttled = mAppConnector.now() - *mNoOutboundCapacity;
+            mOverlayMetrics.mConnectionFloodThrottle.Update(throttled);
+            mMetrics.mFloodThrottle.Update(throttled);
         }
         mNoOutboundCapacity.reset();
 
@@ -226,6 +262,58 @@ FlowControl::handleTxSizeIncrease(uint32_t increase)
     }
 }
 
+void
+FlowControl::setRoundTripTime(std::chrono::milliseconds rtt)
+{
+    mRoundTripTime = rtt;
+}
+
+void
+FlowControl::resizeWindow(FlowControlCapacity& capacity, uint64_t minWindow,
+                          uint64_t& grant, uint64_t minGrant,
+                          VirtualClock::duration elapsed)
+{
+    ZoneScoped;
+    releaseAssert(mRoundTripTime);
+    // SEND_MORE carries 32-bit amounts
+    uint64_t const maxWindow = std::min<uint64_t>(
+        minWindow * mAppConnector.getConfig().FLOW_CONTROL_MAX_CAPACITY_FACTOR,
+        UINT32_MAX);
+    uint64_t target = maxWindow;
+    if (elapsed.count() > 0)
+    {
+        // In flight: what we processed per unit of time, times the time to
+        // get our request to the peer and its data back
+        double inFlight = static_cast<double>(grant) *
+                          std::chrono::duration<double>(*mRoundTripTime) /
+                          std::chrono::duration<double>(elapsed);
+        target = static_cast<uint64_t>(
+            std::min(2 * inFlight, static_cast<double>(maxWindow)));
+        target = std::max(target, minWindow);
+    }
+
+    uint64_t const window = capacity.getCapacityLimits().mFloodCapacity;
+    if (target > window)
+    {
+        auto delta = target - window;
+        capacity.resizeFloodCapacity(static_cast<int64_t>(delta));
+        grant += delta;
+    }
+    else if (target < window && grant > minGrant)
+    {
+        // Keep back some of the capacity we would have given back
+        auto available = capacity.getCapacity();
+        uint64_t delta = std::min({window - target, grant - minGrant,
+                                   available.mFloodCapacity});
+        if (available.mTotalCapacity)
+        {
+            delta = std::min(delta, *available.mTotalCapacity);
+        }
+        capacity.resizeFloodCapacity(-static_cast<int64_t>(delta));
+        grant -= delta;
+    }
+}
+
 bool
 FlowControl::beginMessageProcessing(StellarMessage const& msg)
 {
@@ -248,7 +336,38 @@ FlowControl::endMessageProcessing(StellarMessage const& msg)
         mFloodDataProcessedBytes +=
             mFlowControlBytesCapacity->releaseLocalCapacity(msg);
     }
+    return getSendMoreCapacity();
+}
+
+bool
+FlowControl::beginFloodMessageProcessing(uint64_t bodySize)
+{
+    ZoneScoped;
+
+    return mFlowControlCapacity->lockLocalFloodCapacity(bodySize) &&
+           (!mFlowControlBytesCapacity ||
+            mFlowControlBytesCapacity->lockLocalFloodCapacity(bodySize));
+}
 
+SendMoreCapacity
+FlowControl::endFloodMessageProcessing(uint64_t bodySize)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+
+    mFloodDataProcessed +=
+        mFlowControlCapacity->releaseLocalFloodCapacity(bodySize);
+    if (mFlowControlBytesCapacity)
+    {
+        mFloodDataProcessedBytes +=
+            mFlowControlBytesCapacity->releaseLocalFloodCapacity(bodySize);
+    }
+    return getSendMoreCapacity();
+}
+
+SendMoreCapacity
+FlowControl::getSendMoreCapacity()
+{
     releaseAssert(mFloodDataProcessed <=
                   mAppConnector.getConfig().FLOW_CONTROL_SEND_MORE_BATCH_SIZE);
     bool shouldSendMore =
@@ -276,11 +395,47 @@ FlowControl::endMessageProcessing(StellarMessage const& msg)
         // Reset counters
         mFloodDataProcessed = 0;
         mFloodDataProcessedBytes = 0;
+
+        auto now = mAppConnector.now();
+        auto const& cfg = mAppConnector.getConfig();
+        if (cfg.FLOW_CONTROL_MAX_CAPACITY_FACTOR > 1 && mRoundTripTime)
+        {
+            auto elapsed = now - mLastSendMoreTime;
+            resizeWindow(*mFlowControlCapacity,
+                         cfg.PEER_FLOOD_READING_CAPACITY, res.first, 0,
+                         elapsed);
+            if (mFlowControlBytesCapacity)
+            {
+                // SEND_MORE_EXTENDED must give some bytes back
+                resizeWindow(*mFlowControlBytesCapacity,
+                             mAppConnector.getOverlayManager()
+                                 .getFlowControlBytesConfig()
+                                 .mTotal,
+                             *res.second, 1, elapsed);
+            }
+        }
+        mLastSendMoreTime = now;
+
+        mOverlayMetrics.mFlowControlWindow.Update(
+            mFlowControlCapacity->getCapacityLimits().mFloodCapacity);
+        if (mFlowControlBytesCapacity)
+        {
+            mOverlayMetrics.mFlowControlWindowBytes.Update(
+                mFlowControlBytesCapacity->getCapacityLimits().mFloodCapacity);
+        }
     }
 
     return res;
 }
 
+uint64_t
+FlowControl::getNumMessagesCanRead() const
+{
+    auto total = mFlowControlCapacity->getCapacity().mTotalCapacity;
+    releaseAssert(total);
+    return *total;
+}
+
 bool
 FlowControl::canRead() const
 {
@@ -428,19 +583,44 @@ FlowControl::addMsgAndMaybeTrimQueue(std::shared_ptr<StellarMessage const> msg)
             return overLimit;
         };
 
+        // Returns the transaction to drop to get under the limits: the
+        // oldest one, unless trimming by fee and it didn't time out, in which
+        // case it's the oldest one of those with the lowest fee rate
+        auto pickVictim = [&]() {
+            auto victim = queue.begin();
+            if (!mAppConnector.getConfig().OUTBOUND_TX_QUEUE_TRIM_BY_FEE ||
+                dropMessageAfterTimeout(*victim, now))
+            {
+                return victim;
+            }
+            auto lowest = getInclusionFeeBid(victim->mMessage->transaction());
+            for (auto it = victim + 1; it != queue.end(); ++it)
+            {
+                auto bid = getInclusionFeeBid(it->mMessage->transaction());
+                if (feeRate3WayCompare(bid.first, bid.second, lowest.first,
+                                       lowest.second) < 0)
+                {
+                    victim = it;
+                    lowest = bid;
+                }
+            }
+            return victim;
+        };
+
         // Message/byte limit purge
         while (isOverLimit(queue))
         {
             dropped++;
+            auto victim = pickVictim();
             if (mFlowControlBytesCapacity)
             {
                 size_t s = mFlowControlBytesCapacity->getMsgResourceCount(
-                    *(queue.front().mMessage));
+                    *(victim->mMessage));
                 releaseAssert(mTxQueueByteCount >= s);
                 mTxQueueByteCount -= s;
             }
             om.mOutboundQueueDropTxs.Mark(dropped);
-            queue.pop_front();
+            queue.erase(victim);
         }
     }
     else if (type == SCP_MESSAGE)
@@ -529,6 +709,8 @@ FlowControl::getFlowControlJsonInfo(bool compact) const
     }
     res["local_capacity"]["flood"] = static_cast<Json::UInt64>(
         mFlowControlCapacity->getCapacity().mFloodCapacity);
+    res["local_capacity"]["window"] = static_cast<Json::UInt64>(
+        mFlowControlCapacity->getCapacityLimits().mFloodCapacity);
     res["peer_capacity"] =
         static_cast<Json::UInt64>(mFlowControlCapacity->getOutboundCapacity());
     if (mFlowControlBytesCapacity)
@@ -540,6 +722,8 @@ FlowControl::getFlowControlJsonInfo(bool compact) const
         }
         res["local_capacity_bytes"]["flood"] = static_cast<Json::UInt64>(
             mFlowControlBytesCapacity->getCapacity().mFloodCapacity);
+        res["local_capacity_bytes"]["window"] = static_cast<Json::UInt64>(
+            mFlowControlBytesCapacity->getCapacityLimits().mFloodCapacity);
         res["peer_capacity_bytes"] = static_cast<Json::UInt64>(
             mFlowControlBytesCapacity->getOutboundCapacity());
     }
@@ -561,6 +745,38 @@ FlowControl::getFlowControlJsonInfo(bool compact) const
     return res;
 }
 
+Json::Value
+FlowControl::getTelemetryJsonInfo() const
+{
+    releaseAssert(threadIsMain());
+
+    auto queueDelay = [](medida::Timer const& t) {
+        Json::Value res(Json::arrayValue);
+        auto snap = t.GetSnapshot();
+        res.append(static_cast<Json::UInt64>(t.count()));
+        res.append(static_cast<Json::UInt64>(snap.getMedian()));
+        res.append(static_cast<Json::UInt64>(snap.get99thPercentile()));
+        return res;
+    };
+    auto throttle = [](medida::Timer const& t) {
+        Json::Value res(Json::arrayValue);
+        res.append(static_cast<Json::UInt64>(t.count()));
+        res.append(static_cast<Json::UInt64>(t.sum()));
+        res.append(static_cast<Json::UInt64>(
+            t.GetSnapshot().get99thPercentile()));
+        return res;
+    };
+
+    Json::Value res;
+    res["queue_ms"]["scp"] = queueDelay(mMetrics.mOutboundQueueDelaySCP);
+    res["queue_ms"]["tx"] = queueDelay(mMetrics.mOutboundQueueDelayTxs);
+    res["queue_ms"]["advert"] = queueDelay(mMetrics.mOutboundQueueDelayAdvert);
+    res["queue_ms"]["demand"] = queueDelay(mMetrics.mOutboundQueueDelayDemand);
+    res["throttle_ms"]["read"] = throttle(mMetrics.mReadThrottle);
+    res["throttle_ms"]["flood"] = throttle(mMetrics.mFloodThrottle);
+    return res;
+}
+
 void
 FlowControl::throttleRead()
 {
@@ -575,8 +791,9 @@ FlowControl::stopThrottling()
     {
         CLOG_DEBUG(Overlay, "Stop throttling reading from peer {}",
                    mAppConnector.getConfig().toShortString(mNodeID));
-        mOverlayMetrics.mConnectionReadThrottle.Update(mAppConnector.now() -
-                                                       *mLastThrottle);
+        auto throttled = mAppConnector.now() - *mLastThrottle;
+        mOverlayMetrics.mConnectionReadThrottle.Update(throttled);
+        mMetrics.mReadThrottle.Update(throttled);
         mLastThrottle.reset();
         return true;
     }
@@ -602,6 +819,12 @@ FlowControl::FlowControlMetrics::FlowControlMetrics()
     , mOutboundQueueDelayDemand(medida::Timer(Peer::PEER_METRICS_DURATION_UNIT,
                                               Peer::PEER_METRICS_RATE_UNIT,
                                               Peer::PEER_METRICS_WINDOW_SIZE))
+    , mReadThrottle(medida::Timer(Peer::PEER_METRICS_DURATION_UNIT,
+                                  Peer::PEER_METRICS_RATE_UNIT,
+                                  Peer::PEER_METRICS_WINDOW_SIZE))
+    , mFloodThrottle(medida::Timer(Peer::PEER_METRICS_DURATION_UNIT,
+                                   Peer::PEER_METRICS_RATE_UNIT,
+                                   Peer::PEER_METRICS_WINDOW_SIZE))
 {
     releaseAssert(threadIsMain());
 }
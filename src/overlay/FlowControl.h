@@ -46,6 +46,10 @@ class FlowControl
         medida::Timer mOutboundQueueDelayTxs;
         medida::Timer mOutboundQueueDelayAdvert;
         medida::Timer mOutboundQueueDelayDemand;
+        // time spent not reading from the peer, and not sending it flood
+        // messages, for lack of capacity
+        medida::Timer mReadThrottle;
+        medida::Timer mFloodThrottle;
     };
 
     // How many _hashes_ in total are queued?
@@ -78,6 +82,11 @@ class FlowControl
     // SEND_MORE to this peer
     uint64_t mFloodDataProcessedBytes{0};
     std::optional<VirtualClock::time_point> mNoOutboundCapacity;
+    // Latest round trip time measured to this peer, and when we last asked
+    // it for more data, to size the windows when
+    // FLOW_CONTROL_MAX_CAPACITY_FACTOR is set
+    std::optional<std::chrono::milliseconds> mRoundTripTime;
+    VirtualClock::time_point mLastSendMoreTime;
     FlowControlMetrics mMetrics;
     std::function<void(std::shared_ptr<StellarMessage const>)> mSendCallback;
 
@@ -87,6 +96,16 @@ class FlowControl
     // This methods drops obsolete load from the outbound queue
     void addMsgAndMaybeTrimQueue(std::shared_ptr<StellarMessage const> msg);
     bool hasOutboundCapacity(StellarMessage const& msg) const;
+    // Resize the flood window of `capacity`, between `minWindow` and
+    // FLOW_CONTROL_MAX_CAPACITY_FACTOR times that, to twice what the peer
+    // had in flight while we processed `grant` in `elapsed`. `grant`, the
+    // capacity about to be given back to the peer, is adjusted by the
+    // change but doesn't go below `minGrant`.
+    void resizeWindow(FlowControlCapacity& capacity, uint64_t minWindow,
+                      uint64_t& grant, uint64_t minGrant,
+                      VirtualClock::duration elapsed);
+    // Capacity to request from the peer once messages were processed
+    SendMoreCapacity getSendMoreCapacity();
 
   public:
     FlowControl(OverlayAppConnector& connector);
@@ -96,6 +115,18 @@ class FlowControl
     void maybeReleaseCapacityAndTriggerSend(StellarMessage const& msg);
     virtual size_t getOutboundQueueByteLimit() const;
     void handleTxSizeIncrease(uint32_t increase);
+    void setRoundTripTime(std::chrono::milliseconds rtt);
+
+    // Number of messages that can still be read before reading from the peer
+    // has to stop
+    uint64_t getNumMessagesCanRead() const;
+
+    // Bytes of transactions waiting in the outbound queue
+    size_t
+    getTxQueueByteCount() const
+    {
+        return mTxQueueByteCount;
+    }
 
 #ifdef BUILD_TESTS
     std::shared_ptr<FlowControlCapacity>
@@ -147,6 +178,11 @@ class FlowControl
     // processing the message. It returns available capacity that can now be
     // requested from the peer.
     SendMoreCapacity endMessageProcessing(StellarMessage const& msg);
+
+    // Same as beginMessageProcessing and endMessageProcessing for a flood
+    // message of `bodySize` bytes that is dropped without being decoded
+    bool beginFloodMessageProcessing(uint64_t bodySize);
+    SendMoreCapacity endFloodMessageProcessing(uint64_t bodySize);
     bool canRead() const;
 
     // This method return last timestamp (if any) when peer had no available
@@ -160,6 +196,10 @@ class FlowControl
 
     Json::Value getFlowControlJsonInfo(bool compact) const;
 
+    // Outbound queue delay ([count, p50, p99] in ms, by message kind) and
+    // throttling time ([count, total, p99] in ms) of this peer
+    Json::Value getTelemetryJsonInfo() const;
+
     void
     start(NodeID const& peerID,
           std::function<void(std::shared_ptr<StellarMessage const>)> sendCb,
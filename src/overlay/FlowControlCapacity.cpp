@@ -6,7 +6,7 @@
 #include "overlay/FlowControl.h"
 #include "overlay/OverlayManager.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -14,8 +14,10 @@ namespace stellar
 FlowControlMessageCapacity::FlowControlMessageCapacity(Config const& cfg,
                                                        NodeID const& nodeID)
     : FlowControlCapacity(cfg, nodeID)
+    , mCapacityLimits{cfg.PEER_FLOOD_READING_CAPACITY,
+                      std::make_optional<uint64_t>(cfg.PEER_READING_CAPACITY)}
 {
-    mCapacity = getCapacityLimits();
+    mCapacity = mCapacityLimits;
 }
 
 uint64_t
@@ -25,11 +27,22 @@ FlowControlMessageCapacity::getMsgResourceCount(StellarMessage const& msg) const
     return 1;
 }
 
+uint64_t
+FlowControlMessageCapacity::getResourceCount(uint64_t bodySize) const
+{
+    return 1;
+}
+
 FlowControlCapacity::ReadingCapacity
 FlowControlMessageCapacity::getCapacityLimits() const
 {
-    return {mConfig.PEER_FLOOD_READING_CAPACITY,
-            std::make_optional<uint64_t>(mConfig.PEER_READING_CAPACITY)};
+    return mCapacityLimits;
+}
+
+void
+FlowControlMessageCapacity::resizeFloodCapacity(int64_t delta)
+{
+    resizeCapacity(mCapacityLimits, delta);
 }
 
 void
@@ -74,6 +87,12 @@ FlowControlByteCapacity::getMsgResourceCount(StellarMessage const& msg) const
     return msgBodySize(msg);
 }
 
+uint64_t
+FlowControlByteCapacity::getResourceCount(uint64_t bodySize) const
+{
+    return bodySize;
+}
+
 void
 FlowControlByteCapacity::releaseOutboundCapacity(StellarMessage const& msg)
 {
@@ -95,6 +114,12 @@ FlowControlByteCapacity::canRead() const
     return true;
 }
 
+void
+FlowControlByteCapacity::resizeFloodCapacity(int64_t delta)
+{
+    resizeCapacity(mCapacityLimits, delta);
+}
+
 void
 FlowControlByteCapacity::handleTxSizeIncrease(uint32_t increase)
 {
@@ -109,6 +134,32 @@ FlowControlCapacity::FlowControlCapacity(Config const& cfg,
     releaseAssert(threadIsMain());
 }
 
+void
+FlowControlCapacity::resizeCapacity(ReadingCapacity& limits, int64_t delta)
+{
+    ZoneScoped;
+    auto move = [delta](uint64_t& value) {
+        if (delta < 0)
+        {
+            releaseAssert(value >= static_cast<uint64_t>(-delta));
+            value -= static_cast<uint64_t>(-delta);
+        }
+        else
+        {
+            value += static_cast<uint64_t>(delta);
+        }
+    };
+    move(limits.mFloodCapacity);
+    move(mCapacity.mFloodCapacity);
+    if (limits.mTotalCapacity)
+    {
+        releaseAssert(mCapacity.mTotalCapacity);
+        move(*limits.mTotalCapacity);
+        move(*mCapacity.mTotalCapacity);
+    }
+    checkCapacityInvariants();
+}
+
 void
 FlowControlCapacity::checkCapacityInvariants() const
 {
@@ -140,17 +191,29 @@ FlowControlCapacity::lockOutboundCapacity(StellarMessage const& msg)
 
 bool
 FlowControlCapacity::lockLocalCapacity(StellarMessage const& msg)
+{
+    return lockLocalResources(getMsgResourceCount(msg),
+                              OverlayManager::isFloodMessage(msg));
+}
+
+bool
+FlowControlCapacity::lockLocalFloodCapacity(uint64_t bodySize)
+{
+    return lockLocalResources(getResourceCount(bodySize), true);
+}
+
+bool
+FlowControlCapacity::lockLocalResources(uint64_t msgResources, bool isFlood)
 {
     ZoneScoped;
     checkCapacityInvariants();
-    auto msgResources = getMsgResourceCount(msg);
     if (mCapacity.mTotalCapacity)
     {
         releaseAssert(*mCapacity.mTotalCapacity >= msgResources);
         *mCapacity.mTotalCapacity -= msgResources;
     }
 
-    if (OverlayManager::isFloodMessage(msg))
+    if (isFlood)
     {
         // No capacity to process flood message
         if (mCapacity.mFloodCapacity < msgResources)
@@ -171,17 +234,30 @@ FlowControlCapacity::lockLocalCapacity(StellarMessage const& msg)
 
 uint64_t
 FlowControlCapacity::releaseLocalCapacity(StellarMessage const& msg)
+{
+    return releaseLocalResources(getMsgResourceCount(msg),
+                                 OverlayManager::isFloodMessage(msg));
+}
+
+uint64_t
+FlowControlCapacity::releaseLocalFloodCapacity(uint64_t bodySize)
+{
+    return releaseLocalResources(getResourceCount(bodySize), true);
+}
+
+uint64_t
+FlowControlCapacity::releaseLocalResources(uint64_t resourcesFreed,
+                                           bool isFlood)
 {
     ZoneScoped;
 
     uint64_t releasedFloodCapacity = 0;
-    size_t resourcesFreed = getMsgResourceCount(msg);
     if (mCapacity.mTotalCapacity)
     {
         *mCapacity.mTotalCapacity += resourcesFreed;
     }
 
-    if (OverlayManager::isFloodMessage(msg))
+    if (isFlood)
     {
         if (mCapacity.mFloodCapacity == 0)
         {
@@ -30,16 +30,32 @@ class FlowControlCapacity
     uint64_t mOutboundCapacity{0};
     NodeID const& mNodeID;
 
+    // Move both `limits` and the available capacity by `delta`
+    void resizeCapacity(ReadingCapacity& limits, int64_t delta);
+
+    bool lockLocalResources(uint64_t msgResources, bool isFlood);
+    uint64_t releaseLocalResources(uint64_t msgResources, bool isFlood);
+
   public:
     virtual uint64_t getMsgResourceCount(StellarMessage const& msg) const = 0;
+    // Same as getMsgResourceCount for a message of `bodySize` bytes
+    virtual uint64_t getResourceCount(uint64_t bodySize) const = 0;
     virtual ReadingCapacity getCapacityLimits() const = 0;
     virtual void releaseOutboundCapacity(StellarMessage const& msg) = 0;
+    // Grow or shrink the flood capacity, and the total capacity if any, by
+    // `delta`. Capacity in use can't be taken back: shrinking is limited to
+    // the available capacity.
+    virtual void resizeFloodCapacity(int64_t delta) = 0;
 
     void lockOutboundCapacity(StellarMessage const& msg);
     bool lockLocalCapacity(StellarMessage const& msg);
     // Release capacity used by this message. Return how flood capacity was
     // freed
     uint64_t releaseLocalCapacity(StellarMessage const& msg);
+    // Same as lockLocalCapacity and releaseLocalCapacity for a flood message
+    // of `bodySize` bytes that wasn't decoded
+    bool lockLocalFloodCapacity(uint64_t bodySize);
+    uint64_t releaseLocalFloodCapacity(uint64_t bodySize);
 
     bool hasOutboundCapacity(StellarMessage const& msg) const;
     void checkCapacityInvariants() const;
@@ -82,21 +98,28 @@ class FlowControlByteCapacity : public FlowControlCapacity
     virtual ~FlowControlByteCapacity() = default;
     virtual uint64_t
     getMsgResourceCount(StellarMessage const& msg) const override;
+    uint64_t getResourceCount(uint64_t bodySize) const override;
     virtual ReadingCapacity getCapacityLimits() const override;
     virtual void releaseOutboundCapacity(StellarMessage const& msg) override;
+    void resizeFloodCapacity(int64_t delta) override;
     bool canRead() const override;
     void handleTxSizeIncrease(uint32_t increase);
 };
 
 class FlowControlMessageCapacity : public FlowControlCapacity
 {
+    // Configured limits, possibly resized to fit the connection
+    ReadingCapacity mCapacityLimits;
+
   public:
     FlowControlMessageCapacity(Config const& cfg, NodeID const& nodeID);
     virtual ~FlowControlMessageCapacity() = default;
     virtual uint64_t
     getMsgResourceCount(StellarMessage const& msg) const override;
+    uint64_t getResourceCount(uint64_t bodySize) const override;
     virtual ReadingCapacity getCapacityLimits() const override;
     void releaseOutboundCapacity(StellarMessage const& msg) override;
+    void resizeFloodCapacity(int64_t delta) override;
     bool canRead() const override;
 };
 }
\ No newline at end of file
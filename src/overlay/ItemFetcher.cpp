@@ -9,7 +9,7 @@
 #include "main/Application.h"
 #include "overlay/Tracker.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
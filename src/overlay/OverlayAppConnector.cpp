@@ -46,6 +46,21 @@ OverlayAppConnector::postOnMainThread(std::function<void()>&& f,
     mApp.postOnMainThread(std::move(f), std::move(message), type);
 }
 
+void
+OverlayAppConnector::postOnOverlayThread(std::function<void()>&& f,
+                                         std::function<void()>&& then,
+                                         std::string&& message)
+{
+    releaseAssert(threadIsMain());
+    auto& app = mApp;
+    mApp.postOnOverlayThread(
+        [&app, f = std::move(f), then = std::move(then), message]() mutable {
+            f();
+            app.postOnMainThread(std::move(then), std::move(message));
+        },
+        message);
+}
+
 Config const&
 OverlayAppConnector::getConfig() const
 {
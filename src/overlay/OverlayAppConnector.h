@@ -30,6 +30,10 @@ class OverlayAppConnector
     void postOnMainThread(
         std::function<void()>&& f, std::string&& message,
         Scheduler::ActionType type = Scheduler::ActionType::NORMAL_ACTION);
+    // Run `f` on the overlay thread, then `then` on the main thread
+    void postOnOverlayThread(std::function<void()>&& f,
+                             std::function<void()>&& then,
+                             std::string&& message);
 
     VirtualClock::time_point now() const;
     Config const& getConfig() const;
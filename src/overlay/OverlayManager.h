@@ -45,6 +45,7 @@
 namespace stellar
 {
 
+class EncodedMessageCache;
 class PeerAuth;
 class PeerBareAddress;
 class PeerManager;
@@ -103,6 +104,17 @@ class OverlayManager
     virtual void recvTransaction(StellarMessage const& msg,
                                  Peer::pointer peer) = 0;
 
+    // Process a transaction received again from `peer`, identified by the
+    // hash `msgID` of its StellarMessage, without decoding it. Returns false
+    // if the transaction isn't known, in which case it must be decoded and
+    // passed to recvTransaction.
+    virtual bool recvKnownTransaction(Hash const& msgID,
+                                      Peer::pointer peer) = 0;
+
+    // Process incoming SCP envelope, pass it down to the herder
+    virtual void recvSCPEnvelope(StellarMessage const& msg,
+                                 Peer::pointer peer) = 0;
+
     // removes msgID from the floodgate's internal state
     // as it's not tracked anymore, calling "broadcast" with a (now forgotten)
     // message with the ID msgID will cause it to be broadcast to all peers
@@ -183,6 +195,11 @@ class OverlayManager
     // Return number of authenticated peers
     virtual int getAuthenticatedPeersCount() const = 0;
 
+    // Average fraction of OUTBOUND_TX_QUEUE_BYTE_LIMIT taken by the
+    // transactions waiting to be sent to the authenticated peers, between 0
+    // and 1 (0 without peers)
+    virtual double getOutboundTxQueueFill() const = 0;
+
     // Attempt to connect to a peer identified by peer address.
     virtual void connectTo(PeerBareAddress const& address) = 0;
 
@@ -195,6 +212,9 @@ class OverlayManager
     // Return the persistent p2p authentication-key cache.
     virtual PeerAuth& getPeerAuth() = 0;
 
+    // Return the encodings of the messages being broadcast.
+    virtual EncodedMessageCache& getEncodedMessageCache() = 0;
+
     // Return the persistent peer manager
     virtual PeerManager& getPeerManager() = 0;
 
@@ -21,17 +21,19 @@
 #include "overlay/SurveyDataManager.h"
 #include "overlay/TCPPeer.h"
 #include "overlay/TxDemandsManager.h"
+#include "transactions/TransactionUtils.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
 #include "util/Thread.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 #include "medida/counter.h"
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/timer.h"
 
 #include <algorithm>
 
@@ -297,11 +299,14 @@ OverlayManagerImpl::OverlayManagerImpl(Application& app)
     , mShuttingDown(false)
     , mOverlayMetrics(app)
     , mMessageCache(0xffff)
+    , mKnownTransactions(0xffff)
     , mTimer(app)
     , mPeerIPTimer(app)
     , mFloodGate(app)
     , mTxDemandsManager(app)
     , mSurveyManager(make_shared<SurveyManager>(app))
+    , mPendingTxs(make_shared<std::deque<PendingTx>>())
+    , mPendingEnvelopes(make_shared<std::vector<PendingEnvelope>>())
     , mInboundPeers(*this, mApp.getMetrics(), "inbound", "reject",
                     mApp.getConfig().MAX_ADDITIONAL_PEER_CONNECTIONS,
                     mSurveyManager)
@@ -1050,6 +1055,23 @@ OverlayManagerImpl::getAuthenticatedPeersCount() const
                             mOutboundPeers.mAuthenticated.size());
 }
 
+double
+OverlayManagerImpl::getOutboundTxQueueFill() const
+{
+    double total = 0;
+    size_t count = 0;
+    for (auto const* peers :
+         {&mInboundPeers.mAuthenticated, &mOutboundPeers.mAuthenticated})
+    {
+        for (auto const& [_, peer] : *peers)
+        {
+            total += peer->getOutboundTxQueueFill();
+            ++count;
+        }
+    }
+    return count == 0 ? 0.0 : total / static_cast<double>(count);
+}
+
 bool
 OverlayManagerImpl::isPreferred(Peer* peer) const
 {
@@ -1154,8 +1176,105 @@ OverlayManagerImpl::recvTransaction(StellarMessage const& msg,
                                     Peer::pointer peer)
 {
     ZoneScoped;
-    auto transaction = TransactionFrameBase::makeTransactionFromWire(
-        mApp.getNetworkID(), msg.transaction());
+    if (!mApp.getConfig().EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION)
+    {
+        admitTransaction(msg, peer,
+                         TransactionFrameBase::makeTransactionFromWire(
+                             mApp.getNetworkID(), msg.transaction()));
+        return;
+    }
+
+    auto check = std::make_shared<TxCheck>();
+    check->mMsg = std::make_shared<StellarMessage const>(msg);
+    mPendingTxs->push_back(PendingTx{check, peer});
+
+    // The task only touches the check and the (thread-safe) signature cache,
+    // and hands back to the main thread if the overlay manager is still
+    // around. Account state is left for the queue to check on the main
+    // thread, so only signatures of master keys are verified here.
+    std::weak_ptr<std::deque<PendingTx>> weakPending = mPendingTxs;
+    Hash networkID = mApp.getNetworkID();
+    Application& app = mApp;
+    mApp.postOnBackgroundThread(
+        [this, check, weakPending, networkID, &app]() {
+            ZoneNamedN(checkZone, "check transaction", true);
+            try
+            {
+                auto tx = TransactionFrameBase::makeTransactionFromWire(
+                    networkID, check->mMsg->transaction());
+                if (tx)
+                {
+                    tx->getFullHash();
+                    verifyMasterKeySignatures(networkID, *tx);
+                }
+                check->mTx = tx;
+            }
+            catch (std::exception const& e)
+            {
+                // The queue rejects the transaction when it is admitted
+                CLOG_DEBUG(Overlay, "Could not check transaction: {}",
+                           e.what());
+            }
+            check->mDone = true;
+            app.postOnMainThread(
+                [this, weakPending]() {
+                    if (weakPending.lock())
+                    {
+                        admitCheckedTransactions();
+                    }
+                },
+                "OverlayManager: admit checked transactions");
+        },
+        "OverlayManager: check transaction");
+}
+
+bool
+OverlayManagerImpl::recvKnownTransaction(Hash const& msgID,
+                                         Peer::pointer peer)
+{
+    ZoneScoped;
+    auto txHash = mKnownTransactions.maybeGet(msgID);
+    // The flood record goes away when the transaction is dropped from the
+    // queue or its ledger closes, after which the transaction must be
+    // checked again
+    if (!txHash || !mFloodGate.addKnownRecord(msgID, peer))
+    {
+        return false;
+    }
+
+    // Same as a duplicate transaction admitted to the queue
+    mTxDemandsManager.recordTxPullLatency(*txHash, peer);
+    CLOG_DEBUG(Overlay,
+               "Peer::recvTransaction Received duplicate transaction {} from "
+               "{} without decoding it",
+               hexAbbrev(*txHash), peer->toString());
+    mOverlayMetrics.mPulledIrrelevantTxs.Mark();
+    mOverlayMetrics.mSkippedTxDecodes.Mark();
+    return true;
+}
+
+void
+OverlayManagerImpl::admitCheckedTransactions()
+{
+    ZoneScoped;
+    while (!mPendingTxs->empty() && mPendingTxs->front().mCheck->mDone)
+    {
+        auto pending = std::move(mPendingTxs->front());
+        mPendingTxs->pop_front();
+        if (!mShuttingDown)
+        {
+            admitTransaction(*pending.mCheck->mMsg, pending.mPeer,
+                             pending.mCheck->mTx);
+        }
+    }
+}
+
+void
+OverlayManagerImpl::admitTransaction(StellarMessage const& msg,
+                                     Peer::pointer peer,
+                                     TransactionFrameBasePtr transaction)
+{
+    ZoneScoped;
     if (transaction)
     {
         // record that this peer sent us this transaction
@@ -1179,6 +1298,10 @@ OverlayManagerImpl::recvTransaction(StellarMessage const& msg,
         }
         else
         {
+            if (mApp.getConfig().EARLY_DUPLICATE_TX_DETECTION)
+            {
+                mKnownTransactions.put(msgID, transaction->getFullHash());
+            }
             bool dup =
                 recvRes == TransactionQueue::AddResult::ADD_STATUS_DUPLICATE;
             if (!dup)
@@ -1199,6 +1322,109 @@ OverlayManagerImpl::recvTransaction(StellarMessage const& msg,
     }
 }
 
+void
+OverlayManagerImpl::recvSCPEnvelope(StellarMessage const& msg,
+                                    Peer::pointer peer)
+{
+    ZoneScoped;
+    if (!mApp.getConfig().EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION)
+    {
+        admitSCPEnvelope(msg, peer);
+        return;
+    }
+
+    mPendingEnvelopes->push_back(
+        PendingEnvelope{std::make_shared<StellarMessage const>(msg), peer,
+                        mApp.getClock().now()});
+    if (!mVerifyingEnvelopes)
+    {
+        verifyPendingEnvelopes();
+    }
+}
+
+void
+OverlayManagerImpl::verifyPendingEnvelopes()
+{
+    ZoneScoped;
+    releaseAssert(!mVerifyingEnvelopes);
+    mVerifyingEnvelopes = true;
+    auto batch = std::make_shared<std::vector<PendingEnvelope>>();
+    std::swap(*batch, *mPendingEnvelopes);
+
+    // The task only reads the batch and fills the (thread-safe) signature
+    // cache, so that the herder finds the signatures there when the
+    // envelopes are admitted on the main thread.
+    std::weak_ptr<std::vector<PendingEnvelope>> weakPending =
+        mPendingEnvelopes;
+    Hash networkID = mApp.getNetworkID();
+    Application& app = mApp;
+    mApp.postOnBackgroundThread(
+        [this, batch, weakPending, networkID, &app]() {
+            ZoneNamedN(verifyZone, "verify SCP envelopes", true);
+            std::vector<xdr::opaque_vec<>> bins;
+            bins.reserve(batch->size());
+            std::vector<PubKeyUtils::VerifySigRequest> requests;
+            requests.reserve(batch->size());
+            for (auto const& pending : *batch)
+            {
+                auto const& envelope = pending.mMsg->envelope();
+                bins.emplace_back(xdr::xdr_to_opaque(
+                    networkID, ENVELOPE_TYPE_SCP, envelope.statement));
+                requests.emplace_back(PubKeyUtils::VerifySigRequest{
+                    envelope.statement.nodeID, envelope.signature,
+                    bins.back()});
+            }
+            PubKeyUtils::verifySigs(requests);
+            app.postOnMainThread(
+                [this, batch, weakPending]() {
+                    if (weakPending.lock())
+                    {
+                        admitVerifiedEnvelopes(*batch);
+                    }
+                },
+                "OverlayManager: admit verified SCP envelopes");
+        },
+        "OverlayManager: verify SCP envelopes");
+}
+
+void
+OverlayManagerImpl::admitVerifiedEnvelopes(
+    std::vector<PendingEnvelope> const& batch)
+{
+    ZoneScoped;
+    auto now = mApp.getClock().now();
+    for (auto const& pending : batch)
+    {
+        mOverlayMetrics.mSCPVerifyQueueDelay.Update(now - pending.mReceived);
+        if (!mShuttingDown)
+        {
+            admitSCPEnvelope(*pending.mMsg, pending.mPeer);
+        }
+    }
+    mVerifyingEnvelopes = false;
+    if (!mShuttingDown && !mPendingEnvelopes->empty())
+    {
+        verifyPendingEnvelopes();
+    }
+}
+
+void
+OverlayManagerImpl::admitSCPEnvelope(StellarMessage const& msg,
+                                     Peer::pointer peer)
+{
+    ZoneScoped;
+    // add it to the floodmap so that this peer gets credit for it
+    Hash msgID;
+    recvFloodedMsgID(msg, peer, msgID);
+
+    auto res = mApp.getHerder().recvSCPEnvelope(msg.envelope());
+    if (res == Herder::ENVELOPE_STATUS_DISCARDED)
+    {
+        // the message was discarded, remove it from the floodmap as well
+        forgetFloodedMsg(msgID);
+    }
+}
+
 void
 OverlayManagerImpl::forgetFloodedMsg(Hash const& msgID)
 {
@@ -1251,6 +1477,20 @@ OverlayManagerImpl::getPeerAuth()
     return mAuth;
 }
 
+EncodedMessageCache&
+OverlayManagerImpl::getEncodedMessageCache()
+{
+    return mEncodedMessageCache;
+}
+
+#ifdef BUILD_TESTS
+TxDemandsManager&
+OverlayManagerImpl::getTxDemandsManager()
+{
+    return mTxDemandsManager;
+}
+#endif
+
 PeerManager&
 OverlayManagerImpl::getPeerManager()
 {
@@ -1275,6 +1515,8 @@ OverlayManagerImpl::shutdown()
     mInboundPeers.shutdown();
     mOutboundPeers.shutdown();
     mTxDemandsManager.shutdown();
+    mPendingTxs->clear();
+    mPendingEnvelopes->clear();
 
     // Switch overlay to "shutting down" state _after_ shutting down peers to
     // allow graceful connection drop
@@ -1283,6 +1525,7 @@ OverlayManagerImpl::shutdown()
     // Stop ticking and resolving peers
     mTimer.cancel();
     mPeerIPTimer.cancel();
+    mPeerManager.flush();
 }
 
 bool
@@ -10,6 +10,7 @@
 #include "PeerManager.h"
 #include "herder/TxSetFrame.h"
 #include "ledger/LedgerTxn.h"
+#include "overlay/EncodedMessageCache.h"
 #include "overlay/Floodgate.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
@@ -20,6 +21,8 @@
 #include "medida/metrics_registry.h"
 #include "util/RandomEvictionCache.h"
 
+#include <atomic>
+#include <deque>
 #include <future>
 #include <set>
 #include <vector>
@@ -78,6 +81,7 @@ class OverlayManagerImpl : public OverlayManager
     PeerManager mPeerManager;
     PeerDoor mDoor;
     PeerAuth mAuth;
+    EncodedMessageCache mEncodedMessageCache;
     bool mShuttingDown;
 
     OverlayMetrics mOverlayMetrics;
@@ -85,6 +89,10 @@ class OverlayManagerImpl : public OverlayManager
     // NOTE: bool is used here as a placeholder, since no ValueType is needed.
     RandomEvictionCache<uint64_t, bool> mMessageCache;
 
+    // With EARLY_DUPLICATE_TX_DETECTION, full hash of the transactions
+    // recently queued, by the hash of their StellarMessage
+    RandomEvictionCache<Hash, Hash> mKnownTransactions;
+
     void tick();
     void updateTimerAndMaybeDropRandomPeer(bool shouldDrop);
     VirtualTimer mTimer;
@@ -98,6 +106,51 @@ class OverlayManagerImpl : public OverlayManager
 
     std::shared_ptr<SurveyManager> mSurveyManager;
 
+    // Background checks of a transaction received while
+    // EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION is set
+    struct TxCheck
+    {
+        std::shared_ptr<StellarMessage const> mMsg;
+        // Null if the transaction could not be decoded
+        TransactionFrameBasePtr mTx;
+        std::atomic<bool> mDone{false};
+    };
+    struct PendingTx
+    {
+        std::shared_ptr<TxCheck> mCheck;
+        Peer::pointer mPeer;
+    };
+    // Transactions whose checks are running, in the order they were received.
+    // They are admitted in that order, so that transactions of the same
+    // account still reach the queue with increasing sequence numbers.
+    // Background tasks only hold weak references to it, so they can tell
+    // whether the overlay manager is gone.
+    std::shared_ptr<std::deque<PendingTx>> mPendingTxs;
+
+    void admitTransaction(StellarMessage const& msg, Peer::pointer peer,
+                          TransactionFrameBasePtr transaction);
+    void admitCheckedTransactions();
+
+    // SCP envelope received while EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION
+    // is set, waiting for its signature to be verified
+    struct PendingEnvelope
+    {
+        std::shared_ptr<StellarMessage const> mMsg;
+        Peer::pointer mPeer;
+        VirtualClock::time_point mReceived;
+    };
+    // Envelopes received since the batch being verified was started, which
+    // make up the next batch. Batches are verified one at a time and handed
+    // to the herder in the order they were received. Background tasks only
+    // hold weak references to it, so they can tell whether the overlay
+    // manager is gone.
+    std::shared_ptr<std::vector<PendingEnvelope>> mPendingEnvelopes;
+    bool mVerifyingEnvelopes{false};
+
+    void admitSCPEnvelope(StellarMessage const& msg, Peer::pointer peer);
+    void verifyPendingEnvelopes();
+    void admitVerifiedEnvelopes(std::vector<PendingEnvelope> const& batch);
+
     PeersList mInboundPeers;
     PeersList mOutboundPeers;
     int availableOutboundPendingSlots() const;
@@ -111,6 +164,9 @@ class OverlayManagerImpl : public OverlayManager
                           Hash& msgID) override;
     void recvTransaction(StellarMessage const& msg,
                          Peer::pointer peer) override;
+    bool recvKnownTransaction(Hash const& msgID, Peer::pointer peer) override;
+    void recvSCPEnvelope(StellarMessage const& msg,
+                         Peer::pointer peer) override;
     void forgetFloodedMsg(Hash const& msgID) override;
     void recvTxDemand(FloodDemand const& dmd, Peer::pointer peer) override;
     bool broadcastMessage(std::shared_ptr<StellarMessage const> msg,
@@ -139,6 +195,7 @@ class OverlayManagerImpl : public OverlayManager
     getOutboundAuthenticatedPeers() const override;
     std::map<NodeID, Peer::pointer> getAuthenticatedPeers() const override;
     int getAuthenticatedPeersCount() const override;
+    double getOutboundTxQueueFill() const override;
 
     // returns nullptr if the passed peer isn't found
     Peer::pointer getConnectedPeer(PeerBareAddress const& address) override;
@@ -153,6 +210,10 @@ class OverlayManagerImpl : public OverlayManager
 
     OverlayMetrics& getOverlayMetrics() override;
     PeerAuth& getPeerAuth() override;
+    EncodedMessageCache& getEncodedMessageCache() override;
+#ifdef BUILD_TESTS
+    TxDemandsManager& getTxDemandsManager();
+#endif
 
     PeerManager& getPeerManager() override;
 
@@ -37,6 +37,10 @@ OverlayMetrics::OverlayMetrics(Application& app)
 
     , mItemFetcherNextPeer(app.getMetrics().NewMeter(
           {"overlay", "item-fetcher", "next-peer"}, "item-fetcher"))
+    , mItemFetcherHedge(app.getMetrics().NewMeter(
+          {"overlay", "item-fetcher", "hedge"}, "item-fetcher"))
+    , mFetchUnusedBytes(app.getMetrics().NewMeter(
+          {"overlay", "fetch", "unused-bytes"}, "byte"))
 
     , mRecvErrorTimer(app.getMetrics().NewTimer({"overlay", "recv", "error"}))
     , mRecvHelloTimer(app.getMetrics().NewTimer({"overlay", "recv", "hello"}))
@@ -89,6 +93,16 @@ OverlayMetrics::OverlayMetrics(Application& app)
           app.getMetrics().NewTimer({"overlay", "delay", "write-queue"}))
     , mMessageDelayInAsyncWriteTimer(
           app.getMetrics().NewTimer({"overlay", "delay", "async-write"}))
+    , mWriteBatchBytes(
+          app.getMetrics().NewHistogram({"overlay", "write-batch", "bytes"}))
+    , mWriteBatchMessages(
+          app.getMetrics().NewHistogram({"overlay", "write-batch", "messages"}))
+    , mWriteBatchBuffers(
+          app.getMetrics().NewHistogram({"overlay", "write-batch", "buffers"}))
+    , mFlowControlWindow(app.getMetrics().NewHistogram(
+          {"overlay", "flow-control", "window"}))
+    , mFlowControlWindowBytes(app.getMetrics().NewHistogram(
+          {"overlay", "flow-control", "window-bytes"}))
     , mOutboundQueueDelaySCP(
           app.getMetrics().NewTimer({"overlay", "outbound-queue", "scp"}))
     , mOutboundQueueDelayTxs(
@@ -160,6 +174,12 @@ OverlayMetrics::OverlayMetrics(Application& app)
           {"overlay", "flood", "peer-tx-pull-latency"}))
     , mAdvertQueueDelay(
           app.getMetrics().NewTimer({"overlay", "flood", "advert-delay"}))
+    , mSuppressedAdvertMeter(app.getMetrics().NewMeter(
+          {"overlay", "flood", "advert-suppressed"}, "transaction"))
+    , mSkippedTxDecodes(app.getMetrics().NewMeter(
+          {"overlay", "flood", "decode-skipped"}, "transaction"))
+    , mSCPVerifyQueueDelay(
+          app.getMetrics().NewTimer({"overlay", "scp-verify", "delay"}))
     , mDemandTimeouts(app.getMetrics().NewMeter(
           {"overlay", "demand", "timeout"}, "timeout"))
     , mPulledRelevantTxs(app.getMetrics().NewMeter(
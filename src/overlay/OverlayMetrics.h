@@ -12,6 +12,7 @@ namespace medida
 class Timer;
 class Meter;
 class Counter;
+class Histogram;
 }
 
 namespace stellar
@@ -38,6 +39,8 @@ struct OverlayMetrics
     medida::Timer& mConnectionFloodThrottle;
 
     medida::Meter& mItemFetcherNextPeer;
+    medida::Meter& mItemFetcherHedge;
+    medida::Meter& mFetchUnusedBytes;
 
     medida::Timer& mRecvErrorTimer;
     medida::Timer& mRecvHelloTimer;
@@ -70,6 +73,13 @@ struct OverlayMetrics
     medida::Timer& mMessageDelayInWriteQueueTimer;
     medida::Timer& mMessageDelayInAsyncWriteTimer;
 
+    medida::Histogram& mWriteBatchBytes;
+    medida::Histogram& mWriteBatchMessages;
+    medida::Histogram& mWriteBatchBuffers;
+
+    medida::Histogram& mFlowControlWindow;
+    medida::Histogram& mFlowControlWindowBytes;
+
     medida::Timer& mOutboundQueueDelaySCP;
     medida::Timer& mOutboundQueueDelayTxs;
     medida::Timer& mOutboundQueueDelayAdvert;
@@ -108,6 +118,9 @@ struct OverlayMetrics
     medida::Timer& mTxPullLatency;
     medida::Timer& mPeerTxPullLatency;
     medida::Timer& mAdvertQueueDelay;
+    medida::Meter& mSuppressedAdvertMeter;
+    medida::Meter& mSkippedTxDecodes;
+    medida::Timer& mSCPVerifyQueueDelay;
 
     medida::Meter& mDemandTimeouts;
     medida::Meter& mPulledRelevantTxs;
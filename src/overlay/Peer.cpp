@@ -5,6 +5,7 @@
 #include "overlay/Peer.h"
 
 #include "BanManager.h"
+#include "crypto/BLAKE2.h"
 #include "crypto/CryptoError.h"
 #include "crypto/Hex.h"
 #include "crypto/KeyUtils.h"
@@ -16,6 +17,7 @@
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "overlay/EncodedMessageCache.h"
 #include "overlay/FlowControl.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
@@ -26,7 +28,10 @@
 #include "overlay/TxAdverts.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/MemoryAttribution.h"
 #include "util/ProtocolVersion.h"
+#include "util/XDRUncheckedPut.h"
+#include "util/ZoneProfiler.h"
 #include "util/finally.h"
 
 #include "herder/HerderUtils.h"
@@ -35,7 +40,6 @@
 #include "xdrpp/marshal.h"
 #include <fmt/format.h>
 
-#include <Tracy.hpp>
 #include <soci.h>
 #include <time.h>
 
@@ -76,8 +80,8 @@ Peer::Peer(Application& app, PeerRole role)
 }
 
 Peer::MsgCapacityTracker::MsgCapacityTracker(std::weak_ptr<Peer> peer,
-                                             StellarMessage const& msg)
-    : mWeakPeer(peer), mMsg(msg)
+                                             StellarMessage&& msg)
+    : mWeakPeer(peer), mMsg(std::move(msg))
 {
     auto self = mWeakPeer.lock();
     if (!self)
@@ -157,15 +161,20 @@ Peer::endMessageProcessing(StellarMessage const& msg)
 
     // We may release reading capacity, which gets taken by the background
     // thread immediately, so we can't assert `canRead` here
-    auto res = mFlowControl->endMessageProcessing(msg);
-    if (res.second)
+    onCapacityReleased(mFlowControl->endMessageProcessing(msg));
+}
+
+void
+Peer::onCapacityReleased(SendMoreCapacity const& capacity)
+{
+    if (capacity.second)
     {
-        sendSendMore(static_cast<uint32>(res.first),
-                     static_cast<uint32>(*res.second));
+        sendSendMore(static_cast<uint32>(capacity.first),
+                     static_cast<uint32>(*capacity.second));
     }
-    else if (res.first > 0)
+    else if (capacity.first > 0)
     {
-        sendSendMore(static_cast<uint32>(res.first));
+        sendSendMore(static_cast<uint32>(capacity.first));
     }
 
     // Now that we've released some capacity, maybe schedule more reads
@@ -299,6 +308,25 @@ Peer::getJsonInfo(bool compact) const
     if (mFlowControl)
     {
         res["flow_control"] = mFlowControl->getFlowControlJsonInfo(compact);
+        res["telemetry"] = mFlowControl->getTelemetryJsonInfo();
+    }
+    // [read, write] bytes by message type
+    auto& bytes = res["telemetry"]["bytes"];
+    bytes = Json::objectValue;
+    for (auto const& [type, n] : mPeerMetrics.mByteReadByType)
+    {
+        auto& v = bytes[xdr::xdr_traits<MessageType>::enum_name(type)];
+        v[0] = static_cast<Json::UInt64>(n);
+        v[1] = static_cast<Json::UInt64>(0);
+    }
+    for (auto const& [type, n] : mPeerMetrics.mByteWriteByType)
+    {
+        auto& v = bytes[xdr::xdr_traits<MessageType>::enum_name(type)];
+        if (v.isNull())
+        {
+            v[0] = static_cast<Json::UInt64>(0);
+        }
+        v[1] = static_cast<Json::UInt64>(n);
     }
     if (!compact)
     {
@@ -712,24 +740,65 @@ Peer::sendMessage(std::shared_ptr<StellarMessage const> msg, bool log)
 void
 Peer::sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg)
 {
-    AuthenticatedMessage amsg;
-    amsg.v0().message = *msg;
+    auto body =
+        mAppConnector.getOverlayManager().getEncodedMessageCache().get(msg);
+    xdr::msg_ptr xdrBytes;
     if (msg->type() != HELLO && msg->type() != ERROR_MSG)
     {
-        ZoneNamedN(hmacZone, "message HMAC", true);
-        amsg.v0().sequence = mSendMacSeq;
-        amsg.v0().mac =
-            hmacSha256(mSendMacKey, xdr::xdr_to_opaque(mSendMacSeq, *msg));
+        xdrBytes = encodeAuthenticatedMessage(*msg, body.get(), &mSendMacKey,
+                                              mSendMacSeq);
         ++mSendMacSeq;
     }
-    xdr::msg_ptr xdrBytes;
+    else
     {
-        ZoneNamedN(xdrZone, "XDR serialize", true);
-        xdrBytes = xdr::xdr_to_msg(amsg);
+        xdrBytes = encodeAuthenticatedMessage(*msg, body.get(), nullptr, 0);
     }
+    mPeerMetrics.mByteWriteByType[msg->type()] += xdrBytes->size();
     this->sendMessage(std::move(xdrBytes));
 }
 
+xdr::msg_ptr
+Peer::encodeAuthenticatedMessage(StellarMessage const& msg,
+                                 xdr::opaque_vec<> const* body,
+                                 HmacSha256Key const* macKey, uint64_t seq)
+{
+    ZoneScoped;
+    // The AuthenticatedMessage is laid out as its version, sequence number,
+    // message and MAC, and the MAC covers the sequence number and message:
+    // write them straight into the buffer sent, then the MAC of that range.
+    size_t const headerSize = 4 + 8;
+    size_t const bodySize = body ? body->size() : xdr::xdr_size(msg);
+    size_t const macSize = 32;
+    auto xdrBytes = xdr::message_t::alloc(headerSize + bodySize + macSize);
+    char* const start = xdrBytes->data();
+    char* const bodyStart = start + headerSize;
+    char* const macStart = bodyStart + bodySize;
+
+    xdr::xdr_put header(start, bodyStart);
+    xdr::xdr_argpack_archive(header, static_cast<uint32_t>(0), seq);
+    {
+        ZoneNamedN(xdrZone, "XDR serialize", true);
+        if (body)
+        {
+            std::memcpy(bodyStart, body->data(), bodySize);
+        }
+        else
+        {
+            xdrPutUnchecked(msg, bodyStart, macStart);
+        }
+    }
+
+    HmacSha256Mac mac;
+    if (macKey)
+    {
+        ZoneNamedN(hmacZone, "message HMAC", true);
+        mac = hmacSha256(*macKey, ByteSlice(start + 4, 8 + bodySize));
+    }
+    xdr::xdr_put trailer(macStart, macStart + macSize);
+    xdr::xdr_argpack_archive(trailer, mac);
+    return xdrBytes;
+}
+
 bool
 Peer::isConnected() const
 {
@@ -742,6 +811,19 @@ Peer::isAuthenticated() const
     return mState == GOT_AUTH;
 }
 
+double
+Peer::getOutboundTxQueueFill() const
+{
+    auto limit = mFlowControl->getOutboundQueueByteLimit();
+    if (limit == 0)
+    {
+        return 0.0;
+    }
+    return std::min(1.0,
+                    static_cast<double>(mFlowControl->getTxQueueByteCount()) /
+                        static_cast<double>(limit));
+}
+
 std::chrono::seconds
 Peer::getLifeTime() const
 {
@@ -766,32 +848,132 @@ Peer::recvAuthenticatedMessage(AuthenticatedMessage&& msg)
 
     if (mState >= GOT_HELLO && msg.v0().message.type() != ERROR_MSG)
     {
-        if (msg.v0().sequence != mRecvMacSeq)
+        auto err = checkMessageAuth(msg, mRecvMacKey, mRecvMacSeq);
+        ++mRecvMacSeq;
+        if (err)
         {
-            ++mRecvMacSeq;
-            sendErrorAndDrop(ERR_AUTH, "unexpected auth sequence",
-                             DropMode::IGNORE_WRITE_QUEUE);
+            sendErrorAndDrop(ERR_AUTH, err, DropMode::IGNORE_WRITE_QUEUE);
             return;
         }
+    }
+    mPeerMetrics.mByteReadByType[msg.v0().message.type()] +=
+        xdr::xdr_size(msg);
+    recvMessage(std::move(msg.v0().message));
+}
+
+void
+Peer::recvVerifiedMessage(AuthenticatedMessage&& msg)
+{
+    ZoneScoped;
+    if (shouldAbort())
+    {
+        return;
+    }
+
+    releaseAssert(mState == GOT_AUTH);
+    if (msg.v0().message.type() != ERROR_MSG)
+    {
+        ++mRecvMacSeq;
+    }
+    mPeerMetrics.mByteReadByType[msg.v0().message.type()] +=
+        xdr::xdr_size(msg);
+    recvMessage(std::move(msg.v0().message));
+}
+
+char const*
+Peer::checkMessageAuth(AuthenticatedMessage const& msg,
+                       HmacSha256Key const& key, uint64_t seq)
+{
+    ZoneScoped;
+    if (msg.v0().sequence != seq)
+    {
+        return "unexpected auth sequence";
+    }
+
+    if (!hmacSha256Verify(
+            msg.v0().mac, key,
+            xdr::xdr_to_opaque(msg.v0().sequence, msg.v0().message)))
+    {
+        return "unexpected MAC";
+    }
+    return nullptr;
+}
 
-        if (!hmacSha256Verify(
-                msg.v0().mac, mRecvMacKey,
-                xdr::xdr_to_opaque(msg.v0().sequence, msg.v0().message)))
+bool
+Peer::maybeDropKnownTransaction(ByteSlice const& body)
+{
+    ZoneScoped;
+    if (!mAppConnector.getConfig().EARLY_DUPLICATE_TX_DETECTION ||
+        mState != GOT_AUTH || shouldAbort())
+    {
+        return false;
+    }
+
+    // An AuthenticatedMessage is laid out as its version, sequence number,
+    // message and MAC, and the message starts with its type
+    size_t const headerSize = 4 + 8;
+    size_t const macSize = 32;
+    if (body.size() < headerSize + 4 + macSize)
+    {
+        return false;
+    }
+    auto readUint = [&](size_t offset, size_t size) {
+        uint64_t res = 0;
+        for (size_t i = 0; i < size; ++i)
         {
-            ++mRecvMacSeq;
-            sendErrorAndDrop(ERR_AUTH, "unexpected MAC",
-                             DropMode::IGNORE_WRITE_QUEUE);
-            return;
+            res = (res << 8) | body[offset + i];
         }
-        ++mRecvMacSeq;
+        return res;
+    };
+    if (readUint(0, 4) != 0 || readUint(4, 8) != mRecvMacSeq ||
+        readUint(headerSize, 4) != static_cast<uint32_t>(TRANSACTION))
+    {
+        return false;
+    }
+
+    // The MAC covers the sequence number and the message
+    size_t const msgSize = body.size() - headerSize - macSize;
+    HmacSha256Mac mac;
+    std::memcpy(mac.mac.data(), body.data() + headerSize + msgSize, macSize);
+    if (!hmacSha256Verify(mac, mRecvMacKey,
+                          ByteSlice(body.data() + 4, 8 + msgSize)))
+    {
+        return false;
+    }
+
+    // The hash of the raw message is the ID the Floodgate knows it by
+    auto msgID = blake2(ByteSlice(body.data() + headerSize, msgSize));
+    if (!mAppConnector.getOverlayManager().recvKnownTransaction(
+            msgID, shared_from_this()))
+    {
+        return false;
+    }
+
+    ++mRecvMacSeq;
+    releaseAssert(mFlowControl);
+    if (!mFlowControl->beginFloodMessageProcessing(msgSize))
+    {
+        drop("unexpected flood message, peer at capacity",
+             Peer::DropDirection::WE_DROPPED_REMOTE,
+             Peer::DropMode::IGNORE_WRITE_QUEUE);
+        return true;
     }
-    recvMessage(msg.v0().message);
+    mPeerMetrics.mByteReadByType[TRANSACTION] += body.size();
+    onCapacityReleased(mFlowControl->endFloodMessageProcessing(msgSize));
+    return true;
 }
 
 void
 Peer::recvMessage(StellarMessage const& stellarMsg)
+{
+    recvMessage(StellarMessage(stellarMsg));
+}
+
+void
+Peer::recvMessage(StellarMessage&& stellarMsg)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Overlay);
     if (shouldAbort())
     {
         return;
@@ -849,7 +1031,8 @@ Peer::recvMessage(StellarMessage const& stellarMsg)
     }
 
     std::weak_ptr<Peer> weak = shared_from_this();
-    auto msgTracker = std::make_shared<MsgCapacityTracker>(weak, stellarMsg);
+    auto msgTracker =
+        std::make_shared<MsgCapacityTracker>(weak, std::move(stellarMsg));
 
     if (!mAppConnector.getLedgerManager().isSynced() && ignoreIfOutOfSync)
     {
@@ -899,6 +1082,7 @@ void
 Peer::recvRawMessage(StellarMessage const& stellarMsg)
 {
     ZoneScoped;
+    MemoryAttributionScope memoryScope(MemorySubsystem::Overlay);
     releaseAssert(threadIsMain());
 
     auto peerStr = toString();
@@ -1101,19 +1285,7 @@ Peer::recvGetTxSet(StellarMessage const& msg)
     auto self = shared_from_this();
     if (auto txSet = mAppConnector.getHerder().getTxSet(msg.txSetHash()))
     {
-        auto newMsg = std::make_shared<StellarMessage>();
-        if (txSet->isGeneralizedTxSet())
-        {
-            newMsg->type(GENERALIZED_TX_SET);
-            txSet->toXDR(newMsg->generalizedTxSet());
-        }
-        else
-        {
-            newMsg->type(TX_SET);
-            txSet->toXDR(newMsg->txSet());
-        }
-
-        self->sendMessage(newMsg);
+        self->sendMessage(txSet->getStellarMessage());
     }
     else
     {
@@ -1137,7 +1309,10 @@ Peer::recvTxSet(StellarMessage const& msg)
 {
     ZoneScoped;
     auto frame = TxSetXDRFrame::makeFromWire(msg.txSet());
-    mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame);
+    if (!mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame))
+    {
+        mOverlayMetrics.mFetchUnusedBytes.Mark(xdr::xdr_size(msg));
+    }
 }
 
 void
@@ -1145,7 +1320,10 @@ Peer::recvGeneralizedTxSet(StellarMessage const& msg)
 {
     ZoneScoped;
     auto frame = TxSetXDRFrame::makeFromWire(msg.generalizedTxSet());
-    mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame);
+    if (!mAppConnector.getHerder().recvTxSet(frame->getContentsHash(), frame))
+    {
+        mOverlayMetrics.mFetchUnusedBytes.Mark(xdr::xdr_size(msg));
+    }
 }
 
 void
@@ -1191,6 +1369,7 @@ Peer::maybeProcessPingResponse(Hash const& id)
             CLOG_DEBUG(Overlay, "Latency {}: {} ms", toString(),
                        mLastPing.count());
             mOverlayMetrics.mConnectionLatencyTimer.Update(mLastPing);
+            mFlowControl->setRoundTripTime(mLastPing);
             mAppConnector.getOverlayManager().getSurveyManager().modifyPeerData(
                 *this, [&](CollectingPeerData& peerData) {
                     peerData.mLatencyMsHistogram.Update(mLastPing.count());
@@ -1236,7 +1415,10 @@ Peer::recvSCPQuorumSet(StellarMessage const& msg)
     ZoneScoped;
     Hash hash = xdrSha256(msg.qSet());
     maybeProcessPingResponse(hash);
-    mAppConnector.getHerder().recvSCPQuorumSet(hash, msg.qSet());
+    if (!mAppConnector.getHerder().recvSCPQuorumSet(hash, msg.qSet()))
+    {
+        mOverlayMetrics.mFetchUnusedBytes.Mark(xdr::xdr_size(msg));
+    }
 }
 
 void
@@ -1245,7 +1427,7 @@ Peer::recvSCPMessage(StellarMessage const& msg)
     ZoneScoped;
     SCPEnvelope const& envelope = msg.envelope();
 
-    auto type = msg.envelope().statement.pledges.type();
+    auto type = envelope.statement.pledges.type();
     auto t = (type == SCP_ST_PREPARE
                   ? mOverlayMetrics.mRecvSCPPrepareTimer.TimeScope()
                   : (type == SCP_ST_CONFIRM
@@ -1274,17 +1456,7 @@ Peer::recvSCPMessage(StellarMessage const& msg)
     }
     ZoneText(codeStr.c_str(), codeStr.size());
 
-    // add it to the floodmap so that this peer gets credit for it
-    Hash msgID;
-    mAppConnector.getOverlayManager().recvFloodedMsgID(msg, shared_from_this(),
-                                                       msgID);
-
-    auto res = mAppConnector.getHerder().recvSCPEnvelope(envelope);
-    if (res == Herder::ENVELOPE_STATUS_DISCARDED)
-    {
-        // the message was discarded, remove it from the floodmap as well
-        mAppConnector.getOverlayManager().forgetFloodedMsg(msgID);
-    }
+    mAppConnector.getOverlayManager().recvSCPEnvelope(msg, shared_from_this());
 }
 
 void
@@ -1408,10 +1580,10 @@ Peer::recvHello(Hello const& elo)
     mRecvNonce = elo.nonce;
     mSendMacSeq = 0;
     mRecvMacSeq = 0;
-    mSendMacKey = peerAuth.getSendingMacKey(elo.cert.pubkey, mSendNonce,
-                                            mRecvNonce, mRole);
-    mRecvMacKey = peerAuth.getReceivingMacKey(elo.cert.pubkey, mSendNonce,
-                                              mRecvNonce, mRole);
+    mSendMacKey =
+        peerAuth.getSendingMacKey(elo.cert, mSendNonce, mRecvNonce, mRole);
+    mRecvMacKey =
+        peerAuth.getReceivingMacKey(elo.cert, mSendNonce, mRecvNonce, mRole);
 
     setState(GOT_HELLO);
 
@@ -1801,7 +1973,7 @@ Peer::handleMaxTxSizeIncrease(uint32_t increase)
 }
 
 bool
-Peer::sendAdvert(Hash const& hash)
+Peer::sendAdvert(Hash const& hash, bool delayed)
 {
     if (!mTxAdverts)
     {
@@ -1815,7 +1987,14 @@ Peer::sendAdvert(Hash const& hash)
     }
 
     // Otherwise, queue up an advert to broadcast to peer
-    mTxAdverts->queueOutgoingAdvert(hash);
+    if (delayed)
+    {
+        mTxAdverts->queueDelayedOutgoingAdvert(hash);
+    }
+    else
+    {
+        mTxAdverts->queueOutgoingAdvert(hash);
+    }
     return true;
 }
 
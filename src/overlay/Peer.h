@@ -14,6 +14,8 @@
 #include "util/Timer.h"
 #include "xdrpp/message.h"
 
+#include <map>
+
 namespace stellar
 {
 
@@ -35,6 +37,7 @@ static const uint32_t MAX_CLASSIC_TX_SIZE_BYTES = 100 * 1024;
 class Application;
 class LoopbackPeer;
 struct OverlayMetrics;
+class ByteSlice;
 class FlowControl;
 class TxAdverts;
 
@@ -156,6 +159,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
         uint64_t mMessagesFulfilled;
         uint64_t mBannedMessageUnfulfilled;
         uint64_t mUnknownMessageUnfulfilled;
+
+        // bytes of messages received and sent, by type
+        std::map<MessageType, uint64_t> mByteReadByType;
+        std::map<MessageType, uint64_t> mByteWriteByType;
     };
 
     struct TimestampedMessage
@@ -175,7 +182,7 @@ class Peer : public std::enable_shared_from_this<Peer>,
         StellarMessage mMsg;
 
       public:
-        MsgCapacityTracker(std::weak_ptr<Peer> peer, StellarMessage const& msg);
+        MsgCapacityTracker(std::weak_ptr<Peer> peer, StellarMessage&& msg);
         ~MsgCapacityTracker();
         StellarMessage const& getMessage();
         std::weak_ptr<Peer> getPeer();
@@ -208,10 +215,21 @@ class Peer : public std::enable_shared_from_this<Peer>,
     bool shouldAbort() const;
 
     void recvAuthenticatedMessage(AuthenticatedMessage&& msg);
+    // Process a message whose sequence number and MAC were already checked,
+    // against mRecvMacSeq and mRecvMacKey, off the main thread
+    void recvVerifiedMessage(AuthenticatedMessage&& msg);
+    // With EARLY_DUPLICATE_TX_DETECTION, check the MAC of an encoded
+    // AuthenticatedMessage and drop it if it's a transaction already
+    // received and queued. Returns false if `body` must be decoded as usual.
+    bool maybeDropKnownTransaction(ByteSlice const& body);
     // These exist mostly to be overridden in TCPPeer and callable via
     // shared_ptr<Peer> as a captured shared_from_this().
     virtual void connectHandler(asio::error_code const& ec);
 
+    // MAC `msg` with the next sequence number and send it
+    virtual void
+    sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg);
+
   private:
     PeerState mState;
     NodeID mPeerID;
@@ -270,6 +288,9 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void sendError(ErrorCode error, std::string const& message);
 
     void recvMessage(StellarMessage const& stellarMsg);
+    // Same, taking over the decoded message rather than copying it until it
+    // is processed
+    void recvMessage(StellarMessage&& stellarMsg);
 
     // NB: This is a move-argument because the write-buffer has to travel
     // with the write-request through the async IO system, and we might have
@@ -296,14 +317,30 @@ class Peer : public std::enable_shared_from_this<Peer>,
     void recurrentTimerExpired(asio::error_code const& error);
     std::chrono::seconds getIOTimeout() const;
 
-    void sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg);
     void beginMessageProcessing(StellarMessage const& msg);
     void endMessageProcessing(StellarMessage const& msg);
+    // Ask the peer for the capacity released by processed messages, and
+    // resume reading from it if it was throttled
+    void
+    onCapacityReleased(std::pair<uint64_t, std::optional<uint64_t>> const&
+                           capacity);
     bool mShuttingDown{false};
 
   public:
     Peer(Application& app, PeerRole role);
 
+    // Check that `msg` has sequence number `seq` and a valid MAC for `key`,
+    // returns the reason it doesn't or nullptr. Can be called from any thread.
+    static char const* checkMessageAuth(AuthenticatedMessage const& msg,
+                                        HmacSha256Key const& key,
+                                        uint64_t seq);
+
+    // Encode `msg` as an AuthenticatedMessage with sequence number `seq`, and
+    // a MAC if `macKey` is set. `body`, if set, is the encoding of `msg`.
+    static xdr::msg_ptr encodeAuthenticatedMessage(
+        StellarMessage const& msg, xdr::opaque_vec<> const* body,
+        HmacSha256Key const* macKey, uint64_t seq);
+
     void shutdown();
 
     std::string msgSummary(StellarMessage const& stellarMsg);
@@ -315,8 +352,9 @@ class Peer : public std::enable_shared_from_this<Peer>,
                           DropMode dropMode);
     void sendTxDemand(TxDemandVector&& demands);
     // Queue up an advert to send, return true if the advert was queued, and
-    // false otherwise (if advert is a duplicate, for example)
-    bool sendAdvert(Hash const& txHash);
+    // false otherwise (if advert is a duplicate, for example). A `delayed`
+    // advert is dropped if the peer advertises the hash to us in the meantime.
+    bool sendAdvert(Hash const& txHash, bool delayed = false);
     void sendSendMore(uint32_t numMessages);
     void sendSendMore(uint32_t numMessages, uint32_t numBytes);
 
@@ -332,6 +370,10 @@ class Peer : public std::enable_shared_from_this<Peer>,
     bool isConnected() const;
     bool isAuthenticated() const;
 
+    // Fraction of OUTBOUND_TX_QUEUE_BYTE_LIMIT taken by the transactions
+    // waiting to be sent to this peer, at most 1
+    double getOutboundTxQueueFill() const;
+
     VirtualClock::time_point
     getCreationTime() const
     {
@@ -9,9 +9,14 @@
 #include "crypto/SecretKey.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
 #include "util/Logging.h"
+#include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 
+#include <algorithm>
+
 namespace stellar
 {
 
@@ -26,8 +31,8 @@ makeAuthCert(Application& app, Curve25519Public const& pub)
     cert.pubkey = pub;
     cert.expiration = app.timeNow() + expirationLimit;
 
-    auto hash = sha256(xdr::xdr_to_opaque(
-        app.getNetworkID(), ENVELOPE_TYPE_AUTH, cert.expiration, cert.pubkey));
+    auto hash = xdrSha256(app.getNetworkID(), ENVELOPE_TYPE_AUTH,
+                          cert.expiration, cert.pubkey);
     CLOG_DEBUG(Overlay, "PeerAuth signing cert hash: {}", hexAbbrev(hash));
     cert.sig = app.getConfig().NODE_SEED.sign(hash);
     return cert;
@@ -39,6 +44,9 @@ PeerAuth::PeerAuth(Application& app)
     , mECDHPublicKey(curve25519DerivePublic(mECDHSecretKey))
     , mCert(makeAuthCert(app, mECDHPublicKey))
     , mSharedKeyCache(0xffff)
+    , mVerifiedCertCache(0xffff)
+    , mResumedAuth(
+          app.getMetrics().NewMeter({"overlay", "auth", "resumed"}, "peer"))
 {
 }
 
@@ -61,31 +69,56 @@ PeerAuth::verifyRemoteAuthCert(NodeID const& remoteNode, AuthCert const& cert)
                    cert.expiration, mApp.timeNow());
         return false;
     }
-    auto hash = sha256(xdr::xdr_to_opaque(
-        mApp.getNetworkID(), ENVELOPE_TYPE_AUTH, cert.expiration, cert.pubkey));
+
+    bool resume = mApp.getConfig().PEER_AUTH_RESUMPTION;
+    if (resume)
+    {
+        // The signature cache is shared with transactions and may have
+        // been churned since the peer last connected
+        auto known = mVerifiedCertCache.maybeGet(remoteNode);
+        if (known && *known == cert)
+        {
+            CLOG_DEBUG(Overlay, "PeerAuth cert already verified");
+            mResumedAuth.Mark();
+            return true;
+        }
+    }
+
+    auto hash = xdrSha256(mApp.getNetworkID(), ENVELOPE_TYPE_AUTH,
+                          cert.expiration, cert.pubkey);
 
     CLOG_DEBUG(Overlay, "PeerAuth verifying cert hash: {}", hexAbbrev(hash));
-    return PubKeyUtils::verifySig(remoteNode, cert.sig, hash);
+    if (!PubKeyUtils::verifySig(remoteNode, cert.sig, hash))
+    {
+        return false;
+    }
+    if (resume)
+    {
+        mVerifiedCertCache.put(remoteNode, cert);
+    }
+    return true;
 }
 
 HmacSha256Key
-PeerAuth::getSharedKey(Curve25519Public const& remotePublic,
-                       Peer::PeerRole role)
+PeerAuth::getSharedKey(AuthCert const& remoteCert, Peer::PeerRole role)
 {
-    auto key = PeerSharedKeyId{remotePublic, role};
-    if (mSharedKeyCache.exists(key))
+    auto key = PeerSharedKeyId{remoteCert.pubkey, role};
+    auto cached = mSharedKeyCache.maybeGet(key);
+    if (cached && cached->mExpiration >= mApp.timeNow())
     {
-        return mSharedKeyCache.get(key);
+        cached->mExpiration =
+            std::max(cached->mExpiration, remoteCert.expiration);
+        return cached->mKey;
     }
-    auto value =
-        curve25519DeriveSharedKey(mECDHSecretKey, mECDHPublicKey, remotePublic,
-                                  role == Peer::WE_CALLED_REMOTE);
-    mSharedKeyCache.put(key, value);
+    auto value = curve25519DeriveSharedKey(mECDHSecretKey, mECDHPublicKey,
+                                           remoteCert.pubkey,
+                                           role == Peer::WE_CALLED_REMOTE);
+    mSharedKeyCache.put(key, CachedSharedKey{value, remoteCert.expiration});
     return value;
 }
 
 HmacSha256Key
-PeerAuth::getSendingMacKey(Curve25519Public const& remotePublic,
+PeerAuth::getSendingMacKey(AuthCert const& remoteCert,
                            uint256 const& localNonce,
                            uint256 const& remoteNonce, Peer::PeerRole role)
 {
@@ -106,12 +139,12 @@ PeerAuth::getSendingMacKey(Curve25519Public const& remotePublic,
         buf.insert(buf.end(), localNonce.begin(), localNonce.end());
         buf.insert(buf.end(), remoteNonce.begin(), remoteNonce.end());
     }
-    auto k = getSharedKey(remotePublic, role);
+    auto k = getSharedKey(remoteCert, role);
     return hkdfExpand(k, buf);
 }
 
 HmacSha256Key
-PeerAuth::getReceivingMacKey(Curve25519Public const& remotePublic,
+PeerAuth::getReceivingMacKey(AuthCert const& remoteCert,
                              uint256 const& localNonce,
                              uint256 const& remoteNonce, Peer::PeerRole role)
 {
@@ -132,7 +165,7 @@ PeerAuth::getReceivingMacKey(Curve25519Public const& remotePublic,
         buf.insert(buf.end(), remoteNonce.begin(), remoteNonce.end());
         buf.insert(buf.end(), localNonce.begin(), localNonce.end());
     }
-    auto k = getSharedKey(remotePublic, role);
+    auto k = getSharedKey(remoteCert, role);
     return hkdfExpand(k, buf);
 }
 }
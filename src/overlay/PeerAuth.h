@@ -5,6 +5,11 @@
 #include "util/RandomEvictionCache.h"
 #include "xdr/Stellar-types.h"
 
+namespace medida
+{
+class Meter;
+}
+
 // Copyright 2015 Stellar Development Foundation and contributors. Licensed
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
@@ -24,14 +29,28 @@ class PeerAuth
     // HKDF_expand(K{us,them}, 1 || nonce_B || nonce_A) for
     // use in a particular A-called-B p2p session.
 
+    //
+    // A shared MAC key is only kept until the last cert seen for its remote
+    // key expires. With PEER_AUTH_RESUMPTION, the cert a peer last
+    // authenticated with is kept as well, so that it doesn't need to be
+    // verified again when the peer reconnects before it expires.
+
+    struct CachedSharedKey
+    {
+        HmacSha256Key mKey;
+        uint64 mExpiration;
+    };
+
     Application& mApp;
     Curve25519Secret mECDHSecretKey;
     Curve25519Public mECDHPublicKey;
     AuthCert mCert;
 
-    RandomEvictionCache<PeerSharedKeyId, HmacSha256Key> mSharedKeyCache;
+    RandomEvictionCache<PeerSharedKeyId, CachedSharedKey> mSharedKeyCache;
+    RandomEvictionCache<NodeID, AuthCert> mVerifiedCertCache;
+    medida::Meter& mResumedAuth;
 
-    HmacSha256Key getSharedKey(Curve25519Public const& remotePublic,
+    HmacSha256Key getSharedKey(AuthCert const& remoteCert,
                                Peer::PeerRole role);
 
   public:
@@ -40,11 +59,11 @@ class PeerAuth
     AuthCert getAuthCert();
     bool verifyRemoteAuthCert(NodeID const& remoteNode, AuthCert const& cert);
 
-    HmacSha256Key getSendingMacKey(Curve25519Public const& remotePublic,
+    HmacSha256Key getSendingMacKey(AuthCert const& remoteCert,
                                    uint256 const& localNonce,
                                    uint256 const& remoteNonce,
                                    Peer::PeerRole role);
-    HmacSha256Key getReceivingMacKey(Curve25519Public const& remotePublic,
+    HmacSha256Key getReceivingMacKey(AuthCert const& remoteCert,
                                      uint256 const& localNonce,
                                      uint256 const& remoteNonce,
                                      Peer::PeerRole role);
@@ -6,12 +6,13 @@
 #include "database/Database.h"
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "overlay/RandomPeerSource.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include "util/ZoneProfiler.h"
 
-#include <Tracy.hpp>
 #include <algorithm>
 #include <cmath>
 #include <fmt/format.h>
@@ -85,82 +86,176 @@ PeerManager::PeerManager(Application& app)
           *this, RandomPeerSource::maxFailures(MAX_FAILURES, true)))
     , mInboundPeersToSend(std::make_unique<RandomPeerSource>(
           *this, RandomPeerSource::maxFailures(MAX_FAILURES, false)))
+    , mFlushTimer(app)
 {
 }
 
-std::vector<PeerBareAddress>
-PeerManager::loadRandomPeers(PeerQuery const& query, size_t size)
+namespace
 {
-    ZoneScoped;
-    // BATCH_SIZE should always be bigger, so it should win anyway
-    size = std::max(size, BATCH_SIZE);
-
-    // if we ever start removing peers from db, we may need to enable this
-    // soci::transaction sqltx(mApp.getDatabase().getSession());
-    // mApp.getDatabase().setCurrentTransactionReadOnly();
+size_t
+typeIndex(int type)
+{
+    releaseAssert(type >= static_cast<int>(PeerType::INBOUND) &&
+                  type <= static_cast<int>(PeerType::PREFERRED));
+    return static_cast<size_t>(type);
+}
+}
 
-    std::vector<std::string> conditions;
-    if (query.mUseNextAttempt)
+void
+PeerManager::ensureLoaded()
+{
+    releaseAssert(threadIsMain());
+    if (mLoaded)
     {
-        conditions.push_back("nextattempt <= :nextattempt");
+        return;
     }
-    if (query.mMaxNumFailures.has_value())
+    mLoaded = true;
+    for (auto const& peer : loadFromDatabase())
     {
-        conditions.push_back("numfailures <= :maxFailures");
+        if (peer.second.mType < static_cast<int>(PeerType::INBOUND) ||
+            peer.second.mType > static_cast<int>(PeerType::PREFERRED))
+        {
+            CLOG_WARNING(Overlay, "Ignoring peer {} of unknown type {}",
+                         peer.first.toString(), peer.second.mType);
+            continue;
+        }
+        insert(peer.first, peer.second, /* inDatabase */ true);
     }
-    if (query.mTypeFilter == PeerTypeFilter::ANY_OUTBOUND)
+    CLOG_DEBUG(Overlay, "Loaded {} peers", mPeers.size());
+}
+
+void
+PeerManager::insert(PeerBareAddress const& address,
+                    PeerRecord const& peerRecord, bool inDatabase)
+{
+    auto& index = mPeersByType[typeIndex(peerRecord.mType)];
+    auto indexIt = index.emplace(
+        VirtualClock::tmToSystemPoint(peerRecord.mNextAttempt), address);
+    auto res =
+        mPeers.emplace(address, PeerEntry{peerRecord, inDatabase, indexIt});
+    releaseAssert(res.second);
+}
+
+void
+PeerManager::erase(std::map<PeerBareAddress, PeerEntry>::iterator it)
+{
+    mPeersByType[typeIndex(it->second.mRecord.mType)].erase(
+        it->second.mIndexIt);
+    mPeers.erase(it);
+}
+
+void
+PeerManager::markDirty(PeerBareAddress const& address)
+{
+    mDirtyPeers.emplace(address);
+    auto period = mApp.getConfig().PEER_TABLE_FLUSH_PERIOD_MS;
+    if (period.count() == 0)
     {
-        conditions.push_back("type != :inboundType");
+        flush();
     }
-    else
+    else if (!mFlushScheduled)
     {
-        conditions.push_back("type = :type");
+        mFlushScheduled = true;
+        mFlushTimer.expires_from_now(period);
+        mFlushTimer.async_wait([this]() { flush(); },
+                               &VirtualTimer::onFailureNoop);
     }
-    releaseAssert(!conditions.empty());
-    std::string where = conditions[0];
-    for (size_t i = 1; i < conditions.size(); i++)
+}
+
+void
+PeerManager::flush()
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    mFlushScheduled = false;
+    mFlushTimer.cancel();
+    if (mDirtyPeers.empty() && mRemovedPeers.empty())
     {
-        where += " AND " + conditions[i];
+        return;
     }
 
-    std::tm nextAttempt =
-        VirtualClock::systemPointToTm(mApp.getClock().system_now());
-    size_t maxNumFailures{0};
-    int exactType = static_cast<int>(query.mTypeFilter);
-    int inboundType = static_cast<int>(PeerType::INBOUND);
-
-    auto bindToStatement = [&](soci::statement& st) {
-        if (query.mUseNextAttempt)
-        {
-            st.exchange(soci::use(nextAttempt));
-        }
-        if (query.mMaxNumFailures.has_value())
+    try
+    {
+        soci::transaction tx(mApp.getDatabase().getSession());
+        for (auto const& address : mRemovedPeers)
         {
-            maxNumFailures = *query.mMaxNumFailures;
-            st.exchange(soci::use(maxNumFailures));
+            removeFromDatabase(address);
         }
-        if (query.mTypeFilter == PeerTypeFilter::ANY_OUTBOUND)
+        for (auto const& address : mDirtyPeers)
         {
-            st.exchange(soci::use(inboundType));
-        }
-        else
-        {
-            st.exchange(soci::use(exactType));
+            auto it = mPeers.find(address);
+            if (it != mPeers.end() &&
+                storeToDatabase(address, it->second.mRecord,
+                                it->second.mInDatabase))
+            {
+                it->second.mInDatabase = true;
+            }
         }
-    };
+        tx.commit();
+    }
+    catch (soci_error& err)
+    {
+        CLOG_ERROR(Overlay, "PeerManager::flush error: {}", err.what());
+    }
+    CLOG_TRACE(Overlay, "Flushed {} peers, removed {}", mDirtyPeers.size(),
+               mRemovedPeers.size());
+    mDirtyPeers.clear();
+    mRemovedPeers.clear();
+}
 
-    auto result = std::vector<PeerBareAddress>{};
-    size_t count = countPeers(where, bindToStatement);
-    if (count == 0)
+std::vector<PeerBareAddress>
+PeerManager::loadRandomPeers(PeerQuery const& query, size_t size)
+{
+    ZoneScoped;
+    ensureLoaded();
+    // BATCH_SIZE should always be bigger, so it should win anyway
+    size = std::max(size, BATCH_SIZE);
+
+    std::vector<PeerType> types;
+    switch (query.mTypeFilter)
     {
-        return result;
+    case PeerTypeFilter::INBOUND_ONLY:
+        types = {PeerType::INBOUND};
+        break;
+    case PeerTypeFilter::OUTBOUND_ONLY:
+        types = {PeerType::OUTBOUND};
+        break;
+    case PeerTypeFilter::PREFERRED_ONLY:
+        types = {PeerType::PREFERRED};
+        break;
+    case PeerTypeFilter::ANY_OUTBOUND:
+        types = {PeerType::OUTBOUND, PeerType::PREFERRED};
+        break;
+    default:
+        abort();
     }
 
-    size_t maxOffset = count > size ? count - size : 0;
-    size_t offset = rand_uniform<size_t>(0, maxOffset);
-    result = loadPeers(size, offset, where, bindToStatement);
+    // Next attempts are stored with a precision of a second
+    auto nextAttempt = VirtualClock::tmToSystemPoint(
+        VirtualClock::systemPointToTm(mApp.getClock().system_now()));
+
+    auto result = std::vector<PeerBareAddress>{};
+    for (auto type : types)
+    {
+        auto const& index = mPeersByType[typeIndex(static_cast<int>(type))];
+        auto end = query.mUseNextAttempt ? index.upper_bound(nextAttempt)
+                                         : index.end();
+        for (auto it = index.begin(); it != end; ++it)
+        {
+            auto const& record = mPeers.at(it->second).mRecord;
+            if (!query.mMaxNumFailures.has_value() ||
+                record.mNumFailures <= *query.mMaxNumFailures)
+            {
+                result.emplace_back(it->second);
+            }
+        }
+    }
 
     stellar::shuffle(std::begin(result), std::end(result), gRandomEngine);
+    if (result.size() > size)
+    {
+        result.resize(size);
+    }
     return result;
 }
 
@@ -169,40 +264,29 @@ PeerManager::removePeersWithManyFailures(size_t minNumFailures,
                                          PeerBareAddress const* address)
 {
     ZoneScoped;
-    releaseAssert(threadIsMain());
-    try
+    ensureLoaded();
+    bool removed = false;
+    for (auto it = mPeers.begin(); it != mPeers.end();)
     {
-        auto& db = mApp.getDatabase();
-        auto sql = std::string{
-            "DELETE FROM peers WHERE numfailures >= :minNumFailures"};
-        if (address)
+        if (it->second.mRecord.mNumFailures >= minNumFailures &&
+            (!address || it->first.getIP() == address->getIP()))
         {
-            sql += " AND ip = :ip";
-        }
-
-        auto prep = db.getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        st.exchange(use(minNumFailures));
-
-        std::string ip;
-        if (address)
-        {
-            ip = address->getIP();
-            st.exchange(use(ip));
+            if (it->second.mInDatabase)
+            {
+                mRemovedPeers.emplace(it->first);
+            }
+            mDirtyPeers.erase(it->first);
+            erase(it++);
+            removed = true;
         }
-        st.define_and_bind();
-
+        else
         {
-            auto timer = db.getDeleteTimer("peer");
-            st.execute(true);
+            ++it;
         }
     }
-    catch (soci_error& err)
+    if (removed && mApp.getConfig().PEER_TABLE_FLUSH_PERIOD_MS.count() == 0)
     {
-        CLOG_ERROR(Overlay,
-                   "PeerManager::removePeersWithManyFailures error: {}",
-                   err.what());
+        flush();
     }
 }
 
@@ -230,48 +314,44 @@ std::pair<PeerRecord, bool>
 PeerManager::load(PeerBareAddress const& address)
 {
     ZoneScoped;
+    ensureLoaded();
+    auto it = mPeers.find(address);
+    if (it != mPeers.end())
+    {
+        return std::make_pair(it->second.mRecord, true);
+    }
+
     auto result = PeerRecord{};
-    auto inDatabase = false;
+    result.mNextAttempt =
+        VirtualClock::systemPointToTm(mApp.getClock().system_now());
+    result.mType = static_cast<int>(PeerType::INBOUND);
+    return std::make_pair(result, false);
+}
 
-    try
+void
+PeerManager::store(PeerBareAddress const& address, PeerRecord const& peerRecord)
+{
+    ZoneScoped;
+    ensureLoaded();
+    auto it = mPeers.find(address);
+    bool inDatabase = false;
+    if (it != mPeers.end())
     {
-        auto prep = mApp.getDatabase().getPreparedStatement(
-            "SELECT numfailures, nextattempt, type FROM peers "
-            "WHERE ip = :v1 AND port = :v2");
-        auto& st = prep.statement();
-        st.exchange(into(result.mNumFailures));
-        st.exchange(into(result.mNextAttempt));
-        st.exchange(into(result.mType));
-        std::string ip = address.getIP();
-        st.exchange(use(ip));
-        int port = address.getPort();
-        st.exchange(use(port));
-        st.define_and_bind();
-        {
-            auto timer = mApp.getDatabase().getSelectTimer("peer");
-            st.execute(true);
-            inDatabase = st.got_data();
-
-            if (!inDatabase)
-            {
-                result.mNextAttempt =
-                    VirtualClock::systemPointToTm(mApp.getClock().system_now());
-                result.mType = static_cast<int>(PeerType::INBOUND);
-            }
-        }
+        inDatabase = it->second.mInDatabase;
+        erase(it);
     }
-    catch (soci_error& err)
+    else if (mRemovedPeers.erase(address) != 0)
     {
-        CLOG_ERROR(Overlay, "PeerManager::load error: {} on {}", err.what(),
-                   address.toString());
+        // Removed since the last flush, the row is still there
+        inDatabase = true;
     }
-
-    return std::make_pair(result, inDatabase);
+    insert(address, peerRecord, inDatabase);
+    markDirty(address);
 }
 
-void
-PeerManager::store(PeerBareAddress const& address, PeerRecord const& peerRecord,
-                   bool inDatabase)
+bool
+PeerManager::storeToDatabase(PeerBareAddress const& address,
+                             PeerRecord const& peerRecord, bool inDatabase)
 {
     ZoneScoped;
     std::string query;
@@ -311,6 +391,7 @@ PeerManager::store(PeerBareAddress const& address, PeerRecord const& peerRecord,
             {
                 CLOG_ERROR(Overlay, "PeerManager::store failed on {}",
                            address.toString());
+                return false;
             }
         }
     }
@@ -318,6 +399,35 @@ PeerManager::store(PeerBareAddress const& address, PeerRecord const& peerRecord,
     {
         CLOG_ERROR(Overlay, "PeerManager::store error: {} on {}", err.what(),
                    address.toString());
+        return false;
+    }
+    return true;
+}
+
+void
+PeerManager::removeFromDatabase(PeerBareAddress const& address)
+{
+    ZoneScoped;
+    try
+    {
+        auto& db = mApp.getDatabase();
+        auto prep = db.getPreparedStatement(
+            "DELETE FROM peers WHERE ip = :v1 AND port = :v2");
+        auto& st = prep.statement();
+        std::string ip = address.getIP();
+        st.exchange(use(ip));
+        int port = address.getPort();
+        st.exchange(use(port));
+        st.define_and_bind();
+        {
+            auto timer = db.getDeleteTimer("peer");
+            st.execute(true);
+        }
+    }
+    catch (soci_error& err)
+    {
+        CLOG_ERROR(Overlay, "PeerManager::remove error: {} on {}", err.what(),
+                   address.toString());
     }
 }
 
@@ -410,7 +520,7 @@ PeerManager::ensureExists(PeerBareAddress const& address)
     if (!peer.second)
     {
         CLOG_TRACE(Overlay, "Learned peer {}", address.toString());
-        store(address, peer.first, peer.second);
+        store(address, peer.first);
     }
 }
 
@@ -467,7 +577,7 @@ PeerManager::update(PeerBareAddress const& address, PeerType observedType,
     TypeUpdate typeUpdate =
         getTypeUpdate(peer.first, observedType, preferredTypeKnown);
     update(peer.first, typeUpdate);
-    store(address, peer.first, peer.second);
+    store(address, peer.first);
 }
 
 void
@@ -476,7 +586,7 @@ PeerManager::update(PeerBareAddress const& address, BackOffUpdate backOff)
     ZoneScoped;
     auto peer = load(address);
     update(peer.first, backOff, mApp);
-    store(address, peer.first, peer.second);
+    store(address, peer.first);
 }
 
 void
@@ -489,93 +599,32 @@ PeerManager::update(PeerBareAddress const& address, PeerType observedType,
         getTypeUpdate(peer.first, observedType, preferredTypeKnown);
     update(peer.first, typeUpdate);
     update(peer.first, backOff, mApp);
-    store(address, peer.first, peer.second);
+    store(address, peer.first);
 }
 
-size_t
-PeerManager::countPeers(std::string const& where,
-                        std::function<void(soci::statement&)> const& bind)
+void
+PeerManager::dropAll(Database& db)
 {
-    ZoneScoped;
-    size_t count = 0;
-
-    try
-    {
-        std::string sql = "SELECT COUNT(*) FROM peers WHERE " + where;
-
-        auto prep = mApp.getDatabase().getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        bind(st);
-        st.exchange(into(count));
-
-        st.define_and_bind();
-        st.execute(true);
-    }
-    catch (soci_error& err)
-    {
-        CLOG_ERROR(Overlay, "countPeers error: {}", err.what());
-    }
-
-    return count;
+    db.getSession() << "DROP TABLE IF EXISTS peers;";
+    db.getSession() << kSQLCreateStatement;
 }
 
-std::vector<PeerBareAddress>
-PeerManager::loadPeers(size_t limit, size_t offset, std::string const& where,
-                       std::function<void(soci::statement&)> const& bind)
+std::vector<std::pair<PeerBareAddress, PeerRecord>>
+PeerManager::loadAllPeers()
 {
     ZoneScoped;
-    auto result = std::vector<PeerBareAddress>{};
-
-    try
-    {
-        std::string sql = "SELECT ip, port "
-                          "FROM peers WHERE " +
-                          where + " LIMIT :limit OFFSET :offset";
-
-        auto prep = mApp.getDatabase().getPreparedStatement(sql);
-        auto& st = prep.statement();
-
-        bind(st);
-        st.exchange(use(limit));
-        st.exchange(use(offset));
-
-        std::string ip;
-        int lport;
-        st.exchange(into(ip));
-        st.exchange(into(lport));
-
-        st.define_and_bind();
-        {
-            auto timer = mApp.getDatabase().getSelectTimer("peer");
-            st.execute(true);
-        }
-        while (st.got_data())
-        {
-            if (!ip.empty() && lport > 0)
-            {
-                result.emplace_back(ip, static_cast<unsigned short>(lport));
-            }
-            st.fetch();
-        }
-    }
-    catch (soci_error& err)
+    ensureLoaded();
+    std::vector<std::pair<PeerBareAddress, PeerRecord>> result;
+    result.reserve(mPeers.size());
+    for (auto const& peer : mPeers)
     {
-        CLOG_ERROR(Overlay, "loadPeers error: {}", err.what());
+        result.emplace_back(peer.first, peer.second.mRecord);
     }
-
     return result;
 }
 
-void
-PeerManager::dropAll(Database& db)
-{
-    db.getSession() << "DROP TABLE IF EXISTS peers;";
-    db.getSession() << kSQLCreateStatement;
-}
-
 std::vector<std::pair<PeerBareAddress, PeerRecord>>
-PeerManager::loadAllPeers()
+PeerManager::loadFromDatabase()
 {
     ZoneScoped;
     std::vector<std::pair<PeerBareAddress, PeerRecord>> result;
@@ -621,12 +670,21 @@ void
 PeerManager::storePeers(
     std::vector<std::pair<PeerBareAddress, PeerRecord>> peers)
 {
-    soci::transaction tx(mApp.getDatabase().getSession());
+    releaseAssert(threadIsMain());
+    mPeers.clear();
+    for (auto& index : mPeersByType)
+    {
+        index.clear();
+    }
+    mDirtyPeers.clear();
+    mRemovedPeers.clear();
+    mLoaded = true;
     for (auto const& peer : peers)
     {
-        store(peer.first, peer.second, /* inDatabase */ false);
+        insert(peer.first, peer.second, /* inDatabase */ false);
+        mDirtyPeers.emplace(peer.first);
     }
-    tx.commit();
+    flush();
 }
 
 const char* PeerManager::kSQLCreateStatement =
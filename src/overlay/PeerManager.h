@@ -7,7 +7,10 @@
 #include "overlay/PeerBareAddress.h"
 #include "util/Timer.h"
 
+#include <array>
 #include <functional>
+#include <map>
+#include <set>
 
 namespace soci
 {
@@ -57,7 +60,10 @@ struct PeerQuery
 PeerAddress toXdr(PeerBareAddress const& address);
 
 /**
- * Maintain list of know peers in database.
+ * Maintain list of know peers. The whole table is loaded from the database on
+ * first use and kept in memory, indexed by type and next attempt time, and the
+ * records that change are written back to the database in batches every
+ * PEER_TABLE_FLUSH_PERIOD_MS, or right away if it is 0, and on shutdown.
  */
 class PeerManager
 {
@@ -107,21 +113,20 @@ class PeerManager
                 bool preferredTypeKnown, BackOffUpdate backOff);
 
     /**
-     * Load PeerRecord data for peer with given address. If not available in
-     * database, create default one. Second value in pair is true when data
-     * was loaded from database, false otherwise.
+     * Load PeerRecord data for peer with given address. If not known,
+     * create default one. Second value in pair is true when the peer is
+     * known, false otherwise.
      */
     std::pair<PeerRecord, bool> load(PeerBareAddress const& address);
 
     /**
-     * Store PeerRecord data into database. If inDatabase is true, uses UPDATE
-     * query, uses INSERT otherwise.
+     * Store PeerRecord data for peer with given address, adding the peer if
+     * it isn't known yet.
      */
-    void store(PeerBareAddress const& address, PeerRecord const& PeerRecord,
-               bool inDatabase);
+    void store(PeerBareAddress const& address, PeerRecord const& peerRecord);
 
     /**
-     * Load size random peers matching query from database.
+     * Load size random peers matching query.
      */
     std::vector<PeerBareAddress> loadRandomPeers(PeerQuery const& query,
                                                  size_t size);
@@ -140,27 +145,60 @@ class PeerManager
                                                 PeerBareAddress const& address);
 
     /**
-     * Load all peers from the database.
+     * Load all peers.
      */
     std::vector<std::pair<PeerBareAddress, PeerRecord>> loadAllPeers();
 
     /**
-     * Store peers in the database.
+     * Replace all peers with the given ones and store them in the database,
+     * which must not have any peer.
      */
     void storePeers(std::vector<std::pair<PeerBareAddress, PeerRecord>>);
 
+    /**
+     * Write to the database the peers changed or removed since the last
+     * flush.
+     */
+    void flush();
+
   private:
     static const char* kSQLCreateStatement;
 
+    using NextAttemptIndex =
+        std::multimap<VirtualClock::system_time_point, PeerBareAddress>;
+
+    struct PeerEntry
+    {
+        PeerRecord mRecord;
+        // Whether the database has a row for the peer, updated by flush
+        bool mInDatabase{false};
+        NextAttemptIndex::iterator mIndexIt;
+    };
+
     Application& mApp;
     std::unique_ptr<RandomPeerSource> mOutboundPeersToSend;
     std::unique_ptr<RandomPeerSource> mInboundPeersToSend;
 
-    size_t countPeers(std::string const& where,
-                      std::function<void(soci::statement&)> const& bind);
-    std::vector<PeerBareAddress>
-    loadPeers(size_t limit, size_t offset, std::string const& where,
-              std::function<void(soci::statement&)> const& bind);
+    bool mLoaded{false};
+    std::map<PeerBareAddress, PeerEntry> mPeers;
+    // Peers of each PeerType, by next attempt time
+    std::array<NextAttemptIndex, 3> mPeersByType;
+    // Peers to write to or remove from the database on the next flush
+    std::set<PeerBareAddress> mDirtyPeers;
+    std::set<PeerBareAddress> mRemovedPeers;
+    VirtualTimer mFlushTimer;
+    bool mFlushScheduled{false};
+
+    void ensureLoaded();
+    void insert(PeerBareAddress const& address, PeerRecord const& peerRecord,
+                bool inDatabase);
+    void erase(std::map<PeerBareAddress, PeerEntry>::iterator it);
+    void markDirty(PeerBareAddress const& address);
+
+    std::vector<std::pair<PeerBareAddress, PeerRecord>> loadFromDatabase();
+    bool storeToDatabase(PeerBareAddress const& address,
+                         PeerRecord const& peerRecord, bool inDatabase);
+    void removeFromDatabase(PeerBareAddress const& address);
 
     void update(PeerRecord& peer, TypeUpdate type);
     void update(PeerRecord& peer, BackOffUpdate backOff, Application& app);
@@ -7,8 +7,8 @@
 #include "crypto/SecretKey.h"
 #include "overlay/Peer.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 
-#include <Tracy.hpp>
 #include <chrono>
 
 using namespace std::chrono_literals;
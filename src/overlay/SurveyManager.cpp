@@ -12,6 +12,7 @@
 #include "overlay/SurveyDataManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/XDROperators.h"
 #include "xdrpp/marshal.h"
 
 namespace stellar
@@ -471,6 +472,11 @@ SurveyManager::relayOrProcessResponse(StellarMessage const& msg,
         if (mRunningSurveyReportingPhaseType &&
             *mRunningSurveyReportingPhaseType == response.commandType)
         {
+            if (mApp.getConfig().BACKGROUND_SURVEY_PROCESSING)
+            {
+                decryptResponseInBackground(msg.type(), response);
+                return;
+            }
             try
             {
                 xdr::opaque_vec<> opaqueDecrypted = curve25519Decrypt(
@@ -479,23 +485,8 @@ SurveyManager::relayOrProcessResponse(StellarMessage const& msg,
 
                 SurveyResponseBody body;
                 xdr::xdr_from_opaque(opaqueDecrypted, body);
-                switch (msg.type())
-                {
-                case SURVEY_RESPONSE:
-                {
-                    processOldStyleTopologyResponse(response.surveyedPeerID,
-                                                    body);
-                }
-                break;
-                case TIME_SLICED_SURVEY_RESPONSE:
-                {
-                    processTimeSlicedTopologyResponse(response.surveyedPeerID,
-                                                      body);
-                }
-                break;
-                default:
-                    releaseAssert(false);
-                }
+                processResponseBody(msg.type(), response.surveyedPeerID,
+                                    body);
             }
             catch (std::exception const& e)
             {
@@ -515,6 +506,102 @@ SurveyManager::relayOrProcessResponse(StellarMessage const& msg,
     }
 }
 
+void
+SurveyManager::processResponseBody(MessageType type,
+                                   NodeID const& surveyedPeerID,
+                                   SurveyResponseBody const& body)
+{
+    switch (type)
+    {
+    case SURVEY_RESPONSE:
+        processOldStyleTopologyResponse(surveyedPeerID, body);
+        break;
+    case TIME_SLICED_SURVEY_RESPONSE:
+        processTimeSlicedTopologyResponse(surveyedPeerID, body);
+        break;
+    default:
+        releaseAssert(false);
+    }
+}
+
+void
+SurveyManager::decryptResponseInBackground(
+    MessageType type, SurveyResponseMessage const& response)
+{
+    if (mPendingBackgroundResponses >= MAX_PENDING_BACKGROUND_RESPONSES)
+    {
+        CLOG_DEBUG(Overlay,
+                   "Dropping survey response from {}: too many responses "
+                   "pending",
+                   KeyUtils::toStrKey(response.surveyedPeerID));
+        return;
+    }
+    ++mPendingBackgroundResponses;
+
+    std::weak_ptr<SurveyManager> weak = shared_from_this();
+    Application& app = mApp;
+    app.postOnBackgroundThread(
+        [weak, &app, type, secret = mCurve25519SecretKey,
+         pub = mCurve25519PublicKey, surveyKey = mCurve25519PublicKey,
+         commandType = response.commandType,
+         surveyedPeerID = response.surveyedPeerID,
+         encryptedBody = response.encryptedBody]() mutable {
+            std::optional<SurveyResponseBody> body;
+            std::string error;
+            try
+            {
+                xdr::opaque_vec<> opaqueDecrypted =
+                    curve25519Decrypt(secret, pub, encryptedBody);
+                body.emplace();
+                xdr::xdr_from_opaque(opaqueDecrypted, *body);
+            }
+            catch (std::exception const& e)
+            {
+                body.reset();
+                error = e.what();
+            }
+            clearCurve25519Keys(pub, secret);
+            encryptedBody.clear();
+
+            app.postOnMainThread(
+                [weak, type, surveyKey, commandType, surveyedPeerID,
+                 body = std::move(body), error = std::move(error)]() {
+                    auto self = weak.lock();
+                    if (!self)
+                    {
+                        return;
+                    }
+                    --self->mPendingBackgroundResponses;
+                    // Drop responses to a survey that ended in the meantime
+                    if (!self->mRunningSurveyReportingPhaseType ||
+                        *self->mRunningSurveyReportingPhaseType !=
+                            commandType ||
+                        !(self->mCurve25519PublicKey == surveyKey))
+                    {
+                        return;
+                    }
+                    try
+                    {
+                        if (!body)
+                        {
+                            throw std::runtime_error(error);
+                        }
+                        self->processResponseBody(type, surveyedPeerID,
+                                                  *body);
+                    }
+                    catch (std::exception const& e)
+                    {
+                        CLOG_ERROR(Overlay,
+                                   "processing survey response failed: {}",
+                                   e.what());
+                        self->mBadResponseNodes.emplace(surveyedPeerID);
+                    }
+                },
+                "SurveyManager: process response");
+        },
+        "SurveyManager: decrypt response");
+}
+
 void
 SurveyManager::relayOrProcessRequest(StellarMessage const& msg,
                                      Peer::pointer peer)
@@ -746,12 +833,13 @@ SurveyManager::processTimeSlicedTopologyResponse(NodeID const& surveyedPeerID,
 
 bool
 SurveyManager::populateSurveyResponseMessage(
-    SurveyRequestMessage const& request, SurveyMessageCommandType type,
-    SurveyResponseBody const& body, SurveyResponseMessage& response) const
+    Config const& cfg, SurveyRequestMessage const& request,
+    SurveyMessageCommandType type, SurveyResponseBody const& body,
+    SurveyResponseMessage& response)
 {
     response.ledgerNum = request.ledgerNum;
     response.surveyorPeerID = request.surveyorPeerID;
-    response.surveyedPeerID = mApp.getConfig().NODE_SEED.getPublicKey();
+    response.surveyedPeerID = cfg.NODE_SEED.getPublicKey();
     response.commandType = type;
 
     try
@@ -805,8 +893,8 @@ SurveyManager::processOldStyleTopologyRequest(
         mApp.getConfig().TARGET_PEER_CONNECTIONS;
 
     auto& response = signedResponse.response;
-    if (!populateSurveyResponseMessage(request, SURVEY_TOPOLOGY, body,
-                                       response))
+    if (!populateSurveyResponseMessage(mApp.getConfig(), request,
+                                       SURVEY_TOPOLOGY, body, response))
     {
         return;
     }
@@ -839,6 +927,58 @@ SurveyManager::processTimeSlicedTopologyRequest(
         return;
     }
 
+    if (!mApp.getConfig().BACKGROUND_SURVEY_PROCESSING)
+    {
+        auto newMsg =
+            makeTimeSlicedTopologyResponse(mApp.getConfig(), request, body);
+        if (newMsg)
+        {
+            broadcast(*newMsg);
+        }
+        return;
+    }
+
+    if (mPendingBackgroundResponses >= MAX_PENDING_BACKGROUND_RESPONSES)
+    {
+        CLOG_DEBUG(Overlay,
+                   "Dropping TimeSlicedTopology response to {}: too many "
+                   "responses pending",
+                   peerIdStr);
+        return;
+    }
+    ++mPendingBackgroundResponses;
+
+    // Encrypting and signing only need the config, which outlives the
+    // background threads
+    std::weak_ptr<SurveyManager> weak = shared_from_this();
+    Application& app = mApp;
+    app.postOnBackgroundThread(
+        [weak, &app, request, body = std::move(body)]() {
+            auto newMsg =
+                makeTimeSlicedTopologyResponse(app.getConfig(), request, body);
+            app.postOnMainThread(
+                [weak, newMsg = std::move(newMsg)]() {
+                    auto self = weak.lock();
+                    if (!self)
+                    {
+                        return;
+                    }
+                    --self->mPendingBackgroundResponses;
+                    if (newMsg)
+                    {
+                        self->broadcast(*newMsg);
+                    }
+                },
+                "SurveyManager: broadcast response");
+        },
+        "SurveyManager: sign response");
+}
+
+std::optional<StellarMessage>
+SurveyManager::makeTimeSlicedTopologyResponse(
+    Config const& cfg, TimeSlicedSurveyRequestMessage const& request,
+    SurveyResponseBody const& body)
+{
     StellarMessage newMsg;
     newMsg.type(TIME_SLICED_SURVEY_RESPONSE);
     auto& signedResponse = newMsg.signedTimeSlicedSurveyResponseMessage();
@@ -847,16 +987,16 @@ SurveyManager::processTimeSlicedTopologyRequest(
     outerResponse.nonce = request.nonce;
 
     auto& innerResponse = outerResponse.response;
-    if (!populateSurveyResponseMessage(
-            request.request, TIME_SLICED_SURVEY_TOPOLOGY, body, innerResponse))
+    if (!populateSurveyResponseMessage(cfg, request.request,
+                                       TIME_SLICED_SURVEY_TOPOLOGY, body,
+                                       innerResponse))
     {
-        return;
+        return std::nullopt;
     }
 
     auto sigBody = xdr::xdr_to_opaque(outerResponse);
-    signedResponse.responseSignature = mApp.getConfig().NODE_SEED.sign(sigBody);
-
-    broadcast(newMsg);
+    signedResponse.responseSignature = cfg.NODE_SEED.sign(sigBody);
+    return newMsg;
 }
 
 void
@@ -1017,9 +1157,20 @@ SurveyManager::topOffRequests(SurveyMessageCommandType type)
     // rate limit) on any node relaying requests on the network (NB: can still
     // happen if some connections get congested)
 
+    // With BACKGROUND_SURVEY_PROCESSING, the requests (and the responses
+    // they bring) wait for the next top off while the main thread is
+    // overloaded
+    uint32_t requestLimit = MAX_REQUEST_LIMIT_PER_LEDGER;
+    if (mApp.getConfig().BACKGROUND_SURVEY_PROCESSING &&
+        mApp.getClock().actionQueueIsOverloaded())
+    {
+        CLOG_DEBUG(Overlay, "Main thread overloaded, delaying survey requests");
+        requestLimit = 0;
+    }
+
     uint32_t requestsSentInSchedule = 0;
     while (mRunningSurveyReportingPhaseType &&
-           requestsSentInSchedule < MAX_REQUEST_LIMIT_PER_LEDGER &&
+           requestsSentInSchedule < requestLimit &&
            !mPeersToSurvey.empty())
     {
         if (mPeersToSurveyQueue.empty())
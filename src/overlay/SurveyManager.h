@@ -27,6 +27,9 @@ class SurveyManager : public std::enable_shared_from_this<SurveyManager>,
 {
   public:
     static uint32_t const SURVEY_THROTTLE_TIMEOUT_MULT;
+    // With BACKGROUND_SURVEY_PROCESSING, the most responses waiting for a
+    // background thread to be encrypted or decrypted
+    static constexpr size_t MAX_PENDING_BACKGROUND_RESPONSES = 64;
 
     SurveyManager(Application& app);
 
@@ -99,13 +102,26 @@ class SurveyManager : public std::enable_shared_from_this<SurveyManager>,
                                            SurveyResponseBody const& body);
     void processTimeSlicedTopologyRequest(
         TimeSlicedSurveyRequestMessage const& request);
+    void processResponseBody(MessageType type, NodeID const& surveyedPeerID,
+                             SurveyResponseBody const& body);
+    // Decrypt `response` on a background thread, and process it back on the
+    // main thread if the survey is still running
+    void decryptResponseInBackground(MessageType type,
+                                     SurveyResponseMessage const& response);
 
     // Populate `response` with the data from the other parameters.  Returns
-    // `false` on encryption failure.
-    bool populateSurveyResponseMessage(SurveyRequestMessage const& request,
-                                       SurveyMessageCommandType type,
-                                       SurveyResponseBody const& body,
-                                       SurveyResponseMessage& response) const;
+    // `false` on encryption failure. Safe to call from any thread.
+    static bool
+    populateSurveyResponseMessage(Config const& cfg,
+                                  SurveyRequestMessage const& request,
+                                  SurveyMessageCommandType type,
+                                  SurveyResponseBody const& body,
+                                  SurveyResponseMessage& response);
+    // Encrypted and signed response to `request`, or nullopt on encryption
+    // failure. Safe to call from any thread.
+    static std::optional<StellarMessage> makeTimeSlicedTopologyResponse(
+        Config const& cfg, TimeSlicedSurveyRequestMessage const& request,
+        SurveyResponseBody const& body);
 
     // Populate `request` with the data from the other parameters
     void populateSurveyRequestMessage(NodeID const& nodeToSurvey,
@@ -177,6 +193,10 @@ class SurveyManager : public std::enable_shared_from_this<SurveyManager>,
     UnorderedSet<NodeID> mBadResponseNodes;
     Json::Value mResults;
 
+    // Responses encrypted or decrypted on background threads and not yet
+    // back on the main thread
+    size_t mPendingBackgroundResponses{0};
+
     // Manager for time-sliced survey data
     SurveyDataManager mSurveyDataManager;
 };
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/TCPPeer.h"
+#include "crypto/ByteSlice.h"
 #include "crypto/CryptoError.h"
 #include "database/Database.h"
 #include "main/Application.h"
@@ -15,8 +16,8 @@
 #include "util/GlobalChecks.h"
 #include "util/LogSlowExecution.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 using namespace soci;
@@ -26,6 +27,32 @@ namespace stellar
 
 using namespace std;
 
+namespace
+{
+// Keep at most `lowat` bytes that the kernel hasn't sent yet in the socket
+// buffer, so that a batch of bulk messages waits in the queues of the peer,
+// where more urgent messages can still be written before it
+void
+setNotSentLowWatermark(asio::ip::tcp::socket& socket, int lowat)
+{
+#ifdef TCP_NOTSENT_LOWAT
+    if (lowat == 0)
+    {
+        return;
+    }
+    asio::detail::socket_option::integer<IPPROTO_TCP, TCP_NOTSENT_LOWAT>
+        option(lowat);
+    asio::error_code ec;
+    std::ignore = socket.set_option(option, ec);
+    if (ec)
+    {
+        CLOG_DEBUG(Overlay, "Could not set TCP_NOTSENT_LOWAT: {}",
+                   ec.message());
+    }
+#endif
+}
+}
+
 ///////////////////////////////////////////////////////////////////////
 // TCPPeer
 ///////////////////////////////////////////////////////////////////////
@@ -55,8 +82,9 @@ TCPPeer::initiate(Application& app, PeerBareAddress const& address)
     result->initialize(address);
     asio::ip::tcp::endpoint endpoint(
         asio::ip::address::from_string(address.getIP()), address.getPort());
+    int lowat = app.getConfig().PEER_TCP_NOTSENT_LOWAT;
     socket->next_layer().async_connect(
-        endpoint, [result](asio::error_code const& error) {
+        endpoint, [result, lowat](asio::error_code const& error) {
             // Handler is invoked asynchronously, so check if connection got
             // dropped in the meantime
             if (result->shouldAbort())
@@ -73,6 +101,7 @@ TCPPeer::initiate(Application& app, PeerBareAddress const& address)
                     result->mSocket->next_layer().set_option(nodelay, ec);
                 std::ignore =
                     result->mSocket->next_layer().set_option(linger, lingerEc);
+                setNotSentLowWatermark(result->mSocket->next_layer(), lowat);
             }
             else
             {
@@ -130,6 +159,8 @@ TCPPeer::accept(Application& app, shared_ptr<TCPPeer::SocketType> socket)
     asio::ip::tcp::socket::linger linger(false, 0);
     std::ignore = socket->next_layer().set_option(nodelay, ec);
     std::ignore = socket->next_layer().set_option(linger, lingerEc);
+    setNotSentLowWatermark(socket->next_layer(),
+                           app.getConfig().PEER_TCP_NOTSENT_LOWAT);
 
     if (!ec && !lingerEc)
     {
@@ -192,6 +223,109 @@ TCPPeer::sendMessage(xdr::msg_ptr&& xdrBytes)
     }
 }
 
+size_t
+TCPPeer::sendPriority(StellarMessage const& msg)
+{
+    switch (msg.type())
+    {
+    case SCP_MESSAGE:
+    case SCP_QUORUMSET:
+    case GET_SCP_QUORUMSET:
+    case GET_SCP_STATE:
+    case SEND_MORE:
+    case SEND_MORE_EXTENDED:
+        return 0;
+    case TX_SET:
+    case GENERALIZED_TX_SET:
+    case GET_TX_SET:
+    case DONT_HAVE:
+        return 1;
+    case TRANSACTION:
+    case FLOOD_DEMAND:
+        return 2;
+    default:
+        return 3;
+    }
+}
+
+void
+TCPPeer::sendAuthenticatedMessage(std::shared_ptr<StellarMessage const> msg)
+{
+    releaseAssert(threadIsMain());
+    // Nothing to reorder with when the socket is idle. Handshake and error
+    // messages go right away.
+    if (!mAppConnector.getConfig().OUTBOUND_PRIORITY_SCHEDULING ||
+        !mWriting || shouldAbort() || msg->type() == HELLO ||
+        msg->type() == AUTH || msg->type() == ERROR_MSG)
+    {
+        Peer::sendAuthenticatedMessage(msg);
+        return;
+    }
+
+    auto size = static_cast<size_t>(xdr::xdr_size(*msg));
+    mPendingSends[sendPriority(*msg)].emplace_back(
+        PendingMessage{std::move(msg), mAppConnector.now(), size});
+}
+
+void
+TCPPeer::schedulePendingSends()
+{
+    ZoneScoped;
+    releaseAssert(mWriteQueue.empty());
+    if (shouldAbort())
+    {
+        for (auto& q : mPendingSends)
+        {
+            q.clear();
+        }
+        return;
+    }
+
+    static constexpr std::array<size_t, NUM_SEND_PRIORITIES> WEIGHTS = {8, 4,
+                                                                        2, 1};
+    size_t const totalWeight = 8 + 4 + 2 + 1;
+    auto const& cfg = mAppConnector.getConfig();
+    size_t const maxBytes = static_cast<size_t>(cfg.MAX_BATCH_WRITE_BYTES);
+    size_t const maxCount = static_cast<size_t>(cfg.MAX_BATCH_WRITE_COUNT);
+    size_t bytes = 0;
+    size_t count = 0;
+
+    auto take = [&](std::deque<PendingMessage>& q) {
+        auto pending = std::move(q.front());
+        q.pop_front();
+        bytes += pending.mSize;
+        ++count;
+        Peer::sendAuthenticatedMessage(pending.mMessage);
+        // Account for the time spent waiting here in the write queue delay
+        releaseAssert(!mWriteQueue.empty());
+        mWriteQueue.back().mEnqueuedTime = pending.mEnqueuedTime;
+    };
+
+    // First, every priority with messages waiting gets its share of the
+    // write, and at least one message, so that none of them starves...
+    for (size_t p = 0; p < NUM_SEND_PRIORITIES; ++p)
+    {
+        auto& q = mPendingSends[p];
+        size_t const share = maxBytes * WEIGHTS[p] / totalWeight;
+        size_t used = 0;
+        while (!q.empty() && count < maxCount &&
+               (used == 0 || used + q.front().mSize <= share))
+        {
+            used += q.front().mSize;
+            take(q);
+        }
+    }
+    // ...then the rest of the write goes by strict priority
+    for (auto& q : mPendingSends)
+    {
+        while (!q.empty() && count < maxCount &&
+               bytes + q.front().mSize <= maxBytes)
+        {
+            take(q);
+        }
+    }
+}
+
 void
 TCPPeer::shutdown()
 {
@@ -262,6 +396,11 @@ TCPPeer::messageSender()
     ZoneScoped;
     releaseAssert(threadIsMain());
 
+    if (mWriteQueue.empty())
+    {
+        schedulePendingSends();
+    }
+
     // if nothing to do, mark progress and return.
     if (mWriteQueue.empty())
     {
@@ -275,27 +414,36 @@ TCPPeer::messageSender()
         return;
     }
 
-    // Take a snapshot of the contents of mWriteQueue into mWriteBuffers, in
-    // terms of asio::const_buffers pointing into the elements of mWriteQueue,
-    // and then issue a single multi-buffer ("scatter-gather") async_write that
-    // covers the whole snapshot. We'll get called back when the batch is
-    // completed, at which point we'll clear mWriteBuffers and remove the entire
-    // snapshot worth of corresponding messages from mWriteQueue (though it may
-    // have grown a bit in the meantime -- we remove only a prefix).
+    // Take a snapshot of a prefix of mWriteQueue, and then issue a single
+    // multi-buffer ("scatter-gather") async_write that covers the whole
+    // snapshot. mWriteBuffers points into the elements of mWriteQueue, except
+    // for runs of small messages which are first copied together into
+    // mCoalescedWrites: asio sends at most 64 buffers per syscall, so a batch
+    // of many small messages would otherwise take many syscalls. We'll get
+    // called back when the batch is completed, at which point we'll clear
+    // mWriteBuffers and remove the entire snapshot worth of corresponding
+    // messages from mWriteQueue (though it may have grown a bit in the
+    // meantime -- we remove only a prefix).
     releaseAssert(mWriteBuffers.empty());
     auto now = mAppConnector.now();
     size_t expected_length = 0;
+    size_t coalesced_length = 0;
+    size_t nMessages = 0;
     size_t maxQueueSize = mAppConnector.getConfig().MAX_BATCH_WRITE_COUNT;
     releaseAssert(maxQueueSize > 0);
     size_t const maxTotalBytes =
         mAppConnector.getConfig().MAX_BATCH_WRITE_BYTES;
+    auto coalesce = [&](TimestampedMessage const& tsm) {
+        size_t sz = tsm.mMessage->raw_size();
+        return nMessages > 1 && sz < MAX_COALESCED_MESSAGE_BYTES &&
+               coalesced_length + sz <= MAX_COALESCED_WRITE_BYTES;
+    };
     for (auto& tsm : mWriteQueue)
     {
         tsm.mIssuedTime = now;
-        size_t sz = tsm.mMessage->raw_size();
-        mWriteBuffers.emplace_back(tsm.mMessage->raw_data(), sz);
-        expected_length += sz;
+        expected_length += tsm.mMessage->raw_size();
         mEnqueueTimeOfLastWrite = tsm.mEnqueuedTime;
+        ++nMessages;
         // check if we reached any limit
         if (expected_length >= maxTotalBytes)
             break;
@@ -303,15 +451,55 @@ TCPPeer::messageSender()
             break;
     }
 
-    CLOG_DEBUG(Overlay, "messageSender {} - b:{} n:{}/{}", toString(),
-               expected_length, mWriteBuffers.size(), mWriteQueue.size());
+    // Reserve the space first, so that the buffers pointing into
+    // mCoalescedWrites stay valid
+    auto end = mWriteQueue.begin() + nMessages;
+    for (auto it = mWriteQueue.begin(); it != end; ++it)
+    {
+        if (coalesce(*it))
+        {
+            coalesced_length += it->mMessage->raw_size();
+        }
+    }
+    mCoalescedWrites.resize(coalesced_length);
+    coalesced_length = 0;
+    uint8_t* runStart = mCoalescedWrites.data();
+    uint8_t* runEnd = runStart;
+    for (auto it = mWriteQueue.begin(); it != end; ++it)
+    {
+        size_t sz = it->mMessage->raw_size();
+        if (coalesce(*it))
+        {
+            std::memcpy(runEnd, it->mMessage->raw_data(), sz);
+            runEnd += sz;
+            coalesced_length += sz;
+            continue;
+        }
+        if (runEnd != runStart)
+        {
+            mWriteBuffers.emplace_back(runStart, runEnd - runStart);
+            runStart = runEnd;
+        }
+        mWriteBuffers.emplace_back(it->mMessage->raw_data(), sz);
+    }
+    if (runEnd != runStart)
+    {
+        mWriteBuffers.emplace_back(runStart, runEnd - runStart);
+    }
+
+    CLOG_DEBUG(Overlay, "messageSender {} - b:{} n:{}/{} buffers:{}",
+               toString(), expected_length, nMessages, mWriteQueue.size(),
+               mWriteBuffers.size());
     mOverlayMetrics.mAsyncWrite.Mark();
+    mOverlayMetrics.mWriteBatchBytes.Update(expected_length);
+    mOverlayMetrics.mWriteBatchMessages.Update(nMessages);
+    mOverlayMetrics.mWriteBatchBuffers.Update(mWriteBuffers.size());
     mPeerMetrics.mAsyncWrite++;
     auto self = static_pointer_cast<TCPPeer>(shared_from_this());
     asio::async_write(
         *(mSocket.get()), mWriteBuffers,
-        [self, expected_length](asio::error_code const& ec,
-                                std::size_t length) {
+        [self, expected_length, nMessages](asio::error_code const& ec,
+                                           std::size_t length) {
             if (expected_length != length)
             {
                 self->drop("error during async_write",
@@ -319,23 +507,22 @@ TCPPeer::messageSender()
                            Peer::DropMode::IGNORE_WRITE_QUEUE);
                 return;
             }
-            self->writeHandler(ec, length, self->mWriteBuffers.size());
+            self->writeHandler(ec, length, nMessages);
 
-            // Walk through a _prefix_ of the write queue
-            // _corresponding_ to the write buffers we just sent.
+            // Walk through the _prefix_ of the write queue we just sent.
             // While walking, record the sent-time in metrics, but
             // also advance iterator 'i' so we wind up with an
             // iterator range to erase from the front of the write
             // queue.
             auto now = self->mAppConnector.now();
             auto i = self->mWriteQueue.begin();
-            while (!self->mWriteBuffers.empty())
+            for (size_t n = 0; n < nMessages; ++n)
             {
                 i->mCompletedTime = now;
                 i->recordWriteTiming(self->mOverlayMetrics, self->mPeerMetrics);
                 ++i;
-                self->mWriteBuffers.pop_back();
             }
+            self->mWriteBuffers.clear();
 
             // Erase the messages from the write queue that we
             // just forgot about the buffers for.
@@ -463,7 +650,7 @@ TCPPeer::scheduleRead()
     // this will be throttled to try to balance input rates across peers.
     ZoneScoped;
 
-    if (mFlowControl->isThrottled())
+    if (mFlowControl->isThrottled() || mDecoding)
     {
         return;
     }
@@ -504,6 +691,17 @@ TCPPeer::startRead()
     // _synchronously_ as we can before we issue an async_read against ASIO.
     while (mSocket->in_avail() >= HDRSZ)
     {
+        if (mDecodeBatch)
+        {
+            // Only add messages that can be read whole right away to the
+            // batch, the next one will be read once it has been decoded
+            mSocket->peek(asio::buffer(mIncomingHeader));
+            if (mSocket->in_avail() < HDRSZ + getIncomingMsgLength())
+            {
+                break;
+            }
+        }
+
         asio::error_code ec_hdr, ec_body;
         size_t n = mSocket->read_some(asio::buffer(mIncomingHeader), ec_hdr);
         if (ec_hdr)
@@ -540,6 +738,10 @@ TCPPeer::startRead()
                 }
                 noteFullyReadBody(length);
                 recvMessage();
+                if (decodeBatchIsFull())
+                {
+                    break;
+                }
                 if (!canRead())
                 {
                     // Break and wait until more capacity frees up
@@ -570,7 +772,11 @@ TCPPeer::startRead()
         }
     }
 
-    if (mSocket->in_avail() < HDRSZ)
+    if (mDecodeBatch)
+    {
+        decodeInBackground();
+    }
+    else if (mSocket->in_avail() < HDRSZ)
     {
         // If there wasn't enough readable in the buffered stream to even get a
         // header (message length), issue an async_read and hope that the
@@ -627,8 +833,18 @@ bool
 TCPPeer::sendQueueIsOverloaded() const
 {
     auto now = mAppConnector.now();
-    return (!mWriteQueue.empty() && (now - mWriteQueue.front().mEnqueuedTime) >
-                                        SCHEDULER_LATENCY_WINDOW);
+    auto overloaded = [&](VirtualClock::time_point enqueuedTime) {
+        return (now - enqueuedTime) > SCHEDULER_LATENCY_WINDOW;
+    };
+    if (!mWriteQueue.empty() && overloaded(mWriteQueue.front().mEnqueuedTime))
+    {
+        return true;
+    }
+    return std::any_of(mPendingSends.begin(), mPendingSends.end(),
+                       [&](auto const& q) {
+                           return !q.empty() &&
+                                  overloaded(q.front().mEnqueuedTime);
+                       });
 }
 
 void
@@ -651,6 +867,16 @@ TCPPeer::readHeaderHandler(asio::error_code const& error,
         if (expected_length != 0)
         {
             mIncomingBody.resize(expected_length);
+            if (mSocket->in_avail() >= expected_length)
+            {
+                // The read that completed the header filled the buffer with
+                // the whole body too: skip a round trip through the event
+                // loop for it
+                asio::error_code ec;
+                size_t n = mSocket->read_some(asio::buffer(mIncomingBody), ec);
+                readBodyHandler(ec, n, expected_length);
+                return;
+            }
             auto self = static_pointer_cast<TCPPeer>(shared_from_this());
             asio::async_read(*mSocket.get(), asio::buffer(mIncomingBody),
                              [self, expected_length](asio::error_code ec,
@@ -682,6 +908,11 @@ TCPPeer::readBodyHandler(asio::error_code const& error,
         noteFullyReadBody(bytes_transferred);
         recvMessage();
         mIncomingHeader.clear();
+        if (mDecodeBatch)
+        {
+            decodeInBackground();
+            return;
+        }
         // Completing a startRead => readHeaderHandler => readBodyHandler
         // sequence happens after the first read of a single large input-buffer
         // worth of input. Even when we weren't preempted, we still bounce off
@@ -707,6 +938,24 @@ TCPPeer::recvMessage()
     releaseAssert(threadIsMain());
     releaseAssert(canRead());
 
+    // Messages being decoded in the background come first
+    if (!mDecoding && !mDecodeBatch && maybeDropKnownTransaction(mIncomingBody))
+    {
+        return;
+    }
+
+    if (getState() == GOT_AUTH &&
+        mAppConnector.getConfig().BACKGROUND_OVERLAY_DECODE)
+    {
+        if (!mDecodeBatch)
+        {
+            mDecodeBatch = std::make_shared<DecodeBatch>();
+        }
+        mDecodeBatch->mBodies.emplace_back(std::move(mIncomingBody));
+        mIncomingBody.clear();
+        return;
+    }
+
     try
     {
         xdr::xdr_get g(mIncomingBody.data(),
@@ -731,6 +980,126 @@ TCPPeer::recvMessage()
     }
 }
 
+bool
+TCPPeer::decodeBatchIsFull() const
+{
+    // Each message read takes one unit of the reading capacity when it is
+    // processed, which must not run out in the middle of a batch
+    return mDecodeBatch && mDecodeBatch->mBodies.size() >=
+                               mFlowControl->getNumMessagesCanRead();
+}
+
+static void
+decodeBatch(TCPPeer::DecodeBatch& batch, HmacSha256Key const& recvMacKey,
+            uint64_t recvMacSeq)
+{
+    ZoneScoped;
+    for (auto const& body : batch.mBodies)
+    {
+        try
+        {
+            xdr::xdr_get g(body.data(), body.data() + body.size());
+            AuthenticatedMessage am;
+            xdr::xdr_argpack_archive(g, am);
+
+            if (am.v0().message.type() != ERROR_MSG)
+            {
+                auto err =
+                    Peer::checkMessageAuth(am, recvMacKey, recvMacSeq++);
+                if (err)
+                {
+                    batch.mErrorCode = ERR_AUTH;
+                    batch.mError = err;
+                    break;
+                }
+            }
+            batch.mMessages.emplace_back(std::move(am));
+        }
+        catch (xdr::xdr_runtime_error& e)
+        {
+            batch.mErrorCode = ERR_DATA;
+            batch.mError = "received corrupt XDR";
+            batch.mErrorDetail = e.what();
+            break;
+        }
+        catch (CryptoError const& e)
+        {
+            batch.mErrorCode = ERR_DATA;
+            batch.mError = "crypto error";
+            batch.mErrorDetail = e.what();
+            break;
+        }
+    }
+    batch.mBodies.clear();
+}
+
+void
+TCPPeer::decodeInBackground()
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    releaseAssert(mDecodeBatch && !mDecoding);
+
+    mDecoding = true;
+    auto batch = std::move(mDecodeBatch);
+    mDecodeBatch.reset();
+    auto self = static_pointer_cast<TCPPeer>(shared_from_this());
+    mAppConnector.postOnOverlayThread(
+        [batch, key = mRecvMacKey, seq = mRecvMacSeq]() {
+            decodeBatch(*batch, key, seq);
+        },
+        [self, batch]() { self->recvDecodedBatch(*batch); },
+        fmt::format(FMT_STRING("TCPPeer::decodeBatch for {}"), toString()));
+}
+
+void
+TCPPeer::recvDecodedBatch(DecodeBatch& batch)
+{
+    ZoneScoped;
+    releaseAssert(threadIsMain());
+    mDecoding = false;
+
+    for (auto& am : batch.mMessages)
+    {
+        if (shouldAbort())
+        {
+            return;
+        }
+        try
+        {
+            Peer::recvVerifiedMessage(std::move(am));
+        }
+        catch (CryptoError const& e)
+        {
+            CLOG_ERROR(Overlay, "{} - Crypto error: {}", toString(), e.what());
+            sendErrorAndDrop(ERR_DATA, "crypto error",
+                             Peer::DropMode::IGNORE_WRITE_QUEUE);
+            return;
+        }
+    }
+
+    if (shouldAbort())
+    {
+        return;
+    }
+    if (batch.mErrorCode)
+    {
+        CLOG_ERROR(Overlay, "{} - recvMessage {}: {}", toString(), batch.mError,
+                   batch.mErrorDetail);
+        sendErrorAndDrop(*batch.mErrorCode, batch.mError,
+                         Peer::DropMode::IGNORE_WRITE_QUEUE);
+        return;
+    }
+    if (!canRead())
+    {
+        CLOG_DEBUG(Overlay, "Throttle reading from peer {}!",
+                   mAppConnector.getConfig().toShortString(getPeerID()));
+        mFlowControl->throttleRead();
+        return;
+    }
+    scheduleRead();
+}
+
 void
 TCPPeer::drop(std::string const& reason, DropDirection dropDirection,
               DropMode dropMode)
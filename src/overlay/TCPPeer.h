@@ -6,7 +6,9 @@
 
 #include "overlay/Peer.h"
 #include "util/Timer.h"
+#include <array>
 #include <deque>
+#include <optional>
 
 namespace medida
 {
@@ -24,6 +26,22 @@ class TCPPeer : public Peer
   public:
     typedef asio::buffered_read_stream<asio::ip::tcp::socket> SocketType;
     static constexpr size_t BUFSZ = 0x40000; // 256KB
+    // Messages below this size are coalesced into at most
+    // MAX_COALESCED_WRITE_BYTES per write batch
+    static constexpr size_t MAX_COALESCED_MESSAGE_BYTES = 0x1000; // 4KB
+    static constexpr size_t MAX_COALESCED_WRITE_BYTES = 0x10000;  // 64KB
+
+    // Messages read in one go when BACKGROUND_OVERLAY_DECODE is set, decoded
+    // and authenticated together on the overlay thread
+    struct DecodeBatch
+    {
+        std::vector<std::vector<uint8_t>> mBodies;
+        std::vector<AuthenticatedMessage> mMessages;
+        // Set if decoding stopped at a message that failed it
+        std::optional<ErrorCode> mErrorCode;
+        std::string mError;
+        std::string mErrorDetail;
+    };
 
   private:
     std::shared_ptr<SocketType> mSocket;
@@ -31,15 +49,44 @@ class TCPPeer : public Peer
     std::vector<uint8_t> mIncomingBody;
 
     std::vector<asio::const_buffer> mWriteBuffers;
+    // Small messages of the write batch are copied together here, so that a
+    // batch of many of them takes a few buffers of a single write syscall
+    std::vector<uint8_t> mCoalescedWrites;
     std::deque<TimestampedMessage> mWriteQueue;
+
+    // With OUTBOUND_PRIORITY_SCHEDULING, messages sent while a write is in
+    // progress, by priority. They only get their MAC sequence number when
+    // they move to mWriteQueue, which is why they can still be reordered.
+    struct PendingMessage
+    {
+        std::shared_ptr<StellarMessage const> mMessage;
+        VirtualClock::time_point mEnqueuedTime;
+        size_t mSize;
+    };
+    static constexpr size_t NUM_SEND_PRIORITIES = 4;
+    std::array<std::deque<PendingMessage>, NUM_SEND_PRIORITIES> mPendingSends;
+
     bool mWriting{false};
     bool mDelayedShutdown{false};
     bool mShutdownScheduled{false};
 
+    // Messages read but not yet sent to the overlay thread, and whether a
+    // batch is being decoded there. Reading stops until it comes back, which
+    // bounds the messages waiting for the main thread to one batch per peer.
+    std::shared_ptr<DecodeBatch> mDecodeBatch;
+    bool mDecoding{false};
+
     void recvMessage();
+    bool decodeBatchIsFull() const;
+    void decodeInBackground();
+    void recvDecodedBatch(DecodeBatch& batch);
     void sendMessage(xdr::msg_ptr&& xdrBytes) override;
 
     void messageSender();
+    void sendAuthenticatedMessage(
+        std::shared_ptr<StellarMessage const> msg) override;
+    // Move pending messages to the empty mWriteQueue for the next write
+    void schedulePendingSends();
 
     size_t getIncomingMsgLength();
     virtual void connected() override;
@@ -97,6 +144,24 @@ class TCPPeer : public Peer
                                                  // `initiate` or
                                                  // `accept` instead
 
+    // 0 for SCP and flow control messages, 1 for tx sets, 2 for
+    // transactions and demands, 3 for adverts and everything else
+    static size_t sendPriority(StellarMessage const& msg);
+
+#ifdef BUILD_TESTS
+    size_t
+    getPendingSendCount(size_t priority) const
+    {
+        return mPendingSends.at(priority).size();
+    }
+
+    SocketType&
+    getSocketForTesting()
+    {
+        return *mSocket;
+    }
+#endif
+
     static pointer initiate(Application& app, PeerBareAddress const& address);
     static pointer accept(Application& app, std::shared_ptr<SocketType> socket);
 
@@ -9,27 +9,34 @@
 #include "crypto/Hex.h"
 #include "herder/Herder.h"
 #include "main/Application.h"
+#include "main/Config.h"
 #include "medida/meter.h"
 #include "overlay/OverlayManager.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Math.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
 
 namespace stellar
 {
 
 std::chrono::milliseconds const Tracker::MS_TO_WAIT_FOR_FETCH_REPLY{1500};
 int const Tracker::MAX_REBUILD_FETCH_LIST = 10;
+std::chrono::milliseconds const Tracker::MIN_HEDGE_DELAY{100};
+std::chrono::milliseconds const Tracker::MAX_HEDGE_DELAY{500};
 
 Tracker::Tracker(Application& app, Hash const& hash, AskPeer& askPeer)
     : mAskPeer(askPeer)
     , mApp(app)
     , mNumListRebuild(0)
     , mTimer(app)
+    , mHedgeTimer(app)
     , mItemHash(hash)
     , mTryNextPeer(
           app.getOverlayManager().getOverlayMetrics().mItemFetcherNextPeer)
+    , mHedge(app.getOverlayManager().getOverlayMetrics().mItemFetcherHedge)
     , mFetchTime("fetch-" + hexAbbrev(hash), LogSlowExecution::Mode::MANUAL)
 {
     releaseAssert(mAskPeer);
@@ -72,7 +79,8 @@ Tracker::clearEnvelopesBelow(uint64 slotIndex, uint64 slotToKeep)
     }
 
     mTimer.cancel();
-    mLastAskedPeer = nullptr;
+    mHedgeTimer.cancel();
+    mPeersInFlight.clear();
 
     return false;
 }
@@ -80,11 +88,21 @@ Tracker::clearEnvelopesBelow(uint64 slotIndex, uint64 slotToKeep)
 void
 Tracker::doesntHave(Peer::pointer peer)
 {
-    if (mLastAskedPeer == peer)
+    auto it = std::find(mPeersInFlight.begin(), mPeersInFlight.end(), peer);
+    if (it == mPeersInFlight.end())
+    {
+        return;
+    }
+    CLOG_TRACE(Overlay, "Does not have {}", hexAbbrev(mItemHash));
+    if (mPeersInFlight.size() == 1)
     {
-        CLOG_TRACE(Overlay, "Does not have {}", hexAbbrev(mItemHash));
         tryNextPeer();
     }
+    else
+    {
+        // other peers may still answer
+        mPeersInFlight.erase(it);
+    }
 }
 
 void
@@ -94,18 +112,102 @@ Tracker::tryNextPeer()
     // will be called by some timer or when we get a
     // response saying they don't have it
     CLOG_TRACE(Overlay, "tryNextPeer {} last: {}", hexAbbrev(mItemHash),
-               (mLastAskedPeer ? mLastAskedPeer->toString() : "<none>"));
+               (mPeersInFlight.empty() ? "<none>"
+                                       : mPeersInFlight.back()->toString()));
 
-    if (mLastAskedPeer)
+    if (!mPeersInFlight.empty())
     {
         mTryNextPeer.Mark();
-        mLastAskedPeer.reset();
+        mPeersInFlight.clear();
+    }
+    mHedgeTimer.cancel();
+
+    bool peerHas = false;
+    auto peer = pickPeer(peerHas);
+
+    std::chrono::milliseconds nextTry;
+    if (!peer)
+    {
+        // we have asked all our peers, reset the list and try again after a
+        // pause
+        mNumListRebuild++;
+        mPeersAsked.clear();
+
+        CLOG_TRACE(Overlay, "tryNextPeer {} restarting fetch #{}",
+                   hexAbbrev(mItemHash), mNumListRebuild);
+
+        nextTry = MS_TO_WAIT_FOR_FETCH_REPLY *
+                  std::min(MAX_REBUILD_FETCH_LIST, mNumListRebuild);
+    }
+    else
+    {
+        ask(peer, peerHas);
+        scheduleHedge();
+        nextTry = MS_TO_WAIT_FOR_FETCH_REPLY;
+    }
+
+    mTimer.expires_from_now(nextTry);
+    mTimer.async_wait([this]() { this->tryNextPeer(); },
+                      VirtualTimer::onFailureNoop);
+}
+
+void
+Tracker::ask(Peer::pointer const& peer, bool peerHas)
+{
+    mPeersAsked[peer] = peerHas;
+    mPeersInFlight.emplace_back(peer);
+    CLOG_TRACE(Overlay, "Asking for {} to {}", hexAbbrev(mItemHash),
+               peer->toString());
+    mAskPeer(peer, mItemHash);
+}
+
+void
+Tracker::scheduleHedge()
+{
+    if (mPeersInFlight.empty() ||
+        mPeersInFlight.size() >= mApp.getConfig().MAX_PARALLEL_FETCH_PEERS)
+    {
+        return;
     }
+    // a peer that answers at all usually does so within a couple of round
+    // trips, past that it's worth asking someone else too
+    auto delay = std::clamp(2 * mPeersInFlight.back()->getPing(),
+                            MIN_HEDGE_DELAY, MAX_HEDGE_DELAY);
+    mHedgeTimer.expires_from_now(delay);
+    mHedgeTimer.async_wait([this]() { this->hedge(); },
+                           VirtualTimer::onFailureNoop);
+}
 
-    auto canAskPeer = [&](Peer::pointer const& p, bool peerHas) {
+void
+Tracker::hedge()
+{
+    ZoneScoped;
+    bool peerHas = false;
+    auto peer = pickPeer(peerHas);
+    if (!peer)
+    {
+        // keep waiting on the peers already asked
+        return;
+    }
+    CLOG_TRACE(Overlay, "Asking another peer for {}", hexAbbrev(mItemHash));
+    mHedge.Mark();
+    ask(peer, peerHas);
+    scheduleHedge();
+}
+
+Peer::pointer
+Tracker::pickPeer(bool& peerHas)
+{
+    ZoneScoped;
+    auto canAskPeer = [&](Peer::pointer const& p, bool hasData) {
+        if (std::find(mPeersInFlight.begin(), mPeersInFlight.end(), p) !=
+            mPeersInFlight.end())
+        {
+            return false;
+        }
         auto it = mPeersAsked.find(p);
         return (p->isAuthenticated() &&
-                (it == mPeersAsked.end() || (peerHas && !it->second)));
+                (it == mPeersAsked.end() || (hasData && !it->second)));
     };
 
     // Helper function to populate "candidates" with a set of peers, which we're
@@ -177,37 +279,12 @@ Tracker::tryNextPeer()
     }
 
     // pick a random element from the candidate list
-    if (!candidates.empty())
-    {
-        mLastAskedPeer = rand_element(candidates);
-    }
-
-    std::chrono::milliseconds nextTry;
-    if (!mLastAskedPeer)
+    if (candidates.empty())
     {
-        // we have asked all our peers, reset the list and try again after a
-        // pause
-        mNumListRebuild++;
-        mPeersAsked.clear();
-
-        CLOG_TRACE(Overlay, "tryNextPeer {} restarting fetch #{}",
-                   hexAbbrev(mItemHash), mNumListRebuild);
-
-        nextTry = MS_TO_WAIT_FOR_FETCH_REPLY *
-                  std::min(MAX_REBUILD_FETCH_LIST, mNumListRebuild);
-    }
-    else
-    {
-        mPeersAsked[mLastAskedPeer] = peerWithEnvelopeSelected;
-        CLOG_TRACE(Overlay, "Asking for {} to {}", hexAbbrev(mItemHash),
-                   mLastAskedPeer->toString());
-        mAskPeer(mLastAskedPeer, mItemHash);
-        nextTry = MS_TO_WAIT_FOR_FETCH_REPLY;
+        return nullptr;
     }
-
-    mTimer.expires_from_now(nextTry);
-    mTimer.async_wait([this]() { this->tryNextPeer(); },
-                      VirtualTimer::onFailureNoop);
+    peerHas = peerWithEnvelopeSelected;
+    return rand_element(candidates);
 }
 
 static std::function<bool(std::pair<Hash, SCPEnvelope> const&)>
@@ -259,6 +336,7 @@ void
 Tracker::cancel()
 {
     mTimer.cancel();
+    mHedgeTimer.cancel();
     mLastSeenSlotIndex = 0;
 }
 
@@ -14,6 +14,10 @@
  *
  * For asking a AskPeer delegate is used.
  *
+ * When MAX_PARALLEL_FETCH_PEERS is above 1 and the peers asked are slow to
+ * answer, more peers are asked in parallel, each after a delay based on the
+ * round trip time of the peer asked before. The first answer is used.
+ *
  * Tracker keeps list of envelopes that requires given data set to be
  * fully resolved. When data is received each envelope is resend to Herder
  * so it can check if it has all required data and then process envelope.
@@ -42,21 +46,36 @@ class Tracker
   private:
     AskPeer mAskPeer;
     Application& mApp;
-    Peer::pointer mLastAskedPeer;
+    // peers asked since the last call to tryNextPeer, in the order they were
+    // asked, that didn't say they don't have the data
+    std::vector<Peer::pointer> mPeersInFlight;
     int mNumListRebuild;
     // keep track of which peer we asked, and if we thought if it had the data
     // or not at the time
     std::map<Peer::pointer, bool> mPeersAsked;
     VirtualTimer mTimer;
+    VirtualTimer mHedgeTimer;
     std::vector<std::pair<Hash, SCPEnvelope>> mWaitingEnvelopes;
     Hash mItemHash;
     medida::Meter& mTryNextPeer;
+    medida::Meter& mHedge;
     uint64 mLastSeenSlotIndex{0};
     LogSlowExecution mFetchTime;
 
+    // Returns a random peer among the closest ones that can be asked, or
+    // nullptr. `peerHas` is set if the peer is known to have the data.
+    Peer::pointer pickPeer(bool& peerHas);
+    void ask(Peer::pointer const& peer, bool peerHas);
+
+    // Asks one more peer in parallel unless enough of them are waited on
+    void scheduleHedge();
+    void hedge();
+
   public:
     static std::chrono::milliseconds const MS_TO_WAIT_FOR_FETCH_REPLY;
     static int const MAX_REBUILD_FETCH_LIST;
+    static std::chrono::milliseconds const MIN_HEDGE_DELAY;
+    static std::chrono::milliseconds const MAX_HEDGE_DELAY;
     /**
      * Create Tracker that tracks data identified by @p hash. @p askPeer
      * delegate is used to fetch the data.
@@ -160,7 +179,13 @@ class Tracker
     Peer::pointer
     getLastAskedPeer()
     {
-        return mLastAskedPeer;
+        return mPeersInFlight.empty() ? nullptr : mPeersInFlight.back();
+    }
+
+    std::vector<Peer::pointer> const&
+    getPeersInFlight() const
+    {
+        return mPeersInFlight;
     }
 #endif
 };
@@ -5,6 +5,8 @@
 #include "overlay/TxAdverts.h"
 #include "ledger/LedgerManager.h"
 #include "main/Application.h"
+#include "overlay/OverlayManager.h"
+#include "overlay/OverlayMetrics.h"
 #include "util/ProtocolVersion.h"
 #include <algorithm>
 
@@ -14,7 +16,10 @@ namespace stellar
 constexpr uint32 const ADVERT_CACHE_SIZE = 50000;
 
 TxAdverts::TxAdverts(Application& app)
-    : mApp(app), mAdvertHistory(ADVERT_CACHE_SIZE), mAdvertTimer(app)
+    : mApp(app)
+    , mAdvertHistory(ADVERT_CACHE_SIZE)
+    , mAdvertTimer(app)
+    , mDelayedAdvertTimer(app)
 {
 }
 
@@ -41,6 +46,7 @@ void
 TxAdverts::shutdown()
 {
     mAdvertTimer.cancel();
+    mDelayedAdvertTimer.cancel();
 }
 
 void
@@ -86,6 +92,69 @@ TxAdverts::queueOutgoingAdvert(Hash const& txHash)
     }
 }
 
+void
+TxAdverts::releaseDelayedAdvert(Hash const& txHash)
+{
+    if (seenAdvert(txHash))
+    {
+        mApp.getOverlayManager()
+            .getOverlayMetrics()
+            .mSuppressedAdvertMeter.Mark();
+    }
+    else
+    {
+        queueOutgoingAdvert(txHash);
+    }
+}
+
+void
+TxAdverts::flushDelayedAdverts()
+{
+    auto now = mApp.getClock().now();
+    while (!mDelayedTxHashes.empty() && mDelayedTxHashes.front().second <= now)
+    {
+        auto txHash = mDelayedTxHashes.front().first;
+        mDelayedTxHashes.pop_front();
+        releaseDelayedAdvert(txHash);
+    }
+    if (!mDelayedTxHashes.empty())
+    {
+        mDelayedAdvertTimer.expires_at(mDelayedTxHashes.front().second);
+        mDelayedAdvertTimer.async_wait([this](asio::error_code const& error) {
+            if (!error)
+            {
+                flushDelayedAdverts();
+            }
+        });
+    }
+}
+
+void
+TxAdverts::queueDelayedOutgoingAdvert(Hash const& txHash)
+{
+    auto const& cfg = mApp.getConfig();
+    bool wasEmpty = mDelayedTxHashes.empty();
+    mDelayedTxHashes.emplace_back(txHash,
+                                  mApp.getClock().now() +
+                                      cfg.FLOOD_ADVERT_PERIOD_MS +
+                                      cfg.FLOOD_DEMAND_PERIOD_MS);
+
+    // Don't hold back more than what an incoming queue can store, advertise
+    // the oldest hashes early instead
+    size_t const limit = mApp.getLedgerManager().getLastMaxTxSetSizeOps();
+    while (mDelayedTxHashes.size() > limit)
+    {
+        auto oldest = mDelayedTxHashes.front().first;
+        mDelayedTxHashes.pop_front();
+        releaseDelayedAdvert(oldest);
+    }
+
+    if (wasEmpty)
+    {
+        flushDelayedAdverts();
+    }
+}
+
 bool
 TxAdverts::seenAdvert(Hash const& hash)
 {
@@ -22,6 +22,10 @@ class Application;
 // we first check the first element in the retry queue. If the retry
 // queue is empty, then we look at mIncomingTxHashes and pop the first element.
 // Both mIncomingTxHashes and mTxHashesToRetry are FIFO.
+//
+// Outgoing adverts can also be held back for a while: on a well connected
+// node, most peers get a new transaction from someone else in that time and
+// advertise it to us, which makes our advert to them useless.
 
 class TxAdverts
 {
@@ -36,11 +40,16 @@ class TxAdverts
     RandomEvictionCache<Hash, uint32_t> mAdvertHistory;
     TxAdvertVector mOutgoingTxHashes;
     VirtualTimer mAdvertTimer;
+    // Held back outgoing hashes, with the time to advertise them
+    std::deque<std::pair<Hash, VirtualClock::time_point>> mDelayedTxHashes;
+    VirtualTimer mDelayedAdvertTimer;
     std::function<void(std::shared_ptr<StellarMessage const>)> mSendCb;
 
     void rememberHash(Hash const& hash, uint32_t ledgerSeq);
     void flushAdvert();
     void startAdvertTimer();
+    void releaseDelayedAdvert(Hash const& txHash);
+    void flushDelayedAdverts();
 
   public:
     TxAdverts(Application& app);
@@ -52,6 +61,10 @@ class TxAdverts
     popIncomingAdvert();
     // Queue up a transaction hash to advertise to neighbours
     void queueOutgoingAdvert(Hash const& txHash);
+    // Queue up a transaction hash to advertise to neighbours after
+    // FLOOD_ADVERT_PERIOD_MS + FLOOD_DEMAND_PERIOD_MS, unless they advertise
+    // it to us first
+    void queueDelayedOutgoingAdvert(Hash const& txHash);
     // Queue up a transaction hash from a neighbour to try demanding
     void queueIncomingAdvert(TxAdvertVector const& hash, uint32_t seq);
     // Queue up transaction hashes to retry demanding. Note: `list` becomes
@@ -72,6 +85,12 @@ class TxAdverts
     {
         return mOutgoingTxHashes.size();
     }
+
+    size_t
+    delayedSize() const
+    {
+        return mDelayedTxHashes.size();
+    }
 #endif
 
     static int64_t getOpsFloodLedger(size_t maxOps, double rate);
@@ -10,9 +10,11 @@
 #include "overlay/OverlayMetrics.h"
 #include "overlay/TxAdverts.h"
 #include "util/Logging.h"
+#include "util/UnorderedSet.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric.h"
-#include <Tracy.hpp>
 #include <algorithm>
+#include <cmath>
 
 namespace stellar
 {
@@ -61,12 +63,147 @@ TxDemandsManager::getMaxDemandSize() const
 }
 
 std::chrono::milliseconds
-TxDemandsManager::retryDelayDemand(int numAttemptsMade) const
+TxDemandsManager::retryDelayDemand(int numAttemptsMade,
+                                   std::optional<NodeID> const& lastPeer) const
 {
-    auto res = numAttemptsMade * mApp.getConfig().FLOOD_DEMAND_BACKOFF_DELAY_MS;
+    auto const& cfg = mApp.getConfig();
+    auto step = cfg.FLOOD_DEMAND_BACKOFF_DELAY_MS;
+    if (cfg.ADAPTIVE_TX_DEMANDS && lastPeer)
+    {
+        // Give the peer twice its usual time to answer, but no less than a
+        // demand period: we can't retry any sooner anyway.
+        auto latency = getPeerPullLatency(*lastPeer);
+        if (latency)
+        {
+            step = std::min(std::max(2 * *latency, cfg.FLOOD_DEMAND_PERIOD_MS),
+                            step);
+        }
+    }
+    auto res = numAttemptsMade * step;
     return std::min(res, std::chrono::milliseconds(MAX_DELAY_DEMAND));
 }
 
+std::optional<std::chrono::milliseconds>
+TxDemandsManager::getPeerPullLatency(NodeID const& peer) const
+{
+    auto it = mPeerStats.find(peer);
+    if (it == mPeerStats.end() || !it->second.mLatencyMs)
+    {
+        return std::nullopt;
+    }
+    return std::chrono::milliseconds(
+        static_cast<int64_t>(std::llround(*it->second.mLatencyMs)));
+}
+
+uint32_t
+TxDemandsManager::getOutstandingDemands(NodeID const& peer) const
+{
+    auto it = mPeerStats.find(peer);
+    return it == mPeerStats.end() ? 0 : it->second.mOutstanding;
+}
+
+void
+TxDemandsManager::updatePeerLatency(NodeID const& peer,
+                                    VirtualClock::duration latency)
+{
+    double sample =
+        std::chrono::duration<double, std::milli>(latency).count();
+    auto& avg = mPeerStats[peer].mLatencyMs;
+    if (avg)
+    {
+        *avg += LATENCY_EWMA_WEIGHT * (sample - *avg);
+    }
+    else
+    {
+        avg = sample;
+    }
+}
+
+void
+TxDemandsManager::clearPendingPeer(DemandHistory& history, bool timedOut)
+{
+    if (!history.pendingPeer)
+    {
+        return;
+    }
+    auto const& peerID = *history.pendingPeer;
+    if (timedOut)
+    {
+        // The peer took at least that long, count it double so that peers
+        // that don't answer fall behind the ones that do. Cap the penalty so
+        // that a single loss doesn't outweigh the history of the peer.
+        auto waited = mApp.getClock().now() - history.peers.at(peerID);
+        updatePeerLatency(peerID,
+                          std::min<VirtualClock::duration>(
+                              2 * waited, 2 * MAX_DELAY_DEMAND));
+    }
+    auto it = mPeerStats.find(peerID);
+    if (it != mPeerStats.end() && it->second.mOutstanding > 0)
+    {
+        --it->second.mOutstanding;
+    }
+    history.pendingPeer.reset();
+}
+
+void
+TxDemandsManager::prunePeerStats(std::vector<Peer::pointer> const& peers)
+{
+    UnorderedSet<NodeID> connected;
+    for (auto const& peer : peers)
+    {
+        connected.emplace(peer->getPeerID());
+    }
+    for (auto it = mPeerStats.begin(); it != mPeerStats.end();)
+    {
+        if (connected.find(it->first) == connected.end())
+        {
+            it = mPeerStats.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+double
+TxDemandsManager::peerScore(NodeID const& peer) const
+{
+    // Peers we know nothing about yet are assumed to answer within a demand
+    // period, which puts them ahead of the slow ones until we know better.
+    double period = static_cast<double>(
+        mApp.getConfig().FLOOD_DEMAND_PERIOD_MS.count());
+    double latency = period;
+    uint32_t outstanding = 0;
+    auto it = mPeerStats.find(peer);
+    if (it != mPeerStats.end())
+    {
+        latency = it->second.mLatencyMs.value_or(period);
+        outstanding = it->second.mOutstanding;
+    }
+    // Expected time until the peer answers a new demand, if it answers the
+    // outstanding ones first
+    return (latency + period) * (1 + outstanding);
+}
+
+void
+TxDemandsManager::sortPeersByScore(std::vector<Peer::pointer>& peers) const
+{
+    std::vector<std::pair<double, Peer::pointer>> scored;
+    scored.reserve(peers.size());
+    for (auto& peer : peers)
+    {
+        scored.emplace_back(peerScore(peer->getPeerID()), std::move(peer));
+    }
+    std::stable_sort(
+        scored.begin(), scored.end(),
+        [](auto const& a, auto const& b) { return a.first < b.first; });
+    for (size_t i = 0; i < peers.size(); ++i)
+    {
+        peers[i] = std::move(scored[i].second);
+    }
+}
+
 TxDemandsManager::DemandStatus
 TxDemandsManager::demandStatus(Hash const& txHash, Peer::pointer peer) const
 {
@@ -94,7 +231,7 @@ TxDemandsManager::demandStatus(Hash const& txHash, Peer::pointer peer) const
     {
         // Check if it's been a while since our last demand
         if ((mApp.getClock().now() - lastDemanded) >=
-            retryDelayDemand(numDemanded))
+            retryDelayDemand(numDemanded, it->second.pendingPeer))
         {
             return DemandStatus::DEMAND;
         }
@@ -142,6 +279,7 @@ TxDemandsManager::demand()
                 // We never received the txn.
                 om.mAbandonedDemandMeter.Mark();
             }
+            clearPendingPeer(it->second, false);
             mPendingDemands.pop();
             mDemandHistoryMap.erase(it);
         }
@@ -154,6 +292,13 @@ TxDemandsManager::demand()
     }
 
     auto peers = mApp.getOverlayManager().getRandomAuthenticatedPeers();
+    prunePeerStats(peers);
+    if (mApp.getConfig().ADAPTIVE_TX_DEMANDS)
+    {
+        // Peers get one demand per pass below, so the first peers get to
+        // demand the transactions that several peers advertised.
+        sortPeersByScore(peers);
+    }
 
     UnorderedMap<Peer::pointer, std::pair<TxDemandVector, std::list<Hash>>>
         demandMap;
@@ -182,6 +327,7 @@ TxDemandsManager::demand()
                 switch (demandStatus(txHash, peer))
                 {
                 case DemandStatus::DEMAND:
+                {
                     demand.push_back(txHash);
                     if (mDemandHistoryMap.find(txHash) ==
                         mDemandHistoryMap.end())
@@ -198,11 +344,15 @@ TxDemandsManager::demand()
                         om.mDemandTimeouts.Mark();
                         ++(peer->getPeerMetrics().mDemandTimeouts);
                     }
-                    mDemandHistoryMap[txHash].peers.emplace(peer->getPeerID(),
-                                                            now);
-                    mDemandHistoryMap[txHash].lastDemanded = now;
+                    auto& history = mDemandHistoryMap[txHash];
+                    clearPendingPeer(history, true);
+                    history.peers.emplace(peer->getPeerID(), now);
+                    history.lastDemanded = now;
+                    history.pendingPeer = peer->getPeerID();
+                    ++mPeerStats[peer->getPeerID()].mOutstanding;
                     addedNewDemand = true;
                     break;
+                }
                 case DemandStatus::RETRY_LATER:
                     retry.push_back(txHash);
                     break;
@@ -259,6 +409,7 @@ TxDemandsManager::recordTxPullLatency(Hash const& hash,
             auto delta = now - peerIt->second;
             om.mPeerTxPullLatency.Update(delta);
             peer->getPeerMetrics().mPullLatency.Update(delta);
+            updatePeerLatency(peer->getPeerID(), delta);
             CLOG_DEBUG(
                 Overlay,
                 "Pulled transaction {} in {} milliseconds from peer {}",
@@ -267,6 +418,7 @@ TxDemandsManager::recordTxPullLatency(Hash const& hash,
                     .count(),
                 peer->toString());
         }
+        clearPendingPeer(it->second, false);
     }
 }
 
@@ -38,6 +38,14 @@ class TxDemandsManager : private NonMovableOrCopyable
     // Stop demanding transactions from peers
     void shutdown();
 
+    // Moving average of the time `peer` took to answer our demands, if it
+    // answered or timed out at least once
+    std::optional<std::chrono::milliseconds>
+    getPeerPullLatency(NodeID const& peer) const;
+
+    // Number of demands sent to `peer` that are still waiting for an answer
+    uint32_t getOutstandingDemands(NodeID const& peer) const;
+
   private:
     // After `MAX_RETRY_COUNT` attempts with linear back-off, we assume that
     // no one has the transaction.
@@ -49,7 +57,21 @@ class TxDemandsManager : private NonMovableOrCopyable
         VirtualClock::time_point lastDemanded;
         UnorderedMap<NodeID, VirtualClock::time_point> peers;
         bool latencyRecorded{false};
+        // Peer the last demand went to, until it answers or we demand the
+        // transaction from someone else
+        std::optional<NodeID> pendingPeer;
+    };
+
+    // What we learned from the demands sent to a peer, used to pick whom
+    // to demand from when ADAPTIVE_TX_DEMANDS is set
+    struct PeerDemandStats
+    {
+        std::optional<double> mLatencyMs;
+        uint32_t mOutstanding{0};
     };
+
+    // Weight of a new sample in the moving average of pull latency
+    static constexpr double LATENCY_EWMA_WEIGHT = 0.25;
     enum class DemandStatus
     {
         DEMAND,      // Demand
@@ -62,6 +84,7 @@ class TxDemandsManager : private NonMovableOrCopyable
     VirtualTimer mDemandTimer;
     UnorderedMap<Hash, DemandHistory> mDemandHistoryMap;
     std::queue<Hash> mPendingDemands;
+    UnorderedMap<NodeID, PeerDemandStats> mPeerStats;
 
     // Begin demanding on schedule
     void startDemandTimer();
@@ -75,7 +98,29 @@ class TxDemandsManager : private NonMovableOrCopyable
     // Decide whether to demand a transaction now, retry later or discard
     DemandStatus demandStatus(Hash const& txHash, Peer::pointer) const;
 
-    // Compute delay between demand retries, with linear backoff
-    std::chrono::milliseconds retryDelayDemand(int numAttemptsMade) const;
+    // Compute delay between demand retries, with linear backoff. With
+    // ADAPTIVE_TX_DEMANDS, the backoff step follows the latency of
+    // `lastPeer`
+    std::chrono::milliseconds
+    retryDelayDemand(int numAttemptsMade,
+                     std::optional<NodeID> const& lastPeer) const;
+
+    // Add a pull latency sample of `peer` to its moving average
+    void updatePeerLatency(NodeID const& peer,
+                           VirtualClock::duration latency);
+
+    // Stop waiting for the peer the last demand of `history` went to. If
+    // `timedOut`, the time it has been waiting counts against the peer.
+    void clearPendingPeer(DemandHistory& history, bool timedOut);
+
+    // Forget about the peers that are not in `peers` anymore
+    void prunePeerStats(std::vector<Peer::pointer> const& peers);
+
+    // Lower is better: peers answering fast and with few demands
+    // outstanding come first
+    double peerScore(NodeID const& peer) const;
+
+    // Put the best peers first, keeping the order of peers that tie
+    void sortPeersByScore(std::vector<Peer::pointer>& peers) const;
 };
 }
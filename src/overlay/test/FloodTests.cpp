@@ -10,6 +10,9 @@
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "overlay/Floodgate.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/OverlayMetrics.h"
 #include "overlay/PeerDoor.h"
@@ -209,6 +212,17 @@ TEST_CASE("Flooding", "[flood][overlay][acceptance]")
                                               networkID, cfgGen2);
                 test(injectTransaction, ackedTransactions, true);
             }
+            SECTION("background signature verification")
+            {
+                auto cfgGenBackground = [&](int n) {
+                    auto cfg = cfgGen2(n);
+                    cfg.EXPERIMENTAL_BACKGROUND_TX_SIG_VERIFICATION = true;
+                    return cfg;
+                };
+                simulation = Topologies::core(4, 1, Simulation::OVER_LOOPBACK,
+                                              networkID, cfgGenBackground);
+                test(injectTransaction, ackedTransactions, true);
+            }
             auto cfgGenPullMode = [&](int n) {
                 auto cfg = getTestConfig(n);
                 // adjust delayed tx flooding
@@ -526,6 +540,18 @@ TEST_CASE("Flooding", "[flood][overlay][acceptance]")
                                      networkID, cfgGen, quorumAdjuster);
                 test(injectSCP, ackedSCP, false);
             }
+            SECTION("background signature verification")
+            {
+                auto cfgGenBackground = [&](int n) {
+                    auto cfg = cfgGen(n);
+                    cfg.EXPERIMENTAL_BACKGROUND_SCP_SIG_VERIFICATION = true;
+                    return cfg;
+                };
+                simulation = Topologies::core(
+                    4, 1.0f, Simulation::OVER_LOOPBACK, networkID,
+                    cfgGenBackground, quorumAdjuster);
+                test(injectSCP, ackedSCP, false);
+            }
             SECTION("tcp")
             {
                 simulation =
@@ -554,4 +580,146 @@ TEST_CASE("Flooding", "[flood][overlay][acceptance]")
         }
     }
 }
+
+TEST_CASE("flood records", "[flood][overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation =
+        std::make_shared<Simulation>(Simulation::OVER_LOOPBACK, networkID);
+
+    std::vector<SecretKey> keys;
+    for (int i = 0; i < 3; ++i)
+    {
+        keys.emplace_back(SecretKey::fromSeed(sha256("n" + std::to_string(i))));
+    }
+    SCPQuorumSet qSet;
+    qSet.threshold = 1;
+    qSet.validators.push_back(keys[0].getPublicKey());
+    for (auto const& k : keys)
+    {
+        simulation->addNode(k, qSet);
+    }
+    simulation->addPendingConnection(keys[0].getPublicKey(),
+                                     keys[1].getPublicKey());
+    simulation->addPendingConnection(keys[0].getPublicKey(),
+                                     keys[2].getPublicKey());
+    simulation->startAllNodes();
+    auto app = simulation->getNode(keys[0].getPublicKey());
+    simulation->crankUntil(
+        [&]() {
+            return app->getOverlayManager().getAuthenticatedPeersCount() == 2;
+        },
+        std::chrono::seconds(5), false);
+
+    std::vector<Peer::pointer> peers;
+    for (auto const& p : app->getOverlayManager().getAuthenticatedPeers())
+    {
+        peers.emplace_back(p.second);
+    }
+    REQUIRE(peers.size() == 2);
+
+    Floodgate fg(*app);
+    auto msg = std::make_shared<StellarMessage>();
+    msg->type(SCP_MESSAGE);
+    msg->envelope().statement.slotIndex = 7;
+    Hash msgID;
+
+    REQUIRE(fg.addRecord(*msg, peers[0], msgID));
+    REQUIRE(!fg.addRecord(*msg, peers[0], msgID));
+    REQUIRE(fg.getPeersKnows(msgID) == std::set<Peer::pointer>{peers[0]});
+    REQUIRE(!fg.addRecord(*msg, peers[1], msgID));
+    REQUIRE(fg.getPeersKnows(msgID) ==
+            std::set<Peer::pointer>{peers[0], peers[1]});
+    // every peer already knows it
+    REQUIRE(!fg.broadcast(msg));
+    REQUIRE(fg.getRecordCount() == 1);
+
+    auto ledgerSeq = app->getHerder().trackingConsensusLedgerIndex();
+    SECTION("forget record")
+    {
+        fg.forgetRecord(msgID);
+        REQUIRE(fg.getRecordCount() == 0);
+        REQUIRE(fg.getPeersKnows(msgID).empty());
+        REQUIRE(fg.addRecord(*msg, peers[1], msgID));
+        REQUIRE(fg.getPeersKnows(msgID) == std::set<Peer::pointer>{peers[1]});
+    }
+    SECTION("clear below")
+    {
+        fg.clearBelow(ledgerSeq);
+        REQUIRE(fg.getRecordCount() == 1);
+        fg.clearBelow(ledgerSeq + 1);
+        REQUIRE(fg.getRecordCount() == 0);
+        REQUIRE(fg.getPeersKnows(msgID).empty());
+
+        // peer slots were released with the records, and don't carry over
+        REQUIRE(fg.addRecord(*msg, peers[1], msgID));
+        REQUIRE(fg.getPeersKnows(msgID) == std::set<Peer::pointer>{peers[1]});
+        REQUIRE(fg.broadcast(msg));
+        REQUIRE(fg.getPeersKnows(msgID) ==
+                std::set<Peer::pointer>{peers[0], peers[1]});
+    }
+    simulation->stopAllNodes();
+}
+
+TEST_CASE("scp relay to quorum first", "[flood][overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto simulation =
+        std::make_shared<Simulation>(Simulation::OVER_LOOPBACK, networkID);
+
+    std::vector<SecretKey> keys;
+    for (int i = 0; i < 3; ++i)
+    {
+        keys.emplace_back(SecretKey::fromSeed(sha256("n" + std::to_string(i))));
+    }
+    // node 1 is in the quorum of node 0, node 2 isn't
+    SCPQuorumSet qSet;
+    qSet.threshold = 1;
+    qSet.validators.push_back(keys[0].getPublicKey());
+    qSet.validators.push_back(keys[1].getPublicKey());
+
+    bool const quorumFirst = GENERATE(false, true);
+    auto cfg = getTestConfig(0);
+    cfg.SCP_RELAY_QUORUM_FIRST = quorumFirst;
+    simulation->addNode(keys[0], qSet, &cfg);
+    simulation->addNode(keys[1], qSet);
+    simulation->addNode(keys[2], qSet);
+    simulation->addPendingConnection(keys[0].getPublicKey(),
+                                     keys[1].getPublicKey());
+    simulation->addPendingConnection(keys[0].getPublicKey(),
+                                     keys[2].getPublicKey());
+    simulation->startAllNodes();
+    auto app = simulation->getNode(keys[0].getPublicKey());
+    simulation->crankUntil(
+        [&]() {
+            return app->getOverlayManager().getAuthenticatedPeersCount() == 2;
+        },
+        std::chrono::seconds(5), false);
+    REQUIRE(app->getHerder().getCurrentlyTrackedQuorum().count(
+                keys[1].getPublicKey()) == 1);
+    REQUIRE(app->getHerder().getCurrentlyTrackedQuorum().count(
+                keys[2].getPublicKey()) == 0);
+
+    auto& broadcast = app->getMetrics().NewMeter(
+        {"overlay", "flood", "broadcast"}, "message");
+    auto& first = app->getMetrics().NewMeter(
+        {"overlay", "flood", "quorum-first"}, "message");
+    auto broadcastBefore = broadcast.count();
+    auto firstBefore = first.count();
+
+    Floodgate fg(*app);
+    auto msg = std::make_shared<StellarMessage>();
+    msg->type(SCP_MESSAGE);
+    msg->envelope().statement.slotIndex = 7;
+    REQUIRE(fg.broadcast(msg));
+    REQUIRE(broadcast.count() - broadcastBefore == 2);
+    REQUIRE(first.count() - firstBefore == (quorumFirst ? 1 : 0));
+
+    // transactions are never sent that way
+    auto tx = std::make_shared<StellarMessage>();
+    tx->type(TRANSACTION);
+    REQUIRE(fg.broadcast(tx, xdrSha256(tx->transaction())));
+    REQUIRE(first.count() - firstBefore == (quorumFirst ? 1 : 0));
+    simulation->stopAllNodes();
+}
 }
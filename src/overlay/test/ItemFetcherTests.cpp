@@ -484,4 +484,85 @@ TEST_CASE("next peer strategy", "[overlay][ItemFetcher]")
         }
     }
 }
+
+TEST_CASE("parallel fetch", "[overlay][ItemFetcher]")
+{
+    auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    auto sim =
+        std::make_shared<Simulation>(Simulation::OVER_LOOPBACK, networkID);
+
+    auto cfgMain = getTestConfig(1);
+    cfgMain.MAX_PARALLEL_FETCH_PEERS = 2;
+    auto cfg1 = getTestConfig(2);
+    auto cfg2 = getTestConfig(3);
+    auto cfg3 = getTestConfig(4);
+
+    SIMULATION_CREATE_NODE(Main);
+    SIMULATION_CREATE_NODE(Node1);
+    SIMULATION_CREATE_NODE(Node2);
+    SIMULATION_CREATE_NODE(Node3);
+    sim->addNode(vMainSecretKey, cfgMain.QUORUM_SET, &cfgMain);
+    sim->addNode(vNode1SecretKey, cfg1.QUORUM_SET, &cfg1);
+    sim->addNode(vNode2SecretKey, cfg2.QUORUM_SET, &cfg2);
+    sim->addNode(vNode3SecretKey, cfg3.QUORUM_SET, &cfg3);
+    sim->addPendingConnection(vMainNodeID, vNode1NodeID);
+    sim->addPendingConnection(vMainNodeID, vNode2NodeID);
+    sim->addPendingConnection(vMainNodeID, vNode3NodeID);
+    sim->startAllNodes();
+    std::vector<Peer::pointer> peers;
+    for (auto const& id : {vNode1NodeID, vNode2NodeID, vNode3NodeID})
+    {
+        peers.emplace_back(
+            sim->getLoopbackConnection(vMainNodeID, id)->getInitiator());
+    }
+    sim->crankUntil(
+        [&]() {
+            return std::all_of(
+                peers.begin(), peers.end(),
+                [](auto const& p) { return p->isAuthenticated(); });
+        },
+        std::chrono::seconds{3}, false);
+
+    auto app = sim->getNode(vMainNodeID);
+    auto& hedges = app->getMetrics().NewMeter(
+        {"overlay", "item-fetcher", "hedge"}, "item-fetcher");
+    auto hedgesBefore = hedges.count();
+    int askCount = 0;
+    ItemFetcher itemFetcher(*app, [&](Peer::pointer, Hash) { askCount++; });
+
+    auto hundred = sha256(ByteSlice("100"));
+    itemFetcher.fetch(hundred, makeEnvelope(100));
+    auto tracker = itemFetcher.getTracker(hundred);
+    REQUIRE(tracker);
+    REQUIRE(askCount == 1);
+
+    // Nobody answers quickly, so a second peer is asked, and no more than
+    // that
+    sim->crankForAtLeast(std::chrono::milliseconds(1000), false);
+    REQUIRE(askCount == 2);
+    REQUIRE(tracker->getPeersInFlight().size() == 2);
+    REQUIRE(hedges.count() == hedgesBefore + 1);
+
+    SECTION("one peer doesn't have it")
+    {
+        auto first = tracker->getPeersInFlight().front();
+        auto second = tracker->getPeersInFlight().back();
+        tracker->doesntHave(first);
+        // the other peer may still answer
+        REQUIRE(askCount == 2);
+        REQUIRE(tracker->getPeersInFlight().size() == 1);
+        REQUIRE(tracker->getLastAskedPeer() == second);
+
+        tracker->doesntHave(second);
+        REQUIRE(askCount == 3);
+        REQUIRE(tracker->getPeersInFlight().size() == 1);
+    }
+    SECTION("answer stops further requests")
+    {
+        itemFetcher.recv(hundred, app->getMetrics().NewTimer(
+                                      {"overlay", "fetch", "test"}));
+        sim->crankForAtLeast(std::chrono::seconds(5), false);
+        REQUIRE(askCount == 2);
+    }
+}
 }
@@ -3,6 +3,7 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "overlay/test/LoopbackPeer.h"
+#include "crypto/ByteSlice.h"
 #include "crypto/Random.h"
 #include "main/Application.h"
 #include "medida/meter.h"
@@ -12,8 +13,8 @@
 #include "overlay/StellarXDR.h"
 #include "util/Logging.h"
 #include "util/Math.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -259,6 +260,10 @@ LoopbackPeer::recvMessage(xdr::msg_ptr const& msg)
     {
         return;
     }
+    if (maybeDropKnownTransaction(msg))
+    {
+        return;
+    }
 
     try
     {
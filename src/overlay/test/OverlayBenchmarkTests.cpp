@@ -0,0 +1,303 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/Random.h"
+#include "crypto/SHA.h"
+#include "crypto/SecretKey.h"
+#include "ledger/LedgerManager.h"
+#include "lib/catch.hpp"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "overlay/test/LoopbackPeer.h"
+#include "test/MicroBenchmark.h"
+#include "test/TestUtils.h"
+#include "test/TxTests.h"
+#include "test/test.h"
+#include "util/Logging.h"
+#include "util/Timer.h"
+#include "util/XDRUncheckedPut.h"
+
+#include "medida/meter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <xdrpp/marshal.h>
+
+using namespace stellar;
+
+namespace
+{
+
+// Number of messages of each kind every peer sends to the node per round
+struct FloodMix
+{
+    std::string mName;
+    size_t mTransactions;
+    size_t mSCPMessages;
+    size_t mAdverts;
+};
+
+StellarMessage
+makeTransactionMessage(Application& app, SecretKey const& source)
+{
+    // The source account doesn't exist, so the herder rejects the
+    // transaction after it went through the whole overlay receive path
+    auto tx = txtest::transactionFromOperations(
+        app, source, 1,
+        {txtest::payment(SecretKey::pseudoRandomForTesting().getPublicKey(),
+                         100)});
+    StellarMessage msg;
+    msg.type(TRANSACTION);
+    msg.transaction() = tx->getEnvelope();
+    return msg;
+}
+
+StellarMessage
+makeSCPMessage(Application& app, SecretKey const& node)
+{
+    StellarMessage msg;
+    msg.type(SCP_MESSAGE);
+    auto& env = msg.envelope();
+    env.statement.nodeID = node.getPublicKey();
+    env.statement.slotIndex =
+        app.getLedgerManager().getLastClosedLedgerNum() + 1;
+    env.statement.pledges.type(SCP_ST_NOMINATE);
+    auto& nom = env.statement.pledges.nominate();
+    nom.quorumSetHash = sha256(randomBytes(32));
+    nom.votes.emplace_back(randomBytes(32));
+    // Left unsigned, the envelope is dropped once its signature is checked
+    return msg;
+}
+
+StellarMessage
+makeAdvertMessage()
+{
+    // Nobody knows these hashes, so the node demands them and never gets
+    // them
+    StellarMessage msg;
+    msg.type(FLOOD_ADVERT);
+    msg.floodAdvert().txHashes.emplace_back(sha256(randomBytes(32)));
+    return msg;
+}
+
+uint64_t
+meterCount(Application& app, std::string const& domain,
+           std::string const& type, std::string const& name)
+{
+    return app.getMetrics().NewMeter({domain, type, name}, "message").count();
+}
+
+void
+runFloodBench(FloodMix const& mix, size_t numPeers, size_t rounds)
+{
+    VirtualClock clock;
+    auto node = createTestApplication(clock, getTestConfig(0));
+    std::vector<Application::pointer> apps;
+    std::vector<std::shared_ptr<LoopbackPeerConnection>> connections;
+    for (size_t i = 0; i < numPeers; ++i)
+    {
+        apps.emplace_back(createTestApplication(
+            clock, getTestConfig(static_cast<int>(i) + 1)));
+        connections.emplace_back(
+            std::make_shared<LoopbackPeerConnection>(*apps.back(), *node));
+    }
+    testutil::crankFor(clock, std::chrono::seconds(5));
+    for (auto const& conn : connections)
+    {
+        REQUIRE(conn->getInitiator()->isAuthenticated());
+        REQUIRE(conn->getAcceptor()->isAuthenticated());
+    }
+
+    // Build everything up front so that signing doesn't count against the
+    // overlay
+    std::vector<std::vector<std::shared_ptr<StellarMessage const>>> msgs(
+        numPeers);
+    for (size_t i = 0; i < numPeers; ++i)
+    {
+        auto source = SecretKey::pseudoRandomForTesting();
+        for (size_t r = 0; r < rounds; ++r)
+        {
+            for (size_t j = 0; j < mix.mTransactions; ++j)
+            {
+                msgs[i].emplace_back(std::make_shared<StellarMessage>(
+                    makeTransactionMessage(*apps[i], source)));
+            }
+            for (size_t j = 0; j < mix.mSCPMessages; ++j)
+            {
+                msgs[i].emplace_back(std::make_shared<StellarMessage>(
+                    makeSCPMessage(*node, source)));
+            }
+            for (size_t j = 0; j < mix.mAdverts; ++j)
+            {
+                msgs[i].emplace_back(
+                    std::make_shared<StellarMessage>(makeAdvertMessage()));
+            }
+        }
+    }
+    size_t const perRound =
+        mix.mTransactions + mix.mSCPMessages + mix.mAdverts;
+
+    auto& recvTx =
+        node->getMetrics().NewTimer({"overlay", "recv", "transaction"});
+    auto& recvSCP =
+        node->getMetrics().NewTimer({"overlay", "recv", "scp-message"});
+    auto& recvAdvert =
+        node->getMetrics().NewTimer({"overlay", "recv", "flood-advert"});
+    auto txBefore = recvTx.count();
+    auto scpBefore = recvSCP.count();
+    auto advertBefore = recvAdvert.count();
+    auto bytesBefore = meterCount(*node, "overlay", "byte", "read");
+
+    auto wallStart = std::chrono::steady_clock::now();
+    auto cpuStart = std::clock();
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < numPeers; ++i)
+        {
+            for (size_t j = 0; j < perRound; ++j)
+            {
+                connections[i]->getInitiator()->sendMessage(
+                    msgs[i][r * perRound + j]);
+            }
+        }
+        // Virtual time skips over idle periods, so the wall clock only
+        // measures the work done
+        testutil::crankFor(clock, std::chrono::milliseconds(100));
+    }
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    auto cpuEnd = std::clock();
+    std::chrono::duration<double> wall =
+        std::chrono::steady_clock::now() - wallStart;
+    // All the applications share this process, so this includes the
+    // senders' work too
+    double cpu = static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+
+    auto txs = recvTx.count() - txBefore;
+    auto scps = recvSCP.count() - scpBefore;
+    auto adverts = recvAdvert.count() - advertBefore;
+    auto bytes = meterCount(*node, "overlay", "byte", "read") - bytesBefore;
+    auto total = txs + scps + adverts;
+
+    double queueDelayTx = 0;
+    double queueDelaySCP = 0;
+    double queueDelayAdvert = 0;
+    double maxQueueDelay = 0;
+    uint64_t queueDrops = 0;
+    size_t linkDrops = 0;
+    for (size_t i = 0; i < numPeers; ++i)
+    {
+        auto& m = apps[i]->getMetrics();
+        auto& tx = m.NewTimer({"overlay", "outbound-queue", "tx"});
+        auto& scp = m.NewTimer({"overlay", "outbound-queue", "scp"});
+        auto& adv = m.NewTimer({"overlay", "outbound-queue", "advert"});
+        queueDelayTx += tx.mean() / numPeers;
+        queueDelaySCP += scp.mean() / numPeers;
+        queueDelayAdvert += adv.mean() / numPeers;
+        maxQueueDelay =
+            std::max({maxQueueDelay, tx.max(), scp.max(), adv.max()});
+        for (auto const& name : {"drop-tx", "drop-scp", "drop-advert"})
+        {
+            queueDrops +=
+                meterCount(*apps[i], "overlay", "outbound-queue", name);
+        }
+        linkDrops +=
+            connections[i]->getInitiator()->getStats().messagesDropped;
+    }
+    auto sent = numPeers * rounds * perRound;
+
+    LOG_INFO(DEFAULT_LOG,
+             "overlay bench '{}': {} peers, {} messages sent in {:.3f}s "
+             "({:.3f}s CPU)",
+             mix.mName, numPeers, sent, wall.count(), cpu);
+    LOG_INFO(DEFAULT_LOG,
+             "received {:.0f} tx/s, {:.0f} SCP msgs/s, {:.0f} adverts/s, "
+             "{:.2f} MB/s, {:.1f}us CPU per message",
+             txs / wall.count(), scps / wall.count(), adverts / wall.count(),
+             bytes / wall.count() / 1e6,
+             total == 0 ? 0.0 : cpu * 1e6 / total);
+    LOG_INFO(DEFAULT_LOG,
+             "outbound queue delay (ms): tx {:.3f}, scp {:.3f}, advert "
+             "{:.3f}, max {:.3f}; dropped {} from queues, {} on links, {} "
+             "not received",
+             queueDelayTx, queueDelaySCP, queueDelayAdvert, maxQueueDelay,
+             queueDrops, linkDrops, sent - total);
+
+    for (auto const& conn : connections)
+    {
+        REQUIRE(conn->getInitiator()->isAuthenticated());
+        REQUIRE(conn->getAcceptor()->isAuthenticated());
+    }
+}
+}
+
+TEST_CASE("overlay throughput bench", "[overlay][bench][!hide]")
+{
+    size_t const numPeers = 8;
+    size_t const rounds = 50;
+
+    SECTION("transactions")
+    {
+        runFloodBench({"transactions", 100, 0, 0}, numPeers, rounds);
+    }
+    SECTION("scp")
+    {
+        runFloodBench({"scp", 0, 20, 0}, numPeers, rounds);
+    }
+    SECTION("adverts")
+    {
+        runFloodBench({"adverts", 0, 0, 100}, numPeers, rounds);
+    }
+    SECTION("mixed")
+    {
+        runFloodBench({"mixed", 50, 5, 50}, numPeers, rounds);
+    }
+}
+
+TEST_CASE("XDR microbench", "[overlay][microbench][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    std::vector<std::pair<std::string, StellarMessage>> msgs = {
+        {"transaction",
+         makeTransactionMessage(*app, SecretKey::pseudoRandomForTesting())},
+        {"scp", makeSCPMessage(*app, SecretKey::pseudoRandomForTesting())}};
+
+    size_t const batch = 1000;
+    for (auto const& named : msgs)
+    {
+        auto const& msg = named.second;
+        auto bytes = xdr::xdr_to_opaque(msg);
+        size_t sink = 0;
+        runMicroBenchmark("xdr.encode." + named.first, [&]() {
+            for (size_t i = 0; i < batch; ++i)
+            {
+                sink += xdr::xdr_to_opaque(msg).size();
+            }
+            return batch;
+        });
+        // The buffer is sized once per message, as the call sites do
+        runMicroBenchmark("xdr.encode-unchecked." + named.first, [&]() {
+            for (size_t i = 0; i < batch; ++i)
+            {
+                std::vector<uint8_t> buf(xdr::xdr_size(msg));
+                xdrPutUnchecked(msg, buf.data(), buf.data() + buf.size());
+                sink += buf.size();
+            }
+            return batch;
+        });
+        runMicroBenchmark("xdr.decode." + named.first, [&]() {
+            StellarMessage decoded;
+            for (size_t i = 0; i < batch; ++i)
+            {
+                xdr::xdr_from_opaque(bytes, decoded);
+                sink += decoded.type();
+            }
+            return batch;
+        });
+        REQUIRE(sink > 0);
+    }
+}
@@ -2,12 +2,15 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "crypto/BLAKE2.h"
 #include "crypto/KeyUtils.h"
 #include "crypto/SecretKey.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
 #include "overlay/BanManager.h"
+#include "overlay/EncodedMessageCache.h"
+#include "overlay/FlowControl.h"
 #include "overlay/OverlayManagerImpl.h"
 #include "overlay/PeerManager.h"
 #include "overlay/TCPPeer.h"
@@ -621,6 +624,66 @@ runWithBothFlowControlModes(std::vector<Config>& cfgs,
     }
 }
 
+TEST_CASE("flow control window auto-tuning", "[overlay][flowcontrol]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig(0);
+    cfg.FLOW_CONTROL_MAX_CAPACITY_FACTOR = 4;
+    auto app = createTestApplication(clock, cfg);
+
+    OverlayAppConnector connector(*app);
+    FlowControl fc(connector);
+    auto fcBytes = app->getOverlayManager().getFlowControlBytesConfig().mTotal;
+    fc.start(getTestConfig(1).NODE_SEED.getPublicKey(),
+             [](std::shared_ptr<StellarMessage const>) {}, fcBytes);
+
+    StellarMessage tx;
+    tx.type(TRANSACTION);
+    auto processBatch = [&]() {
+        SendMoreCapacity res{0, std::nullopt};
+        for (uint32_t i = 0; i < cfg.FLOW_CONTROL_SEND_MORE_BATCH_SIZE; ++i)
+        {
+            REQUIRE(fc.beginMessageProcessing(tx));
+            res = fc.endMessageProcessing(tx);
+        }
+        return res;
+    };
+    auto window = [&]() {
+        return fc.getCapacity()->getCapacityLimits().mFloodCapacity;
+    };
+    auto windowBytes = [&]() {
+        return fc.getCapacityBytes()->getCapacityLimits().mFloodCapacity;
+    };
+    uint64_t const batch = cfg.FLOW_CONTROL_SEND_MORE_BATCH_SIZE;
+    uint64_t const base = cfg.PEER_FLOOD_READING_CAPACITY;
+
+    // Windows stay put until the round trip time is known
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    auto res = processBatch();
+    REQUIRE(res.first == batch);
+    REQUIRE(window() == base);
+    REQUIRE(windowBytes() == fcBytes);
+
+    // A peer far away needs more data in flight, up to the max factor
+    fc.setRoundTripTime(std::chrono::seconds(1000));
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    res = processBatch();
+    REQUIRE(window() == 4 * base);
+    REQUIRE(res.first == batch + 3 * base);
+    REQUIRE(windowBytes() > fcBytes);
+    REQUIRE(windowBytes() <= 4 * static_cast<uint64_t>(fcBytes));
+    REQUIRE(*res.second > batch * FlowControlCapacity::msgBodySize(tx));
+
+    // Once the peer gets closer, capacity is taken back as it's returned
+    fc.setRoundTripTime(std::chrono::milliseconds(1));
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    res = processBatch();
+    REQUIRE(res.first == 0);
+    REQUIRE(window() == 4 * base - batch);
+    REQUIRE(*res.second == 1);
+    REQUIRE(fc.getCapacity()->getCapacity().mFloodCapacity == window());
+}
+
 TEST_CASE("loopback peer flow control activation", "[overlay][flowcontrol]")
 {
     VirtualClock clock;
@@ -952,6 +1015,43 @@ TEST_CASE("failed auth", "[overlay][connections]")
     testutil::shutdownWorkScheduler(*app1);
 }
 
+TEST_CASE("peer auth resumption", "[overlay][connections]")
+{
+    VirtualClock clock;
+    Config cfg1 = getTestConfig(0);
+    Config cfg2 = getTestConfig(1);
+    cfg1.PEER_AUTH_RESUMPTION = true;
+    cfg2.PEER_AUTH_RESUMPTION = true;
+    auto app1 = createTestApplication(clock, cfg1);
+    auto app2 = createTestApplication(clock, cfg2);
+    auto resumed = [](Application& app) {
+        return app.getMetrics()
+            .NewMeter({"overlay", "auth", "resumed"}, "peer")
+            .count();
+    };
+
+    auto conn = std::make_unique<LoopbackPeerConnection>(*app1, *app2);
+    testutil::crankSome(clock);
+    REQUIRE(conn->getInitiator()->isAuthenticated());
+    REQUIRE(conn->getAcceptor()->isAuthenticated());
+    REQUIRE(resumed(*app1) == 0);
+    REQUIRE(resumed(*app2) == 0);
+
+    conn->getInitiator()->drop("testing",
+                               Peer::DropDirection::WE_DROPPED_REMOTE,
+                               Peer::DropMode::IGNORE_WRITE_QUEUE);
+    testutil::crankSome(clock);
+    conn = std::make_unique<LoopbackPeerConnection>(*app1, *app2);
+    testutil::crankSome(clock);
+    REQUIRE(conn->getInitiator()->isAuthenticated());
+    REQUIRE(conn->getAcceptor()->isAuthenticated());
+    REQUIRE(resumed(*app1) == 1);
+    REQUIRE(resumed(*app2) == 1);
+
+    testutil::shutdownWorkScheduler(*app2);
+    testutil::shutdownWorkScheduler(*app1);
+}
+
 TEST_CASE("outbound queue filtering", "[overlay][connections]")
 {
     auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
@@ -1239,6 +1339,63 @@ TEST_CASE("outbound queue filtering", "[overlay][connections]")
     }
 }
 
+TEST_CASE("outbound queue trimming by fee", "[overlay][flowcontrol]")
+{
+    VirtualClock clock;
+    Config cfg1 = getTestConfig(0);
+    Config cfg2 = getTestConfig(1);
+    cfg2.OUTBOUND_TX_QUEUE_TRIM_BY_FEE = true;
+    auto app1 = createTestApplication(clock, cfg1);
+    auto app2 = createTestApplication(clock, cfg2);
+
+    LoopbackPeerConnection conn(*app1, *app2);
+    testutil::crankSome(clock);
+    REQUIRE(conn.getInitiator()->isAuthenticated());
+    REQUIRE(conn.getAcceptor()->isAuthenticated());
+
+    auto peer = conn.getAcceptor();
+    auto& txQueue = peer->getQueues()[1];
+    auto makeTx = [](uint32_t fee) {
+        StellarMessage msg;
+        msg.type(TRANSACTION);
+        msg.transaction().type(ENVELOPE_TYPE_TX);
+        msg.transaction().v1().tx.fee = fee;
+        msg.transaction().v1().tx.operations.resize(1);
+        return std::make_shared<StellarMessage const>(msg);
+    };
+    auto fees = [&]() {
+        std::vector<uint32_t> res;
+        for (auto const& m : txQueue)
+        {
+            res.emplace_back(m.mMessage->transaction().v1().tx.fee);
+        }
+        return res;
+    };
+
+    // Can fit 3 transactions
+    auto byteSize =
+        peer->getFlowControl()->getCapacityBytes()->getMsgResourceCount(
+            *makeTx(100));
+    peer->getFlowControl()->setOutboundQueueLimit(byteSize * 7 / 2);
+
+    for (uint32_t fee : {300, 100, 200, 400})
+    {
+        peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(makeTx(fee));
+    }
+    REQUIRE(fees() == std::vector<uint32_t>{300, 200, 400});
+
+    // A transaction paying less than everything queued is dropped right away
+    peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(makeTx(150));
+    REQUIRE(fees() == std::vector<uint32_t>{300, 200, 400});
+
+    // The oldest of the cheapest transactions goes first
+    peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(makeTx(400));
+    peer->getFlowControl()->addToQueueAndMaybeTrimForTesting(makeTx(300));
+    REQUIRE(fees() == std::vector<uint32_t>{400, 400, 300});
+    REQUIRE(peer->getFlowControl()->getTxQueueByteCountForTesting() ==
+            3 * byteSize);
+}
+
 TEST_CASE("reject non preferred peer", "[overlay][connections]")
 {
     VirtualClock clock;
@@ -2440,11 +2597,11 @@ TEST_CASE("database is purged at overlay start", "[overlay]")
         return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
     };
 
-    peerManager.store(localhost(1), record(118), false);
-    peerManager.store(localhost(2), record(119), false);
-    peerManager.store(localhost(3), record(120), false);
-    peerManager.store(localhost(4), record(121), false);
-    peerManager.store(localhost(5), record(122), false);
+    peerManager.store(localhost(1), record(118));
+    peerManager.store(localhost(2), record(119));
+    peerManager.store(localhost(3), record(120));
+    peerManager.store(localhost(4), record(121));
+    peerManager.store(localhost(5), record(122));
 
     om.start();
 
@@ -2488,7 +2645,7 @@ TEST_CASE("peer numfailures resets after good connection",
 
     auto& om = app1->getOverlayManager();
     auto& peerManager = om.getPeerManager();
-    peerManager.store(localhost(cfg2.PEER_PORT), record(119), false);
+    peerManager.store(localhost(cfg2.PEER_PORT), record(119));
     REQUIRE(peerManager.load(localhost(cfg2.PEER_PORT)).second);
 
     simulation->crankForAtLeast(std::chrono::seconds{4}, true);
@@ -2528,7 +2685,7 @@ TEST_CASE("peer is purged from database after few failures",
 
     auto& om = app1->getOverlayManager();
     auto& peerManager = om.getPeerManager();
-    peerManager.store(localhost(cfg2.PEER_PORT), record(119), false);
+    peerManager.store(localhost(cfg2.PEER_PORT), record(119));
     REQUIRE(peerManager.load(localhost(cfg2.PEER_PORT)).second);
 
     simulation->crankForAtLeast(std::chrono::seconds{5}, true);
@@ -2954,6 +3111,172 @@ TEST_CASE("overlay pull mode", "[overlay][pullmode]")
     }
 }
 
+TEST_CASE("overlay pull mode adaptive demands", "[overlay][pullmode]")
+{
+    VirtualClock clock;
+    auto const numNodes = 3;
+    std::vector<std::shared_ptr<Application>> apps;
+    std::chrono::milliseconds const epsilon{1};
+
+    for (auto i = 0; i < numNodes; i++)
+    {
+        Config cfg = getTestConfig(i);
+        cfg.FLOOD_DEMAND_BACKOFF_DELAY_MS = std::chrono::milliseconds(300);
+        cfg.FLOOD_DEMAND_PERIOD_MS = std::chrono::milliseconds(100);
+        cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 1000;
+        cfg.ADAPTIVE_TX_DEMANDS = true;
+        apps.push_back(createTestApplication(clock, cfg));
+    }
+
+    std::vector<std::shared_ptr<LoopbackPeerConnection>> connections;
+    for (auto i = 0; i < numNodes; i++)
+    {
+        connections.push_back(std::make_shared<LoopbackPeerConnection>(
+            *apps[i], *apps[(i + 1) % numNodes]));
+    }
+    testutil::crankFor(clock, std::chrono::seconds(5));
+
+    auto& demands = static_cast<OverlayManagerImpl&>(
+                        apps[2]->getOverlayManager())
+                        .getTxDemandsManager();
+    auto nodeID = [&](int i) {
+        return apps[i]->getConfig().NODE_SEED.getPublicKey();
+    };
+
+    // Node 0 and Node 1 advertise `hash` to Node 2 at the same time
+    auto advertiseToNode2 = [&](Hash const& hash) {
+        StellarMessage adv;
+        adv.type(FLOOD_ADVERT);
+        adv.floodAdvert().txHashes.push_back(hash);
+        auto advPtr = std::make_shared<StellarMessage const>(adv);
+        connections[2]->getAcceptor()->sendMessage(advPtr, false);
+        connections[1]->getInitiator()->sendMessage(advPtr, false);
+    };
+
+    // Neither of them has the transaction
+    advertiseToNode2(sha256("unknown tx"));
+
+    testutil::crankFor(clock, apps[2]->getConfig().FLOOD_DEMAND_PERIOD_MS +
+                                  epsilon);
+    REQUIRE(getSentDemandCount(apps[2]) == 1);
+    int const first = getUnknownDemandCount(apps[0]) == 1 ? 0 : 1;
+    int const second = 1 - first;
+    REQUIRE(demands.getOutstandingDemands(nodeID(first)) == 1);
+    REQUIRE(!demands.getPeerPullLatency(nodeID(first)));
+
+    // The first peer never answers, the transaction gets demanded from the
+    // other one and the first peer is charged for the wait
+    testutil::crankFor(clock,
+                       2 * apps[2]->getConfig().FLOOD_DEMAND_BACKOFF_DELAY_MS);
+    REQUIRE(getSentDemandCount(apps[2]) == 2);
+    REQUIRE(getUnknownDemandCount(apps[second]) == 1);
+    REQUIRE(demands.getOutstandingDemands(nodeID(first)) == 0);
+    REQUIRE(demands.getOutstandingDemands(nodeID(second)) == 1);
+    auto slowLatency = demands.getPeerPullLatency(nodeID(first));
+    REQUIRE(slowLatency);
+    REQUIRE(*slowLatency >=
+            2 * apps[2]->getConfig().FLOOD_DEMAND_BACKOFF_DELAY_MS);
+
+    // Both peers advertise a real transaction, the one that didn't time out
+    // is asked first and answers
+    auto root = TestAccount::createRoot(*apps[0]);
+    auto tx = root.tx({txtest::createAccount(
+        txtest::getAccount("acc").getPublicKey(), 100)});
+    REQUIRE(apps[0]->getHerder().recvTransaction(tx, true) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+    REQUIRE(apps[1]->getHerder().recvTransaction(tx, true) ==
+            TransactionQueue::AddResult::ADD_STATUS_PENDING);
+    advertiseToNode2(tx->getFullHash());
+    testutil::crankFor(clock, std::chrono::seconds(1));
+
+    REQUIRE(getSentDemandCount(apps[2]) == 3);
+    REQUIRE(getFulfilledDemandCount(apps[second]) == 1);
+    REQUIRE(getFulfilledDemandCount(apps[first]) == 0);
+    auto fastLatency = demands.getPeerPullLatency(nodeID(second));
+    REQUIRE(fastLatency);
+    REQUIRE(*fastLatency < *slowLatency);
+    // Only the demand for the unknown transaction is still outstanding
+    REQUIRE(demands.getOutstandingDemands(nodeID(second)) == 1);
+}
+
+TEST_CASE("duplicate transactions are dropped before decoding", "[overlay]")
+{
+    VirtualClock clock;
+    Config cfg1 = getTestConfig(0);
+    Config cfg2 = getTestConfig(1);
+    cfg2.EARLY_DUPLICATE_TX_DETECTION = true;
+    auto app1 = createTestApplication(clock, cfg1);
+    auto app2 = createTestApplication(clock, cfg2);
+
+    LoopbackPeerConnection conn(*app1, *app2);
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    REQUIRE(conn.getInitiator()->isAuthenticated());
+    REQUIRE(conn.getAcceptor()->isAuthenticated());
+
+    auto& skipped = app2->getMetrics().NewMeter(
+        {"overlay", "flood", "decode-skipped"}, "transaction");
+    auto root = TestAccount::createRoot(*app1);
+    auto sendTx = [&](TransactionFrameBasePtr tx) {
+        auto msg = std::make_shared<StellarMessage>();
+        msg->type(TRANSACTION);
+        msg->transaction() = tx->getEnvelope();
+        conn.getInitiator()->sendMessage(msg);
+        testutil::crankFor(clock, std::chrono::seconds(1));
+        return xdrBlake2(*msg);
+    };
+
+    auto tx = root.tx({txtest::createAccount(
+        txtest::getAccount("acc").getPublicKey(), 100)});
+    auto msgID = sendTx(tx);
+    REQUIRE(app2->getHerder().getTx(tx->getFullHash()));
+    REQUIRE(skipped.count() == 0);
+
+    // The second copy isn't decoded, and the MAC sequence stays in sync
+    REQUIRE(sendTx(tx) == msgID);
+    REQUIRE(skipped.count() == 1);
+    REQUIRE(app2->getOverlayManager().getPeersKnows(msgID).size() == 1);
+
+    // A transaction that wasn't queued is decoded as usual
+    auto tx2 = root.tx({txtest::createAccount(
+        txtest::getAccount("acc2").getPublicKey(), 100)});
+    sendTx(tx2);
+    REQUIRE(app2->getHerder().getTx(tx2->getFullHash()));
+    REQUIRE(skipped.count() == 1);
+    REQUIRE(conn.getInitiator()->isAuthenticated());
+    REQUIRE(conn.getAcceptor()->isAuthenticated());
+}
+
+TEST_CASE("peer telemetry", "[overlay]")
+{
+    VirtualClock clock;
+    auto app1 = createTestApplication(clock, getTestConfig(0));
+    auto app2 = createTestApplication(clock, getTestConfig(1));
+
+    LoopbackPeerConnection conn(*app1, *app2);
+    testutil::crankFor(clock, std::chrono::seconds(1));
+    REQUIRE(conn.getInitiator()->isAuthenticated());
+    REQUIRE(conn.getAcceptor()->isAuthenticated());
+
+    auto root = TestAccount::createRoot(*app1);
+    auto tx = root.tx({txtest::createAccount(
+        txtest::getAccount("acc").getPublicKey(), 100)});
+    auto msg = std::make_shared<StellarMessage>();
+    msg->type(TRANSACTION);
+    msg->transaction() = tx->getEnvelope();
+    conn.getInitiator()->sendMessage(msg);
+    testutil::crankFor(clock, std::chrono::seconds(1));
+
+    auto sent = conn.getInitiator()->getJsonInfo(true)["telemetry"];
+    auto recv = conn.getAcceptor()->getJsonInfo(true)["telemetry"];
+    REQUIRE(sent["bytes"]["TRANSACTION"][0].asUInt64() == 0);
+    REQUIRE(sent["bytes"]["TRANSACTION"][1].asUInt64() > 0);
+    REQUIRE(recv["bytes"]["TRANSACTION"][0] == sent["bytes"]["TRANSACTION"][1]);
+    REQUIRE(recv["bytes"]["AUTH"][0] == sent["bytes"]["AUTH"][1]);
+    REQUIRE(sent["queue_ms"]["tx"][0].asUInt64() == 1);
+    REQUIRE(sent["queue_ms"]["scp"][0].asUInt64() == 0);
+    REQUIRE(sent["throttle_ms"]["read"].size() == 3);
+}
+
 TEST_CASE("overlay pull mode loadgen", "[overlay][pullmode][acceptance]")
 {
     auto networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
@@ -3069,4 +3392,57 @@ TEST_CASE("overlay pull mode with many peers",
 
     REQUIRE(getSentDemandCount(apps[0]) == maxRetry);
 }
+
+TEST_CASE("authenticated message encoding", "[overlay]")
+{
+    auto msg = std::make_shared<StellarMessage>();
+    msg->type(SCP_MESSAGE);
+    msg->envelope().statement.slotIndex = 42;
+    msg->envelope().statement.pledges.type(SCP_ST_EXTERNALIZE);
+    HmacSha256Key key;
+    key.key[0] = 7;
+    uint64_t seq = 12;
+
+    AuthenticatedMessage amsg;
+    amsg.v0().message = *msg;
+    amsg.v0().sequence = seq;
+    amsg.v0().mac = hmacSha256(key, xdr::xdr_to_opaque(seq, *msg));
+    auto expected = xdr::xdr_to_msg(amsg);
+
+    auto check = [&](xdr::msg_ptr const& m) {
+        REQUIRE(m->raw_size() == expected->raw_size());
+        REQUIRE(std::memcmp(m->raw_data(), expected->raw_data(),
+                            m->raw_size()) == 0);
+    };
+
+    SECTION("encoded directly")
+    {
+        check(Peer::encodeAuthenticatedMessage(*msg, nullptr, &key, seq));
+    }
+    SECTION("without MAC")
+    {
+        amsg.v0().sequence = 0;
+        amsg.v0().mac = HmacSha256Mac{};
+        expected = xdr::xdr_to_msg(amsg);
+        check(Peer::encodeAuthenticatedMessage(*msg, nullptr, nullptr, 0));
+    }
+    SECTION("from the encoded message cache")
+    {
+        EncodedMessageCache cache;
+        cache.add(msg);
+        auto body = cache.get(msg);
+        REQUIRE(body);
+        check(Peer::encodeAuthenticatedMessage(*msg, body.get(), &key, seq));
+
+        // messages are identified by their pointer, not their content
+        auto other = std::make_shared<StellarMessage const>(*msg);
+        REQUIRE(!cache.get(other));
+
+        // and are forgotten once released
+        msg.reset();
+        cache.add(other);
+        REQUIRE(cache.size() == 1);
+        REQUIRE(cache.get(other));
+    }
+}
 }
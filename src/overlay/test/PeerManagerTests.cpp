@@ -13,6 +13,8 @@
 #include "test/TestUtils.h"
 #include "test/test.h"
 
+#include <soci.h>
+
 namespace stellar
 {
 
@@ -53,7 +55,7 @@ TEST_CASE("toXdr", "[overlay][PeerManager]")
 
             auto storedPr = loadedPR.first;
             storedPr.mType = static_cast<int>(peerType);
-            pm.store(address, storedPr, false);
+            pm.store(address, storedPr);
 
             auto actualPR = pm.load(address);
             REQUIRE(actualPR.second);
@@ -277,7 +279,7 @@ TEST_CASE("loadRandomPeers", "[overlay][PeerManager]")
                     PeerRecord{VirtualClock::systemPointToTm(time), numFailures,
                                static_cast<int>(type)};
                 peerRecords[port] = peerRecord;
-                peerManager.store(localhost(port), peerRecord, false);
+                peerManager.store(localhost(port), peerRecord);
                 port++;
             }
         }
@@ -374,7 +376,7 @@ TEST_CASE("getPeersToSend", "[overlay][PeerManager]")
         {
             peerManager.store(
                 localhost(port++),
-                PeerRecord{{}, 11, static_cast<int>(PeerType::INBOUND)}, false);
+                PeerRecord{{}, 11, static_cast<int>(PeerType::INBOUND)});
         }
         for (auto i = 0; i < normalOutboundCount; i++)
         {
@@ -384,8 +386,7 @@ TEST_CASE("getPeersToSend", "[overlay][PeerManager]")
         {
             peerManager.store(
                 localhost(port++),
-                PeerRecord{{}, 11, static_cast<int>(PeerType::OUTBOUND)},
-                false);
+                PeerRecord{{}, 11, static_cast<int>(PeerType::OUTBOUND)});
         }
     };
 
@@ -487,17 +488,17 @@ TEST_CASE("RandomPeerSource::nextAttemptCutoff also limits maxFailures",
 
     auto now = VirtualClock::systemPointToTm(clock.system_now());
     peerManager.store(localhost(1),
-                      {now, 0, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 0, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(2),
-                      {now, 0, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 0, static_cast<int>(PeerType::OUTBOUND)});
     peerManager.store(localhost(3),
-                      {now, 120, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 120, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(4),
-                      {now, 120, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 120, static_cast<int>(PeerType::OUTBOUND)});
     peerManager.store(localhost(5),
-                      {now, 121, static_cast<int>(PeerType::INBOUND)}, false);
+                      {now, 121, static_cast<int>(PeerType::INBOUND)});
     peerManager.store(localhost(6),
-                      {now, 121, static_cast<int>(PeerType::OUTBOUND)}, false);
+                      {now, 121, static_cast<int>(PeerType::OUTBOUND)});
 
     auto peers = randomPeerSource.getRandomPeers(
         50, [](PeerBareAddress const&) { return true; });
@@ -517,11 +518,11 @@ TEST_CASE("purge peer table", "[overlay][PeerManager]")
         return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
     };
 
-    peerManager.store(localhost(1), record(1), false);
-    peerManager.store(localhost(2), record(2), false);
-    peerManager.store(localhost(3), record(3), false);
-    peerManager.store(localhost(4), record(4), false);
-    peerManager.store(localhost(5), record(5), false);
+    peerManager.store(localhost(1), record(1));
+    peerManager.store(localhost(2), record(2));
+    peerManager.store(localhost(3), record(3));
+    peerManager.store(localhost(4), record(4));
+    peerManager.store(localhost(5), record(5));
 
     peerManager.removePeersWithManyFailures(3);
     REQUIRE(peerManager.load(localhost(1)).second);
@@ -537,4 +538,44 @@ TEST_CASE("purge peer table", "[overlay][PeerManager]")
     peerManager.removePeersWithManyFailures(2, &localhost2);
     REQUIRE(!peerManager.load(localhost(2)).second);
 }
+
+TEST_CASE("peer table is flushed periodically", "[overlay][PeerManager]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.PEER_TABLE_FLUSH_PERIOD_MS = std::chrono::milliseconds(1000);
+    auto app = createTestApplication(clock, cfg);
+    auto& peerManager = app->getOverlayManager().getPeerManager();
+    auto countRows = [&]() {
+        int count = 0;
+        app->getDatabase().getSession() << "SELECT COUNT(*) FROM peers",
+            soci::into(count);
+        return count;
+    };
+    auto record = [](size_t numFailures) {
+        return PeerRecord{{}, numFailures, static_cast<int>(PeerType::INBOUND)};
+    };
+
+    peerManager.store(localhost(1), record(1));
+    peerManager.store(localhost(2), record(5));
+    REQUIRE(peerManager.load(localhost(1)).second);
+    REQUIRE(countRows() == 0);
+
+    testutil::crankFor(clock, std::chrono::seconds(2));
+    REQUIRE(countRows() == 2);
+
+    // Removed peers are deleted with the next flush too
+    peerManager.removePeersWithManyFailures(3);
+    REQUIRE(!peerManager.load(localhost(2)).second);
+    REQUIRE(countRows() == 2);
+    peerManager.update(localhost(1), PeerManager::BackOffUpdate::INCREASE);
+    peerManager.flush();
+    REQUIRE(countRows() == 1);
+
+    int numFailures = 0;
+    app->getDatabase().getSession()
+        << "SELECT numfailures FROM peers WHERE port = 1",
+        soci::into(numFailures);
+    REQUIRE(numFailures == 2);
+}
 }
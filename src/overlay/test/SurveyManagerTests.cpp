@@ -67,7 +67,8 @@ getSurveyResult(Application& node)
 std::shared_ptr<Simulation>
 setupStaticNetworkTopology(std::vector<Config>& configList,
                            std::vector<PublicKey>& keyList,
-                           std::vector<std::string>& keyStrList)
+                           std::vector<std::string>& keyStrList,
+                           bool backgroundProcessing = false)
 {
     enum
     {
@@ -85,6 +86,7 @@ setupStaticNetworkTopology(std::vector<Config>& configList,
     for (int i = A; i <= E; ++i)
     {
         auto cfg = simulation->newConfig();
+        cfg.BACKGROUND_SURVEY_PROCESSING = backgroundProcessing;
         configList.emplace_back(cfg);
 
         keyList.emplace_back(cfg.NODE_SEED.getPublicKey());
@@ -681,6 +683,53 @@ TEST_CASE("Time sliced static topology survey", "[overlay][survey][topology]")
     }
 }
 
+TEST_CASE("Time sliced survey with background processing",
+          "[overlay][survey][topology]")
+{
+    enum
+    {
+        A,
+        B,
+        C,
+        D, // not in transitive quorum
+        E
+    };
+    std::vector<Config> configList;
+    std::vector<PublicKey> keyList;
+    std::vector<std::string> keyStrList;
+    std::shared_ptr<Simulation> simulation =
+        setupStaticNetworkTopology(configList, keyList, keyStrList, true);
+
+    auto crankForSurvey = [&]() {
+        simulation->crankForAtLeast(
+            configList[A].getExpectedLedgerCloseTime() *
+                SurveyManager::SURVEY_THROTTLE_TIMEOUT_MULT * 2,
+            false);
+    };
+
+    uint32_t constexpr nonce = 0xDEADBEEF;
+    Application& surveyor = *simulation->getNode(keyList[A]);
+    startSurveyCollecting(surveyor, nonce);
+    simulation->crankForAtLeast(5min, false);
+    stopSurveyCollecting(surveyor, nonce);
+    simulation->crankForAtLeast(1min, false);
+
+    // B encrypts its response, and A decrypts it, on background threads
+    REQUIRE(surveyTopologyTimeSliced(surveyor, keyList[B], 0, 0));
+    REQUIRE(surveyTopologyTimeSliced(surveyor, keyList[C], 0, 0));
+    crankForSurvey();
+
+    auto result = getSurveyResult(surveyor);
+    REQUIRE(result["badResponseNodes"].isNull());
+    Json::Value topology = result["topology"];
+    REQUIRE(topology.size() == 2);
+    REQUIRE(topology[keyStrList[B]]["inboundPeers"][0]["nodeId"] ==
+            keyStrList[A]);
+    REQUIRE(topology[keyStrList[B]]["outboundPeers"].size() == 2);
+    REQUIRE(topology[keyStrList[C]]["inboundPeers"][0]["nodeId"] ==
+            keyStrList[B]);
+}
+
 // A time sliced survey with changing topology during the collecting phase
 TEST_CASE("Time sliced dynamic topology survey", "[overlay][survey][topology]")
 {
@@ -2,9 +2,12 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "herder/Herder.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "medida/histogram.h"
+#include "medida/metrics_registry.h"
 #include "overlay/OverlayManager.h"
 #include "overlay/PeerBareAddress.h"
 #include "overlay/PeerDoor.h"
@@ -53,4 +56,205 @@ TEST_CASE("TCPPeer can communicate", "[overlay][acceptance]")
     REQUIRE(p1->isAuthenticated());
     s->stopAllNodes();
 }
+
+TEST_CASE("TCPPeer decodes messages in background", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s =
+        std::make_shared<Simulation>(Simulation::OVER_TCP, networkID);
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet qset;
+    qset.threshold = 2;
+    qset.validators.push_back(v10SecretKey.getPublicKey());
+    qset.validators.push_back(v11SecretKey.getPublicKey());
+
+    Config cfg0 = getTestConfig(0);
+    Config cfg1 = getTestConfig(1);
+    cfg0.BACKGROUND_OVERLAY_DECODE = true;
+    cfg1.BACKGROUND_OVERLAY_DECODE = true;
+    auto n0 = s->addNode(v10SecretKey, qset, &cfg0);
+    auto n1 = s->addNode(v11SecretKey, qset, &cfg1);
+
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+
+    // Both nodes are needed to reach consensus, so all the SCP messages
+    // after the handshake went through the overlay thread
+    s->crankUntil([&]() { return s->haveAllExternalized(4, 1); },
+                  10 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    auto p0 = n0->getOverlayManager().getConnectedPeer(
+        PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT});
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticated());
+    s->stopAllNodes();
+}
+
+TEST_CASE("TCPPeer coalesces small writes", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s =
+        std::make_shared<Simulation>(Simulation::OVER_TCP, networkID);
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet qset;
+    qset.threshold = 1;
+    qset.validators.push_back(v10SecretKey.getPublicKey());
+    auto n0 = s->addNode(v10SecretKey, qset);
+    auto n1 = s->addNode(v11SecretKey, qset);
+
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = n0->getOverlayManager().getConnectedPeer(
+        PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT});
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticated());
+
+    auto& messages =
+        n0->getMetrics().NewHistogram({"overlay", "write-batch", "messages"});
+    auto& buffers =
+        n0->getMetrics().NewHistogram({"overlay", "write-batch", "buffers"});
+    messages.Clear();
+    buffers.Clear();
+
+    // The first message is written right away, and the others are queued
+    // behind it and then written together
+    size_t const n = 100;
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto msg = std::make_shared<StellarMessage>();
+        msg->type(GET_SCP_QUORUMSET);
+        msg->qSetHash() = sha256(std::to_string(i));
+        p0->sendMessage(msg);
+    }
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    REQUIRE(messages.max() >= n - 1);
+    REQUIRE(buffers.max() <= 2);
+    REQUIRE(p0->isAuthenticated());
+    s->stopAllNodes();
+}
+
+TEST_CASE("TCPPeer schedules pending messages by priority", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s =
+        std::make_shared<Simulation>(Simulation::OVER_TCP, networkID);
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet qset;
+    qset.threshold = 1;
+    qset.validators.push_back(v10SecretKey.getPublicKey());
+    Config cfg0 = getTestConfig(0);
+    Config cfg1 = getTestConfig(1);
+    cfg0.OUTBOUND_PRIORITY_SCHEDULING = true;
+    cfg1.OUTBOUND_PRIORITY_SCHEDULING = true;
+    auto n0 = s->addNode(v10SecretKey, qset, &cfg0);
+    auto n1 = s->addNode(v11SecretKey, qset, &cfg1);
+
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = std::dynamic_pointer_cast<TCPPeer>(
+        n0->getOverlayManager().getConnectedPeer(
+            PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT}));
+    REQUIRE(p0);
+    REQUIRE(p0->isAuthenticated());
+
+    // The first message goes to the socket right away, and the others wait
+    // for it in the queue of their priority
+    size_t const n = 50;
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto msg = std::make_shared<StellarMessage>();
+        msg->type(DONT_HAVE);
+        msg->dontHave().type = TX_SET;
+        msg->dontHave().reqHash = sha256(std::to_string(i));
+        p0->sendMessage(msg);
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto msg = std::make_shared<StellarMessage>();
+        msg->type(GET_SCP_QUORUMSET);
+        msg->qSetHash() = sha256(std::to_string(i));
+        p0->sendMessage(msg);
+    }
+    REQUIRE(p0->getPendingSendCount(0) == n);
+    REQUIRE(p0->getPendingSendCount(1) == n - 1);
+
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    for (size_t p = 0; p < 4; ++p)
+    {
+        REQUIRE(p0->getPendingSendCount(p) == 0);
+    }
+    // MACs were computed in the order messages were written, so the
+    // connection survives the reordering
+    REQUIRE(p0->isAuthenticated());
+    s->stopAllNodes();
+}
+
+#ifdef TCP_NOTSENT_LOWAT
+TEST_CASE("TCPPeer limits unsent socket bytes", "[overlay]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer s =
+        std::make_shared<Simulation>(Simulation::OVER_TCP, networkID);
+
+    auto v10SecretKey = SecretKey::fromSeed(sha256("v10"));
+    auto v11SecretKey = SecretKey::fromSeed(sha256("v11"));
+
+    SCPQuorumSet qset;
+    qset.threshold = 1;
+    qset.validators.push_back(v10SecretKey.getPublicKey());
+    Config cfg0 = getTestConfig(0);
+    Config cfg1 = getTestConfig(1);
+    cfg0.PEER_TCP_NOTSENT_LOWAT = 0x4000;
+    cfg1.PEER_TCP_NOTSENT_LOWAT = 0x4000;
+    auto n0 = s->addNode(v10SecretKey, qset, &cfg0);
+    auto n1 = s->addNode(v11SecretKey, qset, &cfg1);
+
+    s->addPendingConnection(v10SecretKey.getPublicKey(),
+                            v11SecretKey.getPublicKey());
+    s->startAllNodes();
+    s->crankForAtLeast(std::chrono::seconds(1), false);
+
+    auto p0 = std::dynamic_pointer_cast<TCPPeer>(
+        n0->getOverlayManager().getConnectedPeer(
+            PeerBareAddress{"127.0.0.1", n1->getConfig().PEER_PORT}));
+    auto p1 = std::dynamic_pointer_cast<TCPPeer>(
+        n1->getOverlayManager().getConnectedPeer(
+            PeerBareAddress{"127.0.0.1", n0->getConfig().PEER_PORT}));
+    REQUIRE(p0);
+    REQUIRE(p1);
+    REQUIRE(p0->isAuthenticated());
+    REQUIRE(p1->isAuthenticated());
+
+    // Both the connecting and the accepting side have it
+    for (auto const& p : {p0, p1})
+    {
+        asio::detail::socket_option::integer<IPPROTO_TCP, TCP_NOTSENT_LOWAT>
+            option;
+        asio::error_code ec;
+        std::ignore =
+            p->getSocketForTesting().next_layer().get_option(option, ec);
+        REQUIRE(!ec);
+        REQUIRE(option.value() == 0x4000);
+    }
+    s->stopAllNodes();
+}
+#endif
 }
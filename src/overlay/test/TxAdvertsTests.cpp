@@ -5,6 +5,9 @@
 #include "ledger/LedgerManager.h"
 #include "lib/catch.hpp"
 #include "main/Application.h"
+#include "medida/meter.h"
+#include "overlay/OverlayManager.h"
+#include "overlay/OverlayMetrics.h"
 #include "overlay/TxAdverts.h"
 #include "test/TestUtils.h"
 #include "test/test.h"
@@ -20,8 +23,11 @@ TEST_CASE("advert queue", "[flood][pullmode][acceptance]")
     TxAdverts pullMode(*app);
 
     bool flushed = false;
-    pullMode.start([&flushed](std::shared_ptr<StellarMessage const> msg) {
+    std::vector<Hash> flushedHashes;
+    pullMode.start([&](std::shared_ptr<StellarMessage const> msg) {
         flushed = true;
+        auto const& hashes = msg->floodAdvert().txHashes;
+        flushedHashes.insert(flushedHashes.end(), hashes.begin(), hashes.end());
     });
 
     auto limit = app->getLedgerManager().getLastMaxTxSetSizeOps();
@@ -128,6 +134,38 @@ TEST_CASE("advert queue", "[flood][pullmode][acceptance]")
 
             REQUIRE(pullMode.outgoingSize() == 0);
         }
+        SECTION("delayed adverts")
+        {
+            pullMode.queueDelayedOutgoingAdvert(getHash(0));
+            pullMode.queueDelayedOutgoingAdvert(getHash(1));
+            REQUIRE(pullMode.delayedSize() == 2);
+            REQUIRE(pullMode.outgoingSize() == 0);
+
+            // The peer advertises one of them to us in the meantime
+            pullMode.queueIncomingAdvert(TxAdvertVector{getHash(1)},
+                                         LedgerManager::GENESIS_LEDGER_SEQ);
+
+            // Not yet
+            testutil::crankFor(clock, cfg.FLOOD_ADVERT_PERIOD_MS);
+            REQUIRE(pullMode.delayedSize() == 2);
+            REQUIRE(!flushed);
+
+            testutil::crankFor(clock, std::chrono::seconds(1));
+            REQUIRE(pullMode.delayedSize() == 0);
+            REQUIRE(flushedHashes == std::vector<Hash>{getHash(0)});
+            REQUIRE(app->getOverlayManager()
+                        .getOverlayMetrics()
+                        .mSuppressedAdvertMeter.count() == 1);
+        }
+        SECTION("delayed adverts are capped")
+        {
+            for (uint32_t i = 0; i < limit + 1; i++)
+            {
+                pullMode.queueDelayedOutgoingAdvert(getHash(i));
+            }
+            REQUIRE(pullMode.delayedSize() == limit);
+            REQUIRE(pullMode.outgoingSize() == 1);
+        }
     }
 }
 }
@@ -44,13 +44,28 @@ class ProcessExitEvent
     void async_wait(std::function<void(asio::error_code)> const& handler);
 };
 
+// What a subprocess is run for. Each class but OTHER can be given a limit of
+// its own on how many run at once (MAX_CONCURRENT_*_SUBPROCESSES), so that a
+// backlog of one kind of command doesn't hold up the others; classes without
+// one share MAX_CONCURRENT_SUBPROCESSES. COMPRESSION and UPLOAD commands are
+// background work, run with a lower priority if configured to.
+enum class ProcessClass
+{
+    OTHER = 0,
+    DOWNLOAD,
+    COMPRESSION,
+    UPLOAD,
+    COUNT
+};
+
 class ProcessManager : public std::enable_shared_from_this<ProcessManager>,
                        public NonMovableOrCopyable
 {
   public:
     static std::shared_ptr<ProcessManager> create(Application& app);
     virtual std::weak_ptr<ProcessExitEvent>
-    runProcess(std::string const& cmdLine, std::string outputFile) = 0;
+    runProcess(std::string const& cmdLine, std::string outputFile,
+               ProcessClass processClass = ProcessClass::OTHER) = 0;
 
     // Return the number or processes we started and have not yet seen exits
     // for, _excluding_ those we're attempting to shut down / are shortly
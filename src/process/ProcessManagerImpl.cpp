@@ -18,7 +18,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Timer.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <fmt/format.h>
 
 #include <algorithm>
@@ -125,6 +125,19 @@ ProcessManager::create(Application& app)
     return std::make_shared<ProcessManagerImpl>(app);
 }
 
+static std::array<size_t, static_cast<size_t>(ProcessClass::COUNT)>
+classMaxProcesses(Config const& cfg)
+{
+    std::array<size_t, static_cast<size_t>(ProcessClass::COUNT)> res{};
+    res[static_cast<size_t>(ProcessClass::DOWNLOAD)] =
+        cfg.MAX_CONCURRENT_DOWNLOAD_SUBPROCESSES;
+    res[static_cast<size_t>(ProcessClass::COMPRESSION)] =
+        cfg.MAX_CONCURRENT_COMPRESSION_SUBPROCESSES;
+    res[static_cast<size_t>(ProcessClass::UPLOAD)] =
+        cfg.MAX_CONCURRENT_UPLOAD_SUBPROCESSES;
+    return res;
+}
+
 class ProcessExitEvent::Impl
     : public std::enable_shared_from_this<ProcessExitEvent::Impl>
 {
@@ -140,6 +153,9 @@ class ProcessExitEvent::Impl
 #endif
     std::weak_ptr<ProcessManagerImpl> mProcManagerImpl;
     int mProcessId{-1};
+    size_t mPool{0};
+    // Run with a lower priority, see ProcessClass
+    bool mBackground{false};
 
     Impl(std::shared_ptr<RealTimer> const& outerTimer,
          std::shared_ptr<asio::error_code> const& outerEc,
@@ -268,11 +284,14 @@ ProcessManagerImpl::shutdown()
         mIsShutdown = true;
 
         // Cancel all pending.
-        for (auto& pending : mPending)
+        for (auto& pool : mPending)
         {
-            pending->mImpl->cancel(ABORT_ERROR_CODE);
+            for (auto& pending : pool)
+            {
+                pending->mImpl->cancel(ABORT_ERROR_CODE);
+            }
+            pool.clear();
         }
-        mPending.clear();
 
         tryProcessShutdownAll();
     }
@@ -308,8 +327,9 @@ ProcessManagerImpl::tryProcessShutdown(std::shared_ptr<ProcessExitEvent> pe)
     {
     case ProcessLifecycle::PENDING:
     {
-        auto pendingIt = find(mPending.begin(), mPending.end(), pe);
-        if (pendingIt == mPending.end())
+        auto& pending = mPending.at(impl->mPool);
+        auto pendingIt = find(pending.begin(), pending.end(), pe);
+        if (pendingIt == pending.end())
         {
             CLOG_WARNING(Process, "Pending process not found in queue: {}",
                          impl->mCmdLine);
@@ -320,7 +340,7 @@ ProcessManagerImpl::tryProcessShutdown(std::shared_ptr<ProcessExitEvent> pe)
             releaseAssertOrThrow(*pendingIt == pe);
             CLOG_DEBUG(Process, "Cancelling pending: {}", impl->mCmdLine);
             impl->cancel(ABORT_ERROR_CODE);
-            mPending.erase(pendingIt);
+            pending.erase(pendingIt);
         }
         break;
     }
@@ -407,6 +427,9 @@ ProcessManagerImpl::handleProcessTermination(int pid, int status)
 
 ProcessManagerImpl::ProcessManagerImpl(Application& app)
     : mMaxProcesses(app.getConfig().MAX_CONCURRENT_SUBPROCESSES)
+    , mClassMaxProcesses(classMaxProcesses(app.getConfig()))
+    , mBackgroundNiceness(app.getConfig().BACKGROUND_SUBPROCESS_NICENESS)
+    , mBackgroundIdleIO(app.getConfig().BACKGROUND_SUBPROCESS_IDLE_IO)
     , mIOContext(app.getClock().getIOContext())
     , mSigChild(mIOContext)
     , mTmpDir(
@@ -546,13 +569,17 @@ ProcessExitEvent::Impl::run()
 
     iH.prepare();
 
+    DWORD priority = mBackground && manager->mBackgroundNiceness > 0
+                         ? BELOW_NORMAL_PRIORITY_CLASS
+                         : 0;
     if (!CreateProcess(NULL,    // No module name (use command line)
                        cmd,     // Command line
                        nullptr, // Process handle not inheritable
                        nullptr, // Thread handle not inheritable
                        TRUE,    // use iH to share handles
                        CREATE_NEW_PROCESS_GROUP | // Create a new process group
-                           EXTENDED_STARTUPINFO_PRESENT, // use STARTUPINFOEX
+                           EXTENDED_STARTUPINFO_PRESENT | // use STARTUPINFOEX
+                           priority, // lower for background commands
                        nullptr, // Use parent's environment block
                        nullptr, // Use parent's starting directory
                        &si,     // Pointer to STARTUPINFO structure
@@ -663,6 +690,9 @@ ProcessManagerImpl::forcedShutdown(std::shared_ptr<ProcessExitEvent> pe)
 
 ProcessManagerImpl::ProcessManagerImpl(Application& app)
     : mMaxProcesses(app.getConfig().MAX_CONCURRENT_SUBPROCESSES)
+    , mClassMaxProcesses(classMaxProcesses(app.getConfig()))
+    , mBackgroundNiceness(app.getConfig().BACKGROUND_SUBPROCESS_NICENESS)
+    , mBackgroundIdleIO(app.getConfig().BACKGROUND_SUBPROCESS_IDLE_IO)
     , mIOContext(app.getClock().getIOContext())
     , mSigChild(mIOContext, SIGCHLD)
     , mTmpDir(
@@ -784,7 +814,24 @@ ProcessExitEvent::Impl::run()
     releaseAssertOrThrow(manager && !manager->isShutdown());
     releaseAssertOrThrow(mLifecycle == ProcessLifecycle::PENDING);
 
-    std::vector<std::string> args = split(mCmdLine);
+    std::vector<std::string> args;
+    if (mBackground)
+    {
+        // posix_spawn has no way to set either, so the command is run by
+        // the usual tools that do
+        if (manager->mBackgroundNiceness > 0)
+        {
+            args = {"nice", "-n", std::to_string(manager->mBackgroundNiceness)};
+        }
+#ifdef __linux__
+        if (manager->mBackgroundIdleIO)
+        {
+            args.insert(args.end(), {"ionice", "-c", "3"});
+        }
+#endif
+    }
+    auto cmdArgs = split(mCmdLine);
+    args.insert(args.end(), cmdArgs.begin(), cmdArgs.end());
     std::vector<char*> argv;
     for (auto& a : args)
     {
@@ -837,7 +884,8 @@ ProcessExitEvent::Impl::run()
 #endif
 
 std::weak_ptr<ProcessExitEvent>
-ProcessManagerImpl::runProcess(std::string const& cmdLine, std::string outFile)
+ProcessManagerImpl::runProcess(std::string const& cmdLine, std::string outFile,
+                               ProcessClass processClass)
 {
     ZoneScoped;
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
@@ -852,12 +900,43 @@ ProcessManagerImpl::runProcess(std::string const& cmdLine, std::string outFile)
 
     pe->mImpl = std::make_shared<ProcessExitEvent::Impl>(
         pe->mTimer, pe->mEc, cmdLine, outFile, tempFile, weakSelf);
-    mPending.push_back(pe);
+    pe->mImpl->mPool = poolOf(processClass);
+    pe->mImpl->mBackground = processClass == ProcessClass::COMPRESSION ||
+                             processClass == ProcessClass::UPLOAD;
+    mPending.at(pe->mImpl->mPool).push_back(pe);
 
     maybeRunPendingProcesses();
     return std::weak_ptr<ProcessExitEvent>(pe);
 }
 
+size_t
+ProcessManagerImpl::poolOf(ProcessClass processClass) const
+{
+    auto pool = static_cast<size_t>(processClass);
+    releaseAssert(pool < NUM_POOLS);
+    return mClassMaxProcesses[pool] > 0
+               ? pool
+               : static_cast<size_t>(ProcessClass::OTHER);
+}
+
+size_t
+ProcessManagerImpl::poolLimit(size_t pool) const
+{
+    return pool == static_cast<size_t>(ProcessClass::OTHER)
+               ? mMaxProcesses
+               : mClassMaxProcesses[pool];
+}
+
+size_t
+ProcessManagerImpl::poolRunningOrShuttingDown(size_t pool)
+{
+    std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
+    return static_cast<size_t>(std::count_if(
+        mProcesses.begin(), mProcesses.end(), [pool](auto const& pe) {
+            return pe.second->mImpl->mPool == pool;
+        }));
+}
+
 void
 ProcessManagerImpl::maybeRunPendingProcesses()
 {
@@ -868,37 +947,47 @@ ProcessManagerImpl::maybeRunPendingProcesses()
         return;
     }
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
-    while (!mPending.empty() &&
-           getNumRunningOrShuttingDownProcesses() < mMaxProcesses)
+    for (size_t pool = 0; pool < NUM_POOLS; ++pool)
     {
-        auto i = mPending.front();
-        mPending.pop_front();
-        try
+        auto& pending = mPending[pool];
+        while (!pending.empty() &&
+               poolRunningOrShuttingDown(pool) < poolLimit(pool))
         {
-            CLOG_DEBUG(Process, "Running: {}", i->mImpl->mCmdLine);
+            auto i = pending.front();
+            pending.pop_front();
+            runPendingProcess(i);
+        }
+    }
+}
 
-            if (!i->mImpl->mOutFile.empty() && fs::exists(i->mImpl->mOutFile))
-            {
-                throw std::runtime_error(
-                    fmt::format(FMT_STRING("output file {} already exists"),
-                                i->mImpl->mOutFile));
-            }
+void
+ProcessManagerImpl::runPendingProcess(std::shared_ptr<ProcessExitEvent> i)
+{
+    try
+    {
+        CLOG_DEBUG(Process, "Running: {}", i->mImpl->mCmdLine);
 
-            i->mImpl->run();
-            auto pid = i->mImpl->getProcessId();
-            if (mProcesses.find(pid) != mProcesses.end())
-            {
-                throw std::runtime_error(fmt::format(
-                    FMT_STRING("process {:d} already exists"), pid));
-            }
-            mProcesses[pid] = i;
+        if (!i->mImpl->mOutFile.empty() && fs::exists(i->mImpl->mOutFile))
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("output file {} already exists"),
+                            i->mImpl->mOutFile));
         }
-        catch (std::runtime_error& e)
+
+        i->mImpl->run();
+        auto pid = i->mImpl->getProcessId();
+        if (mProcesses.find(pid) != mProcesses.end())
         {
-            i->mImpl->cancel(std::make_error_code(std::errc::io_error));
-            CLOG_ERROR(Process, "Error starting process: {}", e.what());
-            CLOG_ERROR(Process, "When running: {}", i->mImpl->mCmdLine);
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("process {:d} already exists"), pid));
         }
+        mProcesses[pid] = i;
+    }
+    catch (std::runtime_error& e)
+    {
+        i->mImpl->cancel(std::make_error_code(std::errc::io_error));
+        CLOG_ERROR(Process, "Error starting process: {}", e.what());
+        CLOG_ERROR(Process, "When running: {}", i->mImpl->mCmdLine);
     }
 }
 
@@ -906,14 +995,18 @@ void
 ProcessManagerImpl::checkInvariants()
 {
     std::lock_guard<std::recursive_mutex> guard(mProcessesMutex);
-    if (mIsShutdown)
+    for (size_t pool = 0; pool < NUM_POOLS; ++pool)
     {
-        releaseAssertOrThrow(mPending.empty());
-    }
-    for (auto const& pe : mPending)
-    {
-        releaseAssertOrThrow(pe->mImpl->mLifecycle ==
-                             ProcessLifecycle::PENDING);
+        if (mIsShutdown)
+        {
+            releaseAssertOrThrow(mPending[pool].empty());
+        }
+        for (auto const& pe : mPending[pool])
+        {
+            releaseAssertOrThrow(pe->mImpl->mLifecycle ==
+                                 ProcessLifecycle::PENDING);
+            releaseAssertOrThrow(pe->mImpl->mPool == pool);
+        }
     }
     for (auto const& pair : mProcesses)
     {
@@ -6,6 +6,7 @@
 
 #include "process/ProcessManager.h"
 #include "util/TmpDir.h"
+#include <array>
 #include <atomic>
 #include <deque>
 #include <mutex>
@@ -25,16 +26,32 @@ class ProcessManagerImpl : public ProcessManager
     // or in mPending (before it's launched).
     std::map<int, std::shared_ptr<ProcessExitEvent>> mProcesses;
 
+    static constexpr size_t NUM_POOLS =
+        static_cast<size_t>(ProcessClass::COUNT);
+
     bool mIsShutdown{false};
+    // Of the shared pool, that of OTHER and of the classes without a limit
     size_t const mMaxProcesses;
+    // Of each class, 0 when it uses the shared pool
+    std::array<size_t, NUM_POOLS> const mClassMaxProcesses;
+    // Applied to background commands
+    int const mBackgroundNiceness;
+    bool const mBackgroundIdleIO;
     asio::io_context& mIOContext;
     // These are only used on POSIX, but they're harmless here.
     asio::signal_set mSigChild;
     std::unique_ptr<TmpDir> mTmpDir;
     uint64_t mTempFileCount{0};
 
-    std::deque<std::shared_ptr<ProcessExitEvent>> mPending;
+    // Waiting processes by pool, a pool being numbered after the class it is
+    // the limit of, or OTHER for the shared one
+    std::array<std::deque<std::shared_ptr<ProcessExitEvent>>, NUM_POOLS>
+        mPending;
+    size_t poolOf(ProcessClass processClass) const;
+    size_t poolLimit(size_t pool) const;
+    size_t poolRunningOrShuttingDown(size_t pool);
     void maybeRunPendingProcesses();
+    void runPendingProcess(std::shared_ptr<ProcessExitEvent> pe);
     void checkInvariants();
 
     void startWaitingForSignalChild();
@@ -49,8 +66,9 @@ class ProcessManagerImpl : public ProcessManager
 
   public:
     explicit ProcessManagerImpl(Application& app);
-    std::weak_ptr<ProcessExitEvent> runProcess(std::string const& cmdLine,
-                                               std::string outFile) override;
+    std::weak_ptr<ProcessExitEvent>
+    runProcess(std::string const& cmdLine, std::string outFile,
+               ProcessClass processClass = ProcessClass::OTHER) override;
     size_t getNumRunningProcesses() override;
     size_t getNumRunningOrShuttingDownProcesses() override;
 
@@ -16,6 +16,7 @@
 #include "xdrpp/autocheck.h"
 #include <chrono>
 #include <fmt/format.h>
+#include <fstream>
 #include <future>
 #include <thread>
 
@@ -290,3 +291,85 @@ TEST_CASE("ProcessManager::tryProcessShutdown test", "[process]")
     }
     REQUIRE(errorCode == asio::error::operation_aborted);
 }
+
+TEST_CASE("subprocess classes have their own limits", "[process]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.MAX_CONCURRENT_SUBPROCESSES = 1;
+    cfg.MAX_CONCURRENT_UPLOAD_SUBPROCESSES = 1;
+    auto app = createTestApplication(clock, cfg);
+    auto& pm = app->getProcessManager();
+
+#ifdef _WIN32
+    std::string command = "waitfor /T 10 pause";
+#else
+    std::string command = "sleep 10";
+#endif
+    // The second waits for the first in the shared pool
+    auto first = pm.runProcess(command, "").lock();
+    auto second = pm.runProcess(command, "", ProcessClass::DOWNLOAD).lock();
+    REQUIRE(first);
+    REQUIRE(second);
+    REQUIRE(pm.getNumRunningProcesses() == 1);
+
+    // An upload doesn't
+    bool exited = false;
+    asio::error_code errorCode;
+    auto upload = pm.runProcess("hostname", "", ProcessClass::UPLOAD).lock();
+    REQUIRE(upload);
+    REQUIRE(pm.getNumRunningProcesses() == 2);
+    upload->async_wait([&](asio::error_code ec) {
+        errorCode = ec;
+        exited = true;
+    });
+    while (!exited && !clock.getIOContext().stopped())
+    {
+        clock.crank(true);
+    }
+    REQUIRE(!errorCode);
+    REQUIRE(pm.getNumRunningProcesses() == 1);
+
+    // Cancelling the pending one leaves the shared pool as it is
+    REQUIRE(pm.tryProcessShutdown(second));
+    REQUIRE(pm.getNumRunningProcesses() == 1);
+    pm.shutdown();
+}
+
+#ifndef _WIN32
+TEST_CASE("background subprocesses run niced", "[process]")
+{
+    VirtualClock clock;
+    auto cfg = getTestConfig();
+    cfg.BACKGROUND_SUBPROCESS_NICENESS = 5;
+    auto app = createTestApplication(clock, cfg);
+    auto& pm = app->getProcessManager();
+    TmpDir dir = app->getTmpDirManager().tmpDir("niceness");
+
+    // `nice` alone prints the niceness it runs with
+    auto niceness = [&](ProcessClass processClass, std::string const& name) {
+        auto out = dir.getName() + "/" + name;
+        bool exited = false;
+        asio::error_code errorCode;
+        auto evt = pm.runProcess("nice", out, processClass).lock();
+        REQUIRE(evt);
+        evt->async_wait([&](asio::error_code ec) {
+            errorCode = ec;
+            exited = true;
+        });
+        while (!exited && !clock.getIOContext().stopped())
+        {
+            clock.crank(true);
+        }
+        REQUIRE(!errorCode);
+        std::ifstream in(out);
+        int n = -1;
+        in >> n;
+        return n;
+    };
+    auto base = niceness(ProcessClass::OTHER, "other");
+    REQUIRE(niceness(ProcessClass::DOWNLOAD, "download") == base);
+    REQUIRE(niceness(ProcessClass::COMPRESSION, "compression") ==
+            std::min(base + 5, 19));
+}
+#endif
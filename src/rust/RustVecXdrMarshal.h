@@ -10,6 +10,8 @@
 // This is a good thing to do especially if you're returning serialized XDR over
 // the rust bridge, since most Rust code is doing to produce a rust::Vec, not a
 // std::vector / CxxVector. Avoids more redundant byte-copies.
+//
+// It also provides toCxxBuf, for the opposite direction.
 
 #include "rust/RustBridge.h"
 
@@ -24,3 +26,22 @@ void bytes_to_void(const rust::Vec<uint8_t>&);
 }
 
 #include <xdrpp/xdrpp/marshal.h>
+
+#include "util/XDRUncheckedPut.h"
+
+#include <memory>
+#include <vector>
+
+namespace stellar
+{
+// Serializes `t` straight into the buffer handed to Rust, rather than into an
+// opaque_vec that is then copied into it.
+template <typename T>
+CxxBuf
+toCxxBuf(T const& t)
+{
+    auto buf = std::make_unique<std::vector<uint8_t>>(xdr::xdr_size(t));
+    xdrPutUnchecked(t, buf->data(), buf->data() + buf->size());
+    return CxxBuf{std::move(buf)};
+}
+}
@@ -65,6 +65,20 @@ impl From<CxxTransactionResources> for TransactionResources {
     }
 }
 
+impl From<&CxxTransactionResources> for TransactionResources {
+    fn from(value: &CxxTransactionResources) -> Self {
+        Self {
+            instructions: value.instructions,
+            read_entries: value.read_entries,
+            write_entries: value.write_entries,
+            read_bytes: value.read_bytes,
+            write_bytes: value.write_bytes,
+            contract_events_size_bytes: value.contract_events_size_bytes,
+            transaction_size_bytes: value.transaction_size_bytes,
+        }
+    }
+}
+
 impl From<CxxFeeConfiguration> for FeeConfiguration {
     fn from(value: CxxFeeConfiguration) -> Self {
         Self {
@@ -476,6 +490,24 @@ pub(crate) fn compute_transaction_resource_fee(
     }
 }
 
+pub(crate) fn compute_transaction_resource_fees(
+    tx_resources: &Vec<CxxTransactionResources>,
+    fee_config: CxxFeeConfiguration,
+) -> Vec<FeePair> {
+    let fee_config: FeeConfiguration = fee_config.into();
+    tx_resources
+        .iter()
+        .map(|r| {
+            let (non_refundable_fee, refundable_fee) =
+                host_compute_transaction_resource_fee(&r.into(), &fee_config);
+            FeePair {
+                non_refundable_fee,
+                refundable_fee,
+            }
+        })
+        .collect()
+}
+
 pub(crate) fn compute_rent_fee(
     changed_entries: &Vec<CxxLedgerEntryRentChange>,
     fee_config: CxxRentFeeConfiguration,
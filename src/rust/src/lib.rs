@@ -256,6 +256,15 @@ mod rust_bridge {
             fee_config: CxxFeeConfiguration,
         ) -> Result<FeePair>;
 
+        // Computes the resource fees of a batch of transactions under the
+        // same network configuration, in the order of `tx_resources`.
+        fn compute_transaction_resource_fees(
+            config_max_protocol: u32,
+            protocol_version: u32,
+            tx_resources: &Vec<CxxTransactionResources>,
+            fee_config: CxxFeeConfiguration,
+        ) -> Result<Vec<FeePair>>;
+
         // Computes the write fee per 1kb written to the ledger given the
         // current bucket list size and network configuration.
         fn compute_write_fee_per_1kb(
@@ -859,6 +868,32 @@ pub(crate) fn compute_transaction_resource_fee(
     ))
 }
 
+pub(crate) fn compute_transaction_resource_fees(
+    config_max_protocol: u32,
+    protocol_version: u32,
+    tx_resources: &Vec<CxxTransactionResources>,
+    fee_config: CxxFeeConfiguration,
+) -> Result<Vec<FeePair>, Box<dyn std::error::Error>> {
+    if protocol_version > config_max_protocol {
+        return Err(Box::new(soroban_curr::contract::CoreHostError::General(
+            "unsupported protocol",
+        )));
+    }
+    #[cfg(feature = "soroban-env-host-prev")]
+    {
+        if protocol_version == config_max_protocol - 1 {
+            return Ok(soroban_prev::contract::compute_transaction_resource_fees(
+                tx_resources,
+                fee_config,
+            ));
+        }
+    }
+    Ok(soroban_curr::contract::compute_transaction_resource_fees(
+        tx_resources,
+        fee_config,
+    ))
+}
+
 pub(crate) fn compute_rent_fee(
     config_max_protocol: u32,
     protocol_version: u32,
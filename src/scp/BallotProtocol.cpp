@@ -12,8 +12,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <functional>
 #include <numeric>
 #include <sstream>
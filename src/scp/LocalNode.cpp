@@ -8,17 +8,131 @@
 #include "crypto/SecretKey.h"
 #include "lib/json/json.h"
 #include "scp/QuorumSetUtils.h"
+#include "util/BitSet.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/UnorderedMap.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <functional>
 
 namespace stellar
 {
+namespace
+{
+// A quorum set in which validators are replaced by their indices among the
+// nodes of an envelope map, so that thresholds are checked by counting the
+// bits it shares with a set of those nodes. Validators that aren't in the map
+// can never be in such a set, so only their number is kept. Sane quorum sets
+// have no duplicate validators, so counting bits matches counting validators.
+struct IndexedQSet
+{
+    uint32 mThreshold;
+    size_t mSize;
+    BitSet mValidators;
+    std::vector<IndexedQSet> mInnerSets;
+
+    IndexedQSet(SCPQuorumSet const& qset,
+                UnorderedMap<NodeID, size_t> const& indices)
+        : mThreshold(qset.threshold)
+        , mSize(qset.validators.size() + qset.innerSets.size())
+        , mValidators(indices.size())
+    {
+        for (auto const& validator : qset.validators)
+        {
+            auto it = indices.find(validator);
+            if (it != indices.end())
+            {
+                mValidators.set(it->second);
+            }
+        }
+        mInnerSets.reserve(qset.innerSets.size());
+        for (auto const& inner : qset.innerSets)
+        {
+            mInnerSets.emplace_back(inner, indices);
+        }
+    }
+
+    // Same as LocalNode::isQuorumSliceInternal, which never meets a
+    // threshold of 0
+    bool
+    isQuorumSlice(BitSet const& nodes) const
+    {
+        if (mThreshold == 0)
+        {
+            return false;
+        }
+        size_t found = nodes.intersectionCount(mValidators);
+        if (found >= mThreshold)
+        {
+            return true;
+        }
+        size_t thresholdLeft = mThreshold - found;
+        for (auto const& inner : mInnerSets)
+        {
+            if (inner.isQuorumSlice(nodes) && --thresholdLeft == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Same as LocalNode::isVBlockingInternal
+    bool
+    isVBlocking(BitSet const& nodes) const
+    {
+        // There is no v-blocking set for {\empty}
+        if (mThreshold == 0)
+        {
+            return false;
+        }
+        int64_t leftTillBlock =
+            static_cast<int64_t>(1 + mSize) - static_cast<int64_t>(mThreshold);
+        auto found =
+            static_cast<int64_t>(nodes.intersectionCount(mValidators));
+        if (found > 0 && found >= leftTillBlock)
+        {
+            return true;
+        }
+        leftTillBlock -= found;
+        for (auto const& inner : mInnerSets)
+        {
+            if (inner.isVBlocking(nodes) && --leftTillBlock <= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Indexes the nodes of `map` by their position in it, and sets the bits of
+// those whose statement passes `filter` in `nodes`.
+UnorderedMap<NodeID, size_t>
+indexNodes(std::map<NodeID, SCPEnvelopeWrapperPtr> const& map,
+           std::function<bool(SCPStatement const&)> const& filter,
+           BitSet& nodes)
+{
+    UnorderedMap<NodeID, size_t> indices;
+    indices.reserve(map.size());
+    nodes = BitSet(map.size());
+    for (auto const& it : map)
+    {
+        size_t i = indices.size();
+        indices.emplace(it.first, i);
+        if (filter(it.second->getStatement()))
+        {
+            nodes.set(i);
+        }
+    }
+    return indices;
+}
+}
+
 LocalNode::LocalNode(NodeID const& nodeID, bool isValidator,
                      SCPQuorumSet const& qSet, SCPDriver& driver)
     : mNodeID(nodeID), mIsValidator(isValidator), mQSet(qSet), mDriver(driver)
@@ -227,16 +341,9 @@ LocalNode::isVBlocking(SCPQuorumSet const& qSet,
                        std::function<bool(SCPStatement const&)> const& filter)
 {
     ZoneScoped;
-    std::vector<NodeID> pNodes;
-    for (auto const& it : map)
-    {
-        if (filter(it.second->getStatement()))
-        {
-            pNodes.push_back(it.first);
-        }
-    }
-
-    return isVBlocking(qSet, pNodes);
+    BitSet nodes;
+    auto indices = indexNodes(map, filter, nodes);
+    return IndexedQSet(qSet, indices).isVBlocking(nodes);
 }
 
 bool
@@ -247,38 +354,53 @@ LocalNode::isQuorum(
     std::function<bool(SCPStatement const&)> const& filter)
 {
     ZoneScoped;
-    std::vector<NodeID> pNodes;
+    BitSet nodes;
+    auto indices = indexNodes(map, filter, nodes);
+
+    // Index the quorum set of every node that passed the filter. Nodes
+    // usually share quorum sets, which are then only indexed once.
+    std::vector<SCPQuorumSetPtr> qSets;
+    std::unordered_map<SCPQuorumSet const*, IndexedQSet> indexedQSets;
+    std::vector<IndexedQSet const*> nodeQSets(map.size(), nullptr);
+    size_t i = 0;
     for (auto const& it : map)
     {
-        if (filter(it.second->getStatement()))
+        if (nodes.get(i))
         {
-            pNodes.push_back(it.first);
+            auto qSetPtr = qfun(it.second->getStatement());
+            if (qSetPtr)
+            {
+                auto indexed = indexedQSets.find(qSetPtr.get());
+                if (indexed == indexedQSets.end())
+                {
+                    indexed = indexedQSets
+                                  .emplace(qSetPtr.get(),
+                                           IndexedQSet(*qSetPtr, indices))
+                                  .first;
+                    qSets.emplace_back(qSetPtr);
+                }
+                nodeQSets[i] = &indexed->second;
+            }
         }
+        ++i;
     }
 
     size_t count = 0;
     do
     {
-        count = pNodes.size();
-        std::vector<NodeID> fNodes(pNodes.size());
-        auto quorumFilter = [&](NodeID nodeID) -> bool {
-            auto qSetPtr = qfun(map.find(nodeID)->second->getStatement());
-            if (qSetPtr)
-            {
-                return isQuorumSlice(*qSetPtr, pNodes);
-            }
-            else
+        count = nodes.count();
+        BitSet filtered(nodes);
+        for (size_t j = 0; nodes.nextSet(j); ++j)
+        {
+            if (!nodeQSets[j] || !nodeQSets[j]->isQuorumSlice(nodes))
             {
-                return false;
+                filtered.unset(j);
             }
-        };
-        auto it = std::copy_if(pNodes.begin(), pNodes.end(), fNodes.begin(),
-                               quorumFilter);
-        fNodes.resize(std::distance(fNodes.begin(), it));
-        pNodes = fNodes;
-    } while (count != pNodes.size());
-
-    return isQuorumSlice(qSet, pNodes);
+        }
+        nodes = filtered;
+    } while (count != nodes.count());
+
+    return IndexedQSet(qSet, indices).isQuorumSlice(nodes);
 }
 
 std::vector<NodeID>
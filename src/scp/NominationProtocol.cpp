@@ -12,8 +12,8 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 #include <algorithm>
 #include <functional>
 
@@ -22,7 +22,11 @@ namespace stellar
 using namespace std::placeholders;
 
 NominationProtocol::NominationProtocol(Slot& slot)
-    : mSlot(slot), mRoundNumber(0), mNominationStarted(false), mTimerExpCount(0)
+    : mSlot(slot)
+    , mRoundNumber(0)
+    , mNominationStarted(false)
+    , mValueHashesRound(0)
+    , mTimerExpCount(0)
 {
 }
 
@@ -217,21 +221,36 @@ NominationProtocol::applyAll(SCPNomination const& nom,
 }
 
 void
-NominationProtocol::updateRoundLeaders()
+NominationProtocol::updateLeaderWeights()
 {
     ZoneScoped;
-    SCPQuorumSet myQSet = mSlot.getLocalNode()->getQuorumSet();
+    auto const& qSetHash = mSlot.getLocalNode()->getQuorumSetHash();
+    if (mLeaderWeightsQSetHash && *mLeaderWeightsQSetHash == qSetHash)
+    {
+        return;
+    }
 
+    SCPQuorumSet myQSet = mSlot.getLocalNode()->getQuorumSet();
     auto localID = mSlot.getLocalNode()->getNodeID();
     normalizeQSet(myQSet, &localID); // excludes self
 
-    size_t maxLeaderCount = 1; // includes self
     // note that node IDs here are unique ("sane"), so we can count by
     // enumeration
+    mLeaderWeights.clear();
     LocalNode::forAllNodes(myQSet, [&](NodeID const& cur) {
-        ++maxLeaderCount;
+        mLeaderWeights.emplace_back(cur, LocalNode::getNodeWeight(cur, myQSet));
         return true;
     });
+    mLeaderWeightsQSetHash = qSetHash;
+}
+
+void
+NominationProtocol::updateRoundLeaders()
+{
+    ZoneScoped;
+    updateLeaderWeights();
+    auto localID = mSlot.getLocalNode()->getNodeID();
+    size_t maxLeaderCount = mLeaderWeights.size() + 1; // includes self
 
     while (mRoundLeaders.size() < maxLeaderCount)
     {
@@ -239,10 +258,12 @@ NominationProtocol::updateRoundLeaders()
         std::set<NodeID> newRoundLeaders;
 
         newRoundLeaders.insert(localID);
-        uint64 topPriority = getNodePriority(localID, myQSet);
+        // local node is in all quorum sets
+        uint64 topPriority = getNodePriority(localID, UINT64_MAX);
 
-        LocalNode::forAllNodes(myQSet, [&](NodeID const& cur) {
-            uint64 w = getNodePriority(cur, myQSet);
+        for (auto const& nw : mLeaderWeights)
+        {
+            uint64 w = getNodePriority(nw.first, nw.second);
             if (w > topPriority)
             {
                 topPriority = w;
@@ -250,10 +271,9 @@ NominationProtocol::updateRoundLeaders()
             }
             if (w == topPriority && w > 0)
             {
-                newRoundLeaders.insert(cur);
+                newRoundLeaders.insert(nw.first);
             }
-            return true;
-        });
+        }
         // expand mRoundLeaders with the newly computed leaders
         auto oldSize = mRoundLeaders.size();
         mRoundLeaders.insert(newRoundLeaders.begin(), newRoundLeaders.end());
@@ -296,16 +316,25 @@ NominationProtocol::hashValue(Value const& value)
 {
     ZoneScoped;
     dbgAssert(!mPreviousValue.empty());
-    return mSlot.getSCPDriver().computeValueHash(
-        mSlot.getSlotIndex(), mPreviousValue, mRoundNumber, value);
+    if (mValueHashesRound != mRoundNumber)
+    {
+        mValueHashes.clear();
+        mValueHashesRound = mRoundNumber;
+    }
+    auto it = mValueHashes.find(value);
+    if (it == mValueHashes.end())
+    {
+        auto h = mSlot.getSCPDriver().computeValueHash(
+            mSlot.getSlotIndex(), mPreviousValue, mRoundNumber, value);
+        it = mValueHashes.emplace(value, h).first;
+    }
+    return it->second;
 }
 
 uint64
 NominationProtocol::getNodePriority(NodeID const& nodeID,
                                     SCPQuorumSet const& qset)
 {
-    ZoneScoped;
-    uint64 res;
     uint64 w;
 
     if (nodeID == mSlot.getLocalNode()->getNodeID())
@@ -317,6 +346,14 @@ NominationProtocol::getNodePriority(NodeID const& nodeID,
     {
         w = LocalNode::getNodeWeight(nodeID, qset);
     }
+    return getNodePriority(nodeID, w);
+}
+
+uint64
+NominationProtocol::getNodePriority(NodeID const& nodeID, uint64 w)
+{
+    ZoneScoped;
+    uint64 res;
 
     // if w > 0; w is inclusive here as
     // 0 <= hashNode <= UINT64_MAX
@@ -551,7 +588,11 @@ NominationProtocol::nominate(ValueWrapperPtr value, Value const& previousValue,
 
     mNominationStarted = true;
 
-    mPreviousValue = previousValue;
+    if (mPreviousValue != previousValue)
+    {
+        mPreviousValue = previousValue;
+        mValueHashes.clear();
+    }
 
     mRoundNumber++;
     updateRoundLeaders();
@@ -7,7 +7,9 @@
 #include "lib/json/json-forwards.h"
 #include "scp/SCP.h"
 #include <functional>
+#include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
@@ -40,6 +42,15 @@ class NominationProtocol
     // the value from the previous slot
     Value mPreviousValue;
 
+    // nodes of the normalized local quorum set, excluding self, with their
+    // weight, for the local quorum set mLeaderWeightsQSetHash
+    std::vector<std::pair<NodeID, uint64>> mLeaderWeights;
+    std::optional<Hash> mLeaderWeightsQSetHash;
+
+    // memoized hashValue results for mValueHashesRound
+    std::map<Value, uint64> mValueHashes;
+    int32 mValueHashesRound;
+
     bool isNewerStatement(NodeID const& nodeID, SCPNomination const& st);
 
     // returns true if 'p' is a subset of 'v'
@@ -75,6 +86,10 @@ class NominationProtocol
     uint64 hashValue(Value const& value);
 
     uint64 getNodePriority(NodeID const& nodeID, SCPQuorumSet const& qset);
+    uint64 getNodePriority(NodeID const& nodeID, uint64 weight);
+
+    // recomputes mLeaderWeights if the local quorum set changed
+    void updateLeaderWeights();
 
     // returns the highest value that we don't have yet, that we should
     // vote for, extracted from a nomination.
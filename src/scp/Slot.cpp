@@ -146,11 +146,73 @@ Slot::getExternalizingState() const
     return mBallotProtocol.getExternalizingState();
 }
 
+void
+Slot::forEachStatementValue(SCPStatement& st,
+                            std::function<void(Value&)> const& f)
+{
+    switch (st.pledges.type())
+    {
+    case SCP_ST_PREPARE:
+    {
+        auto& prep = st.pledges.prepare();
+        f(prep.ballot.value);
+        if (prep.prepared)
+        {
+            f(prep.prepared->value);
+        }
+        if (prep.preparedPrime)
+        {
+            f(prep.preparedPrime->value);
+        }
+    }
+    break;
+    case SCP_ST_CONFIRM:
+        f(st.pledges.confirm().ballot.value);
+        break;
+    case SCP_ST_EXTERNALIZE:
+        f(st.pledges.externalize().commit.value);
+        break;
+    case SCP_ST_NOMINATE:
+    {
+        auto& nom = st.pledges.nominate();
+        for (auto& v : nom.votes)
+        {
+            f(v);
+        }
+        for (auto& v : nom.accepted)
+        {
+            f(v);
+        }
+    }
+    break;
+    default:
+        dbgAbort();
+    }
+}
+
+SCPStatement
+Slot::getHistoricalStatement(HistoricalStatement const& hs)
+{
+    SCPStatement st = hs.mStatement;
+    size_t i = 0;
+    forEachStatementValue(st, [&](Value& v) { v = *hs.mValues.at(i++); });
+    return st;
+}
+
 void
 Slot::recordStatement(SCPStatement const& st)
 {
-    mStatementsHistory.emplace_back(
-        HistoricalStatement{std::time(nullptr), st, mFullyValidated});
+    HistoricalStatement hs{std::time(nullptr), st, {}, mFullyValidated};
+    forEachStatementValue(hs.mStatement, [&](Value& v) {
+        auto it = mHistoryValues.find(v);
+        if (it == mHistoryValues.end())
+        {
+            it = mHistoryValues.emplace(std::move(v)).first;
+        }
+        hs.mValues.emplace_back(&*it);
+        v.clear();
+    });
+    mStatementsHistory.emplace_back(std::move(hs));
     CLOG_DEBUG(SCP, "new statement:  i: {} st: {} validated: {}",
                getSlotIndex(), mSCP.envToStr(st, false),
                (mFullyValidated ? "true" : "false"));
@@ -345,12 +407,12 @@ Slot::getJsonInfo(bool fullKeys)
     for (auto const& item : mStatementsHistory)
     {
         Json::Value& v = ret["statements"][count++];
+        auto st = getHistoricalStatement(item);
         v.append((Json::UInt64)item.mWhen);
-        v.append(mSCP.envToStr(item.mStatement, fullKeys));
+        v.append(mSCP.envToStr(st, fullKeys));
         v.append(item.mValidated);
 
-        Hash const& qSetHash =
-            getCompanionQuorumSetHashFromStatement(item.mStatement);
+        Hash const& qSetHash = getCompanionQuorumSetHashFromStatement(st);
         auto qSet = getSCPDriver().getQSet(qSetHash);
         if (qSet)
         {
@@ -33,14 +33,28 @@ class Slot : public std::enable_shared_from_this<Slot>
 
     // keeps track of all statements seen so far for this slot.
     // it is used for debugging purpose
+    // values are stored once in mHistoryValues: mStatement has its values
+    // cleared and mValues points to them, in the order visited by
+    // forEachStatementValue. Successive nominations from a node repeat all
+    // the values it voted for or accepted before, and ballot statements from
+    // all nodes usually carry the same value.
     struct HistoricalStatement
     {
         time_t mWhen;
         SCPStatement mStatement;
+        std::vector<Value const*> mValues;
         bool mValidated;
     };
 
     std::vector<HistoricalStatement> mStatementsHistory;
+    std::set<Value> mHistoryValues;
+
+    // calls f on each value in the statement
+    static void forEachStatementValue(SCPStatement& st,
+                                      std::function<void(Value&)> const& f);
+
+    // rebuilds the statement recorded in mStatementsHistory
+    static SCPStatement getHistoricalStatement(HistoricalStatement const& hs);
 
     // true if the Slot was fully validated
     bool mFullyValidated;
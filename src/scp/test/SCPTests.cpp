@@ -6,6 +6,7 @@
 #include "crypto/Hex.h"
 #include "crypto/SHA.h"
 #include "lib/catch.hpp"
+#include "lib/json/json.h"
 #include "scp/LocalNode.h"
 #include "scp/SCP.h"
 #include "scp/Slot.h"
@@ -476,6 +477,128 @@ TEST_CASE("vblocking and quorum", "[scp]")
     REQUIRE(LocalNode::isVBlocking(qSet, nodeSet) == true);
 }
 
+TEST_CASE("vblocking and quorum over envelopes", "[scp]")
+{
+    setupValues();
+    SIMULATION_CREATE_NODE(0);
+    SIMULATION_CREATE_NODE(1);
+    SIMULATION_CREATE_NODE(2);
+    SIMULATION_CREATE_NODE(3);
+
+    // 3 of {v0, v1, v2, v3}
+    auto qSet = std::make_shared<SCPQuorumSet>();
+    qSet->threshold = 3;
+    qSet->validators = {v0NodeID, v1NodeID, v2NodeID, v3NodeID};
+
+    // 2 of {v0, 1 of {v1, v2}}
+    auto innerQSet = std::make_shared<SCPQuorumSet>();
+    innerQSet->threshold = 2;
+    innerQSet->validators = {v0NodeID};
+    innerQSet->innerSets.resize(1);
+    innerQSet->innerSets[0].threshold = 1;
+    innerQSet->innerSets[0].validators = {v1NodeID, v2NodeID};
+
+    std::map<NodeID, SCPEnvelopeWrapperPtr> envs;
+    for (auto const& id : {v0NodeID, v1NodeID, v2NodeID, v3NodeID})
+    {
+        SCPEnvelope env;
+        env.statement.nodeID = id;
+        env.statement.pledges.type(SCP_ST_NOMINATE);
+        envs.emplace(id, std::make_shared<SCPEnvelopeWrapper>(env));
+    }
+
+    auto among = [](std::set<NodeID> nodes) {
+        return [nodes](SCPStatement const& st) {
+            return nodes.find(st.nodeID) != nodes.end();
+        };
+    };
+    SCPQuorumSetPtr nodeQSet = qSet;
+    NodeID const* withoutQSet = nullptr;
+    auto qfun = [&](SCPStatement const& st) {
+        return withoutQSet && st.nodeID == *withoutQSet ? nullptr : nodeQSet;
+    };
+
+    REQUIRE(!LocalNode::isVBlocking(*qSet, envs, among({v0NodeID})));
+    REQUIRE(LocalNode::isVBlocking(*qSet, envs, among({v0NodeID, v2NodeID})));
+    REQUIRE(LocalNode::isVBlocking(*qSet, envs));
+
+    REQUIRE(
+        !LocalNode::isQuorum(*qSet, envs, qfun, among({v0NodeID, v2NodeID})));
+    REQUIRE(LocalNode::isQuorum(*qSet, envs, qfun,
+                                among({v0NodeID, v2NodeID, v3NodeID})));
+    REQUIRE(LocalNode::isQuorum(*qSet, envs, qfun));
+
+    // A node without a quorum set is never part of a quorum
+    withoutQSet = &v3NodeID;
+    REQUIRE(!LocalNode::isQuorum(*qSet, envs, qfun,
+                                 among({v0NodeID, v2NodeID, v3NodeID})));
+    REQUIRE(LocalNode::isQuorum(*qSet, envs, qfun));
+    withoutQSet = nullptr;
+
+    nodeQSet = innerQSet;
+    REQUIRE(!LocalNode::isVBlocking(*innerQSet, envs, among({v1NodeID})));
+    REQUIRE(LocalNode::isVBlocking(*innerQSet, envs,
+                                   among({v1NodeID, v2NodeID})));
+    REQUIRE(LocalNode::isQuorum(*innerQSet, envs, qfun,
+                                among({v0NodeID, v2NodeID})));
+    REQUIRE(!LocalNode::isQuorum(*innerQSet, envs, qfun,
+                                 among({v1NodeID, v2NodeID})));
+}
+
+TEST_CASE("statement history shares values", "[scp]")
+{
+    setupValues();
+    SIMULATION_CREATE_NODE(0);
+    SIMULATION_CREATE_NODE(1);
+    SIMULATION_CREATE_NODE(2);
+    SIMULATION_CREATE_NODE(3);
+
+    SCPQuorumSet qSet;
+    qSet.threshold = 3;
+    qSet.validators = {v0NodeID, v1NodeID, v2NodeID, v3NodeID};
+    uint256 qSetHash = sha256(xdr::xdr_to_opaque(qSet));
+
+    TestSCP scp(v0SecretKey.getPublicKey(), qSet);
+    scp.storeQuorumSet(std::make_shared<SCPQuorumSet>(qSet));
+    REQUIRE(scp.nominate(0, xValue, false));
+
+    // successive nominations repeat the earlier values
+    std::vector<SCPEnvelope> received;
+    std::vector<Value> votes = {xValue};
+    std::vector<Value> accepted;
+    received.emplace_back(
+        makeNominate(v1SecretKey, qSetHash, 0, votes, accepted));
+    votes.emplace_back(yValue);
+    received.emplace_back(
+        makeNominate(v1SecretKey, qSetHash, 0, votes, accepted));
+    accepted.emplace_back(xValue);
+    received.emplace_back(
+        makeNominate(v2SecretKey, qSetHash, 0, votes, accepted));
+    for (auto const& env : received)
+    {
+        scp.receiveEnvelope(env);
+    }
+
+    std::set<std::string> expected;
+    for (auto const& env : received)
+    {
+        expected.emplace(scp.mSCP.envToStr(env.statement, true));
+    }
+    for (auto const& env : scp.mEnvs)
+    {
+        expected.emplace(scp.mSCP.envToStr(env.statement, true));
+    }
+
+    auto& slot = scp.getSlot(0);
+    REQUIRE(slot.getStatementCount() == received.size() + scp.mEnvs.size());
+    auto statements = slot.getJsonInfo(true)["statements"];
+    REQUIRE(statements.size() == slot.getStatementCount());
+    for (auto const& st : statements)
+    {
+        REQUIRE(expected.find(st[1].asString()) != expected.end());
+    }
+}
+
 TEST_CASE("v blocking distance", "[scp]")
 {
     setupValues();
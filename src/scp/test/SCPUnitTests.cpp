@@ -186,6 +186,59 @@ makeQSet(std::vector<NodeID> const& nodeIDs, int threshold, int total,
     return qSet;
 }
 
+TEST_CASE("nomination leaders follow local quorum set updates", "[scp]")
+{
+    SIMULATION_CREATE_NODE(0);
+    SIMULATION_CREATE_NODE(1);
+    SIMULATION_CREATE_NODE(2);
+    SIMULATION_CREATE_NODE(3);
+    SIMULATION_CREATE_NODE(4);
+
+    std::vector<NodeID> nodeIDs = {v0NodeID, v1NodeID, v2NodeID, v3NodeID,
+                                   v4NodeID};
+
+    TestNominationSCP nomSCP(v0NodeID, makeQSet(nodeIDs, 2, 3, 0));
+    Slot slot(0, nomSCP.mSCP);
+    NominationTestHandler nom(slot);
+
+    Value v;
+    v.emplace_back(uint8_t(0));
+    nom.setPreviousValue(v);
+
+    // returns the leaders seen over the given rounds
+    auto leadersOver = [&](int firstRound, int lastRound) {
+        std::set<NodeID> seen;
+        for (int r = firstRound; r < lastRound; r++)
+        {
+            nom.getRoundLeaders().clear();
+            nom.setRoundNumber(r);
+            nom.updateRoundLeaders();
+            seen.insert(nom.getRoundLeaders().begin(),
+                        nom.getRoundLeaders().end());
+        }
+        return seen;
+    };
+
+    auto seen = leadersOver(0, 20);
+    REQUIRE(seen.size() > 1);
+    for (auto const& id : seen)
+    {
+        REQUIRE((id == v0NodeID || id == v1NodeID || id == v2NodeID));
+    }
+
+    // {v0, v3, v4}
+    auto newQSet = makeQSet(nodeIDs, 2, 2, 3);
+    newQSet.validators.emplace_back(v0NodeID);
+    nomSCP.mSCP.updateLocalQuorumSet(newQSet);
+
+    seen = leadersOver(20, 40);
+    REQUIRE(seen.size() > 1);
+    for (auto const& id : seen)
+    {
+        REQUIRE((id == v0NodeID || id == v3NodeID || id == v4NodeID));
+    }
+}
+
 // this test case display statistical information on the priority function used
 // by nomination
 TEST_CASE("nomination weight stats", "[scp][!hide]")
@@ -16,6 +16,7 @@
 #include "lib/util/stdrandom.h"
 #include "main/Application.h"
 #include "medida/stats/snapshot.h"
+#include "medida/timer.h"
 #include "overlay/StellarXDR.h"
 #include "simulation/Topologies.h"
 #include "test/test.h"
@@ -24,6 +25,7 @@
 #include "util/Math.h"
 #include "util/types.h"
 #include "xdrpp/autocheck.h"
+#include <ctime>
 #include <fmt/format.h>
 #include <sstream>
 
@@ -64,6 +66,11 @@ TEST_CASE("3 nodes 2 running threshold 2", "[simulation][core3][acceptance]")
         mode = Simulation::OVER_TCP;
     }
 
+    SECTION("Over tcp, a thread per node")
+    {
+        mode = Simulation::OVER_TCP_THREADED;
+    }
+
     {
         Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
         Simulation::pointer simulation =
@@ -148,6 +155,10 @@ TEST_CASE("core topology 4 ledgers at scales 2 to 4",
     {
         mode = Simulation::OVER_TCP;
     }
+    SECTION("Over tcp, a thread per node")
+    {
+        mode = Simulation::OVER_TCP_THREADED;
+    }
 
     Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
 
@@ -167,6 +178,28 @@ TEST_CASE("core topology 4 ledgers at scales 2 to 4",
     }
 }
 
+TEST_CASE("core topology of many nodes on their own threads",
+          "[simulation][scalability][!hide]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    for (int size : {10, 50, 100})
+    {
+        auto tBegin = std::chrono::system_clock::now();
+        Simulation::pointer sim = Topologies::core(
+            size, .666f, Simulation::OVER_TCP_THREADED, networkID);
+        sim->startAllNodes();
+
+        int nLedgers = 4;
+        sim->crankUntil(
+            [&sim, nLedgers]() {
+                return sim->haveAllExternalized(nLedgers + 1, nLedgers);
+            },
+            4 * nLedgers * Herder::EXP_LEDGER_TIMESPAN_SECONDS, true);
+        REQUIRE(sim->haveAllExternalized(nLedgers + 1, nLedgers));
+        printStats(nLedgers, tBegin, sim);
+    }
+}
+
 static void
 resilienceTest(Simulation::pointer sim)
 {
@@ -660,6 +693,129 @@ TEST_CASE("Branched cycle nodes vs network traffic", "[scalability][!hide]")
     });
 }
 
+static Config
+scpScaleConfig(int cfgNum)
+{
+    Config res = getTestConfig(cfgNum);
+    res.ARTIFICIALLY_ACCELERATE_TIME_FOR_TESTING = true;
+    res.TARGET_PEER_CONNECTIONS = 1000;
+    res.MAX_ADDITIONAL_PEER_CONNECTIONS = 1000;
+    return res;
+}
+
+// Measures the cost of reaching consensus as the network grows, without
+// load: SCP envelopes emitted, overlay messages and bytes sent over all
+// nodes, process CPU time per externalized slot and mean time to
+// externalize. The first ledger is not measured, as it includes the
+// connection setup.
+static void
+scpScaleTest(std::string const& name,
+             std::function<Simulation::pointer(int numNodes)> mkSim)
+{
+    ScaleReporter r({name + "nodes", "scp-emit", "out-msg", "out-byte",
+                     "cpu-us-per-slot", "externalize-ms"});
+
+    uint32_t const nLedgers = 5;
+    for (int numNodes = 4; numNodes <= 48; numNodes += 4)
+    {
+        auto sim = mkSim(numNodes);
+        sim->startAllNodes();
+        sim->crankUntil([&]() { return sim->haveAllExternalized(2, 1); },
+                        10 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+        REQUIRE(sim->haveAllExternalized(2, 1));
+
+        auto nodes = sim->getNodes();
+        auto totals = [&]() {
+            std::vector<double> res(3, 0.0);
+            for (auto const& app : nodes)
+            {
+                auto& m = app->getMetrics();
+                auto& emit =
+                    m.NewMeter({"scp", "envelope", "emit"}, "envelope");
+                auto& outmsg =
+                    m.NewMeter({"overlay", "message", "write"}, "message");
+                auto& outbyte =
+                    m.NewMeter({"overlay", "byte", "write"}, "byte");
+                res[0] += emit.count();
+                res[1] += outmsg.count();
+                res[2] += outbyte.count();
+            }
+            return res;
+        };
+        auto externalized = [](Application::pointer app) -> medida::Timer& {
+            return app->getMetrics().NewTimer(
+                {"scp", "timing", "externalized"});
+        };
+        for (auto const& app : nodes)
+        {
+            externalized(app).Clear();
+        }
+        auto begin = totals();
+        auto cpuBegin = std::clock();
+
+        sim->crankUntil(
+            [&]() { return sim->haveAllExternalized(nLedgers + 2, 1); },
+            10 * nLedgers * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+        REQUIRE(sim->haveAllExternalized(nLedgers + 2, 1));
+
+        auto cpuUs = 1e6 * static_cast<double>(std::clock() - cpuBegin) /
+                     CLOCKS_PER_SEC;
+        auto end = totals();
+        double externalizeMs = 0;
+        for (auto const& app : nodes)
+        {
+            externalizeMs += externalized(app).mean();
+        }
+
+        r.write({
+            (double)nodes.size(),
+            end[0] - begin[0],
+            end[1] - begin[1],
+            end[2] - begin[2],
+            cpuUs / nLedgers,
+            externalizeMs / nodes.size(),
+        });
+    }
+}
+
+TEST_CASE("Mesh nodes vs SCP cost", "[scalability][scpbench][!hide]")
+{
+    scpScaleTest("mesh", [](int numNodes) {
+        return Topologies::core(numNodes, 1.0, Simulation::OVER_LOOPBACK,
+                                sha256(fmt::format("nodes-{:d}", numNodes)),
+                                scpScaleConfig);
+    });
+}
+
+TEST_CASE("Mesh nodes with 67% thresholds vs SCP cost",
+          "[scalability][scpbench][!hide]")
+{
+    scpScaleTest("mesh67", [](int numNodes) {
+        return Topologies::core(numNodes, 0.67, Simulation::OVER_LOOPBACK,
+                                sha256(fmt::format("nodes-{:d}", numNodes)),
+                                scpScaleConfig);
+    });
+}
+
+TEST_CASE("Cycle nodes vs SCP cost", "[scalability][scpbench][!hide]")
+{
+    scpScaleTest("cycle", [](int numNodes) {
+        return Topologies::cycle(numNodes, 1.0, Simulation::OVER_LOOPBACK,
+                                 sha256(fmt::format("nodes-{:d}", numNodes)),
+                                 scpScaleConfig);
+    });
+}
+
+TEST_CASE("Hierarchical nodes vs SCP cost", "[scalability][scpbench][!hide]")
+{
+    // the core is 4 nodes, every branch adds mid-tier nodes
+    scpScaleTest("hierarchical", [](int numNodes) {
+        return Topologies::hierarchicalQuorum(
+            numNodes / 4, Simulation::OVER_LOOPBACK,
+            sha256(fmt::format("nodes-{:d}", numNodes)), scpScaleConfig);
+    });
+}
+
 TEST_CASE("Bucket list entries vs write throughput", "[scalability][!hide]")
 {
     VirtualClock clock;
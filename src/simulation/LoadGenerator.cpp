@@ -19,6 +19,7 @@
 #include "util/Math.h"
 #include "util/Timer.h"
 #include "util/XDRCereal.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric.h"
 #include "util/types.h"
 
@@ -28,13 +29,15 @@
 
 #include "medida/meter.h"
 #include "medida/metrics_registry.h"
+#include "medida/stats/snapshot.h"
+#include "medida/timer.h"
 
 #include "ledger/test/LedgerTestUtils.h"
-#include <Tracy.hpp>
 #include <cmath>
 #include <crypto/SHA.h>
 #include <fmt/format.h>
 #include <iomanip>
+#include <random>
 #include <set>
 
 namespace stellar
@@ -69,6 +72,37 @@ sampleDiscrete(std::vector<T> const& values,
                                                       weights.end());
     return values.at(distribution(gRandomEngine));
 }
+
+// Same as txtest::transactionFromOperations, without a signature, and
+// without opening a LedgerTxn for the protocol version
+TransactionFramePtr
+unsignedTransactionFromOperations(Application& app, PublicKey const& from,
+                                  SequenceNumber seq,
+                                  std::vector<Operation> const& ops,
+                                  uint32_t fee)
+{
+    auto ledgerVersion =
+        app.getLedgerManager().getLastClosedLedgerHeader().header.ledgerVersion;
+    TransactionEnvelope e;
+    if (protocolVersionIsBefore(ledgerVersion, ProtocolVersion::V_13))
+    {
+        e.type(ENVELOPE_TYPE_TX_V0);
+        e.v0().tx.sourceAccountEd25519 = from.ed25519();
+        e.v0().tx.fee = fee;
+        e.v0().tx.seqNum = seq;
+        e.v0().tx.operations.assign(ops.begin(), ops.end());
+    }
+    else
+    {
+        e.type(ENVELOPE_TYPE_TX);
+        e.v1().tx.sourceAccount = toMuxedAccount(from);
+        e.v1().tx.fee = fee;
+        e.v1().tx.seqNum = seq;
+        e.v1().tx.operations.assign(ops.begin(), ops.end());
+    }
+    return std::static_pointer_cast<TransactionFrame>(
+        TransactionFrameBase::makeTransactionFromWire(app.getNetworkID(), e));
+}
 } // namespace
 
 // Units of load are scheduled at 100ms intervals.
@@ -86,6 +120,10 @@ const uint32_t LoadGenerator::TIMEOUT_NUM_LEDGERS = 20;
 // without checking for account consistency.
 const uint32_t LoadGenerator::COMPLETION_TIMEOUT_WITHOUT_CHECKS = 4;
 
+// Transactions signed ahead of time are handed to background threads in
+// chunks of this many, spreading a step over the worker threads.
+const size_t LoadGenerator::PRESIGN_CHUNK_SIZE = 64;
+
 // Minimum unique account multiplier. This is used to calculate the minimum
 // number of accounts needed to sustain desired tx/s rate (this provides a
 // buffer in case loadgen is unstable and needs more accounts)
@@ -104,6 +142,12 @@ LoadGenerator::LoadGenerator(Application& app)
           mApp.getMetrics().NewCounter({"ledger", "apply-soroban", "success"}))
     , mApplySorobanFailure(
           mApp.getMetrics().NewCounter({"ledger", "apply-soroban", "failure"}))
+    , mOpenLoopLatency(
+          mApp.getMetrics().NewTimer({"loadgen", "txn", "latency"}))
+    , mOpenLoopDroppedMeter(
+          mApp.getMetrics().NewMeter({"loadgen", "txn", "dropped"}, "txn"))
+    , mPresignedMeter(
+          mApp.getMetrics().NewMeter({"loadgen", "txn", "presigned"}, "txn"))
 {
 }
 
@@ -210,7 +254,7 @@ LoadGenerator::chooseOpCount(Config const& cfg) const
 
 int64_t
 LoadGenerator::getTxPerStep(uint32_t txRate, std::chrono::seconds spikeInterval,
-                            uint32_t spikeSize)
+                            uint32_t spikeSize, bool openLoop)
 {
     if (!mStartTime)
     {
@@ -224,8 +268,27 @@ LoadGenerator::getTxPerStep(uint32_t txRate, std::chrono::seconds spikeInterval,
     auto now = mApp.getClock().now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         now - *mStartTime);
-    auto txs =
-        bigDivideOrThrow(elapsed.count(), txRate, 1000, Rounding::ROUND_DOWN);
+    int64_t txs = 0;
+    if (openLoop)
+    {
+        // Draw the arrivals since the previous step, so that a late timer
+        // doesn't lower the offered load
+        auto sinceLast = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now - mLastArrivalTime);
+        mLastArrivalTime = now;
+        if (sinceLast.count() > 0)
+        {
+            std::poisson_distribution<int64_t> arrivals(
+                static_cast<double>(txRate) * sinceLast.count() / 1000.0);
+            mOpenLoopArrivals += arrivals(gRandomEngine);
+        }
+        txs = mOpenLoopArrivals;
+    }
+    else
+    {
+        txs = bigDivideOrThrow(elapsed.count(), txRate, 1000,
+                               Rounding::ROUND_DOWN);
+    }
     if (spikeInterval.count() > 0)
     {
         txs += bigDivideOrThrow(
@@ -268,7 +331,8 @@ LoadGenerator::cleanupAccounts()
     {
         auto accIt = mAccounts.find(*it);
         releaseAssert(accIt != mAccounts.end());
-        if (!mApp.getHerder().sourceAccountPending(
+        if (mPresignedAccounts.find(*it) == mPresignedAccounts.end() &&
+            !mApp.getHerder().sourceAccountPending(
                 accIt->second->getPublicKey()))
         {
             mAccountsAvailable.insert(*it);
@@ -294,6 +358,14 @@ LoadGenerator::reset()
     mRoot.reset();
     mStartTime.reset();
     mTotalSubmitted = 0;
+    mOpenLoopArrivals = 0;
+    mOpenLoopPending.clear();
+    mOpenLoopLatencies.clear();
+    mOpenLoopDropped = 0;
+    mOpenLoopCheckedLedger = 0;
+    mPresignChunks.clear();
+    mPresignNext = 0;
+    mPresignedAccounts.clear();
     mWaitTillCompleteForLedgers = 0;
     mSorobanWasmWaitTillLedgers = 0;
     mFailed = false;
@@ -414,6 +486,12 @@ LoadGenerator::start(GeneratedLoadConfig& cfg)
     releaseAssert(!mStartTime);
     mStartTime =
         std::make_unique<VirtualClock::time_point>(mApp.getClock().now());
+    mLastArrivalTime = *mStartTime;
+    if (cfg.openLoop)
+    {
+        // Percentiles are reported for this run only
+        mOpenLoopLatency.Clear();
+    }
 
     releaseAssert(mPreLoadgenApplySorobanSuccess == 0);
     releaseAssert(mPreLoadgenApplySorobanFailure == 0);
@@ -483,6 +561,12 @@ LoadGenerator::scheduleLoadGeneration(GeneratedLoadConfig cfg)
         }
     }
 
+    if (cfg.openLoop && !cfg.isLoad())
+    {
+        errorMsg = "Open-loop load generation needs every transaction of "
+                   "account creation and Soroban setup, use a load mode";
+    }
+
     if (errorMsg)
     {
         CLOG_ERROR(LoadGen, "{}", *errorMsg);
@@ -607,6 +691,16 @@ GeneratedLoadConfig::getStatus() const
         ret["min_soroban_percent_success"] = mMinSorobanPercentSuccess;
     }
 
+    if (openLoop)
+    {
+        ret["open_loop"] = true;
+    }
+
+    if (backgroundSigning)
+    {
+        ret["background_signing"] = true;
+    }
+
     return ret;
 }
 
@@ -624,8 +718,13 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
     // Finish if no more txs need to be created.
     if (!cfg.areTxsRemaining())
     {
+        releasePresignedTxs();
         // Done submitting the load, now ensure it propagates to the DB.
-        if (!cfg.isCreate() && cfg.skipLowFeeTxs)
+        if (cfg.openLoop)
+        {
+            waitTillOpenLoopComplete();
+        }
+        else if (!cfg.isCreate() && cfg.skipLowFeeTxs)
         {
             // skipLowFeeTxs allows triggering tx queue limiter, which
             // makes it hard to track the final seq nums. Hence just
@@ -641,7 +740,13 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
 
     updateMinBalance();
 
-    auto txPerStep = getTxPerStep(cfg.txRate, cfg.spikeInterval, cfg.spikeSize);
+    if (cfg.openLoop)
+    {
+        checkOpenLoopTxs();
+    }
+
+    auto txPerStep = getTxPerStep(cfg.txRate, cfg.spikeInterval, cfg.spikeSize,
+                                  cfg.openLoop);
     if (cfg.mode == LoadGenMode::CREATE)
     {
         // Limit creation to the number of accounts we have. This is only the
@@ -674,7 +779,12 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
         }
         else
         {
-            if (mAccountsAvailable.empty())
+            std::optional<PresignedTx> presigned;
+            if (cfg.backgroundSigning)
+            {
+                presigned = takePresignedTx();
+            }
+            if (!presigned && mAccountsAvailable.empty())
             {
                 CLOG_WARNING(
                     LoadGen,
@@ -684,102 +794,22 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
                 return;
             }
 
-            uint64_t sourceAccountId = getNextAvailableAccount();
-
-            std::function<
-                std::pair<LoadGenerator::TestAccountPtr, TransactionFramePtr>()>
-                generateTx;
-
-            switch (cfg.mode)
-            {
-            case LoadGenMode::CREATE:
-                releaseAssert(false);
-                break;
-            case LoadGenMode::PAY:
-                generateTx = [&]() {
-                    return paymentTransaction(cfg.nAccounts, cfg.offset,
-                                              ledgerNum, sourceAccountId, 1,
-                                              cfg.maxGeneratedFeeRate);
-                };
-                break;
-            case LoadGenMode::PRETEND:
+            uint64_t sourceAccountId =
+                presigned ? presigned->mAccountId : getNextAvailableAccount();
+            auto generateTx = makeTxGenerator(cfg, ledgerNum, sourceAccountId);
+            if (presigned)
             {
-                auto opCount = chooseOpCount(mApp.getConfig());
-                generateTx = [&, opCount]() {
-                    return pretendTransaction(cfg.nAccounts, cfg.offset,
-                                              ledgerNum, sourceAccountId,
-                                              opCount, cfg.maxGeneratedFeeRate);
-                };
-            }
-            break;
-            case LoadGenMode::MIXED_CLASSIC:
-            {
-                auto opCount = chooseOpCount(mApp.getConfig());
-                bool isDex =
-                    rand_uniform<uint32_t>(1, 100) <= cfg.getDexTxPercent();
-                generateTx = [&, opCount, isDex]() {
-                    if (isDex)
+                // Retries build a new transaction as usual
+                generateTx = [from = presigned->mFrom, tx = presigned->mTx,
+                              first = true, generateTx]() mutable {
+                    if (first)
                     {
-                        return manageOfferTransaction(ledgerNum,
-                                                      sourceAccountId, opCount,
-                                                      cfg.maxGeneratedFeeRate);
-                    }
-                    else
-                    {
-                        return paymentTransaction(
-                            cfg.nAccounts, cfg.offset, ledgerNum,
-                            sourceAccountId, opCount, cfg.maxGeneratedFeeRate);
+                        first = false;
+                        return std::make_pair(from, tx);
                     }
+                    return generateTx();
                 };
             }
-            break;
-            case LoadGenMode::SOROBAN_UPLOAD:
-            {
-                generateTx = [&]() {
-                    return sorobanRandomWasmTransaction(
-                        ledgerNum, sourceAccountId,
-                        generateFee(cfg.maxGeneratedFeeRate, mApp,
-                                    /* opsCnt */ 1));
-                };
-            }
-            break;
-            case LoadGenMode::SOROBAN_INVOKE_SETUP:
-            case LoadGenMode::SOROBAN_UPGRADE_SETUP:
-                generateTx = [&] {
-                    auto& sorobanCfg = cfg.getMutSorobanConfig();
-                    if (sorobanCfg.nWasms != 0)
-                    {
-                        --sorobanCfg.nWasms;
-                        return createUploadWasmTransaction(
-                            ledgerNum, sourceAccountId, cfg);
-                    }
-                    else
-                    {
-                        --sorobanCfg.nInstances;
-                        return createContractTransaction(ledgerNum,
-                                                         sourceAccountId, cfg);
-                    }
-                };
-                break;
-            case LoadGenMode::SOROBAN_INVOKE:
-                generateTx = [&]() {
-                    return invokeSorobanLoadTransaction(ledgerNum,
-                                                        sourceAccountId, cfg);
-                };
-                break;
-            case LoadGenMode::SOROBAN_CREATE_UPGRADE:
-                generateTx = [&]() {
-                    return invokeSorobanCreateUpgradeTransaction(
-                        ledgerNum, sourceAccountId, cfg);
-                };
-                break;
-            case LoadGenMode::MIXED_CLASSIC_SOROBAN:
-                generateTx = [&]() {
-                    return createMixedClassicSorobanTransaction(
-                        ledgerNum, sourceAccountId, cfg);
-                };
-                break;
-            }
 
             if (submitTx(cfg, generateTx))
             {
@@ -789,6 +819,11 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
             {
                 break;
             }
+            else if (cfg.openLoop)
+            {
+                // The transaction arrived, it just didn't make it in
+                --cfg.nTxs;
+            }
         }
         if (cfg.nAccounts == 0 || !cfg.areTxsRemaining())
         {
@@ -809,9 +844,217 @@ LoadGenerator::generateLoad(GeneratedLoadConfig cfg)
 
     mLastSecond = now;
     mTotalSubmitted += txPerStep;
+    if (cfg.backgroundSigning && cfg.areTxsRemaining() && !mFailed)
+    {
+        presignTxs(cfg, ledgerNum);
+    }
     scheduleLoadGeneration(cfg);
 }
 
+LoadGenerator::TxGenerator
+LoadGenerator::makeTxGenerator(GeneratedLoadConfig& cfg, uint32_t ledgerNum,
+                               uint64_t sourceAccountId)
+{
+    TxGenerator generateTx;
+    switch (cfg.mode)
+    {
+    case LoadGenMode::CREATE:
+        releaseAssert(false);
+        break;
+    case LoadGenMode::PAY:
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            return paymentTransaction(cfg.nAccounts, cfg.offset, ledgerNum,
+                                      sourceAccountId, 1,
+                                      cfg.maxGeneratedFeeRate);
+        };
+        break;
+    case LoadGenMode::PRETEND:
+    {
+        auto opCount = chooseOpCount(mApp.getConfig());
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId, opCount]() {
+            return pretendTransaction(cfg.nAccounts, cfg.offset, ledgerNum,
+                                      sourceAccountId, opCount,
+                                      cfg.maxGeneratedFeeRate);
+        };
+    }
+    break;
+    case LoadGenMode::MIXED_CLASSIC:
+    {
+        auto opCount = chooseOpCount(mApp.getConfig());
+        bool isDex = rand_uniform<uint32_t>(1, 100) <= cfg.getDexTxPercent();
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId, opCount,
+                      isDex]() {
+            if (isDex)
+            {
+                return manageOfferTransaction(ledgerNum, sourceAccountId,
+                                              opCount,
+                                              cfg.maxGeneratedFeeRate);
+            }
+            else
+            {
+                return paymentTransaction(cfg.nAccounts, cfg.offset,
+                                          ledgerNum, sourceAccountId, opCount,
+                                          cfg.maxGeneratedFeeRate);
+            }
+        };
+    }
+    break;
+    case LoadGenMode::SOROBAN_UPLOAD:
+    {
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            return sorobanRandomWasmTransaction(
+                ledgerNum, sourceAccountId,
+                generateFee(cfg.maxGeneratedFeeRate, mApp,
+                            /* opsCnt */ 1));
+        };
+    }
+    break;
+    case LoadGenMode::SOROBAN_INVOKE_SETUP:
+    case LoadGenMode::SOROBAN_UPGRADE_SETUP:
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            auto& sorobanCfg = cfg.getMutSorobanConfig();
+            if (sorobanCfg.nWasms != 0)
+            {
+                --sorobanCfg.nWasms;
+                return createUploadWasmTransaction(ledgerNum, sourceAccountId,
+                                                   cfg);
+            }
+            else
+            {
+                --sorobanCfg.nInstances;
+                return createContractTransaction(ledgerNum, sourceAccountId,
+                                                 cfg);
+            }
+        };
+        break;
+    case LoadGenMode::SOROBAN_INVOKE:
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            return invokeSorobanLoadTransaction(ledgerNum, sourceAccountId,
+                                                cfg);
+        };
+        break;
+    case LoadGenMode::SOROBAN_CREATE_UPGRADE:
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            return invokeSorobanCreateUpgradeTransaction(
+                ledgerNum, sourceAccountId, cfg);
+        };
+        break;
+    case LoadGenMode::MIXED_CLASSIC_SOROBAN:
+        generateTx = [this, &cfg, ledgerNum, sourceAccountId]() {
+            return createMixedClassicSorobanTransaction(
+                ledgerNum, sourceAccountId, cfg);
+        };
+        break;
+    }
+    return generateTx;
+}
+
+void
+LoadGenerator::presignTxs(GeneratedLoadConfig& cfg, uint32_t ledgerNum)
+{
+    ZoneScoped;
+    // Soroban transactions are signed as they are built, along with their
+    // footprint
+    if (cfg.mode != LoadGenMode::PAY && cfg.mode != LoadGenMode::PRETEND &&
+        cfg.mode != LoadGenMode::MIXED_CLASSIC)
+    {
+        return;
+    }
+
+    // Keep about one step worth of transactions ahead; spikes and a rate
+    // above the average are made up for by building the rest as usual
+    int64_t perStep = std::max<int64_t>(
+        1, bigDivideOrThrow(cfg.txRate, STEP_MSECS, 1000, Rounding::ROUND_UP));
+    int64_t wanted = std::min<int64_t>(perStep, cfg.nTxs) -
+                     static_cast<int64_t>(mPresignedAccounts.size());
+    if (wanted <= 0)
+    {
+        return;
+    }
+
+    auto chunk = std::make_shared<PresignChunk>();
+    mDeferSigning = true;
+    for (int64_t i = 0; i < wanted && !mAccountsAvailable.empty(); ++i)
+    {
+        auto sourceAccountId = getNextAvailableAccount();
+        auto [from, tx] = makeTxGenerator(cfg, ledgerNum, sourceAccountId)();
+        mPresignedAccounts.insert(sourceAccountId);
+        chunk->mTxs.emplace_back(
+            PresignedTx{sourceAccountId, from, tx, from->getSecretKey()});
+        if (chunk->mTxs.size() == PRESIGN_CHUNK_SIZE)
+        {
+            signInBackground(chunk);
+            chunk = std::make_shared<PresignChunk>();
+        }
+    }
+    mDeferSigning = false;
+    if (!chunk->mTxs.empty())
+    {
+        signInBackground(chunk);
+    }
+}
+
+void
+LoadGenerator::signInBackground(std::shared_ptr<PresignChunk> chunk)
+{
+    mPresignChunks.push_back(chunk);
+    // The task only touches the chunk, which the main thread leaves alone
+    // until it is done, so it can be dropped by a reset at any time
+    mApp.postOnBackgroundThread(
+        [chunk]() {
+            ZoneNamedN(signZone, "sign loadgen transactions", true);
+            for (auto& ptx : chunk->mTxs)
+            {
+                ptx.mTx->addSignature(ptx.mKey);
+            }
+            chunk->mDone = true;
+        },
+        "LoadGenerator: sign transactions");
+}
+
+std::optional<LoadGenerator::PresignedTx>
+LoadGenerator::takePresignedTx()
+{
+    if (mPresignChunks.empty() || !mPresignChunks.front()->mDone)
+    {
+        return std::nullopt;
+    }
+    auto& chunk = *mPresignChunks.front();
+    auto ptx = chunk.mTxs.at(mPresignNext);
+    if (++mPresignNext == chunk.mTxs.size())
+    {
+        mPresignChunks.pop_front();
+        mPresignNext = 0;
+    }
+    mPresignedAccounts.erase(ptx.mAccountId);
+    mPresignedMeter.Mark();
+    return ptx;
+}
+
+void
+LoadGenerator::releasePresignedTxs()
+{
+    // Give back the sequence numbers and the accounts of the transactions
+    // that won't be submitted, whether signed yet or not
+    for (auto const& chunk : mPresignChunks)
+    {
+        for (auto const& ptx : chunk->mTxs)
+        {
+            if (mPresignedAccounts.erase(ptx.mAccountId) == 0)
+            {
+                continue;
+            }
+            ptx.mFrom->setSequenceNumber(ptx.mFrom->getLastSequenceNumber() -
+                                         1);
+            mAccountsInUse.erase(ptx.mAccountId);
+            mAccountsAvailable.insert(ptx.mAccountId);
+        }
+    }
+    mPresignChunks.clear();
+    mPresignNext = 0;
+    releaseAssert(mPresignedAccounts.empty());
+}
+
 uint32_t
 LoadGenerator::submitCreationTx(uint32_t nAccounts, uint32_t offset,
                                 uint32_t ledgerNum)
@@ -873,7 +1116,7 @@ LoadGenerator::submitTx(GeneratedLoadConfig const& cfg,
            TransactionQueue::AddResult::ADD_STATUS_PENDING)
     {
 
-        if (cfg.skipLowFeeTxs &&
+        if ((cfg.skipLowFeeTxs || cfg.openLoop) &&
             (status ==
                  TransactionQueue::AddResult::ADD_STATUS_TRY_AGAIN_LATER ||
              (status == TransactionQueue::AddResult::ADD_STATUS_ERROR &&
@@ -884,6 +1127,10 @@ LoadGenerator::submitTx(GeneratedLoadConfig const& cfg,
             from->setSequenceNumber(from->getLastSequenceNumber() - 1);
             CLOG_INFO(LoadGen, "skipped low fee tx with fee {}",
                       tx->getInclusionFee());
+            if (cfg.openLoop)
+            {
+                dropOpenLoopTx();
+            }
             return false;
         }
         if (++numTries >= TX_SUBMIT_MAX_TRIES ||
@@ -900,9 +1147,122 @@ LoadGenerator::submitTx(GeneratedLoadConfig const& cfg,
         std::tie(from, tx) = generateTx();
     }
 
+    if (cfg.openLoop)
+    {
+        trackOpenLoopTx(from, tx);
+    }
     return true;
 }
 
+void
+LoadGenerator::trackOpenLoopTx(TestAccountPtr from,
+                               TransactionFramePtr const& tx)
+{
+    OpenLoopTx otx{from, tx->getSeqNum(), mApp.getClock().now(),
+                   mApp.getLedgerManager().getLastClosedLedgerNum()};
+    auto res = mOpenLoopPending.emplace(from->getPublicKey(), otx);
+    if (!res.second)
+    {
+        // The account is only reused once its previous transaction has left
+        // the queue, since the last check. If that one was applied, this one
+        // comes after it; if it was evicted, its sequence number is reused.
+        auto& prev = res.first->second;
+        if (prev.mSeqNum < otx.mSeqNum)
+        {
+            // Applied by now
+            recordOpenLoopLatency(otx.mSubmitted - prev.mSubmitted);
+        }
+        else
+        {
+            dropOpenLoopTx();
+        }
+        prev = otx;
+    }
+}
+
+void
+LoadGenerator::recordOpenLoopLatency(std::chrono::nanoseconds latency)
+{
+    mOpenLoopLatency.Update(latency);
+    mOpenLoopLatencies.emplace_back(
+        std::chrono::duration<double, std::milli>(latency).count());
+}
+
+void
+LoadGenerator::dropOpenLoopTx()
+{
+    ++mOpenLoopDropped;
+    mOpenLoopDroppedMeter.Mark();
+}
+
+void
+LoadGenerator::checkOpenLoopTxs()
+{
+    ZoneScoped;
+    auto lcl = mApp.getLedgerManager().getLastClosedLedgerNum();
+    if (lcl == mOpenLoopCheckedLedger)
+    {
+        return;
+    }
+    mOpenLoopCheckedLedger = lcl;
+
+    // Ledger closes are noticed within a step of happening
+    auto now = mApp.getClock().now();
+    LedgerTxn ltx(mApp.getLedgerTxnRoot(), false,
+                  TransactionMode::READ_ONLY_WITHOUT_SQL_TXN);
+    for (auto it = mOpenLoopPending.begin(); it != mOpenLoopPending.end();)
+    {
+        auto const& otx = it->second;
+        auto acc = stellar::loadAccountWithoutRecord(ltx, it->first);
+        if (acc && acc.current().data.account().seqNum >= otx.mSeqNum)
+        {
+            recordOpenLoopLatency(now - otx.mSubmitted);
+            it = mOpenLoopPending.erase(it);
+        }
+        else if (lcl >= otx.mLedger + TIMEOUT_NUM_LEDGERS)
+        {
+            dropOpenLoopTx();
+            it = mOpenLoopPending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void
+LoadGenerator::waitTillOpenLoopComplete()
+{
+    if (!mLoadTimer)
+    {
+        mLoadTimer = std::make_unique<VirtualTimer>(mApp.getClock());
+    }
+    checkOpenLoopTxs();
+    if (!mOpenLoopPending.empty())
+    {
+        mLoadTimer->expires_from_now(std::chrono::milliseconds(STEP_MSECS));
+        mLoadTimer->async_wait([this]() { this->waitTillOpenLoopComplete(); },
+                               &VirtualTimer::onFailureNoop);
+        return;
+    }
+
+    auto& latencies = mOpenLoopLatencies;
+    std::sort(latencies.begin(), latencies.end());
+    medida::stats::Snapshot snap(latencies);
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+        mApp.getClock().now() - *mStartTime);
+    CLOG_INFO(LoadGen,
+              "Open-loop load over {}s: {} tx included, {} dropped. Latency "
+              "to ledger close: p50 {:.0f}ms, p90 {:.0f}ms, p99 {:.0f}ms",
+              elapsed.count(), latencies.size(),
+              mOpenLoopDropped, snap.getMedian(), snap.getValue(0.9),
+              snap.get99thPercentile());
+    CLOG_INFO(LoadGen, "Load generation complete.");
+    mLoadgenComplete.Mark();
+    reset();
+}
+
 uint64_t
 LoadGenerator::getNextAvailableAccount()
 {
@@ -2068,9 +2428,8 @@ LoadGenerator::createTransactionFramePtr(
     TestAccountPtr from, std::vector<Operation> ops, LoadGenMode mode,
     std::optional<uint32_t> maxGeneratedFeeRate)
 {
-
-    auto txf = transactionFromOperations(
-        mApp, from->getSecretKey(), from->nextSequenceNumber(), ops,
+    auto txf = unsignedTransactionFromOperations(
+        mApp, from->getPublicKey(), from->nextSequenceNumber(), ops,
         generateFee(maxGeneratedFeeRate, mApp, ops.size()));
     if (mode == LoadGenMode::PRETEND)
     {
@@ -2082,8 +2441,11 @@ LoadGenerator::createTransactionFramePtr(
         txbridge::setMaxTime(txf, UINT64_MAX);
     }
 
-    txbridge::getSignatures(txf).clear();
-    txf->addSignature(from->getSecretKey());
+    // Signed only once it can no longer change
+    if (!mDeferSigning)
+    {
+        txf->addSignature(from->getSecretKey());
+    }
     return txf;
 }
 
@@ -10,6 +10,9 @@
 #include "test/TestAccount.h"
 #include "test/TxTests.h"
 #include "xdr/Stellar-types.h"
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <vector>
 
 namespace medida
@@ -170,6 +173,19 @@ struct GeneratedLoadConfig
     // the load generation will fail after a couple of retries.
     // Does not affect account creation.
     bool skipLowFeeTxs = false;
+    // When true, transactions arrive as a Poisson process of mean `txRate`
+    // rather than on a fixed schedule, and each one is followed until it
+    // makes it into a closed ledger, to measure the latency at a given
+    // offered load. Transactions the node turns away, or that don't make it
+    // into a ledger within TIMEOUT_NUM_LEDGERS, are counted as dropped
+    // rather than failing the run. Only for modes that generate load, not
+    // for account creation or Soroban setup.
+    bool openLoop = false;
+    // When true, transactions are built a step ahead of their submission and
+    // signed on background threads, so that the main thread is left with
+    // little more than submitting them. For classic payment, pretend and
+    // mixed classic load only.
+    bool backgroundSigning = false;
 
   private:
     SorobanConfig sorobanConfig;
@@ -266,6 +282,34 @@ class LoadGenerator
         void report();
     };
 
+    // A transaction of an open-loop run that is yet to be seen in a ledger.
+    // Source accounts are not reused until their transaction has left the
+    // queue, so there is at most one per account.
+    struct OpenLoopTx
+    {
+        TestAccountPtr mFrom;
+        SequenceNumber mSeqNum;
+        VirtualClock::time_point mSubmitted;
+        uint32_t mLedger;
+    };
+
+    // A transaction built ahead of time, signed on a background thread with
+    // a copy of its source account's key
+    struct PresignedTx
+    {
+        uint64_t mAccountId;
+        TestAccountPtr mFrom;
+        TransactionFramePtr mTx;
+        SecretKey mKey;
+    };
+    struct PresignChunk
+    {
+        std::vector<PresignedTx> mTxs;
+        std::atomic<bool> mDone{false};
+    };
+    using TxGenerator =
+        std::function<std::pair<TestAccountPtr, TransactionFramePtr>()>;
+
     // There are a few scenarios where tx submission might fail:
     // * ADD_STATUS_DUPLICATE, should be just a no-op and not count toward
     // total tx goal.
@@ -289,6 +333,7 @@ class LoadGenerator
     static const uint32_t TIMEOUT_NUM_LEDGERS;
     static const uint32_t COMPLETION_TIMEOUT_WITHOUT_CHECKS;
     static const uint32_t MIN_UNIQUE_ACCOUNT_MULTIPLIER;
+    static const size_t PRESIGN_CHUNK_SIZE;
 
     std::unique_ptr<VirtualTimer> mLoadTimer;
     int64 mMinBalance;
@@ -298,6 +343,27 @@ class LoadGenerator
     // Set when load generation actually begins
     std::unique_ptr<VirtualClock::time_point> mStartTime;
 
+    // Open-loop state: the arrivals drawn so far, the transactions not yet
+    // seen in a ledger, and the latencies (in ms) of those that were
+    int64_t mOpenLoopArrivals{0};
+    VirtualClock::time_point mLastArrivalTime;
+    UnorderedMap<PublicKey, OpenLoopTx> mOpenLoopPending;
+    std::vector<double> mOpenLoopLatencies;
+    uint64_t mOpenLoopDropped{0};
+    uint32_t mOpenLoopCheckedLedger{0};
+    medida::Timer& mOpenLoopLatency;
+    medida::Meter& mOpenLoopDroppedMeter;
+
+    // Chunks of transactions being signed in the background, in the order
+    // they were built, the next one to submit in the front chunk, and the
+    // accounts they are from, which stay in use until they are submitted
+    std::deque<std::shared_ptr<PresignChunk>> mPresignChunks;
+    size_t mPresignNext{0};
+    std::unordered_set<uint64_t> mPresignedAccounts;
+    medida::Meter& mPresignedMeter;
+    // Set while building transactions to sign in the background
+    bool mDeferSigning{false};
+
     TestAccountPtr mRoot;
     // Accounts cache
     std::map<uint64_t, TestAccountPtr> mAccounts;
@@ -351,7 +417,32 @@ class LoadGenerator
     void resetSorobanState();
     void createRootAccount();
     int64_t getTxPerStep(uint32_t txRate, std::chrono::seconds spikeInterval,
-                         uint32_t spikeSize);
+                         uint32_t spikeSize, bool openLoop);
+
+    // Returns a function building a transaction from the given account for
+    // the mode of `cfg`, which it may update, so must outlive the function
+    TxGenerator makeTxGenerator(GeneratedLoadConfig& cfg, uint32_t ledgerNum,
+                                uint64_t sourceAccountId);
+
+    // Build about a step worth of transactions and have them signed on
+    // background threads, for the next steps to submit
+    void presignTxs(GeneratedLoadConfig& cfg, uint32_t ledgerNum);
+    void signInBackground(std::shared_ptr<PresignChunk> chunk);
+    // The next transaction signed in the background, if there is one ready
+    std::optional<PresignedTx> takePresignedTx();
+    // Give up on the transactions signed in the background not submitted yet
+    void releasePresignedTxs();
+
+    // Follow a transaction of an open-loop run until it is in a ledger
+    void trackOpenLoopTx(TestAccountPtr from, TransactionFramePtr const& tx);
+    void recordOpenLoopLatency(std::chrono::nanoseconds latency);
+    void dropOpenLoopTx();
+    // Once per closed ledger, record the latency of the tracked transactions
+    // that made it in, and give up on those that are too old
+    void checkOpenLoopTxs();
+    // Wait for every open-loop transaction to be in a ledger or dropped, then
+    // report the latency percentiles of the run
+    void waitTillOpenLoopComplete();
 
     // Schedule a callback to generateLoad() STEP_MSECS milliseconds from now.
     void scheduleLoadGeneration(GeneratedLoadConfig cfg);
@@ -23,6 +23,7 @@
 #include "medida/medida.h"
 #include "medida/reporting/console_reporter.h"
 
+#include <future>
 #include <thread>
 
 namespace stellar
@@ -32,7 +33,7 @@ using namespace std;
 
 Simulation::Simulation(Mode mode, Hash const& networkID, ConfigGen confGen,
                        QuorumSetAdjuster qSetAdjust)
-    : mVirtualClockMode(mode != OVER_TCP)
+    : mVirtualClockMode(mode == OVER_LOOPBACK)
     , mClock(mVirtualClockMode ? VirtualClock::VIRTUAL_TIME
                                : VirtualClock::REAL_TIME)
     , mMode(mode)
@@ -46,6 +47,11 @@ Simulation::Simulation(Mode mode, Hash const& networkID, ConfigGen confGen,
 
 Simulation::~Simulation()
 {
+    // nodes still running must be done with their apps before they go
+    for (auto& p : mNodes)
+    {
+        stopNodeThread(p.second);
+    }
     // kills all connections
     mLoopbackConnections.clear();
     // destroy all nodes first
@@ -101,7 +107,7 @@ Simulation::addNode(SecretKey nodeKey, SCPQuorumSet qSet, Config const* cfg2,
         cfg->QUORUM_SET = qSet;
     }
 
-    if (mMode == OVER_TCP)
+    if (isOverTCP())
     {
         cfg->RUN_STANDALONE = false;
     }
@@ -145,6 +151,98 @@ Simulation::getNode(NodeID nodeID)
 {
     return mNodes[nodeID].mApp;
 }
+
+void
+Simulation::runOnNode(NodeID const& id, std::function<void()> const& f)
+{
+    auto it = mNodes.find(id);
+    if (it == mNodes.end() || !it->second.mThread)
+    {
+        f();
+        return;
+    }
+
+    auto nodeThread = it->second.mThread;
+    auto done = std::make_shared<std::promise<void>>();
+    auto res = done->get_future();
+    it->second.mApp->postOnMainThread(
+        [&f, done]() {
+            try
+            {
+                f();
+                done->set_value();
+            }
+            catch (...)
+            {
+                done->set_exception(std::current_exception());
+            }
+        },
+        "Simulation: run on node");
+    while (res.wait_for(std::chrono::milliseconds(10)) !=
+           std::future_status::ready)
+    {
+        if (!nodeThread->mRunning)
+        {
+            throw std::runtime_error("Simulation node stopped running");
+        }
+    }
+    res.get();
+}
+
+void
+Simulation::startNodeThread(Node& node)
+{
+    releaseAssert(!node.mThread);
+    auto nodeThread = std::make_shared<NodeThread>();
+    // Nodes draw from the simulation's seed, but each from its own engine
+    auto seed = static_cast<unsigned int>(gRandomEngine());
+    auto app = node.mApp;
+    auto clock = node.mClock;
+    nodeThread->mThread = std::thread([app, clock, nodeThread, seed]() {
+        markThreadAsMain();
+        gRandomEngine.seed(seed);
+        try
+        {
+            app->start();
+            while (!nodeThread->mStop && !clock->getIOContext().stopped())
+            {
+                clock->crank(true);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            LOG_ERROR(DEFAULT_LOG, "Simulation node {} failed: {}",
+                      app->getConfig().PEER_PORT, e.what());
+        }
+        nodeThread->mRunning = false;
+    });
+    node.mThread = nodeThread;
+}
+
+void
+Simulation::stopNodeThread(Node& node)
+{
+    if (!node.mThread)
+    {
+        return;
+    }
+    auto nodeThread = node.mThread;
+    if (nodeThread->mRunning)
+    {
+        auto app = node.mApp;
+        app->postOnMainThread([app]() { app->gracefulStop(); },
+                              "Simulation: stop node");
+        // Wait a bit for a graceful stop, then wake the thread up to stop
+        for (int i = 0; i < 100 && nodeThread->mRunning; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        nodeThread->mStop = true;
+        asio::post(node.mClock->getIOContext(), []() {});
+    }
+    nodeThread->mThread.join();
+    node.mThread.reset();
+}
 vector<Application::pointer>
 Simulation::getNodes()
 {
@@ -171,9 +269,16 @@ Simulation::removeNode(NodeID const& id)
         auto node = it->second;
         mPeerMap.erase(node.mApp->getConfig().PEER_PORT);
         mNodes.erase(it);
-        node.mApp->gracefulStop();
-        while (node.mClock->crank(false) > 0)
-            ;
+        if (node.mThread)
+        {
+            stopNodeThread(node);
+        }
+        else
+        {
+            node.mApp->gracefulStop();
+            while (node.mClock->crank(false) > 0)
+                ;
+        }
         if (mMode == OVER_LOOPBACK)
         {
             dropAllConnections(id);
@@ -255,13 +360,15 @@ Simulation::dropConnection(NodeID initiator, NodeID acceptor)
         {
             auto& cAcceptor = mNodes[acceptor].mApp->getConfig();
 
-            auto peer = iApp->getOverlayManager().getConnectedPeer(
-                PeerBareAddress{"127.0.0.1", cAcceptor.PEER_PORT});
-            if (peer)
-            {
-                peer->drop("drop", Peer::DropDirection::WE_DROPPED_REMOTE,
-                           Peer::DropMode::IGNORE_WRITE_QUEUE);
-            }
+            runOnNode(initiator, [&]() {
+                auto peer = iApp->getOverlayManager().getConnectedPeer(
+                    PeerBareAddress{"127.0.0.1", cAcceptor.PEER_PORT});
+                if (peer)
+                {
+                    peer->drop("drop", Peer::DropDirection::WE_DROPPED_REMOTE,
+                               Peer::DropMode::IGNORE_WRITE_QUEUE);
+                }
+            });
         }
     }
 }
@@ -313,7 +420,7 @@ Simulation::dropLoopbackConnection(NodeID initiator, NodeID acceptor)
 void
 Simulation::addTCPConnection(NodeID initiator, NodeID acceptor)
 {
-    if (mMode != OVER_TCP)
+    if (!isOverTCP())
     {
         throw runtime_error("Cannot add a TCP connection");
     }
@@ -324,16 +431,32 @@ Simulation::addTCPConnection(NodeID initiator, NodeID acceptor)
         throw runtime_error("PEER_PORT cannot be set to 0");
     }
     auto address = PeerBareAddress{"127.0.0.1", to->getConfig().PEER_PORT};
-    from->getOverlayManager().connectTo(address);
+    runOnNode(initiator,
+              [&]() { from->getOverlayManager().connectTo(address); });
+}
+
+bool
+Simulation::isOverTCP() const
+{
+    return mMode == OVER_TCP || mMode == OVER_TCP_THREADED;
 }
 
 void
 Simulation::startAllNodes()
 {
-    for (auto const& it : mNodes)
+    for (auto& it : mNodes)
     {
         auto app = it.second.mApp;
-        if (app->getState() == Application::APP_CREATED_STATE)
+        if (mMode == OVER_TCP_THREADED)
+        {
+            // The node's thread starts it
+            if (!it.second.mThread &&
+                app->getState() == Application::APP_CREATED_STATE)
+            {
+                startNodeThread(it.second);
+            }
+        }
+        else if (app->getState() == Application::APP_CREATED_STATE)
         {
             app->start();
         }
@@ -349,6 +472,15 @@ Simulation::startAllNodes()
 void
 Simulation::stopAllNodes()
 {
+    if (mMode == OVER_TCP_THREADED)
+    {
+        for (auto& n : mNodes)
+        {
+            stopNodeThread(n.second);
+        }
+        return;
+    }
+
     for (auto& n : mNodes)
     {
         auto app = n.second.mApp;
@@ -365,6 +497,10 @@ Simulation::crankNode(NodeID const& id, VirtualClock::time_point timeout)
     auto p = mNodes[id];
     auto clock = p.mClock;
     auto app = p.mApp;
+    if (p.mThread)
+    {
+        throw std::runtime_error("Can't crank node that runs on its own");
+    }
     if (app->getState() == Application::APP_CREATED_STATE)
     {
         throw std::runtime_error("Can't crank node that is not started");
@@ -417,6 +553,29 @@ Simulation::crankAllNodes(int nbTicks)
 
     std::size_t count = 0;
 
+    if (mMode == OVER_TCP_THREADED)
+    {
+        // Nodes run on their own, the simulation only has its own timers
+        // to dispatch
+        for (int i = 0; i < nbTicks; ++i)
+        {
+            auto n = mClock.crank(false);
+            if (n == 0)
+            {
+                std::this_thread::sleep_for(chrono::milliseconds(1));
+            }
+            count += n;
+        }
+        for (auto const& p : mNodes)
+        {
+            if (p.second.mThread && p.second.mThread->mRunning)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
     VirtualTimer mainQuantumTimer(*mIdleApp);
 
     bool debugFmt = Logging::logDebug("Process");
@@ -523,7 +682,10 @@ Simulation::haveAllExternalized(uint32 num, uint32 maxSpread,
         {
             continue;
         }
-        auto n = app->getLedgerManager().getLastClosedLedgerNum();
+        uint32_t n = 0;
+        runOnNode(it->first, [&]() {
+            n = app->getLedgerManager().getLastClosedLedgerNum();
+        });
         if (n < min)
             min = n;
         if (n > max)
@@ -732,21 +894,23 @@ class ConsoleReporterWithSum : public medida::reporting::ConsoleReporter
 string
 Simulation::metricsSummary(string domain)
 {
-    auto& registry = getNodes().front()->getMetrics();
-    auto const& metrics = registry.GetAllMetrics();
     std::stringstream out;
+    runOnNode(mNodes.begin()->first, [&]() {
+        auto& registry = mNodes.begin()->second.mApp->getMetrics();
+        auto const& metrics = registry.GetAllMetrics();
 
-    ConsoleReporterWithSum reporter{registry, out};
-    for (auto const& kv : metrics)
-    {
-        auto metric = kv.first;
-        if (domain == "" || metric.domain() == domain)
+        ConsoleReporterWithSum reporter{registry, out};
+        for (auto const& kv : metrics)
         {
-            out << "Metric " << metric.domain() << "." << metric.type() << "."
-                << metric.name() << "\n";
-            kv.second->Process(reporter);
+            auto metric = kv.first;
+            if (domain == "" || metric.domain() == domain)
+            {
+                out << "Metric " << metric.domain() << "." << metric.type()
+                    << "." << metric.name() << "\n";
+                kv.second->Process(reporter);
+            }
         }
-    }
+    });
     return out.str();
 }
 
@@ -19,6 +19,9 @@
 #include "util/XDROperators.h"
 #include "xdr/Stellar-types.h"
 
+#include <atomic>
+#include <thread>
+
 #define SIMULATION_CREATE_NODE(N) \
     const Hash v##N##VSeed = sha256("NODE_SEED_" #N); \
     const SecretKey v##N##SecretKey = SecretKey::fromSeed(v##N##VSeed); \
@@ -32,7 +35,13 @@ class Simulation
     enum Mode
     {
         OVER_TCP,
-        OVER_LOOPBACK
+        OVER_LOOPBACK,
+        // Each node runs its own main loop, in real time, on a thread of its
+        // own once started, connected to the others over TCP on the loopback
+        // interface. This scales to hundreds of nodes, as long as there are
+        // cores for them. The simulation's thread only waits: anything
+        // touching a running node must go through runOnNode.
+        OVER_TCP_THREADED
     };
 
     using pointer = std::shared_ptr<Simulation>;
@@ -52,6 +61,10 @@ class Simulation
                                  uint32_t startAtLedger = 0,
                                  std::string const& startAtHash = "");
     Application::pointer getNode(NodeID nodeID);
+    // Runs `f` on the thread of the node and waits for it to be done. When
+    // the node doesn't run on a thread of its own, or not anymore, runs `f`
+    // right away.
+    void runOnNode(NodeID const& id, std::function<void()> const& f);
     std::vector<Application::pointer> getNodes();
     std::vector<NodeID> getNodeIDs();
 
@@ -89,6 +102,7 @@ class Simulation
     void dropLoopbackConnection(NodeID initiator, NodeID acceptor);
     void addTCPConnection(NodeID initiator, NodeID acception);
     void dropAllConnections(NodeID const& id);
+    bool isOverTCP() const;
 
     bool mVirtualClockMode;
     VirtualClock mClock;
@@ -96,10 +110,19 @@ class Simulation
     int mConfigCount;
     Application::pointer mIdleApp;
 
+    // The thread running a node in OVER_TCP_THREADED mode
+    struct NodeThread
+    {
+        std::thread mThread;
+        std::atomic<bool> mStop{false};
+        std::atomic<bool> mRunning{true};
+    };
+
     struct Node
     {
         std::shared_ptr<VirtualClock> mClock;
         Application::pointer mApp;
+        std::shared_ptr<NodeThread> mThread;
 
         ~Node()
         {
@@ -108,6 +131,9 @@ class Simulation
         }
     };
     std::map<NodeID, Node> mNodes;
+
+    void startNodeThread(Node& node);
+    void stopNodeThread(Node& node);
     std::vector<std::pair<NodeID, NodeID>> mPendingConnections;
     std::vector<std::shared_ptr<LoopbackPeerConnection>> mLoopbackConnections;
 
@@ -61,6 +61,51 @@ TEST_CASE("generate load with unique accounts", "[loadgen]")
             },
             300 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
     }
+    SECTION("signed in the background")
+    {
+        loadGen.generateLoad(GeneratedLoadConfig::createAccountsLoad(
+            /* nAccounts */ 1000,
+            /* txRate */ 1));
+        simulation->crankUntil(
+            [&]() {
+                return app.getMetrics()
+                           .NewMeter({"loadgen", "run", "complete"}, "run")
+                           .count() == 1;
+            },
+            100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+        for (auto mode : {LoadGenMode::PAY, LoadGenMode::PRETEND,
+                          LoadGenMode::MIXED_CLASSIC})
+        {
+            auto cfg = GeneratedLoadConfig::txLoad(mode,
+                                                   /* nAccounts */ 1000,
+                                                   /* nTxs */ 300,
+                                                   /* txRate */ 30);
+            cfg.backgroundSigning = true;
+            if (mode == LoadGenMode::MIXED_CLASSIC)
+            {
+                cfg.getMutDexTxPercent() = 50;
+            }
+            auto completed = app.getMetrics()
+                                 .NewMeter({"loadgen", "run", "complete"},
+                                           "run")
+                                 .count();
+            loadGen.generateLoad(cfg);
+            simulation->crankUntil(
+                [&]() {
+                    return app.getMetrics()
+                               .NewMeter({"loadgen", "run", "complete"}, "run")
+                               .count() == completed + 1;
+                },
+                100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+        }
+        REQUIRE(app.getMetrics()
+                    .NewMeter({"loadgen", "run", "failed"}, "run")
+                    .count() == 0);
+        REQUIRE(app.getMetrics()
+                    .NewMeter({"loadgen", "txn", "presigned"}, "txn")
+                    .count() > 0);
+    }
     SECTION("invalid loadgen parameters")
     {
         // Succesfully create accounts
@@ -91,6 +136,74 @@ TEST_CASE("generate load with unique accounts", "[loadgen]")
     }
 }
 
+TEST_CASE("generate open-loop load", "[loadgen]")
+{
+    Hash networkID = sha256(getTestConfig().NETWORK_PASSPHRASE);
+    Simulation::pointer simulation =
+        Topologies::pair(Simulation::OVER_LOOPBACK, networkID, [](int i) {
+            auto cfg = getTestConfig(i);
+            cfg.TESTING_UPGRADE_MAX_TX_SET_SIZE = 5000;
+            return cfg;
+        });
+
+    simulation->startAllNodes();
+    simulation->crankUntil(
+        [&]() { return simulation->haveAllExternalized(3, 1); },
+        2 * Herder::EXP_LEDGER_TIMESPAN_SECONDS, false);
+
+    auto& app = *simulation->getNodes()[0];
+    auto& loadGen = app.getLoadGenerator();
+    auto& complete =
+        app.getMetrics().NewMeter({"loadgen", "run", "complete"}, "run");
+    auto& failed =
+        app.getMetrics().NewMeter({"loadgen", "run", "failed"}, "run");
+
+    SECTION("not for account creation")
+    {
+        auto cfg = GeneratedLoadConfig::createAccountsLoad(
+            /* nAccounts */ 100,
+            /* txRate */ 1);
+        cfg.openLoop = true;
+        loadGen.generateLoad(cfg);
+        simulation->crankUntil([&]() { return failed.count() == 1; },
+                               10 * Herder::EXP_LEDGER_TIMESPAN_SECONDS,
+                               false);
+    }
+    SECTION("latency of every transaction")
+    {
+        loadGen.generateLoad(GeneratedLoadConfig::createAccountsLoad(
+            /* nAccounts */ 1000,
+            /* txRate */ 1));
+        simulation->crankUntil([&]() { return complete.count() == 1; },
+                               100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS,
+                               false);
+
+        uint32_t nTxs = 200;
+        auto cfg = GeneratedLoadConfig::txLoad(LoadGenMode::PAY,
+                                               /* nAccounts */ 1000, nTxs,
+                                               /* txRate */ 20);
+        cfg.openLoop = true;
+        loadGen.generateLoad(cfg);
+        simulation->crankUntil([&]() { return complete.count() == 2; },
+                               100 * Herder::EXP_LEDGER_TIMESPAN_SECONDS,
+                               false);
+        REQUIRE(failed.count() == 0);
+
+        auto& latency =
+            app.getMetrics().NewTimer({"loadgen", "txn", "latency"});
+        auto& dropped =
+            app.getMetrics().NewMeter({"loadgen", "txn", "dropped"}, "txn");
+        REQUIRE(latency.count() + dropped.count() == nTxs);
+        // Nothing is turned away at this rate
+        REQUIRE(dropped.count() == 0);
+        REQUIRE(latency.min() > 0);
+        REQUIRE(latency.max() <=
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    4 * Herder::EXP_LEDGER_TIMESPAN_SECONDS)
+                    .count());
+    }
+}
+
 TEST_CASE("generate soroban load", "[loadgen][soroban]")
 {
     uint32_t const numDataEntries = 5;
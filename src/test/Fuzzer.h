@@ -4,6 +4,8 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace stellar
@@ -24,7 +26,13 @@ class Fuzzer
     // attempts to apply it to the state according to whatever apply may mean,
     // i.e. apply a transaction in the case of a TransactionFuzzer or send a
     // message in case of an OverlayFuzzer
-    virtual void inject(std::string const& filename) = 0;
+    void inject(std::string const& filename);
+    // injectBytes is inject for an input already in memory, which is what
+    // in-process fuzzing engines such as libFuzzer hand over. Inputs of
+    // xdrSizeLimit() bytes or more are skipped. Each input is applied to the
+    // state as it was right after initialize(), so that many inputs can be
+    // run in a single process.
+    virtual void injectBytes(uint8_t const* data, size_t size) = 0;
     virtual void initialize() = 0;
     virtual void shutdown() = 0;
     // genFuzz randomly generates an XDR input for the given fuzzer. For the
@@ -1929,24 +1929,17 @@ TransactionFuzzer::shutdown()
 }
 
 void
-TransactionFuzzer::inject(std::string const& filename)
+TransactionFuzzer::injectBytes(uint8_t const* data, size_t size)
 {
-    std::ifstream in;
-    in.exceptions(std::ios::badbit);
-    in.open(filename, std::ios::binary);
-
-    xdr::xvector<Operation> ops;
-    std::vector<char> bins(xdrSizeLimit());
-    in.read(bins.data(), bins.size());
-    auto actual = in.gcount();
     // stop if either
-    // we could read the whole buffer (too much data was generated by the
-    // fuzzer), or got a short read
-    if (actual == xdrSizeLimit() || actual == 0)
+    // the input fills the whole buffer (too much data was generated by the
+    // fuzzer), or is empty
+    if (size >= static_cast<size_t>(xdrSizeLimit()) || size == 0)
     {
         return;
     }
-    bins.resize(actual);
+    xdr::xvector<Operation> ops;
+    std::vector<char> bins(data, data + size);
     try
     {
         xdr::xdr_from_fuzzer_opaque(mStoredLedgerKeys, mStoredPoolIDs, bins,
@@ -2070,22 +2063,15 @@ OverlayFuzzer::initialize()
 }
 
 void
-OverlayFuzzer::inject(std::string const& filename)
+OverlayFuzzer::injectBytes(uint8_t const* data, size_t size)
 {
-    std::ifstream in;
-    in.exceptions(std::ios::badbit);
-    in.open(filename, std::ios::binary);
-
-    StellarMessage msg;
-    std::vector<char> bins(xdrSizeLimit());
-    in.read(bins.data(), bins.size());
-    auto actual = in.gcount();
-    // if we could read the whole buffer, or got a short read, stop
-    if (in || actual == 0)
+    // if the input fills the whole buffer, or is empty, stop
+    if (size >= static_cast<size_t>(xdrSizeLimit()) || size == 0)
     {
         return;
     }
-    bins.resize(actual);
+    StellarMessage msg;
+    std::vector<char> bins(data, data + size);
     try
     {
         xdr::xdr_from_fuzzer_opaque(mStoredLedgerKeys, mStoredPoolIDs, bins,
@@ -38,7 +38,7 @@ class TransactionFuzzer : public Fuzzer
     TransactionFuzzer()
     {
     }
-    void inject(std::string const& filename) override;
+    void injectBytes(uint8_t const* data, size_t size) override;
     void initialize() override;
     void shutdown() override;
     void genFuzz(std::string const& filename) override;
@@ -72,7 +72,7 @@ class OverlayFuzzer : public Fuzzer
     OverlayFuzzer()
     {
     }
-    void inject(std::string const& filename) override;
+    void injectBytes(uint8_t const* data, size_t size) override;
     void initialize() override;
     void shutdown() override;
     void genFuzz(std::string const& filename) override;
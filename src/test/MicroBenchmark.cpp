@@ -0,0 +1,83 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "test/MicroBenchmark.h"
+#include "main/StellarCoreVersion.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <json/json.h>
+#include <stdexcept>
+#include <vector>
+
+namespace stellar
+{
+
+namespace
+{
+size_t const MICROBENCH_RUNS = 5;
+std::chrono::milliseconds const MICROBENCH_RUN_TIME{200};
+
+Json::Value gMicroBenchmarkResults{Json::objectValue};
+}
+
+void
+runMicroBenchmark(std::string const& name, std::function<size_t()> const& op)
+{
+    releaseAssert(!gMicroBenchmarkResults.isMember(name));
+    using clock = std::chrono::steady_clock;
+    op();
+
+    std::vector<double> rates;
+    size_t totalOps = 0;
+    for (size_t run = 0; run < MICROBENCH_RUNS; ++run)
+    {
+        size_t ops = 0;
+        auto start = clock::now();
+        std::chrono::duration<double> elapsed{0};
+        do
+        {
+            ops += op();
+            elapsed = clock::now() - start;
+        } while (elapsed < MICROBENCH_RUN_TIME);
+        releaseAssert(ops > 0);
+        rates.emplace_back(ops / elapsed.count());
+        totalOps += ops;
+    }
+    std::sort(rates.begin(), rates.end());
+    double median = rates[rates.size() / 2];
+
+    auto& res = gMicroBenchmarkResults[name];
+    res["ops_per_second"] = median;
+    res["ns_per_op"] = 1e9 / median;
+    res["min_ops_per_second"] = rates.front();
+    res["max_ops_per_second"] = rates.back();
+    res["ops"] = Json::UInt64(totalOps);
+    LOG_INFO(DEFAULT_LOG, "microbench {}: {:.0f} ops/s, {:.1f} ns/op", name,
+             median, 1e9 / median);
+}
+
+void
+writeMicroBenchmarkResults(std::string const& filename)
+{
+    Json::Value out;
+    out["version"] = STELLAR_CORE_VERSION;
+    out["runs"] = Json::UInt64(MICROBENCH_RUNS);
+    out["run_ms"] = Json::Int64(MICROBENCH_RUN_TIME.count());
+    out["benchmarks"] = gMicroBenchmarkResults;
+
+    std::ofstream f(filename);
+    f << out.toStyledString();
+    if (!f)
+    {
+        throw std::runtime_error("failed to write benchmark results to " +
+                                 filename);
+    }
+    LOG_INFO(DEFAULT_LOG, "Wrote {} benchmark results to {}",
+             gMicroBenchmarkResults.size(), filename);
+}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace stellar
+{
+
+// Microbenchmarks of hot paths are the test cases tagged [microbench]. Run
+// them with `stellar-core test '[microbench]' --bench-output FILE` to have
+// their results written to FILE as JSON, so that runs on different builds
+// can be compared.
+//
+// Runs `op` for a warm-up round, then repeatedly for about 200ms, five
+// times, and records the median throughput under `name`. `op` does some
+// operations and returns how many, so that cheap ones can be batched. Each
+// name must be recorded once per test run.
+void runMicroBenchmark(std::string const& name,
+                       std::function<size_t()> const& op);
+
+// Writes everything recorded by runMicroBenchmark so far
+void writeMicroBenchmarkResults(std::string const& filename);
+}
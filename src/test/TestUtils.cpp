@@ -139,8 +139,10 @@ BucketListDepthModifier::~BucketListDepthModifier()
 }
 }
 
-TestInvariantManager::TestInvariantManager(medida::MetricsRegistry& registry)
-    : InvariantManagerImpl(registry)
+TestInvariantManager::TestInvariantManager(medida::MetricsRegistry& registry,
+                                           uint32_t checkThreads,
+                                           uint32_t samplePercent)
+    : InvariantManagerImpl(registry, checkThreads, samplePercent)
 {
 }
 
@@ -160,7 +162,9 @@ TestApplication::TestApplication(VirtualClock& clock, Config const& cfg)
 std::unique_ptr<InvariantManager>
 TestApplication::createInvariantManager()
 {
-    return std::make_unique<TestInvariantManager>(getMetrics());
+    return std::make_unique<TestInvariantManager>(
+        getMetrics(), getConfig().INVARIANT_CHECK_THREADS,
+        getConfig().INVARIANT_CHECK_SAMPLE_PERCENT);
 }
 
 TimePoint
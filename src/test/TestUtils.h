@@ -53,7 +53,9 @@ testBucketMetadata(uint32_t protocolVersion)
 class TestInvariantManager : public InvariantManagerImpl
 {
   public:
-    TestInvariantManager(medida::MetricsRegistry& registry);
+    TestInvariantManager(medida::MetricsRegistry& registry,
+                         uint32_t checkThreads = 0,
+                         uint32_t samplePercent = 100);
 
   private:
     virtual void
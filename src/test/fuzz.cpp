@@ -5,10 +5,23 @@
 #include "test/fuzz.h"
 #include "test/FuzzerImpl.h"
 #include "test/test.h"
+#include "util/Logging.h"
 #include "util/XDRStream.h"
 #include "util/types.h"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <xdrpp/autocheck.h>
+
+#ifdef LIBFUZZER_MODE
+// Provided by libFuzzer built without its own main(), see --enable-libfuzzer
+extern "C" int LLVMFuzzerRunDriver(int* argc, char*** argv,
+                                   int (*UserCb)(uint8_t const* Data,
+                                                 size_t Size));
+#endif // LIBFUZZER_MODE
+
 /**
  * This is a very simple fuzzer _stub_. It's intended to be run under an
  * external fuzzer with some fuzzing brains, at this time, preferably AFL.
@@ -19,11 +32,13 @@
  *     random FuzzTransactionInputs or StellarMessages. This is the mode you use
  *     to generate seed data for the external fuzzer's corpus.
  *
- *   - In fuzz mode it reads back a file and appplies it to a stellar-core
+ *   - In fuzz mode it reads back files and appplies them to a stellar-core
  *     instance, applying but not committing transactions one by one to simulate
  *     certain transaction/overlay scenarios. It exits when it's applied the
- *     input. This is the mode the external fuzzer will run its mutant inputs
- *     through.
+ *     inputs. This is the mode the external fuzzer will run its mutant inputs
+ *     through. The instance is set up once per process and each input starts
+ *     over from that state, so AFL's persistent mode, libFuzzer or replaying
+ *     a corpus directory can run many inputs without restarting.
  *
  */
 
@@ -47,14 +62,89 @@ createFuzzer(int processID, FuzzerMode fuzzerMode)
 }
 }
 
+void
+Fuzzer::inject(std::string const& filename)
+{
+    std::ifstream in;
+    in.exceptions(std::ios::badbit);
+    in.open(filename, std::ios::binary);
+
+    // read one byte past the limit so that injectBytes can tell inputs that
+    // are too large
+    std::vector<char> bins(xdrSizeLimit() + 1);
+    in.read(bins.data(), bins.size());
+    injectBytes(reinterpret_cast<uint8_t const*>(bins.data()), in.gcount());
+}
+
+namespace
+{
+// Directories stand for all the files they hold, so that a whole corpus can
+// be replayed by a single process
+std::vector<std::string>
+expandFuzzInputs(std::vector<std::string> const& inputs)
+{
+    std::vector<std::string> res;
+    for (auto const& input : inputs)
+    {
+        if (!std::filesystem::is_directory(input))
+        {
+            res.emplace_back(input);
+            continue;
+        }
+        std::vector<std::string> files;
+        for (auto const& entry : std::filesystem::directory_iterator(input))
+        {
+            if (entry.is_regular_file())
+            {
+                files.emplace_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        res.insert(res.end(), files.begin(), files.end());
+    }
+    return res;
+}
+
+#ifdef LIBFUZZER_MODE
+Fuzzer* gLibFuzzerTarget = nullptr;
+
+int
+libFuzzerTestOneInput(uint8_t const* data, size_t size)
+{
+    gLibFuzzerTarget->injectBytes(data, size);
+    return 0;
+}
+#endif // LIBFUZZER_MODE
+}
+
 #define PERSIST_MAX 1000000
 void
-fuzz(std::string const& filename, std::vector<std::string> const& metrics,
-     int processID, FuzzerMode fuzzerMode)
+fuzz(std::vector<std::string> const& inputs,
+     std::vector<std::string> const& metrics, int processID,
+     FuzzerMode fuzzerMode)
 {
     auto fuzzer = FuzzUtils::createFuzzer(processID, fuzzerMode);
     fuzzer->initialize();
 
+#ifdef LIBFUZZER_MODE
+    // libFuzzer runs the loop itself, taking the inputs as corpus
+    // directories or as single inputs to run, just like its own main()
+    gLibFuzzerTarget = fuzzer.get();
+    std::vector<char*> args{const_cast<char*>("stellar-core")};
+    for (auto const& input : inputs)
+    {
+        args.emplace_back(const_cast<char*>(input.c_str()));
+    }
+    args.emplace_back(nullptr);
+    int argc = static_cast<int>(args.size() - 1);
+    char** argv = args.data();
+    LLVMFuzzerRunDriver(&argc, &argv, libFuzzerTestOneInput);
+    gLibFuzzerTarget = nullptr;
+#else
+    auto files = expandFuzzInputs(inputs);
+    auto start = std::chrono::steady_clock::now();
+    size_t runs = 0;
+
 // "To make this work, the library and this shim need to be compiled in LLVM
 // mode using afl-clang-fast (other compiler wrappers will *not* work)."
 // -- AFL docs
@@ -62,8 +152,19 @@ fuzz(std::string const& filename, std::vector<std::string> const& metrics,
     while (__AFL_LOOP(PERSIST_MAX))
 #endif // AFL_LLVM_MODE
     {
-        fuzzer->inject(filename);
+        for (auto const& file : files)
+        {
+            fuzzer->inject(file);
+            ++runs;
+        }
     }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    LOG_INFO(DEFAULT_LOG, "Ran {} fuzz inputs in {:.3f}s ({:.0f} execs/s)",
+             runs, elapsed.count(),
+             elapsed.count() > 0 ? runs / elapsed.count() : 0.0);
+#endif // LIBFUZZER_MODE
     cleanupTmpDirs();
     fuzzer->shutdown();
 }
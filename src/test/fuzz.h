@@ -24,6 +24,10 @@ namespace FuzzUtils
 std::unique_ptr<Fuzzer> createFuzzer(int processID, FuzzerMode fuzzerMode);
 }
 
-void fuzz(std::string const& filename, std::vector<std::string> const& metrics,
-          int processID, FuzzerMode fuzzerMode);
+// Sets up a fuzzer and injects each input, where directories stand for the
+// files they hold; with LIBFUZZER_MODE, hands the inputs and the fuzzer over
+// to libFuzzer instead.
+void fuzz(std::vector<std::string> const& inputs,
+          std::vector<std::string> const& metrics, int processID,
+          FuzzerMode fuzzerMode);
 }
@@ -19,6 +19,7 @@
 #include "main/StellarCoreVersion.h"
 #include "main/dumpxdr.h"
 #include "test.h"
+#include "test/MicroBenchmark.h"
 #include "test/TestUtils.h"
 #include "util/Logging.h"
 #include "util/Math.h"
@@ -334,6 +335,7 @@ runTest(CommandLineArgs const& args)
     std::string recordTestTxMeta;
     std::string checkTestTxMeta;
     std::string debugTestTxMeta;
+    std::string benchOutput;
 
     auto parser = session.cli();
     parser |= Catch::clara::Opt(
@@ -359,6 +361,8 @@ runTest(CommandLineArgs const& args)
     parser |=
         Catch::clara::Opt(debugTestTxMeta, "FILENAME")["--debug-test-tx-meta"](
             "dump full TxMeta from all tests to FILENAME");
+    parser |= Catch::clara::Opt(benchOutput, "FILENAME")["--bench-output"](
+        "write the results of [microbench] tests to FILENAME as JSON");
 
     session.cli(parser);
 
@@ -459,6 +463,10 @@ runTest(CommandLineArgs const& args)
     {
         reportTestTxMeta();
     }
+    if (!benchOutput.empty())
+    {
+        writeMicroBenchmarkResults(benchOutput);
+    }
     return r;
 }
 
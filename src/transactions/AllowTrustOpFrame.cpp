@@ -12,7 +12,7 @@
 #include "main/Application.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -15,7 +15,7 @@
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <algorithm>
 
 #include "main/Application.h"
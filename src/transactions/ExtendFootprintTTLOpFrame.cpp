@@ -6,7 +6,7 @@
 #include "TransactionUtils.h"
 #include "ledger/LedgerManagerImpl.h"
 #include "ledger/LedgerTypeUtils.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -74,6 +74,9 @@ ExtendFootprintTTLOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     // ledger. Current ledger has to be payed for in order for entry
     // to be extendable, hence don't include it.
     uint32_t newLiveUntilLedgerSeq = ledgerSeq + mExtendFootprintTTLOp.extendTo;
+
+    prefetchFootprintEntries(ltx, footprint.readOnly,
+                             metrics.mMetrics.mExtFpTtlOpPrefetchEntry);
     for (auto const& lk : footprint.readOnly)
     {
         auto ttlKey = getTTLKey(lk);
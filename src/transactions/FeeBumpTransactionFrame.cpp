@@ -53,6 +53,19 @@ FeeBumpTransactionFrame::sorobanResources() const
     return mInnerTx->sorobanResources();
 }
 
+TransactionFrame&
+FeeBumpTransactionFrame::getSorobanFeeFrame()
+{
+    return *mInnerTx;
+}
+
+void
+FeeBumpTransactionFrame::setSignaturesTrusted(bool trusted)
+{
+    // Only the inner transaction's signatures are checked when applying
+    mInnerTx->setSignaturesTrusted(trusted);
+}
+
 xdr::xvector<DiagnosticEvent> const&
 FeeBumpTransactionFrame::getDiagnosticEvents() const
 {
@@ -116,7 +129,10 @@ FeeBumpTransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
     {
         LedgerTxn ltxTx(ltx);
         removeOneTimeSignerKeyFromFeeSource(ltxTx);
-        meta.pushTxChangesBefore(ltxTx.getChanges());
+        if (meta.isEnabled())
+        {
+            meta.pushTxChangesBefore(ltxTx.getChanges());
+        }
         ltxTx.commit();
     }
     catch (std::exception& e)
@@ -411,8 +427,8 @@ FeeBumpTransactionFrame::getContentsHash() const
 {
     if (isZero(mContentsHash))
     {
-        mContentsHash = sha256(xdr::xdr_to_opaque(
-            mNetworkID, ENVELOPE_TYPE_TX_FEE_BUMP, mEnvelope.feeBump().tx));
+        mContentsHash = xdrSha256(mNetworkID, ENVELOPE_TYPE_TX_FEE_BUMP,
+                                  mEnvelope.feeBump().tx);
     }
     return mContentsHash;
 }
@@ -422,17 +438,40 @@ FeeBumpTransactionFrame::getFullHash() const
 {
     if (isZero(mFullHash))
     {
-        mFullHash = sha256(xdr::xdr_to_opaque(mEnvelope));
+        mFullHash = xdrSha256(mEnvelope);
     }
     return mFullHash;
 }
 
+void
+FeeBumpTransactionFrame::collectUncachedHashes(UncachedHashes& hashes) const
+{
+    if (isZero(mFullHash))
+    {
+        hashes.emplace_back(&mFullHash, xdr::xdr_to_opaque(mEnvelope));
+    }
+    if (isZero(mContentsHash))
+    {
+        hashes.emplace_back(
+            &mContentsHash,
+            xdr::xdr_to_opaque(mNetworkID, ENVELOPE_TYPE_TX_FEE_BUMP,
+                               mEnvelope.feeBump().tx));
+    }
+    mInnerTx->collectUncachedHashes(hashes);
+}
+
 Hash const&
 FeeBumpTransactionFrame::getInnerFullHash() const
 {
     return mInnerTx->getFullHash();
 }
 
+TransactionFrame const&
+FeeBumpTransactionFrame::getInnerTx() const
+{
+    return *mInnerTx;
+}
+
 uint32_t
 FeeBumpTransactionFrame::getNumOperations() const
 {
@@ -79,7 +79,9 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
 
     Hash const& getContentsHash() const override;
     Hash const& getFullHash() const override;
+    void collectUncachedHashes(UncachedHashes& hashes) const override;
     Hash const& getInnerFullHash() const;
+    TransactionFrame const& getInnerTx() const;
 
     uint32_t getNumOperations() const override;
     Resource getResources(bool useByteLimitInClassic) const override;
@@ -114,6 +116,8 @@ class FeeBumpTransactionFrame : public TransactionFrameBase
     SorobanResources const& sorobanResources() const override;
     xdr::xvector<DiagnosticEvent> const& getDiagnosticEvents() const override;
     virtual int64 declaredSorobanResourceFee() const override;
+    TransactionFrame& getSorobanFeeFrame() override;
     virtual bool XDRProvidesValidFee() const override;
+    void setSignaturesTrusted(bool trusted) override;
 };
 }
@@ -6,6 +6,7 @@
 // This needs to be included first
 #include "TransactionUtils.h"
 #include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
 #include "xdr/Stellar-ledger-entries.h"
 #include <cstdint>
 #include <json/json.h>
@@ -25,9 +26,10 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTypeUtils.h"
+#include "ledger/SorobanContractUsage.h"
 #include "rust/RustBridge.h"
 #include "transactions/InvokeHostFunctionOpFrame.h"
-#include <Tracy.hpp>
+#include "transactions/ParallelSorobanApply.h"
 #include <crypto/SHA.h>
 
 namespace stellar
@@ -40,26 +42,11 @@ isCodeKey(LedgerKey const& lk)
     return lk.type() == CONTRACT_CODE;
 }
 
-template <typename T>
-std::vector<uint8_t>
-toVec(T const& t)
-{
-    return std::vector<uint8_t>(xdr::xdr_to_opaque(t));
-}
-
-template <typename T>
-CxxBuf
-toCxxBuf(T const& t)
-{
-    return CxxBuf{std::make_unique<std::vector<uint8_t>>(toVec(t))};
-}
-
 CxxLedgerInfo
-getLedgerInfo(AbstractLedgerTxn& ltx, Application& app,
+getLedgerInfo(LedgerHeader const& hdr, Hash const& networkID,
               SorobanNetworkConfig const& sorobanConfig)
 {
     CxxLedgerInfo info{};
-    auto const& hdr = ltx.loadHeader().current();
     info.base_reserve = hdr.baseReserve;
     info.protocol_version = hdr.ledgerVersion;
     info.sequence_number = hdr.ledgerSeq;
@@ -71,13 +58,9 @@ getLedgerInfo(AbstractLedgerTxn& ltx, Application& app,
         sorobanConfig.stateArchivalSettings().minTemporaryTTL;
     info.max_entry_ttl = sorobanConfig.stateArchivalSettings().maxEntryTTL;
 
-    auto cpu = sorobanConfig.cpuCostParams();
-    auto mem = sorobanConfig.memCostParams();
-
-    info.cpu_cost_params = toCxxBuf(cpu);
-    info.mem_cost_params = toCxxBuf(mem);
+    info.cpu_cost_params = toCxxBuf(sorobanConfig.cpuCostParams());
+    info.mem_cost_params = toCxxBuf(sorobanConfig.memCostParams());
 
-    auto& networkID = app.getNetworkID();
     info.network_id.reserve(networkID.size());
     for (auto c : networkID)
     {
@@ -140,10 +123,30 @@ struct HostFunctionMetrics
 
     bool mSuccess{false};
 
+    // Set for contract invocations whose usage is tracked per contract
+    SorobanContractUsage* mContractUsage{nullptr};
+    uint32_t mLedgerSeq{0};
+    Hash mContractID;
+    std::string mFunction;
+
     HostFunctionMetrics(SorobanMetrics& metrics) : mMetrics(metrics)
     {
     }
 
+    void
+    trackContractUsage(SorobanContractUsage& usage, uint32_t ledgerSeq,
+                       InvokeContractArgs const& args)
+    {
+        if (usage.isEnabled() &&
+            args.contractAddress.type() == SC_ADDRESS_TYPE_CONTRACT)
+        {
+            mContractUsage = &usage;
+            mLedgerSeq = ledgerSeq;
+            mContractID = args.contractAddress.contractId();
+            mFunction = args.functionName;
+        }
+    }
+
     void
     noteReadEntry(bool isCodeEntry, uint32_t keySize, uint32_t entrySize)
     {
@@ -226,6 +229,18 @@ struct HostFunctionMetrics
         {
             mMetrics.mHostFnOpFailure.Mark();
         }
+
+        if (mContractUsage)
+        {
+            SorobanInvocationUsage usage;
+            usage.mCpuInsn = mCpuInsn;
+            usage.mMemByte = mMemByte;
+            usage.mReadByte = mLedgerReadByte;
+            usage.mWriteByte = mLedgerWriteByte;
+            usage.mInvokeTimeNsecs = mInvokeTimeNsecs;
+            usage.mSuccess = mSuccess;
+            mContractUsage->record(mLedgerSeq, mContractID, mFunction, usage);
+        }
     }
     medida::TimerContext
     getExecTimer()
@@ -331,6 +346,14 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     Config const& appConfig = app.getConfig();
     HostFunctionMetrics metrics(app.getLedgerManager().getSorobanMetrics());
     auto timeScope = metrics.getExecTimer();
+    if (mInvokeHostFunction.hostFunction.type() ==
+        HOST_FUNCTION_TYPE_INVOKE_CONTRACT)
+    {
+        metrics.trackContractUsage(
+            app.getLedgerManager().getSorobanContractUsage(),
+            ltx.loadHeader().current().ledgerSeq,
+            mInvokeHostFunction.hostFunction.invokeContract());
+    }
     auto const& sorobanConfig =
         app.getLedgerManager().getSorobanNetworkConfig();
 
@@ -467,30 +490,30 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
         return false;
     }
 
-    rust::Vec<CxxBuf> authEntryCxxBufs;
-    authEntryCxxBufs.reserve(mInvokeHostFunction.auth.size());
-    for (auto const& authEntry : mInvokeHostFunction.auth)
-    {
-        authEntryCxxBufs.emplace_back(toCxxBuf(authEntry));
-    }
-
     InvokeHostFunctionOutput out{};
     out.success = false;
     try
     {
-        CxxBuf basePrngSeedBuf{};
-        basePrngSeedBuf.data = std::make_unique<std::vector<uint8_t>>();
-        basePrngSeedBuf.data->assign(sorobanBasePrngSeed.begin(),
-                                     sorobanBasePrngSeed.end());
-
-        out = rust_bridge::invoke_host_function(
-            appConfig.CURRENT_LEDGER_PROTOCOL_VERSION,
-            appConfig.ENABLE_SOROBAN_DIAGNOSTIC_EVENTS, resources.instructions,
-            toCxxBuf(mInvokeHostFunction.hostFunction), toCxxBuf(resources),
-            toCxxBuf(getSourceID()), authEntryCxxBufs,
-            getLedgerInfo(ltx, app, sorobanConfig), ledgerEntryCxxBufs,
-            ttlEntryCxxBufs, basePrngSeedBuf,
-            sorobanConfig.rustBridgeRentFeeConfiguration());
+        // The output may already have been computed by a worker thread from
+        // the same inputs
+        auto parallelApply = app.getLedgerManager().getParallelSorobanApply();
+        std::optional<InvokeHostFunctionOutput> precomputed;
+        if (parallelApply)
+        {
+            precomputed = parallelApply->takeOutput(
+                sorobanBasePrngSeed, ledgerEntryCxxBufs, ttlEntryCxxBufs);
+        }
+        if (precomputed)
+        {
+            out = std::move(*precomputed);
+        }
+        else
+        {
+            out = invokeHostFunction(
+                appConfig, mInvokeHostFunction, resources, getSourceID(),
+                ltx.loadHeader().current(), app.getNetworkID(), sorobanConfig,
+                ledgerEntryCxxBufs, ttlEntryCxxBufs, sorobanBasePrngSeed);
+        }
         metrics.mCpuInsn = out.cpu_insns;
         metrics.mMemByte = out.mem_bytes;
         metrics.mInvokeTimeNsecs = out.time_nsecs;
@@ -689,6 +712,36 @@ InvokeHostFunctionOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     return true;
 }
 
+InvokeHostFunctionOutput
+InvokeHostFunctionOpFrame::invokeHostFunction(
+    Config const& appConfig, InvokeHostFunctionOp const& op,
+    SorobanResources const& resources, AccountID const& sourceID,
+    LedgerHeader const& header, Hash const& networkID,
+    SorobanNetworkConfig const& sorobanConfig,
+    rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+    rust::Vec<CxxBuf> const& ttlEntryCxxBufs, Hash const& sorobanBasePrngSeed)
+{
+    rust::Vec<CxxBuf> authEntryCxxBufs;
+    authEntryCxxBufs.reserve(op.auth.size());
+    for (auto const& authEntry : op.auth)
+    {
+        authEntryCxxBufs.emplace_back(toCxxBuf(authEntry));
+    }
+
+    CxxBuf basePrngSeedBuf{};
+    basePrngSeedBuf.data = std::make_unique<std::vector<uint8_t>>();
+    basePrngSeedBuf.data->assign(sorobanBasePrngSeed.begin(),
+                                 sorobanBasePrngSeed.end());
+
+    return rust_bridge::invoke_host_function(
+        appConfig.CURRENT_LEDGER_PROTOCOL_VERSION,
+        appConfig.ENABLE_SOROBAN_DIAGNOSTIC_EVENTS, resources.instructions,
+        toCxxBuf(op.hostFunction), toCxxBuf(resources), toCxxBuf(sourceID),
+        authEntryCxxBufs, getLedgerInfo(header, networkID, sorobanConfig),
+        ledgerEntryCxxBufs, ttlEntryCxxBufs, basePrngSeedBuf,
+        sorobanConfig.rustBridgeRentFeeConfiguration());
+}
+
 bool
 InvokeHostFunctionOpFrame::doCheckValid(
     SorobanNetworkConfig const& networkConfig, Config const& appConfig,
@@ -47,6 +47,19 @@ class InvokeHostFunctionOpFrame : public OperationFrame
     void
     insertLedgerKeysToPrefetch(UnorderedSet<LedgerKey>& keys) const override;
 
+    // Runs the Soroban host for `op`, given the encoded footprint entries
+    // that exist and their TTLs, exactly as doApply does. This is the only
+    // part of applying the operation that does not access the ledger, so it
+    // may be called from any thread.
+    static InvokeHostFunctionOutput invokeHostFunction(
+        Config const& appConfig, InvokeHostFunctionOp const& op,
+        SorobanResources const& resources, AccountID const& sourceID,
+        LedgerHeader const& header, Hash const& networkID,
+        SorobanNetworkConfig const& sorobanConfig,
+        rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+        rust::Vec<CxxBuf> const& ttlEntryCxxBufs,
+        Hash const& sorobanBasePrngSeed);
+
     static InvokeHostFunctionResultCode
     getInnerCode(OperationResult const& res)
     {
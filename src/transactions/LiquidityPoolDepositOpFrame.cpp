@@ -8,8 +8,8 @@
 #include "ledger/TrustLineWrapper.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric128.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
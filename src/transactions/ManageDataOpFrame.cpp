@@ -14,8 +14,8 @@
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -13,7 +13,7 @@
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 using namespace soci;
 
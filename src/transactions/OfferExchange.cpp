@@ -15,8 +15,10 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
+#include "util/UnorderedSet.h"
+#include "util/ZoneProfiler.h"
 #include "util/numeric128.h"
-#include <Tracy.hpp>
+#include "util/types.h"
 
 struct ExchangedQuantities
 {
@@ -1378,12 +1380,14 @@ getPoolID(Asset const& x, Asset const& y, int32_t feeBps)
     return xdrSha256(lpp);
 }
 
+// poolID is that of the pool of toPoolAsset and fromPoolAsset, given by
+// getPoolID with LIQUIDITY_POOL_FEE_V18
 static bool
-exchangeWithPool(AbstractLedgerTxn& ltxOuter, Asset const& toPoolAsset,
-                 int64_t maxSendToPool, int64_t& toPool,
-                 Asset const& fromPoolAsset, int64_t maxReceiveFromPool,
-                 int64_t& fromPool, RoundingType round,
-                 int64_t maxOffersToCross)
+exchangeWithPool(AbstractLedgerTxn& ltxOuter, PoolID const& poolID,
+                 Asset const& toPoolAsset, int64_t maxSendToPool,
+                 int64_t& toPool, Asset const& fromPoolAsset,
+                 int64_t maxReceiveFromPool, int64_t& fromPool,
+                 RoundingType round, int64_t maxOffersToCross)
 {
     LedgerTxn ltx(ltxOuter);
 
@@ -1412,7 +1416,6 @@ exchangeWithPool(AbstractLedgerTxn& ltxOuter, Asset const& toPoolAsset,
     }
 
     int32_t const feeBps = LIQUIDITY_POOL_FEE_V18;
-    auto poolID = getPoolID(toPoolAsset, fromPoolAsset, feeBps);
     auto lp = loadLiquidityPool(ltx, poolID);
     if (!lp)
     {
@@ -1479,6 +1482,60 @@ exchangeWithPool(AbstractLedgerTxn& ltxOuter, Asset const& toPoolAsset,
     return res;
 }
 
+// Number of offers whose sellers are prefetched at a time while crossing the
+// order book
+static constexpr size_t OFFER_PREFETCH_BATCH_SIZE = 64;
+
+// Bulk loads the accounts and trustlines that crossing the next `count` best
+// offers selling wheat for sheep, starting after `lastPrefetched` (or at the
+// best offer if unset), is going to load one at a time. This only warms the
+// root's entry cache and doesn't change anything in `ltxOuter`. Returns
+// false once there are no more offers.
+static bool
+prefetchOfferSellers(AbstractLedgerTxn& ltxOuter, Asset const& sheep,
+                     Asset const& wheat,
+                     std::optional<OfferDescriptor>& lastPrefetched,
+                     size_t count)
+{
+    ZoneScoped;
+    UnorderedSet<LedgerKey> keys;
+    bool more = true;
+    {
+        // Order book queries require a ledger without active entries
+        LedgerTxn ltx(ltxOuter);
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto offer = lastPrefetched
+                             ? ltx.getBestOffer(sheep, wheat, *lastPrefetched)
+                             : ltx.getBestOffer(sheep, wheat);
+            if (!offer)
+            {
+                more = false;
+                break;
+            }
+            auto const& oe = offer->data.offer();
+            lastPrefetched = OfferDescriptor{oe.price, oe.offerID};
+
+            keys.emplace(accountKey(oe.sellerID));
+            for (auto const& asset : {sheep, wheat})
+            {
+                if (asset.type() != ASSET_TYPE_NATIVE &&
+                    !isIssuer(oe.sellerID, asset))
+                {
+                    keys.emplace(trustlineKey(oe.sellerID, asset));
+                }
+            }
+            // The sponsor is loaded when a sponsored offer is taken
+            if (offer->ext.v() == 1 && offer->ext.v1().sponsoringID)
+            {
+                keys.emplace(accountKey(*offer->ext.v1().sponsoringID));
+            }
+        }
+    }
+    ltxOuter.prefetch(keys);
+    return more;
+}
+
 static ConvertResult
 convertWithOffers(
     AbstractLedgerTxn& ltxOuter, Asset const& sheep, int64_t maxSheepSend,
@@ -1511,8 +1568,27 @@ convertWithOffers(
         return ConvertResult::eCrossedTooMany;
     }
 
+    // Sellers are only prefetched once more than one offer gets crossed, so
+    // that the common single offer case doesn't pay for it
+    std::optional<OfferDescriptor> lastPrefetched;
+    size_t prefetchedCount = 0;
+    bool morePrefetchable = true;
+
     while (needMore)
     {
+        size_t const crossedCount = offerTrail.size();
+        if (crossedCount > 0 && crossedCount >= prefetchedCount &&
+            morePrefetchable &&
+            crossedCount < static_cast<uint64_t>(maxOffersToCross))
+        {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(
+                OFFER_PREFETCH_BATCH_SIZE,
+                static_cast<uint64_t>(maxOffersToCross) - crossedCount));
+            morePrefetchable = prefetchOfferSellers(ltxOuter, sheep, wheat,
+                                                    lastPrefetched, count);
+            prefetchedCount = crossedCount + count;
+        }
+
         LedgerTxn ltx(ltxOuter);
         auto wheatOffer = ltx.loadBestOffer(sheep, wheat);
         if (!wheatOffer)
@@ -1648,9 +1724,9 @@ shouldConvertWithOffers(std::optional<ExchangedQuantities> const& poolExchange,
 // returns true if converting with offers, false otherwise
 static bool
 maybeConvertWithOffers(
-    AbstractLedgerTxn& ltxOuter, Asset const& sheep, int64_t maxSheepSend,
-    int64_t& sheepSend, Asset const& wheat, int64_t maxWheatReceive,
-    int64_t& wheatReceived, RoundingType round,
+    AbstractLedgerTxn& ltxOuter, PoolID const& poolID, Asset const& sheep,
+    int64_t maxSheepSend, int64_t& sheepSend, Asset const& wheat,
+    int64_t maxWheatReceive, int64_t& wheatReceived, RoundingType round,
     std::function<OfferFilterResult(LedgerTxnEntry const&)> filter,
     std::vector<ClaimAtom>& offerTrail, int64_t maxOffersToCross,
     ConvertResult& convertRes)
@@ -1661,7 +1737,7 @@ maybeConvertWithOffers(
     {
         LedgerTxn ltxExchangeWithPool(ltxOuter); // Always rolls back
         ExchangedQuantities res;
-        if (exchangeWithPool(ltxExchangeWithPool, sheep, maxSheepSend,
+        if (exchangeWithPool(ltxExchangeWithPool, poolID, sheep, maxSheepSend,
                              res.sheepSend, wheat, maxWheatReceive,
                              res.wheatReceived, round, maxOffersToCross))
         {
@@ -1711,12 +1787,15 @@ convertWithOffersAndPools(
     sheepSend = 0;
     wheatReceived = 0;
 
+    // Hashed once for both exchanges with the pool and the claim atom
+    auto const poolID = getPoolID(sheep, wheat, LIQUIDITY_POOL_FEE_V18);
+
     {
         ConvertResult convertRes;
-        if (maybeConvertWithOffers(ltxOuter, sheep, maxSheepSend, sheepSend,
-                                   wheat, maxWheatReceive, wheatReceived, round,
-                                   filter, offerTrail, maxOffersToCross,
-                                   convertRes))
+        if (maybeConvertWithOffers(ltxOuter, poolID, sheep, maxSheepSend,
+                                   sheepSend, wheat, maxWheatReceive,
+                                   wheatReceived, round, filter, offerTrail,
+                                   maxOffersToCross, convertRes))
         {
             return convertRes;
         }
@@ -1729,13 +1808,12 @@ convertWithOffersAndPools(
     wheatReceived = 0;
 
     // Compute the exchange from the liquidity pool and actually do the exchange
-    exchangeWithPool(ltxOuter, sheep, maxSheepSend, sheepSend, wheat,
+    exchangeWithPool(ltxOuter, poolID, sheep, maxSheepSend, sheepSend, wheat,
                      maxWheatReceive, wheatReceived, round, maxOffersToCross);
 
     ClaimAtom atom(CLAIM_ATOM_TYPE_LIQUIDITY_POOL);
-    atom.liquidityPool() =
-        ClaimLiquidityAtom(getPoolID(sheep, wheat, LIQUIDITY_POOL_FEE_V18),
-                           wheat, wheatReceived, sheep, sheepSend);
+    atom.liquidityPool() = ClaimLiquidityAtom(poolID, wheat, wheatReceived,
+                                              sheep, sheepSend);
     offerTrail.emplace_back(atom);
     return ConvertResult::eOK;
 }
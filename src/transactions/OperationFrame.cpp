@@ -35,7 +35,7 @@
 #include "util/Logging.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDRCereal.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <medida/metrics_registry.h>
 
 namespace stellar
@@ -0,0 +1,400 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/ParallelSorobanApply.h"
+#include "crypto/SHA.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/LedgerTxn.h"
+#include "ledger/LedgerTypeUtils.h"
+#include "main/Application.h"
+#include "rust/RustVecXdrMarshal.h"
+#include "transactions/InvokeHostFunctionOpFrame.h"
+#include "transactions/TransactionUtils.h"
+#include "util/GlobalChecks.h"
+#include "util/UnorderedSet.h"
+#include "util/ZoneProfiler.h"
+
+#include <medida/meter.h>
+#include <medida/metrics_registry.h>
+#include <numeric>
+
+namespace stellar
+{
+
+ParallelSorobanApply::ParallelSorobanApply(
+    Application& app, AbstractLedgerTxn& ltx,
+    std::vector<TransactionFrameBasePtr> const& txs,
+    std::vector<Hash> const& seeds, size_t threads)
+    : mAppConfig(app.getConfig())
+    , mHeader(ltx.getHeader())
+    , mNetworkID(app.getNetworkID())
+    , mSorobanConfig(app.getLedgerManager().getSorobanNetworkConfigSnapshot())
+    , mTxs(txs)
+    , mClusterOfTx(txs.size())
+    , mSeeds(seeds)
+    , mPromises(txs.size())
+    , mReused(app.getMetrics().NewMeter(
+          {"ledger", "soroban-parallel", "reused"}, "invocation"))
+    , mReinvoked(app.getMetrics().NewMeter(
+          {"ledger", "soroban-parallel", "reinvoked"}, "invocation"))
+{
+    ZoneScoped;
+    releaseAssert(threads > 0);
+    releaseAssert(txs.size() == seeds.size());
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        mTxBySeed.emplace(seeds[i], i);
+        mFutures.emplace_back(mPromises[i].get_future());
+    }
+
+    // Copy the current version of every entry the cluster may access
+    for (auto& txIndices : clusterByFootprint(txs))
+    {
+        auto cluster = std::make_unique<Cluster>();
+        auto load = [&](LedgerKey const& lk) {
+            if (cluster->entries.find(lk) == cluster->entries.end())
+            {
+                auto ltxe = ltx.loadWithoutRecord(lk);
+                if (ltxe)
+                {
+                    cluster->entries.emplace(lk, ltxe.current());
+                }
+            }
+        };
+        for (auto i : txIndices)
+        {
+            mClusterOfTx[i] = mClusters.size();
+            auto const& footprint = txs[i]->sorobanResources().footprint;
+            for (auto const* keys : {&footprint.readOnly, &footprint.readWrite})
+            {
+                for (auto const& lk : *keys)
+                {
+                    load(lk);
+                    if (isSorobanEntry(lk))
+                    {
+                        load(getTTLKey(lk));
+                    }
+                }
+            }
+        }
+        cluster->txs = std::move(txIndices);
+        mClusters.emplace_back(std::move(cluster));
+    }
+
+    size_t const workers = std::min(threads, mClusters.size());
+    for (size_t i = 0; i < workers; ++i)
+    {
+        mWorkers.emplace_back(
+            std::async(std::launch::async, [this]() { runClusters(); }));
+    }
+}
+
+ParallelSorobanApply::~ParallelSorobanApply()
+{
+    mStopping = true;
+    for (auto& w : mWorkers)
+    {
+        w.wait();
+    }
+}
+
+std::vector<std::vector<size_t>>
+ParallelSorobanApply::clusterByFootprint(
+    std::vector<TransactionFrameBasePtr> const& txs)
+{
+    ZoneScoped;
+
+    // Union-find over the transactions, where each set is represented by its
+    // lowest index
+    std::vector<size_t> parent(txs.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t i) {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    auto unite = [&](size_t a, size_t b) {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+        {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    };
+
+    struct Access
+    {
+        std::vector<size_t> txs;
+        bool written{false};
+    };
+    UnorderedMap<LedgerKey, Access> accesses;
+    auto note = [&](LedgerKey const& lk, size_t tx, bool write) {
+        auto& access = accesses[lk];
+        if (access.txs.empty() || access.txs.back() != tx)
+        {
+            access.txs.emplace_back(tx);
+        }
+        access.written = access.written || write;
+    };
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        auto const& footprint = txs[i]->sorobanResources().footprint;
+        for (auto const& lk : footprint.readOnly)
+        {
+            note(lk, i, false);
+        }
+        for (auto const& lk : footprint.readWrite)
+        {
+            note(lk, i, true);
+        }
+        for (auto const* keys : {&footprint.readOnly, &footprint.readWrite})
+        {
+            for (auto const& lk : *keys)
+            {
+                if (isSorobanEntry(lk))
+                {
+                    note(getTTLKey(lk), i, true);
+                }
+            }
+        }
+        note(accountKey(txs[i]->getFeeSourceID()), i, true);
+        note(accountKey(txs[i]->getSourceID()), i, true);
+    }
+
+    for (auto const& kv : accesses)
+    {
+        auto const& access = kv.second;
+        if (access.written)
+        {
+            for (auto tx : access.txs)
+            {
+                unite(access.txs.front(), tx);
+            }
+        }
+    }
+
+    std::vector<std::vector<size_t>> clusters;
+    std::vector<size_t> clusterOfRoot(txs.size());
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+        auto root = find(i);
+        if (root == i)
+        {
+            clusterOfRoot[i] = clusters.size();
+            clusters.emplace_back();
+        }
+        clusters[clusterOfRoot[root]].emplace_back(i);
+    }
+    return clusters;
+}
+
+void
+ParallelSorobanApply::runClusters()
+{
+    ZoneScoped;
+    while (!mStopping)
+    {
+        size_t const next = mNextCluster++;
+        if (next >= mClusters.size())
+        {
+            break;
+        }
+        auto& cluster = *mClusters[next];
+        if (!cluster.claimed.exchange(true))
+        {
+            runCluster(cluster);
+        }
+    }
+}
+
+void
+ParallelSorobanApply::runCluster(Cluster& cluster)
+{
+    // Once a transaction can't be simulated, the entries of the cluster no
+    // longer match what the later transactions will see
+    bool simulated = true;
+    for (auto tx : cluster.txs)
+    {
+        Result res;
+        if (simulated && !mStopping)
+        {
+            try
+            {
+                simulated = runTransaction(cluster, tx, res);
+            }
+            catch (...)
+            {
+                simulated = false;
+                res = Result{};
+            }
+        }
+        mPromises[tx].set_value(std::move(res));
+    }
+}
+
+bool
+ParallelSorobanApply::runTransaction(Cluster& cluster, size_t tx,
+                                     Result& res) const
+{
+    ZoneScoped;
+    auto const& ops = mTxs[tx]->getRawOperations();
+    if (ops.size() != 1 || ops[0].body.type() != INVOKE_HOST_FUNCTION)
+    {
+        // Footprint TTL extensions and restorations are not simulated
+        return false;
+    }
+    auto const& op = ops[0];
+    auto const& resources = mTxs[tx]->sorobanResources();
+    auto const& footprint = resources.footprint;
+
+    // Collect the footprint entries in the same way as
+    // InvokeHostFunctionOpFrame::doApply
+    rust::Vec<CxxBuf> ledgerEntryCxxBufs;
+    rust::Vec<CxxBuf> ttlEntryCxxBufs;
+    for (auto const* keys : {&footprint.readOnly, &footprint.readWrite})
+    {
+        for (auto const& lk : *keys)
+        {
+            std::optional<TTLEntry> ttlEntry;
+            bool sorobanEntryLive = false;
+            if (isSorobanEntry(lk))
+            {
+                auto it = cluster.entries.find(getTTLKey(lk));
+                if (it != cluster.entries.end())
+                {
+                    if (!isLive(it->second, mHeader.ledgerSeq))
+                    {
+                        if (!isTemporaryEntry(lk))
+                        {
+                            // Apply fails before invoking the host and
+                            // without changing any entry
+                            return true;
+                        }
+                    }
+                    else
+                    {
+                        sorobanEntryLive = true;
+                        ttlEntry = it->second.data.ttl();
+                    }
+                }
+            }
+
+            if (!isSorobanEntry(lk) || sorobanEntryLive)
+            {
+                auto it = cluster.entries.find(lk);
+                if (it != cluster.entries.end())
+                {
+                    ledgerEntryCxxBufs.emplace_back(toCxxBuf(it->second));
+                    ttlEntryCxxBufs.emplace_back(
+                        ttlEntry ? toCxxBuf(*ttlEntry)
+                                 : CxxBuf{std::make_unique<
+                                       std::vector<uint8_t>>()});
+                }
+            }
+        }
+    }
+
+    res.inputHash = hashInputs(ledgerEntryCxxBufs, ttlEntryCxxBufs);
+    auto sourceID = op.sourceAccount ? toAccountID(*op.sourceAccount)
+                                     : mTxs[tx]->getSourceID();
+    try
+    {
+        res.output = InvokeHostFunctionOpFrame::invokeHostFunction(
+            mAppConfig, op.body.invokeHostFunctionOp(), resources, sourceID,
+            mHeader, mNetworkID, *mSorobanConfig, ledgerEntryCxxBufs,
+            ttlEntryCxxBufs, mSeeds[tx]);
+    }
+    catch (std::exception&)
+    {
+        // Apply invokes the host again and handles the error
+        return true;
+    }
+
+    if (res.output->success)
+    {
+        // Assume the transaction succeeds, so later transactions of the
+        // cluster see its changes
+        UnorderedSet<LedgerKey> modifiedKeys;
+        for (auto const& buf : res.output->modified_ledger_entries)
+        {
+            LedgerEntry le;
+            xdr::xdr_from_opaque(buf.data, le);
+            // As set by LedgerTxn when apply commits the entry
+            le.lastModifiedLedgerSeq = mHeader.ledgerSeq;
+            auto lk = LedgerEntryKey(le);
+            modifiedKeys.emplace(lk);
+            cluster.entries[lk] = std::move(le);
+        }
+        for (auto const& lk : footprint.readWrite)
+        {
+            if (modifiedKeys.find(lk) == modifiedKeys.end() &&
+                cluster.entries.erase(lk) > 0 && isSorobanEntry(lk))
+            {
+                cluster.entries.erase(getTTLKey(lk));
+            }
+        }
+    }
+    return true;
+}
+
+Hash
+ParallelSorobanApply::hashInputs(rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+                                 rust::Vec<CxxBuf> const& ttlEntryCxxBufs)
+{
+    SHA256 hasher;
+    for (auto const* bufs : {&ledgerEntryCxxBufs, &ttlEntryCxxBufs})
+    {
+        xdrSha256Add(hasher, static_cast<uint64_t>(bufs->size()));
+        for (auto const& buf : *bufs)
+        {
+            xdrSha256Add(hasher, static_cast<uint64_t>(buf.data->size()));
+            hasher.add(*buf.data);
+        }
+    }
+    return hasher.finish();
+}
+
+std::optional<InvokeHostFunctionOutput>
+ParallelSorobanApply::takeOutput(Hash const& sorobanBasePrngSeed,
+                                 rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+                                 rust::Vec<CxxBuf> const& ttlEntryCxxBufs)
+{
+    ZoneScoped;
+    auto it = mTxBySeed.find(sorobanBasePrngSeed);
+    if (it == mTxBySeed.end() || !mFutures[it->second].valid())
+    {
+        return std::nullopt;
+    }
+    size_t const tx = it->second;
+    auto& cluster = *mClusters[mClusterOfTx[tx]];
+    if (!cluster.claimed.exchange(true))
+    {
+        // No worker has started this cluster, so apply invokes the host for
+        // all of it rather than wait
+        for (auto i : cluster.txs)
+        {
+            mFutures[i] = {};
+        }
+        return std::nullopt;
+    }
+
+    auto res = mFutures[tx].get();
+    if (!res.output)
+    {
+        return std::nullopt;
+    }
+    if (res.inputHash != hashInputs(ledgerEntryCxxBufs, ttlEntryCxxBufs))
+    {
+        mReinvoked.Mark();
+        return std::nullopt;
+    }
+    mReused.Mark();
+    return std::move(res.output);
+}
+}
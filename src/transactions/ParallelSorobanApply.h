@@ -0,0 +1,126 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "ledger/NetworkConfig.h"
+#include "rust/RustBridge.h"
+#include "transactions/TransactionFrameBase.h"
+#include "util/NonCopyable.h"
+#include "util/UnorderedMap.h"
+#include "xdr/Stellar-ledger.h"
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
+
+namespace stellar
+{
+class AbstractLedgerTxn;
+class Application;
+class Config;
+
+// ParallelSorobanApply runs the Soroban host for the InvokeHostFunction
+// transactions of a ledger on worker threads, ahead of the serial apply loop.
+//
+// The transactions are split into clusters that cannot affect each other
+// according to their declared footprints (see clusterByFootprint). A worker
+// runs the transactions of a cluster in apply order against its own copy of
+// the entries in their footprints, as loaded when the Soroban phase starts,
+// so the clusters are invoked in parallel.
+//
+// Apply itself stays serial and unchanged: InvokeHostFunctionOpFrame loads,
+// checks and writes everything as before, and only takes a worker's output
+// instead of invoking the host when the worker invoked it with byte-for-byte
+// the same footprint entries. Results and meta are therefore always exactly
+// those of serial apply; a worker that guessed wrong (for example because a
+// transaction failed after its invocation) only costs a second invocation.
+class ParallelSorobanApply : public NonMovableOrCopyable
+{
+    struct Result
+    {
+        Hash inputHash;
+        std::optional<InvokeHostFunctionOutput> output;
+    };
+
+    struct Cluster
+    {
+        std::vector<size_t> txs;
+        UnorderedMap<LedgerKey, LedgerEntry> entries;
+        // Set by whichever of a worker or the apply loop gets to the cluster
+        // first. The apply loop claims clusters no worker has started yet
+        // rather than wait for them.
+        std::atomic<bool> claimed{false};
+    };
+
+    Config const& mAppConfig;
+    LedgerHeader const mHeader;
+    Hash const mNetworkID;
+    std::shared_ptr<SorobanNetworkConfig const> const mSorobanConfig;
+
+    std::vector<TransactionFrameBasePtr> mTxs;
+    std::vector<std::unique_ptr<Cluster>> mClusters;
+    std::vector<size_t> mClusterOfTx;
+    std::map<Hash, size_t> mTxBySeed;
+    std::vector<Hash> mSeeds;
+    std::vector<std::promise<Result>> mPromises;
+    std::vector<std::future<Result>> mFutures;
+
+    std::atomic<size_t> mNextCluster{0};
+    std::atomic<bool> mStopping{false};
+    std::vector<std::future<void>> mWorkers;
+
+    medida::Meter& mReused;
+    medida::Meter& mReinvoked;
+
+    void runClusters();
+    void runCluster(Cluster& cluster);
+    // Returns false if the later transactions of the cluster can't be
+    // simulated after this one
+    bool runTransaction(Cluster& cluster, size_t tx, Result& res) const;
+
+    static Hash hashInputs(rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+                           rust::Vec<CxxBuf> const& ttlEntryCxxBufs);
+
+  public:
+    // `txs` are the Soroban transactions of the ledger in apply order, and
+    // `seeds` the PRNG seeds of their operations, derived from the
+    // transactions' seeds as in TransactionFrame::applyOperations. Must be
+    // called on the main thread between transactions, once all the preceding
+    // ones have been applied to `ltx`.
+    ParallelSorobanApply(Application& app, AbstractLedgerTxn& ltx,
+                         std::vector<TransactionFrameBasePtr> const& txs,
+                         std::vector<Hash> const& seeds, size_t threads);
+
+    // Stops the workers after their current invocation and waits for them
+    ~ParallelSorobanApply();
+
+    // Groups `txs` into clusters such that no transaction writes an entry
+    // (as declared in its footprint) that a transaction of another cluster
+    // reads or writes. Writes include the TTLs of every Soroban entry in the
+    // footprint, which the host may extend, the fee source account, which
+    // receives the refund, and the source account, whose sequence number is
+    // bumped. Each cluster lists indices into `txs` in increasing order, and
+    // clusters are ordered by their first index.
+    static std::vector<std::vector<size_t>>
+    clusterByFootprint(std::vector<TransactionFrameBasePtr> const& txs);
+
+    // Returns the host output computed by a worker for the operation with
+    // PRNG seed `sorobanBasePrngSeed`, waiting for the worker if it has
+    // started on it, if the worker used exactly these footprint entries.
+    // Each output is returned at most once.
+    std::optional<InvokeHostFunctionOutput>
+    takeOutput(Hash const& sorobanBasePrngSeed,
+               rust::Vec<CxxBuf> const& ledgerEntryCxxBufs,
+               rust::Vec<CxxBuf> const& ttlEntryCxxBufs);
+};
+}
@@ -6,7 +6,7 @@
 #include "TransactionUtils.h"
 #include "ledger/LedgerManagerImpl.h"
 #include "ledger/LedgerTypeUtils.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
@@ -77,6 +77,9 @@ RestoreFootprintOpFrame::doApply(Application& app, AbstractLedgerTxn& ltx,
     uint32_t restoredLiveUntilLedger =
         ledgerSeq + archivalSettings.minPersistentTTL - 1;
     rustEntryRentChanges.reserve(footprint.readWrite.size());
+
+    prefetchFootprintEntries(ltx, footprint.readWrite,
+                             metrics.mMetrics.mRestoreFpOpPrefetchEntry);
     for (auto const& lk : footprint.readWrite)
     {
         auto ttlKey = getTTLKey(lk);
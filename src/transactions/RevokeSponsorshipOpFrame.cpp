@@ -9,8 +9,8 @@
 #include "transactions/SponsorshipUtils.h"
 #include "transactions/TransactionUtils.h"
 #include "util/ProtocolVersion.h"
+#include "util/ZoneProfiler.h"
 #include "xdr/Stellar-ledger-entries.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -12,19 +12,137 @@
 #include "util/Algorithm.h"
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <algorithm>
 
 namespace stellar
 {
 
 SignatureChecker::SignatureChecker(
     uint32_t protocolVersion, Hash const& contentsHash,
-    xdr::xvector<DecoratedSignature, 20> const& signatures)
+    xdr::xvector<DecoratedSignature, 20> const& signatures, bool trusted)
     : mProtocolVersion{protocolVersion}
+    , mTrusted{trusted}
     , mContentsHash{contentsHash}
     , mSignatures{signatures}
 {
     mUsedSignatures.resize(mSignatures.size());
+    mVerified.resize(mSignatures.size());
+    for (size_t i = 0; i < mSignatures.size(); i++)
+    {
+        mSignaturesByHint[mSignatures[i].hint].emplace_back(i);
+    }
+}
+
+namespace
+{
+// The hint a signature made by `signerKey` has
+SignatureHint
+getSignerHint(SignerKey const& signerKey)
+{
+    switch (signerKey.type())
+    {
+    case SIGNER_KEY_TYPE_ED25519:
+        return SignatureUtils::getHint(signerKey.ed25519());
+    case SIGNER_KEY_TYPE_HASH_X:
+        return SignatureUtils::getHint(signerKey.hashX());
+    case SIGNER_KEY_TYPE_ED25519_SIGNED_PAYLOAD:
+        return SignatureUtils::getSignedPayloadHint(
+            signerKey.ed25519SignedPayload());
+    default:
+        throw std::runtime_error("signer key type has no signature hint");
+    }
+}
+
+// Weights are added to the total as unsigned values, as they always were,
+// so a large pre-v10 weight wraps around instead of overflowing an int
+uint32_t
+getSignerWeight(uint32_t protocolVersion, Signer const& signer)
+{
+    uint32_t w = signer.weight;
+    if (protocolVersionStartsFrom(protocolVersion, ProtocolVersion::V_10) &&
+        w > UINT8_MAX)
+    {
+        w = UINT8_MAX;
+    }
+    return w;
+}
+}
+
+bool
+SignatureChecker::verifyCached(size_t sigIndex, SignerKey const& signerKey)
+{
+    auto& verified = mVerified[sigIndex];
+    for (auto const& v : verified)
+    {
+        if (v.first == signerKey)
+        {
+            return v.second;
+        }
+    }
+
+    auto const& sig = mSignatures[sigIndex];
+    bool res = false;
+    switch (signerKey.type())
+    {
+    case SIGNER_KEY_TYPE_ED25519:
+        res = SignatureUtils::verify(sig, signerKey, mContentsHash);
+        break;
+    case SIGNER_KEY_TYPE_HASH_X:
+        res = SignatureUtils::verifyHashX(sig, signerKey);
+        break;
+    case SIGNER_KEY_TYPE_ED25519_SIGNED_PAYLOAD:
+        res = SignatureUtils::verifyEd25519SignedPayload(sig, signerKey);
+        break;
+    default:
+        throw std::runtime_error("signer key type has no signature");
+    }
+    verified.emplace_back(signerKey, res);
+    return res;
+}
+
+// Matches signatures in order against the signers that have the same hint,
+// each signer being used by at most one signature
+bool
+SignatureChecker::verifyAll(std::vector<Signer> const& signers,
+                            int32_t neededWeight, int& totalWeight)
+{
+    if (signers.empty())
+    {
+        return false;
+    }
+
+    std::map<SignatureHint, std::vector<size_t>> signersByHint;
+    for (size_t j = 0; j < signers.size(); j++)
+    {
+        signersByHint[getSignerHint(signers[j].key)].emplace_back(j);
+    }
+
+    std::vector<bool> usedSigners(signers.size());
+    for (size_t i = 0; i < mSignatures.size(); i++)
+    {
+        auto it = signersByHint.find(mSignatures[i].hint);
+        if (it == signersByHint.end())
+        {
+            continue;
+        }
+        for (auto j : it->second)
+        {
+            if (usedSigners[j] || !verifyCached(i, signers[j].key))
+            {
+                continue;
+            }
+            mUsedSignatures[i] = true;
+            totalWeight += getSignerWeight(mProtocolVersion, signers[j]);
+            if (totalWeight >= neededWeight)
+                return true;
+
+            usedSigners[j] = true;
+            break;
+        }
+    }
+
+    return false;
 }
 
 bool
@@ -35,7 +153,8 @@ SignatureChecker::checkSignature(std::vector<Signer> const& signersV,
     return true;
 #endif // FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
 
-    if (protocolVersionEquals(mProtocolVersion, ProtocolVersion::V_7))
+    if (mTrusted ||
+        protocolVersionEquals(mProtocolVersion, ProtocolVersion::V_7))
     {
         return true;
     }
@@ -55,84 +174,54 @@ SignatureChecker::checkSignature(std::vector<Signer> const& signersV,
     {
         if (signerKey.key.preAuthTx() == mContentsHash)
         {
-            auto w = signerKey.weight;
-            if (protocolVersionStartsFrom(mProtocolVersion,
-                                          ProtocolVersion::V_10) &&
-                w > UINT8_MAX)
-            {
-                w = UINT8_MAX;
-            }
-            totalWeight += w;
+            totalWeight += getSignerWeight(mProtocolVersion, signerKey);
             if (totalWeight >= neededWeight)
                 return true;
         }
     }
 
-    using VerifyT =
-        std::function<bool(DecoratedSignature const&, Signer const&)>;
-    auto verifyAll = [&](std::vector<Signer>& signers, VerifyT verify) {
-        for (size_t i = 0; i < mSignatures.size(); i++)
-        {
-            auto const& sig = mSignatures[i];
+    if (verifyAll(signers[SIGNER_KEY_TYPE_HASH_X], neededWeight, totalWeight))
+    {
+        return true;
+    }
 
-            for (auto it = signers.begin(); it != signers.end(); ++it)
+    // Verify every signature whose hint matches an ed25519 signer, and that
+    // wasn't checked against it before, in one batch, so the checks below
+    // are cache hits
+    std::vector<PubKeyUtils::VerifySigRequest> requests;
+    for (auto const& signerKey : signers[SIGNER_KEY_TYPE_ED25519])
+    {
+        auto it = mSignaturesByHint.find(getSignerHint(signerKey.key));
+        if (it == mSignaturesByHint.end())
+        {
+            continue;
+        }
+        auto pubKey = KeyUtils::convertKey<PublicKey>(signerKey.key);
+        for (auto i : it->second)
+        {
+            auto const& verified = mVerified[i];
+            if (std::none_of(verified.begin(), verified.end(),
+                             [&](auto const& v) {
+                                 return v.first == signerKey.key;
+                             }))
             {
-                auto& signerKey = *it;
-                if (verify(sig, signerKey))
-                {
-                    mUsedSignatures[i] = true;
-                    auto w = signerKey.weight;
-                    if (protocolVersionStartsFrom(mProtocolVersion,
-                                                  ProtocolVersion::V_10) &&
-                        w > UINT8_MAX)
-                    {
-                        w = UINT8_MAX;
-                    }
-                    totalWeight += w;
-                    if (totalWeight >= neededWeight)
-                        return true;
-
-                    signers.erase(it);
-                    break;
-                }
+                requests.emplace_back(PubKeyUtils::VerifySigRequest{
+                    pubKey, mSignatures[i].signature, mContentsHash});
             }
         }
-
-        return false;
-    };
-
-    auto verified =
-        verifyAll(signers[SIGNER_KEY_TYPE_HASH_X],
-                  [&](DecoratedSignature const& sig, Signer const& signerKey) {
-                      return SignatureUtils::verifyHashX(sig, signerKey.key);
-                  });
-    if (verified)
-    {
-        return true;
     }
-
-    verified = verifyAll(
-        signers[SIGNER_KEY_TYPE_ED25519],
-        [&](DecoratedSignature const& sig, Signer const& signerKey) {
-            return SignatureUtils::verify(sig, signerKey.key, mContentsHash);
-        });
-    if (verified)
+    if (requests.size() > 1)
     {
-        return true;
+        PubKeyUtils::verifySigs(requests);
     }
 
-    verified =
-        verifyAll(signers[SIGNER_KEY_TYPE_ED25519_SIGNED_PAYLOAD],
-                  [&](DecoratedSignature const& sig, Signer const& signerKey) {
-                      return SignatureUtils::verifyEd25519SignedPayload(
-                          sig, signerKey.key);
-                  });
-    if (verified)
+    if (verifyAll(signers[SIGNER_KEY_TYPE_ED25519], neededWeight, totalWeight))
     {
         return true;
     }
 
-    return false;
+    return verifyAll(signers[SIGNER_KEY_TYPE_ED25519_SIGNED_PAYLOAD],
+                     neededWeight, totalWeight);
 }
 
 bool
@@ -142,7 +231,8 @@ SignatureChecker::checkAllSignaturesUsed() const
     return true;
 #endif // FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
 
-    if (protocolVersionEquals(mProtocolVersion, ProtocolVersion::V_7))
+    if (mTrusted ||
+        protocolVersionEquals(mProtocolVersion, ProtocolVersion::V_7))
     {
         return true;
     }
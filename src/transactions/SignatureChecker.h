@@ -19,9 +19,12 @@ namespace stellar
 class SignatureChecker
 {
   public:
+    // With `trusted`, every check passes without verifying anything, for
+    // transactions known to have been applied successfully before
     explicit SignatureChecker(
         uint32_t protocolVersion, Hash const& contentsHash,
-        xdr::xvector<DecoratedSignature, 20> const& signatures);
+        xdr::xvector<DecoratedSignature, 20> const& signatures,
+        bool trusted = false);
 
     bool checkSignature(std::vector<Signer> const& signersV,
                         int32_t neededWeight);
@@ -29,9 +32,21 @@ class SignatureChecker
 
   private:
     uint32_t mProtocolVersion;
+    bool const mTrusted;
     Hash const& mContentsHash;
     xdr::xvector<DecoratedSignature, 20> const& mSignatures;
 
     std::vector<bool> mUsedSignatures;
+
+    // Indices of mSignatures by hint
+    std::map<SignatureHint, std::vector<size_t>> mSignaturesByHint;
+    // Outcome of verifying each signature with the signer keys it was
+    // checked against so far. The same signers are typically checked again
+    // for every operation of the transaction.
+    std::vector<std::vector<std::pair<SignerKey, bool>>> mVerified;
+
+    bool verifyCached(size_t sigIndex, SignerKey const& signerKey);
+    bool verifyAll(std::vector<Signer> const& signers, int32_t neededWeight,
+                   int& totalWeight);
 };
 };
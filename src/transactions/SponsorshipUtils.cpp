@@ -736,6 +736,22 @@ removeSignerWithSponsorship(std::vector<Signer>::const_iterator const& signerIt,
 // Utility functions to handle possible sponsorship
 //
 ////////////////////////////////////////////////////////////////////////////////
+SponsoringAccountCache::SponsoringAccountCache(AbstractLedgerTxn& ltx)
+    : mLtx(ltx)
+{
+}
+
+LedgerTxnEntry&
+SponsoringAccountCache::load(AccountID const& accountID)
+{
+    auto it = mAccounts.find(accountID);
+    if (it == mAccounts.end())
+    {
+        it = mAccounts.emplace(accountID, loadAccount(mLtx, accountID)).first;
+    }
+    return it->second;
+}
+
 SponsorshipResult
 createEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
                                    LedgerTxnHeader const& header,
@@ -799,7 +815,8 @@ createEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
 void
 removeEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
                                    LedgerTxnHeader const& header,
-                                   LedgerEntry& le, LedgerTxnEntry& acc)
+                                   LedgerEntry& le, LedgerTxnEntry& acc,
+                                   SponsoringAccountCache* sponsoringAccounts)
 {
     if (le.ext.v() == 1 && le.ext.v1().sponsoringID)
     {
@@ -819,6 +836,17 @@ removeEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
                                           sponsoredAccount);
             removeEntryWithSponsorship(le, acc.current(), sponsoredAccount);
         }
+        else if (sponsoringAccounts)
+        {
+            auto& sponsoringAcc =
+                sponsoringAccounts->load(*le.ext.v1().sponsoringID);
+
+            canRemoveEntryWithSponsorship(header.current(), le,
+                                          sponsoringAcc.current(),
+                                          sponsoredAccount);
+            removeEntryWithSponsorship(le, sponsoringAcc.current(),
+                                       sponsoredAccount);
+        }
         else
         {
             auto sponsoringAcc = loadAccount(ltx, *le.ext.v1().sponsoringID);
@@ -2,13 +2,14 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include "ledger/LedgerTxnEntry.h"
 #include "overlay/StellarXDR.h"
+#include "util/UnorderedMap.h"
 #include <vector>
 
 namespace stellar
 {
 class AbstractLedgerTxn;
-class LedgerTxnEntry;
 class LedgerTxnHeader;
 
 uint32_t getNumSponsored(LedgerEntry const& le);
@@ -87,13 +88,26 @@ SponsorshipResult canCreateEntryWithoutSponsorship(LedgerHeader const& lh,
 
 void createEntryWithoutSponsorship(LedgerEntry& le, LedgerEntry& acc);
 
+// Loads each sponsoring account once while many entries are removed, rather
+// than once per entry. The accounts stay active in `ltx` while this lives,
+// so they must not be loaded by other means in the meantime.
+class SponsoringAccountCache
+{
+    AbstractLedgerTxn& mLtx;
+    UnorderedMap<AccountID, LedgerTxnEntry> mAccounts;
+
+  public:
+    explicit SponsoringAccountCache(AbstractLedgerTxn& ltx);
+    LedgerTxnEntry& load(AccountID const& accountID);
+};
+
 SponsorshipResult
 createEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
                                    LedgerTxnHeader const& header,
                                    LedgerEntry& le, LedgerTxnEntry& acc);
-void removeEntryWithPossibleSponsorship(AbstractLedgerTxn& ltx,
-                                        LedgerTxnHeader const& header,
-                                        LedgerEntry& le, LedgerTxnEntry& acc);
+void removeEntryWithPossibleSponsorship(
+    AbstractLedgerTxn& ltx, LedgerTxnHeader const& header, LedgerEntry& le,
+    LedgerTxnEntry& acc, SponsoringAccountCache* sponsoringAccounts = nullptr);
 
 SponsorshipResult createSignerWithPossibleSponsorship(
     AbstractLedgerTxn& ltx, LedgerTxnHeader const& header,
@@ -18,6 +18,7 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/OperationApplyMetrics.h"
 #include "ledger/SorobanMetrics.h"
 #include "main/Application.h"
 #include "transactions/SignatureChecker.h"
@@ -32,11 +33,11 @@
 #include "util/ProtocolVersion.h"
 #include "util/XDROperators.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "xdr/Stellar-contract.h"
 #include "xdr/Stellar-ledger.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/printer.h"
-#include <Tracy.hpp>
 #include <iterator>
 #include <string>
 
@@ -54,6 +55,42 @@ namespace
 // Limit to the maximum resource fee allowed for transaction,
 // roughly 112 million lumens.
 int64_t const MAX_RESOURCE_FEE = 1LL << 50;
+
+CxxTransactionResources
+toCxxTransactionResources(SorobanResources const& txResources, uint32_t txSize,
+                          uint32_t eventsSize)
+{
+    CxxTransactionResources cxxResources{};
+    cxxResources.instructions = txResources.instructions;
+
+    cxxResources.read_entries =
+        static_cast<uint32>(txResources.footprint.readOnly.size());
+    cxxResources.write_entries =
+        static_cast<uint32>(txResources.footprint.readWrite.size());
+
+    cxxResources.read_bytes = txResources.readBytes;
+    cxxResources.write_bytes = txResources.writeBytes;
+
+    cxxResources.transaction_size_bytes = txSize;
+    cxxResources.contract_events_size_bytes = eventsSize;
+    return cxxResources;
+}
+
+bool
+sameFeeConfiguration(CxxFeeConfiguration const& lhs,
+                     CxxFeeConfiguration const& rhs)
+{
+    return lhs.fee_per_instruction_increment ==
+               rhs.fee_per_instruction_increment &&
+           lhs.fee_per_read_entry == rhs.fee_per_read_entry &&
+           lhs.fee_per_write_entry == rhs.fee_per_write_entry &&
+           lhs.fee_per_read_1kb == rhs.fee_per_read_1kb &&
+           lhs.fee_per_write_1kb == rhs.fee_per_write_1kb &&
+           lhs.fee_per_historical_1kb == rhs.fee_per_historical_1kb &&
+           lhs.fee_per_contract_event_1kb == rhs.fee_per_contract_event_1kb &&
+           lhs.fee_per_transaction_size_1kb ==
+               rhs.fee_per_transaction_size_1kb;
+}
 } // namespace
 
 using namespace std;
@@ -105,13 +142,13 @@ TransactionFrame::getContentsHash() const
     {
         if (mEnvelope.type() == ENVELOPE_TYPE_TX_V0)
         {
-            mContentsHash = sha256(xdr::xdr_to_opaque(
-                mNetworkID, ENVELOPE_TYPE_TX, 0, mEnvelope.v0().tx));
+            mContentsHash =
+                xdrSha256(mNetworkID, ENVELOPE_TYPE_TX, 0, mEnvelope.v0().tx);
         }
         else
         {
-            mContentsHash = sha256(xdr::xdr_to_opaque(
-                mNetworkID, ENVELOPE_TYPE_TX, mEnvelope.v1().tx));
+            mContentsHash =
+                xdrSha256(mNetworkID, ENVELOPE_TYPE_TX, mEnvelope.v1().tx);
         }
     }
 #ifdef _DEBUG
@@ -120,12 +157,38 @@ TransactionFrame::getContentsHash() const
     return (mContentsHash);
 }
 
+void
+TransactionFrame::collectUncachedHashes(UncachedHashes& hashes) const
+{
+    if (isZero(mFullHash))
+    {
+        hashes.emplace_back(&mFullHash, xdr::xdr_to_opaque(mEnvelope));
+    }
+    if (isZero(mContentsHash))
+    {
+        if (mEnvelope.type() == ENVELOPE_TYPE_TX_V0)
+        {
+            hashes.emplace_back(&mContentsHash,
+                                xdr::xdr_to_opaque(mNetworkID, ENVELOPE_TYPE_TX,
+                                                   0, mEnvelope.v0().tx));
+        }
+        else
+        {
+            hashes.emplace_back(&mContentsHash,
+                                xdr::xdr_to_opaque(mNetworkID, ENVELOPE_TYPE_TX,
+                                                   mEnvelope.v1().tx));
+        }
+    }
+}
+
 void
 TransactionFrame::clearCached()
 {
     Hash zero;
     mContentsHash = zero;
     mFullHash = zero;
+    mCachedValidation.reset();
+    mCachedSorobanResourceFee.reset();
 }
 
 void
@@ -864,24 +927,77 @@ TransactionFrame::computeSorobanResourceFee(
     ZoneScoped;
     releaseAssertOrThrow(
         protocolVersionStartsFrom(protocolVersion, SOROBAN_PROTOCOL_VERSION));
-    CxxTransactionResources cxxResources{};
-    cxxResources.instructions = txResources.instructions;
+    // This may throw, but only in case of the Core version misconfiguration.
+    return rust_bridge::compute_transaction_resource_fee(
+        cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion,
+        toCxxTransactionResources(txResources, txSize, eventsSize),
+        sorobanConfig.rustBridgeFeeConfiguration());
+}
 
-    cxxResources.read_entries =
-        static_cast<uint32>(txResources.footprint.readOnly.size());
-    cxxResources.write_entries =
-        static_cast<uint32>(txResources.footprint.readWrite.size());
+void
+TransactionFrame::precomputePreApplySorobanResourceFees(
+    std::vector<TransactionFrameBasePtr> const& txs, uint32_t protocolVersion,
+    SorobanNetworkConfig const& sorobanConfig, Config const& cfg)
+{
+    ZoneScoped;
+    if (protocolVersionIsBefore(protocolVersion, SOROBAN_PROTOCOL_VERSION))
+    {
+        return;
+    }
+    auto feeConfig = sorobanConfig.rustBridgeFeeConfiguration();
+    std::vector<TransactionFrame*> frames;
+    rust::Vec<CxxTransactionResources> resources;
+    for (auto const& tx : txs)
+    {
+        if (!tx->isSoroban())
+        {
+            continue;
+        }
+        auto& frame = tx->getSorobanFeeFrame();
+        auto const& cached = frame.mCachedSorobanResourceFee;
+        if (cached && cached->mProtocolVersion == protocolVersion &&
+            sameFeeConfiguration(cached->mFeeConfig, feeConfig))
+        {
+            continue;
+        }
+        frames.emplace_back(&frame);
+        resources.emplace_back(toCxxTransactionResources(
+            frame.sorobanResources(), frame.getPreApplySorobanTxSize(), 0));
+    }
+    if (frames.empty())
+    {
+        return;
+    }
 
-    cxxResources.read_bytes = txResources.readBytes;
-    cxxResources.write_bytes = txResources.writeBytes;
+    // This may throw, but only in case of the Core version misconfiguration.
+    auto fees = rust_bridge::compute_transaction_resource_fees(
+        cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion, resources,
+        feeConfig);
+    releaseAssert(fees.size() == frames.size());
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+        frames[i]->mCachedSorobanResourceFee =
+            CachedSorobanResourceFee{protocolVersion, feeConfig, fees[i]};
+    }
+}
 
-    cxxResources.transaction_size_bytes = txSize;
-    cxxResources.contract_events_size_bytes = eventsSize;
+TransactionFrame&
+TransactionFrame::getSorobanFeeFrame()
+{
+    return *this;
+}
 
-    // This may throw, but only in case of the Core version misconfiguration.
-    return rust_bridge::compute_transaction_resource_fee(
-        cfg.CURRENT_LEDGER_PROTOCOL_VERSION, protocolVersion, cxxResources,
-        sorobanConfig.rustBridgeFeeConfiguration());
+void
+TransactionFrame::setSignaturesTrusted(bool trusted)
+{
+    mSignaturesTrusted = trusted;
+}
+
+uint32_t
+TransactionFrame::getPreApplySorobanTxSize() const
+{
+    return static_cast<uint32>(
+        getResources(false).getVal(Resource::Type::TX_BYTE_SIZE));
 }
 
 int64
@@ -898,14 +1014,23 @@ TransactionFrame::computePreApplySorobanResourceFee(
 {
     ZoneScoped;
     releaseAssertOrThrow(isSoroban());
+    auto feeConfig = sorobanConfig.rustBridgeFeeConfiguration();
+    if (mCachedSorobanResourceFee &&
+        mCachedSorobanResourceFee->mProtocolVersion == protocolVersion &&
+        sameFeeConfiguration(mCachedSorobanResourceFee->mFeeConfig,
+                             feeConfig))
+    {
+        return mCachedSorobanResourceFee->mFee;
+    }
     // We always use the declared resource value for the resource fee
     // computation. The refunds are performed as a separate operation that
     // doesn't involve modifying any transaction fees.
-    return computeSorobanResourceFee(
-        protocolVersion, sorobanResources(),
-        static_cast<uint32>(
-            getResources(false).getVal(Resource::Type::TX_BYTE_SIZE)),
-        0, sorobanConfig, cfg);
+    auto fee = computeSorobanResourceFee(protocolVersion, sorobanResources(),
+                                         getPreApplySorobanTxSize(), 0,
+                                         sorobanConfig, cfg);
+    mCachedSorobanResourceFee =
+        CachedSorobanResourceFee{protocolVersion, feeConfig, fee};
+    return fee;
 }
 
 bool
@@ -939,9 +1064,7 @@ TransactionFrame::consumeRefundableSorobanResources(
     feeRefund -= consumedRentFee;
 
     FeePair consumedFee = computeSorobanResourceFee(
-        protocolVersion, sorobanResources(),
-        static_cast<uint32>(
-            getResources(false).getVal(Resource::Type::TX_BYTE_SIZE)),
+        protocolVersion, sorobanResources(), getPreApplySorobanTxSize(),
         consumedContractEventsSizeBytes, sorobanConfig, cfg);
     consumedRefundableFee += consumedFee.refundable_fee;
     if (feeRefund < consumedFee.refundable_fee)
@@ -1544,6 +1667,49 @@ TransactionFrame::removeAccountSigner(AbstractLedgerTxn& ltxOuter,
     }
 }
 
+Hash
+TransactionFrame::getValidationKey(AbstractLedgerTxn& ltx,
+                                   SequenceNumber current, bool chargeFee,
+                                   uint64_t lowerBoundCloseTimeOffset,
+                                   uint64_t upperBoundCloseTimeOffset) const
+{
+    ZoneScoped;
+    SHA256 hasher;
+    // The envelope rather than its cached hash, as tests modify envelopes in
+    // place
+    xdrSha256Add(hasher, mEnvelope);
+    auto header = ltx.loadHeader();
+    xdrSha256Add(hasher, header.current());
+    xdrSha256Add(hasher, current);
+    xdrSha256Add(hasher, static_cast<uint32_t>(chargeFee));
+
+    // The offsets only matter through these checks, which usually pass for
+    // both the offsets used by the queue and those of a nominated close time
+    xdrSha256Add(hasher, static_cast<uint32_t>(
+                             isTooEarly(header, lowerBoundCloseTimeOffset)));
+    xdrSha256Add(hasher, static_cast<uint32_t>(
+                             isTooLate(header, upperBoundCloseTimeOffset)));
+    if (getMinSeqAge() != 0)
+    {
+        xdrSha256Add(hasher, lowerBoundCloseTimeOffset);
+    }
+
+    auto addAccount = [&](AccountID const& id) {
+        auto entry = ltx.loadWithoutRecord(accountKey(id));
+        xdrSha256Add(hasher, static_cast<uint32_t>(bool(entry)));
+        if (entry)
+        {
+            xdrSha256Add(hasher, entry.current());
+        }
+    };
+    addAccount(getSourceID());
+    for (auto const& op : mOperations)
+    {
+        addAccount(op->getSourceID());
+    }
+    return hasher.finish();
+}
+
 bool
 TransactionFrame::checkValidWithOptionallyChargedFee(
     Application& app, AbstractLedgerTxn& ltxOuter, SequenceNumber current,
@@ -1568,17 +1734,47 @@ TransactionFrame::checkValidWithOptionallyChargedFee(
 
     resetResults(ltx.loadHeader().current(), minBaseFee, false);
 
+    std::shared_ptr<SorobanNetworkConfig const> sorobanConfig;
+    if (protocolVersionStartsFrom(ltx.loadHeader().current().ledgerVersion,
+                                  SOROBAN_PROTOCOL_VERSION) &&
+        isSoroban())
+    {
+        sorobanConfig =
+            app.getLedgerManager().getSorobanNetworkConfigSnapshot();
+    }
+
+    std::optional<Hash> validationKey;
+    if (!isSoroban() || sorobanConfig)
+    {
+        validationKey = getValidationKey(ltx, current, chargeFee,
+                                         lowerBoundCloseTimeOffset,
+                                         upperBoundCloseTimeOffset);
+        if (mCachedValidation && mCachedValidation->mKey == *validationKey &&
+            mCachedValidation->mSorobanConfig == sorobanConfig)
+        {
+            // Operation frames reference their results, so these are
+            // assigned in place
+            auto& opResults = getResult().result.results();
+            releaseAssert(opResults.size() ==
+                          mCachedValidation->mOpResults.size());
+            for (size_t i = 0; i < opResults.size(); ++i)
+            {
+                opResults[i] = mCachedValidation->mOpResults[i];
+            }
+            return true;
+        }
+    }
+    mCachedValidation.reset();
+
     SignatureChecker signatureChecker{ltx.loadHeader().current().ledgerVersion,
                                       getContentsHash(),
                                       getSignatures(mEnvelope)};
     std::optional<FeePair> sorobanResourceFee;
-    if (protocolVersionStartsFrom(ltx.loadHeader().current().ledgerVersion,
-                                  SOROBAN_PROTOCOL_VERSION) &&
-        isSoroban())
+    if (sorobanConfig)
     {
         sorobanResourceFee = computePreApplySorobanResourceFee(
-            ltx.loadHeader().current().ledgerVersion,
-            app.getLedgerManager().getSorobanNetworkConfig(), app.getConfig());
+            ltx.loadHeader().current().ledgerVersion, *sorobanConfig,
+            app.getConfig());
     }
     bool res =
         commonValid(app, signatureChecker, ltx, current, false, chargeFee,
@@ -1604,6 +1800,11 @@ TransactionFrame::checkValidWithOptionallyChargedFee(
             getResult().result.code(txBAD_AUTH_EXTRA);
         }
     }
+    if (res && validationKey)
+    {
+        mCachedValidation = CachedValidation{
+            *validationKey, getResult().result.results(), sorobanConfig};
+    }
     return res;
 }
 
@@ -1699,6 +1900,8 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             app.getConfig().LEDGER_PROTOCOL_MIN_VERSION_INTERNAL_ERROR_REPORT;
         auto& opTimer =
             app.getMetrics().NewTimer({"ledger", "operation", "apply"});
+        auto& opTypeMetrics =
+            app.getLedgerManager().getOperationApplyMetrics();
 
         uint64_t opNum{0};
         for (auto& op : mOperations)
@@ -1712,12 +1915,16 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             {
                 SHA256 subSeedSha;
                 subSeedSha.add(sorobanBasePrngSeed);
-                subSeedSha.add(xdr::xdr_to_opaque(opNum));
+                xdrSha256Add(subSeedSha, opNum);
                 subSeed = subSeedSha.finish();
             }
             ++opNum;
 
+            auto const opType = op->getOperation().body.type();
+            auto const applyStart = std::chrono::steady_clock::now();
             bool txRes = op->apply(app, signatureChecker, ltxOp, subSeed);
+            auto const commitStart = std::chrono::steady_clock::now();
+            opTypeMetrics.recordApply(opType, commitStart - applyStart, txRes);
 
             if (!txRes)
             {
@@ -1731,7 +1938,10 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
                 // The operation meta will be empty if the transaction
                 // doesn't succeed so we may as well not do any work in that
                 // case
-                operationMetas.emplace_back(ltxOp.getChanges());
+                if (outerMeta.isEnabled())
+                {
+                    operationMetas.emplace_back(ltxOp.getChanges());
+                }
             }
 
             if (txRes ||
@@ -1739,6 +1949,8 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
             {
                 ltxOp.commit();
             }
+            opTypeMetrics.recordCommit(
+                opType, std::chrono::steady_clock::now() - commitStart);
         }
 
         if (success)
@@ -1759,7 +1971,10 @@ TransactionFrame::applyOperations(SignatureChecker& signatureChecker,
                 // owner to remove that signer
                 LedgerTxn ltxAfter(ltxTx);
                 removeOneTimeSignerFromAllSourceAccounts(ltxAfter);
-                changesAfter = ltxAfter.getChanges();
+                if (outerMeta.isEnabled())
+                {
+                    changesAfter = ltxAfter.getChanges();
+                }
                 ltxAfter.commit();
             }
             else if (protocolVersionStartsFrom(ledgerVersion,
@@ -1902,7 +2117,8 @@ TransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
         mCachedAccount.reset();
         uint32_t ledgerVersion = ltx.loadHeader().current().ledgerVersion;
         SignatureChecker signatureChecker{ledgerVersion, getContentsHash(),
-                                          getSignatures(mEnvelope)};
+                                          getSignatures(mEnvelope),
+                                          mSignaturesTrusted};
 
         //  when applying, a failure during tx validation means that
         //  we'll skip trying to apply operations but we'll still
@@ -1932,7 +2148,10 @@ TransactionFrame::apply(Application& app, AbstractLedgerTxn& ltx,
 
         bool signaturesValid = processSignatures(cv, signatureChecker, ltxTx);
 
-        meta.pushTxChangesBefore(ltxTx.getChanges());
+        if (meta.isEnabled())
+        {
+            meta.pushTxChangesBefore(ltxTx.getChanges());
+        }
         ltxTx.commit();
 
         bool ok = signaturesValid && cv == ValidationType::kMaybeValid;
@@ -2009,7 +2228,10 @@ TransactionFrame::processRefund(Application& app, AbstractLedgerTxn& ltxOuter,
     // transaction success).
     LedgerTxn ltx(ltxOuter);
     int64_t refund = refundSorobanFee(ltx, feeSource);
-    meta.pushTxChangesAfter(ltx.getChanges());
+    if (meta.isEnabled())
+    {
+        meta.pushTxChangesAfter(ltx.getChanges());
+    }
     ltx.commit();
 
     return refund;
@@ -73,6 +73,33 @@ class TransactionFrame : public TransactionFrameBase
 
     std::shared_ptr<InternalLedgerEntry const> mCachedAccount;
 
+    // The last successful checkValid of the transaction, so that validating
+    // it again against the same state (typically when a transaction set
+    // containing it is validated after the queue admitted it) doesn't redo
+    // the signature and resource checks. See getValidationKey. Soroban
+    // transactions also depend on the network config they were checked
+    // against, which is held so that its address identifies it.
+    struct CachedValidation
+    {
+        Hash mKey;
+        xdr::xvector<OperationResult> mOpResults;
+        std::shared_ptr<SorobanNetworkConfig const> mSorobanConfig;
+    };
+    std::optional<CachedValidation> mCachedValidation;
+
+    bool mSignaturesTrusted{false};
+
+    // The last pre-apply Soroban resource fee, along with the protocol and
+    // fee configuration it was computed for, as the same transaction is
+    // typically charged several times from its admission to its apply
+    struct CachedSorobanResourceFee
+    {
+        uint32_t mProtocolVersion;
+        CxxFeeConfiguration mFeeConfig;
+        FeePair mFee;
+    };
+    std::optional<CachedSorobanResourceFee> mCachedSorobanResourceFee;
+
     Hash const& mNetworkID;     // used to change the way we compute signatures
     mutable Hash mContentsHash; // the hash of the contents
     mutable Hash mFullHash;     // the hash of the contents and the sig.
@@ -101,6 +128,14 @@ class TransactionFrame : public TransactionFrameBase
                               LedgerTxnEntry const& sourceAccount,
                               uint64_t lowerBoundCloseTimeOffset) const;
 
+    // Digest of everything checkValid depends on besides the Soroban network
+    // config: the envelope, the ledger header, the entries of the accounts
+    // whose signatures are checked, the `current` sequence number and fee
+    // mode, and the outcome of the close time checks for the given offsets
+    Hash getValidationKey(AbstractLedgerTxn& ltx, SequenceNumber current,
+                          bool chargeFee, uint64_t lowerBoundCloseTimeOffset,
+                          uint64_t upperBoundCloseTimeOffset) const;
+
     bool commonValidPreSeqNum(Application& app, AbstractLedgerTxn& ltx,
                               bool chargeFee,
                               uint64_t lowerBoundCloseTimeOffset,
@@ -150,6 +185,8 @@ class TransactionFrame : public TransactionFrameBase
     int64_t refundSorobanFee(AbstractLedgerTxn& ltx,
                              AccountID const& feeSource);
     void updateSorobanMetrics(Application& app);
+    // Size the Soroban resource fee is charged for
+    uint32_t getPreApplySorobanTxSize() const;
 #ifdef BUILD_TESTS
   public:
 #endif
@@ -177,6 +214,7 @@ class TransactionFrame : public TransactionFrameBase
 
     Hash const& getFullHash() const override;
     Hash const& getContentsHash() const override;
+    void collectUncachedHashes(UncachedHashes& hashes) const override;
 
     std::vector<std::shared_ptr<OperationFrame>> const&
     getOperations() const
@@ -322,7 +360,16 @@ class TransactionFrame : public TransactionFrameBase
         uint32_t protocolVersion, SorobanResources const& txResources,
         uint32_t txSize, uint32_t eventsSize,
         SorobanNetworkConfig const& sorobanConfig, Config const& cfg);
+    // Computes the pre-apply Soroban resource fees of all the Soroban
+    // transactions in `txs` that don't have it cached yet with a single call
+    // to the host, for computePreApplySorobanResourceFee to reuse.
+    static void precomputePreApplySorobanResourceFees(
+        std::vector<TransactionFrameBasePtr> const& txs,
+        uint32_t protocolVersion, SorobanNetworkConfig const& sorobanConfig,
+        Config const& cfg);
+    TransactionFrame& getSorobanFeeFrame() override;
     virtual int64 declaredSorobanResourceFee() const override;
     virtual bool XDRProvidesValidFee() const override;
+    void setSignaturesTrusted(bool trusted) override;
 };
 }
@@ -3,25 +3,57 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "transactions/TransactionFrameBase.h"
+#include "crypto/SHA.h"
 #include "transactions/FeeBumpTransactionFrame.h"
 #include "transactions/TransactionFrame.h"
+#include "util/Arena.h"
+#include "util/ZoneProfiler.h"
 
 namespace stellar
 {
 
 TransactionFrameBasePtr
-TransactionFrameBase::makeTransactionFromWire(Hash const& networkID,
-                                              TransactionEnvelope const& env)
+TransactionFrameBase::makeTransactionFromWire(
+    Hash const& networkID, TransactionEnvelope const& env,
+    std::shared_ptr<Arena> const& arena)
 {
+    // Without an arena, the allocator falls back to the global heap
     switch (env.type())
     {
     case ENVELOPE_TYPE_TX_V0:
     case ENVELOPE_TYPE_TX:
-        return std::make_shared<TransactionFrame>(networkID, env);
+        return std::allocate_shared<TransactionFrame>(
+            ArenaAllocator<TransactionFrame>(arena), networkID, env);
     case ENVELOPE_TYPE_TX_FEE_BUMP:
-        return std::make_shared<FeeBumpTransactionFrame>(networkID, env);
+        return std::allocate_shared<FeeBumpTransactionFrame>(
+            ArenaAllocator<FeeBumpTransactionFrame>(arena), networkID, env);
     default:
         abort();
     }
 }
+
+void
+TransactionFrameBase::cacheHashes(
+    std::vector<TransactionFrameBasePtr> const& txs)
+{
+    ZoneScoped;
+    UncachedHashes hashes;
+    hashes.reserve(2 * txs.size());
+    for (auto const& tx : txs)
+    {
+        tx->collectUncachedHashes(hashes);
+    }
+
+    std::vector<ByteSlice> bins;
+    bins.reserve(hashes.size());
+    for (auto const& h : hashes)
+    {
+        bins.emplace_back(h.second.data(), h.second.size());
+    }
+    auto res = sha256Batch(bins);
+    for (size_t i = 0; i < hashes.size(); ++i)
+    {
+        *hashes[i].first = res[i];
+    }
+}
 }
@@ -20,8 +20,10 @@ namespace stellar
 {
 class AbstractLedgerTxn;
 class Application;
+class Arena;
 class Database;
 class OperationFrame;
+class TransactionFrame;
 
 class TransactionFrameBase;
 using TransactionFrameBasePtr = std::shared_ptr<TransactionFrameBase>;
@@ -31,9 +33,19 @@ using TransactionFrameBaseConstPtr =
 class TransactionFrameBase
 {
   public:
+    // Where to cache a hash of a transaction, and the bytes to hash
+    using UncachedHashes = std::vector<std::pair<Hash*, xdr::opaque_vec<>>>;
+
+    // If `arena` is set, the frame is allocated from it and keeps it alive
+    // for as long as the frame itself lives.
     static TransactionFrameBasePtr
     makeTransactionFromWire(Hash const& networkID,
-                            TransactionEnvelope const& env);
+                            TransactionEnvelope const& env,
+                            std::shared_ptr<Arena> const& arena = nullptr);
+
+    // Computes the full and contents hashes of `txs` that are not cached yet
+    // all at once, with sha256Batch.
+    static void cacheHashes(std::vector<TransactionFrameBasePtr> const& txs);
 
     virtual bool apply(Application& app, AbstractLedgerTxn& ltx,
                        TransactionMetaFrame& meta,
@@ -60,6 +72,9 @@ class TransactionFrameBase
 
     virtual Hash const& getContentsHash() const = 0;
     virtual Hash const& getFullHash() const = 0;
+    // Appends the hashes of this transaction that getContentsHash and
+    // getFullHash would have to compute
+    virtual void collectUncachedHashes(UncachedHashes& hashes) const = 0;
 
     virtual uint32_t getNumOperations() const = 0;
     virtual Resource getResources(bool useByteLimitInClassic) const = 0;
@@ -96,5 +111,13 @@ class TransactionFrameBase
     getDiagnosticEvents() const = 0;
     virtual int64 declaredSorobanResourceFee() const = 0;
     virtual bool XDRProvidesValidFee() const = 0;
+    // The transaction that computes the Soroban resource fee of this one:
+    // itself, or the inner transaction of a fee bump
+    virtual TransactionFrame& getSorobanFeeFrame() = 0;
+
+    // Whether apply takes the signatures as valid without checking them,
+    // which is only right for a transaction replayed from history whose
+    // recorded result is a success
+    virtual void setSignaturesTrusted(bool trusted) = 0;
 };
 }
@@ -0,0 +1,164 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionHistoryWriter.h"
+#include "database/Database.h"
+#include "main/Application.h"
+#include "main/Config.h"
+#include "main/PersistentState.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+namespace stellar
+{
+
+namespace
+{
+// Closing a ledger waits for the writer once that many ledgers are queued,
+// which only happens when it can't keep up, such as during catchup
+size_t const MAX_QUEUED_LEDGERS = 32;
+}
+
+TransactionHistoryWriter::TransactionHistoryWriter(Application& app,
+                                                   uint32_t lcl)
+    : mApp(app)
+    , mSession(app.getDatabase().getPool())
+    , mWriteTimer(app.getMetrics().NewTimer(
+          {"ledger", "transaction-history", "write"}))
+    , mQueuedLedgers(app.getMetrics().NewCounter(
+          {"ledger", "transaction-history", "queued"}))
+    , mLastQueued(lcl)
+{
+    auto& ps = app.getPersistentState();
+    auto written = ps.getState(PersistentState::kTxHistoryWritten);
+    if (!written.empty() && std::stoul(written) < lcl)
+    {
+        CLOG_ERROR(Ledger,
+                   "The transaction history of ledgers {} to {} was not "
+                   "written before the last shutdown and is missing from the "
+                   "database",
+                   std::stoul(written) + 1, lcl);
+    }
+    ps.setState(PersistentState::kTxHistoryWritten, std::to_string(lcl));
+    mThread = std::thread{[this]() { run(); }};
+}
+
+TransactionHistoryWriter::~TransactionHistoryWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCond.notify_all();
+    mThread.join();
+}
+
+void
+TransactionHistoryWriter::run()
+{
+    while (true)
+    {
+        std::pair<uint32_t, TransactionHistoryRows>* next = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [&] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty())
+            {
+                return;
+            }
+            // Leave it queued until it is written, the main thread only
+            // appends to the queue so the reference stays valid
+            next = &mQueue.front();
+        }
+
+        try
+        {
+            write(next->first, next->second);
+        }
+        catch (std::exception& e)
+        {
+            CLOG_ERROR(Ledger, "Failed to write transaction history of {}: {}",
+                       next->first, e.what());
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFailure = std::current_exception();
+            mQueuedLedgers.dec(mQueue.size());
+            mQueue.clear();
+            mCond.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.pop_front();
+            mQueuedLedgers.dec();
+        }
+        mCond.notify_all();
+    }
+}
+
+void
+TransactionHistoryWriter::write(uint32_t ledgerSeq,
+                                TransactionHistoryRows& rows)
+{
+    ZoneScoped;
+    auto timer = mWriteTimer.TimeScope();
+    soci::transaction tx(mSession);
+    rows.store(mApp.getDatabase(), mSession, ledgerSeq, mApp.getConfig());
+    auto written = std::to_string(ledgerSeq);
+    auto const& name =
+        PersistentState::getStateName(PersistentState::kTxHistoryWritten);
+    mSession << "UPDATE storestate SET state = :v WHERE statename = :n",
+        soci::use(written), soci::use(name);
+    tx.commit();
+}
+
+void
+TransactionHistoryWriter::rethrowFailure()
+{
+    if (mFailure)
+    {
+        std::rethrow_exception(mFailure);
+    }
+}
+
+void
+TransactionHistoryWriter::enqueue(uint32_t ledgerSeq,
+                                  TransactionHistoryRows&& rows)
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        // Ledgers can be skipped, by applying buckets, but not reordered
+        releaseAssert(ledgerSeq > mLastQueued);
+        mCond.wait(lock, [&] {
+            return mFailure || mQueue.size() < MAX_QUEUED_LEDGERS;
+        });
+        rethrowFailure();
+        mQueue.emplace_back(ledgerSeq, std::move(rows));
+        mLastQueued = ledgerSeq;
+        mQueuedLedgers.inc();
+    }
+    mCond.notify_all();
+}
+
+bool
+TransactionHistoryWriter::isWritten(uint32_t ledgerSeq)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    rethrowFailure();
+    return mQueue.empty() || mQueue.front().first > ledgerSeq;
+}
+
+void
+TransactionHistoryWriter::waitUntilWritten()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCond.wait(lock, [&] { return mFailure || mQueue.empty(); });
+    rethrowFailure();
+}
+}
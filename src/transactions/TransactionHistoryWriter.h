@@ -0,0 +1,78 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "transactions/TransactionSQL.h"
+#include "util/NonCopyable.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <soci.h>
+#include <thread>
+
+namespace medida
+{
+class Counter;
+class Timer;
+}
+
+namespace stellar
+{
+
+class Application;
+
+// Stores the txhistory and txfeehistory rows of closed ledgers from a thread
+// of its own, through a session of the connection pool, so that closing a
+// ledger doesn't wait for them. Ledgers are queued in order once their header
+// is committed, and each is stored in a transaction of its own that also
+// records it as the last one written, in the txhistorywritten storestate.
+//
+// The rows of the ledgers still queued are lost if the process dies: on
+// startup the writer reports the ledgers whose rows are missing. Anything
+// reading the rows of a ledger on another session, like publishing, must
+// wait for isWritten to hold for it.
+class TransactionHistoryWriter : NonMovableOrCopyable
+{
+    Application& mApp;
+    soci::session mSession;
+    medida::Timer& mWriteTimer;
+    medida::Counter& mQueuedLedgers;
+
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // The ledger at the front is the one being written
+    std::deque<std::pair<uint32_t, TransactionHistoryRows>> mQueue;
+    uint32_t mLastQueued;
+    bool mStopping{false};
+    // Set when writing failed, the writer stops then
+    std::exception_ptr mFailure;
+    std::thread mThread;
+
+    void run();
+    void write(uint32_t ledgerSeq, TransactionHistoryRows& rows);
+    void rethrowFailure();
+
+  public:
+    // `lcl` is the last closed ledger, the rows of all the ledgers up to it
+    // are expected to be stored already.
+    TransactionHistoryWriter(Application& app, uint32_t lcl);
+    // Stores what is still queued before returning
+    ~TransactionHistoryWriter();
+
+    // Queue the rows of `ledgerSeq`, which must follow the last ledger
+    // queued, waiting first if the writer is far behind. Rethrows the error
+    // that stopped the writer, if any.
+    void enqueue(uint32_t ledgerSeq, TransactionHistoryRows&& rows);
+
+    // Whether the rows of all the ledgers up to `ledgerSeq` are stored.
+    // Rethrows the error that stopped the writer, if any.
+    bool isWritten(uint32_t ledgerSeq);
+
+    // Wait for everything queued to be stored
+    void waitUntilWritten();
+};
+}
@@ -11,10 +11,16 @@ namespace stellar
 
 // Wrapper around TransactionMeta XDR that provides mutable access to fields
 // in the proper version of meta.
+//
+// A frame constructed with `enabled` false ignores everything pushed to it,
+// for when nothing consumes the meta. Callers should check isEnabled() before
+// computing LedgerTxn changes that would only be pushed to it.
 class TransactionMetaFrame
 {
   public:
-    TransactionMetaFrame(uint32_t protocolVersion);
+    TransactionMetaFrame(uint32_t protocolVersion, bool enabled = true);
+
+    bool isEnabled() const;
 
     void pushTxChangesBefore(LedgerEntryChanges&& changes);
     size_t getNumChangesBefore() const;
@@ -38,6 +44,7 @@ class TransactionMetaFrame
   private:
     TransactionMeta mTransactionMeta;
     int mVersion;
+    bool mEnabled;
 };
 
 }
@@ -4,17 +4,20 @@
 
 #include "transactions/TransactionSQL.h"
 #include "crypto/Hex.h"
+#include "database/BulkInsertOperation.h"
 #include "database/Database.h"
 #include "database/DatabaseUtils.h"
 #include "herder/TxSetFrame.h"
 #include "ledger/LedgerHeaderUtils.h"
+#include "ledger/LedgerManager.h"
+#include "ledger/RecentLedgerHeaders.h"
 #include "main/Application.h"
 #include "util/Decoder.h"
 #include "util/GlobalChecks.h"
 #include "util/XDRStream.h"
+#include "util/ZoneProfiler.h"
 #include "xdrpp/marshal.h"
 #include "xdrpp/message.h"
-#include <Tracy.hpp>
 
 namespace stellar
 {
@@ -244,14 +247,14 @@ readEncodedTxSets(Application& app, soci::session& sess, uint32_t ledgerSeq,
 
 void
 writeNonGeneralizedTxSetToStream(
-    Database& db, soci::session& sess, uint32 ledgerSeq,
-    std::vector<TransactionFrameBasePtr> const& txs,
+    Database& db, soci::session& sess, RecentLedgerHeaders const& recent,
+    uint32 ledgerSeq, std::vector<TransactionFrameBasePtr> const& txs,
     TransactionHistoryResultEntry& results, XDROutputFileStream& txOut,
     XDROutputFileStream& txResultOut)
 {
     ZoneScoped;
     // prepare the txset for saving
-    auto lh = LedgerHeaderUtils::loadBySequence(db, sess, ledgerSeq);
+    auto lh = LedgerHeaderUtils::loadBySequence(db, sess, ledgerSeq, &recent);
     if (!lh)
     {
         throw std::runtime_error("Could not find ledger");
@@ -304,7 +307,8 @@ writeGeneralizedTxSetToStream(uint32 ledgerSeq,
 
 void
 writeTxSetToStream(
-    Database& db, soci::session& sess, uint32 ledgerSeq,
+    Database& db, soci::session& sess, RecentLedgerHeaders const& recent,
+    uint32 ledgerSeq,
     std::vector<std::pair<uint32_t, std::vector<uint8_t>>> const& encodedTxSets,
     std::vector<std::pair<uint32_t, std::vector<uint8_t>>>::const_iterator&
         encodedTxSetIt,
@@ -321,8 +325,8 @@ writeTxSetToStream(
     // considered generalized.
     if (encodedTxSets.empty() || ledgerSeq < encodedTxSets.front().first)
     {
-        writeNonGeneralizedTxSetToStream(db, sess, ledgerSeq, txs, results,
-                                         txOut, txResultOut);
+        writeNonGeneralizedTxSetToStream(db, sess, recent, ledgerSeq, txs,
+                                         results, txOut, txResultOut);
     }
     else
     {
@@ -348,58 +352,92 @@ writeTxSetToStream(
 } // namespace
 
 void
-storeTransaction(Database& db, uint32_t ledgerSeq,
-                 TransactionFrameBasePtr const& tx, TransactionMeta const& tm,
-                 TransactionResultSet const& resultSet, Config const& cfg)
+TransactionHistoryRows::addTransaction(TransactionFrameBasePtr const& tx,
+                                       TransactionMeta const& tm,
+                                       TransactionResultPair const& result,
+                                       uint32_t txIndex, Config const& cfg)
 {
     ZoneScoped;
-    std::string txBody =
-        decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope()));
-    std::string txResult =
-        decoder::encode_b64(xdr::xdr_to_opaque(resultSet.results.back()));
-    std::string meta = decoder::encode_b64(xdr::xdr_to_opaque(tm));
-
-    std::string txIDString = binToHex(tx->getContentsHash());
-    uint32_t txIndex = static_cast<uint32_t>(resultSet.results.size());
-
-    std::string sqlStr;
-    if (cfg.isUsingBucketListDB())
-    {
-        sqlStr = "INSERT INTO txhistory "
-                 "( txid, ledgerseq, txindex,  txbody, txresult) VALUES "
-                 "(:id,  :seq,      :txindex, :txb,   :txres)";
-    }
-    else
+    mTxIDs.emplace_back(binToHex(tx->getContentsHash()));
+    mTxIndexes.emplace_back(static_cast<int32_t>(txIndex));
+    mTxBodies.emplace_back(
+        decoder::encode_b64(xdr::xdr_to_opaque(tx->getEnvelope())));
+    mTxResults.emplace_back(decoder::encode_b64(xdr::xdr_to_opaque(result)));
+    // txmeta only supported when BucketListDB is not enabled
+    if (!cfg.isUsingBucketListDB())
     {
-        sqlStr =
-            "INSERT INTO txhistory "
-            "( txid, ledgerseq, txindex,  txbody, txresult, txmeta) VALUES "
-            "(:id,  :seq,      :txindex, :txb,   :txres,   :meta)";
+        mTxMetas.emplace_back(decoder::encode_b64(xdr::xdr_to_opaque(tm)));
     }
+}
 
-    auto prep = db.getPreparedStatement(sqlStr);
-    auto& st = prep.statement();
-    st.exchange(soci::use(txIDString));
-    st.exchange(soci::use(ledgerSeq));
-    st.exchange(soci::use(txIndex));
-    st.exchange(soci::use(txBody));
-    st.exchange(soci::use(txResult));
+void
+TransactionHistoryRows::addTransactionFee(TransactionFrameBasePtr const& tx,
+                                          LedgerEntryChanges const& changes,
+                                          uint32_t txIndex)
+{
+    ZoneScoped;
+    mFeeTxIDs.emplace_back(binToHex(tx->getContentsHash()));
+    mFeeTxIndexes.emplace_back(static_cast<int32_t>(txIndex));
+    mFeeChanges.emplace_back(
+        decoder::encode_b64(xdr::xdr_to_opaque(changes)));
+}
 
-    if (!cfg.isUsingBucketListDB())
-    {
-        st.exchange(soci::use(meta));
-    }
+void
+TransactionHistoryRows::store(Database& db, uint32_t ledgerSeq,
+                              Config const& cfg)
+{
+    insert(db, nullptr, ledgerSeq, cfg);
+}
 
-    st.define_and_bind();
-    {
-        auto timer = db.getInsertTimer("txhistory");
-        st.execute(true);
-    }
+void
+TransactionHistoryRows::store(Database& db, soci::session& sess,
+                              uint32_t ledgerSeq, Config const& cfg)
+{
+    insert(db, &sess, ledgerSeq, cfg);
+}
 
-    if (st.get_affected_rows() != 1)
-    {
-        throw std::runtime_error("Could not update data in SQL");
+void
+TransactionHistoryRows::insert(Database& db, soci::session* sess,
+                               uint32_t ledgerSeq, Config const& cfg)
+{
+    ZoneScoped;
+    auto& session = sess ? *sess : db.getSession();
+    auto checkInserted = [](size_t inserted, size_t expected) {
+        if (inserted != expected)
+        {
+            throw std::runtime_error("Could not update data in SQL");
+        }
+    };
+    if (!mFeeTxIDs.empty())
+    {
+        std::vector<int32_t> ledgerSeqs(mFeeTxIDs.size(),
+                                        static_cast<int32_t>(ledgerSeq));
+        BulkInsertOperation op(db, "txfeehistory", "", sess);
+        op.addColumn("txid", mFeeTxIDs);
+        op.addColumn("ledgerseq", ledgerSeqs);
+        op.addColumn("txindex", mFeeTxIndexes);
+        op.addColumn("txchanges", mFeeChanges);
+        checkInserted(doDatabaseTypeSpecificOperation(session, op),
+                      mFeeTxIDs.size());
+    }
+    if (!mTxIDs.empty())
+    {
+        std::vector<int32_t> ledgerSeqs(mTxIDs.size(),
+                                        static_cast<int32_t>(ledgerSeq));
+        BulkInsertOperation op(db, "txhistory", "", sess);
+        op.addColumn("txid", mTxIDs);
+        op.addColumn("ledgerseq", ledgerSeqs);
+        op.addColumn("txindex", mTxIndexes);
+        op.addColumn("txbody", mTxBodies);
+        op.addColumn("txresult", mTxResults);
+        if (!cfg.isUsingBucketListDB())
+        {
+            op.addColumn("txmeta", mTxMetas);
+        }
+        checkInserted(doDatabaseTypeSpecificOperation(session, op),
+                      mTxIDs.size());
     }
+    *this = TransactionHistoryRows();
 }
 
 void
@@ -555,7 +593,8 @@ copyTransactionsToStream(Application& app, soci::session& sess,
          soci::into(curLedgerSeq), soci::into(txBody), soci::into(txResult),
          soci::use(begin), soci::use(end));
 
-    auto lh = LedgerHeaderUtils::loadBySequence(db, sess, ledgerSeq);
+    auto const& recent = app.getLedgerManager().getRecentLedgerHeaders();
+    auto lh = LedgerHeaderUtils::loadBySequence(db, sess, ledgerSeq, &recent);
     if (!lh)
     {
         throw std::runtime_error("Could not find ledger");
@@ -574,9 +613,9 @@ copyTransactionsToStream(Application& app, soci::session& sess,
     {
         if (curLedgerSeq != lastLedgerSeq)
         {
-            writeTxSetToStream(db, sess, lastLedgerSeq, encodedTxSets,
-                               encodedTxSetIt, txs, results, txOut,
-                               txResultOut);
+            writeTxSetToStream(db, sess, recent, lastLedgerSeq,
+                               encodedTxSets, encodedTxSetIt, txs, results,
+                               txOut, txResultOut);
             // reset state
             txs.clear();
             results.ledgerSeq = curLedgerSeq;
@@ -613,7 +652,7 @@ copyTransactionsToStream(Application& app, soci::session& sess,
 
     if (n != 0)
     {
-        writeTxSetToStream(db, sess, lastLedgerSeq, encodedTxSets,
+        writeTxSetToStream(db, sess, recent, lastLedgerSeq, encodedTxSets,
                            encodedTxSetIt, txs, results, txOut, txResultOut);
     }
     return n;
@@ -666,17 +705,19 @@ dropTransactionHistory(Database& db, Config const& cfg)
     createTxSetHistoryTable(db);
 }
 
-void
-deleteOldTransactionHistoryEntries(Database& db, uint32_t ledgerSeq,
+uint64_t
+deleteOldTransactionHistoryEntries(soci::session& sess, uint32_t ledgerSeq,
                                    uint32_t count)
 {
     ZoneScoped;
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "txhistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "txsethistory", "ledgerseq");
-    DatabaseUtils::deleteOldEntriesHelper(db.getSession(), ledgerSeq, count,
-                                          "txfeehistory", "ledgerseq");
+    uint64_t rows = 0;
+    rows += DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                  "txhistory", "ledgerseq");
+    rows += DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                  "txsethistory", "ledgerseq");
+    rows += DatabaseUtils::deleteOldEntriesHelper(sess, ledgerSeq, count,
+                                                  "txfeehistory", "ledgerseq");
+    return rows;
 }
 
 void
@@ -14,16 +14,44 @@ namespace stellar
 class Application;
 class XDROutputFileStream;
 
-void storeTransaction(Database& db, uint32_t ledgerSeq,
-                      TransactionFrameBasePtr const& tx,
-                      TransactionMeta const& tm,
-                      TransactionResultSet const& resultSet, Config const& cfg);
+// The txhistory and txfeehistory rows of a ledger, gathered while its
+// transactions apply and then stored with a single statement per table. On
+// postgres every statement is a round trip to the server, which with a
+// statement per transaction dominated the time to store them.
+class TransactionHistoryRows
+{
+    std::vector<std::string> mTxIDs;
+    std::vector<int32_t> mTxIndexes;
+    std::vector<std::string> mTxBodies;
+    std::vector<std::string> mTxResults;
+    std::vector<std::string> mTxMetas;
 
-void storeTxSet(Database& db, uint32_t ledgerSeq, TxSetXDRFrame const& txSet);
+    std::vector<std::string> mFeeTxIDs;
+    std::vector<int32_t> mFeeTxIndexes;
+    std::vector<std::string> mFeeChanges;
+
+  public:
+    void addTransaction(TransactionFrameBasePtr const& tx,
+                        TransactionMeta const& tm,
+                        TransactionResultPair const& result, uint32_t txIndex,
+                        Config const& cfg);
+
+    void addTransactionFee(TransactionFrameBasePtr const& tx,
+                           LedgerEntryChanges const& changes,
+                           uint32_t txIndex);
 
-void storeTransactionFee(Database& db, uint32_t ledgerSeq,
-                         TransactionFrameBasePtr const& tx,
-                         LedgerEntryChanges const& changes, uint32_t txIndex);
+    // Insert the rows gathered, then forget them
+    void store(Database& db, uint32_t ledgerSeq, Config const& cfg);
+    // Same, through `sess` instead of the main session, from any thread
+    void store(Database& db, soci::session& sess, uint32_t ledgerSeq,
+               Config const& cfg);
+
+  private:
+    void insert(Database& db, soci::session* sess, uint32_t ledgerSeq,
+                Config const& cfg);
+};
+
+void storeTxSet(Database& db, uint32_t ledgerSeq, TxSetXDRFrame const& txSet);
 
 TransactionResultSet getTransactionHistoryResults(Database& db,
                                                   uint32 ledgerSeq);
@@ -40,8 +68,8 @@ void createTxSetHistoryTable(Database& db);
 
 void dropTransactionHistory(Database& db, Config const& cfg);
 
-void deleteOldTransactionHistoryEntries(Database& db, uint32_t ledgerSeq,
-                                        uint32_t count);
+uint64_t deleteOldTransactionHistoryEntries(soci::session& sess,
+                                            uint32_t ledgerSeq, uint32_t count);
 
 void deleteNewerTransactionHistoryEntries(Database& db, uint32_t ledgerSeq);
 }
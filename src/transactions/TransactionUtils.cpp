@@ -9,15 +9,25 @@
 #include "ledger/LedgerTxn.h"
 #include "ledger/LedgerTxnEntry.h"
 #include "ledger/LedgerTxnHeader.h"
+#include "ledger/LedgerTypeUtils.h"
 #include "ledger/TrustLineWrapper.h"
+#include "main/Application.h"
+#include "medida/meter.h"
+#include "transactions/FeeBumpTransactionFrame.h"
 #include "transactions/OfferExchange.h"
+#include "transactions/SignatureUtils.h"
 #include "transactions/SponsorshipUtils.h"
+#include "transactions/TransactionFrameBase.h"
 #include "util/ProtocolVersion.h"
+#include "util/UnorderedSet.h"
 #include "util/XDROperators.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdr/Stellar-contract.h"
 #include "xdr/Stellar-ledger-entries.h"
-#include <Tracy.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 namespace stellar
 {
@@ -479,9 +489,10 @@ acquireOrReleaseLiabilities(AbstractLedgerTxn& ltx,
         return trust;
     };
 
+    auto offerLiabilities = getOfferLiabilities(header, offerEntry.current());
+
     int64_t buyingLiabilities =
-        isAcquire ? getOfferBuyingLiabilities(header, offerEntry)
-                  : -getOfferBuyingLiabilities(header, offerEntry);
+        isAcquire ? offerLiabilities.buying : -offerLiabilities.buying;
     if (offer.buying.type() == ASSET_TYPE_NATIVE)
     {
         auto account = loadAccountAndValidate();
@@ -500,8 +511,7 @@ acquireOrReleaseLiabilities(AbstractLedgerTxn& ltx,
     }
 
     int64_t sellingLiabilities =
-        isAcquire ? getOfferSellingLiabilities(header, offerEntry)
-                  : -getOfferSellingLiabilities(header, offerEntry);
+        isAcquire ? offerLiabilities.selling : -offerLiabilities.selling;
     if (offer.selling.type() == ASSET_TYPE_NATIVE)
     {
         auto account = loadAccountAndValidate();
@@ -902,6 +912,25 @@ getMinimumLimit(LedgerTxnHeader const& header, ConstLedgerTxnEntry const& entry)
     return getMinimumLimit(header, entry.current());
 }
 
+Liabilities
+getOfferLiabilities(LedgerTxnHeader const& header, LedgerEntry const& entry)
+{
+    if (protocolVersionIsBefore(header.current().ledgerVersion,
+                                ProtocolVersion::V_10))
+    {
+        throw std::runtime_error(
+            "Offer liabilities calculated before version 10");
+    }
+    auto const& oe = entry.data.offer();
+    auto res = exchangeV10WithoutPriceErrorThresholds(
+        oe.price, oe.amount, INT64_MAX, INT64_MAX, INT64_MAX,
+        RoundingType::NORMAL);
+    Liabilities liabilities;
+    liabilities.buying = res.numSheepSend;
+    liabilities.selling = res.numWheatReceived;
+    return liabilities;
+}
+
 int64_t
 getOfferBuyingLiabilities(LedgerTxnHeader const& header,
                           LedgerEntry const& entry)
@@ -1328,6 +1357,9 @@ removeOffersByAccountAndAsset(AbstractLedgerTxn& ltx, AccountID const& account,
 
     auto header = ltxInner.loadHeader();
     auto offers = ltxInner.loadOffersByAccountAndAsset(account, asset);
+    // Sponsors are never the seller, which releaseLiabilities loads, so they
+    // can stay loaded across offers
+    SponsoringAccountCache sponsoringAccounts(ltxInner);
     for (auto& offer : offers)
     {
         auto const& oe = offer.current().data.offer();
@@ -1344,7 +1376,7 @@ removeOffersByAccountAndAsset(AbstractLedgerTxn& ltx, AccountID const& account,
         releaseLiabilities(ltxInner, header, offer);
         auto trustAcc = stellar::loadAccount(ltxInner, account);
         removeEntryWithPossibleSponsorship(ltxInner, header, offer.current(),
-                                           trustAcc);
+                                           trustAcc, &sponsoringAccounts);
         offer.erase();
     }
     ltxInner.commit();
@@ -1831,6 +1863,176 @@ getMinInclusionFee(TransactionFrameBase const& tx, LedgerHeader const& header,
     return effectiveBaseFee * std::max<int64_t>(1, tx.getNumOperations());
 }
 
+static xdr::xvector<DecoratedSignature, 20> const&
+getEnvelopeSignatures(TransactionEnvelope const& env)
+{
+    switch (env.type())
+    {
+    case ENVELOPE_TYPE_TX_V0:
+        return env.v0().signatures;
+    case ENVELOPE_TYPE_TX:
+        return env.v1().signatures;
+    case ENVELOPE_TYPE_TX_FEE_BUMP:
+        return env.feeBump().signatures;
+    default:
+        abort();
+    }
+}
+
+void
+verifyMasterKeySignatures(Hash const& networkID, TransactionFrameBase const& tx)
+{
+    ZoneScoped;
+    auto const& env = tx.getEnvelope();
+    UnorderedSet<AccountID> sources;
+    if (env.type() == ENVELOPE_TYPE_TX_FEE_BUMP)
+    {
+        sources.emplace(tx.getFeeSourceID());
+    }
+    else
+    {
+        sources.emplace(tx.getSourceID());
+        for (auto const& op : tx.getRawOperations())
+        {
+            if (op.sourceAccount)
+            {
+                sources.emplace(toAccountID(*op.sourceAccount));
+            }
+        }
+    }
+
+    for (auto const& sig : getEnvelopeSignatures(env))
+    {
+        for (auto const& source : sources)
+        {
+            if (SignatureUtils::verify(sig, source, tx.getContentsHash()))
+            {
+                break;
+            }
+        }
+    }
+
+    if (env.type() == ENVELOPE_TYPE_TX_FEE_BUMP)
+    {
+        // The inner transaction of `tx` itself rather than a copy, so that
+        // its hashes are also computed here rather than when it's admitted
+        auto const& feeBump = static_cast<FeeBumpTransactionFrame const&>(tx);
+        feeBump.getInnerFullHash();
+        verifyMasterKeySignatures(networkID, feeBump.getInnerTx());
+    }
+}
+
+void
+verifySignaturesInParallel(
+    Application& app,
+    std::vector<std::shared_ptr<TransactionFrameBase>> const& txs,
+    size_t jobs)
+{
+    ZoneScoped;
+    // Below this many transactions per job, handing them to another thread
+    // costs about as much as it saves
+    size_t const minPerJob = 32;
+    jobs = std::min(jobs, txs.size() / minPerJob);
+    if (jobs == 0)
+    {
+        return;
+    }
+
+    // Ranges are claimed one at a time, by the background jobs and by this
+    // thread, so that all of them get verified even if the jobs don't start
+    // before this thread runs out of ranges. Jobs that start late find
+    // nothing left to do, which is why they share the state rather than
+    // refer to this frame.
+    struct State
+    {
+        Hash const mNetworkID;
+        std::vector<std::shared_ptr<TransactionFrameBase>> const mTxs;
+        size_t const mChunk;
+        size_t const mChunks;
+        std::atomic<size_t> mNext{0};
+        std::mutex mMutex;
+        std::condition_variable mDoneCV;
+        size_t mDone{0};
+        std::exception_ptr mError;
+
+        State(Hash const& networkID,
+              std::vector<std::shared_ptr<TransactionFrameBase>> const& txs,
+              size_t chunks)
+            : mNetworkID(networkID)
+            , mTxs(txs)
+            , mChunk((txs.size() + chunks - 1) / chunks)
+            , mChunks((txs.size() + mChunk - 1) / mChunk)
+        {
+        }
+
+        void
+        run()
+        {
+            for (size_t i = mNext++; i < mChunks; i = mNext++)
+            {
+                std::exception_ptr error;
+                try
+                {
+                    size_t end = std::min(mTxs.size(), (i + 1) * mChunk);
+                    for (size_t j = i * mChunk; j < end; ++j)
+                    {
+                        verifyMasterKeySignatures(mNetworkID, *mTxs[j]);
+                    }
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (error && !mError)
+                {
+                    mError = error;
+                }
+                if (++mDone == mChunks)
+                {
+                    mDoneCV.notify_all();
+                }
+            }
+        }
+    };
+
+    auto state = std::make_shared<State>(app.getNetworkID(), txs, jobs + 1);
+    for (size_t i = 0; i < jobs; ++i)
+    {
+        app.postOnBackgroundThread([state]() { state->run(); },
+                                   "verifySignaturesInParallel",
+                                   BackgroundTaskClass::VERIFY);
+    }
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mMutex);
+    state->mDoneCV.wait(lock,
+                        [&]() { return state->mDone == state->mChunks; });
+    if (state->mError)
+    {
+        std::rethrow_exception(state->mError);
+    }
+}
+
+void
+prefetchFootprintEntries(AbstractLedgerTxn& ltx,
+                         xdr::xvector<LedgerKey> const& keys,
+                         medida::Meter& prefetchMeter)
+{
+    ZoneScoped;
+    UnorderedSet<LedgerKey> toLoad;
+    toLoad.reserve(2 * keys.size());
+    for (auto const& lk : keys)
+    {
+        toLoad.emplace(lk);
+        if (isSorobanEntry(lk))
+        {
+            toLoad.emplace(getTTLKey(lk));
+        }
+    }
+    prefetchMeter.Mark(ltx.prefetch(toLoad));
+}
+
 bool
 validateContractLedgerEntry(LedgerKey const& lk, size_t entrySize,
                             SorobanNetworkConfig const& config,
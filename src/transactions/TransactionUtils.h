@@ -11,7 +11,14 @@
 #include "xdr/Stellar-transaction.h"
 
 #include <algorithm>
+#include <memory>
 #include <optional>
+#include <vector>
+
+namespace medida
+{
+class Meter;
+}
 
 namespace stellar
 {
@@ -196,6 +203,10 @@ int64_t getMinimumLimit(LedgerTxnHeader const& header,
 int64_t getMinimumLimit(LedgerTxnHeader const& header,
                         ConstLedgerTxnEntry const& entry);
 
+// Buying and selling liabilities of an offer, computed with a single exchange
+Liabilities getOfferLiabilities(LedgerTxnHeader const& header,
+                                LedgerEntry const& entry);
+
 int64_t getOfferBuyingLiabilities(LedgerTxnHeader const& header,
                                   LedgerEntry const& entry);
 int64_t getOfferBuyingLiabilities(LedgerTxnHeader const& header,
@@ -305,11 +316,40 @@ int64_t getMinInclusionFee(TransactionFrameBase const& tx,
                            LedgerHeader const& header,
                            std::optional<int64_t> baseFee = std::nullopt);
 
+// Verifies the signatures of `tx` that are meant for the master keys of its
+// source accounts (and of its inner transaction's, for a fee bump), which
+// populates the signature cache for when `tx` is validated or applied.
+// Signatures from other signers are left for the signature checker. Only
+// depends on `tx`, and caches its hashes, so it may be called off the main
+// thread while no other thread uses `tx`.
+void verifyMasterKeySignatures(Hash const& networkID,
+                               TransactionFrameBase const& tx);
+
+// Runs verifyMasterKeySignatures over `txs` on the calling thread and in up to
+// `jobs` jobs posted to the application's background threads, each taking
+// contiguous ranges of them, and returns once all are verified. Small batches
+// are verified later, when the transactions are validated, as handing them
+// over would cost about as much as it saves. No other thread may use `txs`
+// meanwhile.
+void verifySignaturesInParallel(
+    Application& app,
+    std::vector<std::shared_ptr<TransactionFrameBase>> const& txs,
+    size_t jobs);
+
 bool validateContractLedgerEntry(LedgerKey const& lk, size_t entrySize,
                                  SorobanNetworkConfig const& config,
                                  Config const& appConfig,
                                  TransactionFrame& parentTx);
 
+// Loads the entries of a Soroban footprint, along with their TTL entries,
+// into the cache of the root LedgerTxn in one bulk load, so that the per-key
+// loads an op makes while walking its footprint hit the cache instead of
+// doing one point load each. Marks the number of entries loaded on
+// `prefetchMeter`.
+void prefetchFootprintEntries(AbstractLedgerTxn& ltx,
+                              xdr::xvector<LedgerKey> const& keys,
+                              medida::Meter& prefetchMeter);
+
 struct LumenContractInfo
 {
     Hash mLumenContractID;
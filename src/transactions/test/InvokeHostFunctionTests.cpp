@@ -24,6 +24,7 @@
 #include "test/TestUtils.h"
 #include "test/TxTests.h"
 #include "transactions/InvokeHostFunctionOpFrame.h"
+#include "transactions/ParallelSorobanApply.h"
 #include "transactions/SignatureUtils.h"
 #include "transactions/TransactionUtils.h"
 #include "transactions/test/SorobanTxTestUtils.h"
@@ -1007,6 +1008,26 @@ TEST_CASE("Soroban non-refundable resource fees are stable", "[tx][soroban]")
                     app.getConfig());
         REQUIRE(expectedNonRefundableFee == actualFeePair.non_refundable_fee);
 
+        // The batch computation caches the same fee
+        auto batchTx =
+            makeTx(resources, minInclusionFee, expectedNonRefundableFee);
+        auto ledgerVersion = app.getLedgerManager()
+                                 .getLastClosedLedgerHeader()
+                                 .header.ledgerVersion;
+        TransactionFrame::precomputePreApplySorobanResourceFees(
+            {batchTx, makeTx(resources, minInclusionFee, 1'000'000'000)},
+            ledgerVersion, app.getLedgerManager().getSorobanNetworkConfig(),
+            app.getConfig());
+        auto batchFeePair =
+            std::dynamic_pointer_cast<TransactionFrame>(batchTx)
+                ->computePreApplySorobanResourceFee(
+                    ledgerVersion,
+                    app.getLedgerManager().getSorobanNetworkConfig(),
+                    app.getConfig());
+        REQUIRE(batchFeePair.non_refundable_fee ==
+                actualFeePair.non_refundable_fee);
+        REQUIRE(batchFeePair.refundable_fee == actualFeePair.refundable_fee);
+
         REQUIRE(test.isTxValid(validTx));
 
         // Check that just below minimum resource fee fails
@@ -4296,4 +4317,123 @@ TEST_CASE("Vm instantiation tightening", "[tx][soroban]")
         REQUIRE(inputs.nExports == 14);
         REQUIRE(inputs.nDataSegmentBytes == 0);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("parallel soroban apply", "[tx][soroban]")
+{
+    struct Applied
+    {
+        TransactionResultSet results;
+        std::vector<LedgerEntry> entries;
+        int64_t reused{0};
+        int64_t reinvoked{0};
+    };
+
+    // Sets up the same accounts and contracts with `threads` workers, then
+    // closes one ledger of Soroban transactions and returns its results and
+    // the entries the transactions may have written
+    auto apply = [](uint32_t threads) {
+        auto cfg = getTestConfig();
+        cfg.EXPERIMENTAL_PARALLEL_SOROBAN_APPLY_THREADS = threads;
+        SorobanTest test(cfg);
+        auto& app = test.getApp();
+        ContractStorageTestClient client(test);
+        TestContract& addContract =
+            test.deployWasmContract(rust_bridge::get_test_wasm_add_i32());
+
+        auto startingBalance = app.getLedgerManager().getLastMinBalance(50);
+        auto a1 = test.getRoot().create("A", startingBalance);
+        auto a2 = test.getRoot().create("B", startingBalance);
+        auto a3 = test.getRoot().create("C", startingBalance);
+        auto a4 = test.getRoot().create("D", startingBalance);
+
+        auto putTx = [&](TestAccount& source, std::string const& key,
+                         uint64_t val) {
+            return client.getContract()
+                .prepareInvocation(
+                    "put_persistent", {makeSymbolSCVal(key), makeU64SCVal(val)},
+                    client.writeKeySpec(key,
+                                        ContractDataDurability::PERSISTENT))
+                .withExactNonRefundableResourceFee()
+                .createTx(&source);
+        };
+        auto addTx = [&](TestAccount& source) {
+            return addContract
+                .prepareInvocation("add", {makeI32(7), makeI32(16)},
+                                   SorobanInvocationSpec()
+                                       .setInstructions(2'000'000)
+                                       .setReadBytes(2000))
+                .withExactNonRefundableResourceFee()
+                .createTx(&source);
+        };
+
+        // The second write of key1 depends on the first, and writing key2 may
+        // extend the TTL of the same contract instance. The add contract
+        // shares nothing with the storage one.
+        std::vector<TransactionFrameBasePtr> txs = {
+            putTx(a1, "key1", 1), addTx(a2), putTx(a3, "key1", 2),
+            putTx(a4, "key2", 3)};
+        REQUIRE(ParallelSorobanApply::clusterByFootprint(txs) ==
+                std::vector<std::vector<size_t>>{{0, 2, 3}, {1}});
+
+        auto& reused = app.getMetrics().NewMeter(
+            {"ledger", "soroban-parallel", "reused"}, "invocation");
+        auto& reinvoked = app.getMetrics().NewMeter(
+            {"ledger", "soroban-parallel", "reinvoked"}, "invocation");
+        auto reusedBefore = reused.count();
+        auto reinvokedBefore = reinvoked.count();
+
+        Applied res;
+        res.results = closeLedger(app, txs);
+        for (size_t i = 0; i < txs.size(); ++i)
+        {
+            checkTx(static_cast<int>(i), res.results, txSUCCESS);
+        }
+        REQUIRE(app.getLedgerManager().getParallelSorobanApply() == nullptr);
+        res.reused = reused.count() - reusedBefore;
+        res.reinvoked = reinvoked.count() - reinvokedBefore;
+
+        REQUIRE(client.get("key1", ContractDataDurability::PERSISTENT, 2) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+        REQUIRE(client.get("key2", ContractDataDurability::PERSISTENT, 3) ==
+                INVOKE_HOST_FUNCTION_SUCCESS);
+
+        LedgerTxn ltx(app.getLedgerTxnRoot());
+        auto addEntry = [&](LedgerKey const& lk) {
+            auto ltxe = ltx.loadWithoutRecord(lk);
+            REQUIRE(ltxe);
+            res.entries.emplace_back(ltxe.current());
+        };
+        for (auto const& tx : txs)
+        {
+            addEntry(accountKey(tx->getSourceID()));
+            auto const& footprint = tx->sorobanResources().footprint;
+            for (auto const* keys :
+                 {&footprint.readOnly, &footprint.readWrite})
+            {
+                for (auto const& lk : *keys)
+                {
+                    addEntry(lk);
+                    if (isSorobanEntry(lk))
+                    {
+                        addEntry(getTTLKey(lk));
+                    }
+                }
+            }
+        }
+        return res;
+    };
+
+    auto serial = apply(0);
+    REQUIRE(serial.reused == 0);
+    REQUIRE(serial.reinvoked == 0);
+
+    auto parallel = apply(2);
+    // Workers start on both clusters as soon as the Soroban phase begins,
+    // and apply only gets to the add transaction once the first write of
+    // key1 is applied, so at least the add invocation is reused
+    REQUIRE(parallel.reused > 0);
+    REQUIRE(parallel.reused + parallel.reinvoked <= 4);
+    REQUIRE(parallel.results == serial.results);
+    REQUIRE(parallel.entries == serial.entries);
+}
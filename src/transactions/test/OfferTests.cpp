@@ -12,6 +12,7 @@
 #include "lib/util/uint128_t.h"
 #include "main/Application.h"
 #include "main/Config.h"
+#include "test/MicroBenchmark.h"
 #include "test/TestAccount.h"
 #include "test/TestExceptions.h"
 #include "test/TestMarket.h"
@@ -4088,3 +4089,47 @@ TEST_CASE_VERSIONS("liabilities match created offer", "[tx][offers]")
     // NOTE: Starting in version 10, it is not possible to create an offer that
     // initially exceeds limits.
 }
+
+TEST_CASE("offer crossing microbench", "[offer][microbench][bench][!hide]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    auto minBalance = app->getLedgerManager().getLastMinBalance(2) +
+                      20 * app->getLedgerManager().getLastTxFee();
+
+    auto issuer = root.create("issuer", minBalance * 10);
+    auto xlm = makeNativeAsset();
+    auto usd = issuer.asset("USD");
+
+    // Each seller has an offer a bit more expensive than the previous one
+    size_t const numOffers = 100;
+    int64_t const offerAmount = 1000;
+    for (size_t i = 0; i < numOffers; ++i)
+    {
+        auto seller = root.create("seller " + std::to_string(i), minBalance);
+        seller.changeTrust(usd, offerAmount);
+        issuer.pay(seller, usd, offerAmount);
+        seller.manageOffer(0, usd, xlm,
+                           Price{static_cast<int32_t>(100 + i), 100},
+                           offerAmount);
+    }
+
+    // Buys the whole order book, which is restored by rolling back
+    runMicroBenchmark("offer.crossing", [&]() {
+        LedgerTxn ltx(app->getLedgerTxnRoot());
+        int64_t sheepSend = 0;
+        int64_t wheatReceived = 0;
+        std::vector<ClaimAtom> offerTrail;
+        auto res = convertWithOffersAndPools(
+            ltx, xlm, INT64_MAX, sheepSend, usd, numOffers * offerAmount,
+            wheatReceived, RoundingType::NORMAL,
+            [](LedgerTxnEntry const&) { return OfferFilterResult::eKeep; },
+            offerTrail, INT64_MAX);
+        if (res != ConvertResult::eOK || offerTrail.size() != numOffers)
+        {
+            throw std::runtime_error("order book not crossed");
+        }
+        return offerTrail.size();
+    });
+}
@@ -8,6 +8,8 @@
 #include "crypto/SignerKey.h"
 #include "crypto/SignerKeyUtils.h"
 #include "lib/catch.hpp"
+#include "transactions/SignatureChecker.h"
+#include "util/ProtocolVersion.h"
 #include "xdr/Stellar-transaction.h"
 
 using namespace stellar;
@@ -46,3 +48,65 @@ TEST_CASE("Hash(x) signature", "[signature]")
         REQUIRE_THROWS_AS(SignatureUtils::signHashX(s), xdr::xdr_overflow);
     }
 }
+
+TEST_CASE("signature checker matches signatures across checks",
+          "[signature]")
+{
+    auto hash = sha256(std::string{"CONTENTS"});
+    std::vector<SecretKey> keys;
+    for (auto i = 0; i < 4; i++)
+    {
+        keys.emplace_back(SecretKey::fromSeed(
+            sha256(std::string{"SIGNER_SEED_"} + std::to_string(i))));
+    }
+    auto signer = [&](size_t i) {
+        return Signer{KeyUtils::convertKey<SignerKey>(keys[i].getPublicKey()),
+                      1};
+    };
+
+    xdr::xvector<DecoratedSignature, 20> signatures;
+    signatures.emplace_back(SignatureUtils::sign(keys[0], hash));
+    signatures.emplace_back(SignatureUtils::sign(keys[1], hash));
+    signatures.emplace_back(SignatureUtils::signHashX(std::string{"X"}));
+    // Has the hint of keys[2] but signs something else
+    signatures.emplace_back(
+        SignatureUtils::sign(keys[2], sha256(std::string{"OTHER"})));
+
+    SignatureChecker checker(static_cast<uint32_t>(ProtocolVersion::V_19),
+                             hash, signatures);
+    std::vector<Signer> signers{signer(3), signer(1), signer(2), signer(0)};
+    // Every check sees the same outcomes as the first one
+    for (auto i = 0; i < 3; i++)
+    {
+        REQUIRE(checker.checkSignature(signers, 2));
+        REQUIRE(!checker.checkSignature(signers, 3));
+        REQUIRE(!checker.checkSignature({signer(2), signer(3)}, 1));
+    }
+    REQUIRE(!checker.checkAllSignaturesUsed());
+
+    signers.emplace_back(Signer{SignerKeyUtils::hashXKey(std::string{"X"}), 1});
+    REQUIRE(checker.checkSignature(signers, 3));
+    REQUIRE(!checker.checkSignature(signers, 4));
+    REQUIRE(!checker.checkAllSignaturesUsed());
+}
+
+TEST_CASE("trusted signature checker accepts any signatures", "[signature]")
+{
+    auto hash = sha256(std::string{"CONTENTS"});
+    auto key = SecretKey::fromSeed(sha256(std::string{"SIGNER_SEED"}));
+    Signer signer{KeyUtils::convertKey<SignerKey>(key.getPublicKey()), 1};
+
+    xdr::xvector<DecoratedSignature, 20> signatures;
+    signatures.emplace_back(
+        SignatureUtils::sign(key, sha256(std::string{"OTHER"})));
+
+    SignatureChecker checker(static_cast<uint32_t>(ProtocolVersion::V_19),
+                             hash, signatures);
+    REQUIRE(!checker.checkSignature({signer}, 1));
+
+    SignatureChecker trusted(static_cast<uint32_t>(ProtocolVersion::V_19),
+                             hash, signatures, true);
+    REQUIRE(trusted.checkSignature({signer}, 1));
+    REQUIRE(trusted.checkSignature({}, 1));
+    REQUIRE(trusted.checkAllSignaturesUsed());
+}
@@ -2833,3 +2833,80 @@ TEST_CASE("soroban transaction validation", "[tx][envelope][soroban]")
         }
     }
 }
+
+TEST_CASE("checkValid reuses results only for unchanged state",
+          "[tx][envelope]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    int64_t const paymentAmount = app->getLedgerManager().getLastReserve() * 10;
+    auto a1 = root.create("a1", paymentAmount);
+
+    auto tx = a1.tx({payment(root, 1)});
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    REQUIRE(tx->getResultCode() == txSUCCESS);
+
+    SECTION("account changes")
+    {
+        {
+            auto acc = stellar::loadAccount(ltx, a1.getPublicKey());
+            acc.current().data.account().thresholds[THRESHOLD_LOW] = 2;
+        }
+        REQUIRE(!tx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_AUTH);
+    }
+    SECTION("current sequence number changes")
+    {
+        REQUIRE(!tx->checkValid(*app, ltx, tx->getSeqNum(), 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_SEQ);
+    }
+    SECTION("envelope changes")
+    {
+        getSignatures(tx).clear();
+        REQUIRE(!tx->checkValid(*app, ltx, 0, 0, 0));
+        REQUIRE(tx->getResultCode() == txBAD_AUTH);
+    }
+    SECTION("close time offset makes the transaction too late")
+    {
+        auto closeTime = ltx.loadHeader().current().scpValue.closeTime;
+        auto boundedTx = a1.tx({payment(root, 1)}, tx->getSeqNum());
+        setMaxTime(boundedTx, closeTime + 10);
+        getSignatures(boundedTx).clear();
+        boundedTx->clearCached();
+        boundedTx->addSignature(a1);
+
+        REQUIRE(boundedTx->checkValid(*app, ltx, 0, 0, 5));
+        REQUIRE(boundedTx->checkValid(*app, ltx, 0, 0, 5));
+        REQUIRE(!boundedTx->checkValid(*app, ltx, 0, 0, 20));
+        REQUIRE(boundedTx->getResultCode() == txTOO_LATE);
+    }
+}
+
+TEST_CASE("checkValid reuses Soroban results until the network config changes",
+          "[tx][envelope][soroban]")
+{
+    VirtualClock clock;
+    auto app = createTestApplication(clock, getTestConfig());
+    auto root = TestAccount::createRoot(*app);
+    Operation op;
+    op.body.type(INVOKE_HOST_FUNCTION);
+    op.body.invokeHostFunctionOp().hostFunction.type(
+        HOST_FUNCTION_TYPE_CREATE_CONTRACT);
+
+    SorobanResources resources;
+    resources.instructions = 1'000'000;
+    auto tx = sorobanTransactionFrameFromOps(
+        app->getNetworkID(), root, {op}, {}, resources, 100, 3'500'000);
+    LedgerTxn ltx(app->getLedgerTxnRoot());
+    REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    REQUIRE(tx->checkValid(*app, ltx, 0, 0, 0));
+    REQUIRE(tx->getResultCode() == txSUCCESS);
+
+    auto& cfg = app->getLedgerManager().getMutableSorobanNetworkConfig();
+    cfg.mTxMaxInstructions = resources.instructions - 1;
+    REQUIRE(!tx->checkValid(*app, ltx, 0, 0, 0));
+    REQUIRE(tx->getResultCode() == txSOROBAN_INVALID);
+}
@@ -0,0 +1,82 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/Arena.h"
+#include "util/GlobalChecks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace stellar
+{
+
+namespace
+{
+// Only updated when an arena is destroyed, so allocating stays free of
+// atomic operations.
+std::atomic<uint64_t> gTotalAllocations{0};
+std::atomic<uint64_t> gTotalBytesAllocated{0};
+std::atomic<uint64_t> gTotalBlocks{0};
+std::atomic<uint64_t> gTotalBytesReserved{0};
+}
+
+Arena::Arena(size_t blockSize) : mBlockSize(blockSize)
+{
+    releaseAssert(blockSize > 0);
+}
+
+Arena::~Arena()
+{
+    gTotalAllocations += mStats.allocations;
+    gTotalBytesAllocated += mStats.bytesAllocated;
+    gTotalBlocks += mStats.blocks;
+    gTotalBytesReserved += mStats.bytesReserved;
+}
+
+void*
+Arena::allocate(size_t bytes, size_t alignment)
+{
+    releaseAssert(alignment <= alignof(std::max_align_t));
+    releaseAssert((alignment & (alignment - 1)) == 0);
+
+    void* p = mCurrent;
+    size_t space = mRemaining;
+    if (!p || !std::align(alignment, bytes, p, space))
+    {
+        // Oversized requests get a block of their own so they don't waste
+        // the remainder of the current block.
+        size_t blockSize = std::max(bytes, mBlockSize);
+        mBlocks.emplace_back(new unsigned char[blockSize]);
+        ++mStats.blocks;
+        mStats.bytesReserved += blockSize;
+        if (blockSize > mBlockSize)
+        {
+            ++mStats.allocations;
+            mStats.bytesAllocated += bytes;
+            return mBlocks.back().get();
+        }
+
+        p = mBlocks.back().get();
+        space = blockSize;
+    }
+
+    mCurrent = static_cast<unsigned char*>(p) + bytes;
+    mRemaining = space - bytes;
+    ++mStats.allocations;
+    mStats.bytesAllocated += bytes;
+    return p;
+}
+
+Arena::Stats
+Arena::getTotalStats()
+{
+    Stats stats;
+    stats.allocations = gTotalAllocations;
+    stats.bytesAllocated = gTotalBytesAllocated;
+    stats.blocks = gTotalBlocks;
+    stats.bytesReserved = gTotalBytesReserved;
+    return stats;
+}
+}
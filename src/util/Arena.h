@@ -0,0 +1,127 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace stellar
+{
+
+// Monotonic arena. Allocation bumps a pointer into the current block and
+// deallocation is a no-op; all memory is released at once when the arena is
+// destroyed. This suits short-lived groups of small objects that die
+// together, such as the entries of a ledger's LedgerTxn stack.
+//
+// An Arena is not thread-safe: all allocations must come from one thread at a
+// time. Destruction may happen on any thread.
+class Arena : public NonMovableOrCopyable
+{
+  public:
+    struct Stats
+    {
+        uint64_t allocations{0};
+        uint64_t bytesAllocated{0};
+        uint64_t blocks{0};
+        uint64_t bytesReserved{0};
+    };
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena();
+
+    // alignment must be a power of two no greater than
+    // alignof(std::max_align_t). Throws std::bad_alloc on failure.
+    void* allocate(size_t bytes, size_t alignment);
+
+    Stats const&
+    getStats() const
+    {
+        return mStats;
+    }
+
+    // Totals over all arenas destroyed so far in this process.
+    static Stats getTotalStats();
+
+  private:
+    size_t const mBlockSize;
+    std::vector<std::unique_ptr<unsigned char[]>> mBlocks;
+    unsigned char* mCurrent{nullptr};
+    size_t mRemaining{0};
+    Stats mStats;
+};
+
+// Standard allocator backed by a shared Arena. Every object allocated through
+// it keeps the arena alive, so objects may safely outlive whatever created the
+// arena. An allocator without an arena uses the global heap.
+template <typename T> class ArenaAllocator
+{
+    std::shared_ptr<Arena> mArena;
+
+  public:
+    using value_type = T;
+
+    explicit ArenaAllocator(std::shared_ptr<Arena> arena) noexcept
+        : mArena(std::move(arena))
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator(ArenaAllocator<U> const& other) noexcept
+        : mArena(other.getArena())
+    {
+    }
+
+    T*
+    allocate(size_t n)
+    {
+        if (!mArena)
+        {
+            return std::allocator<T>().allocate(n);
+        }
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(mArena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void
+    deallocate(T* p, size_t n) noexcept
+    {
+        if (!mArena)
+        {
+            std::allocator<T>().deallocate(p, n);
+        }
+    }
+
+    std::shared_ptr<Arena> const&
+    getArena() const noexcept
+    {
+        return mArena;
+    }
+};
+
+template <typename T, typename U>
+bool
+operator==(ArenaAllocator<T> const& lhs, ArenaAllocator<U> const& rhs) noexcept
+{
+    return lhs.getArena() == rhs.getArena();
+}
+
+template <typename T, typename U>
+bool
+operator!=(ArenaAllocator<T> const& lhs, ArenaAllocator<U> const& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
+}
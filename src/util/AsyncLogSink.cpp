@@ -0,0 +1,202 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/AsyncLogSink.h"
+
+#if defined(USE_SPDLOG)
+
+#include <chrono>
+#include <fmt/format.h>
+
+namespace stellar
+{
+
+namespace
+{
+std::chrono::milliseconds const IDLE_WAIT{1};
+
+size_t
+roundUpToPowerOfTwo(size_t n)
+{
+    size_t res = 2;
+    while (res < n)
+    {
+        res <<= 1;
+    }
+    return res;
+}
+}
+
+AsyncLogSink::AsyncLogSink(
+    std::vector<std::shared_ptr<spdlog::sinks::sink>> sinks, size_t capacity)
+    : mSinks(std::move(sinks))
+    , mSlots(std::make_unique<Slot[]>(roundUpToPowerOfTwo(capacity)))
+    , mMask(roundUpToPowerOfTwo(capacity) - 1)
+{
+    for (size_t i = 0; i <= mMask; ++i)
+    {
+        mSlots[i].mSeq.store(i, std::memory_order_relaxed);
+    }
+    mThread = std::thread([this]() { run(); });
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    stop();
+}
+
+void
+AsyncLogSink::stop()
+{
+    if (!mStopping.exchange(true))
+    {
+        mThread.join();
+        mStopped.store(true, std::memory_order_release);
+    }
+}
+
+void
+AsyncLogSink::writeToSinks(spdlog::details::log_msg const& msg)
+{
+    for (auto const& sink : mSinks)
+    {
+        if (sink->should_log(msg.level))
+        {
+            sink->log(msg);
+        }
+    }
+}
+
+void
+AsyncLogSink::log(spdlog::details::log_msg const& msg)
+{
+    if (mStopped.load(std::memory_order_acquire))
+    {
+        writeToSinks(msg);
+        return;
+    }
+
+    // Bounded multi-producer queue: each slot's sequence number says whether
+    // it is free for the producer claiming position `pos`, or still holds
+    // a message the background thread hasn't written
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true)
+    {
+        slot = &mSlots[pos & mMask];
+        size_t seq = slot->mSeq.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0)
+        {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    slot->mMsg = spdlog::details::log_msg_buffer(msg);
+    slot->mSeq.store(pos + 1, std::memory_order_release);
+}
+
+bool
+AsyncLogSink::writeNext()
+{
+    size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+    auto& slot = mSlots[pos & mMask];
+    if (slot.mSeq.load(std::memory_order_acquire) != pos + 1)
+    {
+        return false;
+    }
+    writeToSinks(slot.mMsg);
+    slot.mSeq.store(pos + mMask + 1, std::memory_order_release);
+    mDequeuePos.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+void
+AsyncLogSink::reportDropped()
+{
+    auto dropped = mDropped.load(std::memory_order_relaxed);
+    if (dropped == mReportedDropped)
+    {
+        return;
+    }
+    auto text = fmt::format(
+        FMT_STRING("Dropped {} log messages, async log queue was full"),
+        dropped - mReportedDropped);
+    mReportedDropped = dropped;
+    writeToSinks(
+        spdlog::details::log_msg("default", spdlog::level::warn, text));
+}
+
+void
+AsyncLogSink::run()
+{
+    while (true)
+    {
+        bool wrote = false;
+        while (writeNext())
+        {
+            wrote = true;
+        }
+        reportDropped();
+        if (mStopping.load(std::memory_order_acquire))
+        {
+            while (writeNext())
+            {
+            }
+            break;
+        }
+        if (!wrote)
+        {
+            std::this_thread::sleep_for(IDLE_WAIT);
+        }
+    }
+}
+
+void
+AsyncLogSink::flush()
+{
+    size_t target = mEnqueuePos.load(std::memory_order_acquire);
+    while (!mStopped.load(std::memory_order_acquire) &&
+           mDequeuePos.load(std::memory_order_acquire) < target)
+    {
+        std::this_thread::sleep_for(IDLE_WAIT);
+    }
+    for (auto const& sink : mSinks)
+    {
+        sink->flush();
+    }
+}
+
+void
+AsyncLogSink::set_pattern(std::string const& pattern)
+{
+    for (auto const& sink : mSinks)
+    {
+        sink->set_pattern(pattern);
+    }
+}
+
+void
+AsyncLogSink::set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter)
+{
+    for (auto const& sink : mSinks)
+    {
+        sink->set_formatter(sinkFormatter->clone());
+    }
+}
+}
+
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#if defined(USE_SPDLOG)
+
+// Must include this _before_ spdlog.h
+#include "util/SpdlogTweaks.h"
+
+#include "util/NonCopyable.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <spdlog/details/log_msg_buffer.h>
+#include <spdlog/sinks/sink.h>
+#include <thread>
+#include <vector>
+
+namespace stellar
+{
+
+// A sink handing messages over to a background thread, which formats them
+// with the sinks' patterns and writes them to those sinks. Loggers writing
+// to it only format the message itself and copy it into a bounded
+// lock-free queue; when the queue is full the message is dropped and
+// counted rather than have the logging thread wait, and the background
+// thread reports the drops as they happen.
+//
+// flush() waits for everything logged before it to be written, so that
+// flushing on errors keeps its meaning.
+class AsyncLogSink : public spdlog::sinks::sink, NonMovableOrCopyable
+{
+    struct Slot
+    {
+        std::atomic<size_t> mSeq;
+        spdlog::details::log_msg_buffer mMsg;
+    };
+
+    std::vector<std::shared_ptr<spdlog::sinks::sink>> const mSinks;
+    std::unique_ptr<Slot[]> mSlots;
+    size_t const mMask;
+    std::atomic<size_t> mEnqueuePos{0};
+    std::atomic<size_t> mDequeuePos{0};
+    std::atomic<uint64_t> mDropped{0};
+    uint64_t mReportedDropped{0};
+    std::atomic<bool> mStopping{false};
+    std::atomic<bool> mStopped{false};
+    std::thread mThread;
+
+    void writeToSinks(spdlog::details::log_msg const& msg);
+    bool writeNext();
+    void reportDropped();
+    void run();
+
+  public:
+    // capacity is rounded up to a power of two
+    AsyncLogSink(std::vector<std::shared_ptr<spdlog::sinks::sink>> sinks,
+                 size_t capacity);
+    ~AsyncLogSink() override;
+
+    void log(spdlog::details::log_msg const& msg) override;
+    void flush() override;
+    void set_pattern(std::string const& pattern) override;
+    void
+    set_formatter(std::unique_ptr<spdlog::formatter> sinkFormatter) override;
+
+    // Writes out what is queued and stops the background thread; messages
+    // logged afterwards are written synchronously
+    void stop();
+
+    uint64_t
+    getDroppedCount() const
+    {
+        return mDropped.load(std::memory_order_relaxed);
+    }
+};
+}
+
+#endif
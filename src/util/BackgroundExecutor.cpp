@@ -0,0 +1,175 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BackgroundExecutor.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+#include "medida/timer.h"
+
+namespace stellar
+{
+
+namespace
+{
+std::vector<BackgroundTaskClass> const ALL_CLASSES = {
+    BackgroundTaskClass::QUERY,   BackgroundTaskClass::PREFETCH,
+    BackgroundTaskClass::GENERAL, BackgroundTaskClass::MERGE,
+    BackgroundTaskClass::INDEX,   BackgroundTaskClass::VERIFY};
+}
+
+std::string
+backgroundTaskClassName(BackgroundTaskClass cls)
+{
+    switch (cls)
+    {
+    case BackgroundTaskClass::QUERY:
+        return "query";
+    case BackgroundTaskClass::PREFETCH:
+        return "prefetch";
+    case BackgroundTaskClass::GENERAL:
+        return "general";
+    case BackgroundTaskClass::MERGE:
+        return "merge";
+    case BackgroundTaskClass::INDEX:
+        return "index";
+    case BackgroundTaskClass::VERIFY:
+        return "verify";
+    }
+    releaseAssert(false);
+}
+
+std::optional<BackgroundTaskClass>
+backgroundTaskClassFromName(std::string const& name)
+{
+    for (auto cls : ALL_CLASSES)
+    {
+        if (backgroundTaskClassName(cls) == name)
+        {
+            return cls;
+        }
+    }
+    return std::nullopt;
+}
+
+BackgroundExecutor::BackgroundExecutor(
+    asio::io_context& ctx, size_t maxRunning, medida::MetricsRegistry& metrics,
+    std::map<BackgroundTaskClass, size_t> const& limits)
+    : mCtx(ctx), mMaxRunning(maxRunning)
+{
+    releaseAssert(maxRunning > 0);
+    mClasses.reserve(ALL_CLASSES.size());
+    for (auto cls : ALL_CLASSES)
+    {
+        // The order of the enum is that of ALL_CLASSES
+        releaseAssert(static_cast<size_t>(cls) == mClasses.size());
+        auto name = backgroundTaskClassName(cls);
+        auto it = limits.find(cls);
+        mClasses.emplace_back(TaskClass{
+            {},
+            0,
+            it == limits.end() || it->second == 0 ? maxRunning : it->second,
+            metrics.NewCounter({"background", name, "queued"}),
+            metrics.NewCounter({"background", name, "running"}),
+            metrics.NewTimer({"background", name, "wait"}),
+            metrics.NewTimer({"background", name, "run"})});
+    }
+}
+
+void
+BackgroundExecutor::post(BackgroundTaskClass cls, Job&& job)
+{
+    bool startRunner = false;
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        auto& c = mClasses.at(static_cast<size_t>(cls));
+        c.mQueue.emplace_back(std::move(job), Clock::now());
+        c.mQueued.inc();
+        if (mRunners < mMaxRunning)
+        {
+            ++mRunners;
+            startRunner = true;
+        }
+    }
+    if (startRunner)
+    {
+        postRunner();
+    }
+}
+
+size_t
+BackgroundExecutor::queueSize(BackgroundTaskClass cls) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mClasses.at(static_cast<size_t>(cls)).mQueue.size();
+}
+
+size_t
+BackgroundExecutor::running(BackgroundTaskClass cls) const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mClasses.at(static_cast<size_t>(cls)).mRunning;
+}
+
+void
+BackgroundExecutor::postRunner()
+{
+    asio::post(mCtx, [this]() { runOne(); });
+}
+
+void
+BackgroundExecutor::runOne()
+{
+    ZoneScoped;
+    TaskClass* next = nullptr;
+    Job job;
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        for (auto& c : mClasses)
+        {
+            if (!c.mQueue.empty() && c.mRunning < c.mLimit)
+            {
+                next = &c;
+                break;
+            }
+        }
+        if (!next)
+        {
+            // Whatever is left waits for a job of its class to finish, the
+            // runner of that job takes it then
+            --mRunners;
+            return;
+        }
+        job = std::move(next->mQueue.front().first);
+        next->mWait.Update(Clock::now() - next->mQueue.front().second);
+        next->mQueue.pop_front();
+        next->mQueued.dec();
+        ++next->mRunning;
+        next->mRunningCount.inc();
+    }
+
+    // Release the slot and keep the runner going even if the job throws,
+    // otherwise the runner would be counted in mRunners forever
+    struct Done
+    {
+        BackgroundExecutor& mExecutor;
+        TaskClass& mClass;
+        Clock::time_point const mStart{Clock::now()};
+        ~Done()
+        {
+            mClass.mRun.Update(Clock::now() - mStart);
+            {
+                std::lock_guard<std::mutex> guard(mExecutor.mMutex);
+                --mClass.mRunning;
+                mClass.mRunningCount.dec();
+            }
+            mExecutor.postRunner();
+        }
+    };
+    Done done{*this, *next};
+    job();
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+#include "util/asio.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace medida
+{
+class Counter;
+class MetricsRegistry;
+class Timer;
+}
+
+namespace stellar
+{
+
+// The kinds of background jobs, in decreasing order of priority
+enum class BackgroundTaskClass
+{
+    QUERY,
+    PREFETCH,
+    GENERAL,
+    MERGE,
+    INDEX,
+    VERIFY
+};
+
+std::string backgroundTaskClassName(BackgroundTaskClass cls);
+std::optional<BackgroundTaskClass>
+backgroundTaskClassFromName(std::string const& name);
+
+// Schedules background jobs on the threads running an asio::io_context. Jobs
+// are queued by class and handed to the threads only as they become free:
+// a free thread takes the oldest job of the highest priority class that is
+// below its concurrency limit, so that a backlog of, say, verifications
+// doesn't delay the merges queued after it. Jobs already running are never
+// preempted.
+//
+// At most `maxRunning` jobs are handed to the io_context at once, which
+// should be the number of threads running it. Each job is posted to the
+// io_context on its own, so other handlers on it still get their turn.
+class BackgroundExecutor : public NonMovableOrCopyable
+{
+  public:
+    using Job = std::function<void()>;
+
+    // `limits` caps the number of jobs of a class running at once, classes
+    // missing from it are only limited by `maxRunning`
+    BackgroundExecutor(asio::io_context& ctx, size_t maxRunning,
+                       medida::MetricsRegistry& metrics,
+                       std::map<BackgroundTaskClass, size_t> const& limits);
+
+    void post(BackgroundTaskClass cls, Job&& job);
+
+    // Jobs of `cls` queued and not started yet
+    size_t queueSize(BackgroundTaskClass cls) const;
+    // Jobs of `cls` running
+    size_t running(BackgroundTaskClass cls) const;
+
+  private:
+    using Clock = std::chrono::steady_clock;
+
+    struct TaskClass
+    {
+        std::deque<std::pair<Job, Clock::time_point>> mQueue;
+        size_t mRunning{0};
+        size_t mLimit;
+        medida::Counter& mQueued;
+        medida::Counter& mRunningCount;
+        medida::Timer& mWait;
+        medida::Timer& mRun;
+    };
+
+    asio::io_context& mCtx;
+    size_t const mMaxRunning;
+    mutable std::mutex mMutex;
+    // Indexed by class
+    std::vector<TaskClass> mClasses;
+    // Runners posted to the io_context, each runs one job and posts itself
+    // again as long as there is a job it can start
+    size_t mRunners{0};
+
+    void postRunner();
+    void runOne();
+};
+}
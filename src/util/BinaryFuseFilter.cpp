@@ -0,0 +1,313 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/BinaryFuseFilter.h"
+#include "util/GlobalChecks.h"
+#include "util/ZoneProfiler.h"
+#include "util/siphash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace stellar
+{
+
+namespace
+{
+// Construction almost always succeeds on the first attempt; this bound only
+// guards against looping forever.
+constexpr int MAX_CONSTRUCTION_ATTEMPTS = 100;
+constexpr uint32_t MAX_SEGMENT_LENGTH = 262144;
+
+uint64_t
+murmur64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t
+splitmix64(uint64_t& state)
+{
+    uint64_t z = (state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+// High 64 bits of the 128-bit product a * b, without relying on a 128-bit
+// integer type.
+uint64_t
+mulhi(uint64_t a, uint64_t b)
+{
+    uint64_t aLo = a & 0xffffffff;
+    uint64_t aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffff;
+    uint64_t bHi = b >> 32;
+
+    uint64_t lolo = aLo * bLo;
+    uint64_t hilo = aHi * bLo;
+    uint64_t lohi = aLo * bHi;
+    uint64_t hihi = aHi * bHi;
+
+    uint64_t cross = (lolo >> 32) + (hilo & 0xffffffff) + lohi;
+    return hihi + (hilo >> 32) + (cross >> 32);
+}
+}
+
+BinaryFuseFilter::BinaryFuseFilter(uint32_t fingerprintBits,
+                                   std::array<unsigned char, 16> const& hashKey)
+    : mFingerprintBits(fingerprintBits), mHashKey(hashKey)
+{
+    releaseAssert(fingerprintBits == 8 || fingerprintBits == 16);
+}
+
+uint64_t
+BinaryFuseFilter::hashBytes(unsigned char const* data, size_t len) const
+{
+    SipHash24 sh(mHashKey.data());
+    sh.update(data, len);
+    return sh.digest();
+}
+
+void
+BinaryFuseFilter::allocate(uint32_t size)
+{
+    // Parameters for 3-wise binary fuse filters, from the reference
+    // implementation. They are sensitive: they trade construction success
+    // probability against space overhead.
+    uint32_t segmentLength =
+        size == 0 ? 4
+                  : static_cast<uint32_t>(1)
+                        << static_cast<int>(std::floor(
+                               std::log(static_cast<double>(size)) /
+                                   std::log(3.33) +
+                               2.25));
+    mSegmentLength = std::min(segmentLength, MAX_SEGMENT_LENGTH);
+    mSegmentLengthMask = mSegmentLength - 1;
+
+    double sizeFactor =
+        size <= 1 ? 0
+                  : std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) /
+                                                std::log(static_cast<double>(
+                                                    size)));
+    auto capacity = static_cast<uint64_t>(
+        std::round(static_cast<double>(size) * sizeFactor));
+
+    int64_t segmentCount =
+        static_cast<int64_t>((capacity + mSegmentLength - 1) / mSegmentLength) -
+        2;
+    mSegmentCount = static_cast<uint32_t>(std::max<int64_t>(1, segmentCount));
+    uint64_t arrayLength =
+        (static_cast<uint64_t>(mSegmentCount) + 2) * mSegmentLength;
+    releaseAssert(arrayLength <= std::numeric_limits<uint32_t>::max());
+    mArrayLength = static_cast<uint32_t>(arrayLength);
+    mSegmentCountLength = mSegmentCount * mSegmentLength;
+    mFingerprints.assign(static_cast<size_t>(mArrayLength) *
+                             (mFingerprintBits / 8),
+                         0);
+}
+
+uint32_t
+BinaryFuseFilter::slot(uint32_t index, uint64_t hash) const
+{
+    // Each key maps to one position in each of three consecutive segments
+    uint64_t h = mulhi(hash, mSegmentCountLength);
+    h += static_cast<uint64_t>(index) * mSegmentLength;
+    uint64_t hh = hash & ((UINT64_C(1) << 36) - 1);
+    h ^= (hh >> (36 - 18 * index)) & mSegmentLengthMask;
+    return static_cast<uint32_t>(h);
+}
+
+uint32_t
+BinaryFuseFilter::fingerprint(uint64_t hash) const
+{
+    uint64_t f = hash ^ (hash >> 32);
+    return static_cast<uint32_t>(mFingerprintBits == 8 ? (f & 0xff)
+                                                       : (f & 0xffff));
+}
+
+uint32_t
+BinaryFuseFilter::getFingerprint(uint32_t i) const
+{
+    if (mFingerprintBits == 8)
+    {
+        return mFingerprints[i];
+    }
+    size_t off = static_cast<size_t>(i) * 2;
+    return static_cast<uint32_t>(mFingerprints[off]) |
+           (static_cast<uint32_t>(mFingerprints[off + 1]) << 8);
+}
+
+void
+BinaryFuseFilter::setFingerprint(uint32_t i, uint32_t v)
+{
+    if (mFingerprintBits == 8)
+    {
+        mFingerprints[i] = static_cast<uint8_t>(v);
+        return;
+    }
+    size_t off = static_cast<size_t>(i) * 2;
+    mFingerprints[off] = static_cast<uint8_t>(v & 0xff);
+    mFingerprints[off + 1] = static_cast<uint8_t>((v >> 8) & 0xff);
+}
+
+void
+BinaryFuseFilter::populate(std::vector<uint64_t>& keyHashes)
+{
+    ZoneScoped;
+    releaseAssert(mFingerprintBits == 8 || mFingerprintBits == 16);
+    releaseAssert(mFingerprints.empty());
+
+    // Peeling requires distinct keys. Since the per-attempt mixing below is a
+    // bijection, distinct key hashes stay distinct under every seed.
+    std::sort(keyHashes.begin(), keyHashes.end());
+    keyHashes.erase(std::unique(keyHashes.begin(), keyHashes.end()),
+                    keyHashes.end());
+    releaseAssert(keyHashes.size() <= std::numeric_limits<uint32_t>::max());
+    auto const size = static_cast<uint32_t>(keyHashes.size());
+
+    if (size == 0)
+    {
+        // Empty filter, containsHash always returns false
+        return;
+    }
+    allocate(size);
+
+    std::vector<uint64_t> reverseOrder(size);
+    std::vector<uint8_t> reverseH(size);
+    std::vector<uint32_t> alone(mArrayLength);
+
+    // For each slot, t2count holds (number of keys mapped to the slot) << 2,
+    // with the low two bits the xor of which of the key's three positions (0,
+    // 1 or 2) the slot is. t2hash holds the xor of those keys' hashes. Once a
+    // slot has a single key left, these identify it exactly.
+    std::vector<uint8_t> t2count(mArrayLength);
+    std::vector<uint64_t> t2hash(mArrayLength);
+
+    uint64_t rngState = UINT64_C(0x726b2b9d438b9d4d);
+    uint32_t stackSize = 0;
+    for (int attempt = 0;; ++attempt)
+    {
+        if (attempt >= MAX_CONSTRUCTION_ATTEMPTS)
+        {
+            throw std::runtime_error("failed to construct binary fuse filter");
+        }
+
+        mSeed = splitmix64(rngState);
+        std::fill(t2count.begin(), t2count.end(), 0);
+        std::fill(t2hash.begin(), t2hash.end(), 0);
+
+        bool overflow = false;
+        for (auto key : keyHashes)
+        {
+            uint64_t hash = murmur64(key + mSeed);
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                uint32_t h = slot(i, hash);
+                t2count[h] += 4;
+                t2count[h] ^= static_cast<uint8_t>(i);
+                t2hash[h] ^= hash;
+
+                // More than 63 keys in one slot wraps the counter
+                overflow = overflow || t2count[h] < 4;
+            }
+        }
+        if (overflow)
+        {
+            continue;
+        }
+
+        // Repeatedly peel off keys that are alone in some slot
+        uint32_t queueSize = 0;
+        for (uint32_t i = 0; i < mArrayLength; ++i)
+        {
+            if ((t2count[i] >> 2) == 1)
+            {
+                alone[queueSize++] = i;
+            }
+        }
+
+        stackSize = 0;
+        while (queueSize > 0)
+        {
+            uint32_t index = alone[--queueSize];
+            if ((t2count[index] >> 2) != 1)
+            {
+                continue;
+            }
+
+            uint64_t hash = t2hash[index];
+            uint8_t found = t2count[index] & 3;
+            reverseH[stackSize] = found;
+            reverseOrder[stackSize] = hash;
+            ++stackSize;
+
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if (i == found)
+                {
+                    continue;
+                }
+                uint32_t other = slot(i, hash);
+                if ((t2count[other] >> 2) == 2)
+                {
+                    alone[queueSize++] = other;
+                }
+                t2count[other] -= 4;
+                t2count[other] ^= static_cast<uint8_t>(i);
+                t2hash[other] ^= hash;
+            }
+        }
+
+        if (stackSize == size)
+        {
+            break;
+        }
+    }
+
+    // Assign fingerprints in reverse peeling order, so each key's free slot
+    // is written after the other two slots it depends on are final.
+    for (uint32_t i = stackSize; i-- > 0;)
+    {
+        uint64_t hash = reverseOrder[i];
+        uint32_t found = reverseH[i];
+        uint32_t h[3] = {slot(0, hash), slot(1, hash), slot(2, hash)};
+        uint32_t v = fingerprint(hash) ^ getFingerprint(h[(found + 1) % 3]) ^
+                     getFingerprint(h[(found + 2) % 3]);
+        setFingerprint(h[found], v);
+    }
+}
+
+bool
+BinaryFuseFilter::containsHash(uint64_t keyHash) const
+{
+    if (mFingerprints.empty())
+    {
+        return false;
+    }
+
+    uint64_t hash = murmur64(keyHash + mSeed);
+    uint32_t f = fingerprint(hash) ^ getFingerprint(slot(0, hash)) ^
+                 getFingerprint(slot(1, hash)) ^ getFingerprint(slot(2, hash));
+    return f == 0;
+}
+
+bool
+BinaryFuseFilter::operator==(BinaryFuseFilter const& other) const
+{
+    return mFingerprintBits == other.mFingerprintBits &&
+           mHashKey == other.mHashKey && mSeed == other.mSeed &&
+           mSegmentLength == other.mSegmentLength &&
+           mSegmentCount == other.mSegmentCount &&
+           mArrayLength == other.mArrayLength &&
+           mFingerprints == other.mFingerprints;
+}
+}
@@ -23,11 +23,14 @@ class BitSet
     // Value-semantic wrapper for cbitset that carries a small inline bitset
     // around with it for even less heap allocation / more cache-friendliness.
     // Adjust the INLINE_NWORDS as necessary; it'll still work (just slow down
-    // a bit) if you guess wrong.
+    // a bit) if you guess wrong. 256 bits covers the quorum maps of the
+    // networks we see, so the quorum intersection checker's sets of nodes
+    // stay off the heap, and is a whole number of AVX2 (and NEON) vectors
+    // for the vectorized loops of cbitset.
     static constexpr size_t WORD_BITS_LOG2 = 6; // 2^6 = 64
     static constexpr size_t WORD_BITS = (1 << WORD_BITS_LOG2);
     static_assert(WORD_BITS == (8 * sizeof(uint64_t)), "unexpected WORD_BITS");
-    static constexpr size_t INLINE_NWORDS = 1;
+    static constexpr size_t INLINE_NWORDS = 4;
     static constexpr size_t INLINE_NBITS = INLINE_NWORDS * WORD_BITS;
     mutable bool mCountDirty = {true};
     mutable size_t mCount = {0};
@@ -0,0 +1,237 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+// Fixed-size cache with CLOCK (second chance) eviction. Entries sit in a ring
+// and are marked as referenced whenever they are accessed; to make room, a
+// hand sweeps the ring, clearing marks, and evicts the first entry it finds
+// unmarked. This approximates LRU at the cost of setting a flag per access,
+// and, unlike RandomEvictionCache, draws no random numbers, so it needs no
+// engine of its own to be used off the main thread.
+//
+// The interface and exception safety guarantees match RandomEvictionCache.
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ClockCache : public NonMovableOrCopyable
+{
+  public:
+    struct Counters
+    {
+        uint64_t mHits{0};
+        uint64_t mMisses{0};
+        uint64_t mInserts{0};
+        uint64_t mUpdates{0};
+        uint64_t mEvicts{0};
+    };
+
+  private:
+    struct CacheValue
+    {
+        V mValue;
+        size_t mSlot;
+        bool mReferenced;
+    };
+    using MapType = std::unordered_map<K, CacheValue, Hash>;
+    using MapValueType = typename MapType::value_type;
+
+    size_t mMaxSize;
+    MapType mValueMap;
+    // The ring, pointing at map elements, which are stable across rehashing
+    std::vector<MapValueType*> mRing;
+    size_t mHand{0};
+
+    Counters mCounters;
+
+    // Removes the element at `slot` of the ring, moving the last one there
+    void
+    removeSlot(size_t slot)
+    {
+        auto* vp = mRing[slot];
+        mRing[slot] = mRing.back();
+        mRing[slot]->second.mSlot = slot;
+        mRing.pop_back();
+        mValueMap.erase(vp->first);
+        if (mHand >= mRing.size())
+        {
+            mHand = 0;
+        }
+    }
+
+    // The slot of the next entry to evict, clearing marks on the way
+    size_t
+    sweep()
+    {
+        while (mRing[mHand]->second.mReferenced)
+        {
+            mRing[mHand]->second.mReferenced = false;
+            mHand = (mHand + 1) % mRing.size();
+        }
+        return mHand;
+    }
+
+  public:
+    explicit ClockCache(size_t maxSize) : mMaxSize(std::max<size_t>(1, maxSize))
+    {
+        mValueMap.reserve(mMaxSize + 1);
+        mRing.reserve(mMaxSize);
+    }
+
+    size_t
+    maxSize() const
+    {
+        return mMaxSize;
+    }
+
+    size_t
+    size() const
+    {
+        return mValueMap.size();
+    }
+
+    Counters const&
+    getCounters() const
+    {
+        return mCounters;
+    }
+
+    // `put` does not offer exception safety. If it throws an exception,
+    // cache may be in an inconsistent state. It is, therefore,
+    // client's responsibility to handle failures correctly.
+    void
+    put(K const& k, V const& v)
+    {
+        auto it = mValueMap.find(k);
+        if (it != mValueMap.end())
+        {
+            it->second.mValue = v;
+            it->second.mReferenced = true;
+            ++mCounters.mUpdates;
+            return;
+        }
+
+        size_t slot = mRing.size();
+        if (mRing.size() == mMaxSize)
+        {
+            slot = sweep();
+            mValueMap.erase(mRing[slot]->first);
+            mHand = (mHand + 1) % mRing.size();
+            ++mCounters.mEvicts;
+        }
+        else
+        {
+            mRing.emplace_back(nullptr);
+        }
+        auto& inserted =
+            *mValueMap.emplace(k, CacheValue{v, slot, false}).first;
+        mRing[slot] = &inserted;
+        ++mCounters.mInserts;
+    }
+
+    // `exists` offers strong exception safety guarantee.
+    bool
+    exists(K const& k, bool countMisses = true)
+    {
+        bool miss = (mValueMap.find(k) == mValueMap.end());
+        if (miss && countMisses)
+        {
+            ++mCounters.mMisses;
+        }
+        return !miss;
+    }
+
+    // `clear` does not throw
+    void
+    clear()
+    {
+        mRing.clear();
+        mValueMap.clear();
+        mHand = 0;
+    }
+
+    // `erase_if` offers basic exception safety guarantee. If it throws an
+    // exception, then the cache may or may not be modified.
+    void
+    erase_if(std::function<bool(V const&)> const& f)
+    {
+        for (size_t i = 0; i < mRing.size();)
+        {
+            if (f(mRing[i]->second.mValue))
+            {
+                removeSlot(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+    // Keys of (at most) `maxKeys` entries, those accessed since the hand
+    // last went past them first.
+    std::vector<K>
+    recentKeys(size_t maxKeys) const
+    {
+        std::vector<K> keys;
+        for (bool referenced : {true, false})
+        {
+            for (auto const* vp : mRing)
+            {
+                if (keys.size() >= maxKeys)
+                {
+                    return keys;
+                }
+                if (vp->second.mReferenced == referenced)
+                {
+                    keys.emplace_back(vp->first);
+                }
+            }
+        }
+        return keys;
+    }
+
+    // `maybeGet` offers basic exception safety guarantee.
+    // Returns a pointer to the value if the key exists,
+    // and returns a nullptr otherwise.
+    V*
+    maybeGet(K const& k)
+    {
+        auto it = mValueMap.find(k);
+        if (it != mValueMap.end())
+        {
+            ++mCounters.mHits;
+            it->second.mReferenced = true;
+            return &it->second.mValue;
+        }
+        else
+        {
+            ++mCounters.mMisses;
+            return nullptr;
+        }
+    }
+
+    // `get` offers basic exception safety guarantee.
+    V&
+    get(K const& k)
+    {
+        V* result = maybeGet(k);
+        if (result == nullptr)
+        {
+            throw std::range_error("There is no such key in cache");
+        }
+        return *result;
+    }
+};
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/GlobalChecks.h"
+#include "util/NonCopyable.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace stellar
+{
+
+// Thread-safe cache split into shards, each a single-threaded `Cache` behind
+// its own mutex, so that threads using the cache at the same time rarely wait
+// on each other. The eviction policy and weighing are those of `Cache`:
+// RandomEvictionCache, ClockCache or TinyLFUCache. Keys are spread over
+// shards by their hash, mixed so that the shards' own hashmaps still see
+// well distributed hashes.
+//
+// Values are returned by copy, as a pointer into a shard would outlive its
+// lock; withShard gives locked access to a shard for anything else, such as
+// handling a batch of keys of the same shard under one lock.
+template <typename K, typename V, typename Cache, typename Hash = std::hash<K>>
+class ConcurrentCache : public NonMovableOrCopyable
+{
+  public:
+    using Counters = typename Cache::Counters;
+    using Factory = std::function<std::unique_ptr<Cache>()>;
+
+  private:
+    struct Shard
+    {
+        std::mutex mMutex;
+        std::unique_ptr<Cache> mCache;
+    };
+    std::vector<Shard> mShards;
+    Hash mHash;
+
+  public:
+    ConcurrentCache(size_t shards, Factory const& makeShard)
+        : mShards(shards)
+    {
+        releaseAssert(shards > 0);
+        for (auto& shard : mShards)
+        {
+            shard.mCache = makeShard();
+        }
+    }
+
+    size_t
+    shardCount() const
+    {
+        return mShards.size();
+    }
+
+    size_t
+    shardOf(K const& k) const
+    {
+        uint64_t h = mHash(k);
+        return ((h * UINT64_C(0x9E3779B97F4A7C15)) >> 32) % mShards.size();
+    }
+
+    // Calls `f` with the cache of shard `shard`, under its lock
+    template <typename F>
+    auto
+    withShard(size_t shard, F&& f)
+    {
+        auto& s = mShards.at(shard);
+        std::lock_guard<std::mutex> guard(s.mMutex);
+        return f(*s.mCache);
+    }
+
+    std::optional<V>
+    maybeGet(K const& k)
+    {
+        return withShard(shardOf(k), [&](Cache& cache) -> std::optional<V> {
+            auto* v = cache.maybeGet(k);
+            return v ? std::make_optional(*v) : std::nullopt;
+        });
+    }
+
+    void
+    put(K const& k, V const& v)
+    {
+        withShard(shardOf(k), [&](Cache& cache) { cache.put(k, v); });
+    }
+
+    void
+    erase_if(std::function<bool(V const&)> const& f)
+    {
+        for (size_t i = 0; i < mShards.size(); ++i)
+        {
+            withShard(i, [&](Cache& cache) { cache.erase_if(f); });
+        }
+    }
+
+    void
+    clear()
+    {
+        for (size_t i = 0; i < mShards.size(); ++i)
+        {
+            withShard(i, [](Cache& cache) { cache.clear(); });
+        }
+    }
+
+    // Replaces the cache of every shard, for example to resize them; the
+    // counters of the previous caches are dropped
+    void
+    reset(Factory const& makeShard)
+    {
+        for (auto& shard : mShards)
+        {
+            // The previous cache is destroyed after the lock is released
+            auto cache = makeShard();
+            std::lock_guard<std::mutex> guard(shard.mMutex);
+            shard.mCache.swap(cache);
+        }
+    }
+
+    size_t
+    size()
+    {
+        size_t res = 0;
+        for (size_t i = 0; i < mShards.size(); ++i)
+        {
+            res += withShard(i, [](Cache& cache) { return cache.size(); });
+        }
+        return res;
+    }
+
+    // Summed over shards, each read under its lock
+    Counters
+    getCounters()
+    {
+        Counters res;
+        for (size_t i = 0; i < mShards.size(); ++i)
+        {
+            withShard(i, [&](Cache& cache) {
+                auto const& c = cache.getCounters();
+                res.mHits += c.mHits;
+                res.mMisses += c.mMisses;
+                res.mInserts += c.mInserts;
+                res.mUpdates += c.mUpdates;
+                res.mEvicts += c.mEvicts;
+            });
+        }
+        return res;
+    }
+};
+}
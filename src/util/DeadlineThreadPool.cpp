@@ -0,0 +1,96 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/DeadlineThreadPool.h"
+#include "util/GlobalChecks.h"
+#include "util/Thread.h"
+#include "util/ZoneProfiler.h"
+
+namespace stellar
+{
+
+DeadlineThreadPool::DeadlineThreadPool(size_t numThreads, bool lowPriority)
+{
+    releaseAssert(numThreads > 0);
+    mThreads.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i)
+    {
+        mThreads.emplace_back([this, lowPriority]() {
+            if (lowPriority)
+            {
+                runCurrentThreadWithLowPriority();
+            }
+            else
+            {
+                runCurrentThreadWithMediumPriority();
+            }
+            runThread();
+        });
+    }
+}
+
+DeadlineThreadPool::~DeadlineThreadPool()
+{
+    shutdown();
+}
+
+void
+DeadlineThreadPool::post(Job&& job, uint64_t deadline)
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        releaseAssert(!mStopping);
+        mQueue.push(QueuedJob{deadline, mNextSeq++, std::move(job)});
+    }
+    mCond.notify_one();
+}
+
+size_t
+DeadlineThreadPool::queueSize() const
+{
+    std::lock_guard<std::mutex> guard(mMutex);
+    return mQueue.size();
+}
+
+void
+DeadlineThreadPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> guard(mMutex);
+        mStopping = true;
+    }
+    mCond.notify_all();
+    for (auto& t : mThreads)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+}
+
+void
+DeadlineThreadPool::runThread()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCond.wait(lock, [this] { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty())
+            {
+                // Only reachable when stopping and fully drained.
+                return;
+            }
+            // priority_queue::top is const; moving the closure out before
+            // popping is safe since ordering only looks at mDeadline/mSeq.
+            job = std::move(const_cast<QueuedJob&>(mQueue.top()).mJob);
+            mQueue.pop();
+        }
+        ZoneNamedN(jobZone, "DeadlineThreadPool job", true);
+        job();
+    }
+}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace stellar
+{
+
+// A small fixed-size pool of background threads that, unlike an
+// asio::io_context, runs queued jobs in order of an integer deadline (lowest
+// first) rather than in order of submission. Jobs with equal deadlines run in
+// submission order.
+//
+// This is used for bucket merges: each merge is posted with the ledger at
+// which its FutureBucket must be resolved, so that a merge needed at the next
+// spill of a shallow level is never stuck behind a huge merge of a deep level
+// that won't be needed for hours.
+//
+// Jobs that have already started are never preempted; the deadline only
+// determines which queued job a free thread picks up next.
+class DeadlineThreadPool : public NonMovableOrCopyable
+{
+  public:
+    using Job = std::function<void()>;
+
+    // Starts `numThreads` threads immediately; `numThreads` must be > 0. If
+    // `lowPriority` is set the threads are run with low (worker-thread) OS
+    // priority, otherwise with medium priority.
+    DeadlineThreadPool(size_t numThreads, bool lowPriority = true);
+
+    // Calls shutdown().
+    ~DeadlineThreadPool();
+
+    // Queue `job` to run on one of the pool threads. Must not be called after
+    // shutdown().
+    void post(Job&& job, uint64_t deadline);
+
+    // Number of queued jobs that have not yet been picked up by a thread.
+    size_t queueSize() const;
+
+    size_t
+    numThreads() const
+    {
+        return mThreads.size();
+    }
+
+    // Stop accepting work, let the threads drain all queued jobs and join
+    // them. Safe to call more than once.
+    void shutdown();
+
+  private:
+    struct QueuedJob
+    {
+        uint64_t mDeadline;
+        uint64_t mSeq;
+        Job mJob;
+    };
+
+    struct LaterFirst
+    {
+        bool
+        operator()(QueuedJob const& a, QueuedJob const& b) const
+        {
+            if (a.mDeadline != b.mDeadline)
+            {
+                return a.mDeadline > b.mDeadline;
+            }
+            return a.mSeq > b.mSeq;
+        }
+    };
+
+    void runThread();
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCond;
+    std::priority_queue<QueuedJob, std::vector<QueuedJob>, LaterFirst> mQueue;
+    uint64_t mNextSeq{0};
+    bool mStopping{false};
+    std::vector<std::thread> mThreads;
+};
+}
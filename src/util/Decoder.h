@@ -4,6 +4,8 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <lib/util/basen.h>
 #include <string>
@@ -24,13 +26,51 @@ inline size_t constexpr encoded_size64(size_t rawsize)
     return ((rawsize + 2) / 3 * 4);
 }
 
+// Base32 digit of `v`, from 0 to 31: 'A' to 'Z' then '2' to '7'. Computed
+// rather than looked up so that encoding a seed has the same memory accesses
+// whatever its value.
+inline char
+b32_digit(uint32_t v)
+{
+    return static_cast<char>('A' + v - (41 & (0 - uint32_t(v > 25))));
+}
+
+// Writes the base32 encoding of the `size` bytes at `in`, padding included,
+// to the encoded_size32(size) chars at `out`. Groups of 5 bytes are read as
+// one integer and written as 8 chars, in loops the compiler unrolls.
+inline void
+encode_b32(unsigned char const* in, size_t size, char* out)
+{
+    auto encodeGroup = [](unsigned char const* g, char* o, size_t chars) {
+        uint64_t bits = (uint64_t(g[0]) << 32) | (uint64_t(g[1]) << 24) |
+                        (uint64_t(g[2]) << 16) | (uint64_t(g[3]) << 8) |
+                        uint64_t(g[4]);
+        for (size_t j = 0; j < 8; ++j)
+        {
+            o[j] = j < chars ? b32_digit((bits >> (35 - 5 * j)) & 31) : '=';
+        }
+    };
+    size_t const full = size / 5 * 5;
+    for (size_t i = 0; i < full; i += 5, out += 8)
+    {
+        encodeGroup(in + i, out, 8);
+    }
+    if (size_t const rest = size - full)
+    {
+        unsigned char last[5] = {0};
+        std::memcpy(last, in + full, rest);
+        encodeGroup(last, out, (rest * 8 + 4) / 5);
+    }
+}
+
 template <class T>
 inline std::string
 encode_b32(T const& v)
 {
-    std::string res;
-    res.reserve(encoded_size32(v.size() * sizeof(typename T::value_type)) + 1);
-    bn::encode_b32(v.begin(), v.end(), std::back_inserter(res));
+    size_t const size = v.size() * sizeof(typename T::value_type);
+    std::string res(encoded_size32(size), '\0');
+    encode_b32(reinterpret_cast<unsigned char const*>(v.data()), size,
+               res.data());
     return res;
 }
 
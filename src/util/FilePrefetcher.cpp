@@ -0,0 +1,91 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/FilePrefetcher.h"
+#include "util/FileSystemException.h"
+#include "util/ZoneProfiler.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <algorithm>
+#include <fcntl.h>
+#include <limits>
+#include <unistd.h>
+#endif
+
+namespace stellar
+{
+
+#if defined(__linux__) || defined(__APPLE__)
+
+bool
+FilePrefetcher::isSupported()
+{
+    return true;
+}
+
+FilePrefetcher::FilePrefetcher(std::string const& filename)
+    : mFilename(filename)
+{
+    mFd = ::open(filename.c_str(), O_RDONLY);
+    if (mFd == -1)
+    {
+        FileSystemException::failWithErrno(
+            "failed to open file for prefetch: " + filename + ", reason: ");
+    }
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+    if (mFd != -1)
+    {
+        ::close(mFd);
+    }
+}
+
+void
+FilePrefetcher::prefetch(
+    std::vector<std::pair<size_t, size_t>> const& ranges) const
+{
+    ZoneScoped;
+    ZoneValue(static_cast<int64_t>(ranges.size()));
+    for (auto const& [offset, len] : ranges)
+    {
+#if defined(__linux__)
+        ::posix_fadvise(mFd, static_cast<off_t>(offset),
+                        static_cast<off_t>(len), POSIX_FADV_WILLNEED);
+#else
+        struct radvisory ra;
+        ra.ra_offset = static_cast<off_t>(offset);
+        ra.ra_count = static_cast<int>(
+            std::min<size_t>(len, std::numeric_limits<int>::max()));
+        ::fcntl(mFd, F_RDADVISE, &ra);
+#endif
+    }
+}
+
+#else
+
+bool
+FilePrefetcher::isSupported()
+{
+    return false;
+}
+
+FilePrefetcher::FilePrefetcher(std::string const& filename)
+    : mFilename(filename)
+{
+}
+
+FilePrefetcher::~FilePrefetcher()
+{
+}
+
+void
+FilePrefetcher::prefetch(
+    std::vector<std::pair<size_t, size_t>> const& ranges) const
+{
+}
+
+#endif
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace stellar
+{
+
+// Submits a batch of read-ahead requests for a file to the kernel. prefetch()
+// returns immediately: the kernel queues reads for every range into the page
+// cache and the device services them concurrently, so subsequent synchronous
+// reads of those ranges (through any file handle) hit memory instead of each
+// paying a full device round trip in turn.
+//
+// Implemented with posix_fadvise(POSIX_FADV_WILLNEED) on Linux and
+// fcntl(F_RDADVISE) on macOS. Elsewhere prefetch() is a no-op.
+class FilePrefetcher : public NonMovableOrCopyable
+{
+    std::string const mFilename;
+    int mFd{-1};
+
+  public:
+    // Returns false if prefetch() is a no-op on this platform
+    static bool isSupported();
+
+    // Throws FileSystemException if the file cannot be opened
+    explicit FilePrefetcher(std::string const& filename);
+    ~FilePrefetcher();
+
+    // Ranges are (offset, length) pairs. Failures are ignored, since the
+    // advice is only a hint.
+    void prefetch(std::vector<std::pair<size_t, size_t>> const& ranges) const;
+};
+}
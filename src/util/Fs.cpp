@@ -7,7 +7,7 @@
 #include "util/FileSystemException.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <cstdint>
 #include <filesystem>
 #include <fmt/format.h>
@@ -32,8 +32,10 @@
 #include <io.h>
 #else
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include <cstdio>
@@ -105,6 +107,30 @@ flushFileChanges(native_handle_t fh)
     }
 }
 
+void
+preallocateFile(native_handle_t fh, size_t len)
+{
+}
+
+void
+truncateFile(native_handle_t fh, size_t len)
+{
+    ZoneScoped;
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(len);
+    if (SetFilePointerEx(fh, size, NULL, FILE_BEGIN) == FALSE ||
+        SetEndOfFile(fh) == FALSE)
+    {
+        FileSystemException::failWithGetLastError(
+            "fs::truncateFile() failed on SetEndOfFile(): ");
+    }
+}
+
+void
+dropFileCache(native_handle_t fh, size_t offset, size_t len)
+{
+}
+
 native_handle_t
 openFileToWrite(std::string const& path)
 {
@@ -234,6 +260,51 @@ flushFileChanges(native_handle_t fd)
     }
 }
 
+void
+preallocateFile(native_handle_t fd, size_t len)
+{
+    ZoneScoped;
+#ifdef __linux__
+    // Failure (e.g. a filesystem without fallocate support) only loses the
+    // optimization
+    if (len > 0 && fallocate(fd, FALLOC_FL_KEEP_SIZE, 0,
+                             static_cast<off_t>(len)) != 0)
+    {
+        CLOG_DEBUG(Fs, "fs::preallocateFile() failed on fallocate(): {}",
+                   std::strerror(errno));
+    }
+#endif
+}
+
+void
+truncateFile(native_handle_t fd, size_t len)
+{
+    ZoneScoped;
+    while (ftruncate(fd, static_cast<off_t>(len)) == -1)
+    {
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        FileSystemException::failWithErrno(
+            "fs::truncateFile() failed on ftruncate(): ");
+    }
+}
+
+void
+dropFileCache(native_handle_t fd, size_t offset, size_t len)
+{
+    ZoneScoped;
+#ifdef __linux__
+    // Pages must be clean before posix_fadvise can drop them
+    sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(len),
+                    SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                        SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(len),
+                  POSIX_FADV_DONTNEED);
+#endif
+}
+
 native_handle_t
 openFileToWrite(std::string const& path)
 {
@@ -47,6 +47,19 @@ void unlockFile(std::string const& path);
 // Call fsync() on POSIX or FlushFileBuffers() on Win32.
 void flushFileChanges(native_handle_t h);
 
+// Reserve disk space for the first len bytes of a file without changing its
+// size, so a large sequential write does not fragment the file. Best-effort:
+// does nothing where unsupported. Space reserved past the final size of the
+// file is released by truncateFile.
+void preallocateFile(native_handle_t h, size_t len);
+
+// Set the size of a file to len bytes.
+void truncateFile(native_handle_t h, size_t len);
+
+// Write back any dirty pages in [offset, offset + len) and drop them from the
+// OS page cache. Best-effort: does nothing where unsupported.
+void dropFileCache(native_handle_t h, size_t offset, size_t len);
+
 // Open a native handle (fd or HANDLE) for writing.
 native_handle_t openFileToWrite(std::string const& path);
 
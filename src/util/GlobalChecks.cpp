@@ -17,11 +17,18 @@
 namespace stellar
 {
 static std::thread::id mainThread = std::this_thread::get_id();
+static thread_local bool tMarkedAsMain{false};
 
 bool
 threadIsMain()
 {
-    return mainThread == std::this_thread::get_id();
+    return tMarkedAsMain || mainThread == std::this_thread::get_id();
+}
+
+void
+markThreadAsMain()
+{
+    tMarkedAsMain = true;
 }
 
 void
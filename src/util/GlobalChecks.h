@@ -7,6 +7,10 @@
 namespace stellar
 {
 bool threadIsMain();
+// Makes threadIsMain() true on the calling thread, for a thread running the
+// main loop of an Application other than the one on the main thread, as in
+// simulations with a thread per node
+void markThreadAsMain();
 
 void dbgAbort();
 
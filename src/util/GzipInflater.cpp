@@ -0,0 +1,100 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_ZLIB
+
+#include "util/GzipInflater.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace stellar
+{
+
+GzipInflater::GzipInflater() : mStream(std::make_unique<z_stream_s>())
+{
+    *mStream = {};
+    // 16 added to the window bits selects the gzip format
+    if (inflateInit2(mStream.get(), 16 + MAX_WBITS) != Z_OK)
+    {
+        throw std::runtime_error("failed to initialize zlib");
+    }
+}
+
+GzipInflater::~GzipInflater()
+{
+    inflateEnd(mStream.get());
+}
+
+void
+GzipInflater::inflate(char const* data, size_t size, Output const& out)
+{
+    ZoneScoped;
+    std::array<unsigned char, 64 * 1024> buf;
+    while (size > 0)
+    {
+        if (mDone)
+        {
+            // Another member follows
+            if (inflateReset(mStream.get()) != Z_OK)
+            {
+                throw std::runtime_error("failed to reset zlib");
+            }
+            mDone = false;
+        }
+
+        auto in = static_cast<uInt>(
+            std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+        mStream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        mStream->avail_in = in;
+        int res = Z_OK;
+        do
+        {
+            mStream->next_out = buf.data();
+            mStream->avail_out = static_cast<uInt>(buf.size());
+            res = ::inflate(mStream.get(), Z_NO_FLUSH);
+            if (res == Z_BUF_ERROR)
+            {
+                // Nothing left to do until more input comes
+                break;
+            }
+            if (res != Z_OK && res != Z_STREAM_END)
+            {
+                throw std::runtime_error(
+                    fmt::format(FMT_STRING("invalid gzip data: {}"),
+                                mStream->msg ? mStream->msg : "unknown"));
+            }
+            auto n = buf.size() - mStream->avail_out;
+            if (n > 0)
+            {
+                out(reinterpret_cast<char const*>(buf.data()), n);
+            }
+            // A full output buffer may leave more output pending
+        } while (res == Z_OK &&
+                 (mStream->avail_in > 0 || mStream->avail_out == 0));
+        mDone = res == Z_STREAM_END;
+
+        auto used = in - mStream->avail_in;
+        if (used == 0 && !mDone)
+        {
+            throw std::runtime_error("invalid gzip data: no progress");
+        }
+        data += used;
+        size -= used;
+    }
+}
+
+bool
+GzipInflater::done() const
+{
+    return mDone;
+}
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_ZLIB
+
+#include "util/NonCopyable.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+struct z_stream_s;
+
+namespace stellar
+{
+
+// Decompresses gzip data incrementally, as it arrives, so that it doesn't
+// have to be written compressed to a file first. Several gzip members in a
+// row are decompressed one after the other, like `gzip -d` does.
+class GzipInflater : public NonMovableOrCopyable
+{
+  public:
+    using Output = std::function<void(char const* data, size_t size)>;
+
+    GzipInflater();
+    ~GzipInflater();
+
+    // Decompress the next `size` bytes of the input, passing what comes out
+    // to `out`, possibly in several pieces. Throws std::runtime_error if the
+    // input isn't valid gzip data.
+    void inflate(char const* data, size_t size, Output const& out);
+
+    // True once the input seen so far ends at the end of a gzip member
+    bool done() const;
+
+  private:
+    std::unique_ptr<z_stream_s> mStream;
+    bool mDone{false};
+};
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include "util/types.h"
 
 #if defined(USE_SPDLOG)
+#include "util/AsyncLogSink.h"
 #include "util/Timer.h"
 #include <chrono>
 #include <fmt/chrono.h>
@@ -36,6 +37,9 @@ bool Logging::mColor = false;
 std::string Logging::mLastPattern;
 std::string Logging::mLastFilenamePattern;
 bool Logging::mLogToConsole = true;
+std::set<std::string> Logging::mAsyncPartitions;
+size_t Logging::mAsyncQueueSize = 0;
+std::shared_ptr<AsyncLogSink> Logging::mAsyncSink;
 #endif
 
 // Right now this is hard-coded to log messages at least as important as INFO
@@ -166,10 +170,19 @@ Logging::init(bool truncate)
                 make_shared<basic_file_sink_mt>(filename, /*truncate=*/false));
         }
 
+        std::vector<shared_ptr<sink>> asyncSinks;
+        if (!mAsyncPartitions.empty())
+        {
+            mAsyncSink = make_shared<AsyncLogSink>(sinks, mAsyncQueueSize);
+            asyncSinks.emplace_back(mAsyncSink);
+        }
+
         auto makeLogger =
             [&](std::string const& name) -> shared_ptr<spdlog::logger> {
-            auto logger =
-                make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+            auto const& loggerSinks =
+                mAsyncPartitions.count(name) != 0 ? asyncSinks : sinks;
+            auto logger = make_shared<spdlog::logger>(
+                name, loggerSinks.begin(), loggerSinks.end());
             spdlog::register_logger(logger);
             return logger;
         };
@@ -210,6 +223,12 @@ Logging::deinit()
 #include "util/LogPartitions.def"
 #undef LOG_PARTITION
         spdlog::drop_all();
+        if (mAsyncSink)
+        {
+            // Loggers still held elsewhere write synchronously from now on
+            mAsyncSink->stop();
+            mAsyncSink.reset();
+        }
         mInitialized = false;
     }
 #endif
@@ -277,6 +296,37 @@ Logging::setLoggingColor(bool color)
 #endif
 }
 
+void
+Logging::setAsyncPartitions(std::vector<std::string> const& partitions,
+                            size_t queueSize)
+{
+    std::set<std::string> normalized;
+    for (auto const& p : partitions)
+    {
+        normalized.emplace(normalizePartition(p));
+    }
+#if defined(USE_SPDLOG)
+    std::lock_guard<std::recursive_mutex> guard(mLogMutex);
+    mAsyncPartitions = std::move(normalized);
+    mAsyncQueueSize = queueSize;
+    deinit();
+    init();
+#endif
+}
+
+uint64_t
+Logging::getAsyncDroppedCount()
+{
+#if defined(USE_SPDLOG)
+    std::lock_guard<std::recursive_mutex> guard(mLogMutex);
+    if (mAsyncSink)
+    {
+        return mAsyncSink->getDroppedCount();
+    }
+#endif
+    return 0;
+}
+
 void
 Logging::setLogLevel(LogLevel level, const char* partition)
 {
@@ -9,6 +9,8 @@
 #include <filesystem>
 #include <iostream>
 #include <map>
+#include <set>
+#include <vector>
 
 // Provide support for fmt-strings formatting objects that have
 // an overloaded operator<< defined on them.
@@ -80,6 +82,7 @@
 namespace stellar
 {
 typedef std::shared_ptr<spdlog::logger> LogPtr;
+class AsyncLogSink;
 }
 
 #else
@@ -168,6 +171,9 @@ class Logging
     static std::string mLastPattern;
     static std::string mLastFilenamePattern;
     static bool mLogToConsole;
+    static std::set<std::string> mAsyncPartitions;
+    static size_t mAsyncQueueSize;
+    static std::shared_ptr<AsyncLogSink> mAsyncSink;
 #define LOG_PARTITION(name) static LogPtr name##LogPtr;
 #include "util/LogPartitions.def"
 #undef LOG_PARTITION
@@ -180,6 +186,12 @@ class Logging
     static void setLoggingToFile(std::string const& filename);
     static void setLoggingToConsole(bool console);
     static void setLoggingColor(bool color);
+    // Has the given partitions log through a queue of queueSize messages
+    // written out by a background thread, see AsyncLogSink
+    static void setAsyncPartitions(std::vector<std::string> const& partitions,
+                                   size_t queueSize);
+    // Messages dropped by async partitions since logging was last set up
+    static uint64_t getAsyncDroppedCount();
     static void setLogLevel(LogLevel level, const char* partition);
     static LogLevel getLLfromString(std::string const& levelName);
     static LogLevel getLogLevel(std::string const& partition);
@@ -7,7 +7,7 @@
 #include "crypto/ShortHash.h"
 #include "util/GlobalChecks.h"
 #include "util/UnorderedMap.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <algorithm>
 #include <autocheck/generator.hpp>
 #include <catch.hpp>
@@ -18,7 +18,7 @@
 namespace stellar
 {
 
-stellar_default_random_engine gRandomEngine;
+thread_local stellar_default_random_engine gRandomEngine;
 std::uniform_real_distribution<double> uniformFractionDistribution(0.0, 1.0);
 
 double
@@ -25,7 +25,10 @@ bool rand_flip();
 
 typedef std::minstd_rand stellar_default_random_engine;
 
-extern stellar_default_random_engine gRandomEngine;
+// One per thread, so that threads running an Application each, as in
+// simulations, don't share it. Only the calling thread's engine is seeded by
+// the functions below; other threads must seed theirs.
+extern thread_local stellar_default_random_engine gRandomEngine;
 
 template <typename T>
 T
@@ -0,0 +1,271 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MemoryAttribution.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace stellar
+{
+
+#ifdef USE_MEMORY_ATTRIBUTION
+thread_local MemorySubsystem gMemorySubsystem = MemorySubsystem::Other;
+
+namespace
+{
+char const* const SUBSYSTEM_NAMES[] = {
+#define LOG_PARTITION(name) #name,
+#include "util/LogPartitions.def"
+#undef LOG_PARTITION
+    "Other"};
+
+size_t constexpr NUM_SUBSYSTEMS =
+    static_cast<size_t>(MemorySubsystem::Other) + 1;
+static_assert(sizeof(SUBSYSTEM_NAMES) / sizeof(SUBSYSTEM_NAMES[0]) ==
+              NUM_SUBSYSTEMS);
+
+struct SubsystemCounters
+{
+    std::atomic<uint64_t> mAllocs{0};
+    std::atomic<uint64_t> mFrees{0};
+    std::atomic<uint64_t> mAllocatedBytes{0};
+    std::atomic<uint64_t> mFreedBytes{0};
+};
+
+// Constant-initialized, so that it is usable by allocations made before
+// main() and during static destruction
+std::array<SubsystemCounters, NUM_SUBSYSTEMS> gCounters;
+
+struct AllocHeader
+{
+    uint64_t mSize;
+    MemorySubsystem mSubsystem;
+};
+// Keeps what follows the header aligned as malloc's result is
+size_t constexpr HEADER_SIZE = alignof(std::max_align_t);
+static_assert(sizeof(AllocHeader) <= HEADER_SIZE);
+
+size_t
+headerOffset(size_t align)
+{
+    return align > HEADER_SIZE ? align : HEADER_SIZE;
+}
+
+void*
+attributedAlloc(size_t size, size_t align) noexcept
+{
+    size_t offset = headerOffset(align);
+    void* raw;
+    if (align > HEADER_SIZE)
+    {
+        // aligned_alloc wants the size to be a multiple of the alignment
+        size_t total = (offset + size + align - 1) / align * align;
+        raw = std::aligned_alloc(align, total);
+    }
+    else
+    {
+        raw = std::malloc(offset + size);
+    }
+    if (raw == nullptr)
+    {
+        return nullptr;
+    }
+    auto* p = static_cast<char*>(raw) + offset;
+    auto subsystem = gMemorySubsystem;
+    new (p - HEADER_SIZE) AllocHeader{size, subsystem};
+    auto& c = gCounters[static_cast<size_t>(subsystem)];
+    c.mAllocs.fetch_add(1, std::memory_order_relaxed);
+    c.mAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return p;
+}
+
+void
+attributedFree(void* ptr, size_t align) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    auto* p = static_cast<char*>(ptr);
+    auto const* header = reinterpret_cast<AllocHeader const*>(p - HEADER_SIZE);
+    auto& c = gCounters[static_cast<size_t>(header->mSubsystem)];
+    c.mFrees.fetch_add(1, std::memory_order_relaxed);
+    c.mFreedBytes.fetch_add(header->mSize, std::memory_order_relaxed);
+    std::free(p - headerOffset(align));
+}
+
+void*
+attributedNew(size_t size, size_t align)
+{
+    // operator new must return a distinct pointer for zero-sized allocations
+    while (true)
+    {
+        if (auto* p = attributedAlloc(size == 0 ? 1 : size, align))
+        {
+            return p;
+        }
+        auto handler = std::get_new_handler();
+        if (handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+}
+
+bool
+memoryAttributionEnabled()
+{
+    return true;
+}
+
+std::vector<MemoryAttributionStats>
+getMemoryAttributionStats()
+{
+    std::vector<MemoryAttributionStats> res;
+    for (size_t i = 0; i < NUM_SUBSYSTEMS; ++i)
+    {
+        auto const& c = gCounters[i];
+        res.emplace_back(MemoryAttributionStats{
+            SUBSYSTEM_NAMES[i], c.mAllocs.load(std::memory_order_relaxed),
+            c.mFrees.load(std::memory_order_relaxed),
+            c.mAllocatedBytes.load(std::memory_order_relaxed),
+            c.mFreedBytes.load(std::memory_order_relaxed)});
+    }
+    return res;
+}
+#else
+bool
+memoryAttributionEnabled()
+{
+    return false;
+}
+
+std::vector<MemoryAttributionStats>
+getMemoryAttributionStats()
+{
+    return {};
+}
+#endif // USE_MEMORY_ATTRIBUTION
+}
+
+#ifdef USE_MEMORY_ATTRIBUTION
+using stellar::attributedFree;
+using stellar::attributedNew;
+
+void*
+operator new(size_t size)
+{
+    return attributedNew(size, 0);
+}
+
+void*
+operator new[](size_t size)
+{
+    return attributedNew(size, 0);
+}
+
+void*
+operator new(size_t size, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return attributedNew(size, 0);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void*
+operator new[](size_t size, std::nothrow_t const&) noexcept
+{
+    try
+    {
+        return attributedNew(size, 0);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void*
+operator new(size_t size, std::align_val_t align)
+{
+    return attributedNew(size, static_cast<size_t>(align));
+}
+
+void*
+operator new[](size_t size, std::align_val_t align)
+{
+    return attributedNew(size, static_cast<size_t>(align));
+}
+
+void
+operator delete(void* p) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete[](void* p, size_t) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete(void* p, std::nothrow_t const&) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete[](void* p, std::nothrow_t const&) noexcept
+{
+    attributedFree(p, 0);
+}
+
+void
+operator delete(void* p, std::align_val_t align) noexcept
+{
+    attributedFree(p, static_cast<size_t>(align));
+}
+
+void
+operator delete[](void* p, std::align_val_t align) noexcept
+{
+    attributedFree(p, static_cast<size_t>(align));
+}
+
+void
+operator delete(void* p, size_t, std::align_val_t align) noexcept
+{
+    attributedFree(p, static_cast<size_t>(align));
+}
+
+void
+operator delete[](void* p, size_t, std::align_val_t align) noexcept
+{
+    attributedFree(p, static_cast<size_t>(align));
+}
+#endif // USE_MEMORY_ATTRIBUTION
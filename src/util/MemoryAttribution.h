@@ -0,0 +1,77 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// In builds configured with --enable-memory-attribution, operator new and
+// delete are replaced by versions counting every allocation against the
+// subsystem of the innermost MemoryAttributionScope on the allocating
+// thread, or against `Other` outside of any. Each allocation carries a
+// 16-byte header remembering its size and subsystem, so that its release is
+// counted against the subsystem that allocated it; this is why it is off by
+// default. Memory allocated by C libraries through malloc, or by Rust, isn't
+// seen. In other builds, scopes compile to nothing.
+//
+// Subsystems are the log partitions.
+enum class MemorySubsystem : uint8_t
+{
+#define LOG_PARTITION(name) name,
+#include "util/LogPartitions.def"
+#undef LOG_PARTITION
+    Other
+};
+
+struct MemoryAttributionStats
+{
+    std::string mSubsystem;
+    uint64_t mAllocs;
+    uint64_t mFrees;
+    uint64_t mAllocatedBytes;
+    uint64_t mFreedBytes;
+};
+
+#ifdef USE_MEMORY_ATTRIBUTION
+extern thread_local MemorySubsystem gMemorySubsystem;
+#endif
+
+// Sets the subsystem that allocations made by this thread are counted
+// against until the scope ends
+class MemoryAttributionScope : NonMovableOrCopyable
+{
+  public:
+#ifdef USE_MEMORY_ATTRIBUTION
+    explicit MemoryAttributionScope(MemorySubsystem subsystem)
+        : mPrevious(gMemorySubsystem)
+    {
+        gMemorySubsystem = subsystem;
+    }
+    ~MemoryAttributionScope()
+    {
+        gMemorySubsystem = mPrevious;
+    }
+
+  private:
+    MemorySubsystem const mPrevious;
+#else
+    explicit MemoryAttributionScope(MemorySubsystem)
+    {
+    }
+#endif
+};
+
+bool memoryAttributionEnabled();
+
+// The counts since the start of the process, one per subsystem; empty when
+// memory attribution isn't built in
+std::vector<MemoryAttributionStats> getMemoryAttributionStats();
+}
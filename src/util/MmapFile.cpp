@@ -0,0 +1,133 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/MmapFile.h"
+#include "util/FileSystemException.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace stellar
+{
+
+#ifdef _WIN32
+
+bool
+MmapFile::isSupported()
+{
+    return false;
+}
+
+MmapFile::MmapFile(std::string const& filename) : mFilename(filename)
+{
+    FileSystemException::failWith("memory-mapped files are not supported on "
+                                  "this platform: " +
+                                  filename);
+}
+
+MmapFile::~MmapFile()
+{
+}
+
+void
+MmapFile::adviseRandom() const
+{
+}
+
+void
+MmapFile::adviseWillNeed(size_t offset, size_t len) const
+{
+}
+
+#else
+
+bool
+MmapFile::isSupported()
+{
+    return true;
+}
+
+MmapFile::MmapFile(std::string const& filename) : mFilename(filename)
+{
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        FileSystemException::failWithErrno("failed to open file for mmap: " +
+                                           filename + ", reason: ");
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        FileSystemException::failWithErrno("failed to stat file for mmap: " +
+                                           filename + ", reason: ");
+    }
+
+    mSize = static_cast<size_t>(st.st_size);
+    if (mSize != 0)
+    {
+        void* p = ::mmap(nullptr, mSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            ::close(fd);
+            FileSystemException::failWithErrno("failed to mmap file: " +
+                                               filename + ", reason: ");
+        }
+        mData = static_cast<char const*>(p);
+    }
+
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+}
+
+MmapFile::~MmapFile()
+{
+    if (mData)
+    {
+        if (::munmap(const_cast<char*>(mData), mSize) != 0)
+        {
+            CLOG_WARNING(Fs, "failed to munmap {}: {}", mFilename,
+                         std::strerror(errno));
+        }
+    }
+}
+
+void
+MmapFile::adviseRandom() const
+{
+    if (mData)
+    {
+        ::madvise(const_cast<char*>(mData), mSize, MADV_RANDOM);
+    }
+}
+
+void
+MmapFile::adviseWillNeed(size_t offset, size_t len) const
+{
+    if (!mData || offset >= mSize)
+    {
+        return;
+    }
+
+    // madvise requires an OS-page aligned start address
+    static size_t const osPageSize =
+        static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t alignedStart = offset - (offset % osPageSize);
+    size_t end = std::min(mSize, offset + len);
+    ::madvise(const_cast<char*>(mData) + alignedStart, end - alignedStart,
+              MADV_WILLNEED);
+}
+
+#endif
+}
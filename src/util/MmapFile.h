@@ -0,0 +1,66 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+// Read-only, whole-file memory mapping. Used for random point reads of bucket
+// files, where decoding directly out of the page cache avoids both the
+// read(2) syscall and the copy into an intermediate buffer that
+// XDRInputFileStream performs.
+//
+// Once constructed the mapping is immutable, so a single MmapFile may be read
+// from multiple threads concurrently.
+//
+// Memory mapping is only implemented on POSIX systems; on other platforms
+// isSupported() returns false and the constructor throws.
+class MmapFile : public NonMovableOrCopyable
+{
+    std::string const mFilename;
+    char const* mData{nullptr};
+    size_t mSize{0};
+
+  public:
+    static bool isSupported();
+
+    // Maps `filename` read-only. Throws FileSystemException on failure. Empty
+    // files are valid and result in a mapping with size() == 0.
+    explicit MmapFile(std::string const& filename);
+    ~MmapFile();
+
+    char const*
+    data() const
+    {
+        return mData;
+    }
+
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+
+    std::string const&
+    getFilename() const
+    {
+        return mFilename;
+    }
+
+    // Tell the kernel that accesses will be random, which disables readahead
+    // for the whole mapping.
+    void adviseRandom() const;
+
+    // Tell the kernel that [offset, offset + len) will be read shortly, so the
+    // entire range is faulted in with a single I/O instead of one per OS page.
+    // The range is clamped to the mapping.
+    void adviseWillNeed(size_t offset, size_t len) const;
+};
+}
@@ -0,0 +1,201 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_ZLIB
+
+#include "util/ParallelGzip.h"
+#include "util/ZoneProfiler.h"
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <vector>
+#include <zlib.h>
+
+namespace stellar
+{
+
+namespace
+{
+size_t const BLOCK_SIZE = 1024 * 1024;
+// Size of the deflate window
+size_t const DICTIONARY_SIZE = 32 * 1024;
+
+class Deflater
+{
+    z_stream mStream = {};
+
+  public:
+    explicit Deflater(int level)
+    {
+        // Negative window bits for a raw deflate stream, the gzip header
+        // and trailer are written around all the blocks
+        if (deflateInit2(&mStream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            throw std::runtime_error("failed to initialize zlib");
+        }
+    }
+
+    ~Deflater()
+    {
+        deflateEnd(&mStream);
+    }
+
+    z_stream&
+    stream()
+    {
+        return mStream;
+    }
+};
+
+// Deflate one block of the stream. All blocks but the last end with a sync
+// flush, which leaves the output on a byte boundary so that the blocks can
+// be written one after the other.
+std::vector<unsigned char>
+deflateBlock(std::vector<unsigned char> const& in,
+             unsigned char const* dictionary, size_t dictionarySize,
+             int level, bool last)
+{
+    ZoneScoped;
+    Deflater deflater(level);
+    auto& s = deflater.stream();
+    if (dictionarySize > 0 &&
+        deflateSetDictionary(&s, dictionary,
+                             static_cast<uInt>(dictionarySize)) != Z_OK)
+    {
+        throw std::runtime_error("failed to set deflate dictionary");
+    }
+
+    std::vector<unsigned char> out(deflateBound(&s, in.size()) + 16);
+    s.next_in = const_cast<Bytef*>(in.data());
+    s.avail_in = static_cast<uInt>(in.size());
+    s.next_out = out.data();
+    s.avail_out = static_cast<uInt>(out.size());
+    int const flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true)
+    {
+        int res = deflate(&s, flush);
+        if (res == Z_STREAM_END || (res == Z_BUF_ERROR && !last))
+        {
+            // Z_BUF_ERROR: the previous call flushed everything already
+            break;
+        }
+        if (res != Z_OK)
+        {
+            throw std::runtime_error(
+                fmt::format(FMT_STRING("deflate failed: {}"), res));
+        }
+        if (!last && s.avail_out != 0)
+        {
+            break;
+        }
+        if (s.avail_out == 0)
+        {
+            size_t used = out.size();
+            out.resize(out.size() * 2);
+            s.next_out = out.data() + used;
+            s.avail_out = static_cast<uInt>(out.size() - used);
+        }
+    }
+    out.resize(out.size() - s.avail_out);
+    return out;
+}
+
+void
+writeLE32(std::ofstream& out, uint32_t v)
+{
+    unsigned char bytes[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(v >> (8 * i));
+    }
+    out.write(reinterpret_cast<char const*>(bytes), sizeof(bytes));
+}
+}
+
+void
+gzipFile(std::string const& inPath, std::string const& outPath,
+         size_t threads, int level)
+{
+    ZoneScoped;
+    std::ifstream in(inPath, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), inPath));
+    }
+    in.exceptions(std::ios::badbit);
+    std::ofstream out(outPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Error opening file {}"), outPath));
+    }
+    out.exceptions(std::ios::failbit | std::ios::badbit);
+
+    // No name and no time, made on Unix
+    unsigned char const header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+    out.write(reinterpret_cast<char const*>(header), sizeof(header));
+
+    threads = std::max<size_t>(threads, 1);
+    uLong crc = crc32(0, nullptr, 0);
+    uint64_t total = 0;
+    // Tail of the last block of the previous round
+    std::vector<unsigned char> dictionary;
+    bool eof = false;
+    while (!eof)
+    {
+        std::vector<std::vector<unsigned char>> blocks;
+        while (blocks.size() < threads && !eof)
+        {
+            auto& block = blocks.emplace_back(BLOCK_SIZE);
+            in.read(reinterpret_cast<char*>(block.data()),
+                    static_cast<std::streamsize>(block.size()));
+            block.resize(static_cast<size_t>(in.gcount()));
+            // The last block may be empty, it then only ends the stream
+            eof = block.size() < BLOCK_SIZE;
+        }
+
+        std::vector<std::future<std::vector<unsigned char>>> deflated;
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            unsigned char const* dict = dictionary.data();
+            size_t dictSize = dictionary.size();
+            if (i > 0)
+            {
+                dictSize = std::min(DICTIONARY_SIZE, blocks[i - 1].size());
+                dict = blocks[i - 1].data() + blocks[i - 1].size() - dictSize;
+            }
+            bool last = eof && i + 1 == blocks.size();
+            deflated.emplace_back(std::async(std::launch::async, deflateBlock,
+                                             std::cref(blocks[i]), dict,
+                                             dictSize, level, last));
+        }
+        for (auto const& block : blocks)
+        {
+            crc = crc32(crc, block.data(), static_cast<uInt>(block.size()));
+            total += block.size();
+        }
+        for (auto& f : deflated)
+        {
+            auto bytes = f.get();
+            out.write(reinterpret_cast<char const*>(bytes.data()),
+                      static_cast<std::streamsize>(bytes.size()));
+        }
+
+        auto const& lastBlock = blocks.back();
+        auto dictSize = std::min(DICTIONARY_SIZE, lastBlock.size());
+        dictionary.assign(lastBlock.end() - dictSize, lastBlock.end());
+    }
+
+    writeLE32(out, static_cast<uint32_t>(crc));
+    writeLE32(out, static_cast<uint32_t>(total));
+    out.close();
+}
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_ZLIB
+
+#include <cstddef>
+#include <string>
+
+namespace stellar
+{
+
+// Compress `inPath` into `outPath` as a single gzip member, like `gzip -c`
+// does, but using `threads` threads. As pigz does, the input is cut into
+// blocks that are deflated in parallel, each one primed with the end of the
+// block before it. Throws std::runtime_error on failure.
+void gzipFile(std::string const& inPath, std::string const& outPath,
+              size_t threads, int level = 6);
+}
+
+#endif
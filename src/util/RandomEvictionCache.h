@@ -6,8 +6,11 @@
 #include "util/Math.h"
 #include "util/NonCopyable.h"
 
+#include <algorithm>
+#include <memory>
 #include <random>
 #include <unordered_map>
+#include <vector>
 
 namespace stellar
 {
@@ -56,6 +59,17 @@ class RandomEvictionCache : public NonMovableOrCopyable
     // Each cache keeps some counters just to monitor its performance.
     Counters mCounters;
 
+    // If set, eviction draws from this engine instead of gRandomEngine, which
+    // is unsafe to use off the main thread
+    std::unique_ptr<stellar_default_random_engine> mRandom;
+
+    size_t
+    randomIndex(size_t sz)
+    {
+        return mRandom ? rand_uniform<size_t>(0, sz - 1, *mRandom)
+                       : rand_uniform<size_t>(0, sz - 1);
+    }
+
     // Randomly pick two elements and evict the less-recently-used one.
     void
     evictOne()
@@ -65,8 +79,8 @@ class RandomEvictionCache : public NonMovableOrCopyable
         {
             return;
         }
-        MapValueType*& vp1 = mValuePtrs.at(rand_uniform<size_t>(0, sz - 1));
-        MapValueType*& vp2 = mValuePtrs.at(rand_uniform<size_t>(0, sz - 1));
+        MapValueType*& vp1 = mValuePtrs.at(randomIndex(sz));
+        MapValueType*& vp2 = mValuePtrs.at(randomIndex(sz));
         MapValueType*& victim =
             (vp1->second.mLastAccess < vp2->second.mLastAccess ? vp1 : vp2);
         mValueMap.erase(victim->first);
@@ -76,7 +90,13 @@ class RandomEvictionCache : public NonMovableOrCopyable
     }
 
   public:
-    explicit RandomEvictionCache(size_t maxSize) : mMaxSize(maxSize)
+    // A cache used from more than one thread (under a lock) must pass
+    // `separatePRNG`.
+    explicit RandomEvictionCache(size_t maxSize, bool separatePRNG = false)
+        : mMaxSize(maxSize)
+        , mRandom(separatePRNG
+                      ? std::make_unique<stellar_default_random_engine>()
+                      : nullptr)
     {
         mValueMap.reserve(maxSize + 1);
         mValuePtrs.reserve(maxSize + 1);
@@ -181,6 +201,28 @@ class RandomEvictionCache : public NonMovableOrCopyable
         }
     }
 
+    // Keys of the (at most) `maxKeys` most recently used entries, most
+    // recently used first.
+    std::vector<K>
+    recentKeys(size_t maxKeys) const
+    {
+        std::vector<MapValueType const*> ptrs(mValuePtrs.begin(),
+                                              mValuePtrs.end());
+        auto n = std::min(maxKeys, ptrs.size());
+        std::partial_sort(ptrs.begin(), ptrs.begin() + n, ptrs.end(),
+                          [](MapValueType const* a, MapValueType const* b) {
+                              return a->second.mLastAccess >
+                                     b->second.mLastAccess;
+                          });
+        std::vector<K> keys;
+        keys.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            keys.emplace_back(ptrs[i]->first);
+        }
+        return keys;
+    }
+
     // `maybeGet` offers basic exception safety guarantee.
     // Returns a pointer to the value if the key exists,
     // and returns a nullptr otherwise.
@@ -6,7 +6,8 @@
 #include "lib/util/finally.h"
 #include "util/GlobalChecks.h"
 #include "util/Timer.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
+#include <cmath>
 
 namespace stellar
 {
@@ -27,6 +28,11 @@ class Scheduler::ActionQueue
 
     std::string mName;
     ActionType mType;
+    // Droppable actions waiting longer than this are dropped
+    nsecs mDropLatency;
+    ActionStats mStats;
+    // Stats of the action class of the queue, owned by the Scheduler
+    ActionStats& mClassStats;
     nsecs mTotalService{0};
     std::chrono::steady_clock::time_point mLastService;
     std::deque<Element> mActions;
@@ -40,9 +46,12 @@ class Scheduler::ActionQueue
 
   public:
     ActionQueue(std::string const& name, ActionType type,
-                std::list<Qptr>& idleList)
+                std::list<Qptr>& idleList, nsecs dropLatency,
+                ActionStats& classStats)
         : mName(name)
         , mType(type)
+        , mDropLatency(dropLatency)
+        , mClassStats(classStats)
         , mLastService(std::chrono::steady_clock::time_point::max())
         , mIdleList(idleList)
         , mIdlePosition(mIdleList.end())
@@ -85,6 +94,18 @@ class Scheduler::ActionQueue
         return mType;
     }
 
+    ActionStats const&
+    stats() const
+    {
+        return mStats;
+    }
+
+    void
+    setDropLatency(nsecs dropLatency)
+    {
+        mDropLatency = dropLatency;
+    }
+
     nsecs
     totalService() const
     {
@@ -121,15 +142,17 @@ class Scheduler::ActionQueue
     }
 
     size_t
-    tryTrim(nsecs latencyWindow, VirtualClock::time_point now)
+    tryTrim(VirtualClock::time_point now)
     {
         size_t n = 0;
         while (mType == ActionType::DROPPABLE_ACTION && !mActions.empty() &&
-               isOverloaded(latencyWindow, now))
+               isOverloaded(mDropLatency, now))
         {
             mActions.pop_front();
             n++;
         }
+        mStats.mDropped += n;
+        mClassStats.mDropped += n;
         return n;
     }
 
@@ -146,6 +169,10 @@ class Scheduler::ActionQueue
         ZoneScoped;
         ZoneText(mName.c_str(), mName.size());
         auto before = clock.now();
+        auto delay = std::chrono::duration_cast<nsecs>(
+            before - mActions.front().mEnqueueTime);
+        mStats.mQueueDelay.add(delay);
+        mClassStats.mQueueDelay.add(delay);
         Action action = std::move(mActions.front().mAction);
         mActions.pop_front();
 
@@ -154,12 +181,49 @@ class Scheduler::ActionQueue
             nsecs duration = std::chrono::duration_cast<nsecs>(after - before);
             mTotalService = std::max(mTotalService + duration, minTotalService);
             mLastService = after;
+            ++mStats.mRuns;
+            ++mClassStats.mRuns;
+            mStats.mRunTime.add(duration);
+            mClassStats.mRunTime.add(duration);
         });
 
         action();
     }
 };
 
+void
+Scheduler::LatencyHistogram::add(nsecs d)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    // Bucket i holds durations in [2^(i-1), 2^i) microseconds
+    size_t i = 0;
+    while (us > 0 && i + 1 < NUM_BUCKETS)
+    {
+        us >>= 1;
+        ++i;
+    }
+    ++mBuckets[i];
+    ++mCount;
+    mTotal += d;
+    mMax = std::max(mMax, d);
+}
+
+nsecs
+Scheduler::LatencyHistogram::quantile(double q) const
+{
+    auto rank = static_cast<size_t>(std::ceil(q * mCount));
+    size_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i)
+    {
+        seen += mBuckets[i];
+        if (seen >= rank && seen > 0)
+        {
+            return std::min<nsecs>(std::chrono::microseconds(1ULL << i), mMax);
+        }
+    }
+    return mMax;
+}
+
 Scheduler::Scheduler(VirtualClock& clock,
                      std::chrono::nanoseconds latencyWindow)
     : mRunnableActionQueues([](Qptr a, Qptr b) -> bool {
@@ -171,10 +235,47 @@ Scheduler::Scheduler(VirtualClock& clock,
     setOverloaded(false);
 }
 
+std::string
+Scheduler::actionClass(std::string const& name)
+{
+    return name.substr(0, name.find(' '));
+}
+
+nsecs
+Scheduler::dropLatency(std::string const& queueName) const
+{
+    auto it = mLatencySLOs.find(actionClass(queueName));
+    return it == mLatencySLOs.end() ? mLatencyWindow : it->second;
+}
+
+void
+Scheduler::setLatencySLOs(std::map<std::string, nsecs> slos)
+{
+    mLatencySLOs = std::move(slos);
+    for (auto& qp : mAllActionQueues)
+    {
+        qp.second->setDropLatency(dropLatency(qp.second->name()));
+    }
+}
+
+std::vector<Scheduler::QueueInfo>
+Scheduler::getQueueInfo() const
+{
+    std::vector<QueueInfo> res;
+    res.reserve(mAllActionQueues.size());
+    for (auto const& qp : mAllActionQueues)
+    {
+        auto const& q = qp.second;
+        res.emplace_back(
+            QueueInfo{q->name(), q->type(), q->size(), q->stats()});
+    }
+    return res;
+}
+
 void
 Scheduler::trimSingleActionQueue(Qptr q, VirtualClock::time_point now)
 {
-    size_t trimmed = q->tryTrim(mLatencyWindow, now);
+    size_t trimmed = q->tryTrim(now);
     mStats.mActionsDroppedDueToOverload += trimmed;
     mSize -= trimmed;
 }
@@ -235,7 +336,9 @@ Scheduler::enqueue(std::string&& name, Action&& action, ActionType type)
     if (qi == mAllActionQueues.end())
     {
         mStats.mQueuesActivatedFromFresh++;
-        auto q = std::make_shared<ActionQueue>(name, type, mIdleActionQueues);
+        auto q = std::make_shared<ActionQueue>(name, type, mIdleActionQueues,
+                                               dropLatency(name),
+                                               mClassStats[actionClass(name)]);
         qi = mAllActionQueues.emplace(key, q).first;
         mRunnableActionQueues.push(qi->second);
     }
@@ -4,6 +4,7 @@
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
+#include <array>
 #include <chrono>
 #include <functional>
 #include <list>
@@ -12,6 +13,7 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <vector>
 
 // This class implements a multi-queue scheduler for "actions" (deferred-work
 // callbacks that some subsystem wants to run "soon" on the main thread),
@@ -99,6 +101,15 @@
 //
 //   - We record the enqueue time and "droppability" of an action, to allow us
 //     to measure load level and perform load shedding.
+//
+//   - Droppable actions are dropped once they have waited longer than the
+//     latency window, or than the latency SLO of their action class if one is
+//     set. The action class of a queue is the first word of its name, eg.
+//     "TX" for "TX recvMessage".
+//
+// For each queue and each action class, we also keep the distribution of the
+// time actions wait in the queue and of the time they run, to see what holds
+// the main thread.
 
 namespace stellar
 {
@@ -115,6 +126,56 @@ class Scheduler
         DROPPABLE_ACTION
     };
 
+    // Distribution of durations, in power-of-two buckets of microseconds
+    class LatencyHistogram
+    {
+      public:
+        static constexpr size_t NUM_BUCKETS = 32;
+
+        void add(std::chrono::nanoseconds d);
+        // Upper bound of the bucket of the `q` quantile (0 < q <= 1), capped
+        // at the largest duration added
+        std::chrono::nanoseconds quantile(double q) const;
+
+        size_t
+        count() const
+        {
+            return mCount;
+        }
+        std::chrono::nanoseconds
+        total() const
+        {
+            return mTotal;
+        }
+        std::chrono::nanoseconds
+        max() const
+        {
+            return mMax;
+        }
+
+      private:
+        std::array<size_t, NUM_BUCKETS> mBuckets{};
+        size_t mCount{0};
+        std::chrono::nanoseconds mTotal{0};
+        std::chrono::nanoseconds mMax{0};
+    };
+
+    struct ActionStats
+    {
+        size_t mRuns{0};
+        size_t mDropped{0};
+        LatencyHistogram mQueueDelay;
+        LatencyHistogram mRunTime;
+    };
+
+    struct QueueInfo
+    {
+        std::string mName;
+        ActionType mType;
+        size_t mQueued;
+        ActionStats mStats;
+    };
+
     struct Stats
     {
         size_t mActionsEnqueued{0};
@@ -173,6 +234,15 @@ class Scheduler
 
     std::chrono::nanoseconds const mLatencyWindow;
 
+    // Latency SLOs by action class, replacing mLatencyWindow to drop the
+    // droppable actions of that class
+    std::map<std::string, std::chrono::nanoseconds> mLatencySLOs;
+
+    // Stats by action class, kept while queues come and go
+    std::map<std::string, ActionStats> mClassStats;
+
+    std::chrono::nanoseconds dropLatency(std::string const& queueName) const;
+
     // Largest totalService seen in any queue. This number will continuously
     // advance as queues are serviced; it exists to serve as the upper limit
     // of the window, from which mTotalServiceWindow is subtracted to derive
@@ -224,6 +294,22 @@ class Scheduler
     // overloaded)
     std::chrono::seconds getOverloadedDuration() const;
 
+    // Sets the latency SLOs by action class
+    void
+    setLatencySLOs(std::map<std::string, std::chrono::nanoseconds> slos);
+
+    // The action class of the queue `name`: its first word
+    static std::string actionClass(std::string const& name);
+
+    // Stats of the queues that are runnable or were recently idle
+    std::vector<QueueInfo> getQueueInfo() const;
+
+    std::map<std::string, ActionStats> const&
+    getClassStats() const
+    {
+        return mClassStats;
+    }
+
     size_t
     size() const
     {
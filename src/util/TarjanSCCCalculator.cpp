@@ -10,6 +10,11 @@
 // stock. Go have a look!
 //
 // https://en.wikipedia.org/wiki/Tarjan%27s_strongly_connected_components_algorithm
+//
+// The one departure is that the depth-first search keeps its own stack of
+// frames rather than recursing, since our graphs can hold paths thousands of
+// nodes long. Nodes are visited, and SCCs found, in the same order as with
+// the recursion.
 
 TarjanSCCCalculator::TarjanSCCCalculator()
 {
@@ -41,42 +46,71 @@ void
 TarjanSCCCalculator::scc(
     size_t i, std::function<BitSet const&(size_t)> const& getNodeSuccessors)
 {
-    auto& v = mNodes.at(i);
-    v.mIndex = mIndex;
-    v.mLowLink = mIndex;
-    mIndex++;
-    mStack.push_back(i);
-    v.mOnStack = true;
+    // A node whose successors are being visited, and the first of them not
+    // visited yet
+    struct Frame
+    {
+        size_t mNode;
+        BitSet const* mSuccessors;
+        size_t mNext;
+    };
+    std::vector<Frame> frames;
 
-    BitSet const& succ = getNodeSuccessors(i);
-    for (size_t j = 0; succ.nextSet(j); ++j)
+    auto visit = [&](size_t n) {
+        auto& v = mNodes.at(n);
+        v.mIndex = mIndex;
+        v.mLowLink = mIndex;
+        mIndex++;
+        mStack.push_back(n);
+        v.mOnStack = true;
+        frames.push_back(Frame{n, &getNodeSuccessors(n), 0});
+    };
+
+    visit(i);
+    while (!frames.empty())
     {
-        LOG_TRACE(DEFAULT_LOG, "TarjanSCC edge: {} -> {}", i, j);
-        SCCNode& w = mNodes.at(j);
-        if (w.mIndex == -1)
+        auto& frame = frames.back();
+        size_t n = frame.mNode;
+        auto& v = mNodes.at(n);
+        size_t j = frame.mNext;
+        if (frame.mSuccessors->nextSet(j))
         {
-            scc(j, getNodeSuccessors);
-            v.mLowLink = std::min(v.mLowLink, w.mLowLink);
+            frame.mNext = j + 1;
+            LOG_TRACE(DEFAULT_LOG, "TarjanSCC edge: {} -> {}", n, j);
+            SCCNode& w = mNodes.at(j);
+            if (w.mIndex == -1)
+            {
+                // Invalidates `frame`; the low link of `v` is updated from
+                // that of `w` once `w` is done
+                visit(j);
+            }
+            else if (w.mOnStack)
+            {
+                v.mLowLink = std::min(v.mLowLink, w.mIndex);
+            }
+            continue;
         }
-        else if (w.mOnStack)
+
+        if (v.mLowLink == v.mIndex)
         {
-            v.mLowLink = std::min(v.mLowLink, w.mIndex);
+            BitSet newScc;
+            newScc.set(n);
+            size_t k = 0;
+            do
+            {
+                k = mStack.back();
+                newScc.set(k);
+                mStack.pop_back();
+                mNodes.at(k).mOnStack = false;
+            } while (k != n);
+            LOG_TRACE(DEFAULT_LOG, "TarjanSCC SCC: {}", newScc);
+            mSCCs.push_back(newScc);
         }
-    }
-
-    if (v.mLowLink == v.mIndex)
-    {
-        BitSet newScc;
-        newScc.set(i);
-        size_t j = 0;
-        do
+        frames.pop_back();
+        if (!frames.empty())
         {
-            j = mStack.back();
-            newScc.set(j);
-            mStack.pop_back();
-            mNodes.at(j).mOnStack = false;
-        } while (j != i);
-        LOG_TRACE(DEFAULT_LOG, "TarjanSCC SCC: {}", newScc);
-        mSCCs.push_back(newScc);
+            auto& parent = mNodes.at(frames.back().mNode);
+            parent.mLowLink = std::min(parent.mLowLink, v.mLowLink);
+        }
     }
 }
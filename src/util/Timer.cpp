@@ -7,7 +7,7 @@
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
 #include "util/Scheduler.h"
-#include <Tracy.hpp>
+#include "util/ZoneProfiler.h"
 #include <chrono>
 #include <cstdio>
 #include <thread>
@@ -81,26 +81,11 @@ VirtualClock::maybeSetRealtimer()
     }
 }
 
-bool
-VirtualClockEventCompare::operator()(shared_ptr<VirtualClockEvent> a,
-                                     shared_ptr<VirtualClockEvent> b)
-{
-    return *a < *b;
-}
-
 VirtualClock::time_point
 VirtualClock::next() const
 {
     releaseAssert(threadIsMain());
-    VirtualClock::time_point least = time_point::max();
-    if (!mEvents.empty())
-    {
-        if (mEvents.top()->mWhen < least)
-        {
-            least = mEvents.top()->mWhen;
-        }
-    }
-    return least;
+    return mEvents.next();
 }
 
 VirtualClock::system_time_point
@@ -197,45 +182,21 @@ VirtualClock::enqueue(shared_ptr<VirtualClockEvent> ve)
         return;
     }
     releaseAssert(threadIsMain());
-    mEvents.emplace(ve);
+    mEvents.add(ve);
     maybeSetRealtimer();
 }
 
 void
-VirtualClock::flushCancelledEvents()
+VirtualClock::dequeue(shared_ptr<VirtualClockEvent> const& ve)
 {
-    ZoneScoped;
     if (mDestructing)
     {
         return;
     }
-    if (mFlushesIgnored <= mEvents.size())
-    {
-        // Flushing all the canceled events immediately can lead to
-        // a O(n^2) loop if many events in the queue are canceled one a time.
-        //
-        // By ignoring O(n) flushes, we batch the iterations together and
-        // restore O(n) performance.
-        mFlushesIgnored++;
-        return;
-    }
     releaseAssert(threadIsMain());
-
-    auto toKeep = vector<shared_ptr<VirtualClockEvent>>();
-    toKeep.reserve(mEvents.size());
-
-    while (!mEvents.empty())
-    {
-        auto const& e = mEvents.top();
-        if (!e->getTriggered())
-        {
-            toKeep.emplace_back(e);
-        }
-        mEvents.pop();
-    }
-    mFlushesIgnored = 0;
-    mEvents = PrQueue(toKeep.begin(), toKeep.end());
-    maybeSetRealtimer();
+    // Leaves the real timer as it is: waking up early to find nothing due
+    // costs less than rearming it on every cancellation
+    mEvents.remove(ve);
 }
 
 bool
@@ -244,15 +205,12 @@ VirtualClock::cancelAllEvents()
     ZoneScoped;
     releaseAssert(threadIsMain());
 
-    bool wasEmpty = mEvents.empty();
-    while (!mEvents.empty())
+    auto events = mEvents.clear();
+    for (auto const& ev : events)
     {
-        auto ev = mEvents.top();
-        mEvents.pop();
         ev->cancel();
     }
-    mEvents = PrQueue();
-    return !wasEmpty;
+    return !events.empty();
 }
 
 void
@@ -483,6 +441,12 @@ VirtualClock::actionQueueIsOverloaded() const
     return mActionScheduler->getOverloadedDuration().count() != 0;
 }
 
+Scheduler&
+VirtualClock::getActionScheduler()
+{
+    return *mActionScheduler;
+}
+
 Scheduler::ActionType
 VirtualClock::currentSchedulerActionType() const
 {
@@ -511,18 +475,10 @@ VirtualClock::advanceToNow()
     }
     releaseAssert(threadIsMain());
 
-    auto n = now();
-    vector<shared_ptr<VirtualClockEvent>> toDispatch;
-    while (!mEvents.empty())
-    {
-        if (mEvents.top()->mWhen > n)
-            break;
-        toDispatch.push_back(mEvents.top());
-        mEvents.pop();
-    }
-    // Keep the dispatch loop separate from the pop()-ing loop
-    // so the triggered events can't mutate the priority queue
-    // from underneath us while we are looping.
+    // Events are all taken out before any is triggered, so that the
+    // triggered events can't mutate the wheel from underneath us while we
+    // are looping.
+    auto toDispatch = mEvents.popDue(now());
     for (auto ev : toDispatch)
     {
         ev->trigger();
@@ -628,9 +584,9 @@ VirtualTimer::cancel()
         mCancelled = true;
         for (auto ev : mEvents)
         {
+            mClock.dequeue(ev);
             ev->cancel();
         }
-        mClock.flushCancelledEvents();
         mEvents.clear();
     }
 }
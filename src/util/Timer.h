@@ -10,6 +10,7 @@
 #include "util/asio.h"
 #include "util/NonCopyable.h"
 #include "util/Scheduler.h"
+#include "util/TimerWheel.h"
 
 #include <chrono>
 #include <ctime>
@@ -52,12 +53,6 @@ namespace stellar
 class VirtualTimer;
 class Application;
 class VirtualClockEvent;
-class VirtualClockEventCompare
-{
-  public:
-    bool operator()(std::shared_ptr<VirtualClockEvent> a,
-                    std::shared_ptr<VirtualClockEvent> b);
-};
 
 extern const std::chrono::seconds SCHEDULER_LATENCY_WINDOW;
 
@@ -146,7 +141,7 @@ class VirtualClock
     // thread will dequeue (immediately re-enqueueing into the Scheduler for
     // further time-slicing / load-shedding).
     //
-    // The third is a priority queue of VirtualClockEvents, which is the part of
+    // The third is a timing wheel of VirtualClockEvents, which is the part of
     // the VirtualClock that manages the progress of virtual time and the
     // dispatch of timers as virtual time advances past them.
     std::chrono::steady_clock::time_point mLastDispatchStart;
@@ -157,12 +152,7 @@ class VirtualClock
         std::tuple<std::function<void()>, std::string, Scheduler::ActionType>>
         mPendingActionQueue;
 
-    using PrQueue =
-        std::priority_queue<std::shared_ptr<VirtualClockEvent>,
-                            std::vector<std::shared_ptr<VirtualClockEvent>>,
-                            VirtualClockEventCompare>;
-    PrQueue mEvents;
-    size_t mFlushesIgnored = 0;
+    TimerWheel mEvents;
 
     bool mDestructing{false};
 
@@ -196,7 +186,8 @@ class VirtualClock
     system_time_point system_now() const noexcept;
 
     void enqueue(std::shared_ptr<VirtualClockEvent> ve);
-    void flushCancelledEvents();
+    // Takes a cancelled event out of the queue right away
+    void dequeue(std::shared_ptr<VirtualClockEvent> const& ve);
     bool cancelAllEvents();
 
     // Only valid with VIRTUAL_TIME: sets the current value of the
@@ -218,6 +209,9 @@ class VirtualClock
     size_t getActionQueueSize() const;
     bool actionQueueIsOverloaded() const;
     Scheduler::ActionType currentSchedulerActionType() const;
+
+    // Only to be used from the main thread, like the Scheduler itself
+    Scheduler& getActionScheduler();
 };
 
 class VirtualClockEvent : public NonMovableOrCopyable
@@ -228,6 +222,8 @@ class VirtualClockEvent : public NonMovableOrCopyable
   public:
     VirtualClock::time_point mWhen;
     size_t mSeq;
+    // Owned by the clock's TimerWheel
+    TimerWheelPosition mWheelPos;
     VirtualClockEvent(VirtualClock::time_point when, size_t seq,
                       std::function<void(asio::error_code)> callback);
     bool getTriggered();
@@ -0,0 +1,276 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/TimerWheel.h"
+#include "util/Timer.h"
+
+#include <algorithm>
+
+namespace stellar
+{
+
+using Where = TimerWheelPosition::Where;
+
+bool
+TimerWheel::DueOrder::operator()(EventPtr const& a, EventPtr const& b) const
+{
+    return a->mWhen < b->mWhen ||
+           (a->mWhen == b->mWhen &&
+            a->mWheelPos.mOrder < b->mWheelPos.mOrder);
+}
+
+uint64_t
+TimerWheel::tickOf(time_point t)
+{
+    auto ticks =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            t.time_since_epoch()) /
+        TICK;
+    return ticks < 0 ? 0 : static_cast<uint64_t>(ticks);
+}
+
+void
+TimerWheel::file(Slot& from, Slot::iterator it)
+{
+    auto& pos = (*it)->mWheelPos;
+    auto tick = tickOf((*it)->mWhen);
+    if (tick <= mTick)
+    {
+        pos.mWhere = Where::DUE;
+        mDue.emplace(*it);
+        from.erase(it);
+        return;
+    }
+
+    // The lowest level whose slots span the ticks between mTick and `tick`
+    for (size_t level = 0; level < LEVELS; ++level)
+    {
+        auto shift = SLOT_BITS * (level + 1);
+        if ((tick >> shift) == (mTick >> shift))
+        {
+            auto index = (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+            auto& slot = mSlots[level][index];
+            slot.splice(slot.end(), from, it);
+            mOccupied[level] |= uint64_t(1) << index;
+            pos.mWhere = Where::SLOT;
+            pos.mLevel = static_cast<uint8_t>(level);
+            pos.mIndex = static_cast<uint8_t>(index);
+            pos.mIt = it;
+            return;
+        }
+    }
+    mBeyond.splice(mBeyond.end(), from, it);
+    pos.mWhere = Where::BEYOND;
+    pos.mIt = it;
+}
+
+void
+TimerWheel::refileSlot(size_t level, size_t index)
+{
+    Slot events;
+    events.swap(mSlots[level][index]);
+    mOccupied[level] &= ~(uint64_t(1) << index);
+    while (!events.empty())
+    {
+        file(events, events.begin());
+    }
+}
+
+void
+TimerWheel::advance(uint64_t tick)
+{
+    if (tick <= mTick)
+    {
+        return;
+    }
+
+    // The highest level whose current slot changes, LEVELS if `tick` is
+    // beyond the span of the top level
+    size_t top = 0;
+    while (top < LEVELS && (tick >> (SLOT_BITS * (top + 1))) !=
+                               (mTick >> (SLOT_BITS * (top + 1))))
+    {
+        ++top;
+    }
+    auto const prev = mTick;
+    mTick = tick;
+    mNext.reset();
+
+    // Time goes past all of the slots of the levels below
+    for (size_t level = 0; level < std::min(top, LEVELS); ++level)
+    {
+        for (size_t i = 0; mOccupied[level] != 0 && i < SLOTS; ++i)
+        {
+            if (mOccupied[level] & (uint64_t(1) << i))
+            {
+                refileSlot(level, i);
+            }
+        }
+    }
+
+    if (top < LEVELS)
+    {
+        // And past the slots of this level up to the one it reaches
+        auto from = (prev >> (SLOT_BITS * top)) & (SLOTS - 1);
+        auto to = (tick >> (SLOT_BITS * top)) & (SLOTS - 1);
+        for (auto i = from + 1; i <= to; ++i)
+        {
+            if (mOccupied[top] & (uint64_t(1) << i))
+            {
+                refileSlot(top, i);
+            }
+        }
+    }
+    else
+    {
+        Slot events;
+        events.swap(mBeyond);
+        while (!events.empty())
+        {
+            file(events, events.begin());
+        }
+    }
+}
+
+void
+TimerWheel::add(EventPtr const& ev)
+{
+    ev->mWheelPos.mOrder = mNextOrder++;
+    ++mSize;
+    Slot events{ev};
+    file(events, events.begin());
+    if (ev->mWheelPos.mWhere != Where::DUE && mNext && ev->mWhen < *mNext)
+    {
+        mNext = ev->mWhen;
+    }
+}
+
+void
+TimerWheel::remove(EventPtr const& ev)
+{
+    auto& pos = ev->mWheelPos;
+    switch (pos.mWhere)
+    {
+    case Where::NONE:
+        return;
+    case Where::DUE:
+        mDue.erase(ev);
+        break;
+    case Where::SLOT:
+    {
+        auto& slot = mSlots[pos.mLevel][pos.mIndex];
+        slot.erase(pos.mIt);
+        if (slot.empty())
+        {
+            mOccupied[pos.mLevel] &= ~(uint64_t(1) << pos.mIndex);
+        }
+        break;
+    }
+    case Where::BEYOND:
+        mBeyond.erase(pos.mIt);
+        break;
+    }
+    if (pos.mWhere != Where::DUE && mNext && ev->mWhen == *mNext)
+    {
+        mNext.reset();
+    }
+    pos.mWhere = Where::NONE;
+    --mSize;
+}
+
+TimerWheel::time_point
+TimerWheel::next() const
+{
+    if (!mDue.empty())
+    {
+        return (*mDue.begin())->mWhen;
+    }
+    if (mNext)
+    {
+        return *mNext;
+    }
+
+    // Slots only hold events of ticks after mTick, the ones of lower levels
+    // and, within a level, of lower slots coming first
+    auto res = time_point::max();
+    auto earliest = [&](Slot const& slot) {
+        for (auto const& ev : slot)
+        {
+            res = std::min(res, ev->mWhen);
+        }
+    };
+    size_t level = 0;
+    while (level < LEVELS && mOccupied[level] == 0)
+    {
+        ++level;
+    }
+    if (level < LEVELS)
+    {
+        size_t i = 0;
+        while ((mOccupied[level] & (uint64_t(1) << i)) == 0)
+        {
+            ++i;
+        }
+        earliest(mSlots[level][i]);
+    }
+    else
+    {
+        earliest(mBeyond);
+    }
+    mNext = res;
+    return res;
+}
+
+std::vector<TimerWheel::EventPtr>
+TimerWheel::popDue(time_point now)
+{
+    advance(tickOf(now));
+    std::vector<EventPtr> res;
+    while (!mDue.empty() && (*mDue.begin())->mWhen <= now)
+    {
+        auto it = mDue.begin();
+        (*it)->mWheelPos.mWhere = Where::NONE;
+        res.emplace_back(*it);
+        mDue.erase(it);
+        --mSize;
+    }
+    return res;
+}
+
+std::vector<TimerWheel::EventPtr>
+TimerWheel::clear()
+{
+    std::vector<EventPtr> res;
+    res.reserve(mSize);
+    auto take = [&](EventPtr const& ev) {
+        ev->mWheelPos.mWhere = Where::NONE;
+        res.emplace_back(ev);
+    };
+    for (auto const& ev : mDue)
+    {
+        take(ev);
+    }
+    mDue.clear();
+    for (size_t level = 0; level < LEVELS; ++level)
+    {
+        for (auto& slot : mSlots[level])
+        {
+            for (auto const& ev : slot)
+            {
+                take(ev);
+            }
+            slot.clear();
+        }
+        mOccupied[level] = 0;
+    }
+    for (auto const& ev : mBeyond)
+    {
+        take(ev);
+    }
+    mBeyond.clear();
+    mSize = 0;
+    mNext.reset();
+    return res;
+}
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace stellar
+{
+class VirtualClockEvent;
+
+// Where a VirtualClockEvent is filed in its clock's TimerWheel
+struct TimerWheelPosition
+{
+    enum class Where : uint8_t
+    {
+        NONE,
+        DUE,
+        SLOT,
+        BEYOND
+    };
+    Where mWhere{Where::NONE};
+    uint8_t mLevel{0};
+    uint8_t mIndex{0};
+    std::list<std::shared_ptr<VirtualClockEvent>>::iterator mIt;
+    // Insertion order, breaking ties between events due at the same time
+    uint64_t mOrder{0};
+};
+
+// The pending events of a VirtualClock, in a hierarchical timing wheel:
+// LEVELS wheels of SLOTS slots, a slot of level l spanning SLOTS^l ticks of
+// TICK. Events are filed in a slot according to how far their tick is from
+// the current one, and refiled into the levels below as time reaches their
+// slot, so that adding and removing an event is O(1), and expiring events
+// costs one move per level they go through. Events further away than the
+// span of the top level wait in a list of their own, refiled whenever the top
+// level wraps around.
+//
+// Expiry times are kept exact: the events of ticks that time has reached are
+// held in order of expiry time, then insertion, and only handed out once
+// their time has come.
+class TimerWheel : public NonMovableOrCopyable
+{
+  public:
+    using time_point = std::chrono::steady_clock::time_point;
+    using EventPtr = std::shared_ptr<VirtualClockEvent>;
+
+    static constexpr std::chrono::milliseconds TICK{1};
+    static constexpr size_t SLOT_BITS = 6;
+    static constexpr size_t SLOTS = size_t(1) << SLOT_BITS;
+    static constexpr size_t LEVELS = 4;
+
+  private:
+    using Slot = std::list<EventPtr>;
+
+    struct DueOrder
+    {
+        bool operator()(EventPtr const& a, EventPtr const& b) const;
+    };
+
+    std::array<std::array<Slot, SLOTS>, LEVELS> mSlots;
+    // Bit i of mOccupied[l] is set when mSlots[l][i] isn't empty
+    std::array<uint64_t, LEVELS> mOccupied{};
+    Slot mBeyond;
+    std::set<EventPtr, DueOrder> mDue;
+
+    // Tick that has been reached
+    uint64_t mTick{0};
+    uint64_t mNextOrder{0};
+    size_t mSize{0};
+    // Expiry of the earliest event out of mDue, if known
+    mutable std::optional<time_point> mNext;
+
+    static uint64_t tickOf(time_point t);
+    // Files the event at `it` in `from` relative to mTick
+    void file(Slot& from, Slot::iterator it);
+    void refileSlot(size_t level, size_t index);
+    void advance(uint64_t tick);
+
+  public:
+    void add(EventPtr const& ev);
+    // Does nothing if `ev` isn't in the wheel
+    void remove(EventPtr const& ev);
+
+    bool
+    empty() const
+    {
+        return mSize == 0;
+    }
+    size_t
+    size() const
+    {
+        return mSize;
+    }
+
+    // Expiry time of the earliest event, time_point::max() if there is none
+    time_point next() const;
+
+    // Removes the events due at `now`, in the order they are due
+    std::vector<EventPtr> popDue(time_point now);
+
+    // Removes all events
+    std::vector<EventPtr> clear();
+};
+}
@@ -0,0 +1,451 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/NonCopyable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace stellar
+{
+
+// Cache bounded by the total weight of its values (for example their size in
+// bytes, as computed by `Weigher`) rather than by their number, using the
+// W-TinyLFU policy from Einziger, Friedman and Manes, "TinyLFU: A Highly
+// Efficient Cache Admission Policy" (2017).
+//
+// New entries go into a small LRU window (1% of the weight). Entries that
+// fall out of the window compete for a place in the main segmented LRU
+// cache: a candidate is only admitted over the main cache's eviction victim
+// if it has been accessed more often recently, as estimated by a count-min
+// sketch of access frequencies that is periodically aged. One-off scans
+// therefore churn only the window instead of flushing frequently used
+// entries, and a few heavy values cannot displace many light but hot ones
+// unless they are used as often.
+//
+// The main cache is split into a probation segment, for entries accessed once
+// since admission, and a protected segment (80% of the main cache) for
+// entries accessed again.
+//
+// The interface and exception safety guarantees match RandomEvictionCache.
+template <typename K, typename V, typename Weigher, typename Hash = std::hash<K>>
+class TinyLFUCache : public NonMovableOrCopyable
+{
+  public:
+    struct Counters
+    {
+        uint64_t mHits{0};
+        uint64_t mMisses{0};
+        uint64_t mInserts{0};
+        uint64_t mUpdates{0};
+        uint64_t mEvicts{0};
+    };
+
+  private:
+    enum class Segment
+    {
+        WINDOW,
+        PROBATION,
+        PROTECTED
+    };
+
+    struct CacheValue;
+    using ListType = std::list<CacheValue*>;
+
+    struct CacheValue
+    {
+        V mValue;
+        size_t mWeight;
+        Segment mSegment;
+        typename ListType::iterator mPos;
+        // Points at the key of the map element holding this value, which is
+        // stable across rehashing
+        K const* mKey;
+    };
+    using MapType = std::unordered_map<K, CacheValue, Hash>;
+
+    // Count-min sketch with four rows of saturating 4-bit counters (stored
+    // one per byte). All counters are halved once the number of recorded
+    // accesses reaches ten times the width, so frequency estimates reflect
+    // recent history.
+    class FrequencySketch
+    {
+        static constexpr uint8_t MAX_COUNT = 15;
+        static constexpr size_t ROWS = 4;
+        size_t const mWidth;
+        std::vector<uint8_t> mTable;
+        uint64_t mAdditions{0};
+
+        static size_t
+        widthFor(size_t expectedEntries)
+        {
+            size_t width = 16;
+            while (width < expectedEntries)
+            {
+                width <<= 1;
+            }
+            return width;
+        }
+
+        static uint64_t
+        mix(uint64_t h, size_t row)
+        {
+            h += UINT64_C(0x9E3779B97F4A7C15) * (row + 1);
+            h = (h ^ (h >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+            h = (h ^ (h >> 27)) * UINT64_C(0x94D049BB133111EB);
+            return h ^ (h >> 31);
+        }
+
+        size_t
+        index(uint64_t h, size_t row) const
+        {
+            return row * mWidth + (mix(h, row) & (mWidth - 1));
+        }
+
+      public:
+        explicit FrequencySketch(size_t expectedEntries)
+            : mWidth(widthFor(expectedEntries)), mTable(ROWS * mWidth, 0)
+        {
+        }
+
+        uint8_t
+        estimate(uint64_t h) const
+        {
+            uint8_t res = MAX_COUNT;
+            for (size_t row = 0; row < ROWS; ++row)
+            {
+                res = std::min(res, mTable[index(h, row)]);
+            }
+            return res;
+        }
+
+        void
+        increment(uint64_t h)
+        {
+            bool added = false;
+            for (size_t row = 0; row < ROWS; ++row)
+            {
+                auto& c = mTable[index(h, row)];
+                if (c < MAX_COUNT)
+                {
+                    ++c;
+                    added = true;
+                }
+            }
+            if (added && ++mAdditions >= 10 * mWidth)
+            {
+                for (auto& c : mTable)
+                {
+                    c >>= 1;
+                }
+                mAdditions /= 2;
+            }
+        }
+    };
+
+    size_t const mMaxWeight;
+    size_t const mWindowMaxWeight;
+    size_t const mMainMaxWeight;
+    size_t const mProtectedMaxWeight;
+    Weigher mWeigher;
+    Hash mHash;
+
+    MapType mValueMap;
+    ListType mWindow;
+    ListType mProbation;
+    ListType mProtected;
+    size_t mWindowWeight{0};
+    size_t mProbationWeight{0};
+    size_t mProtectedWeight{0};
+    FrequencySketch mSketch;
+
+    Counters mCounters;
+
+    ListType&
+    listFor(Segment seg)
+    {
+        switch (seg)
+        {
+        case Segment::WINDOW:
+            return mWindow;
+        case Segment::PROBATION:
+            return mProbation;
+        default:
+            return mProtected;
+        }
+    }
+
+    size_t&
+    weightFor(Segment seg)
+    {
+        switch (seg)
+        {
+        case Segment::WINDOW:
+            return mWindowWeight;
+        case Segment::PROBATION:
+            return mProbationWeight;
+        default:
+            return mProtectedWeight;
+        }
+    }
+
+    // Moves `cv` to the most recently used end of `seg`. Does not throw, as
+    // std::list::splice does not.
+    void
+    moveTo(CacheValue& cv, Segment seg)
+    {
+        auto& dst = listFor(seg);
+        dst.splice(dst.begin(), listFor(cv.mSegment), cv.mPos);
+        weightFor(cv.mSegment) -= cv.mWeight;
+        weightFor(seg) += cv.mWeight;
+        cv.mSegment = seg;
+        cv.mPos = dst.begin();
+    }
+
+    void
+    evict(CacheValue& cv)
+    {
+        weightFor(cv.mSegment) -= cv.mWeight;
+        listFor(cv.mSegment).erase(cv.mPos);
+        mValueMap.erase(*cv.mKey);
+        ++mCounters.mEvicts;
+    }
+
+    void
+    onHit(CacheValue& cv)
+    {
+        mSketch.increment(mHash(*cv.mKey));
+        moveTo(cv, cv.mSegment == Segment::WINDOW ? Segment::WINDOW
+                                                  : Segment::PROTECTED);
+        demoteProtected();
+    }
+
+    void
+    demoteProtected()
+    {
+        while (mProtectedWeight > mProtectedMaxWeight)
+        {
+            moveTo(*mProtected.back(), Segment::PROBATION);
+        }
+    }
+
+    // The least recently used entry of the main cache, preferring probation
+    CacheValue*
+    mainVictim() const
+    {
+        if (!mProbation.empty())
+        {
+            return mProbation.back();
+        }
+        return mProtected.empty() ? nullptr : mProtected.back();
+    }
+
+    // Moves entries that overflow the window into the main cache, evicting
+    // whichever of the candidate and the main cache's victims is used less.
+    void
+    maintain()
+    {
+        while (mWindowWeight > mWindowMaxWeight)
+        {
+            CacheValue* candidate = mWindow.back();
+            size_t w = candidate->mWeight;
+            if (w > mMainMaxWeight)
+            {
+                evict(*candidate);
+                continue;
+            }
+
+            auto candidateFreq = mSketch.estimate(mHash(*candidate->mKey));
+            bool admit = true;
+            while (mProbationWeight + mProtectedWeight + w > mMainMaxWeight)
+            {
+                CacheValue* victim = mainVictim();
+                if (candidateFreq > mSketch.estimate(mHash(*victim->mKey)))
+                {
+                    evict(*victim);
+                }
+                else
+                {
+                    admit = false;
+                    break;
+                }
+            }
+
+            if (admit)
+            {
+                moveTo(*candidate, Segment::PROBATION);
+            }
+            else
+            {
+                evict(*candidate);
+            }
+        }
+    }
+
+  public:
+    // `expectedEntries` sizes the frequency sketch; a rough estimate of the
+    // number of entries that fit in `maxWeight` is enough.
+    TinyLFUCache(size_t maxWeight, size_t expectedEntries,
+                 Weigher weigher = Weigher())
+        : mMaxWeight(maxWeight)
+        , mWindowMaxWeight(std::max<size_t>(1, maxWeight / 100))
+        , mMainMaxWeight(maxWeight - std::min(maxWeight, mWindowMaxWeight))
+        , mProtectedMaxWeight(mMainMaxWeight / 5 * 4)
+        , mWeigher(weigher)
+        , mSketch(expectedEntries)
+    {
+    }
+
+    size_t
+    maxWeight() const
+    {
+        return mMaxWeight;
+    }
+
+    size_t
+    weight() const
+    {
+        return mWindowWeight + mProbationWeight + mProtectedWeight;
+    }
+
+    size_t
+    size() const
+    {
+        return mValueMap.size();
+    }
+
+    Counters const&
+    getCounters() const
+    {
+        return mCounters;
+    }
+
+    // `put` does not offer exception safety. If it throws an exception,
+    // cache may be in an inconsistent state. It is, therefore,
+    // client's responsibility to handle failures correctly.
+    void
+    put(K const& k, V const& v)
+    {
+        size_t w = mWeigher(v);
+        auto it = mValueMap.find(k);
+        if (it != mValueMap.end())
+        {
+            auto& cv = it->second;
+            cv.mValue = v;
+            weightFor(cv.mSegment) += w;
+            weightFor(cv.mSegment) -= cv.mWeight;
+            cv.mWeight = w;
+            ++mCounters.mUpdates;
+            onHit(cv);
+            maintain();
+            // A heavier value may have pushed the main cache over its limit
+            while (mProbationWeight + mProtectedWeight > mMainMaxWeight)
+            {
+                evict(*mainVictim());
+            }
+            return;
+        }
+
+        mSketch.increment(mHash(k));
+        if (w > mMaxWeight)
+        {
+            return;
+        }
+
+        auto pair = mValueMap.emplace(
+            k, CacheValue{v, w, Segment::WINDOW, mWindow.end(), nullptr});
+        auto& inserted = *pair.first;
+        inserted.second.mKey = &inserted.first;
+        mWindow.push_front(&inserted.second);
+        inserted.second.mPos = mWindow.begin();
+        mWindowWeight += w;
+        ++mCounters.mInserts;
+        maintain();
+    }
+
+    // `exists` offers strong exception safety guarantee.
+    bool
+    exists(K const& k, bool countMisses = true)
+    {
+        bool miss = (mValueMap.find(k) == mValueMap.end());
+        if (miss && countMisses)
+        {
+            ++mCounters.mMisses;
+        }
+        return !miss;
+    }
+
+    // `clear` does not throw. Frequency history is kept.
+    void
+    clear()
+    {
+        mWindow.clear();
+        mProbation.clear();
+        mProtected.clear();
+        mValueMap.clear();
+        mWindowWeight = 0;
+        mProbationWeight = 0;
+        mProtectedWeight = 0;
+    }
+
+    // Keys of (at most) `maxKeys` entries, those of the protected segment
+    // first, then of the window and of probation, each from the most
+    // recently used.
+    std::vector<K>
+    recentKeys(size_t maxKeys) const
+    {
+        std::vector<K> keys;
+        for (auto const* list : {&mProtected, &mWindow, &mProbation})
+        {
+            for (auto const* cv : *list)
+            {
+                if (keys.size() >= maxKeys)
+                {
+                    return keys;
+                }
+                keys.emplace_back(*cv->mKey);
+            }
+        }
+        return keys;
+    }
+
+    // `maybeGet` offers basic exception safety guarantee.
+    // Returns a pointer to the value if the key exists,
+    // and returns a nullptr otherwise.
+    V*
+    maybeGet(K const& k)
+    {
+        auto it = mValueMap.find(k);
+        if (it != mValueMap.end())
+        {
+            ++mCounters.mHits;
+            onHit(it->second);
+            return &it->second.mValue;
+        }
+        else
+        {
+            ++mCounters.mMisses;
+            return nullptr;
+        }
+    }
+
+    // `get` offers basic exception safety guarantee.
+    V&
+    get(K const& k)
+    {
+        V* result = maybeGet(k);
+        if (result == nullptr)
+        {
+            throw std::range_error("There is no such key in cache");
+        }
+        return *result;
+    }
+};
+}
@@ -9,14 +9,15 @@
 #include "main/Config.h"
 #include "util/Fs.h"
 #include "util/Logging.h"
+#include "util/ZoneProfiler.h"
 
-#include <Tracy.hpp>
 #include <fmt/format.h>
 
 namespace stellar
 {
 
 TmpDir::TmpDir(std::string const& prefix)
+    : mSubdirs(std::make_unique<Subdirs>())
 {
     ZoneScoped;
     size_t attempts = 0;
@@ -36,7 +37,21 @@ TmpDir::TmpDir(std::string const& prefix)
     }
 }
 
-TmpDir::TmpDir(TmpDir&& other) : mPath(std::move(other.mPath))
+TmpDir::TmpDir(std::string const& path, bool keep)
+    : mKeep(keep), mSubdirs(std::make_unique<Subdirs>())
+{
+    if (!fs::mkpath(path))
+    {
+        throw std::runtime_error(
+            fmt::format(FMT_STRING("Could not create directory {}"), path));
+    }
+    mPath = std::make_unique<std::string>(path);
+}
+
+TmpDir::TmpDir(TmpDir&& other)
+    : mPath(std::move(other.mPath))
+    , mKeep(other.mKeep)
+    , mSubdirs(std::move(other.mSubdirs))
 {
 }
 
@@ -46,10 +61,27 @@ TmpDir::getName() const
     return *mPath;
 }
 
+std::optional<std::string>
+TmpDir::makeSubdir(std::string const& rel) const
+{
+    ZoneScoped;
+    auto path = *mPath + "/" + rel;
+    std::lock_guard<std::mutex> guard(mSubdirs->mMutex);
+    if (mSubdirs->mMade.find(rel) == mSubdirs->mMade.end())
+    {
+        if (!fs::mkpath(path))
+        {
+            return std::nullopt;
+        }
+        mSubdirs->mMade.emplace(rel);
+    }
+    return path;
+}
+
 TmpDir::~TmpDir()
 {
     ZoneScoped;
-    if (!mPath)
+    if (!mPath || mKeep)
     {
         return;
     }
@@ -5,19 +5,41 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <unordered_set>
 
 namespace stellar
 {
 class TmpDir
 {
     std::unique_ptr<std::string> mPath;
+    bool mKeep{false};
+
+    // Subdirectories made through makeSubdir, behind a pointer to keep
+    // TmpDir movable
+    struct Subdirs
+    {
+        std::mutex mMutex;
+        std::unordered_set<std::string> mMade;
+    };
+    std::unique_ptr<Subdirs> mSubdirs;
 
   public:
     TmpDir(std::string const& prefix);
+    // Use `path` itself, creating it if needed. With `keep` the directory is
+    // left in place when this is destroyed.
+    TmpDir(std::string const& path, bool keep);
     TmpDir(TmpDir&&);
     ~TmpDir();
     std::string const& getName() const;
+
+    // Path of `rel` under this directory, creating it unless it was already
+    // made through here, so that staging many files into the same
+    // subdirectories costs one mkdir each rather than one per file. Can be
+    // called from any thread. Returns nullopt if it couldn't be made.
+    std::optional<std::string> makeSubdir(std::string const& rel) const;
 };
 
 class TmpDirManager
@@ -10,9 +10,10 @@
 #include "util/Fs.h"
 #include "util/GlobalChecks.h"
 #include "util/Logging.h"
+#include "util/XDRUncheckedPut.h"
+#include "util/ZoneProfiler.h"
 #include "util/types.h"
 #include "xdrpp/marshal.h"
-#include <Tracy.hpp>
 
 #include <filesystem>
 #include <fstream>
@@ -33,8 +34,10 @@ class XDRInputFileStream
 {
     std::ifstream mIn;
     std::vector<char> mBuf;
+    std::vector<char> mReadBuf;
     size_t mSizeLimit;
     size_t mSize;
+    size_t mLastReadSize{0};
 
   public:
     XDRInputFileStream(unsigned int sizeLimit = 0)
@@ -49,6 +52,16 @@ class XDRInputFileStream
         mIn.close();
     }
 
+    // Makes the underlying file buffer read `size` bytes at a time, for long
+    // sequential scans. Must be called before open.
+    void
+    setReadBufferSize(size_t size)
+    {
+        releaseAssert(!mIn.is_open());
+        mReadBuf.resize(size);
+        mIn.rdbuf()->pubsetbuf(mReadBuf.data(), mReadBuf.size());
+    }
+
     void
     open(std::string const& filename)
     {
@@ -151,9 +164,18 @@ class XDRInputFileStream
 
         xdr::xdr_get g(mBuf.data(), mBuf.data() + sz);
         xdr::xdr_argpack_archive(g, out);
+        mLastReadSize = sz;
         return true;
     }
 
+    // Serialized form of the object most recently decoded by readOne. Only
+    // valid until the next read from this stream.
+    ByteSlice
+    lastReadBytes() const
+    {
+        return ByteSlice(mBuf.data(), mLastReadSize);
+    }
+
     // `readPage` reads records of XDR type `T` from the stream into output
     // variable `out`, until it has exceeded `pageSize` bytes or until it finds
     // an `out` value for which `getBucketLedgerKey(out) == key`. It returns
@@ -231,6 +253,14 @@ class XDROutputFileStream
     std::vector<char> mBuf;
     const bool mFsyncOnClose;
 
+    // Written pages are dropped from the page cache in chunks of this size
+    static constexpr size_t DROP_CACHE_CHUNK_SIZE = 32 * 1024 * 1024;
+
+    size_t mBytesWritten{0};
+    bool mPreallocated{false};
+    bool mDropCacheBehind{false};
+    size_t mCacheDroppedUpTo{0};
+
 #ifdef WIN32
     // Windows implementation assumes calls can't get interrupted
     fs::native_handle_t mHandle;
@@ -287,10 +317,20 @@ class XDROutputFileStream
                 "XDROutputFileStream::close() on non-open FILE*");
         }
         flush();
+        if (mPreallocated)
+        {
+            // Release space reserved past what was actually written
+            fs::truncateFile(getHandle(), mBytesWritten);
+        }
         if (mFsyncOnClose)
         {
             fs::flushFileChanges(getHandle());
         }
+        if (mDropCacheBehind)
+        {
+            fs::dropFileCache(getHandle(), mCacheDroppedUpTo,
+                              mBytesWritten - mCacheDroppedUpTo);
+        }
 #ifdef WIN32
         fclose(mOut);
         mOut = nullptr;
@@ -356,6 +396,9 @@ class XDROutputFileStream
                 "XDROutputFileStream::open() on already-open stream");
         }
         fs::native_handle_t handle = fs::openFileToWrite(filename);
+        mBytesWritten = 0;
+        mPreallocated = false;
+        mCacheDroppedUpTo = 0;
 #ifdef WIN32
         mOut = fs::fdOpen(handle);
         if (mOut != NULL)
@@ -377,6 +420,30 @@ class XDROutputFileStream
         return isOpen();
     }
 
+    // Reserves len bytes on disk for a file just opened with open(), for
+    // writers that know roughly how much they will write. Any reservation
+    // beyond what is written is released on close().
+    void
+    preallocate(size_t len)
+    {
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::preallocate() on non-open stream");
+        }
+        fs::preallocateFile(getHandle(), len);
+        mPreallocated = true;
+    }
+
+    // When set, pages are written back and dropped from the page cache as the
+    // file is written, so a large sequential write does not evict pages that
+    // other readers rely on.
+    void
+    setDropCacheBehind(bool dropCacheBehind)
+    {
+        mDropCacheBehind = dropCacheBehind;
+    }
+
     template <typename T>
     void
     writeOne(T const& t, SHA256* hasher = nullptr, size_t* bytesPut = nullptr)
@@ -402,15 +469,36 @@ class XDROutputFileStream
         mBuf[1] = static_cast<char>((sz >> 16) & 0xFF);
         mBuf[2] = static_cast<char>((sz >> 8) & 0xFF);
         mBuf[3] = static_cast<char>(sz & 0xFF);
-        xdr::xdr_put p(mBuf.data() + 4, mBuf.data() + 4 + sz);
-        xdr_argpack_archive(p, t);
+        xdrPutUnchecked(t, mBuf.data() + 4, mBuf.data() + 4 + sz);
+
+        writeBytes(mBuf.data(), sz + 4);
+        if (hasher)
+        {
+            hasher->add(ByteSlice(mBuf.data(), sz + 4));
+        }
+        if (bytesPut)
+        {
+            *bytesPut += (sz + 4);
+        }
+    }
 
-        size_t const to_write = sz + 4;
+    // Writes `len` bytes that are already XDR records, with their record
+    // marks, as writeOne would have written them
+    void
+    writeBytes(char const* data, size_t len)
+    {
+        ZoneScoped;
+        if (!isOpen())
+        {
+            FileSystemException::failWith(
+                "XDROutputFileStream::writeBytes() on non-open stream");
+        }
+        size_t const to_write = len;
         size_t written = 0;
         while (written < to_write)
         {
 #ifdef WIN32
-            auto w = fwrite(mBuf.data() + written, 1, to_write - written, mOut);
+            auto w = fwrite(data + written, 1, to_write - written, mOut);
             if (w == 0)
             {
                 FileSystemException::failWith(
@@ -419,7 +507,7 @@ class XDROutputFileStream
             written += w;
 #else
             asio::error_code ec;
-            auto buf = asio::buffer(mBuf.data() + written, to_write - written);
+            auto buf = asio::buffer(data + written, to_write - written);
             written += asio::write(mBufferedWriteStream, buf, ec);
             if (ec)
             {
@@ -437,13 +525,14 @@ class XDROutputFileStream
             }
 #endif
         }
-        if (hasher)
-        {
-            hasher->add(ByteSlice(mBuf.data(), sz + 4));
-        }
-        if (bytesPut)
+        mBytesWritten += to_write;
+        if (mDropCacheBehind &&
+            mBytesWritten - mCacheDroppedUpTo >= DROP_CACHE_CHUNK_SIZE)
         {
-            *bytesPut += (sz + 4);
+            flush();
+            fs::dropFileCache(getHandle(), mCacheDroppedUpTo,
+                              mBytesWritten - mCacheDroppedUpTo);
+            mCacheDroppedUpTo = mBytesWritten;
         }
     }
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/GlobalChecks.h"
+#include <cstring>
+#include <type_traits>
+#include <xdrpp/endian.h>
+#include <xdrpp/marshal.h>
+
+namespace stellar
+{
+
+// xdrpp-compatible archiver serializing into a buffer that is known to be
+// large enough, because it was sized with xdr::xdr_size of the very object
+// written. Unlike xdr::xdr_put, which checks that each field fits in what is
+// left of the buffer, it only checks once the whole object is written that
+// it took exactly the expected size, which takes the per-field branches out
+// of encoding large objects such as bucket entries, meta and overlay
+// messages. Decoding keeps xdr::xdr_get, as its input isn't trusted.
+struct XDRUncheckedPut
+{
+    unsigned char* mPos;
+
+    explicit XDRUncheckedPut(void* start)
+        : mPos(static_cast<unsigned char*>(start))
+    {
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_same<
+        std::uint32_t, typename xdr::xdr_traits<T>::uint_type>::value>::type
+    operator()(T t)
+    {
+        auto u = xdr::swap32le(xdr::xdr_traits<T>::to_uint(t));
+        std::memcpy(mPos, &u, sizeof(u));
+        mPos += sizeof(u);
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_same<
+        std::uint64_t, typename xdr::xdr_traits<T>::uint_type>::value>::type
+    operator()(T t)
+    {
+        auto u = xdr::swap64le(xdr::xdr_traits<T>::to_uint(t));
+        std::memcpy(mPos, &u, sizeof(u));
+        mPos += sizeof(u);
+    }
+
+    template <typename T>
+    typename std::enable_if<xdr::xdr_traits<T>::is_bytes>::type
+    operator()(const T& t)
+    {
+        size_t len = t.size();
+        if (xdr::xdr_traits<T>::variable_nelem)
+        {
+            (*this)(static_cast<uint32_t>(len));
+        }
+        if (len != 0)
+        {
+            std::memcpy(mPos, t.data(), len);
+            mPos += len;
+        }
+        size_t pad = (4 - (len & 3)) & 3;
+        std::memset(mPos, 0, pad);
+        mPos += pad;
+    }
+
+    template <typename T>
+    typename std::enable_if<xdr::xdr_traits<T>::is_class ||
+                            xdr::xdr_traits<T>::is_container>::type
+    operator()(const T& t)
+    {
+        xdr::xdr_traits<T>::save(*this, t);
+    }
+};
+
+// Serializes `t` into [start, end), which must be xdr::xdr_size(t) bytes
+template <typename T>
+void
+xdrPutUnchecked(T const& t, void* start, void* end)
+{
+    XDRUncheckedPut p(start);
+    xdr::xdr_argpack_archive(p, t);
+    releaseAssertOrThrow(p.mPos == static_cast<unsigned char*>(end));
+}
+}
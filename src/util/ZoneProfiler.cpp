@@ -0,0 +1,167 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/ZoneProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace stellar
+{
+
+namespace
+{
+// Sites beyond the first MAX_ZONES sampled share the last slot
+size_t constexpr MAX_ZONES = 4096;
+// How often threads look for sampling having been enabled
+uint32_t constexpr DISABLED_RECHECK = 1 << 16;
+
+struct Slot
+{
+    std::atomic<ZoneSite const*> mSite{nullptr};
+    std::atomic<uint64_t> mSamples{0};
+    std::atomic<uint64_t> mTotalNs{0};
+    std::atomic<uint64_t> mMaxNs{0};
+    std::array<std::atomic<uint64_t>, 32> mBuckets{};
+};
+
+std::array<Slot, MAX_ZONES + 1> gSlots;
+std::atomic<uint32_t> gNextSlot{0};
+std::atomic<uint32_t> gSamplePeriod{64};
+ZoneSite gOverflowSite{"(other zones)", "", 0};
+
+thread_local uint32_t tRandomState = 0x9e3779b9;
+
+// Uniform in [1, 2 * period - 1], so that zones are sampled once every
+// `period` on average without locking on to the period of a loop
+uint32_t
+nextCountdown(uint32_t period)
+{
+    tRandomState ^= tRandomState << 13;
+    tRandomState ^= tRandomState >> 17;
+    tRandomState ^= tRandomState << 5;
+    return 1 + tRandomState % (2 * period - 1);
+}
+
+Slot&
+getSlot(ZoneSite& site)
+{
+    auto slot = site.mSlot.load(std::memory_order_acquire);
+    if (slot == 0)
+    {
+        auto next = gNextSlot.fetch_add(1, std::memory_order_relaxed);
+        auto const* owner = next < MAX_ZONES ? &site : &gOverflowSite;
+        next = std::min<uint32_t>(next, MAX_ZONES);
+        gSlots[next].mSite.store(owner, std::memory_order_release);
+        // Another thread may get there first, wasting the slot taken here
+        uint32_t expected = 0;
+        if (site.mSlot.compare_exchange_strong(expected, next + 1,
+                                               std::memory_order_acq_rel))
+        {
+            slot = next + 1;
+        }
+        else
+        {
+            slot = expected;
+        }
+    }
+    return gSlots[slot - 1];
+}
+}
+
+uint64_t
+ZoneStats::quantileNs(double q) const
+{
+    auto rank = static_cast<uint64_t>(std::ceil(q * mSamples));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < mBuckets.size(); ++i)
+    {
+        seen += mBuckets[i];
+        if (seen >= rank && seen > 0)
+        {
+            return std::min<uint64_t>(2ULL << i, mMaxNs);
+        }
+    }
+    return mMaxNs;
+}
+
+void
+setZoneProfilerSamplePeriod(uint32_t period)
+{
+    gSamplePeriod.store(period, std::memory_order_relaxed);
+    SampledZone::tCountdown = 1;
+}
+
+uint32_t
+getZoneProfilerSamplePeriod()
+{
+    return gSamplePeriod.load(std::memory_order_relaxed);
+}
+
+void
+SampledZone::start(ZoneSite& site)
+{
+    auto period = gSamplePeriod.load(std::memory_order_relaxed);
+    if (period == 0)
+    {
+        tCountdown = DISABLED_RECHECK;
+        return;
+    }
+    tCountdown = nextCountdown(period);
+    mSite = &site;
+    mStart = std::chrono::steady_clock::now();
+}
+
+void
+SampledZone::finish()
+{
+    auto ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - mStart)
+            .count());
+    auto& slot = getSlot(*mSite);
+    slot.mSamples.fetch_add(1, std::memory_order_relaxed);
+    slot.mTotalNs.fetch_add(ns, std::memory_order_relaxed);
+    auto max = slot.mMaxNs.load(std::memory_order_relaxed);
+    while (ns > max && !slot.mMaxNs.compare_exchange_weak(
+                           max, ns, std::memory_order_relaxed))
+    {
+    }
+    size_t bucket = 0;
+    while (bucket + 1 < slot.mBuckets.size() && (ns >> (bucket + 1)) != 0)
+    {
+        ++bucket;
+    }
+    slot.mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<ZoneStats>
+getZoneStats()
+{
+    std::vector<ZoneStats> res;
+    for (auto const& slot : gSlots)
+    {
+        auto const* site = slot.mSite.load(std::memory_order_acquire);
+        auto samples = slot.mSamples.load(std::memory_order_relaxed);
+        if (site == nullptr || samples == 0)
+        {
+            continue;
+        }
+        ZoneStats stats{site->mName,
+                        site->mFile,
+                        site->mLine,
+                        samples,
+                        slot.mTotalNs.load(std::memory_order_relaxed),
+                        slot.mMaxNs.load(std::memory_order_relaxed),
+                        {}};
+        for (size_t i = 0; i < stats.mBuckets.size(); ++i)
+        {
+            stats.mBuckets[i] =
+                slot.mBuckets[i].load(std::memory_order_relaxed);
+        }
+        res.emplace_back(std::move(stats));
+    }
+    return res;
+}
+}
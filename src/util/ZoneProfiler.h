@@ -0,0 +1,118 @@
+#pragma once
+
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+// Include this instead of <Tracy.hpp>.
+//
+// In builds without Tracy, ZoneScoped and ZoneNamedN feed a sampling
+// profiler instead of compiling to nothing: one in about every
+// ZONE_PROFILER_SAMPLE_PERIOD zones entered by a thread is timed, and its
+// duration (including that of the zones nested in it) added to the
+// statistics of its call site, so that production nodes can tell where time
+// goes without a profiler attached. Zones that aren't sampled only
+// decrement a thread-local counter. With Tracy, the macros are Tracy's.
+
+#include <Tracy.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stellar
+{
+
+// Statically allocated for every zone in the code; mSlot is the index + 1
+// of its statistics, 0 until it is first sampled
+struct ZoneSite
+{
+    char const* const mName;
+    char const* const mFile;
+    uint32_t const mLine;
+    std::atomic<uint32_t> mSlot;
+
+    constexpr ZoneSite(char const* name, char const* file, uint32_t line)
+        : mName(name), mFile(file), mLine(line), mSlot(0)
+    {
+    }
+};
+
+struct ZoneStats
+{
+    std::string mName;
+    std::string mFile;
+    uint32_t mLine;
+    uint64_t mSamples;
+    uint64_t mTotalNs;
+    uint64_t mMaxNs;
+    // mBuckets[i] counts samples lasting [2^i, 2^(i+1)) ns
+    std::array<uint64_t, 32> mBuckets;
+
+    // Upper bound of the bucket of the `q` quantile (0 < q <= 1), capped at
+    // the longest sample
+    uint64_t quantileNs(double q) const;
+};
+
+// 0 disables sampling. Takes effect right away on the calling thread, and on
+// the others the next time they sample, or within 65536 zones if sampling
+// was disabled.
+void setZoneProfilerSamplePeriod(uint32_t period);
+uint32_t getZoneProfilerSamplePeriod();
+
+// Every zone sampled at least once since the start of the process. A zone
+// is estimated to have been entered mSamples * getZoneProfilerSamplePeriod()
+// times.
+std::vector<ZoneStats> getZoneStats();
+
+class SampledZone
+{
+    static inline thread_local uint32_t tCountdown = 1;
+
+    ZoneSite* mSite{nullptr};
+    std::chrono::steady_clock::time_point mStart;
+
+    void start(ZoneSite& site);
+    void finish();
+
+    friend void setZoneProfilerSamplePeriod(uint32_t period);
+
+  public:
+    explicit SampledZone(ZoneSite& site)
+    {
+        if (--tCountdown == 0)
+        {
+            start(site);
+        }
+    }
+
+    ~SampledZone()
+    {
+        if (mSite != nullptr)
+        {
+            finish();
+        }
+    }
+
+    SampledZone(SampledZone const&) = delete;
+    SampledZone& operator=(SampledZone const&) = delete;
+};
+}
+
+#if !defined(TRACY_ENABLE)
+#define STELLAR_ZONE_CONCAT_(a, b) a##b
+#define STELLAR_ZONE_CONCAT(a, b) STELLAR_ZONE_CONCAT_(a, b)
+#define STELLAR_SAMPLED_ZONE(name) \
+    static stellar::ZoneSite STELLAR_ZONE_CONCAT(stellarZoneSite, __LINE__){ \
+        name, __FILE__, static_cast<uint32_t>(__LINE__)}; \
+    stellar::SampledZone STELLAR_ZONE_CONCAT(stellarZone, __LINE__)( \
+        STELLAR_ZONE_CONCAT(stellarZoneSite, __LINE__))
+
+#undef ZoneScoped
+#define ZoneScoped STELLAR_SAMPLED_ZONE(__func__)
+#undef ZoneNamedN
+#define ZoneNamedN(varname, name, active) STELLAR_SAMPLED_ZONE(name)
+#endif
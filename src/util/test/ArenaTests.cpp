@@ -0,0 +1,80 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/Arena.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+using namespace stellar;
+
+TEST_CASE("Arena allocates aligned memory from blocks", "[arena]")
+{
+    Arena arena(256);
+
+    auto p1 = arena.allocate(1, 1);
+    auto p2 = arena.allocate(8, 8);
+    REQUIRE(reinterpret_cast<uintptr_t>(p2) % 8 == 0);
+    REQUIRE(p2 > p1);
+    REQUIRE(arena.getStats().allocations == 2);
+    REQUIRE(arena.getStats().bytesAllocated == 9);
+    REQUIRE(arena.getStats().blocks == 1);
+
+    // Doesn't fit in the rest of the first block
+    arena.allocate(250, 1);
+    REQUIRE(arena.getStats().blocks == 2);
+    REQUIRE(arena.getStats().bytesReserved == 512);
+
+    // Oversized allocations get their own block without replacing the
+    // current one
+    auto big = arena.allocate(1000, 16);
+    REQUIRE(reinterpret_cast<uintptr_t>(big) % 16 == 0);
+    REQUIRE(arena.getStats().blocks == 3);
+    REQUIRE(arena.getStats().bytesReserved == 1512);
+    arena.allocate(4, 4);
+    REQUIRE(arena.getStats().blocks == 3);
+}
+
+TEST_CASE("ArenaAllocator keeps the arena alive", "[arena]")
+{
+    auto before = Arena::getTotalStats();
+    std::shared_ptr<std::string> str;
+    std::weak_ptr<Arena> weakArena;
+    {
+        auto arena = std::make_shared<Arena>();
+        weakArena = arena;
+        str = std::allocate_shared<std::string>(
+            ArenaAllocator<std::string>(arena), "arena");
+
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                           ArenaAllocator<std::pair<int const, int>>>
+            map(0, ArenaAllocator<std::pair<int const, int>>(arena));
+        for (int i = 0; i < 100; ++i)
+        {
+            map.emplace(i, i);
+        }
+        REQUIRE(arena->getStats().allocations > 101);
+    }
+
+    REQUIRE(!weakArena.expired());
+    REQUIRE(*str == "arena");
+    REQUIRE(Arena::getTotalStats().allocations == before.allocations);
+
+    str.reset();
+    REQUIRE(weakArena.expired());
+    REQUIRE(Arena::getTotalStats().allocations > before.allocations + 101);
+}
+
+TEST_CASE("ArenaAllocator without an arena uses the heap", "[arena]")
+{
+    ArenaAllocator<int> alloc(nullptr);
+    auto p = alloc.allocate(10);
+    p[9] = 1;
+    alloc.deallocate(p, 10);
+    REQUIRE(alloc == ArenaAllocator<long>(nullptr));
+    REQUIRE(alloc != ArenaAllocator<int>(std::make_shared<Arena>()));
+}
@@ -0,0 +1,111 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "util/AsyncLogSink.h"
+
+#if defined(USE_SPDLOG)
+
+#include "lib/catch.hpp"
+
+#include <future>
+#include <mutex>
+#include <spdlog/sinks/base_sink.h>
+#include <string>
+#include <vector>
+
+using namespace stellar;
+
+namespace
+{
+// Records what it is given, and waits for `release` before writing anything
+// when it is set
+class RecordingSink : public spdlog::sinks::base_sink<std::mutex>
+{
+  public:
+    std::vector<std::string> mMessages;
+    std::shared_future<void> mRelease;
+
+  protected:
+    void
+    sink_it_(spdlog::details::log_msg const& msg) override
+    {
+        if (mRelease.valid())
+        {
+            mRelease.wait();
+        }
+        mMessages.emplace_back(msg.payload.data(), msg.payload.size());
+    }
+
+    void
+    flush_() override
+    {
+    }
+};
+}
+
+TEST_CASE("async log sink", "[log][asynclog]")
+{
+    auto recorder = std::make_shared<RecordingSink>();
+
+    SECTION("writes everything in order")
+    {
+        auto sink = std::make_shared<AsyncLogSink>(
+            std::vector<std::shared_ptr<spdlog::sinks::sink>>{recorder}, 1024);
+        spdlog::logger logger("test", sink);
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.info("message {}", i);
+        }
+        logger.flush();
+        REQUIRE(recorder->mMessages.size() == 100);
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(recorder->mMessages[i] == "message " + std::to_string(i));
+        }
+        REQUIRE(sink->getDroppedCount() == 0);
+
+        // Once stopped, messages are written right away
+        sink->stop();
+        logger.info("late");
+        REQUIRE(recorder->mMessages.back() == "late");
+    }
+
+    SECTION("drops and counts messages when full")
+    {
+        std::promise<void> release;
+        recorder->mRelease = release.get_future().share();
+        auto sink = std::make_shared<AsyncLogSink>(
+            std::vector<std::shared_ptr<spdlog::sinks::sink>>{recorder}, 4);
+        spdlog::logger logger("test", sink);
+        int const logged = 20;
+        for (int i = 0; i < logged; ++i)
+        {
+            logger.info("message {}", i);
+        }
+        // At most one message is being written, and four queued
+        REQUIRE(sink->getDroppedCount() >= logged - 5);
+        release.set_value();
+        logger.flush();
+        sink->stop();
+
+        auto dropped = sink->getDroppedCount();
+        size_t messages = 0;
+        size_t reports = 0;
+        for (auto const& m : recorder->mMessages)
+        {
+            if (m.find("message ") == 0)
+            {
+                ++messages;
+            }
+            else if (m.find("Dropped ") == 0)
+            {
+                ++reports;
+            }
+        }
+        REQUIRE(messages == logged - dropped);
+        REQUIRE(reports >= 1);
+    }
+}
+
+#endif
@@ -0,0 +1,172 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/BackgroundExecutor.h"
+
+#include "medida/counter.h"
+#include "medida/metrics_registry.h"
+
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace stellar;
+
+namespace
+{
+// An io_context run by `n` threads until it is destroyed
+class Workers
+{
+  public:
+    asio::io_context mCtx;
+
+  private:
+    asio::io_context::work mWork{mCtx};
+    std::vector<std::thread> mThreads;
+
+  public:
+    explicit Workers(size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            mThreads.emplace_back([this]() { mCtx.run(); });
+        }
+    }
+    ~Workers()
+    {
+        stop();
+    }
+
+    // Must be called before the executor using the threads is destroyed
+    void
+    stop()
+    {
+        mCtx.stop();
+        for (auto& t : mThreads)
+        {
+            if (t.joinable())
+            {
+                t.join();
+            }
+        }
+    }
+};
+}
+
+TEST_CASE("BackgroundExecutor starts the highest priority class first",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    Workers workers(1);
+    BackgroundExecutor executor(workers.mCtx, 1, metrics, {});
+
+    // Occupy the only thread so that everything below queues up
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    executor.post(BackgroundTaskClass::GENERAL, [&]() {
+        started.set_value();
+        released.wait();
+    });
+    started.get_future().wait();
+
+    std::mutex mtx;
+    std::vector<int> order;
+    std::promise<void> allDone;
+    auto record = [&](int v) {
+        return [&, v]() {
+            std::lock_guard<std::mutex> guard(mtx);
+            order.push_back(v);
+            if (order.size() == 5)
+            {
+                allDone.set_value();
+            }
+        };
+    };
+    executor.post(BackgroundTaskClass::VERIFY, record(5));
+    executor.post(BackgroundTaskClass::MERGE, record(3));
+    executor.post(BackgroundTaskClass::QUERY, record(1));
+    executor.post(BackgroundTaskClass::VERIFY, record(6));
+    executor.post(BackgroundTaskClass::GENERAL, record(2));
+    REQUIRE(executor.queueSize(BackgroundTaskClass::VERIFY) == 2);
+    REQUIRE(metrics.NewCounter({"background", "verify", "queued"}).count() ==
+            2);
+
+    release.set_value();
+    allDone.get_future().wait();
+    REQUIRE(order == std::vector<int>{1, 2, 3, 5, 6});
+    REQUIRE(executor.queueSize(BackgroundTaskClass::VERIFY) == 0);
+    workers.stop();
+}
+
+TEST_CASE("BackgroundExecutor keeps classes within their limit",
+          "[backgroundexecutor]")
+{
+    medida::MetricsRegistry metrics;
+    Workers workers(2);
+    BackgroundExecutor executor(workers.mCtx, 2, metrics,
+                                {{BackgroundTaskClass::VERIFY, 1}});
+
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> firstStarted;
+    std::promise<void> secondDone;
+    executor.post(BackgroundTaskClass::VERIFY, [&]() {
+        firstStarted.set_value();
+        released.wait();
+    });
+    firstStarted.get_future().wait();
+    executor.post(BackgroundTaskClass::VERIFY,
+                  [&]() { secondDone.set_value(); });
+
+    // The second thread is free but verifications are limited to one, it
+    // still runs other classes
+    std::promise<void> generalDone;
+    executor.post(BackgroundTaskClass::GENERAL,
+                  [&]() { generalDone.set_value(); });
+    generalDone.get_future().wait();
+    REQUIRE(executor.running(BackgroundTaskClass::VERIFY) == 1);
+    REQUIRE(executor.queueSize(BackgroundTaskClass::VERIFY) == 1);
+
+    release.set_value();
+    secondDone.get_future().wait();
+    REQUIRE(executor.queueSize(BackgroundTaskClass::VERIFY) == 0);
+    workers.stop();
+}
+
+TEST_CASE("BackgroundExecutor keeps running after a job throws",
+          "[backgroundexecutor]")
+{
+    // Run the io_context on this thread to see the exception
+    medida::MetricsRegistry metrics;
+    asio::io_context ctx;
+    BackgroundExecutor executor(ctx, 1, metrics, {});
+
+    bool ran = false;
+    executor.post(BackgroundTaskClass::GENERAL,
+                  []() { throw std::runtime_error("job failed"); });
+    executor.post(BackgroundTaskClass::GENERAL, [&]() { ran = true; });
+    REQUIRE_THROWS_AS(ctx.poll(), std::runtime_error);
+    REQUIRE(executor.running(BackgroundTaskClass::GENERAL) == 0);
+
+    ctx.restart();
+    ctx.poll();
+    REQUIRE(ran);
+    REQUIRE(executor.queueSize(BackgroundTaskClass::GENERAL) == 0);
+}
+
+TEST_CASE("BackgroundExecutor class names", "[backgroundexecutor]")
+{
+    for (auto cls : {BackgroundTaskClass::QUERY, BackgroundTaskClass::PREFETCH,
+                     BackgroundTaskClass::GENERAL, BackgroundTaskClass::MERGE,
+                     BackgroundTaskClass::INDEX, BackgroundTaskClass::VERIFY})
+    {
+        REQUIRE(backgroundTaskClassFromName(backgroundTaskClassName(cls)) ==
+                cls);
+    }
+    REQUIRE(!backgroundTaskClassFromName("hashing"));
+}
@@ -0,0 +1,92 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "crypto/ShortHash.h"
+#include "lib/catch.hpp"
+#include "util/BinaryFuseFilter.h"
+
+#include <cereal/archives/binary.hpp>
+#include <sstream>
+
+using namespace stellar;
+
+namespace
+{
+std::vector<uint64_t>
+makeKeys(BinaryFuseFilter const& filter, uint64_t begin, uint64_t end)
+{
+    std::vector<uint64_t> hashes;
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        hashes.emplace_back(filter.hashBytes(
+            reinterpret_cast<unsigned char const*>(&i), sizeof(i)));
+    }
+    return hashes;
+}
+}
+
+TEST_CASE("binary fuse filter", "[binaryfusefilter]")
+{
+    auto fingerprintBits = GENERATE(8u, 16u);
+    size_t const numKeys = 100000;
+    BinaryFuseFilter filter(fingerprintBits, shortHash::getShortHashInitKey());
+
+    SECTION("empty filter contains nothing")
+    {
+        std::vector<uint64_t> empty;
+        filter.populate(empty);
+        for (auto h : makeKeys(filter, 0, 1000))
+        {
+            REQUIRE(!filter.containsHash(h));
+        }
+    }
+
+    auto keys = makeKeys(filter, 0, numKeys);
+    auto sorted = keys;
+    filter.populate(sorted);
+
+    SECTION("no false negatives")
+    {
+        for (auto h : keys)
+        {
+            REQUIRE(filter.containsHash(h));
+        }
+    }
+
+    SECTION("false positive rate and size")
+    {
+        size_t falsePositives = 0;
+        for (auto h : makeKeys(filter, numKeys, 2 * numKeys))
+        {
+            falsePositives += filter.containsHash(h);
+        }
+
+        // Expected rate is 2^-fingerprintBits; allow twice that
+        double rate = static_cast<double>(falsePositives) / numKeys;
+        REQUIRE(rate < 2.0 / (1 << fingerprintBits));
+
+        double bitsPerKey = filter.sizeInBytes() * 8.0 / numKeys;
+        REQUIRE(bitsPerKey < 1.25 * fingerprintBits);
+    }
+
+    SECTION("serialization round trip")
+    {
+        std::stringstream ss;
+        {
+            cereal::BinaryOutputArchive ar(ss);
+            ar(filter);
+        }
+
+        BinaryFuseFilter loaded;
+        {
+            cereal::BinaryInputArchive ar(ss);
+            ar(loaded);
+        }
+        REQUIRE(loaded == filter);
+        for (auto h : keys)
+        {
+            REQUIRE(loaded.containsHash(h));
+        }
+    }
+}
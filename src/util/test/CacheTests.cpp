@@ -3,9 +3,14 @@
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
 
 #include "lib/catch.hpp"
+#include "util/ClockCache.h"
+#include "util/ConcurrentCache.h"
 #include "util/RandomEvictionCache.h"
+#include "util/TinyLFUCache.h"
+#include <atomic>
 #include <ctime>
 #include <map>
+#include <thread>
 
 using namespace stellar;
 
@@ -152,8 +157,10 @@ TEST_CASE("RandomEvictionCache does not thrash",
 }
 
 using RandCache = RandomEvictionCache<int, int>;
+using ClockIntCache = ClockCache<int, int>;
 
-TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache)
+TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache,
+                   ClockIntCache)
 {
     TestType c{5};
 
@@ -161,7 +168,7 @@ TEMPLATE_TEST_CASE("cache empty", "[cache][template]", RandCache)
 }
 
 TEMPLATE_TEST_CASE("cache keeps most added items", "[cache][template]",
-                   RandCache)
+                   RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -189,7 +196,7 @@ TEMPLATE_TEST_CASE("cache keeps most added items", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache keeps last read items", "[cache][template]",
-                   RandCache)
+                   RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -213,7 +220,7 @@ TEMPLATE_TEST_CASE("cache keeps last read items", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache keeps last read items with maybeGet",
-                   "[cache][template]", RandCache)
+                   "[cache][template]", RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -236,7 +243,8 @@ TEMPLATE_TEST_CASE("cache keeps last read items with maybeGet",
     REQUIRE(existing == 5);
 }
 
-TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache)
+TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache,
+                   ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -264,7 +272,7 @@ TEMPLATE_TEST_CASE("cache replace element", "[cache][template]", RandCache)
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes some nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -283,7 +291,7 @@ TEMPLATE_TEST_CASE("cache erase_if removes some nodes", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes no nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -302,7 +310,7 @@ TEMPLATE_TEST_CASE("cache erase_if removes no nodes", "[cache][template]",
 }
 
 TEMPLATE_TEST_CASE("cache erase_if removes all nodes", "[cache][template]",
-                   RandCache)
+                   RandCache, ClockIntCache)
 {
     TestType c{5};
     c.put(0, 0);
@@ -319,3 +327,189 @@ TEMPLATE_TEST_CASE("cache erase_if removes all nodes", "[cache][template]",
     REQUIRE(!c.exists(3));
     REQUIRE(!c.exists(4));
 }
+
+TEST_CASE("ClockCache gives accessed entries a second chance", "[clockcache]")
+{
+    ClockCache<int, int> c(4);
+    for (int i = 0; i < 4; ++i)
+    {
+        c.put(i, i);
+    }
+    REQUIRE(c.maybeGet(0) != nullptr);
+    REQUIRE(c.maybeGet(2) != nullptr);
+
+    // The hand skips 0 and 2, clearing their marks, and evicts 1, then 3
+    c.put(4, 4);
+    REQUIRE(!c.exists(1, false));
+    c.put(5, 5);
+    REQUIRE(!c.exists(3, false));
+    REQUIRE(c.exists(0, false));
+    REQUIRE(c.exists(2, false));
+    REQUIRE(c.getCounters().mEvicts == 2);
+
+    // Accessed entries come first
+    c.maybeGet(5);
+    REQUIRE(c.recentKeys(1) == std::vector<int>{5});
+}
+
+TEST_CASE("ConcurrentCache shares a cache between threads",
+          "[concurrentcache]")
+{
+    using Shard = ClockCache<int, int>;
+    ConcurrentCache<int, int, Shard> cache(
+        8, []() { return std::make_unique<Shard>(100); });
+
+    // Catch assertions are not thread-safe
+    std::atomic<size_t> wrong{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 2000; ++i)
+            {
+                int k = (i * 7 + t) % 400;
+                if (auto v = cache.maybeGet(k))
+                {
+                    wrong += *v != k * 3;
+                }
+                else
+                {
+                    cache.put(k, k * 3);
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    REQUIRE(wrong == 0);
+    REQUIRE(cache.size() <= 8 * 100);
+
+    auto ctrs = cache.getCounters();
+    REQUIRE(ctrs.mHits + ctrs.mMisses == 4 * 2000);
+    REQUIRE(ctrs.mHits > 0);
+
+    // Batches of keys of one shard under one lock
+    auto shard = cache.shardOf(42);
+    cache.withShard(shard, [](Shard& c) { c.put(42, 0); });
+    REQUIRE(cache.maybeGet(42) == std::make_optional(0));
+
+    cache.reset([]() { return std::make_unique<Shard>(1); });
+    REQUIRE(cache.size() == 0);
+    cache.put(1, 1);
+    cache.put(2, 2);
+    REQUIRE(cache.size() <= 2);
+    cache.clear();
+    REQUIRE(!cache.maybeGet(1));
+}
+
+namespace
+{
+struct StringWeigher
+{
+    size_t
+    operator()(std::string const& s) const
+    {
+        return s.size();
+    }
+};
+using StringCache = TinyLFUCache<size_t, std::string, StringWeigher>;
+}
+
+TEST_CASE("TinyLFUCache bounds total weight", "[tinylfucache]")
+{
+    StringCache cache(10000, 1000);
+    auto const& ctrs = cache.getCounters();
+
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        cache.put(i, std::string(1 + i % 50, 'x'));
+        REQUIRE(cache.weight() <= cache.maxWeight());
+    }
+    REQUIRE(ctrs.mInserts == 1000);
+    REQUIRE(ctrs.mEvicts == ctrs.mInserts - cache.size());
+
+    SECTION("updates reweigh entries")
+    {
+        size_t key = 999;
+        REQUIRE(cache.exists(key));
+        // Make the key frequent enough to be admitted at its new weight
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE(cache.maybeGet(key));
+        }
+        cache.put(key, std::string(1000, 'y'));
+        REQUIRE(ctrs.mUpdates == 1);
+        REQUIRE(cache.weight() <= cache.maxWeight());
+        REQUIRE(cache.get(key).size() == 1000);
+
+        cache.put(key, std::string(1, 'y'));
+        REQUIRE(ctrs.mUpdates == 2);
+        REQUIRE(cache.get(key).size() == 1);
+    }
+
+    SECTION("values heavier than the cache are not stored")
+    {
+        cache.put(5000, std::string(10001, 'z'));
+        REQUIRE(!cache.exists(5000));
+        REQUIRE(cache.weight() <= cache.maxWeight());
+    }
+
+    SECTION("clear")
+    {
+        cache.clear();
+        REQUIRE(cache.size() == 0);
+        REQUIRE(cache.weight() == 0);
+        REQUIRE(cache.maybeGet(999) == nullptr);
+    }
+}
+
+TEST_CASE("TinyLFUCache resists scans and heavy values", "[tinylfucache]")
+{
+    size_t const hotKeys = 100;
+    StringCache cache(100 * hotKeys * 2, hotKeys * 10);
+
+    // A hot working set of light entries, accessed repeatedly
+    for (size_t round = 0; round < 5; ++round)
+    {
+        for (size_t i = 0; i < hotKeys; ++i)
+        {
+            if (!cache.maybeGet(i))
+            {
+                cache.put(i, std::string(100, 'h'));
+            }
+        }
+    }
+    for (size_t i = 0; i < hotKeys; ++i)
+    {
+        REQUIRE(cache.exists(i));
+    }
+
+    SECTION("one-off scan")
+    {
+        for (size_t i = hotKeys; i < 50 * hotKeys; ++i)
+        {
+            cache.put(i, std::string(100, 's'));
+        }
+    }
+    SECTION("heavy values")
+    {
+        for (size_t i = hotKeys; i < 2 * hotKeys; ++i)
+        {
+            cache.put(i, std::string(5000, 'b'));
+        }
+    }
+
+    size_t retained = 0;
+    for (size_t i = 0; i < hotKeys; ++i)
+    {
+        if (cache.exists(i, false))
+        {
+            ++retained;
+        }
+    }
+    // Only the small window is churned by the new entries
+    REQUIRE(retained >= hotKeys * 9 / 10);
+    REQUIRE(cache.weight() <= cache.maxWeight());
+}
@@ -0,0 +1,65 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/DeadlineThreadPool.h"
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <vector>
+
+using namespace stellar;
+
+TEST_CASE("DeadlineThreadPool runs queued jobs earliest deadline first",
+          "[deadlinethreadpool]")
+{
+    DeadlineThreadPool pool(1);
+
+    // Occupy the only thread so that everything below queues up.
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+    pool.post(
+        [&]() {
+            started.set_value();
+            released.wait();
+        },
+        0);
+    started.get_future().wait();
+
+    std::mutex mtx;
+    std::vector<int> order;
+    auto record = [&](int v) {
+        return [&, v]() {
+            std::lock_guard<std::mutex> guard(mtx);
+            order.push_back(v);
+        };
+    };
+    pool.post(record(50), 50);
+    pool.post(record(10), 10);
+    pool.post(record(30), 30);
+    pool.post(record(11), 10);
+    REQUIRE(pool.queueSize() == 4);
+
+    release.set_value();
+    pool.shutdown();
+
+    REQUIRE(order == std::vector<int>{10, 11, 30, 50});
+    REQUIRE(pool.queueSize() == 0);
+}
+
+TEST_CASE("DeadlineThreadPool drains all jobs on shutdown",
+          "[deadlinethreadpool]")
+{
+    std::atomic<size_t> count{0};
+    {
+        DeadlineThreadPool pool(4);
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            pool.post([&]() { ++count; }, i % 7);
+        }
+    }
+    REQUIRE(count == 1000);
+}
@@ -63,6 +63,18 @@ TEST_CASE("encode_b32", "[decoder]")
     }
 }
 
+TEST_CASE("encode_b32 matches the generic encoder", "[decoder]")
+{
+    autocheck::generator<std::vector<uint8_t>> input;
+    for (int s = 0; s < 100; s++)
+    {
+        std::vector<uint8_t> in(input(s));
+        std::string expected;
+        bn::encode_b32(in.begin(), in.end(), std::back_inserter(expected));
+        REQUIRE(decoder::encode_b32(in) == expected);
+    }
+}
+
 TEST_CASE("encode_b64", "[decoder]")
 {
     for (auto const& item : b64_data)
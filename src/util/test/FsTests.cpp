@@ -63,6 +63,26 @@ TEST_CASE("filesystem findfiles", "[fs]")
     REQUIRE(files == std::vector<std::string>{docFile.filename().string()});
 }
 
+TEST_CASE("TmpDir makes each subdirectory once", "[fs]")
+{
+    TmpDir tmp("fstests");
+    auto sub = tmp.makeSubdir("a/b");
+    REQUIRE(sub);
+    CHECK(*sub == tmp.getName() + "/a/b");
+    REQUIRE(stdfs::is_directory(*sub));
+
+    // Not looked at again
+    stdfs::remove(*sub);
+    REQUIRE(tmp.makeSubdir("a/b") == sub);
+    CHECK(!stdfs::exists(*sub));
+
+    // Files are staged two levels deep
+    FileTransferInfo ft(tmp, HISTORY_FILE_TYPE_LEDGER, 0x0012347f);
+    CHECK(ft.localPath_nogz() ==
+          tmp.getName() + "/ledger/00/12/ledger-0012347f.xdr");
+    CHECK(stdfs::is_directory(tmp.getName() + "/ledger/00/12"));
+}
+
 TEST_CASE("filesystem remoteName", "[fs]")
 {
     REQUIRE(fs::remoteName(HISTORY_FILE_TYPE_LEDGER, fs::hexStr(0x0abbccdd),
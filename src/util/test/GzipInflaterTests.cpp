@@ -0,0 +1,92 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#ifdef USE_ZLIB
+
+#include "crypto/Random.h"
+#include "lib/catch.hpp"
+#include "util/GzipInflater.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+using namespace stellar;
+
+namespace
+{
+std::string
+gzip(std::string const& data)
+{
+    z_stream stream = {};
+    REQUIRE(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+    std::string res(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(res.data());
+    stream.avail_out = static_cast<uInt>(res.size());
+    REQUIRE(deflate(&stream, Z_FINISH) == Z_STREAM_END);
+    res.resize(stream.total_out);
+    deflateEnd(&stream);
+    return res;
+}
+
+std::string
+inflateInChunks(GzipInflater& inflater, std::string const& data,
+                size_t chunkSize)
+{
+    std::string res;
+    for (size_t i = 0; i < data.size(); i += chunkSize)
+    {
+        inflater.inflate(data.data() + i, std::min(chunkSize, data.size() - i),
+                         [&](char const* out, size_t size) {
+                             res.append(out, size);
+                         });
+    }
+    return res;
+}
+}
+
+TEST_CASE("GzipInflater decompresses incrementally", "[gzip]")
+{
+    auto bytes = randomBytes(100000);
+    // Half random, half compressible
+    std::string data(bytes.begin(), bytes.end());
+    data += std::string(data.size(), 'x');
+    auto compressed = gzip(data);
+
+    for (size_t chunkSize : {size_t(1), size_t(1000), compressed.size()})
+    {
+        GzipInflater inflater;
+        REQUIRE(inflateInChunks(inflater, compressed, chunkSize) == data);
+        REQUIRE(inflater.done());
+    }
+
+    SECTION("several members")
+    {
+        GzipInflater inflater;
+        REQUIRE(inflateInChunks(inflater, compressed + gzip("end"), 4096) ==
+                data + "end");
+        REQUIRE(inflater.done());
+    }
+
+    SECTION("truncated")
+    {
+        GzipInflater inflater;
+        inflateInChunks(inflater, compressed.substr(0, compressed.size() - 4),
+                        4096);
+        REQUIRE(!inflater.done());
+    }
+
+    SECTION("corrupt")
+    {
+        GzipInflater inflater;
+        auto corrupt = compressed;
+        corrupt[1] = 'x';
+        REQUIRE_THROWS_AS(inflateInChunks(inflater, corrupt, 4096),
+                          std::runtime_error);
+    }
+}
+
+#endif
@@ -0,0 +1,53 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/MemoryAttribution.h"
+
+#include <memory>
+#include <vector>
+
+using namespace stellar;
+
+TEST_CASE("memory attribution", "[memoryattribution]")
+{
+    if (!memoryAttributionEnabled())
+    {
+        REQUIRE(getMemoryAttributionStats().empty());
+        return;
+    }
+
+    auto herderStats = []() {
+        for (auto const& s : getMemoryAttributionStats())
+        {
+            if (s.mSubsystem == "Herder")
+            {
+                return s;
+            }
+        }
+        FAIL("no Herder subsystem");
+        return MemoryAttributionStats{};
+    };
+
+    auto before = herderStats();
+    std::unique_ptr<std::vector<char>> v;
+    {
+        MemoryAttributionScope scope(MemorySubsystem::Herder);
+        {
+            MemoryAttributionScope inner(MemorySubsystem::Overlay);
+        }
+        v = std::make_unique<std::vector<char>>(1000);
+    }
+    auto allocated = herderStats();
+    REQUIRE(allocated.mAllocs >= before.mAllocs + 2);
+    REQUIRE(allocated.mAllocatedBytes >=
+            before.mAllocatedBytes + 1000 + sizeof(std::vector<char>));
+
+    // Released outside of the scope, but counted against where it came from
+    v.reset();
+    auto freed = herderStats();
+    REQUIRE(freed.mFrees >= allocated.mFrees + 2);
+    REQUIRE(freed.mFreedBytes >=
+            allocated.mFreedBytes + 1000 + sizeof(std::vector<char>));
+}
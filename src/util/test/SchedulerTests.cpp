@@ -125,3 +125,52 @@ TEST_CASE("scheduler load shedding -- overload", "[scheduler]")
                sched.stats().mActionsDroppedDueToOverload;
     CHECK(sched.stats().mActionsEnqueued == tot);
 }
+
+TEST_CASE("scheduler load shedding -- latency SLOs", "[scheduler]")
+{
+    VirtualClock clock;
+    Scheduler sched(clock, std::chrono::seconds(1));
+    sched.setLatencySLOs({{"a", std::chrono::microseconds(100)}});
+    CHECK(Scheduler::actionClass("a recv") == "a");
+
+    size_t nEvents{0};
+    auto microsleep = [&] {
+        clock.sleep_for(std::chrono::microseconds(1));
+        ++nEvents;
+    };
+    for (size_t i = 0; i < 10; ++i)
+    {
+        sched.enqueue(std::string("a recv"), microsleep,
+                      Scheduler::ActionType::DROPPABLE_ACTION);
+        sched.enqueue(std::string("b recv"), microsleep,
+                      Scheduler::ActionType::DROPPABLE_ACTION);
+    }
+    // Past the SLO of "a" but within the latency window
+    clock.sleep_for(std::chrono::microseconds(200));
+    while (sched.size() != 0)
+    {
+        sched.runOne();
+    }
+    CHECK(nEvents == 10);
+    CHECK(sched.stats().mActionsDroppedDueToOverload == 10);
+
+    auto const& classes = sched.getClassStats();
+    REQUIRE(classes.size() == 2);
+    CHECK(classes.at("a").mDropped == 10);
+    CHECK(classes.at("a").mRuns == 0);
+    auto const& b = classes.at("b");
+    CHECK(b.mDropped == 0);
+    CHECK(b.mRuns == 10);
+    CHECK(b.mQueueDelay.count() == 10);
+    CHECK(b.mQueueDelay.max() >= std::chrono::microseconds(200));
+    CHECK(b.mQueueDelay.quantile(0.5) >= std::chrono::microseconds(200));
+    CHECK(b.mRunTime.total() >= std::chrono::microseconds(10));
+
+    auto queues = sched.getQueueInfo();
+    REQUIRE(queues.size() == 2);
+    for (auto const& q : queues)
+    {
+        CHECK(q.mQueued == 0);
+        CHECK(q.mStats.mRuns + q.mStats.mDropped == 10);
+    }
+}
@@ -13,6 +13,7 @@
 #include "test/TestUtils.h"
 #include "test/test.h"
 #include "util/Logging.h"
+#include "util/Math.h"
 #include <chrono>
 
 using namespace stellar;
@@ -252,3 +253,71 @@ TEST_CASE("timer cancels", "[timer]")
     REQUIRE(timerFired == 8);
     REQUIRE(timerCancelled == 2);
 }
+
+TEST_CASE("timers fire at their exact expiry across timer wheel levels",
+          "[timer]")
+{
+    VirtualClock clock;
+    // From below the wheel's tick to beyond the span of its top level
+    std::vector<std::chrono::microseconds> const scales = {
+        std::chrono::microseconds(1), std::chrono::milliseconds(1),
+        std::chrono::seconds(1), std::chrono::minutes(1),
+        std::chrono::hours(1)};
+
+    size_t const n = 3000;
+    std::vector<std::unique_ptr<VirtualTimer>> timers;
+    std::vector<VirtualClock::time_point> expiries;
+    std::vector<std::pair<VirtualClock::time_point, size_t>> fired;
+    size_t cancelled = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        VirtualClock::duration delay =
+            scales[rand_uniform<size_t>(0, scales.size() - 1)] *
+            rand_uniform<int>(0, 1000);
+        // Some timers expire together, and must fire in the order they
+        // were set
+        if (i % 10 == 1)
+        {
+            delay = expiries.back() - clock.now();
+        }
+        timers.emplace_back(std::make_unique<VirtualTimer>(clock));
+        timers.back()->expires_from_now(delay);
+        expiries.emplace_back(timers.back()->expiry_time());
+        timers.back()->async_wait([&, i](asio::error_code const& ec) {
+            if (ec)
+            {
+                ++cancelled;
+            }
+            else
+            {
+                fired.emplace_back(clock.now(), i);
+            }
+        });
+    }
+    for (size_t i = 0; i < n; i += 3)
+    {
+        timers[i]->cancel();
+    }
+    // Time moves forward between batches of timers
+    testutil::crankFor(clock, std::chrono::seconds(30));
+    for (size_t i = 1; i < n; i += 3)
+    {
+        timers[i]->cancel();
+    }
+
+    while (clock.crank(false) > 0)
+        ;
+    for (size_t i = 0; i < fired.size(); ++i)
+    {
+        auto idx = fired[i].second;
+        REQUIRE(fired[i].first == expiries[idx]);
+        if (i > 0)
+        {
+            auto prev = fired[i - 1].second;
+            REQUIRE(std::make_pair(expiries[prev], prev) <
+                    std::make_pair(expiries[idx], idx));
+        }
+    }
+    REQUIRE(fired.size() + cancelled == n);
+    REQUIRE(cancelled >= n / 3);
+}
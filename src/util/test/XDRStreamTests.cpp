@@ -8,8 +8,10 @@
 #include "test/test.h"
 #include "util/Logging.h"
 #include "util/XDRStream.h"
+#include "util/XDRUncheckedPut.h"
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <chrono>
 
 using namespace stellar;
@@ -44,6 +46,121 @@ TEST_CASE("XDROutputFileStream fail modes", "[xdrstream]")
     }
 }
 
+TEST_CASE("XDROutputFileStream preallocate and drop cache behind",
+          "[xdrstream]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig(0);
+    fs::mkpath(cfg.BUCKET_DIR_PATH);
+    auto filename = fmt::format("{}/preallocated.xdr", cfg.BUCKET_DIR_PATH);
+
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+
+    size_t bytes = 0;
+    {
+        XDROutputFileStream out(clock.getIOContext(), /*doFsync=*/true);
+        out.open(filename);
+
+        // Reserve far more than is written
+        out.preallocate(64 * 1024 * 1024);
+        out.setDropCacheBehind(true);
+        for (auto const& e : bucketEntries)
+        {
+            out.writeOne(e, nullptr, &bytes);
+        }
+        out.close();
+    }
+
+    // Unused reservation is released and the contents are intact
+    REQUIRE(fs::size(filename) == bytes);
+
+    XDRInputFileStream in;
+    in.open(filename);
+    BucketEntry e;
+    size_t i = 0;
+    while (in.readOne(e))
+    {
+        REQUIRE(i < bucketEntries.size());
+        REQUIRE(e == bucketEntries[i++]);
+    }
+    REQUIRE(i == bucketEntries.size());
+    in.close();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("XDRInputFileStream with read buffer", "[xdrstream]")
+{
+    VirtualClock clock;
+    Config const& cfg = getTestConfig(0);
+    fs::mkpath(cfg.BUCKET_DIR_PATH);
+    auto filename = fmt::format("{}/readbuffer.xdr", cfg.BUCKET_DIR_PATH);
+
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+
+    std::vector<size_t> offsets;
+    {
+        size_t bytes = 0;
+        XDROutputFileStream out(clock.getIOContext(), /*doFsync=*/false);
+        out.open(filename);
+        for (auto const& e : bucketEntries)
+        {
+            offsets.emplace_back(bytes);
+            out.writeOne(e, nullptr, &bytes);
+        }
+        out.close();
+    }
+
+    auto bufferSize = GENERATE(4096, 1024 * 1024);
+    auto start = GENERATE(0, 500);
+    XDRInputFileStream in;
+    in.setReadBufferSize(bufferSize);
+    in.open(filename);
+    in.seek(offsets.at(start));
+    BucketEntry e;
+    size_t i = start;
+    while (in.readOne(e))
+    {
+        REQUIRE(i < bucketEntries.size());
+        REQUIRE(e == bucketEntries[i]);
+
+        // The raw bytes of the record match its encoding
+        auto raw = in.lastReadBytes();
+        auto expected = xdr::xdr_to_opaque(bucketEntries[i]);
+        REQUIRE(raw.size() == expected.size());
+        REQUIRE(std::equal(raw.begin(), raw.end(), expected.begin()));
+        ++i;
+    }
+    REQUIRE(i == bucketEntries.size());
+    in.close();
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("XDRUncheckedPut encodes like xdr_put", "[xdrstream]")
+{
+    auto ledgerEntries = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto bucketEntries =
+        Bucket::convertToBucketEntry(false, {}, ledgerEntries, {});
+    for (auto const& e : bucketEntries)
+    {
+        auto expected = xdr::xdr_to_opaque(e);
+        std::vector<uint8_t> buf(xdr::xdr_size(e));
+        xdrPutUnchecked(e, buf.data(), buf.data() + buf.size());
+        REQUIRE(buf == expected);
+    }
+
+    SECTION("a buffer of the wrong size is caught")
+    {
+        auto const& e = bucketEntries.front();
+        std::vector<uint8_t> buf(xdr::xdr_size(e) + 4);
+        REQUIRE_THROWS(
+            xdrPutUnchecked(e, buf.data(), buf.data() + buf.size()));
+    }
+}
+
 TEST_CASE("XDROutputFileStream fsync bench", "[!hide][xdrstream][bench]")
 {
     VirtualClock clock;
@@ -0,0 +1,77 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "lib/catch.hpp"
+#include "util/ZoneProfiler.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace stellar;
+
+#if !defined(TRACY_ENABLE)
+namespace
+{
+void
+sleepInZone()
+{
+    ZoneNamedN(sleepZone, "zone profiler test", true);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+ZoneStats const*
+findZone(std::vector<ZoneStats> const& stats)
+{
+    for (auto const& s : stats)
+    {
+        if (s.mName == "zone profiler test")
+        {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+}
+
+TEST_CASE("zone profiler", "[zoneprofiler]")
+{
+    auto const period = getZoneProfilerSamplePeriod();
+
+    SECTION("samples every zone with a period of 1")
+    {
+        setZoneProfilerSamplePeriod(1);
+        auto before = getZoneStats();
+        auto const* b = findZone(before);
+        uint64_t samplesBefore = b ? b->mSamples : 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            sleepInZone();
+        }
+        auto after = getZoneStats();
+        auto const* a = findZone(after);
+        REQUIRE(a != nullptr);
+        REQUIRE(a->mSamples == samplesBefore + 10);
+        REQUIRE(a->mMaxNs >= 100000);
+        REQUIRE(a->quantileNs(0.5) >= 100000);
+        REQUIRE(a->quantileNs(0.5) <= a->mMaxNs);
+    }
+
+    SECTION("samples nothing when disabled")
+    {
+        setZoneProfilerSamplePeriod(0);
+        auto before = getZoneStats();
+        auto const* b = findZone(before);
+        uint64_t samplesBefore = b ? b->mSamples : 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            sleepInZone();
+        }
+        auto after = getZoneStats();
+        auto const* a = findZone(after);
+        REQUIRE((a ? a->mSamples : 0) == samplesBefore);
+    }
+
+    setZoneProfilerSamplePeriod(period);
+}
+#endif
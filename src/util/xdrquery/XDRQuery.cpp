@@ -10,6 +10,38 @@ XDRMatcher::XDRMatcher(std::string const& query) : mQuery(query)
 {
 }
 
+std::shared_ptr<BoolEvalNode> const&
+XDRMatcher::getEvalRootForType(stellar::LedgerEntryType type)
+{
+    auto it = mEvalRootByType.find(type);
+    if (it != mEvalRootByType.end())
+    {
+        return it->second;
+    }
+
+    using DataTraits = xdr::xdr_traits<stellar::LedgerEntry::_data_t>;
+    auto armName = DataTraits::union_field_name(type);
+    std::string const arm = armName != nullptr ? armName : "";
+    auto isArm = [](std::string const& field) {
+        for (auto const c : stellar::LedgerEntry::_data_t::_xdr_case_values())
+        {
+            auto name = DataTraits::union_field_name(c);
+            if (name != nullptr && field == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    // Only the fields of the arm selected by `type` resolve under `data`
+    auto mayResolve = [&](std::vector<std::string> const& fieldPath) {
+        return fieldPath.size() < 2 || fieldPath[0] != "data" ||
+               fieldPath[1] == arm || !isArm(fieldPath[1]);
+    };
+    return mEvalRootByType.emplace(type, mEvalRoot->prune(mayResolve))
+        .first->second;
+}
+
 XDRFieldExtractor::XDRFieldExtractor(std::string const& query) : mQuery(query)
 {
 }
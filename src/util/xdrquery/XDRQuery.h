@@ -8,6 +8,7 @@
 #include "util/xdrquery/XDRQueryEval.h"
 #include "util/xdrquery/XDRQueryParser.h"
 
+#include <map>
 #include <string>
 #include <variant>
 
@@ -33,6 +34,10 @@ createFieldResolver(T const& xdrMessage, bool validate)
 // operations, e.g.
 // `data.account.balance >= 100000 || data.trustLine.balance < 5000`
 // See more examples in `XDRQueryTests`.
+// When matching `LedgerEntry`, the query is compiled once per entry type:
+// comparisons of fields of the other types (`data.trustLine` above for
+// accounts) are dropped, and entries of types that can't match are rejected
+// before any field is resolved.
 class XDRMatcher
 {
   public:
@@ -57,12 +62,31 @@ class XDRMatcher
             }
             mEvalRoot = std::get<std::shared_ptr<BoolEvalNode>>(statement);
         }
+        // The first message is matched against the whole query, as that's
+        // when its fields are validated
+        if constexpr (std::is_same_v<T, stellar::LedgerEntry>)
+        {
+            if (!firstEval)
+            {
+                auto const& root = getEvalRootForType(xdrMessage.data.type());
+                return root &&
+                       root->evalBool(createFieldResolver(xdrMessage, false));
+            }
+        }
         return mEvalRoot->evalBool(createFieldResolver(xdrMessage, firstEval));
     }
 
   private:
+    // The query compiled for the ledger entries of the given type, which
+    // skips the comparisons of fields in the other types of entries;
+    // nullptr if no entry of that type matches.
+    std::shared_ptr<BoolEvalNode> const&
+    getEvalRootForType(stellar::LedgerEntryType type);
+
     std::string const mQuery;
     std::shared_ptr<BoolEvalNode> mEvalRoot;
+    std::map<stellar::LedgerEntryType, std::shared_ptr<BoolEvalNode>>
+        mEvalRootByType;
 };
 
 // Helper to extract leaf fields from multiple XDR messages using the provided
@@ -168,6 +168,34 @@ BoolOpNode::evalBool(FieldResolver const& fieldResolver) const
     }
 }
 
+std::shared_ptr<BoolEvalNode>
+BoolOpNode::prune(FieldPathFilter const& mayResolve) const
+{
+    auto left = mLeft->prune(mayResolve);
+    auto right = mRight->prune(mayResolve);
+    switch (mType)
+    {
+    case BoolOpNodeType::AND:
+        if (!left || !right)
+        {
+            return nullptr;
+        }
+        break;
+    case BoolOpNodeType::OR:
+        if (!left)
+        {
+            return right;
+        }
+        if (!right)
+        {
+            return left;
+        }
+        break;
+    }
+    return std::make_shared<BoolOpNode>(mType, std::move(left),
+                                        std::move(right));
+}
+
 EvalNodeType
 BoolOpNode::getType() const
 {
@@ -230,41 +258,67 @@ ComparisonNode::evalBool(FieldResolver const& fieldResolver) const
             lit->resolveIntType(*leftVal, field->mFieldPath);
         }
     }
-    auto rightVal = mRight->eval(fieldResolver);
-    if (!rightVal)
+    // Literals are compared in place rather than copied for every message
+    ResultType rightResult;
+    ResultType const* rightVal = &rightResult;
+    if (rightType == EvalNodeType::LITERAL)
+    {
+        rightVal = &static_cast<LiteralNode const*>(mRight.get())->mValue;
+    }
+    else
+    {
+        rightResult = mRight->eval(fieldResolver);
+    }
+    if (!*rightVal)
     {
         return false;
     }
 
     bool leftIsNull = std::holds_alternative<NullField>(*leftVal);
-    bool rightIsNull = std::holds_alternative<NullField>(*rightVal);
+    bool rightIsNull = std::holds_alternative<NullField>(**rightVal);
     if (leftIsNull || rightIsNull)
     {
         return compareNullFields(leftIsNull, rightIsNull);
     }
 
-    if (leftVal->index() != rightVal->index())
+    if (leftVal->index() != (*rightVal)->index())
     {
         throw XDRQueryError(fmt::format(
             FMT_STRING("Type mismatch between values `{}` and `{}`."),
-            resultToString(*leftVal), resultToString(*rightVal)));
+            resultToString(*leftVal), resultToString(**rightVal)));
     }
 
     switch (mType)
     {
     case ComparisonNodeType::EQ:
-        return *leftVal == *rightVal;
+        return *leftVal == **rightVal;
     case ComparisonNodeType::NE:
-        return *leftVal != *rightVal;
+        return *leftVal != **rightVal;
     case ComparisonNodeType::LT:
-        return *leftVal < *rightVal;
+        return *leftVal < **rightVal;
     case ComparisonNodeType::LE:
-        return *leftVal <= *rightVal;
+        return *leftVal <= **rightVal;
     case ComparisonNodeType::GT:
-        return *leftVal > *rightVal;
+        return *leftVal > **rightVal;
     case ComparisonNodeType::GE:
-        return *leftVal >= *rightVal;
+        return *leftVal >= **rightVal;
+    }
+}
+
+std::shared_ptr<BoolEvalNode>
+ComparisonNode::prune(FieldPathFilter const& mayResolve) const
+{
+    // Comparisons with a field that doesn't resolve are always false
+    for (auto const& node : {mLeft, mRight})
+    {
+        if (node->getType() == EvalNodeType::FIELD &&
+            !mayResolve(static_cast<FieldNode const*>(node.get())->mFieldPath))
+        {
+            return nullptr;
+        }
     }
+    // The operands are shared, so that int literals are resolved once
+    return std::make_shared<ComparisonNode>(*this);
 }
 
 EvalNodeType
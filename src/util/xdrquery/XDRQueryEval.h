@@ -45,6 +45,9 @@ using ResultType = std::optional<ResultValueType>;
 using FieldResolver =
     std::function<ResultType(std::vector<std::string> const&)>;
 
+// A function that tells whether the field path may resolve to a value at all.
+using FieldPathFilter = std::function<bool(std::vector<std::string> const&)>;
+
 std::string resultToString(ResultValueType const& result);
 
 enum class EvalNodeType
@@ -108,6 +111,13 @@ struct BoolEvalNode : public EvalNode
     ResultType eval(FieldResolver const& fieldResolver) const override;
 
     virtual bool evalBool(FieldResolver const& fieldResolver) const = 0;
+
+    // Returns this expression for the messages on which only the field paths
+    // accepted by `mayResolve` can resolve, without the comparisons of the
+    // other fields, which are always `false` there. Returns nullptr when the
+    // whole expression is always `false`.
+    virtual std::shared_ptr<BoolEvalNode>
+    prune(FieldPathFilter const& mayResolve) const = 0;
 };
 
 enum class BoolOpNodeType
@@ -124,6 +134,9 @@ struct BoolOpNode : public BoolEvalNode
 
     bool evalBool(FieldResolver const& fieldResolver) const override;
 
+    std::shared_ptr<BoolEvalNode>
+    prune(FieldPathFilter const& mayResolve) const override;
+
     EvalNodeType getType() const override;
 
   private:
@@ -150,6 +163,9 @@ struct ComparisonNode : public BoolEvalNode
 
     bool evalBool(FieldResolver const& fieldResolver) const override;
 
+    std::shared_ptr<BoolEvalNode>
+    prune(FieldPathFilter const& mayResolve) const override;
+
     EvalNodeType getType() const override;
 
   private:
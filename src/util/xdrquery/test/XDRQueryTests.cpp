@@ -1,6 +1,8 @@
 // Copyright 2022 Stellar Development Foundation and contributors. Licensed
 // under the Apache License, Version 2.0. See the COPYING file at the root
 // of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+#include "ledger/test/LedgerTestUtils.h"
+#include "test/MicroBenchmark.h"
 #include "util/types.h"
 #include "util/xdrquery/XDRFieldResolver.h"
 #include "util/xdrquery/XDRQuery.h"
@@ -396,6 +398,35 @@ TEST_CASE("XDR matcher", "[xdrquery]")
         }
     }
 
+    SECTION("compiled per entry type")
+    {
+        std::vector<std::string> queries = {
+            "data.type == 'ACCOUNT'",
+            "data.offer.selling.assetCode >= 'foo'",
+            "data.account.balance > 150 || "
+            "data.offer.selling.assetCode == 'foo'",
+            "data.account.balance > 150 && "
+            "data.offer.selling.assetCode == 'foo'",
+            "data.trustLine.balance > 0 || lastModifiedLedgerSeq == 0",
+            "'01000200' == data.account.thresholds && data.type != 'OFFER'"};
+        std::vector<LedgerEntry> reversed(entries.rbegin(), entries.rend());
+        for (auto const& query : queries)
+        {
+            XDRMatcher compiled(query);
+            // Match in both orders, so that each entry type is compiled both
+            // first and last
+            for (auto const* order : {&entries, &reversed})
+            {
+                for (auto const& entry : *order)
+                {
+                    // The first match of a matcher uses the whole query
+                    XDRMatcher whole(query);
+                    REQUIRE(compiled.matchXDR(entry) == whole.matchXDR(entry));
+                }
+            }
+        }
+    }
+
     SECTION("query errors")
     {
         auto runQuery = [&](std::string const& query) {
@@ -650,5 +681,27 @@ TEST_CASE("XDR accumulator", "[xdrquery]")
     }
 }
 
+TEST_CASE("XDR matcher microbench", "[xdrquery][microbench][bench][!hide]")
+{
+    auto entries = LedgerTestUtils::generateValidLedgerEntries(1000);
+    auto matchAll = [&](XDRMatcher& matcher) {
+        size_t matches = 0;
+        for (auto const& entry : entries)
+        {
+            matches += matcher.matchXDR(entry) ? 1 : 0;
+        }
+        REQUIRE(matches <= entries.size());
+        return entries.size();
+    };
+
+    XDRMatcher offers("data.offer.selling.assetCode == 'USD' && "
+                      "data.offer.amount > 1000");
+    runMicroBenchmark("xdrquery.match-offers",
+                      [&]() { return matchAll(offers); });
+    XDRMatcher accounts("data.account.balance > 100000000");
+    runMicroBenchmark("xdrquery.match-accounts",
+                      [&]() { return matchAll(accounts); });
+}
+
 } // namespace
 } // namespace xdrquery
@@ -0,0 +1,104 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+
+#include "work/BackgroundWork.h"
+#include "main/Application.h"
+#include "util/GlobalChecks.h"
+#include "util/Logging.h"
+#include "util/ZoneProfiler.h"
+
+namespace stellar
+{
+
+BackgroundWork::BackgroundWork(Application& app, std::string name,
+                               size_t maxRetries, BackgroundTaskClass cls)
+    : BasicWork(app, std::move(name), maxRetries), mTaskClass(cls)
+{
+}
+
+BasicWork::State
+BackgroundWork::onRun()
+{
+    ZoneScoped;
+    if (mDone)
+    {
+        mDone = false;
+        if (mResult != State::WORK_RUNNING)
+        {
+            return mResult;
+        }
+    }
+    if (!mRunning)
+    {
+        post();
+    }
+    return State::WORK_WAITING;
+}
+
+void
+BackgroundWork::post()
+{
+    mRunning = true;
+    auto step = ++mStep;
+    Application& app = mApp;
+    std::weak_ptr<BackgroundWork> weak(
+        std::static_pointer_cast<BackgroundWork>(shared_from_this()));
+    auto name = getName();
+    app.postOnBackgroundThread(
+        [&app, weak, step, name]() {
+            auto self = weak.lock();
+            if (!self || self->isAborting())
+            {
+                return;
+            }
+
+            State result;
+            try
+            {
+                result = self->runInBackground();
+                releaseAssert(result == State::WORK_RUNNING ||
+                              result == State::WORK_SUCCESS ||
+                              result == State::WORK_FAILURE);
+            }
+            catch (std::exception const& e)
+            {
+                CLOG_ERROR(Work, "{} failed: {}", name, e.what());
+                result = State::WORK_FAILURE;
+            }
+            // Don't keep the work alive from here, the main thread may be
+            // done with it already
+            self.reset();
+
+            app.postOnMainThread(
+                [weak, step, result]() {
+                    auto self = weak.lock();
+                    if (self && self->mStep == step)
+                    {
+                        self->mRunning = false;
+                        self->mDone = true;
+                        self->mResult = result;
+                        self->wakeUp();
+                    }
+                },
+                name + ": finish");
+        },
+        name + ": run in background", mTaskClass);
+}
+
+bool
+BackgroundWork::onAbort()
+{
+    // The step in flight sees the work aborting, and its state is ignored
+    return true;
+}
+
+void
+BackgroundWork::onReset()
+{
+    ++mStep;
+    mRunning = false;
+    mDone = false;
+    mResult = State::WORK_RUNNING;
+}
+}
@@ -0,0 +1,57 @@
+// Copyright 2024 Stellar Development Foundation and contributors. Licensed
+// under the Apache License, Version 2.0. See the COPYING file at the root
+// of this distribution or at http://www.apache.org/licenses/LICENSE-2.0
+#pragma once
+
+#include "util/BackgroundExecutor.h"
+#include "work/BasicWork.h"
+
+namespace stellar
+{
+
+// A `BackgroundWork` is a work whose steps run on the background threads,
+// as jobs of class `cls`, while its state machine stays on the main thread.
+// Each crank posts one call to `runInBackground` and waits; when the call
+// returns its state is posted back to the main thread, which wakes the work
+// up to take it. Returning WORK_RUNNING runs another step the same way.
+//
+// Works that only compute (hashing, verifying, indexing) can then run side
+// by side: a BatchWork of BackgroundWorks keeps as many steps in flight as
+// it has children running, bounded by the limit of the task class.
+//
+// `runInBackground` must be thread-safe: it may read members that don't
+// change while the work runs and write the members holding its results,
+// which the main thread must only read once the step completed, i.e. in
+// `onSuccess` or in callbacks. Everything else about the work, including
+// its state, belongs to the main thread. Long steps should check
+// `isAborting` and return early: a step still running when the work is
+// aborted or reset completes on its own and its state is ignored.
+class BackgroundWork : public BasicWork
+{
+    BackgroundTaskClass const mTaskClass;
+    // Identifies the step in flight, so that the state of a step posted
+    // before a reset is ignored
+    uint64_t mStep{0};
+    bool mRunning{false};
+    bool mDone{false};
+    State mResult{State::WORK_RUNNING};
+
+    void post();
+
+  public:
+    BackgroundWork(Application& app, std::string name, size_t maxRetries,
+                   BackgroundTaskClass cls = BackgroundTaskClass::GENERAL);
+    virtual ~BackgroundWork() = default;
+
+  protected:
+    // Runs one step on a background thread, returning WORK_SUCCESS or
+    // WORK_FAILURE to finish, or WORK_RUNNING to run another step. WAITING
+    // and ABORTED are not allowed. Exceptions are logged and fail the work.
+    virtual State runInBackground() = 0;
+
+    State onRun() final;
+    bool onAbort() override;
+    // Overrides must call this one
+    void onReset() override;
+};
+}
@@ -91,12 +91,14 @@ class Application;
  * _batches_
  *  - WorkSequence: BasicWork that allows sequential execution of children
  * works.
+ *  - BackgroundWork: BasicWork whose steps run on the background threads.
  *
  * BasicWork is _not_ thread-safe, and therefore should not be used by threads.
  * The only acceptable use case if when we need to spawn an independent work in
  * the background (read from a file, download a file, etc), and post back to the
  * main thread at the end, so Work can finish. In this case, only const
- * functions querying Work's state are thread-safe.
+ * functions querying Work's state are thread-safe. BackgroundWork does this
+ * for works whose steps can run on any thread.
  */
 
 class BasicWork : public std::enable_shared_from_this<BasicWork>,
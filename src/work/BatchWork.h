@@ -41,5 +41,9 @@ class BatchWork : public Work
     virtual bool hasNext() const = 0;
     virtual std::shared_ptr<BasicWork> yieldMoreWork() = 0;
     virtual void resetIter() = 0;
+
+    // Number of children running at most, MAX_CONCURRENT_SUBPROCESSES
+    // unless overridden
+    virtual size_t getMaxConcurrency() const;
 };
 }
@@ -11,9 +11,12 @@
 #include <fmt/format.h>
 
 #include "historywork/RunCommandWork.h"
+#include "work/BackgroundWork.h"
 #include "work/BatchWork.h"
 #include "work/ConditionalWork.h"
 
+#include <atomic>
+#include <limits>
 #include <thread>
 
 using namespace stellar;
@@ -862,6 +865,91 @@ TEST_CASE("Work batching", "[batching][work]")
     }
 }
 
+// ======= BackgroundWork tests ======== //
+class TestBackgroundWork : public BackgroundWork
+{
+    std::thread::id const mMainThread;
+    bool const mThrow;
+
+  public:
+    std::atomic<size_t> mSteps{0};
+    std::atomic<bool> mRanOnMainThread{false};
+    size_t const mNumSteps;
+
+    TestBackgroundWork(Application& app, std::string name, bool thrw = false,
+                       size_t steps = 3)
+        : BackgroundWork(app, std::move(name), BasicWork::RETRY_NEVER)
+        , mMainThread(std::this_thread::get_id())
+        , mThrow(thrw)
+        , mNumSteps(steps)
+    {
+    }
+
+  protected:
+    State
+    runInBackground() override
+    {
+        if (std::this_thread::get_id() == mMainThread)
+        {
+            mRanOnMainThread = true;
+        }
+        if (mThrow)
+        {
+            throw std::runtime_error("background step failed");
+        }
+        return ++mSteps < mNumSteps ? State::WORK_RUNNING
+                                    : State::WORK_SUCCESS;
+    }
+};
+
+TEST_CASE("BackgroundWork test", "[work]")
+{
+    VirtualClock clock;
+    Application::pointer app = createTestApplication(clock, getTestConfig());
+    auto& wm = app->getWorkScheduler();
+
+    SECTION("steps run on background threads")
+    {
+        std::vector<std::shared_ptr<TestBackgroundWork>> works;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            works.emplace_back(wm.scheduleWork<TestBackgroundWork>(
+                fmt::format("background-{:d}", i)));
+        }
+        while (!clock.getIOContext().stopped() && !wm.allChildrenDone())
+        {
+            clock.crank(true);
+        }
+        for (auto const& w : works)
+        {
+            REQUIRE(w->getState() == BasicWork::State::WORK_SUCCESS);
+            REQUIRE(w->mSteps == w->mNumSteps);
+            REQUIRE(!w->mRanOnMainThread);
+        }
+    }
+    SECTION("exception fails the work")
+    {
+        auto w = wm.scheduleWork<TestBackgroundWork>("background-throw", true);
+        while (!clock.getIOContext().stopped() && !wm.allChildrenDone())
+        {
+            clock.crank(true);
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_FAILURE);
+    }
+    SECTION("shutdown")
+    {
+        auto w = wm.scheduleWork<TestBackgroundWork>(
+            "background-long", false, std::numeric_limits<size_t>::max());
+        clock.crank(true);
+        wm.shutdown();
+        while (!clock.getIOContext().stopped() && !wm.allChildrenDone())
+        {
+            clock.crank(true);
+        }
+        REQUIRE(w->getState() == BasicWork::State::WORK_ABORTED);
+    }
+}
+
 class TestBatchWorkCondition : public TestBatchWork
 {
   public: